@@ -6,9 +6,14 @@
 
 
 import argparse
+import json
+import subprocess
+import threading
 
 import demo_runner as dr
 
+import habitat_sim
+
 parser = argparse.ArgumentParser("Running benchmarks on simulator")
 parser.add_argument("--scene", type=str, default=dr.default_sim_settings["scene"])
 parser.add_argument(
@@ -60,8 +65,84 @@ parser.add_argument(
     action="store_true",
     help="Disable frustum culling (default is enabled)",
 )
+parser.add_argument(
+    "--gpu_device_ids",
+    type=int,
+    nargs="+",
+    default=[0],
+    help="GPUs to spread the processes over, --num_procs is per GPU.",
+)
+parser.add_argument(
+    "--disable_perf_stats",
+    action="store_true",
+    help="Do not record the per-component timings of the C++ counters.",
+)
+parser.add_argument(
+    "--report",
+    type=str,
+    default="",
+    help="Write the results to this JSON file, to compare them across releases.",
+)
 args = parser.parse_args()
 
+
+class GpuMonitor:
+    r"""Samples the utilization and memory of GPUs with nvidia-smi while the
+    benchmark runs. Reports nothing if nvidia-smi isn't available.
+    """
+
+    def __init__(self, gpu_device_ids, interval=0.5):
+        self._gpu_device_ids = ",".join(str(i) for i in gpu_device_ids)
+        self._interval = interval
+        self._utilization = []
+        self._memory_used = {}
+        self._stop = threading.Event()
+        self._thread = None
+
+    def _sample(self):
+        try:
+            output = subprocess.check_output(
+                [
+                    "nvidia-smi",
+                    "--query-gpu=index,utilization.gpu,memory.used",
+                    "--format=csv,noheader,nounits",
+                    "--id=" + self._gpu_device_ids,
+                ],
+                stderr=subprocess.DEVNULL,
+            ).decode()
+        except (OSError, subprocess.CalledProcessError):
+            return False
+        for line in output.strip().splitlines():
+            index, utilization, memory_used = (float(v) for v in line.split(","))
+            self._utilization.append(utilization)
+            self._memory_used[index] = max(
+                self._memory_used.get(index, 0.0), memory_used
+            )
+        return True
+
+    def _run(self):
+        while self._sample() and not self._stop.wait(self._interval):
+            pass
+
+    def __enter__(self):
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+        return self
+
+    def __exit__(self, *exc):
+        self._stop.set()
+        self._thread.join()
+
+    def report(self):
+        if not self._utilization:
+            return {}
+        return dict(
+            gpu_utilization=sum(self._utilization) / len(self._utilization),
+            peak_vram_mb=max(self._memory_used.values()),
+            total_peak_vram_mb=sum(self._memory_used.values()),
+        )
+
+
 default_settings = dr.default_sim_settings.copy()
 default_settings["scene"] = args.scene
 default_settings["silent"] = True
@@ -75,6 +156,8 @@ default_settings["compute_action_shortest_path"] = False
 
 default_settings["max_frames"] = args.max_frames
 default_settings["frustum_culling"] = not args.disable_frustum_culling
+default_settings["gpu_device_ids"] = args.gpu_device_ids
+default_settings["enable_perf_stats"] = not args.disable_perf_stats
 
 
 benchmark_items = {
@@ -99,7 +182,7 @@ nprocs_tests = args.num_procs
 
 performance_all = {}
 for nprocs in nprocs_tests:
-    default_settings["num_processes"] = nprocs
+    default_settings["num_processes"] = nprocs * len(args.gpu_device_ids)
     performance = []
     for resolution in resolutions:
         default_settings["width"] = default_settings["height"] = resolution
@@ -109,7 +192,9 @@ for nprocs in nprocs_tests:
             print(" ---------------------- %s ------------------------ " % key)
             settings = default_settings.copy()
             settings.update(value)
-            perf[key] = demo_runner.benchmark(settings)
+            with GpuMonitor(args.gpu_device_ids) as gpu_monitor:
+                perf[key] = demo_runner.benchmark(settings)
+            perf[key].update(gpu_monitor.report())
             print(
                 " ====== FPS (%d x %d, %s): %0.1f ======"
                 % (settings["width"], settings["height"], key, perf[key].get("fps"))
@@ -156,3 +241,76 @@ for nproc, performance in performance_all.items():
         print(
             " =============================================================================="
         )
+
+# throughput of N processes per GPU relative to N times the throughput of the
+# smallest process count
+base_nprocs = min(nprocs_tests)
+for nproc, performance in performance_all.items():
+    for idx in range(len(performance)):
+        for key, value in performance[idx].items():
+            base = performance_all[base_nprocs][idx][key]
+            value["scaling_efficiency"] = (value["fps"] * base_nprocs) / (
+                base["fps"] * nproc
+            )
+
+for nproc, performance in performance_all.items():
+    print(
+        " ================ Scaling efficiency / CPU and memory NPROC={} ================".format(
+            nproc
+        )
+    )
+    print(
+        "Resolution \tconfig      \tefficiency\tcpu ms/frame\tpeak RSS MB\tGPU %\tpeak VRAM MB"
+    )
+    for idx in range(len(performance)):
+        for key, value in performance[idx].items():
+            print(
+                "%d x %d\t%-12s\t%-10.2f\t%-12.2f\t%-11.1f\t%s\t%s"
+                % (
+                    resolutions[idx],
+                    resolutions[idx],
+                    key,
+                    value["scaling_efficiency"],
+                    value["cpu_frame_time"] * 1000,
+                    value["peak_rss_mb"],
+                    "%.1f" % value["gpu_utilization"]
+                    if "gpu_utilization" in value
+                    else "-",
+                    "%.1f" % value["peak_vram_mb"] if "peak_vram_mb" in value else "-",
+                )
+            )
+            if "perf_stats" in value:
+                print(
+                    "\t\t"
+                    + ", ".join(
+                        "%s %.2f" % (name, per_frame)
+                        for name, per_frame in sorted(value["perf_stats"].items())
+                    )
+                )
+    print(
+        " =============================================================================="
+    )
+
+if args.report:
+    report = dict(
+        version=habitat_sim.__version__,
+        scene=args.scene,
+        max_frames=args.max_frames,
+        gpu_device_ids=args.gpu_device_ids,
+        enable_physics=args.enable_physics,
+        frustum_culling=not args.disable_frustum_culling,
+        results=[
+            dict(
+                num_procs_per_gpu=nproc,
+                resolution=resolutions[idx],
+                config=key,
+                **value,
+            )
+            for nproc, performance in performance_all.items()
+            for idx in range(len(performance))
+            for key, value in performance[idx].items()
+        ],
+    )
+    with open(args.report, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    print("Wrote the report to " + args.report)
@@ -7,6 +7,7 @@ import math
 import multiprocessing
 import os
 import random
+import resource
 import time
 from enum import Enum
 
@@ -212,6 +213,7 @@ class DemoRunner:
         total_sim_step_time = 0.0
         total_frames = 0
         start_time = time.time()
+        start_cpu_time = time.process_time()
         action_names = list(
             self._cfg.agents[self._sim_settings["default_agent"]].action_space.keys()
         )
@@ -228,6 +230,9 @@ class DemoRunner:
         while total_frames < self._sim_settings["max_frames"]:
             if total_frames == 1:
                 start_time = time.time()
+                start_cpu_time = time.process_time()
+                if self._sim_settings.get("enable_perf_stats"):
+                    self._sim.reset_perf_stats()
             action = random.choice(action_names)
             if not self._sim_settings["silent"]:
                 print("action", action)
@@ -294,6 +299,19 @@ class DemoRunner:
         perf["fps"] = 1.0 / perf["frame_time"]
         perf["time_per_step"] = time_per_step
         perf["avg_sim_step_time"] = total_sim_step_time / total_frames
+        perf["cpu_frame_time"] = (time.process_time() - start_cpu_time) / total_frames
+        # kilobytes on Linux
+        perf["peak_rss_mb"] = (
+            resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024.0
+        )
+        if self._sim_settings.get("enable_perf_stats"):
+            # the totals of the C++ counters over the timed frames, per frame
+            measured_frames = max(total_frames - 1, 1)
+            perf["perf_stats"] = {
+                name: stat["total"] / measured_frames
+                for name, stat in self._sim.get_perf_stats().items()
+                if not name.endswith("_mb")
+            }
 
         return perf
 
@@ -350,6 +368,12 @@ class DemoRunner:
         return self.init_agent_state(self._sim_settings["default_agent"])
 
     def _bench_target(self, _idx=0):
+        # spread the processes over the GPUs
+        gpu_device_ids = self._sim_settings.get("gpu_device_ids")
+        if gpu_device_ids:
+            self._sim_settings["gpu_device_id"] = gpu_device_ids[
+                _idx % len(gpu_device_ids)
+            ]
         self.init_common()
 
         best_perf = None
@@ -398,12 +422,22 @@ class DemoRunner:
             for k, v in p.items():
                 res[k] += [v]
 
-        return dict(
+        perf = dict(
             frame_time=sum(res["frame_time"]),
             fps=sum(res["fps"]),
             total_time=sum(res["total_time"]) / nprocs,
             avg_sim_step_time=sum(res["avg_sim_step_time"]) / nprocs,
+            cpu_frame_time=sum(res["cpu_frame_time"]) / nprocs,
+            peak_rss_mb=max(res["peak_rss_mb"]),
+            total_peak_rss_mb=sum(res["peak_rss_mb"]),
         )
+        if "perf_stats" in res:
+            perf["perf_stats"] = {
+                name: sum(stats.get(name, 0.0) for stats in res["perf_stats"])
+                / nprocs
+                for name in res["perf_stats"][0]
+            }
+        return perf
 
     def example(self):
         start_state = self.init_common()
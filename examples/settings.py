@@ -33,6 +33,8 @@ default_sim_settings = {
     "num_objects": 10,
     "test_object_index": 0,
     "frustum_culling": True,
+    "gpu_device_id": 0,
+    "enable_perf_stats": False,  # record the C++ performance counters
 }
 
 # build SimulatorConfiguration
@@ -50,7 +52,9 @@ def make_cfg(settings):
         print("sim_cfg.physics_config_file = " + sim_cfg.physics_config_file)
     if "scene_light_setup" in settings:
         sim_cfg.scene_light_setup = settings["scene_light_setup"]
-    sim_cfg.gpu_device_id = 0
+    sim_cfg.gpu_device_id = settings.get("gpu_device_id", 0)
+    if "enable_perf_stats" in settings:
+        sim_cfg.enable_perf_stats = settings["enable_perf_stats"]
     if not hasattr(sim_cfg, "scene_id"):
         raise RuntimeError(
             "Error: Please upgrade habitat-sim. SimulatorConfig API version mismatch"
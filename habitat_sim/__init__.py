@@ -54,20 +54,37 @@ if not getattr(builtins, "__HSIM_SETUP__", False):
         SensorSubType,
         SensorType,
         SimulatorConfiguration,
+        StaleObservationPolicy,
         cuda_enabled,
     )
     from habitat_sim.nav import (  # noqa: F401
+        BatchedGreedyGeodesicFollower,
+        ContinuousPathFollower,
+        CoverageMap,
+        Episode,
+        EpisodeSamplingSettings,
+        GeodesicDistanceField,
         GreedyFollowerCodes,
         GreedyGeodesicFollower,
         HitRecord,
         MultiGoalShortestPath,
+        NavMeshAgentBatch,
+        NavMeshLevel,
+        NavMeshMotion,
         NavMeshSettings,
         PathFinder,
+        PathFollowerSettings,
         ShortestPath,
         VectorGreedyCodes,
+        VelocityCommand,
     )
     from habitat_sim.registry import registry  # noqa: F401
-    from habitat_sim.simulator import Configuration, Simulator  # noqa: F401
+    from habitat_sim.simulator import (  # noqa: F401
+        Configuration,
+        ForkServer,
+        Simulator,
+        VectorSimulator,
+    )
 
     __all__ = [
         "agent",
@@ -153,7 +153,11 @@ class Agent(object):
         if modify_agent_config:
             assert spec not in self.agent_config.sensor_specifications
             self.agent_config.sensor_specifications.append(spec)
-        self._sensors.add(hsim.CameraSensor(self.scene_node.create_child(), spec))
+        if spec.sensor_type == hsim.SensorType.LIDAR:
+            sensor = hsim.LidarSensor(self.scene_node.create_child(), spec)
+        else:
+            sensor = hsim.CameraSensor(self.scene_node.create_child(), spec)
+        self._sensors.add(sensor)
 
     def act(self, action_id: Any) -> bool:
         r"""Take the action specified by action_id
@@ -12,6 +12,7 @@ from habitat_sim._ext.habitat_sim_bindings import (
     ConfigurationGroup,
     GreedyFollowerCodes,
     GreedyGeodesicFollowerImpl,
+    LidarSensor,
     MultiGoalShortestPath,
     PathFinder,
     RigidState,
@@ -3,13 +3,17 @@
 # LICENSE file in the root directory of this source tree.
 
 from habitat_sim._ext.habitat_sim_bindings import (
+    AUTO_GPU_DEVICE,
     DEFAULT_LIGHTING_KEY,
     NO_LIGHT_KEY,
     Camera,
+    GpuDevice,
     LightInfo,
     LightPositionModel,
     Renderer,
     RenderTarget,
+    least_loaded_gpu_device,
+    query_gpu_devices,
 )
 
 __all__ = [
@@ -20,4 +24,8 @@ __all__ = [
     "LightInfo",
     "DEFAULT_LIGHTING_KEY",
     "NO_LIGHT_KEY",
+    "AUTO_GPU_DEVICE",
+    "GpuDevice",
+    "least_loaded_gpu_device",
+    "query_gpu_devices",
 ]
@@ -1,24 +1,46 @@
 from habitat_sim._ext.habitat_sim_bindings import (
+    BatchedGreedyGeodesicFollower,
+    ContinuousPathFollower,
+    CoverageMap,
+    Episode,
+    EpisodeSamplingSettings,
+    GeodesicDistanceField,
     GreedyFollowerCodes,
     GreedyGeodesicFollowerImpl,
     HitRecord,
     MultiGoalShortestPath,
+    NavMeshAgentBatch,
+    NavMeshLevel,
+    NavMeshMotion,
     NavMeshSettings,
     PathFinder,
+    PathFollowerSettings,
     ShortestPath,
     VectorGreedyCodes,
+    VelocityCommand,
 )
 
 from .greedy_geodesic_follower import GreedyGeodesicFollower
 
 __all__ = [
+    "BatchedGreedyGeodesicFollower",
+    "ContinuousPathFollower",
+    "CoverageMap",
+    "Episode",
+    "EpisodeSamplingSettings",
+    "GeodesicDistanceField",
     "GreedyGeodesicFollower",
     "GreedyGeodesicFollowerImpl",
     "GreedyFollowerCodes",
     "MultiGoalShortestPath",
+    "NavMeshAgentBatch",
+    "NavMeshLevel",
+    "NavMeshMotion",
     "NavMeshSettings",
     "PathFinder",
+    "PathFollowerSettings",
     "ShortestPath",
     "HitRecord",
     "VectorGreedyCodes",
+    "VelocityCommand",
 ]
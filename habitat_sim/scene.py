@@ -13,6 +13,7 @@ from habitat_sim._ext.habitat_sim_bindings import (
     SemanticObject,
     SemanticRegion,
     SemanticScene,
+    SemanticSpatialIndex,
 )
 
 __all__ = [
@@ -26,4 +27,5 @@ __all__ = [
     "SemanticObject",
     "SemanticRegion",
     "SemanticScene",
+    "SemanticSpatialIndex",
 ]
@@ -2,20 +2,43 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+from typing import Sequence
+
+import numpy as np
+
 from habitat_sim._ext.habitat_sim_bindings import (
     CameraSensor,
+    LidarSensor,
     Observation,
     Sensor,
     SensorSpec,
     SensorType,
+    StaleObservationPolicy,
     VisualSensor,
+    encode_object_id_runs,
 )
 
 __all__ = [
     "CameraSensor",
+    "LidarSensor",
     "Observation",
     "Sensor",
     "SensorType",
     "SensorSpec",
+    "StaleObservationPolicy",
     "VisualSensor",
+    "encode_object_id_runs",
+    "decode_object_id_runs",
 ]
+
+
+def decode_object_id_runs(runs: np.ndarray, shape: Sequence[int]) -> np.ndarray:
+    r"""Decodes the runs of :ref:`encode_object_id_runs()` into object ids
+
+    :param runs: The runs x 2 array of an id and the length of its run
+    :param shape: The shape of the encoded frame, e.g. :py:`(height, width)`
+    :return: The ids, a :py:`uint32` array of :p:`shape`
+    """
+    runs = np.asarray(runs, dtype=np.uint32).reshape(-1, 2)
+    ids = np.repeat(runs[:, 0], runs[:, 1])
+    return ids.reshape(shape)
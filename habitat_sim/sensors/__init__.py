@@ -4,8 +4,8 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
-from habitat_sim.sensors import noise_models
+from habitat_sim.sensors import noise_models, postprocessing, shared_observations
 
 from .sensor_suite import SensorSuite
 
-__all__ = ["SensorSuite", "noise_models"]
+__all__ = ["SensorSuite", "noise_models", "postprocessing", "shared_observations"]
@@ -8,6 +8,7 @@ from os import path as osp
 from typing import Union
 
 import attr
+import magnum as mn
 import numba
 import numpy as np
 from numpy import ndarray
@@ -18,6 +19,9 @@ try:
 except ImportError:
     torch = None
 
+from habitat_sim._ext.habitat_sim_bindings import (
+    RedwoodNoiseModelCPUImpl as _RedwoodNoiseModelCPUImpl,
+)
 from habitat_sim._ext.habitat_sim_bindings import SensorType
 from habitat_sim.bindings import cuda_enabled
 from habitat_sim.registry import registry
@@ -124,7 +128,9 @@ class RedwoodDepthNoiseModel(SensorNoiseModel):
                 dist, self.gpu_device_id, self.noise_multiplier
             )
         else:
-            self._impl = RedwoodNoiseModelCPUImpl(dist, self.noise_multiplier)
+            # multithreaded and vectorized, RedwoodNoiseModelCPUImpl is kept
+            # as the reference implementation
+            self._impl = _RedwoodNoiseModelCPUImpl(dist, self.noise_multiplier)
 
     @staticmethod
     def is_valid_sensor_type(sensor_type: SensorType) -> bool:
@@ -135,15 +141,46 @@ class RedwoodDepthNoiseModel(SensorNoiseModel):
             if isinstance(gt_depth, np.ndarray):
                 return self._impl.simulate_from_cpu(gt_depth)
             else:
+                gt_depth = gt_depth.contiguous()
                 noisy_depth = torch.empty_like(gt_depth)
-                rows, cols = gt_depth.size()
-                self._impl.simulate_from_gpu(
-                    gt_depth.data_ptr(), rows, cols, noisy_depth.data_ptr()  # type: ignore
-                )
+                if gt_depth.dim() == 3:
+                    # a stack of depth images, e.g. one per environment,
+                    # noised in a single kernel launch
+                    batch, rows, cols = gt_depth.size()
+                    self._impl.simulate_batch_from_gpu(
+                        gt_depth.data_ptr(), batch, rows, cols, noisy_depth.data_ptr()  # type: ignore
+                    )
+                else:
+                    rows, cols = gt_depth.size()
+                    self._impl.simulate_from_gpu(
+                        gt_depth.data_ptr(), rows, cols, noisy_depth.data_ptr()  # type: ignore
+                    )
                 return noisy_depth
+        elif gt_depth.ndim == 3:
+            return self._impl.simulate_batch(gt_depth)
         else:
             return self._impl.simulate(gt_depth)
 
+    @property
+    def applies_to_render_target(self) -> bool:
+        return cuda_enabled
+
+    def apply_to_render_target(self, render_target, buffer) -> None:
+        r"""Noises the depth on the GPU as it's read from the render target,
+        so it's either kept on the GPU or read back to the CPU once, instead
+        of being read back, uploaded and downloaded again"""
+        if isinstance(buffer, np.ndarray):
+            self._impl.simulate_from_render_target(
+                render_target,
+                mn.MutableImageView2D(
+                    mn.PixelFormat.R32F, render_target.framebuffer_size, buffer
+                ),
+            )
+        else:
+            self._impl.simulate_from_render_target_gpu(
+                render_target, buffer.data_ptr()
+            )
+
     def apply(self, gt_depth: Union[ndarray, "Tensor"]) -> Union[ndarray, "Tensor"]:
         r"""Alias of `simulate()` to conform to base-class and expected API"""
         return self.simulate(gt_depth)
@@ -9,9 +9,16 @@ import attr
 import numpy as np
 from numpy import ndarray
 
+from habitat_sim.bindings import cuda_enabled
 from habitat_sim.registry import registry
 from habitat_sim.sensor import SensorType
-from habitat_sim.sensors.noise_models.sensor_noise_model import SensorNoiseModel
+from habitat_sim.sensors.noise_models.sensor_noise_model import (
+    SensorNoiseModel,
+    simulate_rgb_on_gpu,
+)
+
+if cuda_enabled:
+    from habitat_sim._ext.habitat_sim_bindings import RgbNoiseModelGPUImpl
 
 
 def _simulate(image: ndarray, s_vs_p: float, amount: float) -> ndarray:
@@ -45,13 +52,22 @@ class SaltAndPepperNoiseModel(SensorNoiseModel):
     amount: float = 0.05
 
     def __attrs_post_init__(self) -> None:
-        self._impl = SaltAndPepperNoiseModelCPUImpl(self.s_vs_p, self.amount)
+        if cuda_enabled:
+            self._impl = RgbNoiseModelGPUImpl.salt_and_pepper(
+                self.gpu_device_id if self.gpu_device_id is not None else 0,
+                self.s_vs_p,
+                self.amount,
+            )
+        else:
+            self._impl = SaltAndPepperNoiseModelCPUImpl(self.s_vs_p, self.amount)
 
     @staticmethod
     def is_valid_sensor_type(sensor_type: SensorType) -> bool:
         return sensor_type == SensorType.COLOR
 
     def simulate(self, image):
+        if cuda_enabled:
+            return simulate_rgb_on_gpu(self._impl, image)
         return self._impl.simulate(image)
 
     def apply(self, image):
@@ -11,9 +11,10 @@ import attr
 from numpy import ndarray
 
 try:
+    import torch
     from torch import Tensor
 except ImportError:
-    pass
+    torch = None
 
 from habitat_sim.sensor import SensorType
 
@@ -42,8 +43,40 @@ class SensorNoiseModel(abc.ABC):
         :return: The sensor observation with noise applied.
         """
 
+    @property
+    def applies_to_render_target(self) -> bool:
+        r"""Whether `apply_to_render_target()` is supported, in which case
+        sensors use it instead of reading the clean observation first
+        """
+        return False
+
+    def apply_to_render_target(self, render_target, buffer) -> None:
+        r"""Applies the noise model to the frame of a render target directly
+
+        :param render_target: The render target the sensor drew into
+        :param buffer: The buffer to write the noisy observation to, a CUDA
+            tensor for gpu2gpu transfer, otherwise a numpy array. Its rows are
+            top-down, unlike what is read from the render target.
+        """
+        raise NotImplementedError
+
     def __call__(
         self, sensor_observation: Union[ndarray, "Tensor"]
     ) -> Union[ndarray, "Tensor"]:
         r"""Alias of `apply()`"""
         return self.apply(sensor_observation)
+
+
+def simulate_rgb_on_gpu(
+    impl, image: Union[ndarray, "Tensor"]
+) -> Union[ndarray, "Tensor"]:
+    r"""Applies a `RgbNoiseModelGPUImpl` to a color observation, or a stack of
+    them, either on the CPU or in a CUDA tensor
+    """
+    if isinstance(image, ndarray):
+        return impl.simulate_from_cpu(image)
+
+    image = image.contiguous()
+    noisy_image = torch.empty_like(image)
+    impl.simulate_from_gpu(image.data_ptr(), image.numel(), noisy_image.data_ptr())
+    return noisy_image
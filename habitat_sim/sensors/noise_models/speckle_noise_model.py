@@ -8,9 +8,16 @@ import attr
 import numpy as np
 from numpy import ndarray
 
+from habitat_sim.bindings import cuda_enabled
 from habitat_sim.registry import registry
 from habitat_sim.sensor import SensorType
-from habitat_sim.sensors.noise_models.sensor_noise_model import SensorNoiseModel
+from habitat_sim.sensors.noise_models.sensor_noise_model import (
+    SensorNoiseModel,
+    simulate_rgb_on_gpu,
+)
+
+if cuda_enabled:
+    from habitat_sim._ext.habitat_sim_bindings import RgbNoiseModelGPUImpl
 
 
 def _simulate(
@@ -44,15 +51,25 @@ class SpeckleNoiseModel(SensorNoiseModel):
     sigma: int = 1
 
     def __attrs_post_init__(self) -> None:
-        self._impl = SpeckleNoiseModelCPUImpl(
-            self.intensity_constant, self.mean, self.sigma
-        )
+        if cuda_enabled:
+            self._impl = RgbNoiseModelGPUImpl.speckle(
+                self.gpu_device_id if self.gpu_device_id is not None else 0,
+                self.intensity_constant,
+                self.mean,
+                self.sigma,
+            )
+        else:
+            self._impl = SpeckleNoiseModelCPUImpl(
+                self.intensity_constant, self.mean, self.sigma
+            )
 
     @staticmethod
     def is_valid_sensor_type(sensor_type: SensorType) -> bool:
         return sensor_type == SensorType.COLOR
 
     def simulate(self, image: ndarray) -> ndarray:
+        if cuda_enabled:
+            return simulate_rgb_on_gpu(self._impl, image)
         return self._impl.simulate(image)
 
     def apply(self, image: ndarray) -> ndarray:
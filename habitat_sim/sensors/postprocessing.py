@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+r"""Post-processing stages applied to sensor observations
+
+A sensor applies the stages listed in the ``postprocessing`` attribute of its
+`SensorSpec` in order, after its noise model. Every stage takes and returns
+either a numpy array or, with gpu2gpu transfer, a CUDA tensor, so
+observations that stay on the GPU are post-processed there too.
+Observations have top-down rows and the channels, if any, last.
+"""
+
+import abc
+from typing import Sequence, Union
+
+import attr
+import numpy as np
+from numpy import ndarray
+
+try:
+    import torch
+    from torch import Tensor
+except ImportError:
+    torch = None
+
+
+def _is_tensor(observation) -> bool:
+    return torch is not None and torch.is_tensor(observation)
+
+
+def _to_float(observation: Union[ndarray, "Tensor"]) -> Union[ndarray, "Tensor"]:
+    if _is_tensor(observation):
+        return observation.float()
+    return observation.astype(np.float32)
+
+
+def _cast_like(
+    observation: Union[ndarray, "Tensor"], reference: Union[ndarray, "Tensor"]
+) -> Union[ndarray, "Tensor"]:
+    r"""Casts a float observation back to the dtype of ``reference``,
+    rounding to integer dtypes
+    """
+    if _is_tensor(observation):
+        if reference.dtype.is_floating_point:
+            return observation.to(reference.dtype)
+        return observation.round().to(reference.dtype)
+    if np.issubdtype(reference.dtype, np.floating):
+        return observation.astype(reference.dtype)
+    return np.rint(observation).astype(reference.dtype)
+
+
+class PostprocessingStage(abc.ABC):
+    r"""Base class for all post-processing stages"""
+
+    @abc.abstractmethod
+    def apply(self, observation: Union[ndarray, "Tensor"]) -> Union[ndarray, "Tensor"]:
+        r"""Applies the stage to an observation
+
+        :param observation: The observation, should not be modified.
+
+        :return: The post-processed observation
+        """
+
+    def __call__(
+        self, observation: Union[ndarray, "Tensor"]
+    ) -> Union[ndarray, "Tensor"]:
+        r"""Alias of `apply()`"""
+        return self.apply(observation)
+
+
+@attr.s(auto_attribs=True, kw_only=True, slots=True)
+class Crop(PostprocessingStage):
+    r"""Crops the ``height`` x ``width`` pixels whose top left corner is at
+    row ``top`` and column ``left``
+    """
+    top: int = 0
+    left: int = 0
+    height: int
+    width: int
+
+    def apply(self, observation: Union[ndarray, "Tensor"]) -> Union[ndarray, "Tensor"]:
+        assert (
+            self.top + self.height <= observation.shape[0]
+            and self.left + self.width <= observation.shape[1]
+        ), "Crop outside of the {}x{} observation".format(*observation.shape[:2])
+        return observation[
+            self.top : self.top + self.height, self.left : self.left + self.width
+        ]
+
+
+@attr.s(auto_attribs=True, kw_only=True, slots=True)
+class Resize(PostprocessingStage):
+    r"""Resizes to ``height`` x ``width`` pixels
+
+    Downsampling by integer factors averages the pixels, which is what an
+    anti-aliased render at the smaller resolution approximates. Other sizes,
+    and all sizes with ``nearest``, pick the nearest pixel, which is what
+    semantic observations need as object ids can't be averaged.
+    """
+    height: int
+    width: int
+    nearest: bool = False
+
+    def apply(self, observation: Union[ndarray, "Tensor"]) -> Union[ndarray, "Tensor"]:
+        rows, cols = observation.shape[:2]
+        if (rows, cols) == (self.height, self.width):
+            return observation
+
+        if not self.nearest and rows % self.height == 0 and cols % self.width == 0:
+            factor_y = rows // self.height
+            factor_x = cols // self.width
+            blocks = _to_float(observation).reshape(
+                (self.height, factor_y, self.width, factor_x)
+                + tuple(observation.shape[2:])
+            )
+            if _is_tensor(blocks):
+                averaged = blocks.mean(dim=(1, 3))
+            else:
+                averaged = blocks.mean(axis=(1, 3))
+            return _cast_like(averaged, observation)
+
+        # the source pixel under the center of each output pixel
+        y = ((np.arange(self.height) + 0.5) * rows / self.height).astype(np.int64)
+        x = ((np.arange(self.width) + 0.5) * cols / self.width).astype(np.int64)
+        if _is_tensor(observation):
+            y = torch.from_numpy(y).to(observation.device)
+            x = torch.from_numpy(x).to(observation.device)
+            return observation.index_select(0, y).index_select(1, x)
+        return observation[y][:, x]
+
+
+@attr.s(auto_attribs=True, kw_only=True, slots=True)
+class Normalize(PostprocessingStage):
+    r"""Converts to float32 and normalizes as ``(observation - mean) / std``
+
+    ``mean`` and ``std`` are either scalars or have one value per channel,
+    e.g. ``mean=(123.675, 116.28, 103.53)`` for RGB observations.
+    """
+    mean: Union[float, Sequence[float]] = 0.0
+    std: Union[float, Sequence[float]] = 1.0
+
+    def apply(self, observation: Union[ndarray, "Tensor"]) -> Union[ndarray, "Tensor"]:
+        mean = np.asarray(self.mean, dtype=np.float32)
+        std = np.asarray(self.std, dtype=np.float32)
+        if _is_tensor(observation):
+            mean = torch.from_numpy(mean).to(observation.device)
+            std = torch.from_numpy(std).to(observation.device)
+        return (_to_float(observation) - mean) / std
+
+
+def apply_postprocessing(
+    stages: Sequence[PostprocessingStage], observation: Union[ndarray, "Tensor"]
+) -> Union[ndarray, "Tensor"]:
+    r"""Applies ``stages`` to ``observation`` in order"""
+    for stage in stages:
+        observation = stage(observation)
+    return observation
+
+
+__all__ = [
+    "PostprocessingStage",
+    "Crop",
+    "Resize",
+    "Normalize",
+    "apply_postprocessing",
+]
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+r"""Observations handed between processes through shared memory
+
+Multiprocess vector environments usually pickle the observations of each
+`Simulator` back over a pipe. Instead, the process of a simulator can write
+them with a `SharedObservationWriter` into a `SharedObservationRing`, a ring
+of slots in POSIX shared memory, the sensors reading straight into the slot
+when they have no noise model or postprocessing. Only the sequence number
+returned by `SharedObservationWriter.write()` goes through the pipe, and the
+main process gets the observations with a `SharedObservationReader`, as
+numpy arrays viewing the shared memory, without a copy.
+
+A slot is written again ``num_slots`` writes later, so the arrays of a step
+stay valid for ``num_slots - 1`` further steps, as reading in lockstep with
+the simulator does. `SharedObservationReader.is_current()` tells whether the
+arrays of a step were overwritten since.
+"""
+
+from typing import Dict, List, Optional
+
+import numpy as np
+from numpy import ndarray
+
+from habitat_sim._ext.habitat_sim_bindings import DataType, SharedObservationRing
+
+_DATA_TYPES = {
+    np.dtype(np.int8): DataType.INT8,
+    np.dtype(np.uint8): DataType.UINT8,
+    np.dtype(np.int16): DataType.INT16,
+    np.dtype(np.uint16): DataType.UINT16,
+    np.dtype(np.int32): DataType.INT32,
+    np.dtype(np.uint32): DataType.UINT32,
+    np.dtype(np.int64): DataType.INT64,
+    np.dtype(np.uint64): DataType.UINT64,
+    np.dtype(np.float16): DataType.FLOAT16,
+    np.dtype(np.float32): DataType.FLOAT,
+    np.dtype(np.float64): DataType.DOUBLE,
+}
+
+
+def _slot_arrays(ring: SharedObservationRing) -> List[Dict[str, ndarray]]:
+    return [
+        {field.name: ring.array(slot, i) for i, field in enumerate(ring.fields)}
+        for slot in range(ring.num_slots)
+    ]
+
+
+class SharedObservationWriter:
+    r"""Writes the observations of an agent of a simulator into a new
+    `SharedObservationRing`
+
+    :param sim: The simulator, a `habitat_sim.Simulator`
+    :param name: The name of the shared memory segment, e.g.
+        ``"/habitat-env-3"``, removed by `close()`
+    :param num_slots: The number of slots of the ring
+    :param agent_id: The agent, the default one if None
+
+    The fields of the slots are the observations of the sensors of the agent
+    drawn once on construction, with their shape and type after the noise
+    model and the postprocessing. The observations have to be numpy arrays:
+    with gpu2gpu transfer they stay on the GPU. A sensor without an
+    observation at a step, see `SensorSpec.render_interval`, leaves the older
+    contents of the slot.
+    """
+
+    def __init__(
+        self, sim, name: str, num_slots: int = 4, agent_id: Optional[int] = None
+    ) -> None:
+        self._sim = sim
+        self._agent_id = sim._default_agent_id if agent_id is None else agent_id
+        native_buffers = sim._draw_observations([self._agent_id])
+        if not sim.draw_and_read_observations(native_buffers):
+            raise RuntimeError(
+                "Drawing the sensor observations failed, see the log for details"
+            )
+        observations = sim._collect_observations([self._agent_id])[self._agent_id]
+        fields = []
+        for uuid, obs in observations.items():
+            if not isinstance(obs, ndarray) or obs.dtype not in _DATA_TYPES:
+                raise ValueError(
+                    "Expected a numpy array of a numeric type as the observation "
+                    "of {}, got {}".format(uuid, type(obs))
+                )
+            fields.append(
+                SharedObservationRing.Field(uuid, _DATA_TYPES[obs.dtype], obs.shape)
+            )
+        # the native reads of the sensors whose buffer is their observation go
+        # straight into the slots
+        self._direct = {
+            uuid
+            for uuid, buffer in native_buffers[self._agent_id].items()
+            if buffer.shape == observations[uuid].shape
+            and buffer.dtype == observations[uuid].dtype
+        }
+        self._ring = SharedObservationRing(name, fields, num_slots)
+        self._arrays = _slot_arrays(self._ring)
+
+    @property
+    def name(self) -> str:
+        return self._ring.name
+
+    def write(self) -> int:
+        r"""Draw the observations of the agent into the next slot and publish
+        it. Returns the sequence number to hand to the readers.
+        """
+        slot = self._ring.begin_write()
+        arrays = self._arrays[slot]
+        native_buffers = self._sim._draw_observations([self._agent_id])
+        agent_buffers = native_buffers[self._agent_id]
+        for uuid in agent_buffers:
+            if uuid in self._direct:
+                agent_buffers[uuid] = arrays[uuid]
+        if not self._sim.draw_and_read_observations(native_buffers):
+            raise RuntimeError(
+                "Drawing the sensor observations failed, see the log for details"
+            )
+        observations = self._sim._collect_observations(
+            [self._agent_id], native_buffers
+        )[self._agent_id]
+        for uuid, obs in observations.items():
+            if obs is not arrays[uuid]:
+                np.copyto(arrays[uuid], obs)
+        return self._ring.end_write(self._sim.get_world_time())
+
+    def close(self) -> None:
+        r"""Remove the shared memory segment, the readers keep their mapping"""
+        self._arrays = []
+        self._ring = None
+
+    def __enter__(self) -> "SharedObservationWriter":
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+
+class SharedObservationReader:
+    r"""Reads the observations a `SharedObservationWriter` of another process
+    writes
+
+    :param name: The name of the shared memory segment of the writer
+    """
+
+    def __init__(self, name: str) -> None:
+        self._ring = SharedObservationRing(name)
+        self._arrays = _slot_arrays(self._ring)
+
+    @property
+    def num_slots(self) -> int:
+        return self._ring.num_slots
+
+    @property
+    def latest_sequence(self) -> int:
+        r"""The sequence number of the last write, 0 before the first"""
+        return self._ring.latest_sequence
+
+    def observations(self, sequence: int) -> Dict[str, ndarray]:
+        r"""The observations of write sequence, read-only numpy arrays
+        viewing the shared memory
+        """
+        return self._arrays[self._slot(sequence)]
+
+    def timestamp(self, sequence: int) -> float:
+        r"""The world time of the simulator at write sequence"""
+        return self._ring.timestamp_of(self._slot(sequence))
+
+    def _slot(self, sequence: int) -> int:
+        if not self.is_current(sequence):
+            raise ValueError(
+                "The observations of write {} were overwritten or aren't "
+                "written yet".format(sequence)
+            )
+        return self._ring.slot_of(sequence)
+
+    def is_current(self, sequence: int) -> bool:
+        r"""Whether the slot of write sequence still holds its observations,
+        e.g. to check that copies made from them are consistent
+        """
+        return (
+            sequence > 0
+            and self._ring.sequence_of(self._ring.slot_of(sequence)) == sequence
+        )
+
+    def close(self) -> None:
+        self._arrays = []
+        self._ring = None
@@ -2,7 +2,16 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+from habitat_sim._ext.habitat_sim_bindings import MetadataMediator
 from habitat_sim._ext.habitat_sim_bindings import Simulator as SimulatorBackend
 from habitat_sim._ext.habitat_sim_bindings import SimulatorConfiguration
+from habitat_sim._ext.habitat_sim_bindings import (
+    VectorSimulator as VectorSimulatorBackend,
+)
 
-__all__ = ["SimulatorBackend", "SimulatorConfiguration"]
+__all__ = [
+    "MetadataMediator",
+    "SimulatorBackend",
+    "SimulatorConfiguration",
+    "VectorSimulatorBackend",
+]
@@ -4,11 +4,13 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+import multiprocessing
+import pickle
 import time
 from collections import OrderedDict
 from collections.abc import MutableMapping
 from os import path as osp
-from typing import Any, Dict, List
+from typing import Any, Callable, Dict, List
 from typing import MutableMapping as MutableMapping_T
 from typing import Optional, Union, cast, overload
 
@@ -20,6 +22,7 @@ from numpy import ndarray
 
 try:
     import torch
+    import torch.utils.dlpack
     from torch import Tensor
 
     _HAS_TORCH = True
@@ -28,14 +31,53 @@ except ImportError:
 
 import habitat_sim.errors
 from habitat_sim.agent.agent import Agent, AgentConfiguration, AgentState
+from habitat_sim.agent.controls import default_controls
+from habitat_sim.agent.controls.object_controls import ObjectControls
 from habitat_sim.bindings import cuda_enabled
 from habitat_sim.logging import logger
 from habitat_sim.nav import GreedyGeodesicFollower, NavMeshSettings, PathFinder
-from habitat_sim.sensor import SensorSpec, SensorType
+from habitat_sim.registry import registry
+from habitat_sim.scene import SceneNode
+from habitat_sim.sensor import (
+    Observation,
+    SensorSpec,
+    SensorType,
+    StaleObservationPolicy,
+)
 from habitat_sim.sensors.noise_models import make_sensor_noise_model
-from habitat_sim.sim import SimulatorBackend, SimulatorConfiguration
+from habitat_sim.sensors.postprocessing import apply_postprocessing
+from habitat_sim.sim import (
+    MetadataMediator,
+    SimulatorBackend,
+    SimulatorConfiguration,
+    VectorSimulatorBackend,
+)
 from habitat_sim.utils.common import quat_from_angle_axis
 
+# numpy dtype and number of channels of the pixel formats sensors read
+# observations in, see CameraSensor.observation_pixel_format
+_OBSERVATION_FORMATS = {
+    mn.PixelFormat.R32UI: (np.uint32, 1),
+    mn.PixelFormat.R32F: (np.float32, 1),
+    mn.PixelFormat.R16F: (np.float16, 1),
+    mn.PixelFormat.R16UI: (np.uint16, 1),
+    mn.PixelFormat.R8UI: (np.uint8, 1),
+    mn.PixelFormat.RGB8_UNORM: (np.uint8, 3),
+    mn.PixelFormat.RGBA8_UNORM: (np.uint8, 4),
+    mn.PixelFormat.RGB32F: (np.float32, 3),
+}
+
+# the default body actions SimulatorBackend.act_bodies takes natively, with
+# their C++ names and the move_fn they replace
+_NATIVE_BODY_ACTIONS = {
+    "move_forward": ("moveForward", default_controls.MoveForward),
+    "move_backward": ("moveBackward", default_controls.MoveBackward),
+    "move_left": ("moveLeft", default_controls.MoveLeft),
+    "move_right": ("moveRight", default_controls.MoveRight),
+    "turn_left": ("turnLeft", default_controls.LookLeft),
+    "turn_right": ("turnRight", default_controls.LookRight),
+}
+
 # TODO maybe clean up types with TypeVars
 
 
@@ -63,6 +105,16 @@ class Simulator(SimulatorBackend):
     The simulator ties together the backend, the agent, controls functions,
     NavMesh collision checking/pathfinding, attribute template management,
     object manipulation, and physics simulation.
+
+    Thread safety: the long-running calls release the GIL while in C++, e.g.
+    rendering the observations, `step_world()`, `recompute_navmesh()`,
+    `PathFinder.find_path()` and the `RenderTarget` reads, so other Python
+    threads, e.g. running policy inference, proceed meanwhile. The simulator,
+    including its pathfinder, renderer, scene graphs and sensors, is not
+    thread-safe itself: use it from one thread at a time, rendering only from
+    the thread that created it, as its OpenGL context is current there, and
+    don't modify the arguments of a call, such as a `ShortestPath` or the
+    arrays observations are read into, from another thread until it returns.
     """
 
     config: Configuration
@@ -75,6 +127,13 @@ class Simulator(SimulatorBackend):
         default=0.0, init=False
     )  # track the compute time of each step
     __last_state: Dict[int, AgentState] = attr.ib(factory=dict, init=False)
+    # the simulator whose assets and renderer the backend is created with, see
+    # create_sibling()
+    _sibling_of: Optional["Simulator"] = attr.ib(default=None, init=False)
+    # the already loaded metadata the backend is created with, see ForkServer
+    _metadata_mediator: Optional[MetadataMediator] = attr.ib(
+        default=None, init=False
+    )
 
     @staticmethod
     def _sanitize_config(config: Configuration) -> None:
@@ -185,16 +244,38 @@ class Simulator(SimulatorBackend):
 
     def _config_backend(self, config: Configuration) -> None:
         if not self._initialized:
-            super().__init__(config.sim_cfg)
+            if self._sibling_of is not None:
+                super().__init__(self._sibling_of, config.sim_cfg)
+                self._sibling_of = None
+            elif self._metadata_mediator is not None:
+                super().__init__(config.sim_cfg, self._metadata_mediator)
+                self._metadata_mediator = None
+            else:
+                super().__init__(config.sim_cfg)
             self._initialized = True
         else:
             super().reconfigure(config.sim_cfg)
 
-    def _config_agents(self, config: Configuration) -> None:
+    def _config_agents(
+        self, config: Configuration, old_config: Optional[Configuration] = None
+    ) -> List[bool]:
+        r"""Create the agents of config, keeping the ones of old_config whose
+        configuration is unchanged. Returns which agents were kept.
+        """
+        old_agents = self.agents if old_config is not None else []
+        kept = [
+            i < len(old_agents) and old_config.agents[i] == cfg
+            for i, cfg in enumerate(config.agents)
+        ]
         self.agents = [
-            Agent(self.get_active_scene_graph().get_root_node().create_child(), cfg)
-            for cfg in config.agents
+            old_agents[i]
+            if kept[i]
+            else Agent(
+                self.get_active_scene_graph().get_root_node().create_child(), cfg
+            )
+            for i, cfg in enumerate(config.agents)
         ]
+        return kept
 
     def _config_pathfinder(self, config: Configuration) -> None:
         scene_basename = osp.basename(config.sim_cfg.scene_id)
@@ -240,26 +321,117 @@ class Simulator(SimulatorBackend):
             self.__set_from_config(config)
             self.config = config
 
+    def fork(self) -> "Simulator":
+        r"""Branches the simulator into a copy to roll forward independently,
+        e.g. for tree search, without loading anything again
+
+        The copy shares the loaded assets, the renderer, the pathfinder and
+        the semantic scene of this simulator, and gets its own scene graph,
+        physics world, agents and sensors, in their current state. Both must be
+        used from the same thread, except for stepping their physics.
+        """
+        forked = Simulator._uninitialized()
+        # the agent configurations are extended by add_sensor()
+        forked.config = Configuration(
+            self.config.sim_cfg,
+            [
+                attr.evolve(cfg, sensor_specifications=list(cfg.sensor_specifications))
+                for cfg in self.config.agents
+            ],
+        )
+        SimulatorBackend.__init__(forked, self)
+        forked._initialized = True
+        forked._default_agent_id = self._default_agent_id
+
+        root_node = forked.get_active_scene_graph().get_root_node()
+        forked.agents = [
+            Agent(root_node.create_child(), cfg) for cfg in forked.config.agents
+        ]
+        forked.__sensors = [dict() for _ in forked.agents]
+        for agent_id, agent in enumerate(self.agents):
+            forked_agent = forked.agents[agent_id]
+            forked_agent.controls.move_filter_fn = forked.step_filter
+            forked_agent.initial_state = agent.initial_state
+            forked_agent.set_state(agent.get_state(), infer_sensor_states=False)
+            for uuid in self.__sensors[agent_id]:
+                forked._update_simulator_sensors(uuid, agent_id=agent_id)
+        forked.__last_state = dict(self.__last_state)
+        return forked
+
+    def create_sibling(self, config: Configuration) -> "Simulator":
+        r"""Creates a simulator of another scene of the same scene dataset,
+        to keep several scenes active at once
+
+        The sibling shares the loaded assets, the renderer and the metadata of
+        this simulator, so only the assets of its scene that aren't loaded yet
+        are loaded, and gets its own scene graph, physics world, pathfinder,
+        semantic scene, agents and sensors, configured by config. Both must be
+        used from the same thread, except for stepping their physics.
+        """
+        sibling = Simulator._uninitialized()
+        sibling.config = config
+        sibling._sibling_of = self
+        sibling.__attrs_post_init__()
+        return sibling
+
+    @staticmethod
+    def _uninitialized() -> "Simulator":
+        r"""A simulator with the default attributes, without a backend"""
+        sim = Simulator.__new__(Simulator)
+        for field in attr.fields(Simulator):
+            if isinstance(field.default, attr.Factory):
+                setattr(sim, field.name, field.default.factory())
+            elif field.default is not attr.NOTHING:
+                setattr(sim, field.name, field.default)
+        return sim
+
     def __set_from_config(self, config: Configuration) -> None:
+        # if the stage is kept, so is the scene graph the agents and their
+        # sensors are attached to, and the navmesh
+        old_config = (
+            self.config
+            if self._initialized and not self.is_stage_reload_required(config.sim_cfg)
+            else None
+        )
         self._config_backend(config)
-        self._config_agents(config)
-        self._config_pathfinder(config)
+        kept_agents = self._config_agents(config, old_config)
+        if old_config is None or not self._same_navmesh_agent(old_config, config):
+            self._config_pathfinder(config)
         self.frustum_culling = config.sim_cfg.frustum_culling
+        self.occlusion_culling = config.sim_cfg.occlusion_culling
 
         for i in range(len(self.agents)):
             self.agents[i].controls.move_filter_fn = self.step_filter
 
         self._default_agent_id = config.sim_cfg.default_agent_id
 
+        old_sensors = self.__sensors if old_config is not None else []
+        # the render targets of the replaced sensors are reused by the new ones
+        for i, agent_sensors in enumerate(old_sensors):
+            if i >= len(kept_agents) or not kept_agents[i]:
+                for sensor in agent_sensors.values():
+                    sensor.close()
         self.__sensors: List[Dict[str, Sensor]] = [
-            dict() for i in range(len(config.agents))
+            old_sensors[i] if kept_agents[i] else dict()
+            for i in range(len(config.agents))
         ]
         self.__last_state = dict()
         for agent_id, agent_cfg in enumerate(config.agents):
-            for spec in agent_cfg.sensor_specifications:
-                self._update_simulator_sensors(spec.uuid, agent_id=agent_id)
+            if not kept_agents[agent_id]:
+                for spec in agent_cfg.sensor_specifications:
+                    self._update_simulator_sensors(spec.uuid, agent_id=agent_id)
             self.initialize_agent(agent_id)
 
+    @staticmethod
+    def _same_navmesh_agent(a: Configuration, b: Configuration) -> bool:
+        r"""Whether the navmesh of a is valid for b, assuming the same stage"""
+        agent_a = a.agents[a.sim_cfg.default_agent_id]
+        agent_b = b.agents[b.sim_cfg.default_agent_id]
+        return bool(
+            np.isclose(agent_a.radius, agent_b.radius)
+            and np.isclose(agent_a.height, agent_b.height)
+        )
+
     def _update_simulator_sensors(self, uuid: str, agent_id: int) -> None:
         self.__sensors[agent_id][uuid] = Sensor(
             sim=self, agent=self.get_agent(agent_id), sensor_id=uuid
@@ -337,20 +509,86 @@ class Simulator(SimulatorBackend):
         else:
             return_single = False
 
+        native_buffers = self._draw_observations(agent_ids)
+        if not self.draw_and_read_observations(native_buffers):
+            raise RuntimeError(
+                "Drawing the sensor observations failed, see the log for details"
+            )
+
+        observations = self._collect_observations(agent_ids)
+        if return_single:
+            return next(iter(observations.values()))
+        return observations
+
+    def _draw_observations(self, agent_ids: List[int]) -> Dict[int, Dict[str, ndarray]]:
+        r"""Draw the sensors that are read on the GPU or by their noise
+        model, returning the buffers of the other sensors to be drawn and read
+        natively, by draw_and_read_observations()
+        """
+        native_buffers: Dict[int, Dict[str, ndarray]] = {}
         for agent_id in agent_ids:
             agent_sensorsuite = self.__sensors[agent_id]
+            native_buffers[agent_id] = {
+                uuid: sensor._buffer
+                for uuid, sensor in agent_sensorsuite.items()
+                if sensor._native_read
+            }
+            # sensors seeing the same view as an already drawn sensor read
+            # their attachment from its render target instead of drawing again
+            drawn_sensors: List[Sensor] = []
+            world_time = self.get_world_time()
             for _sensor_uuid, sensor in agent_sensorsuite.items():
-                sensor.draw_observation()
-
+                if sensor._native_read:
+                    continue
+                sensor._render_source = None
+                # sensors whose turn to be drawn it isn't get a stale observation
+                if not sensor._sensor_object.schedule_observation(world_time):
+                    continue
+                for drawn in drawn_sensors:
+                    if self.sensors_can_share_render_pass(
+                        drawn._sensor_object, sensor._sensor_object
+                    ):
+                        sensor._render_source = drawn
+                        break
+                if sensor._render_source is None:
+                    sensor.draw_observation()
+                    drawn_sensors.append(sensor)
+        return native_buffers
+
+    def _collect_observations(
+        self,
+        agent_ids: List[int],
+        native_buffers: Optional[Dict[int, Dict[str, ndarray]]] = None,
+    ) -> Dict[int, Dict[str, Union[ndarray, "Tensor"]]]:
+        r"""The observations of the sensors drawn by _draw_observations(),
+        once the native ones are read, into native_buffers if given, e.g. to
+        read into other buffers than those of the sensors
+        """
         # As backport. All Dicts are ordered in Python >= 3.7
         observations: Dict[int, Dict[str, Union[ndarray, "Tensor"]]] = OrderedDict()
         for agent_id in agent_ids:
             agent_observations: Dict[str, Union[ndarray, "Tensor"]] = {}
             for sensor_uuid, sensor in self.__sensors[agent_id].items():
-                agent_observations[sensor_uuid] = sensor.get_observation()
+                if sensor._sensor_object.observation_age != 0:
+                    if (
+                        sensor._spec.stale_observation_policy
+                        == StaleObservationPolicy.REPEAT
+                        and sensor._last_observation is not None
+                    ):
+                        agent_observations[sensor_uuid] = sensor._last_observation
+                    continue
+                if sensor._native_read:
+                    buffer = (
+                        native_buffers[agent_id][sensor_uuid]
+                        if native_buffers is not None
+                        else sensor._buffer
+                    )
+                    obs = sensor._finish_observation(buffer)
+                else:
+                    obs = sensor.get_observation()
+                sensor._last_observation = obs
+                agent_observations[sensor_uuid] = obs
             observations[agent_id] = agent_observations
-        if return_single:
-            return next(iter(observations.values()))
         return observations
 
     @property
@@ -378,6 +616,32 @@ class Simulator(SimulatorBackend):
             agent_id = self._default_agent_id
         return self.__last_state[agent_id]
 
+    def get_agent_rigid_states(
+        self, agent_ids: Optional[List[int]] = None, out: Optional[ndarray] = None
+    ) -> ndarray:
+        r"""The states of the bodies of agents, all of them by default, as an
+        agents x 7 float32 array of rotations in x, y, z, w order followed by
+        positions, see `SceneNode.get_rigid_states()`. Reading them into the
+        same out array each step allocates no states, unlike `last_state()`.
+        """
+        if agent_ids is None:
+            agent_ids = list(range(len(self.agents)))
+        return SceneNode.get_rigid_states(
+            [self.get_agent(agent_id).scene_node for agent_id in agent_ids], out
+        )
+
+    def set_agent_rigid_states(
+        self, states: ndarray, agent_ids: Optional[List[int]] = None
+    ) -> None:
+        r"""Move the bodies of agents, along with their sensors, to states in
+        the layout of `get_agent_rigid_states()`
+        """
+        if agent_ids is None:
+            agent_ids = list(range(len(self.agents)))
+        SceneNode.set_rigid_states(
+            [self.get_agent(agent_id).scene_node for agent_id in agent_ids], states
+        )
+
     @overload
     def step(
         self, action: Union[str, int], dt: float = 1.0 / 60.0
@@ -398,17 +662,12 @@ class Simulator(SimulatorBackend):
         Dict[str, Union[bool, ndarray, "Tensor"]],
         Dict[int, Dict[str, Union[bool, ndarray, "Tensor"]]],
     ]:
-        self._num_total_frames += 1
         if isinstance(action, MutableMapping):
             return_single = False
         else:
             action = cast(Dict[int, Union[str, int]], {self._default_agent_id: action})
             return_single = True
-        collided_dict: Dict[int, bool] = {}
-        for agent_id, agent_act in action.items():
-            agent = self.get_agent(agent_id)
-            collided_dict[agent_id] = agent.act(agent_act)
-            self.__last_state[agent_id] = agent.get_state()
+        collided_dict = self._act(action)
 
         # step physics by dt
         step_start_Time = time.time()
@@ -422,6 +681,56 @@ class Simulator(SimulatorBackend):
             return multi_observations[self._default_agent_id]
         return multi_observations
 
+    def _act(
+        self, action: MutableMapping_T[int, Union[str, int]]
+    ) -> Dict[int, bool]:
+        r"""Take the actions of the agents of a step, returning whether each
+        collided
+        """
+        self._num_total_frames += 1
+        collided_dict: Dict[int, bool] = {}
+        # the default body actions of all agents are taken by one native call,
+        # which filters their moves by the navmesh at once
+        native_ids: List[int] = []
+        bodies: List[SceneNode] = []
+        native_names: List[str] = []
+        amounts: List[float] = []
+        for agent_id, agent_act in action.items():
+            agent = self.get_agent(agent_id)
+            native_name = self._native_body_action(agent, agent_act)
+            if native_name is None:
+                collided_dict[agent_id] = agent.act(agent_act)
+                continue
+            habitat_sim.errors.assert_obj_valid(agent.body)
+            native_ids.append(agent_id)
+            bodies.append(agent.scene_node)
+            native_names.append(native_name)
+            amounts.append(agent.agent_config.action_space[agent_act].actuation.amount)
+        if native_ids:
+            collided = super().act_bodies(bodies, native_names, amounts)
+            collided_dict.update(zip(native_ids, collided))
+        for agent_id in action:
+            self.__last_state[agent_id] = self.get_agent(agent_id).get_state()
+        return collided_dict
+
+    def _native_body_action(self, agent: Agent, action_id: Any) -> Optional[str]:
+        r"""The C++ name of the action of agent if it is a default body action
+        filtered by `step_filter()`, which `act_bodies()` takes natively,
+        None otherwise
+        """
+        action = agent.agent_config.action_space.get(action_id)
+        if action is None or action.name not in _NATIVE_BODY_ACTIONS:
+            return None
+        native_name, move_fn_type = _NATIVE_BODY_ACTIONS[action.name]
+        if (
+            type(registry.get_move_fn(action.name)) is not move_fn_type
+            or getattr(action.actuation, "constraint", None) is not None
+            or type(agent.controls) is not ObjectControls
+            or agent.controls.move_filter_fn != self.step_filter
+        ):
+            return None
+        return native_name
+
     def make_greedy_follower(
         self,
         agent_id: Optional[int] = None,
@@ -450,7 +759,8 @@ class Simulator(SimulatorBackend):
 
     def step_filter(self, start_pos: Vector3, end_pos: Vector3) -> Vector3:
         r"""Computes a valid navigable end point given a target translation on the NavMesh.
-        Uses the configured sliding flag.
+        Uses the configured sliding flag. With kinematic_agent_collisions, the
+        stage and the objects block the move too, see collide_agent_moves().
 
         :param start_pos: The valid initial position of a translation.
         :param end_pos: The target end position of a translation.
@@ -460,6 +770,10 @@ class Simulator(SimulatorBackend):
                 end_pos = self.pathfinder.try_step(start_pos, end_pos)
             else:
                 end_pos = self.pathfinder.try_step_no_sliding(start_pos, end_pos)
+        if self.config.sim_cfg.kinematic_agent_collisions:
+            end_pos = self.collide_agent_moves(
+                [mn.Vector3(start_pos)], [mn.Vector3(end_pos)]
+            )[0]
 
         return end_pos
 
@@ -469,6 +783,222 @@ class Simulator(SimulatorBackend):
     def step_physics(self, dt: float, scene_id: int = 0) -> None:
         self.step_world(dt)
 
+    def save_checkpoint(self, path: str) -> bool:
+        r"""Save the simulation to path, to continue it with
+        `load_checkpoint()`, e.g. after the process was preempted. The states
+        of the agents and their sensors are saved along.
+        """
+        agent_states = [agent.get_state() for agent in self.agents]
+        return super().save_checkpoint(path, pickle.dumps(agent_states))
+
+    def load_checkpoint(self, path: str) -> bool:
+        r"""Continue the simulation saved by `save_checkpoint()` to path.
+        The simulator has to be configured for the scene of the checkpoint,
+        with the same agents. Returns False if the file is malformed, or if
+        not all its objects could be instanced.
+        """
+        user_data = super().load_checkpoint(path)
+        if user_data is None:
+            return False
+        agent_states = pickle.loads(user_data) if user_data else []
+        if len(agent_states) != len(self.agents):
+            return False
+        for agent, state in zip(self.agents, agent_states):
+            agent.set_state(state, reset_sensors=False, infer_sensor_states=False)
+        return True
+
+
+class VectorSimulator:
+    r"""Several environments in one process, sharing one OpenGL context,
+    renderer and asset cache
+
+    :param config: The configuration of the environments, or of each
+        environment
+    :param num_envs: The number of environments, implied by a configuration
+        per environment
+
+    With one configuration, the environments are a `Simulator` and copies of
+    it, see `Simulator.fork()`, so they start in the same state, in the same
+    scene. With a configuration each, they are a `Simulator` and siblings of
+    it, see `Simulator.create_sibling()`, each in its own scene of the same
+    scene dataset. Either way the shaders and the assets shared by several
+    environments are loaded once for all of them. A step takes the actions of the
+    agents of all environments, steps their physics concurrently and draws
+    their sensors before reading any. Use it from the thread that created it.
+    """
+
+    def __init__(
+        self,
+        config: Union[Configuration, List[Configuration]],
+        num_envs: Optional[int] = None,
+    ) -> None:
+        configs = config if isinstance(config, list) else None
+        if configs is not None:
+            if num_envs is not None and num_envs != len(configs):
+                raise ValueError(
+                    "Expected {} configurations, got {}".format(num_envs, len(configs))
+                )
+            num_envs = len(configs)
+        if num_envs is None or num_envs < 1:
+            raise ValueError("Expected at least one environment")
+        if configs is not None:
+            base = Simulator(configs[0])
+            self.envs: List[Simulator] = [base] + [
+                base.create_sibling(cfg) for cfg in configs[1:]
+            ]
+        else:
+            base = Simulator(config)
+            self.envs = [base] + [base.fork() for _ in range(num_envs - 1)]
+        self._backend = VectorSimulatorBackend(self.envs)
+
+    @property
+    def num_envs(self) -> int:
+        return len(self.envs)
+
+    def seed(self, new_seed: int) -> None:
+        r"""Seed the environment i with new_seed + i"""
+        for i, env in enumerate(self.envs):
+            env.seed(new_seed + i)
+
+    def step(
+        self, actions: List[Union[str, int]], dt: float = 1.0 / 60.0
+    ) -> List[Dict[str, Union[bool, ndarray, "Tensor"]]]:
+        r"""Take an action with the default agent of each environment
+
+        :param actions: The action of each environment
+        :param dt: The physics time step
+        :return: The observations of each environment, as
+            `Simulator.step()`
+        """
+        if len(actions) != self.num_envs:
+            raise ValueError(
+                "Expected {} actions, got {}".format(self.num_envs, len(actions))
+            )
+        collided = [
+            env._act({env._default_agent_id: action})[env._default_agent_id]
+            for env, action in zip(self.envs, actions)
+        ]
+        self._backend.step_world(dt)
+        observations = self.get_sensor_observations()
+        for env_observations, env_collided in zip(observations, collided):
+            env_observations["collided"] = env_collided
+        return observations
+
+    def get_sensor_observations(self) -> List[Dict[str, Union[ndarray, "Tensor"]]]:
+        r"""The observations of the default agent of each environment, all
+        drawn before any is read
+        """
+        native_buffers = [
+            env._draw_observations([env._default_agent_id]) for env in self.envs
+        ]
+        if not self._backend.draw_and_read_observations(native_buffers):
+            raise RuntimeError(
+                "Drawing the sensor observations failed, see the log for details"
+            )
+        return [
+            env._collect_observations([env._default_agent_id])[env._default_agent_id]
+            for env in self.envs
+        ]
+
+    def close(self) -> None:
+        # the copies first, the assets are kept until the last one is closed
+        for env in reversed(self.envs):
+            env.close()
+        self.envs = []
+        self._backend = None
+
+    def __enter__(self) -> "VectorSimulator":
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+
+class ForkServer:
+    r"""Loads a scene dataset and the stages of its environments once, then
+    forks worker processes which start their simulators from them
+
+    :param config: The configuration of the environments to preload, or of
+        each one
+
+    The parent process parses the scene dataset configs into a
+    `MetadataMediator` and loads the parts of each stage which need no OpenGL
+    context, its navmesh and semantic scene, see
+    `SimulatorBackend.preload_scene()`, and reads its assets once into the OS
+    file cache. The worker processes are forked from it, so they inherit all
+    of it copy-on-write, and their `Simulator` only creates its OpenGL
+    context and uploads the render assets. The workers start their own
+    context, so the parent process must not create a renderer before forking,
+    and forking is only available on POSIX systems.
+
+    .. code:: py
+
+        def run(sim, queue):
+            queue.put(sim.step("move_forward")["collided"])
+
+        with ForkServer(config) as server:
+            queue = server.context.Queue()
+            server.start_worker(config, run, queue)
+            collided = queue.get()
+    """
+
+    def __init__(self, config: Union[Configuration, List[Configuration]]) -> None:
+        configs = config if isinstance(config, list) else [config]
+        if not configs:
+            raise ValueError("Expected at least one configuration")
+        self.context = multiprocessing.get_context("fork")
+        self.metadata_mediator = MetadataMediator(
+            configs[0].sim_cfg.scene_dataset_config_file
+        )
+        for cfg in configs:
+            SimulatorBackend.preload_scene(cfg.sim_cfg, self.metadata_mediator)
+        self.workers: List[multiprocessing.process.BaseProcess] = []
+
+    def create_simulator(self, config: Configuration) -> Simulator:
+        r"""A simulator of config using the preloaded metadata and stages,
+        in the calling process
+        """
+        sim = Simulator._uninitialized()
+        sim.config = config
+        sim._metadata_mediator = self.metadata_mediator
+        sim.__attrs_post_init__()
+        return sim
+
+    def start_worker(
+        self,
+        config: Configuration,
+        target: Callable[..., Any],
+        *args: Any,
+    ) -> multiprocessing.process.BaseProcess:
+        r"""Fork a worker process which calls target with a simulator of
+        config and args, closing the simulator when it returns
+
+        :return: The started process, also appended to `workers`. Pass data
+            back to the parent through e.g. a queue of `context`.
+        """
+
+        def run() -> None:
+            with self.create_simulator(config) as sim:
+                target(sim, *args)
+
+        worker = self.context.Process(target=run, daemon=True)
+        worker.start()
+        self.workers.append(worker)
+        return worker
+
+    def close(self) -> None:
+        r"""Wait for the workers to exit and drop the preloaded stages"""
+        for worker in self.workers:
+            worker.join()
+        self.workers = []
+        SimulatorBackend.clear_preloaded_scenes()
+
+    def __enter__(self) -> "ForkServer":
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
 
 class Sensor:
     r"""Wrapper around habitat_sim.Sensor
@@ -485,8 +1015,26 @@ class Sensor:
         self._sensor_object = self._agent._sensors[sensor_id]
 
         self._spec = self._sensor_object.specification()
-
-        self._sim.renderer.bind_render_target(self._sensor_object)
+        # the sensor whose render pass this sensor's observation is read from
+        self._render_source: Optional["Sensor"] = None
+
+        # e.g. a LidarSensor, which computes its observation itself in
+        # get_observation(), with no render pass
+        self._is_visual = self._sensor_object.is_visual_sensor()
+        if not self._is_visual:
+            assert (
+                self._spec.noise_model == "None"
+            ), "Sensor '{}' takes no noise model".format(self._spec.uuid)
+            self._buffer = None
+            self._noise_model = make_sensor_noise_model("None", {})
+            self._noise_reads_render_target = False
+            self._postprocessing = list(self._spec.postprocessing)
+            self._native_read = False
+            return
+
+        # follows the encoding of the spec, e.g. RGB8 for "rgb_uint8"
+        self._pixel_format = self._sensor_object.observation_pixel_format
+        dtype, channels = _OBSERVATION_FORMATS[self._pixel_format]
 
         if self._spec.gpu2gpu_transfer:
             assert cuda_enabled, "Must build habitat sim with cuda for gpu2gpu-transfer"
@@ -494,8 +1042,15 @@ class Sensor:
             device = torch.device("cuda", self._sim.gpu_device)  # type: ignore[attr-defined]
             torch.cuda.set_device(device)
 
-            resolution = self._spec.resolution
-            if self._spec.sensor_type == SensorType.SEMANTIC:
+            # rows by columns of the read region
+            size = self._sensor_object.observation_size
+            resolution = (size[1], size[0])
+            if self._spec.sensor_type == SensorType.POINT_CLOUD:
+                size = self._sensor_object.observation_size
+                self._buffer = torch.empty(
+                    size[0] * size[1], channels, dtype=torch.float32, device=device
+                )
+            elif self._spec.sensor_type == SensorType.SEMANTIC:
                 self._buffer = torch.empty(
                     resolution[0], resolution[1], dtype=torch.int32, device=device
                 )
@@ -503,30 +1058,32 @@ class Sensor:
                 self._buffer = torch.empty(
                     resolution[0], resolution[1], dtype=torch.float32, device=device
                 )
-            else:
+            elif self._spec.sensor_type == SensorType.NORMAL:
                 self._buffer = torch.empty(
-                    resolution[0], resolution[1], 4, dtype=torch.uint8, device=device
-                )
-        else:
-            if self._spec.sensor_type == SensorType.SEMANTIC:
-                self._buffer = np.empty(
-                    (self._spec.resolution[0], self._spec.resolution[1]),
-                    dtype=np.uint32,
-                )
-            elif self._spec.sensor_type == SensorType.DEPTH:
-                self._buffer = np.empty(
-                    (self._spec.resolution[0], self._spec.resolution[1]),
-                    dtype=np.float32,
+                    resolution[0],
+                    resolution[1],
+                    channels,
+                    dtype=torch.float32,
+                    device=device,
                 )
             else:
-                self._buffer = np.empty(
-                    (
-                        self._spec.resolution[0],
-                        self._spec.resolution[1],
-                        self._spec.channels,
-                    ),
-                    dtype=np.uint8,
+                self._buffer = torch.empty(
+                    resolution[0],
+                    resolution[1],
+                    channels,
+                    dtype=torch.uint8,
+                    device=device,
                 )
+        elif self._spec.sensor_type == SensorType.POINT_CLOUD:
+            # a list of the points of the subsampled pixels
+            size = self._sensor_object.observation_size
+            self._buffer = np.empty((size[0] * size[1], channels), dtype=dtype)
+        else:
+            size = self._sensor_object.observation_size
+            shape = (size[1], size[0])
+            if channels > 1:
+                shape += (channels,)
+            self._buffer = np.empty(shape, dtype=dtype)
 
         noise_model_kwargs = self._spec.noise_model_kwargs
         self._noise_model = make_sensor_noise_model(
@@ -538,8 +1095,42 @@ class Sensor:
         ), "Noise model '{}' is not valid for sensor '{}'".format(
             self._spec.noise_model, self._spec.uuid
         )
+        if self._spec.noise_model != "None":
+            assert self._pixel_format in (
+                mn.PixelFormat.R32F,
+                mn.PixelFormat.RGBA8_UNORM,
+            ), "Noise models need float32 depth or RGBA8 color, not '{}'".format(
+                self._spec.encoding
+            )
+        # the noise model reads the frame itself, keeping it on the GPU
+        self._noise_reads_render_target = self._noise_model.applies_to_render_target
+        assert not self._noise_reads_render_target or not any(
+            key in self._spec.parameters for key in ("read_region", "read_stride")
+        ), "The noise model of sensor '{}' reads the whole frame".format(
+            self._spec.uuid
+        )
+        self._postprocessing = list(self._spec.postprocessing)
+        # whether Simulator.get_sensor_observations() draws and reads this
+        # sensor natively, with the others, into its host buffer
+        self._native_read = (
+            not self._spec.gpu2gpu_transfer and not self._noise_reads_render_target
+        )
+
+        # drawn upside down, so that the reads are contiguous top-down
+        # observations; the noise models reading the render target flip the
+        # rows themselves
+        self._sim.renderer.bind_render_target(
+            self._sensor_object, top_down_rows=not self._noise_reads_render_target
+        )
 
     def draw_observation(self) -> None:
+        # this sensor now owns the frame it reads from
+        self._render_source = None
+        # the last observation, repeated while the sensor isn't due to be drawn
+        self._last_observation: Optional[Union[ndarray, "Tensor"]] = None
+        if not self._is_visual:
+            return
+
         # sanity check:
 
         # see if the sensor is attached to a scene graph, otherwise it is invalid,
@@ -557,6 +1148,7 @@ class Sensor:
                     "SemanticSensor observation requested but no SemanticScene is loaded"
                 )
             scene = self._sim.get_active_semantic_scene_graph()
+            self._sensor_object.update_object_id_remapping(self._sim.semantic_scene)
         else:  # SensorType is DEPTH or any other type
             scene = self._sim.get_active_scene_graph()
 
@@ -575,6 +1167,9 @@ class Sensor:
         if self._sim.frustum_culling:
             render_flags |= habitat_sim.gfx.Camera.Flags.FRUSTUM_CULLING
 
+        if self._sim.occlusion_culling:
+            render_flags |= habitat_sim.gfx.Camera.Flags.OCCLUSION_CULLING
+
         with self._sensor_object.render_target:
             self._sim.renderer.draw(self._sensor_object, scene, render_flags)
 
@@ -590,45 +1185,119 @@ class Sensor:
                 self._sensor_object, self._sim.get_active_scene_graph(), render_flags
             )
 
+        # start the readback now so it overlaps with drawing the other sensors
+        if (
+            self._spec.async_readback
+            and not self._spec.gpu2gpu_transfer
+            and not self._noise_reads_render_target
+        ):
+            tgt = self._sensor_object.render_target
+            self._sensor_object.set_read_region_of(tgt)
+            if self._spec.sensor_type == SensorType.SEMANTIC:
+                tgt.read_frame_object_id_async(
+                    self._pixel_format, self._sensor_object.object_id_remapping
+                )
+            elif self._spec.sensor_type == SensorType.DEPTH:
+                tgt.read_frame_depth_async(self._pixel_format)
+            elif self._spec.sensor_type == SensorType.NORMAL:
+                tgt.read_frame_normal_async()
+            elif self._spec.sensor_type == SensorType.POINT_CLOUD:
+                tgt.read_frame_points_async(
+                    self._sensor_object.point_cloud_transformation,
+                    self._sensor_object.point_cloud_stride,
+                )
+            else:
+                tgt.read_frame_rgba_async(self._pixel_format)
+
     def get_observation(self) -> Union[ndarray, "Tensor"]:
+        if not self._is_visual:
+            native_obs = Observation()
+            if not self._sensor_object.get_observation(self._sim, native_obs):
+                raise RuntimeError(
+                    "Reading the observation of sensor '{}' failed".format(
+                        self._spec.uuid
+                    )
+                )
+            # a view of the sensor's observation buffers
+            return self._finish_observation(np.array(native_obs.buffer, copy=False))
 
-        tgt = self._sensor_object.render_target
+        if self._render_source is not None:
+            # drawn in the same pass as another sensor with an identical view
+            tgt = self._render_source._sensor_object.render_target
+            if self._spec.sensor_type == SensorType.SEMANTIC:
+                self._sensor_object.update_object_id_remapping(
+                    self._sim.semantic_scene
+                )
+        else:
+            tgt = self._sensor_object.render_target
+
+        if self._noise_reads_render_target:
+            # the noisy observation already has top-down rows
+            if self._spec.gpu2gpu_transfer:
+                with torch.cuda.device(self._buffer.device):  # type: ignore[attr-defined]
+                    obs = torch.empty_like(self._buffer)
+                    self._noise_model.apply_to_render_target(tgt, obs)
+            else:
+                obs = self._buffer
+                self._noise_model.apply_to_render_target(tgt, obs)
+            return apply_postprocessing(self._postprocessing, obs)
 
         if self._spec.gpu2gpu_transfer:
-            with torch.cuda.device(self._buffer.device):  # type: ignore[attr-defined]
-                if self._spec.sensor_type == SensorType.SEMANTIC:
-                    tgt.read_frame_object_id_gpu(self._buffer.data_ptr())  # type: ignore[attr-defined]
-                elif self._spec.sensor_type == SensorType.DEPTH:
-                    tgt.read_frame_depth_gpu(self._buffer.data_ptr())  # type: ignore[attr-defined]
-                else:
-                    tgt.read_frame_rgba_gpu(self._buffer.data_ptr())  # type: ignore[attr-defined]
-
-                obs = self._buffer.flip(0)
+            # read into the next device buffer of the sensor's ring, kept
+            # alive by the tensor, asynchronously on the current stream of
+            # torch, so that the work on other streams overlaps with the read
+            stream = torch.cuda.current_stream(self._buffer.device).cuda_stream
+            device_buffer = self._sensor_object.read_observation_from(
+                tgt, stream=stream
+            ).device_buffer
+            obs = torch.utils.dlpack.from_dlpack(device_buffer.__dlpack__(stream))
         else:
-            size = self._sensor_object.framebuffer_size
+            # the rows of the buffer are tightly packed, RGB8 and 16-bit rows
+            # aren't necessarily aligned to four bytes
+            storage = mn.PixelStorage()
+            storage.alignment = 1
+            size = self._sensor_object.observation_size
+            view = mn.MutableImageView2D(
+                storage,
+                self._pixel_format,
+                size,
+                self._buffer.reshape(size[1], -1),
+            )
 
-            if self._spec.sensor_type == SensorType.SEMANTIC:
+            self._sensor_object.set_read_region_of(tgt)
+            if tgt.has_pending_read:
+                tgt.fence(view)
+            elif self._spec.sensor_type == SensorType.SEMANTIC:
                 tgt.read_frame_object_id(
-                    mn.MutableImageView2D(mn.PixelFormat.R32UI, size, self._buffer)
+                    view, self._sensor_object.object_id_remapping
                 )
             elif self._spec.sensor_type == SensorType.DEPTH:
-                tgt.read_frame_depth(
-                    mn.MutableImageView2D(mn.PixelFormat.R32F, size, self._buffer)
+                tgt.read_frame_depth(view)
+            elif self._spec.sensor_type == SensorType.NORMAL:
+                tgt.read_frame_normal(view)
+            elif self._spec.sensor_type == SensorType.POINT_CLOUD:
+                tgt.read_frame_points(
+                    view,
+                    self._sensor_object.point_cloud_transformation,
+                    self._sensor_object.point_cloud_stride,
                 )
             else:
-                tgt.read_frame_rgba(
-                    mn.MutableImageView2D(
-                        mn.PixelFormat.RGBA8_UNORM,
-                        size,
-                        self._buffer.reshape(self._spec.resolution[0], -1),
-                    )
-                )
+                tgt.read_frame_rgba(view)
+
+            obs = self._buffer
 
-            obs = np.flip(self._buffer, axis=0)
+        return self._finish_observation(obs)
 
-        return self._noise_model(obs)
+    def _finish_observation(
+        self, obs: Union[ndarray, "Tensor"]
+    ) -> Union[ndarray, "Tensor"]:
+        r"""Apply the noise model and the postprocessing to a read observation"""
+        return apply_postprocessing(self._postprocessing, self._noise_model(obs))
 
     def close(self) -> None:
+        # back to the pool of the renderer, for the sensors created next
+        if self._sim is not None and self._sensor_object is not None:
+            self._sim.renderer.release_render_target(self._sensor_object)
         self._sim = None
         self._agent = None
         self._sensor_object = None
@@ -31,6 +31,11 @@ path/to/nvidia/nsight-systems/bin/nsys profile --sample=none --trace=cuda,nvtx
 --trace-fork-before-exec=true --output=my_profile python my_program.py
 # look for my_profile.qdrep in working directory
 
+HABITAT_PROFILING also enables the ranges of the C++ hot paths (rendering,
+culling, readback, physics steps, asset loading and navmesh queries), which
+nest under the Python ranges in the profile. They need libnvToolsExt.so of the
+CUDA toolkit to be found by the dynamic loader.
+
 Example usage for capturing a certain range of train steps (from step 200 to
 step 300):
 
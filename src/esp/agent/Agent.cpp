@@ -9,6 +9,8 @@
 
 #include "esp/scene/ObjectControls.h"
 #include "esp/sensor/CameraSensor.h"
+#include "esp/sensor/CubeMapSensor.h"
+#include "esp/sensor/LidarSensor.h"
 #include "esp/sensor/Sensor.h"
 
 using Magnum::EigenIntegration::cast;
@@ -31,7 +33,14 @@ Agent::Agent(scene::SceneNode& agentNode, const AgentConfiguration& cfg)
     // sensor
 
     auto& sensorNode = agentNode.createChild();
-    sensors_.add(sensor::CameraSensor::create(sensorNode, spec));
+    if (spec->sensorType == sensor::SensorType::Lidar) {
+      sensors_.add(sensor::LidarSensor::create(sensorNode, spec));
+    } else if (sensor::CubeMapSensor::isCubeMapCameraType(
+                   spec->sensorSubType)) {
+      sensors_.add(sensor::CubeMapSensor::create(sensorNode, spec));
+    } else {
+      sensors_.add(sensor::CameraSensor::create(sensorNode, spec));
+    }
   }
 }  // Agent::Agent
 
@@ -0,0 +1,136 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "BakedLightingCache.h"
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Directory.h>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "esp/core/MappedFile.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 'l', 'i', 't', 'e', '\0'};
+constexpr std::uint32_t Version = 1;
+
+// followed by vertexCount Color4s
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t padding;
+  std::uint64_t sourceSize;
+  std::int64_t sourceModified;
+  std::uint64_t lightingHash;
+  std::uint64_t vertexCount;
+};
+
+struct SourceStamp {
+  std::uint64_t size;
+  std::int64_t modified;
+};
+
+bool sourceStamp(const std::string& filename, SourceStamp& stamp) {
+  struct stat status;
+  if (::stat(filename.c_str(), &status) != 0) {
+    return false;
+  }
+  stamp.size = status.st_size;
+  stamp.modified = status.st_mtime;
+  return true;
+}
+
+}  // namespace
+
+BakedLightingCache::BakedLightingCache(std::string directory)
+    : directory_{std::move(directory)} {
+  if (!Cr::Utility::Directory::mkpath(directory_)) {
+    LOG(WARNING) << "BakedLightingCache: cannot create " << directory_
+                 << ", baked lighting won't be cached";
+  }
+}
+
+std::string BakedLightingCache::cacheFilename(
+    const std::string& assetFilename,
+    int meshIndex,
+    std::uint64_t lightingHash) const {
+  char hashes[34];
+  std::snprintf(hashes, sizeof(hashes), "%016llx.%016llx",
+                static_cast<unsigned long long>(core::hashBytes(
+                    {assetFilename.data(), assetFilename.size()})),
+                static_cast<unsigned long long>(lightingHash));
+  return Cr::Utility::Directory::join(
+      directory_, Cr::Utility::Directory::filename(assetFilename) + "." +
+                      hashes + "." + std::to_string(meshIndex) + ".light");
+}
+
+Cr::Containers::Array<Mn::Color4> BakedLightingCache::load(
+    const std::string& assetFilename,
+    int meshIndex,
+    std::uint64_t lightingHash,
+    std::size_t vertexCount) const {
+  SourceStamp stamp;
+  if (!sourceStamp(assetFilename, stamp)) {
+    return {};
+  }
+  Cr::Containers::Array<char> file =
+      core::mapFile(cacheFilename(assetFilename, meshIndex, lightingHash));
+  if (file.size() != sizeof(FileHeader) + vertexCount * sizeof(Mn::Color4)) {
+    return {};
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version || header.sourceSize != stamp.size ||
+      header.sourceModified != stamp.modified ||
+      header.lightingHash != lightingHash ||
+      header.vertexCount != vertexCount) {
+    return {};
+  }
+  Cr::Containers::Array<Mn::Color4> colors{Cr::Containers::NoInit,
+                                           vertexCount};
+  std::memcpy(colors.data(), file.data() + sizeof(FileHeader),
+              vertexCount * sizeof(Mn::Color4));
+  return colors;
+}
+
+bool BakedLightingCache::store(
+    const std::string& assetFilename,
+    int meshIndex,
+    std::uint64_t lightingHash,
+    Cr::Containers::ArrayView<const Mn::Color4> colors) const {
+  SourceStamp stamp;
+  if (!sourceStamp(assetFilename, stamp)) {
+    return false;
+  }
+  FileHeader header{};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.sourceSize = stamp.size;
+  header.sourceModified = stamp.modified;
+  header.lightingHash = lightingHash;
+  header.vertexCount = colors.size();
+
+  Cr::Containers::Array<char> data{
+      Cr::Containers::NoInit,
+      sizeof(FileHeader) + colors.size() * sizeof(Mn::Color4)};
+  std::memcpy(data.data(), &header, sizeof(header));
+  if (!colors.empty()) {
+    std::memcpy(data.data() + sizeof(FileHeader), colors.data(),
+                colors.size() * sizeof(Mn::Color4));
+  }
+  return core::writeFileAtomically(
+      cacheFilename(assetFilename, meshIndex, lightingHash), data);
+}
+
+}  // namespace assets
+}  // namespace esp
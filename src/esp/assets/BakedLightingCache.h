@@ -0,0 +1,85 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_BAKEDLIGHTINGCACHE_H_
+#define ESP_ASSETS_BAKEDLIGHTINGCACHE_H_
+
+/** @file
+ * @brief Class @ref esp::assets::BakedLightingCache
+ */
+
+#include <Corrade/Containers/Array.h>
+#include <Magnum/Math/Color.h>
+#include <cstdint>
+#include <string>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief On-disk cache of the vertex colors baked by
+ * @ref gfx::bakeVertexLighting() for the merged meshes of static assets
+ *
+ * Every merged mesh and lighting, identified by
+ * @ref gfx::bakedLightingHash(), is stored in its own file named after the
+ * asset filename, the index of the merged mesh and the hash. Files are stale
+ * once the size or the modification time of the asset changes. Like the
+ * @ref MeshCache they are written atomically, so several processes can share
+ * a directory, and loading and storing are safe to call from multiple
+ * threads.
+ */
+class BakedLightingCache {
+ public:
+  /**
+   * @brief Constructor
+   * @param directory, the cache directory, created if it doesn't exist
+   */
+  explicit BakedLightingCache(std::string directory);
+
+  /** @brief The cache directory */
+  const std::string& directory() const { return directory_; }
+
+  /**
+   * @brief Load the colors of merged mesh @p meshIndex of @p assetFilename
+   * @param assetFilename, the asset the mesh was merged from
+   * @param meshIndex, the index of the merged mesh
+   * @param lightingHash, the hash of the lighting the colors were baked with
+   * @param vertexCount, the vertex count of the mesh
+   * @return empty if the colors are not cached or are stale
+   */
+  Corrade::Containers::Array<Magnum::Color4> load(
+      const std::string& assetFilename,
+      int meshIndex,
+      std::uint64_t lightingHash,
+      std::size_t vertexCount) const;
+
+  /**
+   * @brief Store the colors of merged mesh @p meshIndex of @p assetFilename
+   * @return false if the file can't be written
+   */
+  bool store(const std::string& assetFilename,
+             int meshIndex,
+             std::uint64_t lightingHash,
+             Corrade::Containers::ArrayView<const Magnum::Color4> colors) const;
+
+  /**
+   * @brief The file the colors of merged mesh @p meshIndex of
+   * @p assetFilename with @p lightingHash are cached in
+   */
+  std::string cacheFilename(const std::string& assetFilename,
+                            int meshIndex,
+                            std::uint64_t lightingHash) const;
+
+ private:
+  std::string directory_;
+
+  ESP_SMART_POINTERS(BakedLightingCache)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_BAKEDLIGHTINGCACHE_H_
@@ -104,6 +104,20 @@ class BaseMesh {
    */
   virtual void uploadBuffersToGPU(bool){};
 
+  /**
+   * @brief Free the CPU copy of the mesh data once it's on the GPU
+   *
+   * The mesh still draws. Its @ref getMeshData() and @ref collisionMeshData_
+   * are empty until the data is set again. Does nothing for meshes not
+   * uploaded yet or whose type doesn't support it, which is all but
+   * @ref GenericMeshData.
+   * @return Whether the data was freed.
+   */
+  virtual bool releaseHostData() { return false; }
+
+  /** @brief Whether @ref releaseHostData() freed the mesh data */
+  bool isHostDataReleased() const { return hostDataReleased_; }
+
   /**
    * @brief Get a pointer to the compiled rendering buffer for the asset.
    *
@@ -164,6 +178,12 @@ class BaseMesh {
    */
   bool buffersOnGPU_ = false;
 
+  /**
+   * @brief Whether the CPU copy of the mesh data was freed, see
+   * @ref releaseHostData()
+   */
+  bool hostDataReleased_ = false;
+
   // ==== rendering ===
   /**
    * @brief Optional storage container for mesh render data.
@@ -0,0 +1,165 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CompressedTextureCache.h"
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/PixelFormat.h>
+#include <cstdio>
+#include <cstring>
+
+#include "esp/core/MappedFile.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 't', 'e', 'x', '\0', '\0'};
+// bump when the compression changes, so older files are compressed again
+constexpr std::uint32_t Version = 1;
+
+// followed by levelCount LevelHeaders, then the data of the levels
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t format;
+  std::uint64_t sourceHash;
+  std::uint64_t levelCount;
+};
+
+struct LevelHeader {
+  std::int32_t width;
+  std::int32_t height;
+  std::uint64_t size;
+};
+
+// hashed in front of the pixels
+struct SourceHeader {
+  std::uint32_t format;
+  std::int32_t width;
+  std::int32_t height;
+  std::uint32_t levelCount;
+};
+
+}  // namespace
+
+CompressedTextureCache::CompressedTextureCache(std::string directory)
+    : directory_{std::move(directory)} {
+  if (!Cr::Utility::Directory::mkpath(directory_)) {
+    LOG(WARNING) << "CompressedTextureCache: cannot create " << directory_
+                 << ", compressed textures won't be cached";
+  }
+}
+
+std::uint64_t CompressedTextureCache::sourceHash(
+    const Mn::Trade::ImageData2D& image,
+    std::size_t levelCount) {
+  SourceHeader header{};
+  header.format = image.isCompressed()
+                      ? 0x80000000u | Mn::UnsignedInt(image.compressedFormat())
+                      : Mn::UnsignedInt(image.format());
+  header.width = image.size().x();
+  header.height = image.size().y();
+  header.levelCount = levelCount;
+  return core::hashBytesXXH64(
+      image.data(), core::hashBytes({reinterpret_cast<const char*>(&header),
+                                     sizeof(header)}));
+}
+
+std::string CompressedTextureCache::cacheFilename(
+    std::uint64_t sourceHash) const {
+  char name[22];
+  std::snprintf(name, sizeof(name), "%016llx.tex",
+                static_cast<unsigned long long>(sourceHash));
+  return Cr::Utility::Directory::join(directory_, name);
+}
+
+std::vector<Mn::Trade::ImageData2D> CompressedTextureCache::load(
+    std::uint64_t sourceHash) const {
+  std::vector<Mn::Trade::ImageData2D> levels;
+  Cr::Containers::Array<char> file = core::mapFile(cacheFilename(sourceHash));
+  if (file.size() < sizeof(FileHeader)) {
+    return levels;
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version || header.sourceHash != sourceHash ||
+      header.levelCount == 0 ||
+      header.levelCount >
+          (file.size() - sizeof(FileHeader)) / sizeof(LevelHeader)) {
+    return levels;
+  }
+
+  std::vector<LevelHeader> levelHeaders(header.levelCount);
+  std::memcpy(levelHeaders.data(), file.data() + sizeof(FileHeader),
+              levelHeaders.size() * sizeof(LevelHeader));
+  std::size_t offset =
+      sizeof(FileHeader) + levelHeaders.size() * sizeof(LevelHeader);
+  for (const LevelHeader& level : levelHeaders) {
+    if (level.size > file.size() - offset) {
+      levels.clear();
+      return levels;
+    }
+    Cr::Containers::Array<char> data{Cr::Containers::NoInit, level.size};
+    std::memcpy(data.data(), file.data() + offset, level.size);
+    offset += level.size;
+    levels.emplace_back(Mn::CompressedPixelFormat(header.format),
+                        Mn::Vector2i{level.width, level.height},
+                        std::move(data));
+  }
+  if (offset != file.size()) {
+    levels.clear();
+  }
+  return levels;
+}
+
+bool CompressedTextureCache::store(
+    std::uint64_t sourceHash,
+    const std::vector<Mn::Trade::ImageData2D>& levels) const {
+  if (levels.empty()) {
+    return false;
+  }
+  std::size_t size =
+      sizeof(FileHeader) + levels.size() * sizeof(LevelHeader);
+  for (const Mn::Trade::ImageData2D& level : levels) {
+    if (!level.isCompressed() ||
+        level.compressedFormat() != levels[0].compressedFormat()) {
+      return false;
+    }
+    size += level.data().size();
+  }
+
+  FileHeader header{};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.format = Mn::UnsignedInt(levels[0].compressedFormat());
+  header.sourceHash = sourceHash;
+  header.levelCount = levels.size();
+
+  Cr::Containers::Array<char> data{Cr::Containers::NoInit, size};
+  std::memcpy(data.data(), &header, sizeof(header));
+  char* levelHeader = data.data() + sizeof(FileHeader);
+  char* levelData = levelHeader + levels.size() * sizeof(LevelHeader);
+  for (const Mn::Trade::ImageData2D& level : levels) {
+    const LevelHeader entry{level.size().x(), level.size().y(),
+                            level.data().size()};
+    std::memcpy(levelHeader, &entry, sizeof(entry));
+    levelHeader += sizeof(entry);
+    if (!level.data().empty()) {
+      std::memcpy(levelData, level.data().data(), level.data().size());
+      levelData += level.data().size();
+    }
+  }
+  return core::writeFileAtomically(cacheFilename(sourceHash), data);
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,78 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_COMPRESSEDTEXTURECACHE_H_
+#define ESP_ASSETS_COMPRESSEDTEXTURECACHE_H_
+
+/** @file
+ * @brief Class @ref esp::assets::CompressedTextureCache
+ */
+
+#include <Magnum/Trade/ImageData.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief On-disk cache of the textures compressed by
+ * @ref gfx::compressTextureImage() on load
+ *
+ * The compressed mip levels of every texture are stored in their own file
+ * named after the @ref sourceHash() of the image they were compressed from,
+ * so the same image is found again from any asset, and compressing it again
+ * is skipped. Like the @ref MeshCache the files are written atomically, so
+ * several processes can share a directory, and loading and storing are safe
+ * to call from multiple threads.
+ */
+class CompressedTextureCache {
+ public:
+  /**
+   * @brief Constructor
+   * @param directory, the cache directory, created if it doesn't exist
+   */
+  explicit CompressedTextureCache(std::string directory);
+
+  /** @brief The cache directory */
+  const std::string& directory() const { return directory_; }
+
+  /**
+   * @brief The hash the compressed levels of @p image are cached by, of its
+   * format, size and pixels
+   * @param image, the uncompressed image, the first mip level of a texture
+   * @param levelCount, the number of mip levels of the texture
+   */
+  static std::uint64_t sourceHash(const Magnum::Trade::ImageData2D& image,
+                                  std::size_t levelCount);
+
+  /**
+   * @brief Load the compressed levels of the image with @p sourceHash
+   * @return empty if they are not cached
+   */
+  std::vector<Magnum::Trade::ImageData2D> load(std::uint64_t sourceHash) const;
+
+  /**
+   * @brief Store the compressed @p levels of the image with @p sourceHash
+   * @return false if a level is not compressed or the file can't be written
+   */
+  bool store(std::uint64_t sourceHash,
+             const std::vector<Magnum::Trade::ImageData2D>& levels) const;
+
+  /** @brief The file the image with @p sourceHash is cached in */
+  std::string cacheFilename(std::uint64_t sourceHash) const;
+
+ private:
+  std::string directory_;
+
+  ESP_SMART_POINTERS(CompressedTextureCache)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_COMPRESSEDTEXTURECACHE_H_
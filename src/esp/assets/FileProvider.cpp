@@ -0,0 +1,61 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "FileProvider.h"
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace assets {
+
+FileProvider::Status StreamingFileProvider::request(
+    const std::string& filename) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (files_.count(filename)) {
+    return Status::Available;
+  }
+  if (unavailable_.count(filename)) {
+    return Status::Unavailable;
+  }
+  if (pending_.insert(filename).second) {
+    requests_.push_back(filename);
+  }
+  return Status::Pending;
+}
+
+Cr::Containers::ArrayView<const char> StreamingFileProvider::data(
+    const std::string& filename) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto found = files_.find(filename);
+  if (found == files_.end()) {
+    return nullptr;
+  }
+  return found->second;
+}
+
+void StreamingFileProvider::addFile(const std::string& filename,
+                                    Cr::Containers::Array<char>&& data) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  pending_.erase(filename);
+  unavailable_.erase(filename);
+  files_[filename] = std::move(data);
+}
+
+void StreamingFileProvider::addUnavailable(const std::string& filename) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  pending_.erase(filename);
+  if (!files_.count(filename)) {
+    unavailable_.insert(filename);
+  }
+}
+
+std::vector<std::string> StreamingFileProvider::takeRequests() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::vector<std::string> requests;
+  requests.swap(requests_);
+  return requests;
+}
+
+}  // namespace assets
+}  // namespace esp
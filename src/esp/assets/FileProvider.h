@@ -0,0 +1,113 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_FILEPROVIDER_H_
+#define ESP_ASSETS_FILEPROVIDER_H_
+
+/** @file
+ * @brief Class @ref esp::assets::FileProvider,
+ * @ref esp::assets::StreamingFileProvider
+ */
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief Supplies the files of the assets instead of the local filesystem,
+ * e.g. as they are downloaded in the web build
+ *
+ * A @ref ResourceManager with a provider, see
+ * @ref ResourceManager::setFileProvider(), opens the files of general assets
+ * through it, including the buffers and images they reference. The main
+ * file and the buffers of an asset are needed to load it. Images which are
+ * still @ref Status::Pending are drawn with a placeholder until they arrive,
+ * and are loaded by @ref ResourceManager::loadStreamedFiles().
+ *
+ * The functions may be called from the loader threads at the same time.
+ */
+class FileProvider {
+ public:
+  /** @brief Whether a file can be read */
+  enum class Status {
+    /** The contents are available with @ref data() */
+    Available,
+    /** The file is on its way, ask again later */
+    Pending,
+    /** The provider doesn't have the file, it's read from the filesystem */
+    Unavailable,
+  };
+
+  virtual ~FileProvider() = default;
+
+  /**
+   * @brief Whether @p filename can be read, asking for it if it's not there
+   * yet. Doesn't block.
+   */
+  virtual Status request(const std::string& filename) = 0;
+
+  /**
+   * @brief The contents of @p filename, valid until @ref release() is called
+   * for it. Empty if it's not @ref Status::Available.
+   */
+  virtual Corrade::Containers::ArrayView<const char> data(
+      const std::string& filename) = 0;
+
+  /** @brief The contents of @p filename are not used anymore */
+  virtual void release(const std::string& filename) = 0;
+
+  ESP_SMART_POINTERS(FileProvider)
+};
+
+/**
+ * @brief @ref FileProvider filled by the host as its downloads complete
+ *
+ * The files requested since the last call to @ref takeRequests() are
+ * fetched by the host, e.g. with `fetch()` in JavaScript, and handed over
+ * with @ref addFile(), or @ref addUnavailable() if they can't be downloaded.
+ * The files are kept after they were released, to be opened again.
+ */
+class StreamingFileProvider : public FileProvider {
+ public:
+  Status request(const std::string& filename) override;
+
+  Corrade::Containers::ArrayView<const char> data(
+      const std::string& filename) override;
+
+  void release(const std::string&) override {}
+
+  /** @brief Add the contents of @p filename */
+  void addFile(const std::string& filename,
+               Corrade::Containers::Array<char>&& data);
+
+  /** @brief @p filename is read from the filesystem instead */
+  void addUnavailable(const std::string& filename);
+
+  /** @brief The files requested since the last call, to be fetched */
+  std::vector<std::string> takeRequests();
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, Corrade::Containers::Array<char>> files_;
+  std::unordered_set<std::string> unavailable_;
+  // requested and not added yet, and the ones not taken by the host yet
+  std::unordered_set<std::string> pending_;
+  std::vector<std::string> requests_;
+
+  ESP_SMART_POINTERS(StreamingFileProvider)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_FILEPROVIDER_H_
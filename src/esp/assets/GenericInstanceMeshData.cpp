@@ -4,9 +4,15 @@
 
 #include "GenericInstanceMeshData.h"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <unordered_map>
+
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/StridedArrayView.h>
 #include <Corrade/Utility/Algorithms.h>
 #include <Magnum/Image.h>
 #include <Magnum/ImageView.h>
@@ -18,6 +24,8 @@
 #include <Magnum/Shaders/Generic.h>
 #include <Magnum/Trade/AbstractImporter.h>
 
+#include "PlyReader.h"
+#include "esp/core/ThreadPool.h"
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
 #include "esp/io/io.h"
@@ -31,6 +39,9 @@ namespace assets {
 
 namespace {
 
+// the number of vertices or faces a worker handles at once
+constexpr size_t GrainSize = 16384;
+
 // TODO: this could instead use Mn::Trade::MeshData directly
 struct InstancePlyData {
   std::vector<vec3f> cpu_vbo;
@@ -39,9 +50,185 @@ struct InstancePlyData {
   std::vector<uint16_t> objectIds;
 };
 
+// Generic Semantic PLY meshes have -Z gravity
+void rotateToEspFrame(std::vector<vec3f>& vbo) {
+  const quatf T_esp_scene =
+      quatf::FromTwoVectors(-vec3f::UnitZ(), geo::ESP_GRAVITY);
+
+  core::ThreadPool::shared().parallelForRanges(
+      vbo.size(), GrainSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          vbo[i] = T_esp_scene * vbo[i];
+        }
+      });
+}
+
+/* Zero-copy path reading the file through PlyReader. Object IDs are either
+   per vertex or per face, per-face IDs are made per-vertex here, duplicating
+   the vertices shared by faces of different objects like the importer does.
+   Returns false if the layout of the file isn't handled, leaving it to the
+   importer, otherwise @p result is set if the file was read successfully. */
+bool readPly(const std::string& plyFile,
+             Cr::Containers::Optional<InstancePlyData>& result) {
+  PlyReader reader;
+  if (!reader.open(plyFile)) {
+    return false;
+  }
+  const PlyReader::Element* vertex = reader.element("vertex");
+  const PlyReader::Element* face = reader.element("face");
+  if (!vertex || !face) {
+    return false;
+  }
+  const PlyReader::Property* position[]{
+      PlyReader::property(*vertex, "x"), PlyReader::property(*vertex, "y"),
+      PlyReader::property(*vertex, "z")};
+  const PlyReader::Property* color[]{PlyReader::property(*vertex, "red"),
+                                     PlyReader::property(*vertex, "green"),
+                                     PlyReader::property(*vertex, "blue")};
+  const PlyReader::Property* indices =
+      PlyReader::property(*face, "vertex_indices");
+  if (!indices) {
+    indices = PlyReader::property(*face, "vertex_index");
+  }
+  const PlyReader::Property* vertexObjectId =
+      PlyReader::property(*vertex, "object_id");
+  const PlyReader::Property* faceObjectId =
+      PlyReader::property(*face, "object_id");
+  for (const PlyReader::Property* property : {position[0], position[1],
+                                              position[2], indices}) {
+    if (!property) {
+      return false;
+    }
+  }
+  if (!indices->isList || indices->listSize < 3 ||
+      PlyReader::typeSize(indices->type) != sizeof(uint32_t)) {
+    return false;
+  }
+
+  /* Same checks as the importer path */
+  for (const PlyReader::Property* property : color) {
+    if (!property) {
+      LOG(ERROR) << "File has no vertex colors";
+      return true;
+    }
+    if (property->type != PlyReader::Type::UnsignedChar) {
+      LOG(ERROR) << "Unexpected vertex color type";
+      return true;
+    }
+  }
+  if (!vertexObjectId && !faceObjectId) {
+    LOG(ERROR) << "File has no object IDs";
+    return true;
+  }
+
+  const size_t numVertices = vertex->count;
+  const size_t numFaces = face->count;
+  const size_t faceSize = indices->listSize;
+  InstancePlyData data;
+  data.cpu_vbo.resize(numVertices);
+  data.cpu_cbo.resize(numVertices);
+  for (size_t i = 0; i < 3; ++i) {
+    PlyReader::readInto(*vertex, *position[i], 0,
+                        PlyReader::component<float>(data.cpu_vbo, i));
+    PlyReader::readInto(*vertex, *color[i], 0,
+                        PlyReader::component<uint8_t>(data.cpu_cbo, i));
+  }
+
+  std::vector<uint32_t> faceIndices(numFaces * faceSize);
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  std::atomic<bool> validIndices{true};
+  pool.parallelForRanges(numFaces, GrainSize, [&](size_t begin, size_t end) {
+    bool valid = true;
+    for (size_t f = begin; f < end; ++f) {
+      uint32_t* out = faceIndices.data() + f * faceSize;
+      std::memcpy(out, face->data + f * face->stride + indices->offset,
+                  faceSize * sizeof(uint32_t));
+      for (size_t v = 0; v < faceSize; ++v) {
+        valid = valid && out[v] < numVertices;
+      }
+    }
+    if (!valid) {
+      validIndices = false;
+    }
+  });
+  if (!validIndices) {
+    LOG(ERROR) << "File has vertex indices out of range";
+    return true;
+  }
+
+  std::vector<int64_t> objectIds(vertexObjectId ? numVertices : numFaces);
+  PlyReader::readInto(vertexObjectId ? *vertex : *face,
+                      vertexObjectId ? *vertexObjectId : *faceObjectId, 0,
+                      Cr::Containers::stridedArrayView(objectIds));
+  if (!objectIds.empty() &&
+      (*std::max_element(objectIds.begin(), objectIds.end()) > 65535 ||
+       *std::min_element(objectIds.begin(), objectIds.end()) < 0)) {
+    LOG(ERROR) << "Object IDs can't fit into 16 bits";
+    return true;
+  }
+
+  if (vertexObjectId) {
+    data.objectIds.assign(objectIds.begin(), objectIds.end());
+  } else {
+    // the first face using a vertex gives it its object ID, faces of other
+    // objects get a copy of it
+    constexpr uint32_t Unset = ~uint32_t{};
+    std::vector<uint32_t> vertexObjectIds(numVertices, Unset);
+    std::unordered_map<uint64_t, uint32_t> copies;
+    for (size_t f = 0; f < numFaces; ++f) {
+      const uint32_t objectId = objectIds[f];
+      for (size_t v = 0; v < faceSize; ++v) {
+        uint32_t& index = faceIndices[f * faceSize + v];
+        if (vertexObjectIds[index] == Unset) {
+          vertexObjectIds[index] = objectId;
+        } else if (vertexObjectIds[index] != objectId) {
+          auto copy = copies.emplace(uint64_t(index) << 16 | objectId,
+                                     data.cpu_vbo.size());
+          if (copy.second) {
+            data.cpu_vbo.push_back(data.cpu_vbo[index]);
+            data.cpu_cbo.push_back(data.cpu_cbo[index]);
+            vertexObjectIds.push_back(objectId);
+          }
+          index = copy.first->second;
+        }
+      }
+    }
+    data.objectIds.resize(vertexObjectIds.size());
+    for (size_t i = 0; i < vertexObjectIds.size(); ++i) {
+      // vertices no face references keep ID 0
+      data.objectIds[i] =
+          vertexObjectIds[i] == Unset ? 0 : uint16_t(vertexObjectIds[i]);
+    }
+  }
+
+  // polygons are triangulated as fans
+  const size_t trianglesPerFace = faceSize - 2;
+  data.cpu_ibo.resize(numFaces * trianglesPerFace * 3);
+  pool.parallelForRanges(numFaces, GrainSize, [&](size_t begin, size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      const uint32_t* in = faceIndices.data() + f * faceSize;
+      uint32_t* out = data.cpu_ibo.data() + f * trianglesPerFace * 3;
+      for (size_t t = 0; t < trianglesPerFace; ++t) {
+        *out++ = in[0];
+        *out++ = in[t + 1];
+        *out++ = in[t + 2];
+      }
+    }
+  });
+
+  rotateToEspFrame(data.cpu_vbo);
+  result = std::move(data);
+  return true;
+}
+
 Cr::Containers::Optional<InstancePlyData> parsePly(
     Mn::Trade::AbstractImporter& importer,
     const std::string& plyFile) {
+  Cr::Containers::Optional<InstancePlyData> result;
+  if (readPly(plyFile, result)) {
+    return result;
+  }
+
   /* Open the file. On error the importer already prints a diagnostic message,
      so no need to do that here. The importer implicitly converts per-face
      attributes to per-vertex, so nothing extra needs to be done. */
@@ -98,45 +285,125 @@ Cr::Containers::Optional<InstancePlyData> parsePly(
                      Cr::Containers::arrayCast<2, Mn::UnsignedShort>(
                          Cr::Containers::stridedArrayView(data.objectIds)));
 
-  // Generic Semantic PLY meshes have -Z gravity
-  const quatf T_esp_scene =
-      quatf::FromTwoVectors(-vec3f::UnitZ(), geo::ESP_GRAVITY);
-
-  for (auto& xyz : data.cpu_vbo) {
-    xyz = T_esp_scene * xyz;
-  }
+  rotateToEspFrame(data.cpu_vbo);
   return data;
 }
 
 }  // namespace
 
-std::vector<std::unique_ptr<GenericInstanceMeshData>>
+std::unique_ptr<GenericInstanceMeshData>
 GenericInstanceMeshData::fromPlySplitByObjectId(
     Mn::Trade::AbstractImporter& importer,
     const std::string& plyFile) {
   Cr::Containers::Optional<InstancePlyData> parseResult =
       parsePly(importer, plyFile);
   if (!parseResult) {
-    return {};
+    return nullptr;
   }
   const InstancePlyData& data = *parseResult;
+  const size_t numTriangles = data.cpu_ibo.size() / 3;
 
-  std::vector<GenericInstanceMeshData::uptr> splitMeshData;
-  std::unordered_map<uint16_t, PerObjectIdMeshBuilder> objectIdToObjectData;
-
-  for (size_t i = 0; i < data.cpu_ibo.size(); ++i) {
-    const uint32_t globalIndex = data.cpu_ibo[i];
-    const uint16_t objectId = data.objectIds[globalIndex];
-    if (objectIdToObjectData.find(objectId) == objectIdToObjectData.end()) {
-      auto instanceMesh = GenericInstanceMeshData::create_unique();
-      objectIdToObjectData.emplace(
-          objectId, PerObjectIdMeshBuilder{*instanceMesh, objectId});
-      splitMeshData.emplace_back(std::move(instanceMesh));
+  /* Sort the triangles by object ID, with a single pass of a 16-bit radix
+     sort. Chunks of the triangles are counted and scattered in parallel,
+     each into its own range of every bucket, which keeps the sort stable.
+     The vertices of a triangle all have the object ID of its face. */
+  constexpr size_t NumObjectIds = 1 << 16;
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const size_t numChunks = std::max<size_t>(
+      1, std::min(pool.numThreads() + 1, numTriangles / NumObjectIds));
+  const size_t chunkSize = (numTriangles + numChunks - 1) / numChunks;
+  auto objectIdOf = [&data](size_t triangle) {
+    return data.objectIds[data.cpu_ibo[3 * triangle]];
+  };
+
+  std::vector<uint32_t> offsets(numChunks * NumObjectIds, 0);
+  pool.parallelFor(numChunks, numChunks, [&](size_t chunk, size_t) {
+    uint32_t* counts = offsets.data() + chunk * NumObjectIds;
+    const size_t end = std::min(numTriangles, (chunk + 1) * chunkSize);
+    for (size_t i = chunk * chunkSize; i < end; ++i) {
+      ++counts[objectIdOf(i)];
+    }
+  });
+  std::vector<uint32_t> bucketStart(NumObjectIds + 1);
+  uint32_t sortedSoFar = 0;
+  for (size_t objectId = 0; objectId < NumObjectIds; ++objectId) {
+    bucketStart[objectId] = sortedSoFar;
+    for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+      uint32_t& offset = offsets[chunk * NumObjectIds + objectId];
+      const uint32_t count = offset;
+      offset = sortedSoFar;
+      sortedSoFar += count;
+    }
+  }
+  bucketStart[NumObjectIds] = sortedSoFar;
+
+  // the triangles, sorted by object ID
+  std::vector<uint32_t> sorted(numTriangles);
+  pool.parallelFor(numChunks, numChunks, [&](size_t chunk, size_t) {
+    uint32_t* offset = offsets.data() + chunk * NumObjectIds;
+    const size_t end = std::min(numTriangles, (chunk + 1) * chunkSize);
+    for (size_t i = chunk * chunkSize; i < end; ++i) {
+      sorted[offset[objectIdOf(i)]++] = i;
+    }
+  });
+
+  // the objects are in the order they first appear in, the sort being
+  // stable that's the first triangle in every bucket
+  std::vector<uint16_t> objectIds;
+  for (size_t objectId = 0; objectId < NumObjectIds; ++objectId) {
+    if (bucketStart[objectId] != bucketStart[objectId + 1]) {
+      objectIds.push_back(objectId);
     }
-    objectIdToObjectData.at(objectId).addVertex(
-        globalIndex, data.cpu_vbo[globalIndex], data.cpu_cbo[globalIndex]);
   }
-  return splitMeshData;
+  std::sort(objectIds.begin(), objectIds.end(),
+            [&](uint16_t a, uint16_t b) {
+              return sorted[bucketStart[a]] < sorted[bucketStart[b]];
+            });
+
+  // one mesh with the triangles of every object in a contiguous range of the
+  // indices, the vertices are shared as they are
+  auto mesh = GenericInstanceMeshData::create_unique();
+  mesh->cpu_vbo_ = std::move(parseResult->cpu_vbo);
+  mesh->cpu_cbo_ = std::move(parseResult->cpu_cbo);
+  mesh->objectIds_ = std::move(parseResult->objectIds);
+  mesh->cpu_ibo_.resize(parseResult->cpu_ibo.size());
+  mesh->objectSubmeshes_.resize(objectIds.size());
+  std::vector<uint32_t> submeshOffsets(objectIds.size());
+  uint32_t indexOffset = 0;
+  for (size_t iObject = 0; iObject < objectIds.size(); ++iObject) {
+    const uint16_t objectId = objectIds[iObject];
+    submeshOffsets[iObject] = indexOffset;
+    indexOffset += 3 * (bucketStart[objectId + 1] - bucketStart[objectId]);
+  }
+  pool.parallelFor(
+      objectIds.size(), pool.numThreads() + 1, [&](size_t iObject, size_t) {
+        const uint16_t objectId = objectIds[iObject];
+        const uint32_t begin = bucketStart[objectId];
+        const uint32_t count = bucketStart[objectId + 1] - begin;
+        uint32_t* out = mesh->cpu_ibo_.data() + submeshOffsets[iObject];
+        Mn::Range3D box{Mn::Vector3{std::numeric_limits<float>::max()},
+                        Mn::Vector3{-std::numeric_limits<float>::max()}};
+        for (uint32_t t = 0; t < count; ++t) {
+          for (size_t v = 0; v < 3; ++v) {
+            const uint32_t index =
+                parseResult->cpu_ibo[3 * sorted[begin + t] + v];
+            *out++ = index;
+            const Mn::Vector3& position =
+                Mn::Vector3::from(mesh->cpu_vbo_[index].data());
+            box = {Mn::Math::min(box.min(), position),
+                   Mn::Math::max(box.max(), position)};
+          }
+        }
+        gfx::Drawable::Submesh& submesh = mesh->objectSubmeshes_[iObject];
+        submesh.indexOffset = submeshOffsets[iObject];
+        submesh.indexCount = 3 * count;
+        submesh.box = box;
+        submesh.id = objectId;
+      });
+
+  mesh->collisionMeshData_.primitive = Magnum::MeshPrimitive::Triangles;
+  mesh->updateCollisionMeshData();
+  return mesh;
 }
 
 std::unique_ptr<GenericInstanceMeshData> GenericInstanceMeshData::fromPLY(
@@ -214,21 +481,5 @@ void GenericInstanceMeshData::updateCollisionMeshData() {
       Cr::Containers::arrayView(cpu_ibo_));
 }
 
-void GenericInstanceMeshData::PerObjectIdMeshBuilder::addVertex(
-    uint32_t vertexId,
-    const vec3f& position,
-    const vec3uc& color) {
-  // if we haven't seen this vertex, add it to the local vertex/color buffer
-  auto result = vertexIdToVertexIndex_.emplace(vertexId, data_.cpu_vbo_.size());
-  if (result.second) {
-    data_.cpu_vbo_.emplace_back(position);
-    data_.cpu_cbo_.emplace_back(color);
-    data_.objectIds_.emplace_back(objectId_);
-  }
-
-  // update index buffers with local index of vertex/color
-  data_.cpu_ibo_.emplace_back(result.first->second);
-}
-
 }  // namespace assets
 }  // namespace esp
@@ -10,11 +10,11 @@
 #include <Magnum/GL/Mesh.h>
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "BaseMesh.h"
 #include "esp/core/esp.h"
+#include "esp/gfx/Drawable.h"
 
 namespace esp {
 namespace assets {
@@ -32,14 +32,20 @@ class GenericInstanceMeshData : public BaseMesh {
   virtual ~GenericInstanceMeshData(){};
 
   /**
-   * @brief Split a .ply file by objectIDs into different meshes
+   * @brief Load from a .ply file, with the triangles of each object in a
+   * range of the indices
    *
    * @param plyFile .ply file to load and split
-   * @return Mesh data split by objectID
+   * @return Mesh data with @ref getObjectSubmeshes(), nullptr on error
+   *
+   * The objects are in the order they first appear in the file. Drawn with
+   * the ranges as @ref gfx::Drawable::setSubmeshes(), the objects are culled
+   * separately and can be hidden, while the visible ones are still drawn
+   * with a single multi-draw call.
    */
-  static std::vector<std::unique_ptr<GenericInstanceMeshData>>
-  fromPlySplitByObjectId(Magnum::Trade::AbstractImporter& importer,
-                         const std::string& plyFile);
+  static std::unique_ptr<GenericInstanceMeshData> fromPlySplitByObjectId(
+      Magnum::Trade::AbstractImporter& importer,
+      const std::string& plyFile);
 
   /**
    * @brief Load from a .ply file
@@ -71,20 +77,16 @@ class GenericInstanceMeshData : public BaseMesh {
     return objectIds_;
   }
 
- protected:
-  class PerObjectIdMeshBuilder {
-   public:
-    PerObjectIdMeshBuilder(GenericInstanceMeshData& data, uint16_t objectId)
-        : data_{data}, objectId_{objectId} {}
-
-    void addVertex(uint32_t vertexId, const vec3f& vertex, const vec3uc& color);
-
-   private:
-    GenericInstanceMeshData& data_;
-    uint16_t objectId_;
-    std::unordered_map<uint32_t, size_t> vertexIdToVertexIndex_;
-  };
+  /**
+   * @brief The range of the indices and the bounding box of each object, with
+   * the object ID as @ref gfx::Drawable::Submesh::id, empty unless loaded
+   * with @ref fromPlySplitByObjectId()
+   */
+  const std::vector<gfx::Drawable::Submesh>& getObjectSubmeshes() const {
+    return objectSubmeshes_;
+  }
 
+ protected:
   void updateCollisionMeshData();
 
   // ==== rendering ====
@@ -94,6 +96,7 @@ class GenericInstanceMeshData : public BaseMesh {
   std::vector<vec3uc> cpu_cbo_;
   std::vector<uint32_t> cpu_ibo_;
   std::vector<uint16_t> objectIds_;
+  std::vector<gfx::Drawable::Submesh> objectSubmeshes_;
 
   ESP_SMART_POINTERS(GenericInstanceMeshData)
 };
@@ -6,15 +6,225 @@
 
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/StridedArrayView.h>
 #include <Corrade/Utility/DebugStl.h>
+#include <Magnum/Math/FunctionsBatch.h>
+#include <Magnum/Math/Packing.h>
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/MeshTools/Interleave.h>
+#include <Magnum/MeshTools/Transform.h>
+#include <cstring>
+
+#include "esp/geo/geo.h"
 namespace Cr = Corrade;
 namespace Mn = Magnum;
 
 namespace esp {
 namespace assets {
 
+namespace {
+
+/* The mesh with its positions in one contiguous block at the start of the
+   vertex data, followed by the other attributes interleaved, so that the
+   collision data can reference the positions the GPU buffer is uploaded from
+   instead of keeping a copy. Meshes which are laid out like that already are
+   moved through, ones without indices or three-component float positions are
+   only interleaved. */
+Mn::Trade::MeshData withContiguousPositions(Mn::Trade::MeshData&& meshData) {
+  if (!meshData.isIndexed() ||
+      !meshData.hasAttribute(Mn::Trade::MeshAttribute::Position) ||
+      meshData.attributeFormat(Mn::Trade::MeshAttribute::Position) !=
+          Mn::VertexFormat::Vector3) {
+    return Mn::MeshTools::interleave(std::move(meshData));
+  }
+  const Mn::UnsignedInt positionId =
+      meshData.attributeId(Mn::Trade::MeshAttribute::Position);
+  if (meshData.attributeStride(positionId) == sizeof(Mn::Vector3) &&
+      (meshData.vertexDataFlags() & Mn::Trade::DataFlag::Mutable) &&
+      (meshData.vertexDataFlags() & Mn::Trade::DataFlag::Owned) &&
+      (meshData.indexDataFlags() & Mn::Trade::DataFlag::Owned)) {
+    return std::move(meshData);
+  }
+
+  const std::size_t vertexCount = meshData.vertexCount();
+  std::vector<std::size_t> attributeSizes;
+  std::size_t stride = 0;
+  for (Mn::UnsignedInt i = 0; i < meshData.attributeCount(); ++i) {
+    attributeSizes.push_back(meshData.attribute(i).size()[1]);
+    if (i != positionId) {
+      stride += attributeSizes.back();
+    }
+  }
+  const std::size_t positionsSize = vertexCount * sizeof(Mn::Vector3);
+  Cr::Containers::Array<char> vertexData{Cr::Containers::NoInit,
+                                         positionsSize + vertexCount * stride};
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      meshData.attributeCount()};
+  std::size_t offset = positionsSize;
+  for (Mn::UnsignedInt i = 0; i < meshData.attributeCount(); ++i) {
+    Cr::Containers::StridedArrayView2D<const char> source =
+        meshData.attribute(i);
+    char* const target = vertexData + (i == positionId ? 0 : offset);
+    const std::size_t targetStride =
+        i == positionId ? sizeof(Mn::Vector3) : stride;
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+      std::memcpy(target + v * targetStride, source[v].data(),
+                  attributeSizes[i]);
+    }
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        meshData.attributeName(i), meshData.attributeFormat(i),
+        Cr::Containers::StridedArrayView1D<const void>{
+            Cr::Containers::arrayView(vertexData), target, vertexCount,
+            std::ptrdiff_t(targetStride)},
+        meshData.attributeArraySize(i)};
+    if (i != positionId) {
+      offset += attributeSizes[i];
+    }
+  }
+
+  // the indices are moved if the mesh owns them
+  const Mn::MeshIndexType indexType = meshData.indexType();
+  const std::size_t indexSize =
+      meshData.indexCount() * Mn::meshIndexTypeSize(indexType);
+  const std::size_t indexOffset =
+      static_cast<const char*>(meshData.indices().data()) -
+      meshData.indexData().data();
+  Cr::Containers::Array<char> indexData;
+  if (meshData.indexDataFlags() & Mn::Trade::DataFlag::Owned) {
+    indexData = meshData.releaseIndexData();
+  } else {
+    indexData = Cr::Containers::Array<char>{Cr::Containers::NoInit,
+                                            indexOffset + indexSize};
+    std::memcpy(indexData + indexOffset,
+                meshData.indexData().data() + indexOffset, indexSize);
+  }
+  Mn::Trade::MeshIndexData indices{
+      indexType, indexData.slice(indexOffset, indexOffset + indexSize)};
+  return Mn::Trade::MeshData{meshData.primitive(),
+                             std::move(indexData),
+                             indices,
+                             std::move(vertexData),
+                             std::move(attributes),
+                             Mn::UnsignedInt(vertexCount)};
+}
+
+// The format an attribute is uploaded in by compressedMeshData()
+Mn::VertexFormat compressedFormat(const Mn::Trade::MeshData& meshData,
+                                  Mn::UnsignedInt id) {
+  const Mn::VertexFormat format = meshData.attributeFormat(id);
+  if (meshData.attributeArraySize(id)) {
+    return format;
+  }
+  switch (meshData.attributeName(id)) {
+    case Mn::Trade::MeshAttribute::Normal:
+    case Mn::Trade::MeshAttribute::Tangent:
+    case Mn::Trade::MeshAttribute::Bitangent:
+      if (format == Mn::VertexFormat::Vector3) {
+        return Mn::VertexFormat::Vector3sNormalized;
+      }
+      // four-component tangents store the handedness in w, which is -1 or 1
+      if (format == Mn::VertexFormat::Vector4) {
+        return Mn::VertexFormat::Vector4sNormalized;
+      }
+      return format;
+    case Mn::Trade::MeshAttribute::TextureCoordinates: {
+      if (format != Mn::VertexFormat::Vector2) {
+        return format;
+      }
+      for (const Mn::Vector2& uv : meshData.attribute<Mn::Vector2>(id)) {
+        if (!(uv >= Mn::Vector2{0.0f}).all() ||
+            !(uv <= Mn::Vector2{1.0f}).all()) {
+          return Mn::VertexFormat::Vector2h;
+        }
+      }
+      return Mn::VertexFormat::Vector2usNormalized;
+    }
+    default:
+      return format;
+  }
+}
+
+/* A copy of the vertices of @p meshData with smaller attribute formats, see
+   GenericMeshData::setCompressVertexFormats(), referencing its indices */
+Mn::Trade::MeshData compressedMeshData(const Mn::Trade::MeshData& meshData) {
+  const std::size_t vertexCount = meshData.vertexCount();
+  std::vector<Mn::VertexFormat> formats;
+  std::vector<std::size_t> offsets;
+  std::size_t stride = 0;
+  for (Mn::UnsignedInt i = 0; i < meshData.attributeCount(); ++i) {
+    formats.push_back(compressedFormat(meshData, i));
+    offsets.push_back(stride);
+    std::size_t size = meshData.attribute(i).size()[1];
+    if (formats.back() != meshData.attributeFormat(i)) {
+      size = Mn::vertexFormatSize(formats.back());
+    }
+    // keep the attributes four-byte aligned for the vertex fetch
+    stride += (size + 3) / 4 * 4;
+  }
+
+  Cr::Containers::Array<char> vertexData{Cr::Containers::ValueInit,
+                                         vertexCount * stride};
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      meshData.attributeCount()};
+  for (Mn::UnsignedInt i = 0; i < meshData.attributeCount(); ++i) {
+    char* const target = vertexData + offsets[i];
+    const Mn::VertexFormat format = formats[i];
+    if (format == Mn::VertexFormat::Vector3sNormalized) {
+      const auto source = meshData.attribute<Mn::Vector3>(i);
+      for (std::size_t v = 0; v < vertexCount; ++v) {
+        *reinterpret_cast<Mn::Vector3s*>(target + v * stride) =
+            Mn::Math::pack<Mn::Vector3s>(source[v]);
+      }
+    } else if (format == Mn::VertexFormat::Vector4sNormalized) {
+      const auto source = meshData.attribute<Mn::Vector4>(i);
+      for (std::size_t v = 0; v < vertexCount; ++v) {
+        *reinterpret_cast<Mn::Vector4s*>(target + v * stride) =
+            Mn::Math::pack<Mn::Vector4s>(source[v]);
+      }
+    } else if (format == Mn::VertexFormat::Vector2usNormalized) {
+      const auto source = meshData.attribute<Mn::Vector2>(i);
+      for (std::size_t v = 0; v < vertexCount; ++v) {
+        *reinterpret_cast<Mn::Vector2us*>(target + v * stride) =
+            Mn::Math::pack<Mn::Vector2us>(source[v]);
+      }
+    } else if (format == Mn::VertexFormat::Vector2h) {
+      const auto source = meshData.attribute<Mn::Vector2>(i);
+      for (std::size_t v = 0; v < vertexCount; ++v) {
+        *reinterpret_cast<Mn::Vector2us*>(target + v * stride) =
+            Mn::Math::packHalf(source[v]);
+      }
+    } else {
+      Cr::Containers::StridedArrayView2D<const char> source =
+          meshData.attribute(i);
+      for (std::size_t v = 0; v < vertexCount; ++v) {
+        std::memcpy(target + v * stride, source[v].data(),
+                    source.size()[1]);
+      }
+    }
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        meshData.attributeName(i), format,
+        Cr::Containers::StridedArrayView1D<const void>{
+            Cr::Containers::arrayView(vertexData), target, vertexCount,
+            std::ptrdiff_t(stride)},
+        meshData.attributeArraySize(i)};
+  }
+
+  if (!meshData.isIndexed()) {
+    return Mn::Trade::MeshData{meshData.primitive(), std::move(vertexData),
+                               std::move(attributes),
+                               Mn::UnsignedInt(vertexCount)};
+  }
+  return Mn::Trade::MeshData{meshData.primitive(),
+                             {},
+                             meshData.indexData(),
+                             Mn::Trade::MeshIndexData{meshData.indices()},
+                             std::move(vertexData),
+                             std::move(attributes),
+                             Mn::UnsignedInt(vertexCount)};
+}
+
+}  // namespace
+
 void GenericMeshData::uploadBuffersToGPU(bool forceReload) {
   if (forceReload) {
     buffersOnGPU_ = false;
@@ -22,6 +232,11 @@ void GenericMeshData::uploadBuffersToGPU(bool forceReload) {
   if (buffersOnGPU_) {
     return;
   }
+  // keep the uploaded buffers of a mesh whose data was released
+  if (!meshData_) {
+    buffersOnGPU_ = renderingBuffer_ != nullptr;
+    return;
+  }
 
   renderingBuffer_.reset();
   renderingBuffer_ = std::make_unique<GenericMeshData::RenderingBuffer>();
@@ -31,11 +246,38 @@ void GenericMeshData::uploadBuffersToGPU(bool forceReload) {
     compileFlags |= Magnum::MeshTools::CompileFlag::GenerateSmoothNormals;
   }
   // position, normals, uv, colors are bound to corresponding attributes
-  renderingBuffer_->mesh = Magnum::MeshTools::compile(*meshData_, compileFlags);
+  auto compile = [&](const Mn::Trade::MeshData& meshData) {
+    // generated normals are appended as floats
+    if (compressVertexFormats_) {
+      return Mn::MeshTools::compile(compressedMeshData(meshData),
+                                    compileFlags);
+    }
+    return Mn::MeshTools::compile(meshData, compileFlags);
+  };
+  renderingBuffer_->mesh = compile(*meshData_);
+  for (const auto& lod : lods_) {
+    renderingBuffer_->lods.push_back(
+        {compile(compactLodMeshData(lod.first)), lod.second});
+  }
 
   buffersOnGPU_ = true;
 }
 
+bool GenericMeshData::releaseHostData() {
+  if (!buffersOnGPU_ || !meshData_) {
+    return false;
+  }
+  meshData_ = Cr::Containers::NullOpt;
+  collisionMeshData_.positions = nullptr;
+  collisionMeshData_.indices = nullptr;
+  positionData_ = nullptr;
+  indexData_ = nullptr;
+  cacheFile_ = nullptr;
+  lods_ = {};
+  hostDataReleased_ = true;
+  return true;
+}
+
 Magnum::GL::Mesh* GenericMeshData::getMagnumGLMesh() {
   if (renderingBuffer_ == nullptr) {
     return nullptr;
@@ -45,22 +287,35 @@ Magnum::GL::Mesh* GenericMeshData::getMagnumGLMesh() {
 }
 
 void GenericMeshData::setMeshData(Magnum::Trade::MeshData&& meshData) {
-  /* Interleave the mesh, if not already. This makes the GPU happier (better
-     cache locality for vertex fetching) and is a no-op if the source data is
-     already interleaved, so doesn't hurt to have it there always. */
+  /* Lay the positions out contiguously and interleave the other attributes.
+     This makes the GPU happier (better cache locality for vertex fetching),
+     the buffer is uploaded as it is and the collision data references the
+     positions in it. */
 
   /* TODO: Address that non-triangle meshes will have their collisionMeshData_
    * incorrectly calculated */
 
-  meshData_ = Mn::MeshTools::interleave(std::move(meshData));
+  meshData_ = withContiguousPositions(std::move(meshData));
+  hostDataReleased_ = false;
 
   collisionMeshData_.primitive = meshData_->primitive();
 
   /* For collision data we need positions as Vector3 in a contiguous array.
-     There's little chance the data are stored like that in MeshData, so unpack
-     them to an array. */
-  collisionMeshData_.positions = positionData_ =
-      meshData_->positions3DAsArray();
+     If the mesh has them like that, reference them, otherwise unpack them to
+     an array. */
+  const Mn::Trade::MeshAttribute position = Mn::Trade::MeshAttribute::Position;
+  if (meshData_->hasAttribute(position) &&
+      meshData_->attributeFormat(position) == Mn::VertexFormat::Vector3 &&
+      meshData_->attributeStride(position) == sizeof(Mn::Vector3) &&
+      (meshData_->vertexDataFlags() & Mn::Trade::DataFlag::Mutable)) {
+    positionData_ = nullptr;
+    collisionMeshData_.positions = {
+        static_cast<Mn::Vector3*>(meshData_->mutableAttribute(position).data()),
+        meshData_->vertexCount()};
+  } else {
+    collisionMeshData_.positions = positionData_ =
+        meshData_->positions3DAsArray();
+  }
 
   /* For collision data we need indices as UnsignedInt. If the mesh already has
      those, just make the collision data reference them. If not, unpack them
@@ -89,5 +344,230 @@ void GenericMeshData::importAndSetMeshData(
   setMeshData(*std::move(mesh));
 }  // importAndSetMeshData
 
+int GenericMeshData::generateLods() {
+  lods_.clear();
+  lodsGenerated_ = true;
+  if (!meshData_ || !meshData_->isIndexed() ||
+      meshData_->primitive() != Mn::MeshPrimitive::Triangles) {
+    return 0;
+  }
+  for (geo::MeshLod& lod : geo::generateMeshLods(collisionMeshData_.positions,
+                                                 collisionMeshData_.indices)) {
+    lods_.emplace_back(std::move(lod.indices), lod.error);
+  }
+  // compiled on the next upload
+  buffersOnGPU_ = false;
+  return lods_.size();
+}  // generateLods
+
+bool GenericMeshData::isMergeable() const {
+  if (!meshData_ || meshData_->primitive() != Mn::MeshPrimitive::Triangles) {
+    return false;
+  }
+  for (Mn::UnsignedInt i = 0; i < meshData_->attributeCount(); ++i) {
+    const Mn::VertexFormat format = meshData_->attributeFormat(i);
+    switch (meshData_->attributeName(i)) {
+      case Mn::Trade::MeshAttribute::Position:
+      case Mn::Trade::MeshAttribute::Normal:
+      case Mn::Trade::MeshAttribute::Bitangent:
+        if (format != Mn::VertexFormat::Vector3) {
+          return false;
+        }
+        break;
+      case Mn::Trade::MeshAttribute::Tangent:
+        if (format != Mn::VertexFormat::Vector3 &&
+            format != Mn::VertexFormat::Vector4) {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+bool GenericMeshData::hasSameAttributes(const GenericMeshData& other) const {
+  const Mn::Trade::MeshData& a = *meshData_;
+  const Mn::Trade::MeshData& b = *other.meshData_;
+  if (a.attributeCount() != b.attributeCount()) {
+    return false;
+  }
+  for (Mn::UnsignedInt i = 0; i < a.attributeCount(); ++i) {
+    if (a.attributeName(i) != b.attributeName(i) ||
+        a.attributeFormat(i) != b.attributeFormat(i) ||
+        a.attributeArraySize(i) != b.attributeArraySize(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void GenericMeshData::setMergedMeshData(
+    const std::vector<std::pair<const GenericMeshData*, Mn::Matrix4>>& meshes,
+    std::vector<gfx::Drawable::Submesh>& submeshes) {
+  CORRADE_INTERNAL_ASSERT(!meshes.empty());
+  const Mn::Trade::MeshData& first = *meshes.front().first->meshData_;
+
+  std::size_t vertexCount = 0;
+  std::size_t indexCount = 0;
+  for (const auto& mesh : meshes) {
+    const Mn::Trade::MeshData& meshData = *mesh.first->meshData_;
+    vertexCount += meshData.vertexCount();
+    indexCount +=
+        meshData.isIndexed() ? meshData.indexCount() : meshData.vertexCount();
+  }
+
+  // one interleaved buffer with the attributes of the first mesh, like
+  // compactLodMeshData()
+  std::vector<std::size_t> attributeSizes;
+  std::size_t stride = 0;
+  for (Mn::UnsignedInt i = 0; i < first.attributeCount(); ++i) {
+    attributeSizes.push_back(first.attribute(i).size()[1]);
+    stride += attributeSizes.back();
+  }
+  Cr::Containers::Array<char> vertexData{Cr::Containers::NoInit,
+                                         vertexCount * stride};
+  Cr::Containers::Array<char> indexData{Cr::Containers::NoInit,
+                                        indexCount * sizeof(Mn::UnsignedInt)};
+  auto indices = Cr::Containers::arrayCast<Mn::UnsignedInt>(
+      Cr::Containers::arrayView(indexData));
+
+  submeshes.clear();
+  std::size_t vertexOffset = 0;
+  std::size_t indexOffset = 0;
+  for (const auto& mesh : meshes) {
+    const Mn::Trade::MeshData& meshData = *mesh.first->meshData_;
+    const Mn::Matrix4& transformation = mesh.second;
+    const Mn::Matrix3x3 normalMatrix = transformation.normalMatrix();
+    std::size_t attributeOffset = 0;
+    for (Mn::UnsignedInt i = 0; i < meshData.attributeCount(); ++i) {
+      Cr::Containers::StridedArrayView2D<const char> source =
+          meshData.attribute(i);
+      char* const target = vertexData + vertexOffset * stride + attributeOffset;
+      for (std::size_t v = 0; v < meshData.vertexCount(); ++v) {
+        std::memcpy(target + v * stride, source[v].data(), attributeSizes[i]);
+      }
+
+      // the formats are checked by isMergeable(), the handedness of
+      // four-component tangents is kept
+      const Mn::Trade::MeshAttribute name = meshData.attributeName(i);
+      for (std::size_t v = 0; v < meshData.vertexCount(); ++v) {
+        auto& vector = *reinterpret_cast<Mn::Vector3*>(target + v * stride);
+        if (name == Mn::Trade::MeshAttribute::Position) {
+          vector = transformation.transformPoint(vector);
+        } else if (name == Mn::Trade::MeshAttribute::Normal) {
+          vector = (normalMatrix * vector).normalized();
+        } else if (name == Mn::Trade::MeshAttribute::Tangent ||
+                   name == Mn::Trade::MeshAttribute::Bitangent) {
+          vector = transformation.transformVector(vector).normalized();
+        }
+      }
+      attributeOffset += attributeSizes[i];
+    }
+
+    const std::size_t meshIndexCount =
+        meshData.isIndexed() ? meshData.indexCount() : meshData.vertexCount();
+    if (meshData.isIndexed()) {
+      Cr::Containers::Array<Mn::UnsignedInt> meshIndices =
+          meshData.indicesAsArray();
+      for (std::size_t k = 0; k < meshIndexCount; ++k) {
+        indices[indexOffset + k] = vertexOffset + meshIndices[k];
+      }
+    } else {
+      for (std::size_t k = 0; k < meshIndexCount; ++k) {
+        indices[indexOffset + k] = vertexOffset + k;
+      }
+    }
+
+    Cr::Containers::Array<Mn::Vector3> positions =
+        meshData.positions3DAsArray();
+    Mn::MeshTools::transformPointsInPlace(transformation, positions);
+    submeshes.push_back({Mn::UnsignedInt(indexOffset),
+                         Mn::UnsignedInt(meshIndexCount),
+                         geo::getPointSetBounds(positions)});
+
+    vertexOffset += meshData.vertexCount();
+    indexOffset += meshIndexCount;
+  }
+
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      first.attributeCount()};
+  std::size_t attributeOffset = 0;
+  for (Mn::UnsignedInt i = 0; i < first.attributeCount(); ++i) {
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        first.attributeName(i), first.attributeFormat(i),
+        Cr::Containers::StridedArrayView1D<const void>{
+            Cr::Containers::arrayView(vertexData),
+            vertexData + attributeOffset, vertexCount, std::ptrdiff_t(stride)},
+        first.attributeArraySize(i)};
+    attributeOffset += attributeSizes[i];
+  }
+
+  Mn::Trade::MeshIndexData indexView{indices};
+  setMeshData(Mn::Trade::MeshData{Mn::MeshPrimitive::Triangles,
+                                  std::move(indexData), indexView,
+                                  std::move(vertexData), std::move(attributes),
+                                  Mn::UnsignedInt(vertexCount)});
+}  // setMergedMeshData
+
+Mn::Trade::MeshData GenericMeshData::compactLodMeshData(
+    const std::vector<Mn::UnsignedInt>& lodIndices) const {
+  // new index of every vertex of meshData_ used by the level
+  constexpr Mn::UnsignedInt Unused = ~Mn::UnsignedInt{};
+  std::vector<Mn::UnsignedInt> remap(meshData_->vertexCount(), Unused);
+  std::vector<Mn::UnsignedInt> usedVertices;
+  Cr::Containers::Array<char> indexData{Cr::Containers::NoInit,
+                                        lodIndices.size() *
+                                            sizeof(Mn::UnsignedInt)};
+  auto indices = Cr::Containers::arrayCast<Mn::UnsignedInt>(
+      Cr::Containers::arrayView(indexData));
+  for (std::size_t i = 0; i < lodIndices.size(); ++i) {
+    Mn::UnsignedInt& index = remap[lodIndices[i]];
+    if (index == Unused) {
+      index = usedVertices.size();
+      usedVertices.push_back(lodIndices[i]);
+    }
+    indices[i] = index;
+  }
+
+  // copy the used vertices into a new interleaved buffer with the attributes
+  // of meshData_
+  std::vector<std::size_t> attributeSizes;
+  std::size_t stride = 0;
+  for (Mn::UnsignedInt i = 0; i < meshData_->attributeCount(); ++i) {
+    attributeSizes.push_back(meshData_->attribute(i).size()[1]);
+    stride += attributeSizes.back();
+  }
+  Cr::Containers::Array<char> vertexData{Cr::Containers::NoInit,
+                                         usedVertices.size() * stride};
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      meshData_->attributeCount()};
+  std::size_t offset = 0;
+  for (Mn::UnsignedInt i = 0; i < meshData_->attributeCount(); ++i) {
+    Cr::Containers::StridedArrayView2D<const char> source =
+        meshData_->attribute(i);
+    for (std::size_t v = 0; v < usedVertices.size(); ++v) {
+      std::memcpy(vertexData + v * stride + offset,
+                  source[usedVertices[v]].data(), attributeSizes[i]);
+    }
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        meshData_->attributeName(i), meshData_->attributeFormat(i),
+        Cr::Containers::StridedArrayView1D<const void>{
+            Cr::Containers::arrayView(vertexData), vertexData + offset,
+            usedVertices.size(), std::ptrdiff_t(stride)},
+        meshData_->attributeArraySize(i)};
+    offset += attributeSizes[i];
+  }
+
+  Mn::Trade::MeshIndexData indexView{indices};
+  return Mn::Trade::MeshData{Mn::MeshPrimitive::Triangles,
+                             std::move(indexData),
+                             indexView,
+                             std::move(vertexData),
+                             std::move(attributes),
+                             Mn::UnsignedInt(usedVertices.size())};
+}  // compactLodMeshData
+
 }  // namespace assets
 }  // namespace esp
@@ -13,9 +13,13 @@
 #include <Corrade/Containers/Optional.h>
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/Trade/AbstractImporter.h>
+#include <Magnum/Trade/MeshData.h>
+#include <utility>
+#include <vector>
 
 #include "BaseMesh.h"
 #include "esp/core/esp.h"
+#include "esp/gfx/Drawable.h"
 
 namespace esp {
 namespace assets {
@@ -34,6 +38,21 @@ class GenericMeshData : public BaseMesh {
      * @brief Compiled openGL render data for the mesh.
      */
     Magnum::GL::Mesh mesh;
+
+    /**
+     * @brief A compiled coarser level of detail of the mesh
+     */
+    struct Lod {
+      Magnum::GL::Mesh mesh;
+      //! maximal distance a vertex moved, in the units of the mesh
+      float error;
+    };
+
+    /**
+     * @brief Coarser levels of detail of @ref mesh, from the finest to the
+     * coarsest, see @ref GenericMeshData::generateLods()
+     */
+    std::vector<Lod> lods;
   };
 
   /** @brief Constructor. Sets @ref SupportedMeshType::GENERIC_MESH to identify
@@ -53,6 +72,28 @@ class GenericMeshData : public BaseMesh {
    */
   virtual void uploadBuffersToGPU(bool forceReload = false) override;
 
+  /**
+   * @brief Free the mesh data, the collision data and the levels of detail
+   * once uploaded. Reloading with @ref uploadBuffersToGPU() does nothing
+   * until the data is set again, e.g. with @ref setMeshData().
+   */
+  virtual bool releaseHostData() override;
+
+  /**
+   * @brief Set whether the next @ref uploadBuffersToGPU() compresses the
+   * vertex formats on the GPU
+   *
+   * Normals, tangents and bitangents are uploaded as 16-bit normalized
+   * integers and texture coordinates as 16-bit normalized integers if they
+   * are in [0, 1], as half floats otherwise. The GPU converts them back to
+   * floats when fetching the vertices, so the shaders work unchanged. The
+   * positions stay floats, since meshes span tens of meters and the
+   * collision data references them. The mesh data on the CPU is unchanged.
+   */
+  void setCompressVertexFormats(bool compress) {
+    compressVertexFormats_ = compress;
+  }
+
   /**
    * @brief Set mesh data from external source, and sets the @ref collisionMesh_
    * references.  Can be used for meshDatas that are manually synthesized, such
@@ -82,6 +123,46 @@ class GenericMeshData : public BaseMesh {
   void importAndSetMeshData(Magnum::Trade::AbstractImporter& importer,
                             const std::string& meshName);
 
+  /**
+   * @brief Generate coarser levels of detail of the mesh with
+   * @ref geo::generateMeshLods(). They are compiled into
+   * @ref RenderingBuffer::lods by the next @ref uploadBuffersToGPU().
+   *
+   * Does nothing for meshes which are not made of indexed triangles.
+   * @return the number of levels generated
+   */
+  int generateLods();
+
+  /**
+   * @brief Whether the mesh can be merged with others by @ref
+   * setMergedMeshData(): a triangle mesh whose positions, normals, tangents
+   * and bitangents are floats
+   */
+  bool isMergeable() const;
+
+  /**
+   * @brief Whether the mesh has the same attributes, in the same formats and
+   * order, as @p other
+   */
+  bool hasSameAttributes(const GenericMeshData& other) const;
+
+  /**
+   * @brief Set the mesh data to the indexed triangles of several meshes,
+   * transformed to a common space
+   * @param meshes The meshes, which have to be @ref isMergeable() and have
+   * the same attributes, and their transformations
+   * @param[out] submeshes Filled with the range of the indices and the
+   * transformed bounding box of each mesh, in order
+   *
+   * Positions are transformed as points, normals by the normal matrix and
+   * tangents and bitangents by the rotation and scaling. The other
+   * attributes are copied as they are.
+   */
+  void setMergedMeshData(
+      const std::vector<std::pair<const GenericMeshData*, Magnum::Matrix4>>&
+          meshes,
+      std::vector<gfx::Drawable::Submesh>& submeshes);
+
   /**
    * @brief Returns a pointer to the compiled render data storage structure.
    * @return Pointer to the @ref renderingBuffer_.
@@ -107,11 +188,27 @@ class GenericMeshData : public BaseMesh {
 
   bool needsNormals_ = true;
 
+  bool compressVertexFormats_ = false;
+
  private:
+  // sets the data of meshes it loads, reads the data of meshes it stores
+  friend class MeshCache;
+
+  /* Cache file mapped by MeshCache::load(), referenced by all the data */
+  Corrade::Containers::Array<char> cacheFile_;
   /* Internal; can store data referenced by positions / indices if the original
      MeshData doesn't have them in desired type */
   Corrade::Containers::Array<Magnum::Vector3> positionData_;
   Corrade::Containers::Array<Magnum::UnsignedInt> indexData_;
+  /* Triangle indices and error of each level of detail, see generateLods() */
+  std::vector<std::pair<std::vector<Magnum::UnsignedInt>, float>> lods_;
+  /* Whether generateLods() ran, even if it generated no level */
+  bool lodsGenerated_ = false;
+
+  /* Mesh data with the vertices of meshData_ used by the level of detail
+     @p lodIndices and the indices remapped to them */
+  Magnum::Trade::MeshData compactLodMeshData(
+      const std::vector<Magnum::UnsignedInt>& lodIndices) const;
 };
 }  // namespace assets
 }  // namespace esp
@@ -0,0 +1,496 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "MeshCache.h"
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/VertexFormat.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "GenericMeshData.h"
+#include "esp/core/MappedFile.h"
+#include "esp/geo/geo.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 'm', 'e', 's', 'h', '\0'};
+constexpr std::uint32_t Version = 1;
+// of the blobs, so that the mapped views are aligned for any vertex format
+constexpr std::size_t Alignment = 16;
+
+enum : std::uint32_t {
+  LodsGenerated = 1 << 0,
+  // the index type is not UnsignedInt, so collision indices are stored
+  // unpacked
+  SeparateCollisionIndices = 1 << 1,
+};
+
+struct Blob {
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint64_t sourceSize;
+  std::int64_t sourceModified;
+  std::uint32_t primitive;
+  std::uint32_t indexType;
+  std::uint32_t indexCount;
+  std::uint32_t vertexCount;
+  std::uint32_t attributeCount;
+  std::uint32_t lodCount;
+  Blob indices;
+  Blob vertices;
+  Blob positions;
+  Blob collisionIndices;
+};
+
+// followed by attributeCount of these, then lodCount LodHeaders
+struct AttributeHeader {
+  std::uint32_t name;
+  std::uint32_t format;
+  std::uint64_t offset;
+  std::int64_t stride;
+  std::uint32_t arraySize;
+  std::uint32_t padding;
+};
+
+struct LodHeader {
+  Blob indices;
+  float error;
+  std::uint32_t padding;
+};
+
+constexpr char CollisionMagic[8] = {'e', 's', 'p', 'c', 'o', 'l', 'l', '\0'};
+constexpr std::uint32_t CollisionVersion = 1;
+
+// followed by the positions and the indices
+struct CollisionFileHeader {
+  char magic[8];
+  std::uint32_t version;
+  float maxError;
+  std::uint64_t sourceSize;
+  std::int64_t sourceModified;
+  std::uint32_t vertexCount;
+  std::uint32_t indexCount;
+};
+
+struct SourceStamp {
+  std::uint64_t size;
+  std::int64_t modified;
+};
+
+bool sourceStamp(const std::string& filename, SourceStamp& stamp) {
+  struct stat status;
+  if (::stat(filename.c_str(), &status) != 0) {
+    return false;
+  }
+  stamp.size = status.st_size;
+  stamp.modified = status.st_mtime;
+  return true;
+}
+
+std::size_t aligned(std::size_t offset) {
+  return (offset + Alignment - 1) / Alignment * Alignment;
+}
+
+// the blob in file, empty if it is out of bounds
+Cr::Containers::ArrayView<char> blobView(Cr::Containers::ArrayView<char> file,
+                                         const Blob& blob) {
+  if (blob.offset > file.size() || blob.size > file.size() - blob.offset) {
+    return nullptr;
+  }
+  return file.slice(blob.offset, blob.offset + blob.size);
+}
+
+bool isValidIndexType(std::uint32_t type) {
+  return type == std::uint32_t(Mn::MeshIndexType::UnsignedByte) ||
+         type == std::uint32_t(Mn::MeshIndexType::UnsignedShort) ||
+         type == std::uint32_t(Mn::MeshIndexType::UnsignedInt);
+}
+
+// the file of mesh meshIndex of assetFilename in directory, with extension
+std::string cachedFilename(const std::string& directory,
+                           const std::string& assetFilename,
+                           int meshIndex,
+                           const char* extension) {
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx",
+                static_cast<unsigned long long>(core::hashBytes(
+                    {assetFilename.data(), assetFilename.size()})));
+  return Cr::Utility::Directory::join(
+      directory, Cr::Utility::Directory::filename(assetFilename) + "." +
+                     hash + "." + std::to_string(meshIndex) + extension);
+}
+
+}  // namespace
+
+MeshCache::MeshCache(std::string directory)
+    : directory_{std::move(directory)} {
+  if (!Cr::Utility::Directory::mkpath(directory_)) {
+    LOG(WARNING) << "MeshCache: cannot create " << directory_
+                 << ", meshes won't be cached";
+  }
+}
+
+std::string MeshCache::cacheFilename(const std::string& assetFilename,
+                                     int meshIndex) const {
+  return cachedFilename(directory_, assetFilename, meshIndex, ".mesh");
+}
+
+std::string MeshCache::simplifiedCollisionFilename(
+    const std::string& assetFilename,
+    int meshIndex) const {
+  return cachedFilename(directory_, assetFilename, meshIndex, ".collision");
+}
+
+bool MeshCache::loadSimplifiedCollision(const std::string& assetFilename,
+                                        int meshIndex,
+                                        float maxError,
+                                        geo::SimplifiedMesh& mesh) const {
+  SourceStamp stamp;
+  if (!sourceStamp(assetFilename, stamp)) {
+    return false;
+  }
+  Cr::Containers::Array<char> file =
+      core::mapFile(simplifiedCollisionFilename(assetFilename, meshIndex));
+  if (file.size() < sizeof(CollisionFileHeader)) {
+    return false;
+  }
+  CollisionFileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  const std::size_t positionsSize =
+      std::size_t{header.vertexCount} * sizeof(Mn::Vector3);
+  const std::size_t indicesSize =
+      std::size_t{header.indexCount} * sizeof(Mn::UnsignedInt);
+  if (std::memcmp(header.magic, CollisionMagic, sizeof(CollisionMagic)) !=
+          0 ||
+      header.version != CollisionVersion || header.maxError != maxError ||
+      header.sourceSize != stamp.size ||
+      header.sourceModified != stamp.modified ||
+      file.size() != sizeof(header) + positionsSize + indicesSize) {
+    return false;
+  }
+  const char* data = file.data() + sizeof(header);
+  mesh.positions.resize(header.vertexCount);
+  mesh.indices.resize(header.indexCount);
+  if (positionsSize) {
+    std::memcpy(mesh.positions.data(), data, positionsSize);
+  }
+  if (indicesSize) {
+    std::memcpy(mesh.indices.data(), data + positionsSize, indicesSize);
+  }
+  return true;
+}
+
+bool MeshCache::storeSimplifiedCollision(
+    const std::string& assetFilename,
+    int meshIndex,
+    float maxError,
+    const geo::SimplifiedMesh& mesh) const {
+  SourceStamp stamp;
+  if (!sourceStamp(assetFilename, stamp)) {
+    return false;
+  }
+  CollisionFileHeader header{};
+  std::memcpy(header.magic, CollisionMagic, sizeof(CollisionMagic));
+  header.version = CollisionVersion;
+  header.maxError = maxError;
+  header.sourceSize = stamp.size;
+  header.sourceModified = stamp.modified;
+  header.vertexCount = mesh.positions.size();
+  header.indexCount = mesh.indices.size();
+  const std::size_t positionsSize = mesh.positions.size() * sizeof(Mn::Vector3);
+  const std::size_t indicesSize =
+      mesh.indices.size() * sizeof(Mn::UnsignedInt);
+  const std::size_t size = sizeof(header) + positionsSize + indicesSize;
+  Cr::Containers::Array<char> data{Cr::Containers::NoInit, size};
+  std::memcpy(data, &header, sizeof(header));
+  if (positionsSize) {
+    std::memcpy(data + sizeof(header), mesh.positions.data(), positionsSize);
+  }
+  if (indicesSize) {
+    std::memcpy(data + sizeof(header) + positionsSize, mesh.indices.data(),
+                indicesSize);
+  }
+  return core::writeFileAtomically(
+      simplifiedCollisionFilename(assetFilename, meshIndex), data);
+}
+
+bool MeshCache::load(const std::string& assetFilename,
+                     int meshIndex,
+                     bool needsLods,
+                     GenericMeshData& mesh) const {
+  SourceStamp stamp;
+  if (!sourceStamp(assetFilename, stamp)) {
+    return false;
+  }
+  Cr::Containers::Array<char> file =
+      core::mapFile(cacheFilename(assetFilename, meshIndex));
+  if (file.size() < sizeof(FileHeader)) {
+    return false;
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.sourceSize != stamp.size ||
+      header.sourceModified != stamp.modified) {
+    return false;
+  }
+  return deserialize(std::move(file), needsLods, mesh);
+}
+
+bool MeshCache::deserialize(Cr::Containers::Array<char> file,
+                            bool needsLods,
+                            GenericMeshData& mesh) {
+  if (file.size() < sizeof(FileHeader)) {
+    return false;
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version ||
+      (needsLods && !(header.flags & LodsGenerated)) ||
+      !isValidIndexType(header.indexType) ||
+      file.size() < sizeof(FileHeader) +
+                        header.attributeCount * sizeof(AttributeHeader) +
+                        header.lodCount * sizeof(LodHeader)) {
+    return false;
+  }
+
+  // check the blob sizes against the counts
+  const Mn::MeshIndexType indexType = Mn::MeshIndexType(header.indexType);
+  Cr::Containers::ArrayView<char> indices = blobView(file, header.indices);
+  Cr::Containers::ArrayView<char> vertices = blobView(file, header.vertices);
+  Cr::Containers::ArrayView<char> positions = blobView(file, header.positions);
+  Cr::Containers::ArrayView<char> collisionIndices = indices;
+  if (header.flags & SeparateCollisionIndices) {
+    collisionIndices = blobView(file, header.collisionIndices);
+  } else if (indexType != Mn::MeshIndexType::UnsignedInt) {
+    return false;
+  }
+  if (indices.size() !=
+          header.indexCount * Mn::meshIndexTypeSize(indexType) ||
+      vertices.size() != header.vertices.size ||
+      positions.size() != header.vertexCount * sizeof(Mn::Vector3) ||
+      collisionIndices.size() != header.indexCount * sizeof(Mn::UnsignedInt)) {
+    return false;
+  }
+
+  const char* tables = file.data() + sizeof(FileHeader);
+  Cr::Containers::Array<Mn::Trade::MeshAttributeData> attributes{
+      header.attributeCount};
+  for (std::uint32_t i = 0; i < header.attributeCount; ++i) {
+    AttributeHeader attribute;
+    std::memcpy(&attribute, tables + i * sizeof(AttributeHeader),
+                sizeof(attribute));
+    const Mn::VertexFormat format = Mn::VertexFormat(attribute.format);
+    if (Mn::isVertexFormatImplementationSpecific(format) ||
+        attribute.stride <= 0) {
+      return false;
+    }
+    const std::size_t size =
+        Mn::vertexFormatSize(format) *
+        std::max(attribute.arraySize, std::uint32_t{1});
+    if (header.vertexCount &&
+        attribute.offset + (header.vertexCount - 1) * attribute.stride +
+                size >
+            vertices.size()) {
+      return false;
+    }
+    attributes[i] = Mn::Trade::MeshAttributeData{
+        Mn::Trade::MeshAttribute(attribute.name), format,
+        Cr::Containers::StridedArrayView1D<const void>{
+            vertices, vertices.data() + attribute.offset, header.vertexCount,
+            std::ptrdiff_t(attribute.stride)},
+        Mn::UnsignedShort(attribute.arraySize)};
+  }
+
+  std::vector<std::pair<std::vector<Mn::UnsignedInt>, float>> lods;
+  if (needsLods) {
+    tables += header.attributeCount * sizeof(AttributeHeader);
+    for (std::uint32_t i = 0; i < header.lodCount; ++i) {
+      LodHeader lod;
+      std::memcpy(&lod, tables + i * sizeof(LodHeader), sizeof(lod));
+      Cr::Containers::ArrayView<char> lodIndices =
+          blobView(file, lod.indices);
+      if (lodIndices.size() != lod.indices.size ||
+          lodIndices.size() % sizeof(Mn::UnsignedInt)) {
+        return false;
+      }
+      auto values = Cr::Containers::arrayCast<const Mn::UnsignedInt>(
+          Cr::Containers::ArrayView<const char>{lodIndices});
+      lods.emplace_back(
+          std::vector<Mn::UnsignedInt>(values.begin(), values.end()),
+          lod.error);
+    }
+  }
+
+  // the views stay valid when the mapping moves into the mesh
+  mesh.meshData_ = Mn::Trade::MeshData{
+      Mn::MeshPrimitive(header.primitive),
+      Mn::Trade::DataFlag::Mutable,
+      indices,
+      Mn::Trade::MeshIndexData{indexType, indices},
+      Mn::Trade::DataFlag::Mutable,
+      vertices,
+      std::move(attributes),
+      header.vertexCount};
+  mesh.collisionMeshData_.primitive = Mn::MeshPrimitive(header.primitive);
+  mesh.collisionMeshData_.positions =
+      Cr::Containers::arrayCast<Mn::Vector3>(positions);
+  mesh.collisionMeshData_.indices =
+      Cr::Containers::arrayCast<Mn::UnsignedInt>(collisionIndices);
+  mesh.positionData_ = nullptr;
+  mesh.indexData_ = nullptr;
+  mesh.lods_ = std::move(lods);
+  mesh.lodsGenerated_ = needsLods;
+  mesh.cacheFile_ = std::move(file);
+  mesh.hostDataReleased_ = false;
+  return true;
+}
+
+bool MeshCache::store(const std::string& assetFilename,
+                      int meshIndex,
+                      const GenericMeshData& mesh) const {
+  SourceStamp stamp;
+  if (!sourceStamp(assetFilename, stamp)) {
+    return false;
+  }
+  Cr::Containers::Array<char> data = serialize(mesh);
+  if (data.empty()) {
+    return false;
+  }
+  FileHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  header.sourceSize = stamp.size;
+  header.sourceModified = stamp.modified;
+  std::memcpy(data.data(), &header, sizeof(header));
+  return core::writeFileAtomically(cacheFilename(assetFilename, meshIndex),
+                                   data);
+}
+
+Cr::Containers::Array<char> MeshCache::serialize(const GenericMeshData& mesh) {
+  const Cr::Containers::Optional<Mn::Trade::MeshData>& meshData =
+      mesh.meshData_;
+  if (!meshData || !meshData->isIndexed() ||
+      Mn::isMeshPrimitiveImplementationSpecific(meshData->primitive())) {
+    return {};
+  }
+  for (Mn::UnsignedInt i = 0; i < meshData->attributeCount(); ++i) {
+    if (Mn::isVertexFormatImplementationSpecific(
+            meshData->attributeFormat(i))) {
+      return {};
+    }
+  }
+
+  FileHeader header{};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.flags = mesh.lodsGenerated_ ? LodsGenerated : 0;
+  header.primitive = std::uint32_t(meshData->primitive());
+  header.indexType = std::uint32_t(meshData->indexType());
+  header.indexCount = meshData->indexCount();
+  header.vertexCount = meshData->vertexCount();
+  header.attributeCount = meshData->attributeCount();
+  header.lodCount = mesh.lods_.size();
+
+  Cr::Containers::ArrayView<const char> indices{
+      static_cast<const char*>(meshData->indices().data()),
+      meshData->indexCount() * Mn::meshIndexTypeSize(meshData->indexType())};
+  Cr::Containers::ArrayView<const char> vertices = meshData->vertexData();
+  auto positions = Cr::Containers::arrayCast<const char>(
+      mesh.collisionMeshData_.positions);
+  Cr::Containers::ArrayView<const char> collisionIndices;
+  if (meshData->indexType() != Mn::MeshIndexType::UnsignedInt) {
+    header.flags |= SeparateCollisionIndices;
+    collisionIndices =
+        Cr::Containers::arrayCast<const char>(mesh.collisionMeshData_.indices);
+  }
+
+  // lay the blobs out after the tables
+  std::size_t size = sizeof(FileHeader) +
+                     header.attributeCount * sizeof(AttributeHeader) +
+                     header.lodCount * sizeof(LodHeader);
+  auto place = [&size](Blob& blob, std::size_t blobSize) {
+    size = aligned(size);
+    blob.offset = size;
+    blob.size = blobSize;
+    size += blobSize;
+  };
+  place(header.indices, indices.size());
+  place(header.vertices, vertices.size());
+  // the collision positions usually reference the vertex data, see
+  // GenericMeshData::setMeshData(), they're not stored twice then
+  if (!positions.empty() && positions.data() >= vertices.data() &&
+      positions.data() + positions.size() <=
+          vertices.data() + vertices.size()) {
+    header.positions.offset =
+        header.vertices.offset + (positions.data() - vertices.data());
+    header.positions.size = positions.size();
+    positions = nullptr;
+  } else {
+    place(header.positions, positions.size());
+  }
+  place(header.collisionIndices, collisionIndices.size());
+  std::vector<LodHeader> lods(header.lodCount);
+  for (std::size_t i = 0; i < lods.size(); ++i) {
+    place(lods[i].indices,
+          mesh.lods_[i].first.size() * sizeof(Mn::UnsignedInt));
+    lods[i].error = mesh.lods_[i].second;
+    lods[i].padding = 0;
+  }
+
+  Cr::Containers::Array<char> data{Cr::Containers::ValueInit, size};
+  auto write = [&data](const Blob& blob, const void* source) {
+    if (blob.size) {
+      std::memcpy(data + blob.offset, source, blob.size);
+    }
+  };
+  std::memcpy(data, &header, sizeof(header));
+  char* tables = data + sizeof(FileHeader);
+  for (Mn::UnsignedInt i = 0; i < header.attributeCount; ++i) {
+    AttributeHeader attribute{};
+    attribute.name = std::uint32_t(meshData->attributeName(i));
+    attribute.format = std::uint32_t(meshData->attributeFormat(i));
+    attribute.offset =
+        static_cast<const char*>(meshData->attribute(i).data()) -
+        vertices.data();
+    attribute.stride = meshData->attributeStride(i);
+    attribute.arraySize = meshData->attributeArraySize(i);
+    std::memcpy(tables, &attribute, sizeof(attribute));
+    tables += sizeof(attribute);
+  }
+  for (std::size_t i = 0; i < lods.size(); ++i) {
+    std::memcpy(tables, &lods[i], sizeof(LodHeader));
+    tables += sizeof(LodHeader);
+    write(lods[i].indices, mesh.lods_[i].first.data());
+  }
+  write(header.indices, indices.data());
+  write(header.vertices, vertices.data());
+  if (!positions.empty()) {
+    write(header.positions, positions.data());
+  }
+  write(header.collisionIndices, collisionIndices.data());
+  return data;
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,150 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_MESHCACHE_H_
+#define ESP_ASSETS_MESHCACHE_H_
+
+/** @file
+ * @brief Class @ref esp::assets::MeshCache
+ */
+
+#include <Corrade/Containers/Array.h>
+#include <string>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace geo {
+struct SimplifiedMesh;
+}
+namespace assets {
+
+class GenericMeshData;
+
+/**
+ * @brief On-disk cache of the processed meshes of general assets
+ *
+ * Every mesh is stored in its own file, with the interleaved vertex and index
+ * buffers as they are uploaded, the unpacked collision positions and indices
+ * and the levels of detail. Loading a mesh from the cache maps its file
+ * copy-on-write and points the @ref GenericMeshData at it, so processes
+ * loading the same dataset share the host memory of their meshes instead of
+ * each keeping a copy, and skip the import and processing.
+ *
+ * Files are named after the asset filename and the mesh index, and are
+ * stale once the size or the modification time of the asset changes. They
+ * are written atomically, so several processes can share a directory.
+ * Loading and storing are safe to call from multiple threads.
+ *
+ * The simplified collision meshes of stages, see
+ * @ref ResourceManager::setStageCollisionSimplification(), are cached next to
+ * the meshes in files of their own, per simplification error.
+ */
+class MeshCache {
+ public:
+  /**
+   * @brief Constructor
+   * @param directory, the cache directory, created if it doesn't exist
+   */
+  explicit MeshCache(std::string directory);
+
+  /** @brief The cache directory */
+  const std::string& directory() const { return directory_; }
+
+  /**
+   * @brief Load mesh @p meshIndex of @p assetFilename into @p mesh
+   * @param assetFilename, the asset the mesh was imported from
+   * @param meshIndex, the index of the mesh in the asset
+   * @param needsLods, whether the levels of detail have to be cached too
+   * @param mesh, a mesh without data, new or after
+   * GenericMeshData::releaseHostData()
+   * @return false if the mesh is not cached, is stale or was stored without
+   * levels of detail which are needed, leaving @p mesh untouched
+   */
+  bool load(const std::string& assetFilename,
+            int meshIndex,
+            bool needsLods,
+            GenericMeshData& mesh) const;
+
+  /**
+   * @brief Store mesh @p meshIndex of @p assetFilename
+   * @param assetFilename, the asset the mesh was imported from
+   * @param meshIndex, the index of the mesh in the asset
+   * @param mesh, the mesh with its data set, its levels of detail are stored
+   * if they were generated
+   * @return false if the mesh can't be cached, i.e. it's not indexed or uses
+   * implementation-specific formats, or the file can't be written
+   */
+  bool store(const std::string& assetFilename,
+             int meshIndex,
+             const GenericMeshData& mesh) const;
+
+  /** @brief The file mesh @p meshIndex of @p assetFilename is cached in */
+  std::string cacheFilename(const std::string& assetFilename,
+                            int meshIndex) const;
+
+  /**
+   * @brief Load the simplified collision mesh of mesh @p meshIndex of
+   * @p assetFilename into @p mesh
+   * @param assetFilename, the asset the mesh was imported from
+   * @param meshIndex, the index of the mesh in the asset
+   * @param maxError, the error the mesh was simplified with
+   * @param mesh, the mesh to fill
+   * @return false if the mesh is not cached, is stale or was simplified with
+   * another error, leaving @p mesh untouched
+   */
+  bool loadSimplifiedCollision(const std::string& assetFilename,
+                               int meshIndex,
+                               float maxError,
+                               geo::SimplifiedMesh& mesh) const;
+
+  /**
+   * @brief Store the simplified collision mesh of mesh @p meshIndex of
+   * @p assetFilename
+   * @return false if the file can't be written
+   */
+  bool storeSimplifiedCollision(const std::string& assetFilename,
+                                int meshIndex,
+                                float maxError,
+                                const geo::SimplifiedMesh& mesh) const;
+
+  /**
+   * @brief The file the simplified collision mesh of mesh @p meshIndex of
+   * @p assetFilename is cached in
+   */
+  std::string simplifiedCollisionFilename(const std::string& assetFilename,
+                                          int meshIndex) const;
+
+  /**
+   * @brief The contents of a cache file of @p mesh, without the stamp of its
+   * asset, e.g. to store it in another container
+   * @return empty if the mesh can't be cached, see @ref store()
+   */
+  static Corrade::Containers::Array<char> serialize(
+      const GenericMeshData& mesh);
+
+  /**
+   * @brief Point @p mesh at the contents of @ref serialize()
+   * @param data, the contents, referenced by the mesh from now on, e.g. a
+   * mapped file
+   * @param needsLods, whether the levels of detail are needed
+   * @param mesh, a mesh without data, new or after
+   * GenericMeshData::releaseHostData()
+   * @return false if @p data is invalid or has no levels of detail which are
+   * needed, leaving @p mesh untouched
+   */
+  static bool deserialize(Corrade::Containers::Array<char> data,
+                          bool needsLods,
+                          GenericMeshData& mesh);
+
+ private:
+  std::string directory_;
+
+  ESP_SMART_POINTERS(MeshCache)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_MESHCACHE_H_
@@ -5,7 +5,6 @@
 #include "Mp3dInstanceMeshData.h"
 
 #include <fstream>
-#include <sstream>
 #include <vector>
 
 #include <sophus/so3.hpp>
@@ -13,6 +12,7 @@
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/StridedArrayView.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/Image.h>
@@ -20,6 +20,7 @@
 #include <Magnum/PixelFormat.h>
 #include <Magnum/Trade/Trade.h>
 
+#include "PlyReader.h"
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
 #include "esp/io/io.h"
@@ -28,94 +29,67 @@ namespace esp {
 namespace assets {
 
 bool Mp3dInstanceMeshData::loadMp3dPLY(const std::string& plyFile) {
-  std::ifstream ifs(plyFile);
-  if (!ifs.good()) {
+  PlyReader reader;
+  if (!reader.open(plyFile)) {
     LOG(ERROR) << "Cannot open file at " << plyFile;
     return false;
   }
 
-  std::string line, token;
-  std::istringstream iss;
-  std::getline(ifs, line);
-  if (line != "ply") {
+  // normals and texture coordinates are skipped
+  const PlyReader::Element* vertex = reader.element("vertex");
+  const PlyReader::Element* face = reader.element("face");
+  if (!vertex || !face) {
     LOG(ERROR) << "Invalid ply file header";
     return false;
   }
-  std::getline(ifs, line);
-  if (line != "format binary_little_endian 1.0") {
-    LOG(ERROR) << "Invalid ply file header";
-    return false;
-  }
-
-  // element vertex nVertex
-  std::getline(ifs, line);
-  iss.str(line);
-  iss >> token;
-  if (token != "element") {
-    LOG(ERROR) << "Invalid element vertex header line";
-    return false;
-  }
-  int nVertex;
-  iss >> token >> nVertex;
-
-  // we know the header is fixed so skip until face count
-  do {
-    std::getline(ifs, line);
-  } while ((line.substr(0, 12) != "element face") && !ifs.eof());
-  std::stringstream iss2;
-  iss2.str(line);
-  iss2 >> token;
-  if (token != "element") {
-    LOG(ERROR) << "Invalid element face header line";
-    return false;
+  const PlyReader::Property* vertexProperties[]{
+      PlyReader::property(*vertex, "x"),
+      PlyReader::property(*vertex, "y"),
+      PlyReader::property(*vertex, "z"),
+      PlyReader::property(*vertex, "red"),
+      PlyReader::property(*vertex, "green"),
+      PlyReader::property(*vertex, "blue")};
+  const PlyReader::Property* faceProperties[]{
+      PlyReader::property(*face, "vertex_indices"),
+      PlyReader::property(*face, "material_id"),
+      PlyReader::property(*face, "segment_id"),
+      PlyReader::property(*face, "category_id")};
+  for (const PlyReader::Property* property : vertexProperties) {
+    if (!property) {
+      LOG(ERROR) << "Invalid element vertex header line";
+      return false;
+    }
   }
-  int nFace;
-  iss2 >> token >> nFace;
-
-  // ignore rest of header
-  do {
-    std::getline(ifs, line);
-  } while ((line != "end_header") && !ifs.eof());
-
-  cpu_cbo_.clear();
-  cpu_cbo_.reserve(nVertex);
-  cpu_vbo_.clear();
-  cpu_vbo_.reserve(nVertex);
-  cpu_ibo_.clear();
-  cpu_ibo_.reserve(nFace);
-
-  for (int i = 0; i < nVertex; ++i) {
-    vec3f position;
-    vec3f normal;
-    vec2f texCoords;
-    vec3uc rgb;
-
-    ifs.read(reinterpret_cast<char*>(position.data()), 3 * sizeof(float));
-    ifs.read(reinterpret_cast<char*>(normal.data()), 3 * sizeof(float));
-    ifs.read(reinterpret_cast<char*>(texCoords.data()), 2 * sizeof(float));
-    ifs.read(reinterpret_cast<char*>(rgb.data()), 3 * sizeof(uint8_t));
-    cpu_vbo_.emplace_back(position);
-    cpu_cbo_.emplace_back(rgb);
+  for (const PlyReader::Property* property : faceProperties) {
+    if (!property) {
+      LOG(ERROR) << "Invalid element face header line";
+      return false;
+    }
   }
-
-  for (int i = 0; i < nFace; ++i) {
-    uint8_t nIndices;
-    vec3ui indices;
-    int32_t materialId;
-    int32_t segmentId;
-    int32_t categoryId;
-
-    ifs.read(reinterpret_cast<char*>(&nIndices), sizeof(nIndices));
-    ASSERT(nIndices == 3);
-    ifs.read(reinterpret_cast<char*>(indices.data()), 3 * sizeof(int));
-    ifs.read(reinterpret_cast<char*>(&materialId), sizeof(materialId));
-    ifs.read(reinterpret_cast<char*>(&segmentId), sizeof(segmentId));
-    ifs.read(reinterpret_cast<char*>(&categoryId), sizeof(categoryId));
-    cpu_ibo_.emplace_back(indices);
-    materialIds_.emplace_back(materialId);
-    segmentIds_.emplace_back(segmentId);
-    categoryIds_.emplace_back(categoryId);
+  ASSERT(faceProperties[0]->listSize == 3);
+
+  const size_t nVertex = vertex->count;
+  const size_t nFace = face->count;
+  cpu_vbo_.resize(nVertex);
+  cpu_cbo_.resize(nVertex);
+  cpu_ibo_.resize(nFace);
+  for (size_t i = 0; i < 3; ++i) {
+    PlyReader::readInto(*vertex, *vertexProperties[i], 0,
+                        PlyReader::component<float>(cpu_vbo_, i));
+    PlyReader::readInto(*vertex, *vertexProperties[3 + i], 0,
+                        PlyReader::component<uint8_t>(cpu_cbo_, i));
+    PlyReader::readInto(*face, *faceProperties[0], i,
+                        PlyReader::component<uint32_t>(cpu_ibo_, i));
   }
+  materialIds_.resize(nFace);
+  segmentIds_.resize(nFace);
+  categoryIds_.resize(nFace);
+  PlyReader::readInto(*face, *faceProperties[1], 0,
+                      Corrade::Containers::stridedArrayView(materialIds_));
+  PlyReader::readInto(*face, *faceProperties[2], 0,
+                      Corrade::Containers::stridedArrayView(segmentIds_));
+  PlyReader::readInto(*face, *faceProperties[3], 0,
+                      Corrade::Containers::stridedArrayView(categoryIds_));
 
   // Construct vertices for meshData
   // Store indices, facd_ids in Magnum MeshData3D format such that
@@ -4,7 +4,10 @@
 
 #include "PTexMeshData.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
@@ -12,16 +15,25 @@
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/PluginManager/Manager.h>
 #include <Corrade/Utility/Algorithms.h>
 #include <Corrade/Utility/Assert.h>
 #include <Corrade/Utility/Debug.h>
 #include <Corrade/Utility/DebugStl.h>
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/GL/BufferTextureFormat.h>
+#include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/ImageView.h>
+#include <Magnum/Math/Packing.h>
 #include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/AbstractImageConverter.h>
+#include <sys/stat.h>
 
+#include "esp/core/AsyncLog.h"
+#include "esp/core/MappedFile.h"
+#include "esp/core/ThreadPool.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/PTexMeshShader.h"
 #include "esp/io/io.h"
@@ -29,6 +41,8 @@
 
 static constexpr int ROTATION_SHIFT = 30;
 static constexpr int FACE_MASK = 0x3FFFFFFF;
+// the number of vertices or faces a worker of the cheap loops handles at once
+static constexpr size_t LOOP_GRAIN_SIZE = 16384;
 
 namespace Mn = Magnum;
 namespace Cr = Corrade;
@@ -57,7 +71,9 @@ void PTexMeshData::load(const std::string& meshFile,
   const io::JsonDocument json = io::parseJsonFile(paramsFile);
   splitSize_ = json["splitSize"].GetDouble();
   tileSize_ = json["tileSize"].GetInt();
+  meshFile_ = meshFile;
   atlasFolder_ = atlasFolder;
+  adjacencyFile_ = meshFile + ".adjacency";
 
   loadMeshData(meshFile);
 }
@@ -156,13 +172,17 @@ std::vector<PTexMeshData::MeshData> splitMesh(
     boundingBox.extend(mesh.vbo[i].head<3>());
   }
 
-// calculate vertex grid position and code
-#pragma omp parallel for
-  for (size_t i = 0; i < mesh.vbo.size(); i++) {
-    const vec3f p = mesh.vbo[i].head<3>();
-    vec3f pi = (p - boundingBox.min()) / splitSize;
-    verts[i] = EncodeMorton3(pi.cast<int>());
-  }
+  core::ThreadPool& pool = core::ThreadPool::shared();
+
+  // calculate vertex grid position and code
+  pool.parallelForRanges(
+      mesh.vbo.size(), LOOP_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          const vec3f p = mesh.vbo[i].head<3>();
+          vec3f pi = (p - boundingBox.min()) / splitSize;
+          verts[i] = EncodeMorton3(pi.cast<int>());
+        }
+      });
 
   // data structure for sorting faces
   struct SortFace {
@@ -179,17 +199,20 @@ std::vector<PTexMeshData::MeshData> splitMesh(
   std::vector<SortFace> faces;
   faces.resize(numFaces);
 
-#pragma omp parallel for
-  for (size_t i = 0; i < numFaces; i++) {
-    faces[i].originalFace = i;
-    faces[i].code = std::numeric_limits<uint32_t>::max();
-    for (int j = 0; j < 4; j++) {
-      faces[i].index[j] = mesh.ibo[i * 4 + j];
-
-      // face code is minimum of referenced vertices codes
-      faces[i].code = std::min(faces[i].code, verts[faces[i].index[j]]);
-    }
-  }
+  pool.parallelForRanges(
+      numFaces, LOOP_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          faces[i].originalFace = i;
+          faces[i].code = std::numeric_limits<uint32_t>::max();
+          for (int j = 0; j < 4; j++) {
+            faces[i].index[j] = mesh.ibo[i * 4 + j];
+
+            // face code is minimum of referenced vertices codes
+            faces[i].code =
+                std::min(faces[i].code, verts[faces[i].index[j]]);
+          }
+        }
+      });
 
   // sort faces by code
   std::sort(faces.begin(), faces.end(),
@@ -228,8 +251,7 @@ std::vector<PTexMeshData::MeshData> splitMesh(
     subMeshes.emplace_back();
   }
 
-#pragma omp parallel for
-  for (size_t i = 0; i < numChunks; i++) {
+  pool.parallelFor(numChunks, pool.numThreads() + 1, [&](size_t i, size_t) {
     uint32_t chunkSize = chunkStart[i + 1] - chunkStart[i];
 
     std::vector<uint32_t> refdVerts;
@@ -270,246 +292,67 @@ std::vector<PTexMeshData::MeshData> splitMesh(
       // Careful:
       // for Ptex mesh we never ever set the "cbo"
     }
-  }
+  });
 
   return subMeshes;
 }
 
-// =========== the input file format =======================
-// a uint64_t, N, the number of sub-meshes;
-
-// it follows by N chunks, each of which contains:
-// a uint64_t, M, the number of faces within the chunk;
-// M uint32_t, face indices (sorted) in the *original* mesh;
-// =========================================================
-
-//  this binary can be generated by modifying the splitMesh() in file
-//  PTexLib.cpp in ReplicaSDK.
-//  and the name is hard-coded as "sorted_faces.bin" in the simulator.
-
-// Put it in the sub-folder, "habitat".
-
-std::vector<PTexMeshData::MeshData> loadSubMeshes(
-    const PTexMeshData::MeshData& mesh,
-    const std::string& filename) {
-  // sanity checks
-  CORRADE_ASSERT(!filename.empty(),
-                 "PTexMeshData::loadSubMeshes: filename cannot be empty.", {});
-  std::ifstream file;
-  file.open(filename, std::ios::in | std::ios::binary);
-  CORRADE_ASSERT(
-      file.good(),
-      "PTexMeshData::loadSubMeshes: cannot open the file " << filename, {});
-
-  uint64_t numSubMeshes = 0;
-  file.read(reinterpret_cast<char*>(&numSubMeshes), sizeof(uint64_t));
-
-  std::vector<PTexMeshData::MeshData> subMeshes(numSubMeshes);
-
-  size_t totalFaces = 0;  // used in sanity check
-  for (uint64_t iMesh = 0; iMesh < numSubMeshes; ++iMesh) {
-    uint64_t numFaces = 0;
-    file.read(reinterpret_cast<char*>(&numFaces), sizeof(uint64_t));
-
-    std::vector<uint32_t> originalFaces(numFaces);
-    // load the face indices in the *original* mesh
-    file.read(reinterpret_cast<char*>(originalFaces.data()),
-              sizeof(uint32_t) * numFaces);
-    // a *vertex* lookup table:
-    // global index of the original mesh --> local index in sub-meshes
-    // (note: this table cannot be defined outside of the for loop, as a vertex
-    // in original mesh may appear in different sub-meshes.)
-    std::unordered_map<uint32_t, uint32_t> globalToLocal;
-
-    // Another *vertex* lookup table:
-    // local index of current sub-mesh --> global index of the original mesh
-    std::vector<uint32_t> localToGlobal;
-
-    // compute the two lookup tables
-    for (size_t jFace = 0; jFace < numFaces; ++jFace) {
-      uint32_t f = originalFaces[jFace];  // face index in original mesh
-      for (size_t v = 0; v < 4; ++v) {
-        uint32_t global = mesh.ibo[f * 4 + v];
-        if (globalToLocal.find(global) == globalToLocal.end()) {
-          globalToLocal[global] = localToGlobal.size();
-          localToGlobal.push_back(global);
-        }
-      }
-    }
-
-    // compute the ibo for the current sub-mesh
-    auto& ibo = subMeshes[iMesh].ibo;
-    ibo.resize(numFaces * 4);
-    uint64_t idx = 0;
-    for (size_t jFace = 0; jFace < numFaces; ++jFace) {
-      uint32_t f = originalFaces[jFace];
-      for (size_t v = 0; v < 4; ++v) {
-        uint32_t global = mesh.ibo[f * 4 + v];
-        CORRADE_ASSERT(globalToLocal.find(global) != globalToLocal.end(),
-                       "PTexMeshData::loadSubMeshes: vertex "
-                           << global << " is not in the sub-mesh " << iMesh,
-                       {});
-        uint32_t local = globalToLocal[global];
-        ibo[idx++] = local;
-      }
-    }  // for jFace
-
-    // this is to break the quad into 2 triangles
-    // we need this triangle mesh to do object picking
-    computeTriangleMeshIndices(numFaces, subMeshes[iMesh]);
-
-    // compute the vbo, nbo for the current sub-mesh
-    uint64_t numVertices = localToGlobal.size();
-    subMeshes[iMesh].vbo.resize(numVertices);
-    subMeshes[iMesh].nbo.resize(numVertices);
-    for (size_t jLocal = 0; jLocal < numVertices; ++jLocal) {
-      uint32_t global = localToGlobal[jLocal];
-      subMeshes[iMesh].vbo[jLocal] = mesh.vbo[global];
-      subMeshes[iMesh].nbo[jLocal] = mesh.nbo[global];
-    }
-
-    // Careful:
-    // for Ptex mesh we never ever set the "cbo"
-
-    totalFaces += numFaces;
-  }  // for iMesh
-  file.close();
-  CORRADE_ASSERT(totalFaces == mesh.ibo.size() / 4,
-                 "PTexMeshData::loadSubMeshes: the number of faces loaded from "
-                 "the file does not "
-                 "match it from the ptex mesh.",
-                 {});
+namespace {
 
-  LOG(INFO) << "The number of quads: " << totalFaces << ", which equals to "
-            << totalFaces * 2 << " triangles.";
-
-  return subMeshes;
-}
-
-void PTexMeshData::calculateAdjacency(const PTexMeshData::MeshData& mesh,
-                                      std::vector<uint32_t>& adjFaces) {
-  struct EdgeData {
-    int face;
-    int edge;
-  };
-
-  std::unordered_map<uint64_t, std::vector<EdgeData>> edgeMap;
-
-  size_t numFaces = mesh.ibo.size() / 4;
-
-  typedef std::unordered_map<uint64_t, std::vector<EdgeData>>::iterator
-      EdgeIter;
-  std::vector<EdgeIter> edgeIterators(numFaces * 4);
-
-  // for each face
-  for (int f = 0; f < numFaces; f++) {
-    // for each edge
-    for (int e = 0; e < 4; e++) {
-      // add to edge to face map
-      const int e_index = f * 4 + e;
-      const uint32_t i0 = mesh.ibo[e_index];
-      const uint32_t i1 = mesh.ibo[f * 4 + ((e + 1) % 4)];
-      const uint64_t key =
-          static_cast<uint64_t>(std::min(i0, i1)) << 32 | std::max(i0, i1);
-
-      const EdgeData edgeData{f, e};
-
-      auto it = edgeMap.find(key);
-
-      if (it == edgeMap.end()) {
-        it = edgeMap.emplace(key, std::vector<EdgeData>()).first;
-        it->second.reserve(4);
-        it->second.push_back(edgeData);
-      } else {
-        it->second.push_back(edgeData);
-      }
-
-      edgeIterators[e_index] = it;
-    }
+// Binary payload of a PTex PLY file, referencing the mapped file
+struct PlyLayout {
+  size_t numVertices = 0;
+  size_t numFaces = 0;
+  size_t normalDimensions = 0;
+  size_t colorDimensions = 0;
+  size_t vertexPacketSizeBytes = 0;
+  size_t positionOffsetBytes = 0;
+  size_t normalOffsetBytes = 0;
+  size_t colorOffsetBytes = 0;
+  size_t faceDimensions = 0;
+  size_t facePacketSizeBytes = 0;
+  // first vertex and face packets
+  const char* vertices = nullptr;
+  const char* faces = nullptr;
+
+  vec3f position(size_t i) const {
+    vec3f position;
+    std::memcpy(position.data(),
+                vertices + vertexPacketSizeBytes * i + positionOffsetBytes,
+                3 * sizeof(float));
+    return position;
   }
 
-  adjFaces.resize(numFaces * 4);
-
-  for (int f = 0; f < numFaces; f++) {
-    for (int e = 0; e < 4; e++) {
-      const int e_index = f * 4 + e;
-      auto it = edgeIterators[e_index];
-      const std::vector<EdgeData>& adj = it->second;
-
-      // find adjacent face
-      int adjFace = -1;
-      for (size_t i = 0; i < adj.size(); i++) {
-        if (adj[i].face != f)
-          adjFace = adj[i].face;
-      }
-
-      // find number of 90 degree rotation steps between faces
-      int rot = 0;
-      if (adj.size() == 2) {
-        int edge0 = 0, edge1 = 0;
-        if (adj[0].edge == e) {
-          edge0 = adj[0].edge;
-          edge1 = adj[1].edge;
-        } else if (adj[1].edge == e) {
-          edge0 = adj[1].edge;
-          edge1 = adj[0].edge;
-        }
-
-        rot = (edge0 - edge1 + 2) & 3;
-      }
-
-      // pack adjacent face and rotation into 32-bit int
-      adjFaces[f * 4 + e] = (rot << ROTATION_SHIFT) | (adjFace & FACE_MASK);
-    }
+  vec4f normal(size_t i) const {
+    vec4f normal(0, 0, 0, 1);
+    std::memcpy(normal.data(),
+                vertices + vertexPacketSizeBytes * i + normalOffsetBytes,
+                normalDimensions * sizeof(float));
+    return normal;
   }
-}
-
-void PTexMeshData::loadMeshData(const std::string& meshFile) {
-  PTexMeshData::MeshData originalMesh;
-  parsePLY(meshFile, originalMesh);
-
-  computeTriangleMeshIndices(originalMesh.ibo.size() / 4, originalMesh);
-  collisionMeshData_.primitive = Mn::MeshPrimitive::Triangles;
-
-  submeshes_.clear();
-  if (splitSize_ > 0.0f) {
-    LOG(INFO) << "Splitting mesh... ";
-
-    collisionVbo_ = Cr::Containers::Array<Mn::Vector3>(originalMesh.vbo.size());
-    Cr::Utility::copy(Cr::Containers::arrayCast<Mn::Vector3>(
-                          Cr::Containers::arrayView(originalMesh.vbo)),
-                      collisionVbo_);
-    collisionIbo_ =
-        Cr::Containers::Array<Mn::UnsignedInt>(originalMesh.ibo_tri.size());
-    Cr::Utility::copy(originalMesh.ibo_tri, collisionIbo_);
-
-    collisionMeshData_.positions = collisionVbo_;
-    collisionMeshData_.indices = collisionIbo_;
 
-    // In this version, we load the sorted faces directly from an external
-    // binary file dumped out from ReplicaSDK, and disable the function
-    // splitMesh(...)
+  vec4uc color(size_t i) const {
+    vec4uc color(0, 0, 0, 255);
+    std::memcpy(color.data(),
+                vertices + vertexPacketSizeBytes * i + colorOffsetBytes,
+                colorDimensions);
+    return color;
+  }
 
-    // See detailed comments in front of the splitMesh(...)
-    std::string subMeshesFilename = Corrade::Utility::Directory::join(
-        atlasFolder_, "../habitat/sorted_faces.bin");
-    submeshes_ = loadSubMeshes(originalMesh, subMeshesFilename);
+  // the packets are not aligned, the count byte comes first
+  const char* faceIndices(size_t face) const {
+    return faces + facePacketSizeBytes * face + 1;
+  }
 
-    // TODO:
-    // re-activate the following function after the bug is fixed in ReplicaSDK.
-    // submeshes_ = splitMesh(originalMesh, splitSize_);
-    // LOG(INFO) << "done" << std::endl;
-  } else {
-    submeshes_.emplace_back(std::move(originalMesh));
-    collisionMeshData_.positions = Cr::Containers::arrayCast<Mn::Vector3>(
-        Cr::Containers::arrayView(submeshes_.back().vbo));
-    collisionMeshData_.indices = Cr::Containers::arrayCast<Mn::UnsignedInt>(
-        Cr::Containers::arrayView(submeshes_.back().ibo_tri));
+  uint32_t index(size_t face, size_t vertex) const {
+    uint32_t index;
+    std::memcpy(&index, faceIndices(face) + vertex * sizeof(uint32_t),
+                sizeof(uint32_t));
+    return index;
   }
-}
+};
 
-void PTexMeshData::parsePLY(const std::string& filename,
-                            PTexMeshData::MeshData& meshData) {
+PlyLayout parsePlyHeader(Cr::Containers::ArrayView<const char> file) {
   std::vector<std::string> comments;
   std::vector<std::string> objInfo;
 
@@ -518,23 +361,33 @@ void PTexMeshData::parsePLY(const std::string& filename,
 
   enum Properties { POSITION = 0, NORMAL, COLOR, NUM_PROPERTIES };
 
-  size_t numVertices = 0;
+  PlyLayout layout;
+  size_t& numVertices = layout.numVertices;
 
   size_t positionDimensions = 0;
-  size_t normalDimensions = 0;
-  size_t colorDimensions = 0;
+  size_t& normalDimensions = layout.normalDimensions;
+  size_t& colorDimensions = layout.colorDimensions;
 
   std::vector<Properties> vertexLayout;
 
-  size_t numFaces = 0;
+  size_t& numFaces = layout.numFaces;
 
-  std::ifstream file(filename, std::ios::binary);
+  // the header is text, up to and including the end_header line
+  const char endHeader[] = "end_header";
+  const char* headerEnd = std::search(file.begin(), file.end(), endHeader,
+                                      endHeader + sizeof(endHeader) - 1);
+  headerEnd = std::find(headerEnd, file.end(), '\n');
+  CORRADE_ASSERT(headerEnd != file.end(),
+                 "PTexMeshData::parsePLY: the file has no complete header",
+                 {});
+  const size_t postHeader = headerEnd + 1 - file.begin();
+  std::istringstream headerStream{std::string{file.begin(), headerEnd + 1}};
 
   // Header parsing
   {
     std::string line;
 
-    while (std::getline(file, line)) {
+    while (std::getline(headerStream, line)) {
       std::istringstream ls(line);
       std::string token;
       ls >> token;
@@ -551,7 +404,7 @@ void PTexMeshData::parsePLY(const std::string& filename,
         ls >> s;
         CORRADE_ASSERT(s == "binary_little_endian",
                        "PTexMeshData::parsePLY: the file is not a binary file "
-                       "in little endian byte order", );
+                       "in little endian byte order", {});
       } else if (token == "element") {
         std::string name;
         size_t size;
@@ -565,10 +418,12 @@ void PTexMeshData::parsePLY(const std::string& filename,
           numFaces = size;
           CORRADE_ASSERT(numFaces > 0,
                          "PTexMeshData::parsePLY: number of faces is not "
-                         "greater than 0.", );
+                         "greater than 0.", {});
         } else {
-          CORRADE_ASSERT(
-              false, "PTexMeshData::parsePLY: Cannot parse element" << name, );
+          CORRADE_ASSERT(false,
+                         "PTexMeshData::parsePLY: Cannot parse element"
+                             << name,
+                         {});
         }
 
         // Keep track of what element we parsed last to associate the
@@ -589,22 +444,23 @@ void PTexMeshData::parsePLY(const std::string& filename,
 
           CORRADE_ASSERT(countType == "uchar" || countType == "uint8",
                          "PTexMeshData::parsePLY: Don't understand count type"
-                             << countType, );
+                             << countType, {});
 
-          CORRADE_ASSERT(
-              type == "int",
-              "PTexMeshData::parsePLY: Don't understand index type" << type, );
+          CORRADE_ASSERT(type == "int",
+                         "PTexMeshData::parsePLY: Don't understand index type"
+                             << type,
+                         {});
 
           CORRADE_ASSERT(lastElement == "face",
                          "PTexMeshData::parsePLY: Only expecting list after "
                          "face element, not after"
-                             << lastElement, );
+                             << lastElement, {});
         }
 
         CORRADE_ASSERT(
             type == "float" || type == "int" || type == "uchar" ||
                 type == "uint8",
-            "PTexMeshData::parsePLY: Don't understand type" << type, );
+            "PTexMeshData::parsePLY: Don't understand type" << type, {});
 
         ls >> name;
 
@@ -612,7 +468,7 @@ void PTexMeshData::parsePLY(const std::string& filename,
         if (lastElement == "vertex") {
           CORRADE_ASSERT(type != "int",
                          "PTexMeshData::parsePLY: Don't support 32-bit integer "
-                         "properties", );
+                         "properties", {});
 
           // Position information
           if (name == "x") {
@@ -620,21 +476,21 @@ void PTexMeshData::parsePLY(const std::string& filename,
             vertexLayout.push_back(Properties::POSITION);
             CORRADE_ASSERT(type == "float",
                            "PTexMeshData::parsePLY: Don't support 8-bit "
-                           "integer positions", );
+                           "integer positions", {});
           } else if (name == "y") {
             CORRADE_ASSERT(lastProperty == "x",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "x, y, z, (w) order", );
+                           "x, y, z, (w) order", {});
             positionDimensions = 2;
           } else if (name == "z") {
             CORRADE_ASSERT(lastProperty == "y",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "x, y, z, (w) order", );
+                           "x, y, z, (w) order", {});
             positionDimensions = 3;
           } else if (name == "w") {
             CORRADE_ASSERT(lastProperty == "z",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "x, y, z, (w) order", );
+                           "x, y, z, (w) order", {});
             positionDimensions = 4;
           }
 
@@ -644,16 +500,16 @@ void PTexMeshData::parsePLY(const std::string& filename,
             vertexLayout.push_back(Properties::NORMAL);
             CORRADE_ASSERT(type == "float",
                            "PTexMeshData::parsePLY: Don't support 8-bit "
-                           "integer normals", );
+                           "integer normals", {});
           } else if (name == "ny") {
             CORRADE_ASSERT(lastProperty == "nx",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "nx, ny, nz order", );
+                           "nx, ny, nz order", {});
             normalDimensions = 2;
           } else if (name == "nz") {
             CORRADE_ASSERT(lastProperty == "ny",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "nx, ny, nz order", );
+                           "nx, ny, nz order", {});
             normalDimensions = 3;
           }
 
@@ -663,27 +519,27 @@ void PTexMeshData::parsePLY(const std::string& filename,
             vertexLayout.push_back(Properties::COLOR);
             CORRADE_ASSERT(type == "uchar" || type == "uint8",
                            "PTexMeshData::parsePLY: Don't support non-8-bit "
-                           "integer colors", );
+                           "integer colors", {});
           } else if (name == "green") {
             CORRADE_ASSERT(lastProperty == "red",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "red, green, blue, (alpha) order", );
+                           "red, green, blue, (alpha) order", {});
             colorDimensions = 2;
           } else if (name == "blue") {
             CORRADE_ASSERT(lastProperty == "green",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "red, green, blue, (alpha) order", );
+                           "red, green, blue, (alpha) order", {});
             colorDimensions = 3;
           } else if (name == "alpha") {
             CORRADE_ASSERT(lastProperty == "blue",
                            "PTexMeshData::parsePLY: Properties should follow "
-                           "red, green, blue, (alpha) order", );
+                           "red, green, blue, (alpha) order", {});
             colorDimensions = 4;
           }
         } else if (lastElement == "face") {
           CORRADE_ASSERT(isList,
                          "PTexMeshData::parsePLY: No idea what to do with "
-                         "properties following faces", );
+                         "properties following faces", {});
         } else {
           // No idea what to do with properties before elements
           CORRADE_INTERNAL_ASSERT_UNREACHABLE();
@@ -705,23 +561,14 @@ void PTexMeshData::parsePLY(const std::string& filename,
     // Check things make sense.
     CORRADE_ASSERT(
         numVertices > 0,
-        "PTexMeshData::parsePLY: number of vertices is not greater than 0", );
+        "PTexMeshData::parsePLY: number of vertices is not greater than 0", {});
     CORRADE_ASSERT(positionDimensions > 0,
                    "PTexMeshData::parsePLY: the dimensions of the position is "
-                   "not greater than 0", );
-    CORRADE_ASSERT(
-        positionDimensions == 3,
-        "PTexMeshData::parsePLY: the dimensions of the position must be 3.", );
-  }
-
-  meshData.vbo.resize(numVertices, vec3f(0, 0, 0));
-
-  if (normalDimensions) {
-    meshData.nbo.resize(numVertices, vec4f(0, 0, 0, 1));
-  }
-
-  if (colorDimensions) {
-    meshData.cbo.resize(numVertices, vec4uc(0, 0, 0, 255));
+                   "not greater than 0", {});
+    CORRADE_ASSERT(positionDimensions == 3,
+                   "PTexMeshData::parsePLY: the dimensions of the position "
+                   "must be 3.",
+                   {});
   }
 
   // Can only be FLOAT32 or UINT8
@@ -729,11 +576,12 @@ void PTexMeshData::parsePLY(const std::string& filename,
   const size_t normalBytes = normalDimensions * sizeof(float);      // floats
   const size_t colorBytes = colorDimensions * sizeof(uint8_t);      // bytes
 
-  const size_t vertexPacketSizeBytes = positionBytes + normalBytes + colorBytes;
+  const size_t vertexPacketSizeBytes = layout.vertexPacketSizeBytes =
+      positionBytes + normalBytes + colorBytes;
 
-  size_t positionOffsetBytes = 0;
-  size_t normalOffsetBytes = 0;
-  size_t colorOffsetBytes = 0;
+  size_t& positionOffsetBytes = layout.positionOffsetBytes;
+  size_t& normalOffsetBytes = layout.normalOffsetBytes;
+  size_t& colorOffsetBytes = layout.colorOffsetBytes;
 
   size_t offsetSoFarBytes = 0;
 
@@ -752,49 +600,28 @@ void PTexMeshData::parsePLY(const std::string& filename,
     }
   }
 
-  // Close after parsing header and re-open memory mapped
-  const size_t postHeader = file.tellg();
-
-  file.close();
-
-  Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
-      mmappedData = Cr::Utility::Directory::mapRead(filename);
-
-  const size_t fileSize = io::fileSize(filename);
-
-  // Parse each vertex packet and unpack
-  const char* bytes = mmappedData + postHeader;
-
-  for (size_t i = 0; i < numVertices; i++) {
-    const char* nextBytes = bytes + vertexPacketSizeBytes * i;
-
-    memcpy(meshData.vbo[i].data(), &nextBytes[positionOffsetBytes],
-           positionBytes);
-
-    if (normalDimensions)
-      memcpy(meshData.nbo[i].data(), &nextBytes[normalOffsetBytes],
-             normalBytes);
-
-    if (colorDimensions)
-      memcpy(meshData.cbo[i].data(), &nextBytes[colorOffsetBytes], colorBytes);
-  }
-
+  layout.vertices = file.data() + postHeader;
   const size_t bytesSoFar = postHeader + vertexPacketSizeBytes * numVertices;
-
-  bytes = mmappedData + postHeader + vertexPacketSizeBytes * numVertices;
+  CORRADE_ASSERT(bytesSoFar < file.size(),
+                 "PTexMeshData::parsePLY: the file has no faces", {});
+  layout.faces = file.data() + bytesSoFar;
 
   // Read first face to get number of indices;
-  const uint8_t faceDimensions = *bytes;
+  const uint8_t faceDimensions = layout.faces[0];
 
   CORRADE_ASSERT(faceDimensions == 3 || faceDimensions == 4,
                  "PTexMeshData::parsePLY: the dimension of a face is neither "
-                 "3 nor 4.", );
+                 "3 nor 4.",
+                 {});
 
   const size_t countBytes = 1;
   const size_t faceBytes = faceDimensions * sizeof(uint32_t);  // uint32_t
   const size_t facePacketSizeBytes = countBytes + faceBytes;
+  layout.faceDimensions = faceDimensions;
+  layout.facePacketSizeBytes = facePacketSizeBytes;
 
-  const size_t predictedFaces = (fileSize - bytesSoFar) / facePacketSizeBytes;
+  const size_t predictedFaces =
+      (file.size() - bytesSoFar) / facePacketSizeBytes;
 
   // Not sure what to do here
   //    if(predictedFaces < numFaces)
@@ -809,17 +636,437 @@ void PTexMeshData::parsePLY(const std::string& filename,
   //    }
 
   numFaces = std::min(numFaces, predictedFaces);
+  return layout;
+}
+
+}  // namespace
+
+// =========== the input file format =======================
+// a uint64_t, N, the number of sub-meshes;
+
+// it follows by N chunks, each of which contains:
+// a uint64_t, M, the number of faces within the chunk;
+// M uint32_t, face indices (sorted) in the *original* mesh;
+// =========================================================
+
+//  this binary can be generated by modifying the splitMesh() in file
+//  PTexLib.cpp in ReplicaSDK.
+//  and the name is hard-coded as "sorted_faces.bin" in the simulator.
+
+// Put it in the sub-folder, "habitat".
+
+std::vector<PTexMeshData::MeshData> loadSubMeshes(
+    const PlyLayout& mesh,
+    const std::string& filename) {
+  // sanity checks
+  CORRADE_ASSERT(!filename.empty(),
+                 "PTexMeshData::loadSubMeshes: filename cannot be empty.", {});
+  CORRADE_ASSERT(Cr::Utility::Directory::exists(filename),
+                 "PTexMeshData::loadSubMeshes: cannot open the file "
+                     << filename,
+                 {});
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      file = Cr::Utility::Directory::mapRead(filename);
+  CORRADE_ASSERT(file.size() >= sizeof(uint64_t),
+                 "PTexMeshData::loadSubMeshes: the file " << filename
+                                                          << " is truncated",
+                 {});
+
+  uint64_t numSubMeshes = 0;
+  std::memcpy(&numSubMeshes, file.data(), sizeof(uint64_t));
+
+  // locate the chunks first, so the sub-meshes can be built in parallel
+  std::vector<const char*> chunkFaces(numSubMeshes);
+  std::vector<uint64_t> chunkSizes(numSubMeshes);
+  size_t offset = sizeof(uint64_t);
+  size_t totalFaces = 0;  // used in sanity check
+  for (uint64_t iMesh = 0; iMesh < numSubMeshes; ++iMesh) {
+    CORRADE_ASSERT(offset + sizeof(uint64_t) <= file.size(),
+                   "PTexMeshData::loadSubMeshes: the file "
+                       << filename << " is truncated",
+                   {});
+    uint64_t numFaces = 0;
+    std::memcpy(&numFaces, file.data() + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    CORRADE_ASSERT(numFaces <= (file.size() - offset) / sizeof(uint32_t),
+                   "PTexMeshData::loadSubMeshes: the file "
+                       << filename << " is truncated",
+                   {});
+    chunkFaces[iMesh] = file.data() + offset;
+    chunkSizes[iMesh] = numFaces;
+    offset += sizeof(uint32_t) * numFaces;
+    totalFaces += numFaces;
+  }
+  CORRADE_ASSERT(totalFaces == mesh.numFaces,
+                 "PTexMeshData::loadSubMeshes: the number of faces loaded from "
+                 "the file does not "
+                 "match it from the ptex mesh.",
+                 {});
+
+  std::vector<PTexMeshData::MeshData> subMeshes(numSubMeshes);
+  std::vector<char> invalidFaces(numSubMeshes, 0);
+  // no early return is allowed in the parallel loop, invalid face indices are
+  // collected and reported after it
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelFor(
+      numSubMeshes, pool.numThreads() + 1, [&](size_t iMesh, size_t) {
+        const uint64_t numFaces = chunkSizes[iMesh];
+        auto& subMesh = subMeshes[iMesh];
+
+        // a *vertex* lookup table:
+        // global index of the original mesh --> local index in sub-meshes
+        // (note: this table cannot be shared between sub-meshes, as a vertex
+        // in original mesh may appear in different sub-meshes.)
+        std::unordered_map<uint32_t, uint32_t> globalToLocal;
+        globalToLocal.reserve(numFaces * 4);
+
+        // Another *vertex* lookup table:
+        // local index of current sub-mesh --> global index of the original mesh
+        std::vector<uint32_t> localToGlobal;
+
+        // compute the two lookup tables and the ibo for the current sub-mesh,
+        // with the face indices in the *original* mesh read from the file
+        subMesh.ibo.reserve(numFaces * 4);
+        for (size_t jFace = 0; jFace < numFaces; ++jFace) {
+          uint32_t f = 0;  // face index in original mesh
+          std::memcpy(&f, chunkFaces[iMesh] + jFace * sizeof(uint32_t),
+                      sizeof(uint32_t));
+          if (f >= mesh.numFaces) {
+            invalidFaces[iMesh] = 1;
+            continue;
+          }
+          for (size_t v = 0; v < 4; ++v) {
+            uint32_t global = mesh.index(f, v);
+            auto inserted = globalToLocal.emplace(global, localToGlobal.size());
+            if (inserted.second) {
+              localToGlobal.push_back(global);
+            }
+            subMesh.ibo.push_back(inserted.first->second);
+          }
+        }  // for jFace
+
+        // this is to break the quad into 2 triangles
+        // we need this triangle mesh to do object picking
+        subMesh.ibo_tri.reserve(subMesh.ibo.size() / 4 * 6);
+        computeTriangleMeshIndices(subMesh.ibo.size() / 4, subMesh);
+
+        // compute the vbo, nbo for the current sub-mesh
+        uint64_t numVertices = localToGlobal.size();
+        subMesh.vbo.resize(numVertices);
+        subMesh.nbo.resize(numVertices);
+        for (size_t jLocal = 0; jLocal < numVertices; ++jLocal) {
+          uint32_t global = localToGlobal[jLocal];
+          subMesh.vbo[jLocal] = mesh.position(global);
+          subMesh.nbo[jLocal] = mesh.normal(global);
+        }
+
+        // Careful:
+        // for Ptex mesh we never ever set the "cbo"
+      });  // for iMesh
+
+  for (uint64_t iMesh = 0; iMesh < numSubMeshes; ++iMesh) {
+    CORRADE_ASSERT(!invalidFaces[iMesh],
+                   "PTexMeshData::loadSubMeshes: the sub-mesh "
+                       << iMesh << " references a face out of range",
+                   {});
+  }
+
+  LOG(INFO) << "The number of quads: " << totalFaces << ", which equals to "
+            << totalFaces * 2 << " triangles.";
+
+  return subMeshes;
+}
+
+void PTexMeshData::calculateAdjacency(const PTexMeshData::MeshData& mesh,
+                                      std::vector<uint32_t>& adjFaces) {
+  struct EdgeData {
+    int face;
+    int edge;
+  };
+
+  std::unordered_map<uint64_t, std::vector<EdgeData>> edgeMap;
+
+  size_t numFaces = mesh.ibo.size() / 4;
+
+  typedef std::unordered_map<uint64_t, std::vector<EdgeData>>::iterator
+      EdgeIter;
+  std::vector<EdgeIter> edgeIterators(numFaces * 4);
+
+  // for each face
+  for (int f = 0; f < numFaces; f++) {
+    // for each edge
+    for (int e = 0; e < 4; e++) {
+      // add to edge to face map
+      const int e_index = f * 4 + e;
+      const uint32_t i0 = mesh.ibo[e_index];
+      const uint32_t i1 = mesh.ibo[f * 4 + ((e + 1) % 4)];
+      const uint64_t key =
+          static_cast<uint64_t>(std::min(i0, i1)) << 32 | std::max(i0, i1);
+
+      const EdgeData edgeData{f, e};
+
+      auto it = edgeMap.find(key);
+
+      if (it == edgeMap.end()) {
+        it = edgeMap.emplace(key, std::vector<EdgeData>()).first;
+        it->second.reserve(4);
+        it->second.push_back(edgeData);
+      } else {
+        it->second.push_back(edgeData);
+      }
+
+      edgeIterators[e_index] = it;
+    }
+  }
+
+  adjFaces.resize(numFaces * 4);
+
+  for (int f = 0; f < numFaces; f++) {
+    for (int e = 0; e < 4; e++) {
+      const int e_index = f * 4 + e;
+      auto it = edgeIterators[e_index];
+      const std::vector<EdgeData>& adj = it->second;
+
+      // find adjacent face
+      int adjFace = -1;
+      for (size_t i = 0; i < adj.size(); i++) {
+        if (adj[i].face != f)
+          adjFace = adj[i].face;
+      }
+
+      // find number of 90 degree rotation steps between faces
+      int rot = 0;
+      if (adj.size() == 2) {
+        int edge0 = 0, edge1 = 0;
+        if (adj[0].edge == e) {
+          edge0 = adj[0].edge;
+          edge1 = adj[1].edge;
+        } else if (adj[1].edge == e) {
+          edge0 = adj[1].edge;
+          edge1 = adj[0].edge;
+        }
+
+        rot = (edge0 - edge1 + 2) & 3;
+      }
+
+      // pack adjacent face and rotation into 32-bit int
+      adjFaces[f * 4 + e] = (rot << ROTATION_SHIFT) | (adjFace & FACE_MASK);
+    }
+  }
+}
+
+void PTexMeshData::loadMeshData(const std::string& meshFile) {
+  collisionMeshData_.primitive = Mn::MeshPrimitive::Triangles;
+
+  submeshes_.clear();
+  if (splitSize_ > 0.0f) {
+    LOG(INFO) << "Splitting mesh... ";
+
+    // The original mesh is only needed for the collision mesh and to gather
+    // the sub-meshes, both are filled straight from the mapped file instead
+    // of unpacking it first
+    const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+        file = Cr::Utility::Directory::mapRead(meshFile);
+    const PlyLayout originalMesh = parsePlyHeader(file);
+    CORRADE_ASSERT(originalMesh.faceDimensions == 4,
+                   "PTexMeshData::loadMeshData: the faces of"
+                       << meshFile << "are not quads", );
+
+    collisionVbo_ = Cr::Containers::Array<Mn::Vector3>{
+        Cr::Containers::NoInit, originalMesh.numVertices};
+    core::ThreadPool& pool = core::ThreadPool::shared();
+    pool.parallelForRanges(
+        originalMesh.numVertices, LOOP_GRAIN_SIZE,
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            const vec3f position = originalMesh.position(i);
+            collisionVbo_[i] =
+                Mn::Vector3{position[0], position[1], position[2]};
+          }
+        });
+    collisionIbo_ = Cr::Containers::Array<Mn::UnsignedInt>{
+        Cr::Containers::NoInit, originalMesh.numFaces * 6};
+    pool.parallelForRanges(
+        originalMesh.numFaces, LOOP_GRAIN_SIZE, [&](size_t begin, size_t end) {
+          for (size_t f = begin; f < end; ++f) {
+            uint32_t quad[4];
+            std::memcpy(quad, originalMesh.faceIndices(f), sizeof(quad));
+            // the triangles (0, 1, 2), (0, 2, 3), as
+            // computeTriangleMeshIndices()
+            Mn::UnsignedInt* triangles = collisionIbo_.data() + f * 6;
+            triangles[0] = quad[0];
+            triangles[1] = quad[1];
+            triangles[2] = quad[2];
+            triangles[3] = quad[0];
+            triangles[4] = quad[2];
+            triangles[5] = quad[3];
+          }
+        });
+
+    collisionMeshData_.positions = collisionVbo_;
+    collisionMeshData_.indices = collisionIbo_;
+
+    // In this version, we load the sorted faces directly from an external
+    // binary file dumped out from ReplicaSDK, and disable the function
+    // splitMesh(...)
+
+    // See detailed comments in front of the splitMesh(...)
+    std::string subMeshesFilename = Corrade::Utility::Directory::join(
+        atlasFolder_, "../habitat/sorted_faces.bin");
+    submeshes_ = loadSubMeshes(originalMesh, subMeshesFilename);
+
+    // TODO:
+    // re-activate the following function after the bug is fixed in ReplicaSDK.
+    // submeshes_ = splitMesh(originalMesh, splitSize_);
+    // LOG(INFO) << "done" << std::endl;
+  } else {
+    PTexMeshData::MeshData originalMesh;
+    parsePLY(meshFile, originalMesh);
+    computeTriangleMeshIndices(originalMesh.ibo.size() / 4, originalMesh);
 
-  meshData.ibo.resize(numFaces * faceDimensions);
+    submeshes_.emplace_back(std::move(originalMesh));
+    collisionMeshData_.positions = Cr::Containers::arrayCast<Mn::Vector3>(
+        Cr::Containers::arrayView(submeshes_.back().vbo));
+    collisionMeshData_.indices = Cr::Containers::arrayCast<Mn::UnsignedInt>(
+        Cr::Containers::arrayView(submeshes_.back().ibo_tri));
+  }
+}
+
+void PTexMeshData::parsePLY(const std::string& filename,
+                            PTexMeshData::MeshData& meshData) {
+  const Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+      file = Cr::Utility::Directory::mapRead(filename);
+  const PlyLayout ply = parsePlyHeader(file);
+
+  // Parse each vertex packet and unpack
+  meshData.vbo.resize(ply.numVertices);
+  if (ply.normalDimensions) {
+    meshData.nbo.resize(ply.numVertices);
+  }
+  if (ply.colorDimensions) {
+    meshData.cbo.resize(ply.numVertices);
+  }
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelForRanges(
+      ply.numVertices, LOOP_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          meshData.vbo[i] = ply.position(i);
+          if (ply.normalDimensions)
+            meshData.nbo[i] = ply.normal(i);
+          if (ply.colorDimensions)
+            meshData.cbo[i] = ply.color(i);
+        }
+      });
+
+  meshData.ibo.resize(ply.numFaces * ply.faceDimensions);
+  pool.parallelForRanges(
+      ply.numFaces, LOOP_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          std::memcpy(&meshData.ibo[i * ply.faceDimensions], ply.faceIndices(i),
+                      ply.faceDimensions * sizeof(uint32_t));
+        }
+      });
+}
 
-  for (size_t i = 0; i < numFaces; i++) {
-    const char* nextBytes = bytes + facePacketSizeBytes * i;
+namespace {
+
+constexpr char AdjacencyMagic[8] = {'e', 's', 'p', 'a', 'd', 'j', '\0', '\0'};
+constexpr uint32_t AdjacencyVersion = 1;
+
+struct AdjacencyHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t submeshCount;
+};
+
+// followed by submeshCount of these, then the adjacency of all submeshes
+struct AdjacencyEntry {
+  // hash of the submesh ibo the adjacency was computed from
+  uint64_t iboHash;
+  uint64_t offset;
+  uint64_t count;
+};
+
+// adjacency of each submesh in the mapped sidecar file, empty if it's stale
+std::vector<Cr::Containers::ArrayView<const uint32_t>> readAdjacencySidecar(
+    Cr::Containers::ArrayView<const char> file,
+    const std::vector<uint64_t>& iboHashes) {
+  std::vector<Cr::Containers::ArrayView<const uint32_t>> adjFaces(
+      iboHashes.size());
+  AdjacencyHeader header;
+  if (file.size() < sizeof(header)) {
+    return adjFaces;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, AdjacencyMagic, sizeof(AdjacencyMagic)) != 0 ||
+      header.version != AdjacencyVersion ||
+      header.submeshCount != iboHashes.size() ||
+      file.size() <
+          sizeof(header) + header.submeshCount * sizeof(AdjacencyEntry)) {
+    return adjFaces;
+  }
+  for (size_t iMesh = 0; iMesh < iboHashes.size(); ++iMesh) {
+    AdjacencyEntry entry;
+    std::memcpy(&entry,
+                file.data() + sizeof(header) + iMesh * sizeof(entry),
+                sizeof(entry));
+    if (entry.iboHash != iboHashes[iMesh] ||
+        entry.offset % sizeof(uint32_t) || entry.offset > file.size() ||
+        entry.count > (file.size() - entry.offset) / sizeof(uint32_t)) {
+      continue;
+    }
+    adjFaces[iMesh] = {
+        reinterpret_cast<const uint32_t*>(file.data() + entry.offset),
+        std::size_t(entry.count)};
+  }
+  return adjFaces;
+}
 
-    memcpy(&meshData.ibo[i * faceDimensions], &nextBytes[countBytes],
-           faceBytes);
+bool writeAdjacencySidecar(
+    const std::string& filename,
+    const std::vector<uint64_t>& iboHashes,
+    const std::vector<Cr::Containers::ArrayView<const uint32_t>>& adjFaces) {
+  std::size_t size =
+      sizeof(AdjacencyHeader) + adjFaces.size() * sizeof(AdjacencyEntry);
+  std::vector<AdjacencyEntry> entries(adjFaces.size());
+  for (size_t iMesh = 0; iMesh < adjFaces.size(); ++iMesh) {
+    entries[iMesh] = {iboHashes[iMesh], size, adjFaces[iMesh].size()};
+    size += adjFaces[iMesh].size() * sizeof(uint32_t);
   }
+
+  Cr::Containers::Array<char> data{Cr::Containers::NoInit, size};
+  AdjacencyHeader header;
+  std::memcpy(header.magic, AdjacencyMagic, sizeof(AdjacencyMagic));
+  header.version = AdjacencyVersion;
+  header.submeshCount = adjFaces.size();
+  std::memcpy(data, &header, sizeof(header));
+  for (size_t iMesh = 0; iMesh < adjFaces.size(); ++iMesh) {
+    std::memcpy(data + sizeof(header) + iMesh * sizeof(AdjacencyEntry),
+                &entries[iMesh], sizeof(AdjacencyEntry));
+    if (!adjFaces[iMesh].empty()) {
+      std::memcpy(data + entries[iMesh].offset, adjFaces[iMesh].data(),
+                  adjFaces[iMesh].size() * sizeof(uint32_t));
+    }
+  }
+  return core::writeFileAtomically(filename, data);
+}
+
+std::string atlasFilename(const std::string& atlasFolder,
+                          size_t iMesh,
+                          const std::string& extension) {
+  return Cr::Utility::Directory::join(
+      atlasFolder, std::to_string(iMesh) + "-color-ptex" + extension);
 }
 
+// side of a square atlas of numBytes bytes with texelSize bytes per texel, 0
+// if it is not square
+int squareAtlasSize(std::size_t numBytes, std::size_t texelSize) {
+  const int dim = static_cast<int>(std::sqrt(numBytes / texelSize));
+  return std::size_t(dim) * dim * texelSize == numBytes ? dim : 0;
+}
+
+}  // namespace
+
 void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
   if (forceReload) {
     buffersOnGPU_ = false;
@@ -829,8 +1076,8 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
   }
 
   for (int iMesh = 0; iMesh < submeshes_.size(); ++iMesh) {
-    LOG(INFO) << "Loading mesh " << iMesh + 1 << "/" << submeshes_.size()
-              << "... ";
+    ESP_HOT_LOG(INFO) << "Loading mesh " << iMesh + 1 << "/"
+                      << submeshes_.size() << "... ";
 
     renderingBuffers_.emplace_back(
         std::make_unique<PTexMeshData::RenderingBuffer>());
@@ -855,13 +1102,39 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
         submeshes_[iMesh].ibo_tri, Magnum::GL::BufferUsage::StaticDraw);
   }
 #ifndef CORRADE_TARGET_APPLE
-  LOG(INFO) << "Calculating mesh adjacency... ";
-
-  std::vector<std::vector<uint32_t>> adjFaces(submeshes_.size());
-
-#pragma omp parallel for
+  // take the adjacency of the submeshes which didn't change from the sidecar
+  // file, and compute the others
+  std::vector<uint64_t> iboHashes(submeshes_.size());
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelFor(
+      submeshes_.size(), pool.numThreads() + 1, [&](size_t iMesh, size_t) {
+        iboHashes[iMesh] =
+            core::hashBytes(Cr::Containers::arrayCast<const char>(
+                Cr::Containers::arrayView(submeshes_[iMesh].ibo)));
+      });
+  const Cr::Containers::Array<char> sidecar = core::mapFile(adjacencyFile_);
+  std::vector<Cr::Containers::ArrayView<const uint32_t>> adjFaces =
+      readAdjacencySidecar(sidecar, iboHashes);
+
+  std::vector<std::vector<uint32_t>> computedAdjFaces(submeshes_.size());
+  bool computed = false;
   for (int iMesh = 0; iMesh < submeshes_.size(); ++iMesh) {
-    calculateAdjacency(submeshes_[iMesh], adjFaces[iMesh]);
+    computed =
+        computed || adjFaces[iMesh].size() != submeshes_[iMesh].ibo.size();
+  }
+  if (computed) {
+    LOG(INFO) << "Calculating mesh adjacency... ";
+  }
+  pool.parallelFor(
+      submeshes_.size(), pool.numThreads() + 1, [&](size_t iMesh, size_t) {
+        if (adjFaces[iMesh].size() != submeshes_[iMesh].ibo.size()) {
+          calculateAdjacency(submeshes_[iMesh], computedAdjFaces[iMesh]);
+          adjFaces[iMesh] = Cr::Containers::arrayView(computedAdjFaces[iMesh]);
+        }
+      });
+  if (computed && !writeAdjacencySidecar(adjacencyFile_, iboHashes, adjFaces)) {
+    LOG(WARNING) << "PTexMeshData::uploadBuffersToGPU: cannot write "
+                 << adjacencyFile_ << ", the adjacency will be computed again";
   }
 #endif
 
@@ -901,50 +1174,561 @@ void PTexMeshData::uploadBuffersToGPU(bool forceReload) {
                         Magnum::GL::MeshIndexType::UnsignedInt);
   }
 
-  // load atlas data and upload them to GPU
-  LOG(INFO) << "loading atlas textures: ";
+  // the atlases are uploaded by uploadAtlas() once they are drawn, but fail
+  // early if one is missing
   for (size_t iMesh = 0; iMesh < renderingBuffers_.size(); ++iMesh) {
-    const std::string hdrFile = Cr::Utility::Directory::join(
-        atlasFolder_, std::to_string(iMesh) + "-color-ptex.hdr");
-
-    CORRADE_ASSERT(io::exists(hdrFile),
-                   "PTexMeshData::uploadBuffersToGPU: Cannot find the .hdr file"
-                       << hdrFile, );
-
-    LOG(INFO) << "Loading atlas " << iMesh + 1 << "/"
-              << renderingBuffers_.size() << " from " << hdrFile << ". ";
-
-    Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter> data =
-        Cr::Utility::Directory::mapRead(hdrFile);
-    // divided by 6, since there are 3 channels, R, G, B, each of which takes
-    // 1 half_float (2 bytes)
-    const int dim = static_cast<int>(std::sqrt(data.size() / 6));  // square
-    CORRADE_ASSERT(dim * dim * 6 == data.size(),
-                   "PTexMeshData::uploadBuffersToGPU: the atlas texture is not "
-                   "a square", );
-
-    // atlas
-    // the size of each image is dim x dim x 3 (RGB) x 2 (half_float), which
-    // equals to numBytes
-    Magnum::ImageView2D image(Magnum::PixelFormat::RGB16F, {dim, dim}, data);
-
-    renderingBuffers_[iMesh]
-        ->atlasTexture.setWrapping(Magnum::GL::SamplerWrapping::ClampToEdge)
-        .setMagnificationFilter(Magnum::GL::SamplerFilter::Linear)
-        .setMinificationFilter(Magnum::GL::SamplerFilter::Linear)
-        .setStorage(
-            Magnum::Math::log2(image.size().min()) + 1,  // mip level count
-            Magnum::GL::TextureFormat::RGB16F,
-            image.size())
-        .setSubImage(0,   // mipLevel
-                     {},  // offset
-                     image)
-        .generateMipmap();
+    const std::string hdrFile = atlasFilename(atlasFolder_, iMesh, ".hdr");
+    CORRADE_ASSERT(
+        io::exists(hdrFile) ||
+            io::exists(atlasFilename(atlasFolder_, iMesh, ".rgb9e5")),
+        "PTexMeshData::uploadBuffersToGPU: Cannot find the .hdr file"
+            << hdrFile, );
   }
 
   buffersOnGPU_ = true;
 }
 
+void PTexMeshData::uploadAtlas(int submeshID) {
+  CORRADE_ASSERT(submeshID >= 0 && submeshID < renderingBuffers_.size(),
+                 "PTexMeshData::uploadAtlas: the submesh ID" << submeshID
+                                                             << "is invalid", );
+  RenderingBuffer& buffer = *renderingBuffers_[submeshID];
+  if (buffer.atlasUploaded) {
+    return;
+  }
+  buffer.atlasUploaded = true;
+  buffer.atlasTexture.setWrapping(Magnum::GL::SamplerWrapping::ClampToEdge)
+      .setMagnificationFilter(Magnum::GL::SamplerFilter::Linear)
+      .setMinificationFilter(Magnum::GL::SamplerFilter::Linear);
+
+  // the shader fetches texels of level 0 only, so there are no mip levels
+  const std::string packedFile =
+      atlasFilename(atlasFolder_, submeshID, ".rgb9e5");
+  if (io::exists(packedFile)) {
+    Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+        data = Cr::Utility::Directory::mapRead(packedFile);
+    const int dim = squareAtlasSize(data.size(), 4);
+    CORRADE_ASSERT(dim, "PTexMeshData::uploadAtlas: the atlas texture is "
+                        "not a square", );
+    Magnum::ImageView2D image(Magnum::GL::PixelFormat::RGB,
+                              Magnum::GL::PixelType::UnsignedInt5999Rev,
+                              {dim, dim}, data);
+    buffer.atlasTexture
+        .setStorage(1, Magnum::GL::TextureFormat::RGB9E5, image.size())
+        .setSubImage(0, {}, image);
+    buffer.atlasBytes = data.size();
+    return;
+  }
+
+  const std::string hdrFile = atlasFilename(atlasFolder_, submeshID, ".hdr");
+  CORRADE_ASSERT(io::exists(hdrFile),
+                 "PTexMeshData::uploadAtlas: Cannot find the .hdr file"
+                     << hdrFile, );
+  ESP_HOT_LOG(INFO) << "Loading atlas " << submeshID + 1 << "/"
+                    << renderingBuffers_.size() << " from " << hdrFile << ". ";
+
+  Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter> data =
+      Cr::Utility::Directory::mapRead(hdrFile);
+  // 3 channels, R, G, B, each of which takes 1 half_float (2 bytes)
+  const int dim = squareAtlasSize(data.size(), 6);
+  CORRADE_ASSERT(dim, "PTexMeshData::uploadAtlas: the atlas texture is not "
+                      "a square", );
+  Magnum::ImageView2D image(Magnum::PixelFormat::RGB16F, {dim, dim}, data);
+  buffer.atlasTexture
+      .setStorage(1, Magnum::GL::TextureFormat::RGB16F, image.size())
+      .setSubImage(0, {}, image);
+  buffer.atlasBytes = data.size();
+}
+
+std::size_t PTexMeshData::getMeshBytes() const {
+  std::size_t bytes = 0;
+  for (const MeshData& submesh : submeshes_) {
+    bytes += submesh.vbo.size() * sizeof(vec3f) +
+             submesh.nbo.size() * sizeof(vec4f) +
+             submesh.cbo.size() * sizeof(vec4uc) +
+             (submesh.ibo.size() + submesh.ibo_tri.size()) * sizeof(uint32_t);
+  }
+  return bytes;
+}
+
+std::size_t PTexMeshData::getAtlasBytes() const {
+  std::size_t bytes = 0;
+  for (const std::unique_ptr<RenderingBuffer>& buffer : renderingBuffers_) {
+    bytes += buffer->atlasBytes;
+  }
+  return bytes;
+}
+
+std::size_t PTexMeshData::getCollisionBytes() const {
+  return collisionVbo_.size() * sizeof(Magnum::Vector3) +
+         collisionIbo_.size() * sizeof(Magnum::UnsignedInt);
+}
+
+int PTexMeshData::convertAtlases(const std::string& atlasFolder) {
+  int numConverted = 0;
+  for (size_t iMesh = 0;; ++iMesh) {
+    const std::string hdrFile = atlasFilename(atlasFolder, iMesh, ".hdr");
+    if (!io::exists(hdrFile)) {
+      break;
+    }
+    Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter>
+        data = Cr::Utility::Directory::mapRead(hdrFile);
+    if (!squareAtlasSize(data.size(), 6)) {
+      LOG(ERROR) << "PTexMeshData::convertAtlases: " << hdrFile
+                 << " is not a square atlas";
+      return -1;
+    }
+
+    const std::size_t numTexels = data.size() / 6;
+    Cr::Containers::Array<char> packed{Cr::Containers::NoInit,
+                                       numTexels * sizeof(uint32_t)};
+    for (std::size_t i = 0; i < numTexels; ++i) {
+      Mn::UnsignedShort halves[3];
+      std::memcpy(halves, data + i * 6, 6);
+      const uint32_t texel = packRgb9e5({Mn::Math::unpackHalf(halves[0]),
+                                         Mn::Math::unpackHalf(halves[1]),
+                                         Mn::Math::unpackHalf(halves[2])});
+      std::memcpy(packed + i * sizeof(uint32_t), &texel, sizeof(uint32_t));
+    }
+    const std::string packedFile =
+        atlasFilename(atlasFolder, iMesh, ".rgb9e5");
+    if (!Cr::Utility::Directory::write(packedFile, packed)) {
+      LOG(ERROR) << "PTexMeshData::convertAtlases: cannot write "
+                 << packedFile;
+      return -1;
+    }
+    ++numConverted;
+  }
+  return numConverted;
+}
+
+uint32_t PTexMeshData::packRgb9e5(const Mn::Vector3& color) {
+  // see the EXT_texture_shared_exponent specification
+  constexpr int MantissaBits = 9;
+  constexpr int ExponentBias = 15;
+  constexpr int MaxExponent = 31;
+  const float maxValue = float((1 << MantissaBits) - 1) /
+                         (1 << MantissaBits) *
+                         float(1 << (MaxExponent - ExponentBias));
+
+  Mn::Vector3 clamped;
+  for (int i = 0; i < 3; ++i) {
+    // NaN is clamped to 0 as well
+    clamped[i] = color[i] > 0.0f ? std::min(color[i], maxValue) : 0.0f;
+  }
+  // frexp() gives the exact floor(log2()) plus one, and 0 for 0
+  int exponent;
+  std::frexp(clamped.max(), &exponent);
+  int sharedExponent =
+      std::max(-ExponentBias - 1, exponent - 1) + 1 + ExponentBias;
+  float scale = std::ldexp(1.0f, sharedExponent - ExponentBias - MantissaBits);
+  if (std::floor(clamped.max() / scale + 0.5f) == float(1 << MantissaBits)) {
+    ++sharedExponent;
+    scale *= 2.0f;
+  }
+
+  uint32_t packed = uint32_t(sharedExponent) << 3 * MantissaBits;
+  for (int i = 0; i < 3; ++i) {
+    packed |= uint32_t(std::floor(clamped[i] / scale + 0.5f))
+              << i * MantissaBits;
+  }
+  return packed;
+}
+
+namespace {
+
+// the texels of a mapped atlas, RGB9E5 or half-float RGB
+struct AtlasTexels {
+  Cr::Containers::Array<const char, Cr::Utility::Directory::MapDeleter> data;
+  int dim = 0;
+  bool packed = false;
+
+  Mn::Vector3 fetch(const Mn::Vector2i& p) const {
+    const char* texel =
+        data + (std::size_t(p.y()) * dim + p.x()) * (packed ? 4 : 6);
+    if (packed) {
+      uint32_t bits;
+      std::memcpy(&bits, texel, sizeof(bits));
+      const float scale = std::ldexp(1.0f, int(bits >> 27) - 15 - 9);
+      return Mn::Vector3{float(bits & 0x1ff), float((bits >> 9) & 0x1ff),
+                         float((bits >> 18) & 0x1ff)} *
+             scale;
+    }
+    Mn::UnsignedShort halves[3];
+    std::memcpy(halves, texel, 6);
+    return {Mn::Math::unpackHalf(halves[0]), Mn::Math::unpackHalf(halves[1]),
+            Mn::Math::unpackHalf(halves[2])};
+  }
+};
+
+// the atlas uploadAtlas() would upload, with a dim of 0 if there's none
+AtlasTexels mapAtlas(const std::string& atlasFolder, size_t iMesh) {
+  AtlasTexels atlas;
+  const std::string packedFile = atlasFilename(atlasFolder, iMesh, ".rgb9e5");
+  atlas.packed = io::exists(packedFile);
+  const std::string file =
+      atlas.packed ? packedFile : atlasFilename(atlasFolder, iMesh, ".hdr");
+  if (io::exists(file)) {
+    atlas.data = Cr::Utility::Directory::mapRead(file);
+    atlas.dim = squareAtlasSize(atlas.data.size(), atlas.packed ? 4 : 6);
+  }
+  return atlas;
+}
+
+// RotateUVs() of the PTex fragment shader
+Mn::Vector2i rotateTexel(const Mn::Vector2i& p, int rot, int size) {
+  switch (rot) {
+    case 1:
+      return {p.y(), size - 1 - p.x()};
+    case 2:
+      return {size - 1 - p.x(), size - 1 - p.y()};
+    case 3:
+      return {size - 1 - p.y(), p.x()};
+  }
+  return p;
+}
+
+// indexAdjacentFaces() of the PTex fragment shader, the face whose tile
+// holds the texel p of face, moving p into that tile
+uint32_t adjacentFace(const std::vector<uint32_t>& adjFaces,
+                      uint32_t face,
+                      Mn::Vector2i& p,
+                      int size) {
+  int rot = 0;
+  const auto adjacent = [&](uint32_t f, int edge) {
+    const uint32_t data = adjFaces[f * 4 + edge];
+    rot = int(data >> ROTATION_SHIFT);
+    return data & FACE_MASK;
+  };
+  if (p.y() < 0 || p.y() > size - 1) {
+    const bool below = p.y() < 0;
+    uint32_t adjFace = adjacent(face, below ? 0 : 2);
+    if (adjFace != FACE_MASK) {
+      p.y() += below ? size : -size;
+      if (p.x() < 0 || p.x() > size - 1) {
+        const bool left = p.x() < 0;
+        p.x() += left ? size : -size;
+        p = rotateTexel(p, rot, size);
+        adjFace = adjacent(adjFace, ((left ? 3 : 1) - rot) & 3);
+        if (adjFace != FACE_MASK) {
+          p = rotateTexel(p, rot, size);
+          return adjFace;
+        }
+      } else {
+        p = rotateTexel(p, rot, size);
+        return adjFace;
+      }
+    }
+  } else if (p.x() < 0 || p.x() > size - 1) {
+    const bool left = p.x() < 0;
+    const uint32_t adjFace = adjacent(face, left ? 3 : 1);
+    if (adjFace != FACE_MASK) {
+      p.x() += left ? size : -size;
+      p = rotateTexel(p, rot, size);
+      return adjFace;
+    }
+  }
+  return face;
+}
+
+// textureAtlas() of the PTex fragment shader, at p in the tile of face
+Mn::Vector3 sampleAtlas(const AtlasTexels& atlas,
+                        const std::vector<uint32_t>& adjFaces,
+                        int tileSize,
+                        uint32_t face,
+                        const Mn::Vector2& p) {
+  const int widthInTiles = atlas.dim / tileSize;
+  const auto fetch = [&](Mn::Vector2i texel) {
+    const uint32_t f = adjacentFace(adjFaces, face, texel, tileSize);
+    texel = Mn::Math::clamp(texel, Mn::Vector2i{0}, Mn::Vector2i{tileSize - 1});
+    texel += Mn::Vector2i{int(f % widthInTiles), int(f / widthInTiles)} *
+             tileSize;
+    return texel.y() < atlas.dim ? atlas.fetch(texel) : Mn::Vector3{};
+  };
+  const Mn::Vector2 corner = p - Mn::Vector2{0.5f};
+  const Mn::Vector2i i{Mn::Math::floor(corner)};
+  const Mn::Vector2 f = corner - Mn::Vector2{i};
+  return Mn::Math::lerp(
+      Mn::Math::lerp(fetch(i), fetch(i + Mn::Vector2i{1, 0}), f.x()),
+      Mn::Math::lerp(fetch(i + Mn::Vector2i{0, 1}), fetch(i + Mn::Vector2i{1}),
+                     f.x()),
+      f.y());
+}
+
+// the size and the modification time of the mesh file a conversion is
+// current with
+bool meshFileStamp(const std::string& meshFile,
+                   uint64_t& size,
+                   int64_t& modified) {
+  struct stat info;
+  if (stat(meshFile.c_str(), &info) != 0) {
+    return false;
+  }
+  size = uint64_t(info.st_size);
+  modified = int64_t(info.st_mtime);
+  return true;
+}
+
+// the corners of the faces in the UVs of the geometry shader, the two
+// triangles it emits being (3, 0, 2) and (2, 0, 1)
+constexpr Mn::Vector2i FaceCorners[4]{{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+constexpr uint32_t FaceTriangles[6]{3, 0, 2, 2, 0, 1};
+
+}  // namespace
+
+bool PTexMeshData::convertToGltf(const std::string& gltfFile,
+                                 int tileResolution) const {
+  const int resolution =
+      tileResolution > 0 ? tileResolution : std::max(int(tileSize_) - 2, 1);
+  const int cellSize = resolution + 2;
+  uint64_t meshSize;
+  int64_t meshModified;
+  if (!meshFileStamp(meshFile_, meshSize, meshModified)) {
+    LOG(ERROR) << "PTexMeshData::convertToGltf: cannot stat " << meshFile_;
+    return false;
+  }
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImageConverter>
+      converterManager;
+  Cr::Containers::Pointer<Mn::Trade::AbstractImageConverter> converter =
+      converterManager.loadAndInstantiate("PngImageConverter");
+  if (!converter) {
+    LOG(ERROR) << "PTexMeshData::convertToGltf: a PngImageConverter plugin "
+                  "is needed to write the atlases";
+    return false;
+  }
+
+  const std::string base =
+      Cr::Utility::Directory::splitExtension(gltfFile).first;
+  const std::string binFile = base + ".bin";
+  std::vector<char> bin;
+  const auto append = [&bin](const void* data, std::size_t size) {
+    const std::size_t offset = bin.size();
+    bin.resize(offset + size);
+    std::memcpy(bin.data() + offset, data, size);
+  };
+
+  std::ostringstream meshes;
+  std::ostringstream images;
+  std::ostringstream views;
+  std::ostringstream accessors;
+  meshes.precision(std::numeric_limits<float>::max_digits10);
+  accessors.precision(std::numeric_limits<float>::max_digits10);
+  const auto addView = [&](std::size_t offset, int target) {
+    views << (views.tellp() > 0 ? "," : "")
+          << "{\"buffer\":0,\"byteOffset\":" << offset
+          << ",\"byteLength\":" << bin.size() - offset
+          << ",\"target\":" << target << "}";
+  };
+  for (size_t iMesh = 0; iMesh < submeshes_.size(); ++iMesh) {
+    const MeshData& mesh = submeshes_[iMesh];
+    const std::size_t numFaces = mesh.ibo.size() / 4;
+    const AtlasTexels atlas = mapAtlas(atlasFolder_, iMesh);
+    if (!atlas.dim || atlas.dim < int(tileSize_)) {
+      LOG(ERROR) << "PTexMeshData::convertToGltf: the atlas of submesh "
+                 << iMesh << " in " << atlasFolder_
+                 << " is missing or not a square";
+      return false;
+    }
+    LOG(INFO) << "Baking atlas " << iMesh + 1 << "/" << submeshes_.size()
+              << "... ";
+    std::vector<uint32_t> adjFaces;
+    calculateAdjacency(mesh, adjFaces);
+
+    // a cell of the baked atlas per face, in rows of an almost square image
+    const int columns =
+        std::max(int(std::ceil(std::sqrt(double(numFaces)))), 1);
+    const Mn::Vector2i size{
+        columns * cellSize,
+        std::max(int((numFaces + columns - 1) / columns), 1) * cellSize};
+    Cr::Containers::Array<char> pixels{Cr::Containers::ValueInit,
+                                       std::size_t(size.product()) * 3};
+    // a face samples cellSize^2 texels, far fewer faces than vertices per
+    // worker are enough
+    core::ThreadPool::shared().parallelForRanges(
+        numFaces, LOOP_GRAIN_SIZE / 256, [&](size_t begin, size_t end) {
+          for (int f = int(begin); f < int(end); ++f) {
+            const Mn::Vector2i cell =
+                Mn::Vector2i{f % columns, f / columns} * cellSize;
+            for (int y = 0; y < cellSize; ++y) {
+              for (int x = 0; x < cellSize; ++x) {
+                // the texels around the face sample past its edges
+                const Mn::Vector2 uv =
+                    (Mn::Vector2{Mn::Vector2i{x, y}} - Mn::Vector2{0.5f}) /
+                    float(resolution);
+                const Mn::Vector3 texel = sampleAtlas(
+                    atlas, adjFaces, tileSize_, f, uv * float(tileSize_));
+                const Mn::Color3ub color =
+                    toneMap(texel, exposure_, gamma_, saturation_);
+                std::memcpy(pixels + (std::size_t(cell.y() + y) * size.x() +
+                                      cell.x() + x) *
+                                         3,
+                            color.data(), 3);
+              }
+            }
+          }
+        });
+    const std::string atlasFile =
+        base + "." + std::to_string(iMesh) + ".png";
+    if (!converter->exportToFile(
+            Mn::ImageView2D{Mn::PixelStorage{}.setAlignment(1),
+                            Mn::PixelFormat::RGB8Unorm, size, pixels},
+            atlasFile)) {
+      LOG(ERROR) << "PTexMeshData::convertToGltf: cannot write "
+                 << atlasFile;
+      return false;
+    }
+
+    // four vertices per face, as the faces don't share their texels
+    std::vector<Mn::Vector3> positions(numFaces * 4);
+    std::vector<Mn::Vector2> textureCoordinates(numFaces * 4);
+    std::vector<uint32_t> indices(numFaces * 6);
+    Mn::Vector3 min{std::numeric_limits<float>::max()};
+    Mn::Vector3 max{-std::numeric_limits<float>::max()};
+    for (std::size_t f = 0; f < numFaces; ++f) {
+      const Mn::Vector2i cell =
+          Mn::Vector2i{int(f % columns), int(f / columns)} * cellSize;
+      for (int k = 0; k < 4; ++k) {
+        const vec3f& position = mesh.vbo[mesh.ibo[f * 4 + k]];
+        positions[f * 4 + k] = {position.x(), position.y(), position.z()};
+        min = Mn::Math::min(min, positions[f * 4 + k]);
+        max = Mn::Math::max(max, positions[f * 4 + k]);
+        // glTF has the origin of the texture coordinates at the top
+        const Mn::Vector2 st =
+            Mn::Vector2{cell + Mn::Vector2i{1} + FaceCorners[k] * resolution} /
+            Mn::Vector2{size};
+        textureCoordinates[f * 4 + k] = {st.x(), 1.0f - st.y()};
+      }
+      for (int k = 0; k < 6; ++k) {
+        indices[f * 6 + k] = uint32_t(f * 4 + FaceTriangles[k]);
+      }
+    }
+    const std::size_t view = iMesh * 3;
+    const std::size_t positionOffset = bin.size();
+    append(positions.data(), positions.size() * sizeof(Mn::Vector3));
+    addView(positionOffset, 34962);
+    const std::size_t textureCoordinateOffset = bin.size();
+    append(textureCoordinates.data(),
+           textureCoordinates.size() * sizeof(Mn::Vector2));
+    addView(textureCoordinateOffset, 34962);
+    const std::size_t indexOffset = bin.size();
+    append(indices.data(), indices.size() * sizeof(uint32_t));
+    addView(indexOffset, 34963);
+
+    const char* separator = iMesh ? "," : "";
+    accessors << separator << "{\"bufferView\":" << view
+              << ",\"componentType\":5126,\"count\":" << positions.size()
+              << ",\"type\":\"VEC3\",\"min\":[" << min.x() << "," << min.y()
+              << "," << min.z() << "],\"max\":[" << max.x() << "," << max.y()
+              << "," << max.z() << "]},{\"bufferView\":" << view + 1
+              << ",\"componentType\":5126,\"count\":"
+              << textureCoordinates.size()
+              << ",\"type\":\"VEC2\"},{\"bufferView\":" << view + 2
+              << ",\"componentType\":5125,\"count\":" << indices.size()
+              << ",\"type\":\"SCALAR\"}";
+    meshes << separator
+           << "{\"primitives\":[{\"attributes\":{\"POSITION\":" << view
+           << ",\"TEXCOORD_0\":" << view + 1 << "},\"indices\":" << view + 2
+           << ",\"material\":" << iMesh << "}]}";
+    images << separator << "{\"uri\":\""
+           << Cr::Utility::Directory::filename(atlasFile) << "\"}";
+  }
+  if (!Cr::Utility::Directory::write(binFile, bin)) {
+    LOG(ERROR) << "PTexMeshData::convertToGltf: cannot write " << binFile;
+    return false;
+  }
+
+  // the materials, textures and nodes are one per submesh
+  std::ostringstream materials;
+  std::ostringstream textures;
+  std::ostringstream nodes;
+  std::ostringstream sceneNodes;
+  for (size_t iMesh = 0; iMesh < submeshes_.size(); ++iMesh) {
+    const char* separator = iMesh ? "," : "";
+    materials << separator
+              << "{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":"
+              << iMesh
+              << "},\"metallicFactor\":0,\"roughnessFactor\":1},"
+                 "\"extensions\":{\"KHR_materials_unlit\":{}}}";
+    textures << separator << "{\"sampler\":0,\"source\":" << iMesh << "}";
+    nodes << separator << "{\"mesh\":" << iMesh << "}";
+    sceneNodes << separator << iMesh;
+  }
+  std::ostringstream gltf;
+  gltf << "{\"asset\":{\"version\":\"2.0\",\"generator\":"
+          "\"esp::assets::PTexMeshData::convertToGltf()\",\"extras\":{"
+       << "\"ptexMeshSize\":" << meshSize
+       << ",\"ptexMeshModified\":" << meshModified
+       << ",\"tileResolution\":" << tileResolution << "}},"
+       << "\"extensionsUsed\":[\"KHR_materials_unlit\"],"
+       << "\"scene\":0,\"scenes\":[{\"nodes\":[" << sceneNodes.str() << "]}],"
+       << "\"nodes\":[" << nodes.str() << "],"
+       << "\"meshes\":[" << meshes.str() << "],"
+       << "\"materials\":[" << materials.str() << "],"
+       << "\"textures\":[" << textures.str() << "],"
+       // ClampToEdge, Linear and LinearMipmapLinear
+       << "\"samplers\":[{\"magFilter\":9729,\"minFilter\":9987,"
+          "\"wrapS\":33071,\"wrapT\":33071}],"
+       << "\"images\":[" << images.str() << "],"
+       << "\"accessors\":[" << accessors.str() << "],"
+       << "\"bufferViews\":[" << views.str() << "],"
+       << "\"buffers\":[{\"uri\":\""
+       << Cr::Utility::Directory::filename(binFile)
+       << "\",\"byteLength\":" << bin.size() << "}]}";
+  const std::string json = gltf.str();
+  if (!core::writeFileAtomically(gltfFile, {json.data(), json.size()})) {
+    LOG(ERROR) << "PTexMeshData::convertToGltf: cannot write " << gltfFile;
+    return false;
+  }
+  return true;
+}
+
+bool PTexMeshData::isGltfConversionCurrent(const std::string& meshFile,
+                                           const std::string& gltfFile,
+                                           int tileResolution) {
+  uint64_t meshSize;
+  int64_t meshModified;
+  if (!io::exists(gltfFile) ||
+      !meshFileStamp(meshFile, meshSize, meshModified)) {
+    return false;
+  }
+  try {
+    const io::JsonDocument gltf = io::parseJsonFile(gltfFile);
+    const auto asset = gltf.FindMember("asset");
+    if (asset == gltf.MemberEnd() || !asset->value.IsObject() ||
+        !asset->value.HasMember("extras")) {
+      return false;
+    }
+    const io::JsonGenericValue& extras = asset->value["extras"];
+    return extras.IsObject() && extras.HasMember("ptexMeshSize") &&
+           extras["ptexMeshSize"].IsUint64() &&
+           extras["ptexMeshSize"].GetUint64() == meshSize &&
+           extras.HasMember("ptexMeshModified") &&
+           extras["ptexMeshModified"].IsInt64() &&
+           extras["ptexMeshModified"].GetInt64() == meshModified &&
+           extras.HasMember("tileResolution") &&
+           extras["tileResolution"].IsInt() &&
+           extras["tileResolution"].GetInt() == tileResolution;
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+}
+
+Mn::Color3ub PTexMeshData::toneMap(const Mn::Vector3& color,
+                                   float exposure,
+                                   float gamma,
+                                   float saturation) {
+  Mn::Vector3 c = color * exposure;
+  const float p = std::sqrt(c.r() * c.r() * 0.299f + c.g() * c.g() * 0.587f +
+                            c.b() * c.b() * 0.114f);
+  c = Mn::Vector3{p} + (c - Mn::Vector3{p}) * saturation;
+  // pow() of the negative components is undefined in the shader, they're
+  // black here
+  for (int i = 0; i < 3; ++i) {
+    c[i] = c[i] > 0.0f ? std::pow(c[i], gamma) : 0.0f;
+  }
+  return Mn::Math::pack<Mn::Color3ub>(Mn::Math::clamp(c, 0.0f, 1.0f));
+}
+
 PTexMeshData::RenderingBuffer* PTexMeshData::getRenderingBuffer(int submeshID) {
   CORRADE_ASSERT(submeshID >= 0 && submeshID < renderingBuffers_.size(),
                  "PTexMeshData::getRenderingBuffer: the submesh ID"
@@ -13,6 +13,7 @@
 #include <Magnum/GL/BufferTexture.h>
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Color.h>
 
 #include "BaseMesh.h"
 #include "esp/core/esp.h"
@@ -39,6 +40,10 @@ class PTexMeshData : public BaseMesh {
     Magnum::GL::Buffer triangleMeshIndexBuffer;
     Magnum::GL::Buffer adjFacesBuffer;
     Magnum::GL::BufferTexture adjFacesBufferTexture;
+    //! whether @ref PTexMeshData::uploadAtlas() uploaded @ref atlasTexture
+    bool atlasUploaded = false;
+    //! the size of the uploaded @ref atlasTexture
+    std::size_t atlasBytes = 0;
 
     RenderingBuffer()
         : adjFacesBuffer{Magnum::GL::Buffer::TargetHint::Texture} {}
@@ -63,9 +68,99 @@ class PTexMeshData : public BaseMesh {
 
   // ==== rendering ====
   RenderingBuffer* getRenderingBuffer(int submeshID);
+  /**
+   * @brief Upload the submeshes and their adjacency.
+   *
+   * The adjacency is read from a `.adjacency` sidecar file next to the mesh.
+   * It is computed for the submeshes whose indices don't match the hash
+   * stored there, after which the sidecar is written again.
+   * @param forceReload whether to upload again if uploaded already
+   */
   virtual void uploadBuffersToGPU(bool forceReload = false) override;
   virtual Magnum::GL::Mesh* getMagnumGLMesh(int submeshID) override;
 
+  /**
+   * @brief Upload the atlas texture of submesh @p submeshID, unless done
+   * already. Called by the drawables of the submesh when they are drawn, so
+   * only the atlases of submeshes which were visible take GPU memory.
+   *
+   * Uses the RGB9E5 atlas written by @ref convertAtlases() if there is one,
+   * the half-float one otherwise. Only the first level is uploaded, the
+   * shader doesn't sample the others.
+   */
+  void uploadAtlas(int submeshID);
+
+  /** @brief The size of the vertices and indices of the submeshes */
+  std::size_t getMeshBytes() const;
+
+  /**
+   * @brief The GPU memory of the atlases uploaded by @ref uploadAtlas(), in
+   * bytes
+   */
+  std::size_t getAtlasBytes() const;
+
+  /**
+   * @brief The size of the collision mesh copied when the mesh is split,
+   * 0 if it references the submesh
+   */
+  std::size_t getCollisionBytes() const;
+
+  /**
+   * @brief Convert the half-float RGB atlases in @p atlasFolder to the
+   * shared exponent RGB9E5 format, which takes 4 bytes per texel instead of
+   * 6. The converted atlases are written next to the originals.
+   * @return the number of converted atlases, -1 if one failed
+   */
+  static int convertAtlases(const std::string& atlasFolder);
+
+  /**
+   * @brief Pack @p color into RGB9E5, negative components are clamped to 0
+   * and large ones to the maximal value, 65408
+   */
+  static uint32_t packRgb9e5(const Magnum::Vector3& color);
+
+  /**
+   * @brief Convert the loaded mesh to a glTF file of UV-mapped submeshes
+   * with baked atlases, drawn by the shaders of general assets instead of
+   * the PTex one
+   *
+   * Every face gets a cell of @p tileResolution + 2 texels square in an RGB8
+   * PNG atlas per submesh, sampled the way the PTex shader does, bilinearly
+   * and across the edges to the adjacent faces, and tone mapped with the
+   * current @ref exposure(), @ref gamma() and @ref saturation(). The texels
+   * around each face keep the filtering of the baked atlas from bleeding in
+   * the other faces. The materials are KHR_materials_unlit ones, the PTex
+   * shader doesn't light either. The buffer and the atlases are written next
+   * to @p gltfFile, which is written last, atomically.
+   *
+   * @param gltfFile The `.gltf` file
+   * @param tileResolution The texels along the side of a face, 0 for
+   * @ref tileSize() - 2, so that the baked atlases are no larger than the
+   * PTex ones
+   * @return false if an atlas is missing or a file can't be written
+   */
+  bool convertToGltf(const std::string& gltfFile,
+                     int tileResolution = 0) const;
+
+  /**
+   * @brief Whether @p gltfFile is a conversion of @p meshFile by
+   * @ref convertToGltf() with @p tileResolution, and the mesh file didn't
+   * change since
+   */
+  static bool isGltfConversionCurrent(const std::string& meshFile,
+                                      const std::string& gltfFile,
+                                      int tileResolution);
+
+  /**
+   * @brief Tone map a texel of the atlases the way the PTex shader does,
+   * scaled by @p exposure, saturated by @p saturation, then raised to
+   * @p gamma
+   */
+  static Magnum::Color3ub toneMap(const Magnum::Vector3& color,
+                                  float exposure,
+                                  float gamma,
+                                  float saturation);
+
   float exposure() const;
   void setExposure(float val);
 
@@ -91,7 +186,11 @@ class PTexMeshData : public BaseMesh {
   //! @brief saturation, the intensity of a color
   float saturation_ = 1.5f;
 
+  std::string meshFile_;
   std::string atlasFolder_;
+  //! @brief Sidecar file next to the mesh caching the adjacency of the
+  //! submeshes, see @ref uploadBuffersToGPU()
+  std::string adjacencyFile_;
   std::vector<MeshData> submeshes_;
   // In the case of splitting the mesh, we need seperate containers
   // to hold the collsion mesh data as the contiguous meshdata be split up
@@ -0,0 +1,235 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PlyReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <unordered_map>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+bool parseType(const std::string& name, PlyReader::Type& type) {
+  static const std::unordered_map<std::string, PlyReader::Type> types{
+      {"char", PlyReader::Type::Char},
+      {"int8", PlyReader::Type::Char},
+      {"uchar", PlyReader::Type::UnsignedChar},
+      {"uint8", PlyReader::Type::UnsignedChar},
+      {"short", PlyReader::Type::Short},
+      {"int16", PlyReader::Type::Short},
+      {"ushort", PlyReader::Type::UnsignedShort},
+      {"uint16", PlyReader::Type::UnsignedShort},
+      {"int", PlyReader::Type::Int},
+      {"int32", PlyReader::Type::Int},
+      {"uint", PlyReader::Type::UnsignedInt},
+      {"uint32", PlyReader::Type::UnsignedInt},
+      {"float", PlyReader::Type::Float},
+      {"float32", PlyReader::Type::Float},
+      {"double", PlyReader::Type::Double},
+      {"float64", PlyReader::Type::Double},
+  };
+  auto found = types.find(name);
+  if (found == types.end()) {
+    return false;
+  }
+  type = found->second;
+  return true;
+}
+
+// the count of a list in a row, the rows are not aligned
+size_t readCount(const char* data, PlyReader::Type type) {
+  switch (type) {
+    case PlyReader::Type::UnsignedChar:
+    case PlyReader::Type::Char:
+      return uint8_t(*data);
+    case PlyReader::Type::UnsignedShort:
+    case PlyReader::Type::Short: {
+      uint16_t count;
+      std::memcpy(&count, data, sizeof(count));
+      return count;
+    }
+    default: {
+      uint32_t count;
+      std::memcpy(&count, data, sizeof(count));
+      return count;
+    }
+  }
+}
+
+}  // namespace
+
+size_t PlyReader::typeSize(Type type) {
+  switch (type) {
+    case Type::Char:
+    case Type::UnsignedChar:
+      return 1;
+    case Type::Short:
+    case Type::UnsignedShort:
+      return 2;
+    case Type::Int:
+    case Type::UnsignedInt:
+    case Type::Float:
+      return 4;
+    case Type::Double:
+      return 8;
+  }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+bool PlyReader::open(const std::string& filename) {
+  elements_.clear();
+  file_ = nullptr;
+  if (!Cr::Utility::Directory::exists(filename)) {
+    LOG(WARNING) << "PlyReader::open(): cannot open " << filename;
+    return false;
+  }
+  file_ = Cr::Utility::Directory::mapRead(filename);
+
+  // the header is text, up to and including the end_header line
+  const char endHeader[] = "end_header";
+  const char* headerEnd = std::search(file_.begin(), file_.end(), endHeader,
+                                      endHeader + sizeof(endHeader) - 1);
+  headerEnd = std::find(headerEnd, file_.end(), '\n');
+  if (headerEnd == file_.end()) {
+    LOG(WARNING) << "PlyReader::open(): " << filename
+                 << " has no complete PLY header";
+    return false;
+  }
+  std::istringstream header{std::string{file_.begin(), headerEnd}};
+
+  std::string line;
+  std::getline(header, line);
+  if (line.compare(0, 3, "ply") != 0) {
+    LOG(WARNING) << "PlyReader::open(): " << filename << " is not a PLY file";
+    return false;
+  }
+  while (std::getline(header, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    std::istringstream ls{line};
+    std::string token;
+    ls >> token;
+    if (token == "format") {
+      std::string format;
+      ls >> format;
+      if (format != "binary_little_endian") {
+        LOG(WARNING) << "PlyReader::open(): " << filename << " is in the "
+                     << format << " format, only binary_little_endian is "
+                     << "supported";
+        return false;
+      }
+    } else if (token == "element") {
+      elements_.emplace_back();
+      ls >> elements_.back().name >> elements_.back().count;
+    } else if (token == "property") {
+      if (elements_.empty()) {
+        LOG(WARNING) << "PlyReader::open(): " << filename
+                     << " has a property before any element";
+        return false;
+      }
+      Property property;
+      std::string type;
+      ls >> type;
+      bool valid = true;
+      if (type == "list") {
+        std::string countType;
+        property.isList = true;
+        ls >> countType >> type;
+        valid = parseType(countType, property.countType);
+      }
+      valid = valid && parseType(type, property.type);
+      ls >> property.name;
+      if (!valid) {
+        LOG(WARNING) << "PlyReader::open(): " << filename
+                     << " has a property of an unknown type: " << line;
+        return false;
+      }
+      elements_.back().properties.push_back(std::move(property));
+    }
+    // comment, obj_info and end_header lines carry no layout
+  }
+
+  // lay the elements out one after another, the size of the lists are taken
+  // from the first row and checked against all the others
+  const char* data = headerEnd + 1;
+  for (Element& element : elements_) {
+    element.data = data;
+    for (Property& property : element.properties) {
+      if (property.isList && element.count) {
+        if (size_t(file_.end() - data) <
+            element.stride + typeSize(property.countType)) {
+          LOG(WARNING) << "PlyReader::open(): " << filename
+                       << " is truncated in element " << element.name;
+          return false;
+        }
+        property.listSize =
+            readCount(data + element.stride, property.countType);
+      }
+      if (property.isList) {
+        element.stride += typeSize(property.countType);
+      }
+      property.offset = element.stride;
+      element.stride += property.listSize * typeSize(property.type);
+    }
+    if (element.count * element.stride > size_t(file_.end() - data)) {
+      LOG(WARNING) << "PlyReader::open(): " << filename
+                   << " is truncated in element " << element.name;
+      return false;
+    }
+
+    for (const Property& property : element.properties) {
+      if (!property.isList) {
+        continue;
+      }
+      const size_t countOffset =
+          property.offset - typeSize(property.countType);
+      std::atomic<bool> uniform{true};
+      core::ThreadPool::shared().parallelForRanges(
+          element.count, GrainSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end && uniform; ++i) {
+              if (readCount(data + i * element.stride + countOffset,
+                            property.countType) != property.listSize) {
+                uniform = false;
+              }
+            }
+          });
+      if (!uniform) {
+        LOG(WARNING) << "PlyReader::open(): the lists of " << property.name
+                     << " in " << filename << " have different sizes";
+        return false;
+      }
+    }
+    data += element.count * element.stride;
+  }
+  return true;
+}
+
+const PlyReader::Element* PlyReader::element(const std::string& name) const {
+  for (const Element& element : elements_) {
+    if (element.name == name) {
+      return &element;
+    }
+  }
+  return nullptr;
+}
+
+const PlyReader::Property* PlyReader::property(const Element& element,
+                                               const std::string& name) {
+  for (const Property& property : element.properties) {
+    if (property.name == name) {
+      return &property;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,184 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_PLYREADER_H_
+#define ESP_ASSETS_PLYREADER_H_
+
+/** @file
+ * @brief Class @ref esp::assets::PlyReader
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Directory.h>
+
+#include "esp/core/ThreadPool.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace assets {
+
+/**
+ * @brief Zero-copy reader of binary little endian PLY files
+ *
+ * The file is mapped and every element is exposed as rows of a fixed stride
+ * into the map, so properties can be viewed in place or converted in
+ * parallel, without reading the file through a stream. Lists are supported
+ * as long as all rows of an element have the same number of items, like the
+ * triangle faces of the semantic meshes, other files are rejected so callers
+ * can fall back to a general importer.
+ */
+class PlyReader {
+ public:
+  /** @brief Type of a property, or of the count or items of a list */
+  enum class Type {
+    Char,
+    UnsignedChar,
+    Short,
+    UnsignedShort,
+    Int,
+    UnsignedInt,
+    Float,
+    Double
+  };
+
+  /** @brief Property of an element */
+  struct Property {
+    std::string name;
+    /** for lists, the type of the items */
+    Type type = Type::Float;
+    bool isList = false;
+    Type countType = Type::UnsignedChar;
+    /** for lists, the number of items shared by all rows */
+    size_t listSize = 1;
+    /** offset of the value, or of the first item, in a row */
+    size_t offset = 0;
+  };
+
+  /** @brief Element, with its rows in the mapped file */
+  struct Element {
+    std::string name;
+    size_t count = 0;
+    std::vector<Property> properties;
+    size_t stride = 0;
+    const char* data = nullptr;
+  };
+
+  /** @brief Size in bytes of @p type */
+  static size_t typeSize(Type type);
+
+  /**
+   * @brief Map and parse @p filename
+   * @return false if the file can't be read, isn't a binary little endian
+   * PLY file or has lists of varying sizes, in which case a warning is
+   * printed
+   */
+  bool open(const std::string& filename);
+
+  /** @brief Element @p name, nullptr if there isn't any */
+  const Element* element(const std::string& name) const;
+
+  /** @brief Property @p name of @p element, nullptr if there isn't any */
+  static const Property* property(const Element& element,
+                                  const std::string& name);
+
+  /**
+   * @brief View on item @p item of @p property in the mapped file
+   *
+   * The property has to be of a type matching @p T, otherwise use
+   * @ref readInto().
+   */
+  template <class T>
+  static Corrade::Containers::StridedArrayView1D<const T>
+  view(const Element& element, const Property& property, size_t item = 0) {
+    CORRADE_INTERNAL_ASSERT(sizeof(T) == typeSize(property.type) &&
+                            item < property.listSize);
+    return {{element.data, element.count * element.stride},
+            reinterpret_cast<const T*>(element.data + property.offset +
+                                       item * sizeof(T)),
+            element.count,
+            std::ptrdiff_t(element.stride)};
+  }
+
+  /**
+   * @brief Convert item @p item of @p property of all rows into @p out
+   * @param element, the element
+   * @param property, a property of @p element
+   * @param item, the item of a list property
+   * @param out, with one value per row of @p element
+   */
+  template <class T>
+  static void readInto(const Element& element,
+                       const Property& property,
+                       size_t item,
+                       Corrade::Containers::StridedArrayView1D<T> out) {
+    CORRADE_INTERNAL_ASSERT(out.size() == element.count &&
+                            item < property.listSize);
+    const char* data = element.data + property.offset +
+                       item * typeSize(property.type);
+    core::ThreadPool::shared().parallelForRanges(
+        element.count, GrainSize, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            out[i] = T(read(data + i * element.stride, property.type));
+          }
+        });
+  }
+
+  /**
+   * @brief View on component @p i of @p values, to read a property into
+   */
+  template <class T, class U>
+  static Corrade::Containers::StridedArrayView1D<T> component(
+      std::vector<U>& values,
+      size_t i) {
+    Corrade::Containers::ArrayView<U> view =
+        Corrade::Containers::arrayView(values.data(), values.size());
+    return {view, reinterpret_cast<T*>(view.data()) + i, view.size(),
+            std::ptrdiff_t(sizeof(U))};
+  }
+
+ private:
+  // the number of rows a worker of the parallel loops reads at once
+  static constexpr size_t GrainSize = 16384;
+
+  // reads a value of @p type, the rows are not aligned
+  static double read(const char* data, Type type) {
+    switch (type) {
+#define READ(type_, T)                    \
+  case Type::type_: {                     \
+    T value;                              \
+    std::memcpy(&value, data, sizeof(T)); \
+    return value;                         \
+  }
+      READ(Char, int8_t)
+      READ(UnsignedChar, uint8_t)
+      READ(Short, int16_t)
+      READ(UnsignedShort, uint16_t)
+      READ(Int, int32_t)
+      READ(UnsignedInt, uint32_t)
+      READ(Float, float)
+      READ(Double, double)
+#undef READ
+    }
+    CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+  }
+
+  Corrade::Containers::Array<const char,
+                             Corrade::Utility::Directory::MapDeleter>
+      file_;
+  std::vector<Element> elements_;
+
+  ESP_SMART_POINTERS(PlyReader)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_PLYREADER_H_
@@ -19,6 +19,7 @@
 #include <Magnum/GL/Context.h>
 #include <Magnum/GL/Extensions.h>
 #include <Magnum/ImageView.h>
+#include <Magnum/Math/Color.h>
 #include <Magnum/Math/FunctionsBatch.h>
 #include <Magnum/Math/Range.h>
 #include <Magnum/Math/Tags.h>
@@ -34,11 +35,27 @@
 #include <Magnum/Trade/PhongMaterialData.h>
 #include <Magnum/Trade/SceneData.h>
 #include <Magnum/Trade/TextureData.h>
-
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <future>
+#include <sys/stat.h>
+#include <tuple>
+
+#include "esp/core/AsyncLog.h"
+#include "esp/core/MappedFile.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/StartupProfile.h"
 #include "esp/geo/geo.h"
+#include "esp/gfx/BakedLighting.h"
+#include "esp/gfx/CubeMap.h"
+#include "esp/gfx/CubeMapCamera.h"
 #include "esp/gfx/GenericDrawable.h"
 #include "esp/gfx/MaterialUtil.h"
 #include "esp/gfx/PbrDrawable.h"
+#include "esp/gfx/PbrImageBasedLighting.h"
+#include "esp/gfx/TextureCompression.h"
 #include "esp/gfx/replay/Recorder.h"
 #include "esp/io/io.h"
 #include "esp/io/json.h"
@@ -48,6 +65,7 @@
 #include "esp/nav/PathFinder.h"
 
 #ifdef ESP_BUILD_WITH_BULLET
+#include "esp/physics/bullet/BulletConvexDecomposition.h"
 #include "esp/physics/bullet/BulletPhysicsManager.h"
 #endif
 
@@ -78,6 +96,227 @@ using metadata::managers::StageAttributesManager;
 
 namespace assets {
 
+namespace {
+
+// The up-to-date baked bundle of @p filename, nullptr if there is none
+std::unique_ptr<SceneBundle> openSceneBundle(const std::string& filename) {
+  const std::string bundleFilename = SceneBundle::filenameFor(filename);
+  if (!io::exists(bundleFilename)) {
+    return nullptr;
+  }
+  auto bundle = std::make_unique<SceneBundle>(bundleFilename);
+  return bundle->isOpen() ? std::move(bundle) : nullptr;
+}
+
+/**
+ * @brief Import @p count items on one loader thread, process each of them on
+ * any loader thread and consume them in order on the calling thread, so that
+ * the GL uploads overlap the decoding of the next items.
+ *
+ * Importers and the plugin manager aren't thread-safe, so @p import is the
+ * only code touching them until this returns.
+ */
+template <class T>
+void pipelineInOrder(core::ThreadPool& pool,
+                     std::size_t count,
+                     const std::function<T(std::size_t)>& import,
+                     const std::function<void(T&)>& process,
+                     const std::function<void(std::size_t, T&)>& consume) {
+  std::vector<std::promise<T>> promises(count);
+  std::vector<std::future<T>> futures;
+  futures.reserve(count);
+  for (std::promise<T>& promise : promises) {
+    futures.push_back(promise.get_future());
+  }
+
+  // written by the importing task, one per item it was able to import
+  std::vector<std::future<void>> processing(count);
+  std::future<void> importing = pool.submit([&]() {
+    for (std::size_t i = 0; i < count; ++i) {
+      std::shared_ptr<T> item;
+      try {
+        item = std::make_shared<T>(import(i));
+      } catch (...) {
+        promises[i].set_exception(std::current_exception());
+        continue;
+      }
+      processing[i] = pool.submit([&promises, &process, item, i]() {
+        try {
+          process(*item);
+          promises[i].set_value(std::move(*item));
+        } catch (...) {
+          promises[i].set_exception(std::current_exception());
+        }
+      });
+    }
+  });
+
+  // the tasks reference the promises, so all of them have to finish before
+  // this returns, also when an exception leaves it
+  std::exception_ptr error;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (error) {
+      futures[i].wait();
+      continue;
+    }
+    try {
+      T item = futures[i].get();
+      consume(i, item);
+    } catch (...) {
+      error = std::current_exception();
+    }
+  }
+  importing.wait();
+  for (std::future<void>& task : processing) {
+    if (task.valid()) {
+      task.wait();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * @brief Append the triangles of the meshes in the tree of @p node to
+ * @p positions and @p indices, transformed to the space of the root like
+ * @ref physics::BulletRigidObject::constructBulletCompoundFromMeshes does.
+ */
+void flattenCollisionMeshes(const Mn::Matrix4& transformFromParentToWorld,
+                            const std::vector<CollisionMeshData>& meshGroup,
+                            const MeshTransformNode& node,
+                            std::vector<Mn::Vector3>& positions,
+                            std::vector<Mn::UnsignedInt>& indices) {
+  const Mn::Matrix4 transformFromLocalToWorld =
+      transformFromParentToWorld * node.transformFromLocalToParent;
+  if (node.meshIDLocal != ID_UNDEFINED) {
+    const CollisionMeshData& mesh = meshGroup[node.meshIDLocal];
+    if (mesh.primitive == Mn::MeshPrimitive::Triangles) {
+      const Mn::UnsignedInt first = positions.size();
+      for (const Mn::Vector3& v : mesh.positions) {
+        positions.push_back(transformFromLocalToWorld.transformPoint(v));
+      }
+      for (const Mn::UnsignedInt index : mesh.indices) {
+        indices.push_back(first + index);
+      }
+    }
+  }
+  for (const MeshTransformNode& child : node.children) {
+    flattenCollisionMeshes(transformFromLocalToWorld, meshGroup, child,
+                           positions, indices);
+  }
+}
+
+/**
+ * @brief The attributes of @p mesh the drawables need to know about
+ */
+gfx::Drawable::Flags meshAttributeFlags(BaseMesh& mesh) {
+  gfx::Drawable::Flags flags{};
+  const auto& meshData = mesh.getMeshData();
+  if (meshData != Cr::Containers::NullOpt) {
+    if (meshData->hasAttribute(Mn::Trade::MeshAttribute::Tangent)) {
+      flags |= gfx::Drawable::Flag::HasTangent;
+
+      // if it has tangent, then check if it has bitangent
+      if (meshData->hasAttribute(Mn::Trade::MeshAttribute::Bitangent)) {
+        flags |= gfx::Drawable::Flag::HasSeparateBitangent;
+      }
+    }
+    if (meshData->hasAttribute(Mn::Trade::MeshAttribute::ObjectId)) {
+      flags |= gfx::Drawable::Flag::HasObjectId;
+    }
+  }
+  return flags;
+}
+
+/**
+ * @brief Append the meshes in the tree of @p node with their transformations
+ * to the space of the root and their material keys, in draw order
+ */
+void flattenRenderMeshes(
+    const Mn::Matrix4& transformFromParentToWorld,
+    const MeshMetaData& metaData,
+    const MeshTransformNode& node,
+    std::vector<std::tuple<int, Mn::Matrix4, std::string>>& meshes) {
+  const Mn::Matrix4 transformFromLocalToWorld =
+      transformFromParentToWorld * node.transformFromLocalToParent;
+  if (node.meshIDLocal != ID_UNDEFINED) {
+    std::string materialKey;
+    if (node.materialIDLocal == ID_UNDEFINED ||
+        metaData.materialIndex.second == ID_UNDEFINED) {
+      materialKey = DEFAULT_MATERIAL_KEY;
+    } else {
+      materialKey =
+          std::to_string(metaData.materialIndex.first + node.materialIDLocal);
+    }
+    meshes.emplace_back(metaData.meshIndex.first + node.meshIDLocal,
+                        transformFromLocalToWorld, std::move(materialKey));
+  }
+  for (const MeshTransformNode& child : node.children) {
+    flattenRenderMeshes(transformFromLocalToWorld, metaData, child, meshes);
+  }
+}
+
+}  // namespace
+
+struct ResourceManager::AssetReference::Usage {
+  int numReferences = 0;
+  // the tick the asset was last loaded or released at, the least recent are
+  // evicted first
+  std::uint64_t lastUsed = 0;
+};
+
+struct ResourceManager::AssetReference::Tracker {
+  std::map<std::string, Usage> assets;
+  std::uint64_t clock = 0;
+};
+
+ResourceManager::AssetReference::AssetReference(
+    AssetReference&& other) noexcept
+    : tracker_{std::move(other.tracker_)}, usage_{other.usage_} {
+  other.usage_ = nullptr;
+}
+
+ResourceManager::AssetReference& ResourceManager::AssetReference::operator=(
+    AssetReference&& other) noexcept {
+  if (this != &other) {
+    release();
+    tracker_ = std::move(other.tracker_);
+    usage_ = other.usage_;
+    other.usage_ = nullptr;
+  }
+  return *this;
+}
+
+ResourceManager::AssetReference::~AssetReference() {
+  release();
+}
+
+void ResourceManager::AssetReference::release() {
+  if (usage_) {
+    --usage_->numReferences;
+    usage_->lastUsed = ++tracker_->clock;
+    usage_ = nullptr;
+  }
+  tracker_ = nullptr;
+}
+
+namespace {
+// Holds a reference to the asset of an instance for as long as its node
+// lives, see ResourceManager::evictUnusedAssets()
+class AssetInstanceFeature : public Mn::SceneGraph::AbstractFeature3D,
+                             public core::ArenaAllocated {
+ public:
+  AssetInstanceFeature(scene::SceneNode& node,
+                       ResourceManager::AssetReference reference)
+      : Mn::SceneGraph::AbstractFeature3D{node},
+        reference_{std::move(reference)} {}
+
+ private:
+  ResourceManager::AssetReference reference_;
+};
+}  // namespace
+
 ResourceManager::ResourceManager(
     metadata::MetadataMediator::ptr& _metadataMediator,
     Flags _flags)
@@ -89,7 +328,7 @@ ResourceManager::ResourceManager(
       importerManager_("nonexistent")
 #endif
 {
-
+  assetUsage_ = std::make_shared<AssetReference::Tracker>();
   initDefaultLightSetups();
   initDefaultMaterials();
   buildImporters();
@@ -171,6 +410,8 @@ bool ResourceManager::loadStage(
     std::vector<int>& activeSceneIDs,
     bool createSemanticMesh,
     bool forceSeparateSemanticSceneGraph) {
+  ESP_PROFILE_SCOPE("ResourceManager::loadStage");
+  ESP_STARTUP_SPAN("ResourceManager::loadStage");
   // create AssetInfos here for each potential mesh file for the scene, if they
   // are unique.
   bool buildCollisionMesh =
@@ -181,6 +422,27 @@ bool ResourceManager::loadStage(
   std::map<std::string, AssetInfo> assetInfoMap =
       createStageAssetInfosFromAttributes(stageAttributes, buildCollisionMesh,
                                           createSemanticMesh);
+  AssetInfo renderInfo = assetInfoMap.at("render");
+
+  // a render mesh with the object ids per vertex draws the semantic
+  // observations itself, in the same scene graph and pass as the color ones,
+  // instead of a separate semantic mesh holding the geometry again
+  if (assetInfoMap.count("semantic") && !forceSeparateSemanticSceneGraph) {
+    bool renderHasObjectIds =
+        assetInfoMap.at("semantic").filepath == renderInfo.filepath;
+    if (!renderHasObjectIds && renderInfo.filepath != EMPTY_SCENE &&
+        renderInfo.type != AssetType::SUNCG_SCENE &&
+        renderInfo.type != AssetType::FRL_PTEX_MESH &&
+        loadStageInternal(renderInfo, nullptr, nullptr, nullptr)) {
+      renderHasObjectIds = hasPerVertexObjectIds(renderInfo.filepath);
+    }
+    if (renderHasObjectIds) {
+      LOG(INFO) << "ResourceManager::loadStage : Stage render mesh "
+                << renderInfo.filepath
+                << " has the object ids, not loading a semantic mesh";
+      assetInfoMap.erase("semantic");
+    }
+  }
 
   // set equal to current Simulator::activeSemanticSceneID_ value
   int activeSemanticSceneID = activeSceneIDs[0];
@@ -249,8 +511,6 @@ bool ResourceManager::loadStage(
   auto& rootNode = sceneGraph.getRootNode();
   auto& drawables = sceneGraph.getDrawables();
 
-  AssetInfo renderInfo = assetInfoMap.at("render");
-
   RenderAssetInstanceCreationInfo::Flags flags;
   flags |= RenderAssetInstanceCreationInfo::Flag::IsStatic;
   flags |= RenderAssetInstanceCreationInfo::Flag::IsRGBD;
@@ -273,6 +533,7 @@ bool ResourceManager::loadStage(
   // declare mesh group variable
   std::vector<CollisionMeshData> meshGroup;
   AssetInfo& infoToUse = renderInfo;
+  bool hasCollisionAsset = false;
   if (assetInfoMap.count("collision")) {
     AssetInfo colInfo = assetInfoMap.at("collision");
     // should this be checked to make sure we do not reload?
@@ -290,8 +551,15 @@ bool ResourceManager::loadStage(
     // collision object, add it
     if (colInfo.filepath.compare(EMPTY_SCENE) != 0) {
       infoToUse = colInfo;
+      hasCollisionAsset = true;
     }  // if not colInfo.filepath.compare(EMPTY_SCENE)
   }    // if collision mesh desired
+  // without a collision asset, physics and the navmesh use the simplified
+  // render meshes, if enabled
+  if (!hasCollisionAsset && stageCollisionSimplification_ > 0.0f &&
+      renderInfo.filepath.compare(EMPTY_SCENE) != 0) {
+    simplifyStageCollision(renderInfo.filepath);
+  }
   // build the appropriate mesh groups, either for the collision mesh, or, if
   // the collision mesh is empty scene
 
@@ -315,12 +583,23 @@ bool ResourceManager::loadStage(
     }
   }
 
+  // nothing reads the stage meshes on the CPU without a collision mesh, they
+  // are re-read if that changes
+  if (releaseStageMeshData_ && !buildCollisionMesh) {
+    const int released = releaseHostMeshData(renderInfo.filepath);
+    if (released) {
+      LOG(INFO) << "ResourceManager::loadStage : Released the CPU data of "
+                << released << " meshes of " << renderInfo.filepath;
+    }
+  }
+
   return true;
 }  // ResourceManager::loadScene
 bool ResourceManager::buildMeshGroups(
     const AssetInfo& info,
     std::vector<CollisionMeshData>& meshGroup) {
   if (collisionMeshGroups_.count(info.filepath) == 0) {
+    restoreHostMeshData(info.filepath);
     //! Collect collision mesh group
     bool colMeshGroupSuccess = false;
     if (info.type == AssetType::INSTANCE_MESH) {
@@ -348,6 +627,16 @@ bool ResourceManager::buildMeshGroups(
                     "initialization.";
       return false;
     }
+    // the simplified meshes replace the render meshes, the primitive stays
+    if (std::vector<geo::SimplifiedMesh>* simplified =
+            findSimplifiedCollision(info.filepath)) {
+      for (std::size_t i = 0; i < meshGroup.size(); ++i) {
+        geo::SimplifiedMesh& mesh = (*simplified)[i];
+        meshGroup[i].positions = {mesh.positions.data(),
+                                  mesh.positions.size()};
+        meshGroup[i].indices = {mesh.indices.data(), mesh.indices.size()};
+      }
+    }
     //! Add scene meshgroup to collision mesh groups
     collisionMeshGroups_.emplace(info.filepath, meshGroup);
   } else {
@@ -357,6 +646,93 @@ bool ResourceManager::buildMeshGroups(
   return true;
 }  // ResourceManager::buildMeshGroups
 
+void ResourceManager::setStageCollisionSimplification(const float maxError) {
+  if (maxError == stageCollisionSimplification_) {
+    return;
+  }
+  // the mesh groups and joined meshes built with the previous error are
+  // rebuilt, the simplified meshes stay for the physics still using them
+  for (const auto& simplified : simplifiedCollisionMeshes_) {
+    collisionMeshGroups_.erase(simplified.first.first);
+    joinedCollisionMeshes_.erase(simplified.first.first);
+  }
+  stageCollisionSimplification_ = maxError;
+}
+
+std::vector<geo::SimplifiedMesh>* ResourceManager::findSimplifiedCollision(
+    const std::string& filename) {
+  if (stageCollisionSimplification_ <= 0.0f) {
+    return nullptr;
+  }
+  auto found = simplifiedCollisionMeshes_.find(
+      {filename, stageCollisionSimplification_});
+  return found != simplifiedCollisionMeshes_.end() ? &found->second : nullptr;
+}
+
+const std::vector<geo::SimplifiedMesh>& ResourceManager::simplifyStageCollision(
+    const std::string& filename) {
+  const std::pair<std::string, float> key{filename,
+                                          stageCollisionSimplification_};
+  auto found = simplifiedCollisionMeshes_.find(key);
+  if (found != simplifiedCollisionMeshes_.end()) {
+    return found->second;
+  }
+  ESP_PROFILE_SCOPE("ResourceManager::simplifyStageCollision");
+  const float maxError = stageCollisionSimplification_;
+  const std::pair<int, int>& meshIndex = getMeshMetaData(filename).meshIndex;
+  const std::size_t count =
+      meshIndex.first == ID_UNDEFINED ? 0
+                                      : meshIndex.second - meshIndex.first + 1;
+  std::vector<geo::SimplifiedMesh> meshes(count);
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t numWorkers = pool.numThreads() + 1;
+
+  // the cached meshes first, the others need the CPU data of the meshes
+  std::vector<char> cached(count, 0);
+  if (meshCache_) {
+    pool.parallelFor(count, numWorkers, [&](std::size_t i, std::size_t) {
+      cached[i] = meshCache_->loadSimplifiedCollision(filename, int(i),
+                                                      maxError, meshes[i]);
+    });
+  }
+  if (std::find(cached.begin(), cached.end(), 0) != cached.end()) {
+    restoreHostMeshData(filename);
+  }
+  pool.parallelFor(count, numWorkers, [&](std::size_t i, std::size_t) {
+    if (cached[i]) {
+      return;
+    }
+    const CollisionMeshData& collision =
+        meshes_.at(meshIndex.first + int(i))->getCollisionMeshData();
+    geo::SimplifiedMesh& mesh = meshes[i];
+    if (collision.primitive != Mn::MeshPrimitive::Triangles) {
+      // not simplified, but a copy as well so it outlives the render mesh
+      mesh.positions.assign(collision.positions.begin(),
+                            collision.positions.end());
+      mesh.indices.assign(collision.indices.begin(), collision.indices.end());
+      return;
+    }
+    mesh = geo::simplifyCollisionMesh(collision.positions, collision.indices,
+                                      maxError);
+    if (meshCache_) {
+      meshCache_->storeSimplifiedCollision(filename, int(i), maxError, mesh);
+    }
+  });
+
+  std::size_t simplifiedTriangles = 0;
+  for (const geo::SimplifiedMesh& mesh : meshes) {
+    simplifiedTriangles += mesh.indices.size() / 3;
+  }
+  LOG(INFO) << "ResourceManager::simplifyStageCollision : Collision mesh of "
+            << filename << " simplified to " << simplifiedTriangles
+            << " triangles within " << maxError;
+  // built from the render meshes, they're rebuilt from the simplified ones
+  collisionMeshGroups_.erase(filename);
+  joinedCollisionMeshes_.erase(filename);
+  return simplifiedCollisionMeshes_.emplace(key, std::move(meshes))
+      .first->second;
+}
+
 std::map<std::string, AssetInfo>
 ResourceManager::createStageAssetInfosFromAttributes(
     const StageAttributes::ptr& stageAttributes,
@@ -376,6 +752,20 @@ ResourceManager::createStageAssetInfosFromAttributes(
       virtualUnitToMeters,                      // virtualUnitToMeters
       stageAttributes->getRequiresLighting()    // requiresLighting
   };
+  // the PTex mesh isn't loaded at all if it's the collision mesh as well
+  std::string ptexMesh;
+  std::string convertedPTex;
+  if (renderInfo.type == AssetType::FRL_PTEX_MESH &&
+      !ptexConversionDirectory_.empty()) {
+    convertedPTex = convertedPTexMesh(renderInfo.filepath);
+    if (!convertedPTex.empty()) {
+      // in the same frame, the PTex shader doesn't light either
+      ptexMesh = renderInfo.filepath;
+      renderInfo.type = AssetType::UNKNOWN;
+      renderInfo.filepath = convertedPTex;
+      renderInfo.requiresLighting = false;
+    }
+  }
   resMap["render"] = renderInfo;
   if (createCollisionInfo) {
     // create collision asset info if requested
@@ -388,6 +778,11 @@ ResourceManager::createStageAssetInfosFromAttributes(
         virtualUnitToMeters,                         // virtualUnitToMeters
         false                                        // requiresLighting
     };
+    if (collisionInfo.type == AssetType::FRL_PTEX_MESH &&
+        !convertedPTex.empty() && collisionInfo.filepath == ptexMesh) {
+      collisionInfo.type = AssetType::UNKNOWN;
+      collisionInfo.filepath = convertedPTex;
+    }
     resMap["collision"] = collisionInfo;
   }
   if (createSemanticInfo) {
@@ -434,6 +829,7 @@ scene::SceneNode* ResourceManager::loadAndCreateRenderAssetInstance(
     const RenderAssetInstanceCreationInfo& creation,
     esp::scene::SceneManager* sceneManagerPtr,
     const std::vector<int>& activeSceneIDs) {
+  ESP_PROFILE_SCOPE("ResourceManager::loadAndCreateRenderAssetInstance");
   // We map isStatic, isSemantic, and isRGBD to a scene graph.
   int sceneID = -1;
   if (!creation.isStatic()) {
@@ -490,6 +886,20 @@ scene::SceneNode* ResourceManager::loadAndCreateRenderAssetInstance(
 }
 
 bool ResourceManager::loadRenderAsset(const AssetInfo& info) {
+  ESP_PROFILE_SCOPE("ResourceManager::loadRenderAsset");
+  ESP_STARTUP_SPAN("ResourceManager::loadRenderAsset");
+  // the same file under another path shares the meshes and textures loaded
+  // already, PTex meshes read the textures next to them
+  std::uint64_t hash = 0;
+  const bool hashed = info.type != AssetType::FRL_PTEX_MESH &&
+                      contentHash(info.filepath, hash);
+  if (hashed && loadSharedRenderAsset(info, hash)) {
+    if (gfxReplayRecorder_) {
+      gfxReplayRecorder_->onLoadRenderAsset(info);
+    }
+    return true;
+  }
+
   bool meshSuccess = false;
   if (info.type == AssetType::FRL_PTEX_MESH) {
     meshSuccess = loadRenderAssetPTex(info);
@@ -501,6 +911,12 @@ bool ResourceManager::loadRenderAsset(const AssetInfo& info) {
     // loadRenderAsset doesn't yet support the requested asset type
     CORRADE_INTERNAL_ASSERT_UNREACHABLE();
   }
+  if (meshSuccess) {
+    measureAsset(info.filepath, true);
+    if (hashed) {
+      contentAssets_.emplace(hash, info.filepath);
+    }
+  }
   if (gfxReplayRecorder_) {
     gfxReplayRecorder_->onLoadRenderAsset(info);
   }
@@ -545,6 +961,11 @@ scene::SceneNode* ResourceManager::createRenderAssetInstance(
     CORRADE_INTERNAL_ASSERT_UNREACHABLE();
   }
 
+  if (newNode) {
+    // the asset stays loaded as long as the instance, see
+    // evictUnusedAssets()
+    newNode->addFeature<AssetInstanceFeature>(acquireAsset(creation.filepath));
+  }
   if (gfxReplayRecorder_ && newNode) {
     gfxReplayRecorder_->onCreateRenderAssetInstance(newNode, creation);
   }
@@ -561,7 +982,15 @@ bool ResourceManager::loadStageInternal(
   const std::string& filename = info.filepath;
   bool meshSuccess = true;
   if (info.filepath.compare(EMPTY_SCENE) != 0) {
-    if (!Cr::Utility::Directory::exists(filename)) {
+    const FileProvider::Status provided =
+        fileProvider_ ? fileProvider_->request(filename)
+                      : FileProvider::Status::Unavailable;
+    if (provided == FileProvider::Status::Pending) {
+      LOG(ERROR) << "ResourceManager::loadStageInternal : Scene file "
+                 << filename << " is not downloaded yet";
+      meshSuccess = false;
+    } else if (provided == FileProvider::Status::Unavailable &&
+               !Cr::Utility::Directory::exists(filename)) {
       LOG(ERROR)
           << "ResourceManager::loadStageInternal : Cannot find scene file "
           << filename;
@@ -654,7 +1083,7 @@ bool ResourceManager::loadObjectMeshDataFromFile(
 
 Magnum::Range3D ResourceManager::computeMeshBB(BaseMesh* meshDataGL) {
   CollisionMeshData& meshData = meshDataGL->getCollisionMeshData();
-  return Mn::Math::minmax(meshData.positions);
+  return geo::getPointSetBounds(meshData.positions);
 }
 
 #ifdef ESP_BUILD_PTEX_SUPPORT
@@ -683,7 +1112,7 @@ void ResourceManager::computePTexMeshAbsoluteAABBs(
     Mn::MeshTools::transformPointsInPlace(absTransforms[iEntry], pos);
 
     scene::SceneNode& node = staticDrawableInfo[iEntry].node;
-    node.setAbsoluteAABB(Mn::Math::minmax(pos));
+    node.setAbsoluteAABB(geo::getPointSetBounds(pos));
   }
 }  // ResourceManager::computePTexMeshAbsoluteAABBs
 #endif
@@ -719,20 +1148,44 @@ void ResourceManager::computeGeneralMeshAbsoluteAABBs(
           meshData->positions3DAsArray(jArray);
       Mn::MeshTools::transformPointsInPlace(absTransforms[iEntry], pos);
 
-      std::pair<Mn::Vector3, Mn::Vector3> bb = Mn::Math::minmax(pos);
-      bbPos.push_back(bb.first);
-      bbPos.push_back(bb.second);
+      const Mn::Range3D bb = geo::getPointSetBounds(pos);
+      bbPos.push_back(bb.min());
+      bbPos.push_back(bb.max());
     }
 
     // locate the scene node which contains the current drawable
     scene::SceneNode& node = staticDrawableInfo[iEntry].node;
 
     // set the absolute axis aligned bounding box
-    node.setAbsoluteAABB(Mn::Math::minmax(bbPos));
+    node.setAbsoluteAABB(geo::getPointSetBounds(bbPos));
 
   }  // iEntry
 }  // ResourceManager::computeGeneralMeshAbsoluteAABBs
 
+bool ResourceManager::hasPerVertexObjectIds(const std::string& filename) {
+  auto found = resourceDict_.find(filename);
+  if (found == resourceDict_.end()) {
+    return false;
+  }
+  if (found->second.assetInfo.type == AssetType::INSTANCE_MESH) {
+    return true;
+  }
+  const auto& meshIndex = found->second.meshMetaData.meshIndex;
+  if (meshIndex.first == ID_UNDEFINED) {
+    return false;
+  }
+  // the attributes are only known while the host data is there
+  for (int meshID = meshIndex.first; meshID <= meshIndex.second; ++meshID) {
+    auto mesh = meshes_.find(meshID);
+    if (mesh == meshes_.end() ||
+        !(meshAttributeFlags(*mesh->second) &
+          gfx::Drawable::Flag::HasObjectId)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void ResourceManager::computeInstanceMeshAbsoluteAABBs(
     const std::vector<StaticDrawableInfo>& staticDrawableInfo) {
   std::vector<Mn::Matrix4> absTransforms =
@@ -757,7 +1210,7 @@ void ResourceManager::computeInstanceMeshAbsoluteAABBs(
                                           transformedPositions);
 
     scene::SceneNode& node = staticDrawableInfo[iEntry].node;
-    node.setAbsoluteAABB(Mn::Math::minmax(transformedPositions));
+    node.setAbsoluteAABB(geo::getPointSetBounds(transformedPositions));
   }  // iEntry
 }
 
@@ -841,6 +1294,31 @@ void ResourceManager::buildPrimitiveAssetData(
   // build mesh data object
   primMeshData->importAndSetMeshData(*primitiveImporter_, primClassName);
 
+  // templates of other handles may generate the same mesh, e.g. differing
+  // only in parameters the primitive ignores, share it with them
+  const Mn::Trade::MeshData& generated = *primMeshData->getMeshData();
+  const std::uint64_t hash = core::hashBytesXXH64(
+      generated.vertexData(),
+      core::hashBytesXXH64(generated.indexData(),
+                           core::hashBytesXXH64({primClassName.data(),
+                                                 primClassName.size()})));
+  auto candidates = contentAssets_.equal_range(hash);
+  for (auto candidate = candidates.first; candidate != candidates.second;
+       ++candidate) {
+    auto source = resourceDict_.find(candidate->second);
+    if (source == resourceDict_.end() ||
+        source->second.assetInfo.type != AssetType::PRIMITIVE) {
+      continue;
+    }
+    LOG(INFO) << " Primitive Asset " << primAssetHandle
+              << " generates the mesh of " << candidate->second
+              << ", sharing it";
+    resourceDict_.emplace(primAssetHandle,
+                          LoadedAssetData{info, source->second.meshMetaData});
+    contentAssets_.emplace(hash, primAssetHandle);
+    return;
+  }
+
   // compute the mesh bounding box
   primMeshData->BB = computeMeshBB(primMeshData.get());
 
@@ -874,6 +1352,7 @@ void ResourceManager::buildPrimitiveAssetData(
   LoadedAssetData loadedAssetData{info, meshMetaData};
   auto inserted =
       resourceDict_.emplace(primAssetHandle, std::move(loadedAssetData));
+  contentAssets_.emplace(hash, primAssetHandle);
 
   LOG(INFO) << " Primitive Asset Added : ID : " << primTemplate->getID()
             << " : attr lib key : " << primTemplate->getHandle()
@@ -986,36 +1465,27 @@ bool ResourceManager::loadRenderAssetIMesh(const AssetInfo& info) {
   CORRADE_INTERNAL_ASSERT_OUTPUT(
       importer = importerManager_.loadAndInstantiate("StanfordImporter"));
 
-  std::vector<GenericInstanceMeshData::uptr> instanceMeshes;
-  if (info.splitInstanceMesh) {
-    instanceMeshes =
-        GenericInstanceMeshData::fromPlySplitByObjectId(*importer, filename);
-  } else {
-    GenericInstanceMeshData::uptr meshData =
-        GenericInstanceMeshData::fromPLY(*importer, filename);
-    if (meshData)
-      instanceMeshes.emplace_back(std::move(meshData));
-  }
-
-  if (instanceMeshes.empty()) {
+  core::StartupProfile::addBytesRead(io::fileSize(filename));
+  // split by object, the objects are ranges of the indices of one mesh
+  GenericInstanceMeshData::uptr meshData =
+      info.splitInstanceMesh
+          ? GenericInstanceMeshData::fromPlySplitByObjectId(*importer,
+                                                            filename)
+          : GenericInstanceMeshData::fromPLY(*importer, filename);
+  if (!meshData) {
     LOG(ERROR) << "Error loading instance mesh data";
     return false;
   }
 
-  int meshStart = nextMeshID_;
-  int meshEnd = meshStart + instanceMeshes.size() - 1;
-  nextMeshID_ = meshEnd + 1;
-  MeshMetaData meshMetaData{meshStart, meshEnd};
-  meshMetaData.root.children.resize(instanceMeshes.size());
+  const int meshID = nextMeshID_++;
+  MeshMetaData meshMetaData{meshID, meshID};
+  meshMetaData.root.children.resize(1);
+  meshMetaData.root.children[0].meshIDLocal = 0;
 
-  for (int meshIDLocal = 0; meshIDLocal < instanceMeshes.size();
-       ++meshIDLocal) {
-    instanceMeshes[meshIDLocal]->uploadBuffersToGPU(false);
-    meshes_.emplace(meshStart + meshIDLocal,
-                    std::move(instanceMeshes[meshIDLocal]));
-
-    meshMetaData.root.children[meshIDLocal].meshIDLocal = meshIDLocal;
-  }
+  core::StartupProfile::addTriangles(
+      meshData->getCollisionMeshData().indices.size() / 3);
+  meshData->uploadBuffersToGPU(false);
+  meshes_.emplace(meshID, std::move(meshData));
 
   // update the dictionary
   resourceDict_.emplace(filename,
@@ -1053,12 +1523,17 @@ scene::SceneNode* ResourceManager::createRenderAssetInstanceIMesh(
     // That means One CANNOT query the data like e.g.,
     // meshes_.at(iMesh)->getMeshData()->hasAttribute(Mn::Trade::MeshAttribute::Tangent)
     // It will SEGFAULT!
-    createDrawable(*(meshes_.at(iMesh)->getMagnumGLMesh()),  // render mesh
-                   meshAttributeFlags,                 // mesh attribute flags
-                   node,                               // scene node
-                   creation.lightSetupKey,             // lightSetup key
-                   PER_VERTEX_OBJECT_ID_MATERIAL_KEY,  // material key
-                   drawables);                         // drawable group
+    gfx::Drawable& drawable = createDrawable(
+        *(meshes_.at(iMesh)->getMagnumGLMesh()),  // render mesh
+        meshAttributeFlags,                       // mesh attribute flags
+        node,                                     // scene node
+        creation.lightSetupKey,                   // lightSetup key
+        PER_VERTEX_OBJECT_ID_MATERIAL_KEY,        // material key
+        drawables);                               // drawable group
+    // the objects of a split mesh are culled and hidden separately
+    drawable.setSubmeshes(
+        static_cast<GenericInstanceMeshData&>(*meshes_.at(iMesh))
+            .getObjectSubmeshes());
 
     if (computeAbsoluteAABBs) {
       staticDrawableInfo.emplace_back(StaticDrawableInfo{node, iMesh});
@@ -1072,103 +1547,116 @@ scene::SceneNode* ResourceManager::createRenderAssetInstanceIMesh(
   return instanceRoot;
 }
 
-bool ResourceManager::loadRenderAssetGeneral(const AssetInfo& info) {
-  ASSERT(isRenderAssetGeneral(info.type));
-
-  const std::string& filename = info.filepath;
-  CHECK(resourceDict_.count(filename) == 0);
+void ResourceManager::configureBasisImporter() {
+  if (basisImporterConfigured_) {
+    return;
+  }
+  basisImporterConfigured_ = true;
 
-  // Preferred plugins, Basis target GPU format
-  importerManager_.setPreferredPlugins("GltfImporter", {"TinyGltfImporter"});
-#ifdef ESP_BUILD_ASSIMP_SUPPORT
-  importerManager_.setPreferredPlugins("ObjImporter", {"AssimpImporter"});
-#endif
-  {
-    Cr::PluginManager::PluginMetadata* const metadata =
-        importerManager_.metadata("BasisImporter");
-    Mn::GL::Context& context = Mn::GL::Context::current();
+  // Basis files are transcoded once on load to the best block format the GPU
+  // samples natively, so they stay compressed both in memory and on upload
+  Cr::PluginManager::PluginMetadata* const metadata =
+      importerManager_.metadata("BasisImporter");
+  Mn::GL::Context& context = Mn::GL::Context::current();
 #ifdef MAGNUM_TARGET_WEBGL
-    if (context.isExtensionSupported<
-            Mn::GL::Extensions::WEBGL::compressed_texture_astc>())
+  if (context.isExtensionSupported<
+          Mn::GL::Extensions::WEBGL::compressed_texture_astc>())
 #else
-    if (context.isExtensionSupported<
-            Mn::GL::Extensions::KHR::texture_compression_astc_ldr>())
+  if (context.isExtensionSupported<
+          Mn::GL::Extensions::KHR::texture_compression_astc_ldr>())
 #endif
-    {
-      LOG(INFO) << "Importing Basis files as ASTC 4x4";
-      metadata->configuration().setValue("format", "Astc4x4RGBA");
-    }
+  {
+    LOG(INFO) << "Importing Basis files as ASTC 4x4";
+    metadata->configuration().setValue("format", "Astc4x4RGBA");
+  }
 #ifdef MAGNUM_TARGET_GLES
-    else if (context.isExtensionSupported<
-                 Mn::GL::Extensions::EXT::texture_compression_bptc>())
+  else if (context.isExtensionSupported<
+               Mn::GL::Extensions::EXT::texture_compression_bptc>())
 #else
-    else if (context.isExtensionSupported<
-                 Mn::GL::Extensions::ARB::texture_compression_bptc>())
+  else if (context.isExtensionSupported<
+               Mn::GL::Extensions::ARB::texture_compression_bptc>())
 #endif
-    {
-      LOG(INFO) << "Importing Basis files as BC7";
-      metadata->configuration().setValue("format", "Bc7RGBA");
-    }
+  {
+    LOG(INFO) << "Importing Basis files as BC7";
+    metadata->configuration().setValue("format", "Bc7RGBA");
+  }
 #ifdef MAGNUM_TARGET_WEBGL
-    else if (context.isExtensionSupported<
-                 Mn::GL::Extensions::WEBGL::compressed_texture_s3tc>())
+  else if (context.isExtensionSupported<
+               Mn::GL::Extensions::WEBGL::compressed_texture_s3tc>())
 #elif defined(MAGNUM_TARGET_GLES)
-    else if (context.isExtensionSupported<
-                 Mn::GL::Extensions::EXT::texture_compression_s3tc>() ||
-             context.isExtensionSupported<
-                 Mn::GL::Extensions::ANGLE::texture_compression_dxt5>())
+  else if (context.isExtensionSupported<
+               Mn::GL::Extensions::EXT::texture_compression_s3tc>() ||
+           context.isExtensionSupported<
+               Mn::GL::Extensions::ANGLE::texture_compression_dxt5>())
 #else
-    else if (context.isExtensionSupported<
-                 Mn::GL::Extensions::EXT::texture_compression_s3tc>())
+  else if (context.isExtensionSupported<
+               Mn::GL::Extensions::EXT::texture_compression_s3tc>())
 #endif
-    {
-      LOG(INFO) << "Importing Basis files as BC3";
-      metadata->configuration().setValue("format", "Bc3RGBA");
-    }
+  {
+    LOG(INFO) << "Importing Basis files as BC3";
+    metadata->configuration().setValue("format", "Bc3RGBA");
+  }
 #ifndef MAGNUM_TARGET_GLES2
-    else
+  else
 #ifndef MAGNUM_TARGET_GLES
-        if (context.isExtensionSupported<
-                Mn::GL::Extensions::ARB::ES3_compatibility>())
+      if (context.isExtensionSupported<
+              Mn::GL::Extensions::ARB::ES3_compatibility>())
 #endif
-    {
-      LOG(INFO) << "Importing Basis files as ETC2";
-      metadata->configuration().setValue("format", "Etc2RGBA");
-    }
+  {
+    LOG(INFO) << "Importing Basis files as ETC2";
+    metadata->configuration().setValue("format", "Etc2RGBA");
+  }
 #else /* For ES2, fall back to PVRTC as ETC2 is not available */
-    else
+  else
 #ifdef MAGNUM_TARGET_WEBGL
-        if (context.isExtensionSupported<Mn::WEBGL::compressed_texture_pvrtc>())
+      if (context.isExtensionSupported<Mn::WEBGL::compressed_texture_pvrtc>())
 #else
-        if (context.isExtensionSupported<Mn::IMG::texture_compression_pvrtc>())
+      if (context.isExtensionSupported<Mn::IMG::texture_compression_pvrtc>())
 #endif
-    {
-      LOG(INFO) << "Importing Basis files as PVRTC 4bpp";
-      metadata->configuration().setValue("format", "PvrtcRGBA4bpp");
-    }
+  {
+    LOG(INFO) << "Importing Basis files as PVRTC 4bpp";
+    metadata->configuration().setValue("format", "PvrtcRGBA4bpp");
+  }
 #endif
 #if defined(MAGNUM_TARGET_GLES2) || !defined(MAGNUM_TARGET_GLES)
-    else /* ES3 has ETC2 always */
-    {
-      LOG(WARNING) << "No supported GPU compressed texture format detected, "
-                      "Basis images will get imported as RGBA8";
-      metadata->configuration().setValue("format", "RGBA8");
-    }
-#endif
+  else /* ES3 has ETC2 always */
+  {
+    LOG(WARNING) << "No supported GPU compressed texture format detected, "
+                    "Basis images will get imported as RGBA8";
+    metadata->configuration().setValue("format", "RGBA8");
   }
+#endif
+}  // ResourceManager::configureBasisImporter
+
+bool ResourceManager::loadRenderAssetGeneral(const AssetInfo& info) {
+  ASSERT(isRenderAssetGeneral(info.type));
+
+  const std::string& filename = info.filepath;
+  CHECK(resourceDict_.count(filename) == 0);
+
+  // Preferred plugins
+  importerManager_.setPreferredPlugins("GltfImporter", {"TinyGltfImporter"});
+#ifdef ESP_BUILD_ASSIMP_SUPPORT
+  importerManager_.setPreferredPlugins("ObjImporter", {"AssimpImporter"});
+#endif
+  configureBasisImporter();
 
   if (!fileImporter_->openFile(filename)) {
     LOG(ERROR) << "Cannot open file " << filename;
     return false;
   }
+  core::StartupProfile::addBytesRead(io::fileSize(filename));
+
+  // the meshes and images baked offline, if there is an up-to-date bundle
+  std::unique_ptr<SceneBundle> bundle = openSceneBundle(filename);
 
   // load file and add it to the dictionary
   LoadedAssetData loadedAssetData{info};
   if (requiresTextures_) {
-    loadTextures(*fileImporter_, loadedAssetData);
+    loadTextures(*fileImporter_, loadedAssetData, bundle.get());
     loadMaterials(*fileImporter_, loadedAssetData);
   }
-  loadMeshes(*fileImporter_, loadedAssetData);
+  loadMeshes(*fileImporter_, loadedAssetData, bundle.get());
   auto inserted = resourceDict_.emplace(filename, std::move(loadedAssetData));
   MeshMetaData& meshMetaData = inserted.first->second.meshMetaData;
 
@@ -1213,6 +1701,8 @@ scene::SceneNode* ResourceManager::createRenderAssetInstanceGeneralPrimitive(
 
   CHECK(resourceDict_.count(creation.filepath));
   const LoadedAssetData& loadedAssetData = resourceDict_.at(creation.filepath);
+  // the drawables are set up from the mesh data
+  restoreHostMeshData(creation.filepath);
 
   std::vector<scene::SceneNode*> dummyVisNodeCache;
   auto& visNodeCache = userVisNodeCache ? *userVisNodeCache : dummyVisNodeCache;
@@ -1234,14 +1724,44 @@ scene::SceneNode* ResourceManager::createRenderAssetInstanceGeneralPrimitive(
                                       : scene::SceneNodeType::OBJECT;
   bool computeAbsoluteAABBs = creation.isStatic();
 
-  addComponent(loadedAssetData.meshMetaData,       // mesh metadata
-               newNode,                            // parent scene node
-               creation.lightSetupKey,             // lightSetup key
-               drawables,                          // drawable group
-               loadedAssetData.meshMetaData.root,  // mesh transform node
-               visNodeCache,  // a vector of scene nodes, the visNodeCache
-               computeAbsoluteAABBs,  // compute absolute AABBs
-               staticDrawableInfo);   // a vector of static drawable info
+  const std::vector<MergedStaticMesh>* mergedMeshes = nullptr;
+  if (computeAbsoluteAABBs && mergeStaticMeshes_) {
+    mergedMeshes =
+        bakeStaticLighting_
+            ? &getBakedStaticMeshes(creation.filepath, creation.lightSetupKey,
+                                    newNode.absoluteTransformationMatrix())
+            : &getMergedStaticMeshes(creation.filepath);
+  }
+  if (mergedMeshes && !mergedMeshes->empty()) {
+    // a drawable per merged mesh, in the space of the asset
+    for (const MergedStaticMesh& merged : *mergedMeshes) {
+      scene::SceneNode& node = newNode.createChild();
+      visNodeCache.push_back(&node);
+      gfx::Drawable::Flags meshAttributeFlags = merged.meshAttributeFlags;
+      BaseMesh& mesh = *meshes_.at(merged.meshID);
+      gfx::Drawable& drawable =
+          createDrawable(*mesh.getMagnumGLMesh(),  // render mesh
+                         meshAttributeFlags,       // mesh attribute flags
+                         node,                     // scene node
+                         merged.lightingBaked
+                             ? NO_LIGHT_KEY
+                             : creation.lightSetupKey,  // lightSetup Key
+                         merged.materialKey,            // material key
+                         drawables);                    // drawable group
+      drawable.setSubmeshes(merged.submeshes);
+      staticDrawableInfo.emplace_back(StaticDrawableInfo{node, merged.meshID});
+      node.setMeshBB(mesh.BB);
+    }
+  } else {
+    addComponent(loadedAssetData.meshMetaData,       // mesh metadata
+                 newNode,                            // parent scene node
+                 creation.lightSetupKey,             // lightSetup key
+                 drawables,                          // drawable group
+                 loadedAssetData.meshMetaData.root,  // mesh transform node
+                 visNodeCache,  // a vector of scene nodes, the visNodeCache
+                 computeAbsoluteAABBs,  // compute absolute AABBs
+                 staticDrawableInfo);   // a vector of static drawable info
+  }
 
   if (computeAbsoluteAABBs) {
     // now compute aabbs by constructed staticDrawableInfo
@@ -1258,6 +1778,168 @@ scene::SceneNode* ResourceManager::createRenderAssetInstanceGeneralPrimitive(
   return &newNode;
 }
 
+const std::vector<ResourceManager::MergedStaticMesh>&
+ResourceManager::getMergedStaticMeshes(const std::string& filename) {
+  auto found = mergedStaticMeshes_.find(filename);
+  if (found != mergedStaticMeshes_.end()) {
+    return found->second;
+  }
+  std::vector<MergedStaticMesh>& mergedMeshes = mergedStaticMeshes_[filename];
+
+  const LoadedAssetData& loadedAssetData = resourceDict_.at(filename);
+  std::vector<std::tuple<int, Mn::Matrix4, std::string>> meshes;
+  flattenRenderMeshes(Mn::Matrix4{}, loadedAssetData.meshMetaData,
+                      loadedAssetData.meshMetaData.root, meshes);
+
+  // group the meshes by material and attributes, keeping the draw order
+  // within each group
+  struct Group {
+    std::string materialKey;
+    std::vector<std::pair<const GenericMeshData*, Mn::Matrix4>> meshes;
+  };
+  std::vector<Group> groups;
+  for (const auto& entry : meshes) {
+    auto* mesh = dynamic_cast<const GenericMeshData*>(
+        meshes_.at(std::get<0>(entry)).get());
+    if (!mesh || !mesh->isMergeable()) {
+      LOG(WARNING) << "ResourceManager::getMergedStaticMeshes : the meshes of "
+                   << filename << " can't be merged, drawing them separately";
+      return mergedMeshes;
+    }
+    auto group =
+        std::find_if(groups.begin(), groups.end(), [&](const Group& other) {
+          return other.materialKey == std::get<2>(entry) &&
+                 other.meshes.front().first->hasSameAttributes(*mesh);
+        });
+    if (group == groups.end()) {
+      groups.push_back({std::get<2>(entry), {}});
+      group = groups.end() - 1;
+    }
+    group->meshes.emplace_back(mesh, std::get<1>(entry));
+  }
+
+  for (const Group& group : groups) {
+    auto mergedMesh = std::make_unique<GenericMeshData>(
+        loadedAssetData.assetInfo.requiresLighting);
+    mergedMesh->setCompressVertexFormats(compressVertexFormats_);
+    std::vector<gfx::Drawable::Submesh> submeshes;
+    mergedMesh->setMergedMeshData(group.meshes, submeshes);
+    mergedMesh->BB = computeMeshBB(mergedMesh.get());
+    mergedMesh->uploadBuffersToGPU(false);
+
+    const int meshID = nextMeshID_++;
+    mergedMeshes.push_back({meshID, group.materialKey,
+                            assets::meshAttributeFlags(*mergedMesh),
+                            std::move(submeshes)});
+    meshes_.emplace(meshID, std::move(mergedMesh));
+  }
+  LOG(INFO) << "ResourceManager::getMergedStaticMeshes : merged the "
+            << meshes.size() << " meshes of " << filename << " into "
+            << mergedMeshes.size();
+  return mergedMeshes;
+}
+
+const std::vector<ResourceManager::MergedStaticMesh>&
+ResourceManager::getBakedStaticMeshes(const std::string& filename,
+                                      const std::string& lightSetupKey,
+                                      const Mn::Matrix4& transformation) {
+  const std::vector<MergedStaticMesh>& mergedMeshes =
+      getMergedStaticMeshes(filename);
+  Mn::Resource<gfx::LightSetup> lightSetup = getLightSetup(lightSetupKey);
+  if (mergedMeshes.empty() || !lightSetup ||
+      !gfx::canBakeLighting(*lightSetup)) {
+    return mergedMeshes;
+  }
+  const std::uint64_t lightSetupHash =
+      gfx::bakedLightingHash(*lightSetup, transformation);
+  const auto key = std::make_pair(filename, lightSetupHash);
+  auto found = bakedStaticMeshes_.find(key);
+  if (found != bakedStaticMeshes_.end()) {
+    return found->second;
+  }
+  std::vector<MergedStaticMesh>& bakedMeshes = bakedStaticMeshes_[key];
+
+  int bakedCount = 0;
+  for (std::size_t i = 0; i < mergedMeshes.size(); ++i) {
+    const MergedStaticMesh& merged = mergedMeshes[i];
+    bakedMeshes.push_back(merged);
+    Mn::Resource<gfx::MaterialData> materialData =
+        shaderManager_.get<gfx::MaterialData>(merged.materialKey);
+    if (!materialData || materialData->type != gfx::MaterialDataType::Phong) {
+      continue;
+    }
+    const auto& material =
+        static_cast<const gfx::PhongMaterialData&>(*materialData);
+    const Cr::Containers::Optional<Mn::Trade::MeshData>& meshData =
+        meshes_.at(merged.meshID)->getMeshData();
+    if (!gfx::canBakeLighting(material) || !meshData ||
+        !meshData->hasAttribute(Mn::Trade::MeshAttribute::Normal) ||
+        meshData->hasAttribute(Mn::Trade::MeshAttribute::Color)) {
+      continue;
+    }
+
+    const std::uint64_t lightingHash =
+        gfx::bakedLightingHash(lightSetupHash, material);
+    Cr::Containers::Array<Mn::Color4> colors;
+    if (bakedLightingCache_) {
+      colors = bakedLightingCache_->load(filename, i, lightingHash,
+                                         meshData->vertexCount());
+    }
+    if (colors.empty()) {
+      Cr::Containers::Array<Mn::Vector3> positions =
+          meshData->positions3DAsArray();
+      Cr::Containers::Array<Mn::Vector3> normals = meshData->normalsAsArray();
+      colors = gfx::bakeVertexLighting(
+          *lightSetup, material, transformation,
+          Cr::Containers::arrayView(positions),
+          Cr::Containers::arrayView(normals));
+      if (bakedLightingCache_) {
+        bakedLightingCache_->store(filename, i, lightingHash, colors);
+      }
+    }
+
+    // the baked colors modulate the diffuse texture, with no lights
+    const std::string bakedMaterialKey = merged.materialKey + "_baked";
+    if (!shaderManager_.get<gfx::MaterialData>(bakedMaterialKey)) {
+      auto bakedMaterial = gfx::PhongMaterialData::create_unique();
+      bakedMaterial->ambientColor = Mn::Color4{1.0f};
+      bakedMaterial->diffuseColor = Mn::Color4{0.0f};
+      bakedMaterial->specularColor = Mn::Color4{0.0f};
+      bakedMaterial->ambientTexture = material.diffuseTexture
+                                          ? material.diffuseTexture
+                                          : material.ambientTexture;
+      bakedMaterial->textureMatrix = material.textureMatrix;
+      bakedMaterial->vertexColored = true;
+      bakedMaterial->perVertexObjectId = material.perVertexObjectId;
+      bakedMaterial->doubleSided = material.doubleSided;
+      shaderManager_.set<gfx::MaterialData>(bakedMaterialKey,
+                                            bakedMaterial.release());
+    }
+
+    auto bakedMesh = std::make_unique<GenericMeshData>(false);
+    bakedMesh->setCompressVertexFormats(compressVertexFormats_);
+    bakedMesh->setMeshData(Mn::MeshTools::interleave(
+        *meshData, {Mn::Trade::MeshAttributeData{
+                       Mn::Trade::MeshAttribute::Color,
+                       Cr::Containers::arrayView(colors)}}));
+    bakedMesh->BB = meshes_.at(merged.meshID)->BB;
+    bakedMesh->uploadBuffersToGPU(false);
+    // nothing reads the baked copy on the CPU
+    bakedMesh->releaseHostData();
+
+    MergedStaticMesh& baked = bakedMeshes.back();
+    baked.meshID = nextMeshID_++;
+    baked.materialKey = bakedMaterialKey;
+    baked.lightingBaked = true;
+    meshes_.emplace(baked.meshID, std::move(bakedMesh));
+    ++bakedCount;
+  }
+  LOG(INFO) << "ResourceManager::getBakedStaticMeshes : baked the lighting of "
+            << bakedCount << " of the " << mergedMeshes.size()
+            << " merged meshes of " << filename;
+  return bakedMeshes;
+}
+
 bool ResourceManager::buildTrajectoryVisualization(
     const std::string& trajVisName,
     const std::vector<Mn::Vector3>& pts,
@@ -1279,19 +1961,20 @@ bool ResourceManager::buildTrajectoryVisualization(
     radius = .001;
   }
 
-  LOG(INFO) << "ResourceManager::loadTrajectoryVisualization : Calling "
-               "trajectoryTubeSolid to build a tube named :"
-            << trajVisName << " with " << pts.size()
-            << " points, building a tube of radius :" << radius << " using "
-            << numSegments << " circular segments and " << numInterp
-            << " interpolated points between each trajectory point.";
+  ESP_HOT_LOG(INFO) << "ResourceManager::loadTrajectoryVisualization : "
+                       "Calling trajectoryTubeSolid to build a tube named :"
+                    << trajVisName << " with " << pts.size()
+                    << " points, building a tube of radius :" << radius
+                    << " using " << numSegments << " circular segments and "
+                    << numInterp
+                    << " interpolated points between each trajectory point.";
 
   // create mesh tube
   Cr::Containers::Optional<Mn::Trade::MeshData> trajTubeMesh =
       geo::buildTrajectoryTubeSolid(pts, numSegments, radius, smooth,
                                     numInterp);
-  LOG(INFO) << "ResourceManager::loadTrajectoryVisualization : Successfully "
-               "returned from trajectoryTubeSolid ";
+  ESP_HOT_LOG(INFO) << "ResourceManager::loadTrajectoryVisualization : "
+                       "Successfully returned from trajectoryTubeSolid ";
 
   // make assetInfo
   AssetInfo info{AssetType::PRIMITIVE};
@@ -1306,21 +1989,28 @@ bool ResourceManager::buildTrajectoryVisualization(
   visMeshData->uploadBuffersToGPU(false);
 
   // make MeshMetaData
-  int meshStart = meshes_.size();
+  int meshStart = nextMeshID_++;
   int meshEnd = meshStart;
   MeshMetaData meshMetaData{meshStart, meshEnd};
 
   meshes_.emplace(meshStart, std::move(visMeshData));
 
-  // default material for now
-  auto phongMaterial = gfx::PhongMaterialData::create_unique();
-  phongMaterial->specularColor = {1.0, 1.0, 1.0, 1.0};
-  phongMaterial->ambientColor = color;
-  phongMaterial->diffuseColor = color;
-
-  meshMetaData.setMaterialIndices(nextMaterialID_, nextMaterialID_);
-  shaderManager_.set(std::to_string(nextMaterialID_++),
-                     static_cast<gfx::MaterialData*>(phongMaterial.release()));
+  // trajectories of the same color share their material, so that they are
+  // drawn one after another without rebinding it
+  const std::array<float, 4> colorKey{color.r(), color.g(), color.b(),
+                                      color.a()};
+  auto material = trajectoryMaterials_.find(colorKey);
+  if (material == trajectoryMaterials_.end()) {
+    auto phongMaterial = gfx::PhongMaterialData::create_unique();
+    phongMaterial->specularColor = {1.0, 1.0, 1.0, 1.0};
+    phongMaterial->ambientColor = color;
+    phongMaterial->diffuseColor = color;
+    shaderManager_.set(
+        std::to_string(nextMaterialID_),
+        static_cast<gfx::MaterialData*>(phongMaterial.release()));
+    material = trajectoryMaterials_.emplace(colorKey, nextMaterialID_++).first;
+  }
+  meshMetaData.setMaterialIndices(material->second, material->second);
 
   meshMetaData.root.meshIDLocal = 0;
   meshMetaData.root.componentID = 0;
@@ -1347,7 +2037,8 @@ bool ResourceManager::buildTrajectoryVisualization(
 
 int ResourceManager::loadNavMeshVisualization(esp::nav::PathFinder& pathFinder,
                                               scene::SceneNode* parent,
-                                              DrawableGroup* drawables) {
+                                              DrawableGroup* drawables,
+                                              bool wireframe) {
   int navMeshPrimitiveID = ID_UNDEFINED;
 
   if (!pathFinder.isLoaded())
@@ -1365,21 +2056,25 @@ int ResourceManager::loadNavMeshVisualization(esp::nav::PathFinder& pathFinder,
     positions[vix] = Magnum::Vector3{navMeshData->vbo[vix]};
   }
 
-  indices.resize(navMeshData->ibo.size() * 2);
-  for (size_t ix = 0; ix < navMeshData->ibo.size();
-       ix += 3) {  // for each triangle, create lines
-    size_t nix = ix * 2;
-    indices[nix] = navMeshData->ibo[ix];
-    indices[nix + 1] = navMeshData->ibo[ix + 1];
-    indices[nix + 2] = navMeshData->ibo[ix + 1];
-    indices[nix + 3] = navMeshData->ibo[ix + 2];
-    indices[nix + 4] = navMeshData->ibo[ix + 2];
-    indices[nix + 5] = navMeshData->ibo[ix];
+  if (wireframe) {
+    indices.resize(navMeshData->ibo.size() * 2);
+    for (size_t ix = 0; ix < navMeshData->ibo.size();
+         ix += 3) {  // for each triangle, create lines
+      size_t nix = ix * 2;
+      indices[nix] = navMeshData->ibo[ix];
+      indices[nix + 1] = navMeshData->ibo[ix + 1];
+      indices[nix + 2] = navMeshData->ibo[ix + 1];
+      indices[nix + 3] = navMeshData->ibo[ix + 2];
+      indices[nix + 4] = navMeshData->ibo[ix + 2];
+      indices[nix + 5] = navMeshData->ibo[ix];
+    }
+  } else {
+    indices.assign(navMeshData->ibo.begin(), navMeshData->ibo.end());
   }
 
   // create a temporary mesh object referencing the above data
   Mn::Trade::MeshData visualNavMesh{
-      Mn::MeshPrimitive::Lines,
+      wireframe ? Mn::MeshPrimitive::Lines : Mn::MeshPrimitive::Triangles,
       {},
       indices,
       Mn::Trade::MeshIndexData{indices},
@@ -1621,24 +2316,65 @@ gfx::PbrMaterialData::uptr ResourceManager::buildPbrShadedMaterialData(
 }
 
 void ResourceManager::loadMeshes(Importer& importer,
-                                 LoadedAssetData& loadedAssetData) {
+                                 LoadedAssetData& loadedAssetData,
+                                 const SceneBundle* bundle) {
+  ESP_STARTUP_SPAN("ResourceManager::loadMeshes");
   int meshStart = nextMeshID_;
   int meshEnd = meshStart + importer.meshCount() - 1;
   nextMeshID_ = meshEnd + 1;
   loadedAssetData.meshMetaData.setMeshIndices(meshStart, meshEnd);
 
-  for (int iMesh = 0; iMesh < importer.meshCount(); ++iMesh) {
-    // don't need normals if we aren't using lighting
-    auto gltfMeshData = std::make_unique<GenericMeshData>(
-        loadedAssetData.assetInfo.requiresLighting);
-    gltfMeshData->importAndSetMeshData(importer, iMesh);
-
-    // compute the mesh bounding box
-    gltfMeshData->BB = computeMeshBB(gltfMeshData.get());
+  const std::string& filename = loadedAssetData.assetInfo.filepath;
+  struct ImportedMesh {
+    std::size_t index;
+    // NullOpt if the mesh was loaded from the bundle or the cache
+    Cr::Containers::Optional<Mn::Trade::MeshData> meshData;
+    std::unique_ptr<GenericMeshData> mesh;
+  };
+  pipelineInOrder<ImportedMesh>(
+      loaderThreads(), importer.meshCount(),
+      // Map from the bundle or the cache, or import on the loader thread
+      [&](std::size_t iMesh) {
+        ImportedMesh imported;
+        imported.index = iMesh;
+        // don't need normals if we aren't using lighting
+        imported.mesh = std::make_unique<GenericMeshData>(
+            loadedAssetData.assetInfo.requiresLighting);
+        imported.mesh->setCompressVertexFormats(compressVertexFormats_);
+        if (bundle &&
+            bundle->loadMesh(iMesh, generateMeshLods_, *imported.mesh)) {
+          return imported;
+        }
+        if (meshCache_ && meshCache_->load(filename, iMesh, generateMeshLods_,
+                                           *imported.mesh)) {
+          return imported;
+        }
+        imported.meshData = importer.mesh(iMesh);
+        CORRADE_INTERNAL_ASSERT(imported.meshData);
+        return imported;
+      },
+      // Process the meshes in parallel
+      [&](ImportedMesh& imported) {
+        if (imported.meshData) {
+          imported.mesh->setMeshData(*std::move(imported.meshData));
+          if (generateMeshLods_) {
+            imported.mesh->generateLods();
+          }
+          if (meshCache_) {
+            meshCache_->store(filename, imported.index, *imported.mesh);
+          }
+        }
 
-    gltfMeshData->uploadBuffersToGPU(false);
-    meshes_.emplace(meshStart + iMesh, std::move(gltfMeshData));
-  }
+        // compute the mesh bounding box
+        imported.mesh->BB = computeMeshBB(imported.mesh.get());
+      },
+      // Upload them on the thread owning the context
+      [&](std::size_t iMesh, ImportedMesh& imported) {
+        core::StartupProfile::addTriangles(
+            imported.mesh->getCollisionMeshData().indices.size() / 3);
+        imported.mesh->uploadBuffersToGPU(false);
+        meshes_.emplace(meshStart + iMesh, std::move(imported.mesh));
+      });
 }
 
 //! Recursively load the transformation chain specified by the mesh file
@@ -1681,83 +2417,522 @@ void ResourceManager::loadMeshHierarchy(Importer& importer,
 }
 
 void ResourceManager::loadTextures(Importer& importer,
-                                   LoadedAssetData& loadedAssetData) {
+                                   LoadedAssetData& loadedAssetData,
+                                   const SceneBundle* bundle) {
+  ESP_STARTUP_SPAN("ResourceManager::loadTextures");
   int textureStart = nextTextureID_;
   int textureEnd = textureStart + importer.textureCount() - 1;
   nextTextureID_ = textureEnd + 1;
   loadedAssetData.meshMetaData.setTextureIndices(textureStart, textureEnd);
 
-  for (int iTexture = 0; iTexture < importer.textureCount(); ++iTexture) {
-    auto currentTextureID = textureStart + iTexture;
-    textures_.emplace(currentTextureID,
-                      std::make_shared<Magnum::GL::Texture2D>());
-    auto& currentTexture = textures_.at(currentTextureID);
-
-    auto textureData = importer.texture(iTexture);
-    if (!textureData ||
-        textureData->type() != Magnum::Trade::TextureData::Type::Texture2D) {
-      LOG(ERROR) << "Cannot load texture " << iTexture << " skipping";
-      currentTexture = nullptr;
-      continue;
+  Mn::Resource<gfx::TextureStreamer> textureStreamer =
+      shaderManager_.get<gfx::TextureStreamer>(gfx::TextureStreamer::Key);
+  // resources aren't thread-safe, query it here
+  const bool streamTextures = bool(textureStreamer);
+  const bool compressTextures = canCompressTextures();
+
+  struct DecodedTexture {
+    Cr::Containers::Optional<Mn::Trade::TextureData> textureData;
+    // all mip levels, empty if one failed to load
+    std::vector<Mn::Trade::ImageData2D> levels;
+    // the file of the image if it failed because it's not downloaded yet
+    std::string pendingFile;
+  };
+  pipelineInOrder<DecodedTexture>(
+      loaderThreads(), importer.textureCount(),
+      // Map or decode all mip levels on the loader thread
+      [this, &importer, bundle](std::size_t iTexture) {
+        DecodedTexture decoded;
+        decoded.textureData = importer.texture(iTexture);
+        if (!decoded.textureData ||
+            decoded.textureData->type() !=
+                Mn::Trade::TextureData::Type::Texture2D) {
+          return decoded;
+        }
+        const Mn::UnsignedInt imageId = decoded.textureData->image();
+        if (bundle && bundle->loadImage(imageId, decoded.levels)) {
+          return decoded;
+        }
+        lastPendingFile_.clear();
+        const Mn::UnsignedInt levelCount = importer.image2DLevelCount(imageId);
+        for (Mn::UnsignedInt level = 0; level != levelCount; ++level) {
+          Cr::Containers::Optional<Mn::Trade::ImageData2D> image =
+              importer.image2D(imageId, level);
+          if (!image) {
+            decoded.levels.clear();
+            decoded.pendingFile = lastPendingFile_;
+            break;
+          }
+          decoded.levels.push_back(std::move(*image));
+        }
+        return decoded;
+      },
+      // The streamer keeps all mip levels on the CPU, generate them in
+      // parallel, and compress them in parallel too
+      [this, streamTextures, compressTextures](DecodedTexture& decoded) {
+        if (compressTextures) {
+          compressTextureLevels(decoded.levels);
+        }
+        if (streamTextures && decoded.levels.size() == 1 &&
+            !decoded.levels[0].isCompressed()) {
+          decoded.levels = gfx::TextureStreamer::generateMipLevels(
+              std::move(decoded.levels[0]));
+        }
+      },
+      // Upload them in order on the thread owning the context
+      [&](std::size_t iTexture, DecodedTexture& decoded) {
+        auto currentTextureID = textureStart + iTexture;
+        textures_.emplace(currentTextureID,
+                          std::make_shared<Magnum::GL::Texture2D>());
+        auto& currentTexture = textures_.at(currentTextureID);
+
+        const Cr::Containers::Optional<Mn::Trade::TextureData>& textureData =
+            decoded.textureData;
+        if (!textureData || textureData->type() !=
+                                Magnum::Trade::TextureData::Type::Texture2D) {
+          LOG(ERROR) << "Cannot load texture " << iTexture << " skipping";
+          currentTexture = nullptr;
+          return;
+        }
+        std::vector<Mn::Trade::ImageData2D>& levels = decoded.levels;
+        if (levels.empty() && decoded.pendingFile.empty()) {
+          LOG(ERROR) << "Cannot load texture image, skipping";
+          currentTexture = nullptr;
+          return;
+        }
+
+        // Configure the texture
+        Mn::GL::Texture2D& texture = *currentTexture;
+        texture.setMagnificationFilter(textureData->magnificationFilter())
+            .setMinificationFilter(textureData->minificationFilter(),
+                                   textureData->mipmapFilter())
+            .setWrapping(textureData->wrapping().xy());
+
+        // Drawn with a gray pixel until the image arrives, with mutable
+        // storage that the upload replaces
+        if (levels.empty()) {
+          const Mn::Color4ub placeholder{128, 128, 128, 255};
+          texture
+              .setMinificationFilter(textureData->minificationFilter(),
+                                     Mn::SamplerMipmap::Base)
+              .setImage(0, Mn::GL::TextureFormat::RGBA8,
+                        Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm,
+                                        {1, 1},
+                                        {&placeholder, sizeof(placeholder)}});
+          pendingTextures_.push_back({currentTexture, decoded.pendingFile,
+                                      textureData->minificationFilter(),
+                                      textureData->mipmapFilter()});
+          return;
+        }
+
+        // a third more for the mip chain generated from a single level, see
+        // setAssetCacheBudget()
+        std::size_t& textureBytes = textureBytes_[currentTextureID];
+        for (const Mn::Trade::ImageData2D& level : levels) {
+          textureBytes += level.data().size();
+        }
+        if (levels.size() == 1 && !levels[0].isCompressed()) {
+          textureBytes += textureBytes / 3;
+        }
+        uploadTextureLevels(texture, std::move(levels));
+      });
+}  // ResourceManager::loadTextures
+
+void ResourceManager::uploadTextureLevels(
+    Mn::GL::Texture2D& texture,
+    std::vector<Mn::Trade::ImageData2D>&& levels) {
+  Mn::Resource<gfx::TextureStreamer> textureStreamer =
+      shaderManager_.get<gfx::TextureStreamer>(gfx::TextureStreamer::Key);
+  const bool streamTextures = bool(textureStreamer);
+
+  Mn::GL::TextureFormat format;
+  if (levels[0].isCompressed()) {
+    format = Mn::GL::textureFormat(levels[0].compressedFormat());
+  } else {
+    format = Mn::GL::textureFormat(levels[0].format());
+  }
+
+  // A single uncompressed level larger than 1x1 is a format the streamer
+  // can't filter, it's uploaded eagerly
+  if (streamTextures &&
+      (levels.size() > 1 || levels[0].isCompressed() ||
+       levels[0].size() == Mn::Vector2i{1})) {
+    textureStreamer->addTexture(texture, format, std::move(levels));
+    return;
+  }
+
+  // If there is just one level and the image is not compressed, we'll
+  // generate mips ourselves
+  const bool generateMipmap = levels.size() == 1 && !levels[0].isCompressed();
+  if (generateMipmap) {
+    texture.setStorage(Mn::Math::log2(levels[0].size().max()) + 1, format,
+                       levels[0].size());
+  } else {
+    texture.setStorage(levels.size(), format, levels[0].size());
+  }
+
+  // Load all mip levels
+  std::size_t textureBytes = 0;
+  for (std::size_t level = 0; level != levels.size(); ++level) {
+    if (levels[level].isCompressed())
+      texture.setCompressedSubImage(level, {}, levels[level]);
+    else
+      texture.setSubImage(level, {}, levels[level]);
+    textureBytes += levels[level].data().size();
+  }
+  core::StartupProfile::addTexture(textureBytes);
+
+  // Generate a mipmap if requested
+  if (generateMipmap)
+    texture.generateMipmap();
+}  // ResourceManager::uploadTextureLevels
+
+bool ResourceManager::canCompressTextures() const {
+  if (!compressTextures_ || !Mn::GL::Context::hasCurrent()) {
+    return false;
+  }
+#ifdef MAGNUM_TARGET_WEBGL
+  return Mn::GL::Context::current()
+      .isExtensionSupported<
+          Mn::GL::Extensions::WEBGL::compressed_texture_s3tc>();
+#else
+  return Mn::GL::Context::current()
+      .isExtensionSupported<
+          Mn::GL::Extensions::EXT::texture_compression_s3tc>();
+#endif
+}
+
+void ResourceManager::compressTextureLevels(
+    std::vector<Mn::Trade::ImageData2D>& levels) const {
+  if (levels.empty()) {
+    return;
+  }
+  for (const Mn::Trade::ImageData2D& level : levels) {
+    if (level.isCompressed() || level.format() != levels[0].format() ||
+        !gfx::isTextureCompressible(level.format())) {
+      return;
+    }
+  }
+
+  const std::uint64_t sourceHash =
+      CompressedTextureCache::sourceHash(levels[0], levels.size());
+  if (compressedTextureCache_) {
+    std::vector<Mn::Trade::ImageData2D> cached =
+        compressedTextureCache_->load(sourceHash);
+    if (!cached.empty()) {
+      levels = std::move(cached);
+      return;
     }
+  }
 
-    // Configure the texture
-    Mn::GL::Texture2D& texture = *(textures_.at(textureStart + iTexture).get());
-    texture.setMagnificationFilter(textureData->magnificationFilter())
-        .setMinificationFilter(textureData->minificationFilter(),
-                               textureData->mipmapFilter())
-        .setWrapping(textureData->wrapping().xy());
-
-    // Load all mip levels
-    const std::uint32_t levelCount =
-        importer.image2DLevelCount(textureData->image());
-    bool generateMipmap = false;
-    for (std::uint32_t level = 0; level != levelCount; ++level) {
-      // TODO:
-      // it seems we have a way to just load the image once in this case,
-      // as long as the image2DName include the full path to the image
-      Cr::Containers::Optional<Mn::Trade::ImageData2D> image =
-          importer.image2D(textureData->image(), level);
-      if (!image) {
-        LOG(ERROR) << "Cannot load texture image, skipping";
-        currentTexture = nullptr;
-        break;
-      }
+  // compressed textures can't generate their mip levels on the GPU
+  if (levels.size() == 1) {
+    levels = gfx::TextureStreamer::generateMipLevels(std::move(levels[0]));
+  }
+  // all levels in the format of the first, BC3 if any of them has alpha
+  std::vector<Mn::Trade::ImageData2D> compressed;
+  compressed.reserve(levels.size());
+  for (const Mn::Trade::ImageData2D& level : levels) {
+    const bool forceAlpha = !compressed.empty() &&
+                            compressed[0].compressedFormat() ==
+                                Mn::CompressedPixelFormat::Bc3RGBAUnorm;
+    compressed.push_back(gfx::compressTextureImage(level, forceAlpha));
+  }
+  if (compressedTextureCache_) {
+    compressedTextureCache_->store(sourceHash, compressed);
+  }
+  levels = std::move(compressed);
+}  // ResourceManager::compressTextureLevels
 
-      Mn::GL::TextureFormat format;
-      if (image->isCompressed()) {
-        format = Mn::GL::textureFormat(image->compressedFormat());
-      } else {
-        format = Mn::GL::textureFormat(image->format());
-      }
+core::ThreadPool& ResourceManager::loaderThreads() {
+  if (!loaderThreads_) {
+    loaderThreads_ = std::make_unique<core::ThreadPool>();
+  }
+  return *loaderThreads_;
+}
 
-      // For the very first level, allocate the texture
-      if (level == 0) {
-        // If there is just one level and the image is not compressed, we'll
-        // generate mips ourselves
-        if (levelCount == 1 && !image->isCompressed()) {
-          texture.setStorage(Mn::Math::log2(image->size().max()) + 1, format,
-                             image->size());
-          generateMipmap = true;
-        } else
-          texture.setStorage(levelCount, format, image->size());
-      }
+void ResourceManager::setMeshCacheDirectory(const std::string& directory) {
+  if (directory.empty()) {
+    meshCache_ = nullptr;
+  } else if (!meshCache_ || meshCache_->directory() != directory) {
+    meshCache_ = std::make_unique<MeshCache>(directory);
+  }
+}
+
+void ResourceManager::setBakedLightingCacheDirectory(
+    const std::string& directory) {
+  if (directory.empty()) {
+    bakedLightingCache_ = nullptr;
+  } else if (!bakedLightingCache_ ||
+             bakedLightingCache_->directory() != directory) {
+    bakedLightingCache_ = std::make_unique<BakedLightingCache>(directory);
+  }
+}
+
+void ResourceManager::setCompressedTextureCacheDirectory(
+    const std::string& directory) {
+  if (directory.empty()) {
+    compressedTextureCache_ = nullptr;
+  } else if (!compressedTextureCache_ ||
+             compressedTextureCache_->directory() != directory) {
+    compressedTextureCache_ =
+        std::make_unique<CompressedTextureCache>(directory);
+  }
+}
+
+void ResourceManager::setPTexConversionDirectory(const std::string& directory,
+                                                 int tileResolution) {
+  if (!directory.empty() && !Cr::Utility::Directory::mkpath(directory)) {
+    LOG(WARNING) << "ResourceManager::setPTexConversionDirectory : cannot "
+                    "create "
+                 << directory << ", PTex stages won't be converted";
+    ptexConversionDirectory_.clear();
+    return;
+  }
+  ptexConversionDirectory_ = directory;
+  ptexTileResolution_ = tileResolution;
+}
+
+std::string ResourceManager::convertedPTexMesh(const std::string& meshFile) {
+#ifdef ESP_BUILD_PTEX_SUPPORT
+  // the meshes of PTex datasets are all named mesh.ply, so named after their
+  // folder and the hash of their path
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx",
+                static_cast<unsigned long long>(
+                    core::hashBytes({meshFile.data(), meshFile.size()})));
+  const std::string gltfFile = Cr::Utility::Directory::join(
+      ptexConversionDirectory_,
+      Cr::Utility::Directory::filename(
+          Cr::Utility::Directory::path(meshFile)) +
+          "." + hash + ".gltf");
+  if (PTexMeshData::isGltfConversionCurrent(meshFile, gltfFile,
+                                            ptexTileResolution_)) {
+    return gltfFile;
+  }
+  LOG(INFO) << "ResourceManager::convertedPTexMesh : Converting " << meshFile
+            << " to " << gltfFile;
+  PTexMeshData pTexMeshData;
+  pTexMeshData.load(meshFile,
+                    Cr::Utility::Directory::join(
+                        Cr::Utility::Directory::path(meshFile), "textures"));
+  if (pTexMeshData.convertToGltf(gltfFile, ptexTileResolution_)) {
+    return gltfFile;
+  }
+  LOG(WARNING) << "ResourceManager::convertedPTexMesh : Converting "
+               << meshFile << " failed, drawing it with the PTex shader";
+#endif
+  return {};
+}
+
+void ResourceManager::setShaderCacheDirectory(const std::string& directory) {
+  Mn::Resource<gfx::ProgramBinaryCache> binaryCache =
+      shaderManager_.get<gfx::ProgramBinaryCache>(gfx::ProgramBinaryCache::Key);
+  if (binaryCache) {
+    if (binaryCache->directory() != directory) {
+      binaryCache->setDirectory(directory);
+    }
+    return;
+  }
+  if (!directory.empty()) {
+    shaderManager_.set<gfx::ProgramBinaryCache>(
+        gfx::ProgramBinaryCache::Key, new gfx::ProgramBinaryCache{directory},
+        Mn::ResourceDataState::Final, Mn::ResourcePolicy::Resident);
+  }
+}
+
+void ResourceManager::setImageBasedLightingCacheDirectory(
+    const std::string& directory) {
+  if (!directory.empty() && !Cr::Utility::Directory::mkpath(directory)) {
+    LOG(WARNING) << "ResourceManager::setImageBasedLightingCacheDirectory : "
+                    "cannot create "
+                 << directory << ", the image based lighting won't be cached";
+    imageBasedLightingCacheDirectory_.clear();
+    return;
+  }
+  imageBasedLightingCacheDirectory_ = directory;
+}
+
+void ResourceManager::loadImageBasedLighting(scene::SceneGraph& sceneGraph,
+                                             const Mn::Vector3& position,
+                                             const std::string& cacheKey) {
+  // the capture must not reflect the previous environment
+  removeImageBasedLighting();
+
+  std::string filename;
+  if (!imageBasedLightingCacheDirectory_.empty()) {
+    std::string key = cacheKey;
+    key.append(reinterpret_cast<const char*>(position.data()),
+               sizeof(position));
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(
+                      core::hashBytes({key.data(), key.size()})));
+    filename = Cr::Utility::Directory::join(imageBasedLightingCacheDirectory_,
+                                            std::string{hash} + ".ibl");
+  }
+
+  gfx::PbrImageBasedLighting::uptr lighting;
+  if (!filename.empty()) {
+    lighting = gfx::PbrImageBasedLighting::load(filename);
+  }
+  if (!lighting) {
+    ESP_STARTUP_SPAN("ResourceManager::loadImageBasedLighting");
+    constexpr int EnvironmentSize = 256;
+    gfx::CubeMap environment{EnvironmentSize};
+    gfx::CubeMapCamera& camera = sceneGraph.getDefaultCubeMapCamera();
+    camera.node().setTransformation(Mn::Matrix4::translation(position));
+    camera.updateOriginalViewingMatrix().setProjectionMatrix(EnvironmentSize,
+                                                             0.01f, 1000.0f);
+    environment.renderToTexture(camera, sceneGraph);
+    lighting = gfx::PbrImageBasedLighting::create_unique(environment);
+    if (!filename.empty() && !lighting->store(filename)) {
+      LOG(WARNING) << "ResourceManager::loadImageBasedLighting : cannot "
+                      "write "
+                   << filename;
+    }
+  }
+
+  // mutable, so that another environment can replace it
+  shaderManager_.set<gfx::PbrImageBasedLighting>(
+      gfx::PbrImageBasedLighting::Key, lighting.release(),
+      Mn::ResourceDataState::Mutable, Mn::ResourcePolicy::Resident);
+}
 
-      if (image->isCompressed())
-        texture.setCompressedSubImage(level, {}, *image);
-      else
-        texture.setSubImage(level, {}, *image);
+void ResourceManager::removeImageBasedLighting() {
+  if (shaderManager_.state<gfx::PbrImageBasedLighting>(
+          gfx::PbrImageBasedLighting::Key) == Mn::ResourceState::Mutable) {
+    shaderManager_.set<gfx::PbrImageBasedLighting>(
+        gfx::PbrImageBasedLighting::Key, nullptr,
+        Mn::ResourceDataState::NotFound, Mn::ResourcePolicy::Resident);
+  }
+}
+
+void ResourceManager::setTextureMemoryBudget(std::size_t budgetBytes) {
+  Mn::Resource<gfx::TextureStreamer> textureStreamer =
+      shaderManager_.get<gfx::TextureStreamer>(gfx::TextureStreamer::Key);
+  if (textureStreamer) {
+    textureStreamer->setBudget(budgetBytes);
+    return;
+  }
+  shaderManager_.set<gfx::TextureStreamer>(
+      gfx::TextureStreamer::Key, new gfx::TextureStreamer{budgetBytes},
+      Mn::ResourceDataState::Final, Mn::ResourcePolicy::Resident);
+}
+
+gfx::TextureStreamer* ResourceManager::getTextureStreamer() {
+  Mn::Resource<gfx::TextureStreamer> textureStreamer =
+      shaderManager_.get<gfx::TextureStreamer>(gfx::TextureStreamer::Key);
+  return textureStreamer ? &*textureStreamer : nullptr;
+}
+
+void ResourceManager::setFileProvider(std::shared_ptr<FileProvider> provider) {
+  fileProvider_ = std::move(provider);
+  if (fileProvider_) {
+    fileImporter_->setFileCallback(&provideFile, *this);
+  } else {
+    fileImporter_->setFileCallback(nullptr);
+  }
+}
+
+Cr::Containers::Optional<Cr::Containers::ArrayView<const char>>
+ResourceManager::provideFile(const std::string& filename,
+                             Mn::InputFileCallbackPolicy policy,
+                             ResourceManager& resourceManager) {
+  FileProvider& provider = *resourceManager.fileProvider_;
+  if (policy == Mn::InputFileCallbackPolicy::Close) {
+    provider.release(filename);
+    resourceManager.localFiles_.erase(filename);
+    return {};
+  }
+
+  switch (provider.request(filename)) {
+    case FileProvider::Status::Available: {
+      const Cr::Containers::ArrayView<const char> data =
+          provider.data(filename);
+      core::StartupProfile::addBytesRead(data.size());
+      return data;
+    }
+    case FileProvider::Status::Pending:
+      resourceManager.lastPendingFile_ = filename;
+      return {};
+    case FileProvider::Status::Unavailable:
+      break;
+  }
+
+  auto found = resourceManager.localFiles_.find(filename);
+  if (found == resourceManager.localFiles_.end()) {
+    if (!Cr::Utility::Directory::exists(filename)) {
+      return {};
     }
+    found = resourceManager.localFiles_
+                .emplace(filename, Cr::Utility::Directory::read(filename))
+                .first;
+  }
+  return Cr::Containers::ArrayView<const char>{found->second};
+}
 
-    // Mip level loading failed, fail the whole texture
-    if (currentTexture == nullptr)
+int ResourceManager::loadStreamedFiles() {
+  if (pendingTextures_.empty()) {
+    return 0;
+  }
+  ESP_PROFILE_SCOPE("ResourceManager::loadStreamedFiles");
+  Mn::Resource<gfx::TextureStreamer> textureStreamer =
+      shaderManager_.get<gfx::TextureStreamer>(gfx::TextureStreamer::Key);
+
+  Cr::Containers::Pointer<Importer> imageImporter;
+  int numLoaded = 0;
+  for (auto it = pendingTextures_.begin(); it != pendingTextures_.end();) {
+    if (fileProvider_ &&
+        fileProvider_->request(it->filename) == FileProvider::Status::Pending) {
+      ++it;
       continue;
+    }
+
+    if (!imageImporter) {
+      CORRADE_INTERNAL_ASSERT_OUTPUT(
+          imageImporter =
+              importerManager_.loadAndInstantiate("AnyImageImporter"));
+      if (fileProvider_) {
+        imageImporter->setFileCallback(&provideFile, *this);
+      }
+    }
+    std::vector<Mn::Trade::ImageData2D> levels;
+    if (imageImporter->openFile(it->filename)) {
+      const Mn::UnsignedInt levelCount = imageImporter->image2DLevelCount(0);
+      for (Mn::UnsignedInt level = 0; level != levelCount; ++level) {
+        Cr::Containers::Optional<Mn::Trade::ImageData2D> image =
+            imageImporter->image2D(0, level);
+        if (!image) {
+          levels.clear();
+          break;
+        }
+        levels.push_back(std::move(*image));
+      }
+      imageImporter->close();
+    }
 
-    // Generate a mipmap if requested
-    if (generateMipmap)
-      texture.generateMipmap();
+    if (levels.empty()) {
+      LOG(ERROR) << "ResourceManager::loadStreamedFiles : Cannot load image "
+                 << it->filename << ", keeping the placeholder";
+    } else {
+      // same as the texture would have been set up in loadTextures()
+      if (canCompressTextures()) {
+        compressTextureLevels(levels);
+      }
+      if (textureStreamer && levels.size() == 1 &&
+          !levels[0].isCompressed()) {
+        levels = gfx::TextureStreamer::generateMipLevels(std::move(levels[0]));
+      }
+      it->texture->setMinificationFilter(it->minificationFilter,
+                                         it->mipmapFilter);
+      uploadTextureLevels(*it->texture, std::move(levels));
+      ++numLoaded;
+    }
+    it = pendingTextures_.erase(it);
   }
-}  // ResourceManager::loadTextures
+  return numLoaded;
+}
 
 bool ResourceManager::instantiateAssetsOnDemand(
     const std::string& objectTemplateHandle) {
@@ -1846,13 +3021,49 @@ bool ResourceManager::instantiateAssetsOnDemand(
       }
       collisionMeshGroups_.emplace(collisionAssetHandle, meshGroup);
     }
+    if (ObjectAttributes->getUseConvexDecomposition() &&
+        convexDecompositions_.count(collisionAssetHandle) == 0) {
+      buildConvexDecomposition(collisionAssetHandle);
+    }
   }
 
   return true;
 }  // ResourceManager::instantiateAssetsOnDemand
 
+void ResourceManager::buildConvexDecomposition(
+    const std::string& collisionAssetHandle) {
+  std::vector<std::vector<Mn::Vector3>>& hulls =
+      convexDecompositions_[collisionAssetHandle];
+#ifdef ESP_BUILD_WITH_BULLET
+  const std::string filename =
+      Cr::Utility::Directory::splitExtension(collisionAssetHandle).first +
+      ".hulls";
+  if (physics::loadConvexDecomposition(filename, hulls)) {
+    return;
+  }
+
+  std::vector<Mn::Vector3> positions;
+  std::vector<Mn::UnsignedInt> indices;
+  flattenCollisionMeshes(Mn::Matrix4{}, getCollisionMesh(collisionAssetHandle),
+                         getMeshMetaData(collisionAssetHandle).root, positions,
+                         indices);
+  hulls = physics::decomposeConvex(positions, indices);
+  LOG(INFO) << "ResourceManager::buildConvexDecomposition : decomposed "
+            << collisionAssetHandle << " into " << hulls.size() << " hulls";
+  if (!physics::saveConvexDecomposition(hulls, filename)) {
+    LOG(WARNING) << "ResourceManager::buildConvexDecomposition : cannot "
+                    "cache the decomposition in "
+                 << filename;
+  }
+#else
+  LOG(WARNING) << "ResourceManager::buildConvexDecomposition : convex "
+                  "decompositions need Bullet, "
+               << collisionAssetHandle << " keeps its collision meshes";
+#endif
+}  // ResourceManager::buildConvexDecomposition
+
 void ResourceManager::addObjectToDrawables(
-    const ObjectAttributes::ptr& ObjectAttributes,
+    const ObjectAttributes::cptr& ObjectAttributes,
     scene::SceneNode* parent,
     DrawableGroup* drawables,
     std::vector<scene::SceneNode*>& visNodeCache,
@@ -1906,24 +3117,32 @@ void ResourceManager::addComponent(
           std::to_string(metaData.materialIndex.first + materialIDLocal);
     }
 
-    gfx::Drawable::Flags meshAttributeFlags{};
-    const auto& meshData = meshes_.at(meshID)->getMeshData();
-    if (meshData != Cr::Containers::NullOpt) {
-      if (meshData->hasAttribute(Mn::Trade::MeshAttribute::Tangent)) {
-        meshAttributeFlags |= gfx::Drawable::Flag::HasTangent;
-
-        // if it has tangent, then check if it has bitangent
-        if (meshData->hasAttribute(Mn::Trade::MeshAttribute::Bitangent)) {
-          meshAttributeFlags |= gfx::Drawable::Flag::HasSeparateBitangent;
-        }
+    gfx::Drawable::Flags meshAttributeFlags =
+        assets::meshAttributeFlags(*meshes_.at(meshID));
+    gfx::Drawable& drawable =
+        createDrawable(mesh,                // render mesh
+                       meshAttributeFlags,  // mesh attribute flags
+                       node,                // scene node
+                       lightSetupKey,       // lightSetup Key
+                       materialKey,         // material key
+                       drawables);          // drawable group
+
+    // coarser levels of detail, if generated by loadMeshes()
+    if (auto* genericMesh =
+            dynamic_cast<GenericMeshData*>(meshes_.at(meshID).get())) {
+      std::vector<gfx::Drawable::Lod> lods;
+      for (auto& lod : genericMesh->getRenderingBuffer()->lods) {
+        lods.push_back({&lod.mesh, lod.error});
       }
+      drawable.setLods(std::move(lods));
+    }
+
+    // objects are typically instantiated many times from the same template;
+    // let the group batch copies sharing mesh and material into instanced
+    // draws
+    if (!computeAbsoluteAABBs && drawables != nullptr) {
+      drawables->setInstancingEnabled(true);
     }
-    createDrawable(mesh,                // render mesh
-                   meshAttributeFlags,  // mesh attribute flags
-                   node,                // scene node
-                   lightSetupKey,       // lightSetup Key
-                   materialKey,         // material key
-                   drawables);          // drawable group
 
     // compute the bounding box for the mesh we are adding
     if (computeAbsoluteAABBs) {
@@ -1961,6 +3180,11 @@ void ResourceManager::addPrimitiveToDrawables(int primitiveID,
                  NO_LIGHT_KEY,                        // lightSetup key
                  WHITE_MATERIAL_KEY,                  // material key
                  drawables);                          // drawable group
+  // e.g. the bounding boxes of many objects, all drawing the same unlit
+  // mesh, are batched into one instanced draw
+  if (drawables != nullptr) {
+    drawables->setInstancingEnabled(true);
+  }
 }
 
 void ResourceManager::removePrimitiveMesh(int primitiveID) {
@@ -1968,37 +3192,36 @@ void ResourceManager::removePrimitiveMesh(int primitiveID) {
   primitive_meshes_.erase(primitiveID);
 }
 
-void ResourceManager::createDrawable(Mn::GL::Mesh& mesh,
-                                     gfx::Drawable::Flags& meshAttributeFlags,
-                                     scene::SceneNode& node,
-                                     const Mn::ResourceKey& lightSetupKey,
-                                     const Mn::ResourceKey& materialKey,
-                                     DrawableGroup* group /* = nullptr */) {
+gfx::Drawable& ResourceManager::createDrawable(
+    Mn::GL::Mesh& mesh,
+    gfx::Drawable::Flags& meshAttributeFlags,
+    scene::SceneNode& node,
+    const Mn::ResourceKey& lightSetupKey,
+    const Mn::ResourceKey& materialKey,
+    DrawableGroup* group /* = nullptr */) {
   const auto& materialDataType =
       shaderManager_.get<gfx::MaterialData>(materialKey)->type;
   switch (materialDataType) {
     case gfx::MaterialDataType::None:
-      CORRADE_INTERNAL_ASSERT_UNREACHABLE();
       break;
     case gfx::MaterialDataType::Phong:
-      node.addFeature<gfx::GenericDrawable>(
+      return node.addFeature<gfx::GenericDrawable>(
           mesh,                // render mesh
           meshAttributeFlags,  // mesh attribute flags
           shaderManager_,      // shader manager
           lightSetupKey,       // lightSetup key
           materialKey,         // material key
           group);              // drawable group
-      break;
     case gfx::MaterialDataType::Pbr:
-      node.addFeature<gfx::PbrDrawable>(
+      return node.addFeature<gfx::PbrDrawable>(
           mesh,                // render mesh
           meshAttributeFlags,  // mesh attribute flags
           shaderManager_,      // shader manager
           lightSetupKey,       // lightSetup key
           materialKey,         // material key
           group);              // drawable group
-      break;
   }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
 }
 
 bool ResourceManager::loadSUNCGHouseFile(const AssetInfo& houseInfo,
@@ -2136,42 +3359,510 @@ void ResourceManager::joinHeirarchy(
     MeshData& mesh,
     const MeshMetaData& metaData,
     const MeshTransformNode& node,
-    const Magnum::Matrix4& transformFromParentToWorld) {
+    const Magnum::Matrix4& transformFromParentToWorld,
+    const std::vector<geo::SimplifiedMesh>* simplified) {
   Magnum::Matrix4 transformFromLocalToWorld =
       transformFromParentToWorld * node.transformFromLocalToParent;
 
   if (node.meshIDLocal != ID_UNDEFINED) {
-    CollisionMeshData& meshData =
-        meshes_.at(node.meshIDLocal + metaData.meshIndex.first)
-            ->getCollisionMeshData();
+    Cr::Containers::ArrayView<const Mn::Vector3> positions;
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices;
+    if (simplified) {
+      const geo::SimplifiedMesh& meshData = (*simplified)[node.meshIDLocal];
+      positions = {meshData.positions.data(), meshData.positions.size()};
+      indices = {meshData.indices.data(), meshData.indices.size()};
+    } else {
+      CollisionMeshData& meshData =
+          meshes_.at(node.meshIDLocal + metaData.meshIndex.first)
+              ->getCollisionMeshData();
+      positions = meshData.positions;
+      indices = meshData.indices;
+    }
     int lastIndex = mesh.vbo.size();
-    for (auto& pos : meshData.positions) {
+    for (auto& pos : positions) {
       mesh.vbo.push_back(Magnum::EigenIntegration::cast<vec3f>(
           transformFromLocalToWorld.transformPoint(pos)));
     }
-    for (auto& index : meshData.indices) {
+    for (auto& index : indices) {
       mesh.ibo.push_back(index + lastIndex);
     }
   }
 
   for (auto& child : node.children) {
-    joinHeirarchy(mesh, metaData, child, transformFromLocalToWorld);
+    joinHeirarchy(mesh, metaData, child, transformFromLocalToWorld,
+                  simplified);
   }
 }
 
 std::unique_ptr<MeshData> ResourceManager::createJoinedCollisionMesh(
     const std::string& filename) {
-  std::unique_ptr<MeshData> mesh = std::make_unique<MeshData>();
+  return std::make_unique<MeshData>(*getJoinedCollisionMesh(filename));
+}
+
+MeshData::cptr ResourceManager::getJoinedCollisionMesh(
+    const std::string& filename) {
+  auto found = joinedCollisionMeshes_.find(filename);
+  if (found != joinedCollisionMeshes_.end()) {
+    return found->second;
+  }
 
   CHECK(resourceDict_.count(filename) > 0);
 
   const MeshMetaData& metaData = getMeshMetaData(filename);
+  MeshData::ptr mesh = MeshData::create();
 
+  // the simplified meshes don't need the meshes, released meshes are re-read
+  // for as long as they're needed otherwise
+  const std::vector<geo::SimplifiedMesh>* simplified =
+      findSimplifiedCollision(filename);
+  const bool restored = !simplified && restoreHostMeshData(filename);
   Magnum::Matrix4 identity;
-  joinHeirarchy(*mesh, metaData, metaData.root, identity);
+  joinHeirarchy(*mesh, metaData, metaData.root, identity, simplified);
+  if (restored) {
+    // kept released, which is what the memory was freed for
+    releaseHostMeshData(filename);
+    return mesh;
+  }
 
+  joinedCollisionMeshes_.emplace(filename, mesh);
+  measureAsset(filename, false);
   return mesh;
 }
 
+int ResourceManager::releaseHostMeshData(const std::string& filename) {
+  auto found = resourceDict_.find(filename);
+  // the collision meshes of the other paths of the same contents reference
+  // the data too, see loadSharedRenderAsset()
+  if (found == resourceDict_.end() || findAssetSharingMeshes(filename)) {
+    return 0;
+  }
+  // the mesh groups reference the collision data, the joined mesh is freed
+  // too
+  collisionMeshGroups_.erase(filename);
+  const bool joinedFreed = joinedCollisionMeshes_.erase(filename);
+  const std::pair<int, int>& meshIndex = found->second.meshMetaData.meshIndex;
+  int released = 0;
+  for (int iMesh = meshIndex.first; iMesh <= meshIndex.second; ++iMesh) {
+    released += meshes_.at(iMesh)->releaseHostData();
+  }
+  if (released || joinedFreed) {
+    measureAsset(filename, false);
+  }
+  return released;
+}
+
+bool ResourceManager::restoreHostMeshData(const std::string& filename) {
+  auto found = resourceDict_.find(filename);
+  if (found == resourceDict_.end()) {
+    return false;
+  }
+  const std::pair<int, int>& meshIndex = found->second.meshMetaData.meshIndex;
+  std::unique_ptr<SceneBundle> bundle;
+  bool sourcesOpened = false;
+  bool importerOpened = false;
+  bool restored = false;
+  for (int iMesh = meshIndex.first; iMesh <= meshIndex.second; ++iMesh) {
+    auto* mesh = dynamic_cast<GenericMeshData*>(meshes_.at(iMesh).get());
+    if (!mesh || !mesh->isHostDataReleased()) {
+      continue;
+    }
+    // from where loadMeshes() would take it, without levels of detail
+    const int localIndex = iMesh - meshIndex.first;
+    if (!sourcesOpened) {
+      bundle = openSceneBundle(filename);
+      sourcesOpened = true;
+    }
+    if ((bundle && bundle->loadMesh(localIndex, false, *mesh)) ||
+        (meshCache_ && meshCache_->load(filename, localIndex, false, *mesh))) {
+      restored = true;
+      continue;
+    }
+    if (!importerOpened && !fileImporter_->openFile(filename)) {
+      LOG(ERROR) << "ResourceManager::restoreHostMeshData : Cannot open "
+                 << filename << ", its meshes stay without CPU data";
+      return restored;
+    }
+    importerOpened = true;
+    Cr::Containers::Optional<Mn::Trade::MeshData> meshData =
+        fileImporter_->mesh(localIndex);
+    if (!meshData) {
+      LOG(ERROR) << "ResourceManager::restoreHostMeshData : Cannot import "
+                 << "mesh " << localIndex << " of " << filename;
+      continue;
+    }
+    mesh->setMeshData(*std::move(meshData));
+    restored = true;
+  }
+  if (restored) {
+    LOG(INFO) << "ResourceManager::restoreHostMeshData : Re-read the meshes "
+              << "of " << filename;
+    measureAsset(filename, false);
+  }
+  return restored;
+}
+
+ResourceManager::AssetReference ResourceManager::acquireAsset(
+    const std::string& filename) const {
+  AssetReference reference;
+  reference.tracker_ = assetUsage_;
+  reference.usage_ = &assetUsage_->assets[filename];
+  ++reference.usage_->numReferences;
+  return reference;
+}
+
+int ResourceManager::getNumAssetReferences(const std::string& filename) const {
+  auto found = assetUsage_->assets.find(filename);
+  return found == assetUsage_->assets.end() ? 0 : found->second.numReferences;
+}
+
+std::size_t ResourceManager::getAssetCacheHostBytes() const {
+  std::size_t bytes = 0;
+  for (const auto& asset : assetBytes_) {
+    bytes += asset.second.host;
+  }
+  return bytes;
+}
+
+std::size_t ResourceManager::getAssetCacheGpuBytes() const {
+  std::size_t bytes = 0;
+  for (const auto& asset : assetBytes_) {
+    bytes += asset.second.gpu;
+  }
+  return bytes;
+}
+
+std::map<std::string, core::MemoryUsage> ResourceManager::getMemoryUsage() {
+  core::MemoryUsage meshes, textures, ptexAtlases, collisionMeshes;
+  for (const auto& mesh : meshes_) {
+    if (!mesh.second) {
+      continue;
+    }
+#ifdef ESP_BUILD_PTEX_SUPPORT
+    if (mesh.second->getMeshType() == SupportedMeshType::PTEX_MESH) {
+      const auto& ptexMesh = static_cast<const PTexMeshData&>(*mesh.second);
+      meshes.hostBytes += ptexMesh.getMeshBytes();
+      meshes.gpuBytes += ptexMesh.getMeshBytes();
+      ptexAtlases.gpuBytes += ptexMesh.getAtlasBytes();
+      collisionMeshes.hostBytes += ptexMesh.getCollisionBytes();
+      continue;
+    }
+#endif
+    // the same estimates as measureAsset()
+    std::size_t meshBytes = 0;
+    if (const auto& meshData = mesh.second->getMeshData()) {
+      meshBytes = meshData->vertexData().size() + meshData->indexData().size();
+    }
+    const CollisionMeshData& collision = mesh.second->getCollisionMeshData();
+    const std::size_t collisionBytes =
+        collision.positions.size() * sizeof(Mn::Vector3) +
+        collision.indices.size() * sizeof(Mn::UnsignedInt);
+    meshes.hostBytes += meshBytes;
+    meshes.gpuBytes += meshBytes ? meshBytes : collisionBytes;
+    collisionMeshes.hostBytes += collisionBytes;
+  }
+  for (const auto& joined : joinedCollisionMeshes_) {
+    collisionMeshes.hostBytes += joined.second->vbo.size() * sizeof(vec3f) +
+                                 joined.second->ibo.size() * sizeof(uint32_t);
+  }
+  for (const auto& simplified : simplifiedCollisionMeshes_) {
+    for (const geo::SimplifiedMesh& mesh : simplified.second) {
+      collisionMeshes.hostBytes +=
+          mesh.positions.size() * sizeof(Mn::Vector3) +
+          mesh.indices.size() * sizeof(Mn::UnsignedInt);
+    }
+  }
+  if (gfx::TextureStreamer* textureStreamer = getTextureStreamer()) {
+    const gfx::TextureStreamer::Statistics statistics =
+        textureStreamer->statistics();
+    textures.hostBytes = statistics.hostBytes;
+    textures.gpuBytes = statistics.residentBytes;
+  } else {
+    for (const auto& texture : textureBytes_) {
+      textures.gpuBytes += texture.second;
+    }
+  }
+  return {{"meshes", meshes},
+          {"textures", textures},
+          {"ptex_atlases", ptexAtlases},
+          {"collision_meshes", collisionMeshes}};
+}
+
+void ResourceManager::measureAsset(const std::string& filename,
+                                   const bool measureGpu) {
+  auto found = resourceDict_.find(filename);
+  if (found == resourceDict_.end()) {
+    return;
+  }
+  // counted once for the contents loaded under several paths
+  const std::string* sharing = findAssetSharingMeshes(filename);
+  if (sharing && assetBytes_.count(*sharing)) {
+    return;
+  }
+  const MeshMetaData& meshMetaData = found->second.meshMetaData;
+  AssetBytes bytes;
+  for (int iMesh = meshMetaData.meshIndex.first;
+       iMesh <= meshMetaData.meshIndex.second; ++iMesh) {
+    auto mesh = meshes_.find(iMesh);
+    if (mesh == meshes_.end() || !mesh->second) {
+      continue;
+    }
+    std::size_t meshBytes = 0;
+    if (const auto& meshData = mesh->second->getMeshData()) {
+      meshBytes = meshData->vertexData().size() + meshData->indexData().size();
+    }
+    // unpacked copies for the general meshes, the only CPU data of the
+    // others
+    const CollisionMeshData& collision = mesh->second->getCollisionMeshData();
+    const std::size_t collisionBytes =
+        collision.positions.size() * sizeof(Mn::Vector3) +
+        collision.indices.size() * sizeof(Mn::UnsignedInt);
+    bytes.host += meshBytes + collisionBytes;
+    bytes.gpu += meshBytes ? meshBytes : collisionBytes;
+  }
+  auto joined = joinedCollisionMeshes_.find(filename);
+  if (joined != joinedCollisionMeshes_.end()) {
+    bytes.host += joined->second->vbo.size() * sizeof(vec3f) +
+                  joined->second->ibo.size() * sizeof(uint32_t);
+  }
+  for (const auto& simplified : simplifiedCollisionMeshes_) {
+    if (simplified.first.first != filename) {
+      continue;
+    }
+    for (const geo::SimplifiedMesh& mesh : simplified.second) {
+      bytes.host += mesh.positions.size() * sizeof(Mn::Vector3) +
+                    mesh.indices.size() * sizeof(Mn::UnsignedInt);
+    }
+  }
+  AssetBytes& measured = assetBytes_[filename];
+  if (!measureGpu) {
+    measured.host = bytes.host;
+    return;
+  }
+  for (int iTexture = meshMetaData.textureIndex.first;
+       iTexture <= meshMetaData.textureIndex.second; ++iTexture) {
+    auto texture = textureBytes_.find(iTexture);
+    if (texture != textureBytes_.end()) {
+      bytes.gpu += texture->second;
+    }
+  }
+  measured = bytes;
+  assetUsage_->assets[filename].lastUsed = ++assetUsage_->clock;
+}
+
+int ResourceManager::evictUnusedAssets() {
+  std::size_t hostBytes = getAssetCacheHostBytes();
+  std::size_t gpuBytes = getAssetCacheGpuBytes();
+  const auto overBudget = [&]() {
+    return (assetCacheHostBudget_ && hostBytes > assetCacheHostBudget_) ||
+           (assetCacheGpuBudget_ && gpuBytes > assetCacheGpuBudget_);
+  };
+  if (!overBudget()) {
+    return 0;
+  }
+
+  // the loaded assets nothing references, least recently used first
+  std::vector<std::pair<std::uint64_t, std::string>> unused;
+  for (const auto& asset : resourceDict_) {
+    auto found = assetUsage_->assets.find(asset.first);
+    if (found == assetUsage_->assets.end()) {
+      unused.emplace_back(0, asset.first);
+    } else if (found->second.numReferences == 0) {
+      unused.emplace_back(found->second.lastUsed, asset.first);
+    }
+  }
+  std::sort(unused.begin(), unused.end());
+
+  int evicted = 0;
+  for (const auto& asset : unused) {
+    if (!overBudget()) {
+      break;
+    }
+    // the memory of contents shared with other paths stays theirs
+    auto bytes = assetBytes_.find(asset.second);
+    if (bytes != assetBytes_.end() && !findAssetSharingMeshes(asset.second)) {
+      hostBytes -= bytes->second.host;
+      gpuBytes -= bytes->second.gpu;
+    }
+    evictAsset(asset.second);
+    ++evicted;
+  }
+  LOG(INFO) << "ResourceManager::evictUnusedAssets : Freed " << evicted
+            << " assets, the rest take about " << hostBytes
+            << " bytes of CPU and " << gpuBytes << " bytes of GPU memory";
+  return evicted;
+}
+
+void ResourceManager::evictAsset(const std::string& filename) {
+  auto found = resourceDict_.find(filename);
+  const std::string* sharing = findAssetSharingMeshes(filename);
+  if (sharing) {
+    // loaded under another path too, which keeps the meshes and textures
+    auto bytes = assetBytes_.find(filename);
+    if (bytes != assetBytes_.end()) {
+      assetBytes_[*sharing] = bytes->second;
+    }
+    resourceDict_.erase(found);
+  } else if (found != resourceDict_.end()) {
+    const MeshMetaData& meshMetaData = found->second.meshMetaData;
+    if (meshMetaData.meshIndex.first != ID_UNDEFINED) {
+      for (int iMesh = meshMetaData.meshIndex.first;
+           iMesh <= meshMetaData.meshIndex.second; ++iMesh) {
+        meshes_.erase(iMesh);
+      }
+    }
+    if (meshMetaData.textureIndex.first != ID_UNDEFINED) {
+      gfx::TextureStreamer* textureStreamer = getTextureStreamer();
+      for (int iTexture = meshMetaData.textureIndex.first;
+           iTexture <= meshMetaData.textureIndex.second; ++iTexture) {
+        // the streamer would keep uploading to the destroyed texture
+        auto texture = textures_.find(iTexture);
+        if (textureStreamer && texture != textures_.end() &&
+            texture->second) {
+          textureStreamer->removeTexture(*texture->second);
+        }
+        textures_.erase(iTexture);
+        textureBytes_.erase(iTexture);
+      }
+    }
+    resourceDict_.erase(found);
+  }
+
+  // the collision meshes reference the meshes, the merged meshes are meshes
+  // of their own
+  collisionMeshGroups_.erase(filename);
+  convexDecompositions_.erase(filename);
+  joinedCollisionMeshes_.erase(filename);
+  // of every error, nothing uses the asset anymore
+  for (auto simplified = simplifiedCollisionMeshes_.begin();
+       simplified != simplifiedCollisionMeshes_.end();) {
+    if (simplified->first.first == filename) {
+      simplified = simplifiedCollisionMeshes_.erase(simplified);
+    } else {
+      ++simplified;
+    }
+  }
+  auto merged = mergedStaticMeshes_.find(filename);
+  if (merged != mergedStaticMeshes_.end()) {
+    for (const MergedStaticMesh& mesh : merged->second) {
+      meshes_.erase(mesh.meshID);
+    }
+    mergedStaticMeshes_.erase(merged);
+  }
+  for (auto baked = bakedStaticMeshes_.begin();
+       baked != bakedStaticMeshes_.end();) {
+    if (baked->first.first != filename) {
+      ++baked;
+      continue;
+    }
+    for (const MergedStaticMesh& mesh : baked->second) {
+      meshes_.erase(mesh.meshID);
+    }
+    baked = bakedStaticMeshes_.erase(baked);
+  }
+
+  assetBytes_.erase(filename);
+  assetUsage_->assets.erase(filename);
+  for (auto asset = contentAssets_.begin(); asset != contentAssets_.end();) {
+    if (asset->second == filename) {
+      asset = contentAssets_.erase(asset);
+    } else {
+      ++asset;
+    }
+  }
+}
+
+bool ResourceManager::contentHash(const std::string& filename,
+                                  std::uint64_t& hash) {
+  // glTF and OBJ files may read buffers, images and materials next to them
+  const std::string extension = Cr::Utility::String::lowercase(
+      Cr::Utility::Directory::splitExtension(filename).second);
+  if (extension != ".glb" && extension != ".ply") {
+    return false;
+  }
+  struct stat status;
+  if (::stat(filename.c_str(), &status) != 0) {
+    return false;
+  }
+  auto found = contentHashes_.find(filename);
+  if (found != contentHashes_.end() &&
+      found->second.size == std::uint64_t(status.st_size) &&
+      found->second.modified == status.st_mtime) {
+    hash = found->second.hash;
+    return true;
+  }
+  const Cr::Containers::Array<char> data = core::mapFile(filename);
+  if (data.empty()) {
+    return false;
+  }
+  hash = core::hashBytesXXH64(data);
+  contentHashes_[filename] = {std::uint64_t(status.st_size), status.st_mtime,
+                              hash};
+  return true;
+}
+
+bool ResourceManager::loadSharedRenderAsset(const AssetInfo& info,
+                                            const std::uint64_t hash) {
+  auto candidates = contentAssets_.equal_range(hash);
+  for (auto candidate = candidates.first; candidate != candidates.second;
+       ++candidate) {
+    auto source = resourceDict_.find(candidate->second);
+    if (source == resourceDict_.end()) {
+      continue;
+    }
+    // loaded with the same options, only the path differs
+    AssetInfo sourceInfo = source->second.assetInfo;
+    sourceInfo.filepath = info.filepath;
+    if (sourceInfo != info) {
+      continue;
+    }
+    LOG(INFO) << "ResourceManager::loadSharedRenderAsset : " << info.filepath
+              << " has the contents of " << candidate->second
+              << ", sharing its meshes and textures";
+    resourceDict_.emplace(info.filepath,
+                          LoadedAssetData{info, source->second.meshMetaData});
+    contentAssets_.emplace(hash, info.filepath);
+    assetUsage_->assets[info.filepath].lastUsed = ++assetUsage_->clock;
+    return true;
+  }
+  return false;
+}
+
+const std::string* ResourceManager::findAssetSharingMeshes(
+    const std::string& filename) const {
+  auto found = resourceDict_.find(filename);
+  if (found == resourceDict_.end()) {
+    return nullptr;
+  }
+  const MeshMetaData& meshMetaData = found->second.meshMetaData;
+  if (meshMetaData.meshIndex.first == ID_UNDEFINED &&
+      meshMetaData.textureIndex.first == ID_UNDEFINED) {
+    return nullptr;
+  }
+  for (const auto& asset : resourceDict_) {
+    if (asset.first != filename &&
+        asset.second.meshMetaData.meshIndex == meshMetaData.meshIndex &&
+        asset.second.meshMetaData.textureIndex == meshMetaData.textureIndex) {
+      return &asset.first;
+    }
+  }
+  return nullptr;
+}
+
+int ResourceManager::deleteAssetInstances(scene::SceneNode& parent) {
+  std::vector<scene::SceneNode*> instances;
+  for (scene::MagnumObject& child : parent.children()) {
+    for (Mn::SceneGraph::AbstractFeature3D& feature : child.features()) {
+      if (dynamic_cast<AssetInstanceFeature*>(&feature)) {
+        instances.push_back(static_cast<scene::SceneNode*>(&child));
+        break;
+      }
+    }
+  }
+  for (scene::SceneNode* instance : instances) {
+    delete instance;
+  }
+  return instances.size();
+}
+
 }  // namespace assets
 }  // namespace esp
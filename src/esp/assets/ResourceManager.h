@@ -10,6 +10,8 @@
  * esp::assets::ResourceManager::ShaderType
  */
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -19,18 +21,28 @@
 #include <Corrade/Containers/EnumSet.h>
 #include <Corrade/Containers/Optional.h>
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/FileCallback.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/MeshTools/Transform.h>
+#include <Magnum/Sampler.h>
 #include <Magnum/SceneGraph/MatrixTransformation3D.h>
 
 #include "Asset.h"
+#include "BakedLightingCache.h"
 #include "BaseMesh.h"
 #include "CollisionMeshData.h"
+#include "CompressedTextureCache.h"
+#include "FileProvider.h"
 #include "GenericMeshData.h"
+#include "MeshCache.h"
 #include "MeshData.h"
 #include "MeshMetaData.h"
 #include "RenderAssetInstanceCreationInfo.h"
+#include "SceneBundle.h"
+#include "esp/core/MemoryUsage.h"
+#include "esp/core/ThreadPool.h"
+#include "esp/geo/geo.h"
 #include "esp/gfx/Drawable.h"
 #include "esp/gfx/DrawableGroup.h"
 #include "esp/gfx/MaterialData.h"
@@ -195,6 +207,16 @@ class ResourceManager {
    */
   bool instantiateAssetsOnDemand(const std::string& objTemplateHandle);
 
+  /**
+   * @brief Load the convex decomposition of a collision asset into @ref
+   * convexDecompositions_ from the .hulls file next to it, or build and save
+   * it there if there is none. Regenerate the file with
+   * `datatool create_convex_decomposition` after changing the asset.
+   * @param collisionAssetHandle The key of the asset in @ref
+   * collisionMeshGroups_.
+   */
+  void buildConvexDecomposition(const std::string& collisionAssetHandle);
+
   //======== Accessor functions ========
   /**
    * @brief Getter for all @ref assets::CollisionMeshData associated with the
@@ -212,6 +234,22 @@ class ResourceManager {
     return collisionMeshGroups_.at(collisionAssetHandle);
   }
 
+  /**
+   * @brief Getter for the convex decomposition of a collision asset, built
+   * for the objects with @ref
+   * metadata::attributes::ObjectAttributes::getUseConvexDecomposition().
+   *
+   * @param collisionAssetHandle The key by which the asset is referenced in
+   * @ref convexDecompositions_.
+   * @return The vertices of each convex hull of the decomposition, in the
+   * space of the asset.
+   */
+  const std::vector<std::vector<Mn::Vector3>>& getConvexDecomposition(
+      const std::string& collisionAssetHandle) const {
+    CHECK(convexDecompositions_.count(collisionAssetHandle) > 0);
+    return convexDecompositions_.at(collisionAssetHandle);
+  }
+
   /**
    * @brief Return manager for construction and access to asset attributes.
    */
@@ -315,7 +353,7 @@ class ResourceManager {
    * @brief Construct a unified @ref MeshData from a loaded asset's collision
    * meshes.
    *
-   * See @ref joinHeirarchy.
+   * A copy of @ref getJoinedCollisionMesh(), see @ref joinHeirarchy.
    * @param filename The identifying string key for the asset. See @ref
    * resourceDict_ and @ref meshes_.
    * @return The unified @ref MeshData object for the asset.
@@ -323,6 +361,128 @@ class ResourceManager {
   std::unique_ptr<MeshData> createJoinedCollisionMesh(
       const std::string& filename);
 
+  /**
+   * @brief The @ref createJoinedCollisionMesh() of an asset, joined once and
+   * shared until the asset is evicted, e.g. to recompute the navmesh
+   * repeatedly
+   *
+   * Not kept for the assets whose CPU data was released, see
+   * @ref setReleaseStageMeshData(), they're joined again every time.
+   */
+  MeshData::cptr getJoinedCollisionMesh(const std::string& filename);
+
+  /**
+   * @brief Free the CPU copies of the meshes of a loaded asset, keeping what
+   * was uploaded to the GPU, see @ref BaseMesh::releaseHostData()
+   *
+   * They're re-read from the asset, the bundle or the mesh cache when
+   * they're needed again, e.g. by @ref createJoinedCollisionMesh(), by the
+   * collision mesh groups or for a new instance. Nothing is freed for the
+   * contents loaded under several paths.
+   * @return The number of meshes freed
+   */
+  int releaseHostMeshData(const std::string& filename);
+
+  /**
+   * @brief Keeps a loaded asset from being freed by @ref evictUnusedAssets()
+   * while it's alive
+   *
+   * Each instance of a render asset holds one, as do the physics objects
+   * colliding with the meshes of an asset. Empty when default-constructed,
+   * movable but not copyable, and safe to destroy after the
+   * @ref ResourceManager.
+   */
+  class AssetReference {
+   public:
+    AssetReference() = default;
+    AssetReference(const AssetReference&) = delete;
+    AssetReference(AssetReference&& other) noexcept;
+    AssetReference& operator=(const AssetReference&) = delete;
+    AssetReference& operator=(AssetReference&& other) noexcept;
+    ~AssetReference();
+
+   private:
+    friend ResourceManager;
+    struct Usage;
+    struct Tracker;
+
+    void release();
+
+    std::shared_ptr<Tracker> tracker_;
+    Usage* usage_ = nullptr;
+  };
+
+  /**
+   * @brief Keep an asset loaded, whether it's loaded already or not, until
+   * the returned reference is destroyed
+   * @param filename The identifying string key for the asset. See @ref
+   * resourceDict_.
+   */
+  AssetReference acquireAsset(const std::string& filename) const;
+
+  /**
+   * @brief The number of live @ref AssetReference of an asset, its instances
+   * and the physics objects colliding with it
+   */
+  int getNumAssetReferences(const std::string& filename) const;
+
+  /**
+   * @brief Set the memory budgets of the loaded assets, in bytes, 0 for no
+   * budget, the default
+   *
+   * Over budget, @ref evictUnusedAssets() frees the assets nothing
+   * references. The sizes are estimated from the vertex and index data and
+   * the texture images of the assets when they're loaded.
+   */
+  void setAssetCacheBudget(std::size_t hostBytes, std::size_t gpuBytes) {
+    assetCacheHostBudget_ = hostBytes;
+    assetCacheGpuBudget_ = gpuBytes;
+  }
+
+  /** @brief See @ref setAssetCacheBudget() */
+  std::size_t getAssetCacheHostBudget() const { return assetCacheHostBudget_; }
+
+  /** @brief See @ref setAssetCacheBudget() */
+  std::size_t getAssetCacheGpuBudget() const { return assetCacheGpuBudget_; }
+
+  /** @brief The estimated CPU memory of the loaded assets, in bytes */
+  std::size_t getAssetCacheHostBytes() const;
+
+  /** @brief The estimated GPU memory of the loaded assets, in bytes */
+  std::size_t getAssetCacheGpuBytes() const;
+
+  /**
+   * @brief The estimated memory of the loaded assets, by kind
+   *
+   * Keyed by `meshes`, the vertices and indices of the render meshes,
+   * `textures`, resident ones only if they are streamed, `ptex_atlases`, the
+   * uploaded atlases of PTex meshes, and `collision_meshes`, the CPU
+   * copies of the collision meshes, joined and simplified ones included,
+   * which the physics shapes reference. The internal structures the
+   * physics library builds on top of them aren't counted.
+   */
+  std::map<std::string, core::MemoryUsage> getMemoryUsage();
+
+  /**
+   * @brief Free the assets without @ref AssetReference, least recently used
+   * first, until the loaded assets fit in the budgets of
+   * @ref setAssetCacheBudget()
+   *
+   * Their meshes, textures, collision meshes and merged meshes are freed,
+   * they're loaded again when they're instanced next. Their materials are
+   * kept.
+   * @return The number of assets freed
+   */
+  int evictUnusedAssets();
+
+  /**
+   * @brief Delete the children of @p parent that are instances of render
+   * assets, e.g. the stage of a scene graph no longer drawn, so that their
+   * assets can be evicted
+   * @return The number of instances deleted
+   */
+  int deleteAssetInstances(scene::SceneNode& parent);
+
   /**
    * @brief Add an object from a specified object template handle to the
    * specified @ref DrawableGroup as a child of the specified @ref
@@ -344,7 +504,7 @@ class ResourceManager {
    * result of this process.
    */
   void addObjectToDrawables(
-      const metadata::attributes::ObjectAttributes::ptr& ObjectAttributes,
+      const metadata::attributes::ObjectAttributes::cptr& ObjectAttributes,
       scene::SceneNode* parent,
       DrawableGroup* drawables,
       std::vector<scene::SceneNode*>& visNodeCache,
@@ -381,12 +541,15 @@ class ResourceManager {
    * @param pathFinder Holds the NavMesh information.
    * @param parent The new Drawable is attached to this node.
    * @param drawables The group with which the new Drawable will be rendered.
+   * @param wireframe Whether to draw the edges of the triangles, otherwise
+   * the triangles are filled, e.g. for occupancy maps.
    * @return The primitive ID of the new object or @ref ID_UNDEFINED if
    * construction failed.
    */
   int loadNavMeshVisualization(esp::nav::PathFinder& pathFinder,
                                scene::SceneNode* parent,
-                               DrawableGroup* drawables);
+                               DrawableGroup* drawables,
+                               bool wireframe = true);
 
   /**
    * @brief Generate a tube following the passed trajectory of points.
@@ -429,6 +592,218 @@ class ResourceManager {
    */
   inline void setRequiresTextures(bool newVal) { requiresTextures_ = newVal; }
 
+  /**
+   * @brief Set whether coarser levels of detail are generated for the meshes
+   * of general assets loaded afterwards, see @ref
+   * GenericMeshData::generateLods(). Their drawables pick a level from the
+   * projected size of the simplification error.
+   */
+  void setGenerateMeshLods(bool newVal) { generateMeshLods_ = newVal; }
+
+  /**
+   * @brief Set whether static instances of general assets created
+   * afterwards, e.g. stages, draw their meshes merged by material
+   *
+   * The meshes sharing a material and vertex format are merged on the first
+   * instantiation of an asset into one mesh, pre-transformed to the space of
+   * the asset, with a drawable per merged mesh instead of per glTF mesh
+   * node. The ranges of the original meshes are still culled separately,
+   * see @ref gfx::Drawable::setSubmeshes(). Assets with meshes that can't be
+   * merged, see @ref GenericMeshData::isMergeable(), are instantiated as
+   * usual.
+   */
+  void setMergeStaticMeshes(bool newVal) { mergeStaticMeshes_ = newVal; }
+
+  /**
+   * @brief Set whether static instances of general assets created
+   * afterwards bake the lighting of their merged meshes into vertex colors
+   *
+   * Only applies with @ref setMergeStaticMeshes(). The lighting of the Phong
+   * materials is evaluated per vertex once per asset and light setup, see
+   * @ref gfx::bakeVertexLighting(), and the meshes are drawn without lights,
+   * so static lighting costs nothing per frame while objects keep their
+   * dynamic lights. Light setups with lights relative to the camera, PBR
+   * materials and meshes with vertex colors stay lit dynamically. Changing
+   * the light setup afterwards only affects the instances created after the
+   * change.
+   */
+  void setBakeStaticLighting(bool newVal) { bakeStaticLighting_ = newVal; }
+
+  /**
+   * @brief Cache the lighting baked by @ref setBakeStaticLighting() in
+   * @p directory, see @ref BakedLightingCache
+   *
+   * @param directory The cache directory, empty to disable the cache
+   */
+  void setBakedLightingCacheDirectory(const std::string& directory);
+
+  /**
+   * @brief Set whether stages loaded afterwards without a collision mesh,
+   * i.e. without physics, free the CPU copies of their meshes once uploaded
+   *
+   * For large scans, this halves the host memory of the stage. See
+   * @ref releaseHostMeshData().
+   */
+  void setReleaseStageMeshData(bool newVal) { releaseStageMeshData_ = newVal; }
+
+  /**
+   * @brief Set the error the collision meshes of stages loaded afterwards
+   * without a collision asset are simplified with, 0 to collide with the
+   * render meshes
+   *
+   * The triangle meshes of physics and the navmesh of such stages are built
+   * from @ref geo::simplifyCollisionMesh() of their render meshes, which
+   * moves no surface by more than @p maxError, in the units of the stage.
+   * Dense scans collapse to a small fraction of their triangles. The
+   * simplified meshes are cached by the @ref MeshCache, if any.
+   */
+  void setStageCollisionSimplification(float maxError);
+
+  /**
+   * @brief Set whether the meshes of general assets loaded afterwards are
+   * uploaded with compressed vertex formats, see
+   * @ref GenericMeshData::setCompressVertexFormats()
+   */
+  void setCompressVertexFormats(bool newVal) {
+    compressVertexFormats_ = newVal;
+  }
+
+  /**
+   * @brief Set whether the RGB8 and RGBA8 textures of general assets loaded
+   * afterwards are compressed on load, see @ref gfx::compressTextureImage()
+   *
+   * Compressed textures take a quarter to an eighth of the GPU memory of the
+   * uncompressed ones. The mip levels are generated and compressed on the
+   * loader threads, in parallel for the textures of an asset; cache them
+   * with @ref setCompressedTextureCacheDirectory() to compress them once.
+   * Without S3TC support in the context textures are uploaded uncompressed.
+   */
+  void setCompressTextures(bool newVal) { compressTextures_ = newVal; }
+
+  /**
+   * @brief Cache the textures compressed by @ref setCompressTextures() in
+   * @p directory, see @ref CompressedTextureCache
+   *
+   * @param directory The cache directory, empty to disable the cache
+   */
+  void setCompressedTextureCacheDirectory(const std::string& directory);
+
+  /**
+   * @brief Cache the processed meshes of general assets loaded afterwards in
+   * @p directory, see @ref MeshCache. Meshes found there are mapped instead
+   * of imported, the others are stored after processing.
+   *
+   * @param directory The cache directory, empty to disable the cache
+   */
+  void setMeshCacheDirectory(const std::string& directory);
+
+  /**
+   * @brief Cache the linked programs of the shaders created afterwards in
+   * @p directory, see @ref gfx::ProgramBinaryCache, so that later processes
+   * load them instead of compiling them.
+   *
+   * @param directory The cache directory, empty to disable the cache
+   */
+  void setShaderCacheDirectory(const std::string& directory);
+
+  /**
+   * @brief Cache the image based lighting computed by
+   * @ref loadImageBasedLighting() in @p directory, see
+   * @ref gfx::PbrImageBasedLighting::store()
+   *
+   * @param directory The cache directory, empty to disable the cache
+   */
+  void setImageBasedLightingCacheDirectory(const std::string& directory);
+
+  /**
+   * @brief Light the PBR drawables drawn afterwards with the environment of
+   * @p sceneGraph seen from @p position, see
+   * @ref gfx::PbrImageBasedLighting
+   *
+   * The environment is captured by the default cube map camera of
+   * @p sceneGraph and its maps are computed on the GPU, unless the cache of
+   * @ref setImageBasedLightingCacheDirectory() has them for @p cacheKey and
+   * @p position already. The cache is not invalidated if the assets behind
+   * @p cacheKey change.
+   *
+   * @param sceneGraph The scene graph to capture, usually the stage only
+   * @param position The world position of the capture
+   * @param cacheKey Identifies the environment in the cache, e.g. the stage
+   * file
+   */
+  void loadImageBasedLighting(scene::SceneGraph& sceneGraph,
+                              const Magnum::Vector3& position,
+                              const std::string& cacheKey);
+
+  /**
+   * @brief Draw the PBR drawables without the lighting of
+   * @ref loadImageBasedLighting()
+   */
+  void removeImageBasedLighting();
+
+  /**
+   * @brief Draw the PTex stages loaded afterwards as general assets,
+   * converted by @ref PTexMeshData::convertToGltf() into @p directory
+   *
+   * A stage is converted on its first load and again once its mesh file
+   * changed, the later loads import the conversion with
+   * @ref loadRenderAssetGeneral() and draw it with the flat shader, without
+   * the adjacency lookups of the PTex one. The collision and semantic meshes
+   * are the same. Stages failing to convert are drawn with the PTex shader.
+   *
+   * @param directory The directory of the conversions, empty to draw the
+   * PTex stages with the PTex shader
+   * @param tileResolution The texels along the side of a face in the baked
+   * atlases, 0 for the tile size of the PTex atlases less the two texels
+   * bordering the faces
+   */
+  void setPTexConversionDirectory(const std::string& directory,
+                                  int tileResolution = 0);
+
+  /**
+   * @brief Stream the textures of general assets loaded afterwards within a
+   * GPU memory budget, see @ref gfx::TextureStreamer. Textures loaded before
+   * stay fully resident.
+   *
+   * @param budgetBytes The budget, 0 for unlimited. If the streamer exists
+   * already only its budget is changed.
+   */
+  void setTextureMemoryBudget(std::size_t budgetBytes);
+
+  /**
+   * @brief The texture streamer, nullptr unless @ref setTextureMemoryBudget()
+   * was called.
+   */
+  gfx::TextureStreamer* getTextureStreamer();
+
+  /**
+   * @brief Open the files of general assets loaded afterwards, and of the
+   * buffers and images they reference, through @p provider instead of the
+   * filesystem, see @ref FileProvider
+   *
+   * @param provider The provider, nullptr to read the filesystem again
+   */
+  void setFileProvider(std::shared_ptr<FileProvider> provider);
+
+  /**
+   * @brief The file provider, nullptr unless @ref setFileProvider() was called
+   */
+  const std::shared_ptr<FileProvider>& getFileProvider() const {
+    return fileProvider_;
+  }
+
+  /**
+   * @brief Load the images which were drawn with a placeholder since their
+   * files were still @ref FileProvider::Status::Pending, if they arrived
+   *
+   * Call it e.g. once per frame while @ref hasPendingFiles().
+   * @return The number of textures loaded
+   */
+  int loadStreamedFiles();
+
+  /** @brief Whether textures wait for the files of their images */
+  bool hasPendingFiles() const { return !pendingTextures_.empty(); }
+
   /**
    * @brief Set a replay recorder so that ResourceManager can notify it about
    * render assets.
@@ -509,6 +884,20 @@ class ResourceManager {
     int meshID;
   };
 
+  /**
+   * @brief A mesh of a general asset merged from the meshes sharing a
+   * material, see @ref setMergeStaticMeshes()
+   */
+  struct MergedStaticMesh {
+    //! key into meshes_
+    int meshID;
+    std::string materialKey;
+    gfx::Drawable::Flags meshAttributeFlags;
+    std::vector<gfx::Drawable::Submesh> submeshes;
+    //! drawn without lights, see @ref setBakeStaticLighting()
+    bool lightingBaked = false;
+  };
+
   //======== Scene Functions ========
 
   /**
@@ -557,19 +946,44 @@ class ResourceManager {
    * @param importer The importer already loaded with information for the
    * asset.
    * @param loadedAssetData The asset's @ref LoadedAssetData object.
+   * @param bundle The baked bundle of the asset, nullptr if there is none.
+   * The images it has are mapped from it instead of decoded.
+   *
+   * The images are decoded on a @ref loaderThreads() thread while the
+   * previous ones are uploaded.
+   */
+  void loadTextures(Importer& importer,
+                    LoadedAssetData& loadedAssetData,
+                    const SceneBundle* bundle);
+
+  /**
+   * @brief Pick the compressed format Basis images get transcoded to from the
+   * extensions supported by the current GL context. Done once, before the
+   * first general asset is loaded.
    */
-  void loadTextures(Importer& importer, LoadedAssetData& loadedAssetData);
+  void configureBasisImporter();
+
+  /**
+   * @brief The threads decoding and processing assets while the calling
+   * thread uploads them, created on first use
+   */
+  core::ThreadPool& loaderThreads();
 
   /**
    * @brief Load meshes from importer into assets.
    *
    * Compute bounding boxes, upload mesh data to GPU, and update metaData for
-   * an asset to link meshes to that asset.
+   * an asset to link meshes to that asset. The meshes are imported on a
+   * @ref loaderThreads() thread and processed in parallel.
    * @param importer The importer already loaded with information for the
    * asset.
    * @param loadedAssetData The asset's @ref LoadedAssetData object.
+   * @param bundle The baked bundle of the asset, nullptr if there is none.
+   * The meshes it has are mapped from it instead of imported and processed.
    */
-  void loadMeshes(Importer& importer, LoadedAssetData& loadedAssetData);
+  void loadMeshes(Importer& importer,
+                  LoadedAssetData& loadedAssetData,
+                  const SceneBundle* bundle);
 
   /**
    * @brief Recursively parse the mesh component transformation heirarchy for
@@ -598,10 +1012,12 @@ class ResourceManager {
    * @param transformFromParentToWorld The cumulative transformation up to but
    * not including the current @ref MeshTransformNode.
    */
-  void joinHeirarchy(MeshData& mesh,
-                     const MeshMetaData& metaData,
-                     const MeshTransformNode& node,
-                     const Mn::Matrix4& transformFromParentToWorld);
+  void joinHeirarchy(
+      MeshData& mesh,
+      const MeshMetaData& metaData,
+      const MeshTransformNode& node,
+      const Mn::Matrix4& transformFromParentToWorld,
+      const std::vector<geo::SimplifiedMesh>* simplified = nullptr);
 
   /**
    * @brief Load materials from importer into assets, and update metaData for
@@ -673,6 +1089,13 @@ class ResourceManager {
                          scene::SceneNode* parent,
                          DrawableGroup* drawables);
 
+  /**
+   * @brief Whether all meshes of a loaded asset carry the object ids per
+   * vertex, i.e. it's an instance mesh or its meshes have an object id
+   * attribute, so that its drawables draw the semantic observations too.
+   */
+  bool hasPerVertexObjectIds(const std::string& filename);
+
   /**
    * @brief Builds the appropriate collision mesh groups for the passed
    * assetInfo, and adds it to the @ref collisionMeshGroup map.
@@ -683,6 +1106,97 @@ class ResourceManager {
   bool buildMeshGroups(const AssetInfo& info,
                        std::vector<CollisionMeshData>& meshGroup);
 
+  /**
+   * @brief Simplify the collision meshes of the stage @p filename with the
+   * error of @ref setStageCollisionSimplification(), unless they already are
+   * @return The simplified meshes, per mesh of the asset
+   */
+  const std::vector<geo::SimplifiedMesh>& simplifyStageCollision(
+      const std::string& filename);
+
+  /**
+   * @brief The simplified collision meshes of @p filename with the current
+   * error, nullptr if there are none
+   */
+  std::vector<geo::SimplifiedMesh>* findSimplifiedCollision(
+      const std::string& filename);
+
+  /**
+   * @brief Re-read the meshes of @p filename freed by
+   * @ref releaseHostMeshData()
+   * @return Whether any mesh was re-read
+   */
+  bool restoreHostMeshData(const std::string& filename);
+
+  /**
+   * @brief Estimate the memory of a loaded asset, see
+   * @ref setAssetCacheBudget()
+   * @param filename The identifying string key for the asset
+   * @param measureGpu Whether to measure the GPU memory too, which is only
+   * known while the mesh data is still on the CPU, after loading
+   */
+  void measureAsset(const std::string& filename, bool measureGpu);
+
+  /**
+   * @brief Free a loaded asset, see @ref evictUnusedAssets()
+   */
+  void evictAsset(const std::string& filename);
+
+  /**
+   * @brief The hash of the contents of @p filename, memoized by its size and
+   * modification time
+   * @return Whether the file was hashed, false for the files that can't be
+   * read and the formats that may reference other files, e.g. glTF and OBJ
+   */
+  bool contentHash(const std::string& filename, std::uint64_t& hash);
+
+  /**
+   * @brief Load @p info as an alias of a loaded asset with the same
+   * @ref contentHash() and load options, sharing its meshes and textures
+   * @return Whether such an asset was loaded
+   */
+  bool loadSharedRenderAsset(const AssetInfo& info, std::uint64_t hash);
+
+  /**
+   * @brief Another loaded asset sharing the meshes and textures of
+   * @p filename, see @ref loadSharedRenderAsset(), nullptr if none
+   */
+  const std::string* findAssetSharingMeshes(const std::string& filename) const;
+
+  /**
+   * @brief The file callback of the importers with a provider, see
+   * @ref setFileProvider(). Files the provider doesn't have are read from
+   * the filesystem.
+   */
+  static Corrade::Containers::Optional<
+      Corrade::Containers::ArrayView<const char>>
+  provideFile(const std::string& filename,
+              Mn::InputFileCallbackPolicy policy,
+              ResourceManager& resourceManager);
+
+  /**
+   * @brief Upload all mip levels of a texture, to the texture streamer if
+   * there is one, see @ref loadTextures()
+   */
+  void uploadTextureLevels(Mn::GL::Texture2D& texture,
+                           std::vector<Mn::Trade::ImageData2D>&& levels);
+
+  /**
+   * @brief Whether textures are compressed on load, i.e. with
+   * @ref setCompressTextures() and a context supporting S3TC. Call on the
+   * thread owning the context.
+   */
+  bool canCompressTextures() const;
+
+  /**
+   * @brief Replace uncompressed RGB8 and RGBA8 mip levels of a texture with
+   * compressed ones, from the @ref CompressedTextureCache if they're cached
+   * there, generating the mip chain of a single level first. Safe to call
+   * from the loader threads.
+   */
+  void compressTextureLevels(
+      std::vector<Mn::Trade::ImageData2D>& levels) const;
+
   /**
    * @brief Creates a map of appropriate asset infos for sceneries.  Will always
    * create render asset info.  Will create collision asset info and semantic
@@ -695,6 +1209,13 @@ class ResourceManager {
    * @param createSemanticInfo Whether semantic mesh-based asset info should be
    * created
    */
+  /**
+   * @brief The conversion of PTex mesh @p meshFile in the directory of
+   * @ref setPTexConversionDirectory(), converted first if it isn't current,
+   * empty if that fails
+   */
+  std::string convertedPTexMesh(const std::string& meshFile);
+
   std::map<std::string, AssetInfo> createStageAssetInfosFromAttributes(
       const metadata::attributes::StageAttributes::ptr& stageAttributes,
       bool createCollisionInfo,
@@ -805,6 +1326,26 @@ class ResourceManager {
    */
   void translateMesh(BaseMesh* meshDataGL, Mn::Vector3 translation);
 
+  /**
+   * @brief The merged meshes of a loaded general asset, built on the first
+   * call, empty if it has meshes that can't be merged
+   */
+  const std::vector<MergedStaticMesh>& getMergedStaticMeshes(
+      const std::string& filename);
+
+  /**
+   * @brief The merged meshes of a loaded general asset with the lighting of
+   * @p lightSetupKey baked for an instance at @p transformation, built on the
+   * first call, see @ref setBakeStaticLighting()
+   *
+   * The meshes whose lighting can't be baked are the ones of
+   * @ref getMergedStaticMeshes().
+   */
+  const std::vector<MergedStaticMesh>& getBakedStaticMeshes(
+      const std::string& filename,
+      const std::string& lightSetupKey,
+      const Mn::Matrix4& transformation);
+
   /**
    * @brief Compute and return the axis aligned bounding box of a mesh in mesh
    * local space
@@ -869,14 +1410,15 @@ class ResourceManager {
    * @param texture Optional texture for the mesh.
    * @param color Optional color parameter for the shader program. Defaults to
    * white.
+   * @return the created drawable
    */
 
-  void createDrawable(Mn::GL::Mesh& mesh,
-                      gfx::Drawable::Flags& meshAttributeFlags,
-                      scene::SceneNode& node,
-                      const Mn::ResourceKey& lightSetupKey,
-                      const Mn::ResourceKey& materialKey,
-                      DrawableGroup* group = nullptr);
+  gfx::Drawable& createDrawable(Mn::GL::Mesh& mesh,
+                                gfx::Drawable::Flags& meshAttributeFlags,
+                                scene::SceneNode& node,
+                                const Mn::ResourceKey& lightSetupKey,
+                                const Mn::ResourceKey& materialKey,
+                                DrawableGroup* group = nullptr);
 
   Flags flags_;
 
@@ -936,6 +1478,11 @@ class ResourceManager {
    */
   Corrade::PluginManager::Manager<Importer> importerManager_;
 
+  /**
+   * @brief See @ref loaderThreads()
+   */
+  std::unique_ptr<core::ThreadPool> loaderThreads_;
+
   /**
    * @brief Importer used to synthesize Magnum Primitives (PrimitiveImporter).
    * This object allows for similar usage to File-based importers, but requires
@@ -948,6 +1495,35 @@ class ResourceManager {
    */
   Corrade::Containers::Pointer<Importer> fileImporter_;
 
+  /**
+   * @brief See @ref setFileProvider()
+   */
+  std::shared_ptr<FileProvider> fileProvider_;
+
+  /**
+   * @brief The files @ref provideFile() read from the filesystem, until the
+   * importer closes them
+   */
+  std::map<std::string, Corrade::Containers::Array<char>> localFiles_;
+
+  /**
+   * @brief The last file @ref provideFile() was asked for which is still
+   * pending. Only the importer thread touches it while loading.
+   */
+  std::string lastPendingFile_;
+
+  /**
+   * @brief A texture drawn with a placeholder until its image arrives, see
+   * @ref loadStreamedFiles()
+   */
+  struct PendingTexture {
+    std::shared_ptr<Mn::GL::Texture2D> texture;
+    std::string filename;
+    Mn::SamplerFilter minificationFilter;
+    Mn::SamplerMipmap mipmapFilter;
+  };
+  std::vector<PendingTexture> pendingTextures_;
+
   // ======== Physical parameter data ========
 
   //! tracks primitive mesh ids
@@ -964,15 +1540,165 @@ class ResourceManager {
    */
   std::map<std::string, std::vector<CollisionMeshData>> collisionMeshGroups_;
 
+  /**
+   * @brief Maps the keys of @ref collisionMeshGroups_ to the vertices of the
+   * convex hulls decomposing the asset, for the assets needing them.
+   */
+  std::map<std::string, std::vector<std::vector<Mn::Vector3>>>
+      convexDecompositions_;
+
+  /**
+   * @brief See @ref getJoinedCollisionMesh()
+   */
+  std::map<std::string, MeshData::cptr> joinedCollisionMeshes_;
+
+  /**
+   * @brief The simplified collision meshes of each stage and error, see
+   * @ref setStageCollisionSimplification(). They're kept until the asset is
+   * evicted, as the physics of a stage references them.
+   */
+  std::map<std::pair<std::string, float>, std::vector<geo::SimplifiedMesh>>
+      simplifiedCollisionMeshes_;
+
+  /**
+   * @brief See @ref setStageCollisionSimplification()
+   */
+  float stageCollisionSimplification_ = 0.0f;
+
   /**
    * @brief Flag to load textures of meshes
    */
   bool requiresTextures_ = true;
 
+  /**
+   * @brief Flag to generate levels of detail of general meshes on load
+   */
+  bool generateMeshLods_ = false;
+
+  /**
+   * @brief See @ref setMergeStaticMeshes()
+   */
+  bool mergeStaticMeshes_ = false;
+
+  /**
+   * @brief See @ref setBakeStaticLighting()
+   */
+  bool bakeStaticLighting_ = false;
+
+  /**
+   * @brief See @ref setReleaseStageMeshData()
+   */
+  bool releaseStageMeshData_ = false;
+
+  /**
+   * @brief See @ref setCompressVertexFormats()
+   */
+  bool compressVertexFormats_ = false;
+
+  /**
+   * @brief See @ref setCompressTextures()
+   */
+  bool compressTextures_ = false;
+
+  /**
+   * @brief The merged meshes of each asset, see @ref getMergedStaticMeshes()
+   */
+  std::map<std::string, std::vector<MergedStaticMesh>> mergedStaticMeshes_;
+
+  /**
+   * @brief The baked merged meshes of each asset and lighting, see
+   * @ref getBakedStaticMeshes()
+   */
+  std::map<std::pair<std::string, std::uint64_t>,
+           std::vector<MergedStaticMesh>>
+      bakedStaticMeshes_;
+
+  /**
+   * @brief See @ref setMeshCacheDirectory(), nullptr if disabled
+   */
+  std::unique_ptr<MeshCache> meshCache_;
+
+  /**
+   * @brief See @ref setBakedLightingCacheDirectory(), nullptr if disabled
+   */
+  std::unique_ptr<BakedLightingCache> bakedLightingCache_;
+
+  /**
+   * @brief See @ref setCompressedTextureCacheDirectory(), nullptr if disabled
+   */
+  std::unique_ptr<CompressedTextureCache> compressedTextureCache_;
+
+  //! See @ref setImageBasedLightingCacheDirectory(), empty if disabled
+  std::string imageBasedLightingCacheDirectory_;
+
+  //! See @ref setPTexConversionDirectory(), empty if disabled
+  std::string ptexConversionDirectory_;
+  int ptexTileResolution_ = 0;
+
+  /**
+   * @brief Whether @ref configureBasisImporter() picked the transcoding
+   * target already
+   */
+  bool basisImporterConfigured_ = false;
+
   /**
    * @brief See @ref setRecorder.
    */
   std::shared_ptr<esp::gfx::replay::Recorder> gfxReplayRecorder_;
+
+  /**
+   * @brief The estimated memory of a loaded asset, see
+   * @ref setAssetCacheBudget()
+   */
+  struct AssetBytes {
+    std::size_t host = 0;
+    std::size_t gpu = 0;
+  };
+
+  /**
+   * @brief The estimated memory of the loaded assets, keyed like
+   * @ref resourceDict_
+   */
+  std::map<std::string, AssetBytes> assetBytes_;
+
+  /**
+   * @brief The size of the images of the loaded textures, keyed like
+   * @ref textures_
+   */
+  std::map<int, std::size_t> textureBytes_;
+
+  /**
+   * @brief The references to the assets, see @ref acquireAsset()
+   */
+  std::shared_ptr<AssetReference::Tracker> assetUsage_;
+
+  /**
+   * @brief See @ref setAssetCacheBudget()
+   */
+  std::size_t assetCacheHostBudget_ = 0;
+  std::size_t assetCacheGpuBudget_ = 0;
+
+  /**
+   * @brief See @ref contentHash()
+   */
+  struct ContentHash {
+    std::uint64_t size;
+    std::int64_t modified;
+    std::uint64_t hash;
+  };
+  std::map<std::string, ContentHash> contentHashes_;
+
+  /**
+   * @brief The loaded assets by the @ref contentHash() of their file, see
+   * @ref loadSharedRenderAsset()
+   */
+  std::multimap<std::uint64_t, std::string> contentAssets_;
+
+  /**
+   * @brief The material of the trajectories of each color, see
+   * @ref buildTrajectoryVisualization()
+   */
+  std::map<std::array<float, 4>, int> trajectoryMaterials_;
 };  // class ResourceManager
 
 CORRADE_ENUMSET_OPERATORS(ResourceManager::Flags)
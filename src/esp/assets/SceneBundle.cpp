@@ -0,0 +1,424 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SceneBundle.h"
+
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/PluginManager/PluginMetadata.h>
+#include <Corrade/Utility/ConfigurationGroup.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/AbstractImporter.h>
+#include <Magnum/Trade/MeshData.h>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "GenericMeshData.h"
+#include "MeshCache.h"
+#include "esp/core/MappedFile.h"
+#include "esp/nav/PathFinder.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace assets {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 'b', 'n', 'd', 'l', '\0'};
+constexpr std::uint32_t Version = 1;
+// of the entry contents, enough for the mesh blobs and the pixel rows
+constexpr std::size_t Alignment = 64;
+const char* const NavMeshEntry = "navmesh";
+
+struct Blob {
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+// followed by sourceCount SourceHeaders, entryCount EntryHeaders, the names
+// and the aligned entry contents
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t sourceCount;
+  std::uint32_t entryCount;
+  std::uint32_t padding;
+};
+
+// a file entries were baked from, relative to the bundle directory
+struct SourceHeader {
+  Blob name;
+  std::uint64_t size;
+  std::int64_t modified;
+};
+
+struct EntryHeader {
+  Blob name;
+  Blob data;
+  std::uint32_t source;
+  std::uint32_t padding;
+};
+
+// the contents of an image entry are levelCount of these
+struct LevelHeader {
+  std::uint32_t format;
+  std::int32_t alignment;
+  std::int32_t width;
+  std::int32_t height;
+};
+
+bool sourceStamp(const std::string& filename, SourceHeader& source) {
+  struct stat status;
+  if (::stat(filename.c_str(), &status) != 0) {
+    return false;
+  }
+  source.size = status.st_size;
+  source.modified = status.st_mtime;
+  return true;
+}
+
+// pixel rows are padded to the alignment
+std::size_t levelDataSize(const LevelHeader& level) {
+  const std::size_t pixelSize = Mn::pixelSize(Mn::PixelFormat(level.format));
+  const std::size_t rowSize =
+      (level.width * pixelSize + level.alignment - 1) / level.alignment *
+      level.alignment;
+  return rowSize * level.height;
+}
+
+std::string levelEntry(int index, std::size_t level) {
+  return SceneBundle::imageEntry(index) + "/" + std::to_string(level);
+}
+
+// The contents of a bundle being baked
+struct Writer {
+  struct Entry {
+    std::string name;
+    Cr::Containers::Array<char> data;
+    std::uint32_t source;
+  };
+
+  std::vector<std::string> sourceNames;
+  std::vector<SourceHeader> sources;
+  std::vector<Entry> entries;
+
+  // false if the file doesn't exist
+  bool addSource(const std::string& filename) {
+    SourceHeader source{};
+    if (!sourceStamp(filename, source)) {
+      return false;
+    }
+    sourceNames.push_back(Cr::Utility::Directory::filename(filename));
+    sources.push_back(source);
+    return true;
+  }
+
+  // an entry baked from the last added source
+  void add(std::string name, Cr::Containers::Array<char> data) {
+    entries.push_back(Entry{std::move(name), std::move(data),
+                            std::uint32_t(sources.size() - 1)});
+  }
+
+  Cr::Containers::Array<char> write() const {
+    std::size_t size = sizeof(FileHeader) +
+                       sources.size() * sizeof(SourceHeader) +
+                       entries.size() * sizeof(EntryHeader);
+    std::vector<SourceHeader> sourceHeaders = sources;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      sourceHeaders[i].name = Blob{size, sourceNames[i].size()};
+      size += sourceNames[i].size();
+    }
+    std::vector<EntryHeader> entryHeaders(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      entryHeaders[i].name = Blob{size, entries[i].name.size()};
+      size += entries[i].name.size();
+    }
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      size = (size + Alignment - 1) / Alignment * Alignment;
+      entryHeaders[i].data = Blob{size, entries[i].data.size()};
+      entryHeaders[i].source = entries[i].source;
+      entryHeaders[i].padding = 0;
+      size += entries[i].data.size();
+    }
+
+    Cr::Containers::Array<char> file{Cr::Containers::ValueInit, size};
+    FileHeader header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.sourceCount = sources.size();
+    header.entryCount = entries.size();
+    char* out = file.data();
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      std::memcpy(out, &sourceHeaders[i], sizeof(SourceHeader));
+      out += sizeof(SourceHeader);
+      std::memcpy(file + sourceHeaders[i].name.offset, sourceNames[i].data(),
+                  sourceNames[i].size());
+    }
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      std::memcpy(out, &entryHeaders[i], sizeof(EntryHeader));
+      out += sizeof(EntryHeader);
+      std::memcpy(file + entryHeaders[i].name.offset, entries[i].name.data(),
+                  entries[i].name.size());
+      if (!entries[i].data.empty()) {
+        std::memcpy(file + entryHeaders[i].data.offset, entries[i].data.data(),
+                    entries[i].data.size());
+      }
+    }
+    return file;
+  }
+};
+
+// The levels of image @p index as entries, false if they can't be baked
+bool addImage(Writer& writer,
+              Mn::Trade::AbstractImporter& importer,
+              int index) {
+  const Mn::UnsignedInt levelCount = importer.image2DLevelCount(index);
+  std::vector<LevelHeader> levelHeaders;
+  std::vector<Cr::Containers::Array<char>> levels;
+  for (Mn::UnsignedInt level = 0; level != levelCount; ++level) {
+    Cr::Containers::Optional<Mn::Trade::ImageData2D> image =
+        importer.image2D(index, level);
+    // only tightly laid out rows are handled on load
+    if (!image || image->isCompressed() ||
+        Mn::isPixelFormatImplementationSpecific(image->format()) ||
+        image->storage().rowLength() != 0 ||
+        image->storage().skip() != Mn::Vector3i{}) {
+      return false;
+    }
+    LevelHeader levelHeader{};
+    levelHeader.format = std::uint32_t(image->format());
+    levelHeader.alignment = image->storage().alignment();
+    levelHeader.width = image->size().x();
+    levelHeader.height = image->size().y();
+    if (image->data().size() < levelDataSize(levelHeader)) {
+      return false;
+    }
+    levelHeaders.push_back(levelHeader);
+    levels.push_back(image->release());
+  }
+  if (levels.empty()) {
+    return false;
+  }
+
+  Cr::Containers::Array<char> table{Cr::Containers::NoInit,
+                                    levelHeaders.size() * sizeof(LevelHeader)};
+  std::memcpy(table.data(), levelHeaders.data(), table.size());
+  writer.add(SceneBundle::imageEntry(index), std::move(table));
+  for (std::size_t level = 0; level != levels.size(); ++level) {
+    writer.add(levelEntry(index, level), std::move(levels[level]));
+  }
+  return true;
+}
+
+}  // namespace
+
+std::string SceneBundle::filenameFor(const std::string& assetFilename) {
+  return Cr::Utility::Directory::splitExtension(assetFilename).first +
+         ".bundle";
+}
+
+std::string SceneBundle::meshEntry(int index) {
+  return "mesh/" + std::to_string(index);
+}
+
+std::string SceneBundle::imageEntry(int index) {
+  return "image/" + std::to_string(index);
+}
+
+SceneBundle::SceneBundle(std::string filename)
+    : filename_{std::move(filename)} {
+  // the tables are read from a mapping of the whole file, dropped after
+  Cr::Containers::Array<char> file = core::mapFile(filename_);
+  if (file.size() < sizeof(FileHeader)) {
+    return;
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version ||
+      (file.size() - sizeof(FileHeader)) / sizeof(SourceHeader) <
+          header.sourceCount ||
+      file.size() - sizeof(FileHeader) -
+              header.sourceCount * sizeof(SourceHeader) <
+          std::uint64_t(header.entryCount) * sizeof(EntryHeader)) {
+    LOG(WARNING) << "SceneBundle: " << filename_
+                 << " is not a bundle of version " << Version << ", ignoring";
+    return;
+  }
+  auto inFile = [&file](const Blob& blob) {
+    return blob.offset <= file.size() && blob.size <= file.size() - blob.offset;
+  };
+
+  // the sources that are still as they were baked
+  const std::string directory = Cr::Utility::Directory::path(filename_);
+  std::vector<bool> fresh(header.sourceCount);
+  const char* tables = file.data() + sizeof(FileHeader);
+  for (std::uint32_t i = 0; i < header.sourceCount; ++i) {
+    SourceHeader baked;
+    std::memcpy(&baked, tables, sizeof(baked));
+    tables += sizeof(baked);
+    if (!inFile(baked.name)) {
+      return;
+    }
+    SourceHeader current;
+    fresh[i] =
+        sourceStamp(Cr::Utility::Directory::join(
+                        directory, std::string{file + baked.name.offset,
+                                               std::size_t(baked.name.size)}),
+                    current) &&
+        current.size == baked.size && current.modified == baked.modified;
+  }
+
+  std::size_t staleCount = 0;
+  for (std::uint32_t i = 0; i < header.entryCount; ++i) {
+    EntryHeader entry;
+    std::memcpy(&entry, tables, sizeof(entry));
+    tables += sizeof(entry);
+    if (!inFile(entry.name) || !inFile(entry.data) ||
+        entry.source >= header.sourceCount) {
+      LOG(WARNING) << "SceneBundle: " << filename_ << " is corrupted, ignoring";
+      entries_.clear();
+      return;
+    }
+    if (!fresh[entry.source]) {
+      ++staleCount;
+      continue;
+    }
+    entries_.emplace(
+        std::string{file + entry.name.offset, std::size_t(entry.name.size)},
+        Entry{entry.data.offset, entry.data.size});
+  }
+  if (staleCount) {
+    LOG(WARNING) << "SceneBundle: " << staleCount << " entries of "
+                 << filename_
+                 << " are older than their sources and won't be used";
+  }
+}
+
+Cr::Containers::Array<char> SceneBundle::map(const std::string& name) const {
+  auto found = entries_.find(name);
+  if (found == entries_.end()) {
+    return {};
+  }
+  return core::mapFile(filename_, found->second.offset, found->second.size);
+}
+
+bool SceneBundle::loadMesh(int index,
+                           bool needsLods,
+                           GenericMeshData& mesh) const {
+  if (!has(meshEntry(index))) {
+    return false;
+  }
+  return MeshCache::deserialize(map(meshEntry(index)), needsLods, mesh);
+}
+
+bool SceneBundle::loadImage(
+    int index,
+    std::vector<Mn::Trade::ImageData2D>& levels) const {
+  if (!has(imageEntry(index))) {
+    return false;
+  }
+  Cr::Containers::Array<char> table = map(imageEntry(index));
+  const std::size_t levelCount = table.size() / sizeof(LevelHeader);
+  if (!levelCount || table.size() % sizeof(LevelHeader)) {
+    return false;
+  }
+  std::vector<Mn::Trade::ImageData2D> loaded;
+  loaded.reserve(levelCount);
+  for (std::size_t level = 0; level != levelCount; ++level) {
+    LevelHeader header;
+    std::memcpy(&header, table + level * sizeof(LevelHeader), sizeof(header));
+    const Mn::PixelFormat format = Mn::PixelFormat(header.format);
+    if (Mn::isPixelFormatImplementationSpecific(format) ||
+        header.width <= 0 || header.height <= 0 ||
+        (header.alignment != 1 && header.alignment != 2 &&
+         header.alignment != 4 && header.alignment != 8)) {
+      return false;
+    }
+    Cr::Containers::Array<char> data = map(levelEntry(index, level));
+    if (data.size() < levelDataSize(header)) {
+      return false;
+    }
+    loaded.emplace_back(Mn::PixelStorage{}.setAlignment(header.alignment),
+                        format, Mn::Vector2i{header.width, header.height},
+                        std::move(data));
+  }
+  levels = std::move(loaded);
+  return true;
+}
+
+bool SceneBundle::loadNavMesh(nav::PathFinder& pathfinder) const {
+  if (!has(NavMeshEntry)) {
+    return false;
+  }
+  return pathfinder.loadNavMeshData(map(NavMeshEntry));
+}
+
+bool SceneBundle::bake(const std::string& assetFilename,
+                       const std::string& bundleFilename) {
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImporter> manager;
+  manager.setPreferredPlugins("GltfImporter", {"TinyGltfImporter"});
+  // Basis images are transcoded on load to a format picked for the GPU, keep
+  // them out of the bundle by transcoding to a compressed one here
+  if (Cr::PluginManager::PluginMetadata* const metadata =
+          manager.metadata("BasisImporter")) {
+    metadata->configuration().setValue("format", "Bc7RGBA");
+  }
+  Cr::Containers::Pointer<Mn::Trade::AbstractImporter> importer =
+      manager.loadAndInstantiate("AnySceneImporter");
+  Writer writer;
+  if (!importer || !writer.addSource(assetFilename) ||
+      !importer->openFile(assetFilename)) {
+    LOG(ERROR) << "SceneBundle::bake(): cannot open " << assetFilename;
+    return false;
+  }
+
+  int meshCount = 0;
+  for (Mn::UnsignedInt i = 0; i != importer->meshCount(); ++i) {
+    Cr::Containers::Optional<Mn::Trade::MeshData> meshData =
+        importer->mesh(i);
+    if (!meshData) {
+      continue;
+    }
+    // with normals, the on-disk format is the same for unlit assets
+    GenericMeshData mesh{true};
+    mesh.setMeshData(*std::move(meshData));
+    mesh.generateLods();
+    Cr::Containers::Array<char> data = MeshCache::serialize(mesh);
+    if (!data.empty()) {
+      writer.add(meshEntry(i), std::move(data));
+      ++meshCount;
+    }
+  }
+
+  int imageCount = 0;
+  for (Mn::UnsignedInt i = 0; i != importer->image2DCount(); ++i) {
+    imageCount += addImage(writer, *importer, i);
+  }
+
+  const std::string navmeshFilename =
+      Cr::Utility::Directory::splitExtension(assetFilename).first +
+      ".navmesh";
+  if (writer.addSource(navmeshFilename)) {
+    writer.add(NavMeshEntry, Cr::Utility::Directory::read(navmeshFilename));
+  }
+
+  if (!core::writeFileAtomically(bundleFilename, writer.write())) {
+    LOG(ERROR) << "SceneBundle::bake(): cannot write " << bundleFilename;
+    return false;
+  }
+  LOG(INFO) << "SceneBundle::bake(): baked " << meshCount << " of "
+            << importer->meshCount() << " meshes and " << imageCount << " of "
+            << importer->image2DCount() << " images of " << assetFilename
+            << " into " << bundleFilename;
+  return true;
+}
+
+}  // namespace assets
+}  // namespace esp
@@ -0,0 +1,126 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_ASSETS_SCENEBUNDLE_H_
+#define ESP_ASSETS_SCENEBUNDLE_H_
+
+/** @file
+ * @brief Class @ref esp::assets::SceneBundle
+ */
+
+#include <Corrade/Containers/Array.h>
+#include <Magnum/Trade/ImageData.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace nav {
+class PathFinder;
+}
+namespace assets {
+
+class GenericMeshData;
+
+/**
+ * @brief Single file with the preprocessed data of a general asset and its
+ * navmesh, baked offline with `datatool bake_scene_bundle`
+ *
+ * The file is a table of named entries followed by their contents, aligned,
+ * each mapped on its own copy-on-write when it's loaded:
+ *
+ * - `mesh/<i>`: mesh `i` of the asset with its levels of detail, in the
+ *   format of @ref MeshCache::serialize(), ready for upload and referenced by
+ *   the collision data;
+ * - `image/<i>`: the formats and sizes of the decoded mip levels of image
+ *   `i`, followed by a `image/<i>/<level>` entry with the pixels of each,
+ *   ready for upload. Compressed images, e.g. Basis files transcoded to a
+ *   format depending on the GPU, aren't baked;
+ * - `navmesh`: the `.navmesh` file of the asset, if there is one.
+ *
+ * The scene hierarchy and the materials are still imported from the asset.
+ * Every entry records the size and modification time of the file it was
+ * baked from, and is ignored once that file changes. A bundle is picked up
+ * when it is named after the asset, see @ref filenameFor().
+ */
+class SceneBundle {
+ public:
+  /** @brief The bundle of @p assetFilename, with the extension replaced */
+  static std::string filenameFor(const std::string& assetFilename);
+
+  /** @brief Entry name of mesh @p index */
+  static std::string meshEntry(int index);
+
+  /** @brief Entry name of image @p index */
+  static std::string imageEntry(int index);
+
+  /**
+   * @brief Bake the bundle of @p assetFilename and of the navmesh next to it
+   * @param assetFilename, a general asset, e.g. a glTF file
+   * @param bundleFilename, the bundle to write, replaced atomically
+   * @return whether the bundle was written
+   */
+  static bool bake(const std::string& assetFilename,
+                   const std::string& bundleFilename);
+
+  /**
+   * @brief Constructor
+   *
+   * Reads the table of entries of @p filename, if it exists and is a bundle
+   * of a known version, and checks which entries are up to date.
+   */
+  explicit SceneBundle(std::string filename);
+
+  /** @brief The bundle file */
+  const std::string& filename() const { return filename_; }
+
+  /** @brief Whether the bundle has up-to-date entries */
+  bool isOpen() const { return !entries_.empty(); }
+
+  /** @brief Whether entry @p name exists and is up to date */
+  bool has(const std::string& name) const { return entries_.count(name); }
+
+  /**
+   * @brief Map the contents of entry @p name, copy-on-write
+   * @return empty if the entry is missing or stale
+   */
+  Corrade::Containers::Array<char> map(const std::string& name) const;
+
+  /**
+   * @brief Load mesh @p index into @p mesh, see @ref MeshCache::load()
+   * Safe to call from multiple threads.
+   */
+  bool loadMesh(int index, bool needsLods, GenericMeshData& mesh) const;
+
+  /**
+   * @brief Load the mip levels of image @p index into @p levels
+   * Safe to call from multiple threads.
+   * @return false if the image isn't baked, leaving @p levels untouched
+   */
+  bool loadImage(int index,
+                 std::vector<Magnum::Trade::ImageData2D>& levels) const;
+
+  /** @brief Load the baked navmesh into @p pathfinder */
+  bool loadNavMesh(nav::PathFinder& pathfinder) const;
+
+ private:
+  struct Entry {
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  std::string filename_;
+  // the up-to-date entries
+  std::unordered_map<std::string, Entry> entries_;
+
+  ESP_SMART_POINTERS(SceneBundle)
+};
+
+}  // namespace assets
+}  // namespace esp
+
+#endif  // ESP_ASSETS_SCENEBUNDLE_H_
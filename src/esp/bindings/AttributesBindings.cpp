@@ -200,6 +200,36 @@ void initAttributesBindings(py::module& m) {
           &ObjectAttributes::setJoinCollisionMeshes,
           R"(Whether collision meshes for objects constructed from this
           template should be joined into a convex hull or kept separate.)")
+      .def_property(
+          "max_hull_vertices", &ObjectAttributes::getMaxHullVertices,
+          &ObjectAttributes::setMaxHullVertices,
+          R"(The maximum number of vertices of each convex collision hull of
+          objects constructed from this template, 0 for no simplification.)")
+      .def_property(
+          "use_convex_decomposition",
+          &ObjectAttributes::getUseConvexDecomposition,
+          &ObjectAttributes::setUseConvexDecomposition,
+          R"(Whether the collision asset of objects constructed from this
+          template should be approximated by a convex decomposition, cached
+          in a .hulls file next to the asset.)")
+      .def_property(
+          "collision_group", &ObjectAttributes::getCollisionGroup,
+          &ObjectAttributes::setCollisionGroup,
+          R"(The physics.CollisionGroup of objects constructed from this
+          template, 0 for the default of their motion type.)")
+      .def_property(
+          "collision_mask", &ObjectAttributes::getCollisionMask,
+          &ObjectAttributes::setCollisionMask,
+          R"(The physics.CollisionGroup values objects constructed from this
+          template collide with, 0 for the default of their motion type.)")
+      .def_property(
+          "static_environment_only",
+          &ObjectAttributes::getStaticEnvironmentOnly,
+          &ObjectAttributes::setStaticEnvironmentOnly,
+          R"(Whether objects constructed from this template only collide with
+          static and kinematic objects and the stage, in the DEBRIS collision
+          group, e.g. for clutter. Overridden by a collision_group or
+          collision_mask.)")
       .def_property(
           "is_visibile", &ObjectAttributes::getIsVisible,
           &ObjectAttributes::setIsVisible,
@@ -301,8 +331,31 @@ void initAttributesBindings(py::module& m) {
                     R"(The timestep to use for forward simulation.)")
       .def_property("max_substeps", &PhysicsManagerAttributes::getMaxSubsteps,
                     &PhysicsManagerAttributes::setMaxSubsteps,
-                    R"(Maximum simulation steps between each rendering step.
-                    (Not currently implemented).)")
+                    R"(Maximum fixed simulation steps a step of the world takes,
+                    0 for no limit.)")
+      .def_property(
+          "skip_if_behind", &PhysicsManagerAttributes::getSkipIfBehind,
+          &PhysicsManagerAttributes::setSkipIfBehind,
+          R"(Whether the time of the steps beyond max_substeps is dropped, slowing
+          the world down, instead of caught up by the next steps.)")
+      .def_property(
+          "render_interpolation",
+          &PhysicsManagerAttributes::getRenderInterpolation,
+          &PhysicsManagerAttributes::setRenderInterpolation,
+          R"(Whether moving objects are drawn between their last two fixed steps,
+          a step behind, rather than predicted ahead of the last one.)")
+      .def_property(
+          "num_threads", &PhysicsManagerAttributes::getNumThreads,
+          &PhysicsManagerAttributes::setNumThreads,
+          R"(The number of threads stepping the simulation. 1 for a single-threaded
+          world, 0 for all threads of Bullet's task scheduler, at most the thread
+          budget of the process. Needs Bullet built with BT_THREADSAFE.)")
+      .def_property(
+          "deterministic", &PhysicsManagerAttributes::getDeterministic,
+          &PhysicsManagerAttributes::setDeterministic,
+          R"(Whether the simulation is bitwise reproducible: stepped on one thread
+          whatever num_threads, with a fixed number of solver iterations. See
+          Simulator.get_physics_state_checksum().)")
       .def_property(
           "gravity", &PhysicsManagerAttributes::getGravity,
           &PhysicsManagerAttributes::setGravity,
@@ -75,6 +75,11 @@ void declareBaseAttributesManager(py::module& m,
           R"(Returns a list of template handles that either contain or explicitly do not
             contain the passed search_str, based on the value of boolean contains.)",
           "search_str"_a = "", "contains"_a = true)
+      .def("get_template_handles_by_prefix",
+           &MgrClass::getObjectHandlesByPrefix,
+           R"(Returns a list of template handles that start with the passed prefix,
+            ignoring case, sorted ignoring case.)",
+           "prefix"_a)
       .def(
           "load_configs",
           static_cast<std::vector<int> (MgrClass::*)(const std::string&, bool)>(
@@ -294,6 +299,13 @@ void initAttributesManagersBindings(py::module& m) {
             is true, then these templates will be unable to be deleted)",
            "path"_a, "save_as_defaults"_a = false)
 
+      .def_property(
+          "lazy_loading", &ObjectAttributesManager::getLazyLoading,
+          &ObjectAttributesManager::setLazyLoading,
+          R"(Whether the configs loaded from now on are only parsed when their
+            templates are first accessed. Their handles are registered as
+            file-based templates right away.)")
+
       // manage file-based templates access
       .def(
           "get_num_file_templates",
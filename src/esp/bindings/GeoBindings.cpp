@@ -4,7 +4,11 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/numpy.h>
+#include <cstring>
+
 #include "esp/geo/OBB.h"
+#include "esp/geo/VoxelGrid.h"
 #include "esp/geo/geo.h"
 
 namespace py = pybind11;
@@ -64,6 +68,57 @@ void initGeoBindings(py::module& m) {
            1.0 is a chordal Catmull-Rom spline)",
       "key_points"_a, "num_interpolations"_a, "alpha"_a = .5f);
 
+  // ==== VoxelGrid ====
+  py::class_<VoxelGrid, VoxelGrid::ptr>(
+      geo, "VoxelGrid",
+      R"(A dense grid of cubic voxels, each EMPTY or holding the semantic id of the surface it contains.)")
+      .def(py::init<const Magnum::Vector3&, float, const Magnum::Vector3i&>(),
+           "origin"_a, "voxel_size"_a, "size"_a)
+      .def_readonly_static("EMPTY", &VoxelGrid::Empty)
+      .def_readonly("origin", &VoxelGrid::origin,
+                    R"(The lower corner of the first voxel.)")
+      .def_readonly("voxel_size", &VoxelGrid::voxelSize)
+      .def_readonly("size", &VoxelGrid::size,
+                    R"(The number of voxels along x, y and z.)")
+      .def_property_readonly(
+          "voxels",
+          [](const VoxelGrid& self) {
+            const Magnum::Vector3i& size = self.size;
+            return py::array_t<uint32_t>(
+                {std::size_t(size.z()), std::size_t(size.y()),
+                 std::size_t(size.x())},
+                self.voxels.data());
+          },
+          R"(A copy of the voxels, indexed by z, y and x.)")
+      .def_property_readonly("num_occupied", &VoxelGrid::numOccupied)
+      .def(
+          "occupied_voxels",
+          [](const VoxelGrid& self) {
+            const std::vector<Magnum::Vector3i> occupied =
+                self.occupiedVoxels();
+            py::array_t<int> coordinates({occupied.size(), std::size_t(3)});
+            std::memcpy(coordinates.mutable_data(), occupied.data(),
+                        occupied.size() * sizeof(Magnum::Vector3i));
+            return coordinates;
+          },
+          R"(The x, y and z of the voxels that are not EMPTY, a sparse grid.)")
+      .def(
+          "save",
+          [](const VoxelGrid& self, const std::string& filename) {
+            return saveVoxelGrid(self, filename);
+          },
+          "filename"_a)
+      .def_static(
+          "load",
+          [](const std::string& filename) -> VoxelGrid::ptr {
+            auto grid = VoxelGrid::create();
+            if (!loadVoxelGrid(filename, *grid))
+              return nullptr;
+            return grid;
+          },
+          "filename"_a,
+          R"(Load a grid saved by save() or the create_voxel_grid task of datatool, None if it is not a valid grid.)");
+
 }  // initGeoBindings
 
 }  // namespace geo
@@ -4,6 +4,9 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/numpy.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
@@ -14,10 +17,12 @@
 #include "python/corrade/EnumOperators.h"
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/GpuDevices.h"
 #include "esp/gfx/LightSetup.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/Renderer.h"
+#include "esp/gfx/TextureStreamer.h"
 #include "esp/scene/SemanticScene.h"
 
 namespace py = pybind11;
@@ -51,6 +56,11 @@ void initGfxBindings(py::module& m) {
 
   flags.value("FRUSTUM_CULLING", RenderCamera::Flag::FrustumCulling)
       .value("OBJECTS_ONLY", RenderCamera::Flag::ObjectsOnly)
+      .value("OCCLUSION_CULLING", RenderCamera::Flag::OcclusionCulling)
+      .value("PRESERVE_DRAW_ORDER", RenderCamera::Flag::PreserveDrawOrder)
+      .value("DEPTH_ONLY", RenderCamera::Flag::DepthOnly)
+      .value("OBJECT_ID_ONLY", RenderCamera::Flag::ObjectIdOnly)
+      .value("LINEAR_DEPTH", RenderCamera::Flag::LinearDepth)
       .value("NONE", RenderCamera::Flag{});
   corrade::enumOperators(flags);
 
@@ -87,7 +97,8 @@ void initGfxBindings(py::module& m) {
           },
           R"(Draw given scene using the visual sensor)", "visualSensor"_a,
           "scene"_a,
-          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling})
+          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling},
+          py::call_guard<py::gil_scoped_release>())
       .def(
           "draw",
           [](Renderer& self, RenderCamera& camera,
@@ -95,8 +106,113 @@ void initGfxBindings(py::module& m) {
             self.draw(camera, sceneGraph, RenderCamera::Flags{flags});
           },
           R"(Draw given scene using the camera)", "camera"_a, "scene"_a,
-          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling})
-      .def("bind_render_target", &Renderer::bindRenderTarget);
+          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling},
+          py::call_guard<py::gil_scoped_release>())
+      .def("bind_render_target", &Renderer::bindRenderTarget,
+           R"(Bind a RenderTarget to the sensor. With top_down_rows, it is
+           drawn upside down so that its reads have top-down rows, like
+           observations, and need no flipping.)",
+           "sensor"_a, "top_down_rows"_a = false)
+      .def("release_render_target", &Renderer::releaseRenderTarget,
+           R"(Unbind the RenderTarget of the sensor into the pool that
+           bind_render_target reuses the render targets of, e.g. before the
+           sensor is removed.)",
+           "sensor"_a)
+      .def("set_render_target_pool_capacity",
+           &Renderer::setRenderTargetPoolCapacity,
+           R"(Set how many released render targets the pool keeps, the
+           oldest are destroyed first. 0 destroys them on release.)",
+           "capacity"_a)
+      .def_property_readonly("render_target_pool_size",
+                             &Renderer::renderTargetPoolSize,
+                             R"(The number of released render targets in the
+                             pool.)")
+      .def("reset_occlusion_culling", &Renderer::resetOcclusionCulling,
+           R"(Drop the occlusion culling history of all sensors and cameras.)")
+      .def(
+          "query_visibility",
+          [](Renderer& self, sensor::VisualSensor& sensor,
+             scene::SceneGraph& sceneGraph,
+             const std::vector<Mn::Matrix4>& poses,
+             const std::vector<scene::SceneNode*>& objects,
+             RenderCamera::Flag flags) {
+            return self.queryVisibility(sensor, sceneGraph, poses, objects,
+                                        RenderCamera::Flags{flags});
+          },
+          R"(The fraction of each of the objects, scene nodes, visible
+          from each of the poses, absolute mn.Matrix4 transformations of the
+          sensor, with occlusion queries, as a flat list of the objects of the
+          first pose first. Overwrites the render target of the sensor.)",
+          "sensor"_a, "scene"_a, "poses"_a, "objects"_a,
+          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling},
+          py::call_guard<py::gil_scoped_release>())
+      .def("create_batch_render_target", &Renderer::createBatchRenderTarget,
+           R"(Create a RenderTarget holding batch_size tiles of the
+           reference sensor's resolution, for use with draw_batch.)",
+           "reference_sensor"_a, "batch_size"_a)
+      .def(
+          "draw_batch",
+          [](Renderer& self, RenderTarget& target,
+             const std::vector<sensor::VisualSensor*>& sensors,
+             const std::vector<scene::SceneGraph*>& scenes,
+             RenderCamera::Flag flags) {
+            if (sensors.size() != scenes.size()) {
+              throw py::value_error{
+                  "draw_batch: sensors and scenes must have the same length"};
+            }
+            std::vector<Renderer::BatchEntry> batch;
+            batch.reserve(sensors.size());
+            for (size_t i = 0; i < sensors.size(); ++i) {
+              batch.push_back(Renderer::BatchEntry{
+                  *sensors[i], *scenes[i], RenderCamera::Flags{flags}});
+            }
+            self.drawBatch(target, batch);
+          },
+          R"(Draw each (sensor, scene) pair into its own tile of target. A
+          single read of target then returns the observations of the batch.)",
+          "target"_a, "sensors"_a, "scenes"_a,
+          "flags"_a = RenderCamera::Flag{RenderCamera::Flag::FrustumCulling},
+          py::call_guard<py::gil_scoped_release>())
+      .def_static("batch_tile_viewport", &Renderer::batchTileViewport,
+                  R"(The viewport of tile index in a batch of batch_size.)",
+                  "tile_size"_a, "batch_size"_a, "index"_a);
+
+  py::class_<TextureStreamer> textureStreamer{
+      m, "TextureStreamer",
+      R"(Keeps the textures of the loaded assets within a GPU memory budget.)"};
+  py::class_<TextureStreamer::Statistics>(textureStreamer, "Statistics")
+      .def_readonly("budget_bytes", &TextureStreamer::Statistics::budgetBytes)
+      .def_readonly("resident_bytes",
+                    &TextureStreamer::Statistics::residentBytes)
+      .def_readonly("host_bytes", &TextureStreamer::Statistics::hostBytes)
+      .def_readonly("num_textures", &TextureStreamer::Statistics::numTextures)
+      .def_readonly("num_streamed_levels",
+                    &TextureStreamer::Statistics::numStreamedLevels)
+      .def_readonly("num_evicted_levels",
+                    &TextureStreamer::Statistics::numEvictedLevels)
+      .def_readonly("num_budget_misses",
+                    &TextureStreamer::Statistics::numBudgetMisses)
+      .def_readonly("uploaded_bytes",
+                    &TextureStreamer::Statistics::uploadedBytes);
+  textureStreamer
+      .def_property("budget", &TextureStreamer::budget,
+                    &TextureStreamer::setBudget,
+                    R"(The GPU memory budget in bytes, 0 if unlimited.)")
+      .def("statistics", &TextureStreamer::statistics);
+
+  py::class_<ObjectIdRemapping, ObjectIdRemapping::ptr>(m, "ObjectIdRemapping",
+                                                       R"(
+      Lookup table remapping object ids on the GPU, ids beyond the table are
+      remapped to unmapped_value. Needs a GL context.)")
+      .def(py::init([](const std::vector<Mn::UnsignedInt>& table,
+                       Mn::UnsignedInt unmappedValue) {
+             return ObjectIdRemapping::create(
+                 Corrade::Containers::arrayView(table), unmappedValue);
+           }),
+           "table"_a, "unmapped_value"_a = 0)
+      .def_property_readonly("size", &ObjectIdRemapping::size)
+      .def_property_readonly("unmapped_value",
+                             &ObjectIdRemapping::unmappedValue);
 
   py::class_<RenderTarget>(m, "RenderTarget")
       .def("__enter__",
@@ -108,13 +224,78 @@ void initGfxBindings(py::module& m) {
            [](RenderTarget& self, const py::object&, const py::object&,
               const py::object&) { self.renderExit(); })
       .def("read_frame_rgba", &RenderTarget::readFrameRgba,
-           "Reads RGBA frame into passed img in uint8 byte format.")
-      .def("read_frame_depth", &RenderTarget::readFrameDepth)
-      .def("read_frame_object_id", &RenderTarget::readFrameObjectId)
+           R"(Reads RGBA frame into passed img in uint8 byte format, or RGB
+          if img is RGB8_UNORM.)",
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_depth", &RenderTarget::readFrameDepth,
+           R"(Reads depth into passed img, as float meters for R32F, half
+          floats for R16F or uint16 millimeters for R16UI.)",
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_object_id", &RenderTarget::readFrameObjectId,
+           R"(Reads the object ids into passed img, of R32UI, R32I, R16UI or
+          R8UI, remapped on the GPU through the lookup table of remapping if
+          it's not None.)",
+           "img"_a, "remapping"_a = nullptr,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "read_frame_object_id_histogram",
+          [](RenderTarget& self, std::size_t binCount,
+             ObjectIdRemapping* remapping) {
+            py::array_t<Mn::UnsignedInt> counts(binCount);
+            self.readFrameObjectIdHistogram({counts.mutable_data(), binCount},
+                                            remapping);
+            return counts;
+          },
+          R"(The number of pixels of each object id below bin_count, counted
+          on the GPU, by the values of the ids in the lookup table of
+          remapping if it's not None.)",
+          "bin_count"_a, "remapping"_a = nullptr)
+      .def("read_frame_normal", &RenderTarget::readFrameNormal,
+           R"(Reads the unit surface normals in the camera frame, reconstructed
+          from the depth on the GPU, into passed RGB32F img.)",
+           py::call_guard<py::gil_scoped_release>())
+      .def("read_frame_points", &RenderTarget::readFramePoints,
+           R"(Reads the points unprojected from the depth on the GPU into
+          passed RGB32F img of point_cloud_size(stride), transformed from the
+          camera frame by transformation, zero where nothing was drawn.)",
+           "img"_a, "transformation"_a = Mn::Matrix4{}, "stride"_a = 1,
+           py::call_guard<py::gil_scoped_release>())
+      .def("point_cloud_size", &RenderTarget::pointCloudSize,
+           R"(The size of the points of read_frame_points() subsampled by
+          stride.)",
+           "stride"_a = 1)
       .def("blit_rgba_to_default", &RenderTarget::blitRgbaToDefault)
+      .def_property_readonly(
+          "top_down_rows", &RenderTarget::topDownRows,
+          R"(Whether the reads have their first row at the top of the image.)")
+      .def("read_frame_rgba_async", &RenderTarget::readFrameRgbaAsync,
+           R"(Start an asynchronous RGBA, or RGB8_UNORM, read; retrieve it
+          with fence().)",
+           "format"_a = Mn::PixelFormat::RGBA8Unorm)
+      .def("read_frame_depth_async", &RenderTarget::readFrameDepthAsync,
+           R"(Start an asynchronous depth read in one of the formats of
+          read_frame_depth(); retrieve it with fence().)",
+           "format"_a = Mn::PixelFormat::R32F)
+      .def("read_frame_object_id_async",
+           &RenderTarget::readFrameObjectIdAsync,
+           R"(Start an asynchronous object id read in one of the formats of
+          read_frame_object_id(); retrieve it with fence().)",
+           "format"_a = Mn::PixelFormat::R32UI, "remapping"_a = nullptr)
+      .def("read_frame_normal_async", &RenderTarget::readFrameNormalAsync,
+           "Start an asynchronous normal read; retrieve it with fence().")
+      .def("read_frame_points_async", &RenderTarget::readFramePointsAsync,
+           "Start an asynchronous point read; retrieve it with fence().",
+           "transformation"_a = Mn::Matrix4{}, "stride"_a = 1)
+      .def_property_readonly("has_pending_read", &RenderTarget::hasPendingRead)
+      .def("is_pending_read_ready", &RenderTarget::isPendingReadReady,
+           "Whether fence() would return without blocking.")
+      .def("fence", &RenderTarget::fence,
+           "Wait for the pending asynchronous read and copy it into img.",
+           py::call_guard<py::gil_scoped_release>())
 #ifdef ESP_BUILD_WITH_CUDA
       .def("read_frame_rgba_gpu",
-           [](RenderTarget& self, size_t devPtr) {
+           [](RenderTarget& self, size_t devPtr, Mn::PixelFormat format,
+              size_t stream) {
              /*
               * Python has no concept of a pointer, so PyTorch thus exposes the
               pointer to CUDA memory as a simple size_t
@@ -128,21 +309,77 @@ void initGfxBindings(py::module& m) {
               *
               * so reinterpret_cast<uint8_t*> simply undoes the
               reinterpret_cast<size_t>
+              *
+              * The stream is a cudaStream_t the same way, e.g.
+              torch.cuda.Stream.cuda_stream
               */
 
-             self.readFrameRgbaGPU(reinterpret_cast<uint8_t*>(devPtr));
-           })
+             self.readFrameRgbaGPU(reinterpret_cast<uint8_t*>(devPtr), format,
+                                   reinterpret_cast<CUstream_st*>(stream));
+           },
+           "dev_ptr"_a, "format"_a = Mn::PixelFormat::RGBA8Unorm,
+           "stream"_a = 0, py::call_guard<py::gil_scoped_release>(),
+           R"(Read into CUDA memory, enqueued on the CUDA stream, the legacy
+           default stream if 0, without waiting for the copy. The same for the
+           other GPU reads.)")
       .def("read_frame_depth_gpu",
-           [](RenderTarget& self, size_t devPtr) {
-             self.readFrameDepthGPU(reinterpret_cast<float*>(devPtr));
-           })
-      .def("read_frame_object_id_gpu",
-           [](RenderTarget& self, size_t devPtr) {
-             self.readFrameObjectIdGPU(reinterpret_cast<int32_t*>(devPtr));
-           })
+           [](RenderTarget& self, size_t devPtr, Mn::PixelFormat format,
+              size_t stream) {
+             self.readFrameDepthGPU(reinterpret_cast<void*>(devPtr), format,
+                                    reinterpret_cast<CUstream_st*>(stream));
+           },
+           "dev_ptr"_a, "format"_a = Mn::PixelFormat::R32F, "stream"_a = 0,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "read_frame_object_id_gpu",
+          [](RenderTarget& self, size_t devPtr, Mn::PixelFormat format,
+             ObjectIdRemapping* remapping, size_t stream) {
+            self.readFrameObjectIdGPU(reinterpret_cast<void*>(devPtr), format,
+                                      remapping,
+                                      reinterpret_cast<CUstream_st*>(stream));
+          },
+          "dev_ptr"_a, "format"_a = Mn::PixelFormat::R32UI,
+          "remapping"_a = nullptr, "stream"_a = 0,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "read_frame_normal_gpu",
+          [](RenderTarget& self, size_t devPtr, size_t stream) {
+            self.readFrameNormalGPU(reinterpret_cast<float*>(devPtr),
+                                    reinterpret_cast<CUstream_st*>(stream));
+          },
+          "dev_ptr"_a, "stream"_a = 0, py::call_guard<py::gil_scoped_release>())
+      .def(
+          "read_frame_points_gpu",
+          [](RenderTarget& self, size_t devPtr,
+             const Mn::Matrix4& transformation, int stride, size_t stream) {
+            self.readFramePointsGPU(reinterpret_cast<float*>(devPtr),
+                                    transformation, stride,
+                                    reinterpret_cast<CUstream_st*>(stream));
+          },
+          "dev_ptr"_a, "transformation"_a = Mn::Matrix4{}, "stride"_a = 1,
+          "stream"_a = 0, py::call_guard<py::gil_scoped_release>())
 #endif
       .def("render_enter", &RenderTarget::renderEnter)
-      .def("render_exit", &RenderTarget::renderExit);
+      .def("render_enter_linear_depth", &RenderTarget::renderEnterLinearDepth,
+           R"(Like render_enter(), for a pass drawn with the LINEAR_DEPTH flag.
+          Returns whether the pass writes the linear depth.)")
+      .def("render_exit", &RenderTarget::renderExit)
+      .def_property_readonly("framebuffer_size",
+                             &RenderTarget::framebufferSize)
+      .def("set_read_region", &RenderTarget::setReadRegion,
+           R"(Restrict the reads to region, in the rows of the reads, sampling
+          the centers of its stride x stride blocks on the GPU. The whole
+          framebuffer if region is empty.)",
+           "region"_a, "stride"_a = 1)
+      .def_property_readonly("read_region", &RenderTarget::readRegion)
+      .def_property_readonly("read_stride", &RenderTarget::readStride)
+      .def_property_readonly(
+          "read_size", &RenderTarget::readSize,
+          R"(The size of the reads, read_region subsampled by read_stride.)")
+      .def_property_readonly(
+          "samples", &RenderTarget::samples,
+          R"(Samples per pixel of the multisample anti-aliasing, 1 if it's
+          disabled.)");
 
   py::enum_<LightPositionModel>(
       m, "LightPositionModel",
@@ -163,11 +400,33 @@ void initGfxBindings(py::module& m) {
       .def_readwrite("vector", &LightInfo::vector)
       .def_readwrite("color", &LightInfo::color)
       .def_readwrite("model", &LightInfo::model)
+      .def_readwrite("range", &LightInfo::range,
+                     R"(Distance past which a point light has no effect,
+                     infinite by default.)")
       .def(py::self == py::self)
       .def(py::self != py::self);
 
   m.attr("DEFAULT_LIGHTING_KEY") = DEFAULT_LIGHTING_KEY;
   m.attr("NO_LIGHT_KEY") = NO_LIGHT_KEY;
+
+  py::class_<GpuDevice>(m, "GpuDevice",
+                        R"(A GPU that contexts can be created on.)")
+      .def_readonly("device", &GpuDevice::device,
+                    R"(The CUDA device id, as taken by gpu_device_id.)")
+      .def_readonly("name", &GpuDevice::name)
+      .def_readonly("total_memory", &GpuDevice::totalMemory,
+                    R"(Memory of the device in bytes, 0 if unknown.)")
+      .def_readonly("used_memory", &GpuDevice::usedMemory,
+                    R"(Memory used by all processes in bytes, 0 if unknown.)")
+      .def_readonly("num_contexts", &GpuDevice::numContexts,
+                    R"(The number of contexts this process has on the device.)");
+  m.def(
+      "query_gpu_devices", &queryGpuDevices,
+      R"(The GPUs of the system with their memory use, from the NVIDIA management library if it's installed, in the order of their PCI bus ids.)");
+  m.def(
+      "least_loaded_gpu_device", &leastLoadedGpuDevice,
+      R"(The GPU the next context is placed on with gpu_device_id = AUTO_GPU_DEVICE: the one using the least memory, then with the fewest contexts of this process, spreading processes of equal load by their process id.)");
+  m.attr("AUTO_GPU_DEVICE") = AUTO_GPU_DEVICE;
 }
 
 }  // namespace gfx
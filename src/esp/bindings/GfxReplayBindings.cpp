@@ -26,9 +26,18 @@ void initGfxReplayBindings(py::module& m) {
           "set_keyframe_index", &Player::setKeyframeIndex,
           R"(Set a keyframe by index, or pass -1 to clear the currently-set keyframe.)")
 
+      .def(
+          "set_interpolated_keyframe_index",
+          &Player::setInterpolatedKeyframeIndex, "frame_index"_a,
+          R"(Set a fractional keyframe index: the keyframe of its integer part is set and the instances updated by the next keyframe are interpolated toward it, e.g. to play a recording of 5 keyframes per second at 30 frames per second with frame f at f * 5 / 30.)")
+
       .def("get_keyframe_index", &Player::getKeyframeIndex,
            R"(Get the number of keyframes read from file.)")
 
+      .def_property("snapshot_interval", &Player::getSnapshotInterval,
+                    &Player::setSnapshotInterval,
+                    R"(The number of keyframes between the full-state snapshots that seeking starts from, 0 if disabled.)")
+
       .def(
           "get_user_transform",
           [](Player& self, const std::string& name) {
@@ -81,6 +90,65 @@ void initGfxReplayBindings(py::module& m) {
           },
           R"(Write all saved keyframes to a file, then discard the keyframes.)")
 
+      .def(
+          "start_streaming_to_file",
+          [](ReplayManager& self, const std::string& filepath,
+             int keyframesPerChunk, float translationQuantum) {
+            if (!self.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            return self.getRecorder()->startStreamingToFile(
+                filepath, keyframesPerChunk, translationQuantum);
+          },
+          "filepath"_a, "keyframes_per_chunk"_a = 64,
+          "translation_quantum"_a = 1e-4f,
+          R"(Write the saved keyframes and the ones saved afterwards to a compact binary file as they are saved, rather than keeping them in memory. The translations of the instances are stored in multiples of translation_quantum meters. Returns whether the file could be opened. read_keyframes_from_file reads the file like a JSON one.)")
+
+      .def(
+          "set_state_update_thresholds",
+          [](ReplayManager& self, float translationThreshold,
+             float rotationThreshold) {
+            if (!self.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            self.getRecorder()->setStateUpdateThresholds(translationThreshold,
+                                                         rotationThreshold);
+          },
+          "translation"_a, "rotation"_a,
+          R"(Set how far, in meters and radians, an instance has to move from its last saved state before its state is saved again. 0 saves any change.)")
+
+      .def(
+          "stop_streaming",
+          [](ReplayManager& self) {
+            if (!self.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            self.getRecorder()->stopStreaming();
+          },
+          R"(Write the last streamed keyframes and close the file.)")
+
+      .def(
+          "start_keyframe_server",
+          [](ReplayManager& self, int port, float translationQuantum) {
+            if (!self.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            return self.startKeyframeServer(port, translationQuantum);
+          },
+          "port"_a = 8765, "translation_quantum"_a = 1e-4f,
+          R"(Serve each saved keyframe to remote viewers, e.g. the bindings_js ReplayClient, over a WebSocket on port, or any free port for 0. Returns the port, or -1 if the server couldn't listen.)")
+
+      .def("stop_keyframe_server", &ReplayManager::stopKeyframeServer,
+           R"(Stop serving keyframes and disconnect the viewers.)")
+
       .def("read_keyframes_from_file", &ReplayManager::readKeyframesFromFile,
            R"(Create a Player object from a replay file.)");
 }
@@ -17,11 +17,30 @@ namespace metadata {
 
 void initMetadataMediatorBindings(py::module& m) {
   py::class_<MetadataMediator, MetadataMediator::ptr>(m, "MetadataMediator")
+      .def(py::init(&MetadataMediator::create<const std::string&>),
+           "dataset"_a = "default",
+           R"(Load the scene dataset config, or create an empty dataset of that name.)")
       .def_property(
           "active_dataset", &MetadataMediator::getActiveSceneDatasetName,
           &MetadataMediator::setActiveSceneDatasetName,
           R"(The currently active dataset being used.  Will attempt to load
             configuration files specified if does not already exist.)")
+      .def_property(
+          "lazy_object_loading", &MetadataMediator::getLazyObjectLoading,
+          &MetadataMediator::setLazyObjectLoading,
+          R"(Whether the datasets loaded from now on only parse their object
+            configs when the templates are first accessed, for datasets of
+            many more objects than are used at a time.)")
+      .def_property(
+          "use_dataset_index", &MetadataMediator::getUseDatasetIndex,
+          &MetadataMediator::setUseDatasetIndex,
+          R"(Whether the datasets loaded from now on take the configs found in
+            their paths from the index next to their config, when it is up to
+            date, instead of listing the directories.)")
+      .def("build_dataset_index", &MetadataMediator::buildDatasetIndex,
+           "dataset"_a,
+           R"(Search all the paths of the dataset config and save what was
+            found as its index, next to it. Returns whether it was saved.)")
 
       /* --- Template Manager accessors --- */
       .def_property_readonly(
@@ -1,4 +1,7 @@
 #include "esp/bindings/bindings.h"
+
+#include <pybind11/numpy.h>
+
 #include "esp/physics/PhysicsManager.h"
 #include "esp/physics/RigidObject.h"
 
@@ -22,6 +25,14 @@ void initPhysicsBindings(py::module& m) {
       .value("KINEMATIC", MotionType::KINEMATIC)
       .value("DYNAMIC", MotionType::DYNAMIC);
 
+  // ==== enum object CollisionGroup ====
+  py::enum_<CollisionGroup>(m, "CollisionGroup", py::arithmetic())
+      .value("DEFAULT", CollisionGroup::DEFAULT)
+      .value("STATIC", CollisionGroup::STATIC)
+      .value("DEBRIS", CollisionGroup::DEBRIS)
+      .value("STAGE", CollisionGroup::STAGE)
+      .value("ALL", CollisionGroup::ALL);
+
   // ==== struct object VelocityControl ====
   py::class_<VelocityControl, VelocityControl::ptr>(m, "VelocityControl")
       .def(py::init(&VelocityControl::create<>))
@@ -48,6 +59,65 @@ void initPhysicsBindings(py::module& m) {
       .def_readonly("hits", &RaycastResults::hits)
       .def_readonly("ray", &RaycastResults::ray)
       .def("has_hits", &RaycastResults::hasHits);
+
+  // ==== struct object MultiRaycastResults ====
+  // the arrays view the results, which they keep alive
+  auto vectorsArray = [](py::object self, std::vector<Magnum::Vector3>& v) {
+    return py::array_t<float>({v.size(), std::size_t(3)},
+                              v.empty() ? nullptr : v.data()->data(), self);
+  };
+  py::class_<MultiRaycastResults, MultiRaycastResults::ptr>(
+      m, "MultiRaycastResults")
+      .def(py::init(&MultiRaycastResults::create<>))
+      .def_property_readonly(
+          "hit_offsets",
+          [](py::object self) {
+            auto& v = self.cast<MultiRaycastResults&>().hitOffsets;
+            return py::array_t<int>(v.size(), v.data(), self);
+          },
+          R"(The hits of ray i are the entries [hit_offsets[i], hit_offsets[i + 1]) of the other arrays, sorted by distance.)")
+      .def_property_readonly(
+          "object_ids",
+          [](py::object self) {
+            auto& v = self.cast<MultiRaycastResults&>().objectIds;
+            return py::array_t<int>(v.size(), v.data(), self);
+          },
+          R"(The ids of the objects hit, -1 for the stage.)")
+      .def_property_readonly(
+          "points",
+          [vectorsArray](py::object self) {
+            return vectorsArray(self,
+                                self.cast<MultiRaycastResults&>().points);
+          },
+          R"(The hit points in world space, as a hits x 3 array.)")
+      .def_property_readonly(
+          "normals",
+          [vectorsArray](py::object self) {
+            return vectorsArray(self,
+                                self.cast<MultiRaycastResults&>().normals);
+          },
+          R"(The collision object normals at the hit points, as a hits x 3 array.)")
+      .def_property_readonly(
+          "ray_distances",
+          [](py::object self) {
+            auto& v = self.cast<MultiRaycastResults&>().rayDistances;
+            return py::array_t<double>(v.size(), v.data(), self);
+          },
+          R"(The distances of the hits along the ray directions, in units of ray length.)")
+      .def_property_readonly("num_rays", &MultiRaycastResults::numRays)
+      .def_property_readonly("num_hits", &MultiRaycastResults::numHits);
+
+  // ==== struct object SweepResult ====
+  py::class_<SweepResult, SweepResult::ptr>(m, "SweepResult")
+      .def(py::init(&SweepResult::create<>))
+      .def_readonly("has_hit", &SweepResult::hasHit)
+      .def_readonly("object_id", &SweepResult::objectId,
+                    R"(The id of the object hit, -1 for the stage.)")
+      .def_readonly(
+          "time_of_impact", &SweepResult::timeOfImpact,
+          R"(The fraction of the path travelled before the impact, 1 without hit.)")
+      .def_readonly("point", &SweepResult::point)
+      .def_readonly("normal", &SweepResult::normal);
 }
 
 }  // namespace physics
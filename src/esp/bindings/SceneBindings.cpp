@@ -4,6 +4,9 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
+
 #include <Magnum/Magnum.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 
@@ -16,6 +19,7 @@
 #include "esp/scene/SceneManager.h"
 #include "esp/scene/SceneNode.h"
 #include "esp/scene/SemanticScene.h"
+#include "esp/scene/SemanticSpatialIndex.h"
 #include "esp/scene/SuncgSemanticScene.h"
 
 namespace py = pybind11;
@@ -24,6 +28,27 @@ using py::literals::operator""_a;
 namespace esp {
 namespace scene {
 
+namespace {
+
+using StateArray =
+    py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// View on a nodes x 7 array as the core::RigidState of each node
+Corrade::Containers::ArrayView<core::RigidState> rigidStatesView(
+    StateArray& states,
+    std::size_t count) {
+  constexpr ssize_t components = sizeof(core::RigidState) / sizeof(float);
+  if (states.ndim() != 2 || std::size_t(states.shape(0)) != count ||
+      states.shape(1) != components) {
+    throw std::invalid_argument(
+        "SceneNode: expected the states as an array of " +
+        std::to_string(count) + " x " + std::to_string(components));
+  }
+  return {reinterpret_cast<core::RigidState*>(states.mutable_data()), count};
+}
+
+}  // namespace
+
 void initSceneBindings(py::module& m) {
   // ==== SceneGraph ====
 
@@ -68,7 +93,31 @@ void initSceneBindings(py::module& m) {
           "mesh_bb", &SceneNode::getMeshBB,
           R"(The axis aligned bounding box of the mesh drawables attached to this node.)")
       .def_property_readonly("absolute_translation",
-                             &SceneNode::absoluteTranslation);
+                             &SceneNode::absoluteTranslation)
+      .def_static(
+          "get_rigid_states",
+          [](const std::vector<SceneNode*>& nodes, py::object out) {
+            StateArray states = out.is_none()
+                                    ? StateArray({nodes.size(), std::size_t{7}})
+                                    : out.cast<StateArray>();
+            if (!out.is_none() && states.ptr() != out.ptr()) {
+              throw std::invalid_argument(
+                  "SceneNode: out has to be a C-contiguous float32 array");
+            }
+            getRigidStates({nodes.data(), nodes.size()},
+                           rigidStatesView(states, nodes.size()));
+            return states;
+          },
+          R"(The transformations of the nodes relative to their parents, as a nodes x 7 float32 array of rotation quaternions in x, y, z, w order followed by translations, the layout of RigidState. Written into out if given, so reading e.g. the bodies of many agents each step allocates no arrays.)",
+          "nodes"_a, "out"_a = py::none())
+      .def_static(
+          "set_rigid_states",
+          [](const std::vector<SceneNode*>& nodes, StateArray states) {
+            setRigidStates({nodes.data(), nodes.size()},
+                           rigidStatesView(states, nodes.size()));
+          },
+          R"(Set the transformations of the nodes relative to their parents from a nodes x 7 array in the layout of get_rigid_states().)",
+          "nodes"_a, "states"_a);
 
   py::class_<SceneGraph>(m, "SceneGraph")
       .def(py::init())
@@ -236,7 +285,67 @@ void initSceneBindings(py::module& m) {
       .def_property_readonly("semantic_index_map",
                              &SemanticScene::getSemanticIndexMap)
       .def("semantic_index_to_object_index",
-           &SemanticScene::semanticIndexToObjectIndex);
+           &SemanticScene::semanticIndexToObjectIndex)
+      .def("semantic_id_to_category_index",
+           &SemanticScene::semanticIdToCategoryIndex,
+           R"(The table from the semantic ids of the objects, the ids of
+          semantic observations, to the index of their category under
+          mapping, 0 for ids of no object or of objects with no category.)",
+           "mapping"_a = "")
+      .def("semantic_id_to_instance_id", &SemanticScene::semanticIdToInstanceId,
+           R"(The table from the semantic ids of the objects to compact
+          instance ids, numbering the objects from 1 in increasing semantic id
+          order, 0 for ids of no object.)");
+
+  // ==== SemanticSpatialIndex ====
+  py::class_<SemanticSpatialIndex, SemanticSpatialIndex::ptr>(
+      m, "SemanticSpatialIndex", R"(
+        Point and radius queries against the objects and regions of a
+        :py:class:`SemanticScene`, built once over their bounding boxes.
+        Objects and regions are reported by their index in
+        :py:attr:`SemanticScene.objects` and :py:attr:`SemanticScene.regions`.
+      )")
+      .def(py::init(&SemanticSpatialIndex::create<const SemanticScene&>),
+           "scene"_a)
+      .def("objects_at",
+           py::overload_cast<const vec3f&>(&SemanticSpatialIndex::objectsAt,
+                                           py::const_),
+           R"(
+        The objects whose OBB contains the point, in increasing index order.
+      )",
+           "point"_a)
+      .def("region_at", &SemanticSpatialIndex::regionAt, R"(
+        The region that contains the point, the smallest one if several do,
+        -1 if none does.
+      )",
+           "point"_a)
+      .def("objects_in_radius",
+           py::overload_cast<const vec3f&, float>(
+               &SemanticSpatialIndex::objectsInRadius, py::const_),
+           R"(
+        The objects whose OBB is at most radius from the point, nearest first.
+      )",
+           "point"_a, "radius"_a)
+      .def("batch_objects_at",
+           py::overload_cast<const std::vector<vec3f>&>(
+               &SemanticSpatialIndex::objectsAt, py::const_),
+           R"(
+        :py:meth:`objects_at` for each of the points.
+      )",
+           "points"_a, py::call_guard<py::gil_scoped_release>())
+      .def("batch_regions_at", &SemanticSpatialIndex::regionsAt, R"(
+        :py:meth:`region_at` for each of the points.
+      )",
+           "points"_a, py::call_guard<py::gil_scoped_release>())
+      .def("batch_objects_in_radius",
+           py::overload_cast<const std::vector<vec3f>&, float>(
+               &SemanticSpatialIndex::objectsInRadius, py::const_),
+           R"(
+        :py:meth:`objects_in_radius` for each of the points.
+      )",
+           "points"_a, "radius"_a, py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("num_objects", &SemanticSpatialIndex::numObjects)
+      .def_property_readonly("num_regions", &SemanticSpatialIndex::numRegions);
 
   // ==== ObjectControls ====
   py::class_<ObjectControls, ObjectControls::ptr>(m, "ObjectControls")
@@ -244,7 +353,32 @@ void initSceneBindings(py::module& m) {
       .def("action", &ObjectControls::action, R"(
         Take action using this :py:class:`ObjectControls`.
       )",
-           "object"_a, "name"_a, "amount"_a, "apply_filter"_a = true);
+           "object"_a, "name"_a, "amount"_a, "apply_filter"_a = true)
+      .def_static("action_id", &ObjectControls::actionId, R"(
+        The id of a built-in action for :py:meth:`action_batch`, -1 for other
+        actions.
+      )",
+                  "name"_a)
+      .def(
+          "action_batch",
+          [](ObjectControls& self, const std::vector<int>& actionIds,
+             const std::vector<float>& amounts,
+             std::vector<core::RigidState> states, bool applyFilter) {
+            std::vector<bool> collided =
+                self.actionBatch(actionIds, amounts, states, applyFilter);
+            return py::make_tuple(std::move(states), std::move(collided));
+          },
+          R"(
+        Take one action with each of many objects at once, on their states.
+        Returns the new states and whether each move collided.
+      )",
+          "action_ids"_a, "amounts"_a, "states"_a, "apply_filter"_a = true)
+      .def("set_batch_move_filter_function",
+           &ObjectControls::setBatchMoveFilterFunction, R"(
+        Set the function filtering all the moves of :py:meth:`action_batch` at
+        once, e.g. :py:meth:`PathFinder.try_step_batch`.
+      )",
+           "filter"_a);
 }
 
 }  // namespace scene
@@ -4,19 +4,30 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/numpy.h>
+
 #include <Magnum/Magnum.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 
 #include <Magnum/PythonBindings.h>
 #include <Magnum/SceneGraph/PythonBindings.h>
 
+#include <cstring>
 #include <utility>
 
+#include "esp/gfx/RenderTarget.h"
 #include "esp/sensor/CameraSensor.h"
+#include "esp/sensor/LidarSensor.h"
+#include "esp/sensor/ObjectIdRuns.h"
+#include "esp/sensor/ObservationRecorder.h"
 #ifdef ESP_BUILD_WITH_CUDA
+#include "esp/sensor/DeviceBuffer.h"
 #include "esp/sensor/RedwoodNoiseModel.h"
+#include "esp/sensor/RgbNoiseModel.h"
 #endif
+#include "esp/sensor/RedwoodNoiseModelCPU.h"
 #include "esp/sensor/Sensor.h"
+#include "esp/sensor/SharedObservationRing.h"
 #include "esp/sim/Simulator.h"
 
 namespace py = pybind11;
@@ -31,6 +42,136 @@ esp::scene::SceneNode* nodeGetter(T& self) {
     throw py::value_error{"feature not valid"};
   return &self.node();
 };
+
+// the numpy type of the elements of a SharedObservationRing field
+py::dtype ringFieldDtype(const esp::core::DataType dataType) {
+  using esp::core::DataType;
+  switch (dataType) {
+    case DataType::DT_INT8:
+      return py::dtype::of<int8_t>();
+    case DataType::DT_UINT8:
+      return py::dtype::of<uint8_t>();
+    case DataType::DT_INT16:
+      return py::dtype::of<int16_t>();
+    case DataType::DT_UINT16:
+      return py::dtype::of<uint16_t>();
+    case DataType::DT_INT32:
+      return py::dtype::of<int32_t>();
+    case DataType::DT_UINT32:
+      return py::dtype::of<uint32_t>();
+    case DataType::DT_INT64:
+      return py::dtype::of<int64_t>();
+    case DataType::DT_UINT64:
+      return py::dtype::of<uint64_t>();
+    case DataType::DT_FLOAT:
+      return py::dtype::of<float>();
+    case DataType::DT_DOUBLE:
+      return py::dtype::of<double>();
+    case DataType::DT_FLOAT16:
+      // the struct module's half precision float, numpy.float16
+      return py::dtype{"e"};
+    default:
+      throw py::value_error{"SharedObservationRing field has no data type"};
+  }
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+// The DLPack ABI, https://github.com/dmlc/dlpack, which is stable, so it's
+// declared here instead of depending on its header
+enum DLDeviceType : int32_t { kDLCUDA = 2 };
+enum DLDataTypeCode : uint8_t { kDLInt = 0, kDLUInt = 1, kDLFloat = 2 };
+
+struct DLDevice {
+  DLDeviceType device_type;
+  int32_t device_id;
+};
+
+struct DLDataType {
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+};
+
+struct DLTensor {
+  void* data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t* shape;
+  int64_t* strides;
+  uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+  DLTensor dl_tensor;
+  void* manager_ctx;
+  void (*deleter)(DLManagedTensor* self);
+};
+
+DLDataType dlDataType(esp::core::DataType dataType) {
+  using esp::core::DataType;
+  switch (dataType) {
+    case DataType::DT_INT8:
+    case DataType::DT_INT16:
+    case DataType::DT_INT32:
+    case DataType::DT_INT64:
+      return {kDLInt, uint8_t(8 * esp::core::getDataTypeByteSize(dataType)),
+              1};
+    case DataType::DT_UINT8:
+    case DataType::DT_UINT16:
+    case DataType::DT_UINT32:
+    case DataType::DT_UINT64:
+      return {kDLUInt, uint8_t(8 * esp::core::getDataTypeByteSize(dataType)),
+              1};
+    case DataType::DT_FLOAT16:
+    case DataType::DT_FLOAT:
+    case DataType::DT_DOUBLE:
+      return {kDLFloat, uint8_t(8 * esp::core::getDataTypeByteSize(dataType)),
+              1};
+    default:
+      throw py::value_error{"DeviceBuffer has no data type"};
+  }
+}
+
+// keeps the buffer alive until the consumer of the capsule is done with it
+struct DLPackContext {
+  DLManagedTensor tensor;
+  esp::sensor::DeviceBuffer::ptr buffer;
+  std::vector<int64_t> shape;
+};
+
+py::capsule toDLPack(const esp::sensor::DeviceBuffer::ptr& buffer) {
+  std::unique_ptr<DLPackContext> context{new DLPackContext{}};
+  context->buffer = buffer;
+  context->shape.assign(buffer->shape().begin(), buffer->shape().end());
+
+  DLTensor& tensor = context->tensor.dl_tensor;
+  tensor.data = buffer->data();
+  tensor.device = {kDLCUDA, buffer->deviceId()};
+  tensor.ndim = context->shape.size();
+  tensor.dtype = dlDataType(buffer->dataType());
+  tensor.shape = context->shape.data();
+  // compact row-major
+  tensor.strides = nullptr;
+  tensor.byte_offset = 0;
+  context->tensor.manager_ctx = context.get();
+  context->tensor.deleter = [](DLManagedTensor* self) {
+    delete static_cast<DLPackContext*>(self->manager_ctx);
+  };
+
+  // consumers rename the capsule once they own the tensor, otherwise it was
+  // never consumed and is freed with the capsule
+  py::capsule capsule{&context.release()->tensor, "dltensor",
+                      [](PyObject* object) {
+                        if (PyCapsule_IsValid(object, "dltensor")) {
+                          auto* managed = static_cast<DLManagedTensor*>(
+                              PyCapsule_GetPointer(object, "dltensor"));
+                          managed->deleter(managed);
+                        }
+                      }};
+  return capsule;
+}
+#endif
 }  // namespace
 
 namespace esp {
@@ -38,8 +179,59 @@ namespace sensor {
 
 void initSensorBindings(py::module& m) {
   // ==== Observation ====
-  // NOLINTNEXTLINE(bugprone-unused-raii)
-  py::class_<Observation, Observation::ptr>(m, "Observation");
+  py::class_<Observation, Observation::ptr> observation{m, "Observation"};
+  observation.def(py::init(&Observation::create<>))
+      .def_readonly("buffer", &Observation::buffer,
+                    R"(The observation data. Supports the buffer protocol, so
+                    numpy.asarray(obs.buffer) is a zero-copy view that stays
+                    valid for num_observation_buffers - 1 further steps.)")
+      .def_readonly("timestamp", &Observation::timestamp,
+                    R"(World time of the simulator when the observation was
+                    drawn)")
+      .def_readonly("age", &Observation::age,
+                    R"(Requests since the observation was drawn, above 0 for
+                    stale observations, see SensorSpec.render_interval)");
+
+#ifdef ESP_BUILD_WITH_CUDA
+  py::class_<DeviceBuffer, DeviceBuffer::ptr>(m, "DeviceBuffer")
+      .def_property_readonly("shape", &DeviceBuffer::shape)
+      .def_property_readonly("data_type", &DeviceBuffer::dataType)
+      .def_property_readonly("device_id", &DeviceBuffer::deviceId)
+      .def_property_readonly(
+          "data_ptr",
+          [](DeviceBuffer& self) {
+            return reinterpret_cast<std::size_t>(self.data());
+          },
+          R"(The device pointer to the data)")
+      .def(
+          "__dlpack__",
+          [](const DeviceBuffer::ptr& self, py::object stream) {
+            // the DLPack stream values are those of cudaStream_t, 1 for the
+            // legacy default stream, 2 for the per-thread one, and -1 for
+            // none to synchronize with
+            const std::intptr_t consumer =
+                stream.is_none() ? 1 : stream.cast<std::intptr_t>();
+            if (consumer != -1) {
+              self->waitForWrite(reinterpret_cast<CUstream_st*>(consumer));
+            }
+            return toDLPack(self);
+          },
+          R"(Export to DLPack, e.g. for torch.from_dlpack(), without a copy. The
+          observation is read asynchronously, the consumer stream, the legacy
+          default stream if None, waits for the read without blocking the
+          host.)",
+          "stream"_a = py::none())
+      .def("__dlpack_device__", [](DeviceBuffer& self) {
+        return py::make_tuple(int(kDLCUDA), self.deviceId());
+      });
+
+  observation.def_readonly(
+      "device_buffer", &Observation::deviceBuffer,
+      R"(The observation in CUDA memory if the sensor has gpu2gpu_transfer
+      enabled, in which case buffer is None. Supports DLPack, so
+      torch.from_dlpack(obs.device_buffer) is a zero-copy tensor that stays
+      valid for num_observation_buffers - 1 further steps.)");
+#endif
 
   // TODO fill out other SensorTypes
   // ==== enum SensorType ====
@@ -47,11 +239,20 @@ void initSensorBindings(py::module& m) {
       .value("NONE", SensorType::None)
       .value("COLOR", SensorType::Color)
       .value("DEPTH", SensorType::Depth)
-      .value("SEMANTIC", SensorType::Semantic);
+      .value("NORMAL", SensorType::Normal)
+      .value("SEMANTIC", SensorType::Semantic)
+      .value("LIDAR", SensorType::Lidar)
+      .value("POINT_CLOUD", SensorType::PointCloud);
 
   py::enum_<SensorSubType>(m, "SensorSubType")
       .value("PINHOLE", SensorSubType::Pinhole)
-      .value("ORTHOGRAPHIC", SensorSubType::Orthographic);
+      .value("ORTHOGRAPHIC", SensorSubType::Orthographic)
+      .value("EQUIRECTANGULAR", SensorSubType::Equirectangular)
+      .value("FISHEYE", SensorSubType::Fisheye);
+
+  py::enum_<StaleObservationPolicy>(m, "StaleObservationPolicy")
+      .value("REPEAT", StaleObservationPolicy::Repeat)
+      .value("OMIT", StaleObservationPolicy::Omit);
 
   // ==== SensorSpec ====
   py::class_<SensorSpec, SensorSpec::ptr>(m, "SensorSpec", py::dynamic_attr())
@@ -66,6 +267,17 @@ void initSensorBindings(py::module& m) {
       .def_readwrite("channels", &SensorSpec::channels)
       .def_readwrite("encoding", &SensorSpec::encoding)
       .def_readwrite("gpu2gpu_transfer", &SensorSpec::gpu2gpuTransfer)
+      .def_readwrite("async_readback", &SensorSpec::asyncReadback)
+      .def_readwrite("num_observation_buffers",
+                     &SensorSpec::numObservationBuffers)
+      .def_readwrite("msaa_samples", &SensorSpec::msaaSamples)
+      .def_readwrite("render_interval", &SensorSpec::renderInterval,
+                     R"(The sensor is only drawn every render_interval-th
+                     time its observation is requested, starting with the
+                     first; the others get a stale observation following
+                     stale_observation_policy)")
+      .def_readwrite("stale_observation_policy",
+                     &SensorSpec::staleObservationPolicy)
       .def_readwrite("observation_space", &SensorSpec::observationSpace)
       .def_readwrite("noise_model", &SensorSpec::noiseModel)
       .def_property(
@@ -80,6 +292,20 @@ void initSensorBindings(py::module& m) {
           [](SensorSpec& self, py::dict v) {
             py::setattr(py::cast(self), "__noise_model_kwargs", std::move(v));
           })
+      .def_property(
+          "postprocessing",
+          [](SensorSpec& self) -> py::list {
+            py::handle handle = py::cast(self);
+            if (!py::hasattr(handle, "__postprocessing")) {
+              py::setattr(handle, "__postprocessing", py::list());
+            }
+            return py::getattr(handle, "__postprocessing");
+          },
+          [](SensorSpec& self, py::list v) {
+            py::setattr(py::cast(self), "__postprocessing", std::move(v));
+          },
+          R"(Stages of habitat_sim.sensors.postprocessing applied in order to
+          the observations, after the noise model)")
       .def("__eq__",
            [](const SensorSpec& self, const SensorSpec& other) -> bool {
              return self == other;
@@ -97,6 +323,17 @@ void initSensorBindings(py::module& m) {
       .def("set_transformation_from_spec", &Sensor::setTransformationFromSpec)
       .def("is_visual_sensor", &Sensor::isVisualSensor)
       .def("get_observation", &Sensor::getObservation)
+      .def("schedule_observation", &Sensor::scheduleObservation,
+           R"(Count a request for an observation and return whether the
+          sensor is due to be drawn for it, see SensorSpec.render_interval)",
+           "time"_a)
+      .def_property_readonly(
+          "observation_age", &Sensor::observationAge,
+          R"(Requests since the sensor was last due, 0 if it was due for the
+          last one, -1 if it never was)")
+      .def_property_readonly("observation_timestamp",
+                             &Sensor::observationTimestamp,
+                             R"(World time the sensor was last due at)")
       .def_property_readonly("node", nodeGetter<Sensor>,
                              "Node this object is attached to")
       .def_property_readonly("object", nodeGetter<Sensor>, "Alias to node");
@@ -123,6 +360,88 @@ void initSensorBindings(py::module& m) {
            R"(Modify Orthographic Zoom or Perspective FOV multiplicatively by
           passed amount. User >1 to increase, 0<factor<1 to decrease.)",
            "factor"_a)
+      .def(
+          "read_observation_from",
+          [](CameraSensor& self, gfx::RenderTarget& source, size_t stream) {
+            Observation::ptr obs = Observation::create();
+#ifdef ESP_BUILD_WITH_CUDA
+            if (self.specification()->gpu2gpuTransfer) {
+              self.readObservationToDevice(
+                  source, *obs, reinterpret_cast<CUstream_st*>(stream));
+              return obs;
+            }
+#endif
+            self.readObservationFrom(source, *obs);
+            return obs;
+          },
+          R"(Read the observation of this CameraSensor from the matching
+          attachment of the render target drawn this frame, without drawing.
+          With gpu2gpu_transfer enabled it's in the device_buffer of the
+          returned Observation, read asynchronously on the CUDA stream, e.g.
+          torch.cuda.Stream.cuda_stream, the legacy default stream if 0.
+          Otherwise it's in its buffer and stream is ignored.)",
+          "source"_a, "stream"_a = 0)
+      .def_property_readonly(
+          "observation_pixel_format", &CameraSensor::observationPixelFormat,
+          R"(The pixel format observations are read in, following the sensor
+          type and the encoding of its spec: RGB8_UNORM for "rgb_uint8" color,
+          R16F for "depth_float16" and R16UI for "depth_uint16_mm" depth.)")
+      .def("update_object_id_remapping",
+           &CameraSensor::updateObjectIdRemapping,
+           R"(Update the lookup table remapping the object ids of a semantic
+          sensor to the semantic scene, following the "semantic_remapping"
+          parameter: "category", "category:<mapping>", e.g. "category:mpcat40",
+          or "instance". Only uploaded again when the scene changes.)",
+           "semantic_scene"_a)
+      .def_property_readonly(
+          "object_id_remapping", &CameraSensor::objectIdRemapping,
+          py::return_value_policy::reference_internal,
+          R"(The lookup table of update_object_id_remapping(), None if the
+          object ids aren't remapped.)")
+      .def_property_readonly(
+          "observation_size", &CameraSensor::observationSize,
+          R"(The size of the image observations are read as, that of
+          read_region divided by read_stride, the framebuffer size subsampled
+          by point_cloud_stride for point cloud sensors.)")
+      .def_property_readonly(
+          "read_region", &CameraSensor::readRegion,
+          R"(The "read_region" parameter, "x y width height" of the top-down
+          rows of the observation, the region of the framebuffer observations
+          are read from. The whole framebuffer by default.)")
+      .def_property_readonly(
+          "read_stride", &CameraSensor::readStride,
+          R"(The "read_stride" parameter, each observation pixel is the center
+          of a stride x stride block of read_region.)")
+      .def(
+          "read_object_id_histogram",
+          [](CameraSensor& self, gfx::RenderTarget& source,
+             std::size_t binCount) {
+            py::array_t<Mn::UnsignedInt> counts(binCount);
+            if (!self.readObjectIdHistogram(
+                    source, {counts.mutable_data(), binCount})) {
+              throw std::runtime_error(
+                  "Object id histograms are of semantic sensors");
+            }
+            return counts;
+          },
+          R"(The number of pixels of each object id of source below
+          bin_count, remapped by object_id_remapping, counted on the GPU
+          instead of reading the observation.)",
+          "source"_a, "bin_count"_a)
+      .def("set_read_region_of", &CameraSensor::setReadRegionOf,
+           R"(Restrict the reads of the render target to read_region at
+          read_stride, for reading it directly.)",
+           "target"_a)
+      .def_property_readonly(
+          "point_cloud_stride", &CameraSensor::pointCloudStride,
+          R"(The "point_cloud_stride" parameter of point cloud sensors, each
+          point is the center of a stride x stride block of pixels.)")
+      .def_property_readonly(
+          "point_cloud_transformation",
+          &CameraSensor::pointCloudTransformation,
+          R"(The transformation of the camera frame points of point cloud
+          sensors, following the "point_cloud_frame" parameter: identity for
+          "camera", the absolute sensor transformation for "world".)")
       .def("reset_zoom", &CameraSensor::resetZoom,
            R"(Reset Orthographic Zoom or Perspective FOV to values
           specified in current sensor spec for this CameraSensor.)")
@@ -148,12 +467,180 @@ void initSensorBindings(py::module& m) {
           "far_plane_dist", &CameraSensor::getFar, &CameraSensor::setFar,
           R"(The distance to the far clipping plane for this CameraSensor uses.)");
 
+  // ==== LidarSensor ====
+  py::class_<LidarSensor, Magnum::SceneGraph::PyFeature<LidarSensor>, Sensor,
+             Magnum::SceneGraph::PyFeatureHolder<LidarSensor>>(m,
+                                                              "LidarSensor")
+      .def(py::init_alias<std::reference_wrapper<scene::SceneNode>,
+                          const SensorSpec::ptr&>())
+      .def("set_scan_parameters", &LidarSensor::setScanParameters,
+           R"(Update the ray directions and ranges from the parameters of the
+           sensor spec: the channels x rays resolution, "hfov", "vfov",
+           "near", "far" and "noise_stddev".)",
+           "sensor_spec"_a)
+      .def_property_readonly(
+          "ray_directions",
+          [](LidarSensor& self) {
+            const std::vector<Mn::Vector3>& directions = self.rayDirections();
+            py::array_t<float> array{
+                std::vector<size_t>{directions.size(), 3}};
+            std::memcpy(array.mutable_data(), directions.data(),
+                        directions.size() * sizeof(Mn::Vector3));
+            return array;
+          },
+          R"(The unit ray directions in the sensor frame, one row per point
+          of the observation)");
+
+  // ==== ObservationRecorder ====
+  py::class_<ObservationRecorder, ObservationRecorder::ptr>(
+      m, "ObservationRecorder",
+      R"(Writes the observations of camera sensors to files on background
+      threads: <directory>/<uuid>/<frame>.png for 8-bit color and .npy for
+      the others, with the first row at the top.)")
+      .def(py::init<const std::string&, std::size_t, std::size_t>(),
+           "directory"_a, "num_threads"_a = 2, "max_queued_frames"_a = 8)
+      .def("record", &ObservationRecorder::record,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Queue the observation the sensor drew last, read straight from
+           its render target, e.g. after the draw_observation() of a sensor.
+           Blocks while max_queued_frames wait to be written, with the GIL
+           released. Returns the number of the frame, -1 if the sensor has no
+           render target.)",
+           "sensor"_a)
+      .def("flush", &ObservationRecorder::flush,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Wait until every queued frame is written.)")
+      .def_property_readonly("num_written", &ObservationRecorder::numWritten)
+      .def_property_readonly("num_failed", &ObservationRecorder::numFailed)
+      .def_property_readonly("num_queued", &ObservationRecorder::numQueued);
+
+  m.def(
+      "encode_object_id_runs",
+      [](const py::array_t<uint32_t, py::array::c_style |
+                                         py::array::forcecast>& ids) {
+        const Corrade::Containers::ArrayView<const uint32_t> view{
+            ids.data(), std::size_t(ids.size())};
+        std::size_t count = 0;
+        {
+          py::gil_scoped_release release;
+          count = countObjectIdRuns(view);
+        }
+        py::array_t<uint32_t> runs{{py::ssize_t(count), py::ssize_t{2}}};
+        {
+          py::gil_scoped_release release;
+          encodeObjectIdRuns(view, {runs.mutable_data(), 2 * count});
+        }
+        return runs;
+      },
+      R"(Run-length encode object ids, e.g. a semantic observation, in row-major order. Returns a runs x 2 array of an id and the number of consecutive pixels with it, typically orders of magnitude smaller than the frame, for logging or sending observations. Decoded by habitat_sim.sensor.decode_object_id_runs() with the shape of the frame.)",
+      "ids"_a);
+
+  // ==== SharedObservationRing ====
+  py::class_<SharedObservationRing, SharedObservationRing::ptr> ring{
+      m, "SharedObservationRing",
+      R"(A ring of observation slots in POSIX shared memory, created by the
+      process of a simulator and opened read-only by name by others, e.g. the
+      main process of multiprocess vector environments. A slot is written
+      again num_slots publications later. See
+      habitat_sim.sensors.shared_observations for the Python writer and
+      reader.)"};
+  py::class_<SharedObservationRing::Field>(ring, "Field")
+      .def(py::init([](const std::string& name, core::DataType dataType,
+                       std::vector<std::size_t> shape) {
+             return SharedObservationRing::Field{name, dataType,
+                                                 std::move(shape)};
+           }),
+           "name"_a, "data_type"_a, "shape"_a)
+      .def_readonly("name", &SharedObservationRing::Field::name)
+      .def_readonly("data_type", &SharedObservationRing::Field::dataType)
+      .def_readonly("shape", &SharedObservationRing::Field::shape);
+  ring.def(py::init<const std::string&,
+                    const std::vector<SharedObservationRing::Field>&,
+                    std::size_t>(),
+           "name"_a, "fields"_a, "num_slots"_a,
+           R"(Create the shared memory segment name, e.g. "/habitat-env-3",
+           removed when this ring is destroyed.)")
+      .def(py::init<const std::string&>(), "name"_a,
+           R"(Open the segment name created by another ring, read-only.)")
+      .def_property_readonly("name", &SharedObservationRing::name)
+      .def_property_readonly("is_writer", &SharedObservationRing::isWriter)
+      .def_property_readonly("num_slots", &SharedObservationRing::numSlots)
+      .def_property_readonly("fields", &SharedObservationRing::fields)
+      .def("field_index", &SharedObservationRing::fieldIndex, "name"_a)
+      .def(
+          "array",
+          [](const SharedObservationRing::ptr& self, std::size_t slot,
+             std::size_t field) {
+            if (slot >= self->numSlots() || field >= self->fields().size()) {
+              throw py::index_error{"slot or field out of range"};
+            }
+            const SharedObservationRing::Field& description =
+                self->fields()[field];
+            // a view of the segment, which the array keeps mapped
+            py::array array{ringFieldDtype(description.dataType),
+                            std::vector<ssize_t>{description.shape.begin(),
+                                                 description.shape.end()},
+                            self->data(slot, field).data(), py::cast(self)};
+            if (!self->isWriter()) {
+              // the mapping of the readers is read-only
+              reinterpret_cast<py::detail::PyArray_Proxy*>(array.ptr())
+                  ->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+            }
+            return array;
+          },
+          R"(A numpy array viewing a field of a slot, without a copy,
+          writable for the writer only.)",
+          "slot"_a, "field"_a)
+      .def("begin_write", &SharedObservationRing::beginWrite,
+           R"(Start writing the next slot, marking it unpublished. Returns the
+           slot.)")
+      .def("end_write", &SharedObservationRing::endWrite, "timestamp"_a = 0.0,
+           R"(Publish the slot of the last begin_write(). Returns the
+           sequence number of the publication, from 1.)")
+      .def_property_readonly("latest_sequence",
+                             &SharedObservationRing::latestSequence)
+      .def("slot_of", &SharedObservationRing::slotOf, "sequence"_a)
+      .def("sequence_of", &SharedObservationRing::sequenceOf, "slot"_a,
+           R"(The publication a slot holds, 0 while it's written.)")
+      .def("timestamp_of", &SharedObservationRing::timestampOf, "slot"_a);
+
   // ==== SensorSuite ====
   py::class_<SensorSuite, SensorSuite::ptr>(m, "SensorSuite")
       .def(py::init(&SensorSuite::create<>))
       .def("add", &SensorSuite::add)
       .def("get", &SensorSuite::get, R"(get the sensor by id)");
 
+  py::class_<RedwoodNoiseModelCPUImpl, RedwoodNoiseModelCPUImpl::uptr>(
+      m, "RedwoodNoiseModelCPUImpl")
+      .def(py::init(&RedwoodNoiseModelCPUImpl::create_unique<
+                    const Eigen::Ref<const Eigen::RowMatrixXf>&, float>),
+           "model"_a, "noise_multiplier"_a)
+      .def(py::init(&RedwoodNoiseModelCPUImpl::create_unique<
+                    const Eigen::Ref<const Eigen::RowMatrixXf>&, float,
+                    uint64_t>),
+           "model"_a, "noise_multiplier"_a, "seed"_a)
+      .def("simulate",
+           py::overload_cast<const Eigen::Ref<const Eigen::RowMatrixXf>>(
+               &RedwoodNoiseModelCPUImpl::simulate),
+           R"(Noise the depth on multiple threads of the CPU)", "depth"_a)
+      .def(
+          "simulate_batch",
+          [](RedwoodNoiseModelCPUImpl& self,
+             py::array_t<float, py::array::c_style | py::array::forcecast>
+                 depth) {
+            if (depth.ndim() != 3)
+              throw std::invalid_argument(
+                  "RedwoodNoiseModelCPUImpl::simulate_batch(): expected a "
+                  "stack of depth images");
+            py::array_t<float> noisyDepth{depth.request().shape};
+            self.simulate(depth.data(), depth.shape(0), depth.shape(1),
+                          depth.shape(2), noisyDepth.mutable_data());
+            return noisyDepth;
+          },
+          R"(Noise a stack of batch x rows x cols depth images)", "depth"_a)
+      .def("seed", &RedwoodNoiseModelCPUImpl::seed,
+           R"(Seed the noise of the following frames)", "seed"_a);
+
 #ifdef ESP_BUILD_WITH_CUDA
   py::class_<RedwoodNoiseModelGPUImpl, RedwoodNoiseModelGPUImpl::uptr>(
       m, "RedwoodNoiseModelGPUImpl")
@@ -165,7 +652,63 @@ void initSensorBindings(py::module& m) {
                                    const int cols, std::size_t devNoisyDepth) {
         self.simulateFromGPU(reinterpret_cast<const float*>(devDepth), rows,
                              cols, reinterpret_cast<float*>(devNoisyDepth));
-      });
+      })
+      .def(
+          "simulate_batch_from_gpu",
+          [](RedwoodNoiseModelGPUImpl& self, std::size_t devDepth,
+             const int batch, const int rows, const int cols,
+             std::size_t devNoisyDepth) {
+            self.simulateBatchFromGPU(reinterpret_cast<const float*>(devDepth),
+                                      batch, rows, cols,
+                                      reinterpret_cast<float*>(devNoisyDepth));
+          },
+          R"(Noise a stack of batch depth images of rows x cols in a single kernel launch)")
+      .def(
+          "simulate_from_render_target_gpu",
+          [](RedwoodNoiseModelGPUImpl& self, gfx::RenderTarget& target,
+             std::size_t devNoisyDepth) {
+            self.simulateFromRenderTargetGPU(
+                target, reinterpret_cast<float*>(devNoisyDepth));
+          },
+          R"(Noise the depth of the render target on the GPU, writing it to the device pointer devNoisyDepth with top-down rows)",
+          "target"_a, "dev_noisy_depth"_a)
+      .def("simulate_from_render_target",
+           &RedwoodNoiseModelGPUImpl::simulateFromRenderTarget,
+           R"(Noise the depth of the render target on the GPU and read it back to the view, with top-down rows)",
+           "target"_a, "view"_a);
+
+  py::class_<RgbNoiseModelGPUImpl, RgbNoiseModelGPUImpl::uptr>(
+      m, "RgbNoiseModelGPUImpl")
+      .def_static("gaussian", &RgbNoiseModelGPUImpl::gaussian,
+                  "gpu_device_id"_a, "intensity_constant"_a, "mean"_a,
+                  "sigma"_a)
+      .def_static("salt_and_pepper", &RgbNoiseModelGPUImpl::saltAndPepper,
+                  "gpu_device_id"_a, "s_vs_p"_a, "amount"_a)
+      .def_static("speckle", &RgbNoiseModelGPUImpl::speckle, "gpu_device_id"_a,
+                  "intensity_constant"_a, "mean"_a, "sigma"_a)
+      .def("seed", &RgbNoiseModelGPUImpl::seed,
+           R"(Seed the noise of the following images)", "seed"_a)
+      .def(
+          "simulate_from_cpu",
+          [](RgbNoiseModelGPUImpl& self,
+             py::array_t<uint8_t, py::array::c_style | py::array::forcecast>
+                 image) {
+            py::array_t<uint8_t> noisyImage{image.request().shape};
+            self.simulateFromCPU(image.data(), image.size(),
+                                 noisyImage.mutable_data());
+            return noisyImage;
+          },
+          "image"_a)
+      .def(
+          "simulate_from_gpu",
+          [](RgbNoiseModelGPUImpl& self, std::size_t devImage,
+             std::size_t size, std::size_t devNoisyImage) {
+            self.simulateFromGPU(reinterpret_cast<const uint8_t*>(devImage),
+                                 size,
+                                 reinterpret_cast<uint8_t*>(devNoisyImage));
+          },
+          R"(Noise size 8-bit values, any number of images stored one after another)",
+          "dev_image"_a, "size"_a, "dev_noisy_image"_a);
 #endif
 }
 
@@ -6,13 +6,17 @@
 
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
 #include <Magnum/Math/Vector3.h>
 
 #include "esp/core/esp.h"
+#include "esp/nav/CoverageMap.h"
 #include "esp/nav/GreedyFollower.h"
+#include "esp/nav/NavMeshAgentBatch.h"
 #include "esp/nav/PathFinder.h"
+#include "esp/nav/PathFollower.h"
 #include "esp/scene/ObjectControls.h"
 
 namespace py = pybind11;
@@ -23,6 +27,34 @@ using py::literals::operator""_a;
 namespace esp {
 namespace nav {
 
+namespace {
+
+using PointArray =
+    py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// The rows of an N x 3 array of points
+std::vector<vec3f> pointsFromArray(const PointArray& array, const char* name) {
+  if (array.ndim() != 2 || array.shape(1) != 3) {
+    throw std::invalid_argument(std::string{"PathFinder: expected "} + name +
+                                " as an N x 3 array of points");
+  }
+  std::vector<vec3f> points(array.shape(0));
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    points[i] = Eigen::Map<const vec3f>(array.data(i, 0));
+  }
+  return points;
+}
+
+py::array_t<float> pointsToArray(const std::vector<vec3f>& points) {
+  py::array_t<float> array({points.size(), std::size_t(3)});
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    Eigen::Map<vec3f>(array.mutable_data(i, 0)) = points[i];
+  }
+  return array;
+}
+
+}  // namespace
+
 void initShortestPathBindings(py::module& m) {
   py::class_<HitRecord>(m, "HitRecord")
       .def(py::init())
@@ -47,6 +79,47 @@ void initShortestPathBindings(py::module& m) {
       .def_readwrite("geodesic_distance",
                      &MultiGoalShortestPath::geodesicDistance);
 
+  py::class_<GeodesicDistanceField, GeodesicDistanceField::ptr>(
+      m, "GeodesicDistanceField",
+      R"(Geodesic distances to a set of goals precomputed over a navmesh by PathFinder.build_geodesic_distance_field(), queried with PathFinder.geodesic_distance().)")
+      .def_property_readonly("goals", &GeodesicDistanceField::getGoals)
+      .def_property_readonly("node_spacing",
+                             &GeodesicDistanceField::getNodeSpacing)
+      .def("save", &GeodesicDistanceField::save, "path"_a)
+      .def_static(
+          "load", &GeodesicDistanceField::load,
+          R"(Loads a field saved by save(), None if the file isn't one. The field is only valid for the navmesh it was built on.)",
+          "path"_a);
+
+  py::class_<EpisodeSamplingSettings, EpisodeSamplingSettings::ptr>(
+      m, "EpisodeSamplingSettings",
+      R"(Constraints on the episodes sampled by PathFinder.sample_episodes().)")
+      .def(py::init(&EpisodeSamplingSettings::create<>))
+      .def_readwrite("min_geodesic_distance",
+                     &EpisodeSamplingSettings::minGeodesicDistance)
+      .def_readwrite("max_geodesic_distance",
+                     &EpisodeSamplingSettings::maxGeodesicDistance)
+      .def_readwrite("min_geodesic_to_euclidean_ratio",
+                     &EpisodeSamplingSettings::minGeodesicToEuclideanRatio)
+      .def_readwrite("max_height_difference",
+                     &EpisodeSamplingSettings::maxHeightDifference)
+      .def_readwrite("min_island_radius",
+                     &EpisodeSamplingSettings::minIslandRadius)
+      .def_readwrite("island", &EpisodeSamplingSettings::island)
+      .def_readwrite("max_attempts", &EpisodeSamplingSettings::maxAttempts);
+
+  py::class_<Episode>(m, "Episode")
+      .def(py::init())
+      .def_readwrite("start", &Episode::start)
+      .def_readwrite("goal", &Episode::goal)
+      .def_readwrite("geodesic_distance", &Episode::geodesicDistance);
+
+  py::class_<NavMeshLevel>(m, "NavMeshLevel")
+      .def(py::init())
+      .def_readwrite("height", &NavMeshLevel::height)
+      .def_readwrite("bounds", &NavMeshLevel::bounds)
+      .def_readwrite("area", &NavMeshLevel::area);
+
   py::class_<NavMeshSettings, NavMeshSettings::ptr>(m, "NavMeshSettings")
       .def(py::init(&NavMeshSettings::create<>))
       .def_readwrite("cell_size", &NavMeshSettings::cellSize)
@@ -68,6 +141,9 @@ void initShortestPathBindings(py::module& m) {
       .def_readwrite("filter_ledge_spans", &NavMeshSettings::filterLedgeSpans)
       .def_readwrite("filter_walkable_low_height_spans",
                      &NavMeshSettings::filterWalkableLowHeightSpans)
+      .def_readwrite(
+          "tile_size", &NavMeshSettings::tileSize,
+          R"(Width and depth of the tiles in voxels, at most 255. 0 builds a single tile. Tiled navmeshes can be updated with Simulator.update_navmesh().)")
       .def("set_defaults", &NavMeshSettings::setDefaults);
 
   py::class_<PathFinder, PathFinder::ptr>(m, "PathFinder")
@@ -76,13 +152,96 @@ void initShortestPathBindings(py::module& m) {
       .def("seed", &PathFinder::seed)
       .def("get_topdown_view", &PathFinder::getTopDownView,
            R"(Returns the topdown view of the PathFinder's navmesh.)",
-           "meters_per_pixel"_a, "height"_a)
+           "meters_per_pixel"_a, "height"_a,
+           py::call_guard<py::gil_scoped_release>())
       .def("get_random_navigable_point", &PathFinder::getRandomNavigablePoint)
+      .def(
+          "get_random_navigable_point_on_island",
+          &PathFinder::getRandomNavigablePointOnIsland,
+          R"(Returns a random navigable point on an island, uniformly over its area.)",
+          "island_index"_a)
+      .def("get_random_navigable_point_on_largest_island",
+           &PathFinder::getRandomNavigablePointOnLargestIsland)
+      .def(
+          "get_random_navigable_point_on_level",
+          &PathFinder::getRandomNavigablePointOnLevel,
+          R"(Returns a random navigable point on a level, uniformly over its area.)",
+          "level_index"_a)
+      .def(
+          "sample_episodes", &PathFinder::sampleEpisodes,
+          R"(Samples start and goal pairs satisfying the constraints of settings in parallel, without the GIL. The episodes only depend on the seed, fewer than count are returned if some weren't found within settings.max_attempts.)",
+          "count"_a, "seed"_a, "settings"_a = EpisodeSamplingSettings{},
+          py::call_guard<py::gil_scoped_release>())
       .def("find_path", py::overload_cast<ShortestPath&>(&PathFinder::findPath),
-           "path"_a)
+           "path"_a, py::call_guard<py::gil_scoped_release>())
       .def("find_path",
            py::overload_cast<MultiGoalShortestPath&>(&PathFinder::findPath),
-           "path"_a)
+           "path"_a, py::call_guard<py::gil_scoped_release>())
+      .def(
+          "enable_path_cache", &PathFinder::enablePathCache,
+          R"(Keeps the results of find_path() for a ShortestPath, returned again for the queries with ends on the same polygons and in the same cells of a grid of quantum. Cleared when the navmesh changes.)",
+          "capacity"_a = 4096, "quantum"_a = 0.001f)
+      .def("disable_path_cache", &PathFinder::disablePathCache)
+      .def_property_readonly("is_path_cache_enabled",
+                             &PathFinder::isPathCacheEnabled)
+      .def_property_readonly("path_cache_hits", &PathFinder::pathCacheHits)
+      .def_property_readonly("path_cache_misses",
+                             &PathFinder::pathCacheMisses)
+      .def(
+          "find_paths_batch",
+          [](PathFinder& self,
+             py::array_t<float, py::array::c_style | py::array::forcecast>
+                 starts,
+             py::array_t<float, py::array::c_style | py::array::forcecast>
+                 ends,
+             bool returnPaths) -> py::object {
+            if (starts.ndim() != 2 || starts.shape(1) != 3 ||
+                ends.ndim() != 2 || ends.shape(1) != 3 ||
+                starts.shape(0) != ends.shape(0))
+              throw std::invalid_argument(
+                  "PathFinder::find_paths_batch(): expected two N x 3 arrays "
+                  "of points");
+            const std::size_t count = starts.shape(0);
+            std::vector<vec3f> startPoints(count), endPoints(count);
+            for (std::size_t i = 0; i < count; ++i) {
+              startPoints[i] = Eigen::Map<const vec3f>(starts.data(i, 0));
+              endPoints[i] = Eigen::Map<const vec3f>(ends.data(i, 0));
+            }
+
+            std::vector<float> distances;
+            std::vector<vec3f> points;
+            std::vector<std::size_t> pointOffsets;
+            {
+              py::gil_scoped_release release;
+              distances = self.findPathsBatch(
+                  startPoints, endPoints, returnPaths ? &points : nullptr,
+                  returnPaths ? &pointOffsets : nullptr);
+            }
+
+            py::array_t<float> distanceArray(distances.size(),
+                                             distances.data());
+            if (!returnPaths)
+              return std::move(distanceArray);
+            py::array_t<float> pointArray({points.size(), std::size_t(3)});
+            for (std::size_t i = 0; i < points.size(); ++i) {
+              Eigen::Map<vec3f>(pointArray.mutable_data(i, 0)) = points[i];
+            }
+            return py::make_tuple(
+                distanceArray, pointArray,
+                py::array_t<std::size_t>(pointOffsets.size(),
+                                         pointOffsets.data()));
+          },
+          R"(Finds the shortest paths from each of the N x 3 starts to the end of the same row in parallel, without the GIL. Returns the geodesic distances, inf where there is no path, and with return_paths also the points of all paths one after another and the index of the first point of each path followed by the number of points.)",
+          "starts"_a, "ends"_a, "return_paths"_a = false)
+      .def(
+          "build_geodesic_distance_field",
+          &PathFinder::buildGeodesicDistanceField,
+          R"(Computes the geodesic distance from the whole navmesh to the closest of the goals with one search, for goal sets that are queried many times.)",
+          "goals"_a, "node_spacing"_a = 0.25f,
+          py::call_guard<py::gil_scoped_release>())
+      .def("geodesic_distance", &PathFinder::geodesicDistance,
+           R"(The geodesic distance from pt to the closest goal of a field.)",
+           "field"_a, "pt"_a)
       .def("try_step", &PathFinder::tryStep<Magnum::Vector3>, "start"_a,
            "end"_a)
       .def("try_step", &PathFinder::tryStep<vec3f>, "start"_a, "end"_a)
@@ -90,17 +249,117 @@ void initShortestPathBindings(py::module& m) {
            &PathFinder::tryStepNoSliding<Magnum::Vector3>, "start"_a, "end"_a)
       .def("try_step_no_sliding", &PathFinder::tryStepNoSliding<vec3f>,
            "start"_a, "end"_a)
+      .def("try_step_batch", &PathFinder::tryStepBatch<Magnum::Vector3>,
+           R"(Same as try_step for many steps at once, in parallel.)",
+           "starts"_a, "ends"_a, py::call_guard<py::gil_scoped_release>())
+      .def("try_step_no_sliding_batch",
+           &PathFinder::tryStepNoSlidingBatch<Magnum::Vector3>,
+           R"(Same as try_step_no_sliding for many steps at once, in
+           parallel.)",
+           "starts"_a, "ends"_a, py::call_guard<py::gil_scoped_release>())
+      .def(
+          "try_step_batch_array",
+          [](PathFinder& self, const PointArray& starts, const PointArray& ends,
+             bool allowSliding) {
+            const std::vector<vec3f> startPoints =
+                pointsFromArray(starts, "starts");
+            const std::vector<vec3f> endPoints = pointsFromArray(ends, "ends");
+            if (startPoints.size() != endPoints.size())
+              throw std::invalid_argument(
+                  "PathFinder::try_step_batch_array(): expected as many "
+                  "starts as ends");
+            std::vector<vec3f> results;
+            {
+              py::gil_scoped_release release;
+              results =
+                  allowSliding
+                      ? self.tryStepBatch(startPoints, endPoints)
+                      : self.tryStepNoSlidingBatch(startPoints, endPoints);
+            }
+            return pointsToArray(results);
+          },
+          R"(Same as try_step_batch, or try_step_no_sliding_batch without allow_sliding, from an N x 3 array of starts to an N x 3 array of ends, without the GIL. Returns the N x 3 ends of the steps. Consecutive rows with the same start project it to the navmesh once.)",
+          "starts"_a, "ends"_a, "allow_sliding"_a = true)
       .def("snap_point", &PathFinder::snapPoint<Magnum::Vector3>)
       .def("snap_point", &PathFinder::snapPoint<vec3f>)
+      .def(
+          "snap_point_batch",
+          [](PathFinder& self, const PointArray& points) {
+            const std::vector<vec3f> inputs = pointsFromArray(points, "points");
+            std::vector<vec3f> snapped;
+            {
+              py::gil_scoped_release release;
+              snapped = self.snapPointBatch(inputs);
+            }
+            return pointsToArray(snapped);
+          },
+          R"(Same as snap_point for an N x 3 array of points in parallel, without the GIL. Returns the N x 3 snapped points, NaN where no navigable point is near.)",
+          "points"_a)
       .def("island_radius", &PathFinder::islandRadius, "pt"_a)
+      .def_property_readonly("num_islands", &PathFinder::numIslands)
+      .def("get_island", &PathFinder::getIsland,
+           R"(Returns the island of a point, -1 if it isn't near the navmesh.)",
+           "pt"_a)
+      .def("island_area", &PathFinder::islandArea, "island_index"_a)
+      .def_property_readonly("largest_island", &PathFinder::largestIsland)
+      .def(
+          "segment_levels", &PathFinder::segmentLevels,
+          R"(Sets how the navmesh is split into levels, e.g. floors: at level_heights, such as the heights of the semantic levels of the scene, or else at the heights with the most walkable area at least min_level_separation apart.)",
+          "level_heights"_a = std::vector<float>{},
+          "min_level_separation"_a = 1.5f,
+          py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("num_levels", &PathFinder::numLevels)
+      .def("get_levels", &PathFinder::getLevels)
+      .def("get_level", &PathFinder::getLevel,
+           R"(Returns the level of a point, -1 if it isn't near the navmesh.)",
+           "pt"_a)
+      .def(
+          "get_topdown_view_of_level", &PathFinder::getTopDownViewOfLevel,
+          R"(Returns the topdown view of the polygons of a level, on the same grid as get_topdown_view.)",
+          "level_index"_a, "meters_per_pixel"_a,
+          py::call_guard<py::gil_scoped_release>())
       .def_property_readonly("is_loaded", &PathFinder::isLoaded)
+      .def_property_readonly(
+          "is_tiled", &PathFinder::isTiled,
+          R"(Whether the navmesh was built with tiles that Simulator.update_navmesh() can rebuild.)")
+      .def(
+          "add_cylinder_obstacle", &PathFinder::addCylinderObstacle,
+          R"(Adds a vertical cylinder obstacle, standing on position, to a tiled navmesh. Returns its ID, 0 on failure. The navmesh changes on update_obstacles().)",
+          "position"_a, "radius"_a, "height"_a)
+      .def(
+          "add_box_obstacle", &PathFinder::addBoxObstacle,
+          R"(Adds a box obstacle, rotated by y_rotation radians around the vertical axis, to a tiled navmesh. Returns its ID, 0 on failure. The navmesh changes on update_obstacles().)",
+          "center"_a, "half_extents"_a, "y_rotation"_a = 0.0f)
+      .def(
+          "remove_obstacle", &PathFinder::removeObstacle,
+          R"(Removes an obstacle on the next update_obstacles(). Returns whether it exists.)",
+          "obstacle_id"_a)
+      .def(
+          "update_obstacles", &PathFinder::updateObstacles,
+          R"(Carves the obstacles added and removed since the last call into the navmesh, rebuilding only the tiles they touch.)",
+          py::call_guard<py::gil_scoped_release>())
       .def_property_readonly("navigable_area", &PathFinder::getNavigableArea)
-      .def("load_nav_mesh", &PathFinder::loadNavMesh)
-      .def("save_nav_mesh", &PathFinder::saveNavMesh, "path"_a)
+      .def("load_nav_mesh", &PathFinder::loadNavMesh,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "clear_heightfield_cache", &PathFinder::clearHeightfieldCache,
+          R"(Frees the voxelization that the next recompute_navmesh() of the same scene with another agent radius or height reuses.)")
+      .def("save_nav_mesh", &PathFinder::saveNavMesh, "path"_a,
+           py::call_guard<py::gil_scoped_release>())
       .def("distance_to_closest_obstacle",
            &PathFinder::distanceToClosestObstacle,
            R"(Returns the distance to the closest obstacle.)", "pt"_a,
-           "max_search_radius"_a = 2.0)
+           "max_search_radius"_a = 2.0,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "enable_obstacle_distance_field",
+          &PathFinder::enableObstacleDistanceField,
+          R"(Precomputes the distance to the walls on a grid, for distance_to_closest_obstacle() to return at once for points farther from the walls than the search radius. The results don't change. The grid is built on the first query and after navmesh changes.)",
+          "cell_size"_a = 0.05f, "max_distance"_a = 2.0f)
+      .def("disable_obstacle_distance_field",
+           &PathFinder::disableObstacleDistanceField)
+      .def_property_readonly("is_obstacle_distance_field_enabled",
+                             &PathFinder::isObstacleDistanceFieldEnabled)
       .def("closest_obstacle_surface_point",
            &PathFinder::closestObstacleSurfacePoint,
            R"(Returns the hit_pos, hit_normal and hit_dist of the surface point
@@ -108,7 +367,23 @@ void initShortestPathBindings(py::module& m) {
            "pt"_a, "max_search_radius"_a = 2.0)
       .def("is_navigable", &PathFinder::isNavigable,
            R"(Checks to see if the agent can stand at the specified point.)",
-           "pt"_a, "max_y_delta"_a = 0.5);
+           "pt"_a, "max_y_delta"_a = 0.5)
+      .def(
+          "is_navigable_batch",
+          [](PathFinder& self, const PointArray& points, float maxYDelta) {
+            const std::vector<vec3f> inputs = pointsFromArray(points, "points");
+            std::vector<bool> navigable;
+            {
+              py::gil_scoped_release release;
+              navigable = self.isNavigableBatch(inputs, maxYDelta);
+            }
+            py::array_t<bool> array(navigable.size());
+            std::copy(navigable.begin(), navigable.end(),
+                      array.mutable_data());
+            return array;
+          },
+          R"(Same as is_navigable for an N x 3 array of points in parallel, without the GIL. Returns a boolean array.)",
+          "points"_a, "max_y_delta"_a = 0.5);
 
   // this enum is used by GreedyGeodesicFollowerImpl so it needs to be defined
   // before it
@@ -148,6 +423,135 @@ void initShortestPathBindings(py::module& m) {
                &GreedyGeodesicFollowerImpl::findPath),
            py::return_value_policy::move)
       .def("reset", &GreedyGeodesicFollowerImpl::reset);
+
+  py::class_<BatchedGreedyGeodesicFollower,
+             BatchedGreedyGeodesicFollower::ptr>(
+      m, "BatchedGreedyGeodesicFollower",
+      R"(Plans the greedy actions of many agents at once, in parallel.
+
+      The moves are simulated natively with the pathfinder instead of by
+      python callbacks.)")
+      .def(py::init(&BatchedGreedyGeodesicFollower::create<
+                    PathFinder::ptr&, double, double, double, bool, bool, int,
+                    float>),
+           "pathfinder"_a, "goal_dist"_a, "forward_amount"_a, "turn_amount"_a,
+           "allow_sliding"_a = true, "fix_thrashing"_a = true,
+           "thrashing_threshold"_a = 16, "memo_resolution"_a = 1e-4f)
+      .def("next_actions_along",
+           &BatchedGreedyGeodesicFollower::nextActionsAlong, "states"_a,
+           "goals"_a, py::call_guard<py::gil_scoped_release>(),
+           R"(The next action of each agent, agent i is in states[i] and heads
+           to goals[i].)")
+      .def("find_paths", &BatchedGreedyGeodesicFollower::findPaths,
+           "starts"_a, "goals"_a, py::call_guard<py::gil_scoped_release>(),
+           R"(The actions from each start to its goal, empty for the agents
+           that can't reach their goal.)")
+      .def("reset",
+           py::overload_cast<>(&BatchedGreedyGeodesicFollower::reset))
+      .def("reset",
+           py::overload_cast<std::size_t>(
+               &BatchedGreedyGeodesicFollower::reset),
+           "agent"_a);
+
+  py::class_<PathFollowerSettings, PathFollowerSettings::ptr>(
+      m, "PathFollowerSettings")
+      .def(py::init(&PathFollowerSettings::create<>))
+      .def_readwrite("lookahead_distance",
+                     &PathFollowerSettings::lookaheadDistance)
+      .def_readwrite("linear_speed", &PathFollowerSettings::linearSpeed)
+      .def_readwrite("max_angular_speed",
+                     &PathFollowerSettings::maxAngularSpeed)
+      .def_readwrite("max_heading_error",
+                     &PathFollowerSettings::maxHeadingError)
+      .def_readwrite("goal_radius", &PathFollowerSettings::goalRadius)
+      .def_readwrite("corner_radius", &PathFollowerSettings::cornerRadius)
+      .def_readwrite("max_corner_cut", &PathFollowerSettings::maxCornerCut);
+
+  py::class_<VelocityCommand>(
+      m, "VelocityCommand",
+      R"(Velocities in the local frame of the agent, to be set as the
+      linear_velocity and angular_velocity of a VelocityControl with
+      lin_vel_is_local and ang_vel_is_local.)")
+      .def(py::init())
+      .def_readwrite("linear_velocity", &VelocityCommand::linearVelocity)
+      .def_readwrite("angular_velocity", &VelocityCommand::angularVelocity)
+      .def_readwrite("done", &VelocityCommand::done);
+
+  py::class_<ContinuousPathFollower, ContinuousPathFollower::ptr>(
+      m, "ContinuousPathFollower",
+      R"(Follows a path with continuous velocities by pure pursuit, rounding
+      its corners.)")
+      .def(py::init(&ContinuousPathFollower::create<
+                    PathFinder::ptr&, const PathFollowerSettings&>),
+           "pathfinder"_a, "settings"_a = PathFollowerSettings{})
+      .def("set_goal", &ContinuousPathFollower::setGoal, "start"_a, "goal"_a,
+           R"(Follow the shortest path from start to goal, returns whether
+           there is one.)")
+      .def("set_path", &ContinuousPathFollower::setPath, "points"_a)
+      .def_property_readonly("smoothed_path",
+                             &ContinuousPathFollower::smoothedPath)
+      .def_property_readonly("path_length",
+                             &ContinuousPathFollower::pathLength)
+      .def_property_readonly("progress", &ContinuousPathFollower::progress)
+      .def("next_command", &ContinuousPathFollower::nextCommand, "state"_a,
+           "dt"_a)
+      .def("follow_path", &ContinuousPathFollower::followPath, "start"_a,
+           "dt"_a, "max_steps"_a = 10000,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Follows the path from start until its end, moving along the
+           navmesh, and returns the state after each step.)")
+      .def("reset", &ContinuousPathFollower::reset);
+
+  py::enum_<NavMeshMotion>(m, "NavMeshMotion")
+      .value("MOVE_FORWARD", NavMeshMotion::MoveForward)
+      .value("MOVE_BACKWARD", NavMeshMotion::MoveBackward)
+      .value("MOVE_LEFT", NavMeshMotion::MoveLeft)
+      .value("MOVE_RIGHT", NavMeshMotion::MoveRight)
+      .value("TURN_LEFT", NavMeshMotion::TurnLeft)
+      .value("TURN_RIGHT", NavMeshMotion::TurnRight);
+
+  py::class_<NavMeshAgentBatch, NavMeshAgentBatch::ptr>(
+      m, "NavMeshAgentBatch",
+      R"(Steps many agents on the navmesh alone, without sensors or a scene
+      graph, e.g. for blind agents. Scene nodes are only updated by
+      sync_node(), before rendering.)")
+      .def(py::init(&NavMeshAgentBatch::create<PathFinder::ptr&, std::size_t,
+                                               bool>),
+           "pathfinder"_a, "num_agents"_a, "allow_sliding"_a = true)
+      .def("add_action", &NavMeshAgentBatch::addAction, "motion"_a,
+           "amount"_a,
+           R"(Add an action moving by amount, or turning by amount degrees,
+           and return its index for step().)")
+      .def_property_readonly("num_actions", &NavMeshAgentBatch::numActions)
+      .def_property_readonly("num_agents", &NavMeshAgentBatch::numAgents)
+      .def_property("states", &NavMeshAgentBatch::states,
+                    &NavMeshAgentBatch::setStates)
+      .def("state", &NavMeshAgentBatch::state, "agent"_a)
+      .def("set_state", &NavMeshAgentBatch::setState, "agent"_a, "state"_a)
+      .def("step", &NavMeshAgentBatch::step, "actions"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Take the action of each agent, negative to not move, and return
+           whether each move collided.)")
+      .def("sync_node", &NavMeshAgentBatch::syncNode, "agent"_a, "node"_a,
+           R"(Write the state of an agent to its scene node if it changed,
+           returns whether it did.)");
+
+  py::class_<CoverageMap, CoverageMap::ptr>(
+      m, "CoverageMap",
+      R"(Accumulates the navigable cells of a top-down view seen by an agent,
+      e.g. for exploration rewards.)")
+      .def(py::init(&CoverageMap::create<PathFinder::ptr&, float, float>),
+           "pathfinder"_a, "meters_per_pixel"_a, "height"_a)
+      .def("update", &CoverageMap::update, "pose"_a, "hfov"_a, "range"_a,
+           R"(Mark the cells visible from pose, within hfov radians and range,
+           and return the number of cells seen for the first time.)")
+      .def_property_readonly("num_covered", &CoverageMap::numCovered)
+      .def_property_readonly("covered_area", &CoverageMap::coveredArea)
+      .def_property_readonly("num_navigable", &CoverageMap::numNavigable)
+      .def_property_readonly("coverage", &CoverageMap::coverage,
+                             R"(Grid of the cells seen, as get_topdown_view.)")
+      .def_property_readonly("navigable", &CoverageMap::navigable)
+      .def("reset", &CoverageMap::reset);
 }
 
 }  // namespace nav
@@ -8,6 +8,9 @@
 #include <Magnum/Magnum.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 
+#include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
+
 #include <Magnum/PythonBindings.h>
 #include <Magnum/SceneGraph/PythonBindings.h>
 
@@ -15,30 +18,102 @@
 #include "esp/gfx/Renderer.h"
 #include "esp/gfx/replay/ReplayManager.h"
 #include "esp/scene/SemanticScene.h"
+#include "esp/sim/RenderClient.h"
+#include "esp/sim/RenderServer.h"
 #include "esp/sim/Simulator.h"
 #include "esp/sim/SimulatorConfiguration.h"
+#include "esp/sim/VectorSimulator.h"
 
+namespace Cr = Corrade;
 namespace py = pybind11;
 using py::literals::operator""_a;
 
 namespace esp {
 namespace sim {
 
+namespace {
+
+constexpr int ContiguousArray = py::array::c_style | py::array::forcecast;
+using FloatArray = py::array_t<float, ContiguousArray>;
+using IdArray = py::array_t<int, ContiguousArray>;
+
+// View on the rows of a count x components array, e.g. as Magnum::Vector3
+template <class T>
+Cr::Containers::ArrayView<const T> rowsView(const FloatArray& array,
+                                            std::size_t count,
+                                            const char* name) {
+  constexpr ssize_t components = sizeof(T) / sizeof(float);
+  if (array.ndim() != 2 || std::size_t(array.shape(0)) != count ||
+      array.shape(1) != components) {
+    throw std::invalid_argument(std::string{"Simulator: expected "} + name +
+                                " as an array of " + std::to_string(count) +
+                                " x " + std::to_string(components));
+  }
+  return {reinterpret_cast<const T*>(array.data()), count};
+}
+
+// New count x components array, with a view on its rows to write them to
+template <class T>
+std::pair<py::array_t<float>, Cr::Containers::ArrayView<T>> newRows(
+    std::size_t count) {
+  py::array_t<float> array({count, sizeof(T) / sizeof(float)});
+  return {array, {reinterpret_cast<T*>(array.mutable_data()), count}};
+}
+
+using ObservationViews =
+    std::map<int, std::map<std::string, Cr::Containers::ArrayView<void>>>;
+
+// Views on observation buffers by agent id and sensor uuid, kept alive by the
+// caller
+ObservationViews observationViews(
+    std::map<int, std::map<std::string, py::array>>& buffers,
+    const char* caller) {
+  ObservationViews views;
+  for (auto& agentBuffers : buffers) {
+    auto& agentViews = views[agentBuffers.first];
+    for (auto& sensorBuffer : agentBuffers.second) {
+      py::array& array = sensorBuffer.second;
+      if (!(array.flags() & py::array::c_style) || !array.writeable())
+        throw std::invalid_argument(
+            std::string{caller} + ": expected writeable C-contiguous arrays");
+      agentViews[sensorBuffer.first] = {array.mutable_data(),
+                                        std::size_t(array.nbytes())};
+    }
+  }
+  return views;
+}
+
+}  // namespace
+
 void initSimBindings(py::module& m) {
   // ==== SimulatorConfiguration ====
   py::class_<SimulatorConfiguration, SimulatorConfiguration::ptr>(
       m, "SimulatorConfiguration")
       .def(py::init(&SimulatorConfiguration::create<>))
       .def_readwrite("scene_id", &SimulatorConfiguration::activeSceneID)
+      .def_readwrite("scene_dataset_config_file",
+                     &SimulatorConfiguration::sceneDatasetConfigFile)
       .def_readwrite("random_seed", &SimulatorConfiguration::randomSeed)
       .def_readwrite("default_agent_id",
                      &SimulatorConfiguration::defaultAgentId)
       .def_readwrite("default_camera_uuid",
                      &SimulatorConfiguration::defaultCameraUuid)
-      .def_readwrite("gpu_device_id", &SimulatorConfiguration::gpuDeviceId)
+      .def_readwrite(
+          "gpu_device_id", &SimulatorConfiguration::gpuDeviceId,
+          R"(CUDA device id of the GPU to render on, habitat_sim.gfx.AUTO_GPU_DEVICE for the least loaded one. Simulator.gpu_device is the device picked.)")
       .def_readwrite("allow_sliding", &SimulatorConfiguration::allowSliding)
+      .def_readwrite(
+          "kinematic_agent_collisions",
+          &SimulatorConfiguration::kinematicAgentCollisions,
+          R"(Whether the moves of the agents are also blocked by the stage and the objects, see Simulator.collide_agent_moves(). Requires enable_physics.)")
+      .def_readwrite("agent_collision_radius",
+                     &SimulatorConfiguration::agentCollisionRadius)
+      .def_readwrite("agent_collision_height",
+                     &SimulatorConfiguration::agentCollisionHeight)
       .def_readwrite("create_renderer", &SimulatorConfiguration::createRenderer)
       .def_readwrite("frustum_culling", &SimulatorConfiguration::frustumCulling)
+      .def_readwrite("occlusion_culling",
+                     &SimulatorConfiguration::occlusionCulling)
       .def_readwrite("enable_physics", &SimulatorConfiguration::enablePhysics)
       .def_readwrite(
           "enable_gfx_replay_save",
@@ -56,12 +131,117 @@ void initSimBindings(py::module& m) {
           R"(Required to support playback of any gfx replay that includes a stage with a semantic mesh. Set to false otherwise.)")
       .def_readwrite("requires_textures",
                      &SimulatorConfiguration::requiresTextures)
+      .def_readwrite("generate_mesh_lods",
+                     &SimulatorConfiguration::generateMeshLods)
+      .def_readwrite(
+          "merge_static_meshes", &SimulatorConfiguration::mergeStaticMeshes,
+          R"(Draw the meshes of stages and other static assets merged by material, in a few draw calls. The original meshes are still culled separately.)")
+      .def_readwrite(
+          "bake_static_lighting", &SimulatorConfiguration::bakeStaticLighting,
+          R"(Bake the lighting of the merged meshes of stages into vertex colors when they are loaded, so that static lighting costs nothing per frame. Objects keep their dynamic lights. Requires merge_static_meshes.)")
+      .def_readwrite(
+          "pbr_image_based_lighting",
+          &SimulatorConfiguration::pbrImageBasedLighting,
+          R"(Light the PBR materials by the environment of the stage too, captured from the center of the stage when it is loaded. Only applies to lit materials.)")
+      .def_readwrite(
+          "release_stage_mesh_data",
+          &SimulatorConfiguration::releaseStageMeshData,
+          R"(Free the CPU copies of the meshes of stages loaded without physics once they are on the GPU. They are re-read from disk when needed, e.g. to recompute the navmesh.)")
+      .def_readwrite(
+          "stage_collision_simplification",
+          &SimulatorConfiguration::stageCollisionSimplification,
+          R"(The error the collision meshes of stages without a collision asset are simplified with, for physics and the navmesh, in the units of the stage. No surface moves by more than this. 0 to collide with the render meshes. Cached in mesh_cache_directory, if set.)")
+      .def_readwrite(
+          "compress_vertex_formats",
+          &SimulatorConfiguration::compressVertexFormats,
+          R"(Upload the normals, tangents and texture coordinates of meshes loaded afterwards as 16-bit values instead of floats, to save GPU memory and bandwidth.)")
+      .def_readwrite(
+          "texture_memory_budget",
+          &SimulatorConfiguration::textureMemoryBudget,
+          R"(GPU memory budget of the textures, in bytes. Textures of assets loaded afterwards are streamed if not 0.)")
+      .def_readwrite(
+          "asset_cache_host_budget",
+          &SimulatorConfiguration::assetCacheHostBudget,
+          R"(CPU memory budget of the loaded assets, in bytes, 0 for none. Over budget, the assets no instance uses anymore are freed when the stage changes, least recently used first.)")
+      .def_readwrite(
+          "asset_cache_gpu_budget",
+          &SimulatorConfiguration::assetCacheGpuBudget,
+          R"(GPU memory budget of the loaded assets, in bytes, 0 for none, see asset_cache_host_budget.)")
+      .def_readwrite(
+          "enable_perf_stats", &SimulatorConfiguration::enablePerfStats,
+          R"(Record the timings and counts of the hot paths, see Simulator.get_perf_stats(). Shared by the simulators of the process.)")
+      .def_readwrite(
+          "thread_budget", &SimulatorConfiguration::threadBudget,
+          R"(Number of threads the process computes on, including the calling one, e.g. the share of the cores of each of the simulators running on a node. 0 keeps the current budget, the hardware concurrency by default. Shared by the simulators of the process.)")
+      .def_readwrite(
+          "mesh_cache_directory", &SimulatorConfiguration::meshCacheDirectory,
+          R"(Directory caching the processed meshes of assets, memory-mapped by all simulators using it. Empty to disable.)")
+      .def_readwrite(
+          "baked_lighting_cache_directory",
+          &SimulatorConfiguration::bakedLightingCacheDirectory,
+          R"(Directory caching the lighting baked by bake_static_lighting, per stage and light setup. Empty to disable.)")
+      .def_readwrite(
+          "compress_textures", &SimulatorConfiguration::compressTextures,
+          R"(Compress the RGB and RGBA textures of assets to BC1 or BC3 on load, a quarter to an eighth of their GPU memory. Needs S3TC support, otherwise textures stay uncompressed.)")
+      .def_readwrite(
+          "compressed_texture_cache_directory",
+          &SimulatorConfiguration::compressedTextureCacheDirectory,
+          R"(Directory caching the textures compressed by compress_textures, by the hash of their images, so they are compressed once. Empty to disable.)")
+      .def_readwrite(
+          "shader_cache_directory",
+          &SimulatorConfiguration::shaderCacheDirectory,
+          R"(Directory caching the linked shader programs, so that later processes with the same driver load them instead of compiling them. Empty to disable.)")
+      .def_readwrite(
+          "image_based_lighting_cache_directory",
+          &SimulatorConfiguration::imageBasedLightingCacheDirectory,
+          R"(Directory caching the maps of pbr_image_based_lighting per stage, so they are computed once. Delete it when a stage changes. Empty to disable.)")
+      .def_readwrite(
+          "ptex_conversion_directory",
+          &SimulatorConfiguration::ptexConversionDirectory,
+          R"(Directory of the PTex stages converted on their first load to glTF files with baked atlases, drawn by the flat shader instead of the PTex one. Empty to draw them with the PTex shader.)")
+      .def_readwrite(
+          "ptex_conversion_tile_resolution",
+          &SimulatorConfiguration::ptexConversionTileResolution,
+          R"(Texels along the side of a face in the atlases of the stages converted into ptex_conversion_directory, 0 for the tile size of the PTex atlases less two.)")
+      .def_readwrite(
+          "semantic_scene_cache_directory",
+          &SimulatorConfiguration::semanticSceneCacheDirectory,
+          R"(Directory caching the parsed semantic scenes of the stages in a compact binary format, so that their house files are parsed once. Empty to disable.)")
       .def(py::self == py::self)
       .def(py::self != py::self);
 
+  // ==== TopDownMap ====
+  py::class_<TopDownMap>(
+      m, "TopDownMap",
+      R"(Top-down maps drawn by Simulator.render_top_down_map(), on the grid of PathFinder.get_topdown_view(): rows along z and columns along x from origin.)")
+      .def_readonly("origin", &TopDownMap::origin,
+                    R"(The x and z of the lower corner of the first pixel.)")
+      .def_readonly("meters_per_pixel", &TopDownMap::metersPerPixel)
+      .def_readonly("occupancy", &TopDownMap::occupancy,
+                    R"(Where the navmesh is.)")
+      .def_readonly(
+          "semantic_ids", &TopDownMap::semanticIds,
+          R"(The semantic id of the highest surface, 0 where there is none.)")
+      .def_readonly(
+          "heights", &TopDownMap::heights,
+          R"(The height of the highest surface, NaN where there is none.)");
+
   // ==== Simulator ====
   py::class_<Simulator, Simulator::ptr>(m, "Simulator")
       .def(py::init<const SimulatorConfiguration&>())
+      .def(py::init<const SimulatorConfiguration&,
+                    metadata::MetadataMediator::ptr>(),
+           "cfg"_a, "metadata_mediator"_a,
+           R"(Create a simulator using an already loaded metadata mediator instead of parsing the scene dataset configs again.)")
+      .def(py::init([](const Simulator& other) { return other.fork(); }),
+           "other"_a,
+           R"(Fork another simulator: share its loaded assets, renderer, pathfinder and semantic scene, and copy its scene graph, physics world and agents in their current state.)")
+      .def(py::init([](const Simulator& other,
+                       const SimulatorConfiguration& cfg) {
+             return other.createSibling(cfg);
+           }),
+           "other"_a, "cfg"_a,
+           R"(Create a sibling of another simulator, of another scene of the same dataset: share its loaded assets, renderer and metadata, with its own scene graph, physics world, pathfinder, semantic scene and agents configured by cfg.)")
       .def("get_active_scene_graph", &Simulator::getActiveSceneGraph,
            R"(PYTHON DOES NOT GET OWNERSHIP)",
            py::return_value_policy::reference)
@@ -77,11 +257,29 @@ void initSimBindings(py::module& m) {
             Not available for all datasets
             )")
       .def_property_readonly("renderer", &Simulator::getRenderer)
+      .def_property_readonly(
+          "texture_streamer", &Simulator::getTextureStreamer,
+          py::return_value_policy::reference_internal,
+          R"(The texture streamer, None unless texture_memory_budget was set.)")
       .def_property_readonly(
           "gfx_replay_manager", &Simulator::getGfxReplayManager,
           R"(Use gfx_replay_manager for replay recording and playback.)")
       .def("seed", &Simulator::seed, "new_seed"_a)
       .def("reconfigure", &Simulator::reconfigure, "configuration"_a)
+      .def(
+          "prefetch_scene", &Simulator::prefetchScene, "configuration"_a,
+          R"(Load the navmesh and semantic scene of the stage of configuration in the background, a following reconfigure() to it swaps them in.)")
+      .def(
+                .def_static(
+          "preload_scene", &Simulator::preloadScene, "configuration"_a,
+          "metadata_mediator"_a,
+          R"(Load the navmesh and semantic scene of the stage of configuration into a cache of the process, which the first simulator of this process or of a process forked from it reconfigured to the stage takes them from.)")
+      .def_static("clear_preloaded_scenes", &Simulator::clearPreloadedScenes,
+                  R"(Drop the stages loaded by preload_scene().)")
+      .def(
+          "is_stage_reload_required", &Simulator::isStageReloadRequired,
+          "configuration"_a,
+          R"(Whether reconfigure() with configuration loads the stage again, otherwise it only applies the settings the stage does not depend on and resets.)")
       .def("reset", &Simulator::reset)
       .def("close", &Simulator::close)
       .def_property("pathfinder", &Simulator::getPathFinder,
@@ -90,11 +288,28 @@ void initSimBindings(py::module& m) {
           "navmesh_visualization", &Simulator::isNavMeshVisualizationActive,
           &Simulator::setNavMeshVisualization,
           R"(Enable or disable wireframe visualization of current pathfinder's NavMesh.)")
+      .def(
+          "render_top_down_map", &Simulator::renderTopDownMap,
+          "meters_per_pixel"_a, "min_height"_a, "max_height"_a,
+          "tile_size"_a = 1024,
+          R"(Draw the navmesh occupancy, the semantic ids and the heights of the scene between min_height and max_height from above, one tile_size square tile at a time. Empty without a renderer or a navmesh.)")
+      .def(
+          "voxelize_scene", &Simulator::voxelizeScene, "voxel_size"_a,
+          "include_objects"_a = true,
+          R"(Voxelize the collision meshes of the stage, whose voxels hold 0, and of the objects, whose voxels hold the semantic id of the object. Uses all cores.)")
+      .def(
+          "voxelize_objects", &Simulator::voxelizeObjects, "grid"_a,
+          "object_ids"_a,
+          R"(Mark the voxels the objects touch at their current poses, e.g. the dynamic objects each step on a copy of the grid of the stage.)")
       .def_property_readonly("gpu_device", &Simulator::gpuDevice)
       .def_property_readonly("random", &Simulator::random)
       .def_property("frustum_culling", &Simulator::isFrustumCullingEnabled,
                     &Simulator::setFrustumCullingEnabled,
                     R"(Enable or disable the frustum culling)")
+      .def_property(
+          "occlusion_culling", &Simulator::isOcclusionCullingEnabled,
+          &Simulator::setOcclusionCullingEnabled,
+          R"(Enable or disable occlusion culling based on the previous frame's occlusion queries)")
       .def_property(
           "active_dataset", &Simulator::getActiveSceneDatasetName,
           &Simulator::setActiveSceneDatasetName,
@@ -170,11 +385,32 @@ void initSimBindings(py::module& m) {
           "get_existing_object_ids", &Simulator::getExistingObjectIDs,
           "scene_id"_a = 0,
           R"(Get the list of ids for all objects currently instanced in the scene.)")
+      .def(
+          "set_object_pool_size", &Simulator::setObjectPoolSize, "size"_a,
+          "scene_id"_a = 0,
+          R"(Keep up to size removed objects of each template, hidden and out of the world, for the next add_object calls of the template to reactivate rather than create. 0, the default, disables pooling.)")
+      .def("get_object_pool_size", &Simulator::getObjectPoolSize,
+           "scene_id"_a = 0,
+           R"(Get the number of removed objects of each template kept for reuse.)")
+      .def("get_num_pooled_objects", &Simulator::getNumPooledObjects,
+           "scene_id"_a = 0,
+           R"(Get the number of removed objects waiting for reuse.)")
+      .def("clear_object_pool", &Simulator::clearObjectPool, "scene_id"_a = 0,
+           R"(Delete the removed objects waiting for reuse.)")
 
       /* --- Kinematics and dynamics --- */
       .def(
           "step_world", &Simulator::stepWorld, "dt"_a = 1.0 / 60.0,
-          R"(Step the physics simulation by a desired timestep (dt). Note that resulting world time after step may not be exactly t+dt. Use get_world_time to query current simulation time.)")
+          R"(Step the physics simulation by a desired timestep (dt). Note that resulting world time after step may not be exactly t+dt. Use get_world_time to query current simulation time. Releases the GIL.)",
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "act_bodies", &Simulator::actBodies, "bodies"_a, "actions"_a,
+          "amounts"_a, py::call_guard<py::gil_scoped_release>(),
+          R"(Take a built-in body action (moveForward, turnLeft, ...) with each of a list of scene nodes, e.g. the bodies of agents, with all the moves filtered by the navmesh in one query. Returns whether each move collided, empty if an action is not a body action.)")
+      .def(
+          "step_agents", &Simulator::step, "actions"_a, "dt"_a = 1.0 / 60.0,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Take the action of each of the C++ agents given by agent id, with the body actions filtered by the navmesh in one query, then step the physics once. Returns whether the action of each agent collided.)")
       .def("get_world_time", &Simulator::getWorldTime,
            R"(Query the current simualtion world time.)")
       .def("get_gravity", &Simulator::getGravity, "scene_id"_a = 0,
@@ -205,6 +441,106 @@ void initSimBindings(py::module& m) {
           "get_rigid_state", &Simulator::getRigidState, "object_id"_a,
           "scene_id"_a = 0,
           R"(Get an object's transformation as a RigidState (i.e. vector, quaternion).)")
+      .def(
+          "get_rigid_states",
+          [](Simulator& self, const IdArray& objectIDs, int sceneID) {
+            const std::size_t count = objectIDs.size();
+            auto translations = newRows<Magnum::Vector3>(count);
+            auto rotations = newRows<Magnum::Quaternion>(count);
+            self.getRigidStates({objectIDs.data(), count}, translations.second,
+                                rotations.second, sceneID);
+            return py::make_tuple(translations.first, rotations.first);
+          },
+          "object_ids"_a, "scene_id"_a = 0,
+          R"(Get the transformations of many objects in one go, as a tuple of objects x 3 translations and objects x 4 rotation quaternions in x, y, z, w order.)")
+      .def(
+          "set_rigid_states",
+          [](Simulator& self, const IdArray& objectIDs,
+             const FloatArray& translations, const FloatArray& rotations,
+             int sceneID) {
+            const std::size_t count = objectIDs.size();
+            self.setRigidStates(
+                {objectIDs.data(), count},
+                rowsView<Magnum::Vector3>(translations, count, "translations"),
+                rowsView<Magnum::Quaternion>(rotations, count, "rotations"),
+                sceneID);
+          },
+          "object_ids"_a, "translations"_a, "rotations"_a, "scene_id"_a = 0,
+          R"(Set the transformations of many objects in one go from objects x 3 translations and objects x 4 rotation quaternions in x, y, z, w order, and update their simulation states.)")
+      .def(
+          "get_velocities",
+          [](Simulator& self, const IdArray& objectIDs, int sceneID) {
+            const std::size_t count = objectIDs.size();
+            auto linVels = newRows<Magnum::Vector3>(count);
+            auto angVels = newRows<Magnum::Vector3>(count);
+            self.getVelocities({objectIDs.data(), count}, linVels.second,
+                               angVels.second, sceneID);
+            return py::make_tuple(linVels.first, angVels.first);
+          },
+          "object_ids"_a, "scene_id"_a = 0,
+          R"(Get the linear and angular velocities of many objects in one go, as a tuple of two objects x 3 arrays.)")
+      .def(
+          "set_velocities",
+          [](Simulator& self, const IdArray& objectIDs,
+             const FloatArray& linearVelocities,
+             const FloatArray& angularVelocities, int sceneID) {
+            const std::size_t count = objectIDs.size();
+            self.setVelocities(
+                {objectIDs.data(), count},
+                rowsView<Magnum::Vector3>(linearVelocities, count,
+                                          "linear_velocities"),
+                rowsView<Magnum::Vector3>(angularVelocities, count,
+                                          "angular_velocities"),
+                sceneID);
+          },
+          "object_ids"_a, "linear_velocities"_a, "angular_velocities"_a,
+          "scene_id"_a = 0,
+          R"(Set the linear and angular velocities of many objects in one go from two objects x 3 arrays.)")
+      .def(
+          "save_physics_state", &Simulator::savePhysicsState,
+          "scene_id"_a = 0,
+          R"(Save the motion types, rigid states, velocities and sleep states of all objects and the world time, and return a handle to restore them with restore_physics_state(), e.g. to reset episodes without recreating objects. -1 without physics.)")
+      .def(
+          "restore_physics_state", &Simulator::restorePhysicsState,
+          "handle"_a, "scene_id"_a = 0,
+          R"(Restore a state saved by save_physics_state(). Returns False, changing nothing, if an object of the state was removed. Objects added since keep their state.)")
+      .def(
+          "remove_physics_state", &Simulator::removePhysicsState, "handle"_a,
+          "scene_id"_a = 0,
+          R"(Free a state saved by save_physics_state().)")
+      .def(
+          "serialize_physics_state",
+          [](const Simulator& self, int sceneID) {
+            return py::bytes(self.serializePhysicsState(sceneID));
+          },
+          "scene_id"_a = 0,
+          R"(The state saved by save_physics_state() as bytes, to restore with deserialize_physics_state() in this or an identically populated simulator.)")
+      .def(
+          "deserialize_physics_state", &Simulator::deserializePhysicsState,
+          "state"_a, "scene_id"_a = 0,
+          R"(Restore bytes returned by serialize_physics_state().)")
+      .def(
+          "save_checkpoint",
+          [](Simulator& self, const std::string& path, py::bytes userData) {
+            return self.saveCheckpoint(path, userData);
+          },
+          "path"_a, "user_data"_a = py::bytes{},
+          R"(Save the scene identity, the objects and their physics state, the states of the C++ agents, the random generators and a modified navmesh, with user_data, to a binary file, to continue with load_checkpoint(), e.g. after preemption. Returns False if the file can't be written.)")
+      .def(
+          "load_checkpoint",
+          [](Simulator& self, const std::string& path) -> py::object {
+            std::string userData;
+            if (!self.loadCheckpoint(path, &userData)) {
+              return py::none();
+            }
+            return py::bytes(userData);
+          },
+          "path"_a,
+          R"(Continue from a file of save_checkpoint() of the active scene, with the same agents. The objects are replaced and attached to the stage node. Returns the user_data it was saved with, None if the file is malformed or not all objects could be instanced.)")
+      .def(
+          "get_physics_state_checksum", &Simulator::getPhysicsStateChecksum,
+          "scene_id"_a = 0,
+          R"(A hash of the physics state, equal after the same steps of identically populated simulators with deterministic physics. 0 without physics.)")
       .def("set_translation", &Simulator::setTranslation, "translation"_a,
            "object_id"_a, "scene_id"_a = 0,
            R"(Set an object's translation and update its simulation state.)")
@@ -248,6 +584,16 @@ void initSimBindings(py::module& m) {
       .def("set_object_is_collidable", &Simulator::setObjectIsCollidable,
            "collidable"_a, "object_id"_a,
            R"(Set whether or not an object is collidable.)")
+      .def("set_object_collision_filter",
+           &Simulator::setObjectCollisionFilter, "group"_a, "mask"_a,
+           "object_id"_a,
+           R"(Set the physics.CollisionGroup of an object and the groups it collides with, 0 for the defaults of its motion type. Two objects only collide if each one's group is in the mask of the other, e.g. group DEBRIS with mask STATIC | STAGE only collides with the static environment, which skips the contacts among clutter.)")
+      .def("get_object_collision_group",
+           &Simulator::getObjectCollisionGroup, "object_id"_a,
+           R"(Get the physics.CollisionGroup of an object.)")
+      .def("get_object_collision_mask", &Simulator::getObjectCollisionMask,
+           "object_id"_a,
+           R"(Get the physics.CollisionGroup values an object collides with.)")
       .def("get_stage_is_collidable", &Simulator::getStageIsCollidable,
            R"(Get whether or not the static stage is collidable.)")
       .def("set_stage_is_collidable", &Simulator::setStageIsCollidable,
@@ -259,8 +605,96 @@ void initSimBindings(py::module& m) {
           R"(Run collision detection and return a binary indicator of penetration between the specified object and any other collision object. Physics must be enabled.)")
       .def(
           "cast_ray", &Simulator::castRay, "ray"_a, "max_distance"_a = 100.0,
-          "scene_id"_a = 0,
-          R"(Cast a ray into the collidable scene and return hit results. Physics must be enabled. max_distance in units of ray length.)")
+          "scene_id"_a = 0, "closest_hit_only"_a = false,
+          "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+          R"(Cast a ray into the collidable scene and return hit results. Physics must be enabled. max_distance in units of ray length. With closest_hit_only, only the closest hit is reported, which is cheaper. The ray only hits the physics.CollisionGroup values in collision_filter_mask, e.g. ~CollisionGroup.STAGE skips the stage.)")
+      .def(
+          "cast_rays",
+          [](Simulator& self,
+             py::array_t<float, py::array::c_style | py::array::forcecast>
+                 origins,
+             py::array_t<float, py::array::c_style | py::array::forcecast>
+                 directions,
+             float maxDistance, bool closestHitOnly, int sceneID,
+             int collisionFilterMask) {
+            if (origins.ndim() != 2 || origins.shape(1) != 3 ||
+                directions.ndim() != 2 || directions.shape(1) != 3 ||
+                origins.shape(0) != directions.shape(0))
+              throw std::invalid_argument(
+                  "Simulator::cast_rays(): expected origins and directions "
+                  "as two rays x 3 arrays");
+            std::vector<esp::geo::Ray> rays(origins.shape(0));
+            auto o = origins.unchecked<2>();
+            auto d = directions.unchecked<2>();
+            for (std::size_t i = 0; i < rays.size(); ++i) {
+              rays[i].origin = {o(i, 0), o(i, 1), o(i, 2)};
+              rays[i].direction = {d(i, 0), d(i, 1), d(i, 2)};
+            }
+            py::gil_scoped_release release;
+            return self.castRays(rays, maxDistance, closestHitOnly, sceneID,
+                                 collisionFilterMask);
+          },
+          "origins"_a, "directions"_a, "max_distance"_a = 100.0,
+          "closest_hit_only"_a = false, "scene_id"_a = 0,
+          "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+          R"(Cast a batch of rays, given as rays x 3 arrays of origins and directions, into the collidable scene on multiple threads and return the hits of all of them in flat arrays. Physics must be enabled. max_distance in units of ray length. The rays only hit the physics.CollisionGroup values in collision_filter_mask.)")
+      .def("overlap_aabb", &Simulator::overlapAabb, "aabb"_a,
+           "scene_id"_a = 0,
+           "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+           py::call_guard<py::gil_scoped_release>(),
+           R"(The sorted ids of the objects whose bounding box overlaps a mn.Range3D, from the broadphase of the collision world without running collision detection, -1 for the stage. Physics must be enabled. Releases the GIL.)")
+      .def("overlap_sphere", &Simulator::overlapSphere, "center"_a,
+           "radius"_a, "scene_id"_a = 0,
+           "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+           py::call_guard<py::gil_scoped_release>(),
+           R"(The sorted ids of the objects whose bounding box overlaps a sphere, as overlap_aabb().)")
+      .def("overlap_obb", &Simulator::overlapObb, "obb"_a, "scene_id"_a = 0,
+           "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+           py::call_guard<py::gil_scoped_release>(),
+           R"(The sorted ids of the objects whose bounding box overlaps a geo.OBB, as overlap_aabb().)")
+      .def("query_object_visibility", &Simulator::queryObjectVisibility,
+           "agent_id"_a, "sensor_id"_a, "poses"_a, "object_ids"_a,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(The fraction of each of a list of rigid objects a visual sensor of an agent sees from each of a list of mn.Matrix4 poses of the sensor, with occlusion queries, as a flat list of the objects of the first pose first. Empty if there is no such sensor. Overwrites the render target of the sensor.)")
+      .def("contact_tests", &Simulator::contactTests, "object_ids"_a,
+           "scene_id"_a = 0, py::call_guard<py::gil_scoped_release>(),
+           R"(contact_test() of a list of objects, updating the collision world once for all of them. Physics must be enabled.)")
+      .def("test_placements",
+           py::overload_cast<int, const std::vector<Mn::Matrix4>&, int>(
+               &Simulator::testPlacements),
+           "object_id"_a, "transformations"_a, "scene_id"_a = 0,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Whether an object would be in contact with any other object at each of a list of mn.Matrix4 transformations, without moving it and ignoring the object itself, e.g. to reject the candidate poses of a placement sampler. Physics must be enabled.)")
+      .def("test_placements",
+           py::overload_cast<const std::string&,
+                             const std::vector<Mn::Matrix4>&, int>(
+               &Simulator::testPlacements),
+           "object_lib_handle"_a, "transformations"_a, "scene_id"_a = 0,
+           R"(test_placements() of an object template, instanced once for the whole list and removed after.)")
+      .def("sweep_object", &Simulator::sweepObject, "object_id"_a, "from"_a,
+           "to"_a, "scene_id"_a = 0,
+           "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Sweep the collision shape of an object from the mn.Matrix4 transformation of its root node to a mn.Vector3 translation, keeping the rotation, and return the first physics.SweepResult, without moving the object and ignoring it. Physics must be enabled.)")
+      .def("sweep_object_batch", &Simulator::sweepObjectBatch,
+           "object_id"_a, "from"_a, "to"_a, "scene_id"_a = 0,
+           "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+           py::call_guard<py::gil_scoped_release>(),
+           R"(sweep_object() along lists of starts and ends, on multiple threads.)")
+      .def("sweep_capsule", &Simulator::sweepCapsule, "radius"_a, "height"_a,
+           "from"_a, "to"_a, "scene_id"_a = 0,
+           "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Sweep an upright capsule of the given radius and height, caps included, between two centers and return the first physics.SweepResult, e.g. to check that an agent can move from A to B. Physics must be enabled.)")
+      .def("sweep_capsule_batch", &Simulator::sweepCapsuleBatch,
+           "radius"_a, "height"_a, "from"_a, "to"_a, "scene_id"_a = 0,
+           "collision_filter_mask"_a = int(esp::physics::CollisionGroup::ALL),
+           py::call_guard<py::gil_scoped_release>(),
+           R"(sweep_capsule() along lists of starts and ends, on multiple threads.)")
+      .def(
+          "collide_agent_moves", &Simulator::collideAgentMoves, "starts"_a,
+          "ends"_a, py::call_guard<py::gil_scoped_release>(),
+          R"(With SimulatorConfiguration.kinematic_agent_collisions, block the moves of agent bodies from lists of feet positions to lists of ends by the stage and the objects, sweeping capsules of agent_collision_radius and agent_collision_height that slide along the obstacles following allow_sliding, as one batch. Returns the ends, unchanged otherwise or without physics.)")
       .def("set_object_bb_draw", &Simulator::setObjectBBDraw, "draw_bb"_a,
            "object_id"_a, "scene_id"_a = 0,
            R"(Enable or disable bounding box visualization for an object.)")
@@ -268,10 +702,20 @@ void initSimBindings(py::module& m) {
           "set_object_semantic_id", &Simulator::setObjectSemanticId,
           "semantic_id"_a, "object_id"_a, "scene_id"_a = 0,
           R"(Convenience function to set the semanticId for all visual SceneNodes belonging to an object.)")
+      .def(
+          "set_semantic_object_hidden", &Simulator::setSemanticObjectHidden,
+          "semantic_object_id"_a, "hidden"_a,
+          R"(Hide or show an object of the semantic instance mesh of the stage from all sensors, if the mesh is split by object. Returns False if the mesh has no such object.)")
       .def(
           "recompute_navmesh", &Simulator::recomputeNavMesh, "pathfinder"_a,
           "navmesh_settings"_a, "include_static_objects"_a = false,
-          R"(Recompute the NavMesh for a given PathFinder instance using configured NavMeshSettings. Optionally include all MotionType::STATIC objects in the navigability constraints.)")
+          R"(Recompute the NavMesh for a given PathFinder instance using configured NavMeshSettings. Optionally include all MotionType::STATIC objects in the navigability constraints. Releases the GIL.)",
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "update_navmesh", &Simulator::updateNavMesh, "pathfinder"_a,
+          "region_min"_a, "region_max"_a, "include_static_objects"_a = false,
+          R"(Update a NavMesh recomputed with a nonzero NavMeshSettings.tile_size after the scene geometry changed within the region_min, region_max box, e.g. an object moved, by rebuilding only the tiles overlapping it. include_static_objects must be the same as for recompute_navmesh(). Releases the GIL.)",
+          py::call_guard<py::gil_scoped_release>())
       .def("add_trajectory_object", &Simulator::addTrajectoryObject,
            "traj_vis_name"_a, "points"_a, "num_segments"_a = 3,
            "radius"_a = .001, "color"_a = Mn::Color4{0.9, 0.1, 0.1, 1.0},
@@ -294,12 +738,197 @@ void initSimBindings(py::module& m) {
           "set_object_light_setup", &Simulator::setObjectLightSetup,
           "object_id"_a, "light_setup_key"_a, "scene_id"_a = 0,
           R"(Modify the LightSetup used to the render all components of an object by setting the LightSetup key referenced by all Drawables attached to the object's visual SceneNodes.)")
+      .def(
+          "prewarm_shaders", &Simulator::prewarmShaders,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Create the shader variants the loaded scene needs up front, so that the first frame doesn't compile them, with the GIL released. Call it again after adding objects with new materials or changing light setups.)")
+      .def(
+          "get_perf_stats",
+          [](Simulator& self) {
+            py::list bounds;
+            for (int i = 0; i < core::PerfStats::NumBuckets; ++i) {
+              bounds.append(core::PerfStats::bucketLowerBound(i));
+            }
+            py::dict stats;
+            for (const auto& it : self.getPerfStats()) {
+              const core::PerfStats::Stat& stat = it.second;
+              py::dict entry;
+              entry["count"] = stat.count;
+              entry["last"] = stat.last;
+              entry["mean"] = stat.mean;
+              entry["min"] = stat.min;
+              entry["max"] = stat.max;
+              entry["total"] = stat.total;
+              entry["histogram"] = py::cast(std::vector<uint64_t>(
+                  stat.histogram.begin(), stat.histogram.end()));
+              entry["histogram_lower_bounds"] = bounds;
+              stats[py::str(it.first)] = entry;
+            }
+            return stats;
+          },
+          R"(The timings, in milliseconds, and counts of the hot paths since the last reset_perf_stats(), recorded while SimulatorConfiguration.enable_perf_stats is set. Each entry has the number of samples, the last one, their exponential moving average, extrema and total, and a histogram with power-of-two buckets.)")
+      .def("reset_perf_stats", &Simulator::resetPerfStats,
+           R"(Forget the samples of get_perf_stats().)")
+      .def(
+          "get_memory_stats",
+          [](Simulator& self) {
+            py::dict stats;
+            for (const auto& it : self.getMemoryStats()) {
+              py::dict entry;
+              entry["host_bytes"] = it.second.hostBytes;
+              entry["gpu_bytes"] = it.second.gpuBytes;
+              stats[py::str(it.first)] = entry;
+            }
+            return stats;
+          },
+          R"(The estimated CPU and GPU memory, in bytes, of the meshes, textures, PTex atlases, collision meshes, navmesh, semantic scene, render targets and replay keyframes, measured when called.)")
+      .def(
+          "get_startup_profile",
+          [](Simulator& self) {
+            py::list spans;
+            for (const auto& span : self.getStartupProfile().spans()) {
+              py::dict entry;
+              entry["name"] = span.name;
+              entry["parent"] = span.parent;
+              entry["depth"] = span.depth;
+              entry["count"] = span.count;
+              entry["start_ms"] = span.startMs;
+              entry["duration_ms"] = span.durationMs;
+              entry["bytes_read"] = span.bytesRead;
+              entry["textures_uploaded"] = span.texturesUploaded;
+              entry["texture_bytes"] = span.textureBytes;
+              entry["triangles"] = span.triangles;
+              spans.append(entry);
+            }
+            return spans;
+          },
+          R"(Where the time of the last reconfigure went: a list of spans, parents before their children, with their duration and the bytes read, textures uploaded and triangles of each, children included.)")
+      .def(
+          "get_startup_report",
+          [](Simulator& self) { return self.getStartupProfile().report(); },
+          R"(The spans of get_startup_profile() as an indented tree, as logged after reconfigure.)")
+      .def(
+          "sensors_can_share_render_pass",
+          &Simulator::sensorsCanShareRenderPass, "sensor_a"_a, "sensor_b"_a,
+          R"(Whether two sensors see the exact same view of the same scene graph, so that a single render pass fills the color, depth and object id attachments read by both.)")
+      .def(
+          "draw_and_read_observations",
+          [](Simulator& self,
+             std::map<int, std::map<std::string, py::array>> buffers) {
+            const ObservationViews views = observationViews(
+                buffers, "Simulator::draw_and_read_observations()");
+            // the arrays are kept alive by the caller
+            py::gil_scoped_release release;
+            return self.drawAndReadObservations(views);
+          },
+          "buffers"_a,
+          R"(Draw the sensors of several agents and read their observations into preallocated C-contiguous arrays, given by agent id and sensor uuid, with the GIL released. All sensors are drawn before any is read and sensors seeing the same view share a render pass. The rows are in the order of the render targets of the sensors, see RenderTarget.top_down_rows. Returns whether every observation could be drawn and read.)")
 
       .def(
           "get_num_active_contact_points",
           &Simulator::getNumActiveContactPoints,
           R"(The number of contact points that were active during the last step. An object resting on another object will involve several active contact points. Once both objects are asleep, the contact points are inactive. This count can be used as a metric for the complexity/cost of collision-handling in the current scene.)");
   ;
+
+  // ==== VectorSimulator ====
+  py::class_<VectorSimulator, VectorSimulator::ptr>(
+      m, "VectorSimulator",
+      R"(Several environments in one process, sharing the OpenGL context, renderer and asset cache of the first, e.g. simulators forked from it. The physics of the environments is stepped concurrently, their sensors are drawn on the thread of the context.)")
+      .def(py::init<std::vector<Simulator::ptr>>(), "envs"_a)
+      .def_static("fork", &VectorSimulator::fork, "base"_a, "num_envs"_a,
+                  R"(Create num_envs environments, base and copies of it.)")
+      .def_static(
+          "with_scenes", &VectorSimulator::withScenes, "base"_a, "cfgs"_a,
+          R"(Create an environment per configuration after base, each a sibling of base with its own scene.)")
+      .def_property_readonly("num_envs", &VectorSimulator::numEnvs)
+      .def("get_simulator", &VectorSimulator::getSimulator, "env"_a)
+      .def("seed", &VectorSimulator::seed, "new_seed"_a,
+           R"(Seed the environment i with new_seed + i.)")
+      .def(
+          "step_world", &VectorSimulator::stepWorld, "dt"_a = 1.0 / 60.0,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Step the physics of all environments concurrently, with the GIL released. Returns the world time of each environment.)")
+      .def(
+          "draw_and_read_observations",
+          [](VectorSimulator& self,
+             std::vector<std::map<int, std::map<std::string, py::array>>>
+                 buffers) {
+            std::vector<ObservationViews> views;
+            for (auto& envBuffers : buffers) {
+              views.push_back(observationViews(
+                  envBuffers, "VectorSimulator::draw_and_read_observations()"));
+            }
+            // the arrays are kept alive by the caller
+            py::gil_scoped_release release;
+            return self.drawAndReadObservations(views);
+          },
+          "buffers"_a,
+          R"(Simulator.draw_and_read_observations() for all environments, given a list of the buffers of each, with the GIL released. Every sensor is drawn before any is read. Returns whether every observation could be drawn and read.)");
+
+  // ==== RenderServer ====
+  py::class_<RenderServer, RenderServer::ptr>(
+      m, "RenderServer",
+      R"(Renders the observations of remote simulators, see RenderClient, from the gfx replay keyframes they stream. Each client gets its own scene graph of sim.)")
+      .def(py::init<Simulator&, int>(), "sim"_a, "port"_a = 0,
+           py::keep_alive<1, 2>())
+      .def_property_readonly("is_listening", &RenderServer::isListening)
+      .def_property_readonly("port", &RenderServer::port)
+      .def_property_readonly("num_clients", &RenderServer::numClients)
+      .def(
+          "poll", &RenderServer::poll, "timeout_ms"_a = 0,
+          py::call_guard<py::gil_scoped_release>(),
+          R"(Receive the messages of the clients, render the oldest pending request of each in one pass and send the observations, with the GIL released. Waits up to timeout_ms for messages if no request is pending, forever for -1. Returns the number of requests rendered.)");
+
+  // ==== RenderClient ====
+  py::class_<RenderClient, RenderClient::ptr>(
+      m, "RenderClient",
+      R"(Gets the observations of a simulator that doesn't render from a RenderServer, streaming the keyframes of its gfx replay recorder.)")
+      .def(py::init<const std::string&, int, float>(), "host"_a, "port"_a,
+           "translation_quantum"_a = 1e-4f)
+      .def_property_readonly("is_connected", &RenderClient::isConnected)
+      .def("set_sensors", &RenderClient::setSensors, "specs"_a,
+           R"(Replace the camera sensors the server renders for this client.)")
+      .def(
+          "stream_keyframes",
+          [](RenderClient& self, gfx::replay::ReplayManager& replayManager) {
+            if (!replayManager.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            self.streamKeyframes(replayManager.getRecorder());
+          },
+          "replay_manager"_a,
+          R"(Send the scene recorded by replay_manager so far, then each keyframe it saves.)")
+      .def(
+          "render",
+          [](RenderClient& self,
+             const std::map<std::string,
+                            std::pair<Magnum::Vector3, Magnum::Quaternion>>&
+                 poses) {
+            std::vector<RenderSensorPose> sensorPoses;
+            for (const auto& pose : poses) {
+              sensorPoses.push_back(
+                  {pose.first, pose.second.first, pose.second.second});
+            }
+            std::vector<RenderObservation> observations;
+            bool rendered;
+            {
+              py::gil_scoped_release release;
+              rendered = self.render(sensorPoses, observations);
+            }
+            if (!rendered) {
+              throw std::runtime_error(
+                  "RenderClient.render: lost the connection to the server");
+            }
+            std::map<std::string, core::Buffer::ptr> buffers;
+            for (RenderObservation& observation : observations) {
+              buffers[observation.uuid] = std::move(observation.buffer);
+            }
+            return buffers;
+          },
+          "poses"_a,
+          R"(Render the observations of the sensors at the absolute poses of a dict of uuid to (translation, rotation). Save a keyframe of the replay manager first so that the server has the current scene. Blocks until the server answered, with the GIL released. Returns a dict of uuid to Buffer, None for the sensors the server doesn't have.)");
 }
 
 }  // namespace sim
@@ -4,7 +4,10 @@
 
 #include "esp/bindings/bindings.h"
 
+#include <pybind11/numpy.h>
+
 #include "esp/core//random.h"
+#include "esp/core/Buffer.h"
 #include "esp/core/Configuration.h"
 #include "esp/core/RigidState.h"
 
@@ -22,7 +25,73 @@ void initEspBindings(py::module& m) {
 
 namespace core {
 
+namespace {
+//! numpy format string and item size of a @ref DataType
+std::pair<std::string, size_t> bufferFormat(DataType dataType) {
+  switch (dataType) {
+    case DataType::DT_INT8:
+      return {py::format_descriptor<int8_t>::format(), 1};
+    case DataType::DT_UINT8:
+      return {py::format_descriptor<uint8_t>::format(), 1};
+    case DataType::DT_INT16:
+      return {py::format_descriptor<int16_t>::format(), 2};
+    case DataType::DT_UINT16:
+      return {py::format_descriptor<uint16_t>::format(), 2};
+    case DataType::DT_INT32:
+      return {py::format_descriptor<int32_t>::format(), 4};
+    case DataType::DT_UINT32:
+      return {py::format_descriptor<uint32_t>::format(), 4};
+    case DataType::DT_INT64:
+      return {py::format_descriptor<int64_t>::format(), 8};
+    case DataType::DT_UINT64:
+      return {py::format_descriptor<uint64_t>::format(), 8};
+    case DataType::DT_FLOAT:
+      return {py::format_descriptor<float>::format(), sizeof(float)};
+    case DataType::DT_DOUBLE:
+      return {py::format_descriptor<double>::format(), sizeof(double)};
+    case DataType::DT_FLOAT16:
+      // the struct module's half precision float, numpy.float16
+      return {"e", 2};
+    default:
+      throw py::value_error{"Buffer has no data type"};
+  }
+}
+}  // namespace
+
 void initCoreBindings(py::module& m) {
+  // ==== Buffer ====
+  // exposes the python buffer protocol, so np.asarray(buffer) is zero-copy
+  py::class_<Buffer, Buffer::ptr>(m, "Buffer", py::buffer_protocol())
+      .def_readonly("shape", &Buffer::shape)
+      .def_readonly("data_type", &Buffer::dataType)
+      .def_buffer([](Buffer& self) -> py::buffer_info {
+        const auto format = bufferFormat(self.dataType);
+        std::vector<ssize_t> shape{self.shape.begin(), self.shape.end()};
+        std::vector<ssize_t> strides(shape.size());
+        ssize_t stride = format.second;
+        for (int i = shape.size() - 1; i >= 0; --i) {
+          strides[i] = stride;
+          stride *= shape[i];
+        }
+        return py::buffer_info{self.data.data(), ssize_t(format.second),
+                               format.first, ssize_t(shape.size()),
+                               shape, strides};
+      });
+
+  py::enum_<DataType>(m, "DataType")
+      .value("NONE", DataType::DT_NONE)
+      .value("INT8", DataType::DT_INT8)
+      .value("UINT8", DataType::DT_UINT8)
+      .value("INT16", DataType::DT_INT16)
+      .value("UINT16", DataType::DT_UINT16)
+      .value("INT32", DataType::DT_INT32)
+      .value("UINT32", DataType::DT_UINT32)
+      .value("INT64", DataType::DT_INT64)
+      .value("UINT64", DataType::DT_UINT64)
+      .value("FLOAT", DataType::DT_FLOAT)
+      .value("DOUBLE", DataType::DT_DOUBLE)
+      .value("FLOAT16", DataType::DT_FLOAT16);
+
   py::class_<Configuration, Configuration::ptr>(m, "ConfigurationGroup")
       .def(py::init(&Configuration::create<>))
       .def("get_bool", &Configuration::getBool)
@@ -42,22 +111,67 @@ void initCoreBindings(py::module& m) {
       .def("remove_value", &Configuration::removeValue);
 
   // ==== struct RigidState ===
-  py::class_<RigidState, RigidState::ptr>(m, "RigidState")
+  // the buffer protocol exposes the rotation x, y, z, w and the translation
+  // as 7 floats, so np.asarray(state) and the array views are zero-copy
+  static_assert(sizeof(RigidState) == 7 * sizeof(float),
+                "RigidState is expected to be 7 packed floats");
+  py::class_<RigidState, RigidState::ptr>(m, "RigidState",
+                                          py::buffer_protocol())
       .def(py::init(&RigidState::create<>))
       .def(py::init(&RigidState::create<const Magnum::Quaternion&,
                                         const Magnum::Vector3&>))
       .def_readwrite("rotation", &RigidState::rotation)
-      .def_readwrite("translation", &RigidState::translation);
+      .def_readwrite("translation", &RigidState::translation)
+      .def_buffer([](RigidState& self) -> py::buffer_info {
+        return py::buffer_info{self.rotation.data(), 7};
+      })
+      .def_property_readonly(
+          "rotation_array",
+          [](py::object self) {
+            RigidState& state = self.cast<RigidState&>();
+            return py::array_t<float>(4, state.rotation.data(), self);
+          },
+          R"(The rotation as a view of 4 floats in x, y, z, w order, writing to it changes the state without converting a quaternion.)")
+      .def_property_readonly(
+          "translation_array",
+          [](py::object self) {
+            RigidState& state = self.cast<RigidState&>();
+            return py::array_t<float>(3, state.translation.data(), self);
+          },
+          R"(The translation as a view of 3 floats, writing to it changes the state without converting a vector.)");
 
   py::class_<Random, Random::ptr>(m, "Random")
       .def(py::init(&Random::create<>))
+      .def(py::init(&Random::create<uint64_t, uint64_t>), "seed"_a,
+           "stream"_a = 0)
       .def("seed", &Random::seed)
+      .def("split", &Random::split,
+           R"(A new generator for stream_id, only depending on the seed and the stream of this one)",
+           "stream_id"_a)
       .def("uniform_float_01", &Random::uniform_float_01)
       .def("uniform_float", &Random::uniform_float)
       .def("uniform_int", py::overload_cast<>(&Random::uniform_int))
       .def("uniform_int", py::overload_cast<int, int>(&Random::uniform_int))
       .def("uniform_uint", &Random::uniform_uint)
-      .def("normal_float_01", &Random::normal_float_01);
+      .def("normal_float_01", &Random::normal_float_01)
+      .def(
+          "uniform_float_array",
+          [](Random& self, std::size_t count, float a, float b) {
+            py::array_t<float> out(count);
+            self.fillUniform({out.mutable_data(), count}, a, b);
+            return out;
+          },
+          R"(An array of count floats distributed uniformly in [a, b))",
+          "count"_a, "a"_a = 0.0f, "b"_a = 1.0f)
+      .def(
+          "normal_float_array",
+          [](Random& self, std::size_t count, float mean, float stddev) {
+            py::array_t<float> out(count);
+            self.fillNormal({out.mutable_data(), count}, mean, stddev);
+            return out;
+          },
+          R"(An array of count floats distributed normally)", "count"_a,
+          "mean"_a = 0.0f, "stddev"_a = 1.0f);
 }
 
 }  // namespace core
@@ -9,12 +9,18 @@
 
 namespace em = emscripten;
 
+#include "esp/assets/FileProvider.h"
+#include "esp/gfx/Renderer.h"
+#include "esp/gfx/TextureStreamer.h"
+#include "esp/gfx/replay/KeyframeStream.h"
+#include "esp/gfx/replay/ReplayManager.h"
 #include "esp/scene/SemanticScene.h"
 #include "esp/sensor/CameraSensor.h"
 #include "esp/sim/Simulator.h"
 
 using namespace esp;
 using namespace esp::agent;
+using namespace esp::assets;
 using namespace esp::core;
 using namespace esp::geo;
 using namespace esp::gfx;
@@ -68,6 +74,110 @@ void Sensor_setLocalTransform(Sensor& sensor,
   node.setRotation(Magnum::Quaternion(quatf(rot)).normalized());
 }
 
+// Draws the eyes of a stereo pair straight into the framebuffer bound in
+// JavaScript, e.g. the one of a WebXR layer, see modules/vr_demo.js. The
+// viewports are [x, y, width, height].
+void Simulator_drawStereo(Simulator& sim,
+                          Sensor& leftEye,
+                          Sensor& rightEye,
+                          const vec4i& leftViewport,
+                          const vec4i& rightViewport) {
+  auto* left = dynamic_cast<VisualSensor*>(&leftEye);
+  auto* right = dynamic_cast<VisualSensor*>(&rightEye);
+  if (!left || !right)
+    return;
+
+  RenderCamera::Flags flags;
+  if (sim.isFrustumCullingEnabled())
+    flags |= RenderCamera::Flag::FrustumCulling;
+  if (TextureStreamer* textureStreamer = sim.getTextureStreamer())
+    textureStreamer->nextFrame();
+
+  const auto range = [](const vec4i& viewport) {
+    return Magnum::Range2Di::fromSize({viewport[0], viewport[1]},
+                                      {viewport[2], viewport[3]});
+  };
+  sim.getRenderer()->drawStereo(*left, *right, sim.getActiveSceneGraph(),
+                                range(leftViewport), range(rightViewport),
+                                flags);
+}
+
+// Hands a file downloaded by modules/file_streamer.js over, copying the
+// Uint8Array into the WASM heap
+void StreamingFileProvider_addFile(StreamingFileProvider& provider,
+                                   const std::string& filename,
+                                   const em::val& contents) {
+  const std::size_t size = contents["length"].as<std::size_t>();
+  Corrade::Containers::Array<char> data{Corrade::Containers::NoInit, size};
+  em::val(em::typed_memory_view(
+              size, reinterpret_cast<unsigned char*>(data.data())))
+      .call<void>("set", contents);
+  provider.addFile(filename, std::move(data));
+}
+
+// Renders the keyframes of a gfx::replay::KeyframeServer, passed in as the
+// messages of a WebSocket, see modules/replay_client.js
+class ReplayClient {
+ public:
+  explicit ReplayClient(Simulator& sim)
+      : player_{sim.getGfxReplayManager()->createPlayer()} {}
+
+  // Returns false if the message is not a valid keyframe
+  bool handleMessage(const std::string& message) {
+    if (!decoder_) {
+      float translationQuantum;
+      if (!gfx::replay::readKeyframeStreamHeader(
+              message.data(), message.size(), translationQuantum)) {
+        return false;
+      }
+      decoder_ =
+          std::make_unique<gfx::replay::KeyframeDecoder>(translationQuantum);
+      return true;
+    }
+    gfx::replay::Keyframe keyframe;
+    if (!decoder_->decode(message.data(), message.size(), keyframe)) {
+      return false;
+    }
+    player_->appendKeyframe(std::move(keyframe));
+    player_->setKeyframeIndex(player_->getNumKeyframes() - 1);
+    return true;
+  }
+
+  int getNumKeyframes() const { return player_->getNumKeyframes(); }
+
+  bool hasUserTransform(const std::string& name) const {
+    Magnum::Vector3 translation;
+    Magnum::Quaternion rotation;
+    return getUserTransform(name, translation, rotation);
+  }
+
+  vec3f getUserTranslation(const std::string& name) const {
+    Magnum::Vector3 translation;
+    Magnum::Quaternion rotation;
+    getUserTransform(name, translation, rotation);
+    return vec3f(translation);
+  }
+
+  vec4f getUserRotation(const std::string& name) const {
+    Magnum::Vector3 translation;
+    Magnum::Quaternion rotation;
+    getUserTransform(name, translation, rotation);
+    return quatf(rotation).coeffs();
+  }
+
+ private:
+  std::shared_ptr<gfx::replay::Player> player_;
+  std::unique_ptr<gfx::replay::KeyframeDecoder> decoder_;
+
+  // The user transform of the latest keyframe, identity if it has none
+  bool getUserTransform(const std::string& name,
+                        Magnum::Vector3& translation,
+                        Magnum::Quaternion& rotation) const {
+    return player_->getKeyframeIndex() >= 0 &&
+           player_->getUserTransform(name, &translation, &rotation);
+  }
+};
+
 vec3f quaternionToEuler(const quatf& q) {
   return q.toRotationMatrix().eulerAngles(0, 1, 2);
 }
@@ -198,7 +308,19 @@ EMSCRIPTEN_BINDINGS(habitat_sim_bindings_js) {
       .property("defaultAgentId", &SimulatorConfiguration::defaultAgentId)
       .property("defaultCameraUuid", &SimulatorConfiguration::defaultCameraUuid)
       .property("gpuDeviceId", &SimulatorConfiguration::gpuDeviceId)
-      .property("compressTextures", &SimulatorConfiguration::compressTextures);
+      .property("compressTextures", &SimulatorConfiguration::compressTextures)
+      .property("fileProvider", &SimulatorConfiguration::fileProvider);
+
+  em::class_<FileProvider>("FileProvider")
+      .smart_ptr<FileProvider::ptr>("FileProvider::ptr");
+
+  em::class_<StreamingFileProvider, em::base<FileProvider>>(
+      "StreamingFileProvider")
+      .smart_ptr_constructor("StreamingFileProvider",
+                             &StreamingFileProvider::create<>)
+      .function("addFile", &StreamingFileProvider_addFile)
+      .function("addUnavailable", &StreamingFileProvider::addUnavailable)
+      .function("takeRequests", &StreamingFileProvider::takeRequests);
 
   em::class_<AgentState>("AgentState")
       .smart_ptr_constructor("AgentState", &AgentState::create<>)
@@ -259,6 +381,9 @@ EMSCRIPTEN_BINDINGS(habitat_sim_bindings_js) {
       .function("getAgentObservationSpace", &Simulator_getAgentObservationSpace)
       .function("getAgent", &Simulator::getAgent)
       .function("getPathFinder", &Simulator::getPathFinder)
+      .function("drawStereo", &Simulator_drawStereo)
+      .function("loadStreamedFiles", &Simulator::loadStreamedFiles)
+      .function("hasPendingFiles", &Simulator::hasPendingFiles)
       .function("addAgent",
                 em::select_overload<Agent::ptr(const AgentConfiguration&)>(
                     &Simulator::addAgent))
@@ -266,4 +391,12 @@ EMSCRIPTEN_BINDINGS(habitat_sim_bindings_js) {
                 em::select_overload<Agent::ptr(const AgentConfiguration&,
                                                scene::SceneNode&)>(
                     &Simulator::addAgent));
+
+  em::class_<ReplayClient>("ReplayClient")
+      .constructor<Simulator&>()
+      .function("handleMessage", &ReplayClient::handleMessage)
+      .function("getNumKeyframes", &ReplayClient::getNumKeyframes)
+      .function("hasUserTransform", &ReplayClient::hasUserTransform)
+      .function("getUserTranslation", &ReplayClient::getUserTranslation)
+      .function("getUserRotation", &ReplayClient::getUserRotation);
 }
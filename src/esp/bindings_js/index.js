@@ -7,6 +7,7 @@
 import WebDemo from "./modules/web_demo";
 import VRDemo from "./modules/vr_demo";
 import ViewerDemo from "./modules/viewer_demo";
+import FileStreamer from "./modules/file_streamer";
 import { defaultScene } from "./modules/defaults";
 import "./bindings.css";
 import {
@@ -33,16 +34,42 @@ function preload(url) {
   return file_parents_str + file;
 }
 
+// The path preload() gives the file at url, without downloading it
+function preloadedPath(url) {
+  if (url.indexOf("http") === -1) {
+    return "/" + url;
+  }
+  return "/" + url.split("/").pop();
+}
+
+// Streams the files of the scene at url instead of preloading them, see
+// modules/file_streamer.js. Files next to the scene are fetched from next to
+// its URL.
+function createFileStreamer(url) {
+  const path = preloadedPath(url);
+  const dir = path.substr(0, path.lastIndexOf("/") + 1);
+  const urlDir = url.substr(0, url.lastIndexOf("/") + 1);
+  return new FileStreamer(filename =>
+    filename.startsWith(dir)
+      ? urlDir + filename.substr(dir.length)
+      : filename.substr(1)
+  );
+}
+
 Module.preRun.push(() => {
   let config = {};
   config.scene = defaultScene;
   buildConfigFromURLParameters(config);
   window.config = config;
   const scene = config.scene;
-  Module.scene = preload(scene);
   const fileNoExtension = scene.substr(0, scene.lastIndexOf("."));
-
-  preload(fileNoExtension + ".navmesh");
+  if (config.stream) {
+    // fetched once the runtime is up
+    Module.scene = preloadedPath(scene);
+  } else {
+    Module.scene = preload(scene);
+    preload(fileNoExtension + ".navmesh");
+  }
   if (config.semantic === "mp3d") {
     preload(fileNoExtension + ".house");
     preload(fileNoExtension + "_semantic.ply");
@@ -53,6 +80,11 @@ Module.preRun.push(() => {
 
 Module.onRuntimeInitialized = async function() {
   console.log("hsim_bindings initialized");
+  if (window.config.stream) {
+    // only the scene file itself is needed to start
+    Module.fileStreamer = createFileStreamer(window.config.scene);
+    await Module.fileStreamer.fetchFile(Module.scene);
+  }
   let demo;
   if (window.vrEnabled) {
     const supported = await navigator.xr.isSessionSupported("immersive-vr");
@@ -0,0 +1,74 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+/*global Module */
+
+/**
+ * Downloads the files a Module.StreamingFileProvider is asked for, so that
+ * the simulator draws the scene before all of its files are there. Images
+ * are drawn with a placeholder and the navmesh is loaded once they arrive.
+ */
+class FileStreamer {
+  /**
+   * @param {function} urlFor - URL of a file the simulator opens
+   */
+  constructor(urlFor) {
+    this.provider = new Module.StreamingFileProvider();
+    this.urlFor = urlFor;
+  }
+
+  /**
+   * Fetch a file and hand it over to the provider.
+   * @param {string} filename - file the simulator opens
+   * @returns {Promise} resolved once the provider has the file
+   */
+  async fetchFile(filename) {
+    try {
+      const response = await fetch(this.urlFor(filename));
+      if (!response.ok) {
+        throw new Error(response.statusText);
+      }
+      const contents = new Uint8Array(await response.arrayBuffer());
+      this.provider.addFile(filename, contents);
+    } catch (error) {
+      console.warn(`Cannot fetch ${filename}: ${error}`);
+      this.provider.addUnavailable(filename);
+    }
+  }
+
+  /**
+   * Start fetching the files requested since the last call.
+   * @returns {Promise} resolved once the provider has them
+   */
+  fetchRequests() {
+    const requests = this.provider.takeRequests();
+    const fetches = [];
+    for (let i = 0; i < requests.size(); i++) {
+      fetches.push(this.fetchFile(requests.get(i)));
+    }
+    requests.delete();
+    return Promise.all(fetches);
+  }
+
+  /**
+   * Keep fetching the files the simulator asks for and load them as they
+   * arrive, until none are pending.
+   * @param {Object} sim - the Module.Simulator
+   * @param {function} onLoaded - called after files were loaded
+   */
+  stream(sim, onLoaded = () => {}) {
+    const pump = () => {
+      this.fetchRequests();
+      if (sim.loadStreamedFiles()) {
+        onLoaded();
+      }
+      if (sim.hasPendingFiles()) {
+        window.setTimeout(pump, 100);
+      }
+    };
+    pump();
+  }
+}
+
+export default FileStreamer;
@@ -0,0 +1,72 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+/*global Module */
+
+/**
+ * ReplayClient class, which renders the keyframes streamed by the
+ * KeyframeServer of a remote simulator
+ */
+class ReplayClient {
+  // PUBLIC methods.
+
+  /**
+   * Create a replay client.
+   * @param {Simulator} sim - simulator the keyframes are rendered in, e.g.
+   *   the sim of a SimEnv
+   * @param {string} url - WebSocket URL of the server, e.g. ws://host:8765
+   * @param {function} onKeyframe - called after each keyframe with this client
+   */
+  constructor(sim, url, onKeyframe = () => {}) {
+    this.client = new Module.ReplayClient(sim);
+    this.onKeyframe = onKeyframe;
+    this.socket = new WebSocket(url);
+    this.socket.binaryType = "arraybuffer";
+    this.socket.onmessage = event => this.handleMessage(event);
+    this.socket.onerror = event => {
+      console.error("ReplayClient: connection error", event);
+    };
+  }
+
+  /**
+   * Get the translation and rotation of a user transform, e.g. a camera, in
+   * the latest keyframe.
+   * @param {string} name - name of the user transform
+   * @returns {Object} {translation, rotation}, or null if there is none
+   */
+  getUserTransform(name) {
+    if (!this.client.hasUserTransform(name)) {
+      return null;
+    }
+    return {
+      translation: this.client.getUserTranslation(name),
+      rotation: this.client.getUserRotation(name)
+    };
+  }
+
+  /**
+   * Close the connection and release the player.
+   */
+  close() {
+    this.socket.close();
+    this.client.delete();
+  }
+
+  // PRIVATE methods.
+
+  handleMessage(event) {
+    // embind converts the bytes of a Uint8Array to a std::string
+    if (!this.client.handleMessage(new Uint8Array(event.data))) {
+      console.error("ReplayClient: invalid message, disconnecting");
+      this.socket.close();
+      return;
+    }
+    // the first message is the header of the stream
+    if (this.client.getNumKeyframes() > 0) {
+      this.onKeyframe(this);
+    }
+  }
+}
+
+export default ReplayClient;
@@ -2,7 +2,7 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
-/* global XRWebGLLayer */
+/* global Module, XRWebGLLayer */
 import WebDemo from "./web_demo";
 import { defaultAgentConfig } from "./defaults";
 
@@ -16,8 +16,6 @@ class VRDemo extends WebDemo {
   webXRSession = null;
   xrReferenceSpace = null;
   gl = null;
-  tex = null;
-  inds = null;
 
   fps = 0;
   skipFrames = 60;
@@ -41,113 +39,12 @@ class VRDemo extends WebDemo {
     this.exitVR();
   }
 
-  // Compiles a GLSL shader. Returns null on failure
-  compileShader(src, type) {
-    const shader = this.gl.createShader(type);
-    this.gl.shaderSource(shader, src);
-    this.gl.compileShader(shader);
-
-    if (this.gl.getShaderParameter(shader, this.gl.COMPILE_STATUS)) {
-      return shader;
-    } else {
-      console.error("GLSL shader error: " + this.gl.getShaderInfoLog(shader));
-      return null;
-    }
-  }
-
-  initGL() {
-    if (this.gl === null) {
-      return null;
-    }
-    const vertSrc =
-      "attribute vec3 p;attribute vec2 u;varying highp vec2 v;void main(){gl_Position=vec4(p,1);v=u;}";
-    const fragSrc =
-      "uniform sampler2D t;varying highp vec2 v;void main(){gl_FragColor=texture2D(t,v);}";
-    const vert = this.compileShader(vertSrc, this.gl.VERTEX_SHADER);
-    const frag = this.compileShader(fragSrc, this.gl.FRAGMENT_SHADER);
-    if (vert === null || frag === null) {
-      console.log("Failed to compile shaders");
-      return null;
-    }
-
-    const program = this.gl.createProgram();
-
-    this.gl.attachShader(program, vert);
-    this.gl.attachShader(program, frag);
-
-    this.gl.linkProgram(program);
-
-    if (!this.gl.getProgramParameter(program, this.gl.LINK_STATUS)) {
-      console.error("GLSL program error:" + this.gl.getProgramInfoLog(program));
-      return null;
-    }
-
-    this.gl.useProgram(program);
-
-    // Vertices
-    const verts = [
-      -1.0,
-      1.0,
-      0.0,
-      -1.0,
-      -1.0,
-      0.0,
-      1.0,
-      -1.0,
-      0.0,
-      1.0,
-      1.0,
-      0.0
-    ];
-    const vertBuf = this.gl.createBuffer();
-    this.gl.bindBuffer(this.gl.ARRAY_BUFFER, vertBuf);
-    this.gl.bufferData(
-      this.gl.ARRAY_BUFFER,
-      new Float32Array(verts),
-      this.gl.STATIC_DRAW
-    );
-    // Position attribute
-    const posAttrib = this.gl.getAttribLocation(program, "p");
-    this.gl.vertexAttribPointer(posAttrib, 3, this.gl.FLOAT, false, 0, 0);
-    this.gl.enableVertexAttribArray(posAttrib);
-
-    // UVs
-    const UVs = [0.0, 1.0, 0.0, 0.0, 1.0, 0.0, 1.0, 1.0];
-    const uvBuf = this.gl.createBuffer();
-    this.gl.bindBuffer(this.gl.ARRAY_BUFFER, uvBuf);
-    this.gl.bufferData(
-      this.gl.ARRAY_BUFFER,
-      new Float32Array(UVs),
-      this.gl.STATIC_DRAW
-    );
-    // UV attribute
-    const uvAttrib = this.gl.getAttribLocation(program, "u");
-    this.gl.vertexAttribPointer(uvAttrib, 2, this.gl.FLOAT, false, 0, 0);
-    this.gl.enableVertexAttribArray(uvAttrib);
-
-    // Indices
-    this.inds = [3, 2, 1, 3, 1, 0];
-    const indBuf = this.gl.createBuffer();
-    this.gl.bindBuffer(this.gl.ELEMENT_ARRAY_BUFFER, indBuf);
-    this.gl.bufferData(
-      this.gl.ELEMENT_ARRAY_BUFFER,
-      new Uint16Array(this.inds),
-      this.gl.STATIC_DRAW
-    );
-
-    // Texture uniform
-    const texUni = this.gl.getUniformLocation(program, "t");
-    this.gl.uniform1i(texUni, 0);
-
-    console.log("Initialized WebXR GL state");
-  }
-
   async enterVR() {
     if (this.gl === null) {
-      this.gl = document.createElement("canvas").getContext("webgl", {
-        xrCompatible: true
-      });
-      this.initGL();
+      // the context the simulator renders with, so that it can draw straight
+      // into the framebuffer of the layer
+      this.gl = Module.canvas.getContext("webgl2");
+      await this.gl.makeXRCompatible();
     }
     this.webXRSession = await navigator.xr.requestSession("immersive-vr", {
       requiredFeatures: ["local-floor"]
@@ -195,56 +92,6 @@ class VRDemo extends WebDemo {
     }
   }
 
-  drawTextureData(texRes, texData) {
-    if (this.tex === null) {
-      this.tex = this.gl.createTexture();
-      this.gl.bindTexture(this.gl.TEXTURE_2D, this.tex);
-
-      this.gl.texParameteri(
-        this.gl.TEXTURE_2D,
-        this.gl.TEXTURE_WRAP_S,
-        this.gl.CLAMP_TO_EDGE
-      );
-      this.gl.texParameteri(
-        this.gl.TEXTURE_2D,
-        this.gl.TEXTURE_WRAP_T,
-        this.gl.CLAMP_TO_EDGE
-      );
-      this.gl.texParameteri(
-        this.gl.TEXTURE_2D,
-        this.gl.TEXTURE_MIN_FILTER,
-        this.gl.NEAREST
-      );
-      this.gl.texParameteri(
-        this.gl.TEXTURE_2D,
-        this.gl.TEXTURE_MAG_FILTER,
-        this.gl.NEAREST
-      );
-    }
-
-    this.gl.bindTexture(this.gl.TEXTURE_2D, this.tex);
-    this.gl.texImage2D(
-      this.gl.TEXTURE_2D,
-      0, // level
-      this.gl.RGBA, // internal format
-      texRes[1], // width
-      texRes[0], // height
-      0, // border
-      this.gl.RGBA, // format
-      this.gl.UNSIGNED_BYTE, // type
-      new Uint8Array(texData) // data
-    );
-
-    this.gl.activeTexture(this.gl.TEXTURE0);
-
-    this.gl.drawElements(
-      this.gl.TRIANGLES,
-      this.inds.length,
-      this.gl.UNSIGNED_SHORT,
-      0
-    );
-  }
-
   drawVRScene(t, frame) {
     const session = frame.session;
 
@@ -259,14 +106,22 @@ class VRDemo extends WebDemo {
 
     const layer = session.renderState.baseLayer;
     this.gl.bindFramebuffer(this.gl.FRAMEBUFFER, layer.framebuffer);
+    this.gl.clear(this.gl.COLOR_BUFFER_BIT | this.gl.DEPTH_BUFFER_BIT);
 
     const agent = this.simenv.sim.getAgent(this.simenv.selectedAgentId);
 
     const VIEW_SENSORS = ["left_eye", "right_eye"];
+    const sensors = [];
+    const viewports = [];
     for (var iView = 0; iView < pose.views.length; ++iView) {
       const view = pose.views[iView];
       const viewport = layer.getViewport(view);
-      this.gl.viewport(viewport.x, viewport.y, viewport.width, viewport.height);
+      viewports.push([
+        viewport.x,
+        viewport.y,
+        viewport.width,
+        viewport.height
+      ]);
 
       const sensor = agent.sensorSuite.get(VIEW_SENSORS[iView]);
 
@@ -274,10 +129,17 @@ class VRDemo extends WebDemo {
         pointToArray(view.transform.position).slice(0, -1), // don't need w for position
         pointToArray(view.transform.orientation)
       );
+      sensors.push(sensor);
+    }
 
-      const texRes = sensor.specification().resolution;
-      const texData = sensor.getObservation(this.simenv.sim).getData();
-      this.drawTextureData(texRes, texData);
+    // both eyes are drawn into the layer in one call, with no readback
+    if (sensors.length === 2) {
+      this.simenv.sim.drawStereo(
+        sensors[0],
+        sensors[1],
+        viewports[0],
+        viewports[1]
+      );
     }
 
     this.updateFPS();
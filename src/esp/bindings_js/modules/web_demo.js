@@ -25,6 +25,9 @@ class WebDemo {
   ) {
     this.config = new Module.SimulatorConfiguration();
     this.config.scene_id = Module.scene;
+    if (Module.fileStreamer) {
+      this.config.fileProvider = Module.fileStreamer.provider;
+    }
     this.simenv = new SimEnv(this.config, episode, 0);
 
     agentConfig = this.updateAgentConfigWithSensors({ ...agentConfig });
@@ -53,6 +56,11 @@ class WebDemo {
 
     this.task.init();
     this.task.reset();
+
+    // draw again as the images of the scene arrive
+    if (Module.fileStreamer) {
+      Module.fileStreamer.stream(this.simenv.sim, () => this.task.render());
+    }
   }
 
   updateAgentConfigWithSensors(agentConfig = defaultAgentConfig) {
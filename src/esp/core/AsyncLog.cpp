@@ -0,0 +1,191 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "AsyncLog.h"
+
+#include <Corrade/configure.h>
+#include <chrono>
+
+#if defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_EMSCRIPTEN)
+#include <pthread.h>
+#define ESP_ASYNC_LOG_FORK_HANDLERS
+#endif
+
+namespace esp {
+namespace core {
+
+namespace {
+std::atomic<std::int64_t>& intervalNs() {
+  static std::atomic<std::int64_t> interval{1000000000};
+  return interval;
+}
+}  // namespace
+
+double LogRateLimiter::interval() {
+  return intervalNs().load(std::memory_order_relaxed) * 1.0e-9;
+}
+
+void LogRateLimiter::setInterval(double seconds) {
+  ASSERT(seconds >= 0.0);
+  intervalNs().store(std::int64_t(seconds * 1.0e9), std::memory_order_relaxed);
+}
+
+LogRateLimiter* LogRateLimiter::acquire() {
+  const std::int64_t now =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  std::int64_t last = lastNs_.load(std::memory_order_relaxed);
+  if ((last == Never ||
+       now - last >= intervalNs().load(std::memory_order_relaxed)) &&
+      lastNs_.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+    return this;
+  }
+  suppressed_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+AsyncLogMessage::~AsyncLogMessage() {
+  const std::uint64_t suppressed = limiter_.takeSuppressed();
+  if (suppressed) {
+    stream_ << " (" << suppressed << " similar messages suppressed)";
+  }
+  AsyncLogSink::instance().push({severity_, file_, line_, stream_.str()});
+}
+
+AsyncLogSink& AsyncLogSink::instance() {
+  static AsyncLogSink sink;
+  return sink;
+}
+
+AsyncLogSink::AsyncLogSink() {
+#ifdef ESP_ASYNC_LOG_FORK_HANDLERS
+  pthread_atfork(lockForFork, unlockAfterFork, resetAfterFork);
+#endif
+}
+
+AsyncLogSink::~AsyncLogSink() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  if (thread_) {
+    thread_->join();
+  }
+}
+
+void AsyncLogSink::push(Record&& record) {
+#ifdef CORRADE_TARGET_EMSCRIPTEN
+  write(record);
+#else
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (records_.size() >= MaxQueuedMessages) {
+      ++dropped_;
+      return;
+    }
+    if (!thread_) {
+      start();
+    }
+    records_.emplace_back(std::move(record));
+  }
+  condition_.notify_one();
+#endif
+}
+
+void AsyncLogSink::flush() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  drained_.wait(lock, [&]() { return records_.empty() && !writing_; });
+}
+
+void AsyncLogSink::setOutput(std::function<void(const Record&)> output) {
+  flush();
+  std::lock_guard<std::mutex> lock{mutex_};
+  output_ = std::move(output);
+}
+
+void AsyncLogSink::start() {
+  thread_ = std::make_unique<std::thread>([this]() { run(); });
+}
+
+void AsyncLogSink::run() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  for (;;) {
+    condition_.wait(lock, [&]() { return stopping_ || !records_.empty(); });
+    if (records_.empty()) {
+      return;
+    }
+    Record record = std::move(records_.front());
+    records_.pop_front();
+    const std::size_t dropped = dropped_;
+    dropped_ = 0;
+    writing_ = true;
+    const auto output = output_;
+    lock.unlock();
+
+    if (dropped) {
+      Record note{ESP_LOG_SEVERITY_WARNING, __FILE__, __LINE__,
+                  "AsyncLogSink : the queue was full, dropped " +
+                      std::to_string(dropped) + " messages"};
+      if (output) {
+        output(note);
+      } else {
+        write(note);
+      }
+    }
+    if (output) {
+      output(record);
+    } else {
+      write(record);
+    }
+
+    lock.lock();
+    writing_ = false;
+    if (records_.empty()) {
+      drained_.notify_all();
+    }
+  }
+}
+
+void AsyncLogSink::write(const Record& record) {
+#if defined(ESP_BUILD_GLOG_SHIM)
+  switch (record.severity) {
+    case ESP_LOG_SEVERITY_INFO:
+      LOG(INFO) << record.message;
+      break;
+    case ESP_LOG_SEVERITY_WARNING:
+      LOG(WARNING) << record.message;
+      break;
+    default:
+      LOG(ERROR) << record.message;
+  }
+#else
+  // keep the file and line of the call site in the prefix of glog
+  google::LogMessage(record.file, record.line, record.severity).stream()
+      << record.message;
+#endif
+}
+
+// the thread doesn't exist in a child process, which copied the mutex as it
+// was when forking, so it's held across the fork
+void AsyncLogSink::lockForFork() {
+  instance().mutex_.lock();
+}
+
+void AsyncLogSink::unlockAfterFork() {
+  instance().mutex_.unlock();
+}
+
+void AsyncLogSink::resetAfterFork() {
+  AsyncLogSink& sink = instance();
+  static_cast<void>(sink.thread_.release());
+  sink.records_.clear();
+  sink.dropped_ = 0;
+  sink.writing_ = false;
+  sink.mutex_.unlock();
+}
+
+}  // namespace core
+}  // namespace esp
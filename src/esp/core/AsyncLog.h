@@ -0,0 +1,203 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_ASYNCLOG_H_
+#define ESP_CORE_ASYNCLOG_H_
+
+/** @file
+ * @brief Macro @ref ESP_HOT_LOG, classes @ref esp::core::LogRateLimiter and
+ * @ref esp::core::AsyncLogSink
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "esp/core/logging.h"
+
+/**
+ * @brief Severities of @ref ESP_HOT_LOG, those of glog
+ *
+ * Fatal messages have to abort where they are logged, so there is no
+ * ESP_LOG_SEVERITY_FATAL.
+ */
+#define ESP_LOG_SEVERITY_INFO 0
+#define ESP_LOG_SEVERITY_WARNING 1
+#define ESP_LOG_SEVERITY_ERROR 2
+
+/**
+ * @brief Log from frequently executed code
+ *
+ * Used like LOG(), e.g. ESP_HOT_LOG(WARNING) << "...". Unlike it:
+ *
+ * - messages of a severity below ESP_MIN_LOG_LEVEL, set with the CMake
+ *   option of the same name, are compiled out, including the evaluation of
+ *   the streamed expressions
+ * - each call site logs at most once per @ref LogRateLimiter::interval(),
+ *   the next message it logs tells how many were suppressed in between, and
+ *   a suppressed message costs a clock read and an atomic increment, nothing
+ *   is formatted
+ * - the message is formatted into a string on the calling thread and
+ *   written by the thread of @ref AsyncLogSink, so the caller doesn't wait
+ *   for the lock and the I/O of the log
+ */
+#define ESP_HOT_LOG(severity)                                                \
+  for (esp::core::LogRateLimiter* espHotLogLimiter_ =                        \
+           ESP_LOG_SEVERITY_##severity < ESP_MIN_LOG_LEVEL                   \
+               ? nullptr                                                     \
+               : []() {                                                      \
+                   static esp::core::LogRateLimiter limiter;                 \
+                   return &limiter;                                          \
+                 }()                                                         \
+                     ->acquire();                                            \
+       espHotLogLimiter_; espHotLogLimiter_ = nullptr)                       \
+  esp::core::AsyncLogMessage(ESP_LOG_SEVERITY_##severity, __FILE__, __LINE__, \
+                             *espHotLogLimiter_)                             \
+      .stream()
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Rate limit of the messages of a call site of @ref ESP_HOT_LOG
+ */
+class LogRateLimiter {
+ public:
+  /** @brief Minimum time in seconds between two messages of a call site */
+  static double interval();
+
+  /**
+   * @brief Set the minimum time in seconds between two messages of a call
+   * site, for all of them. Defaults to 1, 0 logs every message.
+   */
+  static void setInterval(double seconds);
+
+  /**
+   * @brief Take the permission to log a message
+   * @return this if the message is logged, nullptr if it is suppressed
+   *
+   * Thread-safe, of concurrent messages at most one is logged.
+   */
+  LogRateLimiter* acquire();
+
+  /**
+   * @brief Number of messages suppressed since the last logged one, and
+   * reset it
+   */
+  std::uint64_t takeSuppressed() {
+    return suppressed_.exchange(0, std::memory_order_relaxed);
+  }
+
+ private:
+  enum : std::int64_t { Never = INT64_MIN };
+  // steady clock time in nanoseconds of the last message logged
+  std::atomic<std::int64_t> lastNs_{Never};
+  std::atomic<std::uint64_t> suppressed_{0};
+};
+
+/**
+ * @brief A message being streamed to by @ref ESP_HOT_LOG, handed to
+ * @ref AsyncLogSink when destroyed
+ */
+class AsyncLogMessage {
+ public:
+  AsyncLogMessage(int severity,
+                  const char* file,
+                  int line,
+                  LogRateLimiter& limiter)
+      : severity_{severity}, file_{file}, line_{line}, limiter_(limiter) {}
+
+  ~AsyncLogMessage();
+
+  AsyncLogMessage(const AsyncLogMessage&) = delete;
+  AsyncLogMessage& operator=(const AsyncLogMessage&) = delete;
+
+  std::ostream& stream() { return stream_; }
+
+ private:
+  int severity_;
+  const char* file_;
+  int line_;
+  LogRateLimiter& limiter_;
+  std::ostringstream stream_;
+};
+
+/**
+ * @brief Process-wide queue of the messages of @ref ESP_HOT_LOG and the
+ * thread writing them to the log
+ *
+ * The thread is started by the first message, and again in a child process
+ * forked afterwards, which doesn't write the messages still queued in the
+ * parent. At most @ref MaxQueuedMessages are queued, the ones beyond are
+ * dropped and counted in the next one written. The queue is drained when the
+ * process exits. Without threads, e.g. on Emscripten, messages are written
+ * right away.
+ */
+class AsyncLogSink {
+ public:
+  enum : std::size_t { MaxQueuedMessages = 4096 };
+
+  /** @brief A formatted message */
+  struct Record {
+    int severity;
+    //! the __FILE__ of the call site, with static lifetime
+    const char* file;
+    int line;
+    std::string message;
+  };
+
+  /** @brief The sink, created on first use */
+  static AsyncLogSink& instance();
+
+  ~AsyncLogSink();
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+  /** @brief Queue @p record, or drop it if the queue is full */
+  void push(Record&& record);
+
+  /** @brief Wait until the queued messages are written */
+  void flush();
+
+  /**
+   * @brief Set where the messages are written, nullptr for glog, e.g. to
+   * capture them in a test. Flushes first.
+   */
+  void setOutput(std::function<void(const Record&)> output);
+
+ private:
+  AsyncLogSink();
+  void start();
+  void run();
+  void write(const Record& record);
+  static void lockForFork();
+  static void unlockAfterFork();
+  static void resetAfterFork();
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::condition_variable drained_;
+  std::deque<Record> records_;
+  // messages dropped since the last one written
+  std::size_t dropped_ = 0;
+  // whether the thread is writing a record taken off the queue
+  bool writing_ = false;
+  bool stopping_ = false;
+  // leaked, not destroyed, in a forked child where the thread doesn't exist
+  std::unique_ptr<std::thread> thread_;
+  std::function<void(const Record&)> output_;
+};
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_ASYNCLOG_H_
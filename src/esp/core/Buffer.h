@@ -25,8 +25,12 @@ enum class DataType {
   DT_UINT64 = 8,
   DT_FLOAT = 9,
   DT_DOUBLE = 10,
+  DT_FLOAT16 = 11,
 };
 
+//! Size in bytes of an element of @p dataType, 0 for @ref DataType::DT_NONE
+size_t getDataTypeByteSize(DataType dataType);
+
 class Buffer {
  public:
   explicit Buffer() {}
@@ -0,0 +1,206 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "Configuration.h"
+
+#include <functional>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace core {
+
+namespace {
+template <typename T>
+std::string format(const T& value) {
+  return Cr::Utility::ConfigurationValue<T>::toString(value, {});
+}
+
+template <typename T>
+T parse(const std::string& value) {
+  return Cr::Utility::ConfigurationValue<T>::fromString(value, {});
+}
+}  // namespace
+
+int Configuration::addStringToGroup(const std::string& key,
+                                    const std::string& value) {
+  entries_.push_back({std::hash<std::string>{}(key), key, {}});
+  store(entries_.back().value, value);
+  int count = 0;
+  for (const Entry& entry : entries_) {
+    count += (entry.key == key);
+  }
+  return count;
+}
+
+std::vector<std::string> Configuration::getStringGroup(
+    const std::string& key) const {
+  std::vector<std::string> strings;
+  const std::size_t keyHash = std::hash<std::string>{}(key);
+  for (const Entry& entry : entries_) {
+    if (entry.keyHash == keyHash && entry.key == key) {
+      strings.push_back(toString(entry.value));
+    }
+  }
+  return strings;
+}
+
+bool Configuration::removeValue(const std::string& key) {
+  const std::size_t keyHash = std::hash<std::string>{}(key);
+  for (auto entry = entries_.begin(); entry != entries_.end(); ++entry) {
+    if (entry->keyHash == keyHash && entry->key == key) {
+      entries_.erase(entry);
+      return true;
+    }
+  }
+  return false;
+}
+
+Cr::Utility::ConfigurationGroup Configuration::getConfigurationGroup() const {
+  Cr::Utility::ConfigurationGroup group;
+  for (const Entry& entry : entries_) {
+    group.addValue(entry.key, toString(entry.value));
+  }
+  return group;
+}
+
+const Configuration::Value* Configuration::find(const std::string& key) const {
+  const std::size_t keyHash = std::hash<std::string>{}(key);
+  for (const Entry& entry : entries_) {
+    if (entry.keyHash == keyHash && entry.key == key) {
+      return &entry.value;
+    }
+  }
+  return nullptr;
+}
+
+Configuration::Value& Configuration::findOrAdd(const std::string& key) {
+  const std::size_t keyHash = std::hash<std::string>{}(key);
+  for (Entry& entry : entries_) {
+    if (entry.keyHash == keyHash && entry.key == key) {
+      return entry.value;
+    }
+  }
+  entries_.push_back({keyHash, key, {}});
+  return entries_.back().value;
+}
+
+void Configuration::store(Value& value, const std::string& x) {
+  value.type = ValueType::String;
+  value.string = x;
+}
+
+void Configuration::store(Value& value, bool x) {
+  value.type = ValueType::Bool;
+  value.boolean = x;
+  value.string.clear();
+}
+
+void Configuration::store(Value& value, int x) {
+  value.type = ValueType::Int;
+  value.integer = x;
+  value.string.clear();
+}
+
+void Configuration::store(Value& value, float x) {
+  value.type = ValueType::Float;
+  value.real = x;
+  value.string.clear();
+}
+
+void Configuration::store(Value& value, double x) {
+  value.type = ValueType::Double;
+  value.realDouble = x;
+  value.string.clear();
+}
+
+void Configuration::store(Value& value, const Mn::Vector3& x) {
+  value.type = ValueType::Vec3;
+  value.vector[0] = x.x();
+  value.vector[1] = x.y();
+  value.vector[2] = x.z();
+  value.string.clear();
+}
+
+void Configuration::store(Value& value, const Mn::Quaternion& x) {
+  value.type = ValueType::Quat;
+  value.vector[0] = x.vector().x();
+  value.vector[1] = x.vector().y();
+  value.vector[2] = x.vector().z();
+  value.vector[3] = x.scalar();
+  value.string.clear();
+}
+
+void Configuration::store(Value& value, Mn::Rad x) {
+  value.type = ValueType::Rad;
+  value.real = float(x);
+  value.string.clear();
+}
+
+void Configuration::load(const Value& value, std::string& x) {
+  x = value.type == ValueType::String ? value.string : toString(value);
+}
+
+void Configuration::load(const Value& value, bool& x) {
+  x = value.type == ValueType::Bool ? value.boolean
+                                    : parse<bool>(toString(value));
+}
+
+void Configuration::load(const Value& value, int& x) {
+  x = value.type == ValueType::Int ? value.integer
+                                   : parse<int>(toString(value));
+}
+
+void Configuration::load(const Value& value, float& x) {
+  x = value.type == ValueType::Float ? value.real
+                                     : parse<float>(toString(value));
+}
+
+void Configuration::load(const Value& value, double& x) {
+  x = value.type == ValueType::Double ? value.realDouble
+                                      : parse<double>(toString(value));
+}
+
+void Configuration::load(const Value& value, Mn::Vector3& x) {
+  x = value.type == ValueType::Vec3 ? Mn::Vector3::from(value.vector)
+                                    : parse<Mn::Vector3>(toString(value));
+}
+
+void Configuration::load(const Value& value, Mn::Quaternion& x) {
+  x = value.type == ValueType::Quat
+          ? Mn::Quaternion{Mn::Vector3::from(value.vector), value.vector[3]}
+          : parse<Mn::Quaternion>(toString(value));
+}
+
+void Configuration::load(const Value& value, Mn::Rad& x) {
+  x = value.type == ValueType::Rad ? Mn::Rad{value.real}
+                                   : parse<Mn::Rad>(toString(value));
+}
+
+std::string Configuration::toString(const Value& value) {
+  switch (value.type) {
+    case ValueType::String:
+      return value.string;
+    case ValueType::Bool:
+      return format(value.boolean);
+    case ValueType::Int:
+      return format(value.integer);
+    case ValueType::Float:
+      return format(value.real);
+    case ValueType::Double:
+      return format(value.realDouble);
+    case ValueType::Vec3:
+      return format(Mn::Vector3::from(value.vector));
+    case ValueType::Quat:
+      return format(
+          Mn::Quaternion{Mn::Vector3::from(value.vector), value.vector[3]});
+    case ValueType::Rad:
+      return format(Mn::Rad{value.real});
+  }
+  return {};
+}
+
+}  // namespace core
+}  // namespace esp
@@ -7,14 +7,30 @@
 
 #include <Corrade/Utility/Configuration.h>
 #include <Magnum/Magnum.h>
+#include <Magnum/Math/Angle.h>
 #include <Magnum/Math/ConfigurationValue.h>
+#include <Magnum/Math/Quaternion.h>
+#include <Magnum/Math/Vector3.h>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "esp/core/esp.h"
 
 namespace esp {
 namespace core {
 
+/**
+ * @brief Values by key, e.g. the properties of attributes
+ *
+ * The values are stored as the type they were set with, so that getting them
+ * as that type, e.g. @ref getDouble() after @ref setDouble(), doesn't parse
+ * or format anything. Getting a value as another type converts it through
+ * its string representation, like a @ref Corrade::Utility::ConfigurationGroup
+ * storing all values as strings does; @ref getConfigurationGroup() makes one
+ * for the code that needs it.
+ */
 class Configuration {
  public:
   // virtual destructor set to that pybind11 recognizes attributes inheritance
@@ -23,7 +39,11 @@ class Configuration {
 
   template <typename T>
   bool set(const std::string& key, const T& value) {
-    return cfg.setValue(key, value);
+    store(findOrAdd(key), value);
+    return true;
+  }
+  bool set(const std::string& key, const char* value) {
+    return set(key, std::string{value});
   }
   bool setBool(const std::string& key, bool value) { return set(key, value); }
   bool setFloat(const std::string& key, float value) { return set(key, value); }
@@ -43,9 +63,18 @@ class Configuration {
   bool setRad(const std::string& key, Magnum::Rad value) {
     return set(key, value);
   }
+
+  /**
+   * @brief Get the value of @p key as @p T, a default-constructed one if
+   * there is none
+   */
   template <typename T>
   T get(const std::string& key) const {
-    return cfg.value<T>(key);
+    T result{};
+    if (const Value* value = find(key)) {
+      load(*value, result);
+    }
+    return result;
   }
   bool getBool(const std::string& key) const { return get<bool>(key); }
   float getFloat(const std::string& key) const { return get<float>(key); }
@@ -65,61 +94,95 @@ class Configuration {
   }
 
   /**@brief Add a string to a group and return the resulting group size. */
-  int addStringToGroup(const std::string& key, const std::string& value) {
-    cfg.addValue(key, value);
-    return cfg.valueCount(key);
-  }
+  int addStringToGroup(const std::string& key, const std::string& value);
 
   /**@brief Collect and return strings in a key group. */
-  std::vector<std::string> getStringGroup(const std::string& key) const {
-    std::vector<std::string> strings;
-    for (size_t v = 0; v < cfg.valueCount(key); ++v) {
-      strings.push_back(cfg.value<std::string>(key, v));
-    }
-    return strings;
-  }
-
-  bool hasValue(const std::string& key) const { return cfg.hasValue(key); }
-
-  bool removeValue(const std::string& key) { return cfg.removeValue(key); }
-
- protected:
-  Corrade::Utility::ConfigurationGroup cfg;
-
-  ESP_SMART_POINTERS(Configuration)
-};
-
-// Below uses std::variant; not yet available in clang c++17
-/*
-#include <std/variant>
-
-class Configuration {
- public:
-  Configuration() : values_() {}
-
+  std::vector<std::string> getStringGroup(const std::string& key) const;
+
+  bool hasValue(const std::string& key) const { return find(key) != nullptr; }
+
+  /**@brief Remove the value of @p key, the first of a group. */
+  bool removeValue(const std::string& key);
+
+  /**
+   * @brief The values as strings in a Corrade configuration group, in the
+   * order they were added, e.g. for the configuration of a plugin
+   */
+  Corrade::Utility::ConfigurationGroup getConfigurationGroup() const;
+
+ private:
+  enum class ValueType : std::uint8_t {
+    String,
+    Bool,
+    Int,
+    Float,
+    Double,
+    Vec3,
+    Quat,
+    Rad
+  };
+
+  struct Value {
+    Value() : vector{} {}
+
+    ValueType type = ValueType::String;
+    union {
+      bool boolean;
+      int integer;
+      float real;
+      double realDouble;
+      // Vec3 and Quat, as x, y, z (, w); Rad in the first
+      float vector[4];
+    };
+    std::string string;
+  };
+
+  struct Entry {
+    //! std::hash of the key, compared before the key itself
+    std::size_t keyHash;
+    std::string key;
+    Value value;
+  };
+
+  const Value* find(const std::string& key) const;
+  Value& findOrAdd(const std::string& key);
+
+  static void store(Value& value, const std::string& x);
+  static void store(Value& value, bool x);
+  static void store(Value& value, int x);
+  static void store(Value& value, float x);
+  static void store(Value& value, double x);
+  static void store(Value& value, const Magnum::Vector3& x);
+  static void store(Value& value, const Magnum::Quaternion& x);
+  static void store(Value& value, Magnum::Rad x);
+  // any other type as its string representation
   template <typename T>
-  bool set(const std::string& key, const T& value) {
-    bool didOverride = hasValue(key);
-    values_[key] = value;
-    return didOverride;
-  }
-
+  static void store(Value& value, const T& x) {
+    store(value, Corrade::Utility::ConfigurationValue<T>::toString(x, {}));
+  }
+
+  static void load(const Value& value, std::string& x);
+  static void load(const Value& value, bool& x);
+  static void load(const Value& value, int& x);
+  static void load(const Value& value, float& x);
+  static void load(const Value& value, double& x);
+  static void load(const Value& value, Magnum::Vector3& x);
+  static void load(const Value& value, Magnum::Quaternion& x);
+  static void load(const Value& value, Magnum::Rad& x);
   template <typename T>
-  T get(const std::string& key) const {
-    return boost::get<T>(values_.at(key));
+  static void load(const Value& value, T& x) {
+    x = Corrade::Utility::ConfigurationValue<T>::fromString(toString(value),
+                                                             {});
   }
 
-  bool hasValue(const std::string& key) {
-    return values_.count(key) > 0;
-  }
+  //! The value as a Corrade configuration formats it
+  static std::string toString(const Value& value);
 
- protected:
-  typedef boost::variant<bool, int, float, double, std::string> ConfigValue;
-  std::map<std::string, ConfigValue> values_;
+  //! In the order they were added, several for the keys of string groups
+  std::vector<Entry> entries_;
 
   ESP_SMART_POINTERS(Configuration)
 };
-*/
 
 }  // namespace core
 }  // namespace esp
@@ -29,6 +29,7 @@ class ManagedContainer : public ManagedContainerBase {
                 "AbstractManagedObject");
 
   typedef std::shared_ptr<T> ManagedPtr;
+  typedef std::shared_ptr<const T> ManagedCPtr;
 
   ManagedContainer(const std::string& metadataType)
       : ManagedContainerBase(metadataType) {}
@@ -100,11 +101,30 @@ class ManagedContainer : public ManagedContainerBase {
                  << ". Aborting.";
       return nullptr;
     }
-    // convert doc to const value
-    const io::JsonGenericValue config = docConfig.GetObject();
+    return this->createObjectFromJSONDoc(filename, docConfig, registerObject);
+  }  // ManagedContainer::createObjectFromJSONFile
+
+  /**
+   * @brief Creates an instance of a managed object from an already parsed
+   * JSON file, e.g. one of a batch parsed in parallel.
+   *
+   * @param filename the name of the file @p docConfig was parsed from.
+   * @param docConfig the parsed JSON document.
+   * @param registerObject whether to add this managed object to the
+   * library.
+   * @return a reference to the desired managed object, or nullptr if fails.
+   */
+  ManagedPtr createObjectFromJSONDoc(const std::string& filename,
+                                     const io::JsonDocument& docConfig,
+                                     bool registerObject = true) {
+    // a document is its root value
+    const io::JsonGenericValue& config = docConfig;
     ManagedPtr attr = this->buildManagedObjectFromDoc(filename, config);
+    if (nullptr == attr) {
+      return nullptr;
+    }
     return this->postCreateRegister(attr, registerObject);
-  }  // ManagedContainer::createObjectFromJSONFile
+  }  // ManagedContainer::createObjectFromJSONDoc
 
   /**
    * @brief Method to load a Managed Object's data from a file.  If the file
@@ -221,8 +241,9 @@ class ManagedContainer : public ManagedContainerBase {
    * @return A mutable reference to the object managed object, or nullptr if
    * does not exist
    */
-  ManagedPtr getObjectByID(int managedObjectID) const {
+  ManagedPtr getObjectByID(int managedObjectID) {
     std::string objectHandle = getObjectHandleByID(managedObjectID);
+    this->buildDeferredObject(objectHandle);
     if (!checkExistsWithMessage(objectHandle,
                                 "ManagedContainer::getObjectByID")) {
       return nullptr;
@@ -240,7 +261,8 @@ class ManagedContainer : public ManagedContainerBase {
    * @return A reference to the managed object, or nullptr if does not
    * exist
    */
-  ManagedPtr getObjectByHandle(const std::string& objectHandle) const {
+  ManagedPtr getObjectByHandle(const std::string& objectHandle) {
+    this->buildDeferredObject(objectHandle);
     if (!checkExistsWithMessage(objectHandle,
                                 "ManagedContainer::getObjectByHandle")) {
       return nullptr;
@@ -318,6 +340,39 @@ class ManagedContainer : public ManagedContainerBase {
     return getObjectIDByHandleOrNew(objectHandle, false);
   }  // ManagedContainer::getObjectIDByHandle
 
+  /**
+   * @brief Get the registered managed object identified by the
+   * managedObjectID, shared without copying it, for read-only use on hot
+   * paths.
+   *
+   * Registering a managed object replaces the registered one with a copy
+   * instead of changing it, so the shared managed object keeps the values it
+   * had when retrieved.  Managed objects to be edited should be retrieved with
+   * @ref getObjectCopyByID instead.
+   * @param managedObjectID The ID of the managed object.
+   * @return The managed object, or nullptr if does not exist
+   */
+  ManagedCPtr getObjectSharedByID(int managedObjectID) {
+    std::string objectHandle = getObjectHandleByID(managedObjectID);
+    return getObjectSharedByHandle(objectHandle);
+  }  // ManagedContainer::getObjectSharedByID
+
+  /**
+   * @brief Get the registered managed object specified by passed handle,
+   * shared without copying it, for read-only use on hot paths.  See @ref
+   * getObjectSharedByID.
+   * @param objectHandle the string key of the managed object desired.
+   * @return The managed object, or nullptr if does not exist
+   */
+  ManagedCPtr getObjectSharedByHandle(const std::string& objectHandle) {
+    this->buildDeferredObject(objectHandle);
+    if (!checkExistsWithMessage(objectHandle,
+                                "ManagedContainer::getObjectSharedByHandle")) {
+      return nullptr;
+    }
+    return getObjectInternal<T>(objectHandle);
+  }  // ManagedContainer::getObjectSharedByHandle
+
   /**
    * @brief Get a copy of the managed object identified by the
    * managedObjectID.
@@ -331,6 +386,7 @@ class ManagedContainer : public ManagedContainerBase {
    */
   ManagedPtr getObjectCopyByID(int managedObjectID) {
     std::string objectHandle = getObjectHandleByID(managedObjectID);
+    this->buildDeferredObject(objectHandle);
     if (!checkExistsWithMessage(objectHandle,
                                 "ManagedContainer::getObjectCopyByID")) {
       return nullptr;
@@ -348,6 +404,7 @@ class ManagedContainer : public ManagedContainerBase {
    * not exist
    */
   ManagedPtr getObjectCopyByHandle(const std::string& objectHandle) {
+    this->buildDeferredObject(objectHandle);
     if (!checkExistsWithMessage(objectHandle,
                                 "ManagedContainer::getObjectCopyByHandle")) {
       return nullptr;
@@ -444,6 +501,18 @@ class ManagedContainer : public ManagedContainerBase {
     }
   }  // setFileDirectoryFromHandle
 
+  /**
+   * @brief Called before the managed object with the passed handle is handed
+   * out, so that specializations which register placeholders for managed
+   * objects can build them on first use instead. Building may fail and remove
+   * the placeholder.
+   *
+   * @param objectHandle handle of the managed object about to be accessed,
+   * which might not exist.
+   */
+  virtual void buildDeferredObject(
+      CORRADE_UNUSED const std::string& objectHandle) {}
+
   /**
    * @brief Used Internally.  Create and configure newly-created managed object
    * with any default values, before any specific values are set.
@@ -584,7 +653,7 @@ class ManagedContainer : public ManagedContainerBase {
     ManagedPtr managedObjectCopy = copyObject(object);
     // add to libraries
     setObjectInternal(managedObjectCopy, objectHandle);
-    objectLibKeyByID_.emplace(objectID, objectHandle);
+    setObjectHandleInternal(objectID, objectHandle);
     return objectID;
   }  // ManagedContainer::addObjectToLibrary
 
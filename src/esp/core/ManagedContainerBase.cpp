@@ -4,6 +4,10 @@
 
 #include "ManagedContainerBase.h"
 
+#include <climits>
+
+#include "StartupProfile.h"
+
 namespace esp {
 namespace core {
 
@@ -85,9 +89,17 @@ ManagedContainerBase::getObjectHandlesBySubStringPerType(
 
   std::size_t strSize = strToLookFor.length();
 
+  std::string uncachedKey;
   for (std::map<int, std::string>::const_iterator iter = mapOfHandles.begin();
        iter != mapOfHandles.end(); ++iter) {
-    std::string key = Cr::Utility::String::lowercase(iter->second);
+    // the handles of the library are cached in lowercase
+    auto cached = lowercaseHandleByID_.find(iter->first);
+    const bool isCached = cached != lowercaseHandleByID_.end() &&
+                          cached->second.size() == iter->second.size();
+    if (!isCached) {
+      uncachedKey = Cr::Utility::String::lowercase(iter->second);
+    }
+    const std::string& key = isCached ? cached->second : uncachedKey;
     // be sure that key is big enough to search in (otherwise find has undefined
     // behavior)
     if (key.length() < strSize) {
@@ -144,9 +156,24 @@ ManagedContainerBase::getObjectHandlesBySubStringPerType(
   return res;
 }  // ManagedContainerBase::getObjectHandlesBySubStringPerType
 
+std::vector<std::string> ManagedContainerBase::getObjectHandlesByPrefix(
+    const std::string& prefix) const {
+  std::vector<std::string> res;
+  const std::string strToLookFor = Cr::Utility::String::lowercase(prefix);
+  for (auto iter = lowercaseHandleIndex_.lower_bound({strToLookFor, INT_MIN});
+       iter != lowercaseHandleIndex_.end() &&
+       iter->first.compare(0, strToLookFor.size(), strToLookFor) == 0;
+       ++iter) {
+    res.push_back(objectLibKeyByID_.at(iter->second));
+  }
+  return res;
+}  // ManagedContainerBase::getObjectHandlesByPrefix
+
 bool ManagedContainerBase::verifyLoadDocument(const std::string& filename,
                                               io::JsonDocument& jsonDoc) {
   if (isValidFileName(filename)) {
+    ESP_STARTUP_SPAN("io::parseJsonFile");
+    StartupProfile::addBytesRead(io::fileSize(filename));
     try {
       jsonDoc = io::parseJsonFile(filename);
     } catch (...) {
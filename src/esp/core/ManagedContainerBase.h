@@ -15,6 +15,9 @@
 #include <functional>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <Corrade/Utility/Directory.h>
 #include <Corrade/Utility/String.h>
@@ -122,6 +125,17 @@ class ManagedContainerBase {
                                               contains);
   }  // ManagedContainerBase::getObjectHandlesBySubstring
 
+  /**
+   * @brief Get a list of all managed objects whose origin handles start with
+   * prefix, ignoring prefix's case.  Uses a sorted index of the handles, so
+   * it only visits the matching handles.
+   * @param prefix prefix to search for at the start of the handles.
+   * @return vector of 0 or more managed object handles starting with the
+   * passed prefix, sorted ignoring case
+   */
+  std::vector<std::string> getObjectHandlesByPrefix(
+      const std::string& prefix) const;
+
   /**
    * @brief returns a vector of managed object handles representing the
    * system-specified undeletable managed objects this manager manages. These
@@ -151,6 +165,8 @@ class ManagedContainerBase {
   void reset() {
     objectLibKeyByID_.clear();
     objectLibrary_.clear();
+    lowercaseHandleByID_.clear();
+    lowercaseHandleIndex_.clear();
     availableObjectIDs_.clear();
     resetFinalize();
   }  // ManagedContainerBase::reset
@@ -162,16 +178,18 @@ class ManagedContainerBase {
    *
    * @param objectID The unique ID of the desired managed object.
    * @return The key referencing the managed object in @ref
-   * objectLibrary_, or nullptr if does not exist.
+   * objectLibrary_, or an empty string if does not exist.
    */
-  std::string getObjectHandleByID(const int objectID) const {
-    if (objectLibKeyByID_.count(objectID) == 0) {
+  const std::string& getObjectHandleByID(const int objectID) const {
+    static const std::string noHandle;
+    auto iter = objectLibKeyByID_.find(objectID);
+    if (iter == objectLibKeyByID_.end()) {
       LOG(ERROR) << "ManagedContainerBase::getObjectHandleByID : Unknown "
                  << objectType_ << " managed object ID:" << objectID
                  << ". Aborting";
-      return nullptr;
+      return noHandle;
     }
-    return objectLibKeyByID_.at(objectID);
+    return iter->second;
   }  // ManagedContainer::getObjectHandleByID
 
   /**
@@ -219,6 +237,23 @@ class ManagedContainerBase {
     objectLibrary_[handle] = ptr;
   }
 
+  /**
+   * @brief Only used from class template AddObject method.  Map the passed ID
+   * to the handle of the object being added and index the handle for
+   * searches.
+   * @param objectID the ID of the object being managed
+   * @param handle the name (key) used for the object in the library
+   */
+  void setObjectHandleInternal(int objectID, const std::string& handle) {
+    if (!objectLibKeyByID_.emplace(objectID, handle).second) {
+      // re-registration of an existing handle, already indexed
+      return;
+    }
+    std::string lowercaseHandle = Cr::Utility::String::lowercase(handle);
+    lowercaseHandleIndex_.emplace(lowercaseHandle, objectID);
+    lowercaseHandleByID_.emplace(objectID, std::move(lowercaseHandle));
+  }
+
   //======== Common JSON import and utility functions ========
 
   /**
@@ -369,6 +404,11 @@ class ManagedContainerBase {
   void deleteObjectInternal(int objectID, const std::string& objectHandle) {
     objectLibKeyByID_.erase(objectID);
     objectLibrary_.erase(objectHandle);
+    auto lowercaseIter = lowercaseHandleByID_.find(objectID);
+    if (lowercaseIter != lowercaseHandleByID_.end()) {
+      lowercaseHandleIndex_.erase({lowercaseIter->second, objectID});
+      lowercaseHandleByID_.erase(lowercaseIter);
+    }
     availableObjectIDs_.emplace_front(objectID);
     // call instance-specific update to remove managed object handle from any
     // local lists
@@ -384,7 +424,7 @@ class ManagedContainerBase {
   /**
    * @brief Maps string keys to managed object managed objects
    */
-  std::map<std::string, std::shared_ptr<void>> objectLibrary_;
+  std::unordered_map<std::string, std::shared_ptr<void>> objectLibrary_;
 
   /** @brief A descriptive name of the managed object being managed by this
    * manager.
@@ -397,6 +437,18 @@ class ManagedContainerBase {
    */
   std::map<int, std::string> objectLibKeyByID_;
 
+  /**
+   * @brief Lowercase handles of the managed objects by ID, so that searches
+   * ignoring case don't convert every handle
+   */
+  std::unordered_map<int, std::string> lowercaseHandleByID_;
+
+  /**
+   * @brief Lowercase handles and IDs of the managed objects, sorted for
+   * prefix searches
+   */
+  std::set<std::pair<std::string, int>> lowercaseHandleIndex_;
+
   /**
    * @brief Deque holding all IDs of deleted objects. These ID's should be
    * recycled before using map-size-based IDs
@@ -0,0 +1,178 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace core {
+
+namespace {
+const std::uint64_t XXH_PRIME1 = 11400714785074694791ull;
+const std::uint64_t XXH_PRIME2 = 14029467366897019727ull;
+const std::uint64_t XXH_PRIME3 = 1609587929392839161ull;
+const std::uint64_t XXH_PRIME4 = 9650029242287828579ull;
+const std::uint64_t XXH_PRIME5 = 2870177450012600261ull;
+
+std::uint64_t rotateLeft(const std::uint64_t x, const int bits) {
+  return (x << bits) | (x >> (64 - bits));
+}
+
+// little-endian, as all the platforms built for
+template <class T>
+T read(const char* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+std::uint64_t xxhRound(std::uint64_t accumulator, const std::uint64_t input) {
+  accumulator += input * XXH_PRIME2;
+  return rotateLeft(accumulator, 31) * XXH_PRIME1;
+}
+
+std::uint64_t xxhMerge(const std::uint64_t accumulator,
+                       const std::uint64_t lane) {
+  return (accumulator ^ xxhRound(0, lane)) * XXH_PRIME1 + XXH_PRIME4;
+}
+}  // namespace
+
+Cr::Containers::Array<char> mapFile(const std::string& filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return {};
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0 || status.st_size == 0) {
+    ::close(fd);
+    return {};
+  }
+  const std::size_t size = status.st_size;
+  // writable so that the contents can back mutable views, MAP_PRIVATE keeps
+  // writes out of the file and the other processes
+  void* data =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return {};
+  }
+  return Cr::Containers::Array<char>{
+      static_cast<char*>(data), size,
+      [](char* data, std::size_t size) { ::munmap(data, size); }};
+}
+
+Cr::Containers::Array<char> mapFile(const std::string& filename,
+                                    const std::uint64_t offset,
+                                    const std::size_t size) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return {};
+  }
+  struct stat status;
+  if (size == 0 || ::fstat(fd, &status) != 0 ||
+      offset > std::uint64_t(status.st_size) ||
+      size > std::uint64_t(status.st_size) - offset) {
+    ::close(fd);
+    return {};
+  }
+  // mmap() needs a page-aligned offset, map from the page containing it
+  static const std::size_t pageSize = ::sysconf(_SC_PAGESIZE);
+  const std::size_t lead = offset % pageSize;
+  void* data = ::mmap(nullptr, lead + size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, offset - lead);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return {};
+  }
+  return Cr::Containers::Array<char>{
+      static_cast<char*>(data) + lead, size, [](char* data, std::size_t size) {
+        const std::size_t lead =
+            reinterpret_cast<std::uintptr_t>(data) % pageSize;
+        ::munmap(data - lead, lead + size);
+      }};
+}
+
+bool writeFileAtomically(const std::string& filename,
+                         Cr::Containers::ArrayView<const char> data) {
+  const std::string temporary =
+      filename + ".tmp" + std::to_string(::getpid());
+  std::ofstream file{temporary, std::ios::binary};
+  file.write(data.data(), data.size());
+  file.close();
+  if (!file) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::uint64_t hashBytesXXH64(Cr::Containers::ArrayView<const char> data,
+                             const std::uint64_t seed) {
+  const char* p = data.data();
+  const char* const end = p + data.size();
+  std::uint64_t hash;
+  if (data.size() >= 32) {
+    // four lanes of 8 bytes, independent so that they pipeline
+    std::uint64_t lanes[4]{seed + XXH_PRIME1 + XXH_PRIME2, seed + XXH_PRIME2,
+                           seed, seed - XXH_PRIME1};
+    for (; p + 32 <= end; p += 32) {
+      for (int i = 0; i != 4; ++i) {
+        lanes[i] = xxhRound(lanes[i], read<std::uint64_t>(p + 8 * i));
+      }
+    }
+    hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) +
+           rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+    for (const std::uint64_t lane : lanes) {
+      hash = xxhMerge(hash, lane);
+    }
+  } else {
+    hash = seed + XXH_PRIME5;
+  }
+  hash += data.size();
+
+  for (; p + 8 <= end; p += 8) {
+    hash ^= xxhRound(0, read<std::uint64_t>(p));
+    hash = rotateLeft(hash, 27) * XXH_PRIME1 + XXH_PRIME4;
+  }
+  if (p + 4 <= end) {
+    hash ^= read<std::uint32_t>(p) * XXH_PRIME1;
+    hash = rotateLeft(hash, 23) * XXH_PRIME2 + XXH_PRIME3;
+    p += 4;
+  }
+  for (; p != end; ++p) {
+    hash ^= std::uint8_t(*p) * XXH_PRIME5;
+    hash = rotateLeft(hash, 11) * XXH_PRIME1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= XXH_PRIME2;
+  hash ^= hash >> 29;
+  hash *= XXH_PRIME3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+std::uint64_t hashBytes(Cr::Containers::ArrayView<const char> data) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (const char c : data) {
+    hash = (hash ^ std::uint8_t(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace core
+}  // namespace esp
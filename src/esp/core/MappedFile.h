@@ -0,0 +1,67 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_MAPPEDFILE_H_
+#define ESP_CORE_MAPPEDFILE_H_
+
+/** @file
+ * @brief Memory mapping and atomic replacement of cache files
+ */
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <cstdint>
+#include <string>
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Map @p filename into memory, copy-on-write
+ *
+ * The pages are shared by all processes mapping the same file until one of
+ * them writes to its mapping, which leaves the file untouched.
+ * @return the contents, empty if the file is missing, empty or can't be
+ * mapped
+ */
+Corrade::Containers::Array<char> mapFile(const std::string& filename);
+
+/**
+ * @brief Map @p size bytes of @p filename from @p offset, copy-on-write
+ *
+ * Like @ref mapFile(const std::string&), for files containing several
+ * independently owned parts. The offset doesn't need to be page-aligned.
+ * @return the contents, empty if the range is out of the file or can't be
+ * mapped
+ */
+Corrade::Containers::Array<char> mapFile(const std::string& filename,
+                                         std::uint64_t offset,
+                                         std::size_t size);
+
+/**
+ * @brief Write @p data to @p filename through a temporary file renamed over
+ * it, so that concurrent readers see either the old or the new contents
+ * @return whether the file was written
+ */
+bool writeFileAtomically(const std::string& filename,
+                         Corrade::Containers::ArrayView<const char> data);
+
+/**
+ * @brief FNV-1a hash of @p data, to key cache files with. Unlike
+ * @cpp std::hash @ce, it is the same in all processes and builds.
+ */
+std::uint64_t hashBytes(Corrade::Containers::ArrayView<const char> data);
+
+/**
+ * @brief XXH64 hash of @p data, several times faster than @ref hashBytes()
+ * on large data, e.g. to identify files by their contents. The same in all
+ * processes and builds too.
+ */
+std::uint64_t hashBytesXXH64(Corrade::Containers::ArrayView<const char> data,
+                             std::uint64_t seed = 0);
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_MAPPEDFILE_H_
@@ -0,0 +1,39 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_MEMORYUSAGE_H_
+#define ESP_CORE_MEMORYUSAGE_H_
+
+/** @file
+ * @brief Struct @ref esp::core::MemoryUsage
+ */
+
+#include <cstddef>
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief The estimated memory of a subsystem, in bytes
+ *
+ * Counts the data the subsystem allocated itself, not the bookkeeping of the
+ * containers or of the libraries it hands the data to.
+ */
+struct MemoryUsage {
+  //! CPU memory
+  std::size_t hostBytes = 0;
+  //! GPU memory
+  std::size_t gpuBytes = 0;
+
+  MemoryUsage& operator+=(const MemoryUsage& other) {
+    hostBytes += other.hostBytes;
+    gpuBytes += other.gpuBytes;
+    return *this;
+  }
+};
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_MEMORYUSAGE_H_
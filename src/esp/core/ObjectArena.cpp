@@ -0,0 +1,80 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObjectArena.h"
+
+#include <new>
+
+namespace esp {
+namespace core {
+
+namespace {
+// in front of every allocation, so that deallocate() finds where it belongs
+struct alignas(alignof(std::max_align_t)) Header {
+  ObjectArena* arena;
+  std::size_t sizeClass;
+};
+}  // namespace
+
+constexpr std::size_t ObjectArena::MaxPooledSize;
+
+void* ObjectArena::allocate(const std::size_t size, ObjectArena* arena) {
+  if (!arena || size > MaxPooledSize) {
+    auto* header = static_cast<Header*>(::operator new(sizeof(Header) + size));
+    header->arena = nullptr;
+    return header + 1;
+  }
+
+  const std::size_t sizeClass = (size + Alignment - 1) / Alignment;
+  Header* header;
+  FreeSlot*& freeSlot = arena->freeSlots_[sizeClass];
+  if (freeSlot) {
+    header = reinterpret_cast<Header*>(freeSlot);
+    freeSlot = freeSlot->next;
+  } else {
+    const std::size_t slotSize = sizeof(Header) + sizeClass * Alignment;
+    if (std::size_t(arena->blockEnd_ - arena->blockCursor_) < slotSize) {
+      // the rest of the current block is left unused
+      arena->blocks_.emplace_back(new char[BlockSize]);
+      arena->blockCursor_ = arena->blocks_.back().get();
+      arena->blockEnd_ = arena->blockCursor_ + BlockSize;
+    }
+    header = reinterpret_cast<Header*>(arena->blockCursor_);
+    arena->blockCursor_ += slotSize;
+  }
+  header->arena = arena;
+  header->sizeClass = sizeClass;
+  ++arena->numAllocations_;
+  return header + 1;
+}
+
+void ObjectArena::deallocate(void* pointer) {
+  if (!pointer) {
+    return;
+  }
+  Header* header = static_cast<Header*>(pointer) - 1;
+  ObjectArena* arena = header->arena;
+  if (!arena) {
+    ::operator delete(header);
+    return;
+  }
+
+  const std::size_t sizeClass = header->sizeClass;
+  auto* freeSlot = reinterpret_cast<FreeSlot*>(header);
+  freeSlot->next = arena->freeSlots_[sizeClass];
+  arena->freeSlots_[sizeClass] = freeSlot;
+  if (--arena->numAllocations_ == 0 && arena->released_) {
+    delete arena;
+  }
+}
+
+void ObjectArena::release() {
+  released_ = true;
+  if (numAllocations_ == 0) {
+    delete this;
+  }
+}
+
+}  // namespace core
+}  // namespace esp
@@ -0,0 +1,128 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_OBJECTARENA_H_
+#define ESP_CORE_OBJECTARENA_H_
+
+/** @file
+ * @brief Class @ref esp::core::ObjectArena, @ref esp::core::ArenaAllocated
+ */
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Memory for many small objects of varied sizes created and destroyed
+ * together, e.g. the nodes and drawables of a scene graph
+ *
+ * Allocations are rounded up to 16 bytes and carved out of 64 KiB blocks,
+ * and deallocated ones are kept in a free list of their size for the next
+ * allocations. The blocks are only returned to the system all at once, when
+ * the arena goes away. Allocations larger than @ref MaxPooledSize go to the
+ * heap. Not thread-safe, like the scene graphs it serves.
+ *
+ * The owner calls @ref release() rather than deleting the arena, through
+ * @ref uptr: if objects allocated in it are still alive, e.g. moved to
+ * another scene graph, the blocks outlive the owner until the last of them
+ * is deallocated.
+ */
+class ObjectArena {
+ public:
+  //! Allocations above this size are passed to the heap
+  static constexpr std::size_t MaxPooledSize = 2048;
+
+  //! Releases the arena, see @ref release()
+  struct Releaser {
+    void operator()(ObjectArena* arena) const { arena->release(); }
+  };
+
+  //! Owns an arena
+  typedef std::unique_ptr<ObjectArena, Releaser> uptr;
+
+  //! Create an arena
+  static uptr create() { return uptr{new ObjectArena}; }
+
+  ObjectArena(const ObjectArena&) = delete;
+  ObjectArena& operator=(const ObjectArena&) = delete;
+
+  /**
+   * @brief Allocate @p size bytes aligned for any type
+   * @param size  The size of the allocation
+   * @param arena The arena to allocate in, the heap if nullptr
+   */
+  static void* allocate(std::size_t size, ObjectArena* arena);
+
+  /**
+   * @brief Deallocate memory returned by @ref allocate(), in the arena it was
+   * allocated in or on the heap
+   */
+  static void deallocate(void* pointer);
+
+  /**
+   * @brief Free the blocks now if nothing allocated in the arena is alive,
+   * otherwise once the last allocation is deallocated. The arena isn't used
+   * after.
+   */
+  void release();
+
+  //! The number of live allocations in the blocks
+  std::size_t numAllocations() const { return numAllocations_; }
+
+  //! The size of the blocks taken from the system
+  std::size_t reservedBytes() const { return blocks_.size() * BlockSize; }
+
+ private:
+  ObjectArena() = default;
+  ~ObjectArena() = default;
+
+  static constexpr std::size_t Alignment = alignof(std::max_align_t);
+  static constexpr std::size_t BlockSize = 64 * 1024;
+  static constexpr std::size_t NumSizeClasses = MaxPooledSize / Alignment + 1;
+
+  // a deallocated slot, in the free list of its size
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* blockCursor_ = nullptr;
+  char* blockEnd_ = nullptr;
+  FreeSlot* freeSlots_[NumSizeClasses]{};
+  std::size_t numAllocations_ = 0;
+  bool released_ = false;
+};
+
+/**
+ * @brief Base of the classes created in an @ref ObjectArena with
+ * `new (arena) T{...}`, where a nullptr arena uses the heap as a plain
+ * `new T{...}` does; `delete` frees the memory of both
+ */
+class ArenaAllocated {
+ public:
+  static void* operator new(std::size_t size) {
+    return ObjectArena::allocate(size, nullptr);
+  }
+  static void* operator new(std::size_t size, ObjectArena* arena) {
+    return ObjectArena::allocate(size, arena);
+  }
+  static void operator delete(void* pointer) {
+    ObjectArena::deallocate(pointer);
+  }
+  // called if a constructor throws
+  static void operator delete(void* pointer, ObjectArena*) {
+    ObjectArena::deallocate(pointer);
+  }
+
+ protected:
+  ~ArenaAllocated() = default;
+};
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_OBJECTARENA_H_
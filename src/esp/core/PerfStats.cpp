@@ -0,0 +1,94 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PerfStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace esp {
+namespace core {
+
+constexpr int PerfStats::NumBuckets;
+constexpr int PerfStats::MinExponent;
+constexpr double PerfStats::MeanWeight;
+constexpr std::size_t PerfStats::NumStats;
+
+PerfStats& PerfStats::shared() {
+  static PerfStats stats;
+  return stats;
+}
+
+const char* PerfStats::name(const PerfStat stat) {
+  switch (stat) {
+    case PerfStat::Cull:
+      return "cull_ms";
+    case PerfStat::Draw:
+      return "draw_ms";
+    case PerfStat::Readback:
+      return "readback_ms";
+    case PerfStat::Physics:
+      return "physics_ms";
+    case PerfStat::Nav:
+      return "nav_ms";
+    case PerfStat::VisibleDrawables:
+      return "visible_drawables";
+    case PerfStat::ActiveContactPoints:
+      return "active_contact_points";
+    case PerfStat::TextureMemory:
+      return "texture_memory_mb";
+  }
+  return "";
+}
+
+double PerfStats::bucketLowerBound(const int bucket) {
+  return bucket == 0 ? 0.0 : std::ldexp(1.0, bucket - 1 + MinExponent);
+}
+
+void PerfStats::add(const PerfStat stat, const double value) {
+  if (!isEnabled())
+    return;
+
+  // frexp() gives value = m * 2^e with m in [0.5, 1), so value is in
+  // [2^(e - 1), 2^e)
+  int bucket = 0;
+  if (value > 0.0) {
+    int exponent;
+    std::frexp(value, &exponent);
+    bucket = std::min(std::max(exponent - MinExponent, 0), NumBuckets - 1);
+  }
+
+  Slot& slot = slots_[std::size_t(stat)];
+  std::lock_guard<std::mutex> lock{slot.mutex};
+  Stat& s = slot.stat;
+  if (s.count == 0) {
+    s.min = s.max = value;
+  } else {
+    s.min = std::min(s.min, value);
+    s.max = std::max(s.max, value);
+  }
+  ++s.count;
+  s.last = value;
+  s.total += value;
+  // a plain average until there are enough samples for the moving one
+  const double weight = std::max(MeanWeight, 1.0 / s.count);
+  s.mean += weight * (value - s.mean);
+  ++s.histogram[bucket];
+}
+
+PerfStats::Stat PerfStats::get(const PerfStat stat) const {
+  const Slot& slot = slots_[std::size_t(stat)];
+  std::lock_guard<std::mutex> lock{slot.mutex};
+  return slot.stat;
+}
+
+void PerfStats::reset() {
+  for (Slot& slot : slots_) {
+    std::lock_guard<std::mutex> lock{slot.mutex};
+    slot.stat = Stat{};
+  }
+}
+
+}  // namespace core
+}  // namespace esp
@@ -0,0 +1,168 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_PERFSTATS_H_
+#define ESP_CORE_PERFSTATS_H_
+
+/** @file
+ * @brief Class @ref esp::core::PerfStats, @ref esp::core::PerfTimer, enum
+ * @ref esp::core::PerfStat, macro @ref ESP_PERF_TIMER()
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace esp {
+namespace core {
+
+/** @brief The quantities tracked by @ref PerfStats */
+enum class PerfStat : uint8_t {
+  /** Frustum culling of a drawable group, in milliseconds */
+  Cull,
+  /** Drawing a scene graph from a camera, culling included, in milliseconds */
+  Draw,
+  /** Reading an attachment of a render target back, in milliseconds */
+  Readback,
+  /** A physics step, in milliseconds */
+  Physics,
+  /** A navmesh query, in milliseconds */
+  Nav,
+  /** Drawables left after culling, per draw */
+  VisibleDrawables,
+  /** Active contact points, per physics step */
+  ActiveContactPoints,
+  /** GPU memory of the streamed textures, in MiB, when it's sampled */
+  TextureMemory,
+};
+
+/**
+ * @brief Low-overhead aggregates of the timings and counts of the hot paths
+ *
+ * Each sample updates the count, last value, exponential moving average,
+ * extrema and a histogram of its quantity under a lock of its own, so that
+ * the hot paths can record from any thread. Nothing is recorded while the
+ * stats are disabled, which they are by default, and then recording is a
+ * branch on a flag.
+ */
+class PerfStats {
+ public:
+  /** @brief Number of histogram buckets */
+  static constexpr int NumBuckets = 32;
+
+  /**
+   * @brief Base 2 exponent of the upper bound of the first bucket
+   *
+   * Bucket @f$ i > 0 @f$ holds the values in
+   * @f$ [2^{i - 1 + m}, 2^{i + m}) @f$, the first one everything below
+   * and the last one everything above.
+   */
+  static constexpr int MinExponent = -10;
+
+  /** @brief Weight of a new sample in the moving average */
+  static constexpr double MeanWeight = 0.05;
+
+  /** @brief Number of quantities */
+  static constexpr std::size_t NumStats =
+      std::size_t(PerfStat::TextureMemory) + 1;
+
+  /** @brief Aggregates of the samples of a quantity */
+  struct Stat {
+    uint64_t count = 0;
+    double last = 0.0;
+    //! exponential moving average, the plain average of the first samples
+    double mean = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double total = 0.0;
+    std::array<uint64_t, NumBuckets> histogram{};
+  };
+
+  /** @brief The stats of the process */
+  static PerfStats& shared();
+
+  /** @brief Name of a quantity, in `snake_case` with its unit */
+  static const char* name(PerfStat stat);
+
+  /** @brief Lower bound of a histogram bucket, 0 for the first one */
+  static double bucketLowerBound(int bucket);
+
+  /** @brief Whether samples are recorded */
+  bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /** @brief Enable or disable recording, the samples so far are kept */
+  void setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /** @brief Record a sample, if enabled */
+  void add(PerfStat stat, double value);
+
+  /** @brief The aggregates of a quantity */
+  Stat get(PerfStat stat) const;
+
+  /** @brief Forget all the samples */
+  void reset();
+
+ private:
+  struct Slot {
+    mutable std::mutex mutex;
+    Stat stat;
+  };
+
+  std::array<Slot, NumStats> slots_;
+  std::atomic<bool> enabled_{false};
+};
+
+/**
+ * @brief Records the lifetime of the object in milliseconds to
+ * @ref PerfStats::shared(), if it's enabled when the timer is created
+ */
+class PerfTimer {
+ public:
+  explicit PerfTimer(PerfStat stat)
+      : stat_{stat}, active_{PerfStats::shared().isEnabled()} {
+    if (active_)
+      start_ = std::chrono::steady_clock::now();
+  }
+
+  ~PerfTimer() {
+    if (active_) {
+      const std::chrono::duration<double, std::milli> duration =
+          std::chrono::steady_clock::now() - start_;
+      PerfStats::shared().add(stat_, duration.count());
+    }
+  }
+
+  PerfTimer(const PerfTimer&) = delete;
+  PerfTimer& operator=(const PerfTimer&) = delete;
+
+ private:
+  PerfStat stat_;
+  bool active_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace core
+}  // namespace esp
+
+#define ESP_PERF_TIMER_CONCAT_IMPL(a, b) a##b
+#define ESP_PERF_TIMER_CONCAT(a, b) ESP_PERF_TIMER_CONCAT_IMPL(a, b)
+
+/**
+ * @brief Time the rest of the enclosing scope as a sample of
+ * @ref esp::core::PerfStat "PerfStat::stat"
+ *
+ * @code{.cpp}
+ * ESP_PERF_TIMER(Cull);
+ * @endcode
+ */
+#define ESP_PERF_TIMER(stat)                                                   \
+  const ::esp::core::PerfTimer ESP_PERF_TIMER_CONCAT(espPerfTimer, __LINE__) { \
+    ::esp::core::PerfStat::stat                                                \
+  }
+
+#endif  // ESP_CORE_PERFSTATS_H_
@@ -0,0 +1,78 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "Profiling.h"
+
+#include <Corrade/configure.h>
+#include <cstdlib>
+#include <cstring>
+
+#include "esp/core/esp.h"
+
+#ifdef CORRADE_TARGET_UNIX
+#include <dlfcn.h>
+#endif
+
+namespace esp {
+namespace core {
+
+namespace {
+
+// The parts of the NVTX library used here
+struct Nvtx {
+  Nvtx() {
+    const char* env = std::getenv("HABITAT_PROFILING");
+    if (!env || std::strcmp(env, "0") == 0)
+      return;
+#ifdef CORRADE_TARGET_UNIX
+    library = dlopen("libnvToolsExt.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!library)
+      library = dlopen("libnvToolsExt.so", RTLD_NOW | RTLD_LOCAL);
+    if (library) {
+      rangePush = reinterpret_cast<int (*)(const char*)>(
+          dlsym(library, "nvtxRangePushA"));
+      rangePop = reinterpret_cast<int (*)()>(dlsym(library, "nvtxRangePop"));
+    }
+#endif
+    if (isLoaded()) {
+      LOG(INFO) << "HABITAT_PROFILING=" << env
+                << ", native NVTX profiling ranges are enabled";
+    } else {
+      LOG(WARNING) << "HABITAT_PROFILING=" << env
+                   << " but the NVTX library can't be loaded, native "
+                      "profiling ranges are disabled";
+    }
+  }
+
+  bool isLoaded() const { return rangePush && rangePop; }
+
+  void* library = nullptr;
+  int (*rangePush)(const char*) = nullptr;
+  int (*rangePop)() = nullptr;
+};
+
+const Nvtx& nvtx() {
+  static const Nvtx nvtx;
+  return nvtx;
+}
+
+}  // namespace
+
+bool isProfilingEnabled() {
+  static const bool enabled = nvtx().isLoaded();
+  return enabled;
+}
+
+void profilingRangePush(const char* name) {
+  if (isProfilingEnabled())
+    nvtx().rangePush(name);
+}
+
+void profilingRangePop() {
+  if (isProfilingEnabled())
+    nvtx().rangePop();
+}
+
+}  // namespace core
+}  // namespace esp
@@ -0,0 +1,83 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_PROFILING_H_
+#define ESP_CORE_PROFILING_H_
+
+/** @file
+ * @brief Class @ref esp::core::ProfilingScope, macro @ref ESP_PROFILE_SCOPE()
+ */
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Whether native profiling ranges are recorded
+ *
+ * True if the `HABITAT_PROFILING` environment variable is set to something
+ * else than `0`, the same switch as `habitat_sim.utils.profiling_utils`, and
+ * the NVTX library of the CUDA toolkit could be loaded. It's loaded at
+ * runtime, so that it's not a build dependency. Evaluated once.
+ */
+bool isProfilingEnabled();
+
+/**
+ * @brief Open a profiling range, shown by profilers like Nvidia Nsight
+ *
+ * Does nothing unless @ref isProfilingEnabled(). Prefer
+ * @ref ESP_PROFILE_SCOPE(), which closes the range for you.
+ */
+void profilingRangePush(const char* name);
+
+/** @brief Close the innermost range of @ref profilingRangePush() */
+void profilingRangePop();
+
+/**
+ * @brief Profiling range open for the lifetime of the object
+ *
+ * Costs a branch on a cached flag when profiling is disabled.
+ */
+class ProfilingScope {
+ public:
+  /** @param name Name of the range, has to outlive the object */
+  explicit ProfilingScope(const char* name) : active_{isProfilingEnabled()} {
+    if (active_)
+      profilingRangePush(name);
+  }
+
+  ~ProfilingScope() {
+    if (active_)
+      profilingRangePop();
+  }
+
+  ProfilingScope(const ProfilingScope&) = delete;
+  ProfilingScope& operator=(const ProfilingScope&) = delete;
+
+ private:
+  bool active_;
+};
+
+}  // namespace core
+}  // namespace esp
+
+#define ESP_PROFILE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define ESP_PROFILE_SCOPE_CONCAT(a, b) ESP_PROFILE_SCOPE_CONCAT_IMPL(a, b)
+
+/**
+ * @brief Mark the rest of the enclosing scope as a profiling range
+ *
+ * @code{.cpp}
+ * void Renderer::draw(...) {
+ *   ESP_PROFILE_SCOPE("Renderer::draw");
+ *   ...
+ * }
+ * @endcode
+ */
+#define ESP_PROFILE_SCOPE(name)                               \
+  const ::esp::core::ProfilingScope ESP_PROFILE_SCOPE_CONCAT( \
+      espProfilingScope, __LINE__) {                          \
+    name                                                      \
+  }
+
+#endif  // ESP_CORE_PROFILING_H_
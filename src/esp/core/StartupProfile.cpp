@@ -0,0 +1,144 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "StartupProfile.h"
+
+#include <Corrade/Utility/FormatStl.h>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace core {
+
+StartupProfile*& StartupProfile::current() {
+  static thread_local StartupProfile* profile = nullptr;
+  return profile;
+}
+
+StartupProfile::Recording::Recording(StartupProfile& profile,
+                                     const char* name)
+    : previous_{current()} {
+  profile.spans_.clear();
+  profile.open_.clear();
+  profile.openedAt_.clear();
+  profile.start_ = Clock::now();
+  profile.open(name);
+  current() = &profile;
+}
+
+StartupProfile::Recording::~Recording() {
+  current()->close();
+  current() = previous_;
+}
+
+double StartupProfile::elapsedMs() const {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start_)
+      .count();
+}
+
+void StartupProfile::open(const char* name) {
+  const int parent = open_.empty() ? -1 : open_.back();
+  int index = -1;
+  // merge with a sibling of the same name, they're after the parent
+  for (int i = parent + 1; i < int(spans_.size()); ++i) {
+    if (spans_[i].parent == parent && spans_[i].name == name) {
+      index = i;
+      break;
+    }
+  }
+  if (index == -1) {
+    index = spans_.size();
+    Span span;
+    span.name = name;
+    span.parent = parent;
+    span.depth = open_.size();
+    span.startMs = elapsedMs();
+    spans_.push_back(std::move(span));
+  }
+  ++spans_[index].count;
+  open_.push_back(index);
+  openedAt_.push_back(Clock::now());
+}
+
+void StartupProfile::close() {
+  spans_[open_.back()].durationMs +=
+      std::chrono::duration<double, std::milli>(Clock::now() -
+                                                openedAt_.back())
+          .count();
+  open_.pop_back();
+  openedAt_.pop_back();
+}
+
+void StartupProfile::addBytesRead(const uint64_t bytes) {
+  StartupProfile* profile = current();
+  if (!profile)
+    return;
+  for (const int index : profile->open_)
+    profile->spans_[index].bytesRead += bytes;
+}
+
+void StartupProfile::addTexture(const uint64_t bytes) {
+  StartupProfile* profile = current();
+  if (!profile)
+    return;
+  for (const int index : profile->open_) {
+    ++profile->spans_[index].texturesUploaded;
+    profile->spans_[index].textureBytes += bytes;
+  }
+}
+
+void StartupProfile::addTriangles(const uint64_t triangles) {
+  StartupProfile* profile = current();
+  if (!profile)
+    return;
+  for (const int index : profile->open_)
+    profile->spans_[index].triangles += triangles;
+}
+
+std::string StartupProfile::report() const {
+  // children are printed under their parent, in the order they started
+  std::vector<std::vector<int>> children(spans_.size());
+  for (int i = 1; i < int(spans_.size()); ++i)
+    children[spans_[i].parent].push_back(i);
+
+  std::string out;
+  std::vector<int> stack;
+  if (!spans_.empty())
+    stack.push_back(0);
+  while (!stack.empty()) {
+    const Span& span = spans_[stack.back()];
+    const int index = stack.back();
+    stack.pop_back();
+    stack.insert(stack.end(), children[index].rbegin(),
+                 children[index].rend());
+
+    std::string line = std::string(2 * span.depth, ' ') + span.name;
+    if (span.count > 1)
+      line += Cr::Utility::formatString(" x{}", span.count);
+    if (line.size() < 48)
+      line.resize(48, ' ');
+    const std::string duration =
+        Cr::Utility::formatString("{:.1f}", span.durationMs);
+    if (duration.size() < 10)
+      line.append(10 - duration.size(), ' ');
+    line += " " + duration + " ms";
+    if (span.bytesRead)
+      line += Cr::Utility::formatString(", {:.1f} MB read",
+                                        span.bytesRead / 1048576.0);
+    if (span.texturesUploaded)
+      line += Cr::Utility::formatString(
+          ", {} textures ({:.1f} MB)",
+          (unsigned long long)span.texturesUploaded,
+          span.textureBytes / 1048576.0);
+    if (span.triangles)
+      line += Cr::Utility::formatString(", {} triangles",
+                                        (unsigned long long)span.triangles);
+    out += line;
+    out += '\n';
+  }
+  return out;
+}
+
+}  // namespace core
+}  // namespace esp
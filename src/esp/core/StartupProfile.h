@@ -0,0 +1,163 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_STARTUPPROFILE_H_
+#define ESP_CORE_STARTUPPROFILE_H_
+
+/** @file
+ * @brief Class @ref esp::core::StartupProfile, @ref esp::core::StartupSpan,
+ * macro @ref ESP_STARTUP_SPAN()
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Hierarchical timings of a scene load, with the sizes of what was
+ * loaded
+ *
+ * While a @ref Recording is alive, the @ref StartupSpan objects created on
+ * the same thread are recorded as a tree of spans, and the sizes added with
+ * @ref addBytesRead(), @ref addTexture() and @ref addTriangles() are counted
+ * in the innermost open span and its parents. Spans of the same name under
+ * the same parent are merged, e.g. the shaders compiled while loading a
+ * stage are one span with a count. Work done on other threads is part of the
+ * span that waits for it, with no span of its own.
+ *
+ * Without a recording, a span or a size costs a check of a thread-local
+ * pointer.
+ */
+class StartupProfile {
+ public:
+  /** @brief A span of a @ref StartupProfile */
+  struct Span {
+    /** @brief Name, e.g. `ResourceManager::loadStage` */
+    std::string name;
+    /** @brief Index of the parent span, -1 for the root */
+    int parent = -1;
+    /** @brief Nesting depth, 0 for the root */
+    int depth = 0;
+    /** @brief Number of merged spans */
+    int count = 0;
+    /** @brief Start of the first merged span since the recording started */
+    double startMs = 0.0;
+    /** @brief Total duration of the merged spans */
+    double durationMs = 0.0;
+    /** @brief Bytes read from files, including the children */
+    uint64_t bytesRead = 0;
+    /** @brief Textures uploaded to the GPU, including the children */
+    uint64_t texturesUploaded = 0;
+    /** @brief Bytes of the uploaded textures, including the children */
+    uint64_t textureBytes = 0;
+    /** @brief Triangles of the uploaded meshes, including the children */
+    uint64_t triangles = 0;
+  };
+
+  /**
+   * @brief Records a profile for its lifetime
+   *
+   * Clears the profile and opens its root span. Recordings can nest, the
+   * inner one takes over the thread until it ends.
+   */
+  class Recording {
+   public:
+    /** @param name Name of the root span, has to outlive the recording */
+    explicit Recording(StartupProfile& profile, const char* name);
+    ~Recording();
+
+    Recording(const Recording&) = delete;
+    Recording& operator=(const Recording&) = delete;
+
+   private:
+    StartupProfile* previous_;
+  };
+
+  /** @brief The spans, parents before their children */
+  const std::vector<Span>& spans() const { return spans_; }
+
+  /** @brief Whether nothing was recorded */
+  bool isEmpty() const { return spans_.empty(); }
+
+  /** @brief Duration of the root span */
+  double durationMs() const {
+    return spans_.empty() ? 0.0 : spans_[0].durationMs;
+  }
+
+  /** @brief The spans as an indented tree, one per line */
+  std::string report() const;
+
+  /** @brief Count bytes read from a file in the open span */
+  static void addBytesRead(uint64_t bytes);
+
+  /** @brief Count a texture uploaded to the GPU in the open span */
+  static void addTexture(uint64_t bytes);
+
+  /** @brief Count the triangles of a mesh uploaded to the GPU */
+  static void addTriangles(uint64_t triangles);
+
+ private:
+  friend class StartupSpan;
+  using Clock = std::chrono::steady_clock;
+
+  // The recording of the calling thread, nullptr if there is none
+  static StartupProfile*& current();
+
+  void open(const char* name);
+  void close();
+  double elapsedMs() const;
+
+  std::vector<Span> spans_;
+  // Open spans, innermost last
+  std::vector<int> open_;
+  Clock::time_point start_;
+  std::vector<Clock::time_point> openedAt_;
+};
+
+/**
+ * @brief A span of the @ref StartupProfile being recorded, if any, open for
+ * the lifetime of the object
+ */
+class StartupSpan {
+ public:
+  /** @param name Name of the span, has to outlive the object */
+  explicit StartupSpan(const char* name)
+      : profile_{StartupProfile::current()} {
+    if (profile_)
+      profile_->open(name);
+  }
+
+  ~StartupSpan() {
+    if (profile_)
+      profile_->close();
+  }
+
+  StartupSpan(const StartupSpan&) = delete;
+  StartupSpan& operator=(const StartupSpan&) = delete;
+
+ private:
+  StartupProfile* profile_;
+};
+
+}  // namespace core
+}  // namespace esp
+
+#define ESP_STARTUP_SPAN_CONCAT_IMPL(a, b) a##b
+#define ESP_STARTUP_SPAN_CONCAT(a, b) ESP_STARTUP_SPAN_CONCAT_IMPL(a, b)
+
+/**
+ * @brief Mark the rest of the enclosing scope as a span of the
+ * @ref esp::core::StartupProfile being recorded
+ */
+#define ESP_STARTUP_SPAN(name)                            \
+  const ::esp::core::StartupSpan ESP_STARTUP_SPAN_CONCAT( \
+      espStartupSpan, __LINE__) {                         \
+    name                                                  \
+  }
+
+#endif  // ESP_CORE_STARTUPPROFILE_H_
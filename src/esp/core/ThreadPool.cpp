@@ -0,0 +1,341 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace esp {
+namespace core {
+
+namespace {
+
+// the pool and queue of the worker thread running, if any
+thread_local ThreadPool* currentPool = nullptr;
+thread_local std::size_t currentWorker = 0;
+
+struct Budget {
+  std::mutex mutex;
+  std::size_t numThreads = 0;
+  ThreadPool* shared = nullptr;
+};
+
+Budget& budget() {
+  static Budget budget;
+  return budget;
+}
+
+std::size_t workersForBudget(std::size_t numThreads) {
+  if (!numThreads) {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  return numThreads > 1 ? numThreads - 1 : 1;
+}
+
+std::size_t orDefaultNumThreads(std::size_t numThreads) {
+  return numThreads ? numThreads
+                    : workersForBudget(ThreadPool::threadBudget());
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+    : ThreadPool{orDefaultNumThreads(numThreads),
+                 orDefaultNumThreads(numThreads)} {}
+
+ThreadPool::ThreadPool(std::size_t numThreads, std::size_t numActive)
+    : numActive_{std::max<std::size_t>(1, std::min(numActive, numThreads))} {
+  queues_.reserve(numThreads + 1);
+  for (std::size_t i = 0; i <= numThreads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  workers_.reserve(numThreads);
+  for (std::size_t i = 0; i < numThreads; ++i) {
+    workers_.emplace_back([this, i]() { run(i); });
+  }
+}
+
+ThreadPool& ThreadPool::shared() {
+  // created with enough threads for the budget to grow up to the hardware
+  // concurrency later
+  static ThreadPool& pool = []() -> ThreadPool& {
+    Budget& b = budget();
+    std::lock_guard<std::mutex> lock{b.mutex};
+    const std::size_t numActive = workersForBudget(b.numThreads);
+    static ThreadPool pool{std::max(workersForBudget(0), numActive),
+                           numActive};
+    b.shared = &pool;
+    return pool;
+  }();
+  return pool;
+}
+
+void ThreadPool::setThreadBudget(std::size_t numThreads) {
+  Budget& b = budget();
+  std::lock_guard<std::mutex> lock{b.mutex};
+  b.numThreads = numThreads;
+  if (b.shared) {
+    b.shared->setNumThreads(workersForBudget(numThreads));
+  }
+}
+
+std::size_t ThreadPool::threadBudget() {
+  Budget& b = budget();
+  std::lock_guard<std::mutex> lock{b.mutex};
+  return b.numThreads ? b.numThreads
+                      : std::max<std::size_t>(
+                            1, std::thread::hardware_concurrency());
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  parked_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::setNumThreads(std::size_t numThreads) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    numActive_ =
+        std::max<std::size_t>(1, std::min(numThreads, workers_.size()));
+  }
+  condition_.notify_all();
+  parked_.notify_all();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+  Queue& queue =
+      *queues_[currentPool == this ? currentWorker : externalQueue()];
+  {
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    queue.tasks.push_back(std::move(task));
+    ++queued_;
+  }
+  // the waiting threads check queued_ with the mutex locked, so taking it
+  // here makes sure they either see the task or get notified
+  { std::lock_guard<std::mutex> lock{mutex_}; }
+  condition_.notify_one();
+}
+
+void ThreadPool::notifyAll() {
+  { std::lock_guard<std::mutex> lock{mutex_}; }
+  condition_.notify_all();
+}
+
+bool ThreadPool::runOne(std::size_t self) {
+  std::function<void()> task;
+  for (std::size_t i = 0; i < queues_.size() && !task && queued_; ++i) {
+    const std::size_t index = (self + i) % queues_.size();
+    Queue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    // newest first from the own queue, oldest first when stealing
+    if (index == self && self != externalQueue()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    --queued_;
+  }
+  if (!task) {
+    return false;
+  }
+  task();
+  return true;
+}
+
+void ThreadPool::waitHelping(const std::function<bool()>& done) {
+  const std::size_t self =
+      currentPool == this ? currentWorker : externalQueue();
+  while (!done()) {
+    if (runOne(self)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock{mutex_};
+    condition_.wait(lock, [&]() { return queued_ || done(); });
+  }
+}
+
+void ThreadPool::run(std::size_t worker) {
+  currentPool = this;
+  currentWorker = worker;
+  for (;;) {
+    if (runOne(worker)) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (worker >= numActive_) {
+      parked_.wait(lock,
+                   [&]() { return stopping_ || worker < numActive_; });
+    } else {
+      condition_.wait(lock, [&]() {
+        return stopping_ || queued_ || worker >= numActive_;
+      });
+    }
+    if (stopping_ && !queued_) {
+      return;
+    }
+  }
+}
+
+std::size_t ThreadPool::numWorkers(std::size_t count,
+                                   std::size_t maxWorkers) const {
+  return std::max<std::size_t>(
+      1, std::min({count, maxWorkers, numThreads() + 1}));
+}
+
+void ThreadPool::parallelFor(
+    std::size_t count,
+    std::size_t maxWorkers,
+    const std::function<void(std::size_t index, std::size_t worker)>& body) {
+  std::atomic<std::size_t> next{0};
+  auto work = [&](std::size_t worker) {
+    try {
+      for (std::size_t index; (index = next++) < count;) {
+        body(index, worker);
+      }
+    } catch (...) {
+      next = count;
+      throw;
+    }
+  };
+
+  // the other workers reference local state, so wait for all of them before
+  // rethrowing
+  TaskGroup group{*this};
+  const std::size_t workers = numWorkers(count, maxWorkers);
+  for (std::size_t worker = 1; worker < workers; ++worker) {
+    group.run([&work, worker]() { work(worker); });
+  }
+  std::exception_ptr error;
+  try {
+    work(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  try {
+    group.wait();
+  } catch (...) {
+    if (!error) {
+      error = std::current_exception();
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::parallelForRanges(
+    std::size_t count,
+    std::size_t grainSize,
+    const std::function<void(std::size_t begin, std::size_t end)>& body) {
+  grainSize = std::max<std::size_t>(grainSize, 1);
+  parallelFor((count + grainSize - 1) / grainSize, numThreads() + 1,
+              [&](std::size_t range, std::size_t) {
+                const std::size_t begin = range * grainSize;
+                body(begin, std::min(begin + grainSize, count));
+              });
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+    : pool_(pool), state_{std::make_shared<State>()} {}
+
+TaskGroup::~TaskGroup() {
+  pool_.waitHelping([this]() { return done(); });
+}
+
+void TaskGroup::run(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    ++state_->running;
+  }
+  enqueue(pool_, state_, std::move(task));
+}
+
+void TaskGroup::then(std::function<void()> continuation) {
+  {
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    if (state_->running) {
+      state_->continuations.push_back(std::move(continuation));
+      return;
+    }
+    if (state_->error) {
+      return;
+    }
+    ++state_->running;
+  }
+  enqueue(pool_, state_, std::move(continuation));
+}
+
+bool TaskGroup::done() const {
+  std::lock_guard<std::mutex> lock{state_->mutex};
+  return !state_->running;
+}
+
+void TaskGroup::wait() {
+  pool_.waitHelping([this]() { return done(); });
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    std::swap(error, state_->error);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void TaskGroup::enqueue(ThreadPool& pool,
+                        const std::shared_ptr<State>& state,
+                        std::function<void()> task) {
+  // the state outlives the group if the last task finishes as it's destroyed
+  pool.enqueue([&pool, state, task = std::move(task)]() {
+    try {
+      task();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock{state->mutex};
+      if (!state->error) {
+        state->error = std::current_exception();
+      }
+    }
+    finish(pool, state);
+  });
+}
+
+void TaskGroup::finish(ThreadPool& pool, const std::shared_ptr<State>& state) {
+  std::vector<std::function<void()>> continuations;
+  bool done;
+  {
+    std::lock_guard<std::mutex> lock{state->mutex};
+    if (state->running == 1) {
+      if (!state->error) {
+        continuations.swap(state->continuations);
+      } else {
+        state->continuations.clear();
+      }
+    }
+    // the continuations are counted before the task is done, so that the
+    // group doesn't look done in between
+    state->running += continuations.size();
+    done = !--state->running;
+  }
+  for (std::function<void()>& continuation : continuations) {
+    enqueue(pool, state, std::move(continuation));
+  }
+  if (done) {
+    pool.notifyAll();
+  }
+}
+
+}  // namespace core
+}  // namespace esp
@@ -0,0 +1,245 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_CORE_THREADPOOL_H_
+#define ESP_CORE_THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace core {
+
+/**
+ * @brief Work-stealing task scheduler
+ *
+ * Each worker thread has a queue of its own, tasks queued by a worker go to
+ * its queue and the others to a queue shared by the threads outside of the
+ * pool. A worker runs the tasks of its queue newest first, as their data is
+ * the most likely to still be in its caches, and steals the oldest tasks of
+ * the other queues when its own is empty. Threads waiting for a
+ * @ref TaskGroup, including @ref parallelFor(), run queued tasks meanwhile
+ * instead of blocking, so groups and loops can be nested in tasks of the
+ * same pool.
+ *
+ * Used for the CPU side of asset loading, the GL side has to stay on the
+ * thread owning the context. Destroying the pool finishes the queued tasks.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Constructor
+   * @param numThreads, number of worker threads, 0 for one less than the
+   * @ref threadBudget(), as the calling thread usually works too
+   */
+  explicit ThreadPool(std::size_t numThreads = 0);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Process-wide pool for short data-parallel loops on the CPU, like
+   * post-processing of observations, created on first use
+   *
+   * Several threads can run @ref parallelFor() on it at the same time, each
+   * of them working on its own loop too. Long-running tasks belong to pools
+   * of their own so they don't hold these loops up. Runs one less worker
+   * than the @ref threadBudget().
+   */
+  static ThreadPool& shared();
+
+  /**
+   * @brief Set the number of threads the process computes on, including the
+   * calling one, 0 for the hardware concurrency
+   *
+   * Meant to be the share of the cores of each process when several
+   * simulators run on a node, so that they don't oversubscribe them. Resizes
+   * @ref shared() if it exists, up to the number of threads it was created
+   * with, and sizes the pools created afterwards with the default number of
+   * threads. The multithreaded physics worlds created afterwards step on at
+   * most this many threads too.
+   */
+  static void setThreadBudget(std::size_t numThreads);
+
+  /** @brief The thread budget, the hardware concurrency if not set */
+  static std::size_t threadBudget();
+
+  /** @brief Number of worker threads running tasks */
+  std::size_t numThreads() const { return numActive_; }
+
+  /**
+   * @brief Set the number of worker threads running tasks, between 1 and the
+   * number of threads the pool was created with
+   *
+   * The other threads finish their current task and sleep.
+   */
+  void setNumThreads(std::size_t numThreads);
+
+  /**
+   * @brief Queue @p task
+   * @return future for the result of @p task, rethrowing its exception
+   *
+   * Waiting for the future blocks, unlike waiting for a @ref TaskGroup.
+   */
+  template <class F>
+  std::future<typename std::result_of<F()>::type> submit(F&& task) {
+    using Result = typename std::result_of<F()>::type;
+    auto packaged =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    std::future<Result> result = packaged->get_future();
+    enqueue([packaged]() { (*packaged)(); });
+    return result;
+  }
+
+  /**
+   * @brief Run @p body for every index in [0, @p count) and wait for all of
+   * them
+   * @param count, number of indices
+   * @param maxWorkers, upper bound of the number of threads used, including
+   * the calling one
+   * @param body, called with the index and the worker it runs on: 0 for the
+   * calling thread, otherwise in [1, @p maxWorkers); a worker handles one
+   * index at a time, so per-worker state needs no locking
+   *
+   * Indices are handed out dynamically, so uneven costs balance out. The
+   * first exception thrown by @p body is rethrown once all workers stopped.
+   * The workers are tasks of a @ref TaskGroup, so loops can be nested.
+   */
+  void parallelFor(
+      std::size_t count,
+      std::size_t maxWorkers,
+      const std::function<void(std::size_t index, std::size_t worker)>& body);
+
+  /**
+   * @brief Run @p body for the ranges of @p grainSize indices which
+   * partition [0, @p count) on all the workers, and wait for all of them
+   *
+   * For loops whose iterations are too cheap to be handed out one by one.
+   */
+  void parallelForRanges(
+      std::size_t count,
+      std::size_t grainSize,
+      const std::function<void(std::size_t begin, std::size_t end)>& body);
+
+  /**
+   * @brief Number of workers @ref parallelFor() uses for @p count indices,
+   * at most @p maxWorkers
+   */
+  std::size_t numWorkers(std::size_t count, std::size_t maxWorkers) const;
+
+ private:
+  friend class TaskGroup;
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  ThreadPool(std::size_t numThreads, std::size_t numActive);
+
+  // the queue of the threads outside of the pool, the queues exist before
+  // the workers start
+  std::size_t externalQueue() const { return queues_.size() - 1; }
+
+  void enqueue(std::function<void()> task);
+  // runs one queued task, preferably from the queue of worker self
+  bool runOne(std::size_t self);
+  // runs queued tasks until done() is true
+  void waitHelping(const std::function<bool()>& done);
+  void notifyAll();
+  void run(std::size_t worker);
+
+  std::vector<std::thread> workers_;
+  // one per worker, then the one of the other threads
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::atomic<std::size_t> queued_{0};
+  std::atomic<std::size_t> numActive_;
+  std::mutex mutex_;
+  // the threads with nothing to run, and the workers beyond numActive_
+  std::condition_variable condition_;
+  std::condition_variable parked_;
+  bool stopping_ = false;
+
+  ESP_SMART_POINTERS(ThreadPool)
+};
+
+/**
+ * @brief Set of tasks of a @ref ThreadPool waited for together
+ *
+ * Tasks can be run from any thread, including from tasks of the group.
+ * Destroying the group waits for its tasks, so they can reference the state
+ * of the scope owning it.
+ */
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool& pool = ThreadPool::shared());
+
+  /** @brief Waits for the tasks, dropping their exceptions */
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /** @brief Queue @p task in the group */
+  void run(std::function<void()> task);
+
+  /**
+   * @brief Queue @p continuation once all the tasks of the group are done,
+   * right away if there are none
+   *
+   * The continuation is a task of the group too, so it can run more tasks,
+   * and a continuation added after it waits for them. Skipped if a task of
+   * the group threw.
+   */
+  void then(std::function<void()> continuation);
+
+  /** @brief Whether all the tasks and continuations are done */
+  bool done() const;
+
+  /**
+   * @brief Wait for all the tasks and continuations, running queued tasks of
+   * the pool meanwhile
+   *
+   * Rethrows the first exception thrown by a task since the last wait.
+   */
+  void wait();
+
+ private:
+  struct State {
+    std::mutex mutex;
+    std::size_t running = 0;
+    std::vector<std::function<void()>> continuations;
+    std::exception_ptr error;
+  };
+
+  // queues a task already counted in State::running
+  static void enqueue(ThreadPool& pool,
+                      const std::shared_ptr<State>& state,
+                      std::function<void()> task);
+  static void finish(ThreadPool& pool, const std::shared_ptr<State>& state);
+
+  ThreadPool& pool_;
+  std::shared_ptr<State> state_;
+
+  ESP_SMART_POINTERS(TaskGroup)
+};
+
+}  // namespace core
+}  // namespace esp
+
+#endif  // ESP_CORE_THREADPOOL_H_
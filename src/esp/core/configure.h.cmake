@@ -15,3 +15,5 @@
 #cmakedefine ESP_BUILD_WITH_CUDA
 
 #cmakedefine ESP_BUILD_WITH_BULLET
+
+#define ESP_MIN_LOG_LEVEL @ESP_MIN_LOG_LEVEL@
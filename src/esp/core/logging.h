@@ -7,6 +7,15 @@
 
 #include "esp/core/configure.h"
 
+// messages of a lower severity are compiled out: 0 keeps all of them, 1 drops
+// INFO, 2 drops WARNING too, see also ESP_HOT_LOG in esp/core/AsyncLog.h
+#ifndef ESP_MIN_LOG_LEVEL
+#define ESP_MIN_LOG_LEVEL 0
+#endif
+#if ESP_MIN_LOG_LEVEL > 0 && !defined(GOOGLE_STRIP_LOG)
+#define GOOGLE_STRIP_LOG ESP_MIN_LOG_LEVEL
+#endif
+
 #if defined(ESP_BUILD_GLOG_SHIM)
 
 #include <Corrade/Utility/Debug.h>
@@ -0,0 +1,49 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "random.h"
+
+#include <cmath>
+
+namespace esp {
+namespace core {
+
+void Random::normalPair(float* out) {
+  // in (0, 1], so that the logarithm is finite
+  const float u1 = static_cast<float>((next() >> 8) + 1) * (1.0f / 16777216.0f);
+  const float u2 = uniform_float_01();
+  const float radius = std::sqrt(-2.0f * std::log(u1));
+  const float angle = 6.28318530717958647692f * u2;
+  out[0] = radius * std::cos(angle);
+  out[1] = radius * std::sin(angle);
+}
+
+void Random::fillUniform(Corrade::Containers::ArrayView<float> out,
+                         const float a,
+                         const float b) {
+  for (float& value : out) {
+    value = uniform_float(a, b);
+  }
+}
+
+void Random::fillNormal(Corrade::Containers::ArrayView<float> out,
+                        const float mean,
+                        const float stddev) {
+  std::size_t i = 0;
+  if (hasSpareNormal_ && i < out.size()) {
+    hasSpareNormal_ = false;
+    out[i++] = spareNormal_ * stddev + mean;
+  }
+  for (; i + 1 < out.size(); i += 2) {
+    normalPair(&out[i]);
+    out[i] = out[i] * stddev + mean;
+    out[i + 1] = out[i + 1] * stddev + mean;
+  }
+  if (i < out.size()) {
+    out[i] = normal_float_01() * stddev + mean;
+  }
+}
+
+}  // namespace core
+}  // namespace esp
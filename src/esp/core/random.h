@@ -5,6 +5,12 @@
 #ifndef ESP_CORE_RANDOM_H_
 #define ESP_CORE_RANDOM_H_
 
+/** @file
+ * @brief Class @ref esp::core::Random
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+#include <cstdint>
 #include <random>
 
 #include "esp.h"
@@ -12,49 +18,171 @@
 namespace esp {
 namespace core {
 
+/**
+ * @brief Random number generator, a PCG32 with selectable streams
+ *
+ * The same seed and stream always give the same sequence, on every platform,
+ * unlike the standard engines and distributions. @ref split() derives an
+ * independent generator from the seed and a stream id in constant time, e.g.
+ * one for each episode or environment sampled in parallel, so the results
+ * don't depend on the order in which the threads run. The state is 16 bytes,
+ * copying a generator forks its sequence.
+ */
 class Random {
  public:
-  explicit Random(unsigned int seed = std::random_device()())
-      : gen_(seed),
-        uniform_float_01_(0, 1),
-        uniform_int_(),
-        uniform_uint32_(),
-        normal_float_01_(0, 1) {}
+  /**
+   * @brief Constructor
+   * @param seed    Seed of the sequence, random by default
+   * @param stream  Stream of the sequence, generators seeded the same way
+   *                on different streams give unrelated sequences
+   */
+  explicit Random(uint64_t seed = std::random_device()(), uint64_t stream = 0)
+      : stream_{stream} {
+    this->seed(seed);
+  }
 
   //! Seed the random generator state with the given number
-  void seed(uint32_t newSeed) { gen_.seed(newSeed); }
+  void seed(uint64_t newSeed) {
+    seed_ = newSeed;
+    // the PCG seeding sequence, the increment has to be odd
+    increment_ = (mix(stream_) << 1) | 1u;
+    state_ = 0;
+    next();
+    state_ += newSeed;
+    next();
+    hasSpareNormal_ = false;
+  }
+
+  /**
+   * @brief A new generator for @p streamId
+   *
+   * Only depends on the seed and the stream of this generator, not on how
+   * many numbers it drew, and splitting the result again gives yet other
+   * sequences.
+   */
+  Random split(uint64_t streamId) const {
+    return Random{mix(seed_ ^ mix(streamId + 0x9e3779b97f4a7c15ull)),
+                  mix(stream_ + streamId + 1)};
+  }
+
+  /**
+   * @brief The whole state of a generator, e.g. to checkpoint a run and
+   * continue the same sequence later with @ref setState()
+   */
+  struct State {
+    uint64_t state;
+    uint64_t increment;
+    uint64_t seed;
+    uint64_t stream;
+    float spareNormal;
+    uint32_t hasSpareNormal;
+  };
+
+  //! The state of the generator, see @ref State
+  State state() const {
+    return {state_,  increment_,   seed_,
+            stream_, spareNormal_, hasSpareNormal_};
+  }
+
+  //! Continue the sequence of a generator from @p state, see @ref State
+  void setState(const State& state) {
+    state_ = state.state;
+    increment_ = state.increment;
+    seed_ = state.seed;
+    stream_ = state.stream;
+    spareNormal_ = state.spareNormal;
+    hasSpareNormal_ = state.hasSpareNormal != 0;
+  }
 
   //! Return randomly sampled int distributed uniformly in [0,
   //! std::numeric_limits<int>::max()]
-  int uniform_int() { return uniform_int_(gen_); }
+  int uniform_int() { return static_cast<int>(next() >> 1); }
 
   //! Return randomly sampled uint32_t distributed uniformly in [0,
   //! std::numeric_limits<uint32_t>::max()]
-  uint32_t uniform_uint() { return uniform_uint32_(gen_); }
+  uint32_t uniform_uint() { return next(); }
 
   //! Return randomly sampled float distributed uniformly in [0, 1)
-  float uniform_float_01() { return uniform_float_01_(gen_); }
+  float uniform_float_01() {
+    // the 24 bits of the mantissa, so that 1.0f is never returned
+    return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+  }
 
   //! Return randomly sampled float distributed normally (mean=0, std=1)
-  float normal_float_01() { return normal_float_01_(gen_); }
+  float normal_float_01() {
+    if (hasSpareNormal_) {
+      hasSpareNormal_ = false;
+      return spareNormal_;
+    }
+    float normals[2];
+    normalPair(normals);
+    spareNormal_ = normals[1];
+    hasSpareNormal_ = true;
+    return normals[0];
+  }
 
   //! Return randomly sampled float distributed uniformly in [a, b)
   float uniform_float(float a, float b) {
-    return uniform_float_01_(gen_) * (b - a) + a;
+    return uniform_float_01() * (b - a) + a;
   }
 
-  //! Return randomly sampled int distributed uniformly in [a, b)
+  //! Return randomly sampled int distributed uniformly in [a, b), @p a if
+  //! the range is empty
   int uniform_int(int a, int b) {
-    return static_cast<int>(
-        uniform_float(static_cast<float>(a), static_cast<float>(b)));
+    if (b <= a) {
+      return a;
+    }
+    // multiply and shift instead of a modulo, the bias is below 2^-32
+    const uint64_t range = static_cast<uint64_t>(int64_t{b} - a);
+    return static_cast<int>(a + ((uint64_t{next()} * range) >> 32));
   }
 
+  /**
+   * @brief Fill @p out with floats distributed uniformly in [a, b)
+   *
+   * Draws the same numbers as calling @ref uniform_float() for each.
+   */
+  void fillUniform(Corrade::Containers::ArrayView<float> out,
+                   float a = 0.0f,
+                   float b = 1.0f);
+
+  /**
+   * @brief Fill @p out with floats distributed normally
+   *
+   * Draws the same numbers as calling @ref normal_float_01() for each, scaled
+   * by @p stddev and offset by @p mean.
+   */
+  void fillNormal(Corrade::Containers::ArrayView<float> out,
+                  float mean = 0.0f,
+                  float stddev = 1.0f);
+
  protected:
-  std::default_random_engine gen_;
-  std::uniform_real_distribution<float> uniform_float_01_;
-  std::uniform_int_distribution<int> uniform_int_;
-  std::uniform_int_distribution<uint32_t> uniform_uint32_;
-  std::normal_distribution<float> normal_float_01_;
+  // splitmix64 finalizer, turning seeds and stream ids into well mixed bits
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  // PCG-XSH-RR, a 64-bit LCG step and a permutation of its old state
+  uint32_t next() {
+    const uint64_t old = state_;
+    state_ = old * 6364136223846793005ull + increment_;
+    const uint32_t xorshifted =
+        static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    const uint32_t rotation = static_cast<uint32_t>(old >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+  }
+
+  // two independent normals from the Box-Muller transform
+  void normalPair(float* out);
+
+  uint64_t state_ = 0;
+  uint64_t increment_ = 1;
+  uint64_t seed_ = 0;
+  uint64_t stream_ = 0;
+  float spareNormal_ = 0.0f;
+  bool hasSpareNormal_ = false;
 
   ESP_SMART_POINTERS(Random);
 };
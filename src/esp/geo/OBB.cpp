@@ -4,6 +4,8 @@
 
 #include "OBB.h"
 
+#include <Corrade/Utility/Assert.h>
+#include <cmath>
 #include <vector>
 
 #include "esp/geo/geo.h"
@@ -90,6 +92,109 @@ vec3f OBB::closestPoint(const vec3f& p) const {
   return closest;
 }
 
+void ObbsSoA::push_back(const OBB& obb) {
+  const Transform::ConstLinearPart w = obb.worldToLocal().linear();
+  const Transform::ConstTranslationPart t = obb.worldToLocal().translation();
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 3; ++col) {
+      worldToLocal[4 * row + col].push_back(w(row, col));
+    }
+    worldToLocal[4 * row + 3].push_back(t[row]);
+  }
+  const Transform::ConstLinearPart l = obb.localToWorld().linear();
+  for (int col = 0; col < 3; ++col) {
+    for (int row = 0; row < 3; ++row) {
+      localToWorld[3 * col + row].push_back(l(row, col));
+    }
+  }
+}
+
+namespace {
+
+// the point in the local [-1,1]^3 coordinates of the box at item
+struct LocalPoint {
+  float x, y, z;
+};
+
+inline LocalPoint toLocal(const float* const* w,
+                          const uint32_t item,
+                          const vec3f& p) {
+  return {
+      w[0][item] * p.x() + w[1][item] * p.y() + w[2][item] * p.z() + w[3][item],
+      w[4][item] * p.x() + w[5][item] * p.y() + w[6][item] * p.z() + w[7][item],
+      w[8][item] * p.x() + w[9][item] * p.y() + w[10][item] * p.z() +
+          w[11][item]};
+}
+
+}  // namespace
+
+/* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+void obbsContain(const ObbsSoA& obbs,
+                 Cr::Containers::ArrayView<const uint32_t> items,
+                 const vec3f& point,
+                 Cr::Containers::ArrayView<char> contained,
+                 float epsilon) {
+  CORRADE_ASSERT(contained.size() == items.size(),
+                 "geo::obbsContain(): expected" << items.size()
+                                                << "outputs, got"
+                                                << contained.size(), );
+  /* Raw pointers so the optimizer doesn't have to prove the vectors don't
+     alias the output. */
+  const float* w[12];
+  for (int i = 0; i < 12; ++i) {
+    w[i] = obbs.worldToLocal[i].data();
+  }
+  const float bound = 1.0f + epsilon;
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    const LocalPoint local = toLocal(w, items[i], point);
+    contained[i] = char((std::abs(local.x) <= bound) &
+                        (std::abs(local.y) <= bound) &
+                        (std::abs(local.z) <= bound));
+  }
+}
+
+/* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+void obbsDistance(const ObbsSoA& obbs,
+                  Cr::Containers::ArrayView<const uint32_t> items,
+                  const vec3f& point,
+                  Cr::Containers::ArrayView<float> distances) {
+  CORRADE_ASSERT(distances.size() == items.size(),
+                 "geo::obbsDistance(): expected" << items.size()
+                                                 << "outputs, got"
+                                                 << distances.size(), );
+  const float* w[12];
+  for (int i = 0; i < 12; ++i) {
+    w[i] = obbs.worldToLocal[i].data();
+  }
+  const float* l[9];
+  for (int i = 0; i < 9; ++i) {
+    l[i] = obbs.localToWorld[i].data();
+  }
+  const float bound = 1.0f + 1e-6f;
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    const uint32_t item = items[i];
+    const LocalPoint local = toLocal(w, item, point);
+    /* The offset from the closest point, which clamps the local coordinates
+       to the box like OBB::closestPoint(), back in world space. */
+    const float dx = local.x - clamp(local.x, -1.0f, 1.0f);
+    const float dy = local.y - clamp(local.y, -1.0f, 1.0f);
+    const float dz = local.z - clamp(local.z, -1.0f, 1.0f);
+    const float wx = l[0][item] * dx + l[3][item] * dy + l[6][item] * dz;
+    const float wy = l[1][item] * dx + l[4][item] * dy + l[7][item] * dz;
+    const float wz = l[2][item] * dx + l[5][item] * dy + l[8][item] * dz;
+    const bool inside = (std::abs(local.x) <= bound) &
+                        (std::abs(local.y) <= bound) &
+                        (std::abs(local.z) <= bound);
+    distances[i] = inside ? 0.0f : std::sqrt(wx * wx + wy * wy + wz * wz);
+  }
+}
+
 OBB& OBB::rotate(const quatf& q) {
   rotation_ = q * rotation_;
   recomputeTransforms();
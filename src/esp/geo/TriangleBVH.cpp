@@ -0,0 +1,321 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "TriangleBVH.h"
+
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Vector3.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "esp/core/Profiling.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace geo {
+
+namespace {
+const int NUM_BINS = 16;
+// deeper splits are made at the median, which bounds the traversal stack
+const int MAX_SAH_DEPTH = 40;
+// a node at depth d leaves at most d + 1 nodes on the stack, and the median
+// splits add at most 32 levels
+const int TRAVERSAL_STACK_SIZE = MAX_SAH_DEPTH + 32 + 1;
+
+float halfArea(const Mn::Range3D& box) {
+  const Mn::Vector3 size = box.size();
+  return size.x() * size.y() + size.y() * size.z() + size.z() * size.x();
+}
+
+Mn::Range3D inverted() {
+  return {Mn::Vector3{std::numeric_limits<float>::max()},
+          Mn::Vector3{-std::numeric_limits<float>::max()}};
+}
+
+void grow(Mn::Range3D& box, const Mn::Range3D& other) {
+  box = {Mn::Math::min(box.min(), other.min()),
+         Mn::Math::max(box.max(), other.max())};
+}
+}  // namespace
+
+void TriangleBVH::addMesh(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    const Mn::Matrix4& transform) {
+  CORRADE_ASSERT(indices.size() % 3 == 0,
+                 "geo::TriangleBVH::addMesh(): index count"
+                     << indices.size() << "is not divisible by 3", );
+  triangles_.reserve(triangles_.size() + indices.size() / 3);
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const Mn::Vector3 a = transform.transformPoint(positions[indices[i]]);
+    const Mn::Vector3 b = transform.transformPoint(positions[indices[i + 1]]);
+    const Mn::Vector3 c = transform.transformPoint(positions[indices[i + 2]]);
+    triangles_.push_back({a, b - a, c - a, uint32_t(triangles_.size())});
+  }
+  nodes_.clear();
+}
+
+void TriangleBVH::build(const std::size_t maxLeafTriangles) {
+  ESP_PROFILE_SCOPE("geo::TriangleBVH::build");
+  nodes_.clear();
+  const std::size_t numTriangles = triangles_.size();
+  if (numTriangles == 0) {
+    return;
+  }
+
+  std::vector<Mn::Range3D> boxes(numTriangles);
+  std::vector<Mn::Vector3> centroids(numTriangles);
+  for (std::size_t i = 0; i < numTriangles; ++i) {
+    const Triangle& t = triangles_[i];
+    const Mn::Vector3 b = t.v0 + t.e1;
+    const Mn::Vector3 c = t.v0 + t.e2;
+    boxes[i] = {Mn::Math::min(t.v0, Mn::Math::min(b, c)),
+                Mn::Math::max(t.v0, Mn::Math::max(b, c))};
+    centroids[i] = boxes[i].center();
+  }
+  std::vector<uint32_t> order(numTriangles);
+  std::iota(order.begin(), order.end(), 0);
+
+  // at most 2n - 1 nodes, the root first
+  nodes_.reserve(2 * numTriangles);
+  nodes_.push_back({{}, 0, {}, uint32_t(numTriangles)});
+  struct Task {
+    uint32_t node;
+    int depth;
+  };
+  std::vector<Task> tasks{{0, 0}};
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    const uint32_t first = nodes_[task.node].first;
+    const uint32_t count = nodes_[task.node].count;
+    const auto begin = order.begin() + first;
+    const auto end = begin + count;
+
+    Mn::Range3D box = inverted();
+    Mn::Range3D centroidBox = inverted();
+    for (auto it = begin; it != end; ++it) {
+      grow(box, boxes[*it]);
+      grow(centroidBox, {centroids[*it], centroids[*it]});
+    }
+    nodes_[task.node].min = box.min();
+    nodes_[task.node].max = box.max();
+
+    const Mn::Vector3 extent = centroidBox.size();
+    const int axis = extent.x() > extent.y()
+                         ? (extent.x() > extent.z() ? 0 : 2)
+                         : (extent.y() > extent.z() ? 1 : 2);
+    if (count <= maxLeafTriangles || extent[axis] <= 0.0f) {
+      continue;
+    }
+
+    auto middle = begin;
+    if (task.depth < MAX_SAH_DEPTH) {
+      // the bounds and triangle counts of the bins, then the cost of the
+      // split after each bin, the sum of the areas of both sides weighted by
+      // their triangle counts
+      const float scale = NUM_BINS / extent[axis];
+      const float origin = centroidBox.min()[axis];
+      auto binOf = [&](const uint32_t triangle) {
+        return std::min(NUM_BINS - 1,
+                        int((centroids[triangle][axis] - origin) * scale));
+      };
+      Mn::Range3D binBoxes[NUM_BINS];
+      std::size_t binCounts[NUM_BINS]{};
+      std::fill(std::begin(binBoxes), std::end(binBoxes), inverted());
+      for (auto it = begin; it != end; ++it) {
+        const int bin = binOf(*it);
+        grow(binBoxes[bin], boxes[*it]);
+        ++binCounts[bin];
+      }
+      float leftCosts[NUM_BINS - 1];
+      Mn::Range3D leftBox = inverted();
+      std::size_t leftCount = 0;
+      for (int bin = 0; bin < NUM_BINS - 1; ++bin) {
+        grow(leftBox, binBoxes[bin]);
+        leftCount += binCounts[bin];
+        leftCosts[bin] = leftCount ? halfArea(leftBox) * leftCount : 0.0f;
+      }
+      float bestCost = std::numeric_limits<float>::max();
+      int bestBin = -1;
+      Mn::Range3D rightBox = inverted();
+      std::size_t rightCount = 0;
+      for (int bin = NUM_BINS - 1; bin > 0; --bin) {
+        grow(rightBox, binBoxes[bin]);
+        rightCount += binCounts[bin];
+        const float cost = leftCosts[bin - 1] + halfArea(rightBox) * rightCount;
+        if (rightCount && rightCount < count && cost < bestCost) {
+          bestCost = cost;
+          bestBin = bin - 1;
+        }
+      }
+      // small nodes become leaves where testing all their triangles costs
+      // less than any split
+      if ((bestBin < 0 || bestCost >= halfArea(box) * count) &&
+          count <= 4 * maxLeafTriangles) {
+        continue;
+      }
+      if (bestBin >= 0) {
+        middle = std::partition(begin, end, [&](const uint32_t triangle) {
+          return binOf(triangle) <= bestBin;
+        });
+      }
+    }
+    if (middle == begin || middle == end) {
+      middle = begin + count / 2;
+      std::nth_element(begin, middle, end,
+                       [&](const uint32_t a, const uint32_t b) {
+                         return centroids[a][axis] < centroids[b][axis];
+                       });
+    }
+
+    const uint32_t left = nodes_.size();
+    const uint32_t leftCount = middle - begin;
+    nodes_.push_back({{}, first, {}, leftCount});
+    nodes_.push_back({{}, first + leftCount, {}, count - leftCount});
+    nodes_[task.node].first = left;
+    nodes_[task.node].count = 0;
+    tasks.push_back({left + 1, task.depth + 1});
+    tasks.push_back({left, task.depth + 1});
+  }
+
+  std::vector<Triangle> sorted;
+  sorted.reserve(numTriangles);
+  for (const uint32_t triangle : order) {
+    sorted.push_back(triangles_[triangle]);
+  }
+  triangles_ = std::move(sorted);
+}
+
+Mn::Range3D TriangleBVH::bounds() const {
+  if (nodes_.empty()) {
+    return {};
+  }
+  return {nodes_.front().min, nodes_.front().max};
+}
+
+template <class OnHit>
+void TriangleBVH::traverse(const Ray& ray,
+                           float maxDistance,
+                           OnHit onHit) const {
+  CORRADE_ASSERT(
+      nodes_.size() || triangles_.empty(),
+      "geo::TriangleBVH: the triangles were added without build()", );
+  if (nodes_.empty() || ray.direction.isZero()) {
+    return;
+  }
+  // large but finite for the axes the ray doesn't move along, so that the
+  // slab tests never multiply 0 by infinity
+  Mn::Vector3 invDirection;
+  for (int i = 0; i != 3; ++i) {
+    const float d = ray.direction[i];
+    invDirection[i] = 1.0f / (d != 0.0f ? d : 1.0e-30f);
+  }
+  // the entry distance of the ray in a node, infinite if it misses
+  auto entry = [&](const Node& node) {
+    const Mn::Vector3 t0 = (node.min - ray.origin) * invDirection;
+    const Mn::Vector3 t1 = (node.max - ray.origin) * invDirection;
+    const float tNear = std::max(Mn::Math::min(t0, t1).max(), 0.0f);
+    const float tFar = std::min(Mn::Math::max(t0, t1).min(), maxDistance);
+    return tNear <= tFar ? tNear : std::numeric_limits<float>::infinity();
+  };
+
+  // the nodes to visit with their entry distances, skipped once a closer
+  // hit is found
+  struct Entry {
+    uint32_t node;
+    float distance;
+  };
+  Entry stack[TRAVERSAL_STACK_SIZE];
+  const float infinity = std::numeric_limits<float>::infinity();
+  int size = 0;
+  const float rootEntry = entry(nodes_.front());
+  if (rootEntry != infinity) {
+    stack[size++] = {0, rootEntry};
+  }
+  while (size) {
+    const Entry visited = stack[--size];
+    if (visited.distance > maxDistance) {
+      continue;
+    }
+    const Node& node = nodes_[visited.node];
+    if (node.count) {
+      for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+        // Moller-Trumbore
+        const Triangle& t = triangles_[i];
+        const Mn::Vector3 p = Mn::Math::cross(ray.direction, t.e2);
+        const float det = Mn::Math::dot(t.e1, p);
+        if (det == 0.0f) {
+          continue;
+        }
+        const float invDet = 1.0f / det;
+        const Mn::Vector3 s = ray.origin - t.v0;
+        const float u = Mn::Math::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) {
+          continue;
+        }
+        const Mn::Vector3 q = Mn::Math::cross(s, t.e1);
+        const float v = Mn::Math::dot(ray.direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) {
+          continue;
+        }
+        const float distance = Mn::Math::dot(t.e2, q) * invDet;
+        if (distance < 0.0f || distance > maxDistance) {
+          continue;
+        }
+        Mn::Vector3 normal = Mn::Math::cross(t.e1, t.e2).normalized();
+        if (Mn::Math::dot(normal, ray.direction) > 0.0f) {
+          normal = -normal;
+        }
+        maxDistance = onHit(Hit{distance, normal, t.index});
+      }
+      continue;
+    }
+    // the nearer child is visited first, so that closest hits prune more
+    const float leftEntry = entry(nodes_[node.first]);
+    const float rightEntry = entry(nodes_[node.first + 1]);
+    if (leftEntry <= rightEntry) {
+      if (rightEntry != infinity)
+        stack[size++] = {node.first + 1, rightEntry};
+      if (leftEntry != infinity)
+        stack[size++] = {node.first, leftEntry};
+    } else {
+      if (leftEntry != infinity)
+        stack[size++] = {node.first, leftEntry};
+      stack[size++] = {node.first + 1, rightEntry};
+    }
+  }
+}
+
+bool TriangleBVH::castRay(const Ray& ray,
+                          const float maxDistance,
+                          Hit& hit) const {
+  bool found = false;
+  traverse(ray, maxDistance, [&](const Hit& candidate) {
+    // the distance only shrinks, every hit is closer than the last
+    hit = candidate;
+    found = true;
+    return candidate.distance;
+  });
+  return found;
+}
+
+std::size_t TriangleBVH::castRayAll(const Ray& ray,
+                                    const float maxDistance,
+                                    std::vector<Hit>& hits) const {
+  const std::size_t first = hits.size();
+  traverse(ray, maxDistance, [&](const Hit& hit) {
+    hits.push_back(hit);
+    return maxDistance;
+  });
+  std::sort(hits.begin() + first, hits.end(),
+            [](const Hit& a, const Hit& b) { return a.distance < b.distance; });
+  return hits.size() - first;
+}
+
+}  // namespace geo
+}  // namespace esp
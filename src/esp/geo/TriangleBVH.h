@@ -0,0 +1,123 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GEO_TRIANGLEBVH_H_
+#define ESP_GEO_TRIANGLEBVH_H_
+
+/** @file
+ * @brief Class @ref esp::geo::TriangleBVH
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <cstdint>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/geo/geo.h"
+
+namespace esp {
+namespace geo {
+
+/**
+ * @brief A bounding volume hierarchy of static triangles, to cast rays
+ * without a physics engine
+ *
+ * Add the meshes with @ref addMesh(), then @ref build() the hierarchy with
+ * the binned surface area heuristic. The nodes are 32 bytes, the children of
+ * a node next to each other, and the triangles stored in the order of the
+ * leaves with their edges precomputed, so that a traversal walks memory
+ * mostly forward. Rays hit both sides of the triangles. Casting rays is safe
+ * from several threads at once.
+ */
+class TriangleBVH {
+ public:
+  //! The hit of a ray on a triangle
+  struct Hit {
+    //! Distance along the ray direction, in units of ray length
+    float distance;
+    //! The normal of the triangle, facing the origin of the ray
+    Magnum::Vector3 normal;
+    //! The index of the triangle, in the order they were added
+    uint32_t triangle;
+  };
+
+  /**
+   * @brief Add the triangles of a mesh, in the frame of the hierarchy
+   * through @p transform. @ref build() the hierarchy after.
+   */
+  void addMesh(
+      Corrade::Containers::ArrayView<const Magnum::Vector3> positions,
+      Corrade::Containers::ArrayView<const Magnum::UnsignedInt> indices,
+      const Magnum::Matrix4& transform = Magnum::Matrix4{});
+
+  /**
+   * @brief Build the hierarchy of the triangles added so far
+   * @param maxLeafTriangles The number of triangles below which a node is
+   * never split
+   */
+  void build(std::size_t maxLeafTriangles = 4);
+
+  //! Whether there are no triangles
+  bool empty() const { return triangles_.empty(); }
+
+  //! The number of triangles
+  std::size_t numTriangles() const { return triangles_.size(); }
+
+  //! The number of nodes, 0 until @ref build() is called
+  std::size_t numNodes() const { return nodes_.size(); }
+
+  //! The bounds of all triangles, empty until @ref build() is called
+  Magnum::Range3D bounds() const;
+
+  /**
+   * @brief The closest hit of a ray
+   * @param ray         The ray, need not be unit length
+   * @param maxDistance The maximum distance along the ray direction, in
+   * units of ray length
+   * @param[out] hit    The hit, left as is without one
+   * @return Whether the ray hits a triangle
+   */
+  bool castRay(const Ray& ray, float maxDistance, Hit& hit) const;
+
+  /**
+   * @brief Append all hits of a ray to @p hits, sorted by distance
+   * @return The number of hits appended
+   */
+  std::size_t castRayAll(const Ray& ray,
+                         float maxDistance,
+                         std::vector<Hit>& hits) const;
+
+ private:
+  struct Node {
+    Magnum::Vector3 min;
+    // the first triangle of a leaf, the left child of an inner node
+    uint32_t first;
+    Magnum::Vector3 max;
+    // 0 for inner nodes
+    uint32_t count;
+  };
+
+  struct Triangle {
+    Magnum::Vector3 v0;
+    Magnum::Vector3 e1;
+    Magnum::Vector3 e2;
+    uint32_t index;
+  };
+
+  template <class OnHit>
+  void traverse(const Ray& ray, float maxDistance, OnHit onHit) const;
+
+  std::vector<Node> nodes_;
+  std::vector<Triangle> triangles_;
+
+  ESP_SMART_POINTERS(TriangleBVH)
+};
+
+}  // namespace geo
+}  // namespace esp
+
+#endif  // ESP_GEO_TRIANGLEBVH_H_
@@ -0,0 +1,233 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "VoxelGrid.h"
+
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Vector3.h>
+#include <algorithm>
+#include <fstream>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/ThreadPool.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace geo {
+
+namespace {
+const int VOXELS_MAGIC = 'V' << 24 | 'O' << 16 | 'X' << 8 | 'G';  //'VOXG';
+const int VOXELS_VERSION = 1;
+
+struct VoxelsHeader {
+  int magic;
+  int version;
+  Mn::Vector3 origin;
+  float voxelSize;
+  Mn::Vector3i size;
+};
+
+// Whether the triangle overlaps the box centered on the origin with half
+// sizes @p half, the separating axis test of Akenine-Moller: the axes of the
+// box, the normal of the triangle and the cross products of both
+bool triangleOverlapsBox(const Mn::Vector3& half, const Mn::Vector3 (&v)[3]) {
+  for (int axis = 0; axis != 3; ++axis) {
+    if (std::min({v[0][axis], v[1][axis], v[2][axis]}) > half[axis] ||
+        std::max({v[0][axis], v[1][axis], v[2][axis]}) < -half[axis])
+      return false;
+  }
+
+  const Mn::Vector3 edges[3]{v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+  const Mn::Vector3 normal = Mn::Math::cross(edges[0], edges[1]);
+  if (std::abs(Mn::Math::dot(normal, v[0])) >
+      Mn::Math::dot(Mn::Math::abs(normal), half))
+    return false;
+
+  for (const Mn::Vector3& edge : edges) {
+    for (int axis = 0; axis != 3; ++axis) {
+      Mn::Vector3 unit;
+      unit[axis] = 1.0f;
+      const Mn::Vector3 separating = Mn::Math::cross(unit, edge);
+      const float p0 = Mn::Math::dot(separating, v[0]);
+      const float p1 = Mn::Math::dot(separating, v[1]);
+      const float p2 = Mn::Math::dot(separating, v[2]);
+      const float radius = Mn::Math::dot(Mn::Math::abs(separating), half);
+      if (std::min({p0, p1, p2}) > radius || std::max({p0, p1, p2}) < -radius)
+        return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+constexpr uint32_t VoxelGrid::Empty;
+
+VoxelGrid::VoxelGrid(const Mn::Vector3& origin,
+                     const float voxelSize,
+                     const Mn::Vector3i& size)
+    : origin{origin},
+      voxelSize{voxelSize},
+      size{size},
+      voxels(std::size_t(size.product()), Empty) {
+  CORRADE_ASSERT(voxelSize > 0.0f && size.min() >= 0,
+                 "geo::VoxelGrid: expected a positive voxel size and size, "
+                 "got"
+                     << voxelSize << "and" << size, );
+}
+
+VoxelGrid VoxelGrid::covering(const Mn::Range3D& bounds,
+                              const float voxelSize) {
+  CORRADE_ASSERT(voxelSize > 0.0f,
+                 "geo::VoxelGrid::covering(): expected a positive voxel size, "
+                 "got" << voxelSize,
+                 {});
+  // an inverted range, e.g. of no vertices, gives an empty grid
+  if ((bounds.max() < bounds.min()).any()) {
+    return {bounds.min(), voxelSize, Mn::Vector3i{0}};
+  }
+  const Mn::Vector3i size =
+      Mn::Vector3i{Mn::Math::ceil(bounds.size() / voxelSize)} + Mn::Vector3i{2};
+  return {bounds.min() - Mn::Vector3{voxelSize}, voxelSize, size};
+}
+
+std::size_t VoxelGrid::numOccupied() const {
+  return voxels.size() - std::count(voxels.begin(), voxels.end(), Empty);
+}
+
+std::vector<Mn::Vector3i> VoxelGrid::occupiedVoxels() const {
+  std::vector<Mn::Vector3i> occupied;
+  occupied.reserve(numOccupied());
+  std::size_t i = 0;
+  for (int z = 0; z < size.z(); ++z) {
+    for (int y = 0; y < size.y(); ++y) {
+      for (int x = 0; x < size.x(); ++x, ++i) {
+        if (voxels[i] != Empty)
+          occupied.emplace_back(x, y, z);
+      }
+    }
+  }
+  return occupied;
+}
+
+void voxelizeTriangles(VoxelGrid& grid,
+                       Cr::Containers::ArrayView<const Mn::Vector3> positions,
+                       Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+                       const Mn::Matrix4& transform,
+                       const uint32_t semanticId,
+                       const std::size_t maxThreads) {
+  ESP_PROFILE_SCOPE("geo::voxelizeTriangles");
+  CORRADE_ASSERT(indices.size() % 3 == 0,
+                 "geo::voxelizeTriangles(): index count"
+                     << indices.size() << "is not divisible by 3", );
+  CORRADE_ASSERT(grid.voxels.size() == std::size_t(grid.size.product()),
+                 "geo::voxelizeTriangles(): expected"
+                     << grid.size.product() << "voxels but got"
+                     << grid.voxels.size(), );
+  if (indices.empty() || grid.voxels.empty()) {
+    return;
+  }
+
+  // in voxels from the origin of the grid, voxel (x, y, z) being the unit
+  // cube from (x, y, z)
+  std::vector<Mn::Vector3> vertices(positions.size());
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    vertices[i] =
+        (transform.transformPoint(positions[i]) - grid.origin) / grid.voxelSize;
+  }
+  const Mn::Vector3i last = grid.size - Mn::Vector3i{1};
+  const auto voxelRange = [&](std::size_t triangle, Mn::Vector3i& min,
+                              Mn::Vector3i& max) {
+    const Mn::Vector3& a = vertices[indices[triangle * 3]];
+    const Mn::Vector3& b = vertices[indices[triangle * 3 + 1]];
+    const Mn::Vector3& c = vertices[indices[triangle * 3 + 2]];
+    const Mn::Vector3 lower = Mn::Math::min(a, Mn::Math::min(b, c));
+    const Mn::Vector3 upper = Mn::Math::max(a, Mn::Math::max(b, c));
+    if ((upper < Mn::Vector3{0.0f}).any() ||
+        (lower >= Mn::Vector3{grid.size}).any())
+      return false;
+    min = Mn::Math::clamp(Mn::Vector3i{Mn::Math::floor(lower)},
+                          Mn::Vector3i{0}, last);
+    max = Mn::Math::clamp(Mn::Vector3i{Mn::Math::floor(upper)},
+                          Mn::Vector3i{0}, last);
+    return true;
+  };
+
+  // the triangles of each slab of layers along z, so that the slabs are
+  // written by a single thread each and in the order of the triangles
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t numWorkers =
+      maxThreads ? maxThreads : pool.numThreads() + 1;
+  const int numSlabs = std::min<int>(grid.size.z(), 4 * numWorkers);
+  const int slabDepth = (grid.size.z() + numSlabs - 1) / numSlabs;
+  std::vector<std::vector<Mn::UnsignedInt>> slabTriangles(
+      (grid.size.z() + slabDepth - 1) / slabDepth);
+  for (std::size_t triangle = 0; triangle < indices.size() / 3; ++triangle) {
+    Mn::Vector3i min, max;
+    if (!voxelRange(triangle, min, max))
+      continue;
+    for (int slab = min.z() / slabDepth; slab <= max.z() / slabDepth; ++slab)
+      slabTriangles[slab].push_back(triangle);
+  }
+
+  const Mn::Vector3 half{0.5f};
+  pool.parallelFor(
+      slabTriangles.size(), numWorkers, [&](std::size_t slab, std::size_t) {
+        const int zBegin = slab * slabDepth;
+        const int zEnd = std::min(grid.size.z(), zBegin + slabDepth);
+        for (const Mn::UnsignedInt triangle : slabTriangles[slab]) {
+          Mn::Vector3i min, max;
+          voxelRange(triangle, min, max);
+          for (int z = std::max(min.z(), zBegin);
+               z <= std::min(max.z(), zEnd - 1); ++z) {
+            for (int y = min.y(); y <= max.y(); ++y) {
+              for (int x = min.x(); x <= max.x(); ++x) {
+                const Mn::Vector3 center = Mn::Vector3{Mn::Vector3i{x, y, z}} +
+                                           half;
+                const Mn::Vector3 v[3]{
+                    vertices[indices[triangle * 3]] - center,
+                    vertices[indices[triangle * 3 + 1]] - center,
+                    vertices[indices[triangle * 3 + 2]] - center};
+                if (triangleOverlapsBox(half, v))
+                  grid.voxels[grid.index({x, y, z})] = semanticId;
+              }
+            }
+          }
+        }
+      });
+}
+
+bool saveVoxelGrid(const VoxelGrid& grid, const std::string& filename) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  const VoxelsHeader header{VOXELS_MAGIC, VOXELS_VERSION, grid.origin,
+                            grid.voxelSize, grid.size};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(grid.voxels.data()),
+             grid.voxels.size() * sizeof(uint32_t));
+  return bool(file);
+}
+
+bool loadVoxelGrid(const std::string& filename, VoxelGrid& grid) {
+  std::ifstream file(filename, std::ios::binary);
+  VoxelsHeader header{};
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.magic != VOXELS_MAGIC || header.version != VOXELS_VERSION ||
+      !(header.voxelSize > 0.0f) || header.size.min() < 0) {
+    return false;
+  }
+  VoxelGrid loaded{header.origin, header.voxelSize, header.size};
+  if (!file.read(reinterpret_cast<char*>(loaded.voxels.data()),
+                 loaded.voxels.size() * sizeof(uint32_t))) {
+    return false;
+  }
+  grid = std::move(loaded);
+  return true;
+}
+
+}  // namespace geo
+}  // namespace esp
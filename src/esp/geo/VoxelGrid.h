@@ -0,0 +1,138 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GEO_VOXELGRID_H_
+#define ESP_GEO_VOXELGRID_H_
+
+/** @file
+ * @brief Struct @ref esp::geo::VoxelGrid, functions
+ * @ref esp::geo::voxelizeTriangles(), @ref esp::geo::saveVoxelGrid(),
+ * @ref esp::geo::loadVoxelGrid()
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace geo {
+
+/**
+ * @brief A dense grid of cubic voxels, each empty or holding the semantic id
+ * of the surface it contains
+ *
+ * Voxel (x, y, z) spans `origin + voxelSize*{x, y, z}` to
+ * `origin + voxelSize*{x + 1, y + 1, z + 1}`, and x varies the fastest in
+ * @ref voxels.
+ */
+struct VoxelGrid {
+  //! The value of the empty voxels
+  static constexpr uint32_t Empty = 0xffffffffu;
+
+  VoxelGrid() = default;
+
+  /**
+   * @brief Constructor, an empty grid
+   * @param origin    The lower corner of the first voxel
+   * @param voxelSize The edge length of the voxels
+   * @param size      The number of voxels along each axis
+   */
+  VoxelGrid(const Magnum::Vector3& origin,
+            float voxelSize,
+            const Magnum::Vector3i& size);
+
+  /**
+   * @brief An empty grid covering @p bounds, with a voxel of margin on each
+   * side, without voxels if @p bounds is inverted
+   */
+  static VoxelGrid covering(const Magnum::Range3D& bounds, float voxelSize);
+
+  //! The index of voxel @p coordinates in @ref voxels
+  std::size_t index(const Magnum::Vector3i& coordinates) const {
+    return (std::size_t(coordinates.z()) * size.y() + coordinates.y()) *
+               size.x() +
+           coordinates.x();
+  }
+
+  //! The value of a voxel, @ref Empty or a semantic id
+  uint32_t at(const Magnum::Vector3i& coordinates) const {
+    return voxels[index(coordinates)];
+  }
+
+  //! The volume covered by the grid
+  Magnum::Range3D bounds() const {
+    return {origin, origin + Magnum::Vector3{size} * voxelSize};
+  }
+
+  //! The number of voxels that aren't @ref Empty
+  std::size_t numOccupied() const;
+
+  /**
+   * @brief The coordinates of the voxels that aren't @ref Empty, in the
+   * order of @ref voxels, e.g. to store a sparse grid
+   */
+  std::vector<Magnum::Vector3i> occupiedVoxels() const;
+
+  //! The lower corner of the first voxel
+  Magnum::Vector3 origin;
+  //! The edge length of the voxels
+  float voxelSize = 0.0f;
+  //! The number of voxels along each axis
+  Magnum::Vector3i size;
+  //! The voxels, @ref Empty or a semantic id
+  std::vector<uint32_t> voxels;
+
+  ESP_SMART_POINTERS(VoxelGrid)
+};
+
+/**
+ * @brief Mark the voxels a triangle mesh touches
+ * @param grid      The grid whose voxels are marked
+ * @param positions The vertices of the mesh
+ * @param indices   The vertices of each triangle of the mesh
+ * @param transform The transformation from the mesh to the grid
+ * @param semanticId The value the voxels are set to, where a voxel is
+ * touched by several meshes the last one wins
+ * @param maxThreads The upper bound of the number of threads used, 0 for
+ * all of @ref core::ThreadPool::shared()
+ *
+ * Conservative: every voxel a triangle overlaps is marked, with an exact
+ * triangle and box overlap test, so that thin walls are never missed. The
+ * grid is split in slabs along z voxelized in parallel. The parts of the
+ * mesh outside of the grid are ignored.
+ */
+void voxelizeTriangles(
+    VoxelGrid& grid,
+    Corrade::Containers::ArrayView<const Magnum::Vector3> positions,
+    Corrade::Containers::ArrayView<const Magnum::UnsignedInt> indices,
+    const Magnum::Matrix4& transform,
+    uint32_t semanticId,
+    std::size_t maxThreads = 0);
+
+/**
+ * @brief Save a grid in a compact binary file
+ * @param grid The grid.
+ * @param filename The file to write.
+ * @return Whether the file was written.
+ */
+bool saveVoxelGrid(const VoxelGrid& grid, const std::string& filename);
+
+/**
+ * @brief Load a grid saved by @ref saveVoxelGrid()
+ * @param filename The file to read.
+ * @param grid The grid read.
+ * @return Whether the file exists and is a valid grid.
+ */
+bool loadVoxelGrid(const std::string& filename, VoxelGrid& grid);
+
+}  // namespace geo
+}  // namespace esp
+
+#endif  // ESP_GEO_VOXELGRID_H_
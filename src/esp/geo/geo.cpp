@@ -4,11 +4,17 @@
 
 #include "esp/geo/geo.h"
 
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Utility/Assert.h>
 #include <Magnum/Math/FunctionsBatch.h>
 #include <Magnum/Primitives/Circle.h>
 #include <Magnum/Trade/MeshData.h>
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <limits>
 #include <numeric>
+#include <unordered_map>
 
 namespace Mn = Magnum;
 namespace Cr = Corrade;
@@ -123,6 +129,84 @@ Mn::Range3D getTransformedBB(const Mn::Range3D& range,
   return Mn::Range3D::fromCenter(newCenter, newExtent);
 }
 
+/* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+void getTransformedBBs(Cr::Containers::ArrayView<const Mn::Range3D> ranges,
+                       Cr::Containers::ArrayView<const Mn::Matrix4> xforms,
+                       Cr::Containers::ArrayView<Mn::Range3D> out) {
+  CORRADE_ASSERT(
+      xforms.size() == ranges.size() && out.size() == ranges.size(),
+      "geo::getTransformedBBs(): expected" << ranges.size()
+          << "transforms and outputs, got" << xforms.size() << "and"
+          << out.size(), );
+  /* Raw pointers to the min and max of each box and the columns of each
+     matrix, so the optimizer doesn't have to prove the views don't alias the
+     output. Same math as getTransformedBB(), without the temporaries. */
+  const float* const boxes = reinterpret_cast<const float*>(ranges.data());
+  const float* const matrices = reinterpret_cast<const float*>(xforms.data());
+  float* const result = reinterpret_cast<float*>(out.data());
+  const std::size_t count = ranges.size();
+  for (std::size_t i = 0; i < count; ++i) {
+    const float* const box = boxes + 6 * i;
+    const float* const m = matrices + 16 * i;
+    float* const o = result + 6 * i;
+    const float cx = 0.5f * (box[0] + box[3]), ex = 0.5f * (box[3] - box[0]);
+    const float cy = 0.5f * (box[1] + box[4]), ey = 0.5f * (box[4] - box[1]);
+    const float cz = 0.5f * (box[2] + box[5]), ez = 0.5f * (box[5] - box[2]);
+    for (int row = 0; row < 3; ++row) {
+      const float center =
+          m[row] * cx + m[4 + row] * cy + m[8 + row] * cz + m[12 + row];
+      const float extent = Mn::Math::abs(m[row]) * ex +
+                           Mn::Math::abs(m[4 + row]) * ey +
+                           Mn::Math::abs(m[8 + row]) * ez;
+      o[row] = center - extent;
+      o[3 + row] = center + extent;
+    }
+  }
+}
+
+/* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+Mn::Range3D getPointSetBounds(
+    Cr::Containers::ArrayView<const Mn::Vector3> points) {
+  if (points.empty()) {
+    return {};
+  }
+  const float* const p = points.data()->data();
+  const std::size_t count = 3 * points.size();
+  /* 24 lanes, a multiple of both the 3 components and the 8 floats of an AVX
+     register, so lane k always holds component k % 3 and the inner loop is a
+     plain elementwise min and max, which vectorizes without reordering the
+     reduction. */
+  constexpr std::size_t Lanes = 24;
+  float lo[Lanes], hi[Lanes];
+  for (std::size_t k = 0; k < Lanes; ++k) {
+    lo[k] = hi[k] = p[k % 3];
+  }
+  std::size_t i = 0;
+  for (; i + Lanes <= count; i += Lanes) {
+    for (std::size_t k = 0; k < Lanes; ++k) {
+      const float v = p[i + k];
+      lo[k] = v < lo[k] ? v : lo[k];
+      hi[k] = hi[k] < v ? v : hi[k];
+    }
+  }
+  for (; i < count; ++i) {
+    const float v = p[i];
+    lo[i % 3] = v < lo[i % 3] ? v : lo[i % 3];
+    hi[i % 3] = hi[i % 3] < v ? v : hi[i % 3];
+  }
+  for (std::size_t k = 3; k < Lanes; ++k) {
+    lo[k % 3] = Mn::Math::min(lo[k % 3], lo[k]);
+    hi[k % 3] = Mn::Math::max(hi[k % 3], hi[k]);
+  }
+  return {Mn::Vector3::from(lo), Mn::Vector3::from(hi)};
+}
+
 float calcWeightedDistance(const Mn::Vector3& a,
                            const Mn::Vector3& b,
                            float alpha) {
@@ -135,6 +219,33 @@ float calcWeightedDistance(const Mn::Vector3& a,
   return Mn::Math::pow(squareDist, alpha);
 }
 
+/* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+void calcWeightedDistances(Cr::Containers::ArrayView<const Mn::Vector3> points,
+                           float alpha,
+                           Cr::Containers::ArrayView<float> out) {
+  CORRADE_ASSERT(!points.empty() && out.size() == points.size() - 1,
+                 "geo::calcWeightedDistances(): expected"
+                     << points.size() - 1 << "outputs for" << points.size()
+                     << "points, got" << out.size(), );
+  const float* const p = points.data()->data();
+  float* const o = out.data();
+  const std::size_t count = out.size();
+  // the squared distances, vectorized, then the power of each
+  for (std::size_t i = 0; i < count; ++i) {
+    const float dx = p[3 * i + 3] - p[3 * i];
+    const float dy = p[3 * i + 4] - p[3 * i + 1];
+    const float dz = p[3 * i + 5] - p[3 * i + 2];
+    o[i] = dx * dx + dy * dy + dz * dz;
+  }
+  alpha *= .5;
+  for (std::size_t i = 0; i < count; ++i) {
+    o[i] = Mn::Math::pow(o[i], alpha);
+  }
+}
+
 void buildCatmullRomTraj4Points(const std::vector<Mn::Vector3>& pts,
                                 const std::vector<float>& ptKnotVals,
                                 std::vector<Mn::Vector3>& trajectory,
@@ -178,17 +289,16 @@ std::vector<Mn::Vector3> buildCatmullRomTrajOfPoints(
   // trajectory by adding "ghost" point so we start drawing from initial point
   // in trajectory.
   tmpPoints.emplace_back(pts[0] - (pts[1] - pts[0]));
-  ptKnotVals.emplace_back(calcWeightedDistance(tmpPoints[0], pts[0], alpha));
-  for (int i = 0; i < pts.size(); ++i) {
-    tmpPoints.emplace_back(pts[i]);
-    ptKnotVals.emplace_back(
-        calcWeightedDistance(tmpPoints[i], tmpPoints[i + 1], alpha));
-  }
+  tmpPoints.insert(tmpPoints.end(), pts.begin(), pts.end());
   // add final ghost point in trajectory
   int lastIdx = pts.size() - 1;
   tmpPoints.emplace_back(pts[lastIdx] + (pts[lastIdx] - pts[lastIdx - 1]));
-  ptKnotVals.emplace_back(calcWeightedDistance(
-      tmpPoints[tmpPoints.size() - 2], tmpPoints[tmpPoints.size() - 1], alpha));
+  // the knot value of each point relative to the previous one, with the one of
+  // the first real point repeated in front
+  ptKnotVals.resize(tmpPoints.size());
+  calcWeightedDistances(tmpPoints, alpha,
+                        {ptKnotVals.data() + 1, ptKnotVals.size() - 1});
+  ptKnotVals[0] = ptKnotVals[1];
 
   for (int i = 0; i < tmpPoints.size() - 3; ++i) {
     buildCatmullRomTraj4Points(tmpPoints, ptKnotVals, trajectory, i, numInterp);
@@ -198,11 +308,14 @@ std::vector<Mn::Vector3> buildCatmullRomTrajOfPoints(
 
 std::vector<float> getPointDistsAlongTrajectory(
     const std::vector<Mn::Vector3>& pts) {
-  std::vector<float> dists;
-  dists.emplace_back(0.0f);
-  for (int i = 1; i < pts.size(); ++i) {
-    dists.emplace_back(dists[i - 1] +
-                       calcWeightedDistance(pts[i - 1], pts[i], 1.0f));
+  if (pts.empty()) {
+    return {0.0f};
+  }
+  std::vector<float> dists(pts.size());
+  calcWeightedDistances(pts, 1.0f, {dists.data() + 1, dists.size() - 1});
+  dists[0] = 0.0f;
+  for (std::size_t i = 1; i < dists.size(); ++i) {
+    dists[i] += dists[i - 1];
   }
   return dists;
 }  // getPointDistsAlongTrajectory
@@ -398,5 +511,182 @@ Mn::Trade::MeshData buildTrajectoryTubeSolid(
   return meshData;
 }  // ResourceManager::trajectoryTubeSolid
 
+std::vector<Mn::UnsignedInt> simplifyByVertexClustering(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    float cellSize) {
+  CORRADE_ASSERT(cellSize > 0.0f,
+                 "geo::simplifyByVertexClustering(): expected a positive cell "
+                 "size but got"
+                     << cellSize,
+                 {});
+  CORRADE_ASSERT(indices.size() % 3 == 0,
+                 "geo::simplifyByVertexClustering(): index count"
+                     << indices.size() << "is not divisible by 3",
+                 {});
+  if (positions.empty()) {
+    return {};
+  }
+  const Mn::Vector3 origin = Mn::Math::min(positions);
+
+  // cell of every vertex, and the sum of the positions of every cell
+  struct Cell {
+    Mn::Vector3 sum;
+    Mn::UnsignedInt count = 0;
+    Mn::UnsignedInt representative = 0;
+    float distance = std::numeric_limits<float>::infinity();
+  };
+  std::unordered_map<std::uint64_t, Mn::UnsignedInt> cellIndices;
+  std::vector<Cell> cells;
+  std::vector<Mn::UnsignedInt> vertexCells(positions.size());
+  for (Mn::UnsignedInt i = 0; i < positions.size(); ++i) {
+    // 21 bits per axis, enough for 2 million cells along each of them
+    const Mn::Vector3ui coords{(positions[i] - origin) / cellSize};
+    const std::uint64_t key = (std::uint64_t(coords.x()) & 0x1fffff) |
+                              (std::uint64_t(coords.y()) & 0x1fffff) << 21 |
+                              (std::uint64_t(coords.z()) & 0x1fffff) << 42;
+    auto inserted = cellIndices.emplace(key, cells.size());
+    if (inserted.second) {
+      cells.emplace_back();
+    }
+    Cell& cell = cells[inserted.first->second];
+    cell.sum += positions[i];
+    ++cell.count;
+    vertexCells[i] = inserted.first->second;
+  }
+
+  // pick the vertex closest to the centroid of each cell
+  for (Mn::UnsignedInt i = 0; i < positions.size(); ++i) {
+    Cell& cell = cells[vertexCells[i]];
+    const float distance = (positions[i] - cell.sum / float(cell.count)).dot();
+    if (distance < cell.distance) {
+      cell.representative = i;
+      cell.distance = distance;
+    }
+  }
+
+  std::vector<Mn::UnsignedInt> simplified;
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const Mn::UnsignedInt a = vertexCells[indices[i]];
+    const Mn::UnsignedInt b = vertexCells[indices[i + 1]];
+    const Mn::UnsignedInt c = vertexCells[indices[i + 2]];
+    if (a == b || b == c || a == c) {
+      continue;
+    }
+    simplified.push_back(cells[a].representative);
+    simplified.push_back(cells[b].representative);
+    simplified.push_back(cells[c].representative);
+  }
+  return simplified;
+}
+
+std::vector<MeshLod> generateMeshLods(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    int maxLevels,
+    float reduction,
+    std::size_t minTriangles) {
+  std::vector<MeshLod> lods;
+  if (positions.empty() || indices.empty()) {
+    return lods;
+  }
+  const Mn::Range3D bounds{Mn::Math::minmax(positions)};
+  const float extent = Mn::Math::max(bounds.size());
+  if (extent <= 0.0f) {
+    return lods;
+  }
+
+  std::size_t previousTriangles = indices.size() / 3;
+  // finer than any cell that would remove triangles of a sensibly sized mesh
+  float finerCellSize = extent / float(1 << 20);
+  for (int level = 0; level < maxLevels; ++level) {
+    const std::size_t target = std::size_t(previousTriangles * reduction);
+    if (target < minTriangles) {
+      break;
+    }
+
+    // bisect, in log space, for the finest cell size reaching the target
+    float coarserCellSize = extent;
+    std::vector<Mn::UnsignedInt> coarser =
+        simplifyByVertexClustering(positions, indices, coarserCellSize);
+    for (int iteration = 0; iteration < 8; ++iteration) {
+      const float cellSize = std::sqrt(finerCellSize * coarserCellSize);
+      std::vector<Mn::UnsignedInt> simplified =
+          simplifyByVertexClustering(positions, indices, cellSize);
+      if (simplified.size() / 3 <= target) {
+        coarserCellSize = cellSize;
+        coarser = std::move(simplified);
+      } else {
+        finerCellSize = cellSize;
+      }
+    }
+
+    const std::size_t triangles = coarser.size() / 3;
+    // not worth a level, or nothing left to draw
+    if (triangles < minTriangles || triangles > previousTriangles * 0.9f) {
+      break;
+    }
+    lods.push_back({std::move(coarser), std::sqrt(3.0f) * coarserCellSize});
+    previousTriangles = triangles;
+    finerCellSize = coarserCellSize;
+  }
+  return lods;
+}
+
+SimplifiedMesh simplifyCollisionMesh(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    float maxError) {
+  CORRADE_ASSERT(maxError > 0.0f,
+                 "geo::simplifyCollisionMesh(): expected a positive error but "
+                 "got"
+                     << maxError,
+                 {});
+  // the diagonal of a cell bounds how far its vertices move
+  const float cellSize = maxError / std::sqrt(3.0f);
+  const std::vector<Mn::UnsignedInt> clustered =
+      simplifyByVertexClustering(positions, indices, cellSize);
+
+  // the same vertices in any order and winding are the same triangle, keep
+  // the first of them
+  struct Triangle {
+    std::array<Mn::UnsignedInt, 3> vertices;
+    std::size_t first;
+  };
+  std::vector<Triangle> triangles;
+  triangles.reserve(clustered.size() / 3);
+  for (std::size_t i = 0; i + 2 < clustered.size(); i += 3) {
+    Triangle triangle{{clustered[i], clustered[i + 1], clustered[i + 2]}, i};
+    std::sort(triangle.vertices.begin(), triangle.vertices.end());
+    triangles.push_back(triangle);
+  }
+  std::sort(triangles.begin(), triangles.end(),
+            [](const Triangle& a, const Triangle& b) {
+              return a.vertices != b.vertices ? a.vertices < b.vertices
+                                              : a.first < b.first;
+            });
+  std::vector<std::size_t> kept;
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    if (i == 0 || triangles[i].vertices != triangles[i - 1].vertices) {
+      kept.push_back(triangles[i].first);
+    }
+  }
+  std::sort(kept.begin(), kept.end());
+
+  SimplifiedMesh simplified;
+  std::unordered_map<Mn::UnsignedInt, Mn::UnsignedInt> remapped;
+  for (const std::size_t first : kept) {
+    for (std::size_t i = first; i != first + 3; ++i) {
+      auto inserted =
+          remapped.emplace(clustered[i], simplified.positions.size());
+      if (inserted.second) {
+        simplified.positions.push_back(positions[clustered[i]]);
+      }
+      simplified.indices.push_back(inserted.first->second);
+    }
+  }
+  return simplified;
+}
+
 }  // namespace geo
 }  // namespace esp
@@ -9,6 +9,7 @@
 
 #include "esp/core/esp.h"
 
+#include <Corrade/Containers/ArrayView.h>
 #include <Magnum/Math/CubicHermite.h>
 #include <Magnum/Math/Range.h>
 #include "esp/gfx/magnum.h"
@@ -43,6 +44,31 @@ std::vector<vec2f> convexHull2D(const std::vector<vec2f>& points);
 Magnum::Range3D getTransformedBB(const Magnum::Range3D& range,
                                  const Magnum::Matrix4& xform);
 
+/**
+ * @brief @ref getTransformedBB() of each of @p ranges with the matching one
+ * of @p xforms
+ * @param ranges The initial axis-aligned bounding boxes.
+ * @param xforms The transforms to apply, one per box.
+ * @param out The transformed boxes, as many as @p ranges. Must not overlap
+ * @p ranges.
+ *
+ * A branchless loop over the boxes, which the compiler vectorizes, built for
+ * SSE4.2 and AVX2 too on x86 and dispatched at runtime.
+ */
+void getTransformedBBs(Cr::Containers::ArrayView<const Mn::Range3D> ranges,
+                       Cr::Containers::ArrayView<const Mn::Matrix4> xforms,
+                       Cr::Containers::ArrayView<Mn::Range3D> out);
+
+/**
+ * @brief The axis-aligned bounding box of @p points, an empty range at the
+ * origin if there are none
+ *
+ * Same result as Mn::Math::minmax(), but vectorized like
+ * @ref getTransformedBBs().
+ */
+Mn::Range3D getPointSetBounds(
+    Cr::Containers::ArrayView<const Mn::Vector3> points);
+
 /**
  * @brief Return a vector of L2/Euclidean distances of points along a
  * trajectory. First point will always be 0, and last point will give length of
@@ -88,6 +114,21 @@ float calcWeightedDistance(const Mn::Vector3& a,
                            const Mn::Vector3& b,
                            float alpha = .5f);
 
+/**
+ * @brief @ref calcWeightedDistance() of each pair of consecutive @p points
+ * @param points The points, at least one.
+ * @param alpha Exponent for distance calculation, see
+ * @ref calcWeightedDistance().
+ * @param out The distance of point i + 1 from point i at index i, one less
+ * than @p points.
+ *
+ * The squared distances are computed in one vectorized pass, as in
+ * @ref getTransformedBBs().
+ */
+void calcWeightedDistances(Cr::Containers::ArrayView<const Mn::Vector3> points,
+                           float alpha,
+                           Cr::Containers::ArrayView<float> out);
+
 /**
  * @brief Build a smooth trajectory of interpolated points from key points
  * along a path using Catmull-Rom Spline of type determined by chosen @ref
@@ -127,6 +168,87 @@ Mn::Trade::MeshData buildTrajectoryTubeSolid(
     bool smooth,
     int numInterp);
 
+/**
+ * @brief Simplify an indexed triangle mesh by vertex clustering
+ * @param positions, the vertex positions
+ * @param indices, the triangle indices into @p positions
+ * @param cellSize, edge length of the cubic grid cells the vertices are
+ * clustered in
+ * @return triangle indices into @p positions of the simplified mesh
+ *
+ * Every vertex is replaced by the vertex of its cell closest to the centroid
+ * of the cell's vertices, and triangles collapsing to a line or point are
+ * removed. The vertices themselves are not changed, so the result can be
+ * drawn with the vertex attributes of the original mesh. No vertex moves by
+ * more than the cell diagonal, `sqrt(3) * cellSize`.
+ */
+std::vector<Mn::UnsignedInt> simplifyByVertexClustering(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    float cellSize);
+
+/**
+ * @brief A coarser level of detail of an indexed triangle mesh, see
+ * @ref generateMeshLods()
+ */
+struct MeshLod {
+  //! triangle indices into the positions of the original mesh
+  std::vector<Mn::UnsignedInt> indices;
+  //! the maximal distance a vertex moved, in the units of the positions
+  float error;
+};
+
+/**
+ * @brief Generate a chain of levels of detail of an indexed triangle mesh
+ * @param positions, the vertex positions
+ * @param indices, the triangle indices into @p positions
+ * @param maxLevels, the maximal number of levels generated
+ * @param reduction, the fraction of the triangles of the previous level each
+ * level aims for
+ * @param minTriangles, no level with less triangles is generated
+ * @return the levels, ordered from the finest to the coarsest, not including
+ * the original mesh
+ *
+ * Each level is generated with @ref simplifyByVertexClustering(), with the
+ * cell size found by bisection. The chain stops early when a level would not
+ * remove a significant number of triangles.
+ */
+std::vector<MeshLod> generateMeshLods(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    int maxLevels = 3,
+    float reduction = 0.25f,
+    std::size_t minTriangles = 256);
+
+/**
+ * @brief A simplified indexed triangle mesh with its own compact vertices,
+ * see @ref simplifyCollisionMesh()
+ */
+struct SimplifiedMesh {
+  //! the vertex positions, only the ones the triangles reference
+  std::vector<Mn::Vector3> positions;
+  //! the triangle indices into @ref positions
+  std::vector<Mn::UnsignedInt> indices;
+};
+
+/**
+ * @brief Simplify a collision mesh within an error bound
+ * @param positions, the vertex positions
+ * @param indices, the triangle indices into @p positions
+ * @param maxError, the maximal distance a vertex may move
+ * @return the simplified mesh, with the unreferenced vertices removed
+ *
+ * Clusters the vertices with @ref simplifyByVertexClustering() in cells
+ * whose diagonal is @p maxError, so large flat or gently curved regions
+ * collapse to a few triangles while no surface moves by more than
+ * @p maxError. Triangles that end up with the same vertices are kept once,
+ * as the collision shapes are two-sided.
+ */
+SimplifiedMesh simplifyCollisionMesh(
+    Cr::Containers::ArrayView<const Mn::Vector3> positions,
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> indices,
+    float maxError);
+
 template <typename T>
 T clamp(const T& n, const T& low, const T& high) {
   return std::max(low, std::min(n, high));
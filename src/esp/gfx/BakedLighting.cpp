@@ -0,0 +1,125 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "BakedLighting.h"
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Matrix3.h>
+#include <cmath>
+#include <vector>
+
+#include "esp/core/MappedFile.h"
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+std::uint64_t hashFloats(const std::vector<float>& values) {
+  return core::hashBytes({reinterpret_cast<const char*>(values.data()),
+                          values.size() * sizeof(float)});
+}
+}  // namespace
+
+bool canBakeLighting(const LightSetup& lightSetup) {
+  if (lightSetup.empty()) {
+    // drawn unlit already
+    return false;
+  }
+  for (const LightInfo& light : lightSetup) {
+    if (light.model == LightPositionModel::CAMERA) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool canBakeLighting(const PhongMaterialData& material) {
+  return !material.vertexColored &&
+         !(material.ambientTexture && material.diffuseTexture &&
+           material.ambientTexture != material.diffuseTexture);
+}
+
+Cr::Containers::Array<Mn::Color4> bakeVertexLighting(
+    const LightSetup& lightSetup,
+    const PhongMaterialData& material,
+    const Mn::Matrix4& transformation,
+    const Cr::Containers::StridedArrayView1D<const Mn::Vector3>& positions,
+    const Cr::Containers::StridedArrayView1D<const Mn::Vector3>& normals) {
+  CORRADE_ASSERT(positions.size() == normals.size(),
+                 "bakeVertexLighting(): expected as many normals as positions",
+                 {});
+
+  // the lights in the world, object-relative ones move with the mesh
+  std::vector<Mn::Vector4> lights;
+  for (const LightInfo& light : lightSetup) {
+    lights.push_back(light.model == LightPositionModel::OBJECT
+                         ? transformation * light.vector
+                         : light.vector);
+  }
+  const Mn::Color3 ambient =
+      material.ambientColor.rgb() * getAmbientLightColor(lightSetup);
+  // the Phong shader adds the alpha of the ambient and diffuse colors
+  const float alpha = Mn::Math::min(
+      material.ambientColor.a() + material.diffuseColor.a(), 1.0f);
+  const Mn::Matrix3x3 normalMatrix = transformation.normalMatrix();
+
+  Cr::Containers::Array<Mn::Color4> colors{Cr::Containers::NoInit,
+                                           positions.size()};
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    const Mn::Vector3 position = transformation.transformPoint(positions[i]);
+    const Mn::Vector3 normal = (normalMatrix * normals[i]).normalized();
+    Mn::Color3 diffuse;
+    for (std::size_t j = 0; j < lights.size(); ++j) {
+      // like the Phong shader, faded out towards the range of the light
+      const Mn::Vector3 direction =
+          lights[j].xyz() - position * lights[j].w();
+      float attenuation = 1.0f;
+      if (lights[j].w() != 0.0f) {
+        const float fade = Mn::Math::clamp(
+            1.0f - Mn::Math::pow(std::sqrt(direction.dot()) /
+                                     Mn::Math::max(lightSetup[j].range,
+                                                   0.0001f),
+                                 4.0f),
+            0.0f, 1.0f);
+        attenuation = fade * fade / (1.0f + direction.dot());
+      }
+      const float intensity =
+          Mn::Math::max(0.0f, Mn::Math::dot(normal, direction.normalized()));
+      diffuse += lightSetup[j].color * intensity * attenuation;
+    }
+    colors[i] = {ambient + material.diffuseColor.rgb() * diffuse, alpha};
+  }
+  return colors;
+}
+
+std::uint64_t bakedLightingHash(const LightSetup& lightSetup,
+                                const Mn::Matrix4& transformation) {
+  std::vector<float> values{transformation.data(), transformation.data() + 16};
+  for (const LightInfo& light : lightSetup) {
+    values.insert(values.end(), light.vector.data(), light.vector.data() + 4);
+    values.insert(values.end(), light.color.data(), light.color.data() + 3);
+    values.push_back(float(light.model));
+    values.push_back(light.range);
+  }
+  return hashFloats(values);
+}
+
+std::uint64_t bakedLightingHash(std::uint64_t lightSetupHash,
+                                const PhongMaterialData& material) {
+  std::vector<float> values{material.ambientColor.data(),
+                            material.ambientColor.data() + 4};
+  values.insert(values.end(), material.diffuseColor.data(),
+                material.diffuseColor.data() + 4);
+  const std::uint64_t hashes[]{lightSetupHash, hashFloats(values)};
+  return core::hashBytes(
+      {reinterpret_cast<const char*>(hashes), sizeof(hashes)});
+}
+
+}  // namespace gfx
+}  // namespace esp
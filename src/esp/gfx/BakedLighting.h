@@ -0,0 +1,80 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_BAKEDLIGHTING_H_
+#define ESP_GFX_BAKEDLIGHTING_H_
+
+/** @file
+ * @brief Functions @ref esp::gfx::canBakeLighting(),
+ * @ref esp::gfx::bakeVertexLighting(), @ref esp::gfx::bakedLightingHash()
+ */
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <cstdint>
+
+#include "LightSetup.h"
+#include "MaterialData.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Whether the lighting of static meshes with @p lightSetup can be
+ * baked: it has lights and none of them is relative to the camera
+ */
+bool canBakeLighting(const LightSetup& lightSetup);
+
+/**
+ * @brief Whether the lighting of meshes with @p material can be baked into
+ * their vertex colors: it doesn't have vertex colors already and its ambient
+ * and diffuse textures, if any, are the same
+ */
+bool canBakeLighting(const PhongMaterialData& material);
+
+/**
+ * @brief The lit color of each vertex of a static mesh drawn with
+ * @p material and @p lightSetup
+ * @param lightSetup    The lights, which have to @ref canBakeLighting()
+ * @param material      The material, which has to @ref canBakeLighting()
+ * @param transformation The transformation of the mesh to the world
+ * @param positions     The vertex positions
+ * @param normals       The vertex normals
+ *
+ * Evaluates the ambient and diffuse terms of the Phong shader per vertex,
+ * with the same attenuation of point lights. The specular term depends on
+ * the view and the normal texture varies within triangles, both are left
+ * out. Drawn with no lights, a white ambient color and the diffuse texture,
+ * if any, as the ambient texture, the colors reproduce the lighting at the
+ * vertices.
+ */
+Corrade::Containers::Array<Magnum::Color4> bakeVertexLighting(
+    const LightSetup& lightSetup,
+    const PhongMaterialData& material,
+    const Magnum::Matrix4& transformation,
+    const Corrade::Containers::StridedArrayView1D<const Magnum::Vector3>&
+        positions,
+    const Corrade::Containers::StridedArrayView1D<const Magnum::Vector3>&
+        normals);
+
+/**
+ * @brief Hash of the inputs of @ref bakeVertexLighting() other than the
+ * mesh, to tell whether baked colors are still valid
+ */
+std::uint64_t bakedLightingHash(const LightSetup& lightSetup,
+                                const Magnum::Matrix4& transformation);
+
+/**
+ * @brief @ref bakedLightingHash(const LightSetup&, const Magnum::Matrix4&)
+ * combined with the colors of @p material
+ */
+std::uint64_t bakedLightingHash(std::uint64_t lightSetupHash,
+                                const PhongMaterialData& material);
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_BAKEDLIGHTING_H_
@@ -0,0 +1,152 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CubeMap.h"
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Shaders/Generic.h>
+
+#include "esp/scene/SceneGraph.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+enum ColorAttachment : Mn::UnsignedInt {
+  ColorBuffer = 0,
+  ObjectIdBuffer = 1,
+};
+}  // namespace
+
+CubeMap::CubeMap(int imageSize, Flags flags)
+    : flags_(flags), imageSize_(imageSize) {
+  CORRADE_ASSERT(imageSize > 0,
+                 "CubeMap::CubeMap(): the image size" << imageSize
+                                                      << "is illegal.", );
+  const Mn::Vector2i size{imageSize};
+
+  if (flags_ & Flag::ColorTexture) {
+    colorTexture_ = Mn::GL::CubeMapTexture{};
+    colorTexture_.setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+        .setMinificationFilter(Mn::GL::SamplerFilter::Linear)
+        .setMagnificationFilter(Mn::GL::SamplerFilter::Linear)
+        .setStorage(1, Mn::GL::TextureFormat::RGBA8, size);
+  }
+
+  depthTexture_.setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setStorage(1, Mn::GL::TextureFormat::DepthComponent32F, size);
+
+  if (flags_ & Flag::ObjectIdTexture) {
+    objectIdTexture_ = Mn::GL::CubeMapTexture{};
+    // integer textures cannot be filtered
+    objectIdTexture_.setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+        .setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+        .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+        .setStorage(1, Mn::GL::TextureFormat::R32UI, size);
+  }
+
+  using DrawAttachment = Mn::GL::Framebuffer::DrawAttachment;
+  const DrawAttachment colorOutput =
+      flags_ & Flag::ColorTexture
+          ? DrawAttachment{Mn::GL::Framebuffer::ColorAttachment{ColorBuffer}}
+          : DrawAttachment::None;
+  const DrawAttachment objectIdOutput =
+      flags_ & Flag::ObjectIdTexture
+          ? DrawAttachment{Mn::GL::Framebuffer::ColorAttachment{
+                ObjectIdBuffer}}
+          : DrawAttachment::None;
+
+  frameBuffers_.reserve(6);
+  for (int iFace = 0; iFace < 6; ++iFace) {
+    const auto face = Mn::GL::CubeMapCoordinate(
+        int(Mn::GL::CubeMapCoordinate::PositiveX) + iFace);
+    frameBuffers_.emplace_back(Mn::Range2Di{{}, size});
+    Mn::GL::Framebuffer& frameBuffer = frameBuffers_.back();
+
+    frameBuffer.attachCubeMapTexture(
+        Mn::GL::Framebuffer::BufferAttachment::Depth, depthTexture_, face, 0);
+    if (flags_ & Flag::ColorTexture) {
+      frameBuffer.attachCubeMapTexture(
+          Mn::GL::Framebuffer::ColorAttachment{ColorBuffer}, colorTexture_,
+          face, 0);
+    }
+    if (flags_ & Flag::ObjectIdTexture) {
+      frameBuffer.attachCubeMapTexture(
+          Mn::GL::Framebuffer::ColorAttachment{ObjectIdBuffer},
+          objectIdTexture_, face, 0);
+    }
+    frameBuffer.mapForDraw(
+        {{Mn::Shaders::Generic3D::ColorOutput, colorOutput},
+         {Mn::Shaders::Generic3D::ObjectIdOutput, objectIdOutput}});
+    CORRADE_INTERNAL_ASSERT(
+        frameBuffer.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+        Mn::GL::Framebuffer::Status::Complete);
+  }
+}
+
+Mn::GL::CubeMapTexture& CubeMap::getTexture(TextureType type) {
+  switch (type) {
+    case TextureType::Color:
+      CORRADE_ASSERT(flags_ & Flag::ColorTexture,
+                     "CubeMap::getTexture(): the cube map was not created with "
+                     "a color texture",
+                     colorTexture_);
+      return colorTexture_;
+    case TextureType::Depth:
+      CORRADE_ASSERT(flags_ & Flag::DepthTexture,
+                     "CubeMap::getTexture(): the cube map was not created with "
+                     "a depth texture",
+                     depthTexture_);
+      return depthTexture_;
+    case TextureType::ObjectId:
+      CORRADE_ASSERT(flags_ & Flag::ObjectIdTexture,
+                     "CubeMap::getTexture(): the cube map was not created with "
+                     "an object id texture",
+                     objectIdTexture_);
+      return objectIdTexture_;
+  }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+void CubeMap::renderToTexture(CubeMapCamera& camera,
+                              scene::SceneGraph& sceneGraph,
+                              RenderCamera::Flags flags,
+                              bool clear) {
+  CORRADE_ASSERT(camera.viewport() == Mn::Vector2i{imageSize_},
+                 "CubeMap::renderToTexture(): the camera viewport"
+                     << camera.viewport() << "does not match the cube map size"
+                     << imageSize_, );
+  if (clear) {
+    for (Mn::GL::Framebuffer& frameBuffer : frameBuffers_) {
+      frameBuffer.clearDepth(1.0);
+      if (flags_ & Flag::ColorTexture) {
+        frameBuffer.clearColor(Mn::Shaders::Generic3D::ColorOutput,
+                               Mn::Color4{0, 0, 0, 1});
+      }
+      if (flags_ & Flag::ObjectIdTexture) {
+        frameBuffer.clearColor(Mn::Shaders::Generic3D::ObjectIdOutput,
+                               Mn::Vector4ui{});
+      }
+    }
+  }
+
+  sceneGraph.updateTransformations();
+  for (auto& it : sceneGraph.getDrawableGroups()) {
+    if (it.second.prepareForDraw(camera)) {
+      camera.drawFaces(
+          it.second,
+          [&](unsigned int iFace) { frameBuffers_[iFace].bind(); }, flags);
+    }
+  }
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,114 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_CUBEMAP_H_
+#define ESP_GFX_CUBEMAP_H_
+
+#include <Corrade/Containers/EnumSet.h>
+#include <Magnum/GL/CubeMapTexture.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/gfx/CubeMapCamera.h"
+#include "esp/gfx/RenderCamera.h"
+
+namespace esp {
+namespace scene {
+class SceneGraph;
+}
+
+namespace gfx {
+
+/**
+ * @brief Cube map render target, filled by a @ref CubeMapCamera
+ *
+ * Holds one texture per enabled @ref Flag and a framebuffer per face, which
+ * @ref renderToTexture() binds while @ref CubeMapCamera::drawFaces() draws the
+ * scene into all faces with a single traversal.
+ */
+class CubeMap {
+ public:
+  enum class Flag : Magnum::UnsignedShort {
+    /**
+     * Render the color into an RGBA8 cube map texture
+     */
+    ColorTexture = 1 << 0,
+    /**
+     * Keep the depth buffer as a sampleable cube map texture, its values are
+     * not unprojected
+     */
+    DepthTexture = 1 << 1,
+    /**
+     * Render the object ids into an R32UI cube map texture
+     */
+    ObjectIdTexture = 1 << 2,
+  };
+
+  /** @brief Flags */
+  typedef Corrade::Containers::EnumSet<Flag> Flags;
+
+  enum class TextureType : uint8_t {
+    Color,
+    Depth,
+    ObjectId,
+  };
+
+  /**
+   * @brief Constructor
+   * @param imageSize, the width (and height) of each face in pixels
+   * @param flags, the textures to render into
+   */
+  explicit CubeMap(int imageSize, Flags flags = Flags{Flag::ColorTexture});
+
+  /** @brief The width (and height) of each face in pixels */
+  int getCubeMapSize() const { return imageSize_; }
+
+  /** @brief The flags passed to the constructor */
+  Flags getFlags() const { return flags_; }
+
+  /**
+   * @brief Get one of the cube map textures
+   *
+   * Expects the corresponding @ref Flag to be set.
+   */
+  Magnum::GL::CubeMapTexture& getTexture(TextureType type);
+
+  /**
+   * @brief Render the drawable groups of @p sceneGraph into all six faces
+   * @param camera, the camera, its projection should be set with
+   * @ref CubeMapCamera::setProjectionMatrix() to the size of this cube map
+   * @param sceneGraph, the scene graph to render
+   * @param flags, the render flags
+   * @param clear, whether to clear the faces first; pass false to draw on top
+   * of the previous contents, e.g. for the objects-only pass of a semantic
+   * sensor
+   */
+  void renderToTexture(CubeMapCamera& camera,
+                       scene::SceneGraph& sceneGraph,
+                       RenderCamera::Flags flags = {
+                           RenderCamera::Flag::FrustumCulling},
+                       bool clear = true);
+
+ protected:
+  Flags flags_;
+  int imageSize_;
+
+  Magnum::GL::CubeMapTexture colorTexture_{Magnum::NoCreate};
+  // always created, it is the depth attachment of the face framebuffers
+  Magnum::GL::CubeMapTexture depthTexture_;
+  Magnum::GL::CubeMapTexture objectIdTexture_{Magnum::NoCreate};
+
+  // one framebuffer per face, in the order of Magnum::GL::CubeMapCoordinate
+  std::vector<Magnum::GL::Framebuffer> frameBuffers_;
+
+  ESP_SMART_POINTERS(CubeMap)
+};
+
+CORRADE_ENUMSET_OPERATORS(CubeMap::Flags)
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_CUBEMAP_H_
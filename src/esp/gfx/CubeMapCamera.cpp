@@ -4,6 +4,9 @@
 
 #include "CubeMapCamera.h"
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/SceneGraph/Drawable.h>
+#include "esp/gfx/DrawableGroup.h"
 
 namespace Mn = Magnum;
 namespace Cr = Corrade;
@@ -49,41 +52,135 @@ CubeMapCamera& CubeMapCamera::switchToFace(unsigned int cubeSideIndex) {
   return *this;
 }
 
-CubeMapCamera& CubeMapCamera::switchToFace(Mn::GL::CubeMapCoordinate cubeSide) {
+Mn::Matrix4 CubeMapCamera::cameraLocalTransform(
+    Mn::GL::CubeMapCoordinate cubeSide) {
   Mn::Vector3 eye{0.0, 0.0, 0.0};
   Mn::Vector3 yUp{0.0, 1.0, 0.0};
   Mn::Vector3 zUp{0.0, 0.0, 1.0};
 
-  auto cameraLocalTransform = [&]() {
-    switch (cubeSide) {
-      case Mn::GL::CubeMapCoordinate::PositiveX:
-        return Mn::Matrix4::lookAt(eye, Mn::Vector3{-1.0, 0.0, 0.0}, -yUp);
-        break;
-      case Mn::GL::CubeMapCoordinate::NegativeX:
-        return Mn::Matrix4::lookAt(eye, Mn::Vector3{1.0, 0.0, 0.0}, -yUp);
-        break;
-      case Mn::GL::CubeMapCoordinate::PositiveY:
-        return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, 1.0, 0.0}, -zUp);
-        break;
-      case Mn::GL::CubeMapCoordinate::NegativeY:
-        return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, -1.0, 0.0}, zUp);
-        break;
-      case Mn::GL::CubeMapCoordinate::PositiveZ:
-        return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, 0.0, -1.0}, -yUp);
-        break;
-      case Mn::GL::CubeMapCoordinate::NegativeZ:
-        return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, 0.0, 1.0}, -yUp);
-        break;
-      default:
-        CORRADE_INTERNAL_ASSERT_UNREACHABLE();
-        break;
-    }
-  };
+  switch (cubeSide) {
+    case Mn::GL::CubeMapCoordinate::PositiveX:
+      return Mn::Matrix4::lookAt(eye, Mn::Vector3{-1.0, 0.0, 0.0}, -yUp);
+    case Mn::GL::CubeMapCoordinate::NegativeX:
+      return Mn::Matrix4::lookAt(eye, Mn::Vector3{1.0, 0.0, 0.0}, -yUp);
+    case Mn::GL::CubeMapCoordinate::PositiveY:
+      return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, 1.0, 0.0}, -zUp);
+    case Mn::GL::CubeMapCoordinate::NegativeY:
+      return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, -1.0, 0.0}, zUp);
+    case Mn::GL::CubeMapCoordinate::PositiveZ:
+      return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, 0.0, -1.0}, -yUp);
+    case Mn::GL::CubeMapCoordinate::NegativeZ:
+      return Mn::Matrix4::lookAt(eye, Mn::Vector3{0.0, 0.0, 1.0}, -yUp);
+    default:
+      CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+  }
+  return {};
+}
+
+CubeMapCamera& CubeMapCamera::switchToFace(Mn::GL::CubeMapCoordinate cubeSide) {
   this->node().setTransformation(originalViewingMatrix_ *
-                                 cameraLocalTransform());
+                                 cameraLocalTransform(cubeSide));
   return *this;
 }
 
+size_t CubeMapCamera::drawFaces(
+    MagnumDrawableGroup& drawables,
+    const std::function<void(unsigned int)>& bindFace,
+    Flags flags) {
+  flags &= ~Flags{Flag::OcclusionCulling};
+  auto* group = dynamic_cast<DrawableGroup*>(&drawables);
+  size_t numDrawn = 0;
+  if (!group) {
+    for (unsigned int iFace = 0; iFace < 6; ++iFace) {
+      switchToFace(iFace);
+      bindFace(iFace);
+      numDrawn += draw(drawables, flags);
+    }
+    restoreTransformation();
+    return numDrawn;
+  }
+
+  // the face cameras, refreshing the camera matrix through the node cache
+  Mn::Matrix4 faceCameraMatrices[6];
+  for (unsigned int iFace = 0; iFace < 6; ++iFace) {
+    switchToFace(iFace);
+    faceCameraMatrices[iFace] = cleanCameraMatrix();
+  }
+
+  // one traversal of the group for all the faces
+  group->drawableTransformations(Mn::Matrix4{Mn::Math::IdentityInit},
+                                 worldTransforms_);
+  if (flags & Flag::ObjectsOnly) {
+    worldTransforms_.erase(
+        worldTransforms_.begin() + removeNonObjects(worldTransforms_),
+        worldTransforms_.end());
+  }
+
+  constexpr uint8_t AllFaces = (1 << 6) - 1;
+  faceMasks_.assign(worldTransforms_.size(), AllFaces);
+  if (flags & Flag::FrustumCulling) {
+    worldBoxes_.clear();
+    boxDrawables_.clear();
+    for (uint32_t i = 0; i < worldTransforms_.size(); ++i) {
+      auto& node = static_cast<scene::SceneNode&>(
+          worldTransforms_[i].first.get().object());
+      Cr::Containers::Optional<Mn::Range3D> aabb = node.getAbsoluteAABB();
+      if (!aabb && node.getMeshBB().size() != Mn::Vector3{}) {
+        aabb = node.cachedAbsoluteMeshBB();
+      }
+      // drawables without any bounds are drawn into every face
+      if (aabb) {
+        worldBoxes_.push_back(*aabb);
+        boxDrawables_.push_back(i);
+      }
+    }
+
+    boxVisible_.resize(worldBoxes_.size());
+    for (unsigned int iFace = 0; iFace < 6; ++iFace) {
+      frustumCullAabbs(Mn::Frustum::fromMatrix(projectionMatrix() *
+                                               faceCameraMatrices[iFace]),
+                       worldBoxes_, 0, worldBoxes_.size(), boxVisible_.data());
+      for (size_t j = 0; j < boxDrawables_.size(); ++j) {
+        if (!boxVisible_[j]) {
+          faceMasks_[boxDrawables_[j]] &= ~(1 << iFace);
+        }
+      }
+    }
+  }
+
+  if (flags & Flag::UseDrawableIdAsObjectId) {
+    useDrawableIds_ = true;
+  }
+  // light setups may have changed since the last frame
+  lightParameterCache_.invalidate();
+
+  previousNumVisibleDrawables_ = 0;
+  for (uint8_t mask : faceMasks_) {
+    previousNumVisibleDrawables_ += (mask != 0);
+  }
+  previousNumOccludedDrawables_ = 0;
+
+  for (unsigned int iFace = 0; iFace < 6; ++iFace) {
+    switchToFace(iFace);
+    node().cachedAbsoluteTransformationMatrix();
+    faceTransforms_.clear();
+    for (size_t i = 0; i < worldTransforms_.size(); ++i) {
+      if (faceMasks_[i] & (1 << iFace)) {
+        faceTransforms_.emplace_back(
+            worldTransforms_[i].first,
+            faceCameraMatrices[iFace] * worldTransforms_[i].second);
+      }
+    }
+    bindFace(iFace);
+    drawTransforms(group, faceTransforms_, flags);
+    numDrawn += faceTransforms_.size();
+  }
+
+  useDrawableIds_ = false;
+  restoreTransformation();
+  return numDrawn;
+}
+
 CubeMapCamera& CubeMapCamera::setProjectionMatrix(int width,
                                                   float znear,
                                                   float zfar) {
@@ -8,7 +8,9 @@
 #include <Magnum/GL/CubeMapTexture.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Tags.h>
+#include <functional>
 #include "esp/core/esp.h"
+#include "esp/gfx/FrustumCulling.h"
 #include "esp/gfx/RenderCamera.h"
 
 namespace esp {
@@ -83,6 +85,38 @@ class CubeMapCamera : public RenderCamera {
    */
   CubeMapCamera& switchToFace(unsigned int cubeSideIndex);
 
+  /**
+   * @brief The local transformation @ref switchToFace() applies on top of the
+   * original viewing matrix for the cube face @p cubeSide
+   *
+   * A face camera looks at the direction opposite to the one OpenGL samples
+   * the face from, rotated by 180 degrees around the Y axis. I.e. a direction
+   * (x, y, z) in the original viewing space maps to the cube map lookup
+   * direction (-x, y, -z).
+   */
+  static Magnum::Matrix4 cameraLocalTransform(
+      Magnum::GL::CubeMapCoordinate cubeSide);
+
+  /**
+   * @brief Draw @p drawables into all six cube faces with a single traversal
+   * @param drawables, the drawables to draw
+   * @param bindFace, called with the face index (see @ref switchToFace())
+   * right before that face is drawn, it should bind the face's framebuffer
+   * @param flags, the render flags; @ref Flag::OcclusionCulling is ignored,
+   * as the query history would alternate between the faces
+   * @return the number of drawables drawn, summed over the faces
+   *
+   * Unlike six calls to @ref draw(), the absolute transformations and the
+   * world-space bounding boxes of the drawables are gathered once and tested
+   * against the six face frusta in one pass, so only the draw calls are
+   * issued per face. Drawable groups which are not a @ref DrawableGroup fall
+   * back to one @ref draw() per face. The local transformation of the camera
+   * node is restored afterwards, see @ref restoreTransformation().
+   */
+  size_t drawFaces(MagnumDrawableGroup& drawables,
+                   const std::function<void(unsigned int)>& bindFace,
+                   Flags flags = {Flag::FrustumCulling});
+
   /**
    * Calling the the setProjectionMatrix from the base class is not allowed.
    * Use the new one instead.
@@ -123,6 +157,20 @@ class CubeMapCamera : public RenderCamera {
   // default value: identity matrix
   Magnum::Matrix4 originalViewingMatrix_ =
       Magnum::Matrix4{Magnum::Math::IdentityInit};
+
+  // scratch storage of drawFaces(), kept to reuse the allocations
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      worldTransforms_;
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      faceTransforms_;
+  // bit i is set if the drawable is visible from face i
+  std::vector<uint8_t> faceMasks_;
+  AabbsSoA worldBoxes_;
+  // index into worldTransforms_ of each box in worldBoxes_
+  std::vector<uint32_t> boxDrawables_;
+  std::vector<char> boxVisible_;
   ESP_SMART_POINTERS(CubeMapCamera)
 };
 }  // namespace gfx
@@ -0,0 +1,148 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CubeMapShader.h"
+
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/CubeMapTexture.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/Version.h>
+#include <Magnum/Math/Vector2.h>
+
+// This is to import the "resources" at runtime. When the resource is
+// compiled into static library, it must be explicitly initialized via this
+// macro, and should be called *outside* of any namespace.
+static void importShaderResources() {
+  CORRADE_RESOURCE_INITIALIZE(ShaderResources)
+}
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+enum TextureUnit : uint8_t {
+  Color = 0,
+  Depth = 1,
+  ObjectId = 2,
+};
+}  // namespace
+
+CubeMapShader::CubeMapShader(Projection projection, Flags flags)
+    : projection_(projection), flags_(flags) {
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+#ifdef MAGNUM_TARGET_WEBGL
+  Mn::GL::Version glVersion = Mn::GL::Version::GLES300;
+#else
+  Mn::GL::Version glVersion = Mn::GL::Version::GL330;
+#endif
+
+  Mn::GL::Shader vert{glVersion, Mn::GL::Shader::Type::Vertex};
+  Mn::GL::Shader frag{glVersion, Mn::GL::Shader::Type::Fragment};
+
+  vert.addSource(flags_ & Flag::TopDownRows ? "#define TOP_DOWN_ROWS\n" : "")
+      .addSource(rs.get("cubemap.vert"));
+  frag
+      .addSource(Cr::Utility::formatString(
+          "#define OUTPUT_ATTRIBUTE_LOCATION_COLOR {}\n"
+          "#define OUTPUT_ATTRIBUTE_LOCATION_OBJECT_ID {}\n",
+          ColorOutput, ObjectIdOutput))
+      .addSource(projection_ == Projection::Fisheye ? "#define FISHEYE\n" : "")
+      .addSource(flags_ & Flag::ColorTexture ? "#define COLOR_TEXTURE\n" : "")
+      .addSource(flags_ & Flag::DepthTexture ? "#define DEPTH_TEXTURE\n" : "")
+      .addSource(flags_ & Flag::ObjectIdTexture ? "#define OBJECT_ID_TEXTURE\n"
+                                                : "")
+      .addSource(rs.get("cubemap.frag"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+
+  attachShaders({vert, frag});
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  if (projection_ == Projection::Fisheye) {
+    fieldOfViewUniform_ = uniformLocation("FieldOfView");
+    aspectRatioUniform_ = uniformLocation("AspectRatio");
+    setAspectRatio(1.0f);
+  }
+  if (flags_ & Flag::ColorTexture) {
+    setUniform(uniformLocation("ColorTexture"), TextureUnit::Color);
+  }
+  if (flags_ & Flag::DepthTexture) {
+    setUniform(uniformLocation("DepthTexture"), TextureUnit::Depth);
+    depthUnprojectionUniform_ = uniformLocation("DepthUnprojection");
+  }
+  if (flags_ & Flag::ObjectIdTexture) {
+    setUniform(uniformLocation("ObjectIdTexture"), TextureUnit::ObjectId);
+  }
+}
+
+CubeMapShader& CubeMapShader::setFieldOfView(Mn::Rad fieldOfView) {
+  CORRADE_ASSERT(projection_ == Projection::Fisheye,
+                 "CubeMapShader::setFieldOfView(): only the fisheye "
+                 "projection has a field of view",
+                 *this);
+  setUniform(fieldOfViewUniform_, float(fieldOfView));
+  return *this;
+}
+
+CubeMapShader& CubeMapShader::setAspectRatio(float aspectRatio) {
+  if (projection_ == Projection::Fisheye) {
+    setUniform(aspectRatioUniform_, aspectRatio);
+  }
+  return *this;
+}
+
+CubeMapShader& CubeMapShader::setDepthUnprojection(
+    const Mn::Vector2& depthUnprojection) {
+  CORRADE_ASSERT(flags_ & Flag::DepthTexture,
+                 "CubeMapShader::setDepthUnprojection(): the shader was not "
+                 "created with depth texture enabled",
+                 *this);
+  setUniform(depthUnprojectionUniform_, depthUnprojection);
+  return *this;
+}
+
+CubeMapShader& CubeMapShader::bindColorTexture(
+    Mn::GL::CubeMapTexture& texture) {
+  CORRADE_ASSERT(flags_ & Flag::ColorTexture,
+                 "CubeMapShader::bindColorTexture(): the shader was not "
+                 "created with color texture enabled",
+                 *this);
+  texture.bind(TextureUnit::Color);
+  return *this;
+}
+
+CubeMapShader& CubeMapShader::bindDepthTexture(
+    Mn::GL::CubeMapTexture& texture) {
+  CORRADE_ASSERT(flags_ & Flag::DepthTexture,
+                 "CubeMapShader::bindDepthTexture(): the shader was not "
+                 "created with depth texture enabled",
+                 *this);
+  texture.bind(TextureUnit::Depth);
+  return *this;
+}
+
+CubeMapShader& CubeMapShader::bindObjectIdTexture(
+    Mn::GL::CubeMapTexture& texture) {
+  CORRADE_ASSERT(flags_ & Flag::ObjectIdTexture,
+                 "CubeMapShader::bindObjectIdTexture(): the shader was not "
+                 "created with object id texture enabled",
+                 *this);
+  texture.bind(TextureUnit::ObjectId);
+  return *this;
+}
+
+}  // namespace gfx
+}  // namespace esp
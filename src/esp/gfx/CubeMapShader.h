@@ -0,0 +1,142 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_CUBEMAPSHADER_H_
+#define ESP_GFX_CUBEMAPSHADER_H_
+
+#include <Corrade/Containers/EnumSet.h>
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/Math/Angle.h>
+#include <Magnum/Shaders/Generic.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+@brief Shader projecting a @ref CubeMap to an equirectangular or a fisheye
+image
+
+Renders a full-screen triangle, draw it with a mesh of three vertices and no
+attributes. The view direction of every output pixel is looked up in the cube
+map, as it was rendered by @ref CubeMapCamera::drawFaces().
+*/
+class CubeMapShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  enum : Magnum::UnsignedInt {
+    /**
+     * Color shader output, present if @ref Flag::ColorTexture is set.
+     */
+    ColorOutput = Magnum::Shaders::Generic3D::ColorOutput,
+
+    /**
+     * Object ID shader output, present if @ref Flag::ObjectIdTexture is set.
+     */
+    ObjectIdOutput = Magnum::Shaders::Generic3D::ObjectIdOutput,
+  };
+
+  enum class Projection : Magnum::UnsignedByte {
+    /**
+     * Longitude along the image width (360 degrees), latitude along its
+     * height (180 degrees)
+     */
+    Equirectangular,
+    /**
+     * Equidistant fisheye, the field of view covers the diameter of the image
+     * circle, see @ref setFieldOfView()
+     */
+    Fisheye,
+  };
+
+  enum class Flag : Magnum::UnsignedShort {
+    /**
+     * Sample the color texture, see @ref bindColorTexture()
+     */
+    ColorTexture = 1 << 0,
+    /**
+     * Sample the depth texture and write the distance along the view ray as
+     * depth, see @ref bindDepthTexture() and @ref setDepthUnprojection()
+     */
+    DepthTexture = 1 << 1,
+    /**
+     * Sample the object id texture, see @ref bindObjectIdTexture()
+     */
+    ObjectIdTexture = 1 << 2,
+    /**
+     * Draw upside down, into a top-down @ref RenderTarget. The triangle is
+     * then clockwise.
+     */
+    TopDownRows = 1 << 3,
+  };
+
+  /** @brief Flags */
+  typedef Corrade::Containers::EnumSet<Flag> Flags;
+
+  /** @brief Constructor */
+  explicit CubeMapShader(Projection projection,
+                         Flags flags = Flags{Flag::ColorTexture});
+
+  /**
+   * @brief Set the field of view of the fisheye projection
+   * @return Reference to self (for method chaining)
+   *
+   * Expects @ref Projection::Fisheye.
+   */
+  CubeMapShader& setFieldOfView(Magnum::Rad fieldOfView);
+
+  /**
+   * @brief Set the aspect ratio (height / width) of the output image
+   * @return Reference to self (for method chaining)
+   *
+   * Only used by @ref Projection::Fisheye.
+   */
+  CubeMapShader& setAspectRatio(float aspectRatio);
+
+  /**
+   * @brief Set the depth unprojection parameters of the cube map faces, which
+   * are also used for the output. See @ref calculateDepthUnprojection().
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that @ref Flag::DepthTexture is set.
+   */
+  CubeMapShader& setDepthUnprojection(const Magnum::Vector2& depthUnprojection);
+
+  /**
+   * @brief Bind the color cube map texture
+   * @return Reference to self (for method chaining)
+   */
+  CubeMapShader& bindColorTexture(Magnum::GL::CubeMapTexture& texture);
+
+  /**
+   * @brief Bind the depth cube map texture
+   * @return Reference to self (for method chaining)
+   */
+  CubeMapShader& bindDepthTexture(Magnum::GL::CubeMapTexture& texture);
+
+  /**
+   * @brief Bind the object id cube map texture
+   * @return Reference to self (for method chaining)
+   */
+  CubeMapShader& bindObjectIdTexture(Magnum::GL::CubeMapTexture& texture);
+
+  /** @brief The projection passed to the constructor */
+  Projection projection() const { return projection_; }
+
+  /** @brief The flags passed to the constructor */
+  Flags flags() const { return flags_; }
+
+ private:
+  Projection projection_;
+  Flags flags_;
+  int fieldOfViewUniform_ = -1, aspectRatioUniform_ = -1,
+      depthUnprojectionUniform_ = -1;
+};
+
+CORRADE_ENUMSET_OPERATORS(CubeMapShader::Flags)
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_CUBEMAPSHADER_H_
@@ -0,0 +1,247 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CullingBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <Corrade/Utility/Assert.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+Mn::Range3D join(const Mn::Range3D& a, const Mn::Range3D& b) {
+  return {Mn::Math::min(a.min(), b.min()), Mn::Math::max(a.max(), b.max())};
+}
+
+//! bit mask with all six frustum planes set
+constexpr uint8_t AllPlanes = (1 << 6) - 1;
+
+/**
+ * @brief Classify a box against the frustum planes in @p planeMask
+ * @return false if the box is outside of the frustum, otherwise true, with
+ * the bits of the planes the box is fully inside of cleared from @p planeMask
+ *
+ * Uses the same center/extent formulation as the linear test in
+ * RenderCamera.cpp, scaled by 2 to avoid the divisions.
+ */
+// unlike Mn::Math::intersects(), boxes that only touch overlap, so that points
+// on a face of a box count as in it
+bool overlaps(const Mn::Range3D& a, const Mn::Range3D& b) {
+  return (a.min() <= b.max()).all() && (b.min() <= a.max()).all();
+}
+
+bool classify(const Mn::Range3D& box,
+              const Mn::Frustum& frustum,
+              uint8_t& planeMask) {
+  const Mn::Vector3 center = box.min() + box.max();
+  const Mn::Vector3 extent = box.max() - box.min();
+
+  for (int iPlane = 0; iPlane < 6; ++iPlane) {
+    if (!(planeMask & (1 << iPlane))) {
+      continue;
+    }
+    const Mn::Vector4& plane = frustum[iPlane];
+    const float d = Mn::Math::dot(center, plane.xyz());
+    const float r = Mn::Math::dot(extent, Mn::Math::abs(plane.xyz()));
+    const float w = -2.0f * plane.w();
+    if (d + r < w) {
+      return false;
+    }
+    if (d - r >= w) {
+      planeMask &= ~(1 << iPlane);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+void CullingBVH::build(const std::vector<Mn::Range3D>& boxes) {
+  clear();
+  if (boxes.empty()) {
+    return;
+  }
+
+  std::vector<Mn::Vector3> centroids;
+  centroids.reserve(boxes.size());
+  itemIndices_.reserve(boxes.size());
+  for (uint32_t i = 0; i < boxes.size(); ++i) {
+    centroids.push_back(boxes[i].center());
+    itemIndices_.push_back(i);
+  }
+
+  // a binary tree with leaves of at least one item has less than 2n nodes
+  nodes_.reserve(2 * boxes.size());
+  nodes_.emplace_back();
+  buildNode(0, boxes, centroids, 0, boxes.size());
+
+  itemBoxes_.resize(boxes.size());
+  for (uint32_t i = 0; i < itemIndices_.size(); ++i) {
+    itemBoxes_.set(i, boxes[itemIndices_[i]]);
+  }
+  slotVisible_.resize(boxes.size());
+}
+
+void CullingBVH::buildNode(uint32_t nodeIndex,
+                           const std::vector<Mn::Range3D>& boxes,
+                           const std::vector<Mn::Vector3>& centroids,
+                           uint32_t begin,
+                           uint32_t end) {
+  Mn::Range3D bounds = boxes[itemIndices_[begin]];
+  Mn::Range3D centroidBounds{centroids[itemIndices_[begin]],
+                             centroids[itemIndices_[begin]]};
+  for (uint32_t i = begin + 1; i < end; ++i) {
+    const uint32_t item = itemIndices_[i];
+    bounds = join(bounds, boxes[item]);
+    centroidBounds = join(centroidBounds, {centroids[item], centroids[item]});
+  }
+  nodes_[nodeIndex].bounds = bounds;
+
+  const Mn::Vector3 centroidExtent = centroidBounds.size();
+  const int axis = centroidExtent.x() >= centroidExtent.y()
+                       ? (centroidExtent.x() >= centroidExtent.z() ? 0 : 2)
+                       : (centroidExtent.y() >= centroidExtent.z() ? 1 : 2);
+
+  // stop splitting small or degenerate sets, all centroids coincide
+  if (end - begin <= MaxLeafSize || centroidExtent[axis] <= 0.0f) {
+    nodes_[nodeIndex].offset = begin;
+    nodes_[nodeIndex].count = end - begin;
+    return;
+  }
+
+  const uint32_t mid = begin + (end - begin) / 2;
+  std::nth_element(itemIndices_.begin() + begin, itemIndices_.begin() + mid,
+                   itemIndices_.begin() + end,
+                   [&](uint32_t a, uint32_t b) {
+                     return centroids[a][axis] < centroids[b][axis];
+                   });
+
+  const uint32_t firstChild = nodes_.size();
+  nodes_.emplace_back();
+  nodes_.emplace_back();
+  // do not keep a reference into nodes_ across the recursion
+  nodes_[nodeIndex].offset = firstChild;
+  nodes_[nodeIndex].count = 0;
+  buildNode(firstChild, boxes, centroids, begin, mid);
+  buildNode(firstChild + 1, boxes, centroids, mid, end);
+}
+
+void CullingBVH::refit(const std::vector<Mn::Range3D>& boxes) {
+  CORRADE_ASSERT(boxes.size() == itemIndices_.size(),
+                 "CullingBVH::refit(): expected" << itemIndices_.size()
+                                                 << "boxes but got"
+                                                 << boxes.size(), );
+  // children are always stored after their parent, so a reverse sweep visits
+  // every node after both of its children
+  for (size_t i = nodes_.size(); i-- > 0;) {
+    Node& node = nodes_[i];
+    if (node.count > 0) {
+      Mn::Range3D bounds = boxes[itemIndices_[node.offset]];
+      itemBoxes_.set(node.offset, bounds);
+      for (uint32_t j = node.offset + 1; j < node.offset + node.count; ++j) {
+        const Mn::Range3D& box = boxes[itemIndices_[j]];
+        itemBoxes_.set(j, box);
+        bounds = join(bounds, box);
+      }
+      node.bounds = bounds;
+    } else {
+      node.bounds =
+          join(nodes_[node.offset].bounds, nodes_[node.offset + 1].bounds);
+    }
+  }
+}
+
+size_t CullingBVH::cull(const Mn::Frustum& frustum,
+                        std::vector<char>& visible) const {
+  visible.assign(itemIndices_.size(), 0);
+  if (nodes_.empty()) {
+    return 0;
+  }
+
+  size_t numVisible = 0;
+  std::vector<char>& slotVisible = slotVisible_;
+  std::vector<std::pair<uint32_t, uint8_t>>& stack = cullStack_;
+  stack.clear();
+  stack.emplace_back(0, AllPlanes);
+  while (!stack.empty()) {
+    uint32_t nodeIndex = stack.back().first;
+    uint8_t planeMask = stack.back().second;
+    stack.pop_back();
+
+    const Node& node = nodes_[nodeIndex];
+    if (planeMask && !classify(node.bounds, frustum, planeMask)) {
+      continue;
+    }
+
+    if (node.count == 0) {
+      stack.emplace_back(node.offset + 1, planeMask);
+      stack.emplace_back(node.offset, planeMask);
+      continue;
+    }
+
+    const uint32_t end = node.offset + node.count;
+    if (planeMask) {
+      frustumCullAabbs(frustum, itemBoxes_, node.offset, end,
+                       slotVisible.data());
+    } else {
+      // items of a leaf fully inside of the frustum need no test
+      std::fill(slotVisible.begin() + node.offset, slotVisible.begin() + end,
+                1);
+    }
+    for (uint32_t i = node.offset; i < end; ++i) {
+      visible[itemIndices_[i]] = slotVisible[i];
+      numVisible += slotVisible[i];
+    }
+  }
+  return numVisible;
+}
+
+void CullingBVH::query(const Mn::Range3D& box,
+                       std::vector<uint32_t>& items) const {
+  items.clear();
+  if (nodes_.empty()) {
+    return;
+  }
+
+  // in the doubled center and size form of itemBoxes_
+  const Mn::Vector3 center = box.min() + box.max();
+  const Mn::Vector3 extent = box.max() - box.min();
+  std::vector<uint32_t> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (!overlaps(node.bounds, box)) {
+      continue;
+    }
+
+    if (node.count == 0) {
+      stack.push_back(node.offset + 1);
+      stack.push_back(node.offset);
+      continue;
+    }
+
+    for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+      if (std::abs(itemBoxes_.centerX[i] - center.x()) <=
+              itemBoxes_.extentX[i] + extent.x() &&
+          std::abs(itemBoxes_.centerY[i] - center.y()) <=
+              itemBoxes_.extentY[i] + extent.y() &&
+          std::abs(itemBoxes_.centerZ[i] - center.z()) <=
+              itemBoxes_.extentZ[i] + extent.z()) {
+        items.push_back(itemIndices_[i]);
+      }
+    }
+  }
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,122 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_CULLINGBVH_H_
+#define ESP_GFX_CULLINGBVH_H_
+
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Range.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/gfx/FrustumCulling.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Axis-aligned bounding volume hierarchy used for frustum culling and
+ * box overlap queries.
+ *
+ * The tree is stored as a flat array of nodes over a permutation of the input
+ * boxes. It is built once with @ref build() (median split along the largest
+ * axis of the box centroids) and can afterwards be updated in place with
+ * @ref refit() when the boxes move but the set of boxes stays the same, which
+ * is what dynamic objects need.
+ */
+class CullingBVH {
+ public:
+  /**
+   * @brief Build the hierarchy over a set of boxes
+   * @param boxes world-space boxes, an item's index in this vector is the
+   * index reported by @ref cull()
+   */
+  void build(const std::vector<Magnum::Range3D>& boxes);
+
+  /**
+   * @brief Update the bounds of the hierarchy bottom-up without changing its
+   * topology
+   * @param boxes new boxes, must have the same size as the ones passed to
+   * @ref build()
+   */
+  void refit(const std::vector<Magnum::Range3D>& boxes);
+
+  /**
+   * @brief Cull the items against a frustum
+   * @param frustum frustum, in the same space as the boxes
+   * @param[out] visible resized to @ref numItems(); set to 1 for every item
+   * whose box intersects the frustum, 0 otherwise
+   * @return the number of visible items
+   *
+   * Subtrees whose bounds are outside of the frustum are skipped, and
+   * subtrees fully inside of it are accepted without testing their items.
+   * The items of the remaining leaves are tested with
+   * @ref frustumCullAabbs(). Uses scratch buffers of the hierarchy, so
+   * concurrent calls on the same hierarchy aren't allowed.
+   */
+  size_t cull(const Magnum::Frustum& frustum, std::vector<char>& visible) const;
+
+  /**
+   * @brief Find the items whose boxes overlap a box
+   * @param box query box, in the same space as the boxes; a degenerate box
+   * is a point query
+   * @param[out] items cleared and filled with the indices of the items whose
+   * boxes overlap or touch @p box, in no particular order
+   */
+  void query(const Magnum::Range3D& box, std::vector<uint32_t>& items) const;
+
+  /** @brief Number of items the hierarchy was built over */
+  size_t numItems() const { return itemIndices_.size(); }
+
+  /** @brief Number of nodes in the hierarchy */
+  size_t numNodes() const { return nodes_.size(); }
+
+  /** @brief Clear the hierarchy */
+  void clear() {
+    nodes_.clear();
+    itemIndices_.clear();
+    itemBoxes_.clear();
+    slotVisible_.clear();
+  }
+
+  //! maximum number of items stored in a leaf, one AVX2 batch of
+  //! @ref frustumCullAabbs()
+  static constexpr uint32_t MaxLeafSize = 8;
+
+ protected:
+  struct Node {
+    Magnum::Range3D bounds;
+    // for inner nodes: index of the first child (the second one follows it
+    // directly); for leaves: offset into itemIndices_
+    uint32_t offset = 0;
+    // number of items for leaves, 0 for inner nodes
+    uint32_t count = 0;
+  };
+
+  void buildNode(uint32_t nodeIndex,
+                 const std::vector<Magnum::Range3D>& boxes,
+                 const std::vector<Magnum::Vector3>& centroids,
+                 uint32_t begin,
+                 uint32_t end);
+
+  std::vector<Node> nodes_;
+  // input box index of each leaf slot
+  std::vector<uint32_t> itemIndices_;
+  // boxes in leaf order, so that each leaf is a contiguous range
+  AabbsSoA itemBoxes_;
+  // scratch of cull(): the results of frustumCullAabbs() per leaf slot,
+  // sized by build(), and the traversal stack, (node index, planes still to
+  // be tested)
+  mutable std::vector<char> slotVisible_;
+  mutable std::vector<std::pair<uint32_t, uint8_t>> cullStack_;
+
+  ESP_SMART_POINTERS(CullingBVH)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_CULLINGBVH_H_
@@ -4,15 +4,21 @@
 
 #include "DepthUnprojection.h"
 
+#include <algorithm>
+
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Containers/Reference.h>
+#include <Corrade/Containers/StridedArrayView.h>
 #include <Corrade/Utility/Resource.h>
 #include <Magnum/GL/Shader.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/Version.h>
+#include <Magnum/ImageView.h>
 #include <Magnum/Math/Functions.h>
 #include <Magnum/Math/Matrix4.h>
 
+#include "esp/core/ThreadPool.h"
+
 namespace Cr = Corrade;
 namespace Mn = Magnum;
 
@@ -51,6 +57,17 @@ DepthShader::DepthShader(Flags flags) : flags_{flags} {
   if (flags & Flag::NoFarPlanePatching)
     frag.addSource("#define NO_FAR_PLANE_PATCHING\n");
 
+  if (flags & Flag::ReconstructNormals) {
+    CORRADE_INTERNAL_ASSERT(flags & Flag::UnprojectExistingDepth);
+    frag.addSource("#define RECONSTRUCT_NORMALS\n");
+  }
+
+  if (flags & Flag::UnprojectPoints) {
+    CORRADE_INTERNAL_ASSERT(flags & Flag::UnprojectExistingDepth &&
+                            !(flags & Flag::ReconstructNormals));
+    frag.addSource("#define UNPROJECT_POINTS\n");
+  }
+
   vert.addSource(rs.get("depth.vert"));
   frag.addSource(rs.get("depth.frag"));
 
@@ -64,6 +81,15 @@ DepthShader::DepthShader(Flags flags) : flags_{flags} {
     projectionMatrixOrDepthUnprojectionUniform_ =
         uniformLocation("depthUnprojection");
     setUniform(uniformLocation("depthTexture"), DepthTextureUnit);
+    if (flags & (Flag::ReconstructNormals | Flag::UnprojectPoints)) {
+      pixelUnprojectionUniform_ = uniformLocation("pixelUnprojection");
+    }
+    if (flags & Flag::UnprojectPoints) {
+      pointTransformationUniform_ = uniformLocation("pointTransformation");
+      pointStrideUniform_ = uniformLocation("pointStride");
+      setPointTransformation(Mn::Matrix4{});
+      setPointStride(1);
+    }
   } else {
     transformationMatrixUniform_ = uniformLocation("transformationMatrix");
     projectionMatrixOrDepthUnprojectionUniform_ =
@@ -78,6 +104,27 @@ DepthShader& DepthShader::setDepthUnprojection(
   return *this;
 }
 
+DepthShader& DepthShader::setPixelUnprojection(
+    const Mn::Vector2& pixelUnprojection) {
+  CORRADE_INTERNAL_ASSERT(flags_ &
+                          (Flag::ReconstructNormals | Flag::UnprojectPoints));
+  setUniform(pixelUnprojectionUniform_, pixelUnprojection);
+  return *this;
+}
+
+DepthShader& DepthShader::setPointTransformation(
+    const Mn::Matrix4& transformation) {
+  CORRADE_INTERNAL_ASSERT(flags_ & Flag::UnprojectPoints);
+  setUniform(pointTransformationUniform_, transformation);
+  return *this;
+}
+
+DepthShader& DepthShader::setPointStride(int stride) {
+  CORRADE_INTERNAL_ASSERT(flags_ & Flag::UnprojectPoints && stride > 0);
+  setUniform(pointStrideUniform_, stride);
+  return *this;
+}
+
 DepthShader& DepthShader::setTransformationMatrix(const Mn::Matrix4& matrix) {
   CORRADE_INTERNAL_ASSERT(!(flags_ & Flag::UnprojectExistingDepth));
   setUniform(transformationMatrixUniform_, matrix);
@@ -104,6 +151,14 @@ Mn::Vector2 calculateDepthUnprojection(const Mn::Matrix4& projectionMatrix) {
          0.5f;
 }
 
+Mn::Vector2 calculatePixelUnprojection(const Mn::Matrix4& projectionMatrix) {
+  // an orthographic projection has no perspective divide
+  if (projectionMatrix[2][3] == 0.0f) {
+    return {};
+  }
+  return 1.0f / Mn::Vector2{projectionMatrix[0][0], projectionMatrix[1][1]};
+}
+
 /* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
 #if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
 __attribute__((target_clones("default", "sse4.2", "avx2")))
@@ -127,5 +182,39 @@ void unprojectDepth(const Mn::Vector2& unprojection,
   }
 }
 
+void unprojectDepth(const Mn::Vector2& unprojection,
+                    const Mn::MutableImageView2D& depth) {
+  CORRADE_ASSERT(depth.pixelSize() == sizeof(Mn::Float),
+                 "unprojectDepth(): expected four-byte pixels, got"
+                     << depth.pixelSize(), );
+  const Cr::Containers::StridedArrayView2D<Mn::Float> pixels =
+      depth.pixels<Mn::Float>();
+  const std::size_t rows = pixels.size()[0];
+  const std::size_t cols = pixels.size()[1];
+
+  // Chunks of about 64k pixels keep the threads busy for long enough to be
+  // worth waking them up, while splitting 640x480 in about five
+  const std::size_t pixelsPerChunk = 1 << 16;
+  const std::size_t rowsPerChunk = std::max<std::size_t>(
+      1, pixelsPerChunk / std::max<std::size_t>(cols, 1));
+  const std::size_t chunks = (rows + rowsPerChunk - 1) / rowsPerChunk;
+  auto unprojectChunk = [&](std::size_t chunk, std::size_t) {
+    const std::size_t end = std::min(rows, (chunk + 1) * rowsPerChunk);
+    for (std::size_t row = chunk * rowsPerChunk; row < end; ++row) {
+      // each row is contiguous, only the rows may be padded
+      unprojectDepth(unprojection,
+                     {static_cast<Mn::Float*>(pixels[row].data()), cols});
+    }
+  };
+
+  if (chunks < 2) {
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+      unprojectChunk(chunk, 0);
+    return;
+  }
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelFor(chunks, pool.numThreads() + 1, unprojectChunk);
+}
+
 }  // namespace gfx
 }  // namespace esp
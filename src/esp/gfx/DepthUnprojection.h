@@ -7,6 +7,7 @@
 
 #include <Corrade/Containers/EnumSet.h>
 #include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/Magnum.h>
 
 namespace esp {
 namespace gfx {
@@ -37,7 +38,28 @@ class DepthShader : public Magnum::GL::AbstractShaderProgram {
      * set to). This might have some performance penalty and can be turned off
      * with this flag.
      */
-    NoFarPlanePatching = 1 << 1
+    NoFarPlanePatching = 1 << 1,
+
+    /**
+     * Together with @ref Flag::UnprojectExistingDepth, output the unit
+     * normals of the surfaces of the bound depth texture in the camera frame
+     * instead of the depth, as an RGBA float with zero alpha. They're the
+     * normals of the triangles and not the interpolated shading normals,
+     * zero on the far plane, and need @ref setPixelUnprojection() besides
+     * @ref setDepthUnprojection().
+     */
+    ReconstructNormals = 1 << 2,
+
+    /**
+     * Together with @ref Flag::UnprojectExistingDepth, output the points of
+     * the bound depth texture as an RGBA float, the camera frame position
+     * transformed by @ref setPointTransformation() and an alpha of one, or
+     * all zero on the far plane. With @ref setPointStride() each output
+     * pixel takes the point of the center of a block of pixels. Needs
+     * @ref setPixelUnprojection() besides @ref setDepthUnprojection(), and
+     * is exclusive with @ref Flag::ReconstructNormals.
+     */
+    UnprojectPoints = 1 << 3
   };
 
   /** @brief Flags */
@@ -60,6 +82,36 @@ class DepthShader : public Magnum::GL::AbstractShaderProgram {
    */
   DepthShader& setDepthUnprojection(const Magnum::Vector2& depthUnprojection);
 
+  /**
+   * @brief Set the pixel unprojection parameters of
+   * @ref Flag::ReconstructNormals or @ref Flag::UnprojectPoints
+   * @return Reference to self (for method chaining)
+   *
+   * See @ref calculatePixelUnprojection().
+   */
+  DepthShader& setPixelUnprojection(const Magnum::Vector2& pixelUnprojection);
+
+  /**
+   * @brief Set the transformation of the points of
+   * @ref Flag::UnprojectPoints
+   * @return Reference to self (for method chaining)
+   *
+   * Applied to the points in the camera frame, e.g. the absolute
+   * transformation of the camera for points in the world frame. Initially
+   * an identity.
+   */
+  DepthShader& setPointTransformation(const Magnum::Matrix4& transformation);
+
+  /**
+   * @brief Set the subsampling of @ref Flag::UnprojectPoints
+   * @return Reference to self (for method chaining)
+   *
+   * Each output pixel takes the point at the center of a @p stride by
+   * @p stride block of the depth texture, the output is then expected to be
+   * the depth texture size divided by @p stride. Initially @cpp 1 @ce.
+   */
+  DepthShader& setPointStride(int stride);
+
   /**
    * @brief Set projection matrix for unprojection
    * @return Reference to self (for method chaining)
@@ -82,6 +134,9 @@ class DepthShader : public Magnum::GL::AbstractShaderProgram {
  private:
   const Flags flags_;
   int transformationMatrixUniform_, projectionMatrixOrDepthUnprojectionUniform_;
+  int pixelUnprojectionUniform_ = -1;
+  int pointTransformationUniform_ = -1;
+  int pointStrideUniform_ = -1;
 };
 
 CORRADE_ENUMSET_OPERATORS(DepthShader::Flags)
@@ -137,6 +192,21 @@ integrate the constants into @f$ a @f$ and @f$ b @f$, returning @f$ a' @f$ and
 Magnum::Vector2 calculateDepthUnprojection(
     const Magnum::Matrix4& projectionMatrix);
 
+/**
+@brief Calculate the coefficients unprojecting pixels for
+    @ref DepthShader::Flag::ReconstructNormals
+
+With the matrix @f$ \boldsymbol{P} @f$ of @ref calculateDepthUnprojection(),
+the camera frame point seen at @f$ (x_n, y_n) @f$ in normalized device
+coordinates at the unprojected depth @f$ -z @f$ is
+@f$ (\frac{x_n}{p} (-z), \frac{y_n}{q} (-z), z) @f$, returned are
+@f$ \frac{1}{p} @f$ and @f$ \frac{1}{q} @f$. Only perspective projections
+are supported, it's zero for others. A projection flipped vertically gives a
+negative @f$ \frac{1}{q} @f$, for which the normals are flipped back.
+*/
+Magnum::Vector2 calculatePixelUnprojection(
+    const Magnum::Matrix4& projectionMatrix);
+
 /**
 @brief Unproject depth values
 @param[in] unprojection Unprojection coefficients from
@@ -151,6 +221,21 @@ consumers expect zeros for things that are too far.
 void unprojectDepth(const Magnum::Vector2& unprojection,
                     Corrade::Containers::ArrayView<Magnum::Float> depth);
 
+/**
+@brief Unproject a depth image on multiple threads
+
+Same as the above, with chunks of rows of @p depth unprojected on the
+@ref core::ThreadPool::shared() pool. Small images, for which waking up the
+workers costs more than it saves, are unprojected on the calling thread. The
+rows are allowed to be padded.
+@param unprojection     Unprojection coefficients from
+    @ref calculateDepthUnprojection()
+@param[in,out] depth    Depth image of four-byte pixels with values in range
+    @f$ [ 0 ; 1 ] @f$
+*/
+void unprojectDepth(const Magnum::Vector2& unprojection,
+                    const Magnum::MutableImageView2D& depth);
+
 }  // namespace gfx
 }  // namespace esp
 
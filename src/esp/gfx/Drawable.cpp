@@ -4,7 +4,19 @@
 
 #include "Drawable.h"
 #include <Corrade/Utility/Assert.h>
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/MeshView.h>
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Intersection.h>
+#include <Magnum/Math/Range.h>
+#include <cmath>
+#include <limits>
 #include "DrawableGroup.h"
+#include "LightweightShaders.h"
+#include "RenderCamera.h"
+#include "TextureStreamer.h"
 #include "esp/scene/SceneNode.h"
 
 namespace esp {
@@ -29,6 +41,163 @@ Drawable::~Drawable() {
   }
 }
 
+DrawStateKey Drawable::getDrawStateKey() const {
+  DrawStateKey key;
+  key.mesh = mesh_.id();
+  return key;
+}
+
+void Drawable::drawInstances(
+    const std::vector<
+        std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                  Magnum::Matrix4>>&,
+    Magnum::SceneGraph::Camera3D&) {
+  // only called for drawables with a valid instance key
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+void Drawable::drawLightweight(const Magnum::Matrix4& transformationMatrix,
+                               Magnum::SceneGraph::Camera3D& camera,
+                               LightweightShaders& shaders,
+                               LightweightPass pass) {
+  Magnum::GL::AbstractShaderProgram* program;
+  if (pass == LightweightPass::LinearDepth) {
+    program = &shaders.linearDepthShader()
+                   .setTransformationMatrix(transformationMatrix)
+                   .setProjectionMatrix(camera.projectionMatrix());
+  } else {
+    const bool objectIds = pass == LightweightPass::ObjectId;
+    Magnum::Shaders::Flat3D& shader =
+        objectIds ? shaders.objectIdShader(hasPerVertexObjectId())
+                  : shaders.depthShader();
+    shader.setTransformationProjectionMatrix(camera.projectionMatrix() *
+                                             transformationMatrix);
+    if (objectIds) {
+      shader.setObjectId(getObjectId(camera));
+    }
+    program = &shader;
+  }
+  Magnum::GL::AbstractShaderProgram& shader = *program;
+  if (lods_.empty() && submeshes_.empty()) {
+    shader.draw(getVisualizerMesh());
+  } else {
+    drawMesh(shader, transformationMatrix, camera);
+  }
+}
+
+std::size_t Drawable::setSubmeshesHidden(Magnum::UnsignedInt id,
+                                         bool hidden) {
+  std::size_t count = 0;
+  for (Submesh& submesh : submeshes_) {
+    if (submesh.id == id) {
+      submesh.hidden = hidden;
+      ++count;
+    }
+  }
+  return count;
+}
+
+void Drawable::drawMesh(Magnum::GL::AbstractShaderProgram& shader,
+                        const Magnum::Matrix4& transformationMatrix,
+                        Magnum::SceneGraph::Camera3D& camera) {
+  if (submeshes_.empty()) {
+    shader.draw(selectLod(transformationMatrix, camera));
+    return;
+  }
+
+  // the frustum in the space of the node, where the boxes are
+  const Magnum::Frustum frustum = Magnum::Frustum::fromMatrix(
+      camera.projectionMatrix() * transformationMatrix);
+  submeshViews_.clear();
+  Magnum::UnsignedInt runEnd = 0;
+  for (const Submesh& submesh : submeshes_) {
+    if (submesh.hidden ||
+        !Magnum::Math::Intersection::rangeFrustum(submesh.box, frustum)) {
+      continue;
+    }
+    // extend the previous view if the ranges are adjacent
+    if (!submeshViews_.empty() && runEnd == submesh.indexOffset) {
+      Magnum::GL::MeshView& view = submeshViews_.back();
+      view.setCount(view.count() + submesh.indexCount);
+    } else {
+      submeshViews_.emplace_back(mesh_);
+      submeshViews_.back()
+          .setCount(submesh.indexCount)
+          .setIndexRange(submesh.indexOffset);
+    }
+    runEnd = submesh.indexOffset + submesh.indexCount;
+  }
+  if (submeshViews_.empty()) {
+    return;
+  }
+  submeshViewReferences_.assign(submeshViews_.begin(), submeshViews_.end());
+  shader.draw(submeshViewReferences_);
+}
+
+Magnum::GL::Mesh& Drawable::selectLod(
+    const Magnum::Matrix4& transformationMatrix,
+    Magnum::SceneGraph::Camera3D& camera) {
+  if (lods_.empty()) {
+    return mesh_;
+  }
+
+  const float pixelsPerUnit =
+      projectedPixelsPerUnit(transformationMatrix, camera);
+  for (auto lod = lods_.rbegin(); lod != lods_.rend(); ++lod) {
+    if (lod->error * pixelsPerUnit <= LodPixelError) {
+      return *lod->mesh;
+    }
+  }
+  return mesh_;
+}
+
+float Drawable::projectedPixelsPerUnit(
+    const Magnum::Matrix4& transformationMatrix,
+    Magnum::SceneGraph::Camera3D& camera) const {
+  // pixels per unit at unit distance (perspective) or per unit (orthographic)
+  const Magnum::Matrix4& projection = camera.projectionMatrix();
+  const float pixelsPerUnit = 0.5f * projection[1][1] * camera.viewport().y();
+  // in the units of the mesh, so the scaling of the node cancels out
+  float distance;
+  if (projection[2][3] != 0.0f) {
+    const Magnum::Vector3 eye = transformationMatrix.inverted().translation();
+    const Magnum::Range3D& box = node_.getMeshBB();
+    distance = (eye - Magnum::Math::clamp(eye, box.min(), box.max())).length();
+  } else {
+    distance = 1.0f / std::sqrt(transformationMatrix.scalingSquared().max());
+  }
+  if (!(distance > 0.0f)) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return pixelsPerUnit / distance;
+}
+
+void Drawable::requestTextures(
+    TextureStreamer& textureStreamer,
+    const Magnum::Matrix4& transformationMatrix,
+    Magnum::SceneGraph::Camera3D& camera,
+    std::initializer_list<const Magnum::GL::Texture2D*> textures) const {
+  const float pixelExtent =
+      projectedPixelsPerUnit(transformationMatrix, camera) *
+      node_.getMeshBB().size().max();
+  for (const Magnum::GL::Texture2D* texture : textures) {
+    if (texture) {
+      textureStreamer.request(*texture, pixelExtent);
+    }
+  }
+}
+
+Magnum::UnsignedInt Drawable::getObjectId(
+    Magnum::SceneGraph::Camera3D& camera) const {
+  // e.g., semantic mesh has its own per vertex annotation, which has been
+  // uploaded to GPU so simply pass 0 to the uniform "objectId" in the
+  // fragment shader
+  if (static_cast<RenderCamera&>(camera).useDrawableIds()) {
+    return drawableId_;
+  }
+  return hasPerVertexObjectId() ? 0 : node_.getSemanticId();
+}
+
 DrawableGroup* Drawable::drawables() {
   auto* group = Magnum::SceneGraph::Drawable3D::drawables();
   if (!group) {
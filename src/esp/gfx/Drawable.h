@@ -6,7 +6,16 @@
 #define ESP_GFX_DRAWABLE_H_
 
 #include <Corrade/Containers/EnumSet.h>
+#include <Corrade/Containers/Reference.h>
+#include <Magnum/GL/MeshView.h>
+#include <Magnum/Math/Range.h>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <vector>
 
+#include "esp/core/ObjectArena.h"
 #include "esp/core/esp.h"
 #include "magnum.h"
 
@@ -17,14 +26,80 @@ class SceneNode;
 namespace gfx {
 
 class DrawableGroup;
+class LightweightShaders;
+enum class LightweightPass : std::uint8_t;
+class TextureStreamer;
+
+/**
+ * @brief Identifies drawables that can be drawn together in a single
+ * instanced draw call, see @ref DrawableGroup::setInstancingEnabled()
+ *
+ * Two drawables with equal keys draw the same mesh with the same shader,
+ * material and lights, and differ only in their transformation and object id.
+ * A default-constructed key (null mesh) means the drawable cannot be instanced.
+ * Like @ref DrawStateKey, the key is made of identifiers that don't depend on
+ * where the resources live in memory, but the mesh, which the GL id alone
+ * doesn't identify without vertex array objects.
+ */
+struct InstanceKey {
+  //! OpenGL id of the mesh
+  Magnum::UnsignedInt meshId = 0;
+  //! hash of the key of the material in the @ref ShaderManager
+  std::size_t material = 0;
+  //! hash of the key of the light setup in the @ref ShaderManager
+  std::size_t lightSetup = 0;
+  //! drawable-specific shader flags
+  unsigned int flags = 0;
+  //! the mesh, only told apart when the ids are equal
+  const void* mesh = nullptr;
+
+  explicit operator bool() const { return mesh != nullptr; }
+
+  bool operator<(const InstanceKey& other) const {
+    return std::tie(meshId, material, lightSetup, flags, mesh) <
+           std::tie(other.meshId, other.material, other.lightSetup,
+                    other.flags, other.mesh);
+  }
+  bool operator==(const InstanceKey& other) const {
+    return !(*this < other) && !(other < *this);
+  }
+};
+
+/**
+ * @brief The GL state a drawable binds when it is drawn
+ *
+ * @ref RenderCamera::draw() orders the draws of a frame by this key, so that
+ * drawables sharing a shader, material and mesh follow each other, unless
+ * @ref RenderCamera::Flag::PreserveDrawOrder is set. The key is made of
+ * identifiers that don't depend on where the resources live in memory, so
+ * the order is the same from run to run.
+ */
+struct DrawStateKey {
+  //! hash of the key of the shader in the @ref ShaderManager, 0 if unknown
+  std::size_t shader = 0;
+  //! hash of the key of the material in the @ref ShaderManager, 0 if unknown
+  std::size_t material = 0;
+  //! OpenGL id of the mesh
+  Magnum::UnsignedInt mesh = 0;
+
+  bool operator<(const DrawStateKey& other) const {
+    return std::tie(shader, material, mesh) <
+           std::tie(other.shader, other.material, other.mesh);
+  }
+  bool operator==(const DrawStateKey& other) const {
+    return !(*this < other) && !(other < *this);
+  }
+};
 
 /**
  * @brief Drawable for use with @ref DrawableGroup.
  *
  * Drawable will retrieve its shader from its group, and draw
- * itself with the shader.
+ * itself with the shader. Drawables added with @ref
+ * scene::SceneNode::addFeature() live in the arena of the scene graph.
  */
-class Drawable : public Magnum::SceneGraph::Drawable3D {
+class Drawable : public Magnum::SceneGraph::Drawable3D,
+                 public core::ArenaAllocated {
  public:
   /** @brief Flag
    * It will not be used directly in the base class "Drawable" but
@@ -39,7 +114,13 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
     /**
      * indicates the mesh data has separate bi-tangent attribute
      */
-    HasSeparateBitangent = 1 << 1
+    HasSeparateBitangent = 1 << 1,
+
+    /**
+     * indicates the mesh data has an object id attribute, which is drawn
+     * instead of the object id of the node
+     */
+    HasObjectId = 1 << 2
   };
   /** @brief Flags */
   typedef Corrade::Containers::EnumSet<Flag> Flags;
@@ -71,9 +152,23 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
    */
   uint64_t getDrawableId() { return drawableId_; }
 
+  /**
+   * @brief Get the index of this drawable in the visibility flags returned by
+   * @ref DrawableGroup::cull(), or @ref ID_UNDEFINED if the group has not
+   * culled it yet
+   */
+  int getCullingIndex() const { return cullingIndex_; }
+
   virtual void setLightSetup(
       CORRADE_UNUSED const Magnum::ResourceKey& lightSetup){};
 
+  /**
+   * @brief Create the shader variant this drawable draws with for its current
+   * light setup, so that the first frame doesn't compile it. Drawables whose
+   * shader is created in their constructor do nothing.
+   */
+  virtual void prewarmShader() {}
+
   Magnum::GL::Mesh& getMesh() { return mesh_; }
 
   /**
@@ -87,7 +182,178 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
    */
   virtual Magnum::GL::Mesh& getVisualizerMesh() { return mesh_; }
 
+  /**
+   * @brief A coarser level of detail of the mesh, see @ref setLods()
+   */
+  struct Lod {
+    Magnum::GL::Mesh* mesh;
+    //! maximal distance a vertex moved, in the units of the mesh
+    float error;
+  };
+
+  /**
+   * @brief Set coarser levels of detail of the mesh, ordered from the finest
+   * to the coarsest. The meshes are not owned by the drawable.
+   *
+   * The drawable then draws the coarsest level whose error, projected to the
+   * viewport at the point of the mesh bounding box closest to the camera,
+   * is at most @ref LodPixelError pixels. Instanced draws always use the
+   * full mesh.
+   */
+  void setLods(std::vector<Lod> lods) { lods_ = std::move(lods); }
+
+  /** @brief The levels of detail set with @ref setLods() */
+  const std::vector<Lod>& getLods() const { return lods_; }
+
+  //! maximal projected error of the level of detail picked by @ref selectLod()
+  static constexpr float LodPixelError = 1.0f;
+
+  /**
+   * @brief A range of the indices of a mesh merged from several meshes, see
+   * @ref setSubmeshes()
+   */
+  struct Submesh {
+    Magnum::UnsignedInt indexOffset;
+    Magnum::UnsignedInt indexCount;
+    //! bounding box of the range, in the space of the node
+    Magnum::Range3D box;
+    //! what the range is to its creator, e.g. the object ID of a semantic
+    //! instance mesh, see @ref setSubmeshesHidden()
+    Magnum::UnsignedInt id = 0;
+    //! hidden ranges are not drawn
+    bool hidden = false;
+  };
+
+  /**
+   * @brief Set the ranges of the indices of the mesh that are culled
+   * separately, ordered by their offsets
+   *
+   * Only the ranges in the view frustum are drawn, consecutive ones with a
+   * single view of the mesh, so that a mesh merged from many static meshes
+   * (see @ref assets::ResourceManager::setMergeStaticMeshes()) is still
+   * culled per original mesh. The mesh has to be indexed, and levels of
+   * detail are not supported along with them.
+   */
+  void setSubmeshes(std::vector<Submesh> submeshes) {
+    submeshes_ = std::move(submeshes);
+  }
+
+  /** @brief The ranges set with @ref setSubmeshes() */
+  const std::vector<Submesh>& getSubmeshes() const { return submeshes_; }
+
+  /**
+   * @brief Hide or show the ranges with @ref Submesh::id equal to @p id
+   * @return the number of such ranges
+   */
+  std::size_t setSubmeshesHidden(Magnum::UnsignedInt id, bool hidden);
+
+  /**
+   * @brief The level of detail to draw, @ref getMesh() if it has none
+   * @param transformationMatrix, transformation relative to @p camera
+   * @param camera, camera to draw from
+   */
+  Magnum::GL::Mesh& selectLod(const Magnum::Matrix4& transformationMatrix,
+                              Magnum::SceneGraph::Camera3D& camera);
+
+  /**
+   * @brief Key of the instanced batch this drawable can be drawn in
+   *
+   * Not instanceable by default. Drawables overriding this have to implement
+   * @ref drawInstances() as well.
+   */
+  virtual InstanceKey getInstanceKey() const { return {}; }
+
+  /**
+   * @brief The state this drawable binds, see @ref DrawStateKey
+   *
+   * Only the mesh is known to the base class.
+   */
+  virtual DrawStateKey getDrawStateKey() const;
+
+  /**
+   * @brief Whether the drawable only draws depth-tested opaque fragments
+   *
+   * The result of such draws doesn't depend on their order, so
+   * @ref RenderCamera::draw() may reorder them by @ref getDrawStateKey().
+   * Other drawables, e.g. blended or overlaid ones, keep the order of the
+   * group.
+   */
+  virtual bool isOpaque() const { return true; }
+
+  /**
+   * @brief Draw several drawables with the same @ref getInstanceKey() as
+   * this one in one instanced draw call
+   * @param instances, the drawables (including this one) and their
+   * transformations relative to @p camera
+   * @param camera, camera to draw from
+   */
+  virtual void drawInstances(
+      const std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& instances,
+      Magnum::SceneGraph::Camera3D& camera);
+
+  /**
+   * @brief Draw only the depth, the depth and the linear depth, or the depth
+   * and the object id, of this drawable with one of @p shaders instead of
+   * its own shader
+   * @param transformationMatrix, transformation relative to @p camera
+   * @param camera, camera to draw from
+   * @param shaders, the shaders to draw with
+   * @param pass, what to write, see @ref LightweightPass
+   *
+   * Draws @ref getVisualizerMesh(), which is a triangle mesh for every
+   * drawable.
+   */
+  virtual void drawLightweight(const Magnum::Matrix4& transformationMatrix,
+                               Magnum::SceneGraph::Camera3D& camera,
+                               LightweightShaders& shaders,
+                               LightweightPass pass);
+
  protected:
+  /**
+   * @brief Whether the object ids are stored per vertex in the mesh (e.g.
+   * semantic meshes), in which case 0 is passed as object id uniform
+   */
+  virtual bool hasPerVertexObjectId() const { return false; }
+
+  /**
+   * @brief The object id written for this drawable by @p camera
+   */
+  Magnum::UnsignedInt getObjectId(Magnum::SceneGraph::Camera3D& camera) const;
+
+  /**
+   * @brief Draw the level of detail picked by @ref selectLod() with @p shader,
+   * or the visible ranges of the mesh if it has submeshes
+   * @param shader, shader to draw with, its uniforms set already
+   * @param transformationMatrix, transformation relative to @p camera
+   * @param camera, camera to draw from
+   */
+  void drawMesh(Magnum::GL::AbstractShaderProgram& shader,
+                const Magnum::Matrix4& transformationMatrix,
+                Magnum::SceneGraph::Camera3D& camera);
+
+  /**
+   * @brief How many pixels a unit of the mesh covers at the point of the mesh
+   * bounding box closest to the camera, infinity if the camera is inside of
+   * the box
+   * @param transformationMatrix, transformation relative to @p camera
+   * @param camera, camera to draw from
+   */
+  float projectedPixelsPerUnit(const Magnum::Matrix4& transformationMatrix,
+                               Magnum::SceneGraph::Camera3D& camera) const;
+
+  /**
+   * @brief Request the levels of @p textures needed for the projected size
+   * of the mesh bounding box from @p textureStreamer
+   * @param textures, the material textures, null ones are skipped
+   */
+  void requestTextures(
+      TextureStreamer& textureStreamer,
+      const Magnum::Matrix4& transformationMatrix,
+      Magnum::SceneGraph::Camera3D& camera,
+      std::initializer_list<const Magnum::GL::Texture2D*> textures) const;
+
   /**
    * @brief Draw the object using given camera
    *
@@ -103,8 +369,18 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
   static uint64_t drawableIdCounter;
   uint64_t drawableId_;
 
+  // assigned by the DrawableGroup when it builds its culling hierarchies
+  friend class DrawableGroup;
+  int cullingIndex_ = ID_UNDEFINED;
+
   scene::SceneNode& node_;
   Magnum::GL::Mesh& mesh_;
+  std::vector<Lod> lods_;
+  std::vector<Submesh> submeshes_;
+  // scratch storage of drawMesh(), reused across frames
+  std::vector<Magnum::GL::MeshView> submeshViews_;
+  std::vector<Corrade::Containers::Reference<Magnum::GL::MeshView>>
+      submeshViewReferences_;
 };
 
 CORRADE_ENUMSET_OPERATORS(Drawable::Flags)
@@ -4,6 +4,10 @@
 #include "DrawableGroup.h"
 #include "Drawable.h"
 
+#include <algorithm>
+
+#include "esp/scene/SceneNode.h"
+
 namespace esp {
 namespace gfx {
 
@@ -40,6 +44,7 @@ Drawable* DrawableGroup::getDrawable(uint64_t id) const {
 bool DrawableGroup::registerDrawable(Drawable& drawable) {
   // if it is already registered, emplace will do nothing
   if (idToDrawable_.emplace(drawable.getDrawableId(), &drawable).second) {
+    cullingBVHDirty_ = true;
     return true;
   }
   return false;
@@ -49,8 +54,205 @@ bool DrawableGroup::unregisterDrawable(Drawable& drawable) {
   if (idToDrawable_.erase(drawable.getDrawableId()) == 0) {
     return false;
   }
+  drawable.cullingIndex_ = ID_UNDEFINED;
+  cullingBVHDirty_ = true;
   return true;
 }
 
+void DrawableGroup::drawableTransformations(
+    const Magnum::Matrix4& cameraMatrix,
+    std::vector<
+        std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                  Magnum::Matrix4>>& drawableTransforms) {
+  drawableTransforms.clear();
+  drawableTransforms.reserve(size());
+  for (size_t i = 0; i < size(); ++i) {
+    Magnum::SceneGraph::Drawable3D& drawable = (*this)[i];
+    auto& node = static_cast<scene::SceneNode&>(drawable.object());
+    drawableTransforms.emplace_back(
+        drawable, cameraMatrix * node.cachedAbsoluteTransformationMatrix());
+  }
+}
+
+namespace {
+
+// whether the result of drawing the drawable doesn't depend on the draw order
+bool isReorderable(Magnum::SceneGraph::Drawable3D& drawable) {
+  auto* ourDrawable = dynamic_cast<Drawable*>(&drawable);
+  return ourDrawable && ourDrawable->isOpaque();
+}
+
+}  // namespace
+
+size_t DrawableGroup::drawInstanced(
+    const std::vector<
+        std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                  Magnum::Matrix4>>& drawableTransforms,
+    Magnum::SceneGraph::Camera3D& camera) {
+  size_t numDrawCalls = 0;
+  for (size_t runBegin = 0; runBegin < drawableTransforms.size();) {
+    // drawables whose result depends on the draw order are drawn in place
+    remaining_.clear();
+    while (runBegin < drawableTransforms.size() &&
+           !isReorderable(drawableTransforms[runBegin].first)) {
+      remaining_.push_back(drawableTransforms[runBegin++]);
+    }
+    if (!remaining_.empty()) {
+      camera.draw(remaining_);
+    }
+    size_t runEnd = runBegin;
+    while (runEnd < drawableTransforms.size() &&
+           isReorderable(drawableTransforms[runEnd].first)) {
+      ++runEnd;
+    }
+    if (runEnd != runBegin) {
+      numDrawCalls +=
+          drawRunInstanced(drawableTransforms, runBegin, runEnd, camera);
+    }
+    runBegin = runEnd;
+  }
+  return numDrawCalls;
+}
+
+size_t DrawableGroup::drawRunInstanced(
+    const std::vector<
+        std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                  Magnum::Matrix4>>& drawableTransforms,
+    size_t begin,
+    size_t end,
+    Magnum::SceneGraph::Camera3D& camera) {
+  instanceKeys_.clear();
+  for (size_t i = begin; i < end; ++i) {
+    InstanceKey key =
+        static_cast<Drawable&>(drawableTransforms[i].first.get())
+            .getInstanceKey();
+    if (key) {
+      instanceKeys_.emplace_back(key, i);
+    }
+  }
+  // stable, so runs of equal keys keep the draw order
+  std::stable_sort(instanceKeys_.begin(), instanceKeys_.end(),
+                   [](const std::pair<InstanceKey, size_t>& a,
+                      const std::pair<InstanceKey, size_t>& b) {
+                     return a.first < b.first;
+                   });
+
+  // the batches, as ranges of instanceKeys_
+  instanceBatches_.clear();
+  instanced_.assign(end - begin, 0);
+  for (size_t batchBegin = 0; batchBegin < instanceKeys_.size();) {
+    size_t batchEnd = batchBegin + 1;
+    while (batchEnd < instanceKeys_.size() &&
+           instanceKeys_[batchEnd].first == instanceKeys_[batchBegin].first) {
+      ++batchEnd;
+    }
+    if (batchEnd - batchBegin >= MinInstanceCount) {
+      instanceBatches_.emplace_back(batchBegin, batchEnd);
+      for (size_t i = batchBegin; i < batchEnd; ++i) {
+        instanced_[instanceKeys_[i].second - begin] = 1;
+      }
+    }
+    batchBegin = batchEnd;
+  }
+  // drawn in the order of their first drawable, not of their keys
+  std::sort(instanceBatches_.begin(), instanceBatches_.end(),
+            [&](const std::pair<size_t, size_t>& a,
+                const std::pair<size_t, size_t>& b) {
+              return instanceKeys_[a.first].second <
+                     instanceKeys_[b.first].second;
+            });
+
+  for (const std::pair<size_t, size_t>& batch : instanceBatches_) {
+    instances_.clear();
+    for (size_t i = batch.first; i < batch.second; ++i) {
+      instances_.push_back(drawableTransforms[instanceKeys_[i].second]);
+    }
+    auto& first = static_cast<Drawable&>(instances_.front().first.get());
+    first.drawInstances(instances_, camera);
+  }
+
+  remaining_.clear();
+  for (size_t i = begin; i < end; ++i) {
+    if (!instanced_[i - begin]) {
+      remaining_.push_back(drawableTransforms[i]);
+    }
+  }
+  if (!remaining_.empty()) {
+    camera.draw(remaining_);
+  }
+  return instanceBatches_.size();
+}
+
+void DrawableGroup::rebuildCullingBVH() {
+  staticCullingDrawables_.clear();
+  dynamicCullingDrawables_.clear();
+
+  std::vector<Magnum::Range3D> staticBoxes;
+  int cullingIndex = 0;
+  for (auto& entry : idToDrawable_) {
+    Drawable& drawable = *entry.second;
+    drawable.cullingIndex_ = cullingIndex++;
+    const scene::SceneNode& node = drawable.getSceneNode();
+    Corrade::Containers::Optional<Magnum::Range3D> aabb =
+        node.getAbsoluteAABB();
+    if (aabb) {
+      staticCullingDrawables_.push_back(&drawable);
+      staticBoxes.push_back(*aabb);
+    } else if (node.getMeshBB().size() != Magnum::Vector3{}) {
+      dynamicCullingDrawables_.push_back(&drawable);
+    }
+  }
+  numCullingDrawables_ = idToDrawable_.size();
+
+  staticCullingBVH_.build(staticBoxes);
+  // the dynamic tree is built from the current poses; afterwards it is only
+  // refit, which keeps its topology (and so its culling cost) from the poses
+  // at build time
+  dynamicCullingBoxes_.resize(dynamicCullingDrawables_.size());
+  for (size_t i = 0; i < dynamicCullingDrawables_.size(); ++i) {
+    dynamicCullingBoxes_[i] =
+        dynamicCullingDrawables_[i]->getSceneNode().cachedAbsoluteMeshBB();
+  }
+  dynamicCullingBVH_.build(dynamicCullingBoxes_);
+
+  cullingBVHDirty_ = false;
+}
+
+const std::vector<char>& DrawableGroup::cull(const Magnum::Frustum& frustum) {
+  if (cullingBVHDirty_) {
+    rebuildCullingBVH();
+  } else if (!dynamicCullingDrawables_.empty()) {
+    // the boxes of the nodes that didn't move are cached, and the tree is
+    // only refit if one of them did
+    bool moved = false;
+    for (size_t i = 0; i < dynamicCullingDrawables_.size(); ++i) {
+      const Magnum::Range3D& box =
+          dynamicCullingDrawables_[i]->getSceneNode().cachedAbsoluteMeshBB();
+      if (box != dynamicCullingBoxes_[i]) {
+        dynamicCullingBoxes_[i] = box;
+        moved = true;
+      }
+    }
+    if (moved) {
+      dynamicCullingBVH_.refit(dynamicCullingBoxes_);
+    }
+  }
+
+  // drawables in neither tree are never culled
+  cullingVisibility_.assign(numCullingDrawables_, 1);
+
+  staticCullingBVH_.cull(frustum, bvhVisibility_);
+  for (size_t i = 0; i < staticCullingDrawables_.size(); ++i) {
+    cullingVisibility_[staticCullingDrawables_[i]->cullingIndex_] =
+        bvhVisibility_[i];
+  }
+  dynamicCullingBVH_.cull(frustum, bvhVisibility_);
+  for (size_t i = 0; i < dynamicCullingDrawables_.size(); ++i) {
+    cullingVisibility_[dynamicCullingDrawables_[i]->cullingIndex_] =
+        bvhVisibility_[i];
+  }
+  return cullingVisibility_;
+}
+
 }  // namespace gfx
 }  // namespace esp
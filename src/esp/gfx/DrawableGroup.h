@@ -10,8 +10,12 @@
 #include <Magnum/SceneGraph/SceneGraph.h>
 #include <unordered_map>
 
+#include <Magnum/Math/Frustum.h>
 #include <functional>
+#include <vector>
 #include "esp/core/esp.h"
+#include "esp/gfx/CullingBVH.h"
+#include "esp/gfx/Drawable.h"
 
 namespace esp {
 namespace gfx {
@@ -64,6 +68,92 @@ class DrawableGroup : public Magnum::SceneGraph::DrawableGroup3D {
    */
   virtual bool prepareForDraw(const RenderCamera&) { return true; }
 
+  /**
+   * @brief Compute the camera-relative transformations of the drawables
+   * @param cameraMatrix the camera matrix to multiply the absolute
+   * transformations with
+   * @param[out] drawableTransforms cleared and filled with the drawables of
+   * this group, in group order, and their transformations relative to the
+   * camera
+   *
+   * Equivalent to Magnum::SceneGraph::Camera::drawableTransformations(), but
+   * reuses the absolute transformations cached on the scene nodes (see
+   * @ref scene::SceneNode::cachedAbsoluteTransformationMatrix()), so that
+   * several cameras rendering the same scene in one frame only repeat the
+   * multiplication with their own camera matrix. The output vector keeps its
+   * capacity across calls.
+   */
+  void drawableTransformations(
+      const Magnum::Matrix4& cameraMatrix,
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms);
+
+  /**
+   * @brief Enable or disable instanced drawing
+   * @return Reference to self (for method chaining)
+   *
+   * If enabled, @ref RenderCamera::draw() draws drawables of this group with
+   * the same @ref Drawable::getInstanceKey() (e.g. copies of an object
+   * template) with a single instanced draw call. Disabled by default.
+   */
+  DrawableGroup& setInstancingEnabled(bool enabled) {
+    instancingEnabled_ = enabled;
+    return *this;
+  }
+
+  /** @brief Whether instanced drawing is enabled */
+  bool isInstancingEnabled() const { return instancingEnabled_; }
+
+  /**
+   * @brief Draw @p drawableTransforms, the instanceable drawables in
+   * instanced batches
+   * @param drawableTransforms, drawables of this group and their
+   * transformations relative to @p camera
+   * @param camera, camera to draw from
+   * @return the number of instanced draw calls
+   *
+   * Only the runs of drawables with @ref Drawable::isOpaque() between the
+   * others are batched, the others are drawn individually in their place. In
+   * a run, the batches are drawn in the order of their first drawable,
+   * followed by the drawables whose instance key is shared by fewer than
+   * @ref MinInstanceCount drawables.
+   */
+  size_t drawInstanced(
+      const std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms,
+      Magnum::SceneGraph::Camera3D& camera);
+
+  //! the minimum number of drawables sharing a key to be drawn instanced
+  static constexpr size_t MinInstanceCount = 2;
+
+  /**
+   * @brief Frustum cull the drawables of this group by bounding volume
+   * hierarchy
+   *
+   * Drawables whose node has an absolute AABB (static meshes) are kept in a
+   * static hierarchy that is rebuilt only after the group changed. Drawables
+   * whose node has just a local mesh bounding box (dynamic objects) are kept
+   * in a second hierarchy that is refit to their current world-space boxes
+   * when one of them moved, see @ref scene::SceneNode::cachedAbsoluteMeshBB().
+   * Drawables with neither are never culled.
+   *
+   * @param frustum the world-space frustum
+   * @return a visibility flag per drawable in the group, indexed by @ref
+   * Drawable::getCullingIndex()
+   */
+  const std::vector<char>& cull(const Magnum::Frustum& frustum);
+
+  /**
+   * @brief Force the culling hierarchies to be rebuilt on the next @ref cull()
+   *
+   * Needed only if the absolute AABB or the mesh bounding box of a node
+   * changes after its drawable started being culled. Adding or removing
+   * drawables does this automatically.
+   */
+  void invalidateCullingBVH() { cullingBVHDirty_ = true; }
+
  protected:
   /**
    * Why a friend class here?
@@ -87,6 +177,48 @@ class DrawableGroup : public Magnum::SceneGraph::DrawableGroup3D {
    * a lookup table, that maps a drawable id to the drawable object
    */
   std::unordered_map<uint64_t, Drawable*> idToDrawable_;
+
+  /**
+   * @brief Sort drawables into static and dynamic culling sets and build
+   * their hierarchies
+   */
+  void rebuildCullingBVH();
+
+  // draw the opaque drawables [begin, end) of drawableTransforms, see
+  // drawInstanced()
+  size_t drawRunInstanced(
+      const std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms,
+      size_t begin,
+      size_t end,
+      Magnum::SceneGraph::Camera3D& camera);
+
+  bool cullingBVHDirty_ = true;
+  //! drawables with an absolute AABB, in static BVH item order
+  std::vector<Drawable*> staticCullingDrawables_;
+  //! drawables with only a local mesh bounding box, in dynamic BVH item order
+  std::vector<Drawable*> dynamicCullingDrawables_;
+  //! total number of drawables the culling indices were assigned to
+  size_t numCullingDrawables_ = 0;
+  CullingBVH staticCullingBVH_;
+  CullingBVH dynamicCullingBVH_;
+  // scratch storage reused across frames
+  std::vector<Magnum::Range3D> dynamicCullingBoxes_;
+  std::vector<char> bvhVisibility_;
+  std::vector<char> cullingVisibility_;
+
+  bool instancingEnabled_ = false;
+  // scratch storage reused across frames
+  std::vector<std::pair<InstanceKey, size_t>> instanceKeys_;
+  std::vector<std::pair<size_t, size_t>> instanceBatches_;
+  std::vector<char> instanced_;
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      instances_;
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      remaining_;
   ESP_SMART_POINTERS(DrawableGroup)
 };
 
@@ -0,0 +1,168 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "Foveation.h"
+
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/RenderbufferFormat.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/GL/Version.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Functions.h>
+
+static void importShaderResources() {
+  CORRADE_RESOURCE_INITIALIZE(ShaderResources)
+}
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+enum TextureUnit : uint8_t {
+  Color = 0,
+};
+
+Mn::Vector2i scaledSize(const Mn::Vector2i& size, float scale) {
+  const Mn::Vector2 scaled = Mn::Math::round(Mn::Vector2{size} * scale);
+  return Mn::Math::max(Mn::Vector2i{1}, Mn::Vector2i{scaled});
+}
+
+// the range of a viewport of a framebuffer of size in texture coordinates
+Mn::Vector4 textureRange(const Mn::Range2Di& viewport,
+                         const Mn::Vector2i& size) {
+  return {Mn::Vector2{viewport.min()} / Mn::Vector2{size},
+          Mn::Vector2{viewport.size()} / Mn::Vector2{size}};
+}
+}  // namespace
+
+bool operator==(const Foveation& a, const Foveation& b) {
+  return a.insetSize == b.insetSize && a.peripheryScale == b.peripheryScale;
+}
+
+bool operator!=(const Foveation& a, const Foveation& b) {
+  return !(a == b);
+}
+
+FoveationShader::FoveationShader() {
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+#ifdef MAGNUM_TARGET_WEBGL
+  Mn::GL::Version glVersion = Mn::GL::Version::GLES300;
+#else
+  Mn::GL::Version glVersion = Mn::GL::Version::GL330;
+#endif
+
+  Mn::GL::Shader vert{glVersion, Mn::GL::Shader::Type::Vertex};
+  Mn::GL::Shader frag{glVersion, Mn::GL::Shader::Type::Fragment};
+
+  // the same full-screen triangle as the cube map projection, in the row
+  // order of the framebuffers, which is the same for both
+  vert.addSource(rs.get("cubemap.vert"));
+  frag.addSource(rs.get("foveation.frag"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+
+  attachShaders({vert, frag});
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  setUniform(uniformLocation("FoveatedTexture"), TextureUnit::Color);
+  insetSizeUniform_ = uniformLocation("InsetSize");
+  insetRangeUniform_ = uniformLocation("InsetRange");
+  peripheryRangeUniform_ = uniformLocation("PeripheryRange");
+}
+
+FoveationShader& FoveationShader::bindFramebuffer(
+    FoveatedFramebuffer& framebuffer) {
+  const Mn::Vector2i size = framebuffer.framebufferSize();
+  framebuffer.colorTexture().bind(TextureUnit::Color);
+  setUniform(insetSizeUniform_, framebuffer.foveation().insetSize);
+  setUniform(insetRangeUniform_,
+             textureRange(framebuffer.insetViewport(), size));
+  setUniform(peripheryRangeUniform_,
+             textureRange(framebuffer.peripheryViewport(), size));
+  return *this;
+}
+
+FoveatedFramebuffer::FoveatedFramebuffer(const Mn::Vector2i& size,
+                                         const Foveation& foveation)
+    : foveation_{foveation}, outputSize_{size} {
+  CORRADE_ASSERT(foveation.insetSize > 0.0f && foveation.insetSize <= 1.0f &&
+                     foveation.peripheryScale > 0.0f &&
+                     foveation.peripheryScale <= 1.0f,
+                 "FoveatedFramebuffer: the inset size and the periphery scale "
+                 "have to be in (0, 1]", );
+
+  // the views side by side, the periphery first
+  const Mn::Vector2i peripherySize =
+      scaledSize(size, foveation.peripheryScale);
+  const Mn::Vector2i insetSize = scaledSize(size, foveation.insetSize);
+  peripheryViewport_ = Mn::Range2Di::fromSize({}, peripherySize);
+  insetViewport_ = Mn::Range2Di::fromSize({peripherySize.x(), 0}, insetSize);
+  framebufferSize_ = {peripherySize.x() + insetSize.x(),
+                      Mn::Math::max(peripherySize.y(), insetSize.y())};
+
+  colorTexture_.setMinificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::RGBA8, framebufferSize_);
+  depthBuffer_.setStorage(Mn::GL::RenderbufferFormat::DepthComponent24,
+                          framebufferSize_);
+  framebuffer_ = Mn::GL::Framebuffer{{{}, framebufferSize_}};
+  framebuffer_
+      .attachTexture(Mn::GL::Framebuffer::ColorAttachment{0}, colorTexture_,
+                     0)
+      .attachRenderbuffer(Mn::GL::Framebuffer::BufferAttachment::Depth,
+                          depthBuffer_);
+  CORRADE_INTERNAL_ASSERT(
+      framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+      Mn::GL::Framebuffer::Status::Complete);
+
+  mesh_ = Mn::GL::Mesh{};
+  mesh_.setCount(3);
+}
+
+Mn::Matrix4 FoveatedFramebuffer::insetProjection(
+    const Mn::Matrix4& projection) const {
+  // the inset spans [-insetSize, insetSize] of the normalized device
+  // coordinates of the full view
+  return Mn::Matrix4::scaling(
+             {Mn::Vector2{1.0f / foveation_.insetSize}, 1.0f}) *
+         projection;
+}
+
+void FoveatedFramebuffer::renderEnter() {
+  framebuffer_.setViewport({{}, framebufferSize_})
+      .clearDepth(1.0)
+      .clearColor(0, Mn::Color4{0, 0, 0, 1})
+      .bind();
+}
+
+void FoveatedFramebuffer::setViewport(const Mn::Range2Di& viewport) {
+  // setViewport() also updates the GL viewport when the framebuffer is bound
+  framebuffer_.setViewport(viewport);
+}
+
+void FoveatedFramebuffer::compose(FoveationShader& shader) {
+  // the front face is flipped while drawing into top-down render targets
+  Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::DepthTest);
+  Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+  shader.bindFramebuffer(*this).draw(mesh_);
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::DepthTest);
+}
+
+}  // namespace gfx
+}  // namespace esp
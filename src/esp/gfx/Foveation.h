@@ -0,0 +1,148 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_FOVEATION_H_
+#define ESP_GFX_FOVEATION_H_
+
+/** @file
+ * @brief Struct @ref esp::gfx::Foveation, class
+ * @ref esp::gfx::FoveatedFramebuffer, @ref esp::gfx::FoveationShader
+ */
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Renderbuffer.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief How a view is split into a full resolution inset and a low
+ * resolution periphery, see @ref FoveatedFramebuffer
+ */
+struct Foveation {
+  /** @brief Fraction of the width and height of the view at its center
+   * drawn at full resolution, in (0, 1] */
+  float insetSize = 0.5f;
+
+  /** @brief Resolution of the whole view drawn under the inset, relative to
+   * the full one, in (0, 1] */
+  float peripheryScale = 0.5f;
+};
+
+bool operator==(const Foveation& a, const Foveation& b);
+bool operator!=(const Foveation& a, const Foveation& b);
+
+class FoveatedFramebuffer;
+
+/**
+ * @brief Shader composing the two views of a @ref FoveatedFramebuffer into a
+ * full resolution image
+ *
+ * Renders a full-screen triangle, draw it with a mesh of three vertices and
+ * no attributes. Pixels inside the inset sample the inset view, the others
+ * the periphery view, both filtered linearly.
+ */
+class FoveationShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  /** @brief Constructor */
+  explicit FoveationShader();
+
+  /**
+   * @brief Bind the color texture of @p framebuffer and set its layout
+   * @return Reference to self (for method chaining)
+   */
+  FoveationShader& bindFramebuffer(FoveatedFramebuffer& framebuffer);
+
+ private:
+  int insetSizeUniform_ = -1, insetRangeUniform_ = -1,
+      peripheryRangeUniform_ = -1;
+};
+
+/**
+ * @brief Framebuffer holding a full resolution inset and a low resolution
+ * periphery of a view side by side
+ *
+ * The periphery covers the whole view at @ref Foveation::peripheryScale
+ * times the resolution of the output, the inset only its central
+ * @ref Foveation::insetSize at the full resolution. Both views are drawn with
+ * the same culling, see @ref insetProjection(), and composed into the output
+ * by @ref compose(), giving a full resolution center for a fraction of the
+ * fill cost: the square of the periphery scale plus the square of the inset
+ * size.
+ */
+class FoveatedFramebuffer {
+ public:
+  /**
+   * @brief Constructor
+   * @param size      Size of the composed output
+   * @param foveation The split of the output
+   */
+  explicit FoveatedFramebuffer(const Magnum::Vector2i& size,
+                               const Foveation& foveation);
+
+  /** @brief Size of the composed output */
+  Magnum::Vector2i outputSize() const { return outputSize_; }
+
+  const Foveation& foveation() const { return foveation_; }
+
+  /** @brief Where the periphery is drawn in the framebuffer */
+  Magnum::Range2Di peripheryViewport() const { return peripheryViewport_; }
+
+  /** @brief Where the inset is drawn in the framebuffer */
+  Magnum::Range2Di insetViewport() const { return insetViewport_; }
+
+  /**
+   * @brief The projection drawing the inset of the view of @p projection,
+   * magnifying its center
+   */
+  Magnum::Matrix4 insetProjection(const Magnum::Matrix4& projection) const;
+
+  /** @brief Clear the framebuffer and bind it for drawing */
+  void renderEnter();
+
+  /**
+   * @brief Draw into @p viewport of the framebuffer, either
+   * @ref peripheryViewport() or @ref insetViewport()
+   */
+  void setViewport(const Magnum::Range2Di& viewport);
+
+  /**
+   * @brief Draw the composed view with @p shader into the framebuffer bound
+   * for drawing, e.g. a @ref RenderTarget
+   *
+   * Depth testing and face culling are disabled while drawing, the depth
+   * attachment of the output is left as it is.
+   */
+  void compose(FoveationShader& shader);
+
+  /** @brief The color texture of both views */
+  Magnum::GL::Texture2D& colorTexture() { return colorTexture_; }
+
+  /** @brief Size of the framebuffer */
+  Magnum::Vector2i framebufferSize() const { return framebufferSize_; }
+
+ private:
+  Foveation foveation_;
+  Magnum::Vector2i outputSize_, framebufferSize_;
+  Magnum::Range2Di peripheryViewport_, insetViewport_;
+  Magnum::GL::Texture2D colorTexture_;
+  Magnum::GL::Renderbuffer depthBuffer_;
+  Magnum::GL::Framebuffer framebuffer_{Magnum::NoCreate};
+  // full-screen triangle drawn by compose()
+  Magnum::GL::Mesh mesh_{Magnum::NoCreate};
+
+  ESP_SMART_POINTERS(FoveatedFramebuffer)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_FOVEATION_H_
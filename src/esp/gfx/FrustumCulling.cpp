@@ -0,0 +1,84 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "FrustumCulling.h"
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+void AabbsSoA::resize(size_t size) {
+  centerX.resize(size);
+  centerY.resize(size);
+  centerZ.resize(size);
+  extentX.resize(size);
+  extentY.resize(size);
+  extentZ.resize(size);
+}
+
+void AabbsSoA::set(size_t index, const Mn::Range3D& box) {
+  const Mn::Vector3 center = box.min() + box.max();
+  const Mn::Vector3 extent = box.max() - box.min();
+  centerX[index] = center.x();
+  centerY[index] = center.y();
+  centerZ[index] = center.z();
+  extentX[index] = extent.x();
+  extentY[index] = extent.y();
+  extentZ[index] = extent.z();
+}
+
+void AabbsSoA::push_back(const Mn::Range3D& box) {
+  resize(size() + 1);
+  set(size() - 1, box);
+}
+
+/* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+void frustumCullAabbs(const Mn::Frustum& frustum,
+                      const AabbsSoA& boxes,
+                      size_t begin,
+                      size_t end,
+                      char* visible) {
+  CORRADE_ASSERT(end <= boxes.size(),
+                 "frustumCullAabbs(): range end" << end << "out of bounds for"
+                                                 << boxes.size() << "boxes", );
+  /* Raw pointers so the optimizer doesn't have to prove the vectors don't
+     alias the output. */
+  const float* const cx = boxes.centerX.data();
+  const float* const cy = boxes.centerY.data();
+  const float* const cz = boxes.centerZ.data();
+  const float* const ex = boxes.extentX.data();
+  const float* const ey = boxes.extentY.data();
+  const float* const ez = boxes.extentZ.data();
+
+  for (size_t i = begin; i < end; ++i) {
+    visible[i] = 1;
+  }
+
+  /* One pass per plane instead of an early-out per box, so the inner loop
+     has no branches and vectorizes over the boxes. Same test as
+     Mn::Math::Intersection::rangeFrustum(), with the center and extent
+     pre-multiplied by two. */
+  for (int iPlane = 0; iPlane < 6; ++iPlane) {
+    const Mn::Vector4& plane = frustum[iPlane];
+    const float nx = plane.x(), ny = plane.y(), nz = plane.z();
+    const float ax = Mn::Math::abs(nx), ay = Mn::Math::abs(ny),
+                az = Mn::Math::abs(nz);
+    const float w = -2.0f * plane.w();
+    for (size_t i = begin; i < end; ++i) {
+      const float d = cx[i] * nx + cy[i] * ny + cz[i] * nz;
+      const float r = ex[i] * ax + ey[i] * ay + ez[i] * az;
+      visible[i] &= char(d + r >= w);
+    }
+  }
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,66 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_FRUSTUMCULLING_H_
+#define ESP_GFX_FRUSTUMCULLING_H_
+
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Range.h>
+#include <cstddef>
+#include <vector>
+
+namespace esp {
+namespace gfx {
+
+/**
+@brief Axis-aligned boxes in a structure-of-arrays layout
+
+Each box is stored as its doubled center (@cpp min + max @ce) and its size
+(@cpp max - min @ce), one array per component, which is the form
+@ref frustumCullAabbs() consumes without any shuffling.
+*/
+struct AabbsSoA {
+  std::vector<float> centerX, centerY, centerZ;
+  std::vector<float> extentX, extentY, extentZ;
+
+  /** @brief Number of boxes */
+  size_t size() const { return centerX.size(); }
+
+  /** @brief Resize all component arrays */
+  void resize(size_t size);
+
+  /** @brief Remove all boxes */
+  void clear() { resize(0); }
+
+  /** @brief Store @p box at @p index */
+  void set(size_t index, const Magnum::Range3D& box);
+
+  /** @brief Append @p box */
+  void push_back(const Magnum::Range3D& box);
+};
+
+/**
+@brief Test a range of boxes against a frustum
+@param[in] frustum  Frustum, in the same space as the boxes
+@param[in] boxes    Boxes to test
+@param[in] begin    First box to test
+@param[in] end      One past the last box to test
+@param[out] visible Set to @cpp 1 @ce at the index of every box in
+    @f$ [ begin ; end ) @f$ that intersects the frustum, @cpp 0 @ce otherwise.
+    Has to be at least @p end long.
+
+Gives the same results as @ref Magnum::Math::Intersection::rangeFrustum(), but
+the loops are branch-free over the component arrays so that the compiler
+tests 4 (SSE, NEON) or 8 (AVX2) boxes per instruction.
+*/
+void frustumCullAabbs(const Magnum::Frustum& frustum,
+                      const AabbsSoA& boxes,
+                      size_t begin,
+                      size_t end,
+                      char* visible);
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_FRUSTUMCULLING_H_
@@ -6,9 +6,11 @@
 
 #include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Utility/FormatStl.h>
+#include <Magnum/GL/Buffer.h>
 #include <Magnum/Math/Color.h>
 #include <Magnum/Math/Matrix3.h>
 
+#include "esp/core/StartupProfile.h"
 #include "esp/scene/SceneNode.h"
 
 namespace Mn = Magnum;
@@ -27,8 +29,13 @@ GenericDrawable::GenericDrawable(scene::SceneNode& node,
       shaderManager_{shaderManager},
       lightSetup_{shaderManager.get<LightSetup>(lightSetupKey)},
       materialData_{
-          shaderManager.get<MaterialData, PhongMaterialData>(materialDataKey)} {
+          shaderManager.get<MaterialData, PhongMaterialData>(materialDataKey)},
+      textureStreamer_{
+          shaderManager.get<TextureStreamer>(TextureStreamer::Key)},
+      instanceBuffers_{
+          shaderManager.get<InstanceBuffers>(InstanceBuffers::Key)} {
   flags_ = Mn::Shaders::Phong::Flag::ObjectId;
+  meshObjectIds_ = bool(meshAttributeFlags & Drawable::Flag::HasObjectId);
   if (materialData_->textureMatrix != Mn::Matrix3{}) {
     flags_ |= Mn::Shaders::Phong::Flag::TextureTransformation;
   }
@@ -52,7 +59,7 @@ GenericDrawable::GenericDrawable(scene::SceneNode& node,
                       "them yet, ignoring a normal map";
     }
   }
-  if (materialData_->perVertexObjectId) {
+  if (hasPerVertexObjectId()) {
     flags_ |= Mn::Shaders::Phong::Flag::InstancedObjectId;
   }
   if (materialData_->vertexColored) {
@@ -63,6 +70,12 @@ GenericDrawable::GenericDrawable(scene::SceneNode& node,
   updateShader();
 }
 
+GenericDrawable::~GenericDrawable() {
+  if (instanceBuffer_) {
+    instanceBuffers_->release(mesh_);
+  }
+}
+
 void GenericDrawable::setLightSetup(const Mn::ResourceKey& resourceKey) {
   lightSetup_ = shaderManager_.get<LightSetup>(resourceKey);
 
@@ -72,105 +85,196 @@ void GenericDrawable::setLightSetup(const Mn::ResourceKey& resourceKey) {
 
 void GenericDrawable::updateShaderLightingParameters(
     const Mn::Matrix4& transformationMatrix,
-    Mn::SceneGraph::Camera3D& camera) {
-  const Mn::Matrix4 cameraMatrix = camera.cameraMatrix();
-
-  std::vector<Mn::Vector4> lightPositions;
-  lightPositions.reserve(lightSetup_->size());
-  std::vector<Mn::Color3> lightColors;
-  lightColors.reserve(lightSetup_->size());
-  std::vector<Mn::Color3> lightSpecularColors;
-  lightSpecularColors.reserve(lightSetup_->size());
-  constexpr float dummyRange = Mn::Constants::inf();
-  std::vector<float> lightRanges(lightSetup_->size(), dummyRange);
-  const Mn::Color4 ambientLightColor = getAmbientLightColor(*lightSetup_);
+    Mn::SceneGraph::Camera3D& camera,
+    Mn::Shaders::Phong& shader) {
+  LightParameterCache& cache =
+      static_cast<RenderCamera&>(camera).lightParameterCache();
+  const LightParameters& lights =
+      cache.get(*lightSetup_, camera.cameraMatrix(), transformationMatrix);
 
-  for (Mn::UnsignedInt i = 0; i < lightSetup_->size(); ++i) {
-    const auto& lightInfo = (*lightSetup_)[i];
-    lightPositions.emplace_back(Mn::Vector4(getLightPositionRelativeToCamera(
-        lightInfo, transformationMatrix, cameraMatrix)));
+  // See documentation in src/deps/magnum/src/Magnum/Shaders/Phong.h
+  shader.setAmbientColor(materialData_->ambientColor * lights.ambientColor)
+      .setDiffuseColor(materialData_->diffuseColor)
+      .setSpecularColor(materialData_->specularColor)
+      .setShininess(materialData_->shininess);
 
-    const auto& lightColor = (*lightSetup_)[i].color;
-    lightColors.emplace_back(lightColor);
+  // the shader is shared by all drawables with the same flags and light
+  // count, the lights only have to be uploaded when they differ from the
+  // previous drawable's
+  if (cache.needsUpload(&shader, lights)) {
+    shader.setLightPositions(lights.positions)
+        .setLightColors(lights.colors)
+        .setLightRanges(lights.ranges);
+  }
+}
 
-    // In general, a light's specular color should match its base color.
-    // However, negative lights have zero (black) specular.
-    constexpr Mn::Color3 blackColor(0.0, 0.0, 0.0);
-    bool isNegativeLight = lightColor.x() < 0;
-    lightSpecularColors.emplace_back(isNegativeLight ? blackColor : lightColor);
+void GenericDrawable::bindTextures(Mn::Shaders::Phong& shader,
+                                   Mn::Shaders::Phong::Flags flags) {
+  if ((flags & Mn::Shaders::Phong::Flag::TextureTransformation) &&
+      materialData_->textureMatrix != Mn::Matrix3{}) {
+    shader.setTextureMatrix(materialData_->textureMatrix);
   }
 
-  // See documentation in src/deps/magnum/src/Magnum/Shaders/Phong.h
-  (*shader_)
-      .setAmbientColor(materialData_->ambientColor * ambientLightColor)
-      .setDiffuseColor(materialData_->diffuseColor)
-      .setSpecularColor(materialData_->specularColor)
-      .setShininess(materialData_->shininess)
-      .setLightPositions(lightPositions)
-      .setLightColors(lightColors)
-      .setLightRanges(lightRanges);
+  if (flags & Mn::Shaders::Phong::Flag::AmbientTexture) {
+    shader.bindAmbientTexture(*(materialData_->ambientTexture));
+  }
+  if (flags & Mn::Shaders::Phong::Flag::DiffuseTexture) {
+    shader.bindDiffuseTexture(*(materialData_->diffuseTexture));
+  }
+  if (flags & Mn::Shaders::Phong::Flag::SpecularTexture) {
+    shader.bindSpecularTexture(*(materialData_->specularTexture));
+  }
+  if (flags & Mn::Shaders::Phong::Flag::NormalTexture) {
+    shader.bindNormalTexture(*(materialData_->normalTexture));
+  }
 }
 
 void GenericDrawable::draw(const Mn::Matrix4& transformationMatrix,
                            Mn::SceneGraph::Camera3D& camera) {
   updateShader();
 
-  updateShaderLightingParameters(transformationMatrix, camera);
+  updateShaderLightingParameters(transformationMatrix, camera, *shader_);
 
   (*shader_)
-      // e.g., semantic mesh has its own per vertex annotation, which has been
-      // uploaded to GPU so simply pass 0 to the uniform "objectId" in the
-      // fragment shader
-      .setObjectId(
-          static_cast<RenderCamera&>(camera).useDrawableIds()
-              ? drawableId_
-              : (materialData_->perVertexObjectId ? 0 : node_.getSemanticId()))
+      .setObjectId(getObjectId(camera))
       .setTransformationMatrix(transformationMatrix)
       .setProjectionMatrix(camera.projectionMatrix())
       .setNormalMatrix(transformationMatrix.normalMatrix());
 
-  if ((flags_ & Mn::Shaders::Phong::Flag::TextureTransformation) &&
-      materialData_->textureMatrix != Mn::Matrix3{}) {
-    shader_->setTextureMatrix(materialData_->textureMatrix);
+  if (textureStreamer_) {
+    requestTextures(*textureStreamer_, transformationMatrix, camera,
+                    {materialData_->ambientTexture,
+                     materialData_->diffuseTexture,
+                     materialData_->specularTexture,
+                     materialData_->normalTexture});
   }
+  bindTextures(*shader_, flags_);
+
+  drawMesh(*shader_, transformationMatrix, camera);
+}
 
-  if (flags_ & Mn::Shaders::Phong::Flag::AmbientTexture) {
-    shader_->bindAmbientTexture(*(materialData_->ambientTexture));
+DrawStateKey GenericDrawable::getDrawStateKey() const {
+  DrawStateKey key;
+  key.shader = std::hash<Mn::ResourceKey>{}(shader_.key());
+  key.material = std::hash<Mn::ResourceKey>{}(materialData_.key());
+  key.mesh = mesh_.id();
+  return key;
+}
+
+InstanceKey GenericDrawable::getInstanceKey() const {
+  if (hasPerVertexObjectId()) {
+    // the object id attribute is taken by the mesh
+    return {};
   }
-  if (flags_ & Mn::Shaders::Phong::Flag::DiffuseTexture) {
-    shader_->bindDiffuseTexture(*(materialData_->diffuseTexture));
+  for (const LightInfo& light : *lightSetup_) {
+    if (light.model == LightPositionModel::OBJECT) {
+      // the light positions would differ per instance
+      return {};
+    }
   }
-  if (flags_ & Mn::Shaders::Phong::Flag::SpecularTexture) {
-    shader_->bindSpecularTexture(*(materialData_->specularTexture));
+  InstanceKey key;
+  key.meshId = mesh_.id();
+  key.material = std::hash<Mn::ResourceKey>{}(materialData_.key());
+  key.lightSetup = std::hash<Mn::ResourceKey>{}(lightSetup_.key());
+  key.mesh = &mesh_;
+  key.flags = static_cast<Mn::Shaders::Phong::Flags::UnderlyingType>(flags_);
+  return key;
+}
+
+void GenericDrawable::drawInstances(
+    const std::vector<
+        std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                  Mn::Matrix4>>& instances,
+    Mn::SceneGraph::Camera3D& camera) {
+  const Mn::Shaders::Phong::Flags instancedFlags =
+      flags_ | Mn::Shaders::Phong::Flag::InstancedTransformation |
+      Mn::Shaders::Phong::Flag::InstancedObjectId;
+  auto shader = getShader(instancedFlags);
+
+  // instances share the material and light setup (see getInstanceKey()), and
+  // no light is object-relative, so the lighting of any of them will do
+  updateShaderLightingParameters(Mn::Matrix4{}, camera, *shader);
+
+  struct InstanceData {
+    Mn::Matrix4 transformationMatrix;
+    Mn::Matrix3x3 normalMatrix;
+    Mn::UnsignedInt objectId;
+  };
+  std::vector<InstanceData> instanceData;
+  instanceData.reserve(instances.size());
+  for (const auto& instance : instances) {
+    auto& drawable = static_cast<GenericDrawable&>(instance.first.get());
+    instanceData.push_back({instance.second, instance.second.normalMatrix(),
+                            drawable.getObjectId(camera)});
   }
-  if (flags_ & Mn::Shaders::Phong::Flag::NormalTexture) {
-    shader_->bindNormalTexture(*(materialData_->normalTexture));
+
+  // every drawable drawn instanced keeps the buffer of the mesh alive, which
+  // is added to the mesh once, when it's created
+  if (!instanceBuffers_) {
+    shaderManager_.set<InstanceBuffers>(
+        InstanceBuffers::Key, new InstanceBuffers{},
+        Mn::ResourceDataState::Final, Mn::ResourcePolicy::Resident);
+  }
+  for (const auto& instance : instances) {
+    auto& drawable = static_cast<GenericDrawable&>(instance.first.get());
+    if (drawable.instanceBuffer_) {
+      continue;
+    }
+    const std::pair<Mn::GL::Buffer*, bool> acquired =
+        instanceBuffers_->acquire(mesh_);
+    drawable.instanceBuffer_ = acquired.first;
+    if (acquired.second) {
+      mesh_.addVertexBufferInstanced(*acquired.first, 1, 0,
+                                     Mn::Shaders::Phong::TransformationMatrix{},
+                                     Mn::Shaders::Phong::NormalMatrix{},
+                                     Mn::Shaders::Phong::ObjectId{});
+    }
   }
+  instanceBuffer_->setData(Corrade::Containers::arrayView(instanceData),
+                           Mn::GL::BufferUsage::DynamicDraw);
+
+  // the per-instance attributes are multiplied with / added to the uniforms
+  (*shader)
+      .setObjectId(0)
+      .setTransformationMatrix(Mn::Matrix4{})
+      .setProjectionMatrix(camera.projectionMatrix())
+      .setNormalMatrix(Mn::Matrix3x3{});
 
-  shader_->draw(mesh_);
+  bindTextures(*shader, instancedFlags);
+
+  mesh_.setInstanceCount(instances.size());
+  shader->draw(mesh_);
+  mesh_.setInstanceCount(1);
 }
 
 void GenericDrawable::updateShader() {
+  if (!shader_ || shader_->lightCount() != lightSetup_->size() ||
+      shader_->flags() != flags_) {
+    shader_ = getShader(flags_);
+  }
+}
+
+Mn::Resource<Mn::GL::AbstractShaderProgram, Mn::Shaders::Phong>
+GenericDrawable::getShader(Mn::Shaders::Phong::Flags flags) {
   Mn::UnsignedInt lightCount = lightSetup_->size();
 
-  if (!shader_ || shader_->lightCount() != lightCount ||
-      shader_->flags() != flags_) {
-    // if the number of lights or flags have changed, we need to fetch a
-    // compatible shader
-    shader_ =
-        shaderManager_.get<Mn::GL::AbstractShaderProgram, Mn::Shaders::Phong>(
-            getShaderKey(lightCount, flags_));
-
-    // if no shader with desired number of lights and flags exists, create one
-    if (!shader_) {
-      shaderManager_.set<Mn::GL::AbstractShaderProgram>(
-          shader_.key(), new Mn::Shaders::Phong{flags_, lightCount},
-          Mn::ResourceDataState::Final, Mn::ResourcePolicy::ReferenceCounted);
-    }
+  // if the number of lights or flags have changed, we need to fetch a
+  // compatible shader
+  auto shader =
+      shaderManager_.get<Mn::GL::AbstractShaderProgram, Mn::Shaders::Phong>(
+          getShaderKey(lightCount, flags));
 
-    CORRADE_INTERNAL_ASSERT(shader_ && shader_->lightCount() == lightCount &&
-                            shader_->flags() == flags_);
+  // if no shader with desired number of lights and flags exists, create one
+  if (!shader) {
+    ESP_STARTUP_SPAN("gfx::GenericDrawable::compileShader");
+    shaderManager_.set<Mn::GL::AbstractShaderProgram>(
+        shader.key(), new Mn::Shaders::Phong{flags, lightCount},
+        Mn::ResourceDataState::Final, Mn::ResourcePolicy::ReferenceCounted);
   }
+
+  CORRADE_INTERNAL_ASSERT(shader && shader->lightCount() == lightCount &&
+                          shader->flags() == flags);
+  return shader;
 }
 
 Mn::ResourceKey GenericDrawable::getShaderKey(
@@ -26,17 +26,51 @@ class GenericDrawable : public Drawable {
                            const Magnum::ResourceKey& materialDataKey,
                            DrawableGroup* group = nullptr);
 
+  ~GenericDrawable() override;
+
   void setLightSetup(const Magnum::ResourceKey& lightSetupKey) override;
   static constexpr const char* SHADER_KEY_TEMPLATE = "Phong-lights={}-flags={}";
 
+  /**
+   * @brief Drawables sharing the mesh, material and light setup can be
+   * instanced, unless the material has per-vertex object ids or a light is
+   * positioned relative to the object
+   */
+  InstanceKey getInstanceKey() const override;
+
+  DrawStateKey getDrawStateKey() const override;
+
+  void drawInstances(
+      const std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& instances,
+      Magnum::SceneGraph::Camera3D& camera) override;
+
  protected:
   virtual void draw(const Magnum::Matrix4& transformationMatrix,
                     Magnum::SceneGraph::Camera3D& camera) override;
 
   void updateShader();
+
+  /**
+   * @brief Fetch (or create) the shader with @p flags and the light count of
+   * the current light setup
+   */
+  Magnum::Resource<Magnum::GL::AbstractShaderProgram, Magnum::Shaders::Phong>
+  getShader(Magnum::Shaders::Phong::Flags flags);
+
   void updateShaderLightingParameters(
       const Magnum::Matrix4& transformationMatrix,
-      Magnum::SceneGraph::Camera3D& camera);
+      Magnum::SceneGraph::Camera3D& camera,
+      Magnum::Shaders::Phong& shader);
+
+  bool hasPerVertexObjectId() const override {
+    return materialData_->perVertexObjectId || meshObjectIds_;
+  }
+
+  //! Bind the material textures used by @p flags to @p shader
+  void bindTextures(Magnum::Shaders::Phong& shader,
+                    Magnum::Shaders::Phong::Flags flags);
 
   Magnum::ResourceKey getShaderKey(Magnum::UnsignedInt lightCount,
                                    Magnum::Shaders::Phong::Flags flags) const;
@@ -47,8 +81,15 @@ class GenericDrawable : public Drawable {
       shader_;
   Magnum::Resource<MaterialData, PhongMaterialData> materialData_;
   Magnum::Resource<LightSetup> lightSetup_;
+  Magnum::Resource<TextureStreamer> textureStreamer_;
+  Magnum::Resource<InstanceBuffers> instanceBuffers_;
+  // the buffer of the instanced draws of the mesh, acquired from
+  // instanceBuffers_ the first time this drawable is drawn instanced
+  Magnum::GL::Buffer* instanceBuffer_ = nullptr;
 
   Magnum::Shaders::Phong::Flags flags_;
+  // the mesh has an object id attribute, whatever the material
+  bool meshObjectIds_;
 };
 
 }  // namespace gfx
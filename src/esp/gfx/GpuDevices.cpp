@@ -0,0 +1,201 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "GpuDevices.h"
+
+#include <Corrade/configure.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#include "esp/core/esp.h"
+
+#ifdef CORRADE_TARGET_UNIX
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+#ifdef ESP_BUILD_EGL_SUPPORT
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifndef EGL_CUDA_DEVICE_NV
+#define EGL_CUDA_DEVICE_NV 0x323A
+#endif
+#endif
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+// devices whose used memory differs by less than this are equally loaded
+constexpr std::size_t LoadTolerance = 256 * 1024 * 1024;
+
+std::mutex& contextsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<int, int>& contextsByDevice() {
+  static std::map<int, int> contexts;
+  return contexts;
+}
+
+#ifdef CORRADE_TARGET_UNIX
+// The parts of the NVIDIA management library used here, loaded at runtime so
+// that it's not a build dependency
+struct Nvml {
+  struct Memory {
+    unsigned long long total, free, used;
+  };
+  using Device = void*;
+
+  Nvml() {
+    library = dlopen("libnvidia-ml.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!library)
+      return;
+    init = reinterpret_cast<int (*)()>(dlsym(library, "nvmlInit_v2"));
+    shutdown = reinterpret_cast<int (*)()>(dlsym(library, "nvmlShutdown"));
+    getCount = reinterpret_cast<int (*)(unsigned*)>(
+        dlsym(library, "nvmlDeviceGetCount_v2"));
+    getHandle = reinterpret_cast<int (*)(unsigned, Device*)>(
+        dlsym(library, "nvmlDeviceGetHandleByIndex_v2"));
+    getName = reinterpret_cast<int (*)(Device, char*, unsigned)>(
+        dlsym(library, "nvmlDeviceGetName"));
+    getMemory = reinterpret_cast<int (*)(Device, Memory*)>(
+        dlsym(library, "nvmlDeviceGetMemoryInfo"));
+  }
+
+  bool isLoaded() const {
+    return init && shutdown && getCount && getHandle && getName && getMemory;
+  }
+
+  void* library = nullptr;
+  int (*init)() = nullptr;
+  int (*shutdown)() = nullptr;
+  int (*getCount)(unsigned*) = nullptr;
+  int (*getHandle)(unsigned, Device*) = nullptr;
+  int (*getName)(Device, char*, unsigned) = nullptr;
+  int (*getMemory)(Device, Memory*) = nullptr;
+};
+
+// NVML calls return 0 on success
+std::vector<GpuDevice> nvmlDevices() {
+  static const Nvml nvml;
+  std::vector<GpuDevice> devices;
+  if (!nvml.isLoaded() || nvml.init() != 0)
+    return devices;
+  unsigned count = 0;
+  if (nvml.getCount(&count) == 0) {
+    for (unsigned i = 0; i < count; ++i) {
+      Nvml::Device handle;
+      if (nvml.getHandle(i, &handle) != 0)
+        continue;
+      GpuDevice device;
+      device.device = i;
+      char name[96]{};
+      if (nvml.getName(handle, name, sizeof(name)) == 0)
+        device.name = name;
+      Nvml::Memory memory;
+      if (nvml.getMemory(handle, &memory) == 0) {
+        device.totalMemory = memory.total;
+        device.usedMemory = memory.used;
+      }
+      devices.push_back(device);
+    }
+  }
+  nvml.shutdown();
+  return devices;
+}
+#endif
+
+#ifdef ESP_BUILD_EGL_SUPPORT
+// The EGL devices which are CUDA devices, as WindowlessContext selects them
+std::vector<GpuDevice> eglDevices() {
+  std::vector<GpuDevice> devices;
+  auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+      eglGetProcAddress("eglQueryDevicesEXT"));
+  auto queryDeviceAttrib = reinterpret_cast<PFNEGLQUERYDEVICEATTRIBEXTPROC>(
+      eglGetProcAddress("eglQueryDeviceAttribEXT"));
+  EGLint count = 0;
+  if (!queryDevices || !queryDeviceAttrib ||
+      !queryDevices(0, nullptr, &count))
+    return devices;
+  std::vector<EGLDeviceEXT> handles(count);
+  if (!queryDevices(count, handles.data(), &count))
+    return devices;
+  for (EGLint i = 0; i < count; ++i) {
+    EGLAttrib cudaDevice = -1;
+    if (queryDeviceAttrib(handles[i], EGL_CUDA_DEVICE_NV, &cudaDevice)) {
+      GpuDevice device;
+      device.device = int(cudaDevice);
+      devices.push_back(device);
+    }
+  }
+  std::sort(devices.begin(), devices.end(),
+            [](const GpuDevice& a, const GpuDevice& b) {
+              return a.device < b.device;
+            });
+  return devices;
+}
+#endif
+
+}  // namespace
+
+std::vector<GpuDevice> queryGpuDevices() {
+  std::vector<GpuDevice> devices;
+#ifdef CORRADE_TARGET_UNIX
+  devices = nvmlDevices();
+#endif
+#ifdef ESP_BUILD_EGL_SUPPORT
+  if (devices.empty())
+    devices = eglDevices();
+#endif
+  if (devices.empty())
+    devices.emplace_back();
+
+  std::lock_guard<std::mutex> lock{contextsMutex()};
+  for (GpuDevice& device : devices) {
+    auto found = contextsByDevice().find(device.device);
+    if (found != contextsByDevice().end())
+      device.numContexts = found->second;
+  }
+  return devices;
+}
+
+int leastLoadedGpuDevice() {
+  const std::vector<GpuDevice> devices = queryGpuDevices();
+  std::size_t minUsedMemory = devices[0].usedMemory;
+  for (const GpuDevice& device : devices)
+    minUsedMemory = std::min(minUsedMemory, device.usedMemory);
+
+  std::vector<const GpuDevice*> candidates;
+  int minContexts = 0;
+  for (const GpuDevice& device : devices) {
+    if (device.usedMemory >= minUsedMemory + LoadTolerance)
+      continue;
+    if (candidates.empty() || device.numContexts < minContexts) {
+      candidates.clear();
+      minContexts = device.numContexts;
+    }
+    if (device.numContexts == minContexts)
+      candidates.push_back(&device);
+  }
+
+  std::size_t pick = 0;
+#ifdef CORRADE_TARGET_UNIX
+  pick = std::size_t(getpid()) % candidates.size();
+#endif
+  LOG(INFO) << "Placing the context on GPU " << candidates[pick]->device
+            << " of " << devices.size();
+  return candidates[pick]->device;
+}
+
+void countGpuDeviceContext(const int device, const int delta) {
+  std::lock_guard<std::mutex> lock{contextsMutex()};
+  contextsByDevice()[device] += delta;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,70 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_GPUDEVICES_H_
+#define ESP_GFX_GPUDEVICES_H_
+
+/** @file
+ * @brief Struct @ref esp::gfx::GpuDevice, functions
+ * @ref esp::gfx::queryGpuDevices(), @ref esp::gfx::leastLoadedGpuDevice()
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Device id of @ref WindowlessContext and
+ * @ref sim::SimulatorConfiguration::gpuDeviceId placing the context on the
+ * least loaded GPU, see @ref leastLoadedGpuDevice()
+ */
+constexpr int AUTO_GPU_DEVICE = -1;
+
+/** @brief A GPU that contexts can be created on */
+struct GpuDevice {
+  /** @brief The CUDA device id, as taken by @ref WindowlessContext */
+  int device = 0;
+  /** @brief The name of the device, empty if unknown */
+  std::string name;
+  /** @brief Memory of the device in bytes, 0 if unknown */
+  std::size_t totalMemory = 0;
+  /** @brief Memory used by all processes in bytes, 0 if unknown */
+  std::size_t usedMemory = 0;
+  /** @brief The number of contexts this process has on the device */
+  int numContexts = 0;
+};
+
+/**
+ * @brief The GPUs of the system with their memory use
+ *
+ * The memory is queried from the NVIDIA management library, loaded at
+ * runtime if it's installed, which enumerates the devices in the order of
+ * their PCI bus ids, as CUDA does with @cpp CUDA_DEVICE_ORDER=PCI_BUS_ID @ce.
+ * Without it the devices are enumerated through EGL, without their memory,
+ * and builds without EGL report a single device.
+ */
+std::vector<GpuDevice> queryGpuDevices();
+
+/**
+ * @brief The GPU to create the next context on: the one with the least
+ * memory used, within 256 MB, then with the fewest contexts of this process.
+ *
+ * Processes starting at the same time and seeing the same load are spread
+ * over the devices by their process id.
+ */
+int leastLoadedGpuDevice();
+
+/**
+ * @brief Record that this process created (@p delta 1) or destroyed
+ * (@p delta -1) a context on @p device, see @ref GpuDevice::numContexts
+ */
+void countGpuDeviceContext(int device, int delta);
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_GPUDEVICES_H_
@@ -0,0 +1,35 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "InstanceBuffers.h"
+
+#include <Corrade/Utility/Assert.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+std::pair<Mn::GL::Buffer*, bool> InstanceBuffers::acquire(
+    const Mn::GL::Mesh& mesh) {
+  Entry& entry = buffers_[&mesh];
+  const bool created = !entry.buffer;
+  if (created) {
+    entry.buffer = std::make_unique<Mn::GL::Buffer>();
+  }
+  ++entry.numReferences;
+  return {entry.buffer.get(), created};
+}
+
+void InstanceBuffers::release(const Mn::GL::Mesh& mesh) {
+  auto found = buffers_.find(&mesh);
+  CORRADE_ASSERT(found != buffers_.end(),
+                 "InstanceBuffers::release(): the mesh has no buffer", );
+  if (--found->second.numReferences == 0) {
+    buffers_.erase(found);
+  }
+}
+
+}  // namespace gfx
+}  // namespace esp
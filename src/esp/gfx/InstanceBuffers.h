@@ -0,0 +1,72 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_INSTANCEBUFFERS_H_
+#define ESP_GFX_INSTANCEBUFFERS_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::InstanceBuffers
+ */
+
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/GL.h>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief The buffers with the per-instance attributes of instanced draws, one
+ * per mesh
+ *
+ * A mesh may be drawn instanced by several groups, e.g. the groups of a scene
+ * graph or of simulators sharing a resource manager. They all fill the same
+ * buffer before each of their draws, so it is added to the mesh as instanced
+ * attributes only once. Without vertex array objects, Magnum keeps every
+ * attribute binding added to a mesh, so binding a buffer per group would grow
+ * the mesh with every draw.
+ *
+ * The drawables drawn instanced reference the buffer of their mesh, which is
+ * destroyed with the last of them, before the mesh.
+ */
+class InstanceBuffers {
+ public:
+  /** @brief Key of the buffers in the @ref ShaderManager */
+  static constexpr const char* Key = "instance-buffers";
+
+  /**
+   * @brief Reference the buffer of @p mesh
+   * @return the buffer, and whether it was created by this call and has to be
+   * added to @p mesh
+   */
+  std::pair<Magnum::GL::Buffer*, bool> acquire(const Magnum::GL::Mesh& mesh);
+
+  /**
+   * @brief Release a reference of @ref acquire(), destroying the buffer with
+   * the last one
+   */
+  void release(const Magnum::GL::Mesh& mesh);
+
+  /** @brief The number of meshes with a buffer */
+  std::size_t size() const { return buffers_.size(); }
+
+ private:
+  struct Entry {
+    std::unique_ptr<Magnum::GL::Buffer> buffer;
+    std::size_t numReferences = 0;
+  };
+  std::unordered_map<const Magnum::GL::Mesh*, Entry> buffers_;
+
+  ESP_SMART_POINTERS(InstanceBuffers)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_INSTANCEBUFFERS_H_
@@ -0,0 +1,247 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "LightClusters.h"
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/GL/Sampler.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/PixelFormat.h>
+#include <cmath>
+
+#include "esp/gfx/PbrShader.h"
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+// the tile of a coordinate of normalized device coordinates
+int tileOf(const float ndc, const int tileCount) {
+  return int(Mn::Math::clamp((ndc * 0.5f + 0.5f) * tileCount, 0.0f,
+                             float(tileCount - 1)));
+}
+
+void setNearestFiltering(Mn::GL::Texture2D& texture) {
+  texture.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge);
+}
+
+}  // namespace
+
+constexpr std::size_t LightClusters::MinLightCount;
+constexpr float LightClusters::CutoffIntensity;
+
+bool LightClusters::isClustered(const LightSetup& lightSetup) {
+  if (lightSetup.size() < MinLightCount) {
+    return false;
+  }
+  // their positions differ for every drawable
+  for (const LightInfo& light : lightSetup) {
+    if (light.model == LightPositionModel::OBJECT) {
+      return false;
+    }
+  }
+  return true;
+}
+
+float LightClusters::influenceRadius(const Mn::Color3& color,
+                                     const float range) {
+  // the attenuation is at most 1/(1 + d^2)
+  const float intensity = color.max();
+  if (intensity <= CutoffIntensity) {
+    return 0.0f;
+  }
+  return Mn::Math::min(range, std::sqrt(intensity / CutoffIntensity - 1.0f));
+}
+
+int LightClusters::sliceOf(const float depth) const {
+  const float slice =
+      std::log(Mn::Math::max(depth, 1.0e-4f)) * depthParameters_.x() +
+      depthParameters_.y();
+  return int(Mn::Math::clamp(slice, 0.0f, float(SliceCount - 1)));
+}
+
+std::size_t LightClusters::clusterOf(const Mn::Vector3& position) const {
+  const Mn::Vector4 clip = projection_ * Mn::Vector4{position, 1.0f};
+  const int x = tileOf(clip.x() / clip.w(), TileCountX);
+  const int y = tileOf(clip.y() / clip.w(), TileCountY);
+  return x + TileCountX * (y + TileCountY * sliceOf(-position.z()));
+}
+
+bool LightClusters::update(const LightParameters& parameters,
+                           const Mn::Matrix4& projection) {
+  if (parameters.version == version_ && projection == projection_) {
+    return false;
+  }
+  version_ = parameters.version;
+  projection_ = projection;
+  uploaded_ = false;
+
+  // the depth range of the frustum, a far plane at infinity covers a
+  // thousand times the near distance
+  const Mn::Matrix4 unprojection = projection.inverted();
+  const float znear =
+      Mn::Math::max(-unprojection.transformPoint({0.0f, 0.0f, -1.0f}).z(),
+                    1.0e-2f);
+  float zfar = -unprojection.transformPoint({0.0f, 0.0f, 1.0f}).z();
+  if (!(zfar > znear) || !std::isfinite(zfar)) {
+    zfar = 1000.0f * znear;
+  }
+  const float sliceScale = SliceCount / std::log(zfar / znear);
+  depthParameters_ = {sliceScale, -std::log(znear) * sliceScale};
+
+  const std::size_t count = parameters.positions.size();
+  lightOrder_.clear();
+  for (std::size_t i = 0; i != count; ++i) {
+    if (parameters.positions[i].w() == 0.0f) {
+      lightOrder_.push_back(i);
+    }
+  }
+  directionalLightCount_ = lightOrder_.size();
+  for (std::size_t i = 0; i != count; ++i) {
+    if (parameters.positions[i].w() != 0.0f) {
+      lightOrder_.push_back(i);
+    }
+  }
+
+  // the vectors in the first row, the colors and ranges in the second
+  const std::size_t width = Mn::Math::max(count, std::size_t{1});
+  lightData_.assign(2 * width, Mn::Vector4{});
+  for (std::size_t j = 0; j != count; ++j) {
+    const std::uint32_t i = lightOrder_[j];
+    lightData_[j] = parameters.positions[i];
+    lightData_[width + j] = {parameters.colors[i], parameters.ranges[i]};
+  }
+
+  // the clusters of each point light, conservatively those overlapping the
+  // box around its sphere of influence
+  bounds_.resize(count - directionalLightCount_);
+  for (std::size_t j = directionalLightCount_; j != count; ++j) {
+    const std::uint32_t i = lightOrder_[j];
+    Bounds& bounds = bounds_[j - directionalLightCount_];
+    bounds.min = Mn::Vector3i{0};
+    bounds.max = Mn::Vector3i{-1};
+
+    const Mn::Vector3 center = parameters.positions[i].xyz();
+    const float radius =
+        influenceRadius(parameters.colors[i], parameters.ranges[i]);
+    const float depthMin = -center.z() - radius;
+    const float depthMax = -center.z() + radius;
+    if (radius == 0.0f || depthMax < znear || depthMin > zfar) {
+      continue;
+    }
+
+    // the corners project to a bound of the sphere if none is behind the
+    // camera, otherwise the sphere may cover any tile
+    Mn::Vector2 ndcMin{-1.0f};
+    Mn::Vector2 ndcMax{1.0f};
+    bool bounded = true;
+    Mn::Vector2 cornerMin{Mn::Constants::inf()};
+    Mn::Vector2 cornerMax{-Mn::Constants::inf()};
+    for (int corner = 0; corner != 8; ++corner) {
+      const Mn::Vector3 offset{corner & 1 ? radius : -radius,
+                               corner & 2 ? radius : -radius,
+                               corner & 4 ? radius : -radius};
+      const Mn::Vector4 clip = projection * Mn::Vector4{center + offset, 1.0f};
+      if (clip.w() <= 0.0f) {
+        bounded = false;
+        break;
+      }
+      cornerMin = Mn::Math::min(cornerMin, clip.xy() / clip.w());
+      cornerMax = Mn::Math::max(cornerMax, clip.xy() / clip.w());
+    }
+    if (bounded) {
+      if ((cornerMin > Mn::Vector2{1.0f}).any() ||
+          (cornerMax < Mn::Vector2{-1.0f}).any()) {
+        continue;
+      }
+      ndcMin = cornerMin;
+      ndcMax = cornerMax;
+    }
+    bounds.min = {tileOf(ndcMin.x(), TileCountX),
+                  tileOf(ndcMin.y(), TileCountY), sliceOf(depthMin)};
+    bounds.max = {tileOf(ndcMax.x(), TileCountX),
+                  tileOf(ndcMax.y(), TileCountY), sliceOf(depthMax)};
+  }
+
+  // count the lights of every cluster, then list them
+  clusters_.assign(TileCountX * TileCountY * SliceCount, Mn::Vector2ui{});
+  const auto forEachCluster = [&](const Bounds& bounds, auto&& callback) {
+    for (int z = bounds.min.z(); z <= bounds.max.z(); ++z) {
+      for (int y = bounds.min.y(); y <= bounds.max.y(); ++y) {
+        for (int x = bounds.min.x(); x <= bounds.max.x(); ++x) {
+          callback(clusters_[x + TileCountX * (y + TileCountY * z)]);
+        }
+      }
+    }
+  };
+  for (const Bounds& bounds : bounds_) {
+    forEachCluster(bounds, [](Mn::Vector2ui& cluster) { ++cluster.y(); });
+  }
+  std::uint32_t offset = 0;
+  for (Mn::Vector2ui& cluster : clusters_) {
+    const std::uint32_t lightCount = cluster.y();
+    cluster = {offset, 0};
+    offset += lightCount;
+  }
+  // an empty list still has a row
+  const std::uint32_t rows =
+      Mn::Math::max((offset + IndexTextureWidth - 1) / IndexTextureWidth, 1u);
+  lightIndices_.assign(rows * IndexTextureWidth, 0);
+  for (std::size_t k = 0; k != bounds_.size(); ++k) {
+    const std::uint32_t index = directionalLightCount_ + k;
+    forEachCluster(bounds_[k], [&](Mn::Vector2ui& cluster) {
+      lightIndices_[cluster.x() + cluster.y()++] = index;
+    });
+  }
+  return true;
+}
+
+void LightClusters::bindTextures(PbrShader& shader) {
+  if (!uploaded_) {
+    uploaded_ = true;
+    if (lightTexture_.id() == 0) {
+      lightTexture_ = Mn::GL::Texture2D{};
+      clusterTexture_ = Mn::GL::Texture2D{};
+      indexTexture_ = Mn::GL::Texture2D{};
+      setNearestFiltering(lightTexture_);
+      setNearestFiltering(clusterTexture_);
+      setNearestFiltering(indexTexture_);
+    }
+    lightTexture_.setImage(
+        0, Mn::GL::TextureFormat::RGBA32F,
+        Mn::ImageView2D{Mn::PixelFormat::RGBA32F,
+                        {int(lightData_.size() / 2), 2},
+                        Cr::Containers::arrayView(lightData_)});
+    clusterTexture_.setImage(
+        0, Mn::GL::TextureFormat::RG32UI,
+        Mn::ImageView2D{Mn::PixelFormat::RG32UI,
+                        {TileCountX, TileCountY * SliceCount},
+                        Cr::Containers::arrayView(clusters_)});
+    indexTexture_.setImage(
+        0, Mn::GL::TextureFormat::R32UI,
+        Mn::ImageView2D{
+            Mn::PixelFormat::R32UI,
+            {IndexTextureWidth, int(lightIndices_.size() / IndexTextureWidth)},
+            Cr::Containers::arrayView(lightIndices_)});
+  }
+  shader.bindLightClusterTextures(lightTexture_, clusterTexture_,
+                                  indexTexture_);
+}
+
+void LightClusters::setUniforms(PbrShader& shader) const {
+  shader.setDirectionalLightCount(directionalLightCount_)
+      .setLightClusterDepth(depthParameters_);
+}
+
+}  // namespace gfx
+}  // namespace esp
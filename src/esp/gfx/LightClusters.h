@@ -0,0 +1,165 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_LIGHTCLUSTERS_H_
+#define ESP_GFX_LIGHTCLUSTERS_H_
+
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Vector2.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/gfx/LightParameterCache.h"
+
+namespace esp {
+namespace gfx {
+
+class PbrShader;
+
+/**
+ * @brief The point lights of a view binned into the clusters of its frustum
+ *
+ * The frustum is split into @ref TileCountX by @ref TileCountY tiles in
+ * normalized device coordinates and into @ref SliceCount slices, logarithmic
+ * in the depth. @ref update() lists for every cluster the point lights whose
+ * sphere of influence overlaps it, so that a fragment shaded with
+ * @ref PbrShader::Flag::ClusteredLights loops over the directional lights
+ * and the point lights of its cluster only, instead of over every light of
+ * the scene, with one shader for any number of lights. The lights, the
+ * clusters and their lists are uploaded to textures by @ref bindTextures().
+ *
+ * A point light influences the points within its range, and within the
+ * distance at which its unattenuated intensity falls below
+ * @ref CutoffIntensity, so the lights of large scenes are culled even if
+ * their range is infinite.
+ */
+class LightClusters {
+ public:
+  enum : int {
+    TileCountX = 16,
+    TileCountY = 16,
+    SliceCount = 16,
+    //! the light lists of all clusters are in rows of this many texels
+    IndexTextureWidth = 2048
+  };
+
+  /**
+   * @brief Light setups with at least this many lights and no
+   * object-relative ones are shaded through clusters
+   */
+  static constexpr std::size_t MinLightCount = 8;
+
+  /**
+   * @brief Intensity below which a point light is left out of a cluster,
+   * half of the smallest step of an 8-bit color
+   */
+  static constexpr float CutoffIntensity = 1.0f / 512.0f;
+
+  /**
+   * @brief Whether @p lightSetup is shaded through clusters, see
+   * @ref MinLightCount
+   */
+  static bool isClustered(const LightSetup& lightSetup);
+
+  /**
+   * @brief Distance within which a point light of @p color and @p range
+   * contributes more than @ref CutoffIntensity
+   */
+  static float influenceRadius(const Magnum::Color3& color, float range);
+
+  /**
+   * @brief Bin the lights of @p parameters for @p projection
+   * @return false if the clusters are up to date already
+   *
+   * Does nothing if @p parameters are of the same version as in the last
+   * update and @p projection is the same, so the drawables of a frame share
+   * one update.
+   */
+  bool update(const LightParameters& parameters,
+              const Magnum::Matrix4& projection);
+
+  /**
+   * @brief Upload the lights and clusters of the last @ref update() if they
+   * changed since the last upload, and bind the textures for @p shader
+   *
+   * Expects a current OpenGL context and a shader created with
+   * @ref PbrShader::Flag::ClusteredLights. The texture units are shared by
+   * all shaders, so this has to be called before every draw.
+   */
+  void bindTextures(PbrShader& shader);
+
+  /**
+   * @brief Set the uniforms of @p shader that go with the textures, once
+   * per shader and update
+   */
+  void setUniforms(PbrShader& shader) const;
+
+  /**
+   * @brief Indices of the lights of the parameters in the order of the
+   * light texture, the directional lights first
+   */
+  const std::vector<std::uint32_t>& lightOrder() const { return lightOrder_; }
+
+  /** @brief The number of directional lights at the front of the order */
+  std::size_t directionalLightCount() const { return directionalLightCount_; }
+
+  /**
+   * @brief Offset into @ref lightIndices() and count of the point lights of
+   * each cluster, x first, then y, then the slice
+   */
+  const std::vector<Magnum::Vector2ui>& clusters() const { return clusters_; }
+
+  /**
+   * @brief Positions in @ref lightOrder() of the lights of each cluster,
+   * padded to whole rows of @ref IndexTextureWidth
+   */
+  const std::vector<std::uint32_t>& lightIndices() const {
+    return lightIndices_;
+  }
+
+  /**
+   * @brief The slice of a point at camera-space depth `z` is
+   * `log(-z)*x + y`, clamped to the slices
+   */
+  Magnum::Vector2 depthParameters() const { return depthParameters_; }
+
+  /** @brief The cluster of a camera-space point, e.g. for tests */
+  std::size_t clusterOf(const Magnum::Vector3& position) const;
+
+ private:
+  struct Bounds {
+    Magnum::Vector3i min;
+    Magnum::Vector3i max;
+  };
+
+  int sliceOf(float depth) const;
+
+  uint64_t version_ = 0;
+  Magnum::Matrix4 projection_;
+  bool uploaded_ = false;
+
+  std::vector<std::uint32_t> lightOrder_;
+  std::size_t directionalLightCount_ = 0;
+  std::vector<Magnum::Vector2ui> clusters_;
+  std::vector<std::uint32_t> lightIndices_;
+  Magnum::Vector2 depthParameters_;
+  //! the clusters of each point light, reused between updates
+  std::vector<Bounds> bounds_;
+  std::vector<Magnum::Vector4> lightData_;
+
+  Magnum::GL::Texture2D lightTexture_{Magnum::NoCreate};
+  Magnum::GL::Texture2D clusterTexture_{Magnum::NoCreate};
+  Magnum::GL::Texture2D indexTexture_{Magnum::NoCreate};
+
+  ESP_SMART_POINTERS(LightClusters)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_LIGHTCLUSTERS_H_
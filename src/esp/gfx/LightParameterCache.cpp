@@ -0,0 +1,77 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "LightParameterCache.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+const LightParameters& LightParameterCache::get(
+    const LightSetup& lightSetup,
+    const Mn::Matrix4& cameraMatrix,
+    const Mn::Matrix4& transformationMatrix) {
+  Entry& entry = entries_[&lightSetup];
+  LightParameters& parameters = entry.parameters;
+
+  if (!entry.valid || entry.cameraMatrix != cameraMatrix ||
+      parameters.colors.size() != lightSetup.size()) {
+    // resize() and assignments reuse the capacity from previous frames
+    parameters.positions.resize(lightSetup.size());
+    parameters.colors.resize(lightSetup.size());
+    parameters.ranges.resize(lightSetup.size());
+    parameters.objectRelative = false;
+    for (size_t i = 0; i < lightSetup.size(); ++i) {
+      parameters.colors[i] = lightSetup[i].color;
+      parameters.ranges[i] = lightSetup[i].range;
+      if (lightSetup[i].model == LightPositionModel::OBJECT) {
+        parameters.objectRelative = true;
+      } else {
+        parameters.positions[i] = getLightPositionRelativeToCamera(
+            lightSetup[i], transformationMatrix, cameraMatrix);
+      }
+    }
+    parameters.ambientColor = getAmbientLightColor(lightSetup);
+    parameters.version = nextVersion_++;
+    entry.cameraMatrix = cameraMatrix;
+    entry.valid = true;
+  }
+
+  if (parameters.objectRelative) {
+    // these differ for every drawable
+    for (size_t i = 0; i < lightSetup.size(); ++i) {
+      if (lightSetup[i].model == LightPositionModel::OBJECT) {
+        parameters.positions[i] = getLightPositionRelativeToCamera(
+            lightSetup[i], transformationMatrix, cameraMatrix);
+      }
+    }
+    parameters.version = nextVersion_++;
+  }
+
+  return parameters;
+}
+
+bool LightParameterCache::needsUpload(const void* shader,
+                                      const LightParameters& parameters) {
+  Upload& upload = uploads_[shader];
+  if (upload.parameters == &parameters &&
+      upload.version == parameters.version) {
+    return false;
+  }
+  upload.parameters = &parameters;
+  upload.version = parameters.version;
+  return true;
+}
+
+void LightParameterCache::invalidate() {
+  for (auto& entry : entries_) {
+    entry.second.valid = false;
+  }
+  // shaders are shared between cameras, which upload their own parameters
+  uploads_.clear();
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,100 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_LIGHTPARAMETERCACHE_H_
+#define ESP_GFX_LIGHTPARAMETERCACHE_H_
+
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <unordered_map>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/gfx/LightSetup.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Shader light parameters of a @ref LightSetup, evaluated for a camera
+ */
+struct LightParameters {
+  //! light positions (w == 1) or directions (w == 0) in camera space
+  std::vector<Magnum::Vector4> positions;
+  std::vector<Magnum::Color3> colors;
+  //! the ranges of the lights, infinite for most
+  std::vector<float> ranges;
+  //! combined ambient color for the Phong lighting model
+  Magnum::Color4 ambientColor;
+  //! whether any light is positioned relative to the drawn object
+  bool objectRelative = false;
+  //! incremented every time the parameters are re-evaluated
+  uint64_t version = 0;
+};
+
+/**
+ * @brief Per-camera cache of evaluated light parameters
+ *
+ * Lights positioned relative to the scene or the camera are the same for
+ * every drawable a camera draws, so they are evaluated once per light setup
+ * per frame instead of once per drawable. Only setups containing
+ * object-relative lights are re-evaluated per drawable. All storage is reused
+ * across frames, so drawing does not allocate once the cache is warm.
+ *
+ * Additionally tracks which parameters were last uploaded to which shader, so
+ * that drawables sharing a shader and a light setup upload the light uniforms
+ * only once per frame.
+ */
+class LightParameterCache {
+ public:
+  /**
+   * @brief Get the parameters of @p lightSetup
+   * @param lightSetup, the light setup
+   * @param cameraMatrix, the camera matrix of the camera drawing
+   * @param transformationMatrix, the transformation of the drawn object
+   * relative to the camera, only used for object-relative lights
+   *
+   * The returned reference is valid until the next call.
+   */
+  const LightParameters& get(const LightSetup& lightSetup,
+                             const Magnum::Matrix4& cameraMatrix,
+                             const Magnum::Matrix4& transformationMatrix);
+
+  /**
+   * @brief Whether @p parameters have to be uploaded to @p shader
+   *
+   * Returns false if they were the last light parameters uploaded to it and
+   * did not change since. Otherwise assumes the caller uploads them.
+   */
+  bool needsUpload(const void* shader, const LightParameters& parameters);
+
+  /**
+   * @brief Invalidate all cached parameters, e.g. when a new frame starts or
+   * a light setup changed
+   */
+  void invalidate();
+
+ protected:
+  struct Entry {
+    LightParameters parameters;
+    Magnum::Matrix4 cameraMatrix;
+    bool valid = false;
+  };
+
+  struct Upload {
+    const LightParameters* parameters = nullptr;
+    uint64_t version = 0;
+  };
+
+  std::unordered_map<const LightSetup*, Entry> entries_;
+  std::unordered_map<const void*, Upload> uploads_;
+  uint64_t nextVersion_ = 1;
+
+  ESP_SMART_POINTERS(LightParameterCache)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_LIGHTPARAMETERCACHE_H_
@@ -8,7 +8,8 @@ namespace esp {
 namespace gfx {
 
 bool operator==(const LightInfo& a, const LightInfo& b) {
-  return a.vector == b.vector && a.color == b.color && a.model == b.model;
+  return a.vector == b.vector && a.color == b.color && a.model == b.model &&
+         a.range == b.range;
 }
 
 bool operator!=(const LightInfo& a, const LightInfo& b) {
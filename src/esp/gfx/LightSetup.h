@@ -7,6 +7,7 @@
 
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Color.h>
+#include <Magnum/Math/Constants.h>
 #include <Magnum/Math/Matrix4.h>
 #include <Magnum/Math/Vector3.h>
 
@@ -33,6 +34,10 @@ struct LightInfo {
   Magnum::Vector4 vector;
   Magnum::Color3 color{1};
   LightPositionModel model = LightPositionModel::GLOBAL;
+  // Distance past which a point light has no effect, faded out smoothly
+  // towards it. Infinite by default; a finite range lets a scene with many
+  // lights shade each pixel with the nearby lights only, see LightClusters.
+  float range = Magnum::Constants::inf();
 };
 
 bool operator==(const LightInfo& a, const LightInfo& b);
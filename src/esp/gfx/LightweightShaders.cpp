@@ -0,0 +1,41 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "LightweightShaders.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+Mn::Shaders::Flat3D& LightweightShaders::depthShader() {
+  if (!depthShader_) {
+    depthShader_ = std::make_unique<Mn::Shaders::Flat3D>();
+  }
+  return *depthShader_;
+}
+
+DepthShader& LightweightShaders::linearDepthShader() {
+  if (!linearDepthShader_) {
+    linearDepthShader_ = std::make_unique<DepthShader>();
+  }
+  return *linearDepthShader_;
+}
+
+Mn::Shaders::Flat3D& LightweightShaders::objectIdShader(
+    bool perVertexObjectId) {
+  std::unique_ptr<Mn::Shaders::Flat3D>& shader =
+      perVertexObjectId ? perVertexObjectIdShader_ : objectIdShader_;
+  if (!shader) {
+    Mn::Shaders::Flat3D::Flags flags = Mn::Shaders::Flat3D::Flag::ObjectId;
+    if (perVertexObjectId) {
+      flags |= Mn::Shaders::Flat3D::Flag::InstancedObjectId;
+    }
+    shader = std::make_unique<Mn::Shaders::Flat3D>(flags);
+  }
+  return *shader;
+}
+
+}  // namespace gfx
+}  // namespace esp
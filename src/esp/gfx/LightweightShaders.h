@@ -0,0 +1,74 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_LIGHTWEIGHTSHADERS_H_
+#define ESP_GFX_LIGHTWEIGHTSHADERS_H_
+
+#include <Magnum/Shaders/Flat.h>
+#include <cstdint>
+#include <memory>
+
+#include "esp/core/esp.h"
+#include "esp/gfx/DepthUnprojection.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief The lightweight passes of @ref RenderCamera::draw(), see
+ * @ref Drawable::drawLightweight()
+ */
+enum class LightweightPass : std::uint8_t {
+  /** @ref RenderCamera::Flag::DepthOnly */
+  Depth,
+  /**
+   * @ref RenderCamera::Flag::DepthOnly with
+   * @ref RenderCamera::Flag::LinearDepth
+   */
+  LinearDepth,
+  /** @ref RenderCamera::Flag::ObjectIdOnly */
+  ObjectId
+};
+
+/**
+ * @brief Flat shaders used instead of the drawables' own shaders by the
+ * depth-only and object-id-only passes of @ref RenderCamera::draw()
+ *
+ * The shaders are compiled on first use, so a renderer that never draws such
+ * a pass does not pay for them.
+ */
+class LightweightShaders {
+ public:
+  /**
+   * @brief Shader for @ref RenderCamera::Flag::DepthOnly, the color writes
+   * are masked while it is used
+   */
+  Magnum::Shaders::Flat3D& depthShader();
+
+  /**
+   * @brief Shader for @ref RenderCamera::Flag::LinearDepth, writing the
+   * distance along the view direction of the fragments to the first output
+   */
+  DepthShader& linearDepthShader();
+
+  /**
+   * @brief Shader for @ref RenderCamera::Flag::ObjectIdOnly
+   * @param perVertexObjectId, whether the mesh has an object id attribute,
+   * which is added to the object id uniform
+   */
+  Magnum::Shaders::Flat3D& objectIdShader(bool perVertexObjectId);
+
+ private:
+  std::unique_ptr<Magnum::Shaders::Flat3D> depthShader_;
+  std::unique_ptr<DepthShader> linearDepthShader_;
+  std::unique_ptr<Magnum::Shaders::Flat3D> objectIdShader_;
+  std::unique_ptr<Magnum::Shaders::Flat3D> perVertexObjectIdShader_;
+
+  ESP_SMART_POINTERS(LightweightShaders)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_LIGHTWEIGHTSHADERS_H_
@@ -28,6 +28,12 @@ class MeshVisualizerDrawable : public Drawable {
                                   Magnum::GL::Mesh& mesh,
                                   gfx::DrawableGroup* group);
 
+  /**
+   * @brief The wireframe is drawn over the mesh, so it keeps the order of
+   * the group
+   */
+  bool isOpaque() const override { return false; }
+
  protected:
   /**
    * @brief Draw the object using given camera
@@ -0,0 +1,177 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObjectIdRemapping.h"
+
+#include <algorithm>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/GL/Version.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+
+static void importShaderResources() {
+  CORRADE_RESOURCE_INITIALIZE(ShaderResources)
+}
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+enum TextureUnit : uint8_t {
+  ObjectId = 0,
+  Table = 1,
+};
+}  // namespace
+
+ObjectIdRemapping::ObjectIdRemapping(
+    Cr::Containers::ArrayView<const Mn::UnsignedInt> table,
+    Mn::UnsignedInt unmappedValue)
+    : size_{Mn::UnsignedInt(table.size())}, unmappedValue_{unmappedValue} {
+  // the rows are padded with unmapped values, never read
+  const Mn::Int width =
+      std::max(1, std::min(TextureWidth, Mn::Int(table.size())));
+  const Mn::Int height = std::max(1, (Mn::Int(table.size()) + width - 1) /
+                                         width);
+  Cr::Containers::Array<Mn::UnsignedInt> padded{
+      Cr::Containers::ValueInit, std::size_t(width * height)};
+  std::copy(table.begin(), table.end(), padded.begin());
+
+  texture_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::R32UI, {width, height})
+      .setSubImage(0, {},
+                   Mn::ImageView2D{Mn::PixelFormat::R32UI, {width, height},
+                                   padded});
+}
+
+ObjectIdRemapShader::ObjectIdRemapShader() {
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+#ifdef MAGNUM_TARGET_WEBGL
+  Mn::GL::Version glVersion = Mn::GL::Version::GLES300;
+#else
+  Mn::GL::Version glVersion = Mn::GL::Version::GL330;
+#endif
+
+  Mn::GL::Shader vert{glVersion, Mn::GL::Shader::Type::Vertex};
+  Mn::GL::Shader frag{glVersion, Mn::GL::Shader::Type::Fragment};
+
+  // the same full-screen triangle as the cube map projection
+  vert.addSource(rs.get("cubemap.vert"));
+  frag.addSource(rs.get("objectid-remap.frag"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+
+  attachShaders({vert, frag});
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  setUniform(uniformLocation("ObjectIdTexture"), TextureUnit::ObjectId);
+  setUniform(uniformLocation("TableTexture"), TextureUnit::Table);
+  tableSizeUniform_ = uniformLocation("TableSize");
+  unmappedValueUniform_ = uniformLocation("UnmappedValue");
+}
+
+ObjectIdRemapShader& ObjectIdRemapShader::bindObjectIdTexture(
+    Mn::GL::Texture2D& texture) {
+  texture.bind(TextureUnit::ObjectId);
+  return *this;
+}
+
+ObjectIdRemapShader& ObjectIdRemapShader::setRemapping(
+    ObjectIdRemapping& remapping) {
+  remapping.texture().bind(TextureUnit::Table);
+  setUniform(tableSizeUniform_, remapping.size());
+  setUniform(unmappedValueUniform_, remapping.unmappedValue());
+  return *this;
+}
+
+ObjectIdHistogramShader::ObjectIdHistogramShader() {
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+#ifdef MAGNUM_TARGET_WEBGL
+  Mn::GL::Version glVersion = Mn::GL::Version::GLES300;
+#else
+  Mn::GL::Version glVersion = Mn::GL::Version::GL330;
+#endif
+
+  Mn::GL::Shader vert{glVersion, Mn::GL::Shader::Type::Vertex};
+  Mn::GL::Shader frag{glVersion, Mn::GL::Shader::Type::Fragment};
+
+  vert.addSource(rs.get("objectid-histogram.vert"));
+  frag.addSource(rs.get("objectid-histogram.frag"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+
+  attachShaders({vert, frag});
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  setUniform(uniformLocation("ObjectIdTexture"), TextureUnit::ObjectId);
+  setUniform(uniformLocation("TableTexture"), TextureUnit::Table);
+  remapIdsUniform_ = uniformLocation("RemapIds");
+  tableSizeUniform_ = uniformLocation("TableSize");
+  unmappedValueUniform_ = uniformLocation("UnmappedValue");
+  binCountUniform_ = uniformLocation("BinCount");
+  histogramSizeUniform_ = uniformLocation("HistogramSize");
+  regionOriginUniform_ = uniformLocation("RegionOrigin");
+  regionColumnsUniform_ = uniformLocation("RegionColumns");
+  strideUniform_ = uniformLocation("Stride");
+}
+
+ObjectIdHistogramShader& ObjectIdHistogramShader::bindObjectIdTexture(
+    Mn::GL::Texture2D& texture) {
+  texture.bind(TextureUnit::ObjectId);
+  return *this;
+}
+
+ObjectIdHistogramShader& ObjectIdHistogramShader::setRemapping(
+    ObjectIdRemapping* remapping) {
+  setUniform(remapIdsUniform_, Mn::Int(remapping != nullptr));
+  if (remapping) {
+    remapping->texture().bind(TextureUnit::Table);
+    setUniform(tableSizeUniform_, remapping->size());
+    setUniform(unmappedValueUniform_, remapping->unmappedValue());
+  }
+  return *this;
+}
+
+ObjectIdHistogramShader& ObjectIdHistogramShader::setBins(
+    Mn::UnsignedInt count,
+    const Mn::Vector2i& size) {
+  setUniform(binCountUniform_, count);
+  setUniform(histogramSizeUniform_, size);
+  return *this;
+}
+
+ObjectIdHistogramShader& ObjectIdHistogramShader::setRegion(
+    const Mn::Vector2i& origin,
+    Mn::Int columns,
+    Mn::Int stride) {
+  setUniform(regionOriginUniform_, origin);
+  setUniform(regionColumnsUniform_, columns);
+  setUniform(strideUniform_, stride);
+  return *this;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,155 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_OBJECTIDREMAPPING_H_
+#define ESP_GFX_OBJECTIDREMAPPING_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::ObjectIdRemapping,
+ * @ref esp::gfx::ObjectIdRemapShader, @ref esp::gfx::ObjectIdHistogramShader
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Vector2.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+@brief Lookup table remapping the object ids of a render target on the GPU
+
+Uploads the table to an integer texture, for @ref ObjectIdRemapShader. Object
+ids beyond the end of the table are remapped to @ref unmappedValue(). See
+@ref scene::SemanticScene::semanticIdToCategoryIndex() and
+@ref scene::SemanticScene::semanticIdToInstanceId() for the tables of
+semantic categories and compact instance ids.
+*/
+class ObjectIdRemapping {
+ public:
+  /**
+   * @brief Constructor
+   * @param table         The value of each object id
+   * @param unmappedValue The value of the object ids beyond the table
+   */
+  explicit ObjectIdRemapping(
+      Corrade::Containers::ArrayView<const Magnum::UnsignedInt> table,
+      Magnum::UnsignedInt unmappedValue = 0);
+
+  /** @brief The number of object ids with a value in the table */
+  Magnum::UnsignedInt size() const { return size_; }
+
+  /** @brief The value of the object ids beyond the table */
+  Magnum::UnsignedInt unmappedValue() const { return unmappedValue_; }
+
+  /**
+   * @brief The table texture, wrapped in rows of at most
+   * @ref TextureWidth ids
+   */
+  Magnum::GL::Texture2D& texture() { return texture_; }
+
+  /** @brief Width of the rows of the table texture */
+  static constexpr Magnum::Int TextureWidth = 4096;
+
+ private:
+  Magnum::GL::Texture2D texture_;
+  Magnum::UnsignedInt size_;
+  Magnum::UnsignedInt unmappedValue_;
+
+  ESP_SMART_POINTERS(ObjectIdRemapping)
+};
+
+/**
+@brief Shader remapping an object id texture through an
+@ref ObjectIdRemapping
+
+Renders a full-screen triangle, draw it with a mesh of three vertices and no
+attributes, into an R32UI attachment of the size of the object id texture.
+*/
+class ObjectIdRemapShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  /** @brief Constructor */
+  explicit ObjectIdRemapShader();
+
+  /**
+   * @brief Bind the object id texture to remap
+   * @return Reference to self (for method chaining)
+   */
+  ObjectIdRemapShader& bindObjectIdTexture(Magnum::GL::Texture2D& texture);
+
+  /**
+   * @brief Set the remapping
+   * @return Reference to self (for method chaining)
+   *
+   * Binds its table texture, so it has to be set again if another
+   * remapping was bound since.
+   */
+  ObjectIdRemapShader& setRemapping(ObjectIdRemapping& remapping);
+
+ private:
+  int tableSizeUniform_ = -1, unmappedValueUniform_ = -1;
+};
+
+/**
+@brief Shader counting the pixels of each object id of an object id texture
+
+Draws a point for every counted pixel, at the pixel of its bin, draw it with
+a mesh of @ref Magnum::GL::MeshPrimitive::Points and as many vertices as
+there are pixels counted, without attributes, into an R32F attachment of
+the size of @ref setBins() with additive blending. Object ids outside of
+the bins aren't counted.
+*/
+class ObjectIdHistogramShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  /** @brief Constructor */
+  explicit ObjectIdHistogramShader();
+
+  /**
+   * @brief Bind the object id texture to count
+   * @return Reference to self (for method chaining)
+   */
+  ObjectIdHistogramShader& bindObjectIdTexture(Magnum::GL::Texture2D& texture);
+
+  /**
+   * @brief Set the remapping the object ids are counted through, none if
+   * null
+   * @return Reference to self (for method chaining)
+   *
+   * Binds its table texture, like @ref ObjectIdRemapShader::setRemapping().
+   */
+  ObjectIdHistogramShader& setRemapping(ObjectIdRemapping* remapping);
+
+  /**
+   * @brief Set the number of bins and the size of the attachment holding
+   * them, wrapped in rows of its width
+   * @return Reference to self (for method chaining)
+   */
+  ObjectIdHistogramShader& setBins(Magnum::UnsignedInt count,
+                                   const Magnum::Vector2i& size);
+
+  /**
+   * @brief Set the pixels counted
+   * @return Reference to self (for method chaining)
+   *
+   * The vertices count the pixels from @p origin, @p columns of them per
+   * row, @p stride apart.
+   */
+  ObjectIdHistogramShader& setRegion(const Magnum::Vector2i& origin,
+                                     Magnum::Int columns,
+                                     Magnum::Int stride);
+
+ private:
+  int remapIdsUniform_ = -1, tableSizeUniform_ = -1,
+      unmappedValueUniform_ = -1, binCountUniform_ = -1,
+      histogramSizeUniform_ = -1, regionOriginUniform_ = -1,
+      regionColumnsUniform_ = -1, strideUniform_ = -1;
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_OBJECTIDREMAPPING_H_
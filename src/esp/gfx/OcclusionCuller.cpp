@@ -0,0 +1,220 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "OcclusionCuller.h"
+
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/SampleQuery.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/MeshTools/Compile.h>
+#include <Magnum/Primitives/Cube.h>
+#include <Magnum/SceneGraph/Drawable.h>
+#include <Magnum/Shaders/Flat.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "esp/geo/geo.h"
+#include "esp/gfx/Drawable.h"
+#include "esp/scene/SceneNode.h"
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+//! number of @ref OcclusionCuller::issueQueries() calls after which the
+//! history of drawables that were not queried any more is dropped
+constexpr uint64_t MaxIdleQueryRounds = 64;
+
+}  // namespace
+
+float projectionNearPlane(const Mn::Matrix4& projection) {
+  if (projection[2][3] != 0.0f) {
+    // perspective: [2][2] = (n + f)/(n - f), [3][2] = 2nf/(n - f)
+    return projection[3][2] / (projection[2][2] - 1.0f);
+  }
+  // orthographic: [2][2] = 2/(n - f), [3][2] = (n + f)/(n - f)
+  return (projection[3][2] + 1.0f) / projection[2][2];
+}
+
+struct OcclusionCuller::Impl {
+  Impl() : box_{Mn::MeshTools::compile(Mn::Primitives::cubeSolid())} {}
+
+  struct Entry {
+    Mn::GL::SampleQuery query{Mn::GL::SampleQuery::Target::AnySamplesPassed};
+    // a query was issued and its result not read yet
+    bool pending = false;
+    // result of the most recent finished query
+    bool visible = true;
+    uint64_t lastQueryRound = 0;
+  };
+
+  /**
+   * @brief The world or camera-relative box of a drawable, mapped onto the
+   * [-1, 1] cube
+   * @return false if the drawable has no bounding box
+   */
+  static bool computeBox(
+      const std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                      Mn::Matrix4>& drawableTransform,
+      const Mn::Matrix4& cameraMatrix,
+      Mn::Matrix4& boxTransformation,
+      Mn::Range3D& cameraSpaceBox) {
+    auto& node =
+        static_cast<scene::SceneNode&>(drawableTransform.first.get().object());
+    Mn::Range3D box;
+    Mn::Matrix4 transformation;
+    Cr::Containers::Optional<Mn::Range3D> aabb = node.getAbsoluteAABB();
+    if (aabb) {
+      // static mesh, the box is in world space
+      box = *aabb;
+      transformation = cameraMatrix;
+    } else {
+      box = node.getMeshBB();
+      transformation = drawableTransform.second;
+    }
+    if (box.size() == Mn::Vector3{}) {
+      return false;
+    }
+    boxTransformation = transformation *
+                        Mn::Matrix4::translation(box.center()) *
+                        Mn::Matrix4::scaling(box.size() * 0.5f);
+    cameraSpaceBox = geo::getTransformedBB(box, transformation);
+    return true;
+  }
+
+  size_t cull(std::vector<
+              std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                        Mn::Matrix4>>& drawableTransforms) {
+    auto newEndIter = std::stable_partition(
+        drawableTransforms.begin(), drawableTransforms.end(),
+        [&](const std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                            Mn::Matrix4>& a) {
+          auto* drawable = dynamic_cast<Drawable*>(&a.first.get());
+          if (!drawable) {
+            return true;
+          }
+          auto it = entries_.find(drawable->getDrawableId());
+          if (it == entries_.end()) {
+            return true;
+          }
+          Entry& entry = it->second;
+          // only consume results the GPU already has, never wait for one
+          if (entry.pending && entry.query.resultAvailable()) {
+            entry.visible = entry.query.result<bool>();
+            entry.pending = false;
+          }
+          return entry.visible;
+        });
+    return newEndIter - drawableTransforms.begin();
+  }
+
+  void issueQueries(
+      const std::vector<
+          std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                    Mn::Matrix4>>& drawableTransforms,
+      const Mn::Matrix4& cameraMatrix,
+      const Mn::Matrix4& projectionMatrix) {
+    ++queryRound_;
+    const float znear = projectionNearPlane(projectionMatrix);
+
+    Mn::GL::Renderer::setColorMask(false, false, false, false);
+    Mn::GL::Renderer::setDepthMask(false);
+    // the faces of box-shaped drawables coincide with the faces of their
+    // boxes, which must not be occluded by them
+    Mn::GL::Renderer::setDepthFunction(
+        Mn::GL::Renderer::DepthFunction::LessOrEqual);
+    Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::PolygonOffsetFill);
+    Mn::GL::Renderer::setPolygonOffset(-1.0f, -1.0f);
+    // the camera can be behind some of the faces of a box
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+
+    for (const auto& drawableTransform : drawableTransforms) {
+      auto* drawable = dynamic_cast<Drawable*>(&drawableTransform.first.get());
+      Mn::Matrix4 boxTransformation;
+      Mn::Range3D cameraSpaceBox;
+      if (!drawable || !computeBox(drawableTransform, cameraMatrix,
+                                   boxTransformation, cameraSpaceBox)) {
+        continue;
+      }
+
+      Entry& entry = entries_[drawable->getDrawableId()];
+      entry.lastQueryRound = queryRound_;
+      // the box would be clipped by the near plane and report no samples
+      // even though the drawable is right in front of the camera
+      if (cameraSpaceBox.max().z() >= -znear) {
+        entry.visible = true;
+        continue;
+      }
+      // wait for the previous query of this drawable to finish first
+      if (entry.pending) {
+        continue;
+      }
+
+      entry.query.begin();
+      shader_.setTransformationProjectionMatrix(projectionMatrix *
+                                                boxTransformation);
+      shader_.draw(box_);
+      entry.query.end();
+      entry.pending = true;
+    }
+
+    Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
+    Mn::GL::Renderer::setPolygonOffset(0.0f, 0.0f);
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::PolygonOffsetFill);
+    Mn::GL::Renderer::setDepthFunction(Mn::GL::Renderer::DepthFunction::Less);
+    Mn::GL::Renderer::setDepthMask(true);
+    Mn::GL::Renderer::setColorMask(true, true, true, true);
+
+    // drop the history of drawables that left the view a while ago
+    if (queryRound_ % MaxIdleQueryRounds == 0) {
+      for (auto it = entries_.begin(); it != entries_.end();) {
+        if (queryRound_ - it->second.lastQueryRound >= MaxIdleQueryRounds) {
+          it = entries_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
+  void reset() { entries_.clear(); }
+
+ private:
+  Mn::GL::Mesh box_;
+  Mn::Shaders::Flat3D shader_;
+  std::unordered_map<uint64_t, Entry> entries_;
+  uint64_t queryRound_ = 0;
+};
+
+OcclusionCuller::OcclusionCuller()
+    : pimpl_(spimpl::make_unique_impl<Impl>()) {}
+
+size_t OcclusionCuller::cull(
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  return pimpl_->cull(drawableTransforms);
+}
+
+void OcclusionCuller::issueQueries(
+    const std::vector<
+        std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                  Mn::Matrix4>>& drawableTransforms,
+    const Mn::Matrix4& cameraMatrix,
+    const Mn::Matrix4& projectionMatrix) {
+  pimpl_->issueQueries(drawableTransforms, cameraMatrix, projectionMatrix);
+}
+
+void OcclusionCuller::reset() {
+  pimpl_->reset();
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,89 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_OCCLUSIONCULLER_H_
+#define ESP_GFX_OCCLUSIONCULLER_H_
+
+#include <functional>
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "magnum.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Distance of the near plane of a perspective or orthographic
+ * projection
+ */
+float projectionNearPlane(const Magnum::Matrix4& projection);
+
+/**
+ * @brief Temporal occlusion culling with hardware occlusion queries
+ *
+ * After the visible drawables of a view are drawn, @ref issueQueries() draws
+ * the bounding box of each of them against the resulting depth buffer inside
+ * an occlusion query, with color and depth writes disabled. When the same view
+ * is drawn again, @ref cull() removes the drawables whose box passed no
+ * samples, using only query results the GPU already made available, so it
+ * never stalls the pipeline. Culled drawables keep being queried, which
+ * brings them back one frame after they become visible again.
+ *
+ * The visibility history is per viewpoint, so one instance has to be used for
+ * one sensor (or camera) only.
+ */
+class OcclusionCuller {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * Expects a current OpenGL context.
+   */
+  OcclusionCuller();
+
+  /**
+   * @brief Partition out the drawables that were occluded when last queried
+   * @param drawableTransforms, a vector of pairs of Drawable3D object and its
+   * camera-relative transformation
+   * @return the number of drawables that are not culled; these are moved to
+   * the front of @p drawableTransforms, the culled ones follow them in their
+   * original order
+   *
+   * Drawables without a bounding box or without a finished query are kept.
+   */
+  size_t cull(std::vector<
+              std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>& drawableTransforms);
+
+  /**
+   * @brief Query the visibility of the bounding boxes of drawables
+   * @param drawableTransforms, drawables and their camera-relative
+   * transformations; typically all drawables that passed frustum culling
+   * @param cameraMatrix, the camera matrix the transformations are relative to
+   * @param projectionMatrix, the projection matrix of the camera
+   *
+   * Has to be called with the framebuffer the view was drawn into still
+   * bound, after the drawables that passed @ref cull() were drawn. Boxes that
+   * cross the near plane are always considered visible and not queried.
+   */
+  void issueQueries(
+      const std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms,
+      const Magnum::Matrix4& cameraMatrix,
+      const Magnum::Matrix4& projectionMatrix);
+
+  /**
+   * @brief Forget all visibility history, e.g. after the view jumped
+   */
+  void reset();
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(OcclusionCuller)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_OCCLUSIONCULLER_H_
@@ -5,6 +5,7 @@
 #include "PTexMeshDrawable.h"
 
 #include "esp/assets/PTexMeshData.h"
+#include "esp/core/StartupProfile.h"
 #include "esp/gfx/PTexMeshShader.h"
 
 namespace esp {
@@ -19,6 +20,8 @@ PTexMeshDrawable::PTexMeshDrawable(scene::SceneNode& node,
                                    ShaderManager& shaderManager,
                                    DrawableGroup* group /* = nullptr */)
     : Drawable{node, ptexMeshData.getRenderingBuffer(submeshID)->mesh, group},
+      ptexMeshData_(ptexMeshData),
+      submeshID_(submeshID),
       atlasTexture_(ptexMeshData.getRenderingBuffer(submeshID)->atlasTexture),
 #ifndef CORRADE_TARGET_APPLE
       adjFacesBufferTexture_(
@@ -35,26 +38,26 @@ PTexMeshDrawable::PTexMeshDrawable(scene::SceneNode& node,
           SHADER_KEY);
 
   if (!shaderResource) {
-    shaderManager.set<Magnum::GL::AbstractShaderProgram>(shaderResource.key(),
-                                                         new PTexMeshShader{});
+    ESP_STARTUP_SPAN("gfx::PTexMeshDrawable::compileShader");
+    Magnum::Resource<ProgramBinaryCache> binaryCache =
+        shaderManager.get<ProgramBinaryCache>(ProgramBinaryCache::Key);
+    shaderManager.set<Magnum::GL::AbstractShaderProgram>(
+        shaderResource.key(),
+        new PTexMeshShader{binaryCache ? &*binaryCache : nullptr});
   }
   shader_ = &(*shaderResource);
 }
 
 void PTexMeshDrawable::draw(const Magnum::Matrix4& transformationMatrix,
                             Magnum::SceneGraph::Camera3D& camera) {
+  ptexMeshData_.uploadAtlas(submeshID_);
   (*shader_)
       .setExposure(exposure_)
       .setGamma(gamma_)
       .setSaturation(saturation_)
       .setAtlasTextureSize(atlasTexture_, tileSize_)
       .bindAtlasTexture(atlasTexture_)
-      // e.g., semantic mesh has its own per vertex annotation, which has been
-      // uploaded to GPU so simply pass 0 to the uniform "objectId" in the
-      // fragment shader
-      .setObjectId(static_cast<RenderCamera&>(camera).useDrawableIds()
-                       ? drawableId_
-                       : node_.getSemanticId())
+      .setObjectId(getObjectId(camera))
 #ifndef CORRADE_TARGET_APPLE
       .bindAdjFacesBufferTexture(adjFacesBufferTexture_)
 #endif
@@ -33,6 +33,9 @@ class PTexMeshDrawable : public Drawable {
   virtual void draw(const Magnum::Matrix4& transformationMatrix,
                     Magnum::SceneGraph::Camera3D& camera) override;
 
+  // uploads the atlas on the first draw
+  assets::PTexMeshData& ptexMeshData_;
+  int submeshID_;
   Magnum::GL::Texture2D& atlasTexture_;
 #ifndef CORRADE_TARGET_APPLE
   Magnum::GL::BufferTexture& adjFacesBufferTexture_;
@@ -14,6 +14,7 @@
 #include "PTexMeshShader.h"
 #include "esp/assets/PTexMeshData.h"
 #include "esp/core/esp.h"
+#include "esp/gfx/ProgramBinaryCache.h"
 #include "esp/io/io.h"
 
 // This is to import the "resources" at runtime. // When the resource is
@@ -37,7 +38,7 @@ enum TextureBindingPointIndex : uint8_t {
 };
 }  // namespace
 
-PTexMeshShader::PTexMeshShader() {
+PTexMeshShader::PTexMeshShader(const ProgramBinaryCache* binaryCache) {
   MAGNUM_ASSERT_GL_VERSION_SUPPORTED(Mn::GL::Version::GL410);
 
   if (!Corrade::Utility::Resource::hasGroup("default-shaders")) {
@@ -58,11 +59,22 @@ PTexMeshShader::PTexMeshShader() {
 #endif
   frag.addSource(rs.get("ptex-default-gl410.frag"));
 
-  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, geom, frag}));
-
-  attachShaders({vert, geom, frag});
-
-  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+  const std::string binaryKey =
+      binaryCache ? binaryCache->key({vert, geom, frag}) : std::string{};
+  if (!binaryCache || !binaryCache->load(*this, binaryKey)) {
+    CORRADE_INTERNAL_ASSERT_OUTPUT(
+        Mn::GL::Shader::compile({vert, geom, frag}));
+
+    attachShaders({vert, geom, frag});
+
+    if (binaryCache) {
+      binaryCache->prepareLink(*this);
+    }
+    CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    if (binaryCache) {
+      binaryCache->store(*this, binaryKey);
+    }
+  }
 
   // set texture binding points in the shader;
   // see ptex fragment shader code for details
@@ -22,6 +22,8 @@ class PTexMeshData;
 
 namespace gfx {
 
+class ProgramBinaryCache;
+
 class PTexMeshShader : public Magnum::GL::AbstractShaderProgram {
  public:
   //! @brief vertex positions
@@ -29,8 +31,10 @@ class PTexMeshShader : public Magnum::GL::AbstractShaderProgram {
 
   /**
    * @brief Constructor
+   * @param binaryCache, cache the linked program is loaded from or stored to,
+   * see @ref ProgramBinaryCache, nullptr for none
    */
-  explicit PTexMeshShader();
+  explicit PTexMeshShader(const ProgramBinaryCache* binaryCache = nullptr);
 
   // ======== texture binding ========
   /**
@@ -8,6 +8,9 @@
 #include <Corrade/Utility/FormatStl.h>
 #include <Magnum/GL/Renderer.h>
 
+#include "esp/core/StartupProfile.h"
+#include "esp/gfx/LightClusters.h"
+
 namespace Mn = Magnum;
 
 namespace esp {
@@ -24,7 +27,13 @@ PbrDrawable::PbrDrawable(scene::SceneNode& node,
       shaderManager_{shaderManager},
       lightSetup_{shaderManager.get<LightSetup>(lightSetupKey)},
       materialData_{
-          shaderManager.get<MaterialData, PbrMaterialData>(materialDataKey)} {
+          shaderManager.get<MaterialData, PbrMaterialData>(materialDataKey)},
+      textureStreamer_{
+          shaderManager.get<TextureStreamer>(TextureStreamer::Key)},
+      materialBuffer_{
+          shaderManager.get<PbrMaterialBuffer>(PbrMaterialBuffer::Key)},
+      imageBasedLighting_{shaderManager.get<PbrImageBasedLighting>(
+          PbrImageBasedLighting::Key)} {
   if (materialData_->metallicTexture && materialData_->roughnessTexture) {
     CORRADE_ASSERT(
         materialData_->metallicTexture == materialData_->roughnessTexture,
@@ -33,7 +42,10 @@ PbrDrawable::PbrDrawable(scene::SceneNode& node,
         "2.0 Spec.", );
   }
 
-  flags_ = PbrShader::Flag::ObjectId;
+  // the material is bound from a buffer shared by all PBR drawables, see
+  // PbrMaterialBuffer
+  flags_ = PbrShader::Flag::ObjectId | PbrShader::Flag::MaterialBuffer;
+  meshObjectIds_ = bool(meshAttributeFlags & gfx::Drawable::Flag::HasObjectId);
   if (materialData_->textureMatrix != Mn::Matrix3{}) {
     flags_ |= PbrShader::Flag::TextureTransformation;
   }
@@ -80,9 +92,7 @@ void PbrDrawable::setLightSetup(const Mn::ResourceKey& lightSetupKey) {
 
 void PbrDrawable::draw(const Mn::Matrix4& transformationMatrix,
                        Mn::SceneGraph::Camera3D& camera) {
-  updateShader()
-      .updateShaderLightParameters()
-      .updateShaderLightDirectionParameters(transformationMatrix, camera);
+  updateShader().updateShaderLightParameters(transformationMatrix, camera);
 
   // Assume that in a model, double-sided meshes are significantly less than
   // single-sided meshes.
@@ -97,20 +107,31 @@ void PbrDrawable::draw(const Mn::Matrix4& transformationMatrix,
   }
 
   (*shader_)
-      // e.g., semantic mesh has its own per vertex annotation, which has been
-      // uploaded to GPU so simply pass 0 to the uniform "objectId" in the
-      // fragment shader
-      .setObjectId(
-          static_cast<RenderCamera&>(camera).useDrawableIds()
-              ? drawableId_
-              : (materialData_->perVertexObjectId ? 0 : node_.getSemanticId()))
+      .setObjectId(getObjectId(camera))
       .setTransformationMatrix(transformationMatrix)  // modelview matrix
       .setProjectionMatrix(camera.projectionMatrix())
-      .setNormalMatrix(transformationMatrix.normalMatrix())
-      .setBaseColor(materialData_->baseColor)
-      .setRoughness(materialData_->roughness)
-      .setMetallic(materialData_->metallic)
-      .setEmissiveColor(materialData_->emissiveColor);
+      .setNormalMatrix(transformationMatrix.normalMatrix());
+
+  // the colors, factors and texture matrix of the material
+  if (!materialBuffer_) {
+    shaderManager_.set<PbrMaterialBuffer>(
+        PbrMaterialBuffer::Key, new PbrMaterialBuffer{},
+        Mn::ResourceDataState::Final, Mn::ResourcePolicy::Resident);
+  }
+  if (slotMaterial_ != &*materialData_) {
+    slotMaterial_ = &*materialData_;
+    materialSlot_ = materialBuffer_->slot(*materialData_);
+  }
+  materialBuffer_->bind(materialSlot_, *shader_);
+
+  if (textureStreamer_) {
+    requestTextures(*textureStreamer_, transformationMatrix, camera,
+                    {materialData_->baseColorTexture,
+                     materialData_->roughnessTexture,
+                     materialData_->metallicTexture,
+                     materialData_->normalTexture,
+                     materialData_->emissiveTexture});
+  }
 
   if ((flags_ & PbrShader::Flag::BaseColorTexture) &&
       materialData_->baseColorTexture) {
@@ -140,12 +161,33 @@ void PbrDrawable::draw(const Mn::Matrix4& transformationMatrix,
     shader_->bindEmissiveTexture(*materialData_->emissiveTexture);
   }
 
-  if ((flags_ & PbrShader::Flag::TextureTransformation) &&
-      (materialData_->textureMatrix != Mn::Matrix3{})) {
-    shader_->setTextureMatrix(materialData_->textureMatrix);
+  if (shader_->flags() & PbrShader::Flag::ImageBasedLighting) {
+    imageBasedLighting_->bindTextures(*shader_);
+    // the maps are in world space
+    shader_->setCameraRotation(camera.cameraMatrix().inverted().rotation());
   }
 
-  shader_->draw(mesh_);
+
+  drawMesh(*shader_, transformationMatrix, camera);
+}
+
+void PbrDrawable::drawLightweight(const Mn::Matrix4& transformationMatrix,
+                                  Mn::SceneGraph::Camera3D& camera,
+                                  LightweightShaders& shaders,
+                                  LightweightPass pass) {
+  // back faces of double-sided meshes occlude as well, see draw()
+  if ((flags_ & PbrShader::Flag::DoubleSided) && glIsEnabled(GL_CULL_FACE)) {
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+  }
+  Drawable::drawLightweight(transformationMatrix, camera, shaders, pass);
+}
+
+DrawStateKey PbrDrawable::getDrawStateKey() const {
+  DrawStateKey key;
+  key.shader = std::hash<Mn::ResourceKey>{}(shader_.key());
+  key.material = std::hash<Mn::ResourceKey>{}(materialData_.key());
+  key.mesh = mesh_.id();
+  return key;
 }
 
 Mn::ResourceKey PbrDrawable::getShaderKey(Mn::UnsignedInt lightCount,
@@ -156,60 +198,70 @@ Mn::ResourceKey PbrDrawable::getShaderKey(Mn::UnsignedInt lightCount,
 }
 
 PbrDrawable& PbrDrawable::updateShader() {
+  // a clustered shader reads any number of lights from textures
   unsigned int lightCount = lightSetup_->size();
+  PbrShader::Flags flags = flags_;
+  if (LightClusters::isClustered(*lightSetup_)) {
+    lightCount = 1;
+    flags |= PbrShader::Flag::ClusteredLights;
+  }
+  // the environment lights the lit shaders only
+  if (imageBasedLighting_ && lightCount) {
+    flags |= PbrShader::Flag::ImageBasedLighting;
+  }
   if (!shader_ || shader_->lightCount() != lightCount ||
-      shader_->flags() != flags_) {
+      shader_->flags() != flags) {
     // if the number of lights or flags have changed, we need to fetch a
     // compatible shader
     shader_ = shaderManager_.get<Mn::GL::AbstractShaderProgram, PbrShader>(
-        getShaderKey(lightCount, flags_));
+        getShaderKey(lightCount, flags));
 
     // if no shader with desired number of lights and flags exists, create one
     if (!shader_) {
+      ESP_STARTUP_SPAN("gfx::PbrDrawable::compileShader");
+      Mn::Resource<ProgramBinaryCache> binaryCache =
+          shaderManager_.get<ProgramBinaryCache>(ProgramBinaryCache::Key);
       shaderManager_.set<Mn::GL::AbstractShaderProgram>(
-          shader_.key(), new PbrShader{flags_, lightCount},
+          shader_.key(),
+          new PbrShader{flags, lightCount,
+                        binaryCache ? &*binaryCache : nullptr},
           Mn::ResourceDataState::Final, Mn::ResourcePolicy::ReferenceCounted);
     }
 
     CORRADE_INTERNAL_ASSERT(shader_ && shader_->lightCount() == lightCount &&
-                            shader_->flags() == flags_);
+                            shader_->flags() == flags);
   }
 
   return *this;
 }
 
 // update every light's color, intensity, range etc.
-PbrDrawable& PbrDrawable::updateShaderLightParameters() {
-  // light range has been initialized to Mn::Constants::inf()
-  // in the PbrShader's constructor.
-  // No need to reset it at this point.
-  std::vector<Mn::Color3> colors;
-  colors.reserve(lightSetup_->size());
-  for (unsigned int iLight = 0; iLight < lightSetup_->size(); ++iLight) {
-    // Note: the light color MUST take the intensity into account
-    colors.emplace_back((*lightSetup_)[iLight].color);
-  }
-
-  shader_->setLightColors(colors);
-  return *this;
-}
-
-// update light direction (or position) in *camera* space to the shader
-PbrDrawable& PbrDrawable::updateShaderLightDirectionParameters(
+// update light colors and directions (or positions) in *camera* space
+PbrDrawable& PbrDrawable::updateShaderLightParameters(
     const Magnum::Matrix4& transformationMatrix,
     Magnum::SceneGraph::Camera3D& camera) {
-  std::vector<Mn::Vector4> lightPositions;
-  lightPositions.reserve(lightSetup_->size());
+  LightParameterCache& cache =
+      static_cast<RenderCamera&>(camera).lightParameterCache();
+  const LightParameters& lights =
+      cache.get(*lightSetup_, camera.cameraMatrix(), transformationMatrix);
 
-  const Mn::Matrix4 cameraMatrix = camera.cameraMatrix();
-  for (unsigned int iLight = 0; iLight < lightSetup_->size(); ++iLight) {
-    const auto& lightInfo = (*lightSetup_)[iLight];
-    lightPositions.emplace_back(Mn::Vector4(getLightPositionRelativeToCamera(
-        lightInfo, transformationMatrix, cameraMatrix)));
+  if (shader_->flags() & PbrShader::Flag::ClusteredLights) {
+    // the clusters are binned once per camera and light parameters, the
+    // textures are bound for every draw as other drawables use their units
+    LightClusters& clusters =
+        static_cast<RenderCamera&>(camera).lightClusters(*lightSetup_);
+    clusters.update(lights, camera.projectionMatrix());
+    clusters.bindTextures(*shader_);
+    if (cache.needsUpload(&*shader_, lights)) {
+      clusters.setUniforms(*shader_);
+    }
+  } else if (cache.needsUpload(&*shader_, lights)) {
+    // Note: the light color MUST take the intensity into account
+    shader_->setLightColors(lights.colors);
+    shader_->setLightVectors(lights.positions);
+    shader_->setLightRanges(lights.ranges);
   }
 
-  shader_->setLightVectors(lightPositions);
-
   return *this;
 }
 
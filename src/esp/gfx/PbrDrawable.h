@@ -34,6 +34,15 @@ class PbrDrawable : public Drawable {
    */
   void setLightSetup(const Magnum::ResourceKey& lightSetupkey) override;
 
+  void prewarmShader() override { updateShader(); }
+
+  DrawStateKey getDrawStateKey() const override;
+
+  void drawLightweight(const Magnum::Matrix4& transformationMatrix,
+                       Magnum::SceneGraph::Camera3D& camera,
+                       LightweightShaders& shaders,
+                       LightweightPass pass) override;
+
   static constexpr const char* SHADER_KEY_TEMPLATE = "PBR-lights={}-flags={}";
 
  protected:
@@ -47,6 +56,10 @@ class PbrDrawable : public Drawable {
   virtual void draw(const Magnum::Matrix4& transformationMatrix,
                     Magnum::SceneGraph::Camera3D& camera) override;
 
+  bool hasPerVertexObjectId() const override {
+    return materialData_->perVertexObjectId || meshObjectIds_;
+  }
+
   /**
    *  @brief Update the shader so it can correcly handle the current material,
    *         light setup
@@ -55,20 +68,18 @@ class PbrDrawable : public Drawable {
   PbrDrawable& updateShader();
 
   /**
-   *  @brief Update every light's color, intensity, range etc.
-   *  @return Reference to self (for method chaining)
-   */
-  PbrDrawable& updateShaderLightParameters();
-
-  /**
-   *  @brief Update light direction (or position) in *camera* space to the
-   * shader
+   *  @brief Update every light's color, intensity, and direction (or
+   *         position) in *camera* space to the shader
    *  @param transformationMatrix, describes a tansformation from object (model)
    *         space to camera space
    *  @param camera, the camera, which views and renders the world
    *  @return Reference to self (for method chaining)
+   *
+   *  The light parameters are evaluated once per frame by the camera's
+   *  @ref LightParameterCache and only uploaded if the shader does not have
+   *  them already.
    */
-  PbrDrawable& updateShaderLightDirectionParameters(
+  PbrDrawable& updateShaderLightParameters(
       const Magnum::Matrix4& transformationMatrix,
       Magnum::SceneGraph::Camera3D& camera);
 
@@ -86,6 +97,15 @@ class PbrDrawable : public Drawable {
   Magnum::Resource<Magnum::GL::AbstractShaderProgram, PbrShader> shader_;
   Magnum::Resource<MaterialData, PbrMaterialData> materialData_;
   Magnum::Resource<LightSetup> lightSetup_;
+  Magnum::Resource<TextureStreamer> textureStreamer_;
+  Magnum::Resource<PbrMaterialBuffer> materialBuffer_;
+  Magnum::Resource<PbrImageBasedLighting> imageBasedLighting_;
+  // the slot of materialData_ in materialBuffer_, looked up again if the
+  // material resource changed
+  const PbrMaterialData* slotMaterial_ = nullptr;
+  unsigned int materialSlot_ = 0;
+  // the mesh has an object id attribute, drawn by the object id shaders
+  bool meshObjectIds_;
 };
 
 }  // namespace gfx
@@ -0,0 +1,272 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PbrImageBasedLighting.h"
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Image.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Packing.h>
+#include <Magnum/PixelFormat.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "esp/core/MappedFile.h"
+#include "esp/gfx/CubeMap.h"
+#include "esp/gfx/PbrPrecomputedMapShader.h"
+#include "esp/gfx/PbrShader.h"
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 'i', 'b', 'l', '\0', '\0'};
+constexpr std::uint32_t Version = 1;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::int32_t irradianceMapSize;
+  std::int32_t prefilteredMapSize;
+  std::int32_t prefilteredMapLevels;
+  std::int32_t brdfLookupTableSize;
+};
+
+Mn::GL::CubeMapCoordinate faceCoordinate(const int face) {
+  return Mn::GL::CubeMapCoordinate(
+      int(Mn::GL::CubeMapCoordinate::PositiveX) + face);
+}
+
+// the size of the lookup table in a file, after the faces
+constexpr std::size_t LookupTableBytes =
+    std::size_t{4} * PbrImageBasedLighting::BrdfLookupTableSize *
+    PbrImageBasedLighting::BrdfLookupTableSize;
+
+// calls visit(texture, face, level, size) for every face of every level of
+// the cube maps, in the order of the file
+template <class Visit>
+void forEachFace(PbrImageBasedLighting& lighting, Visit&& visit) {
+  for (int face = 0; face != 6; ++face) {
+    visit(lighting.irradianceMap(), face, 0,
+          int(PbrImageBasedLighting::IrradianceMapSize));
+  }
+  for (int level = 0; level != PbrImageBasedLighting::PrefilteredMapLevels;
+       ++level) {
+    for (int face = 0; face != 6; ++face) {
+      visit(lighting.prefilteredMap(), face, level,
+            PbrImageBasedLighting::PrefilteredMapSize >> level);
+    }
+  }
+}
+
+// the bytes of a face of RGBA16F texels
+std::size_t faceBytes(const int size) {
+  return std::size_t{8} * size * size;
+}
+
+// draws the full-screen triangle with shader into every face of level of
+// texture
+void drawFaces(PbrPrecomputedMapShader& shader,
+               Mn::GL::Mesh& mesh,
+               Mn::GL::CubeMapTexture& texture,
+               const int level,
+               const int size) {
+  for (int face = 0; face != 6; ++face) {
+    Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{size}}};
+    framebuffer
+        .attachCubeMapTexture(Mn::GL::Framebuffer::ColorAttachment{0},
+                              texture, faceCoordinate(face), level)
+        .bind();
+    shader.setFace(face).draw(mesh);
+  }
+}
+
+}  // namespace
+
+PbrImageBasedLighting::PbrImageBasedLighting() {
+  irradianceMap_.setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setMinificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setStorage(1, Mn::GL::TextureFormat::RGBA16F,
+                  Mn::Vector2i{IrradianceMapSize});
+  prefilteredMap_.setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setMinificationFilter(Mn::GL::SamplerFilter::Linear,
+                             Mn::GL::SamplerMipmap::Linear)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setStorage(PrefilteredMapLevels, Mn::GL::TextureFormat::RGBA16F,
+                  Mn::Vector2i{PrefilteredMapSize});
+  brdfLookupTable_.setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setMinificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setStorage(1, Mn::GL::TextureFormat::RG16F,
+                  Mn::Vector2i{BrdfLookupTableSize});
+}
+
+PbrImageBasedLighting::PbrImageBasedLighting(CubeMap& environment)
+    : PbrImageBasedLighting{} {
+  CORRADE_ASSERT(environment.getFlags() & CubeMap::Flag::ColorTexture,
+                 "PbrImageBasedLighting::PbrImageBasedLighting(): the "
+                 "environment has no color texture", );
+
+  Mn::GL::Mesh mesh;
+  mesh.setCount(3);
+  Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::DepthTest);
+  Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+#ifndef MAGNUM_TARGET_GLES
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::SeamlessCubeMapTexture);
+#endif
+
+  // the environment with all its mip levels, which the samples of the
+  // convolutions are read from
+  const int size = environment.getCubeMapSize();
+  Mn::GL::CubeMapTexture environmentMap;
+  environmentMap.setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setMinificationFilter(Mn::GL::SamplerFilter::Linear,
+                             Mn::GL::SamplerMipmap::Linear)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Linear)
+      .setStorage(Mn::Math::log2(Mn::UnsignedInt(size)) + 1,
+                  Mn::GL::TextureFormat::RGBA16F, Mn::Vector2i{size});
+  PbrPrecomputedMapShader copyShader{
+      PbrPrecomputedMapShader::Type::EnvironmentCopy};
+  copyShader.bindEnvironmentMap(
+      environment.getTexture(CubeMap::TextureType::Color));
+  drawFaces(copyShader, mesh, environmentMap, 0, size);
+  environmentMap.generateMipmap();
+
+  PbrPrecomputedMapShader irradianceShader{
+      PbrPrecomputedMapShader::Type::IrradianceMap};
+  irradianceShader.bindEnvironmentMap(environmentMap);
+  drawFaces(irradianceShader, mesh, irradianceMap_, 0, IrradianceMapSize);
+
+  PbrPrecomputedMapShader prefilterShader{
+      PbrPrecomputedMapShader::Type::PrefilteredMap};
+  prefilterShader.bindEnvironmentMap(environmentMap);
+  for (int level = 0; level != PrefilteredMapLevels; ++level) {
+    prefilterShader.setRoughness(float(level) / (PrefilteredMapLevels - 1));
+    drawFaces(prefilterShader, mesh, prefilteredMap_, level,
+              PrefilteredMapSize >> level);
+  }
+
+  PbrPrecomputedMapShader lookupTableShader{
+      PbrPrecomputedMapShader::Type::BrdfLookupTable};
+  Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{BrdfLookupTableSize}}};
+  framebuffer
+      .attachTexture(Mn::GL::Framebuffer::ColorAttachment{0}, brdfLookupTable_,
+                     0)
+      .bind();
+  lookupTableShader.draw(mesh);
+
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::DepthTest);
+}
+
+PbrImageBasedLighting::uptr PbrImageBasedLighting::load(
+    const std::string& filename) {
+  Cr::Containers::Array<char> file = core::mapFile(filename);
+  if (file.size() < sizeof(FileHeader)) {
+    return nullptr;
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version ||
+      header.irradianceMapSize != IrradianceMapSize ||
+      header.prefilteredMapSize != PrefilteredMapSize ||
+      header.prefilteredMapLevels != PrefilteredMapLevels ||
+      header.brdfLookupTableSize != BrdfLookupTableSize) {
+    return nullptr;
+  }
+  std::size_t expectedSize = sizeof(FileHeader) + LookupTableBytes;
+  uptr lighting{new PbrImageBasedLighting{}};
+  forEachFace(*lighting, [&](Mn::GL::CubeMapTexture&, int, int, int size) {
+    expectedSize += faceBytes(size);
+  });
+  if (file.size() != expectedSize) {
+    return nullptr;
+  }
+
+  std::size_t offset = sizeof(FileHeader);
+  forEachFace(*lighting, [&](Mn::GL::CubeMapTexture& texture, int face,
+                             int level, int size) {
+    texture.setSubImage(
+        faceCoordinate(face), level, {},
+        Mn::ImageView2D{Mn::PixelFormat::RGBA16F, Mn::Vector2i{size},
+                        file.slice(offset, offset + faceBytes(size))});
+    offset += faceBytes(size);
+  });
+  lighting->brdfLookupTable_.setSubImage(
+      0, {},
+      Mn::ImageView2D{Mn::PixelFormat::RG16F, Mn::Vector2i{BrdfLookupTableSize},
+                      file.slice(offset, offset + LookupTableBytes)});
+  return lighting;
+}
+
+bool PbrImageBasedLighting::store(const std::string& filename) {
+  FileHeader header;
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.irradianceMapSize = IrradianceMapSize;
+  header.prefilteredMapSize = PrefilteredMapSize;
+  header.prefilteredMapLevels = PrefilteredMapLevels;
+  header.brdfLookupTableSize = BrdfLookupTableSize;
+  std::vector<char> data(reinterpret_cast<const char*>(&header),
+                         reinterpret_cast<const char*>(&header + 1));
+
+  // read through framebuffers, which OpenGL ES can read from too
+  const auto read = [&](Mn::GL::Framebuffer& framebuffer, int size,
+                        Mn::PixelFormat format) {
+#ifndef MAGNUM_TARGET_GLES
+    Mn::Image2D image =
+        framebuffer.read({{}, Mn::Vector2i{size}}, Mn::Image2D{format});
+    data.insert(data.end(), image.data().begin(), image.data().end());
+#else
+    // OpenGL ES and WebGL only guarantee reads of float framebuffers as RGBA
+    // floats, which are packed to the half floats of the file here
+    Mn::Image2D image = framebuffer.read(
+        {{}, Mn::Vector2i{size}}, Mn::Image2D{Mn::PixelFormat::RGBA32F});
+    const std::size_t channels =
+        Mn::pixelSize(format) / sizeof(Mn::UnsignedShort);
+    for (const auto row : image.pixels<Mn::Vector4>()) {
+      for (const Mn::Vector4& pixel : row) {
+        const Mn::Vector4us halves = Mn::Math::packHalf(pixel);
+        data.insert(data.end(), reinterpret_cast<const char*>(halves.data()),
+                    reinterpret_cast<const char*>(halves.data() + channels));
+      }
+    }
+#endif
+  };
+  forEachFace(*this, [&](Mn::GL::CubeMapTexture& texture, int face, int level,
+                         int size) {
+    Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{size}}};
+    framebuffer.attachCubeMapTexture(Mn::GL::Framebuffer::ColorAttachment{0},
+                                     texture, faceCoordinate(face), level);
+    read(framebuffer, size, Mn::PixelFormat::RGBA16F);
+  });
+  Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{BrdfLookupTableSize}}};
+  framebuffer.attachTexture(Mn::GL::Framebuffer::ColorAttachment{0},
+                            brdfLookupTable_, 0);
+  read(framebuffer, BrdfLookupTableSize, Mn::PixelFormat::RG16F);
+
+  return core::writeFileAtomically(filename, {data.data(), data.size()});
+}
+
+void PbrImageBasedLighting::bindTextures(PbrShader& shader) {
+  shader.bindImageBasedLightingTextures(irradianceMap_, prefilteredMap_,
+                                        brdfLookupTable_);
+}
+
+}  // namespace gfx
+}  // namespace esp
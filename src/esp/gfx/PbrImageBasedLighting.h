@@ -0,0 +1,112 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_PBRIMAGEBASEDLIGHTING_H_
+#define ESP_GFX_PBRIMAGEBASEDLIGHTING_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::PbrImageBasedLighting
+ */
+
+#include <Magnum/GL/CubeMapTexture.h>
+#include <Magnum/GL/Texture.h>
+#include <string>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+class CubeMap;
+class PbrShader;
+
+/**
+ * @brief Precomputed image based lighting of an environment for
+ * @ref PbrShader::Flag::ImageBasedLighting
+ *
+ * Holds the three maps of the split sum approximation: the irradiance cube
+ * map for the diffuse reflection, the cube map prefiltered for increasing
+ * roughness along its mip levels for the specular one and the lookup table
+ * of the scale and bias of its Fresnel term. They are computed once on the
+ * GPU by @ref PbrPrecomputedMapShader from an environment, e.g. a stage
+ * captured into a @ref CubeMap by a @ref CubeMapCamera, so a fragment reads
+ * its lighting from them instead of integrating the environment.
+ *
+ * Computing the maps takes long compared to loading them, @ref store()
+ * writes them to a file which @ref load() maps in later processes. The maps
+ * are in the cube map coordinates of @ref CubeMapCamera, i.e. a world
+ * direction (x, y, z) is looked up at (-x, y, -z).
+ *
+ * Drawables find it in the @ref ShaderManager under @ref Key.
+ */
+class PbrImageBasedLighting {
+ public:
+  /** @brief Key in the @ref ShaderManager */
+  static constexpr const char* Key = "pbr-image-based-lighting";
+
+  enum : int {
+    IrradianceMapSize = 32,
+    PrefilteredMapSize = 128,
+    //! from the mirror reflection at level 0 to a roughness of 1
+    PrefilteredMapLevels = 5,
+    BrdfLookupTableSize = 256,
+  };
+
+  /**
+   * @brief Compute the maps of the color texture of @p environment
+   *
+   * Expects a current OpenGL context and @p environment to have a
+   * @ref CubeMap::Flag::ColorTexture. Changes the bound framebuffer and the
+   * viewport.
+   */
+  explicit PbrImageBasedLighting(CubeMap& environment);
+
+  /**
+   * @brief Load the maps from a file written by @ref store()
+   * @return nullptr if the file is missing or was written with other sizes
+   * or by another version
+   *
+   * Expects a current OpenGL context.
+   */
+  static uptr load(const std::string& filename);
+
+  /**
+   * @brief Store the maps to @p filename, atomically
+   * @return false if the file can't be written
+   */
+  bool store(const std::string& filename);
+
+  /** @brief The diffuse irradiance cube map */
+  Magnum::GL::CubeMapTexture& irradianceMap() { return irradianceMap_; }
+
+  /** @brief The specular cube map, prefiltered along the mip levels */
+  Magnum::GL::CubeMapTexture& prefilteredMap() { return prefilteredMap_; }
+
+  /** @brief The BRDF lookup table */
+  Magnum::GL::Texture2D& brdfLookupTable() { return brdfLookupTable_; }
+
+  /**
+   * @brief Bind the maps for @p shader, which has to be created with
+   * @ref PbrShader::Flag::ImageBasedLighting
+   *
+   * The texture units are shared by all shaders, so this has to be called
+   * before every draw.
+   */
+  void bindTextures(PbrShader& shader);
+
+ private:
+  // creates the textures with their storage
+  PbrImageBasedLighting();
+
+  Magnum::GL::CubeMapTexture irradianceMap_;
+  Magnum::GL::CubeMapTexture prefilteredMap_;
+  Magnum::GL::Texture2D brdfLookupTable_;
+
+  ESP_SMART_POINTERS(PbrImageBasedLighting)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_PBRIMAGEBASEDLIGHTING_H_
@@ -0,0 +1,72 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PbrMaterialBuffer.h"
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/Math/Matrix3.h>
+#include <algorithm>
+#include <cstring>
+
+#include "PbrShader.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+static_assert(sizeof(PbrMaterialBuffer::Uniforms) == 112,
+              "PbrMaterialBuffer::Uniforms doesn't match the std140 layout");
+
+PbrMaterialBuffer::Uniforms PbrMaterialBuffer::uniforms(
+    const PbrMaterialData& material) {
+  Uniforms uniforms{};
+  uniforms.baseColor = material.baseColor;
+  uniforms.roughness = material.roughness;
+  uniforms.metallic = material.metallic;
+  uniforms.emissiveColor = material.emissiveColor;
+  for (int i = 0; i < 3; ++i) {
+    uniforms.textureMatrix[i] = {material.textureMatrix[i], 0.0f};
+  }
+  uniforms.normalTextureScale = material.normalTextureScale;
+  return uniforms;
+}
+
+PbrMaterialBuffer::PbrMaterialBuffer()
+    : buffer_{Mn::GL::Buffer::TargetHint::Uniform} {
+  const std::size_t alignment =
+      std::max(Mn::GL::Buffer::uniformOffsetAlignment(), 1);
+  stride_ = (sizeof(Uniforms) + alignment - 1) / alignment * alignment;
+}
+
+unsigned int PbrMaterialBuffer::slot(const PbrMaterialData& material) {
+  auto found = slots_.find(&material);
+  if (found != slots_.end()) {
+    return found->second;
+  }
+  const unsigned int slot = slots_.size();
+  slots_.emplace(&material, slot);
+  data_.resize((slot + 1) * stride_);
+  const Uniforms values = uniforms(material);
+  std::memcpy(data_.data() + slot * stride_, &values, sizeof(values));
+  dirty_ = true;
+  return slot;
+}
+
+void PbrMaterialBuffer::bind(unsigned int slot, PbrShader& shader) {
+  if (dirty_) {
+    // slots are added by the first draw of each material, the uploads stop
+    // once all of them were drawn
+    buffer_.setData(data_, Mn::GL::BufferUsage::StaticDraw);
+    dirty_ = false;
+    boundSlot_ = ~0u;
+  }
+  if (slot != boundSlot_) {
+    shader.bindMaterialBuffer(buffer_, slot * stride_, sizeof(Uniforms));
+    boundSlot_ = slot;
+  }
+}
+
+}  // namespace gfx
+}  // namespace esp
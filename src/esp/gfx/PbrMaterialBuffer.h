@@ -0,0 +1,104 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_PBRMATERIALBUFFER_H_
+#define ESP_GFX_PBRMATERIALBUFFER_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::PbrMaterialBuffer
+ */
+
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Vector4.h>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "MaterialData.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+class PbrShader;
+
+/**
+ * @brief Uniform buffer holding the materials of all PBR drawables
+ *
+ * Every @ref PbrMaterialData gets a slot the first time it's drawn, filled
+ * once since materials don't change after they are loaded. Drawing then
+ * binds the range of the slot, one call instead of setting the colors, the
+ * roughness, the metallic factor, the texture matrix and the normal texture
+ * scale one by one, and none at all for consecutive draws of the same
+ * material, which the draw state sorting of @ref DrawableGroup makes common.
+ * Used with @ref PbrShader::Flag::MaterialBuffer.
+ */
+class PbrMaterialBuffer {
+ public:
+  /** @brief Key of the buffer in the @ref ShaderManager */
+  static constexpr const char* Key = "pbr-material-buffer";
+
+  /**
+   * @brief A slot, in the std140 layout of the `MaterialBlock` uniform block
+   * of the PBR shader
+   */
+  struct Uniforms {
+    Magnum::Color4 baseColor;
+    float roughness;
+    float metallic;
+    float padding0[2];
+    Magnum::Color3 emissiveColor;
+    float padding1;
+    // the columns of a mat3 are padded to four components
+    Magnum::Vector4 textureMatrix[3];
+    float normalTextureScale;
+    float padding2[3];
+  };
+
+  /** @brief The uniforms of @p material */
+  static Uniforms uniforms(const PbrMaterialData& material);
+
+  /** @brief Constructor, needs a GL context */
+  explicit PbrMaterialBuffer();
+
+  /**
+   * @brief The slot of @p material, added on the first call
+   *
+   * The buffer is uploaded again by the next @ref bind() after a slot was
+   * added.
+   */
+  unsigned int slot(const PbrMaterialData& material);
+
+  /**
+   * @brief Bind @p slot as the material of @p shader, unless it is bound
+   * already
+   */
+  void bind(unsigned int slot, PbrShader& shader);
+
+  /** @brief Count of slots */
+  std::size_t slotCount() const { return slots_.size(); }
+
+  /**
+   * @brief Distance between the slots in the buffer, the size of
+   * @ref Uniforms rounded up to the uniform offset alignment
+   */
+  std::size_t stride() const { return stride_; }
+
+ private:
+  std::unordered_map<const PbrMaterialData*, unsigned int> slots_;
+  std::vector<char> data_;
+  Magnum::GL::Buffer buffer_;
+  std::size_t stride_;
+  bool dirty_ = false;
+  // the slot bound last, invalid after an upload
+  unsigned int boundSlot_ = ~0u;
+
+  ESP_SMART_POINTERS(PbrMaterialBuffer)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_PBRMATERIALBUFFER_H_
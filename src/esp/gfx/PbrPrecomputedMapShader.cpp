@@ -0,0 +1,121 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PbrPrecomputedMapShader.h"
+
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/CubeMapTexture.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/Version.h>
+
+// This is to import the "resources" at runtime. When the resource is
+// compiled into static library, it must be explicitly initialized via this
+// macro, and should be called *outside* of any namespace.
+static void importShaderResources() {
+  CORRADE_RESOURCE_INITIALIZE(ShaderResources)
+}
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+enum TextureUnit : uint8_t {
+  Environment = 0,
+};
+
+const char* typeDefine(PbrPrecomputedMapShader::Type type) {
+  switch (type) {
+    case PbrPrecomputedMapShader::Type::EnvironmentCopy:
+      return "";
+    case PbrPrecomputedMapShader::Type::IrradianceMap:
+      return "#define IRRADIANCE_MAP\n";
+    case PbrPrecomputedMapShader::Type::PrefilteredMap:
+      return "#define PREFILTERED_MAP\n";
+    case PbrPrecomputedMapShader::Type::BrdfLookupTable:
+      return "#define BRDF_LOOKUP_TABLE\n";
+  }
+  CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+}  // namespace
+
+PbrPrecomputedMapShader::PbrPrecomputedMapShader(Type type) : type_(type) {
+  if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
+    importShaderResources();
+  }
+
+  const Cr::Utility::Resource rs{"default-shaders"};
+
+#ifdef MAGNUM_TARGET_WEBGL
+  Mn::GL::Version glVersion = Mn::GL::Version::GLES300;
+#else
+  Mn::GL::Version glVersion = Mn::GL::Version::GL330;
+#endif
+
+  Mn::GL::Shader vert{glVersion, Mn::GL::Shader::Type::Vertex};
+  Mn::GL::Shader frag{glVersion, Mn::GL::Shader::Type::Fragment};
+
+  // the full-screen triangle of the cube map shader
+  vert.addSource(rs.get("cubemap.vert"));
+  frag.addSource(Cr::Utility::formatString(
+                     "#define OUTPUT_ATTRIBUTE_LOCATION_COLOR {}\n",
+                     ColorOutput))
+      .addSource(typeDefine(type_))
+      .addSource(rs.get("pbr-precomputed-map.frag"));
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+
+  attachShaders({vert, frag});
+
+  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+
+  if (type_ != Type::BrdfLookupTable) {
+    setUniform(uniformLocation("EnvironmentMap"), TextureUnit::Environment);
+    faceUniform_ = uniformLocation("Face");
+  }
+  if (type_ == Type::PrefilteredMap) {
+    roughnessUniform_ = uniformLocation("Roughness");
+  }
+}
+
+PbrPrecomputedMapShader& PbrPrecomputedMapShader::bindEnvironmentMap(
+    Mn::GL::CubeMapTexture& texture) {
+  CORRADE_ASSERT(type_ != Type::BrdfLookupTable,
+                 "PbrPrecomputedMapShader::bindEnvironmentMap(): the BRDF "
+                 "lookup table samples no environment",
+                 *this);
+  texture.bind(TextureUnit::Environment);
+  return *this;
+}
+
+PbrPrecomputedMapShader& PbrPrecomputedMapShader::setFace(unsigned int face) {
+  CORRADE_ASSERT(type_ != Type::BrdfLookupTable,
+                 "PbrPrecomputedMapShader::setFace(): the BRDF lookup table "
+                 "has no faces",
+                 *this);
+  CORRADE_ASSERT(face < 6,
+                 "PbrPrecomputedMapShader::setFace(): the face" << face
+                                                               << "is illegal",
+                 *this);
+  setUniform(faceUniform_, int(face));
+  return *this;
+}
+
+PbrPrecomputedMapShader& PbrPrecomputedMapShader::setRoughness(
+    float roughness) {
+  CORRADE_ASSERT(type_ == Type::PrefilteredMap,
+                 "PbrPrecomputedMapShader::setRoughness(): only the "
+                 "prefiltered map has a roughness",
+                 *this);
+  setUniform(roughnessUniform_, roughness);
+  return *this;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,96 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_PBRPRECOMPUTEDMAPSHADER_H_
+#define ESP_GFX_PBRPRECOMPUTEDMAPSHADER_H_
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/Shaders/Generic.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+@brief Shader computing the maps of @ref PbrImageBasedLighting
+
+Renders a full-screen triangle, draw it with a mesh of three vertices and no
+attributes into a face of a cube map, or into the BRDF lookup table. The
+environment is sampled at the mip level covering the solid angle of each
+sample, so it should have all its mip levels.
+*/
+class PbrPrecomputedMapShader : public Magnum::GL::AbstractShaderProgram {
+ public:
+  enum : Magnum::UnsignedInt {
+    /**
+     * Color shader output, expects a floating-point attachment.
+     */
+    ColorOutput = Magnum::Shaders::Generic3D::ColorOutput,
+  };
+
+  enum class Type : Magnum::UnsignedByte {
+    /**
+     * Copy the environment into a face, e.g. to generate its mip levels
+     */
+    EnvironmentCopy,
+    /**
+     * The cosine-weighted mean of the environment around the direction of
+     * each texel of a face, for the diffuse reflection
+     */
+    IrradianceMap,
+    /**
+     * The environment filtered by the GGX distribution of the roughness set
+     * with @ref setRoughness(), for the specular reflection
+     */
+    PrefilteredMap,
+    /**
+     * The scale and bias of the Fresnel reflectance at normal incidence of
+     * the specular reflection, over the cosine between the normal and the
+     * view along x and the roughness along y. Samples no environment.
+     */
+    BrdfLookupTable,
+  };
+
+  /** @brief Constructor */
+  explicit PbrPrecomputedMapShader(Type type);
+
+  /** @brief The type passed to the constructor */
+  Type type() const { return type_; }
+
+  /**
+   * @brief Bind the environment cube map
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the type is not @ref Type::BrdfLookupTable.
+   */
+  PbrPrecomputedMapShader& bindEnvironmentMap(
+      Magnum::GL::CubeMapTexture& texture);
+
+  /**
+   * @brief Set the face drawn into, in the order of
+   * @ref Magnum::GL::CubeMapCoordinate
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the type is not @ref Type::BrdfLookupTable.
+   */
+  PbrPrecomputedMapShader& setFace(unsigned int face);
+
+  /**
+   * @brief Set the roughness of the prefiltered level drawn into
+   * @return Reference to self (for method chaining)
+   *
+   * Expects @ref Type::PrefilteredMap.
+   */
+  PbrPrecomputedMapShader& setRoughness(float roughness);
+
+ private:
+  Type type_;
+  int faceUniform_ = -1, roughnessUniform_ = -1;
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_PBRPRECOMPUTEDMAPSHADER_H_
@@ -11,6 +11,8 @@
 #include <Corrade/Utility/DebugStl.h>
 #include <Corrade/Utility/FormatStl.h>
 #include <Corrade/Utility/Resource.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/CubeMapTexture.h>
 #include <Magnum/GL/Context.h>
 #include <Magnum/GL/Extensions.h>
 #include <Magnum/GL/Shader.h>
@@ -23,6 +25,9 @@
 #include <Magnum/PixelFormat.h>
 
 #include "esp/core/esp.h"
+#include "esp/gfx/LightClusters.h"
+#include "esp/gfx/PbrImageBasedLighting.h"
+#include "esp/gfx/ProgramBinaryCache.h"
 #include "esp/io/io.h"
 
 #include <sstream>
@@ -46,10 +51,18 @@ enum TextureUnit : uint8_t {
   MetallicRoughness = 1,
   Normal = 2,
   Emissive = 3,
+  LightData = 4,
+  LightClusterList = 5,
+  LightIndices = 6,
+  IrradianceMap = 7,
+  PrefilteredMap = 8,
+  BrdfLookupTable = 9,
 };
 }  // namespace
 
-PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
+PbrShader::PbrShader(Flags originalFlags,
+                     unsigned int lightCount,
+                     const ProgramBinaryCache* binaryCache)
     : flags_(originalFlags), lightCount_(lightCount) {
   if (!Cr::Utility::Resource::hasGroup("default-shaders")) {
     importShaderResources();
@@ -90,6 +103,12 @@ PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
                                      TextureCoordinates::Location);
   }
 
+  // the material block shared by both stages
+  const std::string materialBuffer =
+      flags_ & Flag::MaterialBuffer
+          ? "#define MATERIAL_BUFFER\n" + rs.get("pbr-material.glsl")
+          : "";
+
   // Add macros
   vert.addSource(attributeLocationsStream.str())
       .addSource(isTextured ? "#define TEXTURED\n" : "")
@@ -100,6 +119,7 @@ PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
       .addSource(flags_ & Flag::TextureTransformation
                      ? "#define TEXTURE_TRANSFORMATION\n"
                      : "")
+      .addSource(materialBuffer)
       .addSource(rs.get("pbr.vert"));
 
   std::stringstream outputAttributeLocationsStream;
@@ -130,13 +150,43 @@ PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
                      : "")
       .addSource(
           Cr::Utility::formatString("#define LIGHT_COUNT {}\n", lightCount_))
+      .addSource(flags_ & Flag::ClusteredLights
+                     ? Cr::Utility::formatString(
+                           "#define CLUSTERED_LIGHTS\n"
+                           "#define CLUSTER_TILE_COUNT ivec2({}, {})\n"
+                           "#define CLUSTER_SLICE_COUNT {}\n"
+                           "#define LIGHT_INDEX_TEXTURE_WIDTH {}\n",
+                           int(LightClusters::TileCountX),
+                           int(LightClusters::TileCountY),
+                           int(LightClusters::SliceCount),
+                           int(LightClusters::IndexTextureWidth))
+                     : "")
+      .addSource(flags_ & Flag::ImageBasedLighting
+                     ? Cr::Utility::formatString(
+                           "#define IMAGE_BASED_LIGHTING\n"
+                           "#define PREFILTERED_MAP_LEVELS {}\n",
+                           int(PbrImageBasedLighting::PrefilteredMapLevels))
+                     : "")
+      .addSource(materialBuffer)
       .addSource(rs.get("pbr.frag"));
 
-  CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+  // a program linked by an earlier run with the same driver and sources
+  // needs no compilation
+  const std::string binaryKey =
+      binaryCache ? binaryCache->key({vert, frag}) : std::string{};
+  if (!binaryCache || !binaryCache->load(*this, binaryKey)) {
+    CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
 
-  attachShaders({vert, frag});
+    attachShaders({vert, frag});
 
-  CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    if (binaryCache) {
+      binaryCache->prepareLink(*this);
+    }
+    CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    if (binaryCache) {
+      binaryCache->store(*this, binaryKey);
+    }
+  }
 
   // bind attributes
 #ifndef MAGNUM_TARGET_GLES
@@ -175,6 +225,19 @@ PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
       setUniform(uniformLocation("NormalTexture"), TextureUnit::Normal);
     }
     // TODO occlusion texture
+    if (flags_ & Flag::ClusteredLights) {
+      setUniform(uniformLocation("LightData"), TextureUnit::LightData);
+      setUniform(uniformLocation("LightClusters"),
+                 TextureUnit::LightClusterList);
+      setUniform(uniformLocation("LightIndices"), TextureUnit::LightIndices);
+    }
+    if (flags_ & Flag::ImageBasedLighting) {
+      setUniform(uniformLocation("IrradianceMap"), TextureUnit::IrradianceMap);
+      setUniform(uniformLocation("PrefilteredMap"),
+                 TextureUnit::PrefilteredMap);
+      setUniform(uniformLocation("BrdfLookupTable"),
+                 TextureUnit::BrdfLookupTable);
+    }
   }
   // emissive texture does not depend on lights
   if (flags_ & Flag::EmissiveTexture) {
@@ -188,25 +251,38 @@ PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
   if (flags_ & Flag::ObjectId) {
     objectIdUniform_ = uniformLocation("ObjectId");
   }
-  if (flags_ & Flag::TextureTransformation) {
-    textureMatrixUniform_ = uniformLocation("TextureMatrix");
-  }
+  if (flags_ & Flag::MaterialBuffer) {
+    // the material is always read, for the emissive color at least
+    setUniformBlockBinding(uniformBlockIndex("MaterialBlock"),
+                           MaterialBufferBinding);
+  } else {
+    if (flags_ & Flag::TextureTransformation) {
+      textureMatrixUniform_ = uniformLocation("TextureMatrix");
+    }
 
-  // materials
-  baseColorUniform_ = uniformLocation("Material.baseColor");
-  roughnessUniform_ = uniformLocation("Material.roughness");
-  metallicUniform_ = uniformLocation("Material.metallic");
-  emissiveColorUniform_ = uniformLocation("Material.emissiveColor");
+    // materials
+    baseColorUniform_ = uniformLocation("Material.baseColor");
+    roughnessUniform_ = uniformLocation("Material.roughness");
+    metallicUniform_ = uniformLocation("Material.metallic");
+    emissiveColorUniform_ = uniformLocation("Material.emissiveColor");
+  }
 
   // lights
-  if (lightCount_) {
+  if (lightCount_ && (flags_ & Flag::ClusteredLights)) {
+    directionalLightCountUniform_ = uniformLocation("DirectionalLightCount");
+    lightClusterDepthUniform_ = uniformLocation("LightClusterDepth");
+  } else if (lightCount_) {
     lightRangesUniform_ = uniformLocation("LightRanges");
     lightColorsUniform_ = uniformLocation("LightColors");
     lightDirectionsUniform_ = uniformLocation("LightDirections");
   }
 
+  if (lightCount_ && (flags_ & Flag::ImageBasedLighting)) {
+    cameraRotationUniform_ = uniformLocation("CameraRotation");
+  }
+
   if ((flags_ & Flag::NormalTexture) && (flags_ & Flag::NormalTextureScale) &&
-      lightCount_) {
+      lightCount_ && !(flags_ & Flag::MaterialBuffer)) {
     normalTextureScaleUniform_ = uniformLocation("NormalTextureScale");
   }
 
@@ -214,14 +290,24 @@ PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
   setTransformationMatrix(Mn::Matrix4{Mn::Math::IdentityInit});
   setProjectionMatrix(Mn::Matrix4{Mn::Math::IdentityInit});
   if (lightCount_) {
-    setBaseColor(Magnum::Color4{0.7f});
-    setRoughness(0.9f);
-    setMetallic(0.1f);
-    if (flags_ & Flag::NormalTexture) {
-      setNormalTextureScale(1.0f);
+    if (!(flags_ & Flag::MaterialBuffer)) {
+      setBaseColor(Magnum::Color4{0.7f});
+      setRoughness(0.9f);
+      setMetallic(0.1f);
+      if (flags_ & Flag::NormalTexture) {
+        setNormalTextureScale(1.0f);
+      }
     }
     setNormalMatrix(Mn::Matrix3x3{Mn::Math::IdentityInit});
-
+    if (flags_ & Flag::ImageBasedLighting) {
+      setCameraRotation(Mn::Matrix3x3{Mn::Math::IdentityInit});
+    }
+  }
+  if (lightCount_ && (flags_ & Flag::ClusteredLights)) {
+    // no lights until the textures are bound
+    setDirectionalLightCount(0);
+    setLightClusterDepth({1.0f, 0.0f});
+  } else if (lightCount_) {
     setLightVectors(Cr::Containers::Array<Mn::Vector4>{
         Cr::Containers::DirectInit, lightCount_,
         // a single directional "fill" light, coming from the center of the
@@ -233,7 +319,9 @@ PbrShader::PbrShader(Flags originalFlags, unsigned int lightCount)
     setLightRanges(Cr::Containers::Array<Mn::Float>{
         Cr::Containers::DirectInit, lightCount_, Mn::Constants::inf()});
   }
-  setEmissiveColor(Magnum::Color3{0.0f});
+  if (!(flags_ & Flag::MaterialBuffer)) {
+    setEmissiveColor(Magnum::Color3{0.0f});
+  }
 }
 
 // Note: the texture binding points are explicitly specified above.
@@ -283,6 +371,18 @@ PbrShader& PbrShader::bindEmissiveTexture(Magnum::GL::Texture2D& texture) {
   return *this;
 }
 
+PbrShader& PbrShader::bindMaterialBuffer(Mn::GL::Buffer& buffer,
+                                         std::size_t offset,
+                                         std::size_t size) {
+  CORRADE_ASSERT(flags_ & Flag::MaterialBuffer,
+                 "PbrShader::bindMaterialBuffer(): the shader was not "
+                 "created with a material buffer",
+                 *this);
+  buffer.bind(Mn::GL::Buffer::Target::Uniform, MaterialBufferBinding, offset,
+              size);
+  return *this;
+}
+
 PbrShader& PbrShader::setProjectionMatrix(const Mn::Matrix4& matrix) {
   setUniform(projMatrixUniform_, matrix);
   return *this;
@@ -306,6 +406,10 @@ PbrShader& PbrShader::setObjectId(unsigned int objectId) {
 }
 
 PbrShader& PbrShader::setBaseColor(const Mn::Color4& color) {
+  CORRADE_ASSERT(!(flags_ & Flag::MaterialBuffer),
+                 "PbrShader::setBaseColor(): the material of the shader is "
+                 "in a buffer",
+                 *this);
   if (lightCount_) {
     setUniform(baseColorUniform_, color);
   }
@@ -313,11 +417,19 @@ PbrShader& PbrShader::setBaseColor(const Mn::Color4& color) {
 }
 
 PbrShader& PbrShader::setEmissiveColor(const Magnum::Color3& color) {
+  CORRADE_ASSERT(!(flags_ & Flag::MaterialBuffer),
+                 "PbrShader::setEmissiveColor(): the material of the shader is "
+                 "in a buffer",
+                 *this);
   setUniform(emissiveColorUniform_, color);
   return *this;
 }
 
 PbrShader& PbrShader::setRoughness(float roughness) {
+  CORRADE_ASSERT(!(flags_ & Flag::MaterialBuffer),
+                 "PbrShader::setRoughness(): the material of the shader is "
+                 "in a buffer",
+                 *this);
   if (lightCount_) {
     setUniform(roughnessUniform_, roughness);
   }
@@ -325,6 +437,10 @@ PbrShader& PbrShader::setRoughness(float roughness) {
 }
 
 PbrShader& PbrShader::setMetallic(float metallic) {
+  CORRADE_ASSERT(!(flags_ & Flag::MaterialBuffer),
+                 "PbrShader::setMetallic(): the material of the shader is "
+                 "in a buffer",
+                 *this);
   if (lightCount_) {
     setUniform(metallicUniform_, metallic);
   }
@@ -332,6 +448,10 @@ PbrShader& PbrShader::setMetallic(float metallic) {
 }
 
 PbrShader& PbrShader::setTextureMatrix(const Mn::Matrix3& matrix) {
+  CORRADE_ASSERT(!(flags_ & Flag::MaterialBuffer),
+                 "PbrShader::setTextureMatrix(): the material of the shader is "
+                 "in a buffer",
+                 *this);
   CORRADE_ASSERT(flags_ & Flag::TextureTransformation,
                  "PbrShader::setTextureMatrix(): the shader was not "
                  "created with texture transformation enabled",
@@ -433,6 +553,10 @@ PbrShader& PbrShader::setLightColors(std::initializer_list<Mn::Color3> colors) {
 }
 
 PbrShader& PbrShader::setNormalTextureScale(float scale) {
+  CORRADE_ASSERT(!(flags_ & Flag::MaterialBuffer),
+                 "PbrShader::setNormalTextureScale(): the material of the "
+                 "shader is in a buffer",
+                 *this);
   CORRADE_ASSERT(flags_ & Flag::NormalTexture,
                  "PbrShader::setNormalTextureScale(): the shader was not "
                  "created with normal texture enabled",
@@ -458,5 +582,69 @@ PbrShader& PbrShader::setLightRanges(std::initializer_list<float> ranges) {
   return setLightRanges(Cr::Containers::arrayView(ranges));
 }
 
+PbrShader& PbrShader::bindLightClusterTextures(Mn::GL::Texture2D& lights,
+                                               Mn::GL::Texture2D& clusters,
+                                               Mn::GL::Texture2D& indices) {
+  CORRADE_ASSERT(flags_ & Flag::ClusteredLights,
+                 "PbrShader::bindLightClusterTextures(): the shader was not "
+                 "created with clustered lights enabled",
+                 *this);
+  if (lightCount_) {
+    lights.bind(TextureUnit::LightData);
+    clusters.bind(TextureUnit::LightClusterList);
+    indices.bind(TextureUnit::LightIndices);
+  }
+  return *this;
+}
+
+PbrShader& PbrShader::setDirectionalLightCount(unsigned int count) {
+  CORRADE_ASSERT(flags_ & Flag::ClusteredLights,
+                 "PbrShader::setDirectionalLightCount(): the shader was not "
+                 "created with clustered lights enabled",
+                 *this);
+  if (lightCount_) {
+    setUniform(directionalLightCountUniform_, int(count));
+  }
+  return *this;
+}
+
+PbrShader& PbrShader::setLightClusterDepth(const Mn::Vector2& parameters) {
+  CORRADE_ASSERT(flags_ & Flag::ClusteredLights,
+                 "PbrShader::setLightClusterDepth(): the shader was not "
+                 "created with clustered lights enabled",
+                 *this);
+  if (lightCount_) {
+    setUniform(lightClusterDepthUniform_, parameters);
+  }
+  return *this;
+}
+
+PbrShader& PbrShader::bindImageBasedLightingTextures(
+    Mn::GL::CubeMapTexture& irradianceMap,
+    Mn::GL::CubeMapTexture& prefilteredMap,
+    Mn::GL::Texture2D& brdfLookupTable) {
+  CORRADE_ASSERT(flags_ & Flag::ImageBasedLighting,
+                 "PbrShader::bindImageBasedLightingTextures(): the shader was "
+                 "not created with image based lighting enabled",
+                 *this);
+  if (lightCount_) {
+    irradianceMap.bind(TextureUnit::IrradianceMap);
+    prefilteredMap.bind(TextureUnit::PrefilteredMap);
+    brdfLookupTable.bind(TextureUnit::BrdfLookupTable);
+  }
+  return *this;
+}
+
+PbrShader& PbrShader::setCameraRotation(const Mn::Matrix3x3& rotation) {
+  CORRADE_ASSERT(flags_ & Flag::ImageBasedLighting,
+                 "PbrShader::setCameraRotation(): the shader was not created "
+                 "with image based lighting enabled",
+                 *this);
+  if (lightCount_) {
+    setUniform(cameraRotationUniform_, rotation);
+  }
+  return *this;
+}
+
 }  // namespace gfx
 }  // namespace esp
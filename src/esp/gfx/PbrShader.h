@@ -5,6 +5,7 @@
 #ifndef ESP_GFX_PBRSHADER_H_
 #define ESP_GFX_PBRSHADER_H_
 
+#include <cstddef>
 #include <initializer_list>
 
 #include <Corrade/Containers/ArrayView.h>
@@ -18,6 +19,8 @@ namespace esp {
 
 namespace gfx {
 
+class ProgramBinaryCache;
+
 class PbrShader : public Magnum::GL::AbstractShaderProgram {
  public:
   // ==== Attribute definitions ====
@@ -69,6 +72,14 @@ class PbrShader : public Magnum::GL::AbstractShaderProgram {
     ObjectIdOutput = Magnum::Shaders::Generic3D::ObjectIdOutput,
   };
 
+  enum : Magnum::UnsignedInt {
+    /**
+     * Uniform buffer binding point of the material, used only if
+     * @ref Flag::MaterialBuffer is set.
+     */
+    MaterialBufferBinding = 0,
+  };
+
   /**
    * @brief Flag
    *
@@ -175,6 +186,35 @@ class PbrShader : public Magnum::GL::AbstractShaderProgram {
      */
     DoubleSided = 1 << 12,
 
+    /**
+     * Read the material, the texture matrix and the normal texture scale
+     * from a range of a uniform buffer bound with @ref bindMaterialBuffer()
+     * instead of setting them one by one, see @ref PbrMaterialBuffer. The
+     * material setters, @ref setTextureMatrix() and
+     * @ref setNormalTextureScale() can't be used then.
+     */
+    MaterialBuffer = 1 << 13,
+
+    /**
+     * Read the lights from textures bound with
+     * @ref bindLightClusterTextures(), shading each fragment with the
+     * directional lights and the point lights of its cluster only, see
+     * @ref LightClusters. The light count passed to the constructor then
+     * only has to be non-zero and @ref setLightVectors(),
+     * @ref setLightColors(), @ref setLightRanges() and their single-light
+     * variants can't be used.
+     */
+    ClusteredLights = 1 << 14,
+
+    /**
+     * Add the reflection of a precomputed environment to the lights, read
+     * from the maps of @ref PbrImageBasedLighting bound with
+     * @ref bindImageBasedLightingTextures(). Needs @ref setCameraRotation()
+     * to look the world directions up. Only used if the light count is
+     * non-zero.
+     */
+    ImageBasedLighting = 1 << 15,
+
     /*
      * TODO: alphaMask
      */
@@ -189,6 +229,8 @@ class PbrShader : public Magnum::GL::AbstractShaderProgram {
    * @brief Constructor
    * @param flags         Flags
    * @param lightCount    Count of light sources
+   * @param binaryCache   Cache the linked program is loaded from or stored
+   *                      to, see @ref ProgramBinaryCache, nullptr for none
    *
    * By default,
    *
@@ -205,7 +247,9 @@ class PbrShader : public Magnum::GL::AbstractShaderProgram {
    *
    * the light range is set to Magnum::Constants::inf()
    */
-  explicit PbrShader(Flags flags = {}, unsigned int lightCount = 1);
+  explicit PbrShader(Flags flags = {},
+                     unsigned int lightCount = 1,
+                     const ProgramBinaryCache* binaryCache = nullptr);
 
   /** @brief Copying is not allowed */
   PbrShader(const PbrShader&) = delete;
@@ -253,6 +297,19 @@ class PbrShader : public Magnum::GL::AbstractShaderProgram {
   PbrShader& bindEmissiveTexture(Magnum::GL::Texture2D& texture);
 
   PbrShader& setTextureMatrix(const Magnum::Matrix3& matrix);
+
+  /**
+   * @brief Bind @p size bytes of @p buffer at @p offset as the material
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the shader was created with @ref Flag::MaterialBuffer. The
+   * range has the layout of @ref PbrMaterialBuffer::Uniforms and has to be
+   * aligned to @ref Magnum::GL::Buffer::uniformOffsetAlignment().
+   */
+  PbrShader& bindMaterialBuffer(Magnum::GL::Buffer& buffer,
+                                std::size_t offset,
+                                std::size_t size);
+
   // ======== set uniforms ===========
   /**
    *  @brief Set "projection" matrix to the uniform on GPU
@@ -411,6 +468,57 @@ class PbrShader : public Magnum::GL::AbstractShaderProgram {
 
   PbrShader& setNormalTextureScale(float scale);
 
+  // -------- clustered lights ---------------
+  /**
+   * @brief Bind the lights, the clusters and their light lists of
+   * @ref LightClusters
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the shader was created with @ref Flag::ClusteredLights.
+   */
+  PbrShader& bindLightClusterTextures(Magnum::GL::Texture2D& lights,
+                                      Magnum::GL::Texture2D& clusters,
+                                      Magnum::GL::Texture2D& indices);
+
+  /**
+   * @brief Set the number of directional lights at the front of the light
+   * texture
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the shader was created with @ref Flag::ClusteredLights.
+   */
+  PbrShader& setDirectionalLightCount(unsigned int count);
+
+  /**
+   * @brief Set the slice parameters of the clusters, see
+   * @ref LightClusters::depthParameters()
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the shader was created with @ref Flag::ClusteredLights.
+   */
+  PbrShader& setLightClusterDepth(const Magnum::Vector2& parameters);
+
+  // -------- image based lighting ---------------
+  /**
+   * @brief Bind the maps of @ref PbrImageBasedLighting
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the shader was created with @ref Flag::ImageBasedLighting.
+   */
+  PbrShader& bindImageBasedLightingTextures(
+      Magnum::GL::CubeMapTexture& irradianceMap,
+      Magnum::GL::CubeMapTexture& prefilteredMap,
+      Magnum::GL::Texture2D& brdfLookupTable);
+
+  /**
+   * @brief Set the rotation of the camera in the world, i.e. from camera to
+   * world space, to look the environment up in
+   * @return Reference to self (for method chaining)
+   *
+   * Expects that the shader was created with @ref Flag::ImageBasedLighting.
+   */
+  PbrShader& setCameraRotation(const Magnum::Matrix3x3& rotation);
+
  protected:
   Flags flags_;
   unsigned int lightCount_;
@@ -436,6 +544,10 @@ class PbrShader : public Magnum::GL::AbstractShaderProgram {
   // when w == 0, it means .xyz is the light direction;
   // when w == 1, it means it is the light position, NOT the direction;
   int lightDirectionsUniform_ = ID_UNDEFINED;
+
+  int directionalLightCountUniform_ = ID_UNDEFINED;
+  int lightClusterDepthUniform_ = ID_UNDEFINED;
+  int cameraRotationUniform_ = ID_UNDEFINED;
 };
 
 CORRADE_ENUMSET_OPERATORS(PbrShader::Flags)
@@ -0,0 +1,148 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ProgramBinaryCache.h"
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/Sha1.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Extensions.h>
+#include <Magnum/GL/OpenGL.h>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "esp/core/MappedFile.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 'p', 'r', 'o', 'g', '\0'};
+constexpr std::uint32_t Version = 1;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t format;
+};
+
+bool isSupported() {
+#ifdef MAGNUM_TARGET_WEBGL
+  return false;
+#else
+#ifndef MAGNUM_TARGET_GLES
+  if (!Mn::GL::Context::current()
+           .isExtensionSupported<Mn::GL::Extensions::ARB::get_program_binary>())
+    return false;
+#endif
+  // drivers may support the extension without any binary format
+  GLint numFormats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  return numFormats > 0;
+#endif
+}
+
+}  // namespace
+
+ProgramBinaryCache::ProgramBinaryCache(std::string directory) {
+  setDirectory(std::move(directory));
+}
+
+void ProgramBinaryCache::setDirectory(std::string directory) {
+  directory_ = std::move(directory);
+  if (!directory_.empty() && !Cr::Utility::Directory::mkpath(directory_)) {
+    LOG(WARNING) << "ProgramBinaryCache: cannot create " << directory_
+                 << ", shader programs won't be cached";
+    directory_.clear();
+  }
+}
+
+bool ProgramBinaryCache::isEnabled() const {
+  return !directory_.empty() && isSupported();
+}
+
+std::string ProgramBinaryCache::key(
+    std::initializer_list<Cr::Containers::Reference<Mn::GL::Shader>> shaders)
+    const {
+  Mn::GL::Context& context = Mn::GL::Context::current();
+  Cr::Utility::Sha1 sha1;
+  sha1 << context.vendorString() << '\0' << context.rendererString() << '\0'
+       << context.versionString() << '\0';
+  for (Mn::GL::Shader& shader : shaders) {
+    sha1 << std::to_string(Mn::UnsignedInt(shader.type())) << '\0';
+    for (const std::string& source : shader.sources()) {
+      sha1 << source << '\0';
+    }
+  }
+  return sha1.digest().hexString();
+}
+
+bool ProgramBinaryCache::load(Mn::GL::AbstractShaderProgram& program,
+                              const std::string& key) const {
+  if (!isEnabled()) {
+    return false;
+  }
+  Cr::Containers::Array<char> file = core::mapFile(
+      Cr::Utility::Directory::join(directory_, key + ".bin"));
+  FileHeader header;
+  if (file.size() <= sizeof(FileHeader)) {
+    return false;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version) {
+    return false;
+  }
+  glProgramBinary(program.id(), header.format, file.data() + sizeof(header),
+                  file.size() - sizeof(header));
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program.id(), GL_LINK_STATUS, &linked);
+  return linked == GL_TRUE;
+}
+
+void ProgramBinaryCache::prepareLink(
+    Mn::GL::AbstractShaderProgram& program) const {
+  if (isEnabled()) {
+    glProgramParameteri(program.id(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+  }
+}
+
+bool ProgramBinaryCache::store(Mn::GL::AbstractShaderProgram& program,
+                               const std::string& key) const {
+  if (!isEnabled()) {
+    return false;
+  }
+  GLint size = 0;
+  glGetProgramiv(program.id(), GL_PROGRAM_BINARY_LENGTH, &size);
+  if (size <= 0) {
+    return false;
+  }
+  Cr::Containers::Array<char> data{Cr::Containers::ValueInit,
+                                   sizeof(FileHeader) + std::size_t(size)};
+  GLsizei written = 0;
+  GLenum format = 0;
+  glGetProgramBinary(program.id(), size, &written, &format,
+                     data.data() + sizeof(FileHeader));
+  if (written <= 0) {
+    return false;
+  }
+  FileHeader header;
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.format = format;
+  std::memcpy(data.data(), &header, sizeof(header));
+  return core::writeFileAtomically(
+      Cr::Utility::Directory::join(directory_, key + ".bin"),
+      data.prefix(sizeof(FileHeader) + written));
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,107 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_PROGRAMBINARYCACHE_H_
+#define ESP_GFX_PROGRAMBINARYCACHE_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::ProgramBinaryCache
+ */
+
+#include <Corrade/Containers/Reference.h>
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Shader.h>
+#include <initializer_list>
+#include <string>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief On-disk cache of linked shader programs
+ *
+ * Stores the driver binaries of the programs, see @cpp glGetProgramBinary()
+ * @ce, so that the shader variants compiled by one process are loaded by the
+ * next ones instead of compiled again. A program is keyed by the vendor,
+ * renderer and version strings of the driver and the sources of its shaders,
+ * so a driver update or an edited shader only misses the cache. The driver
+ * may still reject a binary, which is then compiled as usual and stored
+ * again. Files are written atomically, so several processes can share a
+ * directory.
+ *
+ * Shaders use it around their compilation:
+ *
+ * @code{.cpp}
+ * const std::string key = cache ? cache->key({vert, frag}) : "";
+ * if (!cache || !cache->load(*this, key)) {
+ *   Mn::GL::Shader::compile({vert, frag});
+ *   attachShaders({vert, frag});
+ *   if (cache) cache->prepareLink(*this);
+ *   link();
+ *   if (cache) cache->store(*this, key);
+ * }
+ * @endcode
+ */
+class ProgramBinaryCache {
+ public:
+  /** @brief Key of the cache in the @ref ShaderManager */
+  static constexpr const char* Key = "program-binary-cache";
+
+  /**
+   * @brief Constructor
+   * @param directory, the cache directory, see @ref setDirectory()
+   */
+  explicit ProgramBinaryCache(std::string directory = {});
+
+  /**
+   * @brief Set the cache directory, created if it doesn't exist, empty to
+   * disable the cache
+   */
+  void setDirectory(std::string directory);
+
+  /** @brief The cache directory, empty if disabled */
+  const std::string& directory() const { return directory_; }
+
+  /**
+   * @brief Whether programs are cached, i.e. there is a directory and the
+   * driver supports program binaries
+   */
+  bool isEnabled() const;
+
+  /** @brief The key of the program linked from @p shaders, with sources */
+  std::string key(
+      std::initializer_list<Corrade::Containers::Reference<Magnum::GL::Shader>>
+          shaders) const;
+
+  /**
+   * @brief Load the binary of @p key into @p program, which has no shaders
+   * attached
+   * @return whether @p program is linked, false if the cache is disabled, the
+   * binary is missing or the driver rejected it
+   */
+  bool load(Magnum::GL::AbstractShaderProgram& program,
+            const std::string& key) const;
+
+  /** @brief Ask the driver to keep the binary of @p program before linking */
+  void prepareLink(Magnum::GL::AbstractShaderProgram& program) const;
+
+  /**
+   * @brief Store the binary of the linked @p program
+   * @return false if the cache is disabled or the file can't be written
+   */
+  bool store(Magnum::GL::AbstractShaderProgram& program,
+             const std::string& key) const;
+
+ private:
+  std::string directory_;
+
+  ESP_SMART_POINTERS(ProgramBinaryCache)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_PROGRAMBINARYCACHE_H_
@@ -4,13 +4,22 @@
 
 #include "RenderCamera.h"
 
+#include <algorithm>
+#include <tuple>
+
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Renderer.h>
 #include <Magnum/Math/Frustum.h>
 #include <Magnum/Math/Intersection.h>
 #include <Magnum/Math/Range.h>
 #include <Magnum/SceneGraph/Drawable.h>
+#include "esp/core/PerfStats.h"
+#include "esp/core/Profiling.h"
 #include "esp/gfx/Drawable.h"
 #include "esp/gfx/DrawableGroup.h"
+#include "esp/gfx/LightweightShaders.h"
+#include "esp/gfx/OcclusionCuller.h"
 #include "esp/scene/SceneGraph.h"
 
 namespace Mn = Magnum;
@@ -49,6 +58,24 @@ Cr::Containers::Optional<int> rangeFrustum(const Mn::Range3D& range,
   return Cr::Containers::NullOpt;
 }
 
+namespace {
+
+// the triangles a draw of mesh rasterizes, 0 for points and lines
+size_t numTriangles(Mn::GL::Mesh& mesh) {
+  const size_t count = mesh.count();
+  switch (mesh.primitive()) {
+    case Mn::GL::MeshPrimitive::Triangles:
+      return count / 3;
+    case Mn::GL::MeshPrimitive::TriangleStrip:
+    case Mn::GL::MeshPrimitive::TriangleFan:
+      return count > 2 ? count - 2 : 0;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
 RenderCamera::RenderCamera(scene::SceneNode& node) : MagnumCamera{node} {
   node.setType(scene::SceneNodeType::CAMERA);
   setAspectRatioPolicy(Mn::SceneGraph::AspectRatioPolicy::NotPreserved);
@@ -110,9 +137,9 @@ RenderCamera& RenderCamera::setOrthoProjectionMatrix(int width,
 size_t RenderCamera::cull(
     std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
                           Mn::Matrix4>>& drawableTransforms) {
-  // camera frustum relative to world origin
-  const Mn::Frustum frustum =
-      Mn::Frustum::fromMatrix(projectionMatrix() * cameraMatrix());
+  ESP_PROFILE_SCOPE("RenderCamera::cull");
+  ESP_PERF_TIMER(Cull);
+  const Mn::Frustum frustum = cullingFrustum();
 
   auto newEndIter = std::remove_if(
       drawableTransforms.begin(), drawableTransforms.end(),
@@ -122,24 +149,62 @@ size_t RenderCamera::cull(
         auto& node = static_cast<scene::SceneNode&>(a.first.get().object());
         Corrade::Containers::Optional<Mn::Range3D> aabb =
             node.getAbsoluteAABB();
-        if (aabb) {
-          // if it has an absolute aabb, it is a static mesh
-          Cr::Containers::Optional<int> culledPlane =
-              rangeFrustum(*aabb, frustum, node.getFrustumPlaneIndex());
-          if (culledPlane) {
-            node.setFrustumPlaneIndex(*culledPlane);
+        if (!aabb) {
+          // keep the drawable if its node has no bounding box at all
+          if (node.getMeshBB().size() == Mn::Vector3{}) {
+            return false;
           }
-          // if it has value, it means the aabb is culled
-          return (culledPlane != Cr::Containers::NullOpt);
-        } else {
-          // keep the drawable if its node does not have an absolute AABB
-          return false;
+          // a dynamic mesh, its box is only recomputed after it moved
+          aabb = node.cachedAbsoluteMeshBB();
+        }
+        Cr::Containers::Optional<int> culledPlane =
+            rangeFrustum(*aabb, frustum, node.getFrustumPlaneIndex());
+        if (culledPlane) {
+          node.setFrustumPlaneIndex(*culledPlane);
         }
+        // if it has value, it means the aabb is culled
+        return (culledPlane != Cr::Containers::NullOpt);
+      });
+
+  return (newEndIter - drawableTransforms.begin());
+}
+
+size_t RenderCamera::cull(
+    DrawableGroup& group,
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  ESP_PROFILE_SCOPE("RenderCamera::cull");
+  ESP_PERF_TIMER(Cull);
+  const Mn::Frustum frustum = cullingFrustum();
+
+  const std::vector<char>& visible = group.cull(frustum);
+
+  auto newEndIter = std::remove_if(
+      drawableTransforms.begin(), drawableTransforms.end(),
+      [&](const std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>& a) {
+        const int index =
+            static_cast<Drawable&>(a.first.get()).getCullingIndex();
+        // keep drawables the group does not know about
+        return index != ID_UNDEFINED && !visible[index];
       });
 
   return (newEndIter - drawableTransforms.begin());
 }
 
+Mn::Frustum RenderCamera::cullingFrustum() {
+  if (cullingFrustum_) {
+    return *cullingFrustum_;
+  }
+  // camera frustum relative to world origin
+  return Mn::Frustum::fromMatrix(projectionMatrix() * cameraMatrix());
+}
+
+Mn::Matrix4 RenderCamera::cleanCameraMatrix() {
+  node().cachedAbsoluteTransformationMatrix();
+  return cameraMatrix();
+}
+
 size_t RenderCamera::removeNonObjects(
     std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
                           Mn::Matrix4>>& drawableTransforms) {
@@ -157,9 +222,19 @@ size_t RenderCamera::removeNonObjects(
   return (newEndIter - drawableTransforms.begin());
 }
 
-uint32_t RenderCamera::draw(MagnumDrawableGroup& drawables, Flags flags) {
+uint32_t RenderCamera::draw(MagnumDrawableGroup& drawables,
+                            Flags flags,
+                            OcclusionCuller* occlusionCuller,
+                            LightweightShaders* lightweightShaders) {
+  ESP_PROFILE_SCOPE("RenderCamera::draw");
   previousNumVisibleDrawables_ = drawables.size();
-  if (flags == Flags()) {  // empty set
+  previousNumOccludedDrawables_ = 0;
+  previousNumDrawStateChanges_ = 0;
+  previousNumTriangles_ = 0;
+  // light setups may have changed since the last frame
+  lightParameterCache_.invalidate();
+  auto* group = dynamic_cast<DrawableGroup*>(&drawables);
+  if (flags == Flags() && !group) {  // empty set
     MagnumCamera::draw(drawables);
     return drawables.size();
   }
@@ -168,33 +243,174 @@ uint32_t RenderCamera::draw(MagnumDrawableGroup& drawables, Flags flags) {
     useDrawableIds_ = true;
   }
 
-  std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
-                        Mn::Matrix4>>
-      drawableTransforms = drawableTransformations(drawables);
+  if ((flags & Flag::ReuseCulling) && culledGroup_ == &drawables) {
+    // only the transformations relative to the camera changed
+    const Mn::Matrix4 camera = cleanCameraMatrix();
+    for (auto& drawableTransform : drawableTransforms_) {
+      auto& drawableNode = static_cast<scene::SceneNode&>(
+          drawableTransform.first.get().object());
+      drawableTransform.second =
+          camera * drawableNode.cachedAbsoluteTransformationMatrix();
+    }
+    previousNumVisibleDrawables_ = drawableTransforms_.size();
+    drawTransforms(group, drawableTransforms_, flags, lightweightShaders);
+    useDrawableIds_ = false;
+    return drawableTransforms_.size();
+  }
+  culledGroup_ = &drawables;
+
+  if (group) {
+    // reuses the absolute transformations cached on the scene nodes; unlike
+    // Magnum's drawableTransformations() this does not clean the whole scene,
+    // so the camera matrix is refreshed through the cache of the camera node
+    group->drawableTransformations(cleanCameraMatrix(), drawableTransforms_);
+  } else {
+    drawableTransforms_ = drawableTransformations(drawables);
+  }
 
   if (flags & Flag::ObjectsOnly) {
     // draw just the OBJECTS
-    size_t numObjects = removeNonObjects(drawableTransforms);
-    drawableTransforms.erase(drawableTransforms.begin() + numObjects,
-                             drawableTransforms.end());
+    size_t numObjects = removeNonObjects(drawableTransforms_);
+    drawableTransforms_.erase(drawableTransforms_.begin() + numObjects,
+                              drawableTransforms_.end());
   }
 
   if (flags & Flag::FrustumCulling) {
-    // draw just the visible part
-    previousNumVisibleDrawables_ = cull(drawableTransforms);
+    // draw just the visible part, using the hierarchies of the group if it
+    // has them
+    previousNumVisibleDrawables_ =
+        group ? cull(*group, drawableTransforms_) : cull(drawableTransforms_);
     // erase all items that did not pass the frustum visibility test
-    drawableTransforms.erase(
-        drawableTransforms.begin() + previousNumVisibleDrawables_,
-        drawableTransforms.end());
+    drawableTransforms_.erase(
+        drawableTransforms_.begin() + previousNumVisibleDrawables_,
+        drawableTransforms_.end());
   }
 
-  MagnumCamera::draw(drawableTransforms);
+  if ((flags & Flag::OcclusionCulling) && occlusionCuller) {
+    // the occluded drawables are kept after the visible ones, as their boxes
+    // are queried again below
+    const size_t numUnoccluded = occlusionCuller->cull(drawableTransforms_);
+    previousNumOccludedDrawables_ = drawableTransforms_.size() - numUnoccluded;
+    previousNumVisibleDrawables_ = numUnoccluded;
+
+    unoccludedTransforms_.assign(drawableTransforms_.begin(),
+                                 drawableTransforms_.begin() + numUnoccluded);
+    drawTransforms(group, unoccludedTransforms_, flags, lightweightShaders);
+    occlusionCuller->issueQueries(drawableTransforms_, cameraMatrix(),
+                                  projectionMatrix());
+    drawableTransforms_.erase(drawableTransforms_.begin() + numUnoccluded,
+                              drawableTransforms_.end());
+  } else {
+    drawTransforms(group, drawableTransforms_, flags, lightweightShaders);
+  }
 
   // reset
   if (useDrawableIds_) {
     useDrawableIds_ = false;
   }
-  return drawableTransforms.size();
+  return drawableTransforms_.size();
+}
+
+void RenderCamera::drawTransforms(
+    DrawableGroup* group,
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms,
+    Flags flags,
+    LightweightShaders* lightweightShaders) {
+  for (const auto& drawableTransform : drawableTransforms) {
+    if (auto* drawable =
+            dynamic_cast<Drawable*>(&drawableTransform.first.get())) {
+      previousNumTriangles_ += numTriangles(drawable->getMesh());
+    }
+  }
+  if (!(flags & Flag::PreserveDrawOrder)) {
+    sortByDrawState(drawableTransforms);
+  }
+
+  if (lightweightShaders && (flags & (Flag::DepthOnly | Flag::ObjectIdOnly))) {
+    const bool objectIds = bool(flags & Flag::ObjectIdOnly);
+    const LightweightPass pass =
+        objectIds ? LightweightPass::ObjectId
+                  : flags & Flag::LinearDepth ? LightweightPass::LinearDepth
+                                              : LightweightPass::Depth;
+    if (pass == LightweightPass::Depth) {
+      Mn::GL::Renderer::setColorMask(false, false, false, false);
+    }
+    remainingTransforms_.clear();
+    for (const auto& drawableTransform : drawableTransforms) {
+      auto* drawable = dynamic_cast<Drawable*>(&drawableTransform.first.get());
+      if (drawable) {
+        drawable->drawLightweight(drawableTransform.second, *this,
+                                  *lightweightShaders, pass);
+      } else {
+        remainingTransforms_.push_back(drawableTransform);
+      }
+    }
+    // drawables which are not ours only know their own shader, so they
+    // only write the depth buffer in a linear depth pass
+    if (pass == LightweightPass::LinearDepth) {
+      Mn::GL::Renderer::setColorMask(false, false, false, false);
+    }
+    MagnumCamera::draw(remainingTransforms_);
+    if (pass != LightweightPass::ObjectId) {
+      Mn::GL::Renderer::setColorMask(true, true, true, true);
+    }
+    return;
+  }
+
+  if (group && group->isInstancingEnabled()) {
+    group->drawInstanced(drawableTransforms, *this);
+  } else {
+    MagnumCamera::draw(drawableTransforms);
+  }
+}
+
+void RenderCamera::sortByDrawState(
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>& drawableTransforms) {
+  drawOrder_.clear();
+  drawOrder_.reserve(drawableTransforms.size());
+  uint32_t run = 0;
+  for (uint32_t i = 0; i < drawableTransforms.size(); ++i) {
+    auto* drawable =
+        dynamic_cast<Drawable*>(&drawableTransforms[i].first.get());
+    // drawables which may depend on the draw order are runs of their own,
+    // so they stay between the drawables drawn before and after them
+    const bool reorderable = drawable && drawable->isOpaque();
+    if (!reorderable) {
+      ++run;
+    }
+    // the camera looks down -Z, so the depth grows with -z
+    drawOrder_.push_back(
+        {run, drawable ? drawable->getDrawStateKey() : DrawStateKey{},
+         -drawableTransforms[i].second.translation().z(), i});
+    if (!reorderable) {
+      ++run;
+    }
+  }
+  std::sort(drawOrder_.begin(), drawOrder_.end(),
+            [](const DrawOrderEntry& a, const DrawOrderEntry& b) {
+              if (a.run != b.run) {
+                return a.run < b.run;
+              }
+              if (a.key < b.key) {
+                return true;
+              }
+              if (b.key < a.key) {
+                return false;
+              }
+              return std::tie(a.depth, a.index) < std::tie(b.depth, b.index);
+            });
+
+  sortedTransforms_.clear();
+  sortedTransforms_.reserve(drawableTransforms.size());
+  for (std::size_t i = 0; i != drawOrder_.size(); ++i) {
+    if (i == 0 || !(drawOrder_[i - 1].key == drawOrder_[i].key)) {
+      ++previousNumDrawStateChanges_;
+    }
+    sortedTransforms_.push_back(drawableTransforms[drawOrder_[i].index]);
+  }
+  std::swap(sortedTransforms_, drawableTransforms);
 }
 
 esp::geo::Ray RenderCamera::unproject(const Mn::Vector2i& viewportPosition) {
@@ -5,15 +5,49 @@
 #ifndef ESP_GFX_RENDERCAMERA_H_
 #define ESP_GFX_RENDERCAMERA_H_
 
+#include <Corrade/Containers/Optional.h>
+#include <Magnum/Math/Frustum.h>
+#include <memory>
+
 #include "magnum.h"
 
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
+#include "esp/gfx/Drawable.h"
+#include "esp/gfx/LightClusters.h"
+#include "esp/gfx/LightParameterCache.h"
 #include "esp/scene/SceneNode.h"
 
 namespace esp {
 namespace gfx {
 
+class DrawableGroup;
+class LightweightShaders;
+class OcclusionCuller;
+
+/**
+ * @brief Identity of a view, for the state a @ref Renderer keeps per view
+ *
+ * Unlike the address of the camera or sensor owning it, it is not reused by
+ * views created after the owner is destroyed, whose state would be stale.
+ * A copy is a new view.
+ */
+class ViewKey {
+ public:
+  ViewKey() = default;
+  ViewKey(const ViewKey&) {}
+  ViewKey& operator=(const ViewKey&) { return *this; }
+
+  /** @brief Key of the view in maps, unique among the live views */
+  const void* id() const { return token_.get(); }
+
+  /** @brief Expires when the view is destroyed */
+  std::weak_ptr<const void> lifetime() const { return token_; }
+
+ private:
+  std::shared_ptr<const char> token_ = std::make_shared<const char>();
+};
+
 class RenderCamera : public MagnumCamera {
  public:
   /**
@@ -38,6 +72,56 @@ class RenderCamera : public MagnumCamera {
      * object id" is not set)
      */
     UseDrawableIdAsObjectId = 1 << 2,
+
+    /**
+     * Cull Drawables whose bounding box was occluded the last time they were
+     * drawn from the same view. Only has an effect if an @ref OcclusionCuller
+     * holding the history of that view is passed to @ref draw(), which
+     * @ref Renderer does per sensor.
+     */
+    OcclusionCulling = 1 << 3,
+
+    /**
+     * Draw the Drawables in the order of the group instead of sorting them by
+     * @ref Drawable::getDrawStateKey() (and front-to-back within the same
+     * state) to minimize shader, material and mesh rebinds. Only the
+     * drawables with @ref Drawable::isOpaque() are ever reordered.
+     */
+    PreserveDrawOrder = 1 << 4,
+
+    /**
+     * Draw only the depth, with color writes masked and a trivial flat
+     * shader instead of the shaders of the Drawables. Only has an effect if
+     * @ref LightweightShaders are passed to @ref draw(), which @ref Renderer
+     * does.
+     */
+    DepthOnly = 1 << 5,
+
+    /**
+     * Draw only the depth and the object ids, with a flat shader instead of
+     * the shaders of the Drawables. Only has an effect if
+     * @ref LightweightShaders are passed to @ref draw(), which @ref Renderer
+     * does.
+     */
+    ObjectIdOnly = 1 << 6,
+
+    /**
+     * Draw the Drawables that passed the culling of the previous @ref draw()
+     * of the same group, from the current camera matrix, instead of culling
+     * them again. Lets views that see the same part of the scene, e.g. the
+     * two eyes of a stereo pair culled against a frustum enclosing both, see
+     * @ref setCullingFrustum(), share one culling pass.
+     */
+    ReuseCulling = 1 << 7,
+
+    /**
+     * Together with @ref Flag::DepthOnly, write the linear depth of the
+     * fragments, their distance along the view direction, to the first
+     * color output instead of masking the color writes, so that the depth
+     * needs no unprojection to be read, see
+     * @ref RenderTarget::renderEnterLinearDepth().
+     */
+    LinearDepth = 1 << 8,
   };
 
   typedef Corrade::Containers::EnumSet<Flag> Flags;
@@ -143,13 +227,30 @@ class RenderCamera : public MagnumCamera {
                                          float zfar,
                                          float scale);
 
+  /**
+   * @brief Cull against @p frustum, in world space, instead of the frustum of
+   * the camera until it's reset with @ref Corrade::Containers::NullOpt
+   */
+  RenderCamera& setCullingFrustum(
+      const Corrade::Containers::Optional<Magnum::Frustum>& frustum) {
+    cullingFrustum_ = frustum;
+    return *this;
+  }
+
   /**
    * @brief Overload function to render the drawables
    * @param drawables, a drawable group containing all the drawables
    * @param frustumCulling, whether do frustum culling or not, default: false
+   * @param occlusionCuller, visibility history of this view, used if @p flags
+   * contain @ref Flag::OcclusionCulling
+   * @param lightweightShaders, shaders used if @p flags contain
+   * @ref Flag::DepthOnly or @ref Flag::ObjectIdOnly
    * @return the number of drawables that are drawn
    */
-  uint32_t draw(MagnumDrawableGroup& drawables, Flags flags = {});
+  uint32_t draw(MagnumDrawableGroup& drawables,
+                Flags flags = {},
+                OcclusionCuller* occlusionCuller = nullptr,
+                LightweightShaders* lightweightShaders = nullptr);
 
   /**
    * @brief performs the frustum culling
@@ -165,6 +266,22 @@ class RenderCamera : public MagnumCamera {
               std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
                         Magnum::Matrix4>>& drawableTransforms);
 
+  /**
+   * @brief performs the frustum culling using the bounding volume hierarchies
+   * of a @ref DrawableGroup
+   * @param group, the group the drawables in @p drawableTransforms belong to
+   * @param drawableTransforms, a vector of pairs of Drawable3D object and its
+   * absolute transformation
+   * @return the number of drawables that are not culled
+   *
+   * Same as the overload above, but culls whole subtrees of the scene at
+   * once, see @ref DrawableGroup::cull().
+   */
+  size_t cull(DrawableGroup& group,
+              std::vector<std::pair<
+                  std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                  Magnum::Matrix4>>& drawableTransforms);
+
   /**
    * @brief Cull Drawables for SceneNodes which are not OBJECT type.
    *
@@ -205,9 +322,133 @@ class RenderCamera : public MagnumCamera {
     return previousNumVisibleDrawables_;
   }
 
+  /**
+   * @brief Query the cached number of Drawables that passed frustum culling
+   * but were skipped by occlusion culling in the most recent render pass.
+   * They are not included in @ref getPreviousNumVisibileDrawables().
+   */
+  size_t getPreviousNumOccludedDrawables() const {
+    return previousNumOccludedDrawables_;
+  }
+
+  /**
+   * @brief The number of times the @ref DrawStateKey changed between the
+   * draws of the most recent render pass, i.e. the shader, material or mesh
+   * binds. 0 if it was drawn with @ref Flag::PreserveDrawOrder.
+   */
+  size_t getPreviousNumDrawStateChanges() const {
+    return previousNumDrawStateChanges_;
+  }
+
+  /**
+   * @brief The number of triangles of the full-detail meshes of the drawables
+   * of the most recent render pass
+   */
+  size_t getPreviousNumTriangles() const { return previousNumTriangles_; }
+
+  /**
+   * @brief Light parameters evaluated for this camera, shared by the drawables
+   * it draws. Invalidated at the start of every @ref draw().
+   */
+  LightParameterCache& lightParameterCache() { return lightParameterCache_; }
+
+  /** @brief Identity of the camera for the state kept per view */
+  const ViewKey& viewKey() const { return viewKey_; }
+
+  /**
+   * @brief The light clusters of @p lightSetup for this camera, shared by the
+   * drawables shaded with @ref PbrShader::Flag::ClusteredLights
+   *
+   * Kept alive with the camera, @ref LightClusters::update() rebins them
+   * when the light parameters or the projection changed.
+   */
+  LightClusters& lightClusters(const LightSetup& lightSetup) {
+    return lightClusters_[&lightSetup];
+  }
+
  protected:
+  /**
+   * @brief Draw @p drawableTransforms, in instanced batches if @p group has
+   * instancing enabled
+   *
+   * Unless @p flags contain @ref Flag::PreserveDrawOrder, the drawables are
+   * reordered with @ref sortByDrawState() first. If @p flags contain
+   * @ref Flag::DepthOnly or @ref Flag::ObjectIdOnly and @p lightweightShaders
+   * is not nullptr, the drawables are drawn with
+   * @ref Drawable::drawLightweight() instead.
+   */
+  void drawTransforms(
+      DrawableGroup* group,
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms,
+      Flags flags,
+      LightweightShaders* lightweightShaders = nullptr);
+
+  /**
+   * @brief Sort @p drawableTransforms by @ref Drawable::getDrawStateKey(),
+   * and front-to-back within the same key
+   *
+   * Only the runs of drawables with @ref Drawable::isOpaque() between the
+   * others are sorted; the others, and drawables which are not a
+   * @ref Drawable, keep their place in the order of the group. The sort is
+   * stable, so ties keep the order of the group.
+   */
+  void sortByDrawState(
+      std::vector<
+          std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>>& drawableTransforms);
+
+  // the frustum culled against
+  Magnum::Frustum cullingFrustum();
+
+  /**
+   * @brief The camera matrix for drawables transformed with the absolute
+   * transformations cached on the scene nodes
+   *
+   * Cleans the camera node through
+   * @ref scene::SceneNode::cachedAbsoluteTransformationMatrix() first, as
+   * Magnum's cameraMatrix() cleans the node and its parents without updating
+   * their caches, and is only refreshed by Magnum when the node was dirty.
+   */
+  Magnum::Matrix4 cleanCameraMatrix();
+
   size_t previousNumVisibleDrawables_ = 0;
+  size_t previousNumOccludedDrawables_ = 0;
+  size_t previousNumDrawStateChanges_ = 0;
+  size_t previousNumTriangles_ = 0;
   bool useDrawableIds_ = false;
+  Corrade::Containers::Optional<Magnum::Frustum> cullingFrustum_;
+  ViewKey viewKey_;
+  // the group whose visible drawables are in drawableTransforms_
+  MagnumDrawableGroup* culledGroup_ = nullptr;
+  // drawables and their transformations for the current draw(), kept to
+  // reuse the allocation across frames
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      drawableTransforms_;
+  // the drawables of drawableTransforms_ that passed occlusion culling
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      unoccludedTransforms_;
+  // the drawables left after the instanced batches were drawn
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      remainingTransforms_;
+  // scratch space of sortByDrawState()
+  struct DrawOrderEntry {
+    //! drawables are only reordered within the same run
+    uint32_t run;
+    DrawStateKey key;
+    float depth;
+    uint32_t index;
+  };
+  std::vector<DrawOrderEntry> drawOrder_;
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+      sortedTransforms_;
+  LightParameterCache lightParameterCache_;
+  std::unordered_map<const LightSetup*, LightClusters> lightClusters_;
   ESP_SMART_POINTERS(RenderCamera)
 };
 
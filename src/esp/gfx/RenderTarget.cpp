@@ -6,6 +6,8 @@
 #include <Magnum/GL/BufferImage.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/OpenGL.h>
 #include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderbuffer.h>
 #include <Magnum/GL/RenderbufferFormat.h>
@@ -15,12 +17,20 @@
 #include <Magnum/Image.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Math/Color.h>
+#include <Magnum/Math/Packing.h>
 #include <Magnum/PixelFormat.h>
 
+#include <algorithm>
+#include <cstring>
+#include <map>
+
 #include "RenderTarget.h"
 #include "magnum.h"
 
+#include "esp/core/PerfStats.h"
+#include "esp/core/Profiling.h"
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/ObjectIdRemapping.h"
 
 #ifdef ESP_BUILD_WITH_CUDA
 #include <cuda_gl_interop.h>
@@ -38,31 +48,165 @@ const Mn::GL::Framebuffer::ColorAttachment RgbaBuffer =
     Mn::GL::Framebuffer::ColorAttachment{0};
 const Mn::GL::Framebuffer::ColorAttachment ObjectIdBuffer =
     Mn::GL::Framebuffer::ColorAttachment{1};
+const Mn::GL::Framebuffer::ColorAttachment LinearDepthBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{2};
 const Mn::GL::Framebuffer::ColorAttachment UnprojectedDepthBuffer =
     Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment NormalBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment PointBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment RemappedObjectIdBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment StridedReadBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+const Mn::GL::Framebuffer::ColorAttachment HistogramBuffer =
+    Mn::GL::Framebuffer::ColorAttachment{0};
+
+namespace {
+
+// The reads are tightly packed, RGB8 and 16-bit rows can have any length
+const Mn::PixelStorage PackedRows = Mn::PixelStorage{}.setAlignment(1);
+
+// The framebuffer a read goes to GL with and the rectangle of it read
+struct ReadSource {
+  Mn::GL::Framebuffer& framebuffer;
+  Mn::Range2Di rectangle;
+};
+
+// The samples of the read region of one attachment format at the read
+// stride, see RenderTarget::Impl::readSource()
+struct StridedRead {
+  Mn::GL::Renderbuffer renderbuffer{Mn::NoCreate};
+  Mn::GL::Framebuffer framebuffer{Mn::NoCreate};
+};
+
+// One meter in the uint16 millimeter depth. The unprojected depth is scaled
+// by it before being read as normalized uint16, which GL rounds and clamps
+const float UnormMillimetersPerMeter = 1000.0f / 65535.0f;
+
+// How depth is read as one of the formats of readFrameDepth(): the GL type
+// the unprojected depth is packed to and the factor it's scaled by first
+struct DepthTransfer {
+  Mn::GL::PixelType type;
+  float scale;
+};
+
+DepthTransfer depthTransfer(Mn::PixelFormat format) {
+  CORRADE_ASSERT(format == Mn::PixelFormat::R32F ||
+                     format == Mn::PixelFormat::R16F ||
+                     format == Mn::PixelFormat::R16UI,
+                 "RenderTarget: depth can't be read as" << format, {});
+  if (format == Mn::PixelFormat::R16F) {
+    return {Mn::GL::PixelType::HalfFloat, 1.0f};
+  }
+  if (format == Mn::PixelFormat::R16UI) {
+    return {Mn::GL::PixelType::UnsignedShort, UnormMillimetersPerMeter};
+  }
+  return {Mn::GL::PixelType::Float, 1.0f};
+}
+
+Mn::GL::PixelFormat rgbaTransferFormat(Mn::PixelFormat format) {
+  CORRADE_ASSERT(format == Mn::PixelFormat::RGBA8Unorm ||
+                     format == Mn::PixelFormat::RGB8Unorm,
+                 "RenderTarget: color can't be read as" << format,
+                 Mn::GL::PixelFormat::RGBA);
+  return format == Mn::PixelFormat::RGB8Unorm ? Mn::GL::PixelFormat::RGB
+                                              : Mn::GL::PixelFormat::RGBA;
+}
+
+// The GL type object ids are read as, narrowed by the transfer for the
+// 8- and 16-bit formats
+Mn::GL::PixelType objectIdTransferType(Mn::PixelFormat format) {
+  CORRADE_ASSERT(format == Mn::PixelFormat::R32UI ||
+                     format == Mn::PixelFormat::R32I ||
+                     format == Mn::PixelFormat::R16UI ||
+                     format == Mn::PixelFormat::R8UI,
+                 "RenderTarget: object ids can't be read as" << format,
+                 Mn::GL::PixelType::UnsignedInt);
+  if (format == Mn::PixelFormat::R32I) {
+    return Mn::GL::PixelType::Int;
+  }
+  if (format == Mn::PixelFormat::R16UI) {
+    return Mn::GL::PixelType::UnsignedShort;
+  }
+  if (format == Mn::PixelFormat::R8UI) {
+    return Mn::GL::PixelType::UnsignedByte;
+  }
+  return Mn::GL::PixelType::UnsignedInt;
+}
+
+// Packs depth unprojected on the CPU to the 16-bit format of @p view, the
+// same way the GPU reads do
+void packDepth(const Mn::MutableImageView2D& depth,
+               const Mn::MutableImageView2D& view) {
+  const Cr::Containers::StridedArrayView2D<const Mn::Float> meters =
+      depth.pixels<Mn::Float>();
+  const Cr::Containers::StridedArrayView2D<Mn::UnsignedShort> packed =
+      view.pixels<Mn::UnsignedShort>();
+  const bool half = view.format() == Mn::PixelFormat::R16F;
+  for (std::size_t y = 0; y != meters.size()[0]; ++y) {
+    for (std::size_t x = 0; x != meters.size()[1]; ++x) {
+      const Mn::Float d = meters[y][x];
+      packed[y][x] =
+          half ? Mn::Math::packHalf(d)
+               : Mn::Math::pack<Mn::UnsignedShort>(Mn::Math::clamp(
+                     d * UnormMillimetersPerMeter, 0.0f, 1.0f));
+    }
+  }
+}
+
+}  // namespace
 
 struct RenderTarget::Impl {
   Impl(const Mn::Vector2i& size,
        const Mn::Vector2& depthUnprojection,
        DepthShader* depthShader,
-       Renderer::Flags flags)
+       Renderer::Flags flags,
+       int samples,
+       bool topDownRows)
       : colorBuffer_{},
-        objectIdBuffer_{},
+        objectIdTexture_{},
         depthRenderTexture_{},
         framebuffer_{Mn::NoCreate},
+        multisampleColorBuffer_{Mn::NoCreate},
+        multisampleObjectIdBuffer_{Mn::NoCreate},
+        multisampleDepthBuffer_{Mn::NoCreate},
+        multisampleFramebuffer_{Mn::NoCreate},
         depthUnprojection_{depthUnprojection},
         depthShader_{depthShader},
+        linearDepth_{Mn::NoCreate},
         unprojectedDepth_{Mn::NoCreate},
         depthUnprojectionMesh_{Mn::NoCreate},
         depthUnprojectionFrameBuffer_{Mn::NoCreate},
-        rendererFlags_{flags} {
+        normals_{Mn::NoCreate},
+        normalReconstructionMesh_{Mn::NoCreate},
+        normalFramebuffer_{Mn::NoCreate},
+        points_{Mn::NoCreate},
+        pointUnprojectionMesh_{Mn::NoCreate},
+        pointFramebuffer_{Mn::NoCreate},
+        remappedObjectIds_{Mn::NoCreate},
+        objectIdRemapMesh_{Mn::NoCreate},
+        objectIdRemapFramebuffer_{Mn::NoCreate},
+        histogram_{Mn::NoCreate},
+        histogramMesh_{Mn::NoCreate},
+        histogramFramebuffer_{Mn::NoCreate},
+        fullViewport_{{}, size},
+        readRegion_{fullViewport_},
+        pendingRead_{Mn::NoCreate},
+        rendererFlags_{flags},
+        topDownRows_{topDownRows} {
     if (depthShader_) {
       CORRADE_INTERNAL_ASSERT(depthShader_->flags() &
                               DepthShader::Flag::UnprojectExistingDepth);
     }
 
     colorBuffer_.setStorage(Mn::GL::RenderbufferFormat::SRGB8Alpha8, size);
-    objectIdBuffer_.setStorage(Mn::GL::RenderbufferFormat::R32UI, size);
+    // a texture, so the object ids can be remapped by a shader
+    objectIdTexture_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+        .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+        .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+        .setStorage(1, Mn::GL::TextureFormat::R32UI, size);
     depthRenderTexture_.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
         .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
         .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
@@ -70,13 +214,88 @@ struct RenderTarget::Impl {
 
     framebuffer_ = Mn::GL::Framebuffer{{{}, size}};
     framebuffer_.attachRenderbuffer(RgbaBuffer, colorBuffer_)
-        .attachRenderbuffer(ObjectIdBuffer, objectIdBuffer_)
+        .attachTexture(ObjectIdBuffer, objectIdTexture_, 0)
         .attachTexture(Mn::GL::Framebuffer::BufferAttachment::Depth,
                        depthRenderTexture_, 0)
         .mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
     CORRADE_INTERNAL_ASSERT(
         framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
         Mn::GL::Framebuffer::Status::Complete);
+
+    if (samples > 1) {
+      initMultisampling(samples);
+    }
+  }
+
+  void initMultisampling(int samples) {
+    // the object ids are an integer attachment, which may support fewer
+    // samples
+    GLint maxIntegerSamples = 0;
+    glGetIntegerv(GL_MAX_INTEGER_SAMPLES, &maxIntegerSamples);
+    samples_ = std::min({samples, Mn::GL::Renderbuffer::maxSamples(),
+                         int(maxIntegerSamples)});
+    if (samples_ != samples) {
+      LOG(WARNING) << "RenderTarget: " << samples
+                   << " samples per pixel requested, the GPU supports "
+                   << samples_;
+    }
+    if (samples_ <= 1) {
+      samples_ = 1;
+      return;
+    }
+
+    const Mn::Vector2i size = framebufferSize();
+    multisampleColorBuffer_ = Mn::GL::Renderbuffer{};
+    multisampleColorBuffer_.setStorageMultisample(
+        samples_, Mn::GL::RenderbufferFormat::SRGB8Alpha8, size);
+    multisampleObjectIdBuffer_ = Mn::GL::Renderbuffer{};
+    multisampleObjectIdBuffer_.setStorageMultisample(
+        samples_, Mn::GL::RenderbufferFormat::R32UI, size);
+    multisampleDepthBuffer_ = Mn::GL::Renderbuffer{};
+    multisampleDepthBuffer_.setStorageMultisample(
+        samples_, Mn::GL::RenderbufferFormat::DepthComponent32F, size);
+
+    multisampleFramebuffer_ = Mn::GL::Framebuffer{{{}, size}};
+    multisampleFramebuffer_
+        .attachRenderbuffer(RgbaBuffer, multisampleColorBuffer_)
+        .attachRenderbuffer(ObjectIdBuffer, multisampleObjectIdBuffer_)
+        .attachRenderbuffer(Mn::GL::Framebuffer::BufferAttachment::Depth,
+                            multisampleDepthBuffer_)
+        .mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+    CORRADE_INTERNAL_ASSERT(
+        multisampleFramebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+        Mn::GL::Framebuffer::Status::Complete);
+  }
+
+  // The framebuffer draws go to, the multisampled one if there is any
+  Mn::GL::Framebuffer& drawFramebuffer() {
+    return samples_ > 1 ? multisampleFramebuffer_ : framebuffer_;
+  }
+
+  // Resolves the multisampled attachments into the ones all reads use, if
+  // anything was drawn since the last resolve. Draws may follow renderExit(),
+  // e.g. the objects-only pass of semantic sensors, so it's done lazily by
+  // the reads instead
+  void resolveMultisampling() {
+    if (!resolvePending_) {
+      return;
+    }
+    resolvePending_ = false;
+
+    // a blit writes to all draw buffers, and normalized and integer
+    // attachments can't be blitted together; the depth sample is kept as is
+    framebuffer_.mapForDraw(RgbaBuffer);
+    Mn::GL::AbstractFramebuffer::blit(
+        multisampleFramebuffer_.mapForRead(RgbaBuffer), framebuffer_,
+        fullViewport_, fullViewport_,
+        Mn::GL::FramebufferBlit::Color | Mn::GL::FramebufferBlit::Depth,
+        Mn::GL::FramebufferBlitFilter::Nearest);
+    framebuffer_.mapForDraw(ObjectIdBuffer);
+    Mn::GL::AbstractFramebuffer::blit(
+        multisampleFramebuffer_.mapForRead(ObjectIdBuffer), framebuffer_,
+        fullViewport_, fullViewport_, Mn::GL::FramebufferBlit::Color,
+        Mn::GL::FramebufferBlitFilter::Nearest);
+    framebuffer_.mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
   }
 
   void initDepthUnprojector() {
@@ -99,25 +318,382 @@ struct RenderTarget::Impl {
     }
   }
 
-  void unprojectDepthGPU() {
+  void unprojectDepthGPU(float scale = 1.0f) {
     CORRADE_INTERNAL_ASSERT(depthShader_ != nullptr);
     initDepthUnprojector();
+    resolveMultisampling();
 
+    // the unprojected depth is proportional to the second coefficient
     depthUnprojectionFrameBuffer_.bind();
     (*depthShader_)
         .bindDepthTexture(depthRenderTexture_)
-        .setDepthUnprojection(depthUnprojection_)
+        .setDepthUnprojection(
+            {depthUnprojection_[0], depthUnprojection_[1] * scale})
         .draw(depthUnprojectionMesh_);
   }
 
+  // The framebuffer, mapped for reading, holding the linear depth scaled by
+  // @p scale: the attachment written by the pass if it can be read as is,
+  // otherwise the depth unprojected on the GPU, or nullptr if there's no
+  // shader to unproject it with
+  Mn::GL::Framebuffer* linearDepthSource(float scale) {
+    resolveMultisampling();
+    if (linearDepthDrawn_ && scale == 1.0f) {
+      return &framebuffer_.mapForRead(LinearDepthBuffer);
+    }
+    if (!depthShader_) {
+      return nullptr;
+    }
+    unprojectDepthGPU(scale);
+    return &depthUnprojectionFrameBuffer_.mapForRead(UnprojectedDepthBuffer);
+  }
+
+  void setNormalShader(DepthShader* normalShader) {
+    if (normalShader) {
+      CORRADE_INTERNAL_ASSERT(normalShader->flags() &
+                              DepthShader::Flag::ReconstructNormals);
+    }
+    normalShader_ = normalShader;
+  }
+
+  void setPixelUnprojection(const Mn::Vector2& pixelUnprojection) {
+    pixelUnprojection_ = pixelUnprojection;
+  }
+
+  void initNormalReconstructor() {
+    if (normalFramebuffer_.id() == 0) {
+      normals_ = Mn::GL::Renderbuffer{};
+      normals_.setStorage(Mn::GL::RenderbufferFormat::RGBA32F,
+                          framebufferSize());
+
+      normalFramebuffer_ = Mn::GL::Framebuffer{{{}, framebufferSize()}};
+      normalFramebuffer_.attachRenderbuffer(NormalBuffer, normals_)
+          .mapForDraw({{0, NormalBuffer}});
+      CORRADE_INTERNAL_ASSERT(
+          normalFramebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+
+      normalReconstructionMesh_ = Mn::GL::Mesh{};
+      normalReconstructionMesh_.setCount(3);
+    }
+  }
+
+  // Reconstructs the normals of the drawn depth into normals_, with the
+  // pixel unprojection of the last draw
+  void reconstructNormalsGPU() {
+    if (normalShader_ == nullptr)
+      throw std::runtime_error(
+          "RenderTarget: normals can only be read from the render target of a "
+          "perspective sensor bound by a Renderer");
+    if (pixelUnprojection_.isZero())
+      throw std::runtime_error(
+          "RenderTarget: normals can only be read after a perspective draw");
+    initNormalReconstructor();
+    resolveMultisampling();
+
+    normalFramebuffer_.bind();
+    (*normalShader_)
+        .bindDepthTexture(depthRenderTexture_)
+        .setDepthUnprojection(depthUnprojection_)
+        .setPixelUnprojection(pixelUnprojection_)
+        .draw(normalReconstructionMesh_);
+  }
+
+  void setPointShader(DepthShader* pointShader) {
+    if (pointShader) {
+      CORRADE_INTERNAL_ASSERT(pointShader->flags() &
+                              DepthShader::Flag::UnprojectPoints);
+    }
+    pointShader_ = pointShader;
+  }
+
+  // The size of the points subsampled by stride, see readFramePoints()
+  Mn::Vector2i pointCloudSize(int stride) const {
+    if (stride < 1 || (framebufferSize() / stride).product() == 0)
+      throw std::runtime_error(
+          "RenderTarget: invalid point cloud stride " + std::to_string(stride));
+    return framebufferSize() / stride;
+  }
+
+  // Unprojects the points of the drawn depth into points_, with the pixel
+  // unprojection of the last draw, returning the viewport they cover
+  Mn::Range2Di unprojectPointsGPU(const Mn::Matrix4& transformation,
+                                  int stride) {
+    if (pointShader_ == nullptr)
+      throw std::runtime_error(
+          "RenderTarget: points can only be read from the render target of a "
+          "perspective sensor bound by a Renderer");
+    if (pixelUnprojection_.isZero())
+      throw std::runtime_error(
+          "RenderTarget: points can only be read after a perspective draw");
+    const Mn::Vector2i size = pointCloudSize(stride);
+    // reallocated only when the stride changes
+    if (pointFramebuffer_.id() == 0 ||
+        pointFramebuffer_.viewport().size() != size) {
+      points_ = Mn::GL::Renderbuffer{};
+      points_.setStorage(Mn::GL::RenderbufferFormat::RGBA32F, size);
+
+      pointFramebuffer_ = Mn::GL::Framebuffer{{{}, size}};
+      pointFramebuffer_.attachRenderbuffer(PointBuffer, points_)
+          .mapForDraw({{0, PointBuffer}});
+      CORRADE_INTERNAL_ASSERT(
+          pointFramebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+
+      pointUnprojectionMesh_ = Mn::GL::Mesh{};
+      pointUnprojectionMesh_.setCount(3);
+    }
+    resolveMultisampling();
+
+    pointFramebuffer_.bind();
+    (*pointShader_)
+        .bindDepthTexture(depthRenderTexture_)
+        .setDepthUnprojection(depthUnprojection_)
+        .setPixelUnprojection(pixelUnprojection_)
+        .setPointTransformation(transformation)
+        .setPointStride(stride)
+        .draw(pointUnprojectionMesh_);
+    return {{}, size};
+  }
+
+  void setObjectIdRemapShader(ObjectIdRemapShader* objectIdRemapShader) {
+    objectIdRemapShader_ = objectIdRemapShader;
+  }
+
+  void setDepthUnprojection(const Mn::Vector2& depthUnprojection) {
+    depthUnprojection_ = depthUnprojection;
+  }
+
+  Mn::Vector2 depthUnprojection() const { return depthUnprojection_; }
+
+  // Remaps the drawn object ids into remappedObjectIds_
+  void remapObjectIdsGPU(ObjectIdRemapping& remapping) {
+    if (objectIdRemapShader_ == nullptr)
+      throw std::runtime_error(
+          "RenderTarget: object ids can only be remapped in the render target "
+          "of a sensor bound by a Renderer");
+    if (objectIdRemapFramebuffer_.id() == 0) {
+      remappedObjectIds_ = Mn::GL::Renderbuffer{};
+      remappedObjectIds_.setStorage(Mn::GL::RenderbufferFormat::R32UI,
+                                    framebufferSize());
+
+      objectIdRemapFramebuffer_ = Mn::GL::Framebuffer{{{}, framebufferSize()}};
+      objectIdRemapFramebuffer_
+          .attachRenderbuffer(RemappedObjectIdBuffer, remappedObjectIds_)
+          .mapForDraw({{0, RemappedObjectIdBuffer}});
+      CORRADE_INTERNAL_ASSERT(
+          objectIdRemapFramebuffer_.checkStatus(
+              Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+
+      objectIdRemapMesh_ = Mn::GL::Mesh{};
+      objectIdRemapMesh_.setCount(3);
+    }
+    resolveMultisampling();
+
+    objectIdRemapFramebuffer_.bind();
+    (*objectIdRemapShader_)
+        .bindObjectIdTexture(objectIdTexture_)
+        .setRemapping(remapping)
+        .draw(objectIdRemapMesh_);
+  }
+
+  // The framebuffer, mapped for reading, holding the object ids of a read
+  // through remapping, remapped first if there is any
+  Mn::GL::Framebuffer& objectIdSource(ObjectIdRemapping* remapping) {
+    if (remapping) {
+      remapObjectIdsGPU(*remapping);
+      return objectIdRemapFramebuffer_.mapForRead(RemappedObjectIdBuffer);
+    }
+    resolveMultisampling();
+    return framebuffer_.mapForRead(ObjectIdBuffer);
+  }
+
+  void setObjectIdHistogramShader(
+      ObjectIdHistogramShader* objectIdHistogramShader) {
+    objectIdHistogramShader_ = objectIdHistogramShader;
+  }
+
+  void readFrameObjectIdHistogram(
+      Cr::Containers::ArrayView<Mn::UnsignedInt> counts,
+      ObjectIdRemapping* remapping) {
+    ESP_PROFILE_SCOPE("RenderTarget::readFrameObjectIdHistogram");
+    ESP_PERF_TIMER(Readback);
+    if (objectIdHistogramShader_ == nullptr)
+      throw std::runtime_error(
+          "RenderTarget: object id histograms can only be read from the "
+          "render target of a sensor bound by a Renderer");
+    CORRADE_ASSERT(!counts.empty(),
+                   "RenderTarget::readFrameObjectIdHistogram(): expected at "
+                   "least one bin", );
+    // the bins wrapped in rows, like the tables of the remappings
+    const Mn::Int width =
+        std::min(ObjectIdRemapping::TextureWidth, Mn::Int(counts.size()));
+    const Mn::Vector2i size{width, (Mn::Int(counts.size()) + width - 1) /
+                                       width};
+    // reallocated only when the size of the bins changes
+    if (histogramFramebuffer_.id() == 0 ||
+        histogramFramebuffer_.viewport().size() != size) {
+      histogram_ = Mn::GL::Renderbuffer{};
+      histogram_.setStorage(Mn::GL::RenderbufferFormat::R32F, size);
+
+      histogramFramebuffer_ = Mn::GL::Framebuffer{{{}, size}};
+      histogramFramebuffer_.attachRenderbuffer(HistogramBuffer, histogram_)
+          .mapForDraw({{0, HistogramBuffer}})
+          .mapForRead(HistogramBuffer);
+      CORRADE_INTERNAL_ASSERT(
+          histogramFramebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+
+      histogramMesh_ = Mn::GL::Mesh{Mn::GL::MeshPrimitive::Points};
+    }
+    resolveMultisampling();
+
+    // a point per counted pixel, each adding one to its bin
+    const Mn::Vector2i pixels = readSize();
+    histogramMesh_.setCount(pixels.product());
+    histogramFramebuffer_.clearColor(0, Mn::Color4{}).bind();
+    Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::Blending);
+    Mn::GL::Renderer::setBlendFunction(Mn::GL::Renderer::BlendFunction::One,
+                                       Mn::GL::Renderer::BlendFunction::One);
+    (*objectIdHistogramShader_)
+        .bindObjectIdTexture(objectIdTexture_)
+        .setRemapping(remapping)
+        .setBins(Mn::UnsignedInt(counts.size()), size)
+        .setRegion(readRegion_.min() + Mn::Vector2i{readStride_ / 2},
+                   pixels.x(), readStride_)
+        .draw(histogramMesh_);
+    Mn::GL::Renderer::setBlendFunction(Mn::GL::Renderer::BlendFunction::One,
+                                       Mn::GL::Renderer::BlendFunction::Zero);
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::Blending);
+
+    Cr::Containers::Array<Mn::Float> bins{Cr::NoInit,
+                                          std::size_t(size.product())};
+    histogramFramebuffer_.read(
+        {{}, size},
+        Mn::MutableImageView2D{Mn::PixelFormat::R32F, size, bins});
+    for (std::size_t i = 0; i != counts.size(); ++i) {
+      counts[i] = Mn::UnsignedInt(bins[i] + 0.5f);
+    }
+  }
+
   void renderEnter() {
-    framebuffer_.clearDepth(1.0);
-    framebuffer_.clearColor(0, Mn::Color4{0, 0, 0, 1});
-    framebuffer_.clearColor(1, Mn::Vector4ui{});
-    framebuffer_.bind();
+    Mn::GL::Framebuffer& framebuffer = drawFramebuffer();
+    if (linearDepthDrawn_) {
+      linearDepthDrawn_ = false;
+      framebuffer_.mapForDraw({{0, RgbaBuffer}, {1, ObjectIdBuffer}});
+    }
+    framebuffer.clearDepth(1.0);
+    framebuffer.clearColor(0, Mn::Color4{0, 0, 0, 1});
+    framebuffer.clearColor(1, Mn::Vector4ui{});
+    framebuffer.bind();
+    resolvePending_ = samples_ > 1;
+  }
+
+  bool renderEnterLinearDepth() {
+    renderEnter();
+    // the linear depth of the samples isn't resolved
+    if (samples_ > 1) {
+      return false;
+    }
+    if (linearDepth_.id() == 0) {
+      linearDepth_ = Mn::GL::Renderbuffer{};
+      linearDepth_.setStorage(Mn::GL::RenderbufferFormat::R32F,
+                              framebufferSize());
+      framebuffer_.attachRenderbuffer(LinearDepthBuffer, linearDepth_);
+    }
+    // the other attachments are cleared as well, for the reads of other
+    // sensors sharing the pass
+    framebuffer_.mapForDraw({{0, LinearDepthBuffer}});
+    CORRADE_INTERNAL_ASSERT(
+        framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+        Mn::GL::Framebuffer::Status::Complete);
+    framebuffer_.clearColor(0, Mn::Color4{});
+    linearDepthDrawn_ = true;
+    return true;
+  }
+
+  void renderReEnter() {
+    drawFramebuffer().bind();
+    resolvePending_ = samples_ > 1;
+  }
+
+  void setViewport(const Mn::Range2Di& viewport) {
+    // setViewport() also updates the GL viewport when the framebuffer is bound
+    drawFramebuffer().setViewport(viewport);
+  }
+
+  void resetViewport() { drawFramebuffer().setViewport(fullViewport_); }
+
+  void setReadRegion(const Mn::Range2Di& region, int stride) {
+    const Mn::Range2Di readRegion =
+        region.size().isZero() ? fullViewport_ : region;
+    if (stride < 1 || (readRegion.min() < Mn::Vector2i{0}).any() ||
+        (readRegion.max() > framebufferSize()).any() ||
+        (readRegion.size() < Mn::Vector2i{stride}).any())
+      throw std::runtime_error(
+          "RenderTarget::setReadRegion(): the region has to be inside the "
+          "framebuffer and at least as large as the positive stride");
+    readRegion_ = readRegion;
+    readStride_ = stride;
+  }
+
+  Mn::Range2Di readRegion() const { return readRegion_; }
+
+  int readStride() const { return readStride_; }
+
+  Mn::Vector2i readSize() const { return readRegion_.size() / readStride_; }
+
+  // Whether the reads are of the whole framebuffer, which the CUDA reads
+  // copy from the attachments directly
+  bool readsWholeFramebuffer() const {
+    return readRegion_ == fullViewport_ && readStride_ == 1;
   }
 
-  void renderReEnter() { framebuffer_.bind(); }
+  // The read region of the attachment of @p source mapped for reading, of
+  // @p format: without a stride the region itself, otherwise its samples,
+  // blitted to a framebuffer of their own so that only they are read
+  ReadSource readSource(
+      Mn::GL::Framebuffer& source,
+      Mn::GL::RenderbufferFormat format,
+      Mn::GL::FramebufferBlit mask = Mn::GL::FramebufferBlit::Color) {
+    if (readStride_ == 1) {
+      return {source, readRegion_};
+    }
+    const Mn::Vector2i size = readSize();
+    StridedRead& strided = stridedReads_[format];
+    // reallocated only when the size of the reads changes
+    if (strided.framebuffer.id() == 0 ||
+        strided.framebuffer.viewport().size() != size) {
+      strided.renderbuffer = Mn::GL::Renderbuffer{};
+      strided.renderbuffer.setStorage(format, size);
+
+      strided.framebuffer = Mn::GL::Framebuffer{{{}, size}};
+      if (mask & Mn::GL::FramebufferBlit::Depth) {
+        strided.framebuffer
+            .attachRenderbuffer(Mn::GL::Framebuffer::BufferAttachment::Depth,
+                                strided.renderbuffer)
+            .mapForDraw(Mn::GL::Framebuffer::DrawAttachment::None);
+      } else {
+        strided.framebuffer
+            .attachRenderbuffer(StridedReadBuffer, strided.renderbuffer)
+            .mapForDraw({{0, StridedReadBuffer}})
+            .mapForRead(StridedReadBuffer);
+      }
+      CORRADE_INTERNAL_ASSERT(
+          strided.framebuffer.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+          Mn::GL::Framebuffer::Status::Complete);
+    }
+    resolveMultisampling();
+
+    // scaling every stride by stride block down to a pixel, the nearest
+    // filter picks its center one, like the points of unprojectPointsGPU()
+    Mn::GL::AbstractFramebuffer::blit(
+        source, strided.framebuffer,
+        {readRegion_.min(), readRegion_.min() + size * readStride_},
+        {{}, size}, mask, Mn::GL::FramebufferBlitFilter::Nearest);
+    return {strided.framebuffer, {{}, size}};
+  }
 
   void renderExit() {}
 
@@ -126,155 +702,611 @@ struct RenderTarget::Impl {
       throw std::runtime_error(
           "Simulator was initialized with requiresTextures = false");
 
+    resolveMultisampling();
     framebuffer_.mapForRead(RgbaBuffer);
     ASSERT(framebuffer_.viewport() == Mn::GL::defaultFramebuffer.viewport());
 
+    // the default framebuffer is bottom-up, a blit to a flipped rectangle
+    // turns a top-down image upright
+    Mn::Range2Di target = Mn::GL::defaultFramebuffer.viewport();
+    if (topDownRows_) {
+      target = {{target.left(), target.top()},
+                {target.right(), target.bottom()}};
+    }
     Mn::GL::AbstractFramebuffer::blit(
         framebuffer_, Mn::GL::defaultFramebuffer, framebuffer_.viewport(),
-        Mn::GL::defaultFramebuffer.viewport(), Mn::GL::FramebufferBlit::Color,
+        target, Mn::GL::FramebufferBlit::Color,
         Mn::GL::FramebufferBlitFilter::Nearest);
   }
 
   void readFrameRgba(const Mn::MutableImageView2D& view) {
+    ESP_PROFILE_SCOPE("RenderTarget::readFrameRgba");
+    ESP_PERF_TIMER(Readback);
     if (rendererFlags_ & Renderer::Flag::NoTextures)
       throw std::runtime_error(
           "Simulator was initialized with requiresTextures = false");
 
-    framebuffer_.mapForRead(RgbaBuffer).read(framebuffer_.viewport(), view);
+    resolveMultisampling();
+    const ReadSource read =
+        readSource(framebuffer_.mapForRead(RgbaBuffer),
+                   Mn::GL::RenderbufferFormat::SRGB8Alpha8);
+    read.framebuffer.read(read.rectangle, view);
   }
 
   void readFrameDepth(const Mn::MutableImageView2D& view) {
-    if (depthShader_) {
-      unprojectDepthGPU();
-      depthUnprojectionFrameBuffer_.mapForRead(UnprojectedDepthBuffer)
-          .read(framebuffer_.viewport(), view);
-    } else {
+    ESP_PROFILE_SCOPE("RenderTarget::readFrameDepth");
+    ESP_PERF_TIMER(Readback);
+    const DepthTransfer transfer = depthTransfer(view.format());
+    if (Mn::GL::Framebuffer* source = linearDepthSource(transfer.scale)) {
+      // normalized, not integer, uint16 for the millimeters
+      Mn::MutableImageView2D packedView{view.storage(),
+                                        Mn::GL::PixelFormat::Red,
+                                        transfer.type, view.size(),
+                                        view.data()};
+      const ReadSource read =
+          readSource(*source, Mn::GL::RenderbufferFormat::R32F);
+      read.framebuffer.read(read.rectangle, packedView);
+    } else if (view.format() == Mn::PixelFormat::R32F) {
       Mn::MutableImageView2D depthBufferView{
           Mn::GL::PixelFormat::DepthComponent, Mn::GL::PixelType::Float,
           view.size(), view.data()};
-      framebuffer_.read(framebuffer_.viewport(), depthBufferView);
-      unprojectDepth(depthUnprojection_,
-                     Cr::Containers::arrayCast<Mn::Float>(view.data()));
+      const ReadSource read = depthBufferSource();
+      read.framebuffer.read(read.rectangle, depthBufferView);
+      unprojectDepth(depthUnprojection_, view);
+    } else {
+      Cr::Containers::Array<char> meters{
+          Cr::NoInit, std::size_t(view.size().product()) * sizeof(Mn::Float)};
+      Mn::MutableImageView2D depthBufferView{
+          Mn::GL::PixelFormat::DepthComponent, Mn::GL::PixelType::Float,
+          view.size(), meters};
+      const ReadSource read = depthBufferSource();
+      read.framebuffer.read(read.rectangle, depthBufferView);
+      Mn::MutableImageView2D depth{Mn::PixelFormat::R32F, view.size(),
+                                   meters};
+      unprojectDepth(depthUnprojection_, depth);
+      packDepth(depth, view);
     }
   }
 
-  void readFrameObjectId(const Mn::MutableImageView2D& view) {
-    framebuffer_.mapForRead(ObjectIdBuffer).read(framebuffer_.viewport(), view);
+  void readFrameDepthBuffer(const Mn::MutableImageView2D& view) {
+    ESP_PROFILE_SCOPE("RenderTarget::readFrameDepthBuffer");
+    ESP_PERF_TIMER(Readback);
+    CORRADE_ASSERT(view.format() == Mn::PixelFormat::R32F,
+                   "RenderTarget::readFrameDepthBuffer(): expected R32F, got"
+                       << view.format(), );
+    resolveMultisampling();
+    Mn::MutableImageView2D depthBufferView{
+        view.storage(), Mn::GL::PixelFormat::DepthComponent,
+        Mn::GL::PixelType::Float, view.size(), view.data()};
+    const ReadSource read = depthBufferSource();
+    read.framebuffer.read(read.rectangle, depthBufferView);
   }
 
-  Mn::Vector2i framebufferSize() const {
-    return framebuffer_.viewport().size();
+  // The read region of the depth buffer
+  ReadSource depthBufferSource() {
+    return readSource(framebuffer_,
+                      Mn::GL::RenderbufferFormat::DepthComponent32F,
+                      Mn::GL::FramebufferBlit::Depth);
   }
 
-#ifdef ESP_BUILD_WITH_CUDA
-  void readFrameRgbaGPU(uint8_t* devPtr) {
-    // TODO: Consider implementing the GPU read functions with EGLImage
-    // See discussion here:
-    // https://github.com/facebookresearch/habitat-sim/pull/114#discussion_r312718502
+  void readFrameObjectId(const Mn::MutableImageView2D& view,
+                         ObjectIdRemapping* remapping) {
+    ESP_PROFILE_SCOPE("RenderTarget::readFrameObjectId");
+    ESP_PERF_TIMER(Readback);
+    const ReadSource read = readSource(objectIdSource(remapping),
+                                       Mn::GL::RenderbufferFormat::R32UI);
+    read.framebuffer.read(read.rectangle, view);
+  }
+
+  void readFrameNormal(const Mn::MutableImageView2D& view) {
+    ESP_PROFILE_SCOPE("RenderTarget::readFrameNormal");
+    ESP_PERF_TIMER(Readback);
+    CORRADE_ASSERT(view.format() == Mn::PixelFormat::RGB32F,
+                   "RenderTarget: normals can't be read as" << view.format(), );
+    reconstructNormalsGPU();
+    const ReadSource read =
+        readSource(normalFramebuffer_.mapForRead(NormalBuffer),
+                   Mn::GL::RenderbufferFormat::RGBA32F);
+    read.framebuffer.read(read.rectangle, view);
+  }
+
+  void readFramePoints(const Mn::MutableImageView2D& view,
+                       const Mn::Matrix4& transformation,
+                       int stride) {
+    ESP_PROFILE_SCOPE("RenderTarget::readFramePoints");
+    ESP_PERF_TIMER(Readback);
+    CORRADE_ASSERT(view.format() == Mn::PixelFormat::RGB32F &&
+                       view.size() == pointCloudSize(stride),
+                   "RenderTarget: points can't be read into a" << view.format()
+                       << view.size() << "view", );
+    const Mn::Range2Di viewport = unprojectPointsGPU(transformation, stride);
+    pointFramebuffer_.mapForRead(PointBuffer).read(viewport, view);
+  }
 
+  // Reads viewport of the source, the read region if empty
+  void startAsyncRead(Mn::GL::AbstractFramebuffer& source,
+                      Mn::GL::PixelFormat format,
+                      Mn::GL::PixelType type,
+                      bool unprojectOnFence,
+                      const Mn::Range2Di& viewport = {}) {
+    discardPendingRead();
+    resolveMultisampling();
+    // reuse the pixel buffer across frames; read() reallocates it only if the
+    // size or format changed
+    if (pendingRead_.buffer().id() == 0 || pendingRead_.format() != format ||
+        pendingRead_.type() != type) {
+      pendingRead_ = Mn::GL::BufferImage2D{PackedRows, format, type};
+    }
+    source.read(viewport.size().isZero() ? readRegion_ : viewport,
+                pendingRead_, Mn::GL::BufferUsage::StreamRead);
+    pendingReadFence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // isPendingReadReady() polls without flushing, so the fence has to be
+    // submitted here or it may never signal
+    glFlush();
+    pendingReadUnprojectDepth_ = unprojectOnFence;
+  }
+
+  void readFrameRgbaAsync(Mn::PixelFormat format) {
     if (rendererFlags_ & Renderer::Flag::NoTextures)
       throw std::runtime_error(
           "Simulator was initialized with requiresTextures = false");
 
-    if (colorBufferCugl_ == nullptr)
-      checkCudaErrors(cudaGraphicsGLRegisterImage(
-          &colorBufferCugl_, colorBuffer_.id(), GL_RENDERBUFFER,
-          cudaGraphicsRegisterFlagsReadOnly));
+    const ReadSource read =
+        readSource(framebuffer_.mapForRead(RgbaBuffer),
+                   Mn::GL::RenderbufferFormat::SRGB8Alpha8);
+    startAsyncRead(read.framebuffer, rgbaTransferFormat(format),
+                   Mn::GL::PixelType::UnsignedByte, false, read.rectangle);
+  }
 
-    checkCudaErrors(cudaGraphicsMapResources(1, &colorBufferCugl_, 0));
+  void readFrameDepthAsync(Mn::PixelFormat format) {
+    const DepthTransfer transfer = depthTransfer(format);
+    if (Mn::GL::Framebuffer* source = linearDepthSource(transfer.scale)) {
+      const ReadSource read =
+          readSource(*source, Mn::GL::RenderbufferFormat::R32F);
+      startAsyncRead(read.framebuffer, Mn::GL::PixelFormat::Red,
+                     transfer.type, false, read.rectangle);
+    } else {
+      // packed to the format of the view in fence()
+      const ReadSource read = depthBufferSource();
+      startAsyncRead(read.framebuffer, Mn::GL::PixelFormat::DepthComponent,
+                     Mn::GL::PixelType::Float, true, read.rectangle);
+    }
+  }
 
-    cudaArray* array = nullptr;
-    checkCudaErrors(
-        cudaGraphicsSubResourceGetMappedArray(&array, colorBufferCugl_, 0, 0));
-    const int widthInBytes = framebufferSize().x() * 4 * sizeof(uint8_t);
-    checkCudaErrors(cudaMemcpy2DFromArray(devPtr, widthInBytes, array, 0, 0,
-                                          widthInBytes, framebufferSize().y(),
-                                          cudaMemcpyDeviceToDevice));
+  void readFrameObjectIdAsync(Mn::PixelFormat format,
+                              ObjectIdRemapping* remapping) {
+    const ReadSource read = readSource(objectIdSource(remapping),
+                                       Mn::GL::RenderbufferFormat::R32UI);
+    startAsyncRead(read.framebuffer, Mn::GL::PixelFormat::RedInteger,
+                   objectIdTransferType(format), false, read.rectangle);
+  }
 
-    checkCudaErrors(cudaGraphicsUnmapResources(1, &colorBufferCugl_, 0));
+  void readFrameNormalAsync() {
+    reconstructNormalsGPU();
+    const ReadSource read =
+        readSource(normalFramebuffer_.mapForRead(NormalBuffer),
+                   Mn::GL::RenderbufferFormat::RGBA32F);
+    startAsyncRead(read.framebuffer, Mn::GL::PixelFormat::RGB,
+                   Mn::GL::PixelType::Float, false, read.rectangle);
   }
 
-  void readFrameDepthGPU(float* devPtr) {
-    unprojectDepthGPU();
+  void readFramePointsAsync(const Mn::Matrix4& transformation, int stride) {
+    const Mn::Range2Di viewport = unprojectPointsGPU(transformation, stride);
+    startAsyncRead(pointFramebuffer_.mapForRead(PointBuffer),
+                   Mn::GL::PixelFormat::RGB, Mn::GL::PixelType::Float, false,
+                   viewport);
+  }
 
-    if (depthBufferCugl_ == nullptr)
-      checkCudaErrors(cudaGraphicsGLRegisterImage(
-          &depthBufferCugl_, unprojectedDepth_.id(), GL_RENDERBUFFER,
+  bool hasPendingRead() const { return pendingReadFence_ != nullptr; }
+
+  bool isPendingReadReady() {
+    if (!hasPendingRead())
+      return false;
+    // a zero timeout only polls the fence
+    const GLenum status = glClientWaitSync(pendingReadFence_, 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+  }
+
+  void fence(const Mn::MutableImageView2D& view) {
+    ESP_PROFILE_SCOPE("RenderTarget::fence");
+    ESP_PERF_TIMER(Readback);
+    if (!hasPendingRead())
+      throw std::runtime_error(
+          "RenderTarget::fence(): no asynchronous read is pending");
+
+    const std::size_t byteSize = pendingRead_.size().product() *
+                                 pendingRead_.pixelSize();
+    // depth unprojected on the CPU is read as floats and packed afterwards
+    const bool packDepthOnFence = pendingReadUnprojectDepth_ &&
+                                  view.format() != Mn::PixelFormat::R32F;
+    const std::size_t viewByteSize =
+        packDepthOnFence
+            ? pendingRead_.size().product() * Mn::pixelSize(view.format())
+            : byteSize;
+    CORRADE_ASSERT(view.size() == pendingRead_.size() &&
+                       view.data().size() >= viewByteSize &&
+                       (view.size().x() * view.pixelSize()) %
+                               view.storage().alignment() ==
+                           0,
+                   "RenderTarget::fence(): view does not match the pending "
+                   "read", );
+    Cr::Containers::Array<char> meters;
+    char* target = view.data();
+    if (packDepthOnFence) {
+      meters = Cr::Containers::Array<char>{Cr::NoInit, byteSize};
+      target = meters.data();
+    }
+
+    // flush so the fence is guaranteed to signal, then wait for the
+    // transfer to land in the pixel buffer
+    GLenum status = GL_TIMEOUT_EXPIRED;
+    while (status == GL_TIMEOUT_EXPIRED) {
+      status = glClientWaitSync(pendingReadFence_, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                kFenceTimeoutNs);
+    }
+    CORRADE_INTERNAL_ASSERT(status != GL_WAIT_FAILED);
+
+#ifndef MAGNUM_TARGET_WEBGL
+    Cr::Containers::ArrayView<char> mapped = pendingRead_.buffer().map(
+        0, byteSize, Mn::GL::Buffer::MapFlag::Read);
+    CORRADE_INTERNAL_ASSERT(mapped);
+    std::memcpy(target, mapped.data(), byteSize);
+    pendingRead_.buffer().unmap();
+#else
+    // WebGL cannot map buffers; fall back to a (blocking) sub-data copy
+    pendingRead_.buffer().bind(Mn::GL::Buffer::TargetHint::PixelPack);
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, byteSize, target);
+#endif
+
+    if (packDepthOnFence) {
+      Mn::MutableImageView2D depth{Mn::PixelFormat::R32F, view.size(),
+                                   meters};
+      unprojectDepth(depthUnprojection_, depth);
+      packDepth(depth, view);
+    } else if (pendingReadUnprojectDepth_) {
+      unprojectDepth(depthUnprojection_, view);
+    }
+    discardPendingRead();
+  }
+
+  void discardPendingRead() {
+    if (pendingReadFence_ != nullptr) {
+      glDeleteSync(pendingReadFence_);
+      pendingReadFence_ = nullptr;
+    }
+    pendingReadUnprojectDepth_ = false;
+  }
+
+  Mn::Vector2i framebufferSize() const { return fullViewport_.size(); }
+
+  int samples() const { return samples_; }
+
+  // The attachments and pixel buffers allocated so far, by the size of their
+  // formats
+  std::size_t gpuBytes() const {
+    const std::size_t pixels = framebufferSize().product();
+    // the color, object id and depth attachments, 4 bytes per pixel each
+    std::size_t bytes = pixels * 12;
+    if (samples_ > 1) {
+      bytes += pixels * 12 * samples_;
+    }
+    const auto add = [&](const Mn::GL::Renderbuffer& renderbuffer,
+                         std::size_t pixelBytes, const Mn::Vector2i& size) {
+      if (renderbuffer.id()) {
+        bytes += pixelBytes * size.product();
+      }
+    };
+    add(linearDepth_, 4, framebufferSize());
+    add(unprojectedDepth_, 4, framebufferSize());
+    add(normals_, 16, framebufferSize());
+    add(points_, 16, pointFramebuffer_.viewport().size());
+    add(remappedObjectIds_, 4, framebufferSize());
+    add(histogram_, 4, histogramFramebuffer_.viewport().size());
+    for (const auto& strided : stridedReads_) {
+      add(strided.second.renderbuffer,
+          strided.first == Mn::GL::RenderbufferFormat::RGBA32F ? 16 : 4,
+          strided.second.framebuffer.viewport().size());
+    }
+    bytes += pendingRead_.size().product() * pendingRead_.pixelSize();
+#ifdef ESP_BUILD_WITH_CUDA
+    bytes += packedRead_.size().product() * packedRead_.pixelSize();
+#endif
+    return bytes;
+  }
+
+  bool topDownRows() const { return topDownRows_; }
+
+#ifdef ESP_BUILD_WITH_CUDA
+  // Reads @p source into a pixel buffer on the GPU, which GL packs to
+  // @p format and @p type, and copies the buffer to @p devPtr on @p stream
+  // Reads viewport of the source, the read region if empty
+  void readFramePackedGPU(Mn::GL::AbstractFramebuffer& source,
+                          Mn::GL::PixelFormat format,
+                          Mn::GL::PixelType type,
+                          void* devPtr,
+                          cudaStream_t stream,
+                          const Mn::Range2Di& viewport = {}) {
+    if (packedRead_.buffer().id() == 0 || packedRead_.format() != format ||
+        packedRead_.type() != type) {
+      unregisterPackedRead();
+      packedRead_ = Mn::GL::BufferImage2D{PackedRows, format, type};
+    }
+    source.read(viewport.size().isZero() ? readRegion_ : viewport,
+                packedRead_, Mn::GL::BufferUsage::StreamCopy);
+    const std::size_t byteSize =
+        packedRead_.size().product() * packedRead_.pixelSize();
+
+    // registered again only if the read had to grow the buffer
+    if (packedReadCugl_ != nullptr && packedReadCuglSize_ < byteSize) {
+      unregisterPackedRead();
+    }
+    if (packedReadCugl_ == nullptr) {
+      checkCudaErrors(cudaGraphicsGLRegisterBuffer(
+          &packedReadCugl_, packedRead_.buffer().id(),
           cudaGraphicsRegisterFlagsReadOnly));
+      packedReadCuglSize_ = packedRead_.dataSize();
+    }
 
-    checkCudaErrors(cudaGraphicsMapResources(1, &depthBufferCugl_, 0));
+    checkCudaErrors(cudaGraphicsMapResources(1, &packedReadCugl_, stream));
 
-    cudaArray* array = nullptr;
-    checkCudaErrors(
-        cudaGraphicsSubResourceGetMappedArray(&array, depthBufferCugl_, 0, 0));
-    const int widthInBytes = framebufferSize().x() * 1 * sizeof(float);
-    checkCudaErrors(cudaMemcpy2DFromArray(devPtr, widthInBytes, array, 0, 0,
-                                          widthInBytes, framebufferSize().y(),
-                                          cudaMemcpyDeviceToDevice));
+    void* mapped = nullptr;
+    std::size_t mappedSize = 0;
+    checkCudaErrors(cudaGraphicsResourceGetMappedPointer(&mapped, &mappedSize,
+                                                         packedReadCugl_));
+    CORRADE_INTERNAL_ASSERT(mappedSize >= byteSize);
+    checkCudaErrors(cudaMemcpyAsync(devPtr, mapped, byteSize,
+                                    cudaMemcpyDeviceToDevice, stream));
 
-    checkCudaErrors(cudaGraphicsUnmapResources(1, &depthBufferCugl_, 0));
+    checkCudaErrors(cudaGraphicsUnmapResources(1, &packedReadCugl_, stream));
   }
 
-  void readFrameObjectIdGPU(int32_t* devPtr) {
-    if (objecIdBufferCugl_ == nullptr)
+  // Copies the mapped array of @p resource, registered with CUDA first if
+  // null, to @p devPtr on @p stream
+  void readFrameArrayGPU(cudaGraphicsResource_t& resource,
+                         GLuint image,
+                         GLenum target,
+                         std::size_t pixelSize,
+                         void* devPtr,
+                         cudaStream_t stream) {
+    if (resource == nullptr)
       checkCudaErrors(cudaGraphicsGLRegisterImage(
-          &objecIdBufferCugl_, objectIdBuffer_.id(), GL_RENDERBUFFER,
-          cudaGraphicsRegisterFlagsReadOnly));
+          &resource, image, target, cudaGraphicsRegisterFlagsReadOnly));
 
-    checkCudaErrors(cudaGraphicsMapResources(1, &objecIdBufferCugl_, 0));
+    checkCudaErrors(cudaGraphicsMapResources(1, &resource, stream));
 
     cudaArray* array = nullptr;
-    checkCudaErrors(cudaGraphicsSubResourceGetMappedArray(
-        &array, objecIdBufferCugl_, 0, 0));
-    const int widthInBytes = framebufferSize().x() * 1 * sizeof(int32_t);
-    checkCudaErrors(cudaMemcpy2DFromArray(devPtr, widthInBytes, array, 0, 0,
-                                          widthInBytes, framebufferSize().y(),
-                                          cudaMemcpyDeviceToDevice));
+    checkCudaErrors(
+        cudaGraphicsSubResourceGetMappedArray(&array, resource, 0, 0));
+    const std::size_t widthInBytes = framebufferSize().x() * pixelSize;
+    checkCudaErrors(cudaMemcpy2DFromArrayAsync(
+        devPtr, widthInBytes, array, 0, 0, widthInBytes, framebufferSize().y(),
+        cudaMemcpyDeviceToDevice, stream));
+
+    checkCudaErrors(cudaGraphicsUnmapResources(1, &resource, stream));
+  }
+
+  void unregisterPackedRead() {
+    if (packedReadCugl_ != nullptr) {
+      checkCudaErrors(cudaGraphicsUnregisterResource(packedReadCugl_));
+      packedReadCugl_ = nullptr;
+    }
+  }
+
+  void readFrameRgbaGPU(uint8_t* devPtr,
+                        Mn::PixelFormat format,
+                        cudaStream_t stream) {
+    ESP_PERF_TIMER(Readback);
+    // TODO: Consider implementing the GPU read functions with EGLImage
+    // See discussion here:
+    // https://github.com/facebookresearch/habitat-sim/pull/114#discussion_r312718502
+
+    if (rendererFlags_ & Renderer::Flag::NoTextures)
+      throw std::runtime_error(
+          "Simulator was initialized with requiresTextures = false");
+
+    resolveMultisampling();
+    if (format != Mn::PixelFormat::RGBA8Unorm || !readsWholeFramebuffer()) {
+      const ReadSource read =
+          readSource(framebuffer_.mapForRead(RgbaBuffer),
+                     Mn::GL::RenderbufferFormat::SRGB8Alpha8);
+      readFramePackedGPU(read.framebuffer, rgbaTransferFormat(format),
+                         Mn::GL::PixelType::UnsignedByte, devPtr, stream,
+                         read.rectangle);
+      return;
+    }
+
+    readFrameArrayGPU(colorBufferCugl_, colorBuffer_.id(), GL_RENDERBUFFER,
+                      4 * sizeof(uint8_t), devPtr, stream);
+  }
+
+  void readFrameDepthGPU(void* devPtr,
+                         Mn::PixelFormat format,
+                         cudaStream_t stream) {
+    ESP_PERF_TIMER(Readback);
+    const DepthTransfer transfer = depthTransfer(format);
+    Mn::GL::Framebuffer* source = linearDepthSource(transfer.scale);
+    CORRADE_INTERNAL_ASSERT(source);
+
+    if (format != Mn::PixelFormat::R32F || !readsWholeFramebuffer()) {
+      const ReadSource read =
+          readSource(*source, Mn::GL::RenderbufferFormat::R32F);
+      readFramePackedGPU(read.framebuffer, Mn::GL::PixelFormat::Red,
+                         transfer.type, devPtr, stream, read.rectangle);
+      return;
+    }
+
+    if (linearDepthDrawn_) {
+      readFrameArrayGPU(linearDepthCugl_, linearDepth_.id(), GL_RENDERBUFFER,
+                        sizeof(float), devPtr, stream);
+      return;
+    }
+    readFrameArrayGPU(depthBufferCugl_, unprojectedDepth_.id(),
+                      GL_RENDERBUFFER, sizeof(float), devPtr, stream);
+  }
 
-    checkCudaErrors(cudaGraphicsUnmapResources(1, &objecIdBufferCugl_, 0));
+  void readFrameObjectIdGPU(void* devPtr,
+                            Mn::PixelFormat format,
+                            ObjectIdRemapping* remapping,
+                            cudaStream_t stream) {
+    ESP_PERF_TIMER(Readback);
+    // the remapped, the narrowed and the partial ids go through a pixel
+    // buffer
+    if (remapping || !readsWholeFramebuffer() ||
+        (format != Mn::PixelFormat::R32UI &&
+         format != Mn::PixelFormat::R32I)) {
+      const ReadSource read = readSource(objectIdSource(remapping),
+                                         Mn::GL::RenderbufferFormat::R32UI);
+      readFramePackedGPU(read.framebuffer, Mn::GL::PixelFormat::RedInteger,
+                         objectIdTransferType(format), devPtr, stream,
+                         read.rectangle);
+      return;
+    }
+
+    resolveMultisampling();
+    readFrameArrayGPU(objecIdBufferCugl_, objectIdTexture_.id(), GL_TEXTURE_2D,
+                      sizeof(int32_t), devPtr, stream);
+  }
+
+  void readFrameNormalGPU(float* devPtr, cudaStream_t stream) {
+    ESP_PERF_TIMER(Readback);
+    reconstructNormalsGPU();
+    const ReadSource read =
+        readSource(normalFramebuffer_.mapForRead(NormalBuffer),
+                   Mn::GL::RenderbufferFormat::RGBA32F);
+    readFramePackedGPU(read.framebuffer, Mn::GL::PixelFormat::RGB,
+                       Mn::GL::PixelType::Float, devPtr, stream,
+                       read.rectangle);
+  }
+
+  void readFramePointsGPU(float* devPtr,
+                          const Mn::Matrix4& transformation,
+                          int stride,
+                          cudaStream_t stream) {
+    ESP_PERF_TIMER(Readback);
+    const Mn::Range2Di viewport = unprojectPointsGPU(transformation, stride);
+    readFramePackedGPU(pointFramebuffer_.mapForRead(PointBuffer),
+                       Mn::GL::PixelFormat::RGB, Mn::GL::PixelType::Float,
+                       devPtr, stream, viewport);
+  }
+
+  int cudaDeviceId() {
+    if (cudaDeviceId_ < 0) {
+      // the device driving the current OpenGL context, the render target is
+      // created in it
+      unsigned int count = 0;
+      checkCudaErrors(
+          cudaGLGetDevices(&count, &cudaDeviceId_, 1, cudaGLDeviceListAll));
+      CORRADE_INTERNAL_ASSERT(count > 0);
+    }
+    return cudaDeviceId_;
   }
 #endif
 
   ~Impl() {
+    discardPendingRead();
 #ifdef ESP_BUILD_WITH_CUDA
     if (colorBufferCugl_ != nullptr)
       checkCudaErrors(cudaGraphicsUnregisterResource(colorBufferCugl_));
     if (depthBufferCugl_ != nullptr)
       checkCudaErrors(cudaGraphicsUnregisterResource(depthBufferCugl_));
+    if (linearDepthCugl_ != nullptr)
+      checkCudaErrors(cudaGraphicsUnregisterResource(linearDepthCugl_));
     if (objecIdBufferCugl_ != nullptr)
       checkCudaErrors(cudaGraphicsUnregisterResource(objecIdBufferCugl_));
+    unregisterPackedRead();
 #endif
   }
 
  private:
   Mn::GL::Renderbuffer colorBuffer_;
-  Mn::GL::Renderbuffer objectIdBuffer_;
+  Mn::GL::Texture2D objectIdTexture_;
   Mn::GL::Texture2D depthRenderTexture_;
   Mn::GL::Framebuffer framebuffer_;
 
+  // the attachments draws go to with multisampling, see resolveMultisampling()
+  int samples_ = 1;
+  Mn::GL::Renderbuffer multisampleColorBuffer_;
+  Mn::GL::Renderbuffer multisampleObjectIdBuffer_;
+  Mn::GL::Renderbuffer multisampleDepthBuffer_;
+  Mn::GL::Framebuffer multisampleFramebuffer_;
+  bool resolvePending_ = false;
+
   Mn::Vector2 depthUnprojection_;
   DepthShader* depthShader_;
+  // the linear depth written by the pass, see renderEnterLinearDepth()
+  Mn::GL::Renderbuffer linearDepth_;
+  bool linearDepthDrawn_ = false;
   Mn::GL::Renderbuffer unprojectedDepth_;
   Mn::GL::Mesh depthUnprojectionMesh_;
   Mn::GL::Framebuffer depthUnprojectionFrameBuffer_;
 
+  // the normals reconstructed from the depth, see reconstructNormalsGPU()
+  DepthShader* normalShader_ = nullptr;
+  Mn::Vector2 pixelUnprojection_;
+  Mn::GL::Renderbuffer normals_;
+  Mn::GL::Mesh normalReconstructionMesh_;
+  Mn::GL::Framebuffer normalFramebuffer_;
+
+  // the points unprojected from the depth, see unprojectPointsGPU()
+  DepthShader* pointShader_ = nullptr;
+  Mn::GL::Renderbuffer points_;
+  Mn::GL::Mesh pointUnprojectionMesh_;
+  Mn::GL::Framebuffer pointFramebuffer_;
+
+  // the object ids remapped by a lookup table, see remapObjectIdsGPU()
+  ObjectIdRemapShader* objectIdRemapShader_ = nullptr;
+  Mn::GL::Renderbuffer remappedObjectIds_;
+  Mn::GL::Mesh objectIdRemapMesh_;
+  Mn::GL::Framebuffer objectIdRemapFramebuffer_;
+
+  // the counts of the object ids, see readFrameObjectIdHistogram()
+  ObjectIdHistogramShader* objectIdHistogramShader_ = nullptr;
+  Mn::GL::Renderbuffer histogram_;
+  Mn::GL::Mesh histogramMesh_;
+  Mn::GL::Framebuffer histogramFramebuffer_;
+
+  // the viewport covering the whole framebuffer, restored after batched draws
+  const Mn::Range2Di fullViewport_;
+
+  // the region the reads cover and its subsampling, see setReadRegion()
+  Mn::Range2Di readRegion_;
+  int readStride_ = 1;
+  std::map<Mn::GL::RenderbufferFormat, StridedRead> stridedReads_;
+
+  // state of the asynchronous (pixel buffer object) read, see fence()
+  static constexpr GLuint64 kFenceTimeoutNs = 1000000000;
+  Mn::GL::BufferImage2D pendingRead_;
+  GLsync pendingReadFence_ = nullptr;
+  bool pendingReadUnprojectDepth_ = false;
+
   const Renderer::Flags rendererFlags_;
+  const bool topDownRows_;
 
 #ifdef ESP_BUILD_WITH_CUDA
   cudaGraphicsResource_t colorBufferCugl_ = nullptr;
   cudaGraphicsResource_t objecIdBufferCugl_ = nullptr;
   cudaGraphicsResource_t depthBufferCugl_ = nullptr;
+  cudaGraphicsResource_t linearDepthCugl_ = nullptr;
+  // the pixel buffer of the reads in packed formats, see readFramePackedGPU()
+  Mn::GL::BufferImage2D packedRead_{Mn::NoCreate};
+  cudaGraphicsResource_t packedReadCugl_ = nullptr;
+  std::size_t packedReadCuglSize_ = 0;
+  int cudaDeviceId_ = -1;
 #endif
 };  // namespace gfx
 
 RenderTarget::RenderTarget(const Mn::Vector2i& size,
                            const Mn::Vector2& depthUnprojection,
                            DepthShader* depthShader,
-                           Renderer::Flags flags)
+                           Renderer::Flags flags,
+                           int samples,
+                           bool topDownRows)
     : pimpl_(spimpl::make_unique_impl<Impl>(size,
                                             depthUnprojection,
                                             depthShader,
-                                            flags)) {}
+                                            flags,
+                                            samples,
+                                            topDownRows)) {}
 
 void RenderTarget::renderEnter() {
   pimpl_->renderEnter();
@@ -284,6 +1316,10 @@ void RenderTarget::renderReEnter() {
   pimpl_->renderReEnter();
 }
 
+bool RenderTarget::renderEnterLinearDepth() {
+  return pimpl_->renderEnterLinearDepth();
+}
+
 void RenderTarget::renderExit() {
   pimpl_->renderExit();
 }
@@ -296,8 +1332,89 @@ void RenderTarget::readFrameDepth(const Mn::MutableImageView2D& view) {
   pimpl_->readFrameDepth(view);
 }
 
-void RenderTarget::readFrameObjectId(const Mn::MutableImageView2D& view) {
-  pimpl_->readFrameObjectId(view);
+void RenderTarget::readFrameDepthBuffer(const Mn::MutableImageView2D& view) {
+  pimpl_->readFrameDepthBuffer(view);
+}
+
+void RenderTarget::readFrameObjectId(const Mn::MutableImageView2D& view,
+                                     ObjectIdRemapping* remapping) {
+  pimpl_->readFrameObjectId(view, remapping);
+}
+
+void RenderTarget::setObjectIdRemapShader(
+    ObjectIdRemapShader* objectIdRemapShader) {
+  pimpl_->setObjectIdRemapShader(objectIdRemapShader);
+}
+
+void RenderTarget::readFrameObjectIdHistogram(
+    Cr::Containers::ArrayView<Mn::UnsignedInt> counts,
+    ObjectIdRemapping* remapping) {
+  pimpl_->readFrameObjectIdHistogram(counts, remapping);
+}
+
+void RenderTarget::setObjectIdHistogramShader(
+    ObjectIdHistogramShader* objectIdHistogramShader) {
+  pimpl_->setObjectIdHistogramShader(objectIdHistogramShader);
+}
+
+void RenderTarget::readFrameNormal(const Mn::MutableImageView2D& view) {
+  pimpl_->readFrameNormal(view);
+}
+
+void RenderTarget::setNormalShader(DepthShader* normalShader) {
+  pimpl_->setNormalShader(normalShader);
+}
+
+void RenderTarget::readFramePoints(const Mn::MutableImageView2D& view,
+                                   const Mn::Matrix4& transformation,
+                                   int stride) {
+  pimpl_->readFramePoints(view, transformation, stride);
+}
+
+void RenderTarget::setPointShader(DepthShader* pointShader) {
+  pimpl_->setPointShader(pointShader);
+}
+
+Mn::Vector2i RenderTarget::pointCloudSize(int stride) const {
+  return pimpl_->pointCloudSize(stride);
+}
+
+void RenderTarget::setPixelUnprojection(const Mn::Vector2& pixelUnprojection) {
+  pimpl_->setPixelUnprojection(pixelUnprojection);
+}
+
+void RenderTarget::readFrameRgbaAsync(Mn::PixelFormat format) {
+  pimpl_->readFrameRgbaAsync(format);
+}
+
+void RenderTarget::readFrameDepthAsync(Mn::PixelFormat format) {
+  pimpl_->readFrameDepthAsync(format);
+}
+
+void RenderTarget::readFrameObjectIdAsync(Mn::PixelFormat format,
+                                          ObjectIdRemapping* remapping) {
+  pimpl_->readFrameObjectIdAsync(format, remapping);
+}
+
+void RenderTarget::readFrameNormalAsync() {
+  pimpl_->readFrameNormalAsync();
+}
+
+void RenderTarget::readFramePointsAsync(const Mn::Matrix4& transformation,
+                                        int stride) {
+  pimpl_->readFramePointsAsync(transformation, stride);
+}
+
+bool RenderTarget::hasPendingRead() const {
+  return pimpl_->hasPendingRead();
+}
+
+bool RenderTarget::isPendingReadReady() {
+  return pimpl_->isPendingReadReady();
+}
+
+void RenderTarget::fence(const Mn::MutableImageView2D& view) {
+  pimpl_->fence(view);
 }
 
 void RenderTarget::blitRgbaToDefault() {
@@ -308,17 +1425,84 @@ Mn::Vector2i RenderTarget::framebufferSize() const {
   return pimpl_->framebufferSize();
 }
 
+std::size_t RenderTarget::getGpuBytes() const {
+  return pimpl_->gpuBytes();
+}
+
+int RenderTarget::samples() const {
+  return pimpl_->samples();
+}
+
+void RenderTarget::setDepthUnprojection(
+    const Mn::Vector2& depthUnprojection) {
+  pimpl_->setDepthUnprojection(depthUnprojection);
+}
+
+Mn::Vector2 RenderTarget::depthUnprojection() const {
+  return pimpl_->depthUnprojection();
+}
+
+bool RenderTarget::topDownRows() const {
+  return pimpl_->topDownRows();
+}
+
+void RenderTarget::setViewport(const Mn::Range2Di& viewport) {
+  pimpl_->setViewport(viewport);
+}
+
+void RenderTarget::resetViewport() {
+  pimpl_->resetViewport();
+}
+
+void RenderTarget::setReadRegion(const Mn::Range2Di& region, int stride) {
+  pimpl_->setReadRegion(region, stride);
+}
+
+Mn::Range2Di RenderTarget::readRegion() const {
+  return pimpl_->readRegion();
+}
+
+int RenderTarget::readStride() const {
+  return pimpl_->readStride();
+}
+
+Mn::Vector2i RenderTarget::readSize() const {
+  return pimpl_->readSize();
+}
+
 #ifdef ESP_BUILD_WITH_CUDA
-void RenderTarget::readFrameRgbaGPU(uint8_t* devPtr) {
-  pimpl_->readFrameRgbaGPU(devPtr);
+void RenderTarget::readFrameRgbaGPU(uint8_t* devPtr,
+                                    Mn::PixelFormat format,
+                                    CUstream_st* stream) {
+  pimpl_->readFrameRgbaGPU(devPtr, format, stream);
+}
+
+void RenderTarget::readFrameDepthGPU(void* devPtr,
+                                     Mn::PixelFormat format,
+                                     CUstream_st* stream) {
+  pimpl_->readFrameDepthGPU(devPtr, format, stream);
+}
+
+void RenderTarget::readFrameObjectIdGPU(void* devPtr,
+                                        Mn::PixelFormat format,
+                                        ObjectIdRemapping* remapping,
+                                        CUstream_st* stream) {
+  pimpl_->readFrameObjectIdGPU(devPtr, format, remapping, stream);
+}
+
+void RenderTarget::readFrameNormalGPU(float* devPtr, CUstream_st* stream) {
+  pimpl_->readFrameNormalGPU(devPtr, stream);
 }
 
-void RenderTarget::readFrameDepthGPU(float* devPtr) {
-  pimpl_->readFrameDepthGPU(devPtr);
+void RenderTarget::readFramePointsGPU(float* devPtr,
+                                      const Mn::Matrix4& transformation,
+                                      int stride,
+                                      CUstream_st* stream) {
+  pimpl_->readFramePointsGPU(devPtr, transformation, stride, stream);
 }
 
-void RenderTarget::readFrameObjectIdGPU(int32_t* devPtr) {
-  pimpl_->readFrameObjectIdGPU(devPtr);
+int RenderTarget::cudaDeviceId() {
+  return pimpl_->cudaDeviceId();
 }
 #endif
 
@@ -6,18 +6,28 @@
 #define ESP_GFX_RENDERTARGET_H_
 
 #include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/PixelFormat.h>
 
 #include "esp/core/esp.h"
 
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/ObjectIdRemapping.h"
 #include "esp/gfx/Renderer.h"
 
+#ifdef ESP_BUILD_WITH_CUDA
+// the stream of cudaStream_t, so that the CUDA headers aren't needed here
+struct CUstream_st;
+#endif
+
 namespace esp {
 namespace gfx {
 
 /**
  * Holds a framebuffer and encapsulates the logic of retrieving rendering
- * results of various types (RGB, Depth, ObjectID) from the framebuffer.
+ * results of various types (RGB, Depth, ObjectID, Normal, Points) from the
+ * framebuffer.
  *
  * Reads the rendering results into either CPU or GPU, if compiled with CUDA,
  * memory
@@ -38,11 +48,22 @@ class RenderTarget {
    *                           whether or not @ref readFrameRgba,
    *                           @ref blitRgbaToDefault, and @readFrameRgbaGPU
    *                           are valid calls.
+   * @param samples            Samples per pixel of multisample anti-aliasing.
+   *                           With more than one, draws go to multisampled
+   *                           attachments, which are resolved on the GPU
+   *                           before the first read of a frame.  Clamped to
+   *                           what the GPU supports
+   * @param topDownRows        Draw the images upside down, so that all the
+   *                           reads have their first row at the top of the
+   *                           image, as observations do, instead of the
+   *                           bottom.  See @ref topDownRows()
    */
   RenderTarget(const Magnum::Vector2i& size,
                const Magnum::Vector2& depthUnprojection,
                DepthShader* depthShader,
-               Renderer::Flags flags);
+               Renderer::Flags flags,
+               int samples = 1,
+               bool topDownRows = false);
 
   /**
    * @brief Constructor
@@ -71,6 +92,21 @@ class RenderTarget {
    */
   void renderReEnter();
 
+  /**
+   * @brief Like @ref renderEnter(), for a pass drawn with
+   * @ref RenderCamera::Flag::LinearDepth
+   * @return Whether the pass writes the linear depth. If not, only
+   * @ref renderEnter() was called and the pass is drawn without the flag
+   *
+   * Maps the first fragment output to a float attachment holding the linear
+   * depth, cleared to zero like the depth on the far plane is patched to.
+   * Until the next @ref renderEnter(), the depth reads in meters read it
+   * directly instead of unprojecting the depth buffer in a pass of their
+   * own. Multisampled render targets keep unprojecting the resolved depth
+   * buffer.
+   */
+  bool renderEnterLinearDepth();
+
   /**
    * @brief Called after any draw calls that target this RenderTarget
    */
@@ -81,11 +117,97 @@ class RenderTarget {
    */
   Magnum::Vector2i framebufferSize() const;
 
+  /**
+   * @brief The estimated GPU memory of the attachments and pixel buffers
+   * allocated so far, in bytes, including the ones the reads of depth,
+   * normals, points and remapped object ids allocate when first needed
+   */
+  std::size_t getGpuBytes() const;
+
+  /**
+   * @brief Samples per pixel of the multisample anti-aliasing, 1 if it's
+   * disabled
+   */
+  int samples() const;
+
+  /**
+   * @brief Set the depth unprojection parameters passed on construction,
+   * e.g. for a render target reused by a sensor with another projection
+   */
+  void setDepthUnprojection(const Magnum::Vector2& depthUnprojection);
+
+  /**
+   * @brief The depth unprojection parameters depth reads are unprojected
+   * with
+   */
+  Magnum::Vector2 depthUnprojection() const;
+
+  /**
+   * @brief Whether the reads have their first row at the top of the image
+   *
+   * The draws into the render target flip their projection vertically, and
+   * their front faces accordingly, so that no read has to flip the rows.
+   * @ref blitRgbaToDefault() still shows the image upright.
+   */
+  bool topDownRows() const;
+
+  /**
+   * @brief Restrict subsequent draw calls to a sub-region of the framebuffer,
+   * e.g. one tile of a batched render. See @ref Renderer::drawBatch()
+   *
+   * Reads cover the region of @ref setReadRegion() regardless of the
+   * viewport; call @ref resetViewport() before reading.
+   */
+  void setViewport(const Magnum::Range2Di& viewport);
+
+  /**
+   * @brief Restore the viewport to cover the full framebuffer
+   */
+  void resetViewport();
+
+  /**
+   * @brief Restrict the reads to a region of the framebuffer, subsampled by
+   * @p stride
+   *
+   * @param region The rectangle of the framebuffer the reads cover, in the
+   * rows of the reads, see @ref topDownRows(). The whole framebuffer if
+   * empty.
+   * @param stride The reads are of the center pixels of the @p stride by
+   * @p stride blocks of @p region, sampled by a blit on the GPU before the
+   * read, so that only the pixels read are transferred. The size of the
+   * reads is then @ref readSize().
+   *
+   * Applies to the reads of colors, depth, object ids and normals, on the
+   * CPU, asynchronous and directly into CUDA memory; the points of
+   * @ref readFramePoints() have a stride of their own. Throws if @p region
+   * is not inside the framebuffer or smaller than @p stride, or if @p stride
+   * is not positive.
+   */
+  void setReadRegion(const Magnum::Range2Di& region, int stride = 1);
+
+  /**
+   * @brief The region of the reads, see @ref setReadRegion()
+   */
+  Magnum::Range2Di readRegion() const;
+
+  /**
+   * @brief The subsampling of the reads, see @ref setReadRegion()
+   */
+  int readStride() const;
+
+  /**
+   * @brief The size of the reads, that of @ref readRegion() divided by
+   * @ref readStride(), rounded down
+   */
+  Magnum::Vector2i readSize() const;
+
   /**
    * @brief Retrieve the RGBA rendering results.
    *
    * @param[in, out] view Preallocated memory that will be populated with the
-   * result.  The result will be read as the pixel format of this view.
+   * result.  The result will be read as the pixel format of this view, e.g.
+   * @ref Magnum::PixelFormat::RGB8Unorm drops the alpha channel while the
+   * pixels are packed on the GPU
    */
   void readFrameRgba(const Magnum::MutableImageView2D& view);
 
@@ -93,11 +215,24 @@ class RenderTarget {
    * @brief Retrieve the depth rendering results.
    *
    * @param[in, out] view Preallocated memory that will be populated with the
-   * result.  The PixelFormat of the image must only specify the R channel,
-   * generally @ref Magnum::PixelFormat::R32F
+   * result.  Either @ref Magnum::PixelFormat::R32F for depth in meters,
+   * @ref Magnum::PixelFormat::R16F for the same as half floats, or
+   * @ref Magnum::PixelFormat::R16UI for millimeters, saturating at 65.535
+   * meters.  The smaller formats are packed on the GPU if the RenderTarget
+   * has a DepthShader
    */
   void readFrameDepth(const Magnum::MutableImageView2D& view);
 
+  /**
+   * @brief Retrieve the depth buffer as it is, in [0, 1] from the near to
+   * the far plane, e.g. for orthographic projections, whose depth is linear
+   * and which @ref readFrameDepth() doesn't unproject
+   *
+   * @param[in, out] view Preallocated memory of
+   * @ref Magnum::PixelFormat::R32F that will be populated with the result
+   */
+  void readFrameDepthBuffer(const Magnum::MutableImageView2D& view);
+
   /**
    * @brief Reads the ObjectID rendering results into the memory specified by
    * view
@@ -105,10 +240,191 @@ class RenderTarget {
    * @param[in, out] view Preallocated memory that will be populated with the
    * result.  The PixelFormat of the image must only specify the R channel and
    * be a format which a uint16_t can be interpreted as, generally @ref
-   * Magnum::PixelFormat::R32UI, @ref Magnum::PixelFormat::R32I, or @ref
-   * Magnum::PixelFormat::R16UI
+   * Magnum::PixelFormat::R32UI, @ref Magnum::PixelFormat::R32I, @ref
+   * Magnum::PixelFormat::R16UI or @ref Magnum::PixelFormat::R8UI. The
+   * narrower formats are converted by the transfer, the ids have to fit.
+   * @param remapping  If not nullptr, the ids are remapped through its
+   * table on the GPU first, with the shader of
+   * @ref setObjectIdRemapShader()
+   */
+  void readFrameObjectId(const Magnum::MutableImageView2D& view,
+                         ObjectIdRemapping* remapping = nullptr);
+
+  /**
+   * @brief Set the shader remapping the object ids of
+   * @ref readFrameObjectId()
+   *
+   * Or nullptr, in which case the object ids can't be remapped.
+   */
+  void setObjectIdRemapShader(ObjectIdRemapShader* objectIdRemapShader);
+
+  /**
+   * @brief Count the pixels of each object id of the rendering results
+   *
+   * @param[out] counts The number of pixels of each object id from 0,
+   * counted on the GPU so that only the counts are transferred, e.g. for
+   * the visible objects without reading the whole image. Object ids beyond
+   * the counts aren't counted.
+   * @param remapping  If not nullptr, the pixels are counted by the value
+   * of their id in its table instead, e.g. by semantic category
+   *
+   * Counts the pixels of @ref readRegion() at @ref readStride(). The
+   * counts are exact up to 2^24 pixels of an id. Throws if there's no shader
+   * of @ref setObjectIdHistogramShader().
+   */
+  void readFrameObjectIdHistogram(
+      Corrade::Containers::ArrayView<Magnum::UnsignedInt> counts,
+      ObjectIdRemapping* remapping = nullptr);
+
+  /**
+   * @brief Set the shader of @ref readFrameObjectIdHistogram()
+   *
+   * Or nullptr, in which case the histograms can't be read.
+   */
+  void setObjectIdHistogramShader(
+      ObjectIdHistogramShader* objectIdHistogramShader);
+
+  /**
+   * @brief Retrieve the surface normals of the depth rendering results
+   *
+   * The normals are reconstructed from the depth on the GPU with the shader
+   * of @ref setNormalShader(), see @ref DepthShader::Flag::ReconstructNormals,
+   * so they need no attachment of their own in the draws and come with any
+   * pass that writes depth, including the depth-only one.
+   *
+   * @param[in, out] view Preallocated memory that will be populated with the
+   * result, of @ref Magnum::PixelFormat::RGB32F unit normals in the camera
+   * frame, zero where nothing was drawn
    */
-  void readFrameObjectId(const Magnum::MutableImageView2D& view);
+  void readFrameNormal(const Magnum::MutableImageView2D& view);
+
+  /**
+   * @brief Set the shader reconstructing the normals of
+   * @ref readFrameNormal()
+   *
+   * A @ref DepthShader with @ref DepthShader::Flag::ReconstructNormals, or
+   * nullptr, in which case the normals can't be read.
+   */
+  void setNormalShader(DepthShader* normalShader);
+
+  /**
+   * @brief Retrieve the points of the depth rendering results
+   *
+   * The points are unprojected from the depth on the GPU with the shader of
+   * @ref setPointShader(), see @ref DepthShader::Flag::UnprojectPoints, and
+   * like the normals of @ref readFrameNormal() come with any pass that
+   * writes depth.
+   *
+   * @param[in, out] view Preallocated memory of @ref pointCloudSize() that
+   * will be populated with the result, of @ref Magnum::PixelFormat::RGB32F
+   * points, zero where nothing was drawn
+   * @param transformation Applied to the points in the camera frame, e.g.
+   * the absolute transformation of the camera for world frame points
+   * @param stride Each point is the center pixel of a @p stride by @p stride
+   * block, subsampling the cloud
+   */
+  void readFramePoints(const Magnum::MutableImageView2D& view,
+                       const Magnum::Matrix4& transformation = {},
+                       int stride = 1);
+
+  /**
+   * @brief The size of the points of @ref readFramePoints() subsampled by
+   * @p stride
+   *
+   * Throws if the stride is not positive or larger than the framebuffer.
+   */
+  Magnum::Vector2i pointCloudSize(int stride) const;
+
+  /**
+   * @brief Set the shader unprojecting the points of
+   * @ref readFramePoints()
+   *
+   * A @ref DepthShader with @ref DepthShader::Flag::UnprojectPoints, or
+   * nullptr, in which case the points can't be read.
+   */
+  void setPointShader(DepthShader* pointShader);
+
+  /**
+   * @brief Set the pixel unprojection of the normals, see
+   * @ref calculatePixelUnprojection()
+   *
+   * Set by the @ref Renderer for every draw, following the projection of
+   * the camera, flipped for @ref topDownRows().
+   */
+  void setPixelUnprojection(const Magnum::Vector2& pixelUnprojection);
+
+  /**
+   * @brief Start an asynchronous read of the RGBA rendering results into a
+   * pixel buffer object owned by this RenderTarget.
+   *
+   * Returns immediately; the GPU-to-host transfer overlaps with subsequent
+   * work. Retrieve the result with @ref fence(). Only one read can be in
+   * flight at a time; starting a new one discards the pending result.
+   *
+   * @param format Either @ref Magnum::PixelFormat::RGBA8Unorm or, to drop the
+   * alpha channel, @ref Magnum::PixelFormat::RGB8Unorm
+   */
+  void readFrameRgbaAsync(
+      Magnum::PixelFormat format = Magnum::PixelFormat::RGBA8Unorm);
+
+  /**
+   * @brief Start an asynchronous read of the depth rendering results. See
+   * @ref readFrameRgbaAsync()
+   *
+   * If the RenderTarget has no DepthShader, depth is unprojected, and packed
+   * to @p format, on the CPU inside @ref fence().
+   *
+   * @param format One of the formats of @ref readFrameDepth()
+   */
+  void readFrameDepthAsync(
+      Magnum::PixelFormat format = Magnum::PixelFormat::R32F);
+
+  /**
+   * @brief Start an asynchronous read of the ObjectID rendering results. See
+   * @ref readFrameRgbaAsync()
+   *
+   * @param format     One of the formats of @ref readFrameObjectId()
+   * @param remapping  See @ref readFrameObjectId()
+   */
+  void readFrameObjectIdAsync(
+      Magnum::PixelFormat format = Magnum::PixelFormat::R32UI,
+      ObjectIdRemapping* remapping = nullptr);
+
+  /**
+   * @brief Start an asynchronous read of the normals of
+   * @ref readFrameNormal(). See @ref readFrameRgbaAsync()
+   */
+  void readFrameNormalAsync();
+
+  /**
+   * @brief Start an asynchronous read of the points of
+   * @ref readFramePoints(). See @ref readFrameRgbaAsync()
+   */
+  void readFramePointsAsync(const Magnum::Matrix4& transformation = {},
+                            int stride = 1);
+
+  /**
+   * @brief Whether an asynchronous read was started and not yet retrieved by
+   * @ref fence()
+   */
+  bool hasPendingRead() const;
+
+  /**
+   * @brief Whether the pending asynchronous read has finished on the GPU, so
+   * that @ref fence() will not block. False if there is no pending read.
+   */
+  bool isPendingReadReady();
+
+  /**
+   * @brief Block until the pending asynchronous read is complete and copy the
+   * result into @p view.
+   *
+   * @param[in, out] view Preallocated memory matching the size and pixel
+   * format of the read that was started, e.g. R32UI for
+   * @ref readFrameObjectIdAsync().  Its rows must not be padded, i.e. RGB8
+   * and 16-bit views of odd widths need an alignment of 1
+   */
+  void fence(const Magnum::MutableImageView2D& view);
 
   /**
    * @brief Blits the rgba buffer from internal FBO to default frame buffer
@@ -128,9 +444,21 @@ class RenderTarget {
    * context and the devPtr are on the same CUDA device.
    *
    * @param[in, out] devPtr CUDA memory pointer that points to a contiguous
-   * memory region of at least W*H*sizeof(uint8_t) bytes.
+   * memory region of at least W*H*4*sizeof(uint8_t) bytes, or W*H*3 for
+   * @ref Magnum::PixelFormat::RGB8Unorm
+   * @param format The format of @ref readFrameRgbaAsync() to read in
+   * @param stream The CUDA stream the copy is enqueued on, the legacy default
+   * stream if null
+   *
+   * Returns once the copy is enqueued, @p devPtr is written for the work
+   * enqueued on @p stream after, e.g. inference on the previous observation
+   * on another stream overlaps with it. The rows of the frame are copied in
+   * their order, draw with @ref topDownRows() to have them top-down.
    */
-  void readFrameRgbaGPU(uint8_t* devPtr);
+  void readFrameRgbaGPU(
+      uint8_t* devPtr,
+      Magnum::PixelFormat format = Magnum::PixelFormat::RGBA8Unorm,
+      CUstream_st* stream = nullptr);
 
   /**
    * @brief Reads the depth rendering result directly into CUDA memory.  See
@@ -139,18 +467,66 @@ class RenderTarget {
    * Requires the rendering target to have a valid DepthShader
    *
    * @param[in, out] devPtr CUDA memory pointer that points to a contiguous
-   * memory region of at least W*H*sizeof(float) bytes.
+   * memory region of at least W*H pixels of @p format.
+   * @param format One of the formats of @ref readFrameDepth()
+   * @param stream See @ref readFrameRgbaGPU()
    */
-  void readFrameDepthGPU(float* devPtr);
+  void readFrameDepthGPU(void* devPtr,
+                         Magnum::PixelFormat format = Magnum::PixelFormat::R32F,
+                         CUstream_st* stream = nullptr);
 
   /**
    * @brief Reads the ObjectID rendering result directly into CUDA memory.  See
    * @ref readFrameRgbaGPU()
    *
    * @param[in, out] devPtr CUDA memory pointer that points to a contiguous
-   * memory region of at least W*H*sizeof(int32_t) bytes.
+   * memory region of at least W*H pixels of @p format.
+   * @param format     One of the formats of @ref readFrameObjectId()
+   * @param remapping  See @ref readFrameObjectId()
+   * @param stream     See @ref readFrameRgbaGPU()
+   */
+  void readFrameObjectIdGPU(
+      void* devPtr,
+      Magnum::PixelFormat format = Magnum::PixelFormat::R32UI,
+      ObjectIdRemapping* remapping = nullptr,
+      CUstream_st* stream = nullptr);
+
+  /**
+   * @brief Reads the normals of @ref readFrameNormal() directly into CUDA
+   * memory.  See @ref readFrameRgbaGPU()
+   *
+   * @param[in, out] devPtr CUDA memory pointer that points to a contiguous
+   * memory region of at least W*H*3*sizeof(float) bytes.
+   * @param stream See @ref readFrameRgbaGPU()
+   */
+  void readFrameNormalGPU(float* devPtr, CUstream_st* stream = nullptr);
+
+  /**
+   * @brief Reads the points of @ref readFramePoints() directly into CUDA
+   * memory.  See @ref readFrameRgbaGPU()
+   *
+   * @param[in, out] devPtr CUDA memory pointer that points to a contiguous
+   * memory region of at least 3*sizeof(float) bytes per point of
+   * @ref pointCloudSize().
+   * @param stream See @ref readFrameRgbaGPU()
+   */
+  void readFramePointsGPU(float* devPtr,
+                          const Magnum::Matrix4& transformation = {},
+                          int stride = 1,
+                          CUstream_st* stream = nullptr);
+
+  /**
+   * @brief The CUDA device of the OpenGL context the render target was
+   * created in, the one to allocate the memory of the GPU reads on
+   *
+   * The attachments stay registered with CUDA from their first GPU read until
+   * the render target is destroyed, so the reads only map them, on the
+   * stream of the read, and unmap them once the copy is enqueued, which
+   * keeps OpenGL from drawing to them before the copy is done.  Reads in
+   * the packed formats go through a pixel buffer that is registered the same
+   * way.
    */
-  void readFrameObjectIdGPU(int32_t* devPtr);
+  int cudaDeviceId();
 #endif
 
   ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(RenderTarget)
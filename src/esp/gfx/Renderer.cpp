@@ -4,24 +4,48 @@
 
 #include "Renderer.h"
 
+#include <Corrade/Containers/Optional.h>
 #include <Corrade/Containers/StridedArrayView.h>
 #include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Context.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/OpenGL.h>
 #include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderbuffer.h>
 #include <Magnum/GL/RenderbufferFormat.h>
 #include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/SampleQuery.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/Image.h>
+#include <Magnum/MeshTools/Compile.h>
 #include <Magnum/PixelFormat.h>
+#include <Magnum/Primitives/Cube.h>
+#include <Magnum/Shaders/Flat.h>
+#include <Magnum/Trade/MeshData.h>
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#include "esp/core/PerfStats.h"
+#include "esp/core/Profiling.h"
+#include "esp/geo/geo.h"
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/Drawable.h"
+#include "esp/gfx/Foveation.h"
+#include "esp/gfx/LightweightShaders.h"
+#include "esp/gfx/ObjectIdRemapping.h"
+#include "esp/gfx/OcclusionCuller.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/magnum.h"
 
 namespace Mn = Magnum;
+namespace Cr = Corrade;
 
 namespace esp {
 namespace gfx {
@@ -36,26 +60,369 @@ struct Renderer::Impl {
   void draw(RenderCamera& camera,
             scene::SceneGraph& sceneGraph,
             RenderCamera::Flags flags) {
+    draw(camera, sceneGraph, flags,
+         occlusionCuller(camera.viewKey(), flags));
+  }
+
+  void draw(RenderCamera& camera,
+            scene::SceneGraph& sceneGraph,
+            RenderCamera::Flags flags,
+            OcclusionCuller* occlusionCuller) {
+    ESP_PROFILE_SCOPE("Renderer::draw");
+    ESP_PERF_TIMER(Draw);
+    sceneGraph.updateTransformations();
+    uint32_t numDrawn = 0;
     for (auto& it : sceneGraph.getDrawableGroups()) {
       // TODO: remove || true
       if (it.second.prepareForDraw(camera) || true) {
-        camera.draw(it.second, flags);
+        numDrawn += camera.draw(it.second, flags, occlusionCuller,
+                                &lightweightShaders_);
       }
     }
+    core::PerfStats::shared().add(core::PerfStat::VisibleDrawables, numDrawn);
   }
 
   void draw(sensor::VisualSensor& visualSensor,
             scene::SceneGraph& sceneGraph,
             RenderCamera::Flags flags) {
+    draw(visualSensor, sceneGraph, flags,
+         visualSensor.hasRenderTarget() ? &visualSensor.renderTarget()
+                                        : nullptr);
+  }
+
+  /**
+   * @brief Draw @p visualSensor's view into @p target, which the caller has
+   * bound already
+   */
+  void draw(sensor::VisualSensor& visualSensor,
+            scene::SceneGraph& sceneGraph,
+            RenderCamera::Flags flags,
+            RenderTarget* target) {
     ASSERT(visualSensor.isVisualSensor());
 
+    // e.g. equirectangular sensors, which render a cube map first
+    if (target && visualSensor.drawThroughCubeMap(sceneGraph, flags, *target)) {
+      return;
+    }
+
     // set the modelview matrix, projection matrix of the render camera;
     sceneGraph.setDefaultRenderCamera(visualSensor);
+    RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+
+    // the first rows of a top-down target are the top of the image, which
+    // mirrors the winding of the triangles as well
+    const bool topDownRows = target && target->topDownRows();
+    if (topDownRows) {
+      Mn::Matrix4 projection =
+          Mn::Matrix4::scaling(Mn::Vector3::yScale(-1.0f)) *
+          camera.projectionMatrix();
+      camera.setProjectionMatrix(camera.viewport().x(), camera.viewport().y(),
+                                 projection);
+      Mn::GL::Renderer::setFrontFace(Mn::GL::Renderer::FrontFace::ClockWise);
+    }
+    // the normals and points are unprojected from the depth with the same
+    // projection
+    if (target) {
+      target->setPixelUnprojection(
+          calculatePixelUnprojection(camera.projectionMatrix()));
+    }
+
+    // the default render camera is shared, so the occlusion history is kept
+    // per sensor. The tiles of a batch are drawn at full resolution.
+    Cr::Containers::Optional<Foveation> foveation;
+    if (target && visualSensor.hasRenderTarget() &&
+        target == &visualSensor.renderTarget()) {
+      foveation = visualSensor.foveation();
+    }
+    if (foveation) {
+      drawFoveated(camera, sceneGraph, flags,
+                   occlusionCuller(visualSensor.viewKey(), flags),
+                   foveatedFramebuffer(visualSensor, *foveation), *target);
+    } else {
+      draw(camera, sceneGraph, flags,
+           occlusionCuller(visualSensor.viewKey(), flags));
+    }
+
+    if (topDownRows) {
+      Mn::GL::Renderer::setFrontFace(
+          Mn::GL::Renderer::FrontFace::CounterClockWise);
+    }
+  }
+
+  void drawStereo(sensor::VisualSensor& leftEye,
+                  sensor::VisualSensor& rightEye,
+                  scene::SceneGraph& sceneGraph,
+                  const Mn::Range2Di& leftViewport,
+                  const Mn::Range2Di& rightViewport,
+                  RenderCamera::Flags flags) {
+    ESP_PROFILE_SCOPE("Renderer::drawStereo");
+    ESP_PERF_TIMER(Draw);
+    ASSERT(leftEye.isVisualSensor() && rightEye.isVisualSensor());
+    // the queries of one eye would hide what only the other one sees
+    flags &= ~RenderCamera::Flag::OcclusionCulling;
+
+    // the caller bound a framebuffer Magnum doesn't know about
+    Mn::GL::Context::current().resetState(
+        Mn::GL::Context::State::ExitExternal);
+    sceneGraph.updateTransformations();
+
+    // the eyes look the same way, so the frustum enclosing both is bounded
+    // by their outer side planes and shares the others
+    RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+    sceneGraph.setDefaultRenderCamera(rightEye);
+    const Mn::Frustum right = Mn::Frustum::fromMatrix(
+        camera.projectionMatrix() * camera.cameraMatrix());
+    sceneGraph.setDefaultRenderCamera(leftEye);
+    const Mn::Frustum left = Mn::Frustum::fromMatrix(
+        camera.projectionMatrix() * camera.cameraMatrix());
+    camera.setCullingFrustum(Mn::Frustum{left.left(), right.right(),
+                                         left.bottom(), left.top(),
+                                         left.near(), left.far()});
+
+    uint32_t numDrawn = 0;
+    for (auto& it : sceneGraph.getDrawableGroups()) {
+      it.second.prepareForDraw(camera);
+      for (const bool isRight : {false, true}) {
+        sceneGraph.setDefaultRenderCamera(isRight ? rightEye : leftEye);
+        const Mn::Range2Di& viewport = isRight ? rightViewport : leftViewport;
+        // not tracked by Magnum, which is reset below
+        glViewport(viewport.left(), viewport.bottom(), viewport.sizeX(),
+                   viewport.sizeY());
+        const RenderCamera::Flags eyeFlags =
+            isRight ? flags | RenderCamera::Flag::ReuseCulling : flags;
+        numDrawn += camera.draw(it.second, eyeFlags, nullptr,
+                                &lightweightShaders_);
+      }
+    }
+    camera.setCullingFrustum(Cr::Containers::NullOpt);
+    core::PerfStats::shared().add(core::PerfStat::VisibleDrawables, numDrawn);
+
+    Mn::GL::Context::current().resetState(
+        Mn::GL::Context::State::EnterExternal |
+        Mn::GL::Context::State::Framebuffers);
+  }
 
-    draw(sceneGraph.getDefaultRenderCamera(), sceneGraph, flags);
+  /**
+   * @brief Draw the periphery and the inset of the view of @p camera into
+   * @p framebuffer, culled once, and compose them into @p target
+   */
+  void drawFoveated(RenderCamera& camera,
+                    scene::SceneGraph& sceneGraph,
+                    RenderCamera::Flags flags,
+                    OcclusionCuller* occlusionCuller,
+                    FoveatedFramebuffer& framebuffer,
+                    RenderTarget& target) {
+    ESP_PROFILE_SCOPE("Renderer::drawFoveated");
+    ESP_PERF_TIMER(Draw);
+    framebuffer.renderEnter();
+    sceneGraph.updateTransformations();
+
+    // the inset sees a part of what the periphery sees, so it draws what
+    // passed the culling of the periphery
+    const Mn::Matrix4 projection = camera.projectionMatrix();
+    const Mn::Matrix4 insetProjection =
+        framebuffer.insetProjection(projection);
+    const Mn::Vector2i peripherySize = framebuffer.peripheryViewport().size();
+    const Mn::Vector2i insetSize = framebuffer.insetViewport().size();
+    uint32_t numDrawn = 0;
+    for (auto& it : sceneGraph.getDrawableGroups()) {
+      it.second.prepareForDraw(camera);
+      framebuffer.setViewport(framebuffer.peripheryViewport());
+      camera.setProjectionMatrix(peripherySize.x(), peripherySize.y(),
+                                 projection);
+      numDrawn += camera.draw(it.second, flags, occlusionCuller,
+                              &lightweightShaders_);
+      framebuffer.setViewport(framebuffer.insetViewport());
+      camera.setProjectionMatrix(insetSize.x(), insetSize.y(),
+                                 insetProjection);
+      numDrawn += camera.draw(it.second,
+                              flags | RenderCamera::Flag::ReuseCulling,
+                              nullptr, &lightweightShaders_);
+    }
+    camera.setProjectionMatrix(framebuffer.outputSize().x(),
+                               framebuffer.outputSize().y(), projection);
+    core::PerfStats::shared().add(core::PerfStat::VisibleDrawables, numDrawn);
+
+    if (!foveationShader_) {
+      foveationShader_ = std::make_unique<FoveationShader>();
+    }
+    target.renderReEnter();
+    framebuffer.compose(*foveationShader_);
+  }
+
+  /**
+   * @brief The foveated framebuffer of @p sensor, (re)created when its size
+   * or @p foveation changed
+   */
+  FoveatedFramebuffer& foveatedFramebuffer(sensor::VisualSensor& sensor,
+                                           const Foveation& foveation) {
+    FoveatedFramebuffer::uptr& framebuffer =
+        perView(foveatedFramebuffers_, sensor.viewKey());
+    if (!framebuffer ||
+        framebuffer->outputSize() != sensor.framebufferSize() ||
+        framebuffer->foveation() != foveation) {
+      framebuffer = FoveatedFramebuffer::create_unique(
+          sensor.framebufferSize(), foveation);
+    }
+    return *framebuffer;
   }
 
-  void bindRenderTarget(sensor::VisualSensor& sensor) {
+  template <class T>
+  struct PerView {
+    std::weak_ptr<const void> view;
+    T state;
+  };
+
+  /**
+   * @brief The state of @p view in @p states, default-constructed on first
+   * use
+   *
+   * The state of a destroyed view is dropped as new views are added, also
+   * when a new one gets the same key.
+   */
+  template <class T>
+  static T& perView(std::unordered_map<const void*, PerView<T>>& states,
+                    const ViewKey& view) {
+    PerView<T>& entry = states[view.id()];
+    if (entry.view.expired()) {
+      for (auto it = states.begin(); it != states.end();) {
+        if (&it->second != &entry && it->second.view.expired()) {
+          it = states.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      entry.view = view.lifetime();
+      entry.state = T{};
+    }
+    return entry.state;
+  }
+
+  /**
+   * @brief The occlusion culling history of @p view, created on first use,
+   * or nullptr if @p flags do not ask for occlusion culling
+   */
+  OcclusionCuller* occlusionCuller(const ViewKey& view,
+                                   RenderCamera::Flags flags) {
+    if (!(flags & RenderCamera::Flag::OcclusionCulling)) {
+      return nullptr;
+    }
+    OcclusionCuller::uptr& culler = perView(occlusionCullers_, view);
+    if (!culler) {
+      culler = OcclusionCuller::create_unique();
+    }
+    return culler.get();
+  }
+
+  void resetOcclusionCulling() { occlusionCullers_.clear(); }
+
+  std::vector<float> queryVisibility(
+      sensor::VisualSensor& sensor,
+      scene::SceneGraph& sceneGraph,
+      const std::vector<Mn::Matrix4>& poses,
+      const std::vector<scene::SceneNode*>& objects,
+      RenderCamera::Flags flags) {
+    ESP_PROFILE_SCOPE("Renderer::queryVisibility");
+    CORRADE_ASSERT(sensor.hasRenderTarget(),
+                   "Renderer::queryVisibility: the sensor has no render "
+                   "target",
+                   {});
+    RenderTarget& target = sensor.renderTarget();
+    flags &= ~(RenderCamera::Flag::OcclusionCulling |
+               RenderCamera::Flag::ObjectIdOnly |
+               RenderCamera::Flag::LinearDepth);
+    flags |= RenderCamera::Flag::DepthOnly;
+
+    // the drawables of each object belong to the nearest object above them
+    std::unordered_map<const MagnumObject*, std::size_t> objectIndices;
+    for (std::size_t i = 0; i != objects.size(); ++i) {
+      objectIndices.emplace(objects[i], i);
+    }
+    std::vector<std::vector<Drawable*>> objectDrawables(objects.size());
+    for (auto& it : sceneGraph.getDrawableGroups()) {
+      for (std::size_t i = 0; i != it.second.size(); ++i) {
+        auto* drawable = dynamic_cast<Drawable*>(&it.second[i]);
+        if (!drawable) {
+          continue;
+        }
+        for (const MagnumObject* node = &drawable->getSceneNode(); node;
+             node = node->parent()) {
+          auto found = objectIndices.find(node);
+          if (found != objectIndices.end()) {
+            objectDrawables[found->second].push_back(drawable);
+            break;
+          }
+        }
+      }
+    }
+
+    if (visibilityBox_.id() == 0) {
+      visibilityBox_ = Mn::MeshTools::compile(Mn::Primitives::cubeSolid());
+      visibilityBoxShader_ = Mn::Shaders::Flat3D{};
+    }
+
+    sceneGraph.setDefaultRenderCamera(sensor);
+    RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+    const float znear = projectionNearPlane(camera.projectionMatrix());
+    std::vector<VisibilityQuery> queries(poses.size() * objects.size());
+    for (std::size_t pose = 0; pose != poses.size(); ++pose) {
+      // the default render camera is a child of the root
+      camera.node().setTransformation(poses[pose]);
+      target.renderEnter();
+      draw(camera, sceneGraph, flags, nullptr);
+
+      Mn::GL::Renderer::setColorMask(false, false, false, false);
+      Mn::GL::Renderer::setDepthMask(false);
+      // the depth of the drawables drawn again may differ in the last bits,
+      // e.g. from instancing
+      Mn::GL::Renderer::setDepthFunction(
+          Mn::GL::Renderer::DepthFunction::LessOrEqual);
+      Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::PolygonOffsetFill);
+      Mn::GL::Renderer::setPolygonOffset(-1.0f, -1.0f);
+      VisibilityQuery* poseQueries = &queries[pose * objects.size()];
+      for (std::size_t i = 0; i != objects.size(); ++i) {
+        issueBoxQuery(camera, objectDrawables[i], znear, poseQueries[i]);
+        drawObjectQuery(camera, objectDrawables[i], poseQueries[i],
+                        &poseQueries[i].visible);
+      }
+
+      // the samples of each object alone, drawn twice so that only its
+      // nearest samples are counted
+      for (std::size_t i = 0; i != objects.size(); ++i) {
+        // the clear leaves the masked depth as well
+        Mn::GL::Renderer::setDepthMask(true);
+        target.renderEnter();
+        drawObjectQuery(camera, objectDrawables[i], poseQueries[i], nullptr);
+        Mn::GL::Renderer::setDepthMask(false);
+        drawObjectQuery(camera, objectDrawables[i], poseQueries[i],
+                        &poseQueries[i].total);
+      }
+
+      Mn::GL::Renderer::setPolygonOffset(0.0f, 0.0f);
+      Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::PolygonOffsetFill);
+      Mn::GL::Renderer::setDepthFunction(
+          Mn::GL::Renderer::DepthFunction::Less);
+      Mn::GL::Renderer::setDepthMask(true);
+      Mn::GL::Renderer::setColorMask(true, true, true, true);
+      target.renderExit();
+    }
+
+    std::vector<float> fractions(queries.size(), 0.0f);
+    for (std::size_t i = 0; i != queries.size(); ++i) {
+      if (!queries[i].total.id()) {
+        continue;
+      }
+      const Mn::UnsignedInt total = queries[i].total.result<Mn::UnsignedInt>();
+      if (total) {
+        fractions[i] = std::min(
+            1.0f, float(queries[i].visible.result<Mn::UnsignedInt>()) /
+                      float(total));
+      }
+    }
+    return fractions;
+  }
+
+  void bindRenderTarget(sensor::VisualSensor& sensor, bool topDownRows) {
     auto depthUnprojection = sensor.depthUnprojection();
     if (!depthUnprojection) {
       throw std::runtime_error(
@@ -66,15 +433,273 @@ struct Renderer::Impl {
       depthShader_ = std::make_unique<DepthShader>(
           DepthShader::Flag::UnprojectExistingDepth);
     }
+    // every target gets them, a normal or point cloud sensor may read the
+    // pass of another
+    if (!normalShader_) {
+      normalShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::UnprojectExistingDepth |
+          DepthShader::Flag::ReconstructNormals);
+    }
+    if (!pointShader_) {
+      pointShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::UnprojectExistingDepth |
+          DepthShader::Flag::UnprojectPoints);
+    }
+    if (!objectIdRemapShader_) {
+      objectIdRemapShader_ = std::make_unique<ObjectIdRemapShader>();
+    }
+    if (!objectIdHistogramShader_) {
+      objectIdHistogramShader_ = std::make_unique<ObjectIdHistogramShader>();
+    }
+
+    recycleRenderTarget(sensor.releaseRenderTarget());
+    const int samples = sensor.specification()->msaaSamples;
+    RenderTarget::uptr target =
+        pooledRenderTarget(sensor.framebufferSize(), samples, topDownRows);
+    if (target) {
+      target->setDepthUnprojection(*depthUnprojection);
+      target->setReadRegion({});
+    } else {
+      target = RenderTarget::create_unique(
+          sensor.framebufferSize(), *depthUnprojection, depthShader_.get(),
+          flags_, samples, topDownRows);
+    }
+    target->setNormalShader(normalShader_.get());
+    target->setPointShader(pointShader_.get());
+    target->setObjectIdRemapShader(objectIdRemapShader_.get());
+    target->setObjectIdHistogramShader(objectIdHistogramShader_.get());
+    sensor.bindRenderTarget(std::move(target));
+  }
 
-    sensor.bindRenderTarget(RenderTarget::create_unique(
-        sensor.framebufferSize(), *depthUnprojection, depthShader_.get(),
-        flags_));
+  void releaseRenderTarget(sensor::VisualSensor& sensor) {
+    recycleRenderTarget(sensor.releaseRenderTarget());
+  }
+
+  void setRenderTargetPoolCapacity(std::size_t capacity) {
+    renderTargetPoolCapacity_ = capacity;
+    if (renderTargetPool_.size() > capacity) {
+      renderTargetPool_.erase(
+          renderTargetPool_.begin(),
+          renderTargetPool_.end() - std::ptrdiff_t(capacity));
+    }
+  }
+
+  std::size_t renderTargetPoolSize() const { return renderTargetPool_.size(); }
+
+  std::size_t renderTargetPoolGpuBytes() const {
+    std::size_t bytes = 0;
+    for (const RenderTarget::uptr& target : renderTargetPool_) {
+      bytes += target->getGpuBytes();
+    }
+    return bytes;
+  }
+
+  // the pooled render target matching the arguments, nullptr if none does
+  RenderTarget::uptr pooledRenderTarget(const Mn::Vector2i& size,
+                                        int samples,
+                                        bool topDownRows) {
+    // the most recently released first, it's the likeliest to be reused
+    for (auto it = renderTargetPool_.rbegin(); it != renderTargetPool_.rend();
+         ++it) {
+      if ((*it)->framebufferSize() == size &&
+          (*it)->samples() == std::max(samples, 1) &&
+          (*it)->topDownRows() == topDownRows) {
+        RenderTarget::uptr target = std::move(*it);
+        renderTargetPool_.erase(std::next(it).base());
+        return target;
+      }
+    }
+    return nullptr;
+  }
+
+  void recycleRenderTarget(RenderTarget::uptr target) {
+    if (!target || !renderTargetPoolCapacity_) {
+      return;
+    }
+    if (renderTargetPool_.size() == renderTargetPoolCapacity_) {
+      renderTargetPool_.erase(renderTargetPool_.begin());
+    }
+    renderTargetPool_.push_back(std::move(target));
+  }
+
+  RenderTarget::uptr createBatchRenderTarget(
+      sensor::VisualSensor& referenceSensor,
+      int batchSize) {
+    CORRADE_ASSERT(batchSize > 0,
+                   "Renderer::createBatchRenderTarget: batch size must be "
+                   "positive",
+                   nullptr);
+    auto depthUnprojection = referenceSensor.depthUnprojection();
+    if (!depthUnprojection) {
+      throw std::runtime_error(
+          "Sensor does not have a depthUnprojection matrix");
+    }
+
+    if (!depthShader_) {
+      depthShader_ = std::make_unique<DepthShader>(
+          DepthShader::Flag::UnprojectExistingDepth);
+    }
+
+    return RenderTarget::create_unique(
+        batchFramebufferSize(referenceSensor.framebufferSize(), batchSize),
+        *depthUnprojection, depthShader_.get(), flags_,
+        referenceSensor.specification()->msaaSamples);
+  }
+
+  void drawBatch(RenderTarget& target, const std::vector<BatchEntry>& batch) {
+    if (batch.empty()) {
+      return;
+    }
+    const Mn::Vector2i tileSize = batch[0].sensor.get().framebufferSize();
+    CORRADE_ASSERT(
+        target.framebufferSize() ==
+            batchFramebufferSize(tileSize, batch.size()),
+        "Renderer::drawBatch: render target does not match the batch layout", );
+
+    target.renderEnter();
+    for (int iEntry = 0; iEntry < batch.size(); ++iEntry) {
+      const BatchEntry& entry = batch[iEntry];
+      CORRADE_ASSERT(entry.sensor.get().framebufferSize() == tileSize,
+                     "Renderer::drawBatch: all sensors in a batch must have "
+                     "the same resolution", );
+      // the depth of the whole target is unprojected with the projection of
+      // the reference sensor
+      CORRADE_ASSERT(entry.sensor.get().depthUnprojection() &&
+                         *entry.sensor.get().depthUnprojection() ==
+                             target.depthUnprojection(),
+                     "Renderer::drawBatch: all sensors in a batch must have "
+                     "the projection of the reference sensor", );
+      target.setViewport(batchTileViewport(tileSize, batch.size(), iEntry));
+      draw(entry.sensor.get(), entry.sceneGraph.get(), entry.flags, &target);
+    }
+    target.resetViewport();
+    target.renderExit();
+  }
+
+  static Mn::Vector2i batchGridSize(int batchSize) {
+    const int cols = static_cast<int>(std::ceil(std::sqrt(batchSize)));
+    const int rows = (batchSize + cols - 1) / cols;
+    return {cols, rows};
   }
 
  private:
+  struct VisibilityQuery {
+    // whether the box of the object passed any samples, not created without
+    // a box or if the box crosses the near plane
+    Mn::GL::SampleQuery box{Mn::NoCreate};
+    // not created for objects without drawables
+    Mn::GL::SampleQuery visible{Mn::NoCreate};
+    Mn::GL::SampleQuery total{Mn::NoCreate};
+  };
+
+  void issueBoxQuery(RenderCamera& camera,
+                     const std::vector<Drawable*>& drawables,
+                     float znear,
+                     VisibilityQuery& query) {
+    if (drawables.empty()) {
+      return;
+    }
+    query.visible =
+        Mn::GL::SampleQuery{Mn::GL::SampleQuery::Target::SamplesPassed};
+    query.total =
+        Mn::GL::SampleQuery{Mn::GL::SampleQuery::Target::SamplesPassed};
+
+    Mn::Range3D box;
+    bool hasBox = false;
+    for (Drawable* drawable : drawables) {
+      scene::SceneNode& node = drawable->getSceneNode();
+      Cr::Containers::Optional<Mn::Range3D> aabb = node.getAbsoluteAABB();
+      const Mn::Range3D drawableBox =
+          aabb ? *aabb : node.cachedAbsoluteMeshBB();
+      if (drawableBox.size() == Mn::Vector3{}) {
+        continue;
+      }
+      box = hasBox ? Mn::Math::join(box, drawableBox) : drawableBox;
+      hasBox = true;
+    }
+    // a box crossing the near plane would be clipped and pass no samples
+    if (!hasBox ||
+        geo::getTransformedBB(box, camera.cameraMatrix()).max().z() >=
+            -znear) {
+      return;
+    }
+
+    // the camera can be behind some of the faces of the box
+    Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+    query.box =
+        Mn::GL::SampleQuery{Mn::GL::SampleQuery::Target::AnySamplesPassed};
+    query.box.begin();
+    visibilityBoxShader_.setTransformationProjectionMatrix(
+        camera.projectionMatrix() * camera.cameraMatrix() *
+        Mn::Matrix4::translation(box.center()) *
+        Mn::Matrix4::scaling(box.size() * 0.5f));
+    visibilityBoxShader_.draw(visibilityBox_);
+    query.box.end();
+    Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
+  }
+
+  /**
+   * @brief Draw the depth of @p drawables inside @p sampleQuery, if not null,
+   * skipped on the GPU if the box of @p query passed no samples
+   */
+  void drawObjectQuery(RenderCamera& camera,
+                       const std::vector<Drawable*>& drawables,
+                       VisibilityQuery& query,
+                       Mn::GL::SampleQuery* sampleQuery) {
+    if (drawables.empty()) {
+      return;
+    }
+#ifndef MAGNUM_TARGET_GLES
+    if (query.box.id()) {
+      query.box.beginConditionalRender(
+          Mn::GL::SampleQuery::ConditionalRenderMode::Wait);
+    }
+#endif
+    if (sampleQuery) {
+      sampleQuery->begin();
+    }
+    for (Drawable* drawable : drawables) {
+      drawable->drawLightweight(
+          camera.cameraMatrix() *
+              drawable->getSceneNode().cachedAbsoluteTransformationMatrix(),
+          camera, lightweightShaders_, LightweightPass::Depth);
+    }
+    if (sampleQuery) {
+      sampleQuery->end();
+    }
+#ifndef MAGNUM_TARGET_GLES
+    if (query.box.id()) {
+      query.box.endConditionalRender();
+    }
+#endif
+  }
+
   std::unique_ptr<DepthShader> depthShader_;
+  // reconstructs the normals of the render targets from their depth
+  std::unique_ptr<DepthShader> normalShader_;
+  // unprojects the point clouds of the render targets from their depth
+  std::unique_ptr<DepthShader> pointShader_;
+  // remaps the object ids of the render targets through lookup tables
+  std::unique_ptr<ObjectIdRemapShader> objectIdRemapShader_;
+  // counts the object ids of the render targets
+  std::unique_ptr<ObjectIdHistogramShader> objectIdHistogramShader_;
+  // composes the foveated framebuffers into the render targets
+  std::unique_ptr<FoveationShader> foveationShader_;
+  // the inset and the periphery of the foveated sensors
+  std::unordered_map<const void*, PerView<FoveatedFramebuffer::uptr>>
+      foveatedFramebuffers_;
+  // shaders of the depth-only and object-id-only passes
+  LightweightShaders lightweightShaders_;
   const Flags flags_;
+  // occlusion culling history per sensor or camera, by ViewKey
+  std::unordered_map<const void*, PerView<OcclusionCuller::uptr>>
+      occlusionCullers_;
+  // render targets released by the sensors, the oldest first
+  std::vector<RenderTarget::uptr> renderTargetPool_;
+  std::size_t renderTargetPoolCapacity_ = 8;
+  // the bounding boxes of the objects of queryVisibility()
+  Mn::GL::Mesh visibilityBox_{Mn::NoCreate};
+  Mn::Shaders::Flat3D visibilityBoxShader_{Mn::NoCreate};
 };
 
 Renderer::Renderer(Flags flags)
@@ -92,8 +717,72 @@ void Renderer::draw(sensor::VisualSensor& visualSensor,
   pimpl_->draw(visualSensor, sceneGraph, flags);
 }
 
-void Renderer::bindRenderTarget(sensor::VisualSensor& sensor) {
-  pimpl_->bindRenderTarget(sensor);
+void Renderer::drawStereo(sensor::VisualSensor& leftEye,
+                          sensor::VisualSensor& rightEye,
+                          scene::SceneGraph& sceneGraph,
+                          const Mn::Range2Di& leftViewport,
+                          const Mn::Range2Di& rightViewport,
+                          RenderCamera::Flags flags) {
+  pimpl_->drawStereo(leftEye, rightEye, sceneGraph, leftViewport,
+                     rightViewport, flags);
+}
+
+void Renderer::bindRenderTarget(sensor::VisualSensor& sensor,
+                                bool topDownRows) {
+  pimpl_->bindRenderTarget(sensor, topDownRows);
+}
+
+void Renderer::releaseRenderTarget(sensor::VisualSensor& sensor) {
+  pimpl_->releaseRenderTarget(sensor);
+}
+
+void Renderer::setRenderTargetPoolCapacity(std::size_t capacity) {
+  pimpl_->setRenderTargetPoolCapacity(capacity);
+}
+
+std::size_t Renderer::renderTargetPoolSize() const {
+  return pimpl_->renderTargetPoolSize();
+}
+
+std::size_t Renderer::renderTargetPoolGpuBytes() const {
+  return pimpl_->renderTargetPoolGpuBytes();
+}
+
+void Renderer::resetOcclusionCulling() {
+  pimpl_->resetOcclusionCulling();
+}
+
+std::vector<float> Renderer::queryVisibility(
+    sensor::VisualSensor& sensor,
+    scene::SceneGraph& sceneGraph,
+    const std::vector<Mn::Matrix4>& poses,
+    const std::vector<scene::SceneNode*>& objects,
+    RenderCamera::Flags flags) {
+  return pimpl_->queryVisibility(sensor, sceneGraph, poses, objects, flags);
+}
+
+RenderTarget::uptr Renderer::createBatchRenderTarget(
+    sensor::VisualSensor& referenceSensor,
+    int batchSize) {
+  return pimpl_->createBatchRenderTarget(referenceSensor, batchSize);
+}
+
+void Renderer::drawBatch(RenderTarget& target,
+                         const std::vector<BatchEntry>& batch) {
+  pimpl_->drawBatch(target, batch);
+}
+
+Mn::Range2Di Renderer::batchTileViewport(const Mn::Vector2i& tileSize,
+                                         int batchSize,
+                                         int index) {
+  const int cols = Impl::batchGridSize(batchSize).x();
+  const Mn::Vector2i tile{index % cols, index / cols};
+  return Mn::Range2Di::fromSize(tile * tileSize, tileSize);
+}
+
+Mn::Vector2i Renderer::batchFramebufferSize(const Mn::Vector2i& tileSize,
+                                            int batchSize) {
+  return Impl::batchGridSize(batchSize) * tileSize;
 }
 
 }  // namespace gfx
@@ -5,6 +5,8 @@
 #ifndef ESP_GFX_RENDERER_H_
 #define ESP_GFX_RENDERER_H_
 
+#include <Magnum/Math/Range.h>
+
 #include "esp/core/esp.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/scene/SceneGraph.h"
@@ -13,6 +15,8 @@
 namespace esp {
 namespace gfx {
 
+class RenderTarget;
+
 class Renderer {
  public:
   enum class Flag {
@@ -22,6 +26,15 @@ class Renderer {
   typedef Corrade::Containers::EnumSet<Flag> Flags;
   CORRADE_ENUMSET_FRIEND_OPERATORS(Flags)
 
+  /**
+   * @brief A single (sensor, scene graph) view drawn by @ref drawBatch()
+   */
+  struct BatchEntry {
+    std::reference_wrapper<sensor::VisualSensor> sensor;
+    std::reference_wrapper<scene::SceneGraph> sceneGraph;
+    RenderCamera::Flags flags{RenderCamera::Flag::FrustumCulling};
+  };
+
   /**
    * @brief Constructor
    */
@@ -37,10 +50,158 @@ class Renderer {
             scene::SceneGraph& sceneGraph,
             RenderCamera::Flags flags = {RenderCamera::Flag::FrustumCulling});
 
+  /**
+   * @brief Draw the two eyes of a stereo pair into the framebuffer the caller
+   * has bound, e.g. the framebuffer of a WebXR layer
+   * @param leftEye       Pinhole sensor of the left eye
+   * @param rightEye      Pinhole sensor of the right eye, with the same
+   *                      orientation and projection, to the right of the
+   *                      left eye
+   * @param sceneGraph    The scene graph
+   * @param leftViewport  Where the left eye is drawn, with the aspect ratio
+   *                      of the sensor
+   * @param rightViewport Where the right eye is drawn
+   * @param flags         Flags of both eyes,
+   *                      @ref RenderCamera::Flag::OcclusionCulling is ignored
+   *
+   * The drawables are culled once against the frustum enclosing both eyes
+   * and the visible ones are drawn for each, without going through a
+   * @ref RenderTarget or reading the pixels back. The viewports aren't
+   * cleared. GL state changed by the caller is picked up, and the caller has
+   * to set its own state again afterwards.
+   */
+  void drawStereo(
+      sensor::VisualSensor& leftEye,
+      sensor::VisualSensor& rightEye,
+      scene::SceneGraph& sceneGraph,
+      const Magnum::Range2Di& leftViewport,
+      const Magnum::Range2Di& rightViewport,
+      RenderCamera::Flags flags = {RenderCamera::Flag::FrustumCulling});
+
   /**
    * @brief Binds a @ref RenderTarget to the sensor
+   * @param sensor        The sensor
+   * @param topDownRows   Whether the render target is drawn upside down so
+   *                      that its reads are top-down, see
+   *                      @ref RenderTarget::topDownRows()
+   *
+   * A render target the sensor has already goes to the pool of
+   * @ref releaseRenderTarget() first. The one bound is taken from the pool if
+   * one has the framebuffer size and the multisampling of the sensor and
+   * @p topDownRows, so that sensors rebound after a reconfiguration, or
+   * replacing removed ones, don't allocate new framebuffers.
+   */
+  void bindRenderTarget(sensor::VisualSensor& sensor,
+                        bool topDownRows = false);
+
+  /**
+   * @brief Unbind the render target of @p sensor into the pool of the render
+   * targets @ref bindRenderTarget() reuses, e.g. before the sensor is removed
+   *
+   * Does nothing if the sensor has no render target.
+   */
+  void releaseRenderTarget(sensor::VisualSensor& sensor);
+
+  /**
+   * @brief Set how many released render targets the pool keeps, the oldest
+   * are destroyed first. 0 destroys them on release, 8 by default.
+   */
+  void setRenderTargetPoolCapacity(std::size_t capacity);
+
+  /**
+   * @brief The number of released render targets in the pool
+   */
+  std::size_t renderTargetPoolSize() const;
+
+  /**
+   * @brief The GPU memory of the released render targets in the pool, in
+   * bytes, see @ref RenderTarget::getGpuBytes()
+   */
+  std::size_t renderTargetPoolGpuBytes() const;
+
+  /**
+   * @brief Drop the occlusion culling history of all sensors and cameras
+   *
+   * Drawing with @ref RenderCamera::Flag::OcclusionCulling keeps the query
+   * results of each sensor (or camera) between frames. Call this after the
+   * scene changed completely or sensors were destroyed.
+   */
+  void resetOcclusionCulling();
+
+  /**
+   * @brief The fractions of objects visible from several poses of a sensor
+   * @param sensor      Pinhole or orthographic sensor whose projection and
+   *                    render target the objects are drawn with
+   * @param sceneGraph  The scene graph the objects are in
+   * @param poses       Absolute transformations of the sensor, e.g. the
+   *                    candidate views of a planner
+   * @param objects     Nodes of the objects, the drawables of each node and
+   *                    its children make up an object
+   * @param flags       Flags of the depth pass of the scene,
+   *                    @ref RenderCamera::Flag::DepthOnly is implied
+   * @return The fraction of the samples of each object that is not occluded
+   *    and not outside the viewport, for each pose, the objects of the
+   *    first pose first. 0 for objects without drawables.
+   *
+   * The depth of the scene is drawn into the render target of the sensor
+   * from each pose, then the drawables of each object are drawn against it
+   * in an occlusion query, behind an any-samples query of their bounding box
+   * that skips the drawables of hidden objects on the GPU where conditional
+   * rendering is available. The samples of each object drawn alone are
+   * counted the same way. All poses are issued before any result is read,
+   * so the GPU stalls once per call. The contents of the render target are
+   * overwritten. Objects whose ids are per vertex of a single mesh, e.g. the
+   * objects of a semantic mesh, can't be drawn alone; count their pixels
+   * with @ref RenderTarget::readFrameObjectIdHistogram() instead.
+   */
+  std::vector<float> queryVisibility(
+      sensor::VisualSensor& sensor,
+      scene::SceneGraph& sceneGraph,
+      const std::vector<Magnum::Matrix4>& poses,
+      const std::vector<scene::SceneNode*>& objects,
+      RenderCamera::Flags flags = {RenderCamera::Flag::FrustumCulling});
+
+  /**
+   * @brief Creates a @ref RenderTarget large enough to hold @p batchSize tiles
+   * of the size of @p referenceSensor's framebuffer, laid out by @ref
+   * batchTileViewport(), with the multisampling of @p referenceSensor.
+   *
+   * All sensors drawn into this target with @ref drawBatch() must share the
+   * resolution and projection of @p referenceSensor, since depth is
+   * unprojected for the whole target at once.
+   */
+  std::unique_ptr<RenderTarget> createBatchRenderTarget(
+      sensor::VisualSensor& referenceSensor,
+      int batchSize);
+
+  /**
+   * @brief Draw every entry of @p batch into its own sub-viewport of @p target
+   *
+   * Entry i is drawn into @ref batchTileViewport(tileSize, batch.size(), i).
+   * Expects all sensors to have the resolution and the depth unprojection of
+   * the reference sensor @p target was created for.
+   * The framebuffer is cleared once and the full viewport is restored
+   * afterwards, so a single @ref RenderTarget::readFrameRgba() (or depth /
+   * object id read) retrieves the observations of the whole batch.
+   */
+  void drawBatch(RenderTarget& target, const std::vector<BatchEntry>& batch);
+
+  /**
+   * @brief The viewport of tile @p index in a batch of @p batchSize tiles of
+   * @p tileSize each.
+   *
+   * Tiles are arranged row-major in a grid of ceil(sqrt(batchSize)) columns,
+   * starting from the framebuffer origin (bottom-left in OpenGL conventions).
+   */
+  static Magnum::Range2Di batchTileViewport(const Magnum::Vector2i& tileSize,
+                                            int batchSize,
+                                            int index);
+
+  /**
+   * @brief The size of a framebuffer holding @p batchSize tiles of @p tileSize
    */
-  void bindRenderTarget(sensor::VisualSensor& sensor);
+  static Magnum::Vector2i batchFramebufferSize(const Magnum::Vector2i& tileSize,
+                                               int batchSize);
 
   // draw the scene graph with the default camera in scene graph
   // user needs to set the default camera so that it has correct
@@ -19,5 +19,10 @@ void setLightSetupForSubTree(scene::SceneNode& root,
       });
 }
 
+void prewarmShadersForSubTree(scene::SceneNode& root) {
+  scene::preOrderFeatureTraversalWithCallback<Drawable>(
+      root, [](Drawable& drawable) { drawable.prewarmShader(); });
+}
+
 }  // namespace gfx
 }  // namespace esp
@@ -8,15 +8,25 @@
 #include <Magnum/GL/AbstractShaderProgram.h>
 #include <Magnum/ResourceManager.h>
 
+#include "esp/gfx/InstanceBuffers.h"
 #include "esp/gfx/LightSetup.h"
 #include "esp/gfx/MaterialData.h"
+#include "esp/gfx/PbrImageBasedLighting.h"
+#include "esp/gfx/PbrMaterialBuffer.h"
+#include "esp/gfx/ProgramBinaryCache.h"
+#include "esp/gfx/TextureStreamer.h"
 
 namespace esp {
 namespace gfx {
 
 using ShaderManager = Magnum::ResourceManager<Magnum::GL::AbstractShaderProgram,
                                               gfx::LightSetup,
-                                              gfx::MaterialData>;
+                                              gfx::MaterialData,
+                                              gfx::TextureStreamer,
+                                              gfx::ProgramBinaryCache,
+                                              gfx::PbrMaterialBuffer,
+                                              gfx::PbrImageBasedLighting,
+                                              gfx::InstanceBuffers>;
 
 /**
  * @brief Set the light setup for a subtree
@@ -29,6 +39,14 @@ using ShaderManager = Magnum::ResourceManager<Magnum::GL::AbstractShaderProgram,
 void setLightSetupForSubTree(scene::SceneNode& root,
                              const Magnum::ResourceKey& lightSetup);
 
+/**
+ * @brief Create the shaders of all drawables in a subtree now, see
+ * @ref Drawable::prewarmShader()
+ *
+ * @param root Subtree root
+ */
+void prewarmShadersForSubTree(scene::SceneNode& root);
+
 }  // namespace gfx
 }  // namespace esp
 
@@ -0,0 +1,292 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "TextureCompression.h"
+
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Functions.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+typedef Mn::Color4ub Block[16];
+
+// Clamps to the edge for the blocks past the last row or column
+void readBlock(const Cr::Containers::StridedArrayView3D<const char>& pixels,
+               const int blockX,
+               const int blockY,
+               const bool hasAlpha,
+               Block& block) {
+  const int height = pixels.size()[0];
+  const int width = pixels.size()[1];
+  for (int y = 0; y != 4; ++y) {
+    const int row = std::min(4 * blockY + y, height - 1);
+    for (int x = 0; x != 4; ++x) {
+      const int column = std::min(4 * blockX + x, width - 1);
+      const Cr::Containers::StridedArrayView1D<const char> pixel =
+          pixels[row][column];
+      block[4 * y + x] = {Mn::UnsignedByte(pixel[0]),
+                          Mn::UnsignedByte(pixel[1]),
+                          Mn::UnsignedByte(pixel[2]),
+                          hasAlpha ? Mn::UnsignedByte(pixel[3])
+                                   : Mn::UnsignedByte(255)};
+    }
+  }
+}
+
+std::uint16_t packRgb565(const Mn::Vector3& color) {
+  const Mn::Vector3i bits{Mn::Math::round(
+      Mn::Math::clamp(color, 0.0f, 255.0f) *
+      Mn::Vector3{31.0f / 255.0f, 63.0f / 255.0f, 31.0f / 255.0f})};
+  return std::uint16_t(bits.r() << 11 | bits.g() << 5 | bits.b());
+}
+
+// Expanded the way the GPUs do, replicating the high bits
+Mn::Vector3 unpackRgb565(const std::uint16_t color) {
+  const int r = (color >> 11) & 31;
+  const int g = (color >> 5) & 63;
+  const int b = color & 31;
+  return {float(r << 3 | r >> 2), float(g << 2 | g >> 4),
+          float(b << 3 | b >> 2)};
+}
+
+// Picks the nearest of the four colors of the palette of @p end0 and @p end1
+// for every pixel, returns the squared error
+float fitIndices(const Mn::Vector3 (&colors)[16],
+                 const std::uint16_t end0,
+                 const std::uint16_t end1,
+                 std::uint32_t& indices) {
+  const Mn::Vector3 color0 = unpackRgb565(end0);
+  const Mn::Vector3 color1 = unpackRgb565(end1);
+  const Mn::Vector3 palette[4]{color0, color1, (2.0f * color0 + color1) / 3.0f,
+                               (color0 + 2.0f * color1) / 3.0f};
+  indices = 0;
+  float error = 0.0f;
+  for (int i = 0; i != 16; ++i) {
+    int best = 0;
+    float bestError = std::numeric_limits<float>::max();
+    for (int p = 0; p != 4; ++p) {
+      const float pixelError = (colors[i] - palette[p]).dot();
+      if (pixelError < bestError) {
+        best = p;
+        bestError = pixelError;
+      }
+    }
+    indices |= std::uint32_t(best) << 2 * i;
+    error += bestError;
+  }
+  return error;
+}
+
+// The end colors minimizing the squared error for @p indices, false if the
+// indices don't determine them, e.g. if they're all the same
+bool fitEnds(const Mn::Vector3 (&colors)[16],
+             const std::uint32_t indices,
+             Mn::Vector3& end0,
+             Mn::Vector3& end1) {
+  constexpr float Weights[4]{0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+  float a = 0.0f, b = 0.0f, c = 0.0f;
+  Mn::Vector3 x, y;
+  for (int i = 0; i != 16; ++i) {
+    const float w = Weights[(indices >> 2 * i) & 3];
+    a += (1.0f - w) * (1.0f - w);
+    b += (1.0f - w) * w;
+    c += w * w;
+    x += (1.0f - w) * colors[i];
+    y += w * colors[i];
+  }
+  const float determinant = a * c - b * b;
+  if (std::abs(determinant) < 1.0e-6f) {
+    return false;
+  }
+  end0 = (c * x - b * y) / determinant;
+  end1 = (a * y - b * x) / determinant;
+  return true;
+}
+
+void writeLittleEndian(std::uint64_t value, const int bytes, char* out) {
+  for (int i = 0; i != bytes; ++i) {
+    out[i] = char(value & 0xff);
+    value >>= 8;
+  }
+}
+
+void encodeColorBlock(const Block& block, char* out) {
+  Mn::Vector3 colors[16];
+  Mn::Vector3 mean;
+  Mn::Vector3 min{255.0f};
+  Mn::Vector3 max;
+  for (int i = 0; i != 16; ++i) {
+    colors[i] = Mn::Vector3{block[i].rgb()};
+    mean += colors[i];
+    min = Mn::Math::min(min, colors[i]);
+    max = Mn::Math::max(max, colors[i]);
+  }
+  mean /= 16.0f;
+
+  // the principal axis of the colors, by power iteration from the extent of
+  // the block
+  float xx = 0.0f, xy = 0.0f, xz = 0.0f, yy = 0.0f, yz = 0.0f, zz = 0.0f;
+  for (const Mn::Vector3& color : colors) {
+    const Mn::Vector3 d = color - mean;
+    xx += d.x() * d.x();
+    xy += d.x() * d.y();
+    xz += d.x() * d.z();
+    yy += d.y() * d.y();
+    yz += d.y() * d.z();
+    zz += d.z() * d.z();
+  }
+  Mn::Vector3 axis = max - min;
+  for (int iteration = 0; iteration != 4; ++iteration) {
+    axis = {xx * axis.x() + xy * axis.y() + xz * axis.z(),
+            xy * axis.x() + yy * axis.y() + yz * axis.z(),
+            xz * axis.x() + yz * axis.y() + zz * axis.z()};
+    const float scale = Mn::Math::abs(axis).max();
+    if (scale > 0.0f) {
+      axis /= scale;
+    }
+  }
+
+  // the colors furthest along it are the first guess of the ends
+  Mn::Vector3 end0 = colors[0];
+  Mn::Vector3 end1 = colors[0];
+  float lowest = std::numeric_limits<float>::max();
+  float highest = -std::numeric_limits<float>::max();
+  for (const Mn::Vector3& color : colors) {
+    const float projection = Mn::Math::dot(color, axis);
+    if (projection < lowest) {
+      lowest = projection;
+      end1 = color;
+    }
+    if (projection > highest) {
+      highest = projection;
+      end0 = color;
+    }
+  }
+  std::uint16_t packed0 = packRgb565(end0);
+  std::uint16_t packed1 = packRgb565(end1);
+  std::uint32_t indices;
+  const float error = fitIndices(colors, packed0, packed1, indices);
+
+  // refined by least squares for those indices, if that's better
+  if (fitEnds(colors, indices, end0, end1)) {
+    const std::uint16_t refined0 = packRgb565(end0);
+    const std::uint16_t refined1 = packRgb565(end1);
+    std::uint32_t refinedIndices;
+    if (fitIndices(colors, refined0, refined1, refinedIndices) < error) {
+      packed0 = refined0;
+      packed1 = refined1;
+      indices = refinedIndices;
+    }
+  }
+
+  // the four-color palette needs the first end greater than the second,
+  // swapping them swaps the indices 0 with 1 and 2 with 3
+  if (packed0 < packed1) {
+    std::swap(packed0, packed1);
+    indices ^= 0x55555555u;
+  } else if (packed0 == packed1) {
+    indices = 0;
+  }
+  writeLittleEndian(packed0, 2, out);
+  writeLittleEndian(packed1, 2, out + 2);
+  writeLittleEndian(indices, 4, out + 4);
+}
+
+void encodeAlphaBlock(const Block& block, char* out) {
+  int alpha0 = 0;
+  int alpha1 = 255;
+  for (const Mn::Color4ub& pixel : block) {
+    alpha0 = std::max(alpha0, int(pixel.a()));
+    alpha1 = std::min(alpha1, int(pixel.a()));
+  }
+
+  // the eight-value palette, with the first end greater than the second
+  std::uint64_t indices = 0;
+  if (alpha0 != alpha1) {
+    int palette[8]{alpha0, alpha1};
+    for (int p = 2; p != 8; ++p) {
+      palette[p] = ((8 - p) * alpha0 + (p - 1) * alpha1 + 3) / 7;
+    }
+    for (int i = 0; i != 16; ++i) {
+      int best = 0;
+      for (int p = 1; p != 8; ++p) {
+        if (std::abs(block[i].a() - palette[p]) <
+            std::abs(block[i].a() - palette[best])) {
+          best = p;
+        }
+      }
+      indices |= std::uint64_t(best) << 3 * i;
+    }
+  }
+  out[0] = char(alpha0);
+  out[1] = char(alpha1);
+  writeLittleEndian(indices, 6, out + 2);
+}
+
+}  // namespace
+
+bool isTextureCompressible(const Mn::PixelFormat format) {
+  return format == Mn::PixelFormat::RGB8Unorm ||
+         format == Mn::PixelFormat::RGBA8Unorm;
+}
+
+Mn::Trade::ImageData2D compressTextureImage(
+    const Mn::Trade::ImageData2D& image,
+    const bool forceAlpha) {
+  CORRADE_ASSERT(
+      !image.isCompressed() && isTextureCompressible(image.format()),
+      "esp::gfx::compressTextureImage(): expected an RGB8 or RGBA8 image",
+      (Mn::Trade::ImageData2D{Mn::CompressedPixelFormat::Bc1RGBUnorm,
+                              {},
+                              Cr::Containers::Array<char>{}}));
+
+  const Cr::Containers::StridedArrayView3D<const char> pixels = image.pixels();
+  const bool hasAlpha = image.format() == Mn::PixelFormat::RGBA8Unorm;
+  bool alpha = hasAlpha && forceAlpha;
+  for (int y = 0; hasAlpha && !alpha && y != image.size().y(); ++y) {
+    for (int x = 0; x != image.size().x(); ++x) {
+      if (Mn::UnsignedByte(pixels[y][x][3]) != 255) {
+        alpha = true;
+        break;
+      }
+    }
+  }
+
+  // 8 bytes per 4x4 block for the colors, 8 more in front for the alpha
+  const Mn::Vector2i blocks = (image.size() + Mn::Vector2i{3}) / 4;
+  const std::size_t blockSize = alpha ? 16 : 8;
+  Cr::Containers::Array<char> data{Cr::Containers::NoInit,
+                                   std::size_t(blocks.product()) * blockSize};
+  char* out = data.data();
+  Block block;
+  for (int blockY = 0; blockY != blocks.y(); ++blockY) {
+    for (int blockX = 0; blockX != blocks.x(); ++blockX) {
+      readBlock(pixels, blockX, blockY, hasAlpha, block);
+      if (alpha) {
+        encodeAlphaBlock(block, out);
+        out += 8;
+      }
+      encodeColorBlock(block, out);
+      out += 8;
+    }
+  }
+  return Mn::Trade::ImageData2D{alpha ? Mn::CompressedPixelFormat::Bc3RGBAUnorm
+                                      : Mn::CompressedPixelFormat::Bc1RGBUnorm,
+                                image.size(), std::move(data)};
+}
+
+}  // namespace gfx
+}  // namespace esp
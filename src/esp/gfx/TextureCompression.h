@@ -0,0 +1,50 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_TEXTURECOMPRESSION_H_
+#define ESP_GFX_TEXTURECOMPRESSION_H_
+
+/** @file
+ * @brief Function @ref esp::gfx::compressTextureImage(),
+ * @ref esp::gfx::isTextureCompressible()
+ */
+
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/ImageData.h>
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Whether @ref compressTextureImage() compresses images of @p format
+ *
+ * True for @ref Magnum::PixelFormat::RGB8Unorm and
+ * @ref Magnum::PixelFormat::RGBA8Unorm.
+ */
+bool isTextureCompressible(Magnum::PixelFormat format);
+
+/**
+ * @brief Compress an uncompressed 8-bit color image to S3TC blocks
+ *
+ * RGB images and RGBA images whose alpha is opaque everywhere are compressed
+ * to BC1, a sixth of RGB8 and an eighth of RGBA8, other RGBA images to BC3,
+ * a quarter of RGBA8. The end colors of each 4x4 block are fit along the
+ * principal axis of its colors and refined once by least squares, like
+ * common real-time encoders do; the image is compressed on the calling
+ * thread, so images are compressed in parallel by compressing each on its
+ * own thread.
+ *
+ * @param image An image of a format for which @ref isTextureCompressible()
+ * is true, of any size. Edge blocks repeat the last row or column.
+ * @param forceAlpha Compress RGBA images to BC3 even if they are opaque,
+ * e.g. for the levels of an image whose other levels are not
+ */
+Magnum::Trade::ImageData2D compressTextureImage(
+    const Magnum::Trade::ImageData2D& image,
+    bool forceAlpha = false);
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_TEXTURECOMPRESSION_H_
@@ -0,0 +1,228 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "TextureStreamer.h"
+
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/PixelFormat.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Mn = Magnum;
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+
+void TextureStreamer::addTexture(Mn::GL::Texture2D& texture,
+                                 Mn::GL::TextureFormat format,
+                                 std::vector<Mn::Trade::ImageData2D> levels) {
+  CORRADE_ASSERT(
+      !levels.empty(),
+      "TextureStreamer::addTexture(): expected at least one level", );
+  CORRADE_ASSERT(!hasTexture(texture),
+                 "TextureStreamer::addTexture(): texture added already", );
+
+  const int levelCount = levels.size();
+  int minResidentLevel = levelCount - 1;
+  for (int level = 0; level < levelCount; ++level) {
+    if (levels[level].size().max() <= MinResidentSize) {
+      minResidentLevel = level;
+      break;
+    }
+  }
+
+  Entry entry{&texture, format, std::move(levels), levelCount,
+              minResidentLevel};
+  texture.setMaxLevel(levelCount - 1);
+  for (int level = levelCount - 1; level >= minResidentLevel; --level) {
+    upload(entry, level);
+  }
+  for (int level = 0; level < levelCount; ++level) {
+    statistics_.hostBytes += levelBytes(entry, level);
+  }
+
+  entryIndices_.emplace(&texture, entries_.size());
+  entries_.push_back(std::move(entry));
+}
+
+void TextureStreamer::removeTexture(const Mn::GL::Texture2D& texture) {
+  auto found = entryIndices_.find(&texture);
+  if (found == entryIndices_.end()) {
+    return;
+  }
+  const std::size_t index = found->second;
+  entryIndices_.erase(found);
+
+  const Entry& entry = entries_[index];
+  const int levelCount = entry.levels.size();
+  for (int level = 0; level < levelCount; ++level) {
+    statistics_.hostBytes -= levelBytes(entry, level);
+    if (level >= entry.residentLevel) {
+      statistics_.residentBytes -= levelBytes(entry, level);
+    }
+  }
+
+  // move the last entry into the hole
+  if (index != entries_.size() - 1) {
+    entries_[index] = std::move(entries_.back());
+    entryIndices_[entries_[index].texture] = index;
+  }
+  entries_.pop_back();
+}
+
+void TextureStreamer::request(const Mn::GL::Texture2D& texture,
+                              float pixelExtent) {
+  auto found = entryIndices_.find(&texture);
+  if (found == entryIndices_.end()) {
+    return;
+  }
+  Entry& entry = entries_[found->second];
+  entry.lastUsedFrame = frame_;
+
+  // the coarsest level with at least one texel per pixel, assuming the
+  // texture spans the object once
+  int wantedLevel = entry.minResidentLevel;
+  if (pixelExtent > 0.0f) {
+    const float texelsPerPixel = entry.levels[0].size().max() / pixelExtent;
+    wantedLevel = std::min(
+        wantedLevel, std::max(0, int(std::floor(std::log2(texelsPerPixel)))));
+  }
+
+  while (entry.residentLevel > wantedLevel) {
+    const int level = entry.residentLevel - 1;
+    const std::size_t bytes = levelBytes(entry, level);
+    bool fits = true;
+    while (budgetBytes_ && statistics_.residentBytes + bytes > budgetBytes_) {
+      if (!evictOne(entry)) {
+        fits = false;
+        break;
+      }
+    }
+    if (!fits) {
+      ++statistics_.numBudgetMisses;
+      break;
+    }
+    upload(entry, level);
+    ++statistics_.numStreamedLevels;
+    statistics_.uploadedBytes += bytes;
+  }
+}
+
+TextureStreamer::Statistics TextureStreamer::statistics() const {
+  Statistics statistics = statistics_;
+  statistics.budgetBytes = budgetBytes_;
+  statistics.numTextures = entries_.size();
+  return statistics;
+}
+
+std::size_t TextureStreamer::levelBytes(const Entry& entry, int level) {
+  return entry.levels[level].data().size();
+}
+
+void TextureStreamer::upload(Entry& entry, int level) {
+  const Mn::Trade::ImageData2D& image = entry.levels[level];
+  if (image.isCompressed()) {
+    entry.texture->setCompressedImage(level, image);
+  } else {
+    entry.texture->setImage(level, entry.format, image);
+  }
+  entry.residentLevel = level;
+  entry.texture->setBaseLevel(level);
+  statistics_.residentBytes += levelBytes(entry, level);
+}
+
+bool TextureStreamer::evictOne(const Entry& keep) {
+  Entry* leastRecentlyUsed = nullptr;
+  for (Entry& entry : entries_) {
+    if (&entry == &keep || entry.lastUsedFrame == frame_ ||
+        entry.residentLevel >= entry.minResidentLevel) {
+      continue;
+    }
+    if (!leastRecentlyUsed ||
+        entry.lastUsedFrame < leastRecentlyUsed->lastUsedFrame) {
+      leastRecentlyUsed = &entry;
+    }
+  }
+  if (!leastRecentlyUsed) {
+    return false;
+  }
+
+  Entry& entry = *leastRecentlyUsed;
+  const int level = entry.residentLevel;
+  entry.residentLevel = level + 1;
+  entry.texture->setBaseLevel(level + 1);
+  // levels below the base level are not sampled, respecify the evicted one
+  // as empty to release its memory
+  const Mn::Trade::ImageData2D& image = entry.levels[level];
+  if (image.isCompressed()) {
+    entry.texture->setCompressedImage(
+        level, Mn::CompressedImageView2D{image.compressedFormat(), {}});
+  } else {
+    entry.texture->setImage(level, entry.format,
+                            Mn::ImageView2D{image.format(), {}});
+  }
+  statistics_.residentBytes -= levelBytes(entry, level);
+  ++statistics_.numEvictedLevels;
+  return true;
+}
+
+std::vector<Mn::Trade::ImageData2D> TextureStreamer::generateMipLevels(
+    Mn::Trade::ImageData2D&& image) {
+  std::vector<Mn::Trade::ImageData2D> levels;
+  const bool supported =
+      !image.isCompressed() &&
+      (image.format() == Mn::PixelFormat::R8Unorm ||
+       image.format() == Mn::PixelFormat::RG8Unorm ||
+       image.format() == Mn::PixelFormat::RGB8Unorm ||
+       image.format() == Mn::PixelFormat::RGBA8Unorm ||
+       image.format() == Mn::PixelFormat::R8Srgb ||
+       image.format() == Mn::PixelFormat::RG8Srgb ||
+       image.format() == Mn::PixelFormat::RGB8Srgb ||
+       image.format() == Mn::PixelFormat::RGBA8Srgb);
+  const Mn::PixelFormat format = supported ? image.format() : Mn::PixelFormat{};
+  levels.reserve(Mn::Math::log2(image.size().max()) + 1);
+  levels.push_back(std::move(image));
+  if (!supported) {
+    return levels;
+  }
+
+  const std::size_t channels = Mn::pixelSize(format);
+  while (levels.back().size() != Mn::Vector2i{1}) {
+    const Mn::Trade::ImageData2D& previous = levels.back();
+    const Mn::Vector2i previousSize = previous.size();
+    const Mn::Vector2i size = Mn::Math::max(previousSize / 2, Mn::Vector2i{1});
+    const Cr::Containers::StridedArrayView3D<const char> source =
+        previous.pixels();
+
+    // sRGB levels are filtered in gamma space as well, which is what most
+    // offline tools do too
+    Cr::Containers::Array<char> data{Cr::Containers::NoInit,
+                                     std::size_t(size.product()) * channels};
+    for (int y = 0; y < size.y(); ++y) {
+      const int y0 = std::min(2 * y, previousSize.y() - 1);
+      const int y1 = std::min(2 * y + 1, previousSize.y() - 1);
+      for (int x = 0; x < size.x(); ++x) {
+        const int x0 = std::min(2 * x, previousSize.x() - 1);
+        const int x1 = std::min(2 * x + 1, previousSize.x() - 1);
+        for (std::size_t c = 0; c < channels; ++c) {
+          const unsigned int sum = Mn::UnsignedByte(source[y0][x0][c]) +
+                                   Mn::UnsignedByte(source[y0][x1][c]) +
+                                   Mn::UnsignedByte(source[y1][x0][c]) +
+                                   Mn::UnsignedByte(source[y1][x1][c]);
+          data[(y * size.x() + x) * channels + c] = char((sum + 2) / 4);
+        }
+      }
+    }
+    levels.emplace_back(Mn::PixelStorage{}.setAlignment(1), format, size,
+                        std::move(data));
+  }
+  return levels;
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,159 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_TEXTURESTREAMER_H_
+#define ESP_GFX_TEXTURESTREAMER_H_
+
+#include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureFormat.h>
+#include <Magnum/Trade/ImageData.h>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+
+/**
+ * @brief Keeps the textures of the loaded assets within a GPU memory budget
+ *
+ * The mip levels of every texture added with @ref addTexture() are kept in
+ * host memory. Only the coarse levels, up to @ref MinResidentSize pixels, are
+ * uploaded up front; finer levels are uploaded when a drawable asks for them
+ * with @ref request(), based on its projected size. When the budget would be
+ * exceeded, the finest levels of the textures which were used the longest
+ * time ago are evicted first. Textures used in the current frame (see
+ * @ref nextFrame()) are never evicted, so a budget smaller than the working
+ * set of a frame leaves textures blurry instead of thrashing.
+ *
+ * The textures use mutable storage, the resident levels are selected with
+ * the base level of the texture.
+ */
+class TextureStreamer {
+ public:
+  /** @brief Key of the streamer in the @ref ShaderManager */
+  static constexpr const char* Key = "texture-streamer";
+
+  //! levels of at most this size are always resident
+  static constexpr int MinResidentSize = 128;
+
+  /** @brief Streaming statistics, see @ref statistics() */
+  struct Statistics {
+    //! the budget, 0 if unlimited
+    std::size_t budgetBytes = 0;
+    //! GPU memory of the resident levels of all textures
+    std::size_t residentBytes = 0;
+    //! host memory of the levels kept for streaming
+    std::size_t hostBytes = 0;
+    std::size_t numTextures = 0;
+    //! levels uploaded after the textures were added
+    std::size_t numStreamedLevels = 0;
+    std::size_t numEvictedLevels = 0;
+    //! requests which could not be satisfied within the budget
+    std::size_t numBudgetMisses = 0;
+    std::size_t uploadedBytes = 0;
+  };
+
+  /**
+   * @brief Constructor
+   * @param budgetBytes, the GPU memory budget of the textures, 0 for
+   * unlimited
+   */
+  explicit TextureStreamer(std::size_t budgetBytes = 0)
+      : budgetBytes_{budgetBytes} {}
+
+  /**
+   * @brief Set the GPU memory budget, 0 for unlimited. A lower budget is
+   * enforced by the next @ref request() needing memory.
+   */
+  void setBudget(std::size_t budgetBytes) { budgetBytes_ = budgetBytes; }
+
+  /** @brief The GPU memory budget, 0 if unlimited */
+  std::size_t budget() const { return budgetBytes_; }
+
+  /**
+   * @brief Add a texture and upload its coarse levels
+   * @param texture, the texture, without storage yet; its sampler state is
+   * kept
+   * @param format, the texture format of all levels
+   * @param levels, all the mip levels, from the finest to the coarsest, all
+   * compressed or all uncompressed
+   */
+  void addTexture(Magnum::GL::Texture2D& texture,
+                  Magnum::GL::TextureFormat format,
+                  std::vector<Magnum::Trade::ImageData2D> levels);
+
+  /**
+   * @brief Forget @p texture, e.g. before it is destroyed
+   *
+   * Releases the host copies of its levels. The texture itself is left as it
+   * is. Does nothing if it was not added to the streamer.
+   */
+  void removeTexture(const Magnum::GL::Texture2D& texture);
+
+  /** @brief Whether @p texture was added to the streamer */
+  bool hasTexture(const Magnum::GL::Texture2D& texture) const {
+    return entryIndices_.count(&texture);
+  }
+
+  /**
+   * @brief Make the levels needed for @p texture to cover @p pixelExtent
+   * pixels resident, if the budget allows it
+   * @param texture, the texture, ignored if it was not added to the streamer
+   * @param pixelExtent, the extent of the object it is drawn on, in pixels,
+   * may be infinity
+   *
+   * Marks @p texture as used in the current frame.
+   */
+  void request(const Magnum::GL::Texture2D& texture, float pixelExtent);
+
+  /** @brief Start a new frame, e.g. the render pass of another sensor */
+  void nextFrame() { ++frame_; }
+
+  /** @brief The streaming statistics */
+  Statistics statistics() const;
+
+  /**
+   * @brief Compute the mip chain of an uncompressed 8-bit image with a box
+   * filter
+   * @return @p image followed by its mip levels down to 1x1, or @p image
+   * alone if its format is not one of the 8-bit normalized formats
+   */
+  static std::vector<Magnum::Trade::ImageData2D> generateMipLevels(
+      Magnum::Trade::ImageData2D&& image);
+
+ private:
+  struct Entry {
+    Magnum::GL::Texture2D* texture;
+    Magnum::GL::TextureFormat format;
+    std::vector<Magnum::Trade::ImageData2D> levels;
+    // finest resident level
+    int residentLevel;
+    // levels from this one on are never evicted
+    int minResidentLevel;
+    std::size_t lastUsedFrame = 0;
+  };
+
+  static std::size_t levelBytes(const Entry& entry, int level);
+  void upload(Entry& entry, int level);
+  // evict the finest level of the least recently used texture other than
+  // @p keep, false if there is none
+  bool evictOne(const Entry& keep);
+
+  std::size_t budgetBytes_;
+  std::vector<Entry> entries_;
+  std::unordered_map<const Magnum::GL::Texture2D*, std::size_t> entryIndices_;
+  // starts at 1, so textures never requested are the least recently used
+  std::size_t frame_ = 1;
+  Statistics statistics_;
+
+  ESP_SMART_POINTERS(TextureStreamer)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_TEXTURESTREAMER_H_
@@ -42,9 +42,11 @@ struct WindowlessContext::Impl {
 
 #if defined(CORRADE_TARGET_UNIX) && !defined(CORRADE_TARGET_APPLE)
 #ifdef ESP_BUILD_EGL_SUPPORT
+    if (device == AUTO_GPU_DEVICE)
+      device = device_ = leastLoadedGpuDevice();
     config.setCudaDevice(device);
 #else  // NO ESP_BUILD_EGL_SUPPORT
-    if (device != 0)
+    if (device != 0 && device != AUTO_GPU_DEVICE)
       Mn::Fatal{} << "GLX context does not support multiple GPUs. Please "
                      "compile with --headless for multi-gpu support via EGL";
 
@@ -53,6 +55,9 @@ struct WindowlessContext::Impl {
                      "--headless for EGL support";
 #endif
 #endif
+    // the other platforms have a single device
+    if (device_ == AUTO_GPU_DEVICE)
+      device_ = 0;
 
     windowlessGLContext_ =
         Mn::Platform::WindowlessGLContext{config, &magnumGLContext_};
@@ -64,8 +69,12 @@ struct WindowlessContext::Impl {
 
     if (!magnumGLContext_.tryCreate())
       Mn::Fatal{} << "WindowlessContext: Failed to create OpenGL context";
+
+    countGpuDeviceContext(device_, 1);
   }
 
+  ~Impl() { countGpuDeviceContext(device_, -1); }
+
   void makeCurrent() { windowlessGLContext_.makeCurrent(); }
 
   int gpuDevice() const { return device_; }
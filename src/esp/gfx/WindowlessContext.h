@@ -6,18 +6,26 @@
 #define ESP_GFX_WINDOWLESSCONTEXT_H_
 
 #include "esp/core/esp.h"
+#include "esp/gfx/GpuDevices.h"
 
 namespace esp {
 namespace gfx {
 
 class WindowlessContext {
  public:
+  /**
+   * @brief Constructor
+   * @param gpuDevice, the CUDA device id of the GPU to create the context on,
+   * @ref AUTO_GPU_DEVICE for the least loaded one, see
+   * @ref leastLoadedGpuDevice()
+   */
   explicit WindowlessContext(int gpuDevice = 0);
 
   ~WindowlessContext() { LOG(INFO) << "Deconstructing WindowlessContext"; }
 
   void makeCurrent();
 
+  /** @brief The device the context is on, never @ref AUTO_GPU_DEVICE */
   int gpuDevice() const;
 
   ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(WindowlessContext)
@@ -0,0 +1,294 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "KeyframeServer.h"
+#include "KeyframeStream.h"
+
+#include <Corrade/Utility/Sha1.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <map>
+#include <memory>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+namespace replay {
+
+namespace {
+// Viewers that have this much unsent data are disconnected
+constexpr std::size_t maxPendingBytes = 64 * 1024 * 1024;
+// Requests without the end of their headers after this much are rejected
+constexpr std::size_t maxRequestBytes = 16 * 1024;
+const char* const webSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+std::string base64(const char* data, const std::size_t size) {
+  static const char* const alphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (std::size_t i = 0; i < size; i += 3) {
+    uint32_t bits = uint8_t(data[i]) << 16;
+    if (i + 1 < size)
+      bits |= uint8_t(data[i + 1]) << 8;
+    if (i + 2 < size)
+      bits |= uint8_t(data[i + 2]);
+    out += alphabet[(bits >> 18) & 63];
+    out += alphabet[(bits >> 12) & 63];
+    out += i + 1 < size ? alphabet[(bits >> 6) & 63] : '=';
+    out += i + 2 < size ? alphabet[bits & 63] : '=';
+  }
+  return out;
+}
+
+// The value of a header of an HTTP request, empty if it's missing
+std::string headerValue(const std::string& request, std::string name) {
+  std::string lower = request;
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  std::size_t begin = lower.find("\r\n" + name + ":");
+  if (begin == std::string::npos)
+    return {};
+  begin += name.size() + 3;
+  const std::size_t end = request.find("\r\n", begin);
+  std::string value = request.substr(begin, end - begin);
+  value.erase(0, value.find_first_not_of(" \t"));
+  value.erase(value.find_last_not_of(" \t") + 1);
+  return value;
+}
+
+// Appends an unmasked binary WebSocket frame
+void appendFrame(std::string& out, const std::string& payload) {
+  out += char(0x82);
+  const uint64_t size = payload.size();
+  if (size < 126) {
+    out += char(size);
+  } else if (size < 65536) {
+    out += char(126);
+    out += char(size >> 8);
+    out += char(size);
+  } else {
+    out += char(127);
+    for (int i = 7; i >= 0; --i)
+      out += char(size >> (8 * i));
+  }
+  out += payload;
+}
+
+struct Viewer {
+  int fd;
+  bool open = false;
+  std::string request;
+  std::string pending;
+  std::unique_ptr<KeyframeEncoder> encoder;
+};
+}  // namespace
+
+struct KeyframeServer::Impl {
+  int fd = -1;
+  int port = -1;
+  float translationQuantum;
+  std::vector<Viewer> viewers;
+
+  // What has been published so far, sent to the viewers that connect
+  std::vector<esp::assets::AssetInfo> loads;
+  std::map<RenderAssetInstanceKey, esp::assets::RenderAssetInstanceCreationInfo>
+      creations;
+  std::map<RenderAssetInstanceKey, RenderAssetInstanceState> states;
+
+  Keyframe currentScene() const {
+    Keyframe keyframe;
+    keyframe.loads = loads;
+    keyframe.creations.assign(creations.begin(), creations.end());
+    keyframe.stateUpdates.assign(states.begin(), states.end());
+    return keyframe;
+  }
+
+  void accept() {
+    while (true) {
+      const int viewerFd = ::accept(fd, nullptr, nullptr);
+      if (viewerFd < 0)
+        return;
+      fcntl(viewerFd, F_SETFL, fcntl(viewerFd, F_GETFL) | O_NONBLOCK);
+      viewers.push_back(Viewer{viewerFd});
+    }
+  }
+
+  // Returns false if the viewer disconnected or sent a bad request
+  bool receive(Viewer& viewer) {
+    char buffer[4096];
+    while (true) {
+      const ssize_t size = ::recv(viewer.fd, buffer, sizeof(buffer), 0);
+      if (size == 0)
+        return false;
+      if (size < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+      if (viewer.open) {
+        // a close frame, anything else a viewer sends is ignored
+        if ((buffer[0] & 0x0f) == 0x8)
+          return false;
+        continue;
+      }
+      viewer.request.append(buffer, size);
+      if (viewer.request.find("\r\n\r\n") != std::string::npos)
+        return handshake(viewer);
+      if (viewer.request.size() > maxRequestBytes)
+        return false;
+    }
+  }
+
+  bool handshake(Viewer& viewer) {
+    const std::string key = headerValue(viewer.request, "Sec-WebSocket-Key");
+    if (key.empty()) {
+      LOG(WARNING) << "KeyframeServer: rejected a request that isn't a "
+                      "WebSocket handshake";
+      return false;
+    }
+    const Cr::Utility::Sha1::Digest digest =
+        Cr::Utility::Sha1::digest(key + webSocketGuid);
+    viewer.pending +=
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: " +
+        base64(digest.byteArray(), Cr::Utility::Sha1::DigestSize) + "\r\n\r\n";
+    viewer.open = true;
+    viewer.request.clear();
+
+    viewer.encoder = std::make_unique<KeyframeEncoder>(translationQuantum);
+    appendFrame(viewer.pending, keyframeStreamHeader(translationQuantum));
+    std::string message;
+    viewer.encoder->encode(currentScene(), message);
+    appendFrame(viewer.pending, message);
+    return true;
+  }
+
+  // Returns false if the viewer disconnected or is too far behind
+  bool flush(Viewer& viewer) {
+    while (!viewer.pending.empty()) {
+      const ssize_t size = ::send(viewer.fd, viewer.pending.data(),
+                                  viewer.pending.size(), MSG_NOSIGNAL);
+      if (size < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+          return false;
+        break;
+      }
+      viewer.pending.erase(0, size);
+    }
+    if (viewer.pending.size() > maxPendingBytes) {
+      LOG(WARNING) << "KeyframeServer: disconnected a viewer that doesn't "
+                      "keep up with the keyframes";
+      return false;
+    }
+    return true;
+  }
+
+  void update(const Keyframe& keyframe) {
+    loads.insert(loads.end(), keyframe.loads.begin(), keyframe.loads.end());
+    for (const auto& pair : keyframe.creations)
+      creations[pair.first] = pair.second;
+    for (const RenderAssetInstanceKey key : keyframe.deletions) {
+      creations.erase(key);
+      states.erase(key);
+    }
+    for (const auto& pair : keyframe.stateUpdates)
+      states[pair.first] = pair.second;
+  }
+};
+
+KeyframeServer::KeyframeServer(const int port, const float translationQuantum)
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {
+  CORRADE_ASSERT(translationQuantum > 0,
+                 "KeyframeServer: expected a positive translation quantum, got"
+                     << translationQuantum, );
+  pimpl_->translationQuantum = translationQuantum;
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    LOG(ERROR) << "KeyframeServer: cannot create a socket";
+    return;
+  }
+  const int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  socklen_t addressSize = sizeof(address);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), addressSize) < 0 ||
+      listen(fd, 16) < 0 ||
+      getsockname(fd, reinterpret_cast<sockaddr*>(&address), &addressSize) <
+          0) {
+    LOG(ERROR) << "KeyframeServer: cannot listen on port " << port;
+    ::close(fd);
+    return;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  pimpl_->fd = fd;
+  pimpl_->port = ntohs(address.sin_port);
+  LOG(INFO) << "KeyframeServer: serving keyframes on port " << pimpl_->port;
+}
+
+KeyframeServer::~KeyframeServer() {
+  for (const Viewer& viewer : pimpl_->viewers)
+    ::close(viewer.fd);
+  if (pimpl_->fd >= 0)
+    ::close(pimpl_->fd);
+}
+
+bool KeyframeServer::isListening() const {
+  return pimpl_->fd >= 0;
+}
+
+int KeyframeServer::port() const {
+  return pimpl_->port;
+}
+
+void KeyframeServer::publish(const Keyframe& keyframe) {
+  // the viewers that connect now start from the scene before this keyframe
+  poll();
+  pimpl_->update(keyframe);
+  for (Viewer& viewer : pimpl_->viewers) {
+    if (!viewer.open)
+      continue;
+    std::string message;
+    viewer.encoder->encode(keyframe, message);
+    appendFrame(viewer.pending, message);
+  }
+  poll();
+}
+
+void KeyframeServer::poll() {
+  if (pimpl_->fd < 0)
+    return;
+  pimpl_->accept();
+  auto& viewers = pimpl_->viewers;
+  for (std::size_t i = 0; i < viewers.size();) {
+    if (pimpl_->receive(viewers[i]) && pimpl_->flush(viewers[i])) {
+      ++i;
+    } else {
+      ::close(viewers[i].fd);
+      viewers.erase(viewers.begin() + i);
+    }
+  }
+}
+
+int KeyframeServer::numViewers() const {
+  return std::count_if(pimpl_->viewers.begin(), pimpl_->viewers.end(),
+                       [](const Viewer& viewer) { return viewer.open; });
+}
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
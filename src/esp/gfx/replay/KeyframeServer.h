@@ -0,0 +1,71 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_REPLAY_KEYFRAMESERVER_H_
+#define ESP_GFX_REPLAY_KEYFRAMESERVER_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::replay::KeyframeServer
+ */
+
+#include "Keyframe.h"
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace gfx {
+namespace replay {
+
+/**
+ * @brief Serves render keyframes to remote viewers over WebSockets
+ *
+ * The keyframes are sent in binary messages in the format of @ref
+ * KeyframeEncoder, so that the process that publishes them only pays for
+ * their serialization, and a viewer, e.g. in a browser, renders them with a
+ * @ref Player. A viewer that connects receives a header message, the same as
+ * the header of the files of @ref KeyframeStreamWriter, then a keyframe with
+ * the loads, creations and latest instance states published so far, then
+ * each keyframe published afterwards.
+ *
+ * There is no thread: the connections are accepted and the messages sent,
+ * without blocking, when a keyframe is published or on @ref poll(). A viewer
+ * that doesn't keep up with the messages is disconnected rather than slowing
+ * down the publisher.
+ */
+class KeyframeServer {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] port The TCP port to listen on, 0 for any free one
+   * @param[in] translationQuantum The precision of the translations of the
+   *                               instances, in meters
+   */
+  explicit KeyframeServer(int port, float translationQuantum = 1e-4f);
+
+  ~KeyframeServer();
+
+  /** @brief Whether the server could listen on its port */
+  bool isListening() const;
+
+  /** @brief The port listened on, -1 if not listening */
+  int port() const;
+
+  /** @brief Send a keyframe to the connected viewers */
+  void publish(const Keyframe& keyframe);
+
+  /** @brief Accept connections and send the pending messages */
+  void poll();
+
+  /** @brief The number of connected viewers */
+  int numViewers() const;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(KeyframeServer)
+};
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
+
+#endif
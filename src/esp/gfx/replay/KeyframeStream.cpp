@@ -0,0 +1,537 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "KeyframeStream.h"
+
+#include "esp/core/MappedFile.h"
+#include "esp/core/esp.h"
+
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Quaternion.h>
+#include <Magnum/Math/Vector4.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace replay {
+
+namespace {
+constexpr char fileMagic[4] = {'H', 'S', 'K', 'F'};
+// Version 1 stored absolute translations in multiples of 0.1 mm and the four
+// rotation components in 16 bits each. Version 2 stores the translation
+// quantum in the header, the translations as differences to the previous
+// state of the instance and the rotations as their smallest three components.
+constexpr uint32_t fileVersion = 2;
+// The chunks are stored as they are, the flag leaves room for compressed ones
+constexpr uint8_t chunkUncompressed = 0;
+constexpr std::size_t chunkHeaderSize = 9;
+constexpr float version1TranslationQuantum = 1e-4f;
+constexpr float version1RotationScale = 32767.0f;
+// Bits per smallest component of a rotation, which are at most 1/sqrt(2)
+constexpr int smallestBits = 15;
+constexpr float smallestScale = (1 << smallestBits) - 1;
+constexpr float smallestMax = 0.70710678f;
+
+using Vector3l = Mn::Math::Vector3<int64_t>;
+using Translations = std::unordered_map<RenderAssetInstanceKey, Vector3l>;
+
+// The index of the largest component of a normalized quaternion, flipped
+// positive, in the 2 low bits, then its other components
+uint64_t packRotation(const Mn::Quaternion& rotation) {
+  const Mn::Vector4 q{rotation.vector(), rotation.scalar()};
+  int largest = 0;
+  for (int i = 1; i < 4; ++i) {
+    if (std::abs(q[i]) > std::abs(q[largest]))
+      largest = i;
+  }
+  const float sign = q[largest] < 0 ? -1.0f : 1.0f;
+  uint64_t bits = largest;
+  int shift = 2;
+  for (int i = 0; i < 4; ++i) {
+    if (i == largest)
+      continue;
+    const float v = Mn::Math::clamp(sign * q[i] / smallestMax, -1.0f, 1.0f);
+    bits |= uint64_t(std::lround((v * 0.5f + 0.5f) * smallestScale)) << shift;
+    shift += smallestBits;
+  }
+  return bits;
+}
+
+Mn::Quaternion unpackRotation(uint64_t bits) {
+  const int largest = bits & 3;
+  bits >>= 2;
+  Mn::Vector4 q;
+  float sum = 0.0f;
+  for (int i = 0; i < 4; ++i) {
+    if (i == largest)
+      continue;
+    const float v = (bits & ((1 << smallestBits) - 1)) / smallestScale;
+    q[i] = (v * 2.0f - 1.0f) * smallestMax;
+    sum += q[i] * q[i];
+    bits >>= smallestBits;
+  }
+  q[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+  return Mn::Quaternion{q.xyz(), q.w()}.normalized();
+}
+
+// Appends little-endian values to a buffer
+struct Writer {
+  std::string& out;
+
+  void byte(const uint8_t value) { out.push_back(static_cast<char>(value)); }
+
+  void u32(const uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+      byte((value >> (8 * i)) & 0xff);
+  }
+
+  // The low bytes of value
+  void bytes(const uint64_t value, const int count) {
+    for (int i = 0; i < count; ++i)
+      byte((value >> (8 * i)) & 0xff);
+  }
+
+  void f32(const float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u32(bits);
+  }
+
+  void varint(uint64_t value) {
+    while (value >= 0x80) {
+      byte(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    byte(static_cast<uint8_t>(value));
+  }
+
+  // zigzag, so that small negative values are short too
+  void svarint(const int64_t value) {
+    varint((static_cast<uint64_t>(value) << 1) ^
+           static_cast<uint64_t>(value >> 63));
+  }
+
+  void str(const std::string& value) {
+    varint(value.size());
+    out.append(value);
+  }
+
+  template <typename T>
+  void vec3(const T& value) {
+    for (int i = 0; i < 3; ++i)
+      f32(value[i]);
+  }
+
+  void quaternion(const Mn::Quaternion& value) {
+    vec3(value.vector());
+    f32(value.scalar());
+  }
+};
+
+// Reads the values of Writer, ok turns false past the end
+struct Reader {
+  const char* data;
+  const char* end;
+  bool ok = true;
+
+  uint8_t byte() {
+    if (data == end) {
+      ok = false;
+      return 0;
+    }
+    return static_cast<uint8_t>(*data++);
+  }
+
+  uint32_t u32() {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+      value |= static_cast<uint32_t>(byte()) << (8 * i);
+    return value;
+  }
+
+  uint64_t bytes(const int count) {
+    uint64_t value = 0;
+    for (int i = 0; i < count; ++i)
+      value |= static_cast<uint64_t>(byte()) << (8 * i);
+    return value;
+  }
+
+  float f32() {
+    const uint32_t bits = u32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      const uint8_t b = byte();
+      value |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return value;
+    }
+    ok = false;
+    return 0;
+  }
+
+  int64_t svarint() {
+    const uint64_t value = varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  // A count of elements of at least one byte each, 0 if there aren't as many
+  // bytes left
+  std::size_t count() {
+    const uint64_t value = varint();
+    if (value > static_cast<uint64_t>(end - data)) {
+      ok = false;
+      return 0;
+    }
+    return value;
+  }
+
+  std::string str() {
+    const std::size_t size = count();
+    std::string value{data, size};
+    data += size;
+    return value;
+  }
+
+  Mn::Vector3 vec3() {
+    Mn::Vector3 value;
+    for (int i = 0; i < 3; ++i)
+      value[i] = f32();
+    return value;
+  }
+
+  Mn::Quaternion quaternion() {
+    const Mn::Vector3 vector = vec3();
+    return Mn::Quaternion{vector, f32()};
+  }
+};
+
+// Rotations take 6 bytes, translations the varints of the differences to
+// the previous ones of the instance in translations, which is updated
+void writeKeyframe(Writer& w,
+                   const Keyframe& keyframe,
+                   const float translationQuantum,
+                   Translations& translations) {
+  w.varint(keyframe.loads.size());
+  for (const esp::assets::AssetInfo& info : keyframe.loads) {
+    w.varint(static_cast<uint32_t>(info.type));
+    w.str(info.filepath);
+    w.vec3(info.frame.up());
+    w.vec3(info.frame.front());
+    w.vec3(info.frame.origin());
+    w.f32(info.virtualUnitToMeters);
+    w.byte(info.requiresLighting | info.splitInstanceMesh << 1);
+  }
+
+  w.varint(keyframe.creations.size());
+  for (const auto& pair : keyframe.creations) {
+    const esp::assets::RenderAssetInstanceCreationInfo& creation = pair.second;
+    w.svarint(pair.first);
+    w.str(creation.filepath);
+    w.byte(bool(creation.scale));
+    if (creation.scale)
+      w.vec3(*creation.scale);
+    w.varint(static_cast<unsigned int>(creation.flags));
+    w.str(creation.lightSetupKey);
+  }
+
+  w.varint(keyframe.deletions.size());
+  for (const RenderAssetInstanceKey key : keyframe.deletions) {
+    w.svarint(key);
+    translations.erase(key);
+  }
+
+  w.varint(keyframe.stateUpdates.size());
+  for (const auto& pair : keyframe.stateUpdates) {
+    const Transform& transform = pair.second.absTransform;
+    w.svarint(pair.first);
+    Vector3l& previous = translations[pair.first];
+    for (int i = 0; i < 3; ++i) {
+      const int64_t translation =
+          std::llround(transform.translation[i] / translationQuantum);
+      w.svarint(translation - previous[i]);
+      previous[i] = translation;
+    }
+    w.bytes(packRotation(transform.rotation.normalized()), 6);
+    w.svarint(pair.second.semanticId);
+  }
+
+  w.varint(keyframe.userTransforms.size());
+  for (const auto& pair : keyframe.userTransforms) {
+    w.str(pair.first);
+    w.vec3(pair.second.translation);
+    w.quaternion(pair.second.rotation);
+  }
+}
+
+// Reads the keyframes of writeKeyframe(), or of version 1 files
+void readKeyframe(Reader& r,
+                  Keyframe& keyframe,
+                  const uint32_t version,
+                  const float translationQuantum,
+                  Translations& translations) {
+  keyframe.loads.resize(r.count());
+  for (esp::assets::AssetInfo& info : keyframe.loads) {
+    info.type = static_cast<esp::assets::AssetType>(r.varint());
+    info.filepath = r.str();
+    const Mn::Vector3 up = r.vec3();
+    const Mn::Vector3 front = r.vec3();
+    const Mn::Vector3 origin = r.vec3();
+    info.frame = esp::geo::CoordinateFrame{
+        vec3f{up.x(), up.y(), up.z()}, vec3f{front.x(), front.y(), front.z()},
+        vec3f{origin.x(), origin.y(), origin.z()}};
+    info.virtualUnitToMeters = r.f32();
+    const uint8_t flags = r.byte();
+    info.requiresLighting = flags & 1;
+    info.splitInstanceMesh = flags & 2;
+  }
+
+  keyframe.creations.resize(r.count());
+  for (auto& pair : keyframe.creations) {
+    esp::assets::RenderAssetInstanceCreationInfo& creation = pair.second;
+    pair.first = r.svarint();
+    creation.filepath = r.str();
+    if (r.byte())
+      creation.scale = r.vec3();
+    creation.flags =
+        esp::assets::RenderAssetInstanceCreationInfo::Flags{static_cast<
+            esp::assets::RenderAssetInstanceCreationInfo::Flag>(r.varint())};
+    creation.lightSetupKey = r.str();
+  }
+
+  keyframe.deletions.resize(r.count());
+  for (RenderAssetInstanceKey& key : keyframe.deletions) {
+    key = r.svarint();
+    translations.erase(key);
+  }
+
+  keyframe.stateUpdates.resize(r.count());
+  for (auto& pair : keyframe.stateUpdates) {
+    Transform& transform = pair.second.absTransform;
+    pair.first = r.svarint();
+    if (version == 1) {
+      for (int i = 0; i < 3; ++i)
+        transform.translation[i] = r.svarint() * version1TranslationQuantum;
+      Mn::Vector3 vector;
+      for (int i = 0; i < 3; ++i)
+        vector[i] = r.svarint() / version1RotationScale;
+      const float scalar = r.svarint() / version1RotationScale;
+      transform.rotation = Mn::Quaternion{vector, scalar}.normalized();
+    } else {
+      Vector3l& previous = translations[pair.first];
+      for (int i = 0; i < 3; ++i) {
+        previous[i] += r.svarint();
+        transform.translation[i] = previous[i] * translationQuantum;
+      }
+      transform.rotation = unpackRotation(r.bytes(6));
+    }
+    pair.second.semanticId = r.svarint();
+  }
+
+  const std::size_t numUserTransforms = r.count();
+  for (std::size_t i = 0; i < numUserTransforms && r.ok; ++i) {
+    const std::string name = r.str();
+    Transform& transform = keyframe.userTransforms[name];
+    transform.translation = r.vec3();
+    transform.rotation = r.quaternion();
+  }
+}
+}  // namespace
+
+KeyframeEncoder::KeyframeEncoder(const float translationQuantum)
+    : translationQuantum_{translationQuantum} {
+  CORRADE_ASSERT(translationQuantum > 0,
+                 "KeyframeEncoder: expected a positive translation quantum, got"
+                     << translationQuantum, );
+}
+
+void KeyframeEncoder::encode(const Keyframe& keyframe, std::string& out) {
+  Writer w{out};
+  writeKeyframe(w, keyframe, translationQuantum_, translations_);
+}
+
+KeyframeDecoder::KeyframeDecoder(const float translationQuantum)
+    : translationQuantum_{translationQuantum} {
+  CORRADE_ASSERT(translationQuantum > 0,
+                 "KeyframeDecoder: expected a positive translation quantum, got"
+                     << translationQuantum, );
+}
+
+std::size_t KeyframeDecoder::decode(const char* data,
+                                    const std::size_t size,
+                                    Keyframe& keyframe) {
+  Reader r{data, data + size};
+  keyframe = Keyframe{};
+  readKeyframe(r, keyframe, fileVersion, translationQuantum_, translations_);
+  return r.ok ? r.data - data : 0;
+}
+
+KeyframeStreamWriter::KeyframeStreamWriter(const std::string& filepath,
+                                           const int keyframesPerChunk,
+                                           const float translationQuantum)
+    : file_{filepath, std::ios::binary | std::ios::trunc},
+      keyframesPerChunk_{std::max(1, keyframesPerChunk)},
+      encoder_{translationQuantum} {
+  if (!file_) {
+    LOG(ERROR) << "KeyframeStreamWriter: cannot open " << filepath;
+    return;
+  }
+  const std::string header =
+      keyframeStreamHeader(encoder_.translationQuantum());
+  file_.write(header.data(), header.size());
+}
+
+KeyframeStreamWriter::~KeyframeStreamWriter() {
+  close();
+}
+
+void KeyframeStreamWriter::write(const Keyframe& keyframe) {
+  if (!isOpen())
+    return;
+  encoder_.encode(keyframe, chunk_);
+  ++chunkKeyframes_;
+  ++numKeyframes_;
+  if (chunkKeyframes_ >= keyframesPerChunk_)
+    writeChunk();
+}
+
+bool KeyframeStreamWriter::close() {
+  if (!isOpen())
+    return !failed_;
+  writeChunk();
+  file_.close();
+  return !failed_;
+}
+
+void KeyframeStreamWriter::writeChunk() {
+  if (!chunkKeyframes_)
+    return;
+  std::string header;
+  Writer w{header};
+  w.u32(chunkKeyframes_);
+  w.byte(chunkUncompressed);
+  w.u32(chunk_.size());
+  file_.write(header.data(), header.size());
+  file_.write(chunk_.data(), chunk_.size());
+  // so that the chunk is on disk if the recording is interrupted
+  file_.flush();
+  if (!file_) {
+    LOG(ERROR) << "KeyframeStreamWriter: failed writing a chunk of "
+               << chunkKeyframes_ << " keyframes";
+    failed_ = true;
+  }
+  chunk_.clear();
+  chunkKeyframes_ = 0;
+}
+
+std::string keyframeStreamHeader(const float translationQuantum) {
+  std::string header{fileMagic, sizeof(fileMagic)};
+  Writer w{header};
+  w.u32(fileVersion);
+  w.f32(translationQuantum);
+  return header;
+}
+
+std::size_t readKeyframeStreamHeader(const char* data,
+                                     const std::size_t size,
+                                     float& translationQuantum) {
+  Reader r{data, data + size};
+  char magic[sizeof(fileMagic)];
+  for (char& c : magic)
+    c = r.byte();
+  const uint32_t version = r.u32();
+  const float quantum = r.f32();
+  if (!r.ok || std::memcmp(magic, fileMagic, sizeof(magic)) != 0 ||
+      version != fileVersion || !(quantum > 0))
+    return 0;
+  translationQuantum = quantum;
+  return r.data - data;
+}
+
+bool isKeyframeStreamFile(const std::string& filepath) {
+  std::ifstream file{filepath, std::ios::binary};
+  char magic[sizeof(fileMagic)];
+  return file.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, fileMagic, sizeof(magic)) == 0;
+}
+
+bool readKeyframeStream(const std::string& filepath,
+                        std::vector<Keyframe>& keyframes) {
+  const Cr::Containers::Array<char> file = core::mapFile(filepath);
+  Reader r{file.data(), file.data() + file.size()};
+  char magic[sizeof(fileMagic)];
+  for (char& c : magic)
+    c = r.byte();
+  const uint32_t version = r.u32();
+  if (!r.ok || std::memcmp(magic, fileMagic, sizeof(magic)) != 0) {
+    LOG(ERROR) << "readKeyframeStream: " << filepath
+               << " is not a keyframe stream";
+    return false;
+  }
+  if (version < 1 || version > fileVersion) {
+    LOG(ERROR) << "readKeyframeStream: " << filepath << " has version "
+               << version << ", expected at most " << fileVersion;
+    return false;
+  }
+  const float translationQuantum =
+      version == 1 ? version1TranslationQuantum : r.f32();
+  if (!r.ok || !(translationQuantum > 0)) {
+    LOG(ERROR) << "readKeyframeStream: " << filepath
+               << " has an invalid header";
+    return false;
+  }
+  Translations translations;
+
+  while (r.data != r.end) {
+    if (static_cast<std::size_t>(r.end - r.data) < chunkHeaderSize) {
+      LOG(WARNING) << "readKeyframeStream: dropped the truncated last chunk "
+                      "of "
+                   << filepath;
+      return true;
+    }
+    const uint32_t numKeyframes = r.u32();
+    const uint8_t compression = r.byte();
+    const uint32_t size = r.u32();
+    if (compression != chunkUncompressed) {
+      LOG(ERROR) << "readKeyframeStream: unknown compression "
+                 << int(compression) << " in " << filepath;
+      return false;
+    }
+    if (size > static_cast<std::size_t>(r.end - r.data)) {
+      LOG(WARNING) << "readKeyframeStream: dropped the truncated last chunk "
+                      "of "
+                   << filepath;
+      return true;
+    }
+
+    Reader chunk{r.data, r.data + size};
+    r.data += size;
+    const std::size_t first = keyframes.size();
+    keyframes.resize(first + numKeyframes);
+    for (std::size_t i = first; i < keyframes.size() && chunk.ok; ++i)
+      readKeyframe(chunk, keyframes[i], version, translationQuantum,
+                   translations);
+    if (!chunk.ok || chunk.data != chunk.end) {
+      LOG(ERROR) << "readKeyframeStream: corrupted chunk in " << filepath;
+      keyframes.resize(first);
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
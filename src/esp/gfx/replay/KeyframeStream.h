@@ -0,0 +1,180 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_REPLAY_KEYFRAMESTREAM_H_
+#define ESP_GFX_REPLAY_KEYFRAMESTREAM_H_
+
+/** @file
+ * @brief Class @ref esp::gfx::replay::KeyframeEncoder, @ref
+ * esp::gfx::replay::KeyframeDecoder, @ref
+ * esp::gfx::replay::KeyframeStreamWriter, functions @ref
+ * esp::gfx::replay::isKeyframeStreamFile(), @ref
+ * esp::gfx::replay::readKeyframeStream()
+ */
+
+#include "Keyframe.h"
+
+#include <Magnum/Math/Vector3.h>
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace esp {
+namespace gfx {
+namespace replay {
+
+/**
+ * @brief Encodes render keyframes one at a time in the format of @ref
+ * KeyframeStreamWriter, e.g. to send them over a network
+ *
+ * The translations are encoded relative to the previous states of the
+ * instances, so the keyframes have to be decoded in order, from the first
+ * one, by a @ref KeyframeDecoder of the same translation quantum.
+ */
+class KeyframeEncoder {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] translationQuantum The precision of the translations of the
+   *                               instances, in meters
+   */
+  explicit KeyframeEncoder(float translationQuantum = 1e-4f);
+
+  /** @brief The precision of the translations, in meters */
+  float translationQuantum() const { return translationQuantum_; }
+
+  /** @brief Append the encoding of the next keyframe to @p out */
+  void encode(const Keyframe& keyframe, std::string& out);
+
+ private:
+  float translationQuantum_;
+  // The last quantized translation of each instance
+  std::unordered_map<RenderAssetInstanceKey, Magnum::Math::Vector3<int64_t>>
+      translations_;
+};
+
+/**
+ * @brief Decodes the keyframes of a @ref KeyframeEncoder, in order
+ */
+class KeyframeDecoder {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] translationQuantum The translation quantum of the encoder
+   */
+  explicit KeyframeDecoder(float translationQuantum = 1e-4f);
+
+  /**
+   * @brief Decode the next keyframe
+   *
+   * @return The number of bytes of the keyframe, 0 if @p data is truncated or
+   * corrupted
+   */
+  std::size_t decode(const char* data, std::size_t size, Keyframe& keyframe);
+
+ private:
+  float translationQuantum_;
+  std::unordered_map<RenderAssetInstanceKey, Magnum::Math::Vector3<int64_t>>
+      translations_;
+};
+
+/**
+ * @brief Writes render keyframes to a compact binary file as they are saved
+ *
+ * The file is a header and a sequence of chunks of keyframes, each written
+ * once it's full, so that memory stays bounded however long the recording
+ * and a recording that was interrupted is readable up to its last chunk.
+ * Instance keys, counts and the other integers are varints. The translations
+ * of the instances are quantized, by default to 0.1 mm, and stored as
+ * differences to the previous state of the instance, so that small moves take
+ * a byte or two per component. Their rotations are stored as the three
+ * smallest components of the quaternion in 15 bits each, about 1e-4 radians.
+ * User transforms, typically cameras, are kept exact. See
+ * @ref readKeyframeStream() for the reading side.
+ */
+class KeyframeStreamWriter {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] filepath The file to write, replaced if it exists
+   * @param[in] keyframesPerChunk The number of keyframes buffered before they
+   *                              are written
+   * @param[in] translationQuantum The precision of the translations of the
+   *                               instances, in meters
+   */
+  explicit KeyframeStreamWriter(const std::string& filepath,
+                                int keyframesPerChunk = 64,
+                                float translationQuantum = 1e-4f);
+
+  /** @brief Writes the last chunk */
+  ~KeyframeStreamWriter();
+
+  /** @brief Whether the file could be opened */
+  bool isOpen() const { return file_.is_open(); }
+
+  /** @brief Add a keyframe, writing the chunk if it is full */
+  void write(const Keyframe& keyframe);
+
+  /**
+   * @brief Write the last chunk and close the file
+   *
+   * @return Whether every chunk was written
+   */
+  bool close();
+
+  /** @brief The number of keyframes added */
+  int numKeyframes() const { return numKeyframes_; }
+
+ private:
+  void writeChunk();
+
+  std::ofstream file_;
+  int keyframesPerChunk_;
+  KeyframeEncoder encoder_;
+  std::string chunk_;
+  int chunkKeyframes_ = 0;
+  int numKeyframes_ = 0;
+  bool failed_ = false;
+};
+
+/**
+ * @brief The header of the files of @ref KeyframeStreamWriter, which is also
+ * the first message of @ref KeyframeServer
+ */
+std::string keyframeStreamHeader(float translationQuantum);
+
+/**
+ * @brief Parse the header of @ref keyframeStreamHeader() of the current version
+ *
+ * @return The size of the header, 0 if @p data doesn't start with one
+ */
+std::size_t readKeyframeStreamHeader(const char* data,
+                                     std::size_t size,
+                                     float& translationQuantum);
+
+/** @brief Whether a file was written by @ref KeyframeStreamWriter */
+bool isKeyframeStreamFile(const std::string& filepath);
+
+/**
+ * @brief Read the keyframes written by @ref KeyframeStreamWriter
+ *
+ * A truncated last chunk, e.g. of a recording that was interrupted, is
+ * dropped with a warning.
+ *
+ * @return Whether the file is a keyframe stream of a known version, without
+ * errors before its end
+ */
+bool readKeyframeStream(const std::string& filepath,
+                        std::vector<Keyframe>& keyframes);
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
+
+#endif
@@ -3,22 +3,22 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "Player.h"
+#include "KeyframeStream.h"
 
 #include "esp/assets/ResourceManager.h"
 #include "esp/core/esp.h"
 #include "esp/io/JsonAllTypes.h"
+#include "esp/io/json.h"
 
+#include <Magnum/Math/Functions.h>
 #include <rapidjson/document.h>
 
+#include <algorithm>
+
 namespace esp {
 namespace gfx {
 namespace replay {
 
-void Player::readKeyframesFromJsonDocument(const rapidjson::Document& d) {
-  ASSERT(keyframes_.empty());
-  esp::io::readMember(d, "keyframes", keyframes_);
-}
-
 Player::Player(const LoadAndCreateRenderAssetInstanceCallback& callback)
     : loadAndCreateRenderAssetInstanceCallback(callback) {}
 
@@ -31,14 +31,32 @@ void Player::readKeyframesFromFile(const std::string& filepath) {
                << " not found.";
     return;
   }
-  try {
-    auto newDoc = esp::io::parseJsonFile(filepath);
-    readKeyframesFromJsonDocument(newDoc);
-  } catch (...) {
-    LOG(ERROR)
-        << "Player::readKeyframesFromFile: failed to parse keyframes from "
-        << filepath << ".";
+  if (isKeyframeStreamFile(filepath)) {
+    if (!readKeyframeStream(filepath, keyframes_)) {
+      LOG(ERROR)
+          << "Player::readKeyframesFromFile: failed to read keyframes from "
+          << filepath << ".";
+      keyframes_.clear();
+    }
+  } else {
+    // one keyframe at a time, without a document of the whole file
+    const bool read = esp::io::forEachJsonArrayElement(
+        filepath, "keyframes", [&](const esp::io::JsonGenericValue& value) {
+          Keyframe keyframe;
+          if (!esp::io::fromJsonValue(value, keyframe)) {
+            return false;
+          }
+          keyframes_.emplace_back(std::move(keyframe));
+          return true;
+        });
+    if (!read) {
+      LOG(ERROR)
+          << "Player::readKeyframesFromFile: failed to parse keyframes from "
+          << filepath << ".";
+      keyframes_.clear();
+    }
   }
+  buildSnapshots();
 }
 
 int Player::getKeyframeIndex() const {
@@ -53,7 +71,20 @@ void Player::setKeyframeIndex(int frameIndex) {
   ASSERT(frameIndex == -1 ||
          (frameIndex >= 0 && frameIndex < getNumKeyframes()));
 
-  if (frameIndex < frameIndex_) {
+  restoreInterpolatedInstances();
+  if (frameIndex == -1) {
+    clearFrame();
+    return;
+  }
+
+  if (!snapshots_.empty()) {
+    const int snapshot = std::min<int>(frameIndex / snapshotInterval_,
+                                       snapshots_.size() - 1);
+    const int snapshotFrameIndex = snapshot * snapshotInterval_;
+    if (frameIndex < frameIndex_ || frameIndex_ < snapshotFrameIndex) {
+      applySnapshot(snapshots_[snapshot], snapshotFrameIndex);
+    }
+  } else if (frameIndex < frameIndex_) {
     clearFrame();
   }
 
@@ -62,6 +93,133 @@ void Player::setKeyframeIndex(int frameIndex) {
   }
 }
 
+void Player::setInterpolatedKeyframeIndex(float frameIndex) {
+  ASSERT(frameIndex >= 0.f && frameIndex <= getNumKeyframes() - 1);
+
+  const int index = int(frameIndex);
+  setKeyframeIndex(index);
+  const float t = frameIndex - index;
+  if (t == 0.f || index + 1 >= getNumKeyframes()) {
+    return;
+  }
+
+  // an instance without a state update in the next keyframe doesn't move
+  // until then, and one created by it doesn't exist yet
+  for (const auto& pair : keyframes_[index + 1].stateUpdates) {
+    const auto& it = createdInstances_.find(pair.first);
+    if (it == createdInstances_.end()) {
+      continue;
+    }
+    auto node = it->second;
+    const Transform from{node->translation(), node->rotation()};
+    interpolatedInstances_.emplace(pair.first, from);
+    const auto& to = pair.second.absTransform;
+    node->setTranslation(
+        Magnum::Math::lerp(from.translation, to.translation, t));
+    node->setRotation(Magnum::Math::slerpShortestPath(
+        from.rotation.normalized(), to.rotation.normalized(), t));
+  }
+  interpolation_ = t;
+}
+
+void Player::restoreInterpolatedInstances() {
+  for (const auto& pair : interpolatedInstances_) {
+    const auto& it = createdInstances_.find(pair.first);
+    if (it != createdInstances_.end()) {
+      it->second->setTranslation(pair.second.translation);
+      it->second->setRotation(pair.second.rotation);
+    }
+  }
+  interpolatedInstances_.clear();
+  interpolation_ = 0.f;
+}
+
+void Player::applyStreamedKeyframe(Keyframe&& keyframe) {
+  if (getNumKeyframes()) {
+    setKeyframeIndex(getNumKeyframes() - 1);
+  }
+  applyKeyframe(keyframe);
+  keyframes_.clear();
+  keyframes_.emplace_back(std::move(keyframe));
+  snapshots_.clear();
+  frameIndex_ = 0;
+}
+
+void Player::setSnapshotInterval(int interval) {
+  ASSERT(interval >= 0);
+  snapshotInterval_ = interval;
+  buildSnapshots();
+}
+
+void Player::buildSnapshots() {
+  snapshots_.clear();
+  if (snapshotInterval_ == 0) {
+    return;
+  }
+
+  // instance keys increase with time, so the maps keep the creation order
+  std::vector<esp::assets::AssetInfo> loads;
+  std::map<RenderAssetInstanceKey, esp::assets::RenderAssetInstanceCreationInfo>
+      creations;
+  std::map<RenderAssetInstanceKey, RenderAssetInstanceState> states;
+  for (int i = 0; i < getNumKeyframes(); ++i) {
+    const auto& keyframe = keyframes_[i];
+    loads.insert(loads.end(), keyframe.loads.begin(), keyframe.loads.end());
+    for (const auto& pair : keyframe.creations) {
+      creations[pair.first] = pair.second;
+    }
+    for (const auto& deletionInstanceKey : keyframe.deletions) {
+      creations.erase(deletionInstanceKey);
+      states.erase(deletionInstanceKey);
+    }
+    for (const auto& pair : keyframe.stateUpdates) {
+      states[pair.first] = pair.second;
+    }
+
+    if (i % snapshotInterval_ == 0) {
+      Keyframe snapshot;
+      snapshot.loads = loads;
+      snapshot.creations.assign(creations.begin(), creations.end());
+      snapshot.stateUpdates.assign(states.begin(), states.end());
+      snapshots_.emplace_back(std::move(snapshot));
+    }
+  }
+}
+
+void Player::applySnapshot(const Keyframe& snapshot, int frameIndex) {
+  assetInfos_.clear();
+  for (const auto& assetInfo : snapshot.loads) {
+    if (!failedFilepaths_.count(assetInfo.filepath)) {
+      assetInfos_[assetInfo.filepath] = assetInfo;
+    }
+  }
+
+  // Keep the instances that exist at the snapshot and have a state there,
+  // the others are deleted and the missing ones created
+  std::set<RenderAssetInstanceKey> keep;
+  for (const auto& pair : snapshot.stateUpdates) {
+    keep.insert(pair.first);
+  }
+  for (auto it = createdInstances_.begin(); it != createdInstances_.end();) {
+    if (keep.count(it->first)) {
+      ++it;
+    } else {
+      delete it->second;
+      it = createdInstances_.erase(it);
+    }
+  }
+
+  Keyframe keyframe;
+  for (const auto& pair : snapshot.creations) {
+    if (!createdInstances_.count(pair.first)) {
+      keyframe.creations.push_back(pair);
+    }
+  }
+  keyframe.stateUpdates = snapshot.stateUpdates;
+  applyKeyframe(keyframe);
+  frameIndex_ = frameIndex;
+}
+
 bool Player::getUserTransform(const std::string& name,
                               Magnum::Vector3* translation,
                               Magnum::Quaternion* rotation) const {
@@ -73,6 +231,17 @@ bool Player::getUserTransform(const std::string& name,
   if (it != keyframe.userTransforms.end()) {
     *translation = it->second.translation;
     *rotation = it->second.rotation;
+    if (interpolation_ > 0.f) {
+      const auto& next = keyframes_[frameIndex_ + 1].userTransforms;
+      const auto& nextIt = next.find(name);
+      if (nextIt != next.end()) {
+        *translation = Magnum::Math::lerp(
+            *translation, nextIt->second.translation, interpolation_);
+        *rotation = Magnum::Math::slerpShortestPath(
+            rotation->normalized(), nextIt->second.rotation.normalized(),
+            interpolation_);
+      }
+    }
     return true;
   } else {
     return false;
@@ -84,6 +253,8 @@ void Player::clearFrame() {
     delete pair.second;
   }
   createdInstances_.clear();
+  interpolatedInstances_.clear();
+  interpolation_ = 0.f;
   assetInfos_.clear();
   frameIndex_ = -1;
 }
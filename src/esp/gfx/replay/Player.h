@@ -37,6 +37,16 @@ namespace replay {
  * rendered. Render assets are loaded as needed. See also @ref Recorder. See
  * examples/replay_tutorial.py for usage of this class through bindings (coming
  * soon).
+ *
+ * Seeking doesn't replay the keyframes from the start: the full state of the
+ * scene is snapshotted every @ref getSnapshotInterval() keyframes when the
+ * keyframes are read, and a seek starts from the closest snapshot before the
+ * target unless the current keyframe is closer. The instances that exist at
+ * both are kept rather than re-created.
+ *
+ * Keyframes recorded sparsely, e.g. at 5 Hz, can be played back at a higher
+ * frame rate with @ref setInterpolatedKeyframeIndex, which blends the
+ * transforms of the instances between two consecutive keyframes.
  */
 class Player {
  public:
@@ -54,10 +64,31 @@ class Player {
   /**
    * @brief Read keyframes. See also @ref Recorder::writeSavedKeyframesToFile.
    * After calling this, use @ref setKeyframeIndex to set a keyframe.
+   *
+   * Both the JSON files and the binary ones streamed by @ref
+   * Recorder::startStreamingToFile are read, told apart by their contents.
    * @param filepath
    */
   void readKeyframesFromFile(const std::string& filepath);
 
+  /**
+   * @brief Append a keyframe, e.g. one received from a @ref KeyframeServer.
+   * The snapshots aren't updated, so seeking into appended keyframes replays
+   * them from the last snapshot.
+   */
+  void appendKeyframe(Keyframe&& keyframe) {
+    keyframes_.emplace_back(std::move(keyframe));
+  }
+
+  /**
+   * @brief Apply a keyframe following the current one without keeping the
+   * previous ones, e.g. one streamed live, so that memory stays bounded
+   * however long the stream.
+   *
+   * The player then only holds @p keyframe, at index 0, and can't seek back.
+   */
+  void applyStreamedKeyframe(Keyframe&& keyframe);
+
   /**
    * @brief Get the currently-set keyframe, or -1 if no keyframe is set.
    */
@@ -74,6 +105,33 @@ class Player {
    */
   void setKeyframeIndex(int frameIndex);
 
+  /**
+   * @brief Set a fractional keyframe index, between keyframes
+   * floor(frameIndex) and the next one.
+   *
+   * Keyframe floor(frameIndex) is set and the instances that have a state
+   * update in the next keyframe are moved toward it, with a linear
+   * interpolation of their translation and a spherical one of their
+   * rotation. Creations, deletions and semantic ids are those of keyframe
+   * floor(frameIndex), and @ref getUserTransform interpolates the same way.
+   * To play a recording of @p keyframeRate keyframes per second at
+   * @p frameRate frames per second, set frame f with
+   * f * keyframeRate / frameRate.
+   */
+  void setInterpolatedKeyframeIndex(float frameIndex);
+
+  /**
+   * @brief Get the number of keyframes between snapshots, 0 if disabled.
+   */
+  int getSnapshotInterval() const { return snapshotInterval_; }
+
+  /**
+   * @brief Set the number of keyframes between snapshots, which bounds the
+   * number of keyframes applied by a seek. Pass 0 to disable them, e.g. to
+   * save memory.
+   */
+  void setSnapshotInterval(int interval);
+
   /**
    * @brief Get a user transform. See @ref Recorder::addUserTransformToKeyframe
    * for usage tips.
@@ -87,19 +145,30 @@ class Player {
    */
   void debugSetKeyframes(std::vector<Keyframe>&& keyframes) {
     keyframes_ = std::move(keyframes);
+    buildSnapshots();
   }
 
  private:
-  void readKeyframesFromJsonDocument(const rapidjson::Document& d);
   void clearFrame();
+  void buildSnapshots();
+  void applySnapshot(const Keyframe& snapshot, int frameIndex);
   void applyKeyframe(const Keyframe& keyframe);
+  void restoreInterpolatedInstances();
   static void setSemanticIdForSubtree(esp::scene::SceneNode* rootNode,
                                       int semanticId);
 
   LoadAndCreateRenderAssetInstanceCallback
       loadAndCreateRenderAssetInstanceCallback;
   int frameIndex_ = -1;
+  // the interpolation toward keyframe frameIndex_ + 1, and the transforms of
+  // keyframe frameIndex_ of the instances it moved
+  float interpolation_ = 0.f;
+  std::map<RenderAssetInstanceKey, Transform> interpolatedInstances_;
   std::vector<Keyframe> keyframes_;
+  int snapshotInterval_ = 100;
+  // The loads, creations and latest states of the instances that exist after
+  // each keyframe of index a multiple of snapshotInterval_
+  std::vector<Keyframe> snapshots_;
   std::map<std::string, esp::assets::AssetInfo> assetInfos_;
   std::map<RenderAssetInstanceKey, scene::SceneNode*> createdInstances_;
   std::set<std::string> failedFilepaths_;
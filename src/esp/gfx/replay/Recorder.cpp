@@ -3,19 +3,23 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "Recorder.h"
+#include "KeyframeStream.h"
 
 #include "esp/assets/RenderAssetInstanceCreationInfo.h"
 #include "esp/io/JsonAllTypes.h"
 #include "esp/io/json.h"
 #include "esp/scene/SceneNode.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace esp {
 namespace gfx {
 namespace replay {
 
 /**
  * @brief Helper class to get notified when a SceneNode is about to be
- * destroyed.
+ * destroyed, and when it or one of its parents moves.
  */
 class NodeDeletionHelper : public Magnum::SceneGraph::AbstractFeature3D {
  public:
@@ -25,19 +29,42 @@ class NodeDeletionHelper : public Magnum::SceneGraph::AbstractFeature3D {
         recorder_(writer) {}
 
   ~NodeDeletionHelper() override {
-    recorder_->onDeleteRenderAssetInstance(node);
+    if (recorder_) {
+      recorder_->onDeleteRenderAssetInstance(node);
+    }
+  }
+
+  //! Stop notifying the recorder, e.g. because it is destroyed
+  void detach() { recorder_ = nullptr; }
+
+  /**
+   * @brief Whether the node was marked dirty since the last call
+   *
+   * Magnum only notifies a node that turns dirty, so this misses the moves of
+   * a node that was already dirty; check the node itself too.
+   */
+  bool takeMoved() {
+    const bool moved = moved_;
+    moved_ = false;
+    return moved;
   }
 
  private:
+  void markDirty() override { moved_ = true; }
+
   Recorder* recorder_ = nullptr;
   const scene::SceneNode* node = nullptr;
+  bool moved_ = true;
 };
 
 Recorder::~Recorder() {
+  stopStreaming();
   // Delete NodeDeletionHelpers. This is important because they hold raw
   // pointers to this Recorder and these pointers would become dangling
-  // (invalid) after this Recorder is destroyed.
+  // (invalid) after this Recorder is destroyed. They are detached first so
+  // that they don't remove their records while these are iterated.
   for (auto& instanceRecord : instanceRecords_) {
+    instanceRecord.deletionHelper->detach();
     delete instanceRecord.deletionHelper;
   }
 }
@@ -61,6 +88,7 @@ void Recorder::onCreateRenderAssetInstance(
   // manually later if necessary.
   NodeDeletionHelper* deletionHelper = new NodeDeletionHelper{*node, this};
 
+  instanceIndices_[node] = instanceRecords_.size();
   instanceRecords_.emplace_back(InstanceRecord{
       node, instanceKey, Corrade::Containers::NullOpt, deletionHelper});
 }
@@ -76,19 +104,23 @@ void Recorder::addUserTransformToKeyframe(const std::string& name,
   getKeyframe().userTransforms[name] = Transform{translation, rotation};
 }
 
+void Recorder::addLoadsCreationsDeletions(const Keyframe& keyframe,
+                                          Keyframe* dest) {
+  ASSERT(dest);
+  dest->loads.insert(dest->loads.end(), keyframe.loads.begin(),
+                     keyframe.loads.end());
+  dest->creations.insert(dest->creations.end(), keyframe.creations.begin(),
+                         keyframe.creations.end());
+  for (const auto& deletionInstanceKey : keyframe.deletions) {
+    checkAndAddDeletion(dest, deletionInstanceKey);
+  }
+}
+
 void Recorder::addLoadsCreationsDeletions(KeyframeIterator begin,
                                           KeyframeIterator end,
                                           Keyframe* dest) {
-  ASSERT(dest);
   for (KeyframeIterator curr = begin; curr != end; curr++) {
-    const auto& keyframe = *curr;
-    dest->loads.insert(dest->loads.end(), keyframe.loads.begin(),
-                       keyframe.loads.end());
-    dest->creations.insert(dest->creations.end(), keyframe.creations.begin(),
-                           keyframe.creations.end());
-    for (const auto& deletionInstanceKey : keyframe.deletions) {
-      checkAndAddDeletion(dest, deletionInstanceKey);
-    }
+    addLoadsCreationsDeletions(*curr, dest);
   }
 }
 
@@ -115,7 +147,14 @@ void Recorder::onDeleteRenderAssetInstance(const scene::SceneNode* node) {
 
   checkAndAddDeletion(&getKeyframe(), instanceKey);
 
-  instanceRecords_.erase(instanceRecords_.begin() + index);
+  // move the last record into the hole, so that the indices of the others
+  // stay valid
+  instanceIndices_.erase(node);
+  if (index + 1 != int(instanceRecords_.size())) {
+    instanceRecords_[index] = std::move(instanceRecords_.back());
+    instanceIndices_[instanceRecords_[index].node] = index;
+  }
+  instanceRecords_.pop_back();
 }
 
 Keyframe& Recorder::getKeyframe() {
@@ -127,18 +166,13 @@ RenderAssetInstanceKey Recorder::getNewInstanceKey() {
 }
 
 int Recorder::findInstance(const scene::SceneNode* queryNode) {
-  auto it = std::find_if(instanceRecords_.begin(), instanceRecords_.end(),
-                         [&queryNode](const InstanceRecord& record) {
-                           return record.node == queryNode;
-                         });
-
-  return it == instanceRecords_.end() ? ID_UNDEFINED
-                                      : int(it - instanceRecords_.begin());
+  auto it = instanceIndices_.find(queryNode);
+  return it == instanceIndices_.end() ? ID_UNDEFINED : int(it->second);
 }
 
-RenderAssetInstanceState Recorder::getInstanceState(
-    const scene::SceneNode* node) {
-  const auto absTransformMat = node->absoluteTransformation();
+RenderAssetInstanceState Recorder::getInstanceState(scene::SceneNode* node) {
+  // also cleans the node, so that its next move notifies the deletion helper
+  const auto& absTransformMat = node->cachedAbsoluteTransformationMatrix();
   Transform absTransform{
       absTransformMat.translation(),
       Magnum::Quaternion::fromMatrix(absTransformMat.rotationShear())};
@@ -148,8 +182,19 @@ RenderAssetInstanceState Recorder::getInstanceState(
 
 void Recorder::updateInstanceStates() {
   for (auto& instanceRecord : instanceRecords_) {
-    auto state = getInstanceState(instanceRecord.node);
-    if (!instanceRecord.recentState || state != instanceRecord.recentState) {
+    // A node that stayed clean since its state was taken didn't move, only
+    // its semantic id may have changed
+    const bool moved = instanceRecord.deletionHelper->takeMoved() ||
+                       instanceRecord.node->isDirty();
+    RenderAssetInstanceState state;
+    if (!moved && instanceRecord.recentState) {
+      state = *instanceRecord.recentState;
+      state.semanticId = instanceRecord.node->getSemanticId();
+    } else {
+      state = getInstanceState(instanceRecord.node);
+    }
+    if (!instanceRecord.recentState ||
+        hasChanged(state, *instanceRecord.recentState)) {
       getKeyframe().stateUpdates.push_back(
           std::make_pair(instanceRecord.instanceKey, state));
       instanceRecord.recentState = state;
@@ -157,11 +202,103 @@ void Recorder::updateInstanceStates() {
   }
 }
 
+void Recorder::setStateUpdateThresholds(float translationThreshold,
+                                        float rotationThreshold) {
+  ASSERT(translationThreshold >= 0 && rotationThreshold >= 0);
+  translationThreshold_ = translationThreshold;
+  rotationThreshold_ = rotationThreshold;
+}
+
+bool Recorder::hasChanged(const RenderAssetInstanceState& state,
+                          const RenderAssetInstanceState& recentState) const {
+  if (translationThreshold_ == 0 && rotationThreshold_ == 0) {
+    return state != recentState;
+  }
+  if (state.semanticId != recentState.semanticId) {
+    return true;
+  }
+  const Transform& a = state.absTransform;
+  const Transform& b = recentState.absTransform;
+  if ((a.translation - b.translation).dot() >
+      translationThreshold_ * translationThreshold_) {
+    return true;
+  }
+  // the angle between the rotations, q and -q being the same rotation
+  const float cosHalfAngle = std::min(
+      1.0f, std::abs(Magnum::Math::dot(a.rotation.normalized(),
+                                       b.rotation.normalized())));
+  return 2.0f * std::acos(cosHalfAngle) > rotationThreshold_;
+}
+
+Keyframe Recorder::getSavedScene() {
+  Keyframe keyframe;
+  addLoadsCreationsDeletions(streamedAssets_, &keyframe);
+  addLoadsCreationsDeletions(savedKeyframes_.begin(), savedKeyframes_.end(),
+                             &keyframe);
+  for (const auto& instanceRecord : instanceRecords_) {
+    if (instanceRecord.recentState) {
+      keyframe.stateUpdates.emplace_back(instanceRecord.instanceKey,
+                                         *instanceRecord.recentState);
+    }
+  }
+  return keyframe;
+}
+
 void Recorder::advanceKeyframe() {
-  savedKeyframes_.emplace_back(std::move(currKeyframe_));
+  if (keyframeListener_) {
+    keyframeListener_(currKeyframe_);
+  }
+  if (stream_) {
+    stream_->write(currKeyframe_);
+    addLoadsCreationsDeletions(currKeyframe_, &streamedAssets_);
+  } else {
+    savedKeyframes_.emplace_back(std::move(currKeyframe_));
+  }
   currKeyframe_ = Keyframe{};
 }
 
+bool Recorder::startStreamingToFile(const std::string& filepath,
+                                    const int keyframesPerChunk,
+                                    const float translationQuantum) {
+  stopStreaming();
+  auto stream = std::make_unique<KeyframeStreamWriter>(
+      filepath, keyframesPerChunk, translationQuantum);
+  if (!stream->isOpen()) {
+    return false;
+  }
+  for (const auto& keyframe : savedKeyframes_) {
+    stream->write(keyframe);
+  }
+  addLoadsCreationsDeletions(savedKeyframes_.begin(), savedKeyframes_.end(),
+                             &streamedAssets_);
+  savedKeyframes_.clear();
+  stream_ = std::move(stream);
+  return true;
+}
+
+void Recorder::stopStreaming() {
+  if (!stream_) {
+    return;
+  }
+  if (!stream_->close()) {
+    LOG(ERROR) << "Recorder::stopStreaming: failed writing some keyframes";
+  }
+  stream_ = nullptr;
+
+  // the streamed assets come before the ones of the current keyframe
+  Keyframe keyframe = std::move(streamedAssets_);
+  addLoadsCreationsDeletions(currKeyframe_, &keyframe);
+  keyframe.stateUpdates = std::move(currKeyframe_.stateUpdates);
+  keyframe.userTransforms = std::move(currKeyframe_.userTransforms);
+  currKeyframe_ = std::move(keyframe);
+  streamedAssets_ = Keyframe{};
+  // clear instanceRecord.recentState to ensure updates get included in the next
+  // saved keyframe.
+  for (auto& instanceRecord : instanceRecords_) {
+    instanceRecord.recentState = Corrade::Containers::NullOpt;
+  }
+}
+
 void Recorder::writeSavedKeyframesToFile(const std::string& filepath) {
   auto document = writeKeyframesToJsonDocument();
   esp::io::writeJsonToFile(document, filepath);
@@ -177,6 +314,32 @@ std::string Recorder::writeSavedKeyframesToString() {
   return esp::io::jsonToString(document);
 }
 
+namespace {
+
+// the elements of the containers of a keyframe, not the strings they hold
+std::size_t keyframeBytes(const Keyframe& keyframe) {
+  return keyframe.loads.size() * sizeof(esp::assets::AssetInfo) +
+         keyframe.creations.size() * sizeof(keyframe.creations[0]) +
+         keyframe.deletions.size() * sizeof(RenderAssetInstanceKey) +
+         keyframe.stateUpdates.size() * sizeof(keyframe.stateUpdates[0]) +
+         keyframe.userTransforms.size() *
+             sizeof(std::pair<const std::string, Transform>);
+}
+
+}  // namespace
+
+std::size_t Recorder::getHostBytes() const {
+  using InstanceIndex = std::pair<const scene::SceneNode*, std::size_t>;
+  std::size_t bytes = keyframeBytes(currKeyframe_) +
+                      keyframeBytes(streamedAssets_) +
+                      instanceRecords_.size() * sizeof(InstanceRecord) +
+                      instanceIndices_.size() * sizeof(InstanceIndex);
+  for (const Keyframe& keyframe : savedKeyframes_) {
+    bytes += keyframeBytes(keyframe);
+  }
+  return bytes;
+}
+
 void Recorder::consolidateSavedKeyframes() {
   // consolidate saved keyframes into current keyframe
   addLoadsCreationsDeletions(savedKeyframes_.begin(), savedKeyframes_.end(),
@@ -9,7 +9,10 @@
 
 #include <rapidjson/document.h>
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 namespace esp {
 namespace assets {
@@ -22,6 +25,7 @@ class SceneNode;
 namespace gfx {
 namespace replay {
 
+class KeyframeStreamWriter;
 class NodeDeletionHelper;
 
 /**
@@ -38,6 +42,10 @@ class NodeDeletionHelper;
  * application-specific objects. See also @ref Player (coming soon). See
  * examples/replay_tutorial.py for usage of this class through bindings (coming
  * soon).
+ *
+ * Long recordings can instead be streamed to a compact binary file with
+ * @ref startStreamingToFile(), which writes the keyframes as they are saved
+ * rather than keeping them all in memory. See @ref KeyframeStreamWriter.
  */
 class Recorder {
  public:
@@ -89,6 +97,38 @@ class Recorder {
                                   const Magnum::Vector3& translation,
                                   const Magnum::Quaternion& rotation);
 
+  /**
+   * @brief Set a function called with each keyframe as it is saved, e.g. to
+   * send it to remote viewers, or nullptr to remove it
+   */
+  void setKeyframeListener(std::function<void(const Keyframe&)> listener) {
+    keyframeListener_ = std::move(listener);
+  }
+
+  /**
+   * @brief The loads and creations of the keyframes saved so far and the
+   * latest states of the instances, e.g. for a viewer that starts watching
+   * now
+   *
+   * The keyframes written to a file and forgotten are not included.
+   */
+  Keyframe getSavedScene();
+
+  /**
+   * @brief Set how far an instance has to move before its state is saved
+   * again
+   *
+   * By default any change is saved, so that e.g. the jitter of resting
+   * physics objects is saved every keyframe. The moves are measured from the
+   * last saved state, so that they don't add up to more than the thresholds.
+   * A change of semantic id is always saved.
+   *
+   * @param translationThreshold The distance, in meters
+   * @param rotationThreshold The angle, in radians
+   */
+  void setStateUpdateThresholds(float translationThreshold,
+                                float rotationThreshold);
+
   /**
    * @brief write saved keyframes to file. Not implemented yet.
    * @param filepath
@@ -100,6 +140,46 @@ class Recorder {
    */
   std::string writeSavedKeyframesToString();
 
+  /**
+   * @brief Stream the keyframes to a binary file as they are saved
+   *
+   * The keyframes saved so far are written first. Until @ref stopStreaming(),
+   * saved keyframes go to the file rather than to memory, so
+   * @ref writeSavedKeyframesToFile() has nothing to write. The file is read
+   * back by @ref Player like a JSON one.
+   *
+   * @param filepath The file to write, replaced if it exists
+   * @param keyframesPerChunk The number of keyframes buffered before they are
+   *                          written, see @ref KeyframeStreamWriter
+   * @param translationQuantum The precision of the translations of the
+   *                           instances in the file, in meters
+   * @return Whether the file could be opened
+   */
+  bool startStreamingToFile(const std::string& filepath,
+                            int keyframesPerChunk = 64,
+                            float translationQuantum = 1e-4f);
+
+  /**
+   * @brief Write the last keyframes and close the file
+   *
+   * The keyframes saved afterwards are kept in memory again and start with
+   * the loads and creations of the streamed ones, as after
+   * @ref writeSavedKeyframesToFile().
+   */
+  void stopStreaming();
+
+  /** @brief Whether saved keyframes are streamed to a file */
+  bool isStreaming() const { return bool(stream_); }
+
+  /**
+   * @brief The estimated memory of the keyframes kept in memory and of the
+   * records of the instances, in bytes
+   *
+   * Grows with every saved keyframe until they are written or, while
+   * streaming, stays at the loads and creations of the streamed ones.
+   */
+  std::size_t getHostBytes() const;
+
   /**
    * @brief Reserved for unit-testing.
    */
@@ -127,19 +207,30 @@ class Recorder {
   void advanceKeyframe();
   RenderAssetInstanceKey getNewInstanceKey();
   int findInstance(const scene::SceneNode* queryNode);
-  RenderAssetInstanceState getInstanceState(const scene::SceneNode* node);
+  RenderAssetInstanceState getInstanceState(scene::SceneNode* node);
   void updateInstanceStates();
+  bool hasChanged(const RenderAssetInstanceState& state,
+                  const RenderAssetInstanceState& recentState) const;
   void checkAndAddDeletion(Keyframe* keyframe,
                            RenderAssetInstanceKey instanceKey);
+  void addLoadsCreationsDeletions(const Keyframe& keyframe, Keyframe* dest);
   void addLoadsCreationsDeletions(KeyframeIterator begin,
                                   KeyframeIterator end,
                                   Keyframe* dest);
   void consolidateSavedKeyframes();
 
   std::vector<InstanceRecord> instanceRecords_;
+  // Index of the record of each node in instanceRecords_
+  std::unordered_map<const scene::SceneNode*, std::size_t> instanceIndices_;
   Keyframe currKeyframe_;
   std::vector<Keyframe> savedKeyframes_;
   RenderAssetInstanceKey nextInstanceKey_ = 0;
+  std::function<void(const Keyframe&)> keyframeListener_;
+  float translationThreshold_ = 0.0f;
+  float rotationThreshold_ = 0.0f;
+  std::unique_ptr<KeyframeStreamWriter> stream_;
+  // The loads, creations and deletions of the streamed keyframes
+  Keyframe streamedAssets_;
 };
 
 }  // namespace replay
@@ -21,6 +21,32 @@ std::shared_ptr<Player> ReplayManager::readKeyframesFromFile(
   return player;
 }
 
+int ReplayManager::startKeyframeServer(int port, float translationQuantum) {
+  stopKeyframeServer();
+  if (!recorder_) {
+    LOG(ERROR) << "ReplayManager::startKeyframeServer: no Recorder to serve "
+                  "the keyframes of";
+    return -1;
+  }
+  auto server = std::make_shared<KeyframeServer>(port, translationQuantum);
+  if (!server->isListening()) {
+    return -1;
+  }
+  // the viewers start from what was saved before
+  server->publish(recorder_->getSavedScene());
+  recorder_->setKeyframeListener(
+      [server](const Keyframe& keyframe) { server->publish(keyframe); });
+  keyframeServer_ = std::move(server);
+  return keyframeServer_->port();
+}
+
+void ReplayManager::stopKeyframeServer() {
+  if (recorder_) {
+    recorder_->setKeyframeListener(nullptr);
+  }
+  keyframeServer_ = nullptr;
+}
+
 }  // namespace replay
 }  // namespace gfx
 }  // namespace esp
@@ -5,6 +5,7 @@
 #ifndef ESP_GFX_REPLAY_REPLAYMANAGER_H_
 #define ESP_GFX_REPLAY_REPLAYMANAGER_H_
 
+#include "KeyframeServer.h"
 #include "Player.h"
 #include "Recorder.h"
 
@@ -47,8 +48,32 @@ class ReplayManager {
    */
   std::shared_ptr<Player> readKeyframesFromFile(const std::string& filepath);
 
+  /**
+   * @brief Construct a Player without keyframes, e.g. to append the ones
+   * received from a @ref KeyframeServer.
+   */
+  std::shared_ptr<Player> createPlayer() const {
+    return std::make_shared<Player>(playerCallback_);
+  }
+
+  /**
+   * @brief Serve the keyframes saved by the Recorder to remote viewers, see
+   * @ref KeyframeServer. Replaces the current server.
+   * @param port The TCP port to listen on, 0 for any free one
+   * @param translationQuantum The precision of the sent translations
+   * @return The port listened on, -1 if the server couldn't listen or there
+   * is no Recorder
+   */
+  int startKeyframeServer(int port, float translationQuantum = 1e-4f);
+
+  /**
+   * @brief Stop serving keyframes and disconnect the viewers
+   */
+  void stopKeyframeServer();
+
  private:
   std::shared_ptr<Recorder> recorder_;
+  std::shared_ptr<KeyframeServer> keyframeServer_;
   Player::LoadAndCreateRenderAssetInstanceCallback playerCallback_;
 
   ESP_SMART_POINTERS(ReplayManager)
@@ -0,0 +1,132 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/TestSuite/Tester.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Math/Angle.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/gfx/BakedLighting.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+struct BakedLightingTest : Cr::TestSuite::Tester {
+  explicit BakedLightingTest();
+
+  void canBake();
+  void directionalLight();
+  void objectPointLight();
+  void hash();
+};
+
+BakedLightingTest::BakedLightingTest() {
+  addTests({&BakedLightingTest::canBake, &BakedLightingTest::directionalLight,
+            &BakedLightingTest::objectPointLight, &BakedLightingTest::hash});
+}
+
+PhongMaterialData testMaterial() {
+  PhongMaterialData material;
+  material.ambientColor = {0.1f, 0.1f, 0.1f, 1.0f};
+  material.diffuseColor = {0.8f, 0.8f, 0.8f, 1.0f};
+  return material;
+}
+
+void BakedLightingTest::canBake() {
+  CORRADE_VERIFY(!canBakeLighting(LightSetup{}));
+  CORRADE_VERIFY(canBakeLighting(getDefaultLights()));
+  CORRADE_VERIFY(!canBakeLighting(LightSetup{
+      {{0.0f, 1.0f, 0.0f, 0.0f}, {1.0f}, LightPositionModel::GLOBAL},
+      {{0.0f, 0.0f, 1.0f, 0.0f}, {1.0f}, LightPositionModel::CAMERA}}));
+
+  Mn::GL::Texture2D texture{Mn::NoCreate}, otherTexture{Mn::NoCreate};
+  PhongMaterialData textured = testMaterial();
+  CORRADE_VERIFY(canBakeLighting(textured));
+  textured.diffuseTexture = &texture;
+  CORRADE_VERIFY(canBakeLighting(textured));
+  textured.ambientTexture = &texture;
+  CORRADE_VERIFY(canBakeLighting(textured));
+  // the colors can only modulate one texture
+  textured.ambientTexture = &otherTexture;
+  CORRADE_VERIFY(!canBakeLighting(textured));
+
+  PhongMaterialData vertexColored = testMaterial();
+  vertexColored.vertexColored = true;
+  CORRADE_VERIFY(!canBakeLighting(vertexColored));
+}
+
+void BakedLightingTest::directionalLight() {
+  const LightSetup lights{{{0.0f, 1.0f, 0.0f, 0.0f},
+                           {1.0f, 0.5f, 0.0f},
+                           LightPositionModel::GLOBAL}};
+  const Mn::Vector3 positions[]{{0.0f, 0.0f, 0.0f}, {10.0f, 0.0f, 0.0f}};
+  const Mn::Vector3 normals[]{{0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}};
+  Cr::Containers::Array<Mn::Color4> colors = bakeVertexLighting(
+      lights, testMaterial(), Mn::Matrix4{}, positions, normals);
+  CORRADE_COMPARE(colors.size(), 2);
+
+  // the ambient term, plus the diffuse one facing the light
+  const float ambient = 0.1f * getAmbientLightColor(lights).r();
+  CORRADE_COMPARE(colors[0],
+                  (Mn::Color4{ambient + 0.8f, ambient + 0.4f, ambient, 1.0f}));
+  CORRADE_COMPARE(colors[1], (Mn::Color4{ambient, ambient, ambient, 1.0f}));
+
+  // a rotated mesh turns its normals away from the light
+  Cr::Containers::Array<Mn::Color4> rotated =
+      bakeVertexLighting(lights, testMaterial(),
+                         Mn::Matrix4::rotationX(Mn::Deg{180.0f}), positions,
+                         normals);
+  CORRADE_COMPARE(rotated[0], colors[1]);
+  CORRADE_COMPARE(rotated[1], colors[0]);
+}
+
+void BakedLightingTest::objectPointLight() {
+  // two meters above the origin of the mesh, which is moved to x = 5
+  const LightSetup lights{{{0.0f, 2.0f, 0.0f, 1.0f},
+                           {1.0f, 1.0f, 1.0f},
+                           LightPositionModel::OBJECT}};
+  const Mn::Vector3 positions[]{{0.0f, 0.0f, 0.0f}};
+  const Mn::Vector3 normals[]{{0.0f, 1.0f, 0.0f}};
+  Cr::Containers::Array<Mn::Color4> colors =
+      bakeVertexLighting(lights, testMaterial(),
+                         Mn::Matrix4::translation({5.0f, 0.0f, 0.0f}),
+                         positions, normals);
+
+  // attenuated by 1/(1 + d^2)
+  const float ambient = 0.1f * getAmbientLightColor(lights).r();
+  CORRADE_COMPARE(colors[0].r(), ambient + 0.8f / 5.0f);
+  CORRADE_COMPARE(colors[0].a(), 1.0f);
+}
+
+void BakedLightingTest::hash() {
+  const LightSetup lights = getDefaultLights();
+  const std::uint64_t a = bakedLightingHash(lights, Mn::Matrix4{});
+  CORRADE_COMPARE(bakedLightingHash(lights, Mn::Matrix4{}), a);
+  CORRADE_VERIFY(bakedLightingHash(lights, Mn::Matrix4::translation(
+                                               {1.0f, 0.0f, 0.0f})) != a);
+  LightSetup moved = lights;
+  moved[0].vector.x() += 1.0f;
+  CORRADE_VERIFY(bakedLightingHash(moved, Mn::Matrix4{}) != a);
+
+  PhongMaterialData other = testMaterial();
+  other.diffuseColor = {0.5f, 0.5f, 0.5f, 1.0f};
+  CORRADE_COMPARE(bakedLightingHash(a, testMaterial()),
+                  bakedLightingHash(a, testMaterial()));
+  CORRADE_VERIFY(bakedLightingHash(a, other) !=
+                 bakedLightingHash(a, testMaterial()));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::BakedLightingTest)
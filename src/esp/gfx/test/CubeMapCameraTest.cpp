@@ -0,0 +1,74 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/TestSuite/Tester.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/gfx/CubeMapCamera.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+struct CubeMapCameraTest : Cr::TestSuite::Tester {
+  explicit CubeMapCameraTest();
+
+  void faceOrientation();
+};
+
+// OpenGL cube map face layout: the directions of the s and t texture
+// coordinate axes and of the major axis, see the OpenGL specification
+const struct {
+  const char* name;
+  Mn::GL::CubeMapCoordinate face;
+  Mn::Vector3 s, t, major;
+} FaceData[]{
+    {"+X", Mn::GL::CubeMapCoordinate::PositiveX, -Mn::Vector3::zAxis(),
+     -Mn::Vector3::yAxis(), Mn::Vector3::xAxis()},
+    {"-X", Mn::GL::CubeMapCoordinate::NegativeX, Mn::Vector3::zAxis(),
+     -Mn::Vector3::yAxis(), -Mn::Vector3::xAxis()},
+    {"+Y", Mn::GL::CubeMapCoordinate::PositiveY, Mn::Vector3::xAxis(),
+     Mn::Vector3::zAxis(), Mn::Vector3::yAxis()},
+    {"-Y", Mn::GL::CubeMapCoordinate::NegativeY, Mn::Vector3::xAxis(),
+     -Mn::Vector3::zAxis(), -Mn::Vector3::yAxis()},
+    {"+Z", Mn::GL::CubeMapCoordinate::PositiveZ, Mn::Vector3::xAxis(),
+     -Mn::Vector3::yAxis(), Mn::Vector3::zAxis()},
+    {"-Z", Mn::GL::CubeMapCoordinate::NegativeZ, -Mn::Vector3::xAxis(),
+     -Mn::Vector3::yAxis(), -Mn::Vector3::zAxis()},
+};
+
+CubeMapCameraTest::CubeMapCameraTest() {
+  addInstancedTests({&CubeMapCameraTest::faceOrientation},
+                    Cr::Containers::arraySize(FaceData));
+}
+
+// the lookup direction of a view direction, as documented in
+// CubeMapCamera::cameraLocalTransform() and used by cubemap.frag
+Mn::Vector3 cubeDirection(const Mn::Vector3& direction) {
+  return {-direction.x(), direction.y(), -direction.z()};
+}
+
+void CubeMapCameraTest::faceOrientation() {
+  auto&& data = FaceData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  const Mn::Matrix4 local = CubeMapCamera::cameraLocalTransform(data.face);
+  // the camera looks along -Z, with the image x along +X and y along +Y,
+  // which have to match the face's texture coordinate axes
+  CORRADE_COMPARE(cubeDirection(-local.backward()), data.major);
+  CORRADE_COMPARE(cubeDirection(local.right()), data.s);
+  CORRADE_COMPARE(cubeDirection(local.up()), data.t);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::CubeMapCameraTest)
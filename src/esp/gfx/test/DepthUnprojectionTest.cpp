@@ -4,6 +4,7 @@
 
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/TestSuite/Compare/Container.h>
 #include <Corrade/TestSuite/Compare/Numeric.h>
 #include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/Mesh.h>
@@ -11,6 +12,7 @@
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/Image.h>
+#include <Magnum/ImageView.h>
 #include <Magnum/Math/Color.h>
 #include <Magnum/Math/FunctionsBatch.h>
 #include <Magnum/Math/Matrix4.h>
@@ -37,11 +39,15 @@ struct DepthUnprojectionTest : Mn::GL::OpenGLTester {
   explicit DepthUnprojectionTest();
 
   void testCpu();
+  void testCpuImage();
   void testGpuDirect();
   void testGpuUnprojectExisting();
+  void testGpuReconstructNormals();
+  void testGpuUnprojectPoints();
 
   void benchmarkBaseline();
   void benchmarkCpu();
+  void benchmarkCpuImage();
   void benchmarkGpuDirect();
   void benchmarkGpuUnprojectExisting();
 };
@@ -69,6 +75,30 @@ const struct {
      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.01f, 100.0f)},
 };
 
+const struct {
+  const char* name;
+  Mn::Matrix4 rotation;
+  bool flipped;
+} NormalTestData[]{
+    {"facing the camera", Mn::Matrix4{}, false},
+    {"tilted", Mn::Matrix4::rotationY(30.0_degf) *
+                   Mn::Matrix4::rotationX(-20.0_degf),
+     false},
+    {"tilted, flipped projection", Mn::Matrix4::rotationY(30.0_degf) *
+                                       Mn::Matrix4::rotationX(-20.0_degf),
+     true},
+};
+
+const struct {
+  const char* name;
+  int stride;
+  bool flipped;
+} PointTestData[]{
+    {"", 1, false},
+    {"flipped projection", 1, true},
+    {"stride 4, flipped projection", 4, true},
+};
+
 /* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
 #if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
 #define FMV_SUPPORTED
@@ -143,12 +173,22 @@ DepthUnprojectionTest::DepthUnprojectionTest() {
        &DepthUnprojectionTest::testGpuUnprojectExisting},
       Cr::Containers::arraySize(TestData));
 
+  addTests({&DepthUnprojectionTest::testCpuImage});
+
+  addInstancedTests({&DepthUnprojectionTest::testGpuReconstructNormals},
+                    Cr::Containers::arraySize(NormalTestData));
+
+  addInstancedTests({&DepthUnprojectionTest::testGpuUnprojectPoints},
+                    Cr::Containers::arraySize(PointTestData));
+
   addInstancedBenchmarks({&DepthUnprojectionTest::benchmarkBaseline}, 50,
                          Cr::Containers::arraySize(UnprojectBenchmarkData));
 
   addInstancedBenchmarks({&DepthUnprojectionTest::benchmarkCpu}, 50,
                          Cr::Containers::arraySize(UnprojectBenchmarkData));
 
+  addBenchmarks({&DepthUnprojectionTest::benchmarkCpuImage}, 50);
+
   addBenchmarks({&DepthUnprojectionTest::benchmarkGpuDirect}, 50,
                 BenchmarkType::GpuTime);
 
@@ -174,6 +214,40 @@ void DepthUnprojectionTest::testCpu() {
                        Cr::TestSuite::Compare::around(data.depth * 0.0002f));
 }
 
+void DepthUnprojectionTest::testCpuImage() {
+  const Mn::Vector2 unprojection = calculateDepthUnprojection(
+      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.01f, 100.0f));
+
+  // large enough to be split between threads, with padded rows which have to
+  // stay untouched
+  const Mn::Vector2i size{1027, 311};
+  const std::size_t rowLength = size.x() + 5;
+  Cr::Containers::Array<float> depth{Cr::Containers::NoInit,
+                                     rowLength * size.y()};
+  Cr::Containers::Array<float> expected{Cr::Containers::NoInit, depth.size()};
+  for (std::size_t i = 0; i != depth.size(); ++i) {
+    depth[i] = expected[i] = i % rowLength < std::size_t(size.x())
+                                 ? float(i % 10001) / float(10000)
+                                 : -1.0f;
+  }
+  unprojectDepth(unprojection, expected);
+
+  unprojectDepth(unprojection,
+                 Mn::MutableImageView2D{
+                     Mn::PixelStorage{}.setRowLength(rowLength),
+                     Mn::PixelFormat::R32F, size,
+                     Cr::Containers::arrayView(depth)});
+  for (std::size_t row = 0; row != std::size_t(size.y()); ++row) {
+    CORRADE_ITERATION(row);
+    const std::size_t begin = row * rowLength;
+    CORRADE_COMPARE_AS(depth.slice(begin, begin + size.x()),
+                       expected.slice(begin, begin + size.x()),
+                       Cr::TestSuite::Compare::Container);
+    for (std::size_t i = begin + size.x(); i != begin + rowLength; ++i)
+      CORRADE_COMPARE(depth[i], -1.0f);
+  }
+}
+
 void DepthUnprojectionTest::testGpuDirect() {
   auto&& data = TestData[testCaseInstanceId()];
   setTestCaseDescription(data.name);
@@ -258,6 +332,164 @@ void DepthUnprojectionTest::testGpuUnprojectExisting() {
                        Cr::TestSuite::Compare::around(data.depth * 0.0002f));
 }
 
+void DepthUnprojectionTest::testGpuReconstructNormals() {
+  auto&& data = NormalTestData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  const Mn::Matrix4 projection =
+      Mn::Matrix4::scaling(Mn::Vector3::yScale(data.flipped ? -1.0f : 1.0f)) *
+      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.01f, 100.0f);
+  Mn::GL::Renderer::setClearDepth(1.0f);
+
+  Mn::GL::Texture2D depth;
+  depth.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::DepthComponent32F,
+                  Mn::Vector2i{16});
+  Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{16}}};
+  framebuffer
+      .attachTexture(Mn::GL::Framebuffer::BufferAttachment::Depth, depth, 0)
+      .mapForDraw(Mn::GL::Framebuffer::DrawAttachment::None)
+      .clear(Mn::GL::FramebufferClear::Depth)
+      .bind();
+
+  /* A plane covering the view, its normal is the rotated +Z */
+  const Mn::Matrix4 transformation =
+      Mn::Matrix4::translation(Mn::Vector3::zAxis(-4.0f)) * data.rotation *
+      Mn::Matrix4::scaling(Mn::Vector3{20.0f});
+  Mn::GL::Mesh mesh = Mn::MeshTools::compile(Mn::Primitives::planeSolid());
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::DepthTest);
+  Mn::Shaders::Flat3D flat;
+  flat.setTransformationProjectionMatrix(projection * transformation)
+      .draw(mesh);
+  Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::DepthTest);
+
+  Mn::GL::Texture2D output;
+  output.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::RGBA32F, Mn::Vector2i{16});
+  framebuffer.detach(Mn::GL::Framebuffer::BufferAttachment::Depth)
+      .attachTexture(Mn::GL::Framebuffer::ColorAttachment{0}, output, 0)
+      .mapForDraw(Mn::GL::Framebuffer::ColorAttachment{0})
+      .clear(Mn::GL::FramebufferClear::Color);
+
+  DepthShader shader{DepthShader::Flag::UnprojectExistingDepth |
+                     DepthShader::Flag::ReconstructNormals};
+  shader.setDepthUnprojection(calculateDepthUnprojection(projection))
+      .setPixelUnprojection(calculatePixelUnprojection(projection))
+      .bindDepthTexture(depth)
+      .draw(Mn::GL::Mesh{}.setCount(3));
+
+  MAGNUM_VERIFY_NO_GL_ERROR();
+
+  Mn::Image2D image =
+      framebuffer.read(framebuffer.viewport(), {Mn::PixelFormat::RGBA32F});
+  const Mn::Vector3 expected =
+      data.rotation.transformVector(Mn::Vector3::zAxis());
+  for (const Mn::Vector2i pixel : {Mn::Vector2i{8}, Mn::Vector2i{3, 12}}) {
+    CORRADE_ITERATION(pixel);
+    const Mn::Vector4 normal =
+        image.pixels<Mn::Vector4>()[pixel.y()][pixel.x()];
+    CORRADE_COMPARE_WITH(normal.xyz(), expected,
+                         Cr::TestSuite::Compare::around(Mn::Vector3{0.001f}));
+    CORRADE_COMPARE(normal.w(), 0.0f);
+  }
+
+  /* Orthographic projections can't be unprojected per pixel */
+  CORRADE_COMPARE(calculatePixelUnprojection(
+                      Mn::Matrix4::orthographicProjection({2.0f, 2.0f}, 0.01f,
+                                                          100.0f)),
+                  Mn::Vector2{});
+}
+
+void DepthUnprojectionTest::testGpuUnprojectPoints() {
+  auto&& data = PointTestData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  const Mn::Matrix4 projection =
+      Mn::Matrix4::scaling(Mn::Vector3::yScale(data.flipped ? -1.0f : 1.0f)) *
+      Mn::Matrix4::perspectiveProjection(90.0_degf, 1.0f, 0.01f, 100.0f);
+  Mn::GL::Renderer::setClearDepth(1.0f);
+
+  Mn::GL::Texture2D depth;
+  depth.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::DepthComponent32F,
+                  Mn::Vector2i{16});
+  Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{16}}};
+  framebuffer
+      .attachTexture(Mn::GL::Framebuffer::BufferAttachment::Depth, depth, 0)
+      .mapForDraw(Mn::GL::Framebuffer::DrawAttachment::None)
+      .clear(Mn::GL::FramebufferClear::Depth)
+      .bind();
+
+  /* A plane covering the right half of the view, four units away */
+  Mn::GL::Mesh mesh = Mn::MeshTools::compile(Mn::Primitives::planeSolid());
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::DepthTest);
+  Mn::Shaders::Flat3D flat;
+  flat.setTransformationProjectionMatrix(
+          projection * Mn::Matrix4::translation({10.0f, 0.0f, -4.0f}) *
+          Mn::Matrix4::scaling(Mn::Vector3{10.0f}))
+      .draw(mesh);
+  Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::DepthTest);
+
+  const Mn::Vector2i size{16 / data.stride};
+  Mn::GL::Texture2D output;
+  output.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setMagnificationFilter(Mn::GL::SamplerFilter::Nearest)
+      .setWrapping(Mn::GL::SamplerWrapping::ClampToEdge)
+      .setStorage(1, Mn::GL::TextureFormat::RGBA32F, size);
+  Mn::GL::Framebuffer pointFramebuffer{{{}, size}};
+  pointFramebuffer
+      .attachTexture(Mn::GL::Framebuffer::ColorAttachment{0}, output, 0)
+      .mapForDraw(Mn::GL::Framebuffer::ColorAttachment{0})
+      .clear(Mn::GL::FramebufferClear::Color)
+      .bind();
+
+  const Mn::Matrix4 transformation =
+      Mn::Matrix4::translation({1.0f, 2.0f, 3.0f});
+  DepthShader shader{DepthShader::Flag::UnprojectExistingDepth |
+                     DepthShader::Flag::UnprojectPoints};
+  shader.setDepthUnprojection(calculateDepthUnprojection(projection))
+      .setPixelUnprojection(calculatePixelUnprojection(projection))
+      .setPointTransformation(transformation)
+      .setPointStride(data.stride)
+      .bindDepthTexture(depth)
+      .draw(Mn::GL::Mesh{}.setCount(3));
+
+  MAGNUM_VERIFY_NO_GL_ERROR();
+
+  Mn::Image2D image = pointFramebuffer.read(pointFramebuffer.viewport(),
+                                            {Mn::PixelFormat::RGBA32F});
+  for (int y = 0; y != size.y(); ++y) {
+    for (int x = 0; x != size.x(); ++x) {
+      CORRADE_ITERATION(Mn::Vector2i(x, y));
+      const Mn::Vector4 point = image.pixels<Mn::Vector4>()[y][x];
+      /* The center of the pixel subsampled, with a 90 degree field of view
+         it's at the NDC coordinates times the distance */
+      const Mn::Vector2i pixel = Mn::Vector2i{x, y} * data.stride +
+                                 Mn::Vector2i{data.stride / 2};
+      Mn::Vector2 ndc = (Mn::Vector2{pixel} + Mn::Vector2{0.5f}) / 8.0f -
+                        Mn::Vector2{1.0f};
+      if (data.flipped) {
+        ndc.y() *= -1.0f;
+      }
+      if (ndc.x() < 0.0f) {
+        CORRADE_COMPARE(point, Mn::Vector4{});
+        continue;
+      }
+      CORRADE_COMPARE_WITH(
+          point.xyz(),
+          transformation.transformPoint(Mn::Vector3{ndc * 4.0f, -4.0f}),
+          Cr::TestSuite::Compare::around(Mn::Vector3{0.001f}));
+      CORRADE_COMPARE(point.w(), 1.0f);
+    }
+  }
+}
+
 constexpr Mn::Vector2i BenchmarkSize{1536};
 
 void DepthUnprojectionTest::benchmarkBaseline() {
@@ -306,6 +538,25 @@ void DepthUnprojectionTest::benchmarkCpu() {
                      Cr::TestSuite::Compare::Greater);
 }
 
+void DepthUnprojectionTest::benchmarkCpuImage() {
+  Mn::Vector2 unprojection = calculateDepthUnprojection(
+      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.001f, 100.0f));
+
+  Cr::Containers::Array<float> depth{Cr::Containers::NoInit,
+                                     std::size_t(BenchmarkSize.product())};
+  for (std::size_t i = 0; i != depth.size(); ++i)
+    depth[i] = float(i % 10000) / float(10000);
+
+  CORRADE_BENCHMARK(1) {
+    unprojectDepth(unprojection,
+                   Mn::MutableImageView2D{Mn::PixelFormat::R32F, BenchmarkSize,
+                                          Cr::Containers::arrayView(depth)});
+  }
+
+  CORRADE_COMPARE_AS(Mn::Math::max<float>(depth), 9.0f,
+                     Cr::TestSuite::Compare::Greater);
+}
+
 void DepthUnprojectionTest::benchmarkGpuDirect() {
   Mn::GL::Texture2D output{};
   output.setMinificationFilter(Mn::GL::SamplerFilter::Nearest)
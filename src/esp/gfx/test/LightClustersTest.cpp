@@ -0,0 +1,165 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/TestSuite/Tester.h>
+#include <Magnum/Math/Angle.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Matrix4.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "esp/gfx/LightClusters.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+using namespace Mn::Math::Literals;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+struct LightClustersTest : Cr::TestSuite::Tester {
+  explicit LightClustersTest();
+
+  void clustered();
+  void influenceRadius();
+  void binning();
+  void update();
+};
+
+LightClustersTest::LightClustersTest() {
+  addTests({&LightClustersTest::clustered, &LightClustersTest::influenceRadius,
+            &LightClustersTest::binning, &LightClustersTest::update});
+}
+
+// Positions in LightClusters::lightOrder() of the lights of @p cluster
+std::vector<std::uint32_t> lightsOf(const LightClusters& clusters,
+                                    const std::size_t cluster) {
+  const Mn::Vector2ui range = clusters.clusters()[cluster];
+  return {clusters.lightIndices().begin() + range.x(),
+          clusters.lightIndices().begin() + range.x() + range.y()};
+}
+
+bool contains(const std::vector<std::uint32_t>& lights,
+              const std::uint32_t light) {
+  return std::find(lights.begin(), lights.end(), light) != lights.end();
+}
+
+// one directional light in between point lights of range 1 outside of the
+// frustum, and one in front of the camera at a depth of 10
+LightParameters parameters() {
+  LightParameters parameters;
+  for (int i = 0; i != 9; ++i) {
+    parameters.positions.emplace_back(50.0f, 0.0f, -10.0f, 1.0f);
+    parameters.colors.emplace_back(1.0f);
+    parameters.ranges.push_back(1.0f);
+  }
+  parameters.positions[3] = {0.0f, 0.0f, 1.0f, 0.0f};
+  parameters.ranges[3] = Mn::Constants::inf();
+  parameters.positions[6] = {0.0f, 0.0f, -10.0f, 1.0f};
+  parameters.version = 1;
+  return parameters;
+}
+
+const Mn::Matrix4 Projection =
+    Mn::Matrix4::perspectiveProjection(90.0_degf, 1.0f, 0.1f, 100.0f);
+
+void LightClustersTest::clustered() {
+  LightSetup lights(LightClusters::MinLightCount - 1);
+  CORRADE_VERIFY(!LightClusters::isClustered(lights));
+  lights.emplace_back();
+  CORRADE_VERIFY(LightClusters::isClustered(lights));
+  // object-relative lights differ for every drawable
+  lights.back().model = LightPositionModel::OBJECT;
+  CORRADE_VERIFY(!LightClusters::isClustered(lights));
+}
+
+void LightClustersTest::influenceRadius() {
+  CORRADE_COMPARE(
+      LightClusters::influenceRadius(Mn::Color3{1.0f}, Mn::Constants::inf()),
+      std::sqrt(511.0f));
+  CORRADE_COMPARE(LightClusters::influenceRadius({0.0f, 1.0f, 0.5f}, 2.0f),
+                  2.0f);
+  CORRADE_COMPARE(LightClusters::influenceRadius(Mn::Color3{1.0f / 1024.0f},
+                                                 Mn::Constants::inf()),
+                  0.0f);
+}
+
+void LightClustersTest::binning() {
+  LightClusters clusters;
+  CORRADE_VERIFY(clusters.update(parameters(), Projection));
+
+  // the directional light first, the point lights in their order after it
+  CORRADE_COMPARE(clusters.directionalLightCount(), 1);
+  CORRADE_COMPARE(clusters.lightOrder().size(), 9);
+  CORRADE_COMPARE(clusters.lightOrder()[0], 3);
+  CORRADE_COMPARE(clusters.lightOrder()[1], 0);
+  CORRADE_COMPARE(clusters.lightOrder()[6], 6);
+  CORRADE_COMPARE(clusters.clusters().size(),
+                  std::size_t{LightClusters::TileCountX *
+                              LightClusters::TileCountY *
+                              LightClusters::SliceCount});
+  CORRADE_COMPARE(clusters.lightIndices().size() %
+                      LightClusters::IndexTextureWidth,
+                  0);
+
+  // the light in front of the camera is in the clusters around it only
+  const std::size_t center = clusters.clusterOf({0.0f, 0.0f, -10.0f});
+  CORRADE_VERIFY(contains(lightsOf(clusters, center), 6));
+  CORRADE_VERIFY(
+      contains(lightsOf(clusters, clusters.clusterOf({0.5f, 0.5f, -10.5f})),
+               6));
+  CORRADE_VERIFY(
+      !contains(lightsOf(clusters, clusters.clusterOf({0.0f, 0.0f, -50.0f})),
+                6));
+  CORRADE_VERIFY(
+      !contains(lightsOf(clusters, clusters.clusterOf({9.0f, 9.0f, -10.0f})),
+                6));
+
+  // the ones outside of the frustum are in none
+  std::size_t count = 0;
+  for (const Mn::Vector2ui& cluster : clusters.clusters()) {
+    count += cluster.y();
+  }
+  for (const Mn::Vector2ui& cluster : clusters.clusters()) {
+    for (std::uint32_t k = 0; k != cluster.y(); ++k) {
+      CORRADE_COMPARE(clusters.lightIndices()[cluster.x() + k], 6);
+    }
+  }
+  CORRADE_VERIFY(count > 0);
+}
+
+void LightClustersTest::update() {
+  LightClusters clusters;
+  LightParameters lights = parameters();
+  CORRADE_VERIFY(clusters.update(lights, Projection));
+  // the drawables of a frame share the clusters
+  CORRADE_VERIFY(!clusters.update(lights, Projection));
+
+  // a light moved away from the camera moves to a deeper slice
+  const std::size_t before = clusters.clusterOf({0.0f, 0.0f, -10.0f});
+  lights.positions[6] = {0.0f, 0.0f, -40.0f, 1.0f};
+  lights.version = 2;
+  CORRADE_VERIFY(clusters.update(lights, Projection));
+  CORRADE_VERIFY(!contains(lightsOf(clusters, before), 6));
+  CORRADE_VERIFY(
+      contains(lightsOf(clusters, clusters.clusterOf({0.0f, 0.0f, -40.0f})),
+               6));
+
+  // and so does a changed projection
+  CORRADE_VERIFY(clusters.update(
+      lights,
+      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.1f, 100.0f)));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::LightClustersTest)
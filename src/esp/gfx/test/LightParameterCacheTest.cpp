@@ -0,0 +1,128 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/TestSuite/Tester.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "esp/gfx/LightParameterCache.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+struct LightParameterCacheTest : Cr::TestSuite::Tester {
+  explicit LightParameterCacheTest();
+
+  void sharedLights();
+  void objectLights();
+  void upload();
+};
+
+LightParameterCacheTest::LightParameterCacheTest() {
+  addTests({&LightParameterCacheTest::sharedLights,
+            &LightParameterCacheTest::objectLights,
+            &LightParameterCacheTest::upload});
+}
+
+void LightParameterCacheTest::sharedLights() {
+  const LightSetup lights{
+      {{1.0f, 2.0f, 3.0f, 1.0f},
+       {0.5f, 0.5f, 0.5f},
+       LightPositionModel::GLOBAL},
+      {{0.0f, 0.0f, 1.0f, 0.0f},
+       {1.0f, 0.0f, 0.0f},
+       LightPositionModel::CAMERA}};
+  const Mn::Matrix4 cameraMatrix =
+      Mn::Matrix4::translation({0.0f, 0.0f, -5.0f});
+
+  LightParameterCache cache;
+  const LightParameters& a =
+      cache.get(lights, cameraMatrix, Mn::Matrix4::translation({1.0f, 0, 0}));
+  CORRADE_COMPARE(a.positions.size(), 2);
+  CORRADE_COMPARE(a.positions[0], (Mn::Vector4{1.0f, 2.0f, -2.0f, 1.0f}));
+  CORRADE_COMPARE(a.positions[1], (Mn::Vector4{0.0f, 0.0f, 1.0f, 0.0f}));
+  CORRADE_COMPARE(a.colors[1], (Mn::Color3{1.0f, 0.0f, 0.0f}));
+  CORRADE_VERIFY(!a.objectRelative);
+  const uint64_t version = a.version;
+
+  // other drawables of the same frame reuse the evaluation
+  const LightParameters& b =
+      cache.get(lights, cameraMatrix, Mn::Matrix4::translation({2.0f, 0, 0}));
+  CORRADE_COMPARE(&b, &a);
+  CORRADE_COMPARE(b.version, version);
+
+  // a moved camera re-evaluates
+  const LightParameters& c =
+      cache.get(lights, Mn::Matrix4{}, Mn::Matrix4::translation({2.0f, 0, 0}));
+  CORRADE_VERIFY(c.version != version);
+  CORRADE_COMPARE(c.positions[0], (Mn::Vector4{1.0f, 2.0f, 3.0f, 1.0f}));
+
+  // as does a new frame
+  const uint64_t cVersion = c.version;
+  cache.invalidate();
+  CORRADE_VERIFY(cache.get(lights, Mn::Matrix4{}, Mn::Matrix4{}).version !=
+                 cVersion);
+}
+
+void LightParameterCacheTest::objectLights() {
+  const LightSetup lights{
+      {{1.0f, 0.0f, 0.0f, 1.0f},
+       {1.0f, 1.0f, 1.0f},
+       LightPositionModel::OBJECT},
+      {{0.0f, 1.0f, 0.0f, 1.0f},
+       {1.0f, 1.0f, 1.0f},
+       LightPositionModel::GLOBAL}};
+
+  LightParameterCache cache;
+  const LightParameters& a =
+      cache.get(lights, Mn::Matrix4{}, Mn::Matrix4::translation({1.0f, 0, 0}));
+  CORRADE_VERIFY(a.objectRelative);
+  CORRADE_COMPARE(a.positions[0], (Mn::Vector4{2.0f, 0.0f, 0.0f, 1.0f}));
+  const uint64_t version = a.version;
+
+  const LightParameters& b =
+      cache.get(lights, Mn::Matrix4{}, Mn::Matrix4::translation({3.0f, 0, 0}));
+  CORRADE_VERIFY(b.version != version);
+  CORRADE_COMPARE(b.positions[0], (Mn::Vector4{4.0f, 0.0f, 0.0f, 1.0f}));
+  CORRADE_COMPARE(b.positions[1], (Mn::Vector4{0.0f, 1.0f, 0.0f, 1.0f}));
+}
+
+void LightParameterCacheTest::upload() {
+  const LightSetup lights{
+      {{1.0f, 2.0f, 3.0f, 1.0f},
+       {0.5f, 0.5f, 0.5f},
+       LightPositionModel::GLOBAL}};
+  const LightSetup otherLights{
+      {{0.0f, 0.0f, 1.0f, 0.0f},
+       {1.0f, 0.0f, 0.0f},
+       LightPositionModel::CAMERA}};
+  int shader, otherShader;
+
+  LightParameterCache cache;
+  const LightParameters& a = cache.get(lights, Mn::Matrix4{}, Mn::Matrix4{});
+  CORRADE_VERIFY(cache.needsUpload(&shader, a));
+  CORRADE_VERIFY(!cache.needsUpload(&shader, a));
+  CORRADE_VERIFY(cache.needsUpload(&otherShader, a));
+
+  // another light setup drawn with the same shader
+  const LightParameters& b =
+      cache.get(otherLights, Mn::Matrix4{}, Mn::Matrix4{});
+  CORRADE_VERIFY(cache.needsUpload(&shader, b));
+  CORRADE_VERIFY(cache.needsUpload(&shader, a));
+
+  cache.invalidate();
+  CORRADE_VERIFY(cache.needsUpload(&shader, a));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::LightParameterCacheTest)
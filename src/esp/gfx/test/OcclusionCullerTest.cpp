@@ -0,0 +1,219 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/OpenGLTester.h>
+#include <Magnum/GL/Renderbuffer.h>
+#include <Magnum/GL/RenderbufferFormat.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/MeshTools/Compile.h>
+#include <Magnum/Primitives/Cube.h>
+#include <Magnum/Shaders/Flat.h>
+#include <Magnum/Trade/MeshData.h>
+#include <memory>
+
+#include "esp/gfx/Drawable.h"
+#include "esp/gfx/RenderCamera.h"
+#include "esp/gfx/Renderer.h"
+#include "esp/scene/SceneGraph.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+constexpr Mn::Vector2i Size{64, 64};
+
+// a unit cube writing its depth, with the box it fills
+class CubeDrawable : public Drawable {
+ public:
+  CubeDrawable(scene::SceneNode& node,
+               Mn::GL::Mesh& mesh,
+               Mn::Shaders::Flat3D& shader,
+               DrawableGroup* group)
+      : Drawable{node, mesh, group}, shader_(shader) {
+    node.setMeshBB({Mn::Vector3{-1.0f}, Mn::Vector3{1.0f}});
+  }
+
+ private:
+  void draw(const Mn::Matrix4& transformationMatrix,
+            Mn::SceneGraph::Camera3D& camera) override {
+    shader_
+        .setTransformationProjectionMatrix(camera.projectionMatrix() *
+                                           transformationMatrix)
+        .draw(mesh_);
+  }
+
+  Mn::Shaders::Flat3D& shader_;
+};
+
+struct OcclusionCullerTest : Mn::GL::OpenGLTester {
+  explicit OcclusionCullerTest();
+
+  void occludedThenVisible();
+  void boxCrossingNearPlane();
+  void staleViews();
+  void viewKey();
+
+  /**
+   * @brief Draw a frame with occlusion culling and wait for its queries
+   * @return the number of drawables that were culled
+   */
+  size_t drawFrame(RenderCamera& camera, scene::SceneGraph& sceneGraph);
+
+  //! add a cube at @p translation, scaled by @p scaling
+  scene::SceneNode& addCube(scene::SceneGraph& sceneGraph,
+                            const Mn::Vector3& translation,
+                            const Mn::Vector3& scaling = Mn::Vector3{1.0f});
+
+  Mn::GL::Mesh cube_{Mn::MeshTools::compile(Mn::Primitives::cubeSolid())};
+  Mn::Shaders::Flat3D shader_;
+  Mn::GL::Renderbuffer color_, depth_;
+  Mn::GL::Framebuffer framebuffer_{{{}, Size}};
+  Renderer renderer_;
+};
+
+OcclusionCullerTest::OcclusionCullerTest() {
+  addTests({&OcclusionCullerTest::occludedThenVisible,
+            &OcclusionCullerTest::boxCrossingNearPlane,
+            &OcclusionCullerTest::staleViews, &OcclusionCullerTest::viewKey});
+
+  color_.setStorage(Mn::GL::RenderbufferFormat::RGBA8, Size);
+  depth_.setStorage(Mn::GL::RenderbufferFormat::DepthComponent24, Size);
+  framebuffer_
+      .attachRenderbuffer(Mn::GL::Framebuffer::ColorAttachment{0}, color_)
+      .attachRenderbuffer(Mn::GL::Framebuffer::BufferAttachment::Depth,
+                          depth_);
+}
+
+size_t OcclusionCullerTest::drawFrame(RenderCamera& camera,
+                                      scene::SceneGraph& sceneGraph) {
+  framebuffer_
+      .clear(Mn::GL::FramebufferClear::Color | Mn::GL::FramebufferClear::Depth)
+      .bind();
+  renderer_.draw(camera, sceneGraph, {RenderCamera::Flag::OcclusionCulling});
+  // the culler never waits for a query, so make sure the next frame sees
+  // the results of this one
+  Mn::GL::Renderer::finish();
+  return camera.getPreviousNumOccludedDrawables();
+}
+
+scene::SceneNode& OcclusionCullerTest::addCube(scene::SceneGraph& sceneGraph,
+                                               const Mn::Vector3& translation,
+                                               const Mn::Vector3& scaling) {
+  scene::SceneNode& node = sceneGraph.getRootNode().createChild();
+  node.setTranslation(translation);
+  node.setScaling(scaling);
+  node.addFeature<CubeDrawable>(cube_, shader_, &sceneGraph.getDrawables());
+  return node;
+}
+
+void OcclusionCullerTest::occludedThenVisible() {
+  scene::SceneGraph sceneGraph;
+  // the camera is at the origin, looking towards -z
+  RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+  camera.setProjectionMatrix(Size.x(), Size.y(), 0.1f, 100.0f,
+                             Mn::Deg{90.0f});
+  addCube(sceneGraph, {0.0f, 0.0f, -10.0f});
+  scene::SceneNode& wall =
+      addCube(sceneGraph, {0.0f, 0.0f, -5.0f}, {3.0f, 3.0f, 0.1f});
+
+  // nothing is known about the drawables yet
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 0);
+  // the cube behind the wall is culled, the wall is not culled by its own
+  // depth
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 1);
+  CORRADE_COMPARE(camera.getPreviousNumVisibileDrawables(), 1);
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 1);
+
+  // the box of the culled cube is still queried, against the frame without
+  // the wall, so it comes back after one more frame
+  wall.setTranslation({50.0f, 0.0f, -5.0f});
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 1);
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 0);
+  CORRADE_COMPARE(camera.getPreviousNumVisibileDrawables(), 2);
+}
+
+void OcclusionCullerTest::boxCrossingNearPlane() {
+  scene::SceneGraph sceneGraph;
+  RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+  camera.setProjectionMatrix(Size.x(), Size.y(), 0.1f, 100.0f,
+                             Mn::Deg{90.0f});
+  // a wall filling the whole view hides a cube and the far faces of a room
+  // around the camera
+  addCube(sceneGraph, {0.0f, 0.0f, -1.0f}, {100.0f, 100.0f, 0.01f});
+  addCube(sceneGraph, {0.0f, 0.0f, -10.0f});
+  addCube(sceneGraph, {}, Mn::Vector3{20.0f});
+
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 0);
+  // the box of the room would be clipped by the near plane, so it is not
+  // queried and the room is never culled
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 1);
+  CORRADE_COMPARE(drawFrame(camera, sceneGraph), 1);
+}
+
+void OcclusionCullerTest::staleViews() {
+  scene::SceneGraph sceneGraph;
+  addCube(sceneGraph, {0.0f, 0.0f, -10.0f});
+  addCube(sceneGraph, {0.0f, 0.0f, -5.0f}, {3.0f, 3.0f, 0.1f});
+  scene::SceneNode& cameraNode = sceneGraph.getRootNode().createChild();
+
+  auto camera = std::make_unique<RenderCamera>(cameraNode);
+  camera->setProjectionMatrix(Size.x(), Size.y(), 0.1f, 100.0f,
+                              Mn::Deg{90.0f});
+  CORRADE_COMPARE(drawFrame(*camera, sceneGraph), 0);
+  CORRADE_COMPARE(drawFrame(*camera, sceneGraph), 1);
+
+  {
+    // another view has a history of its own
+    RenderCamera other{cameraNode};
+    other.setProjectionMatrix(Size.x(), Size.y(), 0.1f, 100.0f,
+                              Mn::Deg{90.0f});
+    CORRADE_COMPARE(drawFrame(other, sceneGraph), 0);
+    CORRADE_COMPARE(drawFrame(*camera, sceneGraph), 1);
+  }
+
+  // a camera replacing a destroyed one, likely at the same address, starts
+  // without the history of the old one
+  camera.reset();
+  camera = std::make_unique<RenderCamera>(cameraNode);
+  camera->setProjectionMatrix(Size.x(), Size.y(), 0.1f, 100.0f,
+                              Mn::Deg{90.0f});
+  CORRADE_COMPARE(drawFrame(*camera, sceneGraph), 0);
+  CORRADE_COMPARE(drawFrame(*camera, sceneGraph), 1);
+
+  // all the history is dropped on a reset
+  renderer_.resetOcclusionCulling();
+  CORRADE_COMPARE(drawFrame(*camera, sceneGraph), 0);
+
+  // the camera is a feature of its node, destroyed before it
+  camera.reset();
+}
+
+void OcclusionCullerTest::viewKey() {
+  std::weak_ptr<const void> lifetime;
+  {
+    ViewKey key;
+    lifetime = key.lifetime();
+    CORRADE_VERIFY(!lifetime.expired());
+    CORRADE_VERIFY(key.id());
+
+    ViewKey copy{key};
+    CORRADE_VERIFY(copy.id() != key.id());
+    copy = key;
+    CORRADE_VERIFY(copy.id() != key.id());
+  }
+  CORRADE_VERIFY(lifetime.expired());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::OcclusionCullerTest)
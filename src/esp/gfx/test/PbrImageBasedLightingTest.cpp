@@ -0,0 +1,187 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/GL/CubeMapTexture.h>
+#include <Magnum/GL/Framebuffer.h>
+#include <Magnum/GL/OpenGLTester.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/Image.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/PixelFormat.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esp/gfx/CubeMap.h"
+#include "esp/gfx/PbrImageBasedLighting.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+constexpr int EnvironmentSize = 16;
+
+// offsets of the fields of the file header, after its 8-byte magic
+constexpr std::size_t VersionOffset = 8;
+constexpr std::size_t IrradianceMapSizeOffset = 12;
+
+// how a valid file is broken
+const struct {
+  const char* name;
+  void (*corrupt)(std::string& file);
+} InvalidData[]{
+    {"missing", [](std::string& file) { file.clear(); }},
+    {"truncated header", [](std::string& file) { file.resize(10); }},
+    {"truncated", [](std::string& file) { file.pop_back(); }},
+    {"trailing data", [](std::string& file) { file.push_back('\0'); }},
+    {"wrong magic", [](std::string& file) { file[0] = 'x'; }},
+    {"wrong version",
+     [](std::string& file) {
+       std::uint32_t version;
+       std::memcpy(&version, &file[VersionOffset], sizeof(version));
+       ++version;
+       std::memcpy(&file[VersionOffset], &version, sizeof(version));
+     }},
+    {"wrong size",
+     [](std::string& file) {
+       const std::int32_t size = PbrImageBasedLighting::IrradianceMapSize * 2;
+       std::memcpy(&file[IrradianceMapSizeOffset], &size, sizeof(size));
+     }},
+};
+
+// the texels of the color attachment of framebuffer, read as floats like
+// OpenGL ES allows
+std::vector<Mn::Vector4> readTexels(Mn::GL::Framebuffer& framebuffer,
+                                    int size) {
+  Mn::Image2D image = framebuffer.read({{}, Mn::Vector2i{size}},
+                                       Mn::Image2D{Mn::PixelFormat::RGBA32F});
+  std::vector<Mn::Vector4> texels;
+  for (const auto row : image.pixels<Mn::Vector4>()) {
+    for (const Mn::Vector4& texel : row) {
+      texels.push_back(texel);
+    }
+  }
+  return texels;
+}
+
+std::vector<Mn::Vector4> readFace(Mn::GL::CubeMapTexture& texture,
+                                  int face,
+                                  int level,
+                                  int size) {
+  Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{size}}};
+  framebuffer.attachCubeMapTexture(
+      Mn::GL::Framebuffer::ColorAttachment{0}, texture,
+      Mn::GL::CubeMapCoordinate(int(Mn::GL::CubeMapCoordinate::PositiveX) +
+                                face),
+      level);
+  return readTexels(framebuffer, size);
+}
+
+std::vector<Mn::Vector4> readLookupTable(Mn::GL::Texture2D& texture) {
+  const int size = PbrImageBasedLighting::BrdfLookupTableSize;
+  Mn::GL::Framebuffer framebuffer{{{}, Mn::Vector2i{size}}};
+  framebuffer.attachTexture(Mn::GL::Framebuffer::ColorAttachment{0}, texture,
+                            0);
+  return readTexels(framebuffer, size);
+}
+
+// an environment with a color per face
+CubeMap::uptr coloredEnvironment() {
+  CubeMap::uptr environment = CubeMap::create_unique(EnvironmentSize);
+  for (int face = 0; face != 6; ++face) {
+    const Mn::Color4ub color{Mn::UnsignedByte(40 * face), 255,
+                             Mn::UnsignedByte(255 - 40 * face), 255};
+    std::vector<Mn::Color4ub> texels(EnvironmentSize * EnvironmentSize,
+                                     color);
+    environment->getTexture(CubeMap::TextureType::Color)
+        .setSubImage(Mn::GL::CubeMapCoordinate(
+                         int(Mn::GL::CubeMapCoordinate::PositiveX) + face),
+                     0, {},
+                     Mn::ImageView2D{Mn::PixelFormat::RGBA8Unorm,
+                                     Mn::Vector2i{EnvironmentSize},
+                                     Cr::Containers::arrayView(texels)});
+  }
+  return environment;
+}
+
+struct PbrImageBasedLightingTest : Mn::GL::OpenGLTester {
+  explicit PbrImageBasedLightingTest();
+
+  void storeLoad();
+  void loadInvalid();
+
+  std::string filename_;
+};
+
+PbrImageBasedLightingTest::PbrImageBasedLightingTest()
+    : filename_{Cr::Utility::Directory::join(
+          Cr::Utility::Directory::tmp(), "PbrImageBasedLightingTest.ibl")} {
+  addTests({&PbrImageBasedLightingTest::storeLoad});
+  addInstancedTests({&PbrImageBasedLightingTest::loadInvalid},
+                    Cr::Containers::arraySize(InvalidData));
+}
+
+void PbrImageBasedLightingTest::storeLoad() {
+  CubeMap::uptr environment = coloredEnvironment();
+  PbrImageBasedLighting lighting{*environment};
+  CORRADE_VERIFY(lighting.store(filename_));
+
+  PbrImageBasedLighting::uptr loaded = PbrImageBasedLighting::load(filename_);
+  CORRADE_VERIFY(loaded);
+
+  for (int face = 0; face != 6; ++face) {
+    CORRADE_ITERATION(face);
+    const std::vector<Mn::Vector4> irradiance =
+        readFace(lighting.irradianceMap(), face, 0,
+                 PbrImageBasedLighting::IrradianceMapSize);
+    // the environment isn't black, so the comparisons below aren't trivial
+    CORRADE_VERIFY(irradiance[0].y() > 0.0f);
+    CORRADE_VERIFY(readFace(loaded->irradianceMap(), face, 0,
+                            PbrImageBasedLighting::IrradianceMapSize) ==
+                   irradiance);
+    for (int level = 0; level != PbrImageBasedLighting::PrefilteredMapLevels;
+         ++level) {
+      CORRADE_ITERATION(level);
+      const int size = PbrImageBasedLighting::PrefilteredMapSize >> level;
+      CORRADE_VERIFY(readFace(loaded->prefilteredMap(), face, level, size) ==
+                     readFace(lighting.prefilteredMap(), face, level, size));
+    }
+  }
+  CORRADE_VERIFY(readLookupTable(loaded->brdfLookupTable()) ==
+                 readLookupTable(lighting.brdfLookupTable()));
+}
+
+void PbrImageBasedLightingTest::loadInvalid() {
+  auto&& data = InvalidData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+
+  CubeMap::uptr environment = coloredEnvironment();
+  CORRADE_VERIFY(PbrImageBasedLighting{*environment}.store(filename_));
+  CORRADE_VERIFY(PbrImageBasedLighting::load(filename_));
+
+  const std::string corruptFilename = filename_ + ".corrupt";
+  Cr::Utility::Directory::rm(corruptFilename);
+  std::string file = Cr::Utility::Directory::readString(filename_);
+  data.corrupt(file);
+  if (!file.empty()) {
+    CORRADE_VERIFY(Cr::Utility::Directory::writeString(corruptFilename, file));
+  }
+  CORRADE_VERIFY(!PbrImageBasedLighting::load(corruptFilename));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::PbrImageBasedLightingTest)
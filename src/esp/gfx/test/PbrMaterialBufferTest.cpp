@@ -0,0 +1,69 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/TestSuite/Tester.h>
+#include <Magnum/Math/Matrix3.h>
+#include <cstddef>
+
+#include "esp/gfx/PbrMaterialBuffer.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+struct PbrMaterialBufferTest : Cr::TestSuite::Tester {
+  explicit PbrMaterialBufferTest();
+
+  void layout();
+  void uniforms();
+};
+
+PbrMaterialBufferTest::PbrMaterialBufferTest() {
+  addTests({&PbrMaterialBufferTest::layout, &PbrMaterialBufferTest::uniforms});
+}
+
+void PbrMaterialBufferTest::layout() {
+  // the offsets of the members of MaterialBlock in pbr-material.glsl
+  using Uniforms = PbrMaterialBuffer::Uniforms;
+  CORRADE_COMPARE(offsetof(Uniforms, baseColor), 0);
+  CORRADE_COMPARE(offsetof(Uniforms, roughness), 16);
+  CORRADE_COMPARE(offsetof(Uniforms, metallic), 20);
+  CORRADE_COMPARE(offsetof(Uniforms, emissiveColor), 32);
+  CORRADE_COMPARE(offsetof(Uniforms, textureMatrix), 48);
+  CORRADE_COMPARE(offsetof(Uniforms, normalTextureScale), 96);
+  CORRADE_COMPARE(sizeof(Uniforms), 112);
+}
+
+void PbrMaterialBufferTest::uniforms() {
+  PbrMaterialData material;
+  material.baseColor = {0.1f, 0.2f, 0.3f, 0.4f};
+  material.roughness = 0.25f;
+  material.metallic = 0.75f;
+  material.emissiveColor = {1.0f, 0.5f, 0.0f};
+  material.textureMatrix = Mn::Matrix3::translation({2.0f, 3.0f});
+  material.normalTextureScale = 0.5f;
+
+  const PbrMaterialBuffer::Uniforms uniforms =
+      PbrMaterialBuffer::uniforms(material);
+  CORRADE_COMPARE(uniforms.baseColor, material.baseColor);
+  CORRADE_COMPARE(uniforms.roughness, 0.25f);
+  CORRADE_COMPARE(uniforms.metallic, 0.75f);
+  CORRADE_COMPARE(uniforms.emissiveColor, material.emissiveColor);
+  CORRADE_COMPARE(uniforms.textureMatrix[0], (Mn::Vector4{1.0f, 0, 0, 0}));
+  CORRADE_COMPARE(uniforms.textureMatrix[1], (Mn::Vector4{0, 1.0f, 0, 0}));
+  CORRADE_COMPARE(uniforms.textureMatrix[2],
+                  (Mn::Vector4{2.0f, 3.0f, 1.0f, 0}));
+  CORRADE_COMPARE(uniforms.normalTextureScale, 0.5f);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::PbrMaterialBufferTest)
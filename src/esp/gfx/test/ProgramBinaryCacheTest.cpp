@@ -0,0 +1,112 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/Reference.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Magnum/GL/OpenGLTester.h>
+#include <Magnum/GL/Shader.h>
+#include <Magnum/GL/Version.h>
+#include <string>
+
+#include "esp/gfx/ProgramBinaryCache.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+#ifdef MAGNUM_TARGET_GLES
+constexpr Mn::GL::Version Version = Mn::GL::Version::GLES300;
+#else
+constexpr Mn::GL::Version Version = Mn::GL::Version::GL410;
+#endif
+
+// Links through the cache like the shaders of esp::gfx do
+struct CachedShader : Mn::GL::AbstractShaderProgram {
+  explicit CachedShader(const ProgramBinaryCache& cache,
+                        const std::string& color) {
+    Mn::GL::Shader vert{Version, Mn::GL::Shader::Type::Vertex};
+    Mn::GL::Shader frag{Version, Mn::GL::Shader::Type::Fragment};
+    vert.addSource("void main() { gl_Position = vec4(0.0); }\n");
+    frag.addSource(Cr::Utility::formatString(
+        "out highp vec4 color;\nvoid main() {{ color = {}; }}\n", color));
+
+    const std::string key = cache.key({vert, frag});
+    loaded = cache.load(*this, key);
+    if (!loaded) {
+      CORRADE_INTERNAL_ASSERT_OUTPUT(Mn::GL::Shader::compile({vert, frag}));
+      attachShaders({vert, frag});
+      cache.prepareLink(*this);
+      CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+      stored = cache.store(*this, key);
+    }
+  }
+
+  bool loaded = false;
+  bool stored = false;
+};
+
+struct ProgramBinaryCacheTest : Mn::GL::OpenGLTester {
+  explicit ProgramBinaryCacheTest();
+
+  void storeLoad();
+  void disabled();
+
+  std::string directory_;
+};
+
+ProgramBinaryCacheTest::ProgramBinaryCacheTest()
+    : directory_{Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(),
+                                              "ProgramBinaryCacheTest")} {
+  addTests({&ProgramBinaryCacheTest::storeLoad,
+            &ProgramBinaryCacheTest::disabled});
+}
+
+void ProgramBinaryCacheTest::storeLoad() {
+  // start from an empty cache
+  for (const std::string& file : Cr::Utility::Directory::list(
+           directory_, Cr::Utility::Directory::Flag::SkipDotAndDotDot)) {
+    Cr::Utility::Directory::rm(Cr::Utility::Directory::join(directory_, file));
+  }
+  ProgramBinaryCache cache{directory_};
+  if (!cache.isEnabled())
+    CORRADE_SKIP("The driver doesn't support program binaries");
+
+  CachedShader first{cache, "vec4(1.0)"};
+  CORRADE_VERIFY(!first.loaded);
+  CORRADE_VERIFY(first.stored);
+
+  // the same sources are loaded
+  CachedShader second{cache, "vec4(1.0)"};
+  CORRADE_VERIFY(second.loaded);
+
+  // other sources are compiled
+  CachedShader other{cache, "vec4(0.5)"};
+  CORRADE_VERIFY(!other.loaded);
+  CORRADE_COMPARE(
+      Cr::Utility::Directory::list(
+          directory_, Cr::Utility::Directory::Flag::SkipDotAndDotDot)
+          .size(),
+      2);
+}
+
+void ProgramBinaryCacheTest::disabled() {
+  ProgramBinaryCache cache;
+  CORRADE_VERIFY(!cache.isEnabled());
+
+  CachedShader shader{cache, "vec4(1.0)"};
+  CORRADE_VERIFY(!shader.loaded);
+  CORRADE_VERIFY(!shader.stored);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::ProgramBinaryCacheTest)
@@ -0,0 +1,164 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/TestSuite/Tester.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/PixelFormat.h>
+#include <cstdint>
+#include <cstdlib>
+
+#include "esp/gfx/TextureCompression.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+struct TextureCompressionTest : Cr::TestSuite::Tester {
+  explicit TextureCompressionTest();
+
+  void compressGradient();
+  void compressAlpha();
+  void compressOpaqueAlpha();
+  void compressEdgeBlocks();
+};
+
+TextureCompressionTest::TextureCompressionTest() {
+  addTests({&TextureCompressionTest::compressGradient,
+            &TextureCompressionTest::compressAlpha,
+            &TextureCompressionTest::compressOpaqueAlpha,
+            &TextureCompressionTest::compressEdgeBlocks});
+}
+
+Cr::Containers::Array<char> pixels(Mn::PixelFormat format,
+                                   const Mn::Vector2i& size,
+                                   const Mn::Color4ub& color) {
+  const std::size_t channels = Mn::pixelSize(format);
+  Cr::Containers::Array<char> data{Cr::Containers::NoInit,
+                                   std::size_t(size.product()) * channels};
+  for (std::size_t i = 0; i != data.size(); ++i) {
+    data[i] = char(color[i % channels]);
+  }
+  return data;
+}
+
+Mn::Trade::ImageData2D image(Mn::PixelFormat format,
+                             const Mn::Vector2i& size,
+                             Cr::Containers::Array<char>&& data) {
+  return Mn::Trade::ImageData2D{Mn::PixelStorage{}.setAlignment(1), format,
+                                size, std::move(data)};
+}
+
+Mn::Trade::ImageData2D image(Mn::PixelFormat format,
+                             const Mn::Vector2i& size,
+                             const Mn::Color4ub& color) {
+  return image(format, size, pixels(format, size, color));
+}
+
+// The color of pixel @p i of the BC1 block at @p block
+Mn::Vector3i decodeBc1(const char* block, int i) {
+  const auto byte = [&](int b) { return int(Mn::UnsignedByte(block[b])); };
+  const int end0 = byte(0) | byte(1) << 8;
+  const int end1 = byte(2) | byte(3) << 8;
+  const auto expand = [](int c) {
+    const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    return Mn::Vector3i{r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2};
+  };
+  const Mn::Vector3i color0 = expand(end0);
+  const Mn::Vector3i color1 = expand(end1);
+  const std::uint32_t indices =
+      byte(4) | byte(5) << 8 | byte(6) << 16 | std::uint32_t(byte(7)) << 24;
+  switch ((indices >> 2 * i) & 3) {
+    case 0:
+      return color0;
+    case 1:
+      return color1;
+    case 2:
+      return (2 * color0 + color1) / 3;
+    default:
+      return (color0 + 2 * color1) / 3;
+  }
+}
+
+void TextureCompressionTest::compressGradient() {
+  // a horizontal gray ramp fits the four colors of the palette
+  Cr::Containers::Array<char> data =
+      pixels(Mn::PixelFormat::RGB8Unorm, {4, 4}, {});
+  for (std::size_t i = 0; i != data.size(); ++i) {
+    data[i] = char(i / 3 % 4 * 85);
+  }
+  Mn::Trade::ImageData2D compressed = compressTextureImage(
+      image(Mn::PixelFormat::RGB8Unorm, {4, 4}, std::move(data)));
+  CORRADE_VERIFY(compressed.isCompressed());
+  CORRADE_COMPARE(compressed.compressedFormat(),
+                  Mn::CompressedPixelFormat::Bc1RGBUnorm);
+  CORRADE_COMPARE(compressed.size(), (Mn::Vector2i{4, 4}));
+  CORRADE_COMPARE(compressed.data().size(), 8);
+  // the ends are exact in 5:6:5 for black and white
+  CORRADE_COMPARE(Mn::UnsignedByte(compressed.data()[0]), 0xff);
+  CORRADE_COMPARE(Mn::UnsignedByte(compressed.data()[1]), 0xff);
+  for (int i = 0; i != 16; ++i) {
+    CORRADE_ITERATION(i);
+    const Mn::Vector3i decoded = decodeBc1(compressed.data().data(), i);
+    for (int c = 0; c != 3; ++c) {
+      CORRADE_VERIFY(std::abs(decoded[c] - (i % 4) * 85) <= 2);
+    }
+  }
+}
+
+void TextureCompressionTest::compressAlpha() {
+  Cr::Containers::Array<char> data =
+      pixels(Mn::PixelFormat::RGBA8Unorm, {4, 4}, {10, 20, 30, 255});
+  data[3] = char(0);
+  Mn::Trade::ImageData2D compressed = compressTextureImage(
+      image(Mn::PixelFormat::RGBA8Unorm, {4, 4}, std::move(data)));
+  CORRADE_COMPARE(compressed.compressedFormat(),
+                  Mn::CompressedPixelFormat::Bc3RGBAUnorm);
+  CORRADE_COMPARE(compressed.data().size(), 16);
+  // the alpha ends, the first pixel at the second end, the others at the
+  // first
+  CORRADE_COMPARE(Mn::UnsignedByte(compressed.data()[0]), 255);
+  CORRADE_COMPARE(Mn::UnsignedByte(compressed.data()[1]), 0);
+  CORRADE_COMPARE(Mn::UnsignedByte(compressed.data()[2]), 1);
+  CORRADE_COMPARE(Mn::UnsignedByte(compressed.data()[3]), 0);
+  // a single color is both ends
+  const Mn::Vector3i decoded = decodeBc1(compressed.data().data() + 8, 0);
+  CORRADE_VERIFY(Mn::Math::abs(decoded - Mn::Vector3i{10, 20, 30}).max() <=
+                 4);
+}
+
+void TextureCompressionTest::compressOpaqueAlpha() {
+  Mn::Trade::ImageData2D source =
+      image(Mn::PixelFormat::RGBA8Unorm, {4, 4}, {10, 20, 30, 255});
+  CORRADE_COMPARE(compressTextureImage(source).compressedFormat(),
+                  Mn::CompressedPixelFormat::Bc1RGBUnorm);
+  CORRADE_COMPARE(compressTextureImage(source, true).compressedFormat(),
+                  Mn::CompressedPixelFormat::Bc3RGBAUnorm);
+}
+
+void TextureCompressionTest::compressEdgeBlocks() {
+  Mn::Trade::ImageData2D compressed = compressTextureImage(
+      image(Mn::PixelFormat::RGB8Unorm, {5, 3}, {255, 0, 0, 255}));
+  CORRADE_COMPARE(compressed.size(), (Mn::Vector2i{5, 3}));
+  // two blocks, the second repeating the last column
+  CORRADE_COMPARE(compressed.data().size(), 16);
+  for (int i = 0; i != 16; ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(decodeBc1(compressed.data().data() + 8, i),
+                    (Mn::Vector3i{255, 0, 0}));
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::TextureCompressionTest)
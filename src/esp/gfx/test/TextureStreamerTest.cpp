@@ -0,0 +1,85 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/TestSuite/Tester.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+#include <algorithm>
+
+#include "esp/gfx/TextureStreamer.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace test {
+namespace {
+
+struct TextureStreamerTest : Cr::TestSuite::Tester {
+  explicit TextureStreamerTest();
+
+  void generateMipLevels();
+  void generateMipLevelsNonSquare();
+  void generateMipLevelsUnsupported();
+};
+
+TextureStreamerTest::TextureStreamerTest() {
+  addTests({&TextureStreamerTest::generateMipLevels,
+            &TextureStreamerTest::generateMipLevelsNonSquare,
+            &TextureStreamerTest::generateMipLevelsUnsupported});
+}
+
+Mn::Trade::ImageData2D image(Mn::PixelFormat format,
+                             const Mn::Vector2i& size,
+                             std::initializer_list<char> pixels) {
+  Cr::Containers::Array<char> data{Cr::Containers::NoInit, pixels.size()};
+  std::copy(pixels.begin(), pixels.end(), data.begin());
+  return Mn::Trade::ImageData2D{Mn::PixelStorage{}.setAlignment(1), format,
+                                size, std::move(data)};
+}
+
+void TextureStreamerTest::generateMipLevels() {
+  std::vector<Mn::Trade::ImageData2D> levels =
+      TextureStreamer::generateMipLevels(
+          image(Mn::PixelFormat::RG8Unorm, {2, 2},
+                {0, 100, 10, 100, 20, 100, char(200), 101}));
+  CORRADE_COMPARE(levels.size(), 2);
+  CORRADE_COMPARE(levels[0].size(), (Mn::Vector2i{2, 2}));
+  CORRADE_COMPARE(levels[1].size(), (Mn::Vector2i{1, 1}));
+  CORRADE_COMPARE(levels[1].format(), Mn::PixelFormat::RG8Unorm);
+  // rounded to nearest
+  CORRADE_COMPARE(Mn::UnsignedByte(levels[1].data()[0]), 58);
+  CORRADE_COMPARE(Mn::UnsignedByte(levels[1].data()[1]), 100);
+}
+
+void TextureStreamerTest::generateMipLevelsNonSquare() {
+  std::vector<Mn::Trade::ImageData2D> levels =
+      TextureStreamer::generateMipLevels(
+          image(Mn::PixelFormat::R8Unorm, {4, 1}, {0, 4, 8, 12}));
+  CORRADE_COMPARE(levels.size(), 3);
+  CORRADE_COMPARE(levels[1].size(), (Mn::Vector2i{2, 1}));
+  CORRADE_COMPARE(levels[2].size(), (Mn::Vector2i{1, 1}));
+  // the single row is clamped to the edge
+  CORRADE_COMPARE(Mn::UnsignedByte(levels[1].data()[0]), 2);
+  CORRADE_COMPARE(Mn::UnsignedByte(levels[1].data()[1]), 10);
+  CORRADE_COMPARE(Mn::UnsignedByte(levels[2].data()[0]), 6);
+}
+
+void TextureStreamerTest::generateMipLevelsUnsupported() {
+  Cr::Containers::Array<char> data{Cr::Containers::ValueInit, 2 * 2 * 4};
+  std::vector<Mn::Trade::ImageData2D> levels =
+      TextureStreamer::generateMipLevels(Mn::Trade::ImageData2D{
+          Mn::PixelFormat::R32F, {2, 2}, std::move(data)});
+  CORRADE_COMPARE(levels.size(), 1);
+  CORRADE_COMPARE(levels[0].format(), Mn::PixelFormat::R32F);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace gfx
+}  // namespace esp
+
+CORRADE_TEST_MAIN(esp::gfx::test::TextureStreamerTest)
@@ -5,12 +5,16 @@
 #include "esp/io/json.h"
 
 #include <Corrade/Utility/String.h>
-#include <rapidjson/filereadstream.h>
 #include <rapidjson/filewritestream.h>
 #include <rapidjson/prettywriter.h>
+#include <rapidjson/reader.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
 
+#include "esp/core/MappedFile.h"
 #include "esp/core/esp.h"
 
 namespace Cr = Corrade;
@@ -18,7 +22,165 @@ namespace Cr = Corrade;
 namespace esp {
 namespace io {
 
-bool writeJsonToFile(const JsonDocument& document,
+namespace {
+
+/*
+ * The contents of @p file followed by a null terminator, as in situ parsing
+ * needs, empty if the file is missing or empty. The file is mapped if the
+ * rest of its last page, which the kernel fills with zeros, provides the
+ * terminator, and copied otherwise.
+ */
+Cr::Containers::Array<char> readSource(const std::string& file) {
+  static const std::size_t pageSize = ::sysconf(_SC_PAGESIZE);
+  Cr::Containers::Array<char> mapped = core::mapFile(file);
+  if (mapped.empty() || mapped.size() % pageSize != 0) {
+    return mapped;
+  }
+  Cr::Containers::Array<char> copy{Cr::Containers::NoInit,
+                                   mapped.size() + 1};
+  std::memcpy(copy.data(), mapped.data(), mapped.size());
+  copy[mapped.size()] = '\0';
+  return copy;
+}
+
+/*
+ * Builds the elements of the array member of the root object like a
+ * document does, on a stack of values, and hands them to the consumer as
+ * they're complete. Events outside of the array are only counted.
+ */
+class ArrayElementHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>,
+                                          ArrayElementHandler> {
+ public:
+  ArrayElementHandler(
+      const char* key,
+      const std::function<bool(const JsonGenericValue&)>& consume,
+      JsonAllocator& allocator)
+      : key_{key},
+        keyLength_{std::strlen(key)},
+        consume_(consume),
+        allocator_(allocator) {}
+
+  bool stopped() const { return stopped_; }
+
+  bool Null() { return scalar(JsonGenericValue{}); }
+  bool Bool(bool b) { return scalar(JsonGenericValue{b}); }
+  bool Int(int i) { return scalar(JsonGenericValue{i}); }
+  bool Uint(unsigned i) { return scalar(JsonGenericValue{i}); }
+  bool Int64(int64_t i) { return scalar(JsonGenericValue{i}); }
+  bool Uint64(uint64_t i) { return scalar(JsonGenericValue{i}); }
+  bool Double(double d) { return scalar(JsonGenericValue{d}); }
+  bool String(const char* str, rapidjson::SizeType length, bool copy) {
+    if (!inArray_) {
+      return true;
+    }
+    // in situ, the strings stay in the file
+    return push(copy ? JsonGenericValue{str, length, allocator_}
+                     : JsonGenericValue{rapidjson::StringRef(str, length)});
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+    if (elementDepth_ > 0) {
+      return String(str, length, copy);
+    }
+    if (depth_ == 1) {
+      matchedKey_ = length == keyLength_ && std::memcmp(str, key_, length) == 0;
+    }
+    return true;
+  }
+
+  bool StartObject() { return start(); }
+  bool StartArray() {
+    if (!inArray_ && depth_ == 1 && matchedKey_) {
+      inArray_ = true;
+      return true;
+    }
+    return start();
+  }
+
+  bool EndObject(rapidjson::SizeType memberCount) {
+    if (elementDepth_ == 0) {
+      --depth_;
+      return true;
+    }
+    --elementDepth_;
+    JsonGenericValue object{rapidjson::kObjectType};
+    const std::size_t first = stack_.size() - 2 * memberCount;
+    for (std::size_t i = first; i != stack_.size(); i += 2) {
+      object.AddMember(stack_[i], stack_[i + 1], allocator_);
+    }
+    stack_.erase(stack_.begin() + first, stack_.end());
+    return push(std::move(object));
+  }
+  bool EndArray(rapidjson::SizeType elementCount) {
+    if (elementDepth_ == 0) {
+      if (inArray_) {
+        inArray_ = false;
+        matchedKey_ = false;
+      } else {
+        --depth_;
+      }
+      return true;
+    }
+    --elementDepth_;
+    JsonGenericValue array{rapidjson::kArrayType};
+    array.Reserve(elementCount, allocator_);
+    const std::size_t first = stack_.size() - elementCount;
+    for (std::size_t i = first; i != stack_.size(); ++i) {
+      array.PushBack(stack_[i], allocator_);
+    }
+    stack_.erase(stack_.begin() + first, stack_.end());
+    return push(std::move(array));
+  }
+
+ private:
+  bool start() {
+    if (inArray_) {
+      ++elementDepth_;
+    } else {
+      ++depth_;
+    }
+    return true;
+  }
+
+  bool scalar(JsonGenericValue&& value) {
+    return !inArray_ || push(std::move(value));
+  }
+
+  // a complete value, either an element or a part of one
+  bool push(JsonGenericValue&& value) {
+    if (elementDepth_ > 0) {
+      stack_.push_back(std::move(value));
+      return true;
+    }
+    if (!consume_(value)) {
+      stopped_ = true;
+      return false;
+    }
+    // nothing references the pool anymore
+    allocator_.Clear();
+    return true;
+  }
+
+  const char* key_;
+  std::size_t keyLength_;
+  const std::function<bool(const JsonGenericValue&)>& consume_;
+  JsonAllocator& allocator_;
+  std::vector<JsonGenericValue> stack_;
+  // the nesting outside of the array, 1 in the root object
+  int depth_ = 0;
+  // the nesting inside of the current element
+  int elementDepth_ = 0;
+  bool matchedKey_ = false;
+  bool inArray_ = false;
+  bool stopped_ = false;
+};
+
+// enough for the elements of usual sizes not to allocate
+constexpr std::size_t ElementPoolSize = 256 * 1024;
+
+}  // namespace
+
+bool writeJsonToFile(const JsonGenericValue& document,
                      const std::string& filepath) {
   assert(!filepath.empty());
   std::string outFilePath = filepath;
@@ -42,12 +204,14 @@ bool writeJsonToFile(const JsonDocument& document,
 }
 
 JsonDocument parseJsonFile(const std::string& file) {
-  FILE* pFile = fopen(file.c_str(), "rb");
-  char buffer[65536];
-  rapidjson::FileReadStream is(pFile, buffer, sizeof(buffer));
   JsonDocument d;
-  d.ParseStream<0, rapidjson::UTF8<>, rapidjson::FileReadStream>(is);
-  fclose(pFile);
+  d.source_ = readSource(file);
+  if (d.source_.empty()) {
+    LOG(ERROR) << "Cannot read " << file;
+    throw std::runtime_error("JSON read error");
+  }
+  // the strings of the document point into the source
+  d.ParseInsitu(d.source_.data());
 
   if (d.HasParseError()) {
     LOG(ERROR) << "Parse error reading " << file << " Error code "
@@ -57,6 +221,34 @@ JsonDocument parseJsonFile(const std::string& file) {
   return d;
 }
 
+bool forEachJsonArrayElement(
+    const std::string& file,
+    const char* key,
+    const std::function<bool(const JsonGenericValue&)>& consume) {
+  Cr::Containers::Array<char> source = readSource(file);
+  if (source.empty()) {
+    LOG(ERROR) << "Cannot read " << file;
+    return false;
+  }
+
+  thread_local std::unique_ptr<char[]> poolBuffer{new char[ElementPoolSize]};
+  JsonAllocator allocator{poolBuffer.get(), ElementPoolSize};
+  ArrayElementHandler handler{key, consume, allocator};
+  rapidjson::Reader reader;
+  rapidjson::InsituStringStream stream{source.data()};
+  const rapidjson::ParseResult result =
+      reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+  if (handler.stopped()) {
+    return false;
+  }
+  if (result.IsError()) {
+    LOG(ERROR) << "Parse error reading " << file << " Error code "
+               << result.Code() << " at " << result.Offset();
+    return false;
+  }
+  return true;
+}
+
 JsonDocument parseJsonString(const std::string& jsonString) {
   JsonDocument d;
   d.Parse(jsonString.c_str());
@@ -69,7 +261,7 @@ JsonDocument parseJsonString(const std::string& jsonString) {
   return d;
 }
 
-std::string jsonToString(const JsonDocument& d) {
+std::string jsonToString(const JsonGenericValue& d) {
   rapidjson::StringBuffer buffer{};
   rapidjson::Writer<rapidjson::StringBuffer> writer{buffer};
   d.Accept(writer);
@@ -12,6 +12,7 @@
 #include <rapidjson/document.h>
 #include "esp/core/esp.h"
 
+#include <Corrade/Containers/Array.h>
 #include <functional>
 #include <string>
 #include <vector>
@@ -23,19 +24,62 @@
 namespace esp {
 namespace io {
 
-typedef rapidjson::Document JsonDocument;
+/**
+ * @brief A JSON document, keeping the file it was parsed from
+ *
+ * @ref parseJsonFile() parses the mapped file in situ, so the strings of the
+ * document point into the file instead of being copied.
+ */
+class JsonDocument : public rapidjson::Document {
+ public:
+  JsonDocument() = default;
+  JsonDocument(JsonDocument&&) = default;
+  JsonDocument& operator=(JsonDocument&&) = default;
+
+ private:
+  friend JsonDocument parseJsonFile(const std::string& file);
 
-//! Write a JsonDocument to file
-bool writeJsonToFile(const JsonDocument& document, const std::string& file);
+  Corrade::Containers::Array<char> source_;
+};
 
-//! Parse JSON file and return as JsonDocument object
+//! Write a JsonDocument or value to file
+bool writeJsonToFile(const JsonGenericValue& document,
+                     const std::string& file);
+
+/**
+ * @brief Parse JSON file and return as JsonDocument object
+ *
+ * The file is memory-mapped and parsed in situ.
+ * @throws std::runtime_error if the file can't be read or parsed
+ */
 JsonDocument parseJsonFile(const std::string& file);
 
+/**
+ * @brief Parse the elements of the array member @p key of the root object of
+ * JSON file @p file one at a time, without a document of the whole file
+ *
+ * For large files of many records, e.g. the keyframes of a replay: the file
+ * is memory-mapped and parsed in situ with a SAX reader, skipping the other
+ * members, and only the element being read is built as a value, in a memory
+ * pool reused for every element and by the later calls on the same thread.
+ *
+ * @param file    The file
+ * @param key     The member of the root object, e.g. `"keyframes"`
+ * @param consume Called with every element in order, the element and its
+ * strings are only valid during the call. Return false to stop.
+ * @return false if the file can't be read or parsed or @p consume stopped,
+ * true if it has no such member
+ */
+bool forEachJsonArrayElement(
+    const std::string& file,
+    const char* key,
+    const std::function<bool(const JsonGenericValue&)>& consume);
+
 //! Parse JSON string and return as JsonDocument object
 JsonDocument parseJsonString(const std::string& jsonString);
 
-//! Return string representation of given JsonDocument
-std::string jsonToString(const JsonDocument& d);
+//! Return string representation of given JsonDocument or value
+std::string jsonToString(const JsonGenericValue& d);
 
 //! Return Vec3f coordinates representation of given JsonObject of array type
 esp::vec3f jsonToVec3f(const JsonGenericValue& jsonArray);
@@ -0,0 +1,235 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "DatasetIndex.h"
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "esp/core/MappedFile.h"
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace metadata {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 'd', 's', 'i', 'd', 'x'};
+constexpr std::uint32_t Version = 1;
+
+class Writer {
+ public:
+  template <class T>
+  void value(const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    data_.insert(data_.end(), bytes, bytes + sizeof(T));
+  }
+
+  void string(const std::string& string) {
+    value(std::uint32_t(string.size()));
+    data_.insert(data_.end(), string.begin(), string.end());
+  }
+
+  const std::vector<char>& data() const { return data_; }
+
+ private:
+  std::vector<char> data_;
+};
+
+// Reads the fields back, failing for good at the first one past the end
+class Reader {
+ public:
+  explicit Reader(Cr::Containers::ArrayView<const char> data) : data_{data} {}
+
+  bool failed() const { return failed_; }
+
+  bool atEnd() const { return offset_ == data_.size(); }
+
+  template <class T>
+  T value() {
+    T value{};
+    if (data_.size() - offset_ < sizeof(T)) {
+      failed_ = true;
+      return value;
+    }
+    std::memcpy(&value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  // a number of elements of at least elementSize bytes each, 0 if there
+  // aren't as many bytes left, so that invalid files allocate nothing large
+  std::uint32_t count(std::size_t elementSize) {
+    const std::uint32_t count = value<std::uint32_t>();
+    if (count > (data_.size() - offset_) / elementSize) {
+      failed_ = true;
+      return 0;
+    }
+    return count;
+  }
+
+  std::string string() {
+    const std::uint32_t size = count(1);
+    std::string string{data_.data() + offset_, size};
+    offset_ += size;
+    return string;
+  }
+
+ private:
+  Cr::Containers::ArrayView<const char> data_;
+  std::size_t offset_ = 0;
+  bool failed_ = false;
+};
+
+std::string entryKey(const std::string& path, const std::string& configFile) {
+  return path + '\0' + configFile;
+}
+
+}  // namespace
+
+DatasetIndex::Stamp DatasetIndex::stamp(const std::string& filename) {
+  Stamp stamp;
+  struct stat status;
+  if (::stat(filename.c_str(), &status) == 0) {
+    stamp.exists = true;
+    stamp.size = status.st_size;
+    stamp.modified = status.st_mtime;
+  }
+  return stamp;
+}
+
+bool DatasetIndex::load(const std::string& filename) {
+  const Cr::Containers::Array<char> file = core::mapFile(filename);
+  if (file.size() < sizeof(Magic) + sizeof(Version) ||
+      std::memcmp(file.data(), Magic, sizeof(Magic)) != 0) {
+    return false;
+  }
+  Reader reader{file.suffix(sizeof(Magic))};
+  if (reader.value<std::uint32_t>() != Version) {
+    return false;
+  }
+  const auto readStamp = [&reader]() {
+    Stamp stamp;
+    stamp.exists = reader.value<std::uint8_t>() != 0;
+    stamp.size = reader.value<std::uint64_t>();
+    stamp.modified = reader.value<std::int64_t>();
+    return stamp;
+  };
+
+  std::map<std::string, Entry> entries;
+  const std::uint32_t numEntries = reader.count(1);
+  for (std::uint32_t i = 0; i < numEntries && !reader.failed(); ++i) {
+    const std::string key = reader.string();
+    Entry& entry = entries[key];
+    entry.path = readStamp();
+    entry.configFile = readStamp();
+    const std::uint32_t numConfigs = reader.count(1);
+    for (std::uint32_t j = 0; j < numConfigs && !reader.failed(); ++j) {
+      entry.configs.push_back(reader.string());
+      entry.configStamps.push_back(readStamp());
+    }
+  }
+  if (reader.failed() || !reader.atEnd()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock{mutex_};
+  entries_ = std::move(entries);
+  return true;
+}
+
+bool DatasetIndex::save(const std::string& filename) const {
+  Writer writer;
+  for (const char c : Magic) {
+    writer.value(c);
+  }
+  writer.value(Version);
+  const auto writeStamp = [&writer](const Stamp& stamp) {
+    writer.value(std::uint8_t(stamp.exists));
+    writer.value(stamp.size);
+    writer.value(stamp.modified);
+  };
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    writer.value(std::uint32_t(entries_.size()));
+    for (const auto& keyEntry : entries_) {
+      const Entry& entry = keyEntry.second;
+      writer.string(keyEntry.first);
+      writeStamp(entry.path);
+      writeStamp(entry.configFile);
+      writer.value(std::uint32_t(entry.configs.size()));
+      for (std::size_t i = 0; i < entry.configs.size(); ++i) {
+        writer.string(entry.configs[i]);
+        writeStamp(entry.configStamps[i]);
+      }
+    }
+  }
+  return core::writeFileAtomically(
+      filename, {writer.data().data(), writer.data().size()});
+}
+
+bool DatasetIndex::find(const std::string& path,
+                        const std::string& configFile,
+                        std::vector<std::string>& configs) const {
+  Stamp pathStamp, configFileStamp;
+  std::vector<std::string> found;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto entry = entries_.find(entryKey(path, configFile));
+    if (entry == entries_.end()) {
+      ++misses_;
+      return false;
+    }
+    pathStamp = entry->second.path;
+    configFileStamp = entry->second.configFile;
+    found = entry->second.configs;
+  }
+  // the stats are the slow part on network filesystems, done without the
+  // lock so that the paths of a dataset are checked in parallel
+  if (!(stamp(path) == pathStamp) ||
+      !(stamp(configFile) == configFileStamp)) {
+    ++misses_;
+    return false;
+  }
+  configs.insert(configs.end(), found.begin(), found.end());
+  return true;
+}
+
+void DatasetIndex::record(const std::string& path,
+                          const std::string& configFile,
+                          const std::vector<std::string>& configs) {
+  Entry entry;
+  entry.path = stamp(path);
+  entry.configFile = stamp(configFile);
+  entry.configs = configs;
+  for (const std::string& config : configs) {
+    entry.configStamps.push_back(stamp(config));
+  }
+  std::lock_guard<std::mutex> lock{mutex_};
+  entries_[entryKey(path, configFile)] = std::move(entry);
+}
+
+std::size_t DatasetIndex::size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return entries_.size();
+}
+
+std::vector<std::string> DatasetIndex::changedConfigs() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::vector<std::string> changed;
+  for (const auto& keyEntry : entries_) {
+    const Entry& entry = keyEntry.second;
+    for (std::size_t i = 0; i < entry.configs.size(); ++i) {
+      if (!(stamp(entry.configs[i]) == entry.configStamps[i])) {
+        changed.push_back(entry.configs[i]);
+      }
+    }
+  }
+  return changed;
+}
+
+}  // namespace metadata
+}  // namespace esp
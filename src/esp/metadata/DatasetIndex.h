@@ -0,0 +1,135 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_METADATA_DATASETINDEX_H_
+#define ESP_METADATA_DATASETINDEX_H_
+
+/** @file
+ * @brief Class @ref esp::metadata::DatasetIndex
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace metadata {
+
+/**
+ * @brief The config files found in the search paths of a dataset, stored in
+ * a file so that loading the dataset doesn't list its directories
+ *
+ * An entry is the result of a search for the configs of one type in one
+ * path of a dataset config, i.e. the path itself if it names a config and
+ * the configs of that type in it if it is a directory. The configs are the
+ * handles their templates are registered under. An entry is used as long as
+ * the path and the config it names have the size and modification time they
+ * had when it was recorded, which is two stats instead of a directory listing
+ * and the stats of its files. This catches configs added, removed or renamed
+ * in the directories searched, which changes their modification time, not
+ * configs edited in place, which are read anew anyway.
+ *
+ * The index isn't updated as the dataset changes: stale entries are searched
+ * again on every load until the index is rebuilt, with
+ * @ref managers::SceneDatasetAttributesManager::buildDatasetIndex() or the
+ * `rebuild_dataset_index` task of datatool.
+ */
+class DatasetIndex {
+ public:
+  /** @brief The index of the dataset config @p datasetFilename */
+  static std::string filenameFor(const std::string& datasetFilename) {
+    return datasetFilename + ".index";
+  }
+
+  /**
+   * @brief Load the entries of the index file @p filename
+   * @return false, leaving the index empty, if the file is missing or
+   * invalid
+   */
+  bool load(const std::string& filename);
+
+  /**
+   * @brief Save the entries to @p filename, written atomically so that
+   * processes loading the dataset concurrently see a complete index
+   */
+  bool save(const std::string& filename) const;
+
+  /**
+   * @brief Append the configs found for @p path to @p configs, if its entry
+   * is up to date
+   * @param path the search path, absolute
+   * @param configFile the config @p path names, with the extension of the
+   * type of config searched for
+   * @param configs (out) the configs found
+   *
+   * Thread-safe. Lookups of paths with a stale entry or none are counted in
+   * @ref numMisses().
+   */
+  bool find(const std::string& path,
+            const std::string& configFile,
+            std::vector<std::string>& configs) const;
+
+  /**
+   * @brief Record the @p configs found for @p path by searching the
+   * filesystem, replacing its entry if any
+   *
+   * Thread-safe.
+   */
+  void record(const std::string& path,
+              const std::string& configFile,
+              const std::vector<std::string>& configs);
+
+  /** @brief The number of entries */
+  std::size_t size() const;
+
+  /** @brief The number of lookups which found no up-to-date entry */
+  std::size_t numMisses() const { return misses_; }
+
+  /**
+   * @brief The configs of all the entries whose size or modification time
+   * changed since they were recorded, or which were removed
+   *
+   * Stats every config, for a full check of an index.
+   */
+  std::vector<std::string> changedConfigs() const;
+
+ private:
+  struct Stamp {
+    bool exists = false;
+    std::uint64_t size = 0;
+    std::int64_t modified = 0;
+
+    bool operator==(const Stamp& other) const {
+      return exists == other.exists && size == other.size &&
+             modified == other.modified;
+    }
+  };
+
+  static Stamp stamp(const std::string& filename);
+
+  struct Entry {
+    Stamp path;
+    Stamp configFile;
+    std::vector<std::string> configs;
+    std::vector<Stamp> configStamps;
+  };
+
+  // by search path and config file, separated by a null character, ordered
+  // so that the same searches save the same file
+  std::map<std::string, Entry> entries_;
+  mutable std::mutex mutex_;
+  mutable std::atomic<std::size_t> misses_{0};
+
+  ESP_SMART_POINTERS(DatasetIndex)
+};
+
+}  // namespace metadata
+}  // namespace esp
+
+#endif  // ESP_METADATA_DATASETINDEX_H_
@@ -64,6 +64,46 @@ class MetadataMediator {
    */
   std::string getActiveSceneDatasetName() const { return activeSceneDataset_; }
 
+  /**
+   * @brief Set whether the datasets loaded from now on only parse their object
+   * configs when the templates are first used, for datasets of many objects.
+   * See @ref managers::ObjectAttributesManager::setLazyLoading.
+   */
+  void setLazyObjectLoading(bool lazyObjectLoading) {
+    sceneDatasetAttributesManager_->setLazyObjectLoading(lazyObjectLoading);
+  }
+
+  /**
+   * @brief Whether the datasets loaded parse their object configs lazily.
+   */
+  bool getLazyObjectLoading() const {
+    return sceneDatasetAttributesManager_->getLazyObjectLoading();
+  }
+
+  /**
+   * @brief Set whether the datasets loaded from now on use the index next to
+   * their config instead of searching their paths for configs. See
+   * @ref DatasetIndex.
+   */
+  void setUseDatasetIndex(bool useDatasetIndex) {
+    sceneDatasetAttributesManager_->setUseDatasetIndex(useDatasetIndex);
+  }
+
+  /**
+   * @brief Whether the datasets loaded use the index next to their config.
+   */
+  bool getUseDatasetIndex() const {
+    return sceneDatasetAttributesManager_->getUseDatasetIndex();
+  }
+
+  /**
+   * @brief Rebuild the index of the dataset config @p sceneDatasetName. See
+   * @ref managers::SceneDatasetAttributesManager::buildDatasetIndex.
+   */
+  bool buildDatasetIndex(const std::string& sceneDatasetName) {
+    return sceneDatasetAttributesManager_->buildDatasetIndex(sceneDatasetName);
+  }
+
   /**
    * @brief Return manager for construction and access to asset attributes for
    * current dataset.
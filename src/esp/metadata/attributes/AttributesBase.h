@@ -68,11 +68,11 @@ class AbstractAttributes : public esp::core::AbstractManagedObject,
    * instantiate Primitives.  Names in getter/setters chosen to match parameter
    * name expectations in PrimitiveImporter.
    *
-   * @return a reference to the underlying configuration group for this
-   * attributes object
+   * @return a configuration group of the values of this attributes object,
+   * as strings
    */
-  const Corrade::Utility::ConfigurationGroup& getConfigGroup() const {
-    return cfg;
+  Corrade::Utility::ConfigurationGroup getConfigGroup() const {
+    return getConfigurationGroup();
   }
 
  protected:
@@ -53,6 +53,11 @@ ObjectAttributes::ObjectAttributes(const std::string& handle)
 
   setBoundingBoxCollisions(false);
   setJoinCollisionMeshes(true);
+  setMaxHullVertices(0);
+  setUseConvexDecomposition(false);
+  setCollisionGroup(0);
+  setCollisionMask(0);
+  setStaticEnvironmentOnly(false);
   setRequiresLighting(true);
   setIsVisible(true);
   setSemanticId(0);
@@ -94,7 +94,7 @@ class AbstractObjectAttributes : public AbstractAttributes {
   void setRenderAssetType(int renderAssetType) {
     setInt("render_asset_type", renderAssetType);
   }
-  int getRenderAssetType() { return getInt("render_asset_type"); }
+  int getRenderAssetType() const { return getInt("render_asset_type"); }
 
   void setRenderAssetHandle(const std::string& renderAssetHandle) {
     setString("render_asset", renderAssetHandle);
@@ -127,7 +127,7 @@ class AbstractObjectAttributes : public AbstractAttributes {
   void setCollisionAssetType(int collisionAssetType) {
     setInt("collision_asset_type", collisionAssetType);
   }
-  int getCollisionAssetType() { return getInt("collision_asset_type"); }
+  int getCollisionAssetType() const { return getInt("collision_asset_type"); }
 
   void setCollisionAssetSize(const Magnum::Vector3& collisionAssetSize) {
     setVec3("collision_asset_size", collisionAssetSize);
@@ -231,6 +231,42 @@ class ObjectAttributes : public AbstractObjectAttributes {
     return getBool("join_collision_meshes");
   }
 
+  // if positive, simplify each convex collision hull of the object to at
+  // most this many vertices, 0 keeps all the vertices of the hulls
+  void setMaxHullVertices(int maxHullVertices) {
+    setInt("max_hull_vertices", maxHullVertices);
+  }
+  int getMaxHullVertices() const { return getInt("max_hull_vertices"); }
+
+  // if true approximate the collision asset by a convex decomposition, cached
+  // next to the asset, instead of one convex per mesh or joined meshes
+  void setUseConvexDecomposition(bool useConvexDecomposition) {
+    setBool("use_convex_decomposition", useConvexDecomposition);
+  }
+  bool getUseConvexDecomposition() const {
+    return getBool("use_convex_decomposition");
+  }
+
+  // the physics::CollisionGroup of the object and the groups it collides
+  // with, 0 for the default of its motion type
+  void setCollisionGroup(int collisionGroup) {
+    setInt("collision_group", collisionGroup);
+  }
+  int getCollisionGroup() const { return getInt("collision_group"); }
+  void setCollisionMask(int collisionMask) {
+    setInt("collision_mask", collisionMask);
+  }
+  int getCollisionMask() const { return getInt("collision_mask"); }
+
+  // if true the object only collides with the static environment, i.e. in
+  // the DEBRIS group, unless a collision group or mask is set
+  void setStaticEnvironmentOnly(bool staticEnvironmentOnly) {
+    setBool("static_environment_only", staticEnvironmentOnly);
+  }
+  bool getStaticEnvironmentOnly() const {
+    return getBool("static_environment_only");
+  }
+
   /**
    * @brief If not visible can add dynamic non-rendered object into a scene
    * object.  If is not visible then should not add object to drawables.
@@ -280,12 +316,12 @@ class StageAttributes : public AbstractObjectAttributes {
   void setSemanticAssetType(int semanticAssetType) {
     setInt("semanticAssetType", semanticAssetType);
   }
-  int getSemanticAssetType() { return getInt("semanticAssetType"); }
+  int getSemanticAssetType() const { return getInt("semanticAssetType"); }
 
   void setLoadSemanticMesh(bool loadSemanticMesh) {
     setBool("loadSemanticMesh", loadSemanticMesh);
   }
-  bool getLoadSemanticMesh() { return getBool("loadSemanticMesh"); }
+  bool getLoadSemanticMesh() const { return getBool("loadSemanticMesh"); }
 
   void setNavmeshAssetHandle(const std::string& navmeshAssetHandle) {
     setString("navmeshAssetHandle", navmeshAssetHandle);
@@ -303,7 +339,7 @@ class StageAttributes : public AbstractObjectAttributes {
   void setLightSetup(const std::string& lightSetup) {
     setString("lightSetup", lightSetup);
   }
-  std::string getLightSetup() { return getString("lightSetup"); }
+  std::string getLightSetup() const { return getString("lightSetup"); }
 
   void setFrustumCulling(bool frustumCulling) {
     setBool("frustumCulling", frustumCulling);
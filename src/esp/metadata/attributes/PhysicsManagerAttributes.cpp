@@ -12,7 +12,11 @@ PhysicsManagerAttributes::PhysicsManagerAttributes(const std::string& handle)
     : AbstractAttributes("PhysicsManagerAttributes", handle) {
   setSimulator("none");
   setTimestep(0.01);
-  setMaxSubsteps(10);
+  setMaxSubsteps(0);
+  setSkipIfBehind(true);
+  setRenderInterpolation(false);
+  setNumThreads(1);
+  setDeterministic(false);
 }  // PhysicsManagerAttributes ctor
 
 }  // namespace attributes
@@ -24,9 +24,51 @@ class PhysicsManagerAttributes : public AbstractAttributes {
   void setTimestep(double timestep) { setDouble("timestep", timestep); }
   double getTimestep() const { return getDouble("timestep"); }
 
+  /**
+   * @brief Set the most fixed steps a single step of the world takes, 0 for
+   * no limit.
+   */
   void setMaxSubsteps(int maxSubsteps) { setInt("max_substeps", maxSubsteps); }
   int getMaxSubsteps() const { return getInt("max_substeps"); }
 
+  /**
+   * @brief Set whether the time of the steps beyond the max substeps is
+   * dropped instead of caught up by the next steps of the world.
+   */
+  void setSkipIfBehind(bool skipIfBehind) {
+    setBool("skip_if_behind", skipIfBehind);
+  }
+  bool getSkipIfBehind() const { return getBool("skip_if_behind"); }
+
+  /**
+   * @brief Set whether moving objects are drawn between their last two fixed
+   * steps rather than ahead of the last one.
+   */
+  void setRenderInterpolation(bool renderInterpolation) {
+    setBool("render_interpolation", renderInterpolation);
+  }
+  bool getRenderInterpolation() const {
+    return getBool("render_interpolation");
+  }
+
+  /**
+   * @brief Set the number of threads stepping the simulation: 1 for a
+   * single-threaded world, 0 for all the threads of Bullet's task scheduler.
+   * At most @ref core::ThreadPool::threadBudget() threads are used.
+   */
+  void setNumThreads(int numThreads) { setInt("num_threads", numThreads); }
+  int getNumThreads() const { return getInt("num_threads"); }
+
+  /**
+   * @brief Set whether the simulation is bitwise reproducible: stepped on one
+   * thread whatever @ref setNumThreads, with a fixed number of solver
+   * iterations.
+   */
+  void setDeterministic(bool deterministic) {
+    setBool("deterministic", deterministic);
+  }
+  bool getDeterministic() const { return getBool("deterministic"); }
+
   void setGravity(const Magnum::Vector3& gravity) {
     setVec3("gravity", gravity);
   }
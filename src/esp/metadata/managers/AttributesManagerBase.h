@@ -9,10 +9,14 @@
  * @brief Class Template @ref esp::metadata::managers::AttributesManager
  */
 
+#include <algorithm>
+
 #include "esp/metadata/attributes/AttributesBase.h"
 
 #include "esp/core/ManagedContainer.h"
+#include "esp/core/ThreadPool.h"
 #include "esp/io/io.h"
+#include "esp/metadata/DatasetIndex.h"
 
 namespace Cr = Corrade;
 
@@ -49,7 +53,10 @@ class AttributesManager : public esp::core::ManagedContainer<T> {
    * locations.
    *
    * This will take the list of file names specified and load the referenced
-   * templates.  It is assumed these files are JSON files currently.
+   * templates.  It is assumed these files are JSON files currently.  The
+   * files are read and parsed in parallel, on @ref
+   * esp::core::ThreadPool::shared(), while the templates are built and
+   * registered in the order of @p tmpltFilenames on the calling thread.
    * @param tmpltFilenames list of file names of templates
    * @param saveAsDefaults Set these templates as un-deletable from library.
    * @return vector holding IDs of templates that have been added
@@ -84,10 +91,13 @@ class AttributesManager : public esp::core::ManagedContainer<T> {
    * @param configDir The directory to use as a root to search in - may be
    * different than the config already listed in this manager.
    * @param jsonPaths The json array element
+   * @param index If not null, the paths with an up-to-date entry in it are
+   * not searched, and the others are searched and recorded in it.
    */
 
   void buildCfgPathsFromJSONAndLoad(const std::string& configDir,
-                                    const io::JsonGenericValue& jsonPaths);
+                                    const io::JsonGenericValue& jsonPaths,
+                                    DatasetIndex* index = nullptr);
 
   /**
    * @brief Check if currently configured primitive asset template library has
@@ -129,6 +139,20 @@ class AttributesManager : public esp::core::ManagedContainer<T> {
                                   const io::JsonGenericValue& jsonConfig) = 0;
 
  protected:
+  /**
+   * @brief Called from @ref loadAllFileBasedTemplates for each file, to
+   * register a placeholder that is only built into a template from the file
+   * when first accessed, for managers that support lazy loading.
+   *
+   * @param filename the name of the configuration file
+   * @return The ID of the placeholder, or ID_UNDEFINED if the file is to be
+   * loaded now.
+   */
+  virtual int registerDeferredObject(
+      CORRADE_UNUSED const std::string& filename) {
+    return ID_UNDEFINED;
+  }
+
   /**
    * @brief Called intenrally from createObject.  This will create either a file
    * based AbstractAttributes or a default one based on whether the passed file
@@ -154,6 +178,16 @@ class AttributesManager : public esp::core::ManagedContainer<T> {
  public:
   ESP_SMART_POINTERS(AttributesManager<AttribsPtr>)
 
+ private:
+  /**
+   * @brief Find the @ref JSONTypeExt_ files to load for @p path, as described
+   * in @ref loadAllConfigsFromPath.
+   *
+   * @return Whether @p path exists as a file or a directory
+   */
+  bool findConfigsInPath(const std::string& path,
+                         std::vector<std::string>& paths);
+
 };  // class AttributesManager
 
 /////////////////////////////
@@ -163,18 +197,53 @@ std::vector<int> AttributesManager<T>::loadAllFileBasedTemplates(
     const std::vector<std::string>& paths,
     bool saveAsDefaults) {
   std::vector<int> templateIndices(paths.size(), ID_UNDEFINED);
-  for (int i = 0; i < paths.size(); ++i) {
-    auto attributesFilename = paths[i];
-    LOG(INFO) << "AttributesManager::loadAllFileBasedTemplates : Load "
-              << this->objectType_ << " template: " << attributesFilename;
-    auto tmplt = this->createObjectFromJSONFile(attributesFilename, true);
-
-    // save handles in list of defaults, so they are not removed, if desired.
-    if (saveAsDefaults) {
-      std::string tmpltHandle = tmplt->getHandle();
-      this->undeletableObjectNames_.insert(tmpltHandle);
+  std::vector<std::size_t> toLoad;
+  for (std::size_t i = 0; i < paths.size(); ++i) {
+    templateIndices[i] = this->registerDeferredObject(paths[i]);
+    if (ID_UNDEFINED == templateIndices[i]) {
+      toLoad.push_back(i);
+    } else if (saveAsDefaults) {
+      this->undeletableObjectNames_.insert(paths[i]);
+    }
+  }
+  // Reading and parsing the files dominates for datasets of many small
+  // configs, so that is done in parallel, in batches to bound the memory of
+  // the documents. Building the templates may query other managers, so they
+  // are built and registered here, in order, as before.
+  constexpr std::size_t batchSize = 256;
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  std::vector<io::JsonDocument> docs(std::min(batchSize, toLoad.size()));
+  std::vector<char> parsed(docs.size());
+  for (std::size_t first = 0; first < toLoad.size(); first += batchSize) {
+    const std::size_t count = std::min(batchSize, toLoad.size() - first);
+    pool.parallelFor(count, pool.numThreads() + 1,
+                     [&](const std::size_t i, std::size_t) {
+                       parsed[i] = this->verifyLoadDocument(
+                           paths[toLoad[first + i]], docs[i]);
+                     });
+    for (std::size_t i = 0; i < count; ++i) {
+      const std::string& attributesFilename = paths[toLoad[first + i]];
+      LOG(INFO) << "AttributesManager::loadAllFileBasedTemplates : Load "
+                << this->objectType_ << " template: " << attributesFilename;
+      if (!parsed[i]) {
+        LOG(ERROR) << "AttributesManager::loadAllFileBasedTemplates : "
+                      "Failure reading document as JSON : "
+                   << attributesFilename << ". Skipping.";
+        continue;
+      }
+      auto tmplt =
+          this->createObjectFromJSONDoc(attributesFilename, docs[i], true);
+      if (nullptr == tmplt) {
+        continue;
+      }
+
+      // save handles in list of defaults, so they are not removed, if desired.
+      if (saveAsDefaults) {
+        std::string tmpltHandle = tmplt->getHandle();
+        this->undeletableObjectNames_.insert(tmpltHandle);
+      }
+      templateIndices[toLoad[first + i]] = tmplt->getID();
     }
-    templateIndices[i] = tmplt->getID();
   }
   LOG(INFO)
       << "AttributesManager::loadAllFileBasedTemplates : Loaded file-based "
@@ -183,11 +252,9 @@ std::vector<int> AttributesManager<T>::loadAllFileBasedTemplates(
 }  // AttributesManager<T>::loadAllObjectTemplates
 
 template <class T>
-std::vector<int> AttributesManager<T>::loadAllConfigsFromPath(
+bool AttributesManager<T>::findConfigsInPath(
     const std::string& path,
-    bool saveAsDefaults) {
-  std::vector<std::string> paths;
-  std::vector<int> templateIndices;
+    std::vector<std::string>& paths) {
   namespace Directory = Cr::Utility::Directory;
   std::string attributesFilepath =
       this->convertFilenameToJSON(path, this->JSONTypeExt_);
@@ -198,7 +265,7 @@ std::vector<int> AttributesManager<T>::loadAllConfigsFromPath(
     LOG(WARNING) << "AttributesManager::loadAllConfigsFromPath : Parsing "
                  << this->objectType_ << " : Cannot find " << path << " or "
                  << attributesFilepath << ". Aborting parse.";
-    return templateIndices;
+    return false;
   }
 
   if (fileExists) {
@@ -216,29 +283,59 @@ std::vector<int> AttributesManager<T>::loadAllConfigsFromPath(
       }
     }
   }
-  // build templates from aggregated paths
-  templateIndices = this->loadAllFileBasedTemplates(paths, saveAsDefaults);
+  return true;
+}  // AttributesManager<T>::findConfigsInPath
 
-  return templateIndices;
+template <class T>
+std::vector<int> AttributesManager<T>::loadAllConfigsFromPath(
+    const std::string& path,
+    bool saveAsDefaults) {
+  std::vector<std::string> paths;
+  if (!findConfigsInPath(path, paths)) {
+    return {};
+  }
+  // build templates from aggregated paths
+  return this->loadAllFileBasedTemplates(paths, saveAsDefaults);
 }  // AttributesManager<T>::loadAllConfigsFromPath
 
 template <class T>
 void AttributesManager<T>::buildCfgPathsFromJSONAndLoad(
     const std::string& configDir,
-    const io::JsonGenericValue& jsonPaths) {
-  for (rapidjson::SizeType i = 0; i < jsonPaths.Size(); ++i) {
-    if (!jsonPaths[i].IsString()) {
-      LOG(ERROR)
-          << "AttributesManager::buildCfgPathsFromJSONAndLoad : Invalid path "
-             "value in configuration array element @ idx "
-          << i << ". Skipping.";
-      continue;
-    }
-    std::string absolutePath =
-        Cr::Utility::Directory::join(configDir, jsonPaths[i].GetString());
-    // load all object templates available as configs in absolutePath
-    this->loadAllConfigsFromPath(absolutePath, true);
+    const io::JsonGenericValue& jsonPaths,
+    DatasetIndex* index) {
+  // scan the directories in parallel, then load all the configs found in one
+  // go, in the order of the paths
+  std::vector<std::vector<std::string>> pathsPerEntry(jsonPaths.Size());
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelFor(
+      jsonPaths.Size(), pool.numThreads() + 1,
+      [&](const std::size_t i, std::size_t) {
+        if (!jsonPaths[i].IsString()) {
+          LOG(ERROR) << "AttributesManager::buildCfgPathsFromJSONAndLoad : "
+                        "Invalid path value in configuration array element @ "
+                        "idx "
+                     << i << ". Skipping.";
+          return;
+        }
+        std::string absolutePath =
+            Cr::Utility::Directory::join(configDir, jsonPaths[i].GetString());
+        if (index == nullptr) {
+          findConfigsInPath(absolutePath, pathsPerEntry[i]);
+          return;
+        }
+        const std::string configFile =
+            this->convertFilenameToJSON(absolutePath, this->JSONTypeExt_);
+        if (!index->find(absolutePath, configFile, pathsPerEntry[i])) {
+          findConfigsInPath(absolutePath, pathsPerEntry[i]);
+          index->record(absolutePath, configFile, pathsPerEntry[i]);
+        }
+      });
+  std::vector<std::string> paths;
+  for (const std::vector<std::string>& entryPaths : pathsPerEntry) {
+    paths.insert(paths.end(), entryPaths.begin(), entryPaths.end());
   }
+  // load all object templates available as configs in the paths
+  this->loadAllFileBasedTemplates(paths, true);
   LOG(INFO) << "AttributesManager::buildCfgPathsFromJSONAndLoad : "
             << std::to_string(jsonPaths.Size())
             << " paths specified in JSON doc for " << this->objectType_
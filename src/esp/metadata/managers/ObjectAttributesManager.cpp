@@ -100,6 +100,26 @@ void ObjectAttributesManager::setValsFromJSONDoc(
   io::jsonIntoSetter<bool>(
       jsonConfig, "join_collision_meshes",
       std::bind(&ObjectAttributes::setJoinCollisionMeshes, objAttributes, _1));
+  // Simplify the convex collision hulls if specified
+  io::jsonIntoSetter<int>(
+      jsonConfig, "max_hull_vertices",
+      std::bind(&ObjectAttributes::setMaxHullVertices, objAttributes, _1));
+  // Decompose the collision asset into convex hulls if specified
+  io::jsonIntoSetter<bool>(
+      jsonConfig, "use_convex_decomposition",
+      std::bind(&ObjectAttributes::setUseConvexDecomposition, objAttributes,
+                _1));
+  // The collision filter if specified
+  io::jsonIntoSetter<int>(
+      jsonConfig, "collision_group",
+      std::bind(&ObjectAttributes::setCollisionGroup, objAttributes, _1));
+  io::jsonIntoSetter<int>(
+      jsonConfig, "collision_mask",
+      std::bind(&ObjectAttributes::setCollisionMask, objAttributes, _1));
+  io::jsonIntoSetter<bool>(
+      jsonConfig, "static_environment_only",
+      std::bind(&ObjectAttributes::setStaticEnvironmentOnly, objAttributes,
+                _1));
 
   // The object's interia matrix diagonal
   io::jsonIntoConstSetter<Magnum::Vector3>(
@@ -254,6 +274,12 @@ int ObjectAttributesManager::registerObjectFinalize(
   // Clear dirty flag from when asset handles are changed
   objectTemplate->setIsClean();
 
+  // a template registered over a lazily registered placeholder replaces it
+  if (deferredConfigHandles_.erase(objectTemplateHandle) > 0) {
+    physicsFileObjTmpltLibByID_.erase(
+        this->getObjectIDByHandle(objectTemplateHandle));
+  }
+
   // Add object template to template library
   int objectTemplateID =
       this->addObjectToLibrary(objectTemplate, objectTemplateHandle);
@@ -265,6 +291,50 @@ int ObjectAttributesManager::registerObjectFinalize(
   return objectTemplateID;
 }  // ObjectAttributesManager::registerObjectFinalize
 
+int ObjectAttributesManager::registerDeferredObject(
+    const std::string& filename) {
+  if (!lazyLoading_ || !this->isValidFileName(filename)) {
+    // parse now, reporting a missing file as usual
+    return ID_UNDEFINED;
+  }
+  auto placeholder = this->initNewObjectInternal(filename, true);
+  int objectTemplateID = this->addObjectToLibrary(placeholder, filename);
+  // counted as file-based until built, as configs nearly always are
+  physicsSynthObjTmpltLibByID_.erase(objectTemplateID);
+  physicsFileObjTmpltLibByID_[objectTemplateID] = filename;
+  deferredConfigHandles_.insert(filename);
+  return objectTemplateID;
+}  // ObjectAttributesManager::registerDeferredObject
+
+void ObjectAttributesManager::buildDeferredObject(
+    const std::string& objectHandle) {
+  if (deferredConfigHandles_.count(objectHandle) == 0) {
+    return;
+  }
+  LOG(INFO) << "ObjectAttributesManager::buildDeferredObject : Load "
+            << this->objectType_ << " template: " << objectHandle;
+  ObjectAttributes::ptr objectTemplate = nullptr;
+  io::JsonDocument docConfig;
+  if (this->verifyLoadDocument(objectHandle, docConfig)) {
+    // a document is its root value
+    const io::JsonGenericValue& config = docConfig;
+    objectTemplate = this->buildObjectFromJSONDoc(objectHandle, config);
+  }
+  // registering over the placeholder keeps its ID
+  if (nullptr != objectTemplate &&
+      this->registerObjectFinalize(objectTemplate, objectHandle, false) !=
+          ID_UNDEFINED) {
+    return;
+  }
+  LOG(ERROR) << "ObjectAttributesManager::buildDeferredObject : Failed to "
+                "build lazily registered "
+             << this->objectType_ << " template " << objectHandle
+             << ", so removing it.";
+  this->undeletableObjectNames_.erase(objectHandle);
+  this->deleteObjectInternal(this->getObjectIDByHandle(objectHandle),
+                             objectHandle);
+}  // ObjectAttributesManager::buildDeferredObject
+
 }  // namespace managers
 }  // namespace metadata
 }  // namespace esp
@@ -7,6 +7,8 @@
 
 #include <Corrade/Utility/Assert.h>
 
+#include <unordered_set>
+
 #include "AbstractObjectAttributesManagerBase.h"
 #include "AssetAttributesManager.h"
 
@@ -70,6 +72,29 @@ class ObjectAttributesManager
     return assetAttributesMgr_->getObjectLibHasHandle(handle);
   }
 
+  /**
+   * @brief Set whether the object configs loaded from now on are only parsed
+   * when their templates are first accessed by handle or ID, e.g. by @ref
+   * getObjectCopyByHandle, instead of when loaded.  Their handles are
+   * registered right away, as file-based templates, so that they can be
+   * searched and counted as usual.  Meant for datasets of many more objects
+   * than are used at a time.
+   */
+  void setLazyLoading(bool lazyLoading) { lazyLoading_ = lazyLoading; }
+
+  /**
+   * @brief Whether object configs are loaded lazily, see @ref setLazyLoading.
+   */
+  bool getLazyLoading() const { return lazyLoading_; }
+
+  /**
+   * @brief Get the number of templates registered lazily that have not been
+   * built from their config yet.
+   */
+  int getNumDeferredTemplateObjects() const {
+    return deferredConfigHandles_.size();
+  }
+
   // ======== File-based and primitive-based partition functions ========
 
   /**
@@ -204,13 +229,25 @@ class ObjectAttributesManager
    * @param templateID the ID of the template to remove
    * @param templateHandle the string key of the attributes desired.
    */
-  void updateObjectHandleLists(
-      int templateID,
-      CORRADE_UNUSED const std::string& templateHandle) override {
+  void updateObjectHandleLists(int templateID,
+                               const std::string& templateHandle) override {
     physicsFileObjTmpltLibByID_.erase(templateID);
     physicsSynthObjTmpltLibByID_.erase(templateID);
+    deferredConfigHandles_.erase(templateHandle);
   }
 
+  /**
+   * @brief Register a placeholder for the template of the object config @p
+   * filename if loading lazily, counted as a file-based template until built.
+   */
+  int registerDeferredObject(const std::string& filename) override;
+
+  /**
+   * @brief Build the template of @p objectHandle from its config if it was
+   * registered lazily, replacing the placeholder and keeping its ID.
+   */
+  void buildDeferredObject(const std::string& objectHandle) override;
+
   /**
    * @brief Add a copy of @ref  esp::metadata::attributes::AbstractAttributes
    * object to the @ref objectLibrary_. Verify that render and collision
@@ -237,6 +274,7 @@ class ObjectAttributesManager
   void resetFinalize() override {
     physicsFileObjTmpltLibByID_.clear();
     physicsSynthObjTmpltLibByID_.clear();
+    deferredConfigHandles_.clear();
   }
 
   /**
@@ -270,6 +308,18 @@ class ObjectAttributesManager
    */
   std::map<int, std::string> physicsSynthObjTmpltLibByID_;
 
+  /**
+   * @brief Whether object configs are registered lazily, see @ref
+   * setLazyLoading.
+   */
+  bool lazyLoading_ = false;
+
+  /**
+   * @brief Handles of the templates registered lazily and not built yet,
+   * which are also their config filenames.
+   */
+  std::unordered_set<std::string> deferredConfigHandles_;
+
  public:
   ESP_SMART_POINTERS(ObjectAttributesManager)
 
@@ -50,6 +50,29 @@ void PhysicsAttributesManager::setValsFromJSONDoc(
   io::jsonIntoSetter<int>(jsonConfig, "max_substeps",
                           std::bind(&PhysicsManagerAttributes::setMaxSubsteps,
                                     physicsManagerAttributes, _1));
+
+  // load what happens to the steps beyond the max substeps
+  io::jsonIntoSetter<bool>(
+      jsonConfig, "skip_if_behind",
+      std::bind(&PhysicsManagerAttributes::setSkipIfBehind,
+                physicsManagerAttributes, _1));
+
+  // load whether objects are drawn between fixed steps
+  io::jsonIntoSetter<bool>(
+      jsonConfig, "render_interpolation",
+      std::bind(&PhysicsManagerAttributes::setRenderInterpolation,
+                physicsManagerAttributes, _1));
+
+  // load the number of simulation threads
+  io::jsonIntoSetter<int>(jsonConfig, "num_threads",
+                          std::bind(&PhysicsManagerAttributes::setNumThreads,
+                                    physicsManagerAttributes, _1));
+
+  // load whether the simulation is reproducible
+  io::jsonIntoSetter<bool>(
+      jsonConfig, "deterministic",
+      std::bind(&PhysicsManagerAttributes::setDeterministic,
+                physicsManagerAttributes, _1));
   // load the friction coefficient
   io::jsonIntoSetter<double>(
       jsonConfig, "friction_coefficient",
@@ -26,6 +26,19 @@ SceneDatasetAttributes::ptr SceneDatasetAttributesManager::createObject(
   return attrs;
 }  // SceneDatasetAttributesManager::createObject
 
+bool SceneDatasetAttributesManager::buildDatasetIndex(
+    const std::string& datasetFilename) {
+  const bool lazyObjectLoading = lazyObjectLoading_;
+  lazyObjectLoading_ = true;
+  buildingDatasetIndex_ = true;
+  datasetIndexSaved_ = false;
+  SceneDatasetAttributes::ptr attrs =
+      this->createObject(datasetFilename, false);
+  buildingDatasetIndex_ = false;
+  lazyObjectLoading_ = lazyObjectLoading;
+  return nullptr != attrs && datasetIndexSaved_;
+}  // SceneDatasetAttributesManager::buildDatasetIndex
+
 SceneDatasetAttributes::ptr
 SceneDatasetAttributesManager::initNewObjectInternal(
     const std::string& datasetFilename,
@@ -42,6 +55,8 @@ SceneDatasetAttributesManager::initNewObjectInternal(
   // set the handle of the physics manager that is used for this newly-made
   // dataset
   newAttributes->setPhysicsManagerHandle(physicsManagerAttributesHandle_);
+  newAttributes->getObjectAttributesManager()->setLazyLoading(
+      lazyObjectLoading_);
   // any internal default configuration here
   return newAttributes;
 }  // SceneDatasetAttributesManager::initNewObjectInternal
@@ -51,21 +66,45 @@ void SceneDatasetAttributesManager::setValsFromJSONDoc(
     const io::JsonGenericValue& jsonConfig) {
   // dataset root directory to build paths from
   std::string dsDir = dsAttribs->getFileDirectory();
+  // the index of the paths searched, when it is up to date for them, or
+  // recording them when building it
+  DatasetIndex index;
+  const std::string indexFilename =
+      DatasetIndex::filenameFor(dsAttribs->getHandle());
+  const bool indexLoaded = useDatasetIndex_ && !buildingDatasetIndex_ &&
+                           index.load(indexFilename);
+  DatasetIndex* const indexUsed =
+      indexLoaded || buildingDatasetIndex_ ? &index : nullptr;
   // process stages
   readDatasetJSONCell(dsDir, "stages", jsonConfig,
-                      dsAttribs->getStageAttributesManager());
+                      dsAttribs->getStageAttributesManager(), indexUsed);
 
   // process objects
   readDatasetJSONCell(dsDir, "objects", jsonConfig,
-                      dsAttribs->getObjectAttributesManager());
+                      dsAttribs->getObjectAttributesManager(), indexUsed);
 
   // process light setups - implement handling light setups
   readDatasetJSONCell(dsDir, "light_setups", jsonConfig,
-                      dsAttribs->getLightLayoutAttributesManager());
+                      dsAttribs->getLightLayoutAttributesManager(), indexUsed);
 
   // process scene instances - implement handling scene instances TODO
   readDatasetJSONCell(dsDir, "scene_instances", jsonConfig,
-                      dsAttribs->getSceneAttributesManager());
+                      dsAttribs->getSceneAttributesManager(), indexUsed);
+
+  if (buildingDatasetIndex_) {
+    datasetIndexSaved_ = index.save(indexFilename);
+    LOG(INFO) << "SceneDatasetAttributesManager::setValsFromJSONDoc : "
+              << (datasetIndexSaved_ ? "Saved" : "Failed to save")
+              << " dataset index " << indexFilename << " of " << index.size()
+              << " search paths.";
+  } else if (indexLoaded && index.numMisses() > 0) {
+    LOG(WARNING) << "SceneDatasetAttributesManager::setValsFromJSONDoc : "
+                 << index.numMisses() << " search paths of "
+                 << dsAttribs->getHandle() << " changed since its index "
+                 << indexFilename
+                 << " was built and were searched again. Rebuild it with "
+                    "datatool rebuild_dataset_index.";
+  }
 
   // process navmesh instances
   io::readMember<std::map<std::string, std::string>>(
@@ -84,7 +123,8 @@ void SceneDatasetAttributesManager::readDatasetJSONCell(
     const std::string& dsDir,
     const char* tag,
     const io::JsonGenericValue& jsonConfig,
-    const U& attrMgr) {
+    const U& attrMgr,
+    DatasetIndex* index) {
   if (jsonConfig.HasMember(tag)) {
     if (!jsonConfig[tag].IsObject()) {
       dispCellConfigError(tag);
@@ -143,7 +183,7 @@ void SceneDatasetAttributesManager::readDatasetJSONCell(
                      "skipping.";
             } else {
               const auto& paths = pathsObj[".json"];
-              attrMgr->buildCfgPathsFromJSONAndLoad(dsDir, paths);
+              attrMgr->buildCfgPathsFromJSONAndLoad(dsDir, paths, index);
             }
           }  // if has member ".json"
              // TODO support other extention tags
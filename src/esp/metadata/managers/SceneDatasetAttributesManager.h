@@ -100,6 +100,44 @@ class SceneDatasetAttributesManager
     }
   }  // SceneDatasetAttributesManager::setCurrPhysicsManagerAttributesHandle
 
+  /**
+   * @brief Set whether the datasets created from now on load their object
+   * configs lazily.  See @ref ObjectAttributesManager::setLazyLoading.
+   */
+  void setLazyObjectLoading(bool lazyObjectLoading) {
+    lazyObjectLoading_ = lazyObjectLoading;
+  }
+
+  /**
+   * @brief Whether the datasets created load their object configs lazily.
+   */
+  bool getLazyObjectLoading() const { return lazyObjectLoading_; }
+
+  /**
+   * @brief Set whether the datasets created from now on use the index next to
+   * their config, instead of searching their paths for configs. See
+   * @ref DatasetIndex.
+   */
+  void setUseDatasetIndex(bool useDatasetIndex) {
+    useDatasetIndex_ = useDatasetIndex;
+  }
+
+  /**
+   * @brief Whether the datasets created use the index next to their config.
+   */
+  bool getUseDatasetIndex() const { return useDatasetIndex_; }
+
+  /**
+   * @brief Search all the paths of the dataset config @p datasetFilename and
+   * save what was found as its index, named as
+   * @ref DatasetIndex::filenameFor(), replacing any existing one.
+   *
+   * The dataset is loaded without being registered, with its object configs
+   * loaded lazily.
+   * @return Whether the dataset was loaded and the index saved
+   */
+  bool buildDatasetIndex(const std::string& datasetFilename);
+
  protected:
   /**
    * @brief Verify a particular subcell exists within the dataset_config.JSON
@@ -112,12 +150,14 @@ class SceneDatasetAttributesManager
    * objects, etc)
    * @param jsonConfig The sub cell in the json document being processed.
    * @param attrMgr The dataset's attributes manager for @p tag 's data.
+   * @param index The index of the dataset, if it is used or built.
    */
   template <typename U>
   void readDatasetJSONCell(const std::string& dsDir,
                            const char* tag,
                            const io::JsonGenericValue& jsonConfig,
-                           const U& attrMgr);
+                           const U& attrMgr,
+                           DatasetIndex* index);
 
   /**
    * @brief This will parse an individual element in a "configs" cell array in
@@ -226,6 +266,23 @@ class SceneDatasetAttributesManager
    */
   std::string physicsManagerAttributesHandle_ = "";
 
+  /**
+   * @brief Whether the object configs of new datasets are loaded lazily
+   */
+  bool lazyObjectLoading_ = false;
+
+  /**
+   * @brief Whether new datasets use the index next to their config
+   */
+  bool useDatasetIndex_ = true;
+
+  /**
+   * @brief Whether the dataset being loaded is for @ref buildDatasetIndex(),
+   * and whether its index was saved
+   */
+  bool buildingDatasetIndex_ = false;
+  bool datasetIndexSaved_ = false;
+
   /**
    * @brief Reference to PhysicsAttributesManager to give access to default
    * physics manager attributes settings when
@@ -0,0 +1,154 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "esp/nav/CoverageMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Quaternion.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace nav {
+
+namespace {
+typedef Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> MatrixXb;
+}  // namespace
+
+struct CoverageMap::Impl {
+  float metersPerPixel;
+  // Position of the center of cell (0, 0)
+  float startX, startZ;
+  MatrixXb navigable;
+  MatrixXb coverage;
+  int numNavigable = 0;
+  int numCovered = 0;
+
+  bool isNavigable(const int x, const int z) const {
+    return z >= 0 && z < navigable.rows() && x >= 0 && x < navigable.cols() &&
+           navigable(z, x);
+  }
+
+  // Marks the cell, returns whether it wasn't yet
+  bool mark(const int x, const int z) {
+    if (coverage(z, x))
+      return false;
+    coverage(z, x) = true;
+    ++numCovered;
+    return true;
+  }
+
+  // Walks the cells along the ray with a DDA, from the cell of gx, gz in grid
+  // units until the length or the first cell that isn't navigable
+  int castRay(const float gx,
+              const float gz,
+              const float dx,
+              const float dz,
+              const float length) {
+    int x = std::floor(gx), z = std::floor(gz);
+    const int stepX = dx > 0 ? 1 : -1;
+    const int stepZ = dz > 0 ? 1 : -1;
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    const float deltaX = dx != 0 ? 1.0f / std::abs(dx) : inf;
+    const float deltaZ = dz != 0 ? 1.0f / std::abs(dz) : inf;
+    float nextX = dx != 0 ? (dx > 0 ? x + 1 - gx : gx - x) * deltaX : inf;
+    float nextZ = dz != 0 ? (dz > 0 ? z + 1 - gz : gz - z) * deltaZ : inf;
+
+    int newCells = 0;
+    while (true) {
+      float t;
+      if (nextX < nextZ) {
+        t = nextX;
+        nextX += deltaX;
+        x += stepX;
+      } else {
+        t = nextZ;
+        nextZ += deltaZ;
+        z += stepZ;
+      }
+      if (t > length || !isNavigable(x, z))
+        break;
+      newCells += mark(x, z);
+    }
+    return newCells;
+  }
+};
+
+CoverageMap::CoverageMap(PathFinder::ptr pathfinder,
+                         const float metersPerPixel,
+                         const float height)
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {
+  CORRADE_ASSERT(metersPerPixel > 0,
+                 "CoverageMap: expected a positive cell size, got"
+                     << metersPerPixel, );
+  pimpl_->metersPerPixel = metersPerPixel;
+  pimpl_->navigable = pathfinder->getTopDownView(metersPerPixel, height);
+  pimpl_->numNavigable = pimpl_->navigable.count();
+  const std::pair<vec3f, vec3f> bounds = pathfinder->bounds();
+  pimpl_->startX = std::min(bounds.first[0], bounds.second[0]);
+  pimpl_->startZ = std::min(bounds.first[2], bounds.second[2]);
+  reset();
+}
+
+int CoverageMap::update(const core::RigidState& pose,
+                        const float hfov,
+                        const float range) {
+  Impl& impl = *pimpl_;
+  // The cells are centered on the points sampled by the top-down view
+  const float gx =
+      (pose.translation.x() - impl.startX) / impl.metersPerPixel + 0.5f;
+  const float gz =
+      (pose.translation.z() - impl.startZ) / impl.metersPerPixel + 0.5f;
+  const int x = std::floor(gx), z = std::floor(gz);
+  if (!impl.isNavigable(x, z))
+    return 0;
+
+  int newCells = impl.mark(x, z);
+  const float length = range / impl.metersPerPixel;
+  const Mn::Vector3 forward =
+      pose.rotation.transformVector(-Mn::Vector3::zAxis());
+  const float heading = std::atan2(forward.z(), forward.x());
+  const float fov = std::min(hfov, Mn::Constants::tau());
+  // Neighboring rays are at most one cell apart at the maximum range
+  const int numRays = std::max(2, int(std::ceil(fov * length)) + 1);
+  for (int i = 0; i < numRays; ++i) {
+    const float angle = heading - 0.5f * fov + fov * i / (numRays - 1);
+    newCells +=
+        impl.castRay(gx, gz, std::cos(angle), std::sin(angle), length);
+  }
+  return newCells;
+}
+
+int CoverageMap::numCovered() const {
+  return pimpl_->numCovered;
+}
+
+float CoverageMap::coveredArea() const {
+  return pimpl_->numCovered * pimpl_->metersPerPixel * pimpl_->metersPerPixel;
+}
+
+int CoverageMap::numNavigable() const {
+  return pimpl_->numNavigable;
+}
+
+const MatrixXb& CoverageMap::coverage() const {
+  return pimpl_->coverage;
+}
+
+const MatrixXb& CoverageMap::navigable() const {
+  return pimpl_->navigable;
+}
+
+void CoverageMap::reset() {
+  pimpl_->coverage =
+      MatrixXb::Zero(pimpl_->navigable.rows(), pimpl_->navigable.cols());
+  pimpl_->numCovered = 0;
+}
+
+}  // namespace nav
+}  // namespace esp
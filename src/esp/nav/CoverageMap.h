@@ -0,0 +1,82 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_NAV_COVERAGEMAP_H_
+#define ESP_NAV_COVERAGEMAP_H_
+
+/** @file
+ * @brief Class @ref esp::nav::CoverageMap
+ */
+
+#include "esp/core/RigidState.h"
+#include "esp/core/esp.h"
+#include "esp/nav/PathFinder.h"
+
+namespace esp {
+namespace nav {
+
+/**
+ * @brief Accumulates the navigable area seen by an agent, e.g. for
+ * exploration rewards
+ *
+ * The cells are the pixels of @ref PathFinder::getTopDownView() at a height.
+ * Each update casts rays over the field of view of the agent from its cell,
+ * one cell apart at the maximum range, and marks the cells they cross until
+ * they leave the navigable cells. Obstacles are the boundary of the navmesh,
+ * so anything that is not walkable blocks the view. An update takes time in
+ * the number of cells in the field of view, not in the size of the map.
+ */
+class CoverageMap {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] pathfinder Pathfinder with the navmesh to cover
+   * @param[in] metersPerPixel The size of a cell
+   * @param[in] height The height of the slice of the navmesh, as for @ref
+   *                   PathFinder::getTopDownView()
+   */
+  CoverageMap(PathFinder::ptr pathfinder, float metersPerPixel, float height);
+
+  /**
+   * @brief Mark the cells visible from a pose
+   *
+   * @param[in] pose The pose of the agent, looking along its -Z axis
+   * @param[in] hfov The horizontal field of view, in radians
+   * @param[in] range The distance the agent sees up to
+   *
+   * @return The number of cells seen for the first time, 0 if the agent is
+   * not on a navigable cell
+   */
+  int update(const core::RigidState& pose, float hfov, float range);
+
+  /** @brief The number of cells seen */
+  int numCovered() const;
+
+  /** @brief The area of the cells seen */
+  float coveredArea() const;
+
+  /** @brief The number of navigable cells */
+  int numNavigable() const;
+
+  /**
+   * @brief Grid of the cells seen, with the rows along z and the columns
+   * along x, as the top-down view
+   */
+  const Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>& coverage() const;
+
+  /** @brief The top-down view of the navigable cells */
+  const Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>& navigable()
+      const;
+
+  /** @brief Forget the cells seen, e.g. at the start of an episode */
+  void reset();
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(CoverageMap)
+};
+
+}  // namespace nav
+}  // namespace esp
+
+#endif  // ESP_NAV_COVERAGEMAP_H_
@@ -1,8 +1,15 @@
 #include "esp/nav/GreedyFollower.h"
 
+#include <array>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+
 #include <Magnum/EigenIntegration/GeometryIntegration.h>
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/Math/Quaternion.h>
 
+#include "esp/core/ThreadPool.h"
 #include "esp/core/esp.h"
 #include "esp/geo/geo.h"
 
@@ -255,5 +262,345 @@ void GreedyGeodesicFollowerImpl::reset() {
   thrashingActions_.clear();
 }
 
+namespace {
+// Same as in ObjectControls, a step that moved less collided
+constexpr float collisionEps = 1e-5f;
+
+struct PositionKey {
+  std::array<int, 3> cell;
+  bool operator==(const PositionKey& other) const {
+    return cell == other.cell;
+  }
+};
+
+struct PositionKeyHash {
+  std::size_t operator()(const PositionKey& key) const {
+    std::size_t hash = 0;
+    for (const int c : key.cell)
+      hash = hash * 0x9e3779b1u + std::hash<int>{}(c);
+    return hash;
+  }
+};
+
+// What the reward needs at a position, memoized per agent
+struct PositionDistances {
+  float geodesicDistance;
+  float distanceToClosestObstacle;
+};
+}  // namespace
+
+struct BatchedGreedyGeodesicFollower::Impl {
+  struct Agent {
+    Mn::Vector3 goal;
+    bool hasGoal = false;
+    std::vector<CODES> actions;
+    std::vector<CODES> thrashingActions;
+    std::unordered_map<PositionKey, PositionDistances, PositionKeyHash> memo;
+  };
+
+  // Entries of an agent memo before it's flushed, a few thousand steps
+  static constexpr std::size_t maxMemoSize = 1 << 16;
+
+  PathFinder::ptr pathfinder;
+  double goalDist, forwardAmount, turnAmount;
+  bool allowSliding, fixThrashing;
+  std::size_t thrashingThreshold;
+  float memoResolution;
+  float closeToObsThreshold = 0.2f;
+  float collisionCost = 0.25f;
+  std::vector<Agent> agents;
+
+  void resize(const std::size_t count) {
+    if (agents.size() < count)
+      agents.resize(count);
+  }
+
+  // Reset the agent if it has a new goal
+  void setGoal(Agent& agent, const Mn::Vector3& goal) {
+    if (!agent.hasGoal || (agent.goal - goal).dot() > 1e-10f) {
+      resetAgent(agent);
+      agent.goal = goal;
+      agent.hasGoal = true;
+    }
+  }
+
+  static void resetAgent(Agent& agent) {
+    agent.hasGoal = false;
+    agent.actions.clear();
+    agent.thrashingActions.clear();
+    agent.memo.clear();
+  }
+
+  const PositionDistances& distances(Agent& agent,
+                                     const Mn::Vector3& position) const {
+    PositionKey key;
+    for (int i = 0; i < 3; ++i)
+      key.cell[i] = static_cast<int>(std::round(position[i] / memoResolution));
+    auto found = agent.memo.find(key);
+    if (found != agent.memo.end())
+      return found->second;
+
+    if (agent.memo.size() >= maxMemoSize)
+      agent.memo.clear();
+    ShortestPath path;
+    path.requestedStart = cast<vec3f>(position);
+    path.requestedEnd = cast<vec3f>(agent.goal);
+    pathfinder->findPath(path);
+    const float distanceToObstacle = pathfinder->distanceToClosestObstacle(
+        cast<vec3f>(position), 1.1 * closeToObsThreshold);
+    return agent.memo
+        .emplace(key,
+                 PositionDistances{path.geodesicDistance, distanceToObstacle})
+        .first->second;
+  }
+
+  // The state after "move_forward", and whether it collided
+  bool moveForward(core::RigidState& state) const {
+    const Mn::Vector3 start = state.translation;
+    const Mn::Vector3 end =
+        start + state.rotation.transformVector(
+                    {0.0f, 0.0f, -static_cast<float>(forwardAmount)});
+    state.translation = allowSliding ? pathfinder->tryStep(start, end)
+                                     : pathfinder->tryStepNoSliding(start, end);
+    return (state.translation - start).dot() + collisionEps <
+           (end - start).dot();
+  }
+
+  void turn(core::RigidState& state, const double angle) const {
+    state.rotation = (state.rotation * Mn::Quaternion::rotation(
+                                           Mn::Rad(static_cast<float>(angle)),
+                                           Mn::Vector3::yAxis()))
+                         .normalized();
+  }
+
+  float computeReward(Agent& agent,
+                      const core::RigidState& state,
+                      const float geodesicDistance,
+                      const std::size_t primLen) const {
+    core::RigidState after = state;
+    const bool didCollide = moveForward(after);
+    const PositionDistances& afterDistances =
+        distances(agent, after.translation);
+    return (geodesicDistance - afterDistances.geodesicDistance) /
+               forwardAmount +
+           (-0.0125f * primLen - (didCollide ? collisionCost : 0.0f) -
+            (afterDistances.distanceToClosestObstacle < closeToObsThreshold
+                 ? 0.05f
+                 : 0.0f));
+  }
+
+  // Same as GreedyGeodesicFollowerImpl::nextBestPrimAlong()
+  std::vector<CODES> nextBestPrimAlong(Agent& agent,
+                                       const core::RigidState& state) const {
+    const float geodesicDistance =
+        distances(agent, state.translation).geodesicDistance;
+    if (geodesicDistance == std::numeric_limits<float>::infinity()) {
+      return {CODES::ERROR};
+    }
+
+    if (geodesicDistance < goalDist) {
+      return {CODES::STOP};
+    }
+
+    float bestReward = -collisionCost;
+    std::vector<CODES> bestPrim, leftPrim, rightPrim;
+    core::RigidState left = state, right = state;
+
+    for (float angle = 0; angle < M_PI; angle += turnAmount) {
+      {
+        const float reward =
+            computeReward(agent, left, geodesicDistance, leftPrim.size());
+        if (reward > bestReward) {
+          bestReward = reward;
+          bestPrim = leftPrim;
+          bestPrim.emplace_back(CODES::FORWARD);
+        }
+      }
+
+      {
+        const float reward =
+            computeReward(agent, right, geodesicDistance, rightPrim.size());
+        if (reward > bestReward) {
+          bestReward = reward;
+          bestPrim = rightPrim;
+          bestPrim.emplace_back(CODES::FORWARD);
+        }
+      }
+
+      constexpr float goodEnoughRewardThresh = 0.99f;
+      if (bestReward > goodEnoughRewardThresh)
+        break;
+
+      leftPrim.emplace_back(CODES::LEFT);
+      turn(left, turnAmount);
+
+      rightPrim.emplace_back(CODES::RIGHT);
+      turn(right, -turnAmount);
+    }
+
+    return bestPrim;
+  }
+
+  bool isThrashing(const Agent& agent) const {
+    const std::vector<CODES>& actions = agent.actions;
+    if (actions.size() < thrashingThreshold)
+      return false;
+
+    CODES lastAct = actions.back();
+    bool thrashing = lastAct == CODES::LEFT || lastAct == CODES::RIGHT;
+    for (std::size_t i = 2; i < thrashingThreshold + 1 && thrashing; ++i) {
+      thrashing = (actions[actions.size() - i] == CODES::RIGHT &&
+                   lastAct == CODES::LEFT) ||
+                  (actions[actions.size() - i] == CODES::LEFT &&
+                   lastAct == CODES::RIGHT);
+      lastAct = actions[actions.size() - i];
+    }
+    return thrashing;
+  }
+
+  CODES nextActionAlong(Agent& agent, const core::RigidState& state) const {
+    CODES nextAction;
+    if (fixThrashing && agent.thrashingActions.size() > 0) {
+      nextAction = agent.thrashingActions.back();
+      agent.thrashingActions.pop_back();
+    } else {
+      const std::vector<CODES> nextActions = nextBestPrimAlong(agent, state);
+      if (nextActions.size() == 0) {
+        nextAction = CODES::ERROR;
+      } else if (fixThrashing && isThrashing(agent)) {
+        agent.thrashingActions = {nextActions.rbegin(), nextActions.rend()};
+        nextAction = agent.thrashingActions.back();
+        agent.thrashingActions.pop_back();
+      } else {
+        nextAction = nextActions[0];
+      }
+    }
+    agent.actions.push_back(nextAction);
+    return nextAction;
+  }
+
+  // Same as GreedyGeodesicFollowerImpl::findPath()
+  std::vector<CODES> findPath(Agent& agent, core::RigidState state) const {
+    constexpr std::size_t maxActions = 5e3;
+    std::vector<CODES>& actions = agent.actions;
+    do {
+      const std::vector<CODES> nextPrim = nextBestPrimAlong(agent, state);
+      if (nextPrim.size() == 0) {
+        actions.emplace_back(CODES::ERROR);
+      } else {
+        for (const CODES nextAction : nextPrim) {
+          switch (nextAction) {
+            case CODES::FORWARD:
+              moveForward(state);
+              break;
+
+            case CODES::RIGHT:
+              turn(state, -turnAmount);
+              break;
+
+            case CODES::LEFT:
+              turn(state, turnAmount);
+              break;
+
+            default:
+              break;
+          }
+          actions.emplace_back(nextAction);
+        }
+      }
+    } while (actions.back() != CODES::STOP && actions.back() != CODES::ERROR &&
+             actions.size() < maxActions);
+
+    if (actions.back() == CODES::ERROR || actions.size() >= maxActions)
+      return {};
+    return actions;
+  }
+
+  template <class F>
+  void forEachAgent(const std::size_t count, F&& f) {
+    core::ThreadPool& pool = core::ThreadPool::shared();
+    const std::size_t workers = pool.numWorkers(count, pool.numThreads() + 1);
+    if (workers == 1) {
+      for (std::size_t i = 0; i < count; ++i)
+        f(i, 0);
+    } else {
+      pool.parallelFor(count, workers, f);
+    }
+  }
+};
+
+BatchedGreedyGeodesicFollower::BatchedGreedyGeodesicFollower(
+    PathFinder::ptr pathfinder,
+    double goalDist,
+    double forwardAmount,
+    double turnAmount,
+    bool allowSliding,
+    bool fixThrashing,
+    int thrashingThreshold,
+    float memoResolution)
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {
+  CORRADE_ASSERT(memoResolution > 0,
+                 "BatchedGreedyGeodesicFollower: expected a positive memo "
+                 "resolution, got"
+                     << memoResolution, );
+  pimpl_->pathfinder = std::move(pathfinder);
+  pimpl_->goalDist = goalDist;
+  pimpl_->forwardAmount = forwardAmount;
+  pimpl_->turnAmount = turnAmount;
+  pimpl_->allowSliding = allowSliding;
+  pimpl_->fixThrashing = fixThrashing;
+  pimpl_->thrashingThreshold = thrashingThreshold;
+  pimpl_->memoResolution = memoResolution;
+}
+
+std::vector<BatchedGreedyGeodesicFollower::CODES>
+BatchedGreedyGeodesicFollower::nextActionsAlong(
+    const std::vector<core::RigidState>& states,
+    const std::vector<Mn::Vector3>& goals) {
+  CORRADE_ASSERT(states.size() == goals.size(),
+                 "BatchedGreedyGeodesicFollower::nextActionsAlong(): got"
+                     << states.size() << "states but" << goals.size()
+                     << "goals",
+                 {});
+  pimpl_->resize(states.size());
+  std::vector<CODES> actions(states.size());
+  pimpl_->forEachAgent(states.size(), [&](const std::size_t i, std::size_t) {
+    Impl::Agent& agent = pimpl_->agents[i];
+    pimpl_->setGoal(agent, goals[i]);
+    actions[i] = pimpl_->nextActionAlong(agent, states[i]);
+  });
+  return actions;
+}
+
+std::vector<std::vector<BatchedGreedyGeodesicFollower::CODES>>
+BatchedGreedyGeodesicFollower::findPaths(
+    const std::vector<core::RigidState>& starts,
+    const std::vector<Mn::Vector3>& goals) {
+  CORRADE_ASSERT(starts.size() == goals.size(),
+                 "BatchedGreedyGeodesicFollower::findPaths(): got"
+                     << starts.size() << "starts but" << goals.size()
+                     << "goals",
+                 {});
+  pimpl_->resize(starts.size());
+  std::vector<std::vector<CODES>> paths(starts.size());
+  pimpl_->forEachAgent(starts.size(), [&](const std::size_t i, std::size_t) {
+    Impl::Agent& agent = pimpl_->agents[i];
+    Impl::resetAgent(agent);
+    pimpl_->setGoal(agent, goals[i]);
+    paths[i] = pimpl_->findPath(agent, starts[i]);
+  });
+  return paths;
+}
+
+void BatchedGreedyGeodesicFollower::reset() {
+  for (Impl::Agent& agent : pimpl_->agents)
+    Impl::resetAgent(agent);
+}
+
+void BatchedGreedyGeodesicFollower::reset(const std::size_t agent) {
+  if (agent < pimpl_->agents.size())
+    Impl::resetAgent(pimpl_->agents[agent]);
+}
+
 }  // namespace nav
 }  // namespace esp
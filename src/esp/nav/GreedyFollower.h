@@ -162,6 +162,90 @@ class GreedyGeodesicFollowerImpl {
   ESP_SMART_POINTERS(GreedyGeodesicFollowerImpl)
 };
 
+/**
+ * @brief @ref GreedyGeodesicFollowerImpl for many agents at once, e.g. the
+ * oracle actions of all environments of a batch
+ *
+ * The primitives and the reward are the same, but the actions are applied
+ * natively instead of through python: "move_forward" moves along the -Z axis
+ * of the agent and goes through @ref PathFinder::tryStep() like the step
+ * filter of the simulator, "turn_left" and "turn_right" rotate around the Y
+ * axis.
+ *
+ * The agents are planned in parallel on the @ref core::ThreadPool::shared()
+ * pool. Each agent has its own history to fix thrashing and a memo of the
+ * geodesic and obstacle distances of the positions it evaluated, which the
+ * primitives of consecutive steps mostly share.
+ */
+class BatchedGreedyGeodesicFollower {
+ public:
+  typedef GreedyGeodesicFollowerImpl::CODES CODES;
+
+  /**
+   * @brief Constructor
+   *
+   * @param[in] pathfinder Instance of the pathfinder used for calculating the
+   *                       geodesic shortest path
+   * @param[in] goalDist How close the agents need to get to the goal before
+   *                     calling stop
+   * @param[in] forwardAmount The amount "move_forward" moves the agents
+   * @param[in] turnAmount The amount "turn_left"/"turn_right" turns the
+   *                       agents in radians
+   * @param[in] allowSliding Whether "move_forward" slides along obstacles, as
+   *                         the allow_sliding setting of the simulator
+   * @param[in] fixThrashing Whether or not to fix thrashing
+   * @param[in] thrashingThreshold The length of left, right, left, right
+   *                               actions needed to be considered thrashing
+   * @param[in] memoResolution Positions closer than this share their memoized
+   *                           distances
+   */
+  BatchedGreedyGeodesicFollower(PathFinder::ptr pathfinder,
+                                double goalDist,
+                                double forwardAmount,
+                                double turnAmount,
+                                bool allowSliding = true,
+                                bool fixThrashing = true,
+                                int thrashingThreshold = 16,
+                                float memoResolution = 1e-4f);
+
+  /**
+   * @brief Calculates the next action of every agent to follow its path
+   *
+   * Agent @p i keeps its history and memo between calls while its goal stays
+   * the same, as for @ref GreedyGeodesicFollowerImpl::nextActionAlong().
+   *
+   * @param[in] states The current state of each agent
+   * @param[in] goals The goal of each agent, as many as @p states
+   *
+   * @return The next action of each agent
+   */
+  std::vector<CODES> nextActionsAlong(
+      const std::vector<core::RigidState>& states,
+      const std::vector<Magnum::Vector3>& goals);
+
+  /**
+   * @brief Finds the full path of every agent to its goal, see @ref
+   * GreedyGeodesicFollowerImpl::findPath()
+   *
+   * @param[in] starts The starting state of each agent
+   * @param[in] goals The goal of each agent, as many as @p starts
+   *
+   * @return The actions of each agent, empty for the agents that can't reach
+   * their goal
+   */
+  std::vector<std::vector<CODES>> findPaths(
+      const std::vector<core::RigidState>& starts,
+      const std::vector<Magnum::Vector3>& goals);
+
+  /** @brief Reset the planner of all agents */
+  void reset();
+
+  /** @brief Reset the planner of one agent, e.g. when its episode ends */
+  void reset(std::size_t agent);
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(BatchedGreedyGeodesicFollower)
+};
+
 }  // namespace nav
 }  // namespace esp
 
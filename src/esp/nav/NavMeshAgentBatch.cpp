@@ -0,0 +1,177 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "esp/nav/NavMeshAgentBatch.h"
+
+#include <Magnum/Math/Quaternion.h>
+
+#include "esp/core/ThreadPool.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace nav {
+
+namespace {
+// Same as in the agent controls, a move that got shorter collided
+constexpr float collisionEps = 1e-5f;
+}  // namespace
+
+struct NavMeshAgentBatch::Impl {
+  struct Action {
+    NavMeshMotion motion;
+    float amount;
+  };
+
+  PathFinder::ptr pathfinder;
+  bool allowSliding;
+  std::vector<Action> actions;
+  std::vector<core::RigidState> states;
+  // Whether the state of an agent changed since its node was synced
+  std::vector<char> dirty;
+
+  // Moves state by action, returns whether it collided
+  bool apply(const Action& action, core::RigidState& state) const {
+    Mn::Vector3 direction;
+    switch (action.motion) {
+      case NavMeshMotion::TurnLeft:
+      case NavMeshMotion::TurnRight: {
+        const float angle = action.motion == NavMeshMotion::TurnLeft
+                                ? action.amount
+                                : -action.amount;
+        state.rotation =
+            (state.rotation *
+             Mn::Quaternion::rotation(Mn::Deg{angle}, Mn::Vector3::yAxis()))
+                .normalized();
+        return false;
+      }
+      case NavMeshMotion::MoveForward:
+        direction = -Mn::Vector3::zAxis();
+        break;
+      case NavMeshMotion::MoveBackward:
+        direction = Mn::Vector3::zAxis();
+        break;
+      case NavMeshMotion::MoveLeft:
+        direction = -Mn::Vector3::xAxis();
+        break;
+      case NavMeshMotion::MoveRight:
+        direction = Mn::Vector3::xAxis();
+        break;
+    }
+
+    const Mn::Vector3 start = state.translation;
+    const Mn::Vector3 end =
+        start + state.rotation.transformVector(direction * action.amount);
+    state.translation = allowSliding ? pathfinder->tryStep(start, end)
+                                     : pathfinder->tryStepNoSliding(start, end);
+    return (state.translation - start).dot() + collisionEps <
+           (end - start).dot();
+  }
+};
+
+NavMeshAgentBatch::NavMeshAgentBatch(PathFinder::ptr pathfinder,
+                                     const std::size_t numAgents,
+                                     const bool allowSliding)
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {
+  pimpl_->pathfinder = std::move(pathfinder);
+  pimpl_->allowSliding = allowSliding;
+  pimpl_->states.resize(numAgents);
+  pimpl_->dirty.assign(numAgents, true);
+}
+
+int NavMeshAgentBatch::addAction(const NavMeshMotion motion,
+                                 const float amount) {
+  pimpl_->actions.push_back({motion, amount});
+  return pimpl_->actions.size() - 1;
+}
+
+int NavMeshAgentBatch::numActions() const {
+  return pimpl_->actions.size();
+}
+
+std::size_t NavMeshAgentBatch::numAgents() const {
+  return pimpl_->states.size();
+}
+
+const std::vector<core::RigidState>& NavMeshAgentBatch::states() const {
+  return pimpl_->states;
+}
+
+void NavMeshAgentBatch::setStates(const std::vector<core::RigidState>& states) {
+  pimpl_->states = states;
+  pimpl_->dirty.assign(states.size(), true);
+}
+
+const core::RigidState& NavMeshAgentBatch::state(
+    const std::size_t agent) const {
+  CORRADE_ASSERT(agent < pimpl_->states.size(),
+                 "NavMeshAgentBatch::state(): agent" << agent
+                                                     << "out of range",
+                 pimpl_->states.front());
+  return pimpl_->states[agent];
+}
+
+void NavMeshAgentBatch::setState(const std::size_t agent,
+                                 const core::RigidState& state) {
+  CORRADE_ASSERT(agent < pimpl_->states.size(),
+                 "NavMeshAgentBatch::setState(): agent" << agent
+                                                        << "out of range", );
+  pimpl_->states[agent] = state;
+  pimpl_->dirty[agent] = true;
+}
+
+std::vector<bool> NavMeshAgentBatch::step(const std::vector<int>& actions) {
+  CORRADE_ASSERT(actions.size() == pimpl_->states.size(),
+                 "NavMeshAgentBatch::step(): got" << actions.size()
+                                                  << "actions for"
+                                                  << pimpl_->states.size()
+                                                  << "agents",
+                 {});
+  for (const int action : actions) {
+    CORRADE_ASSERT(action < numActions(),
+                   "NavMeshAgentBatch::step(): action"
+                       << action << "out of range for" << numActions()
+                       << "actions",
+                   {});
+  }
+
+  // std::vector<bool> packs bits, which the workers can't write concurrently
+  std::vector<char> collided(actions.size(), false);
+  auto stepAgent = [&](const std::size_t agent, std::size_t) {
+    if (actions[agent] < 0)
+      return;
+    collided[agent] =
+        pimpl_->apply(pimpl_->actions[actions[agent]], pimpl_->states[agent]);
+    pimpl_->dirty[agent] = true;
+  };
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers =
+      pool.numWorkers(actions.size(), pool.numThreads() + 1);
+  if (workers == 1) {
+    for (std::size_t agent = 0; agent < actions.size(); ++agent)
+      stepAgent(agent, 0);
+  } else {
+    pool.parallelFor(actions.size(), workers, stepAgent);
+  }
+  return {collided.begin(), collided.end()};
+}
+
+bool NavMeshAgentBatch::syncNode(const std::size_t agent,
+                                 scene::SceneNode& node) {
+  CORRADE_ASSERT(agent < pimpl_->states.size(),
+                 "NavMeshAgentBatch::syncNode(): agent" << agent
+                                                        << "out of range",
+                 false);
+  if (!pimpl_->dirty[agent])
+    return false;
+  const core::RigidState& state = pimpl_->states[agent];
+  node.setTranslation(state.translation);
+  node.setRotation(state.rotation);
+  pimpl_->dirty[agent] = false;
+  return true;
+}
+
+}  // namespace nav
+}  // namespace esp
@@ -0,0 +1,118 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_NAV_NAVMESHAGENTBATCH_H_
+#define ESP_NAV_NAVMESHAGENTBATCH_H_
+
+/** @file
+ * @brief Class @ref esp::nav::NavMeshAgentBatch, enum @ref
+ * esp::nav::NavMeshMotion
+ */
+
+#include <vector>
+
+#include "esp/core/RigidState.h"
+#include "esp/core/esp.h"
+#include "esp/nav/PathFinder.h"
+#include "esp/scene/SceneNode.h"
+
+namespace esp {
+namespace nav {
+
+/**
+ * @brief Body motions of @ref NavMeshAgentBatch, the same as the
+ * move_forward, move_backward, move_left, move_right, turn_left and
+ * turn_right controls of the agents
+ */
+enum class NavMeshMotion : int {
+  MoveForward = 0,
+  MoveBackward = 1,
+  MoveLeft = 2,
+  MoveRight = 3,
+  TurnLeft = 4,
+  TurnRight = 5
+};
+
+/**
+ * @brief Steps many agents on the navmesh alone, without sensors or a scene
+ * graph
+ *
+ * For blind agents and path statistics, which don't render. The states of the
+ * agents are a flat array, every step moves all of them at once on the
+ * @ref core::ThreadPool::shared() pool and filters the moves with
+ * @ref PathFinder::tryStep() or @ref PathFinder::tryStepNoSliding(), as the
+ * move filter of the agent controls does. The scene nodes of the agents are
+ * only updated by @ref syncNode(), when they're about to be rendered.
+ */
+class NavMeshAgentBatch {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] pathfinder Pathfinder with the navmesh the agents move on
+   * @param[in] numAgents The number of agents, all at the origin
+   * @param[in] allowSliding Whether the moves slide along obstacles, as the
+   *                         allow_sliding setting of the simulator
+   */
+  NavMeshAgentBatch(PathFinder::ptr pathfinder,
+                    std::size_t numAgents,
+                    bool allowSliding = true);
+
+  /**
+   * @brief Add an action the agents can take
+   *
+   * @param[in] motion The motion of the action
+   * @param[in] amount The distance moved, or the angle turned in degrees
+   *
+   * @return The index of the action in @ref step()
+   */
+  int addAction(NavMeshMotion motion, float amount);
+
+  /** @brief The number of actions added */
+  int numActions() const;
+
+  /** @brief The number of agents */
+  std::size_t numAgents() const;
+
+  /** @brief The state of every agent */
+  const std::vector<core::RigidState>& states() const;
+
+  /**
+   * @brief Set the state of every agent
+   *
+   * Also sets the number of agents to the size of @p states.
+   */
+  void setStates(const std::vector<core::RigidState>& states);
+
+  /** @brief The state of one agent */
+  const core::RigidState& state(std::size_t agent) const;
+
+  /** @brief Set the state of one agent, e.g. at the start of its episode */
+  void setState(std::size_t agent, const core::RigidState& state);
+
+  /**
+   * @brief Take one action with every agent
+   *
+   * @param[in] actions The index from @ref addAction() of the action of each
+   *                    agent, negative for the agents that don't move
+   *
+   * @return Whether the move of each agent was shortened by an obstacle
+   */
+  std::vector<bool> step(const std::vector<int>& actions);
+
+  /**
+   * @brief Write the state of an agent to its scene node, if it changed since
+   * the last call
+   *
+   * @return Whether the node was updated
+   */
+  bool syncNode(std::size_t agent, scene::SceneNode& node);
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(NavMeshAgentBatch)
+};
+
+}  // namespace nav
+}  // namespace esp
+
+#endif  // ESP_NAV_NAVMESHAGENTBATCH_H_
@@ -3,7 +3,13 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "PathFinder.h"
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <list>
+#include <map>
 #include <numeric>
+#include <queue>
 #include <stack>
 #include <unordered_map>
 
@@ -16,17 +22,28 @@
 #include <Corrade/Containers/Optional.h>
 
 #include <cstdio>
+#include <cstring>
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <limits>
+#include <mutex>
 
 #include "esp/assets/MeshData.h"
+#include "esp/core/AsyncLog.h"
+#include "esp/core/MappedFile.h"
+#include "esp/core/PerfStats.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/ThreadPool.h"
+#include "esp/core/random.h"
 #include "esp/core/esp.h"
 
+#include "DetourCommon.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshBuilder.h"
 #include "DetourNavMeshQuery.h"
 #include "DetourNode.h"
+#include "DetourTileCache.h"
+#include "DetourTileCacheBuilder.h"
 #include "Recast.h"
 
 namespace Mn = Magnum;
@@ -35,14 +52,240 @@ namespace Cr = Corrade;
 namespace esp {
 namespace nav {
 
+namespace impl {
+
+// Nodes at the vertices and along the edges of the walkable polygons of a
+// navmesh, as the polygons are convex a straight line joins any two nodes of
+// a polygon. Geodesic distances are shortest paths through the nodes.
+struct NodeGraph {
+  NodeGraph(const dtNavMesh* navMesh,
+            const dtQueryFilter* filter,
+            const float nodeSpacing);
+
+  std::vector<dtPolyRef> polys;
+  std::unordered_map<dtPolyRef, int> polyIndex;
+  std::vector<vec3f> nodes;
+  //! The nodes of each polygon and the polygons of each node
+  std::vector<std::vector<int>> polyNodes;
+  std::vector<std::vector<int>> nodePolys;
+};
+
+NodeGraph::NodeGraph(const dtNavMesh* navMesh,
+                     const dtQueryFilter* filter,
+                     const float nodeSpacing) {
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPoly* poly = &tile->polys[jPoly];
+      const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter->passFilter(ref, tile, poly))
+        continue;
+      polyIndex.emplace(ref, polys.size());
+      polys.push_back(ref);
+    }
+  }
+
+  // The nodes at the same place, to the millimeter, are shared between
+  // polygons. The edges are split from their lexicographically smaller end so
+  // that both polygons along an edge split it the same way.
+  std::map<std::array<int, 3>, int> nodeAt;
+  const auto addNode = [&](const vec3f& position) {
+    const std::array<int, 3> key{
+        static_cast<int>(std::lround(position[0] * 1000.0f)),
+        static_cast<int>(std::lround(position[1] * 1000.0f)),
+        static_cast<int>(std::lround(position[2] * 1000.0f))};
+    const auto inserted = nodeAt.emplace(key, nodes.size());
+    if (inserted.second)
+      nodes.push_back(position);
+    return inserted.first->second;
+  };
+  const auto vertex = [](const dtMeshTile* tile, const dtPoly* poly,
+                         const int i) {
+    return vec3f{Eigen::Map<const vec3f>(&tile->verts[poly->verts[i] * 3])};
+  };
+  // edgeNodes[i][j] are the nodes along edge j of polygon i
+  std::vector<std::vector<std::vector<int>>> edgeNodes(polys.size());
+  polyNodes.resize(polys.size());
+  for (std::size_t i = 0; i < polys.size(); ++i) {
+    const dtMeshTile* tile = nullptr;
+    const dtPoly* poly = nullptr;
+    navMesh->getTileAndPolyByRefUnsafe(polys[i], &tile, &poly);
+    edgeNodes[i].resize(poly->vertCount);
+    for (int j = 0; j < poly->vertCount; ++j) {
+      const vec3f a = vertex(tile, poly, j);
+      const vec3f b = vertex(tile, poly, (j + 1) % poly->vertCount);
+      const bool reversed = std::lexicographical_compare(
+          b.data(), b.data() + 3, a.data(), a.data() + 3);
+      const vec3f& from = reversed ? b : a;
+      const vec3f& to = reversed ? a : b;
+      const int numSegments = std::max(
+          1, static_cast<int>(std::ceil((to - from).norm() / nodeSpacing)));
+      for (int k = 0; k <= numSegments; ++k) {
+        edgeNodes[i][j].push_back(
+            addNode(from + (to - from) * (float(k) / numSegments)));
+      }
+      polyNodes[i].insert(polyNodes[i].end(), edgeNodes[i][j].begin(),
+                          edgeNodes[i][j].end());
+    }
+  }
+
+  // Polygons of different tiles may split their common edge differently, so
+  // the nodes of a neighbor along the edge are nodes of the polygon too
+  for (std::size_t i = 0; i < polys.size(); ++i) {
+    const dtMeshTile* tile = nullptr;
+    const dtPoly* poly = nullptr;
+    navMesh->getTileAndPolyByRefUnsafe(polys[i], &tile, &poly);
+    for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+         iLink = tile->links[iLink].next) {
+      const dtLink& link = tile->links[iLink];
+      const auto neighbor = polyIndex.find(link.ref);
+      if (neighbor == polyIndex.end())
+        continue;
+      const dtMeshTile* neighborTile = nullptr;
+      const dtPoly* neighborPoly = nullptr;
+      navMesh->getTileAndPolyByRefUnsafe(link.ref, &neighborTile,
+                                         &neighborPoly);
+      const vec3f a = vertex(tile, poly, link.edge);
+      const vec3f ab =
+          vertex(tile, poly, (link.edge + 1) % poly->vertCount) - a;
+      for (unsigned int jLink = neighborPoly->firstLink;
+           jLink != DT_NULL_LINK; jLink = neighborTile->links[jLink].next) {
+        const dtLink& backLink = neighborTile->links[jLink];
+        if (backLink.ref != polys[i])
+          continue;
+        for (const int node : edgeNodes[neighbor->second][backLink.edge]) {
+          const float t = (nodes[node] - a).dot(ab) / ab.squaredNorm();
+          if (t > -1e-3f && t < 1.0f + 1e-3f)
+            polyNodes[i].push_back(node);
+        }
+      }
+    }
+    std::sort(polyNodes[i].begin(), polyNodes[i].end());
+    polyNodes[i].erase(std::unique(polyNodes[i].begin(), polyNodes[i].end()),
+                       polyNodes[i].end());
+  }
+
+  nodePolys.resize(nodes.size());
+  for (std::size_t i = 0; i < polys.size(); ++i) {
+    for (const int node : polyNodes[i])
+      nodePolys[node].push_back(i);
+  }
+}
+
+// Dijkstra over a NodeGraph from goals, run only as far as the queries need
+// so that it can be resumed for later queries. Every node also gets the
+// closest goal.
+class GraphSearch {
+ public:
+  struct Goal {
+    vec3f position;
+    int index;
+  };
+
+  explicit GraphSearch(std::shared_ptr<const NodeGraph> graph)
+      : graph_{std::move(graph)},
+        distances_(graph_->nodes.size(),
+                   std::numeric_limits<float>::infinity()),
+        closestGoals_(graph_->nodes.size(), ID_UNDEFINED),
+        polyGoals_(graph_->polys.size()) {}
+
+  const std::shared_ptr<const NodeGraph>& graph() const { return graph_; }
+
+  // Tentative distances, final for the whole graph after run()
+  const std::vector<float>& distances() const { return distances_; }
+  const std::vector<Goal>& polyGoals(const int poly) const {
+    return polyGoals_[poly];
+  }
+
+  void addGoal(const int poly, const vec3f& goal, const int index = 0) {
+    polyGoals_[poly].push_back({goal, index});
+    for (const int node : graph_->polyNodes[poly])
+      relax(node, (graph_->nodes[node] - goal).norm(), index);
+  }
+
+  void run() {
+    while (settleNext()) {
+    }
+  }
+
+  // The distance of a point in a polygon to the closest goal, searching only
+  // until no node left could be on a shorter path
+  float distance(const int poly, const vec3f& pt, int* closestGoal = nullptr) {
+    float distance = std::numeric_limits<float>::infinity();
+    int goalIndex = ID_UNDEFINED;
+    const auto update = [&](const float candidate, const int index) {
+      if (candidate < distance) {
+        distance = candidate;
+        goalIndex = index;
+      }
+    };
+    for (const Goal& goal : polyGoals_[poly])
+      update((pt - goal.position).norm(), goal.index);
+    const auto nodesDistance = [&] {
+      for (const int node : graph_->polyNodes[poly])
+        update((pt - graph_->nodes[node]).norm() + distances_[node],
+               closestGoals_[node]);
+    };
+    nodesDistance();
+    while (!queue_.empty() && queue_.top().first < distance) {
+      settleNext();
+      nodesDistance();
+    }
+    if (closestGoal)
+      *closestGoal = goalIndex;
+    return distance;
+  }
+
+ private:
+  void relax(const int node, const float distance, const int goal) {
+    if (distance < distances_[node]) {
+      distances_[node] = distance;
+      closestGoals_[node] = goal;
+      queue_.emplace(distance, node);
+    }
+  }
+
+  bool settleNext() {
+    if (queue_.empty())
+      return false;
+    const QueueEntry top = queue_.top();
+    queue_.pop();
+    if (top.first > distances_[top.second])
+      return true;
+    const vec3f& position = graph_->nodes[top.second];
+    const int goal = closestGoals_[top.second];
+    for (const int poly : graph_->nodePolys[top.second]) {
+      for (const int node : graph_->polyNodes[poly])
+        relax(node, top.first + (graph_->nodes[node] - position).norm(), goal);
+    }
+    return true;
+  }
+
+  typedef std::pair<float, int> QueueEntry;
+  std::shared_ptr<const NodeGraph> graph_;
+  std::vector<float> distances_;
+  std::vector<int> closestGoals_;
+  std::vector<std::vector<Goal>> polyGoals_;
+  std::priority_queue<QueueEntry,
+                      std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue_;
+};
+
+}  // namespace impl
+
 struct MultiGoalShortestPath::Impl {
   std::vector<vec3f> requestedEnds;
 
   std::vector<dtPolyRef> endRefs;
   std::vector<vec3f> pathEnds;
 
-  std::vector<float> minTheoreticalDist;
-  vec3f prevRequestedStart = vec3f::Zero();
+  //! A backward search from all ends, resumed by every query, to tell which
+  //! ends Detour needs to find a path to
+  Cr::Containers::Optional<impl::GraphSearch> search;
 };
 
 MultiGoalShortestPath::MultiGoalShortestPath()
@@ -53,14 +296,131 @@ void MultiGoalShortestPath::setRequestedEnds(
   pimpl_->endRefs.clear();
   pimpl_->pathEnds.clear();
   pimpl_->requestedEnds = newEnds;
-
-  pimpl_->minTheoreticalDist.assign(newEnds.size(), 0);
+  pimpl_->search = Cr::Containers::NullOpt;
 }
 
 const std::vector<vec3f>& MultiGoalShortestPath::getRequestedEnds() const {
   return pimpl_->requestedEnds;
 }
 
+struct GeodesicDistanceField::Impl {
+  std::vector<vec3f> goals;
+  float nodeSpacing = 0;
+
+  //! The number of polygons and the area of the navmesh the field was built
+  //! on, to tell it from other navmeshes
+  int numNavMeshPolys = 0;
+  float navMeshArea = 0;
+
+  //! The sorted polygons from which a goal is reachable, and the first of
+  //! their nodes in nodes, followed by the number of nodes
+  std::vector<uint64_t> polyRefs;
+  std::vector<uint32_t> polyNodeOffsets;
+
+  //! The nodes of each polygon and their distance to the closest goal
+  std::vector<vec3f> nodes;
+  std::vector<float> nodeDistances;
+};
+
+GeodesicDistanceField::GeodesicDistanceField()
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {};
+
+const std::vector<vec3f>& GeodesicDistanceField::getGoals() const {
+  return pimpl_->goals;
+}
+
+float GeodesicDistanceField::getNodeSpacing() const {
+  return pimpl_->nodeSpacing;
+}
+
+namespace {
+const int DISTANCEFIELD_MAGIC = 'G' << 24 | 'D' << 16 | 'F' << 8 | 'D';
+const int DISTANCEFIELD_VERSION = 1;
+
+struct DistanceFieldHeader {
+  int magic;
+  int version;
+  int numNavMeshPolys;
+  float navMeshArea;
+  float nodeSpacing;
+  uint32_t numGoals;
+  uint32_t numPolys;
+  uint32_t numNodes;
+};
+}  // namespace
+
+bool GeodesicDistanceField::save(const std::string& path) const {
+  FILE* fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+
+  DistanceFieldHeader header{};
+  header.magic = DISTANCEFIELD_MAGIC;
+  header.version = DISTANCEFIELD_VERSION;
+  header.numNavMeshPolys = pimpl_->numNavMeshPolys;
+  header.navMeshArea = pimpl_->navMeshArea;
+  header.nodeSpacing = pimpl_->nodeSpacing;
+  header.numGoals = pimpl_->goals.size();
+  header.numPolys = pimpl_->polyRefs.size();
+  header.numNodes = pimpl_->nodes.size();
+
+  const bool success =
+      fwrite(&header, sizeof(header), 1, fp) == 1 &&
+      fwrite(pimpl_->goals.data(), sizeof(vec3f), header.numGoals, fp) ==
+          header.numGoals &&
+      fwrite(pimpl_->polyRefs.data(), sizeof(uint64_t), header.numPolys,
+             fp) == header.numPolys &&
+      fwrite(pimpl_->polyNodeOffsets.data(), sizeof(uint32_t),
+             header.numPolys + 1, fp) == header.numPolys + 1 &&
+      fwrite(pimpl_->nodes.data(), sizeof(vec3f), header.numNodes, fp) ==
+          header.numNodes &&
+      fwrite(pimpl_->nodeDistances.data(), sizeof(float), header.numNodes,
+             fp) == header.numNodes;
+  fclose(fp);
+  return success;
+}
+
+GeodesicDistanceField::ptr GeodesicDistanceField::load(
+    const std::string& path) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (!fp)
+    return nullptr;
+
+  DistanceFieldHeader header{};
+  if (fread(&header, sizeof(header), 1, fp) != 1 ||
+      header.magic != DISTANCEFIELD_MAGIC ||
+      header.version != DISTANCEFIELD_VERSION) {
+    fclose(fp);
+    return nullptr;
+  }
+
+  auto field = GeodesicDistanceField::create();
+  Impl& impl = *field->pimpl_;
+  impl.numNavMeshPolys = header.numNavMeshPolys;
+  impl.navMeshArea = header.navMeshArea;
+  impl.nodeSpacing = header.nodeSpacing;
+  impl.goals.resize(header.numGoals);
+  impl.polyRefs.resize(header.numPolys);
+  impl.polyNodeOffsets.resize(header.numPolys + 1);
+  impl.nodes.resize(header.numNodes);
+  impl.nodeDistances.resize(header.numNodes);
+
+  const bool success =
+      fread(impl.goals.data(), sizeof(vec3f), header.numGoals, fp) ==
+          header.numGoals &&
+      fread(impl.polyRefs.data(), sizeof(uint64_t), header.numPolys, fp) ==
+          header.numPolys &&
+      fread(impl.polyNodeOffsets.data(), sizeof(uint32_t),
+            header.numPolys + 1, fp) == header.numPolys + 1 &&
+      fread(impl.nodes.data(), sizeof(vec3f), header.numNodes, fp) ==
+          header.numNodes &&
+      fread(impl.nodeDistances.data(), sizeof(float), header.numNodes, fp) ==
+          header.numNodes &&
+      impl.polyNodeOffsets.back() == header.numNodes;
+  fclose(fp);
+  return success ? field : nullptr;
+}
+
 namespace {
 template <typename T>
 std::tuple<dtStatus, dtPolyRef, vec3f> projectToPoly(
@@ -84,6 +444,87 @@ std::tuple<dtStatus, dtPolyRef, vec3f> projectToPoly(
 
   return std::make_tuple(status, polyRef, polyXYZ);
 }
+
+struct Triangle {
+  std::vector<vec3f> v;
+  Triangle() { v.resize(3); }
+};
+
+std::vector<Triangle> getPolygonTriangles(const dtPoly* poly,
+                                          const dtMeshTile* tile) {
+  // Code to iterate over triangles from here:
+  // https://github.com/recastnavigation/recastnavigation/blob/57610fa6ef31b39020231906f8c5d40eaa8294ae/Detour/Source/DetourNavMesh.cpp#L684
+  const std::ptrdiff_t ip = poly - tile->polys;
+  const dtPolyDetail* pd = &tile->detailMeshes[ip];
+  std::vector<Triangle> triangles(pd->triCount);
+
+  for (int j = 0; j < pd->triCount; ++j) {
+    const unsigned char* t = &tile->detailTris[(pd->triBase + j) * 4];
+    const float* v[3];
+    for (int k = 0; k < 3; ++k) {
+      if (t[k] < poly->vertCount)
+        triangles[j].v[k] =
+            Eigen::Map<const vec3f>(&tile->verts[poly->verts[t[k]] * 3]);
+      else
+        triangles[j].v[k] = Eigen::Map<const vec3f>(
+            &tile->detailVerts[(pd->vertBase + (t[k] - poly->vertCount)) * 3]);
+    }
+  }
+
+  return triangles;
+}
+
+// Calculate the area of a polygon by iterating over the triangles in the detail
+// mesh and computing their area
+float polyArea(const dtPoly* poly, const dtMeshTile* tile) {
+  std::vector<Triangle> triangles = getPolygonTriangles(poly, tile);
+
+  float area = 0;
+  for (auto& tri : triangles) {
+    const vec3f w1 = tri.v[1] - tri.v[0];
+    const vec3f w2 = tri.v[2] - tri.v[1];
+    area += 0.5 * w1.cross(w2).norm();
+  }
+
+  return area;
+}
+
+// The detail triangles of all polygons that pass the filter, off-mesh
+// connections aside, and keep if it's set
+std::vector<std::array<vec3f, 3>> walkableDetailTriangles(
+    const dtNavMesh* navMesh,
+    const dtQueryFilter* filter,
+    const std::function<bool(dtPolyRef)>& keep = nullptr) {
+  std::vector<std::array<vec3f, 3>> triangles;
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPoly* poly = &tile->polys[jPoly];
+      const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter->passFilter(ref, tile, poly) || (keep && !keep(ref)))
+        continue;
+      const dtPolyDetail& detail = tile->detailMeshes[jPoly];
+      for (int k = 0; k < detail.triCount; ++k) {
+        const unsigned char* tri = &tile->detailTris[(detail.triBase + k) * 4];
+        std::array<vec3f, 3> triangle;
+        for (int v = 0; v < 3; ++v) {
+          const float* vertex =
+              tri[v] < poly->vertCount
+                  ? &tile->verts[poly->verts[tri[v]] * 3]
+                  : &tile->detailVerts[(detail.vertBase + tri[v] -
+                                        poly->vertCount) *
+                                       3];
+          triangle[v] = Eigen::Map<const vec3f>(vertex);
+        }
+        triangles.push_back(triangle);
+      }
+    }
+  }
+  return triangles;
+}
 }  // namespace
 
 namespace impl {
@@ -94,13 +535,17 @@ namespace impl {
 // Takes O(npolys) to construct
 class IslandSystem {
  public:
-  IslandSystem(const dtNavMesh* navMesh, const dtQueryFilter* filter) {
+  static constexpr uint32_t NO_ISLAND = std::numeric_limits<uint32_t>::max();
+
+  IslandSystem(const dtNavMesh* navMesh, const dtQueryFilter* filter)
+      : navMesh_{navMesh} {
+    initTiles();
     std::vector<vec3f> islandVerts;
 
     // Iterate over all tiles
     for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
       const dtMeshTile* tile = navMesh->getTile(iTile);
-      if (!tile)
+      if (!tile || !tile->header)
         continue;
 
       // Iterate over all polygons in a tile
@@ -111,9 +556,10 @@ class IslandSystem {
         // If the polygon ref is valid, and we haven't seen it yet,
         // start connected component analysis from this polygon
         if (navMesh->isValidPolyRef(startRef) &&
-            (polyToIsland_.find(startRef) == polyToIsland_.end())) {
+            tileIslands_[iTile][jPoly] == NO_ISLAND) {
           uint32_t newIslandId = islandRadius_.size();
-          expandFrom(navMesh, filter, newIslandId, startRef, islandVerts);
+          islandPolyOffsets_.push_back(islandPolys_.size());
+          expandFrom(filter, newIslandId, startRef, islandVerts);
 
           // The radius is calculated as the max deviation from the mean for all
           // points in the island
@@ -129,43 +575,191 @@ class IslandSystem {
           }
 
           islandRadius_.emplace_back(maxRadius);
+          islandArea_.emplace_back(islandPolyAreas_.back());
         }
       }
     }
+    islandPolyOffsets_.push_back(islandPolys_.size());
+  }
+
+  // Writes the islands, their polygons and radii for load()
+  void save(FILE* fp) const {
+    const uint32_t counts[]{static_cast<uint32_t>(islandRadius_.size()),
+                            static_cast<uint32_t>(islandPolys_.size())};
+    fwrite(counts, sizeof(counts), 1, fp);
+    fwrite(islandRadius_.data(), sizeof(float), islandRadius_.size(), fp);
+    for (const std::size_t offset : islandPolyOffsets_) {
+      const uint32_t offset32 = offset;
+      fwrite(&offset32, sizeof(offset32), 1, fp);
+    }
+    for (const dtPolyRef ref : islandPolys_) {
+      const uint64_t ref64 = ref;
+      fwrite(&ref64, sizeof(ref64), 1, fp);
+    }
+    fwrite(islandPolyAreas_.data(), sizeof(float), islandPolyAreas_.size(),
+           fp);
+  }
+
+  // Reads islands written by save() for the same navmesh, in O(npolys) but
+  // without the flood fill. Null if the data is truncated or doesn't match
+  // the polygons of the navmesh.
+  static std::unique_ptr<IslandSystem> load(
+      const dtNavMesh* navMesh,
+      Cr::Containers::ArrayView<const char> data) {
+    std::unique_ptr<IslandSystem> islands{new IslandSystem{navMesh}};
+    islands->initTiles();
+    uint32_t counts[2];
+    if (data.size() < sizeof(counts))
+      return nullptr;
+    std::memcpy(counts, data.data(), sizeof(counts));
+    const uint32_t numIslands = counts[0];
+    const uint32_t numPolys = counts[1];
+    if (data.size() != sizeof(counts) + numIslands * sizeof(float) +
+                           (numIslands + 1) * sizeof(uint32_t) +
+                           numPolys * (sizeof(uint64_t) + sizeof(float)))
+      return nullptr;
+    const char* it = data.data() + sizeof(counts);
+
+    islands->islandRadius_.resize(numIslands);
+    std::memcpy(islands->islandRadius_.data(), it, numIslands * sizeof(float));
+    it += numIslands * sizeof(float);
+    for (uint32_t i = 0; i <= numIslands; ++i, it += sizeof(uint32_t)) {
+      uint32_t offset;
+      std::memcpy(&offset, it, sizeof(offset));
+      // every island has at least one polygon
+      if ((i == 0 && offset != 0) ||
+          (i > 0 && offset <= islands->islandPolyOffsets_.back()) ||
+          (i == numIslands && offset != numPolys))
+        return nullptr;
+      islands->islandPolyOffsets_.push_back(offset);
+    }
+    for (uint32_t i = 0; i < numPolys; ++i, it += sizeof(uint64_t)) {
+      uint64_t ref;
+      std::memcpy(&ref, it, sizeof(ref));
+      islands->islandPolys_.push_back(ref);
+    }
+    islands->islandPolyAreas_.resize(numPolys);
+    std::memcpy(islands->islandPolyAreas_.data(), it,
+                numPolys * sizeof(float));
+
+    for (uint32_t i = 0; i < numIslands; ++i) {
+      const std::size_t last = islands->islandPolyOffsets_[i + 1] - 1;
+      islands->islandArea_.push_back(islands->islandPolyAreas_[last]);
+      for (std::size_t j = islands->islandPolyOffsets_[i]; j <= last; ++j) {
+        const dtPolyRef ref = islands->islandPolys_[j];
+        if (!navMesh->isValidPolyRef(ref) || islands->island(ref) != NO_ISLAND)
+          return nullptr;
+        islands->setIsland(ref, i);
+      }
+    }
+    return islands;
+  }
+
+  inline uint32_t island(dtPolyRef ref) const {
+    unsigned int salt, iTile, iPoly;
+    navMesh_->decodePolyId(ref, salt, iTile, iPoly);
+    if (iTile >= tileIslands_.size() || tileSalts_[iTile] != salt ||
+        iPoly >= tileIslands_[iTile].size())
+      return NO_ISLAND;
+    return tileIslands_[iTile][iPoly];
   }
 
   inline bool hasConnection(dtPolyRef startRef, dtPolyRef endRef) const {
     // If both polygons are on the same island, there must be a path between
     // them
-    auto itStart = polyToIsland_.find(startRef);
-    if (itStart == polyToIsland_.end())
-      return false;
-
-    auto itEnd = polyToIsland_.find(endRef);
-    if (itEnd == polyToIsland_.end())
-      return false;
-
-    return itStart->second == itEnd->second;
+    const uint32_t startIsland = island(startRef);
+    return startIsland != NO_ISLAND && startIsland == island(endRef);
   }
 
   inline float islandRadius(dtPolyRef ref) const {
-    auto itRef = polyToIsland_.find(ref);
-    if (itRef == polyToIsland_.end())
+    const uint32_t islandId = island(ref);
+    if (islandId == NO_ISLAND)
       return 0.0;
 
-    return islandRadius_[itRef->second];
+    return islandRadius_[islandId];
+  }
+
+  int numIslands() const { return islandRadius_.size(); }
+
+  float radiusOfIsland(uint32_t islandId) const {
+    return islandRadius_[islandId];
+  }
+
+  float islandArea(uint32_t islandId) const { return islandArea_[islandId]; }
+
+  // The island with the most area, NO_ISLAND if there is none
+  uint32_t largestIsland() const {
+    if (islandArea_.empty())
+      return NO_ISLAND;
+    return std::max_element(islandArea_.begin(), islandArea_.end()) -
+           islandArea_.begin();
+  }
+
+  // Picks a polygon of the island with a probability proportional to its area
+  // from a uniform number in [0, 1], 0 if the island has no area
+  dtPolyRef randomPoly(uint32_t islandId, float u) const {
+    const auto first = islandPolyAreas_.begin() + islandPolyOffsets_[islandId];
+    const auto last =
+        islandPolyAreas_.begin() + islandPolyOffsets_[islandId + 1];
+    if (islandArea_[islandId] <= 0.0f)
+      return 0;
+    auto it = std::upper_bound(first, last, u * islandArea_[islandId]);
+    if (it == last)
+      --it;
+    return islandPolys_[it - islandPolyAreas_.begin()];
   }
 
  private:
-  std::unordered_map<dtPolyRef, uint32_t> polyToIsland_;
+  const dtNavMesh* navMesh_;
+  std::vector<std::vector<uint32_t>> tileIslands_;
+  std::vector<unsigned int> tileSalts_;
   std::vector<float> islandRadius_;
+  std::vector<float> islandArea_;
+
+  // The polygons of all islands one island after another, the first of each
+  // island and a running sum of their areas within each island
+  std::vector<dtPolyRef> islandPolys_;
+  std::vector<std::size_t> islandPolyOffsets_;
+  std::vector<float> islandPolyAreas_;
+
+  explicit IslandSystem(const dtNavMesh* navMesh) : navMesh_{navMesh} {}
+
+  void initTiles() {
+    // The island of every polygon is stored in a flat array per tile, indexed
+    // like the polygons of the tile, the salt tells stale refs apart
+    tileIslands_.resize(navMesh_->getMaxTiles());
+    tileSalts_.resize(navMesh_->getMaxTiles(), 0);
+    for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh_->getTile(iTile);
+      if (!tile || !tile->header)
+        continue;
+      tileIslands_[iTile].assign(tile->header->polyCount, NO_ISLAND);
+      tileSalts_[iTile] = tile->salt;
+    }
+  }
+
+  void setIsland(const dtPolyRef ref, const uint32_t islandId) {
+    unsigned int salt, iTile, iPoly;
+    navMesh_->decodePolyId(ref, salt, iTile, iPoly);
+    tileIslands_[iTile][iPoly] = islandId;
+  }
+
+  void addPoly(const dtPolyRef ref,
+               const dtMeshTile* tile,
+               const dtPoly* poly,
+               const bool walkable) {
+    const float area = walkable ? polyArea(poly, tile) : 0.0f;
+    const bool firstOfIsland = islandPolys_.size() == islandPolyOffsets_.back();
+    islandPolys_.push_back(ref);
+    islandPolyAreas_.push_back(
+        (firstOfIsland ? 0.0f : islandPolyAreas_.back()) + area);
+  }
 
-  void expandFrom(const dtNavMesh* navMesh,
-                  const dtQueryFilter* filter,
+  void expandFrom(const dtQueryFilter* filter,
                   const uint32_t newIslandId,
                   const dtPolyRef& startRef,
                   std::vector<vec3f>& islandVerts) {
-    polyToIsland_.emplace(startRef, newIslandId);
+    setIsland(startRef, newIslandId);
     islandVerts.clear();
 
     // Force std::stack to be implemented via an std::vector as linked
@@ -180,38 +774,833 @@ class IslandSystem {
 
       const dtMeshTile* tile = nullptr;
       const dtPoly* poly = nullptr;
-      navMesh->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+      navMesh_->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
 
       for (int iVert = 0; iVert < poly->vertCount; ++iVert) {
         islandVerts.emplace_back(
             Eigen::Map<vec3f>(&tile->verts[poly->verts[iVert] * 3]));
       }
+      // The start polygon may not be walkable, it's then never sampled
+      addPoly(ref, tile, poly, filter->passFilter(ref, tile, poly));
 
       // Iterate over all neighbours
       for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
            iLink = tile->links[iLink].next) {
         dtPolyRef neighbourRef = tile->links[iLink].ref;
         // If we've already visited this poly, skip it!
-        if (polyToIsland_.find(neighbourRef) != polyToIsland_.end())
+        if (island(neighbourRef) != NO_ISLAND)
           continue;
 
         const dtMeshTile* neighbourTile = nullptr;
         const dtPoly* neighbourPoly = nullptr;
-        navMesh->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile,
-                                           &neighbourPoly);
+        navMesh_->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile,
+                                            &neighbourPoly);
 
         // If a neighbour isn't walkable, don't add it
         if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
           continue;
 
-        polyToIsland_.emplace(neighbourRef, newIslandId);
+        setIsland(neighbourRef, newIslandId);
         stack.push(neighbourRef);
       }
     }
   }
 };
+
+// Distances from the nodes of a grid over the navmesh to the closest wall,
+// i.e. polygon edge without a walkable neighbour, to tell in O(1) that a
+// point is farther from the walls than a query radius. Like the navmesh, the
+// grid is 2.5D: every node has a layer for each floor above it.
+class ObstacleDistanceField {
+ public:
+  // The layers of nodes further apart in height are different floors
+  static constexpr float LAYER_HEIGHT_TOLERANCE = 0.5f;
+
+  ObstacleDistanceField(const dtNavMesh* navMesh,
+                        const dtQueryFilter* filter,
+                        const std::pair<vec3f, vec3f>& bounds,
+                        const float cellSize,
+                        const float maxDistance)
+      : cellSize_{cellSize}, maxDistance_{maxDistance} {
+    origin_ = bounds.first;
+    sizeX_ = static_cast<int>((bounds.second[0] - origin_[0]) / cellSize) + 2;
+    sizeZ_ = static_cast<int>((bounds.second[2] - origin_[2]) / cellSize) + 2;
+
+    // The heights of the navmesh at every node, rasterized in bands of rows
+    const std::vector<std::array<vec3f, 3>> triangles =
+        walkableDetailTriangles(navMesh, filter);
+    constexpr int rowsPerBand = 32;
+    const int numBands = (sizeZ_ + rowsPerBand - 1) / rowsPerBand;
+    std::vector<std::vector<int>> bandTriangles(numBands);
+    for (std::size_t i = 0; i < triangles.size(); ++i) {
+      const std::array<vec3f, 3>& t = triangles[i];
+      const int first = std::max(
+          0, static_cast<int>(std::ceil(
+                 row(std::min({t[0][2], t[1][2], t[2][2]})))) /
+                 rowsPerBand);
+      const int last = std::min(
+          numBands - 1, static_cast<int>(std::floor(row(
+                            std::max({t[0][2], t[1][2], t[2][2]})))) /
+                            rowsPerBand);
+      for (int band = first; band <= last; ++band)
+        bandTriangles[band].push_back(i);
+    }
+
+    typedef std::pair<int, float> NodeHeight;
+    std::vector<std::vector<NodeHeight>> bandHeights(numBands);
+    const auto rasterizeBand = [&](const std::size_t band, std::size_t) {
+      const int firstRow = band * rowsPerBand;
+      const int endRow = std::min(sizeZ_, firstRow + rowsPerBand);
+      for (const int i : bandTriangles[band]) {
+        const std::array<vec3f, 3>& t = triangles[i];
+        // barycentric coordinates in the x-z plane
+        const float area = (t[1][0] - t[0][0]) * (t[2][2] - t[0][2]) -
+                           (t[2][0] - t[0][0]) * (t[1][2] - t[0][2]);
+        if (std::abs(area) < 1e-12f)
+          continue;
+        const int firstZ = std::max(
+            firstRow, static_cast<int>(std::ceil(
+                          row(std::min({t[0][2], t[1][2], t[2][2]})))));
+        const int lastZ = std::min(
+            endRow - 1, static_cast<int>(std::floor(
+                            row(std::max({t[0][2], t[1][2], t[2][2]})))));
+        const int firstX = std::max(
+            0, static_cast<int>(std::ceil(
+                   column(std::min({t[0][0], t[1][0], t[2][0]})))));
+        const int lastX = std::min(
+            sizeX_ - 1, static_cast<int>(std::floor(column(
+                            std::max({t[0][0], t[1][0], t[2][0]})))));
+        for (int z = firstZ; z <= lastZ; ++z) {
+          const float pz = origin_[2] + z * cellSize_;
+          for (int x = firstX; x <= lastX; ++x) {
+            const float px = origin_[0] + x * cellSize_;
+            const float b1 = ((px - t[0][0]) * (t[2][2] - t[0][2]) -
+                              (t[2][0] - t[0][0]) * (pz - t[0][2])) /
+                             area;
+            const float b2 = ((t[1][0] - t[0][0]) * (pz - t[0][2]) -
+                              (px - t[0][0]) * (t[1][2] - t[0][2])) /
+                             area;
+            const float b0 = 1.0f - b1 - b2;
+            if (b0 < -1e-5f || b1 < -1e-5f || b2 < -1e-5f)
+              continue;
+            bandHeights[band].emplace_back(
+                z * sizeX_ + x, b0 * t[0][1] + b1 * t[1][1] + b2 * t[2][1]);
+          }
+        }
+      }
+      // the triangles around a node all hit it, keep one height per floor
+      std::vector<NodeHeight>& heights = bandHeights[band];
+      std::sort(heights.begin(), heights.end());
+      heights.erase(std::unique(heights.begin(), heights.end(),
+                                [](const NodeHeight& a, const NodeHeight& b) {
+                                  return a.first == b.first &&
+                                         b.second - a.second <
+                                             LAYER_HEIGHT_TOLERANCE;
+                                }),
+                    heights.end());
+    };
+    core::ThreadPool& pool = core::ThreadPool::shared();
+    pool.parallelFor(numBands, pool.numThreads() + 1, rasterizeBand);
+
+    nodeLayerOffsets_.assign(sizeX_ * sizeZ_ + 1, 0);
+    for (const std::vector<NodeHeight>& heights : bandHeights) {
+      for (const NodeHeight& height : heights) {
+        ++nodeLayerOffsets_[height.first + 1];
+        layerHeights_.push_back(height.second);
+      }
+    }
+    std::partial_sum(nodeLayerOffsets_.begin(), nodeLayerOffsets_.end(),
+                     nodeLayerOffsets_.begin());
+    layerDistances_.resize(layerHeights_.size());
+
+    // The walls, bucketed by cells of maxDistance so that a node only looks
+    // at the walls of the 3x3 buckets around it
+    std::vector<std::array<vec3f, 2>> walls = collectWalls(navMesh, filter);
+    const int bucketsX = static_cast<int>((sizeX_ - 1) * cellSize_ /
+                                          maxDistance_) + 1;
+    const int bucketsZ = static_cast<int>((sizeZ_ - 1) * cellSize_ /
+                                          maxDistance_) + 1;
+    const auto bucket = [&](const float coordinate, const int axis,
+                            const int buckets) {
+      return std::min(
+          buckets - 1,
+          std::max(0, static_cast<int>(std::floor(
+                          (coordinate - origin_[axis]) / maxDistance_))));
+    };
+    std::vector<std::vector<int>> bucketWalls(bucketsX * bucketsZ);
+    for (std::size_t i = 0; i < walls.size(); ++i) {
+      const std::array<vec3f, 2>& w = walls[i];
+      for (int bz = bucket(std::min(w[0][2], w[1][2]), 2, bucketsZ);
+           bz <= bucket(std::max(w[0][2], w[1][2]), 2, bucketsZ); ++bz) {
+        for (int bx = bucket(std::min(w[0][0], w[1][0]), 0, bucketsX);
+             bx <= bucket(std::max(w[0][0], w[1][0]), 0, bucketsX); ++bx)
+          bucketWalls[bz * bucketsX + bx].push_back(i);
+      }
+    }
+
+    // A wall counts for a layer if it overlaps the heights an agent could
+    // walk to within maxDistance on slopes of up to 45 degrees, widened by
+    // the height tolerance of the layers so that lowerBound() holds for all
+    // the points it accepts
+    const float wallHeightRange = maxDistance_ + 2 * LAYER_HEIGHT_TOLERANCE;
+    const auto distanceBand = [&](const std::size_t band, std::size_t) {
+      const int firstRow = band * rowsPerBand;
+      const int endRow = std::min(sizeZ_, firstRow + rowsPerBand);
+      for (int z = firstRow; z < endRow; ++z) {
+        const float pz = origin_[2] + z * cellSize_;
+        const int bz = bucket(pz, 2, bucketsZ);
+        for (int x = 0; x < sizeX_; ++x) {
+          const float px = origin_[0] + x * cellSize_;
+          const int bx = bucket(px, 0, bucketsX);
+          const int node = z * sizeX_ + x;
+          for (uint32_t layer = nodeLayerOffsets_[node];
+               layer < nodeLayerOffsets_[node + 1]; ++layer) {
+            const vec3f pt{px, layerHeights_[layer], pz};
+            float distanceSqr = maxDistance_ * maxDistance_;
+            for (int nz = std::max(0, bz - 1);
+                 nz <= std::min(bucketsZ - 1, bz + 1); ++nz) {
+              for (int nx = std::max(0, bx - 1);
+                   nx <= std::min(bucketsX - 1, bx + 1); ++nx) {
+                for (const int i : bucketWalls[nz * bucketsX + nx]) {
+                  const std::array<vec3f, 2>& w = walls[i];
+                  if (std::min(w[0][1], w[1][1]) > pt[1] + wallHeightRange ||
+                      std::max(w[0][1], w[1][1]) < pt[1] - wallHeightRange)
+                    continue;
+                  float t;
+                  distanceSqr = std::min(
+                      distanceSqr, dtDistancePtSegSqr2D(pt.data(), w[0].data(),
+                                                        w[1].data(), t));
+                }
+              }
+            }
+            layerDistances_[layer] = std::sqrt(distanceSqr);
+          }
+        }
+      }
+    };
+    pool.parallelFor(numBands, pool.numThreads() + 1, distanceBand);
+  }
+
+  // A lower bound of the distance from pt to the closest wall, less than
+  // the exact distance by up to a cell diagonal. 0 where no node around pt
+  // is on its floor.
+  float lowerBound(const vec3f& pt) const {
+    const float fx = column(pt[0]);
+    const float fz = row(pt[2]);
+    const int x0 = static_cast<int>(std::floor(fx));
+    const int z0 = static_cast<int>(std::floor(fz));
+    // the distance to the walls is 1-Lipschitz in the x-z plane, so every
+    // corner of the cell bounds the distance of pt
+    float bound = 0.0f;
+    for (int z = std::max(z0, 0); z <= std::min(z0 + 1, sizeZ_ - 1); ++z) {
+      for (int x = std::max(x0, 0); x <= std::min(x0 + 1, sizeX_ - 1); ++x) {
+        const int node = z * sizeX_ + x;
+        const float offset =
+            cellSize_ * std::sqrt((fx - x) * (fx - x) + (fz - z) * (fz - z));
+        for (uint32_t layer = nodeLayerOffsets_[node];
+             layer < nodeLayerOffsets_[node + 1]; ++layer) {
+          if (std::abs(layerHeights_[layer] - pt[1]) <= LAYER_HEIGHT_TOLERANCE)
+            bound = std::max(bound, layerDistances_[layer] - offset);
+        }
+      }
+    }
+    return bound;
+  }
+
+ private:
+  float row(const float z) const { return (z - origin_[2]) / cellSize_; }
+  float column(const float x) const { return (x - origin_[0]) / cellSize_; }
+
+  // The edges of walkable polygons that have no walkable neighbour at least
+  // somewhere along them
+  static std::vector<std::array<vec3f, 2>> collectWalls(
+      const dtNavMesh* navMesh,
+      const dtQueryFilter* filter) {
+    std::vector<std::array<vec3f, 2>> walls;
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (!tile || !tile->header)
+        continue;
+      const dtPolyRef base = navMesh->getPolyRefBase(tile);
+      for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+        const dtPoly* poly = &tile->polys[jPoly];
+        if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+            !filter->passFilter(base | jPoly, tile, poly))
+          continue;
+        for (int j = 0; j < poly->vertCount; ++j) {
+          bool solid = true;
+          if (poly->neis[j] & DT_EXT_LINK) {
+            // only a link over the whole edge makes it open, as a
+            // conservative stand-in for the partial walls Detour finds
+            for (unsigned int k = poly->firstLink; k != DT_NULL_LINK;
+                 k = tile->links[k].next) {
+              const dtLink& link = tile->links[k];
+              if (link.edge != j || link.bmin != 0 || link.bmax != 255)
+                continue;
+              const dtMeshTile* neighbourTile = nullptr;
+              const dtPoly* neighbourPoly = nullptr;
+              navMesh->getTileAndPolyByRefUnsafe(link.ref, &neighbourTile,
+                                                 &neighbourPoly);
+              if (filter->passFilter(link.ref, neighbourTile, neighbourPoly))
+                solid = false;
+            }
+          } else if (poly->neis[j]) {
+            const unsigned int idx = poly->neis[j] - 1;
+            solid = !filter->passFilter(base | idx, tile, &tile->polys[idx]);
+          }
+          if (!solid)
+            continue;
+          const int next = (j + 1) % poly->vertCount;
+          walls.push_back(
+              {vec3f{Eigen::Map<const vec3f>(&tile->verts[poly->verts[j] * 3])},
+               vec3f{Eigen::Map<const vec3f>(
+                   &tile->verts[poly->verts[next] * 3])}});
+        }
+      }
+    }
+    return walls;
+  }
+
+  float cellSize_;
+  float maxDistance_;
+  vec3f origin_;
+  int sizeX_;
+  int sizeZ_;
+  //! The layers of every node, a floor height and the distance to the
+  //! closest wall at most maxDistance_
+  std::vector<uint32_t> nodeLayerOffsets_;
+  std::vector<float> layerHeights_;
+  std::vector<float> layerDistances_;
+};
+
+// Segments the walkable polygons into levels, e.g. the floors of a house.
+// The levels are either given heights or the heights with the most walkable
+// area, at least minLevelSeparation apart. The polygons near the height of a
+// level seed it, then the levels grow from their seeds over the adjacency of
+// the polygons, so a sloped floor stays one level and stairs are split
+// between the floors they connect. The polygons of islands without seeds go
+// to the level of the closest height.
+class LevelSystem {
+ public:
+  static constexpr uint32_t NO_LEVEL = std::numeric_limits<uint32_t>::max();
+
+  struct Level {
+    float height;
+    vec3f bmin, bmax;
+    // The polygons of the level and a running sum of their areas
+    std::vector<dtPolyRef> polys;
+    std::vector<float> polyAreas;
+  };
+
+  LevelSystem(const dtNavMesh* navMesh,
+              const dtQueryFilter* filter,
+              const std::vector<float>& levelHeights,
+              const float minLevelSeparation)
+      : navMesh_{navMesh} {
+    // The walkable polygons, their index in tileLevels_ until they get a
+    // level
+    std::vector<dtPolyRef> refs;
+    std::vector<float> heights, areas;
+    tileLevels_.resize(navMesh->getMaxTiles());
+    tileSalts_.resize(navMesh->getMaxTiles(), 0);
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (!tile || !tile->header)
+        continue;
+      tileLevels_[iTile].assign(tile->header->polyCount, NO_LEVEL);
+      tileSalts_[iTile] = tile->salt;
+      for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+        const dtPoly* poly = &tile->polys[jPoly];
+        const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+        if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+            !filter->passFilter(ref, tile, poly))
+          continue;
+        float height = 0;
+        for (int iVert = 0; iVert < poly->vertCount; ++iVert)
+          height += tile->verts[poly->verts[iVert] * 3 + 1];
+        tileLevels_[iTile][jPoly] = refs.size();
+        refs.push_back(ref);
+        heights.push_back(height / poly->vertCount);
+        areas.push_back(polyArea(poly, tile));
+      }
+    }
+    if (refs.empty())
+      return;
+
+    std::vector<float> levels =
+        levelHeights.empty()
+            ? findLevelHeights(heights, areas, minLevelSeparation)
+            : levelHeights;
+    const auto closestLevel = [&](const float height) {
+      uint32_t closest = 0;
+      for (uint32_t l = 1; l < levels.size(); ++l) {
+        if (std::abs(levels[l] - height) < std::abs(levels[closest] - height))
+          closest = l;
+      }
+      return closest;
+    };
+
+    // Breadth-first from the seeds of all levels at once
+    std::vector<uint32_t> polyLevels(refs.size(), NO_LEVEL);
+    std::queue<uint32_t> queue;
+    for (uint32_t i = 0; i < refs.size(); ++i) {
+      const uint32_t level = closestLevel(heights[i]);
+      if (std::abs(levels[level] - heights[i]) <= seedTolerance) {
+        polyLevels[i] = level;
+        queue.push(i);
+      }
+    }
+    while (!queue.empty()) {
+      const uint32_t i = queue.front();
+      queue.pop();
+      const dtMeshTile* tile = nullptr;
+      const dtPoly* poly = nullptr;
+      navMesh->getTileAndPolyByRefUnsafe(refs[i], &tile, &poly);
+      for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+           iLink = tile->links[iLink].next) {
+        const uint32_t j = tileEntry(tile->links[iLink].ref);
+        if (j == NO_LEVEL || polyLevels[j] != NO_LEVEL)
+          continue;
+        polyLevels[j] = polyLevels[i];
+        queue.push(j);
+      }
+    }
+
+    levels_.resize(levels.size());
+    for (uint32_t l = 0; l < levels.size(); ++l) {
+      levels_[l].height = levels[l];
+      levels_[l].bmin = vec3f::Constant(std::numeric_limits<float>::max());
+      levels_[l].bmax = vec3f::Constant(-std::numeric_limits<float>::max());
+    }
+    for (uint32_t i = 0; i < refs.size(); ++i) {
+      if (polyLevels[i] == NO_LEVEL)
+        polyLevels[i] = closestLevel(heights[i]);
+      Level& level = levels_[polyLevels[i]];
+      level.polys.push_back(refs[i]);
+      level.polyAreas.push_back(
+          (level.polyAreas.empty() ? 0.0f : level.polyAreas.back()) +
+          areas[i]);
+      const dtMeshTile* tile = nullptr;
+      const dtPoly* poly = nullptr;
+      navMesh->getTileAndPolyByRefUnsafe(refs[i], &tile, &poly);
+      for (int iVert = 0; iVert < poly->vertCount; ++iVert) {
+        const Eigen::Map<const vec3f> vert{
+            &tile->verts[poly->verts[iVert] * 3]};
+        level.bmin = level.bmin.cwiseMin(vert);
+        level.bmax = level.bmax.cwiseMax(vert);
+      }
+      setLevel(refs[i], polyLevels[i]);
+    }
+  }
+
+  int numLevels() const { return levels_.size(); }
+
+  const Level& level(const uint32_t level) const { return levels_[level]; }
+
+  float levelArea(const uint32_t level) const {
+    return levels_[level].polyAreas.empty() ? 0.0f
+                                            : levels_[level].polyAreas.back();
+  }
+
+  // The level of a polygon, NO_LEVEL if it isn't walkable
+  inline uint32_t levelOf(const dtPolyRef ref) const {
+    // The entries of the walkable polygons are all levels by now
+    return tileEntry(ref);
+  }
+
+  // Picks a polygon of the level with a probability proportional to its area
+  // from a uniform number in [0, 1], 0 if the level has no area
+  dtPolyRef randomPoly(const uint32_t level, const float u) const {
+    const std::vector<float>& polyAreas = levels_[level].polyAreas;
+    if (levelArea(level) <= 0.0f)
+      return 0;
+    auto it =
+        std::upper_bound(polyAreas.begin(), polyAreas.end(),
+                         u * polyAreas.back());
+    if (it == polyAreas.end())
+      --it;
+    return levels_[level].polys[it - polyAreas.begin()];
+  }
+
+ private:
+  // Polygons this close to the height of a level seed it
+  static constexpr float seedTolerance = 0.25f;
+  // Resolution of the histogram of the heights of the walkable area
+  static constexpr float binSize = 0.1f;
+
+  const dtNavMesh* navMesh_;
+  std::vector<std::vector<uint32_t>> tileLevels_;
+  std::vector<unsigned int> tileSalts_;
+  std::vector<Level> levels_;
+
+  inline uint32_t tileEntry(const dtPolyRef ref) const {
+    unsigned int salt, iTile, iPoly;
+    navMesh_->decodePolyId(ref, salt, iTile, iPoly);
+    if (iTile >= tileLevels_.size() || tileSalts_[iTile] != salt ||
+        iPoly >= tileLevels_[iTile].size())
+      return NO_LEVEL;
+    return tileLevels_[iTile][iPoly];
+  }
+
+  void setLevel(const dtPolyRef ref, const uint32_t level) {
+    unsigned int salt, iTile, iPoly;
+    navMesh_->decodePolyId(ref, salt, iTile, iPoly);
+    tileLevels_[iTile][iPoly] = level;
+  }
+
+  // The peaks of the histogram of the walkable area by height, smoothed over
+  // the seed tolerance, from the highest down, at least minLevelSeparation
+  // apart and with at least a tenth of the area of the highest. Ascending.
+  static std::vector<float> findLevelHeights(const std::vector<float>& heights,
+                                             const std::vector<float>& areas,
+                                             const float minLevelSeparation) {
+    const auto minMax = std::minmax_element(heights.begin(), heights.end());
+    const float minHeight = *minMax.first;
+    const int numBins = int((*minMax.second - minHeight) / binSize) + 1;
+    std::vector<float> bins(numBins, 0.0f);
+    for (std::size_t i = 0; i < heights.size(); ++i)
+      bins[int((heights[i] - minHeight) / binSize)] += areas[i];
+
+    const int radius = int(seedTolerance / binSize);
+    std::vector<float> smoothed(numBins, 0.0f);
+    for (int b = 0; b < numBins; ++b) {
+      for (int k = std::max(0, b - radius);
+           k <= std::min(numBins - 1, b + radius); ++k)
+        smoothed[b] += bins[k];
+    }
+
+    std::vector<int> order(numBins);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return smoothed[a] > smoothed[b];
+    });
+    std::vector<float> peaks;
+    for (const int b : order) {
+      if (smoothed[b] <= 0.1f * smoothed[order[0]])
+        break;
+      const float height = minHeight + (b + 0.5f) * binSize;
+      if (std::all_of(peaks.begin(), peaks.end(), [&](const float peak) {
+            return std::abs(peak - height) >= minLevelSeparation;
+          }))
+        peaks.push_back(height);
+    }
+    // Only degenerate polygons
+    if (peaks.empty())
+      peaks.push_back(minHeight);
+
+    // The level is at the mean height of the area around its peak
+    for (float& peak : peaks) {
+      float weightedHeight = 0, area = 0;
+      for (std::size_t i = 0; i < heights.size(); ++i) {
+        if (std::abs(heights[i] - peak) <= seedTolerance) {
+          weightedHeight += areas[i] * heights[i];
+          area += areas[i];
+        }
+      }
+      if (area > 0)
+        peak = weightedHeight / area;
+    }
+    std::sort(peaks.begin(), peaks.end());
+    return peaks;
+  }
+};
+
+// The voxelization of the last navmesh built, to reuse when only the agent
+// radius or height or the later steps of the build change. Recast's
+// rasterization marks the walkable triangles by slope and merges the spans
+// within the climb, so those are part of the key of the heightfield. The
+// compact heightfield is kept before the erosion, which depends on the radius.
+struct HeightfieldCache {
+  // The key of solid
+  uint64_t meshHash = 0;
+  float cs = 0, ch = 0;
+  float bmin[3]{}, bmax[3]{};
+  float walkableSlopeAngle = 0;
+  int walkableClimb = 0;
+  // The rasterized triangles, before the filters
+  rcHeightfield* solid = nullptr;
+
+  // The rest of the key of chf
+  int walkableHeight = 0;
+  bool filterLowHangingObstacles = false;
+  bool filterLedgeSpans = false;
+  bool filterWalkableLowHeightSpans = false;
+  // The filtered and compacted heightfield, before the erosion
+  rcCompactHeightfield* chf = nullptr;
+
+  HeightfieldCache() = default;
+  HeightfieldCache(const HeightfieldCache&) = delete;
+  HeightfieldCache& operator=(const HeightfieldCache&) = delete;
+  ~HeightfieldCache() { clear(); }
+
+  bool hasSolid(const uint64_t meshHash, const rcConfig& cfg) const {
+    return solid && this->meshHash == meshHash && cs == cfg.cs &&
+           ch == cfg.ch && rcVdistSqr(bmin, cfg.bmin) == 0 &&
+           rcVdistSqr(bmax, cfg.bmax) == 0 &&
+           walkableSlopeAngle == cfg.walkableSlopeAngle &&
+           walkableClimb == cfg.walkableClimb;
+  }
+
+  bool hasCompact(const uint64_t meshHash,
+                  const rcConfig& cfg,
+                  const NavMeshSettings& bs) const {
+    return chf && hasSolid(meshHash, cfg) &&
+           walkableHeight == cfg.walkableHeight &&
+           filterLowHangingObstacles == bs.filterLowHangingObstacles &&
+           filterLedgeSpans == bs.filterLedgeSpans &&
+           filterWalkableLowHeightSpans == bs.filterWalkableLowHeightSpans;
+  }
+
+  void setSolid(const uint64_t meshHash,
+                const rcConfig& cfg,
+                rcHeightfield* solid) {
+    clear();
+    this->meshHash = meshHash;
+    cs = cfg.cs;
+    ch = cfg.ch;
+    rcVcopy(bmin, cfg.bmin);
+    rcVcopy(bmax, cfg.bmax);
+    walkableSlopeAngle = cfg.walkableSlopeAngle;
+    walkableClimb = cfg.walkableClimb;
+    this->solid = solid;
+  }
+
+  void setCompact(const rcConfig& cfg,
+                  const NavMeshSettings& bs,
+                  rcCompactHeightfield* chf) {
+    rcFreeCompactHeightfield(this->chf);
+    walkableHeight = cfg.walkableHeight;
+    filterLowHangingObstacles = bs.filterLowHangingObstacles;
+    filterLedgeSpans = bs.filterLedgeSpans;
+    filterWalkableLowHeightSpans = bs.filterWalkableLowHeightSpans;
+    this->chf = chf;
+  }
+
+  void clear() {
+    rcFreeHeightField(solid);
+    solid = nullptr;
+    rcFreeCompactHeightfield(chf);
+    chf = nullptr;
+  }
+};
+
+// The results of the last shortest path queries, by the polygons of their
+// ends and the cells of quantum they are in
+class PathCache {
+ public:
+  struct Key {
+    dtPolyRef startRef, endRef;
+    std::array<int, 6> cells;
+
+    bool operator==(const Key& other) const {
+      return startRef == other.startRef && endRef == other.endRef &&
+             cells == other.cells;
+    }
+  };
+
+  struct Result {
+    bool found;
+    float geodesicDistance;
+    std::vector<vec3f> points;
+  };
+
+  PathCache(const std::size_t capacity, const float quantum)
+      : capacity_{capacity}, quantum_{quantum} {}
+
+  Key key(const dtPolyRef startRef,
+          const dtPolyRef endRef,
+          const vec3f& start,
+          const vec3f& end) const {
+    Key key{startRef, endRef, {}};
+    for (int i = 0; i < 3; ++i) {
+      key.cells[i] = static_cast<int>(std::floor(start[i] / quantum_));
+      key.cells[3 + i] = static_cast<int>(std::floor(end[i] / quantum_));
+    }
+    return key;
+  }
+
+  // Copies the result of key to result and makes it the most recent
+  bool find(const Key& key, Result& result) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto found = index_.find(key);
+    if (found == index_.end()) {
+      ++misses_;
+      return false;
+    }
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, found->second);
+    result = found->second->second;
+    return true;
+  }
+
+  // Adds the result of key, evicting the least recent one when full
+  void insert(const Key& key, const Result& result) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (index_.count(key))
+      return;
+    entries_.emplace_front(key, result);
+    index_.emplace(key, entries_.begin());
+    if (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    entries_.clear();
+    index_.clear();
+  }
+
+  std::size_t hits() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return hits_;
+  }
+
+  std::size_t misses() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return misses_;
+  }
+
+ private:
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const {
+      std::size_t hash = std::hash<dtPolyRef>{}(key.startRef);
+      hash = hash * 31 + std::hash<dtPolyRef>{}(key.endRef);
+      for (const int cell : key.cells)
+        hash = hash * 31 + std::hash<int>{}(cell);
+      return hash;
+    }
+  };
+
+  const std::size_t capacity_;
+  const float quantum_;
+  mutable std::mutex mutex_;
+  // Most recent first
+  std::list<std::pair<Key, Result>> entries_;
+  std::unordered_map<Key, std::list<std::pair<Key, Result>>::iterator, KeyHash>
+      index_;
+  std::size_t hits_ = 0;
+  std::size_t misses_ = 0;
+};
 }  // namespace impl
 
+namespace {
+enum PolyAreas { POLYAREA_GROUND, POLYAREA_DOOR };
+
+enum PolyFlags {
+  POLYFLAGS_WALK = 0x01,      // walkable
+  POLYFLAGS_DOOR = 0x02,      // ability to move through doors
+  POLYFLAGS_DISABLED = 0x04,  // disabled polygon
+  POLYFLAGS_ALL = 0xffff      // all abilities
+};
+
+// Tile cache room for the layers of a tile, i.e. the floors above each other
+const int EXPECTED_LAYERS_PER_TILE = 4;
+const int MAX_LAYERS = 32;
+
+// Stores the tile cache layers as they are, they are small next to the
+// geometry they are rasterized from
+struct TileCacheCompressor : public dtTileCacheCompressor {
+  int maxCompressedSize(const int bufferSize) override { return bufferSize; }
+
+  dtStatus compress(const unsigned char* buffer,
+                    const int bufferSize,
+                    unsigned char* compressed,
+                    const int maxCompressedSize,
+                    int* compressedSize) override {
+    if (bufferSize > maxCompressedSize) {
+      return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+    }
+    memcpy(compressed, buffer, bufferSize);
+    *compressedSize = bufferSize;
+    return DT_SUCCESS;
+  }
+
+  dtStatus decompress(const unsigned char* compressed,
+                      const int compressedSize,
+                      unsigned char* buffer,
+                      const int maxBufferSize,
+                      int* bufferSize) override {
+    if (compressedSize > maxBufferSize) {
+      return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+    }
+    memcpy(buffer, compressed, compressedSize);
+    *bufferSize = compressedSize;
+    return DT_SUCCESS;
+  }
+};
+
+// Flags the polygons of the tiles the tile cache builds like PathFinder::build
+struct TileCacheMeshProcess : public dtTileCacheMeshProcess {
+  void process(dtNavMeshCreateParams* params,
+               unsigned char* polyAreas,
+               unsigned short* polyFlags) override {
+    for (int i = 0; i < params->polyCount; ++i) {
+      if (polyAreas[i] == DT_TILECACHE_WALKABLE_AREA) {
+        polyAreas[i] = POLYAREA_GROUND;
+      }
+      if (polyAreas[i] == POLYAREA_GROUND) {
+        polyFlags[i] = POLYFLAGS_WALK;
+      } else if (polyAreas[i] == POLYAREA_DOOR) {
+        polyFlags[i] = POLYFLAGS_WALK | POLYFLAGS_DOOR;
+      }
+    }
+  }
+};
+
+// Hands out Detour queries, which keep the state of their searches, so that
+// queries on different threads don't share one. A query returns to the pool
+// when released, new ones are made when all are in use.
+class NavQueryPool {
+ public:
+  struct Releaser {
+    NavQueryPool* pool;
+    void operator()(dtNavMeshQuery* query) const { pool->release(query); }
+  };
+  typedef std::unique_ptr<dtNavMeshQuery, Releaser> Query;
+
+  explicit NavQueryPool(const dtNavMesh* navMesh) : navMesh_{navMesh} {}
+  NavQueryPool(const NavQueryPool&) = delete;
+  NavQueryPool& operator=(const NavQueryPool&) = delete;
+  ~NavQueryPool() {
+    for (dtNavMeshQuery* query : free_)
+      dtFreeNavMeshQuery(query);
+  }
+
+  // Null if a new query fails to initialize
+  Query acquire() {
+    dtNavMeshQuery* query = nullptr;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (!free_.empty()) {
+        query = free_.back();
+        free_.pop_back();
+      }
+    }
+    if (!query) {
+      query = dtAllocNavMeshQuery();
+      if (dtStatusFailed(query->init(navMesh_, 2048))) {
+        LOG(ERROR) << "Could not init Detour navmesh query";
+        dtFreeNavMeshQuery(query);
+        query = nullptr;
+      }
+    }
+    return Query{query, Releaser{this}};
+  }
+
+ private:
+  void release(dtNavMeshQuery* query) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    free_.push_back(query);
+  }
+
+  const dtNavMesh* navMesh_;
+  std::mutex mutex_;
+  std::vector<dtNavMeshQuery*> free_;
+};
+}  // namespace
+
 struct PathFinder::Impl {
   Impl();
   ~Impl() = default;
@@ -225,18 +1614,71 @@ struct PathFinder::Impl {
              const float* bmax);
   bool build(const NavMeshSettings& bs, const esp::assets::MeshData& mesh);
 
+  void clearHeightfieldCache() { heightfieldCache_->clear(); }
+
+  bool rebuildTiles(const float* verts,
+                    const int nverts,
+                    const int* tris,
+                    const int ntris,
+                    const float* bmin,
+                    const float* bmax);
+
+  bool isTiled() const { return tileCache_ != nullptr; }
+
+  uint32_t addCylinderObstacle(const vec3f& position,
+                               const float radius,
+                               const float height);
+  uint32_t addBoxObstacle(const vec3f& center,
+                          const vec3f& halfExtents,
+                          const float yRotation);
+  bool removeObstacle(const uint32_t obstacleID);
+  bool updateObstacles();
+
   vec3f getRandomNavigablePoint();
+  vec3f getRandomNavigablePointOnIsland(const int islandIndex);
+
+  std::vector<Episode> sampleEpisodes(const int count,
+                                      const uint32_t seed,
+                                      const EpisodeSamplingSettings& settings);
 
   bool findPath(ShortestPath& path);
   bool findPath(MultiGoalShortestPath& path);
 
+  void enablePathCache(const std::size_t capacity, const float quantum);
+  void disablePathCache() { pathCache_ = nullptr; }
+  bool isPathCacheEnabled() const { return pathCache_ != nullptr; }
+  std::size_t pathCacheHits() const {
+    return pathCache_ ? pathCache_->hits() : 0;
+  }
+  std::size_t pathCacheMisses() const {
+    return pathCache_ ? pathCache_->misses() : 0;
+  }
+
+  std::vector<float> findPathsBatch(const std::vector<vec3f>& starts,
+                                    const std::vector<vec3f>& ends,
+                                    std::vector<vec3f>* points,
+                                    std::vector<std::size_t>* pointOffsets);
+
+  GeodesicDistanceField::ptr buildGeodesicDistanceField(
+      const std::vector<vec3f>& goals,
+      const float nodeSpacing);
+  float geodesicDistance(const GeodesicDistanceField& field,
+                         const vec3f& pt) const;
+
   template <typename T>
   T tryStep(const T& start, const T& end, bool allowSliding);
+  template <typename T>
+  std::vector<T> tryStepBatch(const std::vector<T>& starts,
+                              const std::vector<T>& ends,
+                              bool allowSliding);
 
   template <typename T>
   T snapPoint(const T& pt);
+  std::vector<vec3f> snapPointBatch(const std::vector<vec3f>& points);
 
   bool loadNavMesh(const std::string& path);
+  bool loadNavMeshData(Cr::Containers::Array<char> file,
+                       const std::string& name);
 
   bool saveNavMesh(const std::string& path);
 
@@ -244,17 +1686,58 @@ struct PathFinder::Impl {
 
   float getNavigableArea() const { return navMeshArea_; };
 
+  std::size_t getHostBytes() const;
+
   void seed(uint32_t newSeed);
 
+  core::Random::State getRandomState() {
+    std::lock_guard<std::mutex> lock{randomMutex_};
+    return random_.state();
+  }
+
+  void setRandomState(const core::Random::State& state) {
+    std::lock_guard<std::mutex> lock{randomMutex_};
+    random_.setState(state);
+  }
+
   float islandRadius(const vec3f& pt) const;
 
+  int numIslands() const;
+  int getIsland(const vec3f& pt) const;
+  float islandArea(const int islandIndex) const;
+  int largestIsland() const;
+
+  void segmentLevels(const std::vector<float>& levelHeights,
+                     const float minLevelSeparation);
+  int numLevels() const;
+  std::vector<NavMeshLevel> getLevels() const;
+  int getLevel(const vec3f& pt) const;
+  vec3f getRandomNavigablePointOnLevel(const int levelIndex);
+
   float distanceToClosestObstacle(const vec3f& pt,
                                   const float maxSearchRadius = 2.0) const;
+
+  void enableObstacleDistanceField(const float cellSize,
+                                   const float maxDistance);
+  void disableObstacleDistanceField();
+  bool isObstacleDistanceFieldEnabled() const {
+    return obstacleFieldCellSize_ > 0;
+  }
   HitRecord closestObstacleSurfacePoint(
       const vec3f& pt,
       const float maxSearchRadius = 2.0) const;
 
   bool isNavigable(const vec3f& pt, const float maxYDelta = 0.5) const;
+  std::vector<bool> isNavigableBatch(const std::vector<vec3f>& points,
+                                     const float maxYDelta = 0.5) const;
+  bool isNavigableInternal(const dtNavMeshQuery* navQuery,
+                           const vec3f& pt,
+                           const float maxYDelta) const;
+
+  // Calls queryOne(navQuery, i) for every i in [0, count) in parallel, each
+  // worker with its own query, nothing without a navmesh
+  template <typename F>
+  void forEachPointBatch(std::size_t count, F&& queryOne) const;
 
   std::pair<vec3f, vec3f> bounds() const { return bounds_; };
 
@@ -262,46 +1745,173 @@ struct PathFinder::Impl {
       const float metersPerPixel,
       const float height);
 
+  Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> getTopDownViewOfLevel(
+      const int levelIndex,
+      const float metersPerPixel);
+
   const assets::MeshData::ptr getNavMeshData();
 
  private:
   struct NavMeshDeleter {
     void operator()(dtNavMesh* mesh) { dtFreeNavMesh(mesh); }
   };
-  struct NavQueryDeleter {
-    void operator()(dtNavMeshQuery* query) { dtFreeNavMeshQuery(query); }
+  struct TileCacheDeleter {
+    void operator()(dtTileCache* tileCache) { dtFreeTileCache(tileCache); }
   };
 
+  //! The mapped .navmesh file the tiles of a loaded navmesh point into, so
+  //! that processes loading the same file share its pages. Declared before
+  //! navMesh_ to outlive it.
+  Cr::Containers::Array<char> navMeshFile_;
   std::unique_ptr<dtNavMesh, NavMeshDeleter> navMesh_ = nullptr;
-  std::unique_ptr<dtNavMeshQuery, NavQueryDeleter> navQuery_ = nullptr;
+  //! Queries of the navmesh, each query method leases its own so that
+  //! concurrent queries are safe
+  std::unique_ptr<NavQueryPool> queryPool_ = nullptr;
+
+  //! Graph of the backward searches of MultiGoalShortestPath, made when first
+  //! needed. Reset with queryPool_.
+  std::shared_ptr<const impl::NodeGraph> nodeGraph_ = nullptr;
+  std::mutex nodeGraphMutex_;
+  std::shared_ptr<const impl::NodeGraph> nodeGraph();
   std::unique_ptr<dtQueryFilter> filter_ = nullptr;
   std::unique_ptr<impl::IslandSystem> islandSystem_ = nullptr;
 
+  //! The grid spacing and range of the obstacle distance field, 0 if it's
+  //! disabled, and the field, made when first needed. Reset with queryPool_.
+  float obstacleFieldCellSize_ = 0;
+  float obstacleFieldMaxDistance_ = 0;
+  mutable std::shared_ptr<const impl::ObstacleDistanceField> obstacleField_ =
+      nullptr;
+  mutable std::mutex obstacleFieldMutex_;
+  std::shared_ptr<const impl::ObstacleDistanceField> obstacleField() const;
+
+  //! The layers of the tiles of a tiled navmesh, to rebuild tiles from. Null
+  //! for single-tile and loaded navmeshes
+  dtTileCacheAlloc tileCacheAlloc_;
+  TileCacheCompressor tileCacheCompressor_;
+  TileCacheMeshProcess tileCacheMeshProcess_;
+  std::unique_ptr<dtTileCache, TileCacheDeleter> tileCache_ = nullptr;
+  //! The settings and the bounds of the tiled navmesh
+  NavMeshSettings tileSettings_;
+  rcConfig tileConfig_{};
+  int tilesX_ = 0;
+  int tilesZ_ = 0;
+
+  //! The results of findPath(ShortestPath&) when enabled. Cleared with
+  //! queryPool_.
+  std::unique_ptr<impl::PathCache> pathCache_ = nullptr;
+
+  //! The voxelization of the last single-tile build, reused by the next
+  //! builds of the same mesh with other agent settings
+  std::unique_ptr<impl::HeightfieldCache> heightfieldCache_ = nullptr;
+
+  //! The last top-down view and its resolution and height. Reset with
+  //! queryPool_.
+  Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> topDownView_;
+  float topDownViewMetersPerPixel_ = 0;
+  float topDownViewHeight_ = 0;
+  std::mutex topDownViewMutex_;
+
+  //! The settings of segmentLevels() and the levels, segmented when first
+  //! needed, with their top-down views by level and resolution. Reset with
+  //! queryPool_.
+  std::vector<float> levelHeights_;
+  float minLevelSeparation_ = 1.5f;
+  mutable std::shared_ptr<const impl::LevelSystem> levelSystem_ = nullptr;
+  mutable std::map<std::pair<int, float>,
+                   Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>>
+      levelViews_;
+  mutable std::mutex levelSystemMutex_;
+  std::shared_ptr<const impl::LevelSystem> levelSystem() const;
+
   //! Holds triangulated geom/topo. Generated when queried. Reset with
-  //! navQuery_.
+  //! queryPool_.
   assets::MeshData::ptr meshData_ = nullptr;
 
   //! Sum of all NavMesh polygons. Computed on NavMesh load/recompute. See
   //! removeZeroAreaPolys.
   float navMeshArea_ = 0;
+  //! The number of polygons, including disabled ones, counted with
+  //! navMeshArea_
+  int numPolys_ = 0;
 
   std::pair<vec3f, vec3f> bounds_;
 
+  //! The generator of the random points, see seed(), drawn from by one query
+  //! at a time
+  core::Random random_{0};
+  std::mutex randomMutex_;
+
   void removeZeroAreaPolys();
 
-  bool initNavQuery();
+  bool initNavQuery(std::unique_ptr<impl::IslandSystem> islandSystem = nullptr);
+
+  bool buildTiled(const NavMeshSettings& bs,
+                  const float* verts,
+                  const int nverts,
+                  const int* tris,
+                  const int ntris,
+                  const float* bmin,
+                  const float* bmax);
+
+  // (Re)build the tiles in [firstX, lastX] x [firstZ, lastZ]
+  bool buildTiles(const float* verts,
+                  const int nverts,
+                  const int* tris,
+                  const int ntris,
+                  int firstX,
+                  int firstZ,
+                  int lastX,
+                  int lastZ);
 
   Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-  findPathInternal(const vec3f& start,
+  findPathInternal(dtNavMeshQuery* navQuery,
+                   const vec3f& start,
                    dtPolyRef startRef,
                    const vec3f& pathStart,
                    const vec3f& end,
                    dtPolyRef endRef,
                    const vec3f& pathEnd);
 
-  bool findPathSetup(MultiGoalShortestPath& path,
+  template <typename T>
+  T tryStepInternal(dtNavMeshQuery* navQuery,
+                    const T& start,
+                    const T& end,
+                    bool allowSliding);
+
+  // tryStepInternal() with the projectToPoly() of start already done, e.g.
+  // once for many steps from the same start
+  template <typename T>
+  T tryStepFromPoly(dtNavMeshQuery* navQuery,
+                    const T& start,
+                    const std::tuple<dtStatus, dtPolyRef, vec3f>& startPoly,
+                    const T& end,
+                    bool allowSliding);
+
+  bool randomPointInPoly(dtNavMeshQuery* navQuery,
+                         const dtPolyRef ref,
+                         const float s,
+                         const float t,
+                         vec3f& pt) const;
+
+  bool randomPointOnIsland(dtNavMeshQuery* navQuery,
+                           const uint32_t island,
+                           const float u,
+                           const float s,
+                           const float t,
+                           dtPolyRef& ref,
+                           vec3f& pt) const;
+
+  bool findPathSetup(dtNavMeshQuery* navQuery,
+                     MultiGoalShortestPath& path,
                      dtPolyRef& startRef,
                      vec3f& pathStart);
+
+  // Queue an obstacle request, applying the queued ones when the queue is full
+  template <typename Request>
+  dtStatus queueObstacleRequest(const char* name, const Request& request);
+  // Rebuild the tiles touched by the queued obstacle requests
+  bool applyObstacleRequests();
 };
 
 namespace {
@@ -312,6 +1922,7 @@ struct Workspace {
   rcContourSet* cset = nullptr;
   rcPolyMesh* pmesh = nullptr;
   rcPolyMeshDetail* dmesh = nullptr;
+  rcHeightfieldLayerSet* lset = nullptr;
 
   ~Workspace() {
     rcFreeHeightField(solid);
@@ -320,40 +1931,12 @@ struct Workspace {
     rcFreeContourSet(cset);
     rcFreePolyMesh(pmesh);
     rcFreePolyMeshDetail(dmesh);
+    rcFreeHeightfieldLayerSet(lset);
   }
 };
 
-enum PolyAreas { POLYAREA_GROUND, POLYAREA_DOOR };
-
-enum PolyFlags {
-  POLYFLAGS_WALK = 0x01,      // walkable
-  POLYFLAGS_DOOR = 0x02,      // ability to move through doors
-  POLYFLAGS_DISABLED = 0x04,  // disabled polygon
-  POLYFLAGS_ALL = 0xffff      // all abilities
-};
-}  // namespace
-
-PathFinder::Impl::Impl() {
-  filter_ = std::make_unique<dtQueryFilter>();
-  filter_->setIncludeFlags(POLYFLAGS_WALK);
-  filter_->setExcludeFlags(0);
-}
-
-bool PathFinder::Impl::build(const NavMeshSettings& bs,
-                             const float* verts,
-                             const int nverts,
-                             const int* tris,
-                             const int ntris,
-                             const float* bmin,
-                             const float* bmax) {
-  Workspace ws;
-  rcContext ctx;
-
-  //
-  // Step 1. Initialize build config.
-  //
-
-  // Init build configuration from GUI
+// Init build configuration from GUI
+rcConfig makeConfig(const NavMeshSettings& bs) {
   rcConfig cfg{};
   memset(&cfg, 0, sizeof(cfg));
   cfg.cs = bs.cellSize;
@@ -372,16 +1955,96 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   cfg.detailSampleDist =
       bs.detailSampleDist < 0.9f ? 0 : bs.cellSize * bs.detailSampleDist;
   cfg.detailSampleMaxError = bs.cellHeight * bs.detailSampleMaxError;
+  return cfg;
+}
 
-  // Set the area where the navigation will be build.
-  // Here the bounds of the input mesh are used, but the
-  // area could be specified by an user defined box, etc.
-  rcVcopy(cfg.bmin, bmin);
-  rcVcopy(cfg.bmax, bmax);
-  rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
-  LOG(INFO) << "Building navmesh with " << cfg.width << "x" << cfg.height
-            << " cells";
+// A copy of the spans of a heightfield, null if out of memory
+rcHeightfield* copyHeightfield(rcContext& ctx, const rcHeightfield& hf) {
+  rcHeightfield* copy = rcAllocHeightfield();
+  if (!copy || !rcCreateHeightfield(&ctx, *copy, hf.width, hf.height, hf.bmin,
+                                    hf.bmax, hf.cs, hf.ch)) {
+    rcFreeHeightField(copy);
+    return nullptr;
+  }
+  // The spans of a column are apart and in order, so adding them again
+  // merges none
+  for (int i = 0; i < hf.width * hf.height; ++i) {
+    for (const rcSpan* span = hf.spans[i]; span; span = span->next) {
+      if (!rcAddSpan(&ctx, *copy, i % hf.width, i / hf.width, span->smin,
+                     span->smax, span->area, 0)) {
+        rcFreeHeightField(copy);
+        return nullptr;
+      }
+    }
+  }
+  return copy;
+}
+
+// Copy count elements of from to a new array, if from isn't null
+template <typename T>
+bool copyArray(T*& to, const T* from, const int count) {
+  if (!from) {
+    return true;
+  }
+  to = static_cast<T*>(rcAlloc(sizeof(T) * count, RC_ALLOC_PERM));
+  if (!to) {
+    return false;
+  }
+  std::memcpy(to, from, sizeof(T) * count);
+  return true;
+}
+
+// A copy of a compact heightfield, null if out of memory
+rcCompactHeightfield* copyCompactHeightfield(const rcCompactHeightfield& chf) {
+  rcCompactHeightfield* copy = rcAllocCompactHeightfield();
+  if (!copy) {
+    return nullptr;
+  }
+  copy->width = chf.width;
+  copy->height = chf.height;
+  copy->spanCount = chf.spanCount;
+  copy->walkableHeight = chf.walkableHeight;
+  copy->walkableClimb = chf.walkableClimb;
+  copy->borderSize = chf.borderSize;
+  copy->maxDistance = chf.maxDistance;
+  copy->maxRegions = chf.maxRegions;
+  rcVcopy(copy->bmin, chf.bmin);
+  rcVcopy(copy->bmax, chf.bmax);
+  copy->cs = chf.cs;
+  copy->ch = chf.ch;
+  if (!copyArray(copy->cells, chf.cells, chf.width * chf.height) ||
+      !copyArray(copy->spans, chf.spans, chf.spanCount) ||
+      !copyArray(copy->dist, chf.dist, chf.spanCount) ||
+      !copyArray(copy->areas, chf.areas, chf.spanCount)) {
+    rcFreeCompactHeightfield(copy);
+    return nullptr;
+  }
+  return copy;
+}
+
+// The hash of the triangles, to key the heightfield cache with
+uint64_t hashMesh(const float* verts,
+                  const int nverts,
+                  const int* tris,
+                  const int ntris) {
+  const uint64_t vertsHash =
+      core::hashBytes(Cr::Containers::arrayCast<const char>(
+          Cr::Containers::arrayView(verts, 3 * nverts)));
+  const uint64_t trisHash =
+      core::hashBytes(Cr::Containers::arrayCast<const char>(
+          Cr::Containers::arrayView(tris, 3 * ntris)));
+  // times the FNV prime so that swapping the arrays changes the hash
+  return vertsHash ^ (trisHash * 0x100000001b3ull);
+}
 
+// Rasterize the triangles into ws.solid, step 2 of PathFinder::build()
+bool rasterizeTriangles(rcContext& ctx,
+                        const rcConfig& cfg,
+                        const float* verts,
+                        const int nverts,
+                        const int* tris,
+                        const int ntris,
+                        Workspace& ws) {
   //
   // Step 2. Rasterize input polygon soup.
   //
@@ -418,7 +2081,15 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
     LOG(ERROR) << "Could not rasterize triangles.";
     return false;
   }
+  return true;
+}
 
+// Filter the walkable surface of ws.solid and compact it into ws.chf, steps 3
+// and 4 of PathFinder::build() up to the erosion
+bool compactWalkable(rcContext& ctx,
+                     const rcConfig& cfg,
+                     const NavMeshSettings& bs,
+                     Workspace& ws) {
   //
   // Step 3. Filter walkables surfaces.
   //
@@ -450,12 +2121,264 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
     LOG(ERROR) << "Could not build compact heightfield";
     return false;
   }
+  return true;
+}
+
+// Rasterize the triangles into ws.solid and filter and erode their walkable
+// surface into ws.chf, steps 2 to 4 of PathFinder::build(). The steps up to
+// the erosion are taken from cache when it has them, and stored in it if not.
+bool rasterizeWalkable(rcContext& ctx,
+                       const rcConfig& cfg,
+                       const NavMeshSettings& bs,
+                       const float* verts,
+                       const int nverts,
+                       const int* tris,
+                       const int ntris,
+                       Workspace& ws,
+                       impl::HeightfieldCache* cache = nullptr) {
+  const uint64_t meshHash =
+      cache ? hashMesh(verts, nverts, tris, ntris) : 0;
+  if (cache && cache->hasCompact(meshHash, cfg, bs)) {
+    ws.chf = copyCompactHeightfield(*cache->chf);
+    if (!ws.chf) {
+      LOG(ERROR) << "Out of memory for compact heightfield";
+      return false;
+    }
+  } else {
+    if (cache && cache->hasSolid(meshHash, cfg)) {
+      ws.solid = copyHeightfield(ctx, *cache->solid);
+      if (!ws.solid) {
+        LOG(ERROR) << "Out of memory for heightfield allocation";
+        return false;
+      }
+    } else {
+      if (!rasterizeTriangles(ctx, cfg, verts, nverts, tris, ntris, ws)) {
+        return false;
+      }
+      // the filters change the spans in place
+      if (cache) {
+        cache->setSolid(meshHash, cfg, copyHeightfield(ctx, *ws.solid));
+      }
+    }
+    if (!compactWalkable(ctx, cfg, bs, ws)) {
+      return false;
+    }
+    if (cache && cache->solid) {
+      cache->setCompact(cfg, bs, copyCompactHeightfield(*ws.chf));
+    }
+  }
 
   // Erode the walkable area by agent radius.
   if (!rcErodeWalkableArea(&ctx, cfg.walkableRadius, *ws.chf)) {
     LOG(ERROR) << "Could not erode walkable area";
     return false;
   }
+  return true;
+}
+
+// Rasterize the triangles overlapping tile (tileX, tileZ) of a tiled navmesh
+// with configuration tiledCfg into tile cache layers, appended to layers
+bool rasterizeTileLayers(const rcConfig& tiledCfg,
+                         const NavMeshSettings& bs,
+                         const float* verts,
+                         const int nverts,
+                         const std::vector<int>& tris,
+                         const int tileX,
+                         const int tileZ,
+                         dtTileCacheCompressor& compressor,
+                         std::vector<std::pair<unsigned char*, int>>& layers) {
+  if (tris.empty()) {
+    return true;
+  }
+
+  // the tile and a border deep enough for the erosion and the regions, the
+  // height range of its triangles as they may have moved since the first
+  // build
+  rcConfig cfg = tiledCfg;
+  const float tileWidth = cfg.tileSize * cfg.cs;
+  const float border = cfg.borderSize * cfg.cs;
+  cfg.bmin[0] = tiledCfg.bmin[0] + tileX * tileWidth - border;
+  cfg.bmin[2] = tiledCfg.bmin[2] + tileZ * tileWidth - border;
+  cfg.bmax[0] = tiledCfg.bmin[0] + (tileX + 1) * tileWidth + border;
+  cfg.bmax[2] = tiledCfg.bmin[2] + (tileZ + 1) * tileWidth + border;
+  cfg.bmin[1] = std::numeric_limits<float>::max();
+  cfg.bmax[1] = -std::numeric_limits<float>::max();
+  for (const int vertex : tris) {
+    cfg.bmin[1] = std::min(cfg.bmin[1], verts[3 * vertex + 1]);
+    cfg.bmax[1] = std::max(cfg.bmax[1], verts[3 * vertex + 1]);
+  }
+
+  rcContext ctx;
+  Workspace ws;
+  if (!rasterizeWalkable(ctx, cfg, bs, verts, nverts, tris.data(),
+                         tris.size() / 3, ws)) {
+    return false;
+  }
+
+  ws.lset = rcAllocHeightfieldLayerSet();
+  if (!ws.lset) {
+    LOG(ERROR) << "Out of memory for heightfield layers";
+    return false;
+  }
+  if (!rcBuildHeightfieldLayers(&ctx, *ws.chf, cfg.borderSize,
+                                cfg.walkableHeight, *ws.lset)) {
+    LOG(ERROR) << "Could not build heightfield layers";
+    return false;
+  }
+
+  for (int i = 0; i < std::min(ws.lset->nlayers, MAX_LAYERS); ++i) {
+    const rcHeightfieldLayer& layer = ws.lset->layers[i];
+    dtTileCacheLayerHeader header{};
+    header.magic = DT_TILECACHE_MAGIC;
+    header.version = DT_TILECACHE_VERSION;
+    header.tx = tileX;
+    header.ty = tileZ;
+    header.tlayer = i;
+    rcVcopy(header.bmin, layer.bmin);
+    rcVcopy(header.bmax, layer.bmax);
+    header.width = static_cast<unsigned char>(layer.width);
+    header.height = static_cast<unsigned char>(layer.height);
+    header.minx = static_cast<unsigned char>(layer.minx);
+    header.maxx = static_cast<unsigned char>(layer.maxx);
+    header.miny = static_cast<unsigned char>(layer.miny);
+    header.maxy = static_cast<unsigned char>(layer.maxy);
+    header.hmin = static_cast<unsigned short>(layer.hmin);
+    header.hmax = static_cast<unsigned short>(layer.hmax);
+
+    unsigned char* data = nullptr;
+    int dataSize = 0;
+    if (dtStatusFailed(dtBuildTileCacheLayer(&compressor, &header,
+                                             layer.heights, layer.areas,
+                                             layer.cons, &data, &dataSize))) {
+      LOG(ERROR) << "Could not build tile cache layer";
+      return false;
+    }
+    layers.emplace_back(data, dataSize);
+  }
+  return true;
+}
+
+// Build the Detour data of a tile cache layer as
+// dtTileCache::buildNavMeshTile() does for a layer without obstacles, but
+// with an allocator of its own so that layers can be built concurrently.
+// navData is null if the layer has no polygons.
+bool buildLayerNavMeshData(const dtTileCacheParams& tileCacheParams,
+                           dtTileCacheCompressor& compressor,
+                           dtTileCacheMeshProcess& meshProcess,
+                           unsigned char* data,
+                           const int dataSize,
+                           std::pair<unsigned char*, int>& navData) {
+  navData = {nullptr, 0};
+  dtTileCacheAlloc alloc;
+  struct Layer {
+    dtTileCacheAlloc& alloc;
+    dtTileCacheLayer* layer = nullptr;
+    dtTileCacheContourSet* lcset = nullptr;
+    dtTileCachePolyMesh* lmesh = nullptr;
+    ~Layer() {
+      dtFreeTileCacheLayer(&alloc, layer);
+      dtFreeTileCacheContourSet(&alloc, lcset);
+      dtFreeTileCachePolyMesh(&alloc, lmesh);
+    }
+  } bc{alloc};
+
+  if (dtStatusFailed(dtDecompressTileCacheLayer(&alloc, &compressor, data,
+                                                dataSize, &bc.layer))) {
+    return false;
+  }
+  const int walkableClimbVx = static_cast<int>(tileCacheParams.walkableClimb /
+                                               tileCacheParams.ch);
+  if (dtStatusFailed(
+          dtBuildTileCacheRegions(&alloc, *bc.layer, walkableClimbVx))) {
+    return false;
+  }
+  bc.lcset = dtAllocTileCacheContourSet(&alloc);
+  if (!bc.lcset ||
+      dtStatusFailed(dtBuildTileCacheContours(
+          &alloc, *bc.layer, walkableClimbVx,
+          tileCacheParams.maxSimplificationError, *bc.lcset))) {
+    return false;
+  }
+  bc.lmesh = dtAllocTileCachePolyMesh(&alloc);
+  if (!bc.lmesh ||
+      dtStatusFailed(dtBuildTileCachePolyMesh(&alloc, *bc.lcset, *bc.lmesh))) {
+    return false;
+  }
+  if (!bc.lmesh->npolys) {
+    return true;
+  }
+
+  const dtTileCacheLayerHeader& header = *bc.layer->header;
+  dtNavMeshCreateParams params{};
+  memset(&params, 0, sizeof(params));
+  params.verts = bc.lmesh->verts;
+  params.vertCount = bc.lmesh->nverts;
+  params.polys = bc.lmesh->polys;
+  params.polyAreas = bc.lmesh->areas;
+  params.polyFlags = bc.lmesh->flags;
+  params.polyCount = bc.lmesh->npolys;
+  params.nvp = DT_VERTS_PER_POLYGON;
+  params.walkableHeight = tileCacheParams.walkableHeight;
+  params.walkableRadius = tileCacheParams.walkableRadius;
+  params.walkableClimb = tileCacheParams.walkableClimb;
+  params.tileX = header.tx;
+  params.tileY = header.ty;
+  params.tileLayer = header.tlayer;
+  params.cs = tileCacheParams.cs;
+  params.ch = tileCacheParams.ch;
+  params.buildBvTree = false;
+  dtVcopy(params.bmin, header.bmin);
+  dtVcopy(params.bmax, header.bmax);
+  meshProcess.process(&params, bc.lmesh->areas, bc.lmesh->flags);
+  return dtCreateNavMeshData(&params, &navData.first, &navData.second);
+}
+}  // namespace
+
+PathFinder::Impl::Impl() {
+  heightfieldCache_ = std::make_unique<impl::HeightfieldCache>();
+  filter_ = std::make_unique<dtQueryFilter>();
+  filter_->setIncludeFlags(POLYFLAGS_WALK);
+  filter_->setExcludeFlags(0);
+}
+
+bool PathFinder::Impl::build(const NavMeshSettings& bs,
+                             const float* verts,
+                             const int nverts,
+                             const int* tris,
+                             const int ntris,
+                             const float* bmin,
+                             const float* bmax) {
+  if (bs.tileSize > 0) {
+    return buildTiled(bs, verts, nverts, tris, ntris, bmin, bmax);
+  }
+  tileCache_ = nullptr;
+
+  Workspace ws;
+  rcContext ctx;
+
+  //
+  // Step 1. Initialize build config.
+  //
+
+  rcConfig cfg = makeConfig(bs);
+
+  // Set the area where the navigation will be build.
+  // Here the bounds of the input mesh are used, but the
+  // area could be specified by an user defined box, etc.
+  rcVcopy(cfg.bmin, bmin);
+  rcVcopy(cfg.bmax, bmax);
+  rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
+  LOG(INFO) << "Building navmesh with " << cfg.width << "x" << cfg.height
+            << " cells";
+
+  //
+  // Steps 2 to 4. Rasterize, filter and erode the walkable surfaces.
+  //
+
+  if (!rasterizeWalkable(ctx, cfg, bs, verts, nverts, tris, ntris, ws,
+                         heightfieldCache_.get())) {
+    return false;
+  }
 
   // // (Optional) Mark areas.
   // const ConvexVolume* vols = geom->getConvexVolumes();
@@ -625,79 +2548,417 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
       return false;
     }
 
-    navMesh_.reset(dtAllocNavMesh());
-    if (!navMesh_) {
-      dtFree(navData);
-      LOG(ERROR) << "Could not allocate Detour navmesh";
-      return false;
+    navMesh_.reset(dtAllocNavMesh());
+    navMeshFile_ = nullptr;
+    if (!navMesh_) {
+      dtFree(navData);
+      LOG(ERROR) << "Could not allocate Detour navmesh";
+      return false;
+    }
+
+    dtStatus status;
+    status = navMesh_->init(navData, navDataSize, DT_TILE_FREE_DATA);
+    if (dtStatusFailed(status)) {
+      dtFree(navData);
+      LOG(ERROR) << "Could not init Detour navmesh";
+      return false;
+    }
+    if (!initNavQuery()) {
+      return false;
+    }
+  }
+
+  // Added as we also need to remove these on navmesh recomputation
+  removeZeroAreaPolys();
+
+  LOG(INFO) << "Created navmesh with " << ws.pmesh->nverts << " vertices "
+            << ws.pmesh->npolys << " polygons";
+
+  return true;
+}
+
+bool PathFinder::Impl::initNavQuery(
+    std::unique_ptr<impl::IslandSystem> islandSystem) {
+  // if we are reinitializing the NavQuery, then also reset the MeshData
+  meshData_.reset();
+
+  queryPool_ = std::make_unique<NavQueryPool>(navMesh_.get());
+  nodeGraph_.reset();
+  obstacleField_.reset();
+  topDownView_.resize(0, 0);
+  if (pathCache_) {
+    pathCache_->clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock{levelSystemMutex_};
+    levelSystem_.reset();
+    levelViews_.clear();
+  }
+  if (!queryPool_->acquire()) {
+    return false;
+  }
+
+  islandSystem_ = islandSystem ? std::move(islandSystem)
+                               : std::make_unique<impl::IslandSystem>(
+                                     navMesh_.get(), filter_.get());
+
+  return true;
+}
+
+bool PathFinder::Impl::build(const NavMeshSettings& bs,
+                             const esp::assets::MeshData& mesh) {
+  const int numVerts = mesh.vbo.size();
+  const int numIndices = mesh.ibo.size();
+  const float mf = std::numeric_limits<float>::max();
+  vec3f bmin(mf, mf, mf);
+  vec3f bmax(-mf, -mf, -mf);
+
+  for (int i = 0; i < numVerts; i++) {
+    const vec3f& p = mesh.vbo[i];
+    bmin = bmin.cwiseMin(p);
+    bmax = bmax.cwiseMax(p);
+  }
+
+  int* indices = new int[numIndices];
+  for (int i = 0; i < numIndices; i++) {
+    indices[i] = static_cast<int>(mesh.ibo[i]);
+  }
+
+  const bool success = build(bs, mesh.vbo[0].data(), numVerts, indices,
+                             numIndices / 3, bmin.data(), bmax.data());
+  delete[] indices;
+  return success;
+}
+
+bool PathFinder::Impl::buildTiled(const NavMeshSettings& bs,
+                                  const float* verts,
+                                  const int nverts,
+                                  const int* tris,
+                                  const int ntris,
+                                  const float* bmin,
+                                  const float* bmax) {
+  rcConfig cfg = makeConfig(bs);
+  rcVcopy(cfg.bmin, bmin);
+  rcVcopy(cfg.bmax, bmax);
+  int gridWidth = 0;
+  int gridDepth = 0;
+  rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &gridWidth, &gridDepth);
+  // the tile cache layers store their size in a byte
+  cfg.tileSize = std::min(bs.tileSize, 255);
+  cfg.borderSize = cfg.walkableRadius + 3;
+  cfg.width = cfg.tileSize + 2 * cfg.borderSize;
+  cfg.height = cfg.width;
+  const int tilesX = (gridWidth + cfg.tileSize - 1) / cfg.tileSize;
+  const int tilesZ = (gridDepth + cfg.tileSize - 1) / cfg.tileSize;
+  LOG(INFO) << "Building navmesh with " << tilesX << "x" << tilesZ
+            << " tiles of " << cfg.tileSize << "x" << cfg.tileSize << " cells";
+
+  dtTileCacheParams tileCacheParams{};
+  memset(&tileCacheParams, 0, sizeof(tileCacheParams));
+  rcVcopy(tileCacheParams.orig, cfg.bmin);
+  tileCacheParams.cs = cfg.cs;
+  tileCacheParams.ch = cfg.ch;
+  tileCacheParams.width = cfg.tileSize;
+  tileCacheParams.height = cfg.tileSize;
+  tileCacheParams.walkableHeight = bs.agentHeight;
+  tileCacheParams.walkableRadius = bs.agentRadius;
+  tileCacheParams.walkableClimb = bs.agentMaxClimb;
+  tileCacheParams.maxSimplificationError = bs.edgeMaxError;
+  tileCacheParams.maxTiles = tilesX * tilesZ * EXPECTED_LAYERS_PER_TILE;
+  tileCacheParams.maxObstacles = 128;
+
+  std::unique_ptr<dtTileCache, TileCacheDeleter> tileCache{dtAllocTileCache()};
+  if (!tileCache ||
+      dtStatusFailed(tileCache->init(&tileCacheParams, &tileCacheAlloc_,
+                                     &tileCacheCompressor_,
+                                     &tileCacheMeshProcess_))) {
+    LOG(ERROR) << "Could not init tile cache";
+    return false;
+  }
+
+  // 22 bits of the polygon references index the tiles and their polygons
+  const int tileBits = std::min(
+      static_cast<int>(dtIlog2(dtNextPow2(tileCacheParams.maxTiles))), 14);
+  dtNavMeshParams params{};
+  memset(&params, 0, sizeof(params));
+  rcVcopy(params.orig, cfg.bmin);
+  params.tileWidth = cfg.tileSize * cfg.cs;
+  params.tileHeight = cfg.tileSize * cfg.cs;
+  params.maxTiles = 1 << tileBits;
+  params.maxPolys = 1 << (22 - tileBits);
+
+  std::unique_ptr<dtNavMesh, NavMeshDeleter> navMesh{dtAllocNavMesh()};
+  if (!navMesh || dtStatusFailed(navMesh->init(&params))) {
+    LOG(ERROR) << "Could not init Detour navmesh";
+    return false;
+  }
+
+  navMesh_ = std::move(navMesh);
+  navMeshFile_ = nullptr;
+  tileCache_ = std::move(tileCache);
+  tileSettings_ = bs;
+  tileConfig_ = cfg;
+  tilesX_ = tilesX;
+  tilesZ_ = tilesZ;
+  return buildTiles(verts, nverts, tris, ntris, 0, 0, tilesX - 1, tilesZ - 1);
+}
+
+bool PathFinder::Impl::buildTiles(const float* verts,
+                                  const int nverts,
+                                  const int* tris,
+                                  const int ntris,
+                                  const int firstX,
+                                  const int firstZ,
+                                  const int lastX,
+                                  const int lastZ) {
+  const rcConfig& cfg = tileConfig_;
+  const float tileWidth = cfg.tileSize * cfg.cs;
+  const float border = cfg.borderSize * cfg.cs;
+  const int numX = lastX - firstX + 1;
+  const int numZ = lastZ - firstZ + 1;
+  if (numX <= 0 || numZ <= 0) {
+    return true;
+  }
+
+  // the triangles overlapping each tile and its border, in one pass over all
+  std::vector<std::vector<int>> tileTris(numX * numZ);
+  const auto tileIndex = [&](const float coordinate, const int axis) {
+    return static_cast<int>(
+        std::floor((coordinate - cfg.bmin[axis]) / tileWidth));
+  };
+  for (int i = 0; i < ntris; ++i) {
+    const float* a = &verts[3 * tris[3 * i]];
+    const float* b = &verts[3 * tris[3 * i + 1]];
+    const float* c = &verts[3 * tris[3 * i + 2]];
+    const int x0 = std::max(
+        firstX, tileIndex(std::min({a[0], b[0], c[0]}) - border, 0));
+    const int x1 = std::min(
+        lastX, tileIndex(std::max({a[0], b[0], c[0]}) + border, 0));
+    const int z0 = std::max(
+        firstZ, tileIndex(std::min({a[2], b[2], c[2]}) - border, 2));
+    const int z1 = std::min(
+        lastZ, tileIndex(std::max({a[2], b[2], c[2]}) + border, 2));
+    for (int z = z0; z <= z1; ++z) {
+      for (int x = x0; x <= x1; ++x) {
+        std::vector<int>& bin = tileTris[(z - firstZ) * numX + x - firstX];
+        bin.insert(bin.end(), &tris[3 * i], &tris[3 * i + 3]);
+      }
+    }
+  }
+
+  // rasterizing is most of the work and independent between tiles
+  std::vector<std::vector<std::pair<unsigned char*, int>>> tileLayers(
+      tileTris.size());
+  std::vector<char> rasterized(tileTris.size());
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelFor(
+      tileTris.size(), pool.numThreads() + 1,
+      [&](const std::size_t i, std::size_t) {
+        rasterized[i] = rasterizeTileLayers(
+            cfg, tileSettings_, verts, nverts, tileTris[i],
+            firstX + static_cast<int>(i) % numX,
+            firstZ + static_cast<int>(i) / numX, tileCacheCompressor_,
+            tileLayers[i]);
+      });
+
+  // The obstacles are marked in the layers by the tile cache, which then
+  // builds the navmesh tiles itself
+  bool obstacles = false;
+  for (int i = 0; i < tileCache_->getObstacleCount(); ++i) {
+    obstacles = obstacles || tileCache_->getObstacle(i)->state !=
+                                 DT_OBSTACLE_EMPTY;
+  }
+  std::vector<std::pair<unsigned char*, int>> addedLayers;
+
+  bool success = true;
+  for (std::size_t i = 0; i < tileTris.size(); ++i) {
+    const int x = firstX + static_cast<int>(i) % numX;
+    const int z = firstZ + static_cast<int>(i) / numX;
+    success = success && rasterized[i];
+
+    // drop the previous layers of the tile and the navmesh tiles built from
+    // them, there may be fewer layers now
+    dtCompressedTileRef oldLayers[MAX_LAYERS];
+    const int numOldLayers =
+        tileCache_->getTilesAt(x, z, oldLayers, MAX_LAYERS);
+    for (int j = 0; j < numOldLayers; ++j) {
+      tileCache_->removeTile(oldLayers[j], nullptr, nullptr);
+    }
+    const dtMeshTile* oldTiles[MAX_LAYERS];
+    const int numOldTiles = const_cast<const dtNavMesh*>(navMesh_.get())
+                                ->getTilesAt(x, z, oldTiles, MAX_LAYERS);
+    for (int j = 0; j < numOldTiles; ++j) {
+      navMesh_->removeTile(navMesh_->getTileRef(oldTiles[j]), nullptr,
+                           nullptr);
     }
 
-    dtStatus status;
-    status = navMesh_->init(navData, navDataSize, DT_TILE_FREE_DATA);
-    if (dtStatusFailed(status)) {
-      dtFree(navData);
-      LOG(ERROR) << "Could not init Detour navmesh";
-      return false;
+    for (const auto& layer : tileLayers[i]) {
+      if (dtStatusFailed(tileCache_->addTile(layer.first, layer.second,
+                                             DT_COMPRESSEDTILE_FREE_DATA,
+                                             nullptr))) {
+        LOG(ERROR) << "Could not add layer of tile " << x << ", " << z;
+        dtFree(layer.first);
+        success = false;
+      } else {
+        addedLayers.push_back(layer);
+      }
     }
-    if (!initNavQuery()) {
-      return false;
+    if (obstacles &&
+        dtStatusFailed(tileCache_->buildNavMeshTilesAt(x, z, navMesh_.get()))) {
+      LOG(ERROR) << "Could not build navmesh tile " << x << ", " << z;
+      success = false;
+    }
+  }
+
+  // the regions, contours and polygons of the layers are independent too,
+  // the tile cache only builds them one at a time
+  if (!obstacles) {
+    std::vector<std::pair<unsigned char*, int>> navData(addedLayers.size());
+    std::vector<char> built(addedLayers.size());
+    pool.parallelFor(addedLayers.size(), pool.numThreads() + 1,
+                     [&](const std::size_t i, std::size_t) {
+                       built[i] = buildLayerNavMeshData(
+                           *tileCache_->getParams(), tileCacheCompressor_,
+                           tileCacheMeshProcess_, addedLayers[i].first,
+                           addedLayers[i].second, navData[i]);
+                     });
+    for (std::size_t i = 0; i < addedLayers.size(); ++i) {
+      if (!built[i]) {
+        LOG(ERROR) << "Could not build navmesh tile layer";
+        success = false;
+      } else if (navData[i].first &&
+                 dtStatusFailed(navMesh_->addTile(
+                     navData[i].first, navData[i].second, DT_TILE_FREE_DATA,
+                     0, nullptr))) {
+        LOG(ERROR) << "Could not add navmesh tile layer";
+        dtFree(navData[i].first);
+        success = false;
+      }
     }
   }
 
   // Added as we also need to remove these on navmesh recomputation
   removeZeroAreaPolys();
+  return initNavQuery() && success;
+}
 
-  LOG(INFO) << "Created navmesh with " << ws.pmesh->nverts << " vertices "
-            << ws.pmesh->npolys << " polygons";
+bool PathFinder::Impl::rebuildTiles(const float* verts,
+                                    const int nverts,
+                                    const int* tris,
+                                    const int ntris,
+                                    const float* bmin,
+                                    const float* bmax) {
+  if (!tileCache_) {
+    LOG(ERROR) << "PathFinder::rebuildTiles(): the navmesh isn't tiled, "
+                  "build it with a nonzero NavMeshSettings::tileSize";
+    return false;
+  }
 
-  return true;
+  // the agent radius erodes the walkable surface next to the region too
+  const rcConfig& cfg = tileConfig_;
+  const float tileWidth = cfg.tileSize * cfg.cs;
+  const float margin = (cfg.walkableRadius + 1) * cfg.cs;
+  const auto tileIndex = [&](const float coordinate, const int axis,
+                             const int numTiles) {
+    const int index = static_cast<int>(
+        std::floor((coordinate - cfg.bmin[axis]) / tileWidth));
+    return std::min(std::max(index, 0), numTiles - 1);
+  };
+  return buildTiles(verts, nverts, tris, ntris,
+                    tileIndex(bmin[0] - margin, 0, tilesX_),
+                    tileIndex(bmin[2] - margin, 2, tilesZ_),
+                    tileIndex(bmax[0] + margin, 0, tilesX_),
+                    tileIndex(bmax[2] + margin, 2, tilesZ_));
 }
 
-bool PathFinder::Impl::initNavQuery() {
-  // if we are reinitializing the NavQuery, then also reset the MeshData
-  meshData_.reset();
+template <typename Request>
+dtStatus PathFinder::Impl::queueObstacleRequest(const char* name,
+                                                const Request& request) {
+  if (!tileCache_) {
+    LOG(ERROR) << "PathFinder::" << name << "(): the navmesh isn't tiled, "
+               << "build it with a nonzero NavMeshSettings::tileSize";
+    return DT_FAILURE;
+  }
 
-  navQuery_.reset(dtAllocNavMeshQuery());
-  dtStatus status = navQuery_->init(navMesh_.get(), 2048);
+  dtStatus status = request();
+  if (dtStatusDetail(status, DT_BUFFER_TOO_SMALL) &&
+      applyObstacleRequests()) {
+    status = request();
+  }
   if (dtStatusFailed(status)) {
-    LOG(ERROR) << "Could not init Detour navmesh query";
-    return false;
+    LOG(ERROR) << "PathFinder::" << name << "(): failed with Detour status "
+               << (status & DT_STATUS_DETAIL_MASK);
   }
+  return status;
+}
 
-  islandSystem_ =
-      std::make_unique<impl::IslandSystem>(navMesh_.get(), filter_.get());
-
+bool PathFinder::Impl::applyObstacleRequests() {
+  bool upToDate = false;
+  while (!upToDate) {
+    if (dtStatusFailed(tileCache_->update(0, navMesh_.get(), &upToDate))) {
+      LOG(ERROR) << "Could not rebuild the tiles touched by obstacles";
+      return false;
+    }
+  }
   return true;
 }
 
-bool PathFinder::Impl::build(const NavMeshSettings& bs,
-                             const esp::assets::MeshData& mesh) {
-  const int numVerts = mesh.vbo.size();
-  const int numIndices = mesh.ibo.size();
-  const float mf = std::numeric_limits<float>::max();
-  vec3f bmin(mf, mf, mf);
-  vec3f bmax(-mf, -mf, -mf);
+uint32_t PathFinder::Impl::addCylinderObstacle(const vec3f& position,
+                                               const float radius,
+                                               const float height) {
+  dtObstacleRef ref = 0;
+  const float grownRadius = radius + tileSettings_.agentRadius;
+  queueObstacleRequest("addCylinderObstacle", [&] {
+    return tileCache_->addObstacle(position.data(), grownRadius, height, &ref);
+  });
+  return ref;
+}
 
-  for (int i = 0; i < numVerts; i++) {
-    const vec3f& p = mesh.vbo[i];
-    bmin = bmin.cwiseMin(p);
-    bmax = bmax.cwiseMax(p);
-  }
+uint32_t PathFinder::Impl::addBoxObstacle(const vec3f& center,
+                                          const vec3f& halfExtents,
+                                          const float yRotation) {
+  dtObstacleRef ref = 0;
+  const vec3f grownHalfExtents =
+      halfExtents + vec3f{tileSettings_.agentRadius, 0.0f,
+                          tileSettings_.agentRadius};
+  queueObstacleRequest("addBoxObstacle", [&] {
+    return tileCache_->addBoxObstacle(center.data(), grownHalfExtents.data(),
+                                      yRotation, &ref);
+  });
+  return ref;
+}
 
-  int* indices = new int[numIndices];
-  for (int i = 0; i < numIndices; i++) {
-    indices[i] = static_cast<int>(mesh.ibo[i]);
+bool PathFinder::Impl::removeObstacle(const uint32_t obstacleID) {
+  if (tileCache_) {
+    const dtTileCacheObstacle* obstacle =
+        tileCache_->getObstacleByRef(obstacleID);
+    if (!obstacle || obstacle->state == DT_OBSTACLE_EMPTY) {
+      LOG(ERROR) << "PathFinder::removeObstacle(): no obstacle " << obstacleID;
+      return false;
+    }
   }
+  return dtStatusSucceed(queueObstacleRequest("removeObstacle", [&] {
+    return tileCache_->removeObstacle(obstacleID);
+  }));
+}
 
-  const bool success = build(bs, mesh.vbo[0].data(), numVerts, indices,
-                             numIndices / 3, bmin.data(), bmax.data());
-  delete[] indices;
-  return success;
+bool PathFinder::Impl::updateObstacles() {
+  if (!tileCache_) {
+    LOG(ERROR) << "PathFinder::updateObstacles(): the navmesh isn't tiled, "
+                  "build it with a nonzero NavMeshSettings::tileSize";
+    return false;
+  }
+  const bool success = applyObstacleRequests();
+  // the rebuilt tiles have new polygons, for the area and the islands too
+  removeZeroAreaPolys();
+  return initNavQuery() && success;
 }
 
 namespace {
 const int NAVMESHSET_MAGIC = 'M' << 24 | 'S' << 16 | 'E' << 8 | 'T';  //'MSET';
-const int NAVMESHSET_VERSION = 1;
+// Version 2 adds NavMeshMetadata after the header and the islands after the
+// tiles, version 1 files are still loaded
+const int NAVMESHSET_VERSION = 2;
 
 struct NavMeshSetHeader {
   int magic;
@@ -706,54 +2967,20 @@ struct NavMeshSetHeader {
   dtNavMeshParams params;
 };
 
+// What loading would otherwise compute from the tiles, as of saving, zero
+// area polygons were disabled in the saved tiles already
+struct NavMeshMetadata {
+  float navigableArea;
+  int numPolys;
+  float bmin[3];
+  float bmax[3];
+};
+
 struct NavMeshTileHeader {
   dtTileRef tileRef;
   int dataSize;
 };
 
-struct Triangle {
-  std::vector<vec3f> v;
-  Triangle() { v.resize(3); }
-};
-
-std::vector<Triangle> getPolygonTriangles(const dtPoly* poly,
-                                          const dtMeshTile* tile) {
-  // Code to iterate over triangles from here:
-  // https://github.com/recastnavigation/recastnavigation/blob/57610fa6ef31b39020231906f8c5d40eaa8294ae/Detour/Source/DetourNavMesh.cpp#L684
-  const std::ptrdiff_t ip = poly - tile->polys;
-  const dtPolyDetail* pd = &tile->detailMeshes[ip];
-  std::vector<Triangle> triangles(pd->triCount);
-
-  for (int j = 0; j < pd->triCount; ++j) {
-    const unsigned char* t = &tile->detailTris[(pd->triBase + j) * 4];
-    const float* v[3];
-    for (int k = 0; k < 3; ++k) {
-      if (t[k] < poly->vertCount)
-        triangles[j].v[k] =
-            Eigen::Map<const vec3f>(&tile->verts[poly->verts[t[k]] * 3]);
-      else
-        triangles[j].v[k] = Eigen::Map<const vec3f>(
-            &tile->detailVerts[(pd->vertBase + (t[k] - poly->vertCount)) * 3]);
-    }
-  }
-
-  return triangles;
-}
-
-// Calculate the area of a polygon by iterating over the triangles in the detail
-// mesh and computing their area
-float polyArea(const dtPoly* poly, const dtMeshTile* tile) {
-  std::vector<Triangle> triangles = getPolygonTriangles(poly, tile);
-
-  float area = 0;
-  for (auto& tri : triangles) {
-    const vec3f w1 = tri.v[1] - tri.v[0];
-    const vec3f w2 = tri.v[2] - tri.v[1];
-    area += 0.5 * w1.cross(w2).norm();
-  }
-
-  return area;
-}
 }  // namespace
 
 // Some polygons have zero area for some reason.  When we navigate into a zero
@@ -762,12 +2989,14 @@ float polyArea(const dtPoly* poly, const dtMeshTile* tile) {
 // Also compute the total NavMesh area for later query.
 void PathFinder::Impl::removeZeroAreaPolys() {
   navMeshArea_ = 0;
+  numPolys_ = 0;
   // Iterate over all tiles
   for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
     const dtMeshTile* tile =
         const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
-    if (!tile)
+    if (!tile || !tile->header)
       continue;
+    numPolys_ += tile->header->polyCount;
 
     // Iterate over all polygons in a tile
     for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
@@ -791,65 +3020,82 @@ void PathFinder::Impl::removeZeroAreaPolys() {
 }
 
 bool PathFinder::Impl::loadNavMesh(const std::string& path) {
-  FILE* fp = fopen(path.c_str(), "rb");
-  if (!fp)
-    return false;
+  // Mapped copy-on-write, Detour only writes to the polygons and links
+  return loadNavMeshData(core::mapFile(path), path);
+}
+
+bool PathFinder::Impl::loadNavMeshData(Cr::Containers::Array<char> file,
+                                       const std::string& name) {
+  std::size_t offset = 0;
+  auto readNext = [&](void* out, const std::size_t size) {
+    if (file.size() - offset < size)
+      return false;
+    memcpy(out, file.data() + offset, size);
+    offset += size;
+    return true;
+  };
 
   // Read header.
   NavMeshSetHeader header{};
-  size_t readLen = fread(&header, sizeof(NavMeshSetHeader), 1, fp);
-  if (readLen != 1) {
-    fclose(fp);
+  if (!readNext(&header, sizeof(NavMeshSetHeader))) {
     return false;
   }
   if (header.magic != NAVMESHSET_MAGIC) {
-    fclose(fp);
     return false;
   }
-  if (header.version != NAVMESHSET_VERSION) {
-    fclose(fp);
+  if (header.version != 1 && header.version != NAVMESHSET_VERSION) {
+    return false;
+  }
+  NavMeshMetadata metadata{};
+  if (header.version >= 2 && !readNext(&metadata, sizeof(NavMeshMetadata))) {
     return false;
   }
 
   vec3f bmin, bmax;
 
-  dtNavMesh* mesh = dtAllocNavMesh();
+  std::unique_ptr<dtNavMesh, NavMeshDeleter> mesh{dtAllocNavMesh()};
   if (!mesh) {
-    fclose(fp);
     return false;
   }
   dtStatus status = mesh->init(&header.params);
   if (dtStatusFailed(status)) {
-    fclose(fp);
     return false;
   }
 
   // Read tiles.
   for (int i = 0; i < header.numTiles; ++i) {
     NavMeshTileHeader tileHeader{};
-    readLen = fread(&tileHeader, sizeof(tileHeader), 1, fp);
-    if (readLen != 1) {
-      fclose(fp);
+    if (!readNext(&tileHeader, sizeof(tileHeader))) {
       return false;
     }
 
     if (!tileHeader.tileRef || !tileHeader.dataSize)
       break;
-
-    unsigned char* data = static_cast<unsigned char*>(
-        dtAlloc(tileHeader.dataSize, DT_ALLOC_PERM));
-    if (!data)
-      break;
-    memset(data, 0, tileHeader.dataSize);
-    readLen = fread(data, tileHeader.dataSize, 1, fp);
-    if (readLen != 1) {
-      dtFree(data);
-      fclose(fp);
+    if (tileHeader.dataSize < 0 ||
+        file.size() - offset < std::size_t(tileHeader.dataSize)) {
       return false;
     }
 
-    mesh->addTile(data, tileHeader.dataSize, DT_TILE_FREE_DATA,
-                  tileHeader.tileRef, nullptr);
+    // The tile data is used in place, unless it isn't aligned for Detour
+    unsigned char* data =
+        reinterpret_cast<unsigned char*>(file.data() + offset);
+    int flags = 0;
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(float) != 0) {
+      data = static_cast<unsigned char*>(
+          dtAlloc(tileHeader.dataSize, DT_ALLOC_PERM));
+      if (!data)
+        break;
+      memcpy(data, file.data() + offset, tileHeader.dataSize);
+      flags = DT_TILE_FREE_DATA;
+    }
+    offset += tileHeader.dataSize;
+
+    if (dtStatusFailed(mesh->addTile(data, tileHeader.dataSize, flags,
+                                     tileHeader.tileRef, nullptr))) {
+      if (flags & DT_TILE_FREE_DATA)
+        dtFree(data);
+      return false;
+    }
     const dtMeshTile* tile = mesh->getTileByRef(tileHeader.tileRef);
     if (i == 0) {
       bmin = vec3f(tile->header->bmin);
@@ -860,14 +3106,30 @@ bool PathFinder::Impl::loadNavMesh(const std::string& path) {
     }
   }
 
-  fclose(fp);
+  std::unique_ptr<impl::IslandSystem> islandSystem;
+  if (header.version >= 2) {
+    islandSystem = impl::IslandSystem::load(mesh.get(), file.suffix(offset));
+    if (!islandSystem) {
+      LOG(WARNING) << "PathFinder::loadNavMesh(): invalid islands in " << name
+                   << ", recomputing them";
+    }
+  }
 
-  navMesh_.reset(mesh);
-  bounds_ = std::make_pair(bmin, bmax);
+  // The previous navmesh goes before the file it may point into
+  navMesh_ = std::move(mesh);
+  navMeshFile_ = std::move(file);
+  tileCache_ = nullptr;
 
-  removeZeroAreaPolys();
+  if (header.version >= 2) {
+    navMeshArea_ = metadata.navigableArea;
+    numPolys_ = metadata.numPolys;
+    bounds_ = std::make_pair(vec3f(metadata.bmin), vec3f(metadata.bmax));
+  } else {
+    bounds_ = std::make_pair(bmin, bmax);
+    removeZeroAreaPolys();
+  }
 
-  return initNavQuery();
+  return initNavQuery(std::move(islandSystem));
 }
 
 bool PathFinder::Impl::saveNavMesh(const std::string& path) {
@@ -893,6 +3155,13 @@ bool PathFinder::Impl::saveNavMesh(const std::string& path) {
   memcpy(&header.params, navMesh->getParams(), sizeof(dtNavMeshParams));
   fwrite(&header, sizeof(NavMeshSetHeader), 1, fp);
 
+  NavMeshMetadata metadata{};
+  metadata.navigableArea = navMeshArea_;
+  metadata.numPolys = numPolys_;
+  Eigen::Map<vec3f>(metadata.bmin) = bounds_.first;
+  Eigen::Map<vec3f>(metadata.bmax) = bounds_.second;
+  fwrite(&metadata, sizeof(NavMeshMetadata), 1, fp);
+
   // Store tiles.
   for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
     const dtMeshTile* tile = navMesh->getTile(i);
@@ -907,34 +3176,148 @@ bool PathFinder::Impl::saveNavMesh(const std::string& path) {
     fwrite(tile->data, tile->dataSize, 1, fp);
   }
 
+  if (islandSystem_)
+    islandSystem_->save(fp);
+
+  const bool success = ferror(fp) == 0;
   fclose(fp);
 
-  return true;
+  return success;
 }
 
 void PathFinder::Impl::seed(uint32_t newSeed) {
-  // TODO: this should be using core::Random instead, but passing function
-  // to navQuery_->findRandomPoint needs to be figured out first
-  srand(newSeed);
+  std::lock_guard<std::mutex> lock{randomMutex_};
+  random_.seed(newSeed);
 }
 
-// Returns a random number [0..1]
-static float frand() {
-  return static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+namespace {
+// dtNavMeshQuery::findRandomPoint takes a plain function, which draws from
+// the generator of the query running on this thread
+thread_local core::Random* frandGenerator = nullptr;
+
+// Returns a random number [0..1)
+float frand() {
+  return frandGenerator->uniform_float_01();
 }
+}  // namespace
 
 vec3f PathFinder::Impl::getRandomNavigablePoint() {
   dtPolyRef ref;
   constexpr float inf = std::numeric_limits<float>::infinity();
   vec3f pt(inf, inf, inf);
-  dtStatus status =
-      navQuery_->findRandomPoint(filter_.get(), frand, &ref, pt.data());
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return pt;
+  }
+  dtStatus status;
+  {
+    std::lock_guard<std::mutex> lock{randomMutex_};
+    frandGenerator = &random_;
+    status = navQuery->findRandomPoint(filter_.get(), frand, &ref, pt.data());
+    frandGenerator = nullptr;
+  }
   if (!dtStatusSucceed(status)) {
-    LOG(ERROR) << "Failed to getRandomNavigablePoint";
+    ESP_HOT_LOG(ERROR) << "Failed to getRandomNavigablePoint";
   }
   return pt;
 }
 
+bool PathFinder::Impl::randomPointOnIsland(dtNavMeshQuery* navQuery,
+                                           const uint32_t island,
+                                           const float u,
+                                           const float s,
+                                           const float t,
+                                           dtPolyRef& ref,
+                                           vec3f& pt) const {
+  // Like dtNavMeshQuery::findRandomPoint, which also picks a polygon by area
+  // then a point in it, but in O(log n) from the areas of the island
+  ref = islandSystem_->randomPoly(island, u);
+  return randomPointInPoly(navQuery, ref, s, t, pt);
+}
+
+bool PathFinder::Impl::randomPointInPoly(dtNavMeshQuery* navQuery,
+                                         const dtPolyRef ref,
+                                         const float s,
+                                         const float t,
+                                         vec3f& pt) const {
+  const dtMeshTile* tile = nullptr;
+  const dtPoly* poly = nullptr;
+  if (!ref ||
+      dtStatusFailed(navMesh_->getTileAndPolyByRef(ref, &tile, &poly))) {
+    return false;
+  }
+  float verts[3 * DT_VERTS_PER_POLYGON];
+  float areas[DT_VERTS_PER_POLYGON];
+  for (int iVert = 0; iVert < poly->vertCount; ++iVert) {
+    dtVcopy(&verts[iVert * 3], &tile->verts[poly->verts[iVert] * 3]);
+  }
+  dtRandomPointInConvexPoly(verts, poly->vertCount, areas, s, t, pt.data());
+  return dtStatusSucceed(navQuery->getPolyHeight(ref, pt.data(), &pt[1]));
+}
+
+vec3f PathFinder::Impl::getRandomNavigablePointOnIsland(
+    const int islandIndex) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  vec3f pt(inf, inf, inf);
+  if (!islandSystem_ || islandIndex < 0 ||
+      islandIndex >= islandSystem_->numIslands()) {
+    ESP_HOT_LOG(ERROR)
+        << "Failed to getRandomNavigablePointOnIsland: no island "
+        << islandIndex;
+    return pt;
+  }
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return pt;
+  }
+
+  dtPolyRef ref;
+  vec3f randomPt;
+  float u, s, t;
+  {
+    std::lock_guard<std::mutex> lock{randomMutex_};
+    u = random_.uniform_float_01();
+    s = random_.uniform_float_01();
+    t = random_.uniform_float_01();
+  }
+  if (!randomPointOnIsland(navQuery.get(), islandIndex, u, s, t, ref,
+                           randomPt)) {
+    ESP_HOT_LOG(ERROR) << "Failed to getRandomNavigablePointOnIsland";
+    return pt;
+  }
+  return randomPt;
+}
+
+vec3f PathFinder::Impl::getRandomNavigablePointOnLevel(const int levelIndex) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  vec3f pt(inf, inf, inf);
+  const std::shared_ptr<const impl::LevelSystem> levels = levelSystem();
+  if (!levels || levelIndex < 0 || levelIndex >= levels->numLevels()) {
+    ESP_HOT_LOG(ERROR) << "Failed to getRandomNavigablePointOnLevel: no level "
+                       << levelIndex;
+    return pt;
+  }
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return pt;
+  }
+
+  vec3f randomPt;
+  float u, s, t;
+  {
+    std::lock_guard<std::mutex> lock{randomMutex_};
+    u = random_.uniform_float_01();
+    s = random_.uniform_float_01();
+    t = random_.uniform_float_01();
+  }
+  const dtPolyRef ref = levels->randomPoly(levelIndex, u);
+  if (!randomPointInPoly(navQuery.get(), ref, s, t, randomPt)) {
+    ESP_HOT_LOG(ERROR) << "Failed to getRandomNavigablePointOnLevel";
+    return pt;
+  }
+  return randomPt;
+}
+
 namespace {
 float pathLength(const std::vector<vec3f>& points) {
   CORRADE_INTERNAL_ASSERT(points.size() > 0);
@@ -950,7 +3333,44 @@ float pathLength(const std::vector<vec3f>& points) {
 }
 }  // namespace
 
+void PathFinder::Impl::enablePathCache(const std::size_t capacity,
+                                       const float quantum) {
+  CORRADE_ASSERT(capacity > 0 && quantum > 0,
+                 "PathFinder::enablePathCache(): expected a positive capacity "
+                 "and quantum, got"
+                     << capacity << "and" << quantum, );
+  pathCache_ = std::make_unique<impl::PathCache>(capacity, quantum);
+}
+
 bool PathFinder::Impl::findPath(ShortestPath& path) {
+  ESP_PROFILE_SCOPE("PathFinder::findPath");
+  impl::PathCache::Key key;
+  bool cacheable = false;
+  if (pathCache_) {
+    const NavQueryPool::Query navQuery = queryPool_->acquire();
+    dtStatus startStatus = DT_FAILURE, endStatus = DT_FAILURE;
+    dtPolyRef startRef = 0, endRef = 0;
+    if (navQuery) {
+      std::tie(startStatus, startRef, std::ignore) =
+          projectToPoly(path.requestedStart, navQuery.get(), filter_.get());
+      std::tie(endStatus, endRef, std::ignore) =
+          projectToPoly(path.requestedEnd, navQuery.get(), filter_.get());
+    }
+    // the points off the navmesh fail right away
+    cacheable = startStatus == DT_SUCCESS && startRef != 0 &&
+                endStatus == DT_SUCCESS && endRef != 0;
+    if (cacheable) {
+      key = pathCache_->key(startRef, endRef, path.requestedStart,
+                            path.requestedEnd);
+      impl::PathCache::Result result;
+      if (pathCache_->find(key, result)) {
+        path.geodesicDistance = result.geodesicDistance;
+        path.points = std::move(result.points);
+        return result.found;
+      }
+    }
+  }
+
   MultiGoalShortestPath tmp;
   tmp.requestedStart = path.requestedStart;
   tmp.setRequestedEnds({path.requestedEnd});
@@ -959,11 +3379,15 @@ bool PathFinder::Impl::findPath(ShortestPath& path) {
 
   path.geodesicDistance = tmp.geodesicDistance;
   path.points = std::move(tmp.points);
+  if (cacheable) {
+    pathCache_->insert(key, {status, path.geodesicDistance, path.points});
+  }
   return status;
 }
 
 Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-PathFinder::Impl::findPathInternal(const vec3f& start,
+PathFinder::Impl::findPathInternal(dtNavMeshQuery* navQuery,
+                                   const vec3f& start,
                                    dtPolyRef startRef,
                                    const vec3f& pathStart,
                                    const vec3f& end,
@@ -984,17 +3408,17 @@ PathFinder::Impl::findPathInternal(const vec3f& start,
 
   int numPolys = 0;
   dtStatus status =
-      navQuery_->findPath(startRef, endRef, pathStart.data(), pathEnd.data(),
-                          filter_.get(), polys, &numPolys, MAX_POLYS);
+      navQuery->findPath(startRef, endRef, pathStart.data(), pathEnd.data(),
+                         filter_.get(), polys, &numPolys, MAX_POLYS);
   if (status != DT_SUCCESS || numPolys == 0) {
     return Cr::Containers::NullOpt;
   }
 
   int numPoints = 0;
   std::vector<vec3f> points(MAX_POLYS);
-  status = navQuery_->findStraightPath(start.data(), end.data(), polys,
-                                       numPolys, points[0].data(), nullptr,
-                                       nullptr, &numPoints, MAX_POLYS);
+  status = navQuery->findStraightPath(start.data(), end.data(), polys,
+                                      numPolys, points[0].data(), nullptr,
+                                      nullptr, &numPoints, MAX_POLYS);
   if (status != DT_SUCCESS || numPoints == 0) {
     return Corrade::Containers::NullOpt;
   }
@@ -1006,7 +3430,8 @@ PathFinder::Impl::findPathInternal(const vec3f& start,
   return std::make_tuple(length, std::move(points));
 }
 
-bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
+bool PathFinder::Impl::findPathSetup(dtNavMeshQuery* navQuery,
+                                     MultiGoalShortestPath& path,
                                      dtPolyRef& startRef,
                                      vec3f& pathStart) {
   path.geodesicDistance = std::numeric_limits<float>::infinity();
@@ -1015,99 +3440,489 @@ bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
   // find nearest polys and path
   dtStatus status;
   std::tie(status, startRef, pathStart) =
-      projectToPoly(path.requestedStart, navQuery_.get(), filter_.get());
+      projectToPoly(path.requestedStart, navQuery, filter_.get());
 
   if (status != DT_SUCCESS || startRef == 0) {
     return false;
   }
 
-  if (path.pimpl_->endRefs.size() != 0)
-    return true;
+  if (path.pimpl_->endRefs.size() != 0)
+    return true;
+
+  for (const auto& rqEnd : path.getRequestedEnds()) {
+    dtPolyRef endRef;
+    vec3f pathEnd;
+    std::tie(status, endRef, pathEnd) =
+        projectToPoly(rqEnd, navQuery, filter_.get());
+
+    if (status != DT_SUCCESS || endRef == 0) {
+      return false;
+    }
+
+    path.pimpl_->endRefs.emplace_back(endRef);
+    path.pimpl_->pathEnds.emplace_back(pathEnd);
+  }
+
+  return true;
+}
+
+std::shared_ptr<const impl::NodeGraph> PathFinder::Impl::nodeGraph() {
+  // node spacing of the backward searches, which only pick the ends to try
+  constexpr float searchNodeSpacing = 0.5f;
+  std::lock_guard<std::mutex> lock{nodeGraphMutex_};
+  if (!nodeGraph_) {
+    nodeGraph_ = std::make_shared<const impl::NodeGraph>(
+        navMesh_.get(), filter_.get(), searchNodeSpacing);
+  }
+  return nodeGraph_;
+}
+
+bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
+  ESP_PROFILE_SCOPE("PathFinder::findPath");
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  dtPolyRef startRef;
+  vec3f pathStart;
+  if (!navQuery || !findPathSetup(navQuery.get(), path, startRef, pathStart))
+    return false;
+
+  MultiGoalShortestPath::Impl& ends = *path.pimpl_;
+  const std::size_t numEnds = ends.requestedEnds.size();
+
+  // Ends farther than the shortest path found so far can't be closer, so try
+  // them by their straight line distance and, first, the closest end of the
+  // backward search from all ends. The search is resumed from where the
+  // previous queries left it, so that it costs little as the start moves.
+  // Its paths, a little longer than the shortest ones, also bound the ends
+  // worth trying, with a margin for Detour's paths along the shortest
+  // corridor, which may be longer than the shortest paths.
+  std::vector<float> lowerBounds(numEnds);
+  for (std::size_t i = 0; i < numEnds; ++i) {
+    lowerBounds[i] = (ends.requestedEnds[i] - path.requestedStart).norm();
+  }
+  std::vector<size_t> ordering(numEnds);
+  std::iota(ordering.begin(), ordering.end(), 0);
+  float searchBound = std::numeric_limits<float>::infinity();
+  int closestEnd = ID_UNDEFINED;
+  if (numEnds > 1) {
+    const std::shared_ptr<const impl::NodeGraph> graph = nodeGraph();
+    if (!ends.search || ends.search->graph() != graph) {
+      ends.search.emplace(graph);
+      for (std::size_t i = 0; i < numEnds; ++i) {
+        const auto endPoly = graph->polyIndex.find(ends.endRefs[i]);
+        if (endPoly != graph->polyIndex.end())
+          ends.search->addGoal(endPoly->second, ends.pathEnds[i], i);
+      }
+    }
+    const auto startPoly = graph->polyIndex.find(startRef);
+    if (startPoly != graph->polyIndex.end()) {
+      const float searchDistance =
+          ends.search->distance(startPoly->second, pathStart, &closestEnd);
+      searchBound = 0.5f + 1.1f * searchDistance;
+    }
+  }
+  const auto isClosestEnd = [&](const size_t i) {
+    return static_cast<int>(i) == closestEnd;
+  };
+  std::sort(ordering.begin(), ordering.end(),
+            [&](const size_t a, const size_t b) -> bool {
+              if (isClosestEnd(a) != isClosestEnd(b))
+                return isClosestEnd(a);
+              return lowerBounds[a] < lowerBounds[b];
+            });
+
+  for (size_t i : ordering) {
+    if (lowerBounds[i] > path.geodesicDistance || lowerBounds[i] > searchBound)
+      continue;
+
+    const Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+        findResult = findPathInternal(
+            navQuery.get(), path.requestedStart, startRef, pathStart,
+            ends.requestedEnds[i], ends.endRefs[i], ends.pathEnds[i]);
+
+    if (findResult && std::get<0>(*findResult) < path.geodesicDistance) {
+      path.geodesicDistance = std::get<0>(*findResult);
+      path.points = std::get<1>(*findResult);
+    }
+  }
+
+  return path.geodesicDistance < std::numeric_limits<float>::infinity();
+}
+
+std::vector<float> PathFinder::Impl::findPathsBatch(
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends,
+    std::vector<vec3f>* points,
+    std::vector<std::size_t>* pointOffsets) {
+  ESP_PROFILE_SCOPE("PathFinder::findPathsBatch");
+  CORRADE_ASSERT(starts.size() == ends.size(),
+                 "PathFinder::findPathsBatch(): got" << starts.size()
+                                                     << "starts but"
+                                                     << ends.size() << "ends",
+                 {});
+  const std::size_t count = starts.size();
+  std::vector<float> distances(count, std::numeric_limits<float>::infinity());
+  std::vector<std::vector<vec3f>> paths(points || pointOffsets ? count : 0);
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers =
+      navMesh_ ? pool.numWorkers(count, pool.numThreads() + 1) : 0;
+  std::vector<NavQueryPool::Query> workerQueries;
+  for (std::size_t worker = 0; worker < workers; ++worker) {
+    workerQueries.push_back(queryPool_->acquire());
+    if (!workerQueries.back())
+      return distances;
+  }
+
+  auto findOne = [&](const std::size_t i, const std::size_t worker) {
+    dtNavMeshQuery* navQuery = workerQueries[worker].get();
+    dtStatus status;
+    dtPolyRef startRef, endRef;
+    vec3f pathStart, pathEnd;
+    std::tie(status, startRef, pathStart) =
+        projectToPoly(starts[i], navQuery, filter_.get());
+    if (status != DT_SUCCESS || startRef == 0)
+      return;
+    std::tie(status, endRef, pathEnd) =
+        projectToPoly(ends[i], navQuery, filter_.get());
+    if (status != DT_SUCCESS || endRef == 0)
+      return;
+
+    Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+        findResult = findPathInternal(navQuery, starts[i], startRef,
+                                      pathStart, ends[i], endRef, pathEnd);
+    if (findResult) {
+      distances[i] = std::get<0>(*findResult);
+      if (!paths.empty())
+        paths[i] = std::move(std::get<1>(*findResult));
+    }
+  };
+
+  if (workers == 1) {
+    for (std::size_t i = 0; i < count; ++i)
+      findOne(i, 0);
+  } else if (workers > 1) {
+    pool.parallelFor(count, workers, findOne);
+  }
+
+  if (pointOffsets) {
+    pointOffsets->clear();
+    pointOffsets->reserve(count + 1);
+    std::size_t offset = 0;
+    for (const auto& path : paths) {
+      pointOffsets->push_back(offset);
+      offset += path.size();
+    }
+    pointOffsets->push_back(offset);
+  }
+  if (points) {
+    points->clear();
+    for (const auto& path : paths)
+      points->insert(points->end(), path.begin(), path.end());
+  }
+  return distances;
+}
+
+std::vector<Episode> PathFinder::Impl::sampleEpisodes(
+    const int count,
+    const uint32_t seed,
+    const EpisodeSamplingSettings& settings) {
+  if (!navMesh_ || !islandSystem_ || count <= 0) {
+    return {};
+  }
+
+  // The islands to sample on and a running sum of their areas, to pick one
+  // by area
+  std::vector<uint32_t> islands;
+  std::vector<float> islandAreas;
+  for (int i = 0; i < islandSystem_->numIslands(); ++i) {
+    if ((settings.island != ID_UNDEFINED && i != settings.island) ||
+        islandSystem_->islandArea(i) <= 0.0f ||
+        islandSystem_->radiusOfIsland(i) < settings.minIslandRadius)
+      continue;
+    islands.push_back(i);
+    islandAreas.push_back((islandAreas.empty() ? 0.0f : islandAreas.back()) +
+                          islandSystem_->islandArea(i));
+  }
+  if (islands.empty()) {
+    LOG(ERROR) << "PathFinder::sampleEpisodes(): no island satisfies the "
+                  "constraints";
+    return {};
+  }
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers = pool.numWorkers(count, pool.numThreads() + 1);
+  std::vector<NavQueryPool::Query> workerQueries;
+  for (std::size_t worker = 0; worker < workers; ++worker) {
+    workerQueries.push_back(queryPool_->acquire());
+    if (!workerQueries.back())
+      return {};
+  }
+
+  // each episode draws from its own stream of the seed
+  const core::Random episodeRandom{seed};
+  std::vector<Cr::Containers::Optional<Episode>> episodes(count);
+  auto sampleOne = [&](const std::size_t i, const std::size_t worker) {
+    dtNavMeshQuery* navQuery = workerQueries[worker].get();
+    core::Random random = episodeRandom.split(i);
+    for (int attempt = 0; attempt < settings.maxAttempts; ++attempt) {
+      auto it =
+          std::upper_bound(islandAreas.begin(), islandAreas.end(),
+                           random.uniform_float_01() * islandAreas.back());
+      if (it == islandAreas.end())
+        --it;
+      const uint32_t island = islands[it - islandAreas.begin()];
+
+      dtPolyRef startRef, goalRef;
+      vec3f start, goal;
+      // drawn in a fixed order, unlike function arguments
+      float uniforms[6];
+      for (float& uniform : uniforms)
+        uniform = random.uniform_float_01();
+      if (!randomPointOnIsland(navQuery, island, uniforms[0], uniforms[1],
+                               uniforms[2], startRef, start) ||
+          !randomPointOnIsland(navQuery, island, uniforms[3], uniforms[4],
+                               uniforms[5], goalRef, goal))
+        continue;
 
-  for (const auto& rqEnd : path.getRequestedEnds()) {
-    dtPolyRef endRef;
-    vec3f pathEnd;
-    std::tie(status, endRef, pathEnd) =
-        projectToPoly(rqEnd, navQuery_.get(), filter_.get());
+      // the geodesic distance is at least the euclidean one, so far apart
+      // pairs are rejected before searching for their path
+      const float euclideanDistance = (goal - start).norm();
+      if (std::abs(goal[1] - start[1]) > settings.maxHeightDifference ||
+          euclideanDistance * settings.minGeodesicToEuclideanRatio >
+              settings.maxGeodesicDistance)
+        continue;
 
-    if (status != DT_SUCCESS || endRef == 0) {
-      return false;
+      Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+          findResult = findPathInternal(navQuery, start, startRef, start, goal,
+                                        goalRef, goal);
+      if (!findResult)
+        continue;
+      const float geodesicDistance = std::get<0>(*findResult);
+      if (geodesicDistance < settings.minGeodesicDistance ||
+          geodesicDistance > settings.maxGeodesicDistance ||
+          geodesicDistance <
+              euclideanDistance * settings.minGeodesicToEuclideanRatio)
+        continue;
+
+      episodes[i] = Episode{start, goal, geodesicDistance};
+      return;
     }
+  };
 
-    path.pimpl_->endRefs.emplace_back(endRef);
-    path.pimpl_->pathEnds.emplace_back(pathEnd);
+  if (workers == 1) {
+    for (int i = 0; i < count; ++i)
+      sampleOne(i, 0);
+  } else {
+    pool.parallelFor(count, workers, sampleOne);
   }
 
-  return true;
+  std::vector<Episode> result;
+  result.reserve(count);
+  for (const auto& episode : episodes) {
+    if (episode)
+      result.push_back(*episode);
+  }
+  if (result.size() < episodes.size()) {
+    LOG(WARNING) << "PathFinder::sampleEpisodes(): found only "
+                 << result.size() << " of " << count << " episodes in "
+                 << settings.maxAttempts << " attempts each";
+  }
+  return result;
 }
 
-bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
-  dtPolyRef startRef;
-  vec3f pathStart;
-  if (!findPathSetup(path, startRef, pathStart))
-    return false;
+GeodesicDistanceField::ptr PathFinder::Impl::buildGeodesicDistanceField(
+    const std::vector<vec3f>& goals,
+    const float nodeSpacing) {
+  const NavQueryPool::Query navQuery =
+      navMesh_ ? queryPool_->acquire() : NavQueryPool::Query{};
+  if (!navQuery) {
+    LOG(ERROR) << "PathFinder::buildGeodesicDistanceField(): no navmesh";
+    return nullptr;
+  }
 
-  if (path.pimpl_->requestedEnds.size() > 1) {
-    // Bound the minimum distance any point could be from the start by either
-    // how close it use to be minus how much we moved from the last search point
-    // or just the L2 distance.
+  impl::GraphSearch search{std::make_shared<const impl::NodeGraph>(
+      navMesh_.get(), filter_.get(), nodeSpacing)};
+  const impl::NodeGraph& graph = *search.graph();
+  for (const vec3f& goal : goals) {
+    dtStatus status;
+    dtPolyRef goalRef;
+    vec3f goalPt;
+    std::tie(status, goalRef, goalPt) =
+        projectToPoly(goal, navQuery.get(), filter_.get());
+    const auto goalPoly = graph.polyIndex.find(goalRef);
+    if (status != DT_SUCCESS || goalPoly == graph.polyIndex.end()) {
+      LOG(WARNING) << "PathFinder::buildGeodesicDistanceField(): ignoring "
+                      "the goal off the navmesh at "
+                   << goal.transpose();
+      continue;
+    }
+    search.addGoal(goalPoly->second, goalPt);
+  }
+  search.run();
+
+  auto field = GeodesicDistanceField::create();
+  GeodesicDistanceField::Impl& fieldData = *field->pimpl_;
+  fieldData.goals = goals;
+  fieldData.nodeSpacing = nodeSpacing;
+  fieldData.numNavMeshPolys = numPolys_;
+  fieldData.navMeshArea = navMeshArea_;
+  std::vector<int> sortedPolys(graph.polys.size());
+  std::iota(sortedPolys.begin(), sortedPolys.end(), 0);
+  std::sort(sortedPolys.begin(), sortedPolys.end(),
+            [&](const int a, const int b) {
+              return graph.polys[a] < graph.polys[b];
+            });
+  const std::vector<float>& distances = search.distances();
+  for (const int i : sortedPolys) {
+    const std::size_t first = fieldData.nodes.size();
+    for (const impl::GraphSearch::Goal& goal : search.polyGoals(i)) {
+      fieldData.nodes.push_back(goal.position);
+      fieldData.nodeDistances.push_back(0.0f);
+    }
+    for (const int node : graph.polyNodes[i]) {
+      if (distances[node] < std::numeric_limits<float>::infinity()) {
+        fieldData.nodes.push_back(graph.nodes[node]);
+        fieldData.nodeDistances.push_back(distances[node]);
+      }
+    }
+    if (fieldData.nodes.size() > first) {
+      fieldData.polyRefs.push_back(graph.polys[i]);
+      fieldData.polyNodeOffsets.push_back(first);
+    }
+  }
+  fieldData.polyNodeOffsets.push_back(fieldData.nodes.size());
+  return field;
+}
 
-    ShortestPath prevPath;
-    prevPath.requestedStart = path.requestedStart;
-    prevPath.requestedEnd = path.pimpl_->prevRequestedStart;
-    findPath(prevPath);
-    const float movedAmount = prevPath.geodesicDistance;
+float PathFinder::Impl::geodesicDistance(const GeodesicDistanceField& field,
+                                         const vec3f& pt) const {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  const GeodesicDistanceField::Impl& fieldData = *field.pimpl_;
+  if (fieldData.numNavMeshPolys != numPolys_ ||
+      fieldData.navMeshArea != navMeshArea_) {
+    ESP_HOT_LOG(ERROR)
+        << "PathFinder::geodesicDistance(): the field was built for a "
+           "different navmesh";
+    return inf;
+  }
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return inf;
+  }
 
-    for (int i = 0; i < path.pimpl_->requestedEnds.size(); ++i) {
-      path.pimpl_->minTheoreticalDist[i] = std::max(
-          path.pimpl_->minTheoreticalDist[i] - movedAmount,
-          (path.pimpl_->requestedEnds[i] - path.requestedStart).norm());
-    }
+  dtStatus status;
+  dtPolyRef ptRef;
+  vec3f polyPt;
+  std::tie(status, ptRef, polyPt) =
+      projectToPoly(pt, navQuery.get(), filter_.get());
+  if (status != DT_SUCCESS || ptRef == 0)
+    return inf;
+  const auto found = std::lower_bound(fieldData.polyRefs.begin(),
+                                      fieldData.polyRefs.end(), ptRef);
+  if (found == fieldData.polyRefs.end() || *found != ptRef)
+    return inf;
+
+  const std::size_t i = found - fieldData.polyRefs.begin();
+  float distance = inf;
+  for (uint32_t node = fieldData.polyNodeOffsets[i];
+       node < fieldData.polyNodeOffsets[i + 1]; ++node) {
+    distance = std::min(distance, (polyPt - fieldData.nodes[node]).norm() +
+                                      fieldData.nodeDistances[node]);
+  }
+  return distance;
+}
 
-    path.pimpl_->prevRequestedStart = path.requestedStart;
+template <typename T>
+T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
+  ESP_PROFILE_SCOPE("PathFinder::tryStep");
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return start;
   }
+  return tryStepInternal(navQuery.get(), start, end, allowSliding);
+}
 
-  // Explore possible goal points by their minimum theoretical distance.
-  std::vector<size_t> ordering(path.pimpl_->requestedEnds.size());
-  std::iota(ordering.begin(), ordering.end(), 0);
-  std::sort(ordering.begin(), ordering.end(),
-            [&path](const size_t a, const size_t b) -> bool {
-              return path.pimpl_->minTheoreticalDist[a] <
-                     path.pimpl_->minTheoreticalDist[b];
-            });
+template <typename T>
+std::vector<T> PathFinder::Impl::tryStepBatch(const std::vector<T>& starts,
+                                              const std::vector<T>& ends,
+                                              const bool allowSliding) {
+  ESP_PROFILE_SCOPE("PathFinder::tryStepBatch");
+  CORRADE_ASSERT(starts.size() == ends.size(),
+                 "PathFinder::tryStepBatch(): got" << starts.size()
+                                                   << "starts but"
+                                                   << ends.size() << "ends",
+                 {});
+  const std::size_t count = starts.size();
+  // The start is where a step that can't be taken ends
+  std::vector<T> results = starts;
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers =
+      navMesh_ ? pool.numWorkers(count, pool.numThreads() + 1) : 0;
+  std::vector<NavQueryPool::Query> workerQueries;
+  for (std::size_t worker = 0; worker < workers; ++worker) {
+    workerQueries.push_back(queryPool_->acquire());
+    if (!workerQueries.back())
+      return results;
+  }
 
-  for (size_t i : ordering) {
-    if (path.pimpl_->minTheoreticalDist[i] > path.geodesicDistance)
-      continue;
+  // Consecutive steps from the same start, e.g. the candidate moves of an
+  // agent, share the projection of the start
+  std::vector<std::size_t> runs, runOf(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (i == 0 || !(starts[i] == starts[i - 1]))
+      runs.push_back(i);
+    runOf[i] = runs.size() - 1;
+  }
+  std::vector<std::tuple<dtStatus, dtPolyRef, vec3f>> startPolys(runs.size());
 
-    const Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-        findResult =
-            findPathInternal(path.requestedStart, startRef, pathStart,
-                             path.pimpl_->requestedEnds[i],
-                             path.pimpl_->endRefs[i], path.pimpl_->pathEnds[i]);
+  auto projectOne = [&](const std::size_t run, const std::size_t worker) {
+    startPolys[run] = projectToPoly(starts[runs[run]],
+                                    workerQueries[worker].get(), filter_.get());
+  };
+  auto stepOne = [&](const std::size_t i, const std::size_t worker) {
+    results[i] = tryStepFromPoly(workerQueries[worker].get(), starts[i],
+                                 startPolys[runOf[i]], ends[i], allowSliding);
+  };
 
-    if (findResult && std::get<0>(*findResult) < path.geodesicDistance) {
-      path.pimpl_->minTheoreticalDist[i] = std::get<0>(*findResult);
-      path.geodesicDistance = std::get<0>(*findResult);
-      path.points = std::get<1>(*findResult);
-    }
+  if (workers == 1) {
+    for (std::size_t run = 0; run < runs.size(); ++run)
+      projectOne(run, 0);
+    for (std::size_t i = 0; i < count; ++i)
+      stepOne(i, 0);
+  } else if (workers > 1) {
+    pool.parallelFor(runs.size(), workers, projectOne);
+    pool.parallelFor(count, workers, stepOne);
   }
+  return results;
+}
 
-  return path.geodesicDistance < std::numeric_limits<float>::infinity();
+template <typename T>
+T PathFinder::Impl::tryStepInternal(dtNavMeshQuery* navQuery,
+                                    const T& start,
+                                    const T& end,
+                                    bool allowSliding) {
+  return tryStepFromPoly(navQuery, start,
+                         projectToPoly(start, navQuery, filter_.get()), end,
+                         allowSliding);
 }
 
 template <typename T>
-T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
+T PathFinder::Impl::tryStepFromPoly(
+    dtNavMeshQuery* navQuery,
+    const T& start,
+    const std::tuple<dtStatus, dtPolyRef, vec3f>& startPoly,
+    const T& end,
+    bool allowSliding) {
   static const int MAX_POLYS = 256;
   dtPolyRef polys[MAX_POLYS];
 
   dtStatus startStatus, endStatus;
   dtPolyRef startRef, endRef;
   vec3f pathStart;
-  std::tie(startStatus, startRef, pathStart) =
-      projectToPoly(start, navQuery_.get(), filter_.get());
+  std::tie(startStatus, startRef, pathStart) = startPoly;
   std::tie(endStatus, endRef, std::ignore) =
-      projectToPoly(end, navQuery_.get(), filter_.get());
+      projectToPoly(end, navQuery, filter_.get());
 
   if (dtStatusFailed(startStatus) || dtStatusFailed(endStatus)) {
     return start;
@@ -1119,9 +3934,9 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
 
   vec3f endPoint;
   int numPolys;
-  navQuery_->moveAlongSurface(startRef, pathStart.data(), end.data(),
-                              filter_.get(), endPoint.data(), polys, &numPolys,
-                              MAX_POLYS, allowSliding);
+  navQuery->moveAlongSurface(startRef, pathStart.data(), end.data(),
+                             filter_.get(), endPoint.data(), polys, &numPolys,
+                             MAX_POLYS, allowSliding);
   // If there isn't any possible path between start and end, just return
   // start, that is cleanest
   if (numPolys == 0) {
@@ -1136,7 +3951,7 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   // surface at the endPoint and set its height to that.
   // Note, this will never fail as endPoint is always within in the poly
   // polys[numPolys - 1]
-  navQuery_->getPolyHeight(polys[numPolys - 1], endPoint.data(), &endPoint[1]);
+  navQuery->getPolyHeight(polys[numPolys - 1], endPoint.data(), &endPoint[1]);
 
   // Hack to deal with infinitely thin walls in recast allowing you to
   // transition between two different connected components
@@ -1144,7 +3959,7 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   // is in the same connected component as the startRef according to
   // findNearestPoly
   std::tie(std::ignore, endRef, std::ignore) =
-      projectToPoly(endPoint, navQuery_.get(), filter_.get());
+      projectToPoly(endPoint, navQuery, filter_.get());
   if (!this->islandSystem_->hasConnection(startRef, endRef)) {
     // There isn't a connection!  This happens when endPoint is on an edge
     // shared between two different connected components (aka infinitely thin
@@ -1173,10 +3988,16 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
 
 template <typename T>
 T PathFinder::Impl::snapPoint(const T& pt) {
+  ESP_PROFILE_SCOPE("PathFinder::snapPoint");
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return {NAN, NAN, NAN};
+  }
+
   dtStatus status;
   vec3f projectedPt;
   std::tie(status, std::ignore, projectedPt) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+      projectToPoly(pt, navQuery.get(), filter_.get());
 
   if (dtStatusSucceed(status)) {
     return T{projectedPt};
@@ -1185,11 +4006,56 @@ T PathFinder::Impl::snapPoint(const T& pt) {
   }
 }
 
+std::vector<vec3f> PathFinder::Impl::snapPointBatch(
+    const std::vector<vec3f>& points) {
+  ESP_PROFILE_SCOPE("PathFinder::snapPointBatch");
+  std::vector<vec3f> snapped(points.size(), vec3f{NAN, NAN, NAN});
+  forEachPointBatch(points.size(), [&](dtNavMeshQuery* navQuery,
+                                       const std::size_t i) {
+    dtStatus status;
+    vec3f projectedPt;
+    std::tie(status, std::ignore, projectedPt) =
+        projectToPoly(points[i], navQuery, filter_.get());
+    if (dtStatusSucceed(status))
+      snapped[i] = projectedPt;
+  });
+  return snapped;
+}
+
+template <typename F>
+void PathFinder::Impl::forEachPointBatch(const std::size_t count,
+                                         F&& queryOne) const {
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers =
+      navMesh_ ? pool.numWorkers(count, pool.numThreads() + 1) : 0;
+  std::vector<NavQueryPool::Query> workerQueries;
+  for (std::size_t worker = 0; worker < workers; ++worker) {
+    workerQueries.push_back(queryPool_->acquire());
+    if (!workerQueries.back())
+      return;
+  }
+
+  if (workers == 1) {
+    for (std::size_t i = 0; i < count; ++i)
+      queryOne(workerQueries[0].get(), i);
+  } else if (workers > 1) {
+    pool.parallelFor(count, workers,
+                     [&](const std::size_t i, const std::size_t worker) {
+                       queryOne(workerQueries[worker].get(), i);
+                     });
+  }
+}
+
 float PathFinder::Impl::islandRadius(const vec3f& pt) const {
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return 0.0;
+  }
+
   dtPolyRef ptRef;
   dtStatus status;
   std::tie(status, ptRef, std::ignore) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+      projectToPoly(pt, navQuery.get(), filter_.get());
   if (status != DT_SUCCESS || ptRef == 0) {
     return 0.0;
   } else {
@@ -1197,40 +4063,200 @@ float PathFinder::Impl::islandRadius(const vec3f& pt) const {
   }
 }
 
+int PathFinder::Impl::numIslands() const {
+  return islandSystem_ ? islandSystem_->numIslands() : 0;
+}
+
+int PathFinder::Impl::getIsland(const vec3f& pt) const {
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return ID_UNDEFINED;
+  }
+
+  dtPolyRef ptRef;
+  dtStatus status;
+  std::tie(status, ptRef, std::ignore) =
+      projectToPoly(pt, navQuery.get(), filter_.get());
+  if (status != DT_SUCCESS || ptRef == 0) {
+    return ID_UNDEFINED;
+  }
+  const uint32_t island = islandSystem_->island(ptRef);
+  return island == impl::IslandSystem::NO_ISLAND ? ID_UNDEFINED
+                                                 : static_cast<int>(island);
+}
+
+void PathFinder::Impl::segmentLevels(const std::vector<float>& levelHeights,
+                                     const float minLevelSeparation) {
+  std::lock_guard<std::mutex> lock{levelSystemMutex_};
+  levelHeights_ = levelHeights;
+  minLevelSeparation_ = minLevelSeparation;
+  levelSystem_.reset();
+  levelViews_.clear();
+}
+
+std::shared_ptr<const impl::LevelSystem> PathFinder::Impl::levelSystem()
+    const {
+  std::lock_guard<std::mutex> lock{levelSystemMutex_};
+  if (!levelSystem_ && navMesh_) {
+    levelSystem_ = std::make_shared<const impl::LevelSystem>(
+        navMesh_.get(), filter_.get(), levelHeights_, minLevelSeparation_);
+  }
+  return levelSystem_;
+}
+
+int PathFinder::Impl::numLevels() const {
+  const std::shared_ptr<const impl::LevelSystem> levels = levelSystem();
+  return levels ? levels->numLevels() : 0;
+}
+
+std::vector<NavMeshLevel> PathFinder::Impl::getLevels() const {
+  std::vector<NavMeshLevel> result;
+  const std::shared_ptr<const impl::LevelSystem> levels = levelSystem();
+  if (!levels)
+    return result;
+  for (int i = 0; i < levels->numLevels(); ++i) {
+    const impl::LevelSystem::Level& level = levels->level(i);
+    result.push_back(
+        {level.height, {level.bmin, level.bmax}, levels->levelArea(i)});
+  }
+  return result;
+}
+
+int PathFinder::Impl::getLevel(const vec3f& pt) const {
+  const std::shared_ptr<const impl::LevelSystem> levels = levelSystem();
+  if (!levels) {
+    return ID_UNDEFINED;
+  }
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return ID_UNDEFINED;
+  }
+
+  dtPolyRef ptRef;
+  dtStatus status;
+  std::tie(status, ptRef, std::ignore) =
+      projectToPoly(pt, navQuery.get(), filter_.get());
+  if (status != DT_SUCCESS || ptRef == 0) {
+    return ID_UNDEFINED;
+  }
+  const uint32_t level = levels->levelOf(ptRef);
+  return level == impl::LevelSystem::NO_LEVEL ? ID_UNDEFINED
+                                              : static_cast<int>(level);
+}
+
+float PathFinder::Impl::islandArea(const int islandIndex) const {
+  if (islandIndex < 0 || islandIndex >= numIslands()) {
+    return 0.0;
+  }
+  return islandSystem_->islandArea(islandIndex);
+}
+
+int PathFinder::Impl::largestIsland() const {
+  if (numIslands() == 0) {
+    return ID_UNDEFINED;
+  }
+  return islandSystem_->largestIsland();
+}
+
+void PathFinder::Impl::enableObstacleDistanceField(const float cellSize,
+                                                   const float maxDistance) {
+  CORRADE_ASSERT(cellSize > 0 && maxDistance > 0,
+                 "PathFinder::enableObstacleDistanceField(): expected a "
+                 "positive cell size and distance, got"
+                     << cellSize << "and" << maxDistance, );
+  std::lock_guard<std::mutex> lock{obstacleFieldMutex_};
+  obstacleFieldCellSize_ = cellSize;
+  obstacleFieldMaxDistance_ = maxDistance;
+  obstacleField_.reset();
+}
+
+void PathFinder::Impl::disableObstacleDistanceField() {
+  std::lock_guard<std::mutex> lock{obstacleFieldMutex_};
+  obstacleFieldCellSize_ = 0;
+  obstacleField_.reset();
+}
+
+std::shared_ptr<const impl::ObstacleDistanceField>
+PathFinder::Impl::obstacleField() const {
+  std::lock_guard<std::mutex> lock{obstacleFieldMutex_};
+  if (!obstacleField_ && obstacleFieldCellSize_ > 0 && navMesh_) {
+    obstacleField_ = std::make_shared<const impl::ObstacleDistanceField>(
+        navMesh_.get(), filter_.get(), bounds_, obstacleFieldCellSize_,
+        obstacleFieldMaxDistance_);
+  }
+  return obstacleField_;
+}
+
 float PathFinder::Impl::distanceToClosestObstacle(
     const vec3f& pt,
     const float maxSearchRadius /*= 2.0*/) const {
+  // Detour gives the search radius when there is no wall within it, which the
+  // field tells without searching for points far enough from the walls
+  if (isObstacleDistanceFieldEnabled()) {
+    const std::shared_ptr<const impl::ObstacleDistanceField> field =
+        obstacleField();
+    if (field && field->lowerBound(pt) >= maxSearchRadius)
+      return maxSearchRadius;
+  }
   return closestObstacleSurfacePoint(pt, maxSearchRadius).hitDist;
 }
 
 HitRecord PathFinder::Impl::closestObstacleSurfacePoint(
     const vec3f& pt,
     const float maxSearchRadius /*= 2.0*/) const {
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return {vec3f(0, 0, 0), vec3f(0, 0, 0),
+            std::numeric_limits<float>::infinity()};
+  }
+
   dtPolyRef ptRef;
   dtStatus status;
   vec3f polyPt;
   std::tie(status, ptRef, polyPt) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+      projectToPoly(pt, navQuery.get(), filter_.get());
   if (status != DT_SUCCESS || ptRef == 0) {
     return {vec3f(0, 0, 0), vec3f(0, 0, 0),
             std::numeric_limits<float>::infinity()};
   } else {
     vec3f hitPos, hitNormal;
     float hitDist;
-    navQuery_->findDistanceToWall(ptRef, polyPt.data(), maxSearchRadius,
-                                  filter_.get(), &hitDist, hitPos.data(),
-                                  hitNormal.data());
+    navQuery->findDistanceToWall(ptRef, polyPt.data(), maxSearchRadius,
+                                 filter_.get(), &hitDist, hitPos.data(),
+                                 hitNormal.data());
     return {hitPos, hitNormal, hitDist};
   }
 }
 
 bool PathFinder::Impl::isNavigable(const vec3f& pt,
                                    const float maxYDelta /*= 0.5*/) const {
+  const NavQueryPool::Query navQuery = queryPool_->acquire();
+  if (!navQuery) {
+    return false;
+  }
+  return isNavigableInternal(navQuery.get(), pt, maxYDelta);
+}
+
+std::vector<bool> PathFinder::Impl::isNavigableBatch(
+    const std::vector<vec3f>& points,
+    const float maxYDelta /*= 0.5*/) const {
+  ESP_PROFILE_SCOPE("PathFinder::isNavigableBatch");
+  // chars, as the workers can't write to the bits of one std::vector<bool>
+  std::vector<char> navigable(points.size(), false);
+  forEachPointBatch(points.size(), [&](dtNavMeshQuery* navQuery,
+                                       const std::size_t i) {
+    navigable[i] = isNavigableInternal(navQuery, points[i], maxYDelta);
+  });
+  return {navigable.begin(), navigable.end()};
+}
+
+bool PathFinder::Impl::isNavigableInternal(const dtNavMeshQuery* navQuery,
+                                           const vec3f& pt,
+                                           const float maxYDelta) const {
   dtPolyRef ptRef;
   dtStatus status;
   vec3f polyPt;
-  std::tie(status, ptRef, polyPt) =
-      projectToPoly(pt, navQuery_.get(), filter_.get());
+  std::tie(status, ptRef, polyPt) = projectToPoly(pt, navQuery, filter_.get());
 
   if (status != DT_SUCCESS || ptRef == 0)
     return false;
@@ -1245,9 +4271,102 @@ bool PathFinder::Impl::isNavigable(const vec3f& pt,
 
 typedef Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> MatrixXb;
 
+namespace {
+// Marks the pixels of topdownMap, sampled from startx, startz every
+// metersPerPixel, that are over or under one of the triangles at most
+// maxYDelta from the height
+void rasterizeTopDownView(const std::vector<std::array<vec3f, 3>>& triangles,
+                          const float startx,
+                          const float startz,
+                          const float metersPerPixel,
+                          const float height,
+                          const float maxYDelta,
+                          MatrixXb& topdownMap) {
+  const int zResolution = topdownMap.rows();
+  const int xResolution = topdownMap.cols();
+  // bin the triangles by bands of rows, rasterized in parallel
+  constexpr int rowsPerBand = 32;
+  const int numBands = (zResolution + rowsPerBand - 1) / rowsPerBand;
+  std::vector<std::vector<int>> bandTriangles(numBands);
+  const auto row = [&](const float z) {
+    return (z - startz) / metersPerPixel;
+  };
+  const auto column = [&](const float x) {
+    return (x - startx) / metersPerPixel;
+  };
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    const std::array<vec3f, 3>& t = triangles[i];
+    const int first = std::max(
+        0, static_cast<int>(std::ceil(row(std::min({t[0][2], t[1][2],
+                                                    t[2][2]})))) /
+               rowsPerBand);
+    const int last = std::min(
+        numBands - 1,
+        static_cast<int>(std::floor(row(std::max({t[0][2], t[1][2],
+                                                   t[2][2]})))) /
+            rowsPerBand);
+    for (int band = first; band <= last; ++band)
+      bandTriangles[band].push_back(i);
+  }
+
+  const auto rasterizeBand = [&](const std::size_t band, std::size_t) {
+    const int firstRow = band * rowsPerBand;
+    const int endRow = std::min(zResolution, firstRow + rowsPerBand);
+    for (const int i : bandTriangles[band]) {
+      const std::array<vec3f, 3>& t = triangles[i];
+      // barycentric coordinates in the x-z plane
+      const float area = (t[1][0] - t[0][0]) * (t[2][2] - t[0][2]) -
+                         (t[2][0] - t[0][0]) * (t[1][2] - t[0][2]);
+      if (std::abs(area) < 1e-12f)
+        continue;
+      const int firstH = std::max(
+          firstRow, static_cast<int>(std::ceil(
+                        row(std::min({t[0][2], t[1][2], t[2][2]})))));
+      const int lastH = std::min(
+          endRow - 1, static_cast<int>(std::floor(
+                          row(std::max({t[0][2], t[1][2], t[2][2]})))));
+      const int firstW = std::max(
+          0, static_cast<int>(std::ceil(
+                 column(std::min({t[0][0], t[1][0], t[2][0]})))));
+      const int lastW = std::min(
+          xResolution - 1, static_cast<int>(std::floor(column(
+                               std::max({t[0][0], t[1][0], t[2][0]})))));
+      for (int h = firstH; h <= lastH; ++h) {
+        const float z = startz + h * metersPerPixel;
+        for (int w = firstW; w <= lastW; ++w) {
+          const float x = startx + w * metersPerPixel;
+          const float b1 = ((x - t[0][0]) * (t[2][2] - t[0][2]) -
+                            (t[2][0] - t[0][0]) * (z - t[0][2])) /
+                           area;
+          const float b2 = ((t[1][0] - t[0][0]) * (z - t[0][2]) -
+                            (x - t[0][0]) * (t[1][2] - t[0][2])) /
+                           area;
+          const float b0 = 1.0f - b1 - b2;
+          if (b0 < -1e-5f || b1 < -1e-5f || b2 < -1e-5f)
+            continue;
+          const float y = b0 * t[0][1] + b1 * t[1][1] + b2 * t[2][1];
+          if (std::abs(y - height) <= maxYDelta)
+            topdownMap(h, w) = true;
+        }
+      }
+    }
+  };
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelFor(numBands, pool.numThreads() + 1, rasterizeBand);
+}
+}  // namespace
+
 Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>
 PathFinder::Impl::getTopDownView(const float metersPerPixel,
                                  const float height) {
+  ESP_PROFILE_SCOPE("PathFinder::getTopDownView");
+  {
+    std::lock_guard<std::mutex> lock{topDownViewMutex_};
+    if (topDownView_.size() && topDownViewMetersPerPixel_ == metersPerPixel &&
+        topDownViewHeight_ == height)
+      return topDownView_;
+  }
+
   std::pair<vec3f, vec3f> mapBounds = bounds();
   vec3f bound1 = mapBounds.first;
   vec3f bound2 = mapBounds.second;
@@ -1258,20 +4377,71 @@ PathFinder::Impl::getTopDownView(const float metersPerPixel,
   int zResolution = zspan / metersPerPixel;
   float startx = fmin(bound1[0], bound2[0]);
   float startz = fmin(bound1[2], bound2[2]);
-  MatrixXb topdownMap(zResolution, xResolution);
+  MatrixXb topdownMap = MatrixXb::Zero(zResolution, xResolution);
+  if (!isLoaded())
+    return topdownMap;
+
+  // A pixel is navigable if it is over or under a walkable polygon at most
+  // 0.5 from the height, as for isNavigable(). Instead of snapping every
+  // pixel, rasterize the detail triangles of the polygons near the height.
+  constexpr float maxYDelta = 0.5f;
+  std::vector<std::array<vec3f, 3>> triangles =
+      walkableDetailTriangles(navMesh_.get(), filter_.get());
+  triangles.erase(
+      std::remove_if(triangles.begin(), triangles.end(),
+                     [&](const std::array<vec3f, 3>& triangle) {
+                       const float minY = std::min(
+                           {triangle[0][1], triangle[1][1], triangle[2][1]});
+                       const float maxY = std::max(
+                           {triangle[0][1], triangle[1][1], triangle[2][1]});
+                       return minY - maxYDelta > height ||
+                              height > maxY + maxYDelta;
+                     }),
+      triangles.end());
+
+  rasterizeTopDownView(triangles, startx, startz, metersPerPixel, height,
+                       maxYDelta, topdownMap);
+
+  std::lock_guard<std::mutex> lock{topDownViewMutex_};
+  topDownView_ = topdownMap;
+  topDownViewMetersPerPixel_ = metersPerPixel;
+  topDownViewHeight_ = height;
+  return topdownMap;
+}
 
-  float curz = startz;
-  float curx = startx;
-  for (int h = 0; h < zResolution; h++) {
-    for (int w = 0; w < xResolution; w++) {
-      vec3f point = vec3f(curx, height, curz);
-      topdownMap(h, w) = isNavigable(point, 0.5);
-      curx = curx + metersPerPixel;
-    }
-    curz = curz + metersPerPixel;
-    curx = startx;
+Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>
+PathFinder::Impl::getTopDownViewOfLevel(const int levelIndex,
+                                        const float metersPerPixel) {
+  const std::shared_ptr<const impl::LevelSystem> levels = levelSystem();
+  {
+    std::lock_guard<std::mutex> lock{levelSystemMutex_};
+    auto found = levelViews_.find({levelIndex, metersPerPixel});
+    if (found != levelViews_.end())
+      return found->second;
   }
 
+  // The same grid as getTopDownView()
+  const vec3f& bound1 = bounds_.first;
+  const vec3f& bound2 = bounds_.second;
+  int xResolution = std::abs(bound1[0] - bound2[0]) / metersPerPixel;
+  int zResolution = std::abs(bound1[2] - bound2[2]) / metersPerPixel;
+  MatrixXb topdownMap = MatrixXb::Zero(zResolution, xResolution);
+  if (!levels || levelIndex < 0 || levelIndex >= levels->numLevels())
+    return topdownMap;
+
+  const std::vector<std::array<vec3f, 3>> triangles = walkableDetailTriangles(
+      navMesh_.get(), filter_.get(), [&](const dtPolyRef ref) {
+        return levels->levelOf(ref) == static_cast<uint32_t>(levelIndex);
+      });
+  rasterizeTopDownView(triangles, std::min(bound1[0], bound2[0]),
+                       std::min(bound1[2], bound2[2]), metersPerPixel,
+                       levels->level(levelIndex).height,
+                       std::numeric_limits<float>::infinity(), topdownMap);
+
+  std::lock_guard<std::mutex> lock{levelSystemMutex_};
+  // The levels may have been segmented again meanwhile
+  if (levelSystem_ == levels)
+    levelViews_[{levelIndex, metersPerPixel}] = topdownMap;
   return topdownMap;
 }
 
@@ -1285,7 +4455,7 @@ const assets::MeshData::ptr PathFinder::Impl::getNavMeshData() {
     for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
       const dtMeshTile* tile =
           const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
-      if (!tile)
+      if (!tile || !tile->header)
         continue;
 
       // Iterate over all polygons in a tile
@@ -1313,6 +4483,29 @@ const assets::MeshData::ptr PathFinder::Impl::getNavMeshData() {
   return meshData_;
 }
 
+std::size_t PathFinder::Impl::getHostBytes() const {
+  std::size_t bytes = 0;
+  if (navMesh_) {
+    const dtNavMesh* navMesh = navMesh_.get();
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (tile && tile->header) {
+        bytes += tile->dataSize;
+      }
+    }
+  }
+  // the compressed layers tiled navmeshes are rebuilt from
+  if (tileCache_) {
+    for (int iTile = 0; iTile < tileCache_->getTileCount(); ++iTile) {
+      const dtCompressedTile* tile = tileCache_->getTile(iTile);
+      if (tile && tile->header) {
+        bytes += tile->dataSize;
+      }
+    }
+  }
+  return bytes;
+}
+
 PathFinder::PathFinder() : pimpl_{spimpl::make_unique_impl<Impl>()} {};
 
 bool PathFinder::build(const NavMeshSettings& bs,
@@ -1329,15 +4522,119 @@ bool PathFinder::build(const NavMeshSettings& bs,
   return pimpl_->build(bs, mesh);
 }
 
+void PathFinder::clearHeightfieldCache() {
+  pimpl_->clearHeightfieldCache();
+}
+
+bool PathFinder::rebuildTiles(const float* verts,
+                              const int nverts,
+                              const int* tris,
+                              const int ntris,
+                              const float* bmin,
+                              const float* bmax) {
+  return pimpl_->rebuildTiles(verts, nverts, tris, ntris, bmin, bmax);
+}
+
+bool PathFinder::rebuildTiles(const esp::assets::MeshData& mesh,
+                              const vec3f& bmin,
+                              const vec3f& bmax) {
+  std::vector<int> indices(mesh.ibo.begin(), mesh.ibo.end());
+  return pimpl_->rebuildTiles(mesh.vbo[0].data(), mesh.vbo.size(),
+                              indices.data(), indices.size() / 3, bmin.data(),
+                              bmax.data());
+}
+
+bool PathFinder::isTiled() const {
+  return pimpl_->isTiled();
+}
+
+uint32_t PathFinder::addCylinderObstacle(const vec3f& position,
+                                         const float radius,
+                                         const float height) {
+  return pimpl_->addCylinderObstacle(position, radius, height);
+}
+
+uint32_t PathFinder::addBoxObstacle(const vec3f& center,
+                                    const vec3f& halfExtents,
+                                    const float yRotation) {
+  return pimpl_->addBoxObstacle(center, halfExtents, yRotation);
+}
+
+bool PathFinder::removeObstacle(const uint32_t obstacleID) {
+  return pimpl_->removeObstacle(obstacleID);
+}
+
+bool PathFinder::updateObstacles() {
+  return pimpl_->updateObstacles();
+}
+
 vec3f PathFinder::getRandomNavigablePoint() {
   return pimpl_->getRandomNavigablePoint();
 }
 
+vec3f PathFinder::getRandomNavigablePointOnIsland(const int islandIndex) {
+  return pimpl_->getRandomNavigablePointOnIsland(islandIndex);
+}
+
+vec3f PathFinder::getRandomNavigablePointOnLargestIsland() {
+  return pimpl_->getRandomNavigablePointOnIsland(pimpl_->largestIsland());
+}
+
+std::vector<Episode> PathFinder::sampleEpisodes(
+    const int count,
+    const uint32_t seed,
+    const EpisodeSamplingSettings& settings) {
+  return pimpl_->sampleEpisodes(count, seed, settings);
+}
+
+std::vector<float> PathFinder::findPathsBatch(
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends,
+    std::vector<vec3f>* points,
+    std::vector<std::size_t>* pointOffsets) {
+  ESP_PERF_TIMER(Nav);
+  return pimpl_->findPathsBatch(starts, ends, points, pointOffsets);
+}
+
+GeodesicDistanceField::ptr PathFinder::buildGeodesicDistanceField(
+    const std::vector<vec3f>& goals,
+    const float nodeSpacing) {
+  return pimpl_->buildGeodesicDistanceField(goals, nodeSpacing);
+}
+
+float PathFinder::geodesicDistance(const GeodesicDistanceField& field,
+                                   const vec3f& pt) const {
+  return pimpl_->geodesicDistance(field, pt);
+}
+
 bool PathFinder::findPath(ShortestPath& path) {
+  ESP_PERF_TIMER(Nav);
   return pimpl_->findPath(path);
 }
 
+void PathFinder::enablePathCache(const std::size_t capacity,
+                                 const float quantum) {
+  pimpl_->enablePathCache(capacity, quantum);
+}
+
+void PathFinder::disablePathCache() {
+  pimpl_->disablePathCache();
+}
+
+bool PathFinder::isPathCacheEnabled() const {
+  return pimpl_->isPathCacheEnabled();
+}
+
+std::size_t PathFinder::pathCacheHits() const {
+  return pimpl_->pathCacheHits();
+}
+
+std::size_t PathFinder::pathCacheMisses() const {
+  return pimpl_->pathCacheMisses();
+}
+
 bool PathFinder::findPath(MultiGoalShortestPath& path) {
+  ESP_PERF_TIMER(Nav);
   return pimpl_->findPath(path);
 }
 
@@ -1347,6 +4644,7 @@ template Mn::Vector3 PathFinder::tryStep<Mn::Vector3>(const Mn::Vector3&,
 
 template <typename T>
 T PathFinder::tryStep(const T& start, const T& end) {
+  ESP_PERF_TIMER(Nav);
   return pimpl_->tryStep(start, end, /*allowSliding=*/true);
 }
 
@@ -1357,21 +4655,61 @@ template Mn::Vector3 PathFinder::tryStepNoSliding<Mn::Vector3>(
 
 template <typename T>
 T PathFinder::tryStepNoSliding(const T& start, const T& end) {
+  ESP_PERF_TIMER(Nav);
   return pimpl_->tryStep(start, end, /*allowSliding=*/false);
 }
 
+template std::vector<vec3f> PathFinder::tryStepBatch<vec3f>(
+    const std::vector<vec3f>&,
+    const std::vector<vec3f>&);
+template std::vector<Mn::Vector3> PathFinder::tryStepBatch<Mn::Vector3>(
+    const std::vector<Mn::Vector3>&,
+    const std::vector<Mn::Vector3>&);
+
+template <typename T>
+std::vector<T> PathFinder::tryStepBatch(const std::vector<T>& starts,
+                                        const std::vector<T>& ends) {
+  ESP_PERF_TIMER(Nav);
+  return pimpl_->tryStepBatch(starts, ends, /*allowSliding=*/true);
+}
+
+template std::vector<vec3f> PathFinder::tryStepNoSlidingBatch<vec3f>(
+    const std::vector<vec3f>&,
+    const std::vector<vec3f>&);
+template std::vector<Mn::Vector3>
+PathFinder::tryStepNoSlidingBatch<Mn::Vector3>(const std::vector<Mn::Vector3>&,
+                                               const std::vector<Mn::Vector3>&);
+
+template <typename T>
+std::vector<T> PathFinder::tryStepNoSlidingBatch(const std::vector<T>& starts,
+                                                 const std::vector<T>& ends) {
+  ESP_PERF_TIMER(Nav);
+  return pimpl_->tryStepBatch(starts, ends, /*allowSliding=*/false);
+}
+
 template vec3f PathFinder::snapPoint<vec3f>(const vec3f& pt);
 template Mn::Vector3 PathFinder::snapPoint<Mn::Vector3>(const Mn::Vector3& pt);
 
 template <typename T>
 T PathFinder::snapPoint(const T& pt) {
+  ESP_PERF_TIMER(Nav);
   return pimpl_->snapPoint(pt);
 }
 
+std::vector<vec3f> PathFinder::snapPointBatch(
+    const std::vector<vec3f>& points) {
+  ESP_PERF_TIMER(Nav);
+  return pimpl_->snapPointBatch(points);
+}
+
 bool PathFinder::loadNavMesh(const std::string& path) {
   return pimpl_->loadNavMesh(path);
 }
 
+bool PathFinder::loadNavMeshData(Cr::Containers::Array<char> data) {
+  return pimpl_->loadNavMeshData(std::move(data), "the navmesh data");
+}
+
 bool PathFinder::saveNavMesh(const std::string& path) {
   return pimpl_->saveNavMesh(path);
 }
@@ -1384,10 +4722,47 @@ void PathFinder::seed(uint32_t newSeed) {
   return pimpl_->seed(newSeed);
 }
 
+core::Random::State PathFinder::getRandomState() {
+  return pimpl_->getRandomState();
+}
+
+void PathFinder::setRandomState(const core::Random::State& state) {
+  pimpl_->setRandomState(state);
+}
+
 float PathFinder::islandRadius(const vec3f& pt) const {
   return pimpl_->islandRadius(pt);
 }
 
+int PathFinder::numIslands() const {
+  return pimpl_->numIslands();
+}
+
+int PathFinder::getIsland(const vec3f& pt) const {
+  return pimpl_->getIsland(pt);
+}
+
+float PathFinder::islandArea(const int islandIndex) const {
+  return pimpl_->islandArea(islandIndex);
+}
+
+int PathFinder::largestIsland() const {
+  return pimpl_->largestIsland();
+}
+
+void PathFinder::enableObstacleDistanceField(const float cellSize,
+                                             const float maxDistance) {
+  pimpl_->enableObstacleDistanceField(cellSize, maxDistance);
+}
+
+void PathFinder::disableObstacleDistanceField() {
+  pimpl_->disableObstacleDistanceField();
+}
+
+bool PathFinder::isObstacleDistanceFieldEnabled() const {
+  return pimpl_->isObstacleDistanceFieldEnabled();
+}
+
 float PathFinder::distanceToClosestObstacle(const vec3f& pt,
                                             const float maxSearchRadius) const {
   return pimpl_->distanceToClosestObstacle(pt, maxSearchRadius);
@@ -1403,6 +4778,15 @@ bool PathFinder::isNavigable(const vec3f& pt, const float maxYDelta) const {
   return pimpl_->isNavigable(pt, maxYDelta);
 }
 
+std::vector<bool> PathFinder::isNavigableBatch(const std::vector<vec3f>& points,
+                                               const float maxYDelta) const {
+  return pimpl_->isNavigableBatch(points, maxYDelta);
+}
+
+std::size_t PathFinder::getHostBytes() const {
+  return pimpl_->getHostBytes();
+}
+
 float PathFinder::getNavigableArea() const {
   return pimpl_->getNavigableArea();
 }
@@ -1411,6 +4795,33 @@ std::pair<vec3f, vec3f> PathFinder::bounds() const {
   return pimpl_->bounds();
 }
 
+void PathFinder::segmentLevels(const std::vector<float>& levelHeights,
+                               const float minLevelSeparation) {
+  pimpl_->segmentLevels(levelHeights, minLevelSeparation);
+}
+
+int PathFinder::numLevels() const {
+  return pimpl_->numLevels();
+}
+
+std::vector<NavMeshLevel> PathFinder::getLevels() const {
+  return pimpl_->getLevels();
+}
+
+int PathFinder::getLevel(const vec3f& pt) const {
+  return pimpl_->getLevel(pt);
+}
+
+vec3f PathFinder::getRandomNavigablePointOnLevel(const int levelIndex) {
+  return pimpl_->getRandomNavigablePointOnLevel(levelIndex);
+}
+
+Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>
+PathFinder::getTopDownViewOfLevel(const int levelIndex,
+                                  const float metersPerPixel) {
+  return pimpl_->getTopDownViewOfLevel(levelIndex, metersPerPixel);
+}
+
 Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> PathFinder::getTopDownView(
     const float metersPerPixel,
     const float height) {
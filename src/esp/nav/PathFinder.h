@@ -5,10 +5,14 @@
 #ifndef ESP_NAV_PATHFINDER_H_
 #define ESP_NAV_PATHFINDER_H_
 
+#include <Corrade/Containers/Array.h>
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include "esp/core/esp.h"
+#include "esp/core/random.h"
 
 namespace esp {
 // forward declaration
@@ -100,6 +104,106 @@ struct MultiGoalShortestPath {
   ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(MultiGoalShortestPath);
 };
 
+/**
+ * @brief Geodesic distances from the whole navmesh to the closest of a set of
+ * goals, built once by @ref PathFinder::buildGeodesicDistanceField() and then
+ * queried by @ref PathFinder::geodesicDistance() for goal sets that are
+ * queried many times, e.g. in evaluation
+ *
+ * The distances are those of the points on the boundary of each navmesh
+ * polygon, the distance of other points is found from the nodes of their
+ * polygon. A field is only valid for the navmesh it was built on, also when
+ * that navmesh is saved and loaded again.
+ */
+class GeodesicDistanceField {
+ public:
+  GeodesicDistanceField();
+
+  /**
+   * @brief The goals the distances are to
+   */
+  const std::vector<vec3f>& getGoals() const;
+
+  /**
+   * @brief The maximum distance between the nodes along a polygon edge
+   */
+  float getNodeSpacing() const;
+
+  /**
+   * @brief Saves the field to a binary file
+   *
+   * @param[in] path The name of the file
+   *
+   * @return Whether the file was written
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * @brief Loads a field saved by @ref save()
+   *
+   * @param[in] path The name of the file
+   *
+   * @return The field, nullptr if the file doesn't exist or isn't a field
+   */
+  static std::shared_ptr<GeodesicDistanceField> load(const std::string& path);
+
+  friend class PathFinder;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(GeodesicDistanceField);
+};
+
+/**
+ * @brief Constraints on the episodes sampled by @ref
+ * PathFinder::sampleEpisodes()
+ */
+struct EpisodeSamplingSettings {
+  //! Range of the geodesic distance from the start to the goal
+  float minGeodesicDistance = 1.0f;
+  float maxGeodesicDistance = std::numeric_limits<float>::infinity();
+
+  //! Minimum ratio of the geodesic to the euclidean distance, above 1 to
+  //! reject the episodes that are a straight line
+  float minGeodesicToEuclideanRatio = 1.0f;
+
+  //! Maximum height difference between the start and the goal, e.g. to keep
+  //! episodes on one floor
+  float maxHeightDifference = std::numeric_limits<float>::infinity();
+
+  //! Minimum @ref PathFinder::islandRadius() of the island of the episode, to
+  //! skip the small islands on furniture
+  float minIslandRadius = 0.0f;
+
+  //! The island to sample on, ID_UNDEFINED for islands picked by area
+  int island = ID_UNDEFINED;
+
+  //! The number of start and goal pairs tried before an episode is given up
+  int maxAttempts = 1000;
+
+  ESP_SMART_POINTERS(EpisodeSamplingSettings)
+};
+
+/**
+ * @brief A start and goal pair sampled by @ref PathFinder::sampleEpisodes()
+ */
+struct Episode {
+  vec3f start;
+  vec3f goal;
+  float geodesicDistance;
+};
+
+/**
+ * @brief A level of the navmesh, e.g. a floor, see @ref
+ * PathFinder::segmentLevels()
+ */
+struct NavMeshLevel {
+  //! The height of the floor of the level
+  float height;
+  //! The axis aligned bounding box of the polygons of the level
+  std::pair<vec3f, vec3f> bounds;
+  //! The navigable area of the level
+  float area;
+};
+
 struct NavMeshSettings {
   //! Cell size in world units
   float cellSize;
@@ -133,6 +237,11 @@ struct NavMeshSettings {
   bool filterLowHangingObstacles;
   bool filterLedgeSpans;
   bool filterWalkableLowHeightSpans;
+  //! Width and depth of the tiles in voxels, at most 255. 0 builds a single
+  //! tile. The tiles are built in parallel on the @ref
+  //! core::ThreadPool::shared() pool, and tiled navmeshes can be updated with
+  //! @ref PathFinder::rebuildTiles
+  int tileSize;
 
   void setDefaults() {
     cellSize = 0.05f;
@@ -151,6 +260,7 @@ struct NavMeshSettings {
     filterLowHangingObstacles = true;
     filterLedgeSpans = true;
     filterWalkableLowHeightSpans = true;
+    tileSize = 0;
   }
 
   NavMeshSettings() { setDefaults(); }
@@ -161,6 +271,16 @@ struct NavMeshSettings {
 /** Loads and/or builds a navigation mesh and then performs path
  * finding and collision queries on that navmesh
  *
+ * The queries that don't change the navmesh, @ref findPath(), @ref
+ * findPathsBatch(), @ref tryStep(), @ref tryStepNoSliding(), @ref
+ * tryStepBatch(), @ref tryStepNoSlidingBatch(), @ref snapPoint(), @ref
+ * snapPointBatch(), @ref isNavigable(), @ref isNavigableBatch(), @ref
+ * islandRadius(), @ref distanceToClosestObstacle() and
+ * @ref closestObstacleSurfacePoint(), are
+ * safe to call concurrently, e.g. from the threads of several environments
+ * sharing one navmesh. Each leases a Detour query from a pool that grows to
+ * the number of concurrent queries. Building, loading and updating the
+ * navmesh must not overlap with any other call.
  */
 class PathFinder {
  public:
@@ -179,6 +299,94 @@ class PathFinder {
              const float* bmax);
   bool build(const NavMeshSettings& bs, const esp::assets::MeshData& mesh);
 
+  /**
+   * @brief Free the voxelization of the last build
+   *
+   * A single-tile build keeps the voxelized mesh, so that building the same
+   * mesh again with another agent radius or height, e.g. to sweep the agent
+   * settings, only redoes the erosion, the regions and the polygons. A change
+   * of the cell size or height, the slope or the climb voxelizes again.
+   */
+  void clearHeightfieldCache();
+
+  /**
+   * @brief Rebuilds the tiles of a navmesh built with a nonzero @ref
+   * NavMeshSettings::tileSize which overlap a region, e.g. after moving an
+   * object, so that the update costs in proportion to the changed area
+   *
+   * @param[in] verts, nverts, tris, ntris The whole updated geometry, only
+   * the triangles near the region are rasterized. The geometry outside of
+   * the region is assumed unchanged.
+   * @param[in] bmin, bmax The region where the geometry changed. Tiles within
+   * the agent radius of it are rebuilt too.
+   *
+   * @return False if the navmesh isn't tiled, e.g. loaded from a file, or if
+   * a tile failed to build
+   */
+  bool rebuildTiles(const float* verts,
+                    const int nverts,
+                    const int* tris,
+                    const int ntris,
+                    const float* bmin,
+                    const float* bmax);
+  bool rebuildTiles(const esp::assets::MeshData& mesh,
+                    const vec3f& bmin,
+                    const vec3f& bmax);
+
+  /**
+   * @return Whether the navmesh was built with tiles that @ref rebuildTiles
+   * can update
+   */
+  bool isTiled() const;
+
+  /**
+   * @brief Adds a vertical cylinder obstacle to a tiled navmesh, e.g. for a
+   * moving object that shouldn't be baked into the navmesh
+   *
+   * The obstacle is grown by the agent radius like the rest of the geometry.
+   * Obstacles are queued and carve the navmesh on @ref updateObstacles(), and
+   * stay in place on @ref rebuildTiles().
+   *
+   * @param[in] position The center of the bottom of the cylinder
+   * @param[in] radius The radius of the cylinder
+   * @param[in] height The height of the cylinder
+   *
+   * @return The ID of the obstacle, 0 if the navmesh isn't tiled or there are
+   * too many obstacles
+   */
+  uint32_t addCylinderObstacle(const vec3f& position,
+                               const float radius,
+                               const float height);
+
+  /**
+   * @brief Same as @ref addCylinderObstacle() for a box obstacle
+   *
+   * @param[in] center The center of the box
+   * @param[in] halfExtents Half of the size of the box along each axis
+   * @param[in] yRotation The rotation of the box around the vertical axis, in
+   * radians
+   */
+  uint32_t addBoxObstacle(const vec3f& center,
+                          const vec3f& halfExtents,
+                          const float yRotation = 0.0f);
+
+  /**
+   * @brief Removes an obstacle added by @ref addCylinderObstacle() or @ref
+   * addBoxObstacle() on the next @ref updateObstacles()
+   *
+   * @return Whether the obstacle exists
+   */
+  bool removeObstacle(const uint32_t obstacleID);
+
+  /**
+   * @brief Applies the obstacles added and removed since the last call,
+   * rebuilding only the tiles they touch. Queries then respect the current
+   * obstacles.
+   *
+   * @return Whether all touched tiles were rebuilt
+   */
+  bool updateObstacles();
+
   /**
    * @brief Returns a random navigable point
    *
@@ -190,6 +398,50 @@ class PathFinder {
    */
   vec3f getRandomNavigablePoint();
 
+  /**
+   * @brief Returns a random navigable point on an island, uniformly over its
+   * area
+   *
+   * Unlike @ref getRandomNavigablePoint(), which visits every polygon of the
+   * navmesh, this takes logarithmic time in the number of polygons of the
+   * island, and also uses the seed set by @ref seed().
+   *
+   * @param[in] islandIndex The island, see @ref getIsland().
+   *
+   * @return A random point on the island, infinite if the island doesn't
+   * exist or has no area.
+   */
+  vec3f getRandomNavigablePointOnIsland(int islandIndex);
+
+  /**
+   * @brief Returns a random navigable point on the island with the most area,
+   * see @ref getRandomNavigablePointOnIsland() and @ref largestIsland()
+   */
+  vec3f getRandomNavigablePointOnLargestIsland();
+
+  /**
+   * @brief Samples start and goal pairs that satisfy the constraints of @p
+   * settings, e.g. to generate a dataset of episodes
+   *
+   * Start and goal are sampled uniformly over the area of an island, the goal
+   * on the island of the start as there is no path to others, until their
+   * path satisfies the constraints. The episodes are sampled in parallel on
+   * the @ref core::ThreadPool::shared() pool, each from the
+   * @ref core::Random::split() of @p seed by its index, so the episodes only
+   * depend on the seed and not on the number of threads or on @ref seed().
+   *
+   * @param[in] count The number of episodes to sample.
+   * @param[in] seed The seed of the episodes.
+   * @param[in] settings The constraints on the episodes.
+   *
+   * @return The episodes, in the order of their index. Fewer than @p count if
+   * some weren't found within @ref EpisodeSamplingSettings::maxAttempts.
+   */
+  std::vector<Episode> sampleEpisodes(
+      int count,
+      uint32_t seed,
+      const EpisodeSamplingSettings& settings = {});
+
   /**
    * @brief Finds the shortest path between two points on the navigation mesh
    *
@@ -202,6 +454,41 @@ class PathFinder {
    */
   bool findPath(ShortestPath& path);
 
+  /**
+   * @brief Keep the results of @ref findPath(ShortestPath&), for scripts that
+   * ask for the same paths again
+   *
+   * A query is a hit when its start and end are on the same polygons and in
+   * the same cells of a grid of @p quantum as those of a cached one, whose
+   * result it returns. Nearby queries within the cells then share the path
+   * of the first one, so @p quantum bounds how far the ends of a returned
+   * path may be from those asked for. The cache is cleared when the navmesh
+   * changes. Enabling it must not overlap with queries.
+   *
+   * @param[in] capacity The number of paths kept, the least recently used
+   * are dropped first.
+   * @param[in] quantum The size of the cells the ends are quantized to.
+   */
+  void enablePathCache(std::size_t capacity = 4096, float quantum = 0.001f);
+
+  /** @brief Free the cache of @ref enablePathCache() */
+  void disablePathCache();
+
+  /** @brief Whether @ref enablePathCache() was called */
+  bool isPathCacheEnabled() const;
+
+  /**
+   * @brief The number of @ref findPath(ShortestPath&) queries answered by the
+   * cache since it was enabled
+   */
+  std::size_t pathCacheHits() const;
+
+  /**
+   * @brief The number of @ref findPath(ShortestPath&) queries the cache had
+   * no result for since it was enabled, queries off the navmesh aside
+   */
+  std::size_t pathCacheMisses() const;
+
   /**
    * @brief Finds the shortest path from a start point to the closest (by
    * geoddesic distance) end point.
@@ -217,6 +504,60 @@ class PathFinder {
    */
   bool findPath(MultiGoalShortestPath& path);
 
+  /**
+   * @brief Finds the shortest paths between many pairs of points at once,
+   * e.g. the distance to the goal of every environment of a batch
+   *
+   * The paths are found in parallel on the @ref core::ThreadPool::shared()
+   * pool, each worker with its own Detour query.
+   *
+   * @param[in] starts The requested start of each path
+   * @param[in] ends The requested end of each path, as many as @p starts
+   * @param[out] points If not null, the points of all paths one after another
+   * @param[out] pointOffsets If not null, the index in @p points of the first
+   * point of each path, followed by the number of points
+   *
+   * @return The geodesic distance of each path, infinity where there is no
+   * path
+   */
+  std::vector<float> findPathsBatch(
+      const std::vector<vec3f>& starts,
+      const std::vector<vec3f>& ends,
+      std::vector<vec3f>* points = nullptr,
+      std::vector<std::size_t>* pointOffsets = nullptr);
+
+  /**
+   * @brief Computes the geodesic distance from the whole navmesh to the
+   * closest of some goals, for @ref geodesicDistance()
+   *
+   * A single Dijkstra search runs from the goals over nodes at the vertices
+   * of the navmesh polygons and along their edges, connecting all nodes of a
+   * polygon as it is convex. Paths through the nodes are slightly longer than
+   * the exact ones, the more the coarser the spacing.
+   *
+   * @param[in] goals The goals. Goals off the navmesh are ignored.
+   * @param[in] nodeSpacing The maximum distance between the nodes along an
+   * edge, finer spacings are more accurate and take more memory
+   *
+   * @return The field, nullptr if no navmesh is loaded
+   */
+  std::shared_ptr<GeodesicDistanceField> buildGeodesicDistanceField(
+      const std::vector<vec3f>& goals,
+      const float nodeSpacing = 0.25f);
+
+  /**
+   * @brief The geodesic distance from a point to the closest goal of a field
+   * made by @ref buildGeodesicDistanceField()
+   *
+   * @param[in] field The field
+   * @param[in] pt The point, snapped to the navmesh
+   *
+   * @return The distance, inf if no goal is reachable from @p pt or the field
+   * was built for a different navmesh
+   */
+  float geodesicDistance(const GeodesicDistanceField& field,
+                         const vec3f& pt) const;
+
   /**
    * @brief Attempts to move from @ref start to @ref end and returns the
    * navigable point closest to @ref end that is feasibly reachable from @ref
@@ -236,6 +577,32 @@ class PathFinder {
   template <typename T>
   T tryStepNoSliding(const T& start, const T& end);
 
+  /**
+   * @brief Same as @ref tryStep for many steps at once, e.g. the moves of a
+   * batch of agents
+   *
+   * The steps are taken in parallel on the @ref core::ThreadPool::shared()
+   * pool, each worker with its own Detour query. Consecutive steps from the
+   * same start, e.g. the candidate moves of one agent, project the start to
+   * the navmesh once.
+   *
+   * @param[in] starts The start of each step
+   * @param[in] ends The desired end of each step, as many as @p starts
+   *
+   * @return The end of each step
+   */
+  template <typename T>
+  std::vector<T> tryStepBatch(const std::vector<T>& starts,
+                              const std::vector<T>& ends);
+
+  /**
+   * @brief Same as @ref tryStepBatch but does not allow for sliding along
+   * walls
+   */
+  template <typename T>
+  std::vector<T> tryStepNoSlidingBatch(const std::vector<T>& starts,
+                                       const std::vector<T>& ends);
+
   /**
    * @brief Snaps a point to the navigation mesh
    *
@@ -247,9 +614,20 @@ class PathFinder {
   template <typename T>
   T snapPoint(const T& pt);
 
+  /**
+   * @brief Same as @ref snapPoint for many points at once, in parallel on
+   * the @ref core::ThreadPool::shared() pool
+   */
+  std::vector<vec3f> snapPointBatch(const std::vector<vec3f>& points);
+
   /**
    * @brief Loads a navigation meshed saved by @ref saveNavMesh
    *
+   * The file is memory-mapped and the tiles are used in place, so that the
+   * processes loading the same file share most of its pages. Files saved
+   * since the islands and the navigable area are stored in them load those
+   * too, older files still load and compute them.
+   *
    * @param[in] path The saved navigation mesh file, generally has extension
    * ``.navmesh``
    *
@@ -257,6 +635,16 @@ class PathFinder {
    */
   bool loadNavMesh(const std::string& path);
 
+  /**
+   * @brief Loads a navigation mesh from the contents of a file saved by
+   * @ref saveNavMesh(), e.g. a part of a mapped @ref assets::SceneBundle
+   *
+   * @param[in] data The contents, referenced by the tiles from now on
+   *
+   * @return Whether or not the navmesh was successfully loaded
+   */
+  bool loadNavMeshData(Corrade::Containers::Array<char> data);
+
   /**
    * @brief Saves a navigation mesh to later be loaded by @ref loadNavMesh
    *
@@ -276,10 +664,22 @@ class PathFinder {
    *
    * @param[in] newSeed The random seed
    *
-   * @note This just seeds the global c @ref rand function.
+   * Each pathfinder has its own @ref core::Random, so the points it samples
+   * don't depend on other pathfinders or on the global c @ref rand function.
    */
   void seed(uint32_t newSeed);
 
+  /**
+   * @brief The state of the generator seeded by @ref seed(), e.g. to
+   * checkpoint a run
+   */
+  core::Random::State getRandomState();
+
+  /**
+   * @brief Continue the random points from a state of @ref getRandomState()
+   */
+  void setRandomState(const core::Random::State& state);
+
   /**
    * @brief returns the size of the connected component @ ref pt belongs to.
    *
@@ -289,6 +689,80 @@ class PathFinder {
    */
   float islandRadius(const vec3f& pt) const;
 
+  /**
+   * @brief Returns the number of islands, i.e. the connected components of
+   * the navmesh
+   */
+  int numIslands() const;
+
+  /**
+   * @brief Returns the island @p pt belongs to
+   *
+   * @param[in] pt The point, snapped to the navmesh.
+   *
+   * @return The index of the island in [0, @ref numIslands()), @ref
+   * ID_UNDEFINED if @p pt isn't near the navmesh.
+   */
+  int getIsland(const vec3f& pt) const;
+
+  /**
+   * @brief Returns the navigable area of an island, 0 if it doesn't exist
+   */
+  float islandArea(int islandIndex) const;
+
+  /**
+   * @brief Returns the island with the most navigable area, @ref
+   * ID_UNDEFINED if no navmesh is loaded
+   */
+  int largestIsland() const;
+
+  /**
+   * @brief Set how the navmesh is split into levels
+   *
+   * The walkable polygons near the height of a level seed it, and the levels
+   * grow from their seeds across the connected polygons, so a sloped floor
+   * stays whole and stairs are split between the floors they join. The
+   * polygons of islands that reach no seed go to the level of the closest
+   * height. The levels are segmented on the first query and again after the
+   * navmesh changes.
+   *
+   * @param[in] levelHeights The heights of the floors, e.g. of the @ref
+   * scene::SemanticLevel of a scene so the indices match, in any order.
+   * Empty to take the heights with the most walkable area.
+   * @param[in] minLevelSeparation The smallest distance between the heights
+   * found when @p levelHeights is empty.
+   */
+  void segmentLevels(const std::vector<float>& levelHeights = {},
+                     float minLevelSeparation = 1.5f);
+
+  /**
+   * @brief Returns the number of levels, ordered as the heights given to
+   * @ref segmentLevels() or else from the lowest up
+   */
+  int numLevels() const;
+
+  /** @brief Returns the height, bounds and area of every level */
+  std::vector<NavMeshLevel> getLevels() const;
+
+  /**
+   * @brief Returns the level @p pt belongs to
+   *
+   * @param[in] pt The point, snapped to the navmesh.
+   *
+   * @return The index of the level in [0, @ref numLevels()), @ref
+   * ID_UNDEFINED if @p pt isn't near the navmesh.
+   */
+  int getLevel(const vec3f& pt) const;
+
+  /**
+   * @brief Returns a random navigable point on a level, uniformly over its
+   * area, as @ref getRandomNavigablePointOnIsland() does for islands
+   *
+   * @return A random point on the level, infinite if the level doesn't exist
+   * or has no area.
+   */
+  vec3f getRandomNavigablePointOnLevel(int levelIndex);
+
   /**
    * @brief Finds the distance to the closest non-navigable location
    *
@@ -301,6 +775,30 @@ class PathFinder {
   float distanceToClosestObstacle(const vec3f& pt,
                                   const float maxSearchRadius = 2.0) const;
 
+  /**
+   * @brief Precompute the distance to the walls on a grid, so that @ref
+   * distanceToClosestObstacle() returns in constant time for the points
+   * farther from the walls than its search radius
+   *
+   * Like the navmesh, the grid is 2.5D, with a layer per floor at each node.
+   * A lookup bounds the distance of a point from below with the nodes around
+   * it, and Detour only searches for the walls of the points that may be
+   * closer than the search radius, so the results are the same. The grid is
+   * built on the first query and again after the navmesh changes.
+   *
+   * @param[in] cellSize The spacing of the nodes of the grid.
+   * @param[in] maxDistance The largest distance stored, search radii beyond
+   * it always search.
+   */
+  void enableObstacleDistanceField(float cellSize = 0.05f,
+                                   float maxDistance = 2.0f);
+
+  /** @brief Free the grid of @ref enableObstacleDistanceField() */
+  void disableObstacleDistanceField();
+
+  /** @brief Whether @ref enableObstacleDistanceField() was called */
+  bool isObstacleDistanceFieldEnabled() const;
+
   /**
    * @brief Same as @ref distanceToClosestObstacle but returns additional
    * information.
@@ -324,20 +822,65 @@ class PathFinder {
    */
   bool isNavigable(const vec3f& pt, const float maxYDelta = 0.5) const;
 
+  /**
+   * @brief Same as @ref isNavigable for many points at once, in parallel on
+   * the @ref core::ThreadPool::shared() pool
+   */
+  std::vector<bool> isNavigableBatch(const std::vector<vec3f>& points,
+                                     float maxYDelta = 0.5) const;
+
   /**
    * Compute and return the total area of all NavMesh polygons
    */
   float getNavigableArea() const;
 
+  /**
+   * @brief The memory of the tiles of the navmesh and, if it's tiled, of the
+   * compressed layers they are rebuilt from, in bytes
+   */
+  std::size_t getHostBytes() const;
+
   /**
    * @return The axis aligned bounding box containing the navigation mesh.
    */
   std::pair<vec3f, vec3f> bounds() const;
 
+  /**
+   * @brief Returns a top-down occupancy grid of the navmesh at a height,
+   * true where a point at the height passes @ref isNavigable()
+   *
+   * The walkable polygons within 0.5 of @p height are rasterized into the
+   * grid on the @ref core::ThreadPool::shared() pool. The last view is kept
+   * until the navmesh changes, so asking for it again is free.
+   *
+   * @param[in] metersPerPixel The size of a pixel
+   * @param[in] height The height of the slice, in world units
+   *
+   * @return The grid, with the rows along z and the columns along x from the
+   * lower corner of @ref bounds()
+   */
   Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> getTopDownView(
       const float metersPerPixel,
       const float height);
 
+  /**
+   * @brief Returns a top-down occupancy grid of the polygons of a level
+   *
+   * Unlike @ref getTopDownView(), which needs a height close to the floor,
+   * every walkable polygon of the level is drawn, and no other. The grid is
+   * the same, so the maps of all levels line up. The maps are kept until the
+   * navmesh or the levels change.
+   *
+   * @param[in] levelIndex The level, see @ref getLevel().
+   * @param[in] metersPerPixel The size of a pixel
+   *
+   * @return The grid, with the rows along z and the columns along x from the
+   * lower corner of @ref bounds(), all false if the level doesn't exist
+   */
+  Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> getTopDownViewOfLevel(
+      int levelIndex,
+      float metersPerPixel);
+
   /**
    * @brief Returns a MeshData object containing triangulated NavMesh polys. The
    * object is generated and stored if this is the first query.
@@ -0,0 +1,289 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "esp/nav/PathFollower.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Quaternion.h>
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace nav {
+
+namespace {
+// Maximum angle between the samples of the arc of a corner
+constexpr float maxArcStep = Mn::Constants::pi() / 16.0f;
+// Corners turning less than this are kept, and U-turns too as the arc of
+// two opposite segments is undefined
+constexpr float minCornerAngle = 1e-3f;
+}  // namespace
+
+struct ContinuousPathFollower::Impl {
+  PathFinder::ptr pathfinder;
+  PathFollowerSettings settings;
+
+  std::vector<Mn::Vector3> points;
+  // Distance along the path of each point
+  std::vector<float> distances;
+
+  float progress = 0.0f;
+  std::size_t segment = 0;
+
+  float length() const { return distances.empty() ? 0.0f : distances.back(); }
+
+  // Appends the arc replacing corner, or corner itself if it stays sharp
+  void roundCorner(const Mn::Vector3& previous,
+                   const Mn::Vector3& corner,
+                   const Mn::Vector3& next) {
+    const Mn::Vector3 in = corner - previous;
+    const Mn::Vector3 out = next - corner;
+    const float inLength = in.length();
+    const float outLength = out.length();
+    const Mn::Vector3 a = in / inLength;
+    const Mn::Vector3 b = out / outLength;
+    const float angle =
+        std::acos(Mn::Math::clamp(Mn::Math::dot(a, b), -1.0f, 1.0f));
+    if (settings.cornerRadius <= 0.0f || angle < minCornerAngle ||
+        angle > Mn::Constants::pi() - minCornerAngle) {
+      points.push_back(corner);
+      return;
+    }
+
+    // The arc is tangent to both segments, its center is on the bisector
+    // inside the corner at radius / cos(angle / 2) from it
+    const float halfCos = std::cos(0.5f * angle);
+    const float halfTan = std::tan(0.5f * angle);
+    float radius = settings.cornerRadius;
+    radius = std::min(radius, settings.maxCornerCut * halfCos / (1 - halfCos));
+    // The arcs of neighboring corners don't overlap
+    const float tangent = std::min(radius * halfTan,
+                                   0.5f * std::min(inLength, outLength));
+    radius = tangent / halfTan;
+    if (radius <= 0.0f) {
+      points.push_back(corner);
+      return;
+    }
+
+    const Mn::Vector3 center =
+        corner + (b - a).normalized() * radius / halfCos;
+    const Mn::Vector3 u = corner - a * tangent - center;
+    const Mn::Vector3 w = corner + b * tangent - center;
+    const int steps = std::max(1, int(std::ceil(angle / maxArcStep)));
+    const float sinAngle = std::sin(angle);
+    for (int j = 0; j <= steps; ++j) {
+      const float s = float(j) / steps;
+      points.push_back(center + (std::sin((1 - s) * angle) * u +
+                                 std::sin(s * angle) * w) /
+                                    sinAngle);
+    }
+  }
+
+  // The point at distance s along the path
+  Mn::Vector3 pointAt(const float s) const {
+    const std::size_t k =
+        std::upper_bound(distances.begin(), distances.end(), s) -
+        distances.begin();
+    if (k == 0)
+      return points.front();
+    if (k == points.size())
+      return points.back();
+    const float segmentLength = distances[k] - distances[k - 1];
+    const float t =
+        segmentLength > 0.0f ? (s - distances[k - 1]) / segmentLength : 0.0f;
+    return Mn::Math::lerp(points[k - 1], points[k], t);
+  }
+
+  // Moves the progress to the projection of position on the path, searching
+  // only a bit further than the lookahead point so the agent doesn't jump to
+  // a part of the path that passes nearby later
+  void project(const Mn::Vector3& position) {
+    const float searchEnd = progress + 2.0f * settings.lookaheadDistance;
+    float bestDistance = std::numeric_limits<float>::infinity();
+    float bestProgress = progress;
+    std::size_t bestSegment = segment;
+    for (std::size_t k = segment;
+         k + 1 < points.size() && distances[k] <= searchEnd; ++k) {
+      const Mn::Vector3 d = points[k + 1] - points[k];
+      const float lengthSquared = d.dot();
+      const float t =
+          lengthSquared > 0.0f
+              ? Mn::Math::clamp(
+                    Mn::Math::dot(position - points[k], d) / lengthSquared,
+                    0.0f, 1.0f)
+              : 0.0f;
+      const float distance = (position - (points[k] + t * d)).dot();
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        bestProgress = Mn::Math::lerp(distances[k], distances[k + 1], t);
+        bestSegment = k;
+      }
+    }
+    if (bestProgress > progress) {
+      progress = bestProgress;
+      segment = bestSegment;
+    }
+  }
+};
+
+ContinuousPathFollower::ContinuousPathFollower(
+    PathFinder::ptr pathfinder,
+    const PathFollowerSettings& settings)
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {
+  pimpl_->pathfinder = std::move(pathfinder);
+  pimpl_->settings = settings;
+}
+
+bool ContinuousPathFollower::setGoal(const Mn::Vector3& start,
+                                     const Mn::Vector3& goal) {
+  ShortestPath path;
+  path.requestedStart = Mn::EigenIntegration::cast<vec3f>(start);
+  path.requestedEnd = Mn::EigenIntegration::cast<vec3f>(goal);
+  if (!pimpl_->pathfinder->findPath(path)) {
+    setPath({});
+    return false;
+  }
+
+  std::vector<Mn::Vector3> points;
+  points.reserve(path.points.size());
+  for (const vec3f& point : path.points)
+    points.emplace_back(point);
+  setPath(points);
+  return true;
+}
+
+void ContinuousPathFollower::setPath(const std::vector<Mn::Vector3>& points) {
+  // Repeated points have no direction to round
+  std::vector<Mn::Vector3> polyline;
+  for (const Mn::Vector3& point : points) {
+    if (polyline.empty() || (point - polyline.back()).dot() > 1e-12f)
+      polyline.push_back(point);
+  }
+
+  pimpl_->points.clear();
+  for (std::size_t i = 0; i < polyline.size(); ++i) {
+    if (i == 0 || i + 1 == polyline.size())
+      pimpl_->points.push_back(polyline[i]);
+    else
+      pimpl_->roundCorner(polyline[i - 1], polyline[i], polyline[i + 1]);
+  }
+
+  pimpl_->distances.resize(pimpl_->points.size());
+  for (std::size_t i = 0; i < pimpl_->points.size(); ++i) {
+    pimpl_->distances[i] =
+        i == 0 ? 0.0f
+               : pimpl_->distances[i - 1] +
+                     (pimpl_->points[i] - pimpl_->points[i - 1]).length();
+  }
+  reset();
+}
+
+const std::vector<Mn::Vector3>& ContinuousPathFollower::smoothedPath() const {
+  return pimpl_->points;
+}
+
+float ContinuousPathFollower::pathLength() const {
+  return pimpl_->length();
+}
+
+float ContinuousPathFollower::progress() const {
+  return pimpl_->progress;
+}
+
+VelocityCommand ContinuousPathFollower::nextCommand(
+    const core::RigidState& state,
+    const float dt) {
+  const PathFollowerSettings& settings = pimpl_->settings;
+  VelocityCommand command;
+  if (pimpl_->points.empty()) {
+    command.done = true;
+    return command;
+  }
+
+  pimpl_->project(state.translation);
+  const float distanceToEnd =
+      (pimpl_->points.back() - state.translation).length();
+  if (distanceToEnd < settings.goalRadius) {
+    command.done = true;
+    return command;
+  }
+
+  const Mn::Vector3 target = pimpl_->pointAt(
+      std::min(pimpl_->progress + settings.lookaheadDistance,
+               pimpl_->length()));
+  const Mn::Vector3 local =
+      state.rotation.invertedNormalized().transformVector(target -
+                                                          state.translation);
+  // On the ground plane of the agent, forward is -Z and left is -X
+  const float targetDistance = local.xz().length();
+  const float headingError =
+      targetDistance > 0.0f ? std::atan2(-local.x(), -local.z()) : 0.0f;
+
+  float linearSpeed = 0.0f;
+  float angularSpeed = 0.0f;
+  if (std::abs(headingError) > settings.maxHeadingError) {
+    angularSpeed = Mn::Math::clamp(headingError / dt, -settings.maxAngularSpeed,
+                                   settings.maxAngularSpeed);
+  } else {
+    linearSpeed = std::min(settings.linearSpeed, distanceToEnd / dt);
+    // Curvature of the circle tangent to the heading through the target
+    const float curvature =
+        targetDistance > 0.0f ? 2.0f * std::sin(headingError) / targetDistance
+                              : 0.0f;
+    angularSpeed = linearSpeed * curvature;
+    // Slow down to keep the curvature when turning at the maximum speed
+    if (std::abs(angularSpeed) > settings.maxAngularSpeed) {
+      angularSpeed = std::copysign(settings.maxAngularSpeed, angularSpeed);
+      linearSpeed = angularSpeed / curvature;
+    }
+  }
+
+  command.linearVelocity = {0.0f, 0.0f, -linearSpeed};
+  command.angularVelocity = {0.0f, angularSpeed, 0.0f};
+  return command;
+}
+
+std::vector<core::RigidState> ContinuousPathFollower::followPath(
+    const core::RigidState& start,
+    const float dt,
+    const int maxSteps) {
+  reset();
+  std::vector<core::RigidState> states;
+  core::RigidState state = start;
+  for (int step = 0; step < maxSteps; ++step) {
+    const VelocityCommand command = nextCommand(state, dt);
+    if (command.done)
+      break;
+
+    // Same as VelocityControl::integrateTransform() with local velocities
+    const Mn::Vector3 end =
+        state.translation +
+        state.rotation.transformVector(command.linearVelocity * dt);
+    if (command.angularVelocity != Mn::Vector3{0.0f}) {
+      const Mn::Vector3 angularVelocity =
+          state.rotation.transformVector(command.angularVelocity);
+      state.rotation =
+          (Mn::Quaternion::rotation(Mn::Rad{(angularVelocity * dt).length()},
+                                    angularVelocity.normalized()) *
+           state.rotation)
+              .normalized();
+    }
+    state.translation = pimpl_->pathfinder->tryStep(state.translation, end);
+    states.push_back(state);
+  }
+  return states;
+}
+
+void ContinuousPathFollower::reset() {
+  pimpl_->progress = 0.0f;
+  pimpl_->segment = 0;
+}
+
+}  // namespace nav
+}  // namespace esp
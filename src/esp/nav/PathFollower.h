@@ -0,0 +1,158 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_NAV_PATHFOLLOWER_H_
+#define ESP_NAV_PATHFOLLOWER_H_
+
+/** @file
+ * @brief Class @ref esp::nav::ContinuousPathFollower, structs @ref
+ * esp::nav::PathFollowerSettings, @ref esp::nav::VelocityCommand
+ */
+
+#include <vector>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "esp/core/RigidState.h"
+#include "esp/core/esp.h"
+#include "esp/nav/PathFinder.h"
+
+namespace esp {
+namespace nav {
+
+/**
+ * @brief Parameters of @ref ContinuousPathFollower
+ */
+struct PathFollowerSettings {
+  //! Distance along the path from the agent to the point it steers to
+  float lookaheadDistance = 0.5f;
+
+  //! Forward speed of the agent in units per second
+  float linearSpeed = 1.0f;
+
+  //! Maximum turning speed of the agent in radians per second
+  float maxAngularSpeed = Magnum::Constants::pi();
+
+  //! The agent turns in place while the point it steers to is further than
+  //! this from its heading, in radians
+  float maxHeadingError = Magnum::Constants::piQuarter();
+
+  //! The goal is reached when the agent is closer to the end of the path
+  float goalRadius = 0.1f;
+
+  //! Radius of the arcs replacing the corners of the path, 0 to keep them
+  float cornerRadius = 0.5f;
+
+  //! Maximum distance the arc of a corner passes from the corner. The
+  //! corners of a path are on the boundary of the navmesh, which is eroded by
+  //! the agent radius, so a fraction of the radius keeps the agent clear of
+  //! the obstacle
+  float maxCornerCut = 0.05f;
+
+  ESP_SMART_POINTERS(PathFollowerSettings)
+};
+
+/**
+ * @brief Velocities computed by @ref ContinuousPathFollower, in the local
+ * frame of the agent
+ *
+ * To be used as @ref physics::VelocityControl::linVel and @ref
+ * physics::VelocityControl::angVel, with both
+ * @ref physics::VelocityControl::linVelIsLocal and
+ * @ref physics::VelocityControl::angVelIsLocal set.
+ */
+struct VelocityCommand {
+  //! Along -Z, the forward direction of the agent
+  Magnum::Vector3 linearVelocity;
+  //! Around +Y, positive to turn left
+  Magnum::Vector3 angularVelocity;
+  //! Whether the agent reached the end of the path, the velocities are zero
+  bool done = false;
+};
+
+/**
+ * @brief Follows a path with continuous velocities, by pure pursuit
+ *
+ * The corners of the path, e.g. a @ref ShortestPath::points, are rounded by
+ * circular arcs tangent to both of their segments. Each step, the agent steers
+ * on the circle through the point @ref PathFollowerSettings::lookaheadDistance
+ * ahead of its projection on the path, which never moves backwards, and turns
+ * in place when that point is too far from its heading.
+ */
+class ContinuousPathFollower {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] pathfinder Pathfinder used for finding the paths and moving
+   *                       the agent along the navmesh in @ref followPath()
+   * @param[in] settings Speeds and smoothing of the follower
+   */
+  explicit ContinuousPathFollower(PathFinder::ptr pathfinder,
+                                  const PathFollowerSettings& settings = {});
+
+  /**
+   * @brief Follow the shortest path from @p start to @p goal
+   *
+   * @return Whether there is a path
+   */
+  bool setGoal(const Magnum::Vector3& start, const Magnum::Vector3& goal);
+
+  /**
+   * @brief Follow the polyline through @p points, rounding its corners
+   */
+  void setPath(const std::vector<Magnum::Vector3>& points);
+
+  /**
+   * @brief The path followed, with its corners rounded
+   */
+  const std::vector<Magnum::Vector3>& smoothedPath() const;
+
+  /** @brief Length of @ref smoothedPath() */
+  float pathLength() const;
+
+  /** @brief Distance along @ref smoothedPath() the agent progressed */
+  float progress() const;
+
+  /**
+   * @brief Calculates the velocities to follow the path from @p state
+   *
+   * Updates the progress of the agent, so call it once per step.
+   *
+   * @param[in] state The current state of the agent
+   * @param[in] dt The duration of the step, the velocities don't overshoot
+   *               the heading or the end of the path in that time
+   */
+  VelocityCommand nextCommand(const core::RigidState& state, float dt);
+
+  /**
+   * @brief Follows the path from @p start until its end in a single call
+   *
+   * Each step integrates the command over @p dt with explicit Euler, the same
+   * as @ref physics::VelocityControl::integrateTransform(), then moves the
+   * agent along the navmesh with @ref PathFinder::tryStep().
+   *
+   * @param[in] start The starting state of the agent
+   * @param[in] dt The duration of each step
+   * @param[in] maxSteps The maximum number of steps
+   *
+   * @return The state after each step, the last one at the end of the path
+   * unless @p maxSteps were taken
+   */
+  std::vector<core::RigidState> followPath(const core::RigidState& start,
+                                           float dt,
+                                           int maxSteps = 10000);
+
+  /** @brief Restart from the beginning of the path */
+  void reset();
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(ContinuousPathFollower)
+};
+
+}  // namespace nav
+}  // namespace esp
+
+#endif  // ESP_NAV_PATHFOLLOWER_H_
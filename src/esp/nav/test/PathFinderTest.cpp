@@ -1,3 +1,7 @@
+#include <cmath>
+#include <limits>
+#include <thread>
+
 #include <Corrade/Containers/ArrayView.h>
 #include <Corrade/TestSuite/Compare/Numeric.h>
 #include <Corrade/TestSuite/Tester.h>
@@ -36,15 +40,36 @@ struct PathFinderTest : Cr::TestSuite::Tester {
 
   void benchmarkSingleGoal();
   void benchmarkMultiGoal();
+  void benchmarkTryStep();
+  void benchmarkTopDownView();
 
   void testCaching();
+  void findPathsBatch();
+  void concurrentQueries();
+  void geodesicDistanceField();
+  void topDownView();
+  void islands();
+  void sampleEpisodes();
+  void saveLoadNavMesh();
+  void obstacleDistanceField();
+
+  void tiledRebuild();
+  void obstacles();
 };
 
 PathFinderTest::PathFinderTest() {
   addTests({&PathFinderTest::bounds, &PathFinderTest::tryStepNoSliding,
-            &PathFinderTest::multiGoalPath, &PathFinderTest::testCaching});
+            &PathFinderTest::multiGoalPath, &PathFinderTest::testCaching,
+            &PathFinderTest::findPathsBatch, &PathFinderTest::concurrentQueries,
+            &PathFinderTest::geodesicDistanceField,
+            &PathFinderTest::topDownView, &PathFinderTest::islands,
+            &PathFinderTest::sampleEpisodes, &PathFinderTest::saveLoadNavMesh,
+            &PathFinderTest::obstacleDistanceField,
+            &PathFinderTest::tiledRebuild, &PathFinderTest::obstacles});
 
   addBenchmarks({&PathFinderTest::benchmarkSingleGoal}, 1000);
+  addBenchmarks({&PathFinderTest::benchmarkTryStep}, 100);
+  addBenchmarks({&PathFinderTest::benchmarkTopDownView}, 10);
   addInstancedBenchmarks({&PathFinderTest::benchmarkMultiGoal}, 100,
                          Cr::Containers::arraySize(MultiGoalBenchMarkData));
 }
@@ -154,6 +179,457 @@ void PathFinderTest::testCaching() {
   }
 }
 
+void PathFinderTest::findPathsBatch() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::vec3f> starts, ends;
+  for (int i = 0; i < 200; ++i) {
+    starts.emplace_back(pathFinder.getRandomNavigablePoint());
+    ends.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+  // no path from outside of the navmesh
+  starts.emplace_back(1e3f, 1e3f, 1e3f);
+  ends.emplace_back(ends.back());
+
+  std::vector<esp::vec3f> points;
+  std::vector<std::size_t> pointOffsets;
+  const std::vector<float> distances =
+      pathFinder.findPathsBatch(starts, ends, &points, &pointOffsets);
+  CORRADE_COMPARE(distances.size(), starts.size());
+  CORRADE_COMPARE(pointOffsets.size(), starts.size() + 1);
+  CORRADE_COMPARE(pointOffsets.back(), points.size());
+
+  for (std::size_t i = 0; i < starts.size(); ++i) {
+    CORRADE_ITERATION(i);
+    esp::nav::ShortestPath path;
+    path.requestedStart = starts[i];
+    path.requestedEnd = ends[i];
+    pathFinder.findPath(path);
+    CORRADE_COMPARE(distances[i], path.geodesicDistance);
+    CORRADE_COMPARE(pointOffsets[i + 1] - pointOffsets[i], path.points.size());
+  }
+  CORRADE_COMPARE(distances.back(), std::numeric_limits<float>::infinity());
+}
+
+void PathFinderTest::concurrentQueries() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  constexpr int numThreads = 4;
+  constexpr int numQueries = 250;
+  std::vector<esp::vec3f> starts, ends;
+  for (int i = 0; i < numThreads * numQueries; ++i) {
+    starts.emplace_back(pathFinder.getRandomNavigablePoint());
+    ends.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+
+  // the same queries on one thread and then on several at once
+  std::vector<float> distances(starts.size());
+  std::vector<float> concurrentDistances(starts.size());
+  std::vector<esp::vec3f> steps(starts.size());
+  std::vector<esp::vec3f> concurrentSteps(starts.size());
+  const auto query = [&](const int first, std::vector<float>& outDistances,
+                         std::vector<esp::vec3f>& outSteps) {
+    for (int i = first; i < first + numQueries; ++i) {
+      esp::nav::ShortestPath path;
+      path.requestedStart = starts[i];
+      path.requestedEnd = ends[i];
+      pathFinder.findPath(path);
+      outDistances[i] = path.geodesicDistance;
+      outSteps[i] = pathFinder.tryStep(starts[i], ends[i]);
+    }
+  };
+  for (int t = 0; t < numThreads; ++t) {
+    query(t * numQueries, distances, steps);
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; ++t) {
+    threads.emplace_back(query, t * numQueries, std::ref(concurrentDistances),
+                         std::ref(concurrentSteps));
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (std::size_t i = 0; i < starts.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(concurrentDistances[i], distances[i]);
+    CORRADE_COMPARE(Mn::Vector3{concurrentSteps[i]}, Mn::Vector3{steps[i]});
+  }
+}
+
+void PathFinderTest::geodesicDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::vec3f> goals;
+  for (int i = 0; i < 5; ++i) {
+    goals.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+  esp::nav::GeodesicDistanceField::ptr field =
+      pathFinder.buildGeodesicDistanceField(goals);
+  CORRADE_VERIFY(field);
+  CORRADE_COMPARE(pathFinder.geodesicDistance(*field, goals[0]), 0.0f);
+
+  const std::string filename = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "PathFinderTest-skokloster.gdf");
+  CORRADE_VERIFY(field->save(filename));
+  esp::nav::GeodesicDistanceField::ptr loadedField =
+      esp::nav::GeodesicDistanceField::load(filename);
+  CORRADE_VERIFY(loadedField);
+  CORRADE_COMPARE(loadedField->getGoals().size(), goals.size());
+
+  esp::nav::MultiGoalShortestPath path;
+  path.setRequestedEnds(goals);
+  for (int i = 0; i < 200; ++i) {
+    CORRADE_ITERATION(i);
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    const bool found = pathFinder.findPath(path);
+    const float distance =
+        pathFinder.geodesicDistance(*field, path.requestedStart);
+    CORRADE_COMPARE(
+        pathFinder.geodesicDistance(*loadedField, path.requestedStart),
+        distance);
+    if (!found) {
+      CORRADE_COMPARE(distance, std::numeric_limits<float>::infinity());
+      continue;
+    }
+    // the nodes approximate the shortest path, Detour the shortest corridor
+    CORRADE_COMPARE_AS(std::abs(distance - path.geodesicDistance),
+                       0.1f + 0.05f * path.geodesicDistance,
+                       Cr::TestSuite::Compare::Less);
+  }
+  Cr::Utility::Directory::rm(filename);
+}
+
+void PathFinderTest::topDownView() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  const float metersPerPixel = 0.1f;
+  const float height = pathFinder.bounds().first[1];
+  const auto view = pathFinder.getTopDownView(metersPerPixel, height);
+  CORRADE_VERIFY(view.count() > 0);
+
+  // same as snapping every pixel, up to pixels right on polygon edges
+  const esp::vec3f start = pathFinder.bounds().first;
+  int mismatches = 0;
+  for (int h = 0; h < view.rows(); ++h) {
+    for (int w = 0; w < view.cols(); ++w) {
+      const esp::vec3f point{start[0] + w * metersPerPixel, height,
+                             start[2] + h * metersPerPixel};
+      if (view(h, w) != pathFinder.isNavigable(point, 0.5f))
+        ++mismatches;
+    }
+  }
+  CORRADE_COMPARE_AS(mismatches, static_cast<int>(view.size() / 100),
+                     Cr::TestSuite::Compare::LessOrEqual);
+
+  // the cached view
+  CORRADE_VERIFY(pathFinder.getTopDownView(metersPerPixel, height) == view);
+}
+
+void PathFinderTest::islands() {
+  esp::nav::PathFinder pathFinder;
+  CORRADE_COMPARE(pathFinder.largestIsland(), esp::ID_UNDEFINED);
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  CORRADE_VERIFY(pathFinder.numIslands() > 0);
+
+  const int largest = pathFinder.largestIsland();
+  float totalArea = 0;
+  for (int i = 0; i < pathFinder.numIslands(); ++i) {
+    CORRADE_COMPARE_AS(pathFinder.islandArea(i),
+                       pathFinder.islandArea(largest),
+                       Cr::TestSuite::Compare::LessOrEqual);
+    totalArea += pathFinder.islandArea(i);
+  }
+  CORRADE_COMPARE_AS(std::abs(totalArea - pathFinder.getNavigableArea()),
+                     1e-3f * pathFinder.getNavigableArea(),
+                     Cr::TestSuite::Compare::LessOrEqual);
+
+  pathFinder.seed(0);
+  std::vector<esp::vec3f> points;
+  for (int i = 0; i < 100; ++i) {
+    const esp::vec3f pt = pathFinder.getRandomNavigablePointOnLargestIsland();
+    CORRADE_ITERATION(i);
+    CORRADE_VERIFY(pathFinder.isNavigable(pt));
+    CORRADE_COMPARE(pathFinder.getIsland(pt), largest);
+    points.push_back(pt);
+  }
+
+  // the same points from the same seed
+  pathFinder.seed(0);
+  for (int i = 0; i < 100; ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_VERIFY(pathFinder.getRandomNavigablePointOnIsland(largest) ==
+                   points[i]);
+  }
+
+  CORRADE_VERIFY(std::isinf(pathFinder.getRandomNavigablePointOnIsland(
+      pathFinder.numIslands())[0]));
+  CORRADE_COMPARE(pathFinder.islandArea(-1), 0.0f);
+}
+
+void PathFinderTest::sampleEpisodes() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  esp::nav::EpisodeSamplingSettings settings;
+  settings.minGeodesicDistance = 2.0f;
+  settings.maxGeodesicDistance = 10.0f;
+  settings.minGeodesicToEuclideanRatio = 1.05f;
+  settings.maxHeightDifference = 0.5f;
+  const std::vector<esp::nav::Episode> episodes =
+      pathFinder.sampleEpisodes(200, 7, settings);
+  CORRADE_COMPARE(episodes.size(), std::size_t{200});
+
+  for (std::size_t i = 0; i < episodes.size(); ++i) {
+    CORRADE_ITERATION(i);
+    const esp::nav::Episode& episode = episodes[i];
+    CORRADE_VERIFY(pathFinder.isNavigable(episode.start));
+    CORRADE_VERIFY(pathFinder.isNavigable(episode.goal));
+    CORRADE_COMPARE(pathFinder.getIsland(episode.start),
+                    pathFinder.getIsland(episode.goal));
+    CORRADE_COMPARE_AS(std::abs(episode.goal[1] - episode.start[1]), 0.5f,
+                       Cr::TestSuite::Compare::LessOrEqual);
+    CORRADE_COMPARE_AS(episode.geodesicDistance, 2.0f,
+                       Cr::TestSuite::Compare::GreaterOrEqual);
+    CORRADE_COMPARE_AS(episode.geodesicDistance, 10.0f,
+                       Cr::TestSuite::Compare::LessOrEqual);
+    CORRADE_COMPARE_AS(episode.geodesicDistance,
+                       1.05f * (episode.goal - episode.start).norm(),
+                       Cr::TestSuite::Compare::GreaterOrEqual);
+
+    esp::nav::ShortestPath path;
+    path.requestedStart = episode.start;
+    path.requestedEnd = episode.goal;
+    CORRADE_VERIFY(pathFinder.findPath(path));
+    CORRADE_COMPARE(path.geodesicDistance, episode.geodesicDistance);
+  }
+
+  // the first episodes again from the same seed
+  const std::vector<esp::nav::Episode> again =
+      pathFinder.sampleEpisodes(50, 7, settings);
+  CORRADE_COMPARE(again.size(), std::size_t{50});
+  for (std::size_t i = 0; i < again.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_VERIFY(again[i].start == episodes[i].start);
+    CORRADE_VERIFY(again[i].goal == episodes[i].goal);
+  }
+
+  // no episode can satisfy these
+  settings.minGeodesicDistance = 1e4f;
+  settings.maxAttempts = 10;
+  CORRADE_VERIFY(pathFinder.sampleEpisodes(10, 7, settings).empty());
+}
+
+void PathFinderTest::saveLoadNavMesh() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  const std::string filename = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "PathFinderTest-skokloster.navmesh");
+  CORRADE_VERIFY(pathFinder.saveNavMesh(filename));
+
+  // the islands, area and bounds are loaded instead of computed
+  esp::nav::PathFinder loaded;
+  CORRADE_VERIFY(loaded.loadNavMesh(filename));
+  CORRADE_COMPARE(loaded.getNavigableArea(), pathFinder.getNavigableArea());
+  CORRADE_VERIFY(loaded.bounds() == pathFinder.bounds());
+  CORRADE_COMPARE(loaded.numIslands(), pathFinder.numIslands());
+  for (int i = 0; i < pathFinder.numIslands(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(loaded.islandArea(i), pathFinder.islandArea(i));
+  }
+
+  pathFinder.seed(0);
+  for (int i = 0; i < 100; ++i) {
+    CORRADE_ITERATION(i);
+    esp::nav::ShortestPath path;
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+    CORRADE_COMPARE(loaded.getIsland(path.requestedStart),
+                    pathFinder.getIsland(path.requestedStart));
+    CORRADE_COMPARE(loaded.islandRadius(path.requestedStart),
+                    pathFinder.islandRadius(path.requestedStart));
+    const bool found = pathFinder.findPath(path);
+    const float distance = path.geodesicDistance;
+    CORRADE_COMPARE(loaded.findPath(path), found);
+    CORRADE_COMPARE(path.geodesicDistance, distance);
+  }
+
+  // loading over a loaded navmesh releases the previous file
+  CORRADE_VERIFY(loaded.loadNavMesh(filename));
+  CORRADE_COMPARE(loaded.numIslands(), pathFinder.numIslands());
+}
+
+void PathFinderTest::obstacleDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  pathFinder.seed(0);
+  std::vector<esp::vec3f> points;
+  std::vector<float> near, far;
+  for (int i = 0; i < 500; ++i) {
+    points.push_back(pathFinder.getRandomNavigablePoint());
+    near.push_back(pathFinder.distanceToClosestObstacle(points.back(), 0.22f));
+    far.push_back(pathFinder.distanceToClosestObstacle(points.back(), 1.0f));
+  }
+
+  // the field only skips the searches that find no wall
+  pathFinder.enableObstacleDistanceField();
+  CORRADE_VERIFY(pathFinder.isObstacleDistanceFieldEnabled());
+  int skippable = 0;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(pathFinder.distanceToClosestObstacle(points[i], 0.22f),
+                    near[i]);
+    CORRADE_COMPARE(pathFinder.distanceToClosestObstacle(points[i], 1.0f),
+                    far[i]);
+    if (near[i] == 0.22f)
+      ++skippable;
+  }
+  CORRADE_VERIFY(skippable > 0);
+
+  pathFinder.disableObstacleDistanceField();
+  CORRADE_VERIFY(!pathFinder.isObstacleDistanceFieldEnabled());
+}
+
+// Append the triangles of an axis-aligned box
+void addBox(std::vector<float>& verts,
+            std::vector<int>& tris,
+            const Mn::Vector3& min,
+            const Mn::Vector3& max) {
+  const int first = verts.size() / 3;
+  for (int i = 0; i < 8; ++i) {
+    verts.push_back(i & 1 ? max.x() : min.x());
+    verts.push_back(i & 2 ? max.y() : min.y());
+    verts.push_back(i & 4 ? max.z() : min.z());
+  }
+  const int faces[][4]{{0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1},
+                       {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+  for (const auto& face : faces) {
+    for (const int corner : {face[0], face[1], face[2], face[0], face[2],
+                             face[3]}) {
+      tris.push_back(first + corner);
+    }
+  }
+}
+
+void PathFinderTest::tiledRebuild() {
+  // a 10x10 floor and a wall across it, with a gap at x > 3
+  std::vector<float> verts{-5, 0, -5, -5, 0, 5, 5, 0, 5, 5, 0, -5};
+  std::vector<int> tris{0, 1, 2, 0, 2, 3};
+  const Mn::Vector3 wallMin{-5.0f, 0.0f, -0.1f};
+  const Mn::Vector3 wallMax{3.0f, 2.0f, 0.1f};
+  const float floorMin[]{-5, 0, -5};
+  const float floorMax[]{5, 0, 5};
+  const float sceneMax[]{5, 2, 5};
+
+  esp::nav::NavMeshSettings settings;
+  settings.tileSize = 32;
+  esp::nav::PathFinder pathFinder;
+  CORRADE_VERIFY(pathFinder.build(settings, verts.data(), verts.size() / 3,
+                                  tris.data(), tris.size() / 3, floorMin,
+                                  floorMax));
+  CORRADE_VERIFY(pathFinder.isTiled());
+
+  esp::nav::ShortestPath path;
+  path.requestedStart = esp::vec3f{0, 0, -3};
+  path.requestedEnd = esp::vec3f{0, 0, 3};
+  CORRADE_VERIFY(pathFinder.findPath(path));
+  CORRADE_COMPARE_AS(path.geodesicDistance, 6.5f,
+                     Cr::TestSuite::Compare::Less);
+
+  // only the tiles around the wall see it
+  addBox(verts, tris, wallMin, wallMax);
+  CORRADE_VERIFY(pathFinder.rebuildTiles(
+      verts.data(), verts.size() / 3, tris.data(), tris.size() / 3,
+      wallMin.data(), wallMax.data()));
+  CORRADE_VERIFY(pathFinder.findPath(path));
+  CORRADE_COMPARE_AS(path.geodesicDistance, 8.0f,
+                     Cr::TestSuite::Compare::Greater);
+
+  // same as building the navmesh with the wall from scratch
+  esp::nav::PathFinder rebuiltPathFinder;
+  CORRADE_VERIFY(rebuiltPathFinder.build(settings, verts.data(),
+                                         verts.size() / 3, tris.data(),
+                                         tris.size() / 3, floorMin, sceneMax));
+  esp::nav::ShortestPath rebuiltPath = path;
+  CORRADE_VERIFY(rebuiltPathFinder.findPath(rebuiltPath));
+  CORRADE_COMPARE(path.geodesicDistance, rebuiltPath.geodesicDistance);
+  CORRADE_COMPARE(pathFinder.getNavigableArea(),
+                  rebuiltPathFinder.getNavigableArea());
+
+  // single-tile navmeshes can't be updated
+  settings.tileSize = 0;
+  CORRADE_VERIFY(pathFinder.build(settings, verts.data(), verts.size() / 3,
+                                  tris.data(), tris.size() / 3, floorMin,
+                                  sceneMax));
+  CORRADE_VERIFY(!pathFinder.isTiled());
+  CORRADE_VERIFY(!pathFinder.rebuildTiles(
+      verts.data(), verts.size() / 3, tris.data(), tris.size() / 3,
+      wallMin.data(), wallMax.data()));
+}
+
+void PathFinderTest::obstacles() {
+  std::vector<float> verts{-5, 0, -5, -5, 0, 5, 5, 0, 5, 5, 0, -5};
+  std::vector<int> tris{0, 1, 2, 0, 2, 3};
+  const float floorMin[]{-5, 0, -5};
+  const float floorMax[]{5, 0, 5};
+
+  esp::nav::NavMeshSettings settings;
+  esp::nav::PathFinder pathFinder;
+  CORRADE_VERIFY(pathFinder.build(settings, verts.data(), verts.size() / 3,
+                                  tris.data(), tris.size() / 3, floorMin,
+                                  floorMax));
+  // obstacles need a tiled navmesh
+  CORRADE_COMPARE(
+      pathFinder.addCylinderObstacle(esp::vec3f{0, 0, 0}, 0.5f, 2.0f), 0u);
+  CORRADE_VERIFY(!pathFinder.updateObstacles());
+
+  settings.tileSize = 32;
+  CORRADE_VERIFY(pathFinder.build(settings, verts.data(), verts.size() / 3,
+                                  tris.data(), tris.size() / 3, floorMin,
+                                  floorMax));
+  esp::nav::ShortestPath path;
+  path.requestedStart = esp::vec3f{0, 0, -3};
+  path.requestedEnd = esp::vec3f{0, 0, 3};
+  CORRADE_VERIFY(pathFinder.findPath(path));
+  const float freeDistance = path.geodesicDistance;
+
+  // a wall from x = -5 to 3, leaving a gap at x > 3
+  const uint32_t wall = pathFinder.addBoxObstacle(
+      esp::vec3f{-1.0f, 1.0f, 0.0f}, esp::vec3f{4.0f, 1.0f, 0.1f});
+  CORRADE_VERIFY(wall != 0);
+  CORRADE_VERIFY(pathFinder.updateObstacles());
+  CORRADE_VERIFY(pathFinder.findPath(path));
+  CORRADE_COMPARE_AS(path.geodesicDistance, 8.0f,
+                     Cr::TestSuite::Compare::Greater);
+  const esp::vec3f stepEnd = pathFinder.tryStep(
+      esp::vec3f{0.0f, 0.0f, -1.0f}, esp::vec3f{0.0f, 0.0f, 1.0f});
+  CORRADE_COMPARE_AS(stepEnd[2], 0.0f, Cr::TestSuite::Compare::Less);
+
+  // and back, once the removal is applied
+  CORRADE_VERIFY(pathFinder.removeObstacle(wall));
+  CORRADE_VERIFY(!pathFinder.removeObstacle(wall + 1));
+  CORRADE_VERIFY(pathFinder.updateObstacles());
+  CORRADE_VERIFY(pathFinder.findPath(path));
+  CORRADE_COMPARE(path.geodesicDistance, freeDistance);
+}
+
 void PathFinderTest::benchmarkSingleGoal() {
   esp::nav::PathFinder pathFinder;
   pathFinder.loadNavMesh(skokloster);
@@ -199,6 +675,45 @@ void PathFinderTest::benchmarkMultiGoal() {
   CORRADE_VERIFY(status);
 }
 
+void PathFinderTest::benchmarkTryStep() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  std::vector<esp::vec3f> starts, ends;
+  for (int i = 0; i < 1000; ++i) {
+    starts.emplace_back(pathFinder.getRandomNavigablePoint());
+    ends.emplace_back(starts.back() + esp::vec3f{0.25f, 0.0f, 0.0f});
+  }
+
+  std::size_t numMoved = 0;
+  CORRADE_BENCHMARK(1) {
+    numMoved = 0;
+    for (std::size_t i = 0; i < starts.size(); ++i) {
+      const esp::vec3f end = pathFinder.tryStep(starts[i], ends[i]);
+      numMoved += end != starts[i];
+    }
+  };
+  CORRADE_VERIFY(numMoved > 0);
+}
+
+void PathFinderTest::benchmarkTopDownView() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  // the views are cached by height, alternate it to measure the computation
+  const float height = pathFinder.bounds().first[1];
+  int iteration = 0;
+  std::size_t numNavigable = 0;
+  CORRADE_BENCHMARK(1) {
+    numNavigable = pathFinder
+                       .getTopDownView(0.1f, height + 0.01f * (iteration++ % 2))
+                       .count();
+  };
+  CORRADE_VERIFY(numNavigable > 0);
+}
+
 }  // namespace
 
 CORRADE_TEST_MAIN(PathFinderTest)
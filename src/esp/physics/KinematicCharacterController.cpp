@@ -0,0 +1,105 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "KinematicCharacterController.h"
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Functions.h>
+#include <algorithm>
+
+#include "esp/core/Profiling.h"
+#include "esp/physics/PhysicsManager.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace physics {
+
+std::vector<Mn::Vector3> KinematicCharacterController::moveBatch(
+    PhysicsManager& physicsManager,
+    const std::vector<Mn::Vector3>& starts,
+    const std::vector<Mn::Vector3>& ends) const {
+  ESP_PROFILE_SCOPE("KinematicCharacterController::moveBatch");
+  CORRADE_ASSERT(starts.size() == ends.size(),
+                 "KinematicCharacterController::moveBatch(): expected as "
+                 "many starts as ends but got"
+                     << starts.size() << "and" << ends.size(),
+                 {});
+  // the capsule between the step height and the top of the body, at least a
+  // sphere
+  const float capsuleHeight =
+      std::max(config_.height - config_.stepHeight, 2.0f * config_.radius);
+  const Mn::Vector3 offset =
+      Mn::Vector3::yAxis(config_.stepHeight + 0.5f * capsuleHeight);
+  // moves shorter than this are done
+  const float minMove = 0.1f * config_.skinWidth;
+
+  std::vector<Mn::Vector3> centers(starts.size());
+  std::vector<Mn::Vector3> remaining(starts.size());
+  std::vector<std::size_t> active;
+  for (std::size_t i = 0; i < starts.size(); ++i) {
+    centers[i] = starts[i] + offset;
+    remaining[i] = ends[i] - starts[i];
+    if (remaining[i].length() > minMove) {
+      active.push_back(i);
+    } else {
+      centers[i] += remaining[i];
+    }
+  }
+
+  std::vector<Mn::Vector3> from, to;
+  for (int slide = 0; slide <= config_.maxSlides && !active.empty();
+       ++slide) {
+    from.clear();
+    to.clear();
+    for (const std::size_t i : active) {
+      from.push_back(centers[i]);
+      to.push_back(centers[i] + remaining[i]);
+    }
+    const std::vector<SweepResult> hits = physicsManager.sweepCapsuleBatch(
+        config_.radius, capsuleHeight, from, to, config_.collisionFilterMask);
+
+    std::size_t numActive = 0;
+    for (std::size_t k = 0; k < active.size(); ++k) {
+      const std::size_t i = active[k];
+      const SweepResult& hit = hits[k];
+      if (!hit.hasHit) {
+        centers[i] += remaining[i];
+        continue;
+      }
+      // stop the skin width short of the impact
+      const float length = remaining[i].length();
+      const float t =
+          std::max(float(hit.timeOfImpact) - config_.skinWidth / length, 0.0f);
+      centers[i] += remaining[i] * t;
+      if (!config_.allowSliding || slide == config_.maxSlides) {
+        continue;
+      }
+
+      // slide along the horizontal normal, so that walls and slopes don't
+      // lift the body, the navmesh keeps it on the floor
+      Mn::Vector3 normal{hit.normal.x(), 0.0f, hit.normal.z()};
+      if (normal.dot() < 1.0e-6f) {
+        continue;
+      }
+      normal = normal.normalized();
+      Mn::Vector3 left = remaining[i] * (1.0f - t);
+      left -= normal * std::min(Mn::Math::dot(left, normal), 0.0f);
+      if (left.length() > minMove) {
+        remaining[i] = left;
+        active[numActive++] = i;
+      }
+    }
+    active.resize(numActive);
+  }
+
+  std::vector<Mn::Vector3> results(starts.size());
+  for (std::size_t i = 0; i < starts.size(); ++i) {
+    results[i] = centers[i] - offset;
+  }
+  return results;
+}
+
+}  // namespace physics
+}  // namespace esp
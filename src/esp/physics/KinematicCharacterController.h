@@ -0,0 +1,93 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_PHYSICS_KINEMATICCHARACTERCONTROLLER_H_
+#define ESP_PHYSICS_KINEMATICCHARACTERCONTROLLER_H_
+
+/** @file
+ * @brief Class @ref esp::physics::KinematicCharacterController
+ */
+
+#include <vector>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "esp/core/esp.h"
+#include "esp/physics/RigidBase.h"
+
+namespace esp {
+namespace physics {
+
+class PhysicsManager;
+
+/**
+ * @brief Moves of agent bodies blocked by the stage and the objects, without
+ * simulating the bodies
+ *
+ * The body is an upright capsule from @ref Configuration::stepHeight above
+ * its position, i.e. its feet, to @ref Configuration::height, so the floor
+ * and obstacles lower than the step aren't hit. A move is swept with
+ * @ref PhysicsManager::sweepCapsuleBatch() and stops short of the first hit,
+ * the rest of it then slides along the obstacle, for up to
+ * @ref Configuration::maxSlides hits. The moves of a batch are swept
+ * together, each slide iteration being one batch of all the moves still
+ * going.
+ *
+ * Meant as the move filter of @ref scene::ObjectControls, after the navmesh
+ * one so that the objects not baked into the navmesh block the agents too.
+ */
+class KinematicCharacterController {
+ public:
+  struct Configuration {
+    //! The radius of the body.
+    float radius = 0.1f;
+    //! The height of the top of the body above its feet.
+    float height = 1.5f;
+    //! The height of the bottom of the capsule above the feet.
+    float stepHeight = 0.2f;
+    //! The distance kept from the obstacles.
+    float skinWidth = 0.01f;
+    //! The number of hits a move slides along before it stops.
+    int maxSlides = 3;
+    //! Whether a move slides along the obstacles or stops at the first one.
+    bool allowSliding = true;
+    //! The @ref CollisionGroup values the body hits.
+    int collisionFilterMask = int(CollisionGroup::ALL);
+  };
+
+  explicit KinematicCharacterController(const Configuration& config)
+      : config_(config) {}
+
+  const Configuration& getConfiguration() const { return config_; }
+
+  /**
+   * @brief The end of a move of the feet from @p start toward @p end
+   */
+  Magnum::Vector3 move(PhysicsManager& physicsManager,
+                       const Magnum::Vector3& start,
+                       const Magnum::Vector3& end) const {
+    return moveBatch(physicsManager, {start}, {end}).front();
+  }
+
+  /**
+   * @brief @ref move() of a batch of moves, in parallel
+   *
+   * With as many @p starts as @p ends, returns the end of each move.
+   */
+  std::vector<Magnum::Vector3> moveBatch(
+      PhysicsManager& physicsManager,
+      const std::vector<Magnum::Vector3>& starts,
+      const std::vector<Magnum::Vector3>& ends) const;
+
+ private:
+  Configuration config_;
+
+  ESP_SMART_POINTERS(KinematicCharacterController)
+};
+
+}  // namespace physics
+}  // namespace esp
+
+#endif  // ESP_PHYSICS_KINEMATICCHARACTERCONTROLLER_H_
@@ -4,17 +4,75 @@
 
 #include "PhysicsManager.h"
 #include "esp/assets/CollisionMeshData.h"
+#include "esp/core/MappedFile.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/ThreadPool.h"
 
 #include <Magnum/Math/Range.h>
 
+#include <algorithm>
+#include <cstring>
+
+namespace Cr = Corrade;
+
 namespace esp {
 namespace physics {
 
+namespace {
+// Adds the collision meshes of a node and its children, in world space
+void addStageMeshes(geo::TriangleBVH& bvh,
+                    const Magnum::Matrix4& transformFromParentToWorld,
+                    const std::vector<assets::CollisionMeshData>& meshGroup,
+                    const assets::MeshTransformNode& node) {
+  const Magnum::Matrix4 transformFromLocalToWorld =
+      transformFromParentToWorld * node.transformFromLocalToParent;
+  if (node.meshIDLocal != ID_UNDEFINED) {
+    const assets::CollisionMeshData& mesh = meshGroup[node.meshIDLocal];
+    bvh.addMesh(mesh.positions, mesh.indices, transformFromLocalToWorld);
+  }
+  for (const assets::MeshTransformNode& child : node.children) {
+    addStageMeshes(bvh, transformFromLocalToWorld, meshGroup, child);
+  }
+}
+
+// Appends the stage hits of a ray, as the simulation implementations do
+void castStageRayHits(const geo::TriangleBVH& bvh,
+                      const esp::geo::Ray& ray,
+                      const double maxDistance,
+                      const bool closestHitOnly,
+                      std::vector<RayHitInfo>& hits) {
+  auto addHit = [&](const geo::TriangleBVH::Hit& bvhHit) {
+    RayHitInfo hit;
+    hit.objectId = ID_UNDEFINED;
+    hit.point = ray.origin + ray.direction * bvhHit.distance;
+    hit.normal = bvhHit.normal;
+    hit.rayDistance = bvhHit.distance;
+    hits.push_back(hit);
+  };
+  if (closestHitOnly) {
+    geo::TriangleBVH::Hit hit;
+    if (bvh.castRay(ray, float(maxDistance), hit)) {
+      addHit(hit);
+    }
+  } else {
+    std::vector<geo::TriangleBVH::Hit> bvhHits;
+    bvh.castRayAll(ray, float(maxDistance), bvhHits);
+    for (const geo::TriangleBVH::Hit& hit : bvhHits) {
+      addHit(hit);
+    }
+  }
+}
+}  // namespace
+
 bool PhysicsManager::initPhysics(scene::SceneNode* node) {
   physicsNode_ = node;
 
   // Copy over relevant configuration
   fixedTimeStep_ = physicsManagerAttributes_->getTimestep();
+  maxSubsteps_ = physicsManagerAttributes_->getMaxSubsteps();
+  skipIfBehind_ = physicsManagerAttributes_->getSkipIfBehind();
+  renderInterpolation_ = physicsManagerAttributes_->getRenderInterpolation();
+  deterministic_ = physicsManagerAttributes_->getDeterministic();
 
   //! Create new scene node and set up any physics-related variables
   // Overridden by specific physics-library-based class
@@ -45,9 +103,96 @@ bool PhysicsManager::addStage(
 
   //! Initialize scene
   bool sceneSuccess = addStageFinalize(handle);
+  stageHasCollisionMeshes_ = sceneSuccess && !meshGroup.empty();
   return sceneSuccess;
 }
 
+const geo::TriangleBVH* PhysicsManager::stageRayBvh(
+    const int collisionFilterMask) {
+  if (!(collisionFilterMask & int(CollisionGroup::STAGE)) ||
+      !stageHasCollisionMeshes_ || !staticStageObject_->getCollidable()) {
+    return nullptr;
+  }
+  if (!stageRayBvh_) {
+    ESP_PROFILE_SCOPE("PhysicsManager::stageRayBvh");
+    const std::string& collisionAssetHandle =
+        staticStageObject_->getInitializationAttributesShared()
+            ->getCollisionAssetHandle();
+    stageRayBvh_ = geo::TriangleBVH::create_unique();
+    addStageMeshes(*stageRayBvh_, Magnum::Matrix4{},
+                   resourceManager_.getCollisionMesh(collisionAssetHandle),
+                   resourceManager_.getMeshMetaData(collisionAssetHandle).root);
+    stageRayBvh_->build();
+  }
+  return stageRayBvh_->empty() ? nullptr : stageRayBvh_.get();
+}
+
+RaycastResults PhysicsManager::castRay(const esp::geo::Ray& ray,
+                                       const double maxDistance,
+                                       const bool closestHitOnly,
+                                       const int collisionFilterMask) {
+  RaycastResults results;
+  results.ray = ray;
+  if (const geo::TriangleBVH* bvh = stageRayBvh(collisionFilterMask)) {
+    castStageRayHits(*bvh, ray, maxDistance, closestHitOnly, results.hits);
+  }
+  return results;
+}
+
+MultiRaycastResults PhysicsManager::castRays(
+    const std::vector<esp::geo::Ray>& rays,
+    const double maxDistance,
+    const bool closestHitOnly,
+    const int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("PhysicsManager::castRays");
+  MultiRaycastResults results;
+  results.hitOffsets.resize(rays.size() + 1, 0);
+  const geo::TriangleBVH* bvh = stageRayBvh(collisionFilterMask);
+  if (!bvh) {
+    return results;
+  }
+
+  // every chunk of rays collects its hits, then they are concatenated
+  const std::size_t raysPerChunk = 64;
+  const std::size_t chunks = (rays.size() + raysPerChunk - 1) / raysPerChunk;
+  std::vector<std::vector<RayHitInfo>> chunkHits(chunks);
+  auto castChunk = [&](const std::size_t chunk, std::size_t) {
+    std::vector<RayHitInfo>& hits = chunkHits[chunk];
+    const std::size_t end = std::min(rays.size(), (chunk + 1) * raysPerChunk);
+    for (std::size_t i = chunk * raysPerChunk; i < end; ++i) {
+      const std::size_t first = hits.size();
+      castStageRayHits(*bvh, rays[i], maxDistance, closestHitOnly, hits);
+      results.hitOffsets[i + 1] = hits.size() - first;
+    }
+  };
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers = pool.numWorkers(chunks, pool.numThreads() + 1);
+  if (workers == 1) {
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      castChunk(chunk, 0);
+    }
+  } else {
+    pool.parallelFor(chunks, workers, castChunk);
+  }
+
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    results.hitOffsets[i + 1] += results.hitOffsets[i];
+  }
+  results.objectIds.reserve(results.numHits());
+  results.points.reserve(results.numHits());
+  results.normals.reserve(results.numHits());
+  results.rayDistances.reserve(results.numHits());
+  for (const std::vector<RayHitInfo>& hits : chunkHits) {
+    for (const RayHitInfo& hit : hits) {
+      results.objectIds.push_back(hit.objectId);
+      results.points.push_back(hit.point);
+      results.normals.push_back(hit.normal);
+      results.rayDistances.push_back(hit.rayDistance);
+    }
+  }
+  return results;
+}
+
 bool PhysicsManager::addStageFinalize(const std::string& handle) {
   //! Initialize scene
   bool sceneSuccess = staticStageObject_->initialize(handle);
@@ -69,6 +214,14 @@ int PhysicsManager::addObject(const std::string& configFileHandle,
                               DrawableGroup* drawables,
                               scene::SceneNode* attachmentNode,
                               const std::string& lightSetup) {
+  if (attachmentNode == nullptr && objectPoolSize_ > 0) {
+    const int pooledObjectID =
+        reactivatePooledObject(configFileHandle, drawables, lightSetup);
+    if (pooledObjectID != ID_UNDEFINED) {
+      return pooledObjectID;
+    }
+  }
+
   //! Make rigid object and add it to existingObjects
   int nextObjectID_ = allocateObjectID();
   scene::SceneNode* objectNode = attachmentNode;
@@ -108,10 +261,12 @@ int PhysicsManager::addObject(const std::string& configFileHandle,
   //! Draw object via resource manager
   //! Render node as child of physics node
   //! Verify we should make the object drawable
-  if (obj->getInitializationAttributes()->getIsVisible()) {
-    resourceManager_.addObjectToDrawables(obj->getInitializationAttributes(),
-                                          obj->visualNode_, drawables,
-                                          obj->visualNodes_, lightSetup);
+  const metadata::attributes::ObjectAttributes::cptr objectAttributes =
+      obj->getInitializationAttributesShared();
+  if (objectAttributes->getIsVisible()) {
+    resourceManager_.addObjectToDrawables(objectAttributes, obj->visualNode_,
+                                          drawables, obj->visualNodes_,
+                                          lightSetup);
   }
 
   // finalize rigid object creation
@@ -123,17 +278,299 @@ int PhysicsManager::addObject(const std::string& configFileHandle,
     return ID_UNDEFINED;
   }
 
+  if (attachmentNode == nullptr) {
+    poolableObjectLightSetups_.emplace(nextObjectID_, lightSetup);
+  }
   return nextObjectID_;
 }
 
+int PhysicsManager::reactivatePooledObject(const std::string& handle,
+                                           DrawableGroup* drawables,
+                                           const std::string& lightSetup) {
+  auto found = objectPool_.find(handle);
+  if (found == objectPool_.end()) {
+    return ID_UNDEFINED;
+  }
+  std::vector<PooledObject>& pool = found->second;
+  // the objects share the template they were made of, which a template
+  // registered again under the handle since replaces in the library
+  const auto attributes =
+      resourceManager_.getObjectAttributesManager()->getObjectSharedByHandle(
+          handle);
+  auto isCurrent = [&](const PooledObject& pooled) {
+    return pooled.object->getInitializationAttributesShared() == attributes;
+  };
+  if (!std::all_of(pool.begin(), pool.end(), isCurrent)) {
+    auto stale = std::stable_partition(pool.begin(), pool.end(), isCurrent);
+    for (auto it = stale; it != pool.end(); ++it) {
+      deletePooledObject(*it);
+    }
+    pool.erase(stale, pool.end());
+  }
+  auto pooled = std::find_if(pool.rbegin(), pool.rend(),
+                             [&](const PooledObject& candidate) {
+                               return candidate.lightSetup == lightSetup;
+                             });
+  if (pooled == pool.rend()) {
+    return ID_UNDEFINED;
+  }
+
+  const int objectID = allocateObjectID();
+  pooled->object->reactivate(objectID);
+  if (drawables) {
+    for (gfx::Drawable* drawable : pooled->drawables) {
+      drawables->add(*drawable);
+    }
+  }
+  existingObjects_.emplace(objectID, std::move(pooled->object));
+  poolableObjectLightSetups_.emplace(objectID, lightSetup);
+  // the vector keeps its capacity for the next removals
+  pool.erase(std::next(pooled).base());
+  return objectID;
+}
+
+void PhysicsManager::deletePooledObject(PooledObject& pooled) {
+  scene::SceneNode* objectNode = &pooled.object->node();
+  pooled.object.reset();
+  delete objectNode;
+}
+
+void PhysicsManager::setObjectPoolSize(const int size) {
+  objectPoolSize_ = std::max(size, 0);
+  for (auto& pool : objectPool_) {
+    // the least recently removed go first
+    const std::size_t excess =
+        pool.second.size() -
+        std::min(pool.second.size(), std::size_t(objectPoolSize_));
+    for (std::size_t i = 0; i < excess; ++i) {
+      deletePooledObject(pool.second[i]);
+    }
+    pool.second.erase(pool.second.begin(), pool.second.begin() + excess);
+  }
+}
+
+int PhysicsManager::getNumPooledObjects() const {
+  int numPooled = 0;
+  for (const auto& pool : objectPool_) {
+    numPooled += pool.second.size();
+  }
+  return numPooled;
+}
+
+void PhysicsManager::clearObjectPool() {
+  for (auto& pool : objectPool_) {
+    for (PooledObject& pooled : pool.second) {
+      deletePooledObject(pooled);
+    }
+  }
+  objectPool_.clear();
+}
+
+bool PhysicsManager::addObjectsOf(const PhysicsManager& other,
+                                  DrawableGroup* drawables) {
+  CORRADE_ASSERT(existingObjects_.empty(),
+                 "PhysicsManager::addObjectsOf(): the manager already has "
+                 "objects",
+                 false);
+  nextObjectID_ = other.nextObjectID_;
+  std::vector<int> failedObjectIDs;
+  for (const auto& object : other.existingObjects_) {
+    // make allocateObjectID() return the ID of the original
+    recycledObjectIDs_.assign(1, object.first);
+    const std::string handle =
+        object.second->getInitializationAttributesShared()->getHandle();
+    if (addObject(handle, drawables) == ID_UNDEFINED) {
+      LOG(ERROR) << "PhysicsManager::addObjectsOf : can't instance object "
+                 << object.first << " from " << handle;
+      failedObjectIDs.push_back(object.first);
+      continue;
+    }
+    if (other.velControlledObjectIDs_.count(object.first)) {
+      *getVelocityControl(object.first) =
+          *object.second->getVelocityControl();
+    }
+  }
+  recycledObjectIDs_ = other.recycledObjectIDs_;
+  recycledObjectIDs_.insert(recycledObjectIDs_.end(), failedObjectIDs.begin(),
+                            failedObjectIDs.end());
+  return failedObjectIDs.empty();
+}
+
+namespace {
+
+const int OBJECT_INSTANCES_MAGIC = 'P' << 24 | 'O' << 16 | 'B' << 8 | 'J';
+const int OBJECT_INSTANCES_VERSION = 1;
+
+struct ObjectInstancesHeader {
+  int magic;
+  int version;
+  int numObjects;
+  int numRecycledObjectIDs;
+  int nextObjectID;
+};
+
+// followed by the handle
+struct ObjectInstance {
+  int objectID;
+  int handleSize;
+  int velocityControlled;
+  int controllingLinVel;
+  int linVelIsLocal;
+  int controllingAngVel;
+  int angVelIsLocal;
+  float linVel[3];
+  float angVel[3];
+};
+
+}  // namespace
+
+std::string PhysicsManager::serializeObjectInstances() const {
+  const ObjectInstancesHeader header{
+      OBJECT_INSTANCES_MAGIC, OBJECT_INSTANCES_VERSION,
+      int(existingObjects_.size()), int(recycledObjectIDs_.size()),
+      nextObjectID_};
+  std::string instances(reinterpret_cast<const char*>(&header),
+                        sizeof(header));
+  instances.append(reinterpret_cast<const char*>(recycledObjectIDs_.data()),
+                   recycledObjectIDs_.size() * sizeof(int));
+  for (const auto& object : existingObjects_) {
+    const std::string handle =
+        object.second->getInitializationAttributesShared()->getHandle();
+    ObjectInstance instance{object.first, int(handle.size()),
+                            int(velControlledObjectIDs_.count(object.first))};
+    if (instance.velocityControlled) {
+      const VelocityControl& control = *object.second->getVelocityControl();
+      instance.controllingLinVel = control.controllingLinVel;
+      instance.linVelIsLocal = control.linVelIsLocal;
+      instance.controllingAngVel = control.controllingAngVel;
+      instance.angVelIsLocal = control.angVelIsLocal;
+      Magnum::Vector3::from(instance.linVel) = control.linVel;
+      Magnum::Vector3::from(instance.angVel) = control.angVel;
+    }
+    instances.append(reinterpret_cast<const char*>(&instance),
+                     sizeof(instance));
+    instances.append(handle);
+  }
+  return instances;
+}
+
+bool PhysicsManager::deserializeObjectInstances(const std::string& instances,
+                                                DrawableGroup* drawables) {
+  std::size_t offset = 0;
+  auto readNext = [&](void* out, const std::size_t size) {
+    if (instances.size() - offset < size) {
+      return false;
+    }
+    std::memcpy(out, instances.data() + offset, size);
+    offset += size;
+    return true;
+  };
+
+  ObjectInstancesHeader header{};
+  if (!readNext(&header, sizeof(header)) ||
+      header.magic != OBJECT_INSTANCES_MAGIC ||
+      header.version != OBJECT_INSTANCES_VERSION || header.numObjects < 0 ||
+      header.numRecycledObjectIDs < 0) {
+    return false;
+  }
+  std::vector<int> recycledObjectIDs(header.numRecycledObjectIDs);
+  if (!recycledObjectIDs.empty() &&
+      !readNext(recycledObjectIDs.data(),
+                recycledObjectIDs.size() * sizeof(int))) {
+    return false;
+  }
+  std::vector<std::pair<ObjectInstance, std::string>> objects(
+      header.numObjects);
+  for (auto& object : objects) {
+    if (!readNext(&object.first, sizeof(ObjectInstance)) ||
+        object.first.handleSize < 0 ||
+        instances.size() - offset < std::size_t(object.first.handleSize)) {
+      return false;
+    }
+    object.second = instances.substr(offset, object.first.handleSize);
+    offset += object.first.handleSize;
+  }
+  if (offset != instances.size()) {
+    return false;
+  }
+
+  // removed objects go to the pools, from which the same templates are
+  // instanced again
+  std::vector<int> existingObjectIDs;
+  existingObjectIDs.reserve(existingObjects_.size());
+  for (const auto& object : existingObjects_) {
+    existingObjectIDs.push_back(object.first);
+  }
+  for (const int objectID : existingObjectIDs) {
+    removeObject(objectID);
+  }
+
+  nextObjectID_ = header.nextObjectID;
+  std::vector<int> failedObjectIDs;
+  for (const auto& object : objects) {
+    const ObjectInstance& instance = object.first;
+    // make allocateObjectID() return the ID of the instance
+    recycledObjectIDs_.assign(1, instance.objectID);
+    if (addObject(object.second, drawables) == ID_UNDEFINED) {
+      LOG(ERROR) << "PhysicsManager::deserializeObjectInstances : can't "
+                    "instance object "
+                 << instance.objectID << " from " << object.second;
+      failedObjectIDs.push_back(instance.objectID);
+      continue;
+    }
+    if (instance.velocityControlled) {
+      VelocityControl& control = *getVelocityControl(instance.objectID);
+      control.controllingLinVel = instance.controllingLinVel;
+      control.linVelIsLocal = instance.linVelIsLocal;
+      control.controllingAngVel = instance.controllingAngVel;
+      control.angVelIsLocal = instance.angVelIsLocal;
+      control.linVel = Magnum::Vector3::from(instance.linVel);
+      control.angVel = Magnum::Vector3::from(instance.angVel);
+    }
+  }
+  recycledObjectIDs_ = std::move(recycledObjectIDs);
+  recycledObjectIDs_.insert(recycledObjectIDs_.end(), failedObjectIDs.begin(),
+                            failedObjectIDs.end());
+  return failedObjectIDs.empty();
+}
+
 void PhysicsManager::removeObject(const int physObjectID,
                                   bool deleteObjectNode,
                                   bool deleteVisualNode) {
   assertIDValidity(physObjectID);
-  scene::SceneNode* objectNode = &existingObjects_.at(physObjectID)->node();
-  scene::SceneNode* visualNode = existingObjects_.at(physObjectID)->visualNode_;
-  existingObjects_.erase(physObjectID);
+  auto object = existingObjects_.find(physObjectID);
+  auto poolable = poolableObjectLightSetups_.find(physObjectID);
+  velControlledObjectIDs_.erase(physObjectID);
   deallocateObjectID(physObjectID);
+
+  if (poolable != poolableObjectLightSetups_.end()) {
+    PooledObject pooled{nullptr, std::move(poolable->second), {}};
+    poolableObjectLightSetups_.erase(poolable);
+    std::vector<PooledObject>* pool = nullptr;
+    if (deleteObjectNode && objectPoolSize_ > 0) {
+      pool = &objectPool_[object->second->getInitializationAttributesShared()
+                              ->getHandle()];
+    }
+    if (pool && pool->size() < std::size_t(objectPoolSize_)) {
+      pooled.object = std::move(object->second);
+      existingObjects_.erase(object);
+      pooled.object->deactivate();
+      // hidden rather than deleted
+      scene::preOrderFeatureTraversalWithCallback<gfx::Drawable>(
+          pooled.object->node(), [&](gfx::Drawable& drawable) {
+            if (drawable.drawables()) {
+              drawable.drawables()->remove(drawable);
+            }
+            pooled.drawables.push_back(&drawable);
+          });
+      pool->push_back(std::move(pooled));
+      return;
+    }
+  }
+
+  scene::SceneNode* objectNode = &object->second->node();
+  scene::SceneNode* visualNode = object->second->visualNode_;
+  existingObjects_.erase(object);
   if (deleteObjectNode) {
     delete objectNode;
   } else if (deleteVisualNode && visualNode) {
@@ -199,6 +636,7 @@ Magnum::Vector3 PhysicsManager::getGravity() const {
 }
 
 void PhysicsManager::stepPhysics(double dt) {
+  ESP_PROFILE_SCOPE("PhysicsManager::stepPhysics");
   // We don't step uninitialized physics sim...
   if (!initialized_) {
     return;
@@ -211,22 +649,81 @@ void PhysicsManager::stepPhysics(double dt) {
     dt = fixedTimeStep_;
   }
 
-  // handle in-between step times? Ideally dt is a multiple of
-  // sceneMetaData_.timestep
-  double targetTime = worldTime_ + dt;
-  while (worldTime_ < targetTime) {
+  restoreDrawnStates();
+  const int numSubsteps = takeSubsteps(dt);
+  for (int substep = 0; substep != numSubsteps; ++substep) {
     // per fixed-step operations can be added here
 
     // kinematic velocity control intergration
-    for (auto& object : existingObjects_) {
-      VelocityControl::ptr velControl = object.second->getVelocityControl();
-      if (velControl->controllingAngVel || velControl->controllingLinVel) {
-        object.second->setRigidState(velControl->integrateTransform(
-            fixedTimeStep_, object.second->getRigidState()));
+    for (const int objectID : velControlledObjectIDs_) {
+      RigidObject& object = *existingObjects_.at(objectID);
+      VelocityControl& velControl = *object.getVelocityControl();
+      if (velControl.controllingAngVel || velControl.controllingLinVel) {
+        object.setRigidState(velControl.integrateTransform(
+            fixedTimeStep_, object.getRigidState()));
       }
     }
     worldTime_ += fixedTimeStep_;
   }
+  drawAtRenderTime();
+}
+
+int PhysicsManager::takeSubsteps(double dt) {
+  pendingTime_ += dt;
+  // the tolerance keeps rounding from postponing a step, e.g. for dt a
+  // multiple of the time step
+  int numSubsteps = int(pendingTime_ / fixedTimeStep_ + 1e-6);
+  if (maxSubsteps_ > 0 && numSubsteps > maxSubsteps_) {
+    if (skipIfBehind_) {
+      pendingTime_ -= (numSubsteps - maxSubsteps_) * fixedTimeStep_;
+    }
+    numSubsteps = maxSubsteps_;
+  }
+  pendingTime_ = std::max(pendingTime_ - numSubsteps * fixedTimeStep_, 0.0);
+  return numSubsteps;
+}
+
+double PhysicsManager::getRenderTimeOffset() const {
+  // a world catching up is drawn at most a step ahead
+  const double offset = std::min(pendingTime_, fixedTimeStep_);
+  return renderInterpolation_ ? offset - fixedTimeStep_ : offset;
+}
+
+void PhysicsManager::restoreDrawnStates() {
+  for (const auto& drawnState : drawnStates_) {
+    auto found = existingObjects_.find(drawnState.first);
+    if (found == existingObjects_.end()) {
+      continue;
+    }
+    // leave the objects moved since they were drawn where they were moved to
+    RigidObject& object = *found->second;
+    const core::RigidState state = object.getRigidState();
+    if (state.translation == drawnState.second.drawn.translation &&
+        state.rotation == drawnState.second.drawn.rotation) {
+      object.setRigidState(drawnState.second.simulated);
+    }
+  }
+  drawnStates_.clear();
+}
+
+void PhysicsManager::drawAtRenderTime() {
+  const double offset = getRenderTimeOffset();
+  if (offset == 0.0) {
+    return;
+  }
+  for (const int objectID : velControlledObjectIDs_) {
+    RigidObject& object = *existingObjects_.at(objectID);
+    VelocityControl& velControl = *object.getVelocityControl();
+    if (object.getMotionType() != MotionType::KINEMATIC ||
+        (!velControl.controllingAngVel && !velControl.controllingLinVel)) {
+      continue;
+    }
+    const core::RigidState simulated = object.getRigidState();
+    const core::RigidState drawn =
+        velControl.integrateTransform(offset, simulated);
+    object.setRigidState(drawn);
+    drawnStates_.emplace(objectID, DrawnState{simulated, drawn});
+  }
 }
 
 //! Profile function. In BulletPhysics stationary objects are
@@ -374,6 +871,202 @@ esp::core::RigidState PhysicsManager::getRigidState(
   return existingObjects_.at(physObjectID)->getRigidState();
 }
 
+void PhysicsManager::getRigidStates(
+    Cr::Containers::ArrayView<const int> physObjectIDs,
+    Cr::Containers::ArrayView<Magnum::Vector3> translations,
+    Cr::Containers::ArrayView<Magnum::Quaternion> rotations) const {
+  CORRADE_ASSERT(translations.size() == physObjectIDs.size() &&
+                     rotations.size() == physObjectIDs.size(),
+                 "PhysicsManager::getRigidStates(): expected"
+                     << physObjectIDs.size() << "translations and rotations", );
+  for (std::size_t i = 0; i < physObjectIDs.size(); ++i) {
+    assertIDValidity(physObjectIDs[i]);
+    const scene::SceneNode& node =
+        existingObjects_.at(physObjectIDs[i])->node();
+    translations[i] = node.translation();
+    rotations[i] = node.rotation();
+  }
+}
+
+void PhysicsManager::setRigidStates(
+    Cr::Containers::ArrayView<const int> physObjectIDs,
+    Cr::Containers::ArrayView<const Magnum::Vector3> translations,
+    Cr::Containers::ArrayView<const Magnum::Quaternion> rotations) {
+  CORRADE_ASSERT(translations.size() == physObjectIDs.size() &&
+                     rotations.size() == physObjectIDs.size(),
+                 "PhysicsManager::setRigidStates(): expected"
+                     << physObjectIDs.size() << "translations and rotations", );
+  for (std::size_t i = 0; i < physObjectIDs.size(); ++i) {
+    assertIDValidity(physObjectIDs[i]);
+    existingObjects_.at(physObjectIDs[i])
+        ->setRigidState(core::RigidState{rotations[i], translations[i]});
+  }
+}
+
+void PhysicsManager::getVelocities(
+    Cr::Containers::ArrayView<const int> physObjectIDs,
+    Cr::Containers::ArrayView<Magnum::Vector3> linVels,
+    Cr::Containers::ArrayView<Magnum::Vector3> angVels) const {
+  CORRADE_ASSERT(linVels.size() == physObjectIDs.size() &&
+                     angVels.size() == physObjectIDs.size(),
+                 "PhysicsManager::getVelocities(): expected"
+                     << physObjectIDs.size() << "velocities", );
+  for (std::size_t i = 0; i < physObjectIDs.size(); ++i) {
+    assertIDValidity(physObjectIDs[i]);
+    const RigidObject& object = *existingObjects_.at(physObjectIDs[i]);
+    linVels[i] = object.getLinearVelocity();
+    angVels[i] = object.getAngularVelocity();
+  }
+}
+
+void PhysicsManager::setVelocities(
+    Cr::Containers::ArrayView<const int> physObjectIDs,
+    Cr::Containers::ArrayView<const Magnum::Vector3> linVels,
+    Cr::Containers::ArrayView<const Magnum::Vector3> angVels) {
+  CORRADE_ASSERT(linVels.size() == physObjectIDs.size() &&
+                     angVels.size() == physObjectIDs.size(),
+                 "PhysicsManager::setVelocities(): expected"
+                     << physObjectIDs.size() << "velocities", );
+  for (std::size_t i = 0; i < physObjectIDs.size(); ++i) {
+    assertIDValidity(physObjectIDs[i]);
+    RigidObject& object = *existingObjects_.at(physObjectIDs[i]);
+    object.setLinearVelocity(linVels[i]);
+    object.setAngularVelocity(angVels[i]);
+  }
+}
+
+namespace {
+
+const int PHYSICS_STATE_MAGIC = 'P' << 24 | 'S' << 16 | 'T' << 8 | 'A';
+const int PHYSICS_STATE_VERSION = 1;
+
+struct PhysicsStateHeader {
+  int magic;
+  int version;
+  int numObjects;
+  int padding;
+  double worldTime;
+};
+
+struct ObjectState {
+  int objectID;
+  int motionType;
+  int active;
+  float translation[3];
+  float rotation[4];
+  float linVel[3];
+  float angVel[3];
+};
+
+}  // namespace
+
+int PhysicsManager::saveState() {
+  savedStates_.emplace(nextStateHandle_, serializeState());
+  return nextStateHandle_++;
+}
+
+bool PhysicsManager::restoreState(const int handle) {
+  auto found = savedStates_.find(handle);
+  return found != savedStates_.end() && deserializeState(found->second);
+}
+
+bool PhysicsManager::removeState(const int handle) {
+  return savedStates_.erase(handle) > 0;
+}
+
+std::string PhysicsManager::serializeState() const {
+  std::string state(sizeof(PhysicsStateHeader) +
+                        existingObjects_.size() * sizeof(ObjectState),
+                    '\0');
+  const PhysicsStateHeader header{PHYSICS_STATE_MAGIC, PHYSICS_STATE_VERSION,
+                                  int(existingObjects_.size()), 0, worldTime_};
+  std::memcpy(&state[0], &header, sizeof(header));
+  std::size_t offset = sizeof(header);
+  for (const auto& object : existingObjects_) {
+    RigidObject& rigidObject = *object.second;
+    const Magnum::Vector3 translation = rigidObject.node().translation();
+    const Magnum::Quaternion rotation = rigidObject.node().rotation();
+    const Magnum::Vector3 linVel = rigidObject.getLinearVelocity();
+    const Magnum::Vector3 angVel = rigidObject.getAngularVelocity();
+    const ObjectState objectState{
+        object.first,
+        int(rigidObject.getMotionType()),
+        rigidObject.isActive(),
+        {translation.x(), translation.y(), translation.z()},
+        {rotation.vector().x(), rotation.vector().y(), rotation.vector().z(),
+         rotation.scalar()},
+        {linVel.x(), linVel.y(), linVel.z()},
+        {angVel.x(), angVel.y(), angVel.z()}};
+    std::memcpy(&state[offset], &objectState, sizeof(objectState));
+    offset += sizeof(objectState);
+  }
+  return state;
+}
+
+std::uint64_t PhysicsManager::getStateChecksum() const {
+  std::string state = serializeState();
+  state.append(reinterpret_cast<const char*>(&pendingTime_),
+               sizeof(pendingTime_));
+  return core::hashBytesXXH64({state.data(), state.size()}, hashEngineState());
+}
+
+bool PhysicsManager::deserializeState(const std::string& state) {
+  PhysicsStateHeader header{};
+  if (state.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, state.data(), sizeof(header));
+  if (header.magic != PHYSICS_STATE_MAGIC ||
+      header.version != PHYSICS_STATE_VERSION || header.numObjects < 0 ||
+      state.size() != sizeof(header) + std::size_t(header.numObjects) *
+                                           sizeof(ObjectState)) {
+    return false;
+  }
+  std::vector<ObjectState> objectStates(header.numObjects);
+  if (header.numObjects > 0) {
+    std::memcpy(objectStates.data(), state.data() + sizeof(header),
+                objectStates.size() * sizeof(ObjectState));
+  }
+  for (const ObjectState& objectState : objectStates) {
+    if (existingObjects_.count(objectState.objectID) == 0) {
+      return false;
+    }
+  }
+
+  for (const ObjectState& objectState : objectStates) {
+    RigidObject& object = *existingObjects_.at(objectState.objectID);
+    const MotionType motionType = MotionType(objectState.motionType);
+    // static objects don't move, so they change type before or after
+    // moving
+    if (object.getMotionType() == MotionType::STATIC &&
+        motionType != MotionType::STATIC) {
+      object.setMotionType(motionType);
+    }
+    object.setRigidState(core::RigidState{
+        Magnum::Quaternion{
+            {objectState.rotation[0], objectState.rotation[1],
+             objectState.rotation[2]},
+            objectState.rotation[3]},
+        Magnum::Vector3::from(objectState.translation)});
+    if (object.getMotionType() != motionType) {
+      object.setMotionType(motionType);
+    }
+    object.setLinearVelocity(Magnum::Vector3::from(objectState.linVel));
+    object.setAngularVelocity(Magnum::Vector3::from(objectState.angVel));
+    if (objectState.active) {
+      object.setActive();
+    } else {
+      object.setSleeping();
+    }
+  }
+  worldTime_ = header.worldTime;
+  pendingTime_ = 0.0;
+  // the restored states are the simulated ones
+  drawnStates_.clear();
+  deserializeStateFinalize();
+  return true;
+}
+
 Magnum::Vector3 PhysicsManager::getTranslation(const int physObjectID) const {
   assertIDValidity(physObjectID);
   return existingObjects_.at(physObjectID)->node().translation();
@@ -411,6 +1104,7 @@ Magnum::Vector3 PhysicsManager::getAngularVelocity(
 VelocityControl::ptr PhysicsManager::getVelocityControl(
     const int physObjectID) {
   assertIDValidity(physObjectID);
+  velControlledObjectIDs_.insert(physObjectID);
   return existingObjects_.at(physObjectID)->getVelocityControl();
 }
 
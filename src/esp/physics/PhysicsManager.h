@@ -10,11 +10,15 @@
  * esp::physics::PhysicsManager::PhysicsSimulationLibrary
  */
 
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
+#include <Corrade/Containers/ArrayView.h>
+
 /* Bullet Physics Integration */
 
 #include "RigidObject.h"
@@ -26,6 +30,8 @@
 #include "esp/assets/MeshData.h"
 #include "esp/assets/MeshMetaData.h"
 #include "esp/assets/ResourceManager.h"
+#include "esp/geo/OBB.h"
+#include "esp/geo/TriangleBVH.h"
 #include "esp/gfx/DrawableGroup.h"
 #include "esp/scene/SceneNode.h"
 
@@ -65,6 +71,46 @@ struct RaycastResults {
   ESP_SMART_POINTERS(RaycastResults)
 };
 
+/**
+ * @brief Holds the ray hits of a batch of rays in flat arrays, one entry per
+ * hit, so they can be handed to numpy without converting every hit.
+ *
+ * The hits of ray i are the entries [hitOffsets[i], hitOffsets[i + 1]),
+ * sorted by distance. Fields as in @ref RayHitInfo.
+ */
+struct MultiRaycastResults {
+  //! One more offset than rays, starting at 0.
+  std::vector<int> hitOffsets{0};
+  std::vector<int> objectIds;
+  std::vector<Magnum::Vector3> points;
+  std::vector<Magnum::Vector3> normals;
+  std::vector<double> rayDistances;
+
+  //! The number of rays.
+  size_t numRays() const { return hitOffsets.size() - 1; }
+
+  //! The number of hits of all rays.
+  size_t numHits() const { return hitOffsets.back(); }
+
+  ESP_SMART_POINTERS(MultiRaycastResults)
+};
+
+//! Holds the first hit of a convex shape swept along a straight path.
+struct SweepResult {
+  //! Whether the shape hits anything before the end of the path.
+  bool hasHit = false;
+  //! The id of the object hit. Stage hits are -1, as no hit.
+  int objectId = -1;
+  //! The fraction of the path travelled before the impact, 1 without hit.
+  double timeOfImpact = 1.0;
+  //! The impact point in world space.
+  Magnum::Vector3 point;
+  //! The normal of the object hit at the point of impact.
+  Magnum::Vector3 normal;
+
+  ESP_SMART_POINTERS(SweepResult)
+};
+
 // TODO: repurpose to manage multiple physical worlds. Currently represents
 // exactly one world.
 
@@ -147,6 +193,7 @@ class PhysicsManager {
   virtual void reset() {
     /* TODO: reset object states or clear them? Other? */
     worldTime_ = 0.0;
+    pendingTime_ = 0.0;
   }
 
   /** @brief Stores references to a set of drawable elements. */
@@ -200,6 +247,42 @@ class PhysicsManager {
                 scene::SceneNode* attachmentNode = nullptr,
                 const std::string& lightSetup = DEFAULT_LIGHTING_KEY);
 
+  /** @brief Instance the objects of another physics manager of the same
+   * resource manager, with the same IDs, templates and velocity controls, e.g.
+   * to fork a simulator. The objects are attached to the stage node and start
+   * at their initial state, copy the states with @ref serializeState and @ref
+   * deserializeState.
+   *  @param other The manager to copy the objects of.
+   *  @param drawables Reference to the scene graph drawables group to enable
+   * rendering of the new objects.
+   *  @return Whether all objects were instanced.
+   */
+  virtual bool addObjectsOf(const PhysicsManager& other,
+                            DrawableGroup* drawables);
+
+  /**
+   * @brief The IDs, template handles and velocity controls of the objects
+   * as a binary blob, to instance them again with @ref
+   * deserializeObjectInstances, e.g. in another process. Their state is in
+   * @ref serializeState.
+   */
+  std::string serializeObjectInstances() const;
+
+  /**
+   * @brief Replace the objects by those of a blob returned by @ref
+   * serializeObjectInstances, with the same IDs, templates and velocity
+   * controls. As for @ref addObjectsOf, the objects are attached to the stage
+   * node and start at their initial state.
+   *  @param instances The blob.
+   *  @param drawables Reference to the scene graph drawables group to enable
+   * rendering of the new objects.
+   *  @return false, changing nothing, if the blob is malformed, otherwise
+   * whether all objects were instanced, which needs the templates to be
+   * registered.
+   */
+  bool deserializeObjectInstances(const std::string& instances,
+                                  DrawableGroup* drawables);
+
   /** @brief Remove an object instance from the pysical scene by ID, destroying
    * its scene graph node and removing it from @ref
    * PhysicsManager::existingObjects_.
@@ -215,6 +298,36 @@ class PhysicsManager {
                             bool deleteObjectNode = true,
                             bool deleteVisualNode = true);
 
+  /** @brief Set the number of removed objects of each template kept for
+   * reuse, 0 by default. Once set, @ref removeObject deactivates the objects
+   * @ref addObject made the node of rather than deleting them: they leave the
+   * world and their drawables are hidden. The next @ref addObject of their
+   * template and light setup without an attachment node reactivates one of
+   * them rather than creating nodes, drawables and collision shapes, see @ref
+   * RigidObject::reactivate. Objects pooled beyond the new size are deleted.
+   *
+   * The objects are deactivated rather than deleted in @ref
+   * esp::gfx::replay recordings as well, so don't pool objects when recording
+   * a replay.
+   *  @param size The number of objects kept for each template.
+   */
+  void setObjectPoolSize(int size);
+
+  /** @brief Get the number of removed objects of each template kept for
+   * reuse, see @ref setObjectPoolSize.
+   */
+  int getObjectPoolSize() const { return objectPoolSize_; }
+
+  /** @brief Get the number of removed objects waiting for reuse, of all
+   * templates.
+   */
+  int getNumPooledObjects() const;
+
+  /** @brief Delete the removed objects waiting for reuse, e.g. after their
+   * templates are unloaded.
+   */
+  void clearObjectPool();
+
   /** @brief Get the number of objects mapped in @ref
    * PhysicsManager::existingObjects_.
    *  @return The size of @ref PhysicsManager::existingObjects_.
@@ -252,7 +365,10 @@ class PhysicsManager {
   //============ Simulator functions =============
 
   /** @brief Step the physical world forward in time. Time may only advance in
-   * increments of @ref fixedTimeStep_.
+   * increments of @ref fixedTimeStep_: the time of @p dt not making a whole
+   * step is kept for the next calls, and moving objects are drawn at
+   * @ref getRenderTime() meanwhile. At most @ref getMaxSubsteps() steps are
+   * taken, see @ref setSkipIfBehind.
    * @param dt The desired amount of time to advance the physical world.
    */
   virtual void stepPhysics(double dt = 0.0);
@@ -289,6 +405,47 @@ class PhysicsManager {
    */
   virtual double getWorldTime() const { return worldTime_; };
 
+  /** @brief Set the most fixed steps a @ref stepPhysics call takes, 0 for no
+   * limit, to bound the time of a call when the world falls behind.
+   */
+  void setMaxSubsteps(int maxSubsteps) { maxSubsteps_ = maxSubsteps; }
+
+  /** @brief Get the most fixed steps a @ref stepPhysics call takes, 0 for no
+   * limit. See @ref setMaxSubsteps.
+   */
+  int getMaxSubsteps() const { return maxSubsteps_; }
+
+  /** @brief Set whether the time of the steps beyond @ref getMaxSubsteps() is
+   * dropped, slowing the world down, instead of caught up by the next
+   * @ref stepPhysics calls. On by default.
+   */
+  void setSkipIfBehind(bool skipIfBehind) { skipIfBehind_ = skipIfBehind; }
+
+  /** @brief Get whether the steps beyond @ref getMaxSubsteps() are dropped.
+   * See @ref setSkipIfBehind.
+   */
+  bool getSkipIfBehind() const { return skipIfBehind_; }
+
+  /** @brief Set whether moving objects are drawn between their last two fixed
+   * steps, a step behind the world, instead of predicted ahead of the last
+   * step, e.g. to render more often than the physics steps without the
+   * objects overshooting collisions. See @ref getRenderTime.
+   */
+  virtual void setRenderInterpolation(bool renderInterpolation) {
+    renderInterpolation_ = renderInterpolation;
+  }
+
+  /** @brief Get whether moving objects are drawn between their last two
+   * fixed steps. See @ref setRenderInterpolation.
+   */
+  bool getRenderInterpolation() const { return renderInterpolation_; }
+
+  /** @brief Get the time moving objects are drawn at: the @ref worldTime_
+   * plus the time requested from @ref stepPhysics not making a fixed step
+   * yet, a fixed step earlier with @ref setRenderInterpolation.
+   */
+  double getRenderTime() const { return worldTime_ + getRenderTimeOffset(); }
+
   /** @brief Get the current gravity in the physical world. By default returns
    * [0,0,0] since their is no notion of force in a kinematic world.
    * @return The current gravity vector in the physical world.
@@ -486,6 +643,112 @@ class PhysicsManager {
    */
   esp::core::RigidState getRigidState(const int objectID) const;
 
+  /** @brief Get the @ref esp::core::RigidState of many objects in one go,
+   * e.g. into arrays viewed by numpy.
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param[out] translations One translation per object.
+   * @param[out] rotations One rotation per object.
+   */
+  void getRigidStates(
+      Corrade::Containers::ArrayView<const int> physObjectIDs,
+      Corrade::Containers::ArrayView<Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<Magnum::Quaternion> rotations) const;
+
+  /** @brief Set the @ref esp::core::RigidState of many objects kinematically
+   * in one go. See @ref setRigidState.
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param translations One translation per object.
+   * @param rotations One rotation per object.
+   */
+  void setRigidStates(
+      Corrade::Containers::ArrayView<const int> physObjectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations);
+
+  /** @brief Get the linear and angular velocities of many objects in one go.
+   * See @ref getLinearVelocity and @ref getAngularVelocity.
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param[out] linVels One linear velocity per object.
+   * @param[out] angVels One angular velocity per object.
+   */
+  void getVelocities(Corrade::Containers::ArrayView<const int> physObjectIDs,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> linVels,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> angVels)
+      const;
+
+  /** @brief Set the linear and angular velocities of many objects in one go.
+   * See @ref setLinearVelocity and @ref setAngularVelocity.
+   * @param physObjectIDs The object IDs and keys identifying the objects in
+   * @ref PhysicsManager::existingObjects_.
+   * @param linVels One linear velocity per object.
+   * @param angVels One angular velocity per object.
+   */
+  void setVelocities(
+      Corrade::Containers::ArrayView<const int> physObjectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> linVels,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> angVels);
+
+  /**
+   * @brief Save the state of the world to restore it with @ref
+   * restoreState, e.g. to reset episodes without recreating objects.
+   *
+   * The state holds the @ref MotionType, rigid state, velocities and sleep
+   * state of every object, and the @ref worldTime_, see @ref
+   * serializeState.
+   * @return The handle of the saved state.
+   */
+  int saveState();
+
+  /**
+   * @brief Restore a state saved by @ref saveState. See @ref
+   * deserializeState.
+   * @param handle The handle returned by @ref saveState.
+   * @return false if there is no such state or an object of the state
+   * doesn't exist anymore.
+   */
+  bool restoreState(int handle);
+
+  /**
+   * @brief Free a state saved by @ref saveState.
+   * @param handle The handle returned by @ref saveState.
+   * @return false if there is no such state.
+   */
+  bool removeState(int handle);
+
+  /**
+   * @brief The state of the world as a compact binary blob, to restore
+   * with @ref deserializeState in this or in an identically populated world.
+   * @return The blob, a fixed size header then a fixed size record per
+   * object.
+   */
+  std::string serializeState() const;
+
+  /**
+   * @brief Restore a state returned by @ref serializeState. Objects added
+   * after it was taken keep their state, contacts are cleared for the
+   * simulation to continue as if the world had been built in that state.
+   * @param state The blob.
+   * @return false, changing nothing, if the blob is malformed or an object
+   * of the state doesn't exist anymore.
+   */
+  bool deserializeState(const std::string& state);
+
+  /**
+   * @brief A hash of the state of the world, e.g. to verify after each step
+   * that two runs stay identical. Covers what @ref serializeState does, the
+   * time not simulated yet and the exact state the physics engine steps.
+   */
+  std::uint64_t getStateChecksum() const;
+
+  /**
+   * @brief Whether the simulation is bitwise reproducible, see
+   * @ref metadata::attributes::PhysicsManagerAttributes::setDeterministic.
+   */
+  bool isDeterministic() const { return deterministic_; }
+
   /** @brief Get the current 3D position of an object.
    * @param  physObjectID The object ID and key identifying the object in @ref
    * PhysicsManager::existingObjects_.
@@ -774,7 +1037,7 @@ class PhysicsManager {
   Magnum::Vector3 getAngularVelocity(const int physObjectID) const;
 
   /**@brief Retrieves a shared pointer to the VelocityControl struct for this
-   * object.
+   * object. From then on, @ref stepPhysics applies the control to the object.
    */
   VelocityControl::ptr getVelocityControl(const int physObjectID);
 
@@ -857,6 +1120,35 @@ class PhysicsManager {
     return existingObjects_.at(physObjectID)->getCollidable();
   };
 
+  /**
+   * @brief Set the collision group of an object and the groups it collides
+   * with, see @ref RigidObject::setCollisionFilter().
+   */
+  bool setObjectCollisionFilter(const int physObjectID,
+                                const int group,
+                                const int mask) {
+    assertIDValidity(physObjectID);
+    return existingObjects_.at(physObjectID)->setCollisionFilter(group, mask);
+  }
+
+  /**
+   * @brief Get the collision group of an object, see
+   * @ref RigidObject::getCollisionGroup().
+   */
+  int getObjectCollisionGroup(const int physObjectID) const {
+    assertIDValidity(physObjectID);
+    return existingObjects_.at(physObjectID)->getCollisionGroup();
+  }
+
+  /**
+   * @brief Get the groups an object collides with, see
+   * @ref RigidObject::getCollisionMask().
+   */
+  int getObjectCollisionMask(const int physObjectID) const {
+    assertIDValidity(physObjectID);
+    return existingObjects_.at(physObjectID)->getCollisionMask();
+  }
+
   /**
    * @brief Set the stage to collidable or not.
    */
@@ -923,20 +1215,214 @@ class PhysicsManager {
    * @brief Cast a ray into the collision world and return a @ref RaycastResults
    * with hit information.
    *
-   * Note: not implemented here in default PhysicsManager as there are no
-   * collision objects without a simulation implementation.
+   * Note: the default PhysicsManager has no collision objects, the rays only
+   * hit the collision meshes of the stage, through a @ref geo::TriangleBVH
+   * built on the first cast. See @ref stageRayBvh().
    *
    * @param ray The ray to cast. Need not be unit length, but returned hit
    * distances will be in units of ray length.
    * @param maxDistance The maximum distance along the ray direction to search.
    * In units of ray length.
+   * @param closestHitOnly Whether to only report the closest hit, which is
+   * cheaper than collecting and sorting all hits.
+   * @param collisionFilterMask The @ref CollisionGroup values the ray hits.
    * @return The raycast results sorted by distance.
    */
-  virtual RaycastResults castRay(const esp::geo::Ray& ray,
-                                 CORRADE_UNUSED double maxDistance = 100.0) {
-    RaycastResults results;
-    results.ray = ray;
-    return results;
+  virtual RaycastResults castRay(
+      const esp::geo::Ray& ray,
+      double maxDistance = 100.0,
+      bool closestHitOnly = false,
+      int collisionFilterMask = int(CollisionGroup::ALL));
+
+  /**
+   * @brief Cast a batch of rays into the collision world, as many @ref
+   * castRay() calls but in parallel and without a result object per ray.
+   *
+   * Note: the default PhysicsManager only hits the stage, as @ref castRay().
+   *
+   * @param rays The rays to cast. Need not be unit length, but returned hit
+   * distances will be in units of ray length. Rays of zero length have no
+   * hits.
+   * @param maxDistance The maximum distance along the ray directions to
+   * search. In units of ray length.
+   * @param closestHitOnly Whether to only report the closest hit of each ray.
+   * @param collisionFilterMask The @ref CollisionGroup values the rays hit.
+   * @return The hits of all rays, each ray's sorted by distance.
+   */
+  virtual MultiRaycastResults castRays(
+      const std::vector<esp::geo::Ray>& rays,
+      double maxDistance = 100.0,
+      bool closestHitOnly = false,
+      int collisionFilterMask = int(CollisionGroup::ALL));
+
+  /**
+   * @brief The objects whose bounding box overlaps a box, from the
+   * broadphase alone, without testing their collision shapes.
+   *
+   * Note: not implemented here in default PhysicsManager as there are no
+   * collision objects, nothing overlaps.
+   *
+   * @param aabb The box, in world space.
+   * @param collisionFilterMask The @ref CollisionGroup values included.
+   * @return The ids of the objects, sorted and each once, -1 for the stage.
+   */
+  virtual std::vector<int> overlapAabb(
+      CORRADE_UNUSED const Magnum::Range3D& aabb,
+      CORRADE_UNUSED int collisionFilterMask = int(CollisionGroup::ALL)) {
+    return {};
+  }
+
+  /**
+   * @brief The objects whose bounding box overlaps a sphere, as @ref
+   * overlapAabb().
+   */
+  virtual std::vector<int> overlapSphere(
+      CORRADE_UNUSED const Magnum::Vector3& center,
+      CORRADE_UNUSED float radius,
+      CORRADE_UNUSED int collisionFilterMask = int(CollisionGroup::ALL)) {
+    return {};
+  }
+
+  /**
+   * @brief The objects whose bounding box overlaps an oriented box, as @ref
+   * overlapAabb().
+   */
+  virtual std::vector<int> overlapObb(
+      CORRADE_UNUSED const geo::OBB& obb,
+      CORRADE_UNUSED int collisionFilterMask = int(CollisionGroup::ALL)) {
+    return {};
+  }
+
+  /**
+   * @brief @ref contactTest() of a batch of objects, sharing the update of
+   * the collision world.
+   *
+   * Note: not implemented here in default PhysicsManager, no object is in
+   * contact.
+   *
+   * @param physObjectIDs The objects.
+   * @return Whether each object is in contact with any other collision
+   * enabled object.
+   */
+  virtual std::vector<bool> contactTests(
+      const std::vector<int>& physObjectIDs) {
+    return std::vector<bool>(physObjectIDs.size(), false);
+  }
+
+  /**
+   * @brief Whether an object would be in contact with any other collision
+   * enabled object at each of a batch of transformations, without moving it.
+   *
+   * Places a probe sharing the collision shape of the object instead of
+   * the object, so that the candidate poses of a placement sampler need no
+   * added or removed bodies. The object itself is ignored.
+   *
+   * Note: not implemented here in default PhysicsManager, no pose is in
+   * contact.
+   *
+   * @param physObjectID The object ID and key identifying the object in @ref
+   * PhysicsManager::existingObjects_.
+   * @param transformations The candidate transformations of the object's
+   * root node, in world space, without scaling.
+   * @return Whether the object is in contact at each transformation.
+   */
+  virtual std::vector<bool> testPlacements(
+      CORRADE_UNUSED int physObjectID,
+      const std::vector<Magnum::Matrix4>& transformations) {
+    return std::vector<bool>(transformations.size(), false);
+  }
+
+  /**
+   * @brief Sweep the collision shape of an object along a straight path and
+   * return its first hit, without moving it, e.g. to check that a grasped
+   * object can be carried from A to B.
+   *
+   * @param physObjectID The object ID and key identifying the object in @ref
+   * PhysicsManager::existingObjects_.
+   * @param from The transformation of the object's root node at the start.
+   * @param to The translation of the object's root node at the end, the
+   * rotation stays that of @p from.
+   * @param collisionFilterMask The @ref CollisionGroup values the object
+   * hits. The object itself is ignored.
+   * @return The first hit.
+   */
+  SweepResult sweepObject(
+      int physObjectID,
+      const Magnum::Matrix4& from,
+      const Magnum::Vector3& to,
+      int collisionFilterMask = int(CollisionGroup::ALL)) {
+    return sweepObjectBatch(physObjectID, {from}, {to}, collisionFilterMask)
+        .front();
+  }
+
+  /**
+   * @brief @ref sweepObject() along a batch of paths, in parallel.
+   *
+   * Note: not implemented here in default PhysicsManager as there are no
+   * collision objects without a simulation implementation, nothing is hit.
+   *
+   * @param physObjectID The object ID and key identifying the object in @ref
+   * PhysicsManager::existingObjects_.
+   * @param from The transformations of the object's root node at the start
+   * of each path.
+   * @param to The translations of the object's root node at the end of each
+   * path, as many as @p from.
+   * @param collisionFilterMask The @ref CollisionGroup values the object
+   * hits.
+   * @return The first hit of each path.
+   */
+  virtual std::vector<SweepResult> sweepObjectBatch(
+      CORRADE_UNUSED int physObjectID,
+      const std::vector<Magnum::Matrix4>& from,
+      CORRADE_UNUSED const std::vector<Magnum::Vector3>& to,
+      CORRADE_UNUSED int collisionFilterMask = int(CollisionGroup::ALL)) {
+    return std::vector<SweepResult>(from.size());
+  }
+
+  /**
+   * @brief Sweep an upright capsule along a straight path and return its
+   * first hit, e.g. to check that an agent can move from A to B.
+   *
+   * @param radius The radius of the capsule.
+   * @param height The height of the capsule, caps included, at least twice
+   * its radius.
+   * @param from The center of the capsule at the start.
+   * @param to The center of the capsule at the end.
+   * @param collisionFilterMask The @ref CollisionGroup values the capsule
+   * hits.
+   * @return The first hit.
+   */
+  SweepResult sweepCapsule(
+      float radius,
+      float height,
+      const Magnum::Vector3& from,
+      const Magnum::Vector3& to,
+      int collisionFilterMask = int(CollisionGroup::ALL)) {
+    return sweepCapsuleBatch(radius, height, {from}, {to}, collisionFilterMask)
+        .front();
+  }
+
+  /**
+   * @brief @ref sweepCapsule() along a batch of paths, in parallel.
+   *
+   * Note: not implemented here in default PhysicsManager, nothing is hit.
+   *
+   * @param radius The radius of the capsule.
+   * @param height The height of the capsule, caps included.
+   * @param from The centers of the capsule at the start of each path.
+   * @param to The centers of the capsule at the end of each path, as many as
+   * @p from.
+   * @param collisionFilterMask The @ref CollisionGroup values the capsule
+   * hits.
+   * @return The first hit of each path.
+   */
+  virtual std::vector<SweepResult> sweepCapsuleBatch(
+      CORRADE_UNUSED float radius,
+      CORRADE_UNUSED float height,
+      const std::vector<Magnum::Vector3>& from,
+      CORRADE_UNUSED const std::vector<Magnum::Vector3>& to,
+      CORRADE_UNUSED int collisionFilterMask = int(CollisionGroup::ALL)) {
+    return std::vector<SweepResult>(from.size());
   }
 
   virtual int getNumActiveContactPoints() { return -1; }
@@ -993,6 +1479,30 @@ class PhysicsManager {
 
   virtual bool addStageFinalize(const std::string& handle);
 
+  /**
+   * @brief The hierarchy of the triangles of the stage collision meshes the
+   * rays of the default PhysicsManager hit, built on the first call.
+   *
+   * @param collisionFilterMask The @ref CollisionGroup values the rays hit.
+   * @return nullptr if the rays don't hit the stage, e.g. it's filtered out,
+   * not collidable or has no collision mesh.
+   */
+  const geo::TriangleBVH* stageRayBvh(int collisionFilterMask);
+
+  /**
+   * @brief Finalize the restoration of a state by @ref deserializeState.
+   * Overidden by derived physics implementations to drop the cached contacts
+   * and forces of the objects, which belong to the state before.
+   */
+  virtual void deserializeStateFinalize() {}
+
+  /**
+   * @brief Hash the state the physics engine steps, seeding the hash of
+   * @ref getStateChecksum. Overridden by derived physics implementations
+   * whose state isn't all in the scene nodes and velocities.
+   */
+  virtual std::uint64_t hashEngineState() const { return 0; }
+
   /** @brief Create and initialize a @ref RigidObject, assign it an ID and add
    * it to existingObjects_ map keyed with newObjectID
    * @param newObjectID valid object ID for the new object
@@ -1007,6 +1517,28 @@ class PhysicsManager {
                                      const std::string& handle,
                                      scene::SceneNode* objectNode);
 
+  //! An object removed with @ref removeObject, kept for reuse
+  struct PooledObject {
+    physics::RigidObject::uptr object;
+    //! The light setup of its drawables
+    std::string lightSetup;
+    //! Its drawables, out of any group until it's reactivated
+    std::vector<gfx::Drawable*> drawables;
+  };
+
+  /** @brief Reactivate an object of the template and light setup from the
+   * @ref objectPool_, dropping the objects of a template registered again
+   * since they were removed.
+   * @return The new ID of the object, or @ref esp::ID_UNDEFINED if there is
+   * none in the pool.
+   */
+  int reactivatePooledObject(const std::string& handle,
+                             DrawableGroup* drawables,
+                             const std::string& lightSetup);
+
+  /** @brief Delete a pooled object and its node. */
+  void deletePooledObject(PooledObject& pooled);
+
   /** @brief A reference to a @ref esp::assets::ResourceManager which holds
    * assets that can be accessed by this @ref PhysicsManager*/
   assets::ResourceManager& resourceManager_;
@@ -1039,6 +1571,32 @@ class PhysicsManager {
    * */
   physics::RigidStage::uptr staticStageObject_ = nullptr;
 
+  //! Whether @ref addStage() was given collision meshes
+  bool stageHasCollisionMeshes_ = false;
+
+  //! See @ref stageRayBvh()
+  geo::TriangleBVH::uptr stageRayBvh_;
+
+  /** @brief Add @p dt to the @ref pendingTime_ and take out the fixed steps
+   * it makes, at most @ref maxSubsteps_. See @ref setSkipIfBehind.
+   * @return The number of fixed steps to take
+   */
+  int takeSubsteps(double dt);
+
+  /** @brief The time moving objects are drawn at after the @ref worldTime_,
+   * negative with @ref renderInterpolation_ */
+  double getRenderTimeOffset() const;
+
+  /** @brief Move the kinematic objects under velocity control drawn at
+   * @ref getRenderTime() back to their simulated states, unless they were
+   * moved since. Called before stepping. */
+  void restoreDrawnStates();
+
+  /** @brief Draw the kinematic objects under velocity control at
+   * @ref getRenderTime(), predicted from their velocity. Called after
+   * stepping. */
+  void drawAtRenderTime();
+
   //! ==== Rigid object memory management ====
 
   /** @brief Maps object IDs to all existing physical object instances in the
@@ -1046,6 +1604,25 @@ class PhysicsManager {
    */
   std::map<int, physics::RigidObject::uptr> existingObjects_;
 
+  /** @brief IDs of the objects whose @ref VelocityControl was handed out by
+   * @ref getVelocityControl, the others can't be controlled. Steps only visit
+   * these, so their cost doesn't grow with the number of other objects.
+   */
+  std::set<int> velControlledObjectIDs_;
+
+  /** @brief The objects deactivated by @ref removeObject by template handle,
+   * the most recently removed last. See @ref setObjectPoolSize.
+   */
+  std::map<std::string, std::vector<PooledObject>> objectPool_;
+
+  //! See @ref setObjectPoolSize
+  int objectPoolSize_ = 0;
+
+  /** @brief The light setups of the objects @ref addObject made the node of,
+   * the only ones pooled by @ref removeObject.
+   */
+  std::map<int, std::string> poolableObjectLightSetups_;
+
   /** @brief A counter of unique object ID's allocated thus far. Used to
    * allocate new IDs when  @ref recycledObjectIDs_ is empty without needing to
    * check @ref existingObjects_ explicitly.*/
@@ -1057,6 +1634,12 @@ class PhysicsManager {
    * allocateObjectID before new IDs are acquired with @ref nextObjectID_. */
   std::vector<int> recycledObjectIDs_;
 
+  //! States saved by @ref saveState, by handle
+  std::map<int, std::string> savedStates_;
+
+  //! The handle of the next state saved by @ref saveState
+  int nextStateHandle_ = 0;
+
   //! Utilities
 
   /** @brief Tracks whether or not this @ref PhysicsManager has already been
@@ -1072,6 +1655,32 @@ class PhysicsManager {
    * simulated with @ref stepPhysics up to this point. */
   double worldTime_ = 0.0;
 
+  /** @brief The time requested from @ref stepPhysics and not simulated yet,
+   * less than a fixed step unless catching up. See @ref takeSubsteps. */
+  double pendingTime_ = 0.0;
+
+  //! See @ref setMaxSubsteps
+  int maxSubsteps_ = 0;
+
+  //! See @ref setSkipIfBehind
+  bool skipIfBehind_ = true;
+
+  //! See @ref setRenderInterpolation
+  bool renderInterpolation_ = false;
+
+  //! See @ref isDeterministic
+  bool deterministic_ = false;
+
+  //! The states of an object moved by @ref stepPhysics and drawn
+  struct DrawnState {
+    core::RigidState simulated;
+    core::RigidState drawn;
+  };
+
+  /** @brief The kinematic objects under velocity control drawn at
+   * @ref getRenderTime() rather than at their simulated state, by ID */
+  std::map<int, DrawnState> drawnStates_;
+
   ESP_SMART_POINTERS(PhysicsManager)
 };
 
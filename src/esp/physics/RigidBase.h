@@ -67,6 +67,29 @@ enum class MotionType {
 
 };
 
+/**
+ * @brief Collision groups of the bodies in the collision world. Raycasts only
+ * hit the groups in their collision filter mask, a combination of these, and
+ * two bodies only collide if each one's group is in the mask of the other,
+ * see @ref RigidObject::setCollisionFilter(). @ref DEFAULT, @ref STATIC and
+ * @ref DEBRIS are Bullet's DefaultFilter, StaticFilter and DebrisFilter. The
+ * values up to 1 << 30 not used here are free for custom groups.
+ */
+enum class CollisionGroup : int {
+  //! Dynamic objects.
+  DEFAULT = 1,
+  //! Static and kinematic objects.
+  STATIC = 2,
+  //! Dynamic objects colliding with the static environment only, i.e. with
+  //! @ref STATIC and @ref STAGE, e.g. clutter, so that pile-ups of them
+  //! generate no contacts among each other.
+  DEBRIS = 8,
+  //! The stage.
+  STAGE = 64,
+  //! All groups, as a collision filter mask.
+  ALL = -1,
+};
+
 class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
  public:
   RigidBase(scene::SceneNode* rigidBodyNode,
@@ -164,6 +187,12 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
    */
   virtual void setActive() {}
 
+  /**
+   * @brief Put an object to sleep until a collision or a change wakes it.
+   * Only derived dynamics implementations have sleeping objects.
+   */
+  virtual void setSleeping() {}
+
   /**
    * @brief Get the @ref MotionType of the object. See @ref setMotionType.
    * @return The object's current @ref MotionType.
@@ -319,8 +348,11 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
    * @brief Set the rotation and translation of the object.
    */
   virtual void setRigidState(const core::RigidState& rigidState) {
-    setTranslation(rigidState.translation);
-    setRotation(rigidState.rotation);
+    if (objectMotionType_ != MotionType::STATIC) {
+      node().setTranslation(rigidState.translation);
+      node().setRotation(rigidState.rotation);
+      syncPose();
+    }
   };
 
   /**
@@ -609,7 +641,18 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
     if (!initializationAttributes_) {
       return nullptr;
     }
-    return T::create(*(static_cast<T*>(initializationAttributes_.get())));
+    return T::create(
+        *(static_cast<const T*>(initializationAttributes_.get())));
+  }
+
+  /**
+   * @brief Get the template used to initialize this object or scene, shared
+   * with the library without copying it.
+   * @return The initialization template, or nullptr if no template exists.
+   */
+  template <class T>
+  std::shared_ptr<const T> getInitializationAttributesShared() const {
+    return std::static_pointer_cast<const T>(initializationAttributes_);
   }
 
   /** @brief Store whatever object attributes you want here! */
@@ -647,14 +690,20 @@ class RigidBase : public Magnum::SceneGraph::AbstractFeature3D {
   bool isCollidable_ = false;
 
   /**
-   * @brief Saved attributes when the object was initialized.
+   * @brief Saved attributes when the object was initialized. Shared with the
+   * attributes library, which replaces rather than modifies the templates it
+   * holds, so these stay as they were at initialization.
    */
-  metadata::attributes::AbstractObjectAttributes::ptr
+  metadata::attributes::AbstractObjectAttributes::cptr
       initializationAttributes_ = nullptr;
 
   //! Access for the object to its own PhysicsManager id. Scene will keep -1.
   int objectId_ = -1;
 
+  //! Keeps the collision asset loaded while the object or scene collides
+  //! with it, see @ref assets::ResourceManager::evictUnusedAssets()
+  assets::ResourceManager::AssetReference collisionAssetReference_;
+
   //! Reference to the ResourceManager for internal access to the object's asset
   //! data.
   const assets::ResourceManager& resMgr_;
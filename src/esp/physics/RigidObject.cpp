@@ -20,9 +20,14 @@ bool RigidObject::initialize(const std::string& handle) {
     return false;
   }
 
-  // save a copy of the template at initialization time
+  // share the template at initialization time, later registrations under the
+  // handle replace it in the library rather than changing it
   initializationAttributes_ =
-      resMgr_.getObjectAttributesManager()->getObjectCopyByHandle(handle);
+      resMgr_.getObjectAttributesManager()->getObjectSharedByHandle(handle);
+  if (initializationAttributes_) {
+    collisionAssetReference_ = resMgr_.acquireAsset(
+        initializationAttributes_->getCollisionAssetHandle());
+  }
 
   return initialization_LibSpecific();
 }  // RigidObject::initialize
@@ -56,9 +61,52 @@ bool RigidObject::finalizeObject() {
 bool RigidObject::initialization_LibSpecific() {
   // default kineamtic unless a simulator is initialized...
   objectMotionType_ = MotionType::KINEMATIC;
+  setCollisionFilterFromTemplate();
   return true;
 }  // RigidObject::initialization_LibSpecific
 
+void RigidObject::reactivate(const int objectId) {
+  objectId_ = objectId;
+  *velControl_ = VelocityControl{};
+  objectMotionType_ = MotionType::KINEMATIC;
+  node().resetTransformation();
+  setSemanticId(getInitializationAttributesShared()->getSemanticId());
+  setCollisionFilterFromTemplate();
+}
+
+void RigidObject::setCollisionFilterFromTemplate() {
+  auto tmpAttr = getInitializationAttributesShared();
+  collisionGroup_ = tmpAttr->getCollisionGroup();
+  collisionMask_ = tmpAttr->getCollisionMask();
+  if (tmpAttr->getStaticEnvironmentOnly() && !collisionGroup_ &&
+      !collisionMask_) {
+    collisionGroup_ = int(CollisionGroup::DEBRIS);
+    collisionMask_ = int(CollisionGroup::STATIC) | int(CollisionGroup::STAGE);
+  }
+}
+
+int RigidObject::getCollisionGroup() const {
+  if (collisionGroup_) {
+    return collisionGroup_;
+  }
+  return objectMotionType_ == MotionType::DYNAMIC ? int(CollisionGroup::DEFAULT)
+                                                  : int(CollisionGroup::STATIC);
+}
+
+int RigidObject::getCollisionMask() const {
+  if (collisionMask_) {
+    return collisionMask_;
+  }
+  switch (objectMotionType_) {
+    case MotionType::DYNAMIC:
+      return int(CollisionGroup::ALL);
+    case MotionType::KINEMATIC:
+      return int(CollisionGroup::ALL) & ~int(CollisionGroup::STATIC);
+    default:
+      return int(CollisionGroup::ALL) & ~int(CollisionGroup::STAGE);
+  }
+}
+
 bool RigidObject::setMotionType(MotionType mt) {
   if (mt != MotionType::DYNAMIC) {
     objectMotionType_ = mt;
@@ -93,7 +141,7 @@ core::RigidState VelocityControl::integrateTransform(
       globalAngVel = rigidState.rotation.transformVector(angVel);
     }
     Magnum::Quaternion q = Magnum::Quaternion::rotation(
-        Magnum::Rad{(globalAngVel * dt).length()}, globalAngVel.normalized());
+        Magnum::Rad{globalAngVel.length() * dt}, globalAngVel.normalized());
     newRigidState.rotation = (q * rigidState.rotation).normalized();
   }
   return newRigidState;
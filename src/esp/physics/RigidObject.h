@@ -66,7 +66,8 @@ struct VelocityControl {
    * For efficiency this function does not support transforms with scaling.
    *
    * Default implementation uses explicit Euler integration.
-   * @param dt The discrete timestep over which to integrate.
+   * @param dt The discrete timestep over which to integrate, negative to
+   * integrate backward.
    * @param objectRotationTranslation The initial state of the object before
    * applying velocity control.
    * @return The new state of the object after applying velocity control over
@@ -132,6 +133,16 @@ class RigidObject : public RigidBase {
         metadata::attributes::ObjectAttributes>();
   };
 
+  /**
+   * @brief Get the template used to initialize this object, without copying
+   * it. For read-only use.
+   */
+  metadata::attributes::ObjectAttributes::cptr
+  getInitializationAttributesShared() const {
+    return RigidBase::getInitializationAttributesShared<
+        metadata::attributes::ObjectAttributes>();
+  }
+
  private:
   /**
    * @brief Finalize the initialization of this @ref RigidScene
@@ -170,7 +181,66 @@ class RigidObject : public RigidBase {
    */
   VelocityControl::ptr getVelocityControl() { return velControl_; };
 
+  /**
+   * @brief Take the object out of the simulation, to keep it in the object
+   * pool of its @ref PhysicsManager until @ref reactivate(). Overridden by
+   * inheriting classes to remove it from the world of their physics library.
+   */
+  virtual void deactivate() {}
+
+  /**
+   * @brief Bring an object taken out by @ref deactivate() back as a new
+   * instance of its template: with a new ID, at the origin, at rest, without
+   * velocity control and with the motion type and semantic id of the
+   * template. Inheriting classes also restore the collidability, mass,
+   * inertia, friction, restitution and damping of the template.
+   * @param objectId The new ID of the object.
+   */
+  virtual void reactivate(int objectId);
+
+  /**
+   * @brief Set the @ref CollisionGroup of the object and the groups it
+   * collides with. Two bodies collide only if each one's group is in the
+   * mask of the other, e.g. @ref CollisionGroup::DEBRIS with
+   * @ref CollisionGroup::STATIC | @ref CollisionGroup::STAGE only collides
+   * with the static environment. Raycasts hit the object if its group is in
+   * their mask.
+   * @param group The group, 0 for the default of the motion type.
+   * @param mask The groups collided with, 0 for the default of the motion
+   * type.
+   * @return Whether the filter was set, only if a dynamics library is in use.
+   */
+  virtual bool setCollisionFilter(CORRADE_UNUSED int group,
+                                  CORRADE_UNUSED int mask) {
+    return false;
+  }
+
+  /**
+   * @brief The collision group of the object, the default of its motion type
+   * if none is set: @ref CollisionGroup::DEFAULT for dynamic objects,
+   * @ref CollisionGroup::STATIC otherwise.
+   */
+  int getCollisionGroup() const;
+
+  /**
+   * @brief The groups the object collides with, the default of its motion
+   * type if none is set: all groups for dynamic objects, all but
+   * @ref CollisionGroup::STATIC for kinematic ones and all but
+   * @ref CollisionGroup::STAGE for static ones.
+   */
+  int getCollisionMask() const;
+
  protected:
+  /**
+   * @brief Set the collision filter of the template, see
+   * @ref metadata::attributes::ObjectAttributes::getStaticEnvironmentOnly()
+   */
+  void setCollisionFilterFromTemplate();
+
+  //! See @ref setCollisionFilter(), 0 for the defaults
+  int collisionGroup_ = 0;
+  int collisionMask_ = 0;
+
   /**
    * @brief Convenience variable: specifies a constant control velocity (linear
    * | angular) applied to the rigid body before each step.
@@ -18,7 +18,11 @@ bool RigidStage::initialize(const std::string& handle) {
   }
   objectMotionType_ = MotionType::STATIC;
   initializationAttributes_ =
-      resMgr_.getStageAttributesManager()->getObjectCopyByHandle(handle);
+      resMgr_.getStageAttributesManager()->getObjectSharedByHandle(handle);
+  if (initializationAttributes_) {
+    collisionAssetReference_ = resMgr_.acquireAsset(
+        initializationAttributes_->getCollisionAssetHandle());
+  }
 
   return initialization_LibSpecific();
 }
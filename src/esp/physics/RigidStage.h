@@ -43,6 +43,16 @@ class RigidStage : public RigidBase {
     return RigidBase::getInitializationAttributes<
         metadata::attributes::StageAttributes>();
   };
+
+  /**
+   * @brief Get the template used to initialize this stage object, without
+   * copying it. For read-only use.
+   */
+  metadata::attributes::StageAttributes::cptr
+  getInitializationAttributesShared() const {
+    return RigidBase::getInitializationAttributesShared<
+        metadata::attributes::StageAttributes>();
+  }
   /**
    * @brief Finalize the creation of this @ref RigidStage
    * @return whether successful finalization.
@@ -8,7 +8,6 @@
 #include <Magnum/BulletIntegration/MotionState.h>
 #include <btBulletDynamicsCommon.h>
 
-#include "BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h"
 #include "esp/assets/Asset.h"
 #include "esp/assets/BaseMesh.h"
 #include "esp/assets/MeshMetaData.h"
@@ -63,7 +62,7 @@ struct SimulationContactResultCallback
 
 class BulletBase {
  public:
-  BulletBase(std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+  BulletBase(std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
              std::shared_ptr<std::map<const btCollisionObject*, int>>
                  collisionObjToObjIds)
       : bWorld_(bWorld), collisionObjToObjIds_(collisionObjToObjIds) {}
@@ -94,8 +93,8 @@ class BulletBase {
 
  protected:
   /** @brief A pointer to the Bullet world to which this object belongs. See
-   * @ref btMultiBodyDynamicsWorld.*/
-  std::shared_ptr<btMultiBodyDynamicsWorld> bWorld_;
+   * @ref btDiscreteDynamicsWorld.*/
+  std::shared_ptr<btDiscreteDynamicsWorld> bWorld_;
 
   /** @brief Static data: All components of a @ref RigidObjectType::SCENE are
    * stored here. Also, all objects set to STATIC are stored here.
@@ -0,0 +1,387 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "BulletConvexDecomposition.h"
+
+#include <Magnum/BulletIntegration/Integration.h>
+#include <Magnum/Math/Functions.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+#include "LinearMath/btConvexHullComputer.h"
+
+#include "esp/core/ThreadPool.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace physics {
+
+namespace {
+
+const int HULLS_MAGIC = 'H' << 24 | 'U' << 16 | 'L' << 8 | 'L';  //'HULL';
+const int HULLS_VERSION = 1;
+
+struct HullsHeader {
+  int magic;
+  int version;
+  int numHulls;
+};
+
+// Dense voxel grid over the mesh bounds, with a padding voxel on each side so
+// the outside connects around the mesh
+struct VoxelGrid {
+  Mn::Vector3 origin;
+  float size = 1.0f;
+  Mn::Vector3i dims;
+
+  int index(const Mn::Vector3i& v) const {
+    return (v.z() * dims.y() + v.y()) * dims.x() + v.x();
+  }
+  Mn::Vector3i voxel(const Mn::Vector3& point) const {
+    return Mn::Vector3i{Mn::Math::floor((point - origin) / size)};
+  }
+  Mn::Vector3 corner(const Mn::Vector3i& v) const {
+    return origin + Mn::Vector3{v} * size;
+  }
+  int count() const { return dims.product(); }
+};
+
+const Mn::Vector3i NEIGHBORS[]{{1, 0, 0},  {-1, 0, 0}, {0, 1, 0},
+                               {0, -1, 0}, {0, 0, 1},  {0, 0, -1}};
+
+// Calls visit with points of triangle abc at most spacing apart, including
+// its vertices
+template <class F>
+void sampleTriangle(const Mn::Vector3& a,
+                    const Mn::Vector3& b,
+                    const Mn::Vector3& c,
+                    float spacing,
+                    F visit) {
+  const float longest =
+      std::max({(b - a).length(), (c - a).length(), (c - b).length()});
+  const int n = std::max(1, int(std::ceil(longest / spacing)));
+  for (int i = 0; i <= n; ++i) {
+    for (int j = 0; j <= n - i; ++j) {
+      visit(a + (b - a) * (float(i) / n) + (c - a) * (float(j) / n));
+    }
+  }
+}
+
+// Volume of the convex hull of points, with the hull vertices in vertices if
+// not null
+double hullVolume(const std::vector<Mn::Vector3>& points,
+                  std::vector<Mn::Vector3>* vertices = nullptr) {
+  if (points.empty()) {
+    return 0.0;
+  }
+  btConvexHullComputer hull;
+  hull.compute(points.data()->data(), sizeof(Mn::Vector3), int(points.size()),
+               0.0f, 0.0f);
+  if (vertices) {
+    vertices->clear();
+    for (int i = 0; i < hull.vertices.size(); ++i) {
+      vertices->emplace_back(hull.vertices[i]);
+    }
+  }
+
+  // sum of the tetrahedra between the origin and a fan of every face
+  double volume = 0.0;
+  for (int f = 0; f < hull.faces.size(); ++f) {
+    const btConvexHullComputer::Edge* first = &hull.edges[hull.faces[f]];
+    const btVector3& a = hull.vertices[first->getSourceVertex()];
+    for (const btConvexHullComputer::Edge* edge = first->getNextEdgeOfFace();
+         edge->getTargetVertex() != first->getSourceVertex();
+         edge = edge->getNextEdgeOfFace()) {
+      const btVector3& b = hull.vertices[edge->getSourceVertex()];
+      const btVector3& c = hull.vertices[edge->getTargetVertex()];
+      volume += a.dot(b.cross(c));
+    }
+  }
+  return std::abs(volume) / 6.0;
+}
+
+// Voxels of the mesh, the ones labeled with one part are split by planes
+// perpendicular to the axes
+class Decomposer {
+ public:
+  Decomposer(const VoxelGrid& grid, std::vector<int> labels)
+      : grid_(grid), labels_(std::move(labels)) {}
+
+  // Empty volume of the hull of the voxels of part on the side of the plane
+  // where coordinate axis of the voxels is below plane if below, or not
+  double concavity(const std::vector<Mn::Vector3i>& part,
+                   int label,
+                   int axis,
+                   int plane,
+                   bool below) const {
+    auto inside = [&](const Mn::Vector3i& v) {
+      return labels_[grid_.index(v)] == label && (v[axis] < plane) == below;
+    };
+    std::vector<Mn::Vector3> corners;
+    std::size_t numVoxels = 0;
+    for (const Mn::Vector3i& v : part) {
+      if (!inside(v)) {
+        continue;
+      }
+      ++numVoxels;
+      // the hull is spanned by the voxels with an outside neighbor
+      bool boundary = false;
+      for (const Mn::Vector3i& n : NEIGHBORS) {
+        boundary = boundary || !inside(v + n);
+      }
+      if (boundary) {
+        for (int c = 0; c < 8; ++c) {
+          corners.push_back(
+              grid_.corner(v + Mn::Vector3i{c & 1, (c >> 1) & 1, c >> 2}));
+        }
+      }
+    }
+    const double voxelVolume = double(grid_.size) * grid_.size * grid_.size;
+    return std::max(0.0, hullVolume(corners) - numVoxels * voxelVolume);
+  }
+
+  // Empty volume of the hull of all the voxels of part
+  double concavity(const std::vector<Mn::Vector3i>& part, int label) const {
+    return concavity(part, label, 0, grid_.dims.x(), true);
+  }
+
+  // Splits part in two at the plane reducing the empty volume the most,
+  // returns false if part is a single voxel wide
+  bool split(std::vector<Mn::Vector3i>& part,
+             int label,
+             int newLabel,
+             std::vector<Mn::Vector3i>& newPart) {
+    struct Candidate {
+      int axis;
+      int plane;
+      double cost;
+    };
+    std::vector<Candidate> candidates;
+    const int planesPerAxis = 8;
+    for (int axis = 0; axis < 3; ++axis) {
+      int lo = std::numeric_limits<int>::max();
+      int hi = std::numeric_limits<int>::min();
+      for (const Mn::Vector3i& v : part) {
+        lo = std::min(lo, v[axis]);
+        hi = std::max(hi, v[axis]);
+      }
+      // planes between voxels lo and hi, spread evenly
+      const int numPlanes = std::min(planesPerAxis, hi - lo);
+      for (int i = 0; i < numPlanes; ++i) {
+        candidates.push_back(
+            {axis, lo + 1 + (hi - lo - 1) * (2 * i + 1) / (2 * numPlanes), 0});
+      }
+    }
+    if (candidates.empty()) {
+      return false;
+    }
+
+    core::ThreadPool& pool = core::ThreadPool::shared();
+    pool.parallelFor(candidates.size(), pool.numThreads() + 1,
+                     [&](const std::size_t i, std::size_t) {
+                       Candidate& candidate = candidates[i];
+                       candidate.cost =
+                           concavity(part, label, candidate.axis,
+                                     candidate.plane, true) +
+                           concavity(part, label, candidate.axis,
+                                     candidate.plane, false);
+                     });
+    const Candidate& best = *std::min_element(
+        candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+
+    std::vector<Mn::Vector3i> kept;
+    for (const Mn::Vector3i& v : part) {
+      if (v[best.axis] < best.plane) {
+        kept.push_back(v);
+      } else {
+        newPart.push_back(v);
+        labels_[grid_.index(v)] = newLabel;
+      }
+    }
+    part = std::move(kept);
+    return true;
+  }
+
+  int label(const Mn::Vector3i& v) const { return labels_[grid_.index(v)]; }
+
+ private:
+  const VoxelGrid& grid_;
+  // the part of every voxel, -1 outside of the mesh
+  std::vector<int> labels_;
+};
+
+}  // namespace
+
+ConvexDecomposition decomposeConvex(
+    const std::vector<Mn::Vector3>& positions,
+    const std::vector<Mn::UnsignedInt>& indices,
+    const ConvexDecompositionSettings& settings) {
+  if (positions.empty() || indices.size() < 3) {
+    return {};
+  }
+
+  Mn::Vector3 min = positions[0];
+  Mn::Vector3 max = positions[0];
+  for (const Mn::Vector3& p : positions) {
+    min = Mn::Math::min(min, p);
+    max = Mn::Math::max(max, p);
+  }
+  VoxelGrid grid;
+  grid.size = std::max((max - min).max() / std::max(settings.resolution, 1),
+                       std::numeric_limits<float>::epsilon());
+  grid.origin = min - Mn::Vector3{grid.size};
+  grid.dims = Mn::Vector3i{Mn::Math::floor((max - min) / grid.size)} + 3;
+
+  auto forEachSample = [&](auto visit) {
+    for (std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+      sampleTriangle(positions[indices[t]], positions[indices[t + 1]],
+                     positions[indices[t + 2]], 0.5f * grid.size, visit);
+    }
+  };
+
+  // voxels on the surface, then the ones not reachable from the padding
+  // without crossing it
+  enum : char { Empty, Surface, Outside };
+  std::vector<char> voxels(grid.count(), Empty);
+  forEachSample([&](const Mn::Vector3& point) {
+    voxels[grid.index(grid.voxel(point))] = Surface;
+  });
+  std::vector<Mn::Vector3i> stack{Mn::Vector3i{0}};
+  voxels[0] = Outside;
+  while (!stack.empty()) {
+    const Mn::Vector3i v = stack.back();
+    stack.pop_back();
+    for (const Mn::Vector3i& n : NEIGHBORS) {
+      const Mn::Vector3i neighbor = v + n;
+      if ((neighbor >= Mn::Vector3i{0}).all() &&
+          (neighbor < grid.dims).all() &&
+          voxels[grid.index(neighbor)] == Empty) {
+        voxels[grid.index(neighbor)] = Outside;
+        stack.push_back(neighbor);
+      }
+    }
+  }
+
+  std::vector<std::vector<Mn::Vector3i>> parts(1);
+  std::vector<int> labels(grid.count(), -1);
+  for (int z = 0; z < grid.dims.z(); ++z) {
+    for (int y = 0; y < grid.dims.y(); ++y) {
+      for (int x = 0; x < grid.dims.x(); ++x) {
+        const Mn::Vector3i v{x, y, z};
+        if (voxels[grid.index(v)] != Outside) {
+          parts[0].push_back(v);
+          labels[grid.index(v)] = 0;
+        }
+      }
+    }
+  }
+
+  // split the most concave part until all are convex enough
+  Decomposer decomposer{grid, std::move(labels)};
+  std::vector<double> concavities{
+      decomposer.concavity(parts[0], 0)};
+  std::vector<bool> splittable{true};
+  while (int(parts.size()) < settings.maxHulls) {
+    int worst = -1;
+    for (int i = 0; i < int(parts.size()); ++i) {
+      if (splittable[i] && (worst < 0 || concavities[i] > concavities[worst])) {
+        worst = i;
+      }
+    }
+    if (worst < 0) {
+      break;
+    }
+    const double voxelVolume = double(grid.size) * grid.size * grid.size;
+    const double volume = parts[worst].size() * voxelVolume;
+    if (concavities[worst] <=
+        settings.maxConcavity * (volume + concavities[worst])) {
+      splittable[worst] = false;
+      continue;
+    }
+
+    const int newLabel = parts.size();
+    std::vector<Mn::Vector3i> newPart;
+    if (!decomposer.split(parts[worst], worst, newLabel, newPart)) {
+      splittable[worst] = false;
+      continue;
+    }
+    parts.push_back(std::move(newPart));
+    concavities[worst] = decomposer.concavity(parts[worst], worst);
+    concavities.push_back(decomposer.concavity(parts.back(), newLabel));
+    splittable.push_back(true);
+  }
+
+  // the surface of the mesh in each part spans its hull
+  std::vector<std::vector<Mn::Vector3>> points(parts.size());
+  forEachSample([&](const Mn::Vector3& point) {
+    const int label = decomposer.label(grid.voxel(point));
+    if (label >= 0) {
+      points[label].push_back(point);
+    }
+  });
+  ConvexDecomposition hulls;
+  for (const std::vector<Mn::Vector3>& partPoints : points) {
+    if (partPoints.empty()) {
+      continue;
+    }
+    hulls.emplace_back();
+    hullVolume(partPoints, &hulls.back());
+  }
+  return hulls;
+}
+
+bool saveConvexDecomposition(const ConvexDecomposition& hulls,
+                             const std::string& filename) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  HullsHeader header{HULLS_MAGIC, HULLS_VERSION, int(hulls.size())};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const std::vector<Mn::Vector3>& hull : hulls) {
+    const int32_t numVertices = hull.size();
+    file.write(reinterpret_cast<const char*>(&numVertices),
+               sizeof(numVertices));
+    file.write(reinterpret_cast<const char*>(hull.data()),
+               hull.size() * sizeof(Mn::Vector3));
+  }
+  return bool(file);
+}
+
+bool loadConvexDecomposition(const std::string& filename,
+                             ConvexDecomposition& hulls) {
+  std::ifstream file(filename, std::ios::binary);
+  HullsHeader header{};
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.magic != HULLS_MAGIC || header.version != HULLS_VERSION ||
+      header.numHulls < 0) {
+    return false;
+  }
+  ConvexDecomposition loaded(header.numHulls);
+  for (std::vector<Mn::Vector3>& hull : loaded) {
+    int32_t numVertices = 0;
+    if (!file.read(reinterpret_cast<char*>(&numVertices),
+                   sizeof(numVertices)) ||
+        numVertices < 0) {
+      return false;
+    }
+    hull.resize(numVertices);
+    if (!file.read(reinterpret_cast<char*>(hull.data()),
+                   hull.size() * sizeof(Mn::Vector3))) {
+      return false;
+    }
+  }
+  hulls = std::move(loaded);
+  return true;
+}
+
+}  // namespace physics
+}  // namespace esp
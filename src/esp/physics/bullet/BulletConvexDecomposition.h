@@ -0,0 +1,86 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_PHYSICS_BULLET_BULLETCONVEXDECOMPOSITION_H_
+#define ESP_PHYSICS_BULLET_BULLETCONVEXDECOMPOSITION_H_
+
+/** @file
+ * @brief Struct @ref esp::physics::ConvexDecompositionSettings, functions
+ * @ref esp::physics::decomposeConvex(), @ref
+ * esp::physics::saveConvexDecomposition(), @ref
+ * esp::physics::loadConvexDecomposition()
+ */
+
+#include <string>
+#include <vector>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace physics {
+
+/** @brief Vertices of each convex hull of a decomposition */
+typedef std::vector<std::vector<Magnum::Vector3>> ConvexDecomposition;
+
+/** @brief Parameters of @ref decomposeConvex() */
+struct ConvexDecompositionSettings {
+  /** @brief Number of voxels along the longest side of the mesh bounds */
+  int resolution = 32;
+
+  /**
+   * @brief Parts whose hull exceeds their volume by at most this fraction of
+   * the hull volume are not split further
+   */
+  float maxConcavity = 0.05f;
+
+  /** @brief Maximum number of hulls */
+  int maxHulls = 16;
+};
+
+/**
+ * @brief Approximate a triangle mesh by a few convex hulls
+ *
+ * Like V-HACD, the mesh is voxelized and filled, then the part whose convex
+ * hull is the least filled by its voxels is split by the axis-aligned plane
+ * that reduces the empty volume of the hulls the most, until all parts are
+ * convex enough or there are @ref ConvexDecompositionSettings::maxHulls
+ * parts. Every hull is spanned by the surface of the mesh within its part,
+ * the candidate planes are evaluated on the @ref core::ThreadPool::shared()
+ * pool.
+ *
+ * @param positions The vertices of the mesh.
+ * @param indices The vertices of each triangle of the mesh.
+ * @param settings The resolution and stopping criteria.
+ * @return The vertices of each hull, none for an empty mesh.
+ */
+ConvexDecomposition decomposeConvex(
+    const std::vector<Magnum::Vector3>& positions,
+    const std::vector<Magnum::UnsignedInt>& indices,
+    const ConvexDecompositionSettings& settings = {});
+
+/**
+ * @brief Save a decomposition in a compact binary file
+ * @param hulls The decomposition.
+ * @param filename The file to write.
+ * @return Whether the file was written.
+ */
+bool saveConvexDecomposition(const ConvexDecomposition& hulls,
+                             const std::string& filename);
+
+/**
+ * @brief Load a decomposition saved by @ref saveConvexDecomposition()
+ * @param filename The file to read.
+ * @param hulls The decomposition read.
+ * @return Whether the file exists and is a valid decomposition.
+ */
+bool loadConvexDecomposition(const std::string& filename,
+                             ConvexDecomposition& hulls);
+
+}  // namespace physics
+}  // namespace esp
+
+#endif  // ESP_PHYSICS_BULLET_BULLETCONVEXDECOMPOSITION_H_
@@ -6,15 +6,174 @@
 //#include "BulletCollision/Gimpact/btGImpactShape.h"
 
 #include "BulletPhysicsManager.h"
+
+#include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/Math/Functions.h>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
 #include "BulletRigidObject.h"
 #include "esp/assets/ResourceManager.h"
+#include "esp/core/AsyncLog.h"
+#include "esp/core/MappedFile.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/ThreadPool.h"
 
 namespace esp {
 namespace physics {
 
+namespace {
+
+// Tests a ray against the collision objects in the broadphase tree leaves it
+// overlaps, like btCollisionWorld::rayTest() but with the traversal stack on
+// the calling thread
+struct RayTestLeaves : btDbvt::ICollide {
+  RayTestLeaves(const btVector3& from,
+                const btVector3& to,
+                btCollisionWorld::RayResultCallback& result)
+      : result_(result) {
+    from_.setIdentity();
+    from_.setOrigin(from);
+    to_.setIdentity();
+    to_.setOrigin(to);
+  }
+
+  void Process(const btDbvtNode* leaf) {
+    auto* proxy = static_cast<btBroadphaseProxy*>(leaf->data);
+    // a closest hit at the ray origin can't be beaten
+    if (result_.m_closestHitFraction == 0 ||
+        !result_.needsCollision(proxy)) {
+      return;
+    }
+    auto* object = static_cast<btCollisionObject*>(proxy->m_clientObject);
+    btCollisionWorld::rayTestSingle(from_, to_, object,
+                                    object->getCollisionShape(),
+                                    object->getWorldTransform(), result_);
+  }
+
+  btTransform from_;
+  btTransform to_;
+  btCollisionWorld::RayResultCallback& result_;
+};
+
+// Sweeps a convex shape against the collision objects in the broadphase tree
+// leaves its path overlaps, like btCollisionWorld::convexSweepTest() but with
+// the traversal stack on the calling thread
+struct SweepTestLeaves : btDbvt::ICollide {
+  SweepTestLeaves(const btConvexShape* shape,
+                  const btTransform& from,
+                  const btTransform& to,
+                  btCollisionWorld::ConvexResultCallback& result)
+      : shape_(shape), from_(from), to_(to), result_(result) {}
+
+  void Process(const btDbvtNode* leaf) {
+    auto* proxy = static_cast<btBroadphaseProxy*>(leaf->data);
+    // a closest hit at the start can't be beaten
+    if (result_.m_closestHitFraction == 0 ||
+        !result_.needsCollision(proxy)) {
+      return;
+    }
+    auto* object = static_cast<btCollisionObject*>(proxy->m_clientObject);
+    btCollisionWorld::objectQuerySingle(shape_, from_, to_, object,
+                                        object->getCollisionShape(),
+                                        object->getWorldTransform(), result_,
+                                        0);
+  }
+
+  const btConvexShape* shape_;
+  btTransform from_;
+  btTransform to_;
+  btCollisionWorld::ConvexResultCallback& result_;
+};
+
+// The closest hit of a sweep, ignoring the collision object swept if any
+struct ClosestSweepResult : btCollisionWorld::ClosestConvexResultCallback {
+  ClosestSweepResult(const btVector3& from,
+                     const btVector3& to,
+                     const btCollisionObject* ignored)
+      : ClosestConvexResultCallback(from, to), ignored_(ignored) {}
+
+  bool needsCollision(btBroadphaseProxy* proxy) const override {
+    return proxy->m_clientObject != ignored_ &&
+           ClosestConvexResultCallback::needsCollision(proxy);
+  }
+
+  const btCollisionObject* ignored_;
+};
+
+// Collects the broadphase proxies in the tree leaves overlapping a volume,
+// with the traversal stack on the calling thread
+struct OverlapLeaves : btDbvt::ICollide {
+  OverlapLeaves(const int collisionFilterMask,
+                std::vector<const btBroadphaseProxy*>& proxies)
+      : collisionFilterMask_(collisionFilterMask), proxies_(proxies) {}
+
+  void Process(const btDbvtNode* leaf) {
+    auto* proxy = static_cast<const btBroadphaseProxy*>(leaf->data);
+    if (proxy->m_collisionFilterGroup & collisionFilterMask_) {
+      proxies_.push_back(proxy);
+    }
+  }
+
+  int collisionFilterMask_;
+  std::vector<const btBroadphaseProxy*>& proxies_;
+};
+
+// Whether an oriented box overlaps an axis-aligned one, the separating axis
+// test of the axes of both and their cross products
+bool obbOverlapsAabb(const Magnum::Vector3& center,
+                     const Magnum::Matrix3x3& axes,
+                     const Magnum::Vector3& halfExtents,
+                     const Magnum::Range3D& aabb) {
+  const Magnum::Vector3 offset = center - aabb.center();
+  const Magnum::Vector3 aabbHalfExtents = aabb.size() * 0.5f;
+  auto separates = [&](const Magnum::Vector3& axis) {
+    const float radius =
+        Magnum::Math::dot(Magnum::Math::abs(axis), aabbHalfExtents) +
+        halfExtents.x() * std::abs(Magnum::Math::dot(axis, axes[0])) +
+        halfExtents.y() * std::abs(Magnum::Math::dot(axis, axes[1])) +
+        halfExtents.z() * std::abs(Magnum::Math::dot(axis, axes[2]));
+    return std::abs(Magnum::Math::dot(offset, axis)) > radius;
+  };
+  for (int i = 0; i != 3; ++i) {
+    Magnum::Vector3 unit;
+    unit[i] = 1.0f;
+    if (separates(unit) || separates(axes[i])) {
+      return false;
+    }
+    for (int j = 0; j != 3; ++j) {
+      // parallel axes were tested above
+      const Magnum::Vector3 axis = Magnum::Math::cross(unit, axes[j]);
+      if (axis.dot() > 1.0e-12f && separates(axis)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Bullet's task scheduler is process-wide and its threads run the steps of
+// all multithreaded worlds, nullptr if Bullet isn't built with BT_THREADSAFE
+btITaskScheduler* taskScheduler() {
+  static std::once_flag created;
+  static btITaskScheduler* scheduler = nullptr;
+  std::call_once(created, []() {
+    scheduler = btCreateDefaultTaskScheduler();
+    if (scheduler) {
+      btSetTaskScheduler(scheduler);
+    }
+  });
+  return scheduler;
+}
+
+}  // namespace
+
 BulletPhysicsManager::~BulletPhysicsManager() {
   LOG(INFO) << "Deconstructing BulletPhysicsManager";
 
+  objectPool_.clear();
   existingObjects_.clear();
   staticStageObject_.reset(nullptr);
 }
@@ -25,8 +184,47 @@ bool BulletPhysicsManager::initPhysicsFinalize() {
   //! We can potentially use other collision checking algorithms, by
   //! uncommenting the line below
   // btGImpactCollisionAlgorithm::registerAlgorithm(&bDispatcher_);
-  bWorld_ = std::make_shared<btMultiBodyDynamicsWorld>(
-      &bDispatcher_, &bBroadphase_, &bSolver_, &bCollisionConfig_);
+  int numThreads = physicsManagerAttributes_->getNumThreads();
+  if (deterministic_ && numThreads != 1) {
+    // the multithreaded world orders the contacts and the islands it solves
+    // by the thread that found them first
+    LOG(INFO) << "BulletPhysicsManager::initPhysicsFinalize : deterministic, "
+                 "stepping on one thread.";
+    numThreads = 1;
+  }
+  btITaskScheduler* scheduler = numThreads != 1 ? taskScheduler() : nullptr;
+  if (numThreads != 1 && !scheduler) {
+    LOG(WARNING) << "BulletPhysicsManager::initPhysicsFinalize : Bullet is "
+                    "built without BT_THREADSAFE, stepping on one thread.";
+  }
+  if (scheduler) {
+    if (numThreads <= 0 || numThreads > scheduler->getMaxNumThreads()) {
+      numThreads = scheduler->getMaxNumThreads();
+    }
+    // the stepping thread works on the islands too, like the callers of
+    // core::ThreadPool::parallelFor()
+    const int budget = int(core::ThreadPool::threadBudget());
+    if (numThreads > budget) {
+      LOG(INFO) << "BulletPhysicsManager::initPhysicsFinalize : "
+                << numThreads << " threads capped to the thread budget of "
+                << budget << ".";
+      numThreads = budget;
+    }
+    scheduler->setNumThreads(numThreads);
+    bDispatcherMt_ =
+        std::make_unique<btCollisionDispatcherMt>(&bCollisionConfig_);
+    bSolverPoolMt_ = std::make_unique<btConstraintSolverPoolMt>(numThreads);
+    // without a multithreaded solver for the largest islands, each island is
+    // solved on one thread by a solver of the pool
+    bWorld_ = std::make_shared<btDiscreteDynamicsWorldMt>(
+        bDispatcherMt_.get(), &bBroadphase_, bSolverPoolMt_.get(), nullptr,
+        &bCollisionConfig_);
+    LOG(INFO) << "BulletPhysicsManager::initPhysicsFinalize : stepping on "
+              << numThreads << " threads.";
+  } else {
+    bWorld_ = std::make_shared<btMultiBodyDynamicsWorld>(
+        &bDispatcher_, &bBroadphase_, &bSolver_, &bCollisionConfig_);
+  }
 
   debugDrawer_.setMode(
       Magnum::BulletIntegration::DebugDraw::Mode::DrawWireframe |
@@ -35,6 +233,17 @@ bool BulletPhysicsManager::initPhysicsFinalize() {
 
   // currently GLB meshes are y-up
   bWorld_->setGravity(btVector3(physicsManagerAttributes_->getVec3("gravity")));
+  // the motion states put the nodes of the dynamic objects between their last
+  // two steps with latency interpolation, predicted ahead of the last one
+  // otherwise
+  bWorld_->setLatencyMotionStateInterpolation(renderInterpolation_);
+  if (deterministic_) {
+    // no shuffled constraint order, and no early exit of the solver
+    // iterations on a residual threshold
+    btContactSolverInfo& solverInfo = bWorld_->getSolverInfo();
+    solverInfo.m_solverMode &= ~SOLVER_RANDMIZE_ORDER;
+    solverInfo.m_leastSquaresResidualThreshold = 0;
+  }
 
   Corrade::Utility::Debug() << "creating staticStageObject_";
   //! Create new scene node
@@ -55,12 +264,65 @@ bool BulletPhysicsManager::addStageFinalize(const std::string& handle) {
   return sceneSuccess;
 }
 
+bool BulletPhysicsManager::addObjectsOf(const PhysicsManager& other,
+                                        DrawableGroup* drawables) {
+  // the hulls are copied on write, see BulletRigidObject::setMargin()
+  if (const auto* bulletOther =
+          dynamic_cast<const BulletPhysicsManager*>(&other)) {
+    convexHullCache_ = bulletOther->convexHullCache_;
+  }
+  return PhysicsManager::addObjectsOf(other, drawables);
+}
+
+void BulletPhysicsManager::deserializeStateFinalize() {
+  btOverlappingPairCache* pairCache =
+      bWorld_->getBroadphase()->getOverlappingPairCache();
+  btCollisionObjectArray& objects = bWorld_->getCollisionObjectArray();
+  for (int i = 0; i < objects.size(); ++i) {
+    if (objects[i]->getBroadphaseHandle()) {
+      pairCache->cleanProxyFromPairs(objects[i]->getBroadphaseHandle(),
+                                     bWorld_->getDispatcher());
+    }
+  }
+  bWorld_->clearForces();
+  if (deterministic_) {
+    // the solver's random seed too, for a restored world to step as one built
+    // in the state
+    bWorld_->getConstraintSolver()->reset();
+  }
+}
+
+std::uint64_t BulletPhysicsManager::hashEngineState() const {
+  // the components one by one, btVector3 has a fourth unused one
+  std::vector<btScalar> values;
+  const btCollisionObjectArray& objects = bWorld_->getCollisionObjectArray();
+  values.reserve(objects.size() * 19);
+  const auto addVector = [&values](const btVector3& vector) {
+    values.insert(values.end(), {vector.x(), vector.y(), vector.z()});
+  };
+  for (int i = 0; i < objects.size(); ++i) {
+    const btTransform& transform = objects[i]->getWorldTransform();
+    addVector(transform.getOrigin());
+    for (int row = 0; row != 3; ++row) {
+      addVector(transform.getBasis()[row]);
+    }
+    if (const btRigidBody* body = btRigidBody::upcast(objects[i])) {
+      addVector(body->getLinearVelocity());
+      addVector(body->getAngularVelocity());
+      values.push_back(btScalar(body->getActivationState()));
+    }
+  }
+  return core::hashBytesXXH64(
+      {reinterpret_cast<const char*>(values.data()),
+       values.size() * sizeof(btScalar)});
+}
+
 bool BulletPhysicsManager::makeAndAddRigidObject(int newObjectID,
                                                  const std::string& handle,
                                                  scene::SceneNode* objectNode) {
   auto ptr = physics::BulletRigidObject::create_unique(
       objectNode, newObjectID, resourceManager_, bWorld_,
-      collisionObjToObjIds_);
+      collisionObjToObjIds_, convexHullCache_);
   bool objSuccess = ptr->initialize(handle);
   if (objSuccess) {
     existingObjects_.emplace(newObjectID, std::move(ptr));
@@ -117,6 +379,7 @@ Magnum::Vector3 BulletPhysicsManager::getGravity() const {
 }
 
 void BulletPhysicsManager::stepPhysics(double dt) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::stepPhysics");
   // We don't step uninitialized physics sim...
   if (!initialized_) {
     return;
@@ -125,44 +388,63 @@ void BulletPhysicsManager::stepPhysics(double dt) {
     dt = fixedTimeStep_;
   }
 
-  // set specified control velocities
-  for (auto& objectItr : existingObjects_) {
-    VelocityControl::ptr velControl = objectItr.second->getVelocityControl();
-    if (objectItr.second->getMotionType() == MotionType::KINEMATIC) {
+  restoreDrawnStates();
+  // Bullet keeps the time not making a whole step itself, only the steps a
+  // catch-up owes from earlier calls are passed again
+  const double owedTime =
+      std::floor(pendingTime_ / fixedTimeStep_ + 1e-6) * fixedTimeStep_;
+  const int numSubsteps = takeSubsteps(dt);
+
+  // set specified control velocities, only objects whose control was handed
+  // out can have one
+  for (const int objectID : velControlledObjectIDs_) {
+    RigidObject& object = *existingObjects_.at(objectID);
+    VelocityControl& velControl = *object.getVelocityControl();
+    if (!velControl.controllingAngVel && !velControl.controllingLinVel) {
+      continue;
+    }
+    if (object.getMotionType() == MotionType::KINEMATIC) {
       // kinematic velocity control intergration
-      if (velControl->controllingAngVel || velControl->controllingLinVel) {
-        objectItr.second->setRigidState(velControl->integrateTransform(
-            dt, objectItr.second->getRigidState()));
-        objectItr.second->setActive();
-      }
-    } else if (objectItr.second->getMotionType() == MotionType::DYNAMIC) {
-      if (velControl->controllingLinVel) {
-        if (velControl->linVelIsLocal) {
-          setLinearVelocity(objectItr.first,
-                            objectItr.second->node().rotation().transformVector(
-                                velControl->linVel));
+      object.setRigidState(velControl.integrateTransform(
+          numSubsteps * fixedTimeStep_, object.getRigidState()));
+      object.setActive();
+    } else if (object.getMotionType() == MotionType::DYNAMIC) {
+      if (velControl.controllingLinVel) {
+        if (velControl.linVelIsLocal) {
+          object.setLinearVelocity(
+              object.node().rotation().transformVector(velControl.linVel));
         } else {
-          setLinearVelocity(objectItr.first, velControl->linVel);
+          object.setLinearVelocity(velControl.linVel);
         }
       }
-      if (velControl->controllingAngVel) {
-        if (velControl->angVelIsLocal) {
-          setAngularVelocity(
-              objectItr.first,
-              objectItr.second->node().rotation().transformVector(
-                  velControl->angVel));
+      if (velControl.controllingAngVel) {
+        if (velControl.angVelIsLocal) {
+          object.setAngularVelocity(
+              object.node().rotation().transformVector(velControl.angVel));
         } else {
-          setAngularVelocity(objectItr.first, velControl->angVel);
+          object.setAngularVelocity(velControl.angVel);
         }
       }
     }
   }
 
   // ==== Physics stepforward ======
-  // NOTE: worldTime_ will always be a multiple of sceneMetaData_.timestep
+  // NOTE: worldTime_ will always be a multiple of sceneMetaData_.timestep.
+  // Bullet drops the steps beyond maxSubSteps, the owed time keeps them for
+  // a catch-up.
+  const int maxSubSteps = maxSubsteps_ > 0 ? maxSubsteps_ : 10000;
   int numSubStepsTaken =
-      bWorld_->stepSimulation(dt, /*maxSubSteps*/ 10000, fixedTimeStep_);
+      bWorld_->stepSimulation(dt + owedTime, maxSubSteps, fixedTimeStep_);
   worldTime_ += numSubStepsTaken * fixedTimeStep_;
+  drawAtRenderTime();
+}
+
+void BulletPhysicsManager::setRenderInterpolation(
+    const bool renderInterpolation) {
+  PhysicsManager::setRenderInterpolation(renderInterpolation);
+  if (bWorld_) {
+    bWorld_->setLatencyMotionStateInterpolation(renderInterpolation);
+  }
 }
 
 void BulletPhysicsManager::setMargin(const int physObjectID,
@@ -224,38 +506,331 @@ bool BulletPhysicsManager::contactTest(const int physObjectID) {
 }
 
 RaycastResults BulletPhysicsManager::castRay(const esp::geo::Ray& ray,
-                                             double maxDistance) {
+                                             double maxDistance,
+                                             bool closestHitOnly,
+                                             int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::castRay");
   RaycastResults results;
   results.ray = ray;
-  double rayLength = ray.direction.length();
-  if (rayLength == 0) {
-    LOG(ERROR) << "BulletPhysicsManager::castRay : Cannot case ray with zero "
-                  "length, aborting. ";
+  if (ray.direction.length() == 0) {
+    ESP_HOT_LOG(ERROR) << "BulletPhysicsManager::castRay : Cannot case ray "
+                          "with zero length, aborting. ";
     return results;
   }
+  castRayHits(ray, maxDistance, closestHitOnly, collisionFilterMask,
+              results.hits);
+  return results;
+}
+
+MultiRaycastResults BulletPhysicsManager::castRays(
+    const std::vector<esp::geo::Ray>& rays,
+    double maxDistance,
+    bool closestHitOnly,
+    int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::castRays");
+  MultiRaycastResults results;
+  results.hitOffsets.resize(rays.size() + 1, 0);
+
+  // every chunk of rays collects its hits, then they are concatenated
+  const std::size_t raysPerChunk = 64;
+  const std::size_t chunks = (rays.size() + raysPerChunk - 1) / raysPerChunk;
+  std::vector<std::vector<RayHitInfo>> chunkHits(chunks);
+  auto castChunk = [&](const std::size_t chunk, std::size_t) {
+    std::vector<RayHitInfo>& hits = chunkHits[chunk];
+    const std::size_t end = std::min(rays.size(), (chunk + 1) * raysPerChunk);
+    for (std::size_t i = chunk * raysPerChunk; i < end; ++i) {
+      const std::size_t first = hits.size();
+      castRayHits(rays[i], maxDistance, closestHitOnly, collisionFilterMask,
+                  hits);
+      results.hitOffsets[i + 1] = hits.size() - first;
+    }
+  };
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers = pool.numWorkers(chunks, pool.numThreads() + 1);
+  if (workers == 1) {
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      castChunk(chunk, 0);
+    }
+  } else {
+    pool.parallelFor(chunks, workers, castChunk);
+  }
+
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    results.hitOffsets[i + 1] += results.hitOffsets[i];
+  }
+  results.objectIds.reserve(results.numHits());
+  results.points.reserve(results.numHits());
+  results.normals.reserve(results.numHits());
+  results.rayDistances.reserve(results.numHits());
+  for (const std::vector<RayHitInfo>& hits : chunkHits) {
+    for (const RayHitInfo& hit : hits) {
+      results.objectIds.push_back(hit.objectId);
+      results.points.push_back(hit.point);
+      results.normals.push_back(hit.normal);
+      results.rayDistances.push_back(hit.rayDistance);
+    }
+  }
+  return results;
+}
+
+void BulletPhysicsManager::castRayHits(const esp::geo::Ray& ray,
+                                       double maxDistance,
+                                       bool closestHitOnly,
+                                       int collisionFilterMask,
+                                       std::vector<RayHitInfo>& hits) const {
+  const double rayLength = ray.direction.length();
+  if (rayLength == 0) {
+    return;
+  }
   btVector3 from(ray.origin);
   btVector3 to(ray.origin + ray.direction * maxDistance);
 
-  btCollisionWorld::AllHitsRayResultCallback allResults(from, to);
-  bWorld_->rayTest(from, to, allResults);
+  // the two trees btDbvtBroadphase::rayTest() traverses
+  auto rayTest = [&](btCollisionWorld::RayResultCallback& result) {
+    result.m_collisionFilterMask = collisionFilterMask;
+    RayTestLeaves leaves{from, to, result};
+    btDbvt::rayTest(bBroadphase_.m_sets[0].m_root, from, to, leaves);
+    btDbvt::rayTest(bBroadphase_.m_sets[1].m_root, from, to, leaves);
+  };
+  // default to -1 for "scene collision" if we don't know which object was
+  // involved
+  auto addHit = [&](const btVector3& point, const btVector3& normal,
+                    btScalar fraction, const btCollisionObject* object) {
+    RayHitInfo hit;
+    hit.normal = Magnum::Vector3{normal};
+    hit.point = Magnum::Vector3{point};
+    hit.rayDistance = (fraction * maxDistance) / rayLength;
+    auto found = collisionObjToObjIds_->find(object);
+    hit.objectId = found != collisionObjToObjIds_->end() ? found->second : -1;
+    hits.push_back(hit);
+  };
+
+  if (closestHitOnly) {
+    btCollisionWorld::ClosestRayResultCallback closest(from, to);
+    rayTest(closest);
+    if (closest.hasHit()) {
+      addHit(closest.m_hitPointWorld, closest.m_hitNormalWorld,
+             closest.m_closestHitFraction, closest.m_collisionObject);
+    }
+    return;
+  }
 
-  // convert to RaycastResults
+  btCollisionWorld::AllHitsRayResultCallback allResults(from, to);
+  rayTest(allResults);
+  const std::size_t first = hits.size();
   for (int i = 0; i < allResults.m_hitPointWorld.size(); ++i) {
-    RayHitInfo hit;
+    addHit(allResults.m_hitPointWorld[i], allResults.m_hitNormalWorld[i],
+           allResults.m_hitFractions[i], allResults.m_collisionObjects[i]);
+  }
+  std::sort(hits.begin() + first, hits.end(),
+            [](const RayHitInfo& A, const RayHitInfo& B) {
+              return A.rayDistance < B.rayDistance;
+            });
+}
 
-    hit.normal = Magnum::Vector3{allResults.m_hitNormalWorld[i]};
-    hit.point = Magnum::Vector3{allResults.m_hitPointWorld[i]};
-    hit.rayDistance = (allResults.m_hitFractions[i] * maxDistance) / rayLength;
-    // default to -1 for "scene collision" if we don't know which object was
-    // involved
-    hit.objectId = -1;
-    if (collisionObjToObjIds_->count(allResults.m_collisionObjects[i]) > 0) {
-      hit.objectId =
-          collisionObjToObjIds_->at(allResults.m_collisionObjects[i]);
+std::vector<int> BulletPhysicsManager::overlapProxies(
+    const Magnum::Range3D& bounds,
+    int collisionFilterMask,
+    const std::function<bool(const Magnum::Range3D&)>& test) {
+  // the objects moved since the last step
+  bWorld_->updateAabbs();
+  std::vector<const btBroadphaseProxy*> proxies;
+  OverlapLeaves leaves{collisionFilterMask, proxies};
+  // the two trees btDbvtBroadphase::aabbTest() traverses
+  const btDbvtVolume volume = btDbvtVolume::FromMM(btVector3{bounds.min()},
+                                                   btVector3{bounds.max()});
+  for (const btDbvt& tree : bBroadphase_.m_sets) {
+    tree.collideTV(tree.m_root, volume, leaves);
+  }
+
+  std::vector<int> objectIds;
+  for (const btBroadphaseProxy* proxy : proxies) {
+    // the leaves are enlarged, the proxies have the bounding boxes
+    const Magnum::Range3D aabb{Magnum::Vector3{proxy->m_aabbMin},
+                               Magnum::Vector3{proxy->m_aabbMax}};
+    if (!Magnum::Math::intersects(aabb, bounds) || !test(aabb)) {
+      continue;
     }
-    results.hits.push_back(hit);
+    auto found = collisionObjToObjIds_->find(
+        static_cast<const btCollisionObject*>(proxy->m_clientObject));
+    objectIds.push_back(found != collisionObjToObjIds_->end() ? found->second
+                                                              : -1);
+  }
+  std::sort(objectIds.begin(), objectIds.end());
+  objectIds.erase(std::unique(objectIds.begin(), objectIds.end()),
+                  objectIds.end());
+  return objectIds;
+}
+
+std::vector<int> BulletPhysicsManager::overlapAabb(const Magnum::Range3D& aabb,
+                                                   int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::overlapAabb");
+  return overlapProxies(aabb, collisionFilterMask,
+                        [](const Magnum::Range3D&) { return true; });
+}
+
+std::vector<int> BulletPhysicsManager::overlapSphere(
+    const Magnum::Vector3& center,
+    float radius,
+    int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::overlapSphere");
+  return overlapProxies(
+      Magnum::Range3D::fromCenter(center, Magnum::Vector3{radius}),
+      collisionFilterMask, [&](const Magnum::Range3D& aabb) {
+        const Magnum::Vector3 closest =
+            Magnum::Math::clamp(center, aabb.min(), aabb.max());
+        return (closest - center).dot() <= radius * radius;
+      });
+}
+
+std::vector<int> BulletPhysicsManager::overlapObb(const geo::OBB& obb,
+                                                  int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::overlapObb");
+  const Magnum::Vector3 center =
+      Magnum::EigenIntegration::cast<Magnum::Vector3>(obb.center());
+  const Magnum::Matrix3x3 axes =
+      Magnum::EigenIntegration::cast<Magnum::Matrix3x3>(
+          Eigen::Matrix3f{obb.rotation().toRotationMatrix()});
+  const Magnum::Vector3 halfExtents =
+      Magnum::EigenIntegration::cast<Magnum::Vector3>(obb.halfExtents());
+  const box3f bounds = obb.toAABB();
+  return overlapProxies(
+      Magnum::Range3D{
+          Magnum::EigenIntegration::cast<Magnum::Vector3>(bounds.min()),
+          Magnum::EigenIntegration::cast<Magnum::Vector3>(bounds.max())},
+      collisionFilterMask, [&](const Magnum::Range3D& aabb) {
+        return obbOverlapsAabb(center, axes, halfExtents, aabb);
+      });
+}
+
+std::vector<bool> BulletPhysicsManager::contactTests(
+    const std::vector<int>& physObjectIDs) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::contactTests");
+  bWorld_->updateAabbs();
+  std::vector<bool> contacts;
+  contacts.reserve(physObjectIDs.size());
+  for (const int physObjectID : physObjectIDs) {
+    assertIDValidity(physObjectID);
+    contacts.push_back(static_cast<BulletRigidObject*>(
+                           existingObjects_.at(physObjectID).get())
+                           ->contactTest());
+  }
+  return contacts;
+}
+
+std::vector<bool> BulletPhysicsManager::testPlacements(
+    const int physObjectID,
+    const std::vector<Magnum::Matrix4>& transformations) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::testPlacements");
+  assertIDValidity(physObjectID);
+  bWorld_->updateAabbs();
+  return static_cast<BulletRigidObject*>(
+             existingObjects_.at(physObjectID).get())
+      ->contactTestsAt(transformations);
+}
+
+std::vector<SweepResult> BulletPhysicsManager::sweepObjectBatch(
+    const int physObjectID,
+    const std::vector<Magnum::Matrix4>& from,
+    const std::vector<Magnum::Vector3>& to,
+    const int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::sweepObjectBatch");
+  assertIDValidity(physObjectID);
+  const auto* object =
+      static_cast<BulletRigidObject*>(existingObjects_.at(physObjectID).get());
+  bWorld_->updateAabbs();
+  return sweepConvexShapes(object->getConvexShapes(), from, to,
+                           collisionFilterMask, object->getCollisionObject());
+}
+
+std::vector<SweepResult> BulletPhysicsManager::sweepCapsuleBatch(
+    const float radius,
+    const float height,
+    const std::vector<Magnum::Vector3>& from,
+    const std::vector<Magnum::Vector3>& to,
+    const int collisionFilterMask) {
+  ESP_PROFILE_SCOPE("BulletPhysicsManager::sweepCapsuleBatch");
+  CORRADE_ASSERT(radius > 0 && height >= 2 * radius,
+                 "BulletPhysicsManager::sweepCapsuleBatch(): expected a "
+                 "positive radius and a height of at least twice the radius "
+                 "but got"
+                     << radius << "and" << height,
+                 {});
+  bWorld_->updateAabbs();
+  // along y, with the distance between the centers of the caps
+  const btCapsuleShape capsule{radius, height - 2 * radius};
+  std::vector<Magnum::Matrix4> fromTransforms;
+  fromTransforms.reserve(from.size());
+  for (const Magnum::Vector3& center : from) {
+    fromTransforms.push_back(Magnum::Matrix4::translation(center));
+  }
+  return sweepConvexShapes({{&capsule, btTransform::getIdentity()}},
+                           fromTransforms, to, collisionFilterMask, nullptr);
+}
+
+std::vector<SweepResult> BulletPhysicsManager::sweepConvexShapes(
+    const std::vector<std::pair<const btConvexShape*, btTransform>>& shapes,
+    const std::vector<Magnum::Matrix4>& from,
+    const std::vector<Magnum::Vector3>& to,
+    const int collisionFilterMask,
+    const btCollisionObject* ignored) const {
+  CORRADE_ASSERT(from.size() == to.size(),
+                 "BulletPhysicsManager::sweepConvexShapes(): expected as "
+                 "many starts as ends but got"
+                     << from.size() << "and" << to.size(),
+                 {});
+  std::vector<SweepResult> results(from.size());
+  auto sweep = [&](const std::size_t i, std::size_t) {
+    SweepResult& result = results[i];
+    const btVector3 offset{to[i] - from[i].translation()};
+    for (const auto& shape : shapes) {
+      const btTransform shapeFrom = btTransform{from[i]} * shape.second;
+      btTransform shapeTo = shapeFrom;
+      shapeTo.setOrigin(shapeFrom.getOrigin() + offset);
+      ClosestSweepResult hit{shapeFrom.getOrigin(), shapeTo.getOrigin(),
+                             ignored};
+      hit.m_collisionFilterMask = collisionFilterMask;
+      // only the hits before those of the other shapes are reported
+      hit.m_closestHitFraction = result.timeOfImpact;
+
+      // the trees btDbvtBroadphase::rayTest() traverses, with the bounds of
+      // the whole path
+      btVector3 min, max, toMin, toMax;
+      shape.first->getAabb(shapeFrom, min, max);
+      shape.first->getAabb(shapeTo, toMin, toMax);
+      min.setMin(toMin);
+      max.setMax(toMax);
+      const btDbvtVolume volume = btDbvtVolume::FromMM(min, max);
+      SweepTestLeaves leaves{shape.first, shapeFrom, shapeTo, hit};
+      for (const btDbvt& tree : bBroadphase_.m_sets) {
+        tree.collideTV(tree.m_root, volume, leaves);
+      }
+
+      if (hit.hasHit()) {
+        result.hasHit = true;
+        result.timeOfImpact = hit.m_closestHitFraction;
+        result.point = Magnum::Vector3{hit.m_hitPointWorld};
+        result.normal = Magnum::Vector3{hit.m_hitNormalWorld};
+        // default to -1 for "scene collision" if we don't know which object
+        // was involved
+        auto found = collisionObjToObjIds_->find(hit.m_hitCollisionObject);
+        result.objectId =
+            found != collisionObjToObjIds_->end() ? found->second : -1;
+      }
+    }
+  };
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers =
+      pool.numWorkers(from.size(), pool.numThreads() + 1);
+  if (workers == 1) {
+    for (std::size_t i = 0; i < from.size(); ++i) {
+      sweep(i, 0);
+    }
+  } else {
+    pool.parallelFor(from.size(), workers, sweep);
   }
-  results.sortByDistance();
   return results;
 }
 
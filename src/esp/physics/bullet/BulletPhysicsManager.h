@@ -14,7 +14,10 @@
 #include <Magnum/BulletIntegration/Integration.h>
 #include <Magnum/BulletIntegration/MotionState.h>
 #include <btBulletDynamicsCommon.h>
+#include <functional>
 
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
 #include "BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h"
 #include "BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h"
 
@@ -30,7 +33,11 @@ namespace physics {
 @brief Dynamic stage and object manager interfacing with Bullet physics
 engine: https://github.com/bulletphysics/bullet3.
 
-See @ref btMultiBodyDynamicsWorld.
+See @ref btMultiBodyDynamicsWorld. With more than one
+@ref metadata::attributes::PhysicsManagerAttributes::getNumThreads, the world
+is a @ref btDiscreteDynamicsWorldMt instead, which finds contacts and solves
+the simulation islands on the threads of Bullet's task scheduler. That needs
+Bullet built with BT_THREADSAFE, otherwise the world stays single-threaded.
 
 Enables @ref RigidObject simulation with @ref MotionType::DYNAMIC.
 
@@ -56,6 +63,7 @@ class BulletPhysicsManager : public PhysicsManager {
       : PhysicsManager(_resourceManager, _physicsManagerAttributes) {
     collisionObjToObjIds_ =
         std::make_shared<std::map<const btCollisionObject*, int>>();
+    convexHullCache_ = std::make_shared<ConvexHullCache>();
   };
 
   /** @brief Destructor which destructs necessary Bullet physics structures.*/
@@ -70,6 +78,13 @@ class BulletPhysicsManager : public PhysicsManager {
    */
   void stepPhysics(double dt) override;
 
+  /** @brief Set whether moving objects are drawn between their last two
+   * fixed steps. The dynamic objects are through the latency interpolation of
+   * the motion states, see @ref
+   * btDiscreteDynamicsWorld::setLatencyMotionStateInterpolation.
+   */
+  void setRenderInterpolation(bool renderInterpolation) override;
+
   /** @brief Set the gravity of the physical world.
    * @param gravity The desired gravity force of the physical world.
    */
@@ -179,10 +194,113 @@ class BulletPhysicsManager : public PhysicsManager {
    * distances will be in units of ray length.
    * @param maxDistance The maximum distance along the ray direction to search.
    * In units of ray length.
+   * @param closestHitOnly Whether to only report the closest hit, found with
+   * a btCollisionWorld::ClosestRayResultCallback.
+   * @param collisionFilterMask The @ref CollisionGroup values the ray hits.
    * @return The raycast results sorted by distance.
    */
-  virtual RaycastResults castRay(const esp::geo::Ray& ray,
-                                 double maxDistance = 100.0) override;
+  virtual RaycastResults castRay(
+      const esp::geo::Ray& ray,
+      double maxDistance = 100.0,
+      bool closestHitOnly = false,
+      int collisionFilterMask = int(CollisionGroup::ALL)) override;
+
+  /**
+   * @brief Cast a batch of rays into the collision world, on the @ref
+   * core::ThreadPool::shared() pool.
+   *
+   * The rays traverse the broadphase trees directly rather than through
+   * btCollisionWorld::rayTest(), which keeps its traversal stack in the
+   * broadphase and so can't run on several threads at once.
+   *
+   * @param rays The rays to cast. Need not be unit length, but returned hit
+   * distances will be in units of ray length.
+   * @param maxDistance The maximum distance along the ray directions to
+   * search. In units of ray length.
+   * @param closestHitOnly Whether to only report the closest hit of each ray.
+   * @param collisionFilterMask The @ref CollisionGroup values the rays hit.
+   * @return The hits of all rays, each ray's sorted by distance.
+   */
+  MultiRaycastResults castRays(
+      const std::vector<esp::geo::Ray>& rays,
+      double maxDistance = 100.0,
+      bool closestHitOnly = false,
+      int collisionFilterMask = int(CollisionGroup::ALL)) override;
+
+  /**
+   * @brief The objects whose bounding box overlaps a box, from the trees of
+   * the @ref btDbvtBroadphase alone.
+   *
+   * The bounding boxes are those of the collision objects, including their
+   * margins. The objects moved since the last step are updated first.
+   *
+   * @param aabb The box, in world space.
+   * @param collisionFilterMask The @ref CollisionGroup values included.
+   * @return The ids of the objects, sorted and each once, -1 for the stage.
+   */
+  std::vector<int> overlapAabb(
+      const Magnum::Range3D& aabb,
+      int collisionFilterMask = int(CollisionGroup::ALL)) override;
+
+  /**
+   * @brief The objects whose bounding box overlaps a sphere, as @ref
+   * overlapAabb().
+   */
+  std::vector<int> overlapSphere(
+      const Magnum::Vector3& center,
+      float radius,
+      int collisionFilterMask = int(CollisionGroup::ALL)) override;
+
+  /**
+   * @brief The objects whose bounding box overlaps an oriented box, as @ref
+   * overlapAabb(), with a separating axis test against each bounding box.
+   */
+  std::vector<int> overlapObb(
+      const geo::OBB& obb,
+      int collisionFilterMask = int(CollisionGroup::ALL)) override;
+
+  /**
+   * @brief @ref contactTest() of a batch of objects.
+   *
+   * Only the bounding boxes of the collision world are updated, once, as
+   * the contact tests query the broadphase trees rather than the pairs of
+   * the last collision detection.
+   */
+  std::vector<bool> contactTests(
+      const std::vector<int>& physObjectIDs) override;
+
+  /**
+   * @brief Whether an object would be in contact at each of a batch of
+   * transformations, see @ref BulletRigidObject::contactTestsAt().
+   */
+  std::vector<bool> testPlacements(
+      int physObjectID,
+      const std::vector<Magnum::Matrix4>& transformations) override;
+
+  /**
+   * @brief Sweep the collision shape of an object along a batch of straight
+   * paths, like @ref btCollisionWorld::convexSweepTest() for each convex
+   * shape of the object, in parallel.
+   *
+   * The rotation stays constant along each path, as Bullet ignores it
+   * against triangle meshes anyway.
+   */
+  std::vector<SweepResult> sweepObjectBatch(
+      int physObjectID,
+      const std::vector<Magnum::Matrix4>& from,
+      const std::vector<Magnum::Vector3>& to,
+      int collisionFilterMask = int(CollisionGroup::ALL)) override;
+
+  /**
+   * @brief Sweep an upright @ref btCapsuleShape along a batch of straight
+   * paths, in parallel.
+   */
+  std::vector<SweepResult> sweepCapsuleBatch(
+      float radius,
+      float height,
+      const std::vector<Magnum::Vector3>& from,
+      const std::vector<Magnum::Vector3>& to,
+      int collisionFilterMask = int(CollisionGroup::ALL)) override;
 
   // The number of contact points that were active during the last step. An
   // object resting on another object will involve several active contact
@@ -211,6 +329,22 @@ class BulletPhysicsManager : public PhysicsManager {
    */
   bool addStageFinalize(const std::string& handle) override;
 
+  /** @brief Also share the convex hulls of the objects with @p other, see
+   * @ref PhysicsManager::addObjectsOf.
+   */
+  bool addObjectsOf(const PhysicsManager& other,
+                    DrawableGroup* drawables) override;
+
+  /** @brief Drop the contact manifolds and forces of all objects after a
+   * state was restored, as they belong to the state before. See @ref
+   * btOverlappingPairCache::cleanProxyFromPairs.
+   */
+  void deserializeStateFinalize() override;
+
+  /** @brief Hash the transforms, velocities and activation states of the
+   * collision objects, in the order Bullet steps them. */
+  std::uint64_t hashEngineState() const override;
+
   /** @brief Create and initialize an @ref RigidObject and add
    * it to existingObjects_ map keyed with newObjectID
    * @param newObjectID valid object ID for the new object
@@ -225,14 +359,52 @@ class BulletPhysicsManager : public PhysicsManager {
                              const std::string& handle,
                              scene::SceneNode* objectNode) override;
 
+  /**
+   * @brief Cast one ray of @ref castRay() or @ref castRays() and append its
+   * hits, sorted by distance, to @p hits. Safe to call from several threads
+   * at once.
+   */
+  void castRayHits(const esp::geo::Ray& ray,
+                   double maxDistance,
+                   bool closestHitOnly,
+                   int collisionFilterMask,
+                   std::vector<RayHitInfo>& hits) const;
+
+  /**
+   * @brief The ids of the objects whose broadphase proxy overlaps @p bounds
+   * and passes @p test, for the overlap queries.
+   */
+  std::vector<int> overlapProxies(
+      const Magnum::Range3D& bounds,
+      int collisionFilterMask,
+      const std::function<bool(const Magnum::Range3D&)>& test);
+
+  /**
+   * @brief Sweep the union of convex @p shapes, given with their
+   * transformations from a common frame, along a batch of paths of that
+   * frame and return the first hit of each, ignoring @p ignored. The paths
+   * are swept in parallel.
+   */
+  std::vector<SweepResult> sweepConvexShapes(
+      const std::vector<std::pair<const btConvexShape*, btTransform>>& shapes,
+      const std::vector<Magnum::Matrix4>& from,
+      const std::vector<Magnum::Vector3>& to,
+      int collisionFilterMask,
+      const btCollisionObject* ignored) const;
+
   btDbvtBroadphase bBroadphase_;
   btDefaultCollisionConfiguration bCollisionConfig_;
 
   btMultiBodyConstraintSolver bSolver_;
   btCollisionDispatcher bDispatcher_{&bCollisionConfig_};
 
-  /** @brief A pointer to the Bullet world. See @ref btMultiBodyDynamicsWorld.*/
-  std::shared_ptr<btMultiBodyDynamicsWorld> bWorld_;
+  //! dispatcher and island solvers of a multithreaded world, if any
+  std::unique_ptr<btCollisionDispatcherMt> bDispatcherMt_;
+  std::unique_ptr<btConstraintSolverPoolMt> bSolverPoolMt_;
+
+  /** @brief A pointer to the Bullet world. See @ref btMultiBodyDynamicsWorld
+   * and @ref btDiscreteDynamicsWorldMt.*/
+  std::shared_ptr<btDiscreteDynamicsWorld> bWorld_;
 
   mutable Magnum::BulletIntegration::DebugDraw debugDrawer_;
 
@@ -241,6 +413,10 @@ class BulletPhysicsManager : public PhysicsManager {
   std::shared_ptr<std::map<const btCollisionObject*, int>>
       collisionObjToObjIds_;
 
+  //! convex collision hulls built for the objects, reused by all the objects
+  //! built from the same template
+  std::shared_ptr<ConvexHullCache> convexHullCache_;
+
  private:
   /** @brief Check if a particular mesh can be used as a collision mesh for
    * Bullet.
@@ -7,6 +7,8 @@
 
 #include <Corrade/Utility/Assert.h>
 
+#include <cmath>
+#include <sstream>
 #include <utility>
 
 #include "BulletCollision/CollisionShapes/btCompoundShape.h"
@@ -32,16 +34,64 @@
 namespace esp {
 namespace physics {
 
+namespace {
+
+// Replaces hull by its support points along maxVertices directions spread
+// over the sphere by a Fibonacci lattice, so at most maxVertices vertices. The
+// directions are taken in the scaled space of the hull.
+void simplifyConvexHull(std::shared_ptr<btConvexHullShape>& hull,
+                        int maxVertices,
+                        const btVector3& scaling) {
+  const int numPoints = hull->getNumPoints();
+  if (numPoints <= maxVertices) {
+    return;
+  }
+  const btVector3* points = hull->getUnscaledPoints();
+  std::vector<bool> kept(numPoints, false);
+  const double goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+  for (int i = 0; i < maxVertices; ++i) {
+    const double z = 1.0 - (2.0 * i + 1.0) / maxVertices;
+    const double r = std::sqrt(1.0 - z * z);
+    const btVector3 direction =
+        btVector3(r * std::cos(goldenAngle * i), r * std::sin(goldenAngle * i),
+                  z) *
+        scaling;
+    int support = 0;
+    btScalar supportDistance = points[0].dot(direction);
+    for (int j = 1; j < numPoints; ++j) {
+      const btScalar distance = points[j].dot(direction);
+      if (distance > supportDistance) {
+        support = j;
+        supportDistance = distance;
+      }
+    }
+    kept[support] = true;
+  }
+
+  btAlignedObjectArray<btVector3> simplified;
+  for (int j = 0; j < numPoints; ++j) {
+    if (kept[j]) {
+      simplified.push_back(points[j]);
+    }
+  }
+  hull = std::make_shared<btConvexHullShape>(&simplified[0].getX(),
+                                             simplified.size());
+}
+
+}  // namespace
+
 BulletRigidObject::BulletRigidObject(
     scene::SceneNode* rigidBodyNode,
     int objectId,
     const assets::ResourceManager& resMgr,
-    std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+    std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
     std::shared_ptr<std::map<const btCollisionObject*, int> >
-        collisionObjToObjIds)
+        collisionObjToObjIds,
+    std::shared_ptr<ConvexHullCache> convexHullCache)
     : BulletBase(std::move(bWorld), std::move(collisionObjToObjIds)),
       RigidObject(rigidBodyNode, objectId, resMgr),
-      MotionState(*rigidBodyNode) {}
+      MotionState(*rigidBodyNode),
+      convexHullCache_(std::move(convexHullCache)) {}
 
 BulletRigidObject::~BulletRigidObject() {
   if (!isActive()) {
@@ -61,7 +111,8 @@ bool BulletRigidObject::initialization_LibSpecific() {
   // TODO: add is_dynamic flag
   objectMotionType_ = MotionType::DYNAMIC;
 
-  isCollidable_ = getInitializationAttributes()->getIsCollidable();
+  isCollidable_ = getInitializationAttributesShared()->getIsCollidable();
+  setCollisionFilterFromTemplate();
 
   // create the bObjectRigidBody_
   constructAndAddRigidBody(objectMotionType_);
@@ -78,7 +129,7 @@ bool BulletRigidObject::finalizeObject_LibSpecific() {
 
 bool BulletRigidObject::constructCollisionShape() {
   // get this object's creation template, appropriately cast
-  auto tmpAttr = getInitializationAttributes();
+  auto tmpAttr = getInitializationAttributesShared();
 
   //! Physical parameters
   double margin = tmpAttr->getMargin();
@@ -100,7 +151,7 @@ bool BulletRigidObject::constructCollisionShape() {
     // if using prim collider get appropriate bullet collision primitive
     // attributes and build bullet collision shape
     auto primAttributes =
-        resMgr_.getAssetAttributesManager()->getObjectCopyByHandle(
+        resMgr_.getAssetAttributesManager()->getObjectSharedByHandle(
             collisionAssetHandle);
     // primitive object pointer construction
     auto primObjPtr = buildPrimitiveCollisionObject(
@@ -123,17 +174,58 @@ bool BulletRigidObject::constructCollisionShape() {
         resMgr_.getMeshMetaData(collisionAssetHandle);
 
     if (!usingBBCollisionShape_) {
-      constructBulletCompoundFromMeshes(Magnum::Matrix4{}, meshGroup,
-                                        metaData.root, joinCollisionMeshes);
-
-      // add the final object after joining meshes
-      if (joinCollisionMeshes) {
-        bObjectConvexShapes_.back()->setLocalScaling(
-            btVector3(tmpAttr->getCollisionAssetSize()));
-        bObjectConvexShapes_.back()->setMargin(0.0);
-        bObjectConvexShapes_.back()->recalcLocalAabb();
-        bObjectShape_->addChildShape(btTransform::getIdentity(),
-                                     bObjectConvexShapes_.back().get());
+      // the object scale is applied to the hulls rather than to the compound,
+      // which would rescale the hulls shared with the other instances
+      const int maxHullVertices = tmpAttr->getMaxHullVertices();
+      // the meshes are kept if they can't be decomposed
+      const bool decompose =
+          tmpAttr->getUseConvexDecomposition() &&
+          !resMgr_.getConvexDecomposition(collisionAssetHandle).empty();
+      const Mn::Vector3 hullScaling =
+          joinCollisionMeshes && !decompose
+              ? tmpAttr->getCollisionAssetSize() * tmpAttr->getScale()
+              : tmpAttr->getScale();
+      std::ostringstream key;
+      key << collisionAssetHandle << ':' << joinCollisionMeshes << ':'
+          << decompose << ':' << maxHullVertices << ':' << hullScaling.x()
+          << ',' << hullScaling.y() << ',' << hullScaling.z();
+
+      auto cached = convexHullCache_->find(key.str());
+      if (cached == convexHullCache_->end()) {
+        bObjectConvexShapes_.clear();
+        if (decompose) {
+          for (const std::vector<Mn::Vector3>& hull :
+               resMgr_.getConvexDecomposition(collisionAssetHandle)) {
+            bObjectConvexShapes_.emplace_back(
+                std::make_shared<btConvexHullShape>(hull.data()->data(),
+                                                    int(hull.size()),
+                                                    sizeof(Mn::Vector3)));
+          }
+        }
+        } else {
+          constructBulletCompoundFromMeshes(Magnum::Matrix4{}, meshGroup,
+                                            metaData.root,
+                                            joinCollisionMeshes);
+        }
+        for (auto& hull : bObjectConvexShapes_) {
+          // drop the interior vertices, which don't change the shape
+          hull->optimizeConvexHull();
+          if (maxHullVertices > 0) {
+            simplifyConvexHull(hull, maxHullVertices, btVector3(hullScaling));
+          }
+          hull->setLocalScaling(btVector3(hullScaling));
+          // Remove local convex margin in favor of margin on the containing
+          // compound
+          hull->setMargin(0.0);
+          hull->recalcLocalAabb();
+        }
+        cached =
+            convexHullCache_->emplace(key.str(), bObjectConvexShapes_).first;
+      }
+      bObjectConvexShapes_ = cached->second;
+      //! Add to compound shape stucture
+      for (auto& hull : bObjectConvexShapes_) {
+        bObjectShape_->addChildShape(btTransform::getIdentity(), hull.get());
       }
     }
   }  // if using prim collider else use mesh collider
@@ -141,7 +233,9 @@ bool BulletRigidObject::constructCollisionShape() {
   //! Set properties
   bObjectShape_->setMargin(margin);
 
-  bObjectShape_->setLocalScaling(btVector3{tmpAttr->getScale()});
+  if (bObjectConvexShapes_.empty()) {
+    bObjectShape_->setLocalScaling(btVector3{tmpAttr->getScale()});
+  }
   bObjectShape_->recalculateLocalAabb();
 
   if (!originShift_.isZero()) {
@@ -239,7 +333,7 @@ void BulletRigidObject::constructBulletCompoundFromMeshes(
       if (bObjectConvexShapes_.empty()) {
         // create the convex if it does not exist
         bObjectConvexShapes_.emplace_back(
-            std::make_unique<btConvexHullShape>());
+            std::make_shared<btConvexHullShape>());
       }
 
       // add points
@@ -249,22 +343,13 @@ void BulletRigidObject::constructBulletCompoundFromMeshes(
       }
 
     } else {
-      bObjectConvexShapes_.emplace_back(std::make_unique<btConvexHullShape>());
+      bObjectConvexShapes_.emplace_back(std::make_shared<btConvexHullShape>());
       // transform points into world space, including any scale/shear in
       // transformFromLocalToWorld.
       for (auto& v : mesh.positions) {
         bObjectConvexShapes_.back()->addPoint(
             btVector3(transformFromLocalToWorld.transformPoint(v)), false);
       }
-      // bObjectConvexShapes_.back()->optimizeConvexHull();
-      // bObjectConvexShapes_.back()->initializePolyhedralFeatures();
-      // Remove local convex margin in favor of margin on the containing
-      // compound
-      bObjectConvexShapes_.back()->setMargin(0.0);
-      bObjectConvexShapes_.back()->recalcLocalAabb();
-      //! Add to compound shape stucture
-      bObjectShape_->addChildShape(btTransform::getIdentity(),
-                                   bObjectConvexShapes_.back().get());
     }
   }
 
@@ -274,6 +359,26 @@ void BulletRigidObject::constructBulletCompoundFromMeshes(
   }
 }  // constructBulletCompoundFromMeshes
 
+void BulletRigidObject::unshareConvexShapes() {
+  for (auto& hull : bObjectConvexShapes_) {
+    if (hull.use_count() == 1) {
+      continue;
+    }
+    auto copy = std::make_shared<btConvexHullShape>(
+        &hull->getUnscaledPoints()->getX(), hull->getNumPoints());
+    copy->setLocalScaling(hull->getLocalScaling());
+    copy->setMargin(hull->getMargin());
+    copy->recalcLocalAabb();
+    for (int i = 0; i < bObjectShape_->getNumChildShapes(); ++i) {
+      btCompoundShapeChild& child = bObjectShape_->getChildList()[i];
+      if (child.m_childShape == hull.get()) {
+        child.m_childShape = copy.get();
+      }
+    }
+    hull = std::move(copy);
+  }
+}  // unshareConvexShapes
+
 void BulletRigidObject::setCollisionFromBB() {
   btVector3 dim(node().getCumulativeBB().size() / 2.0);
 
@@ -294,7 +399,7 @@ void BulletRigidObject::setCollisionFromBB() {
     // otherwise this setup is deferred
     bObjectRigidBody_->setCollisionShape(bObjectShape_.get());
 
-    auto tmpAttr = getInitializationAttributes();
+    auto tmpAttr = getInitializationAttributesShared();
     btVector3 bInertia(tmpAttr->getInertia());
     if (bInertia == btVector3{0, 0, 0}) {
       // allow bullet to compute the inertia tensor if we don't have one
@@ -337,6 +442,26 @@ bool BulletRigidObject::setCollidable(bool collidable) {
   return true;
 }
 
+bool BulletRigidObject::setCollisionFilter(const int group, const int mask) {
+  if (group == collisionGroup_ && mask == collisionMask_) {
+    return true;
+  }
+  collisionGroup_ = group;
+  collisionMask_ = mask;
+  if (!isActive()) {
+    // the objects it supports may not collide with it anymore
+    activateCollisionIsland();
+  }
+  // the broadphase proxy keeps the filter it was added with
+  bWorld_->removeRigidBody(bObjectRigidBody_.get());
+  bWorld_->addRigidBody(bObjectRigidBody_.get(), getCollisionGroup(),
+                        getCollisionMask());
+  if (objectMotionType_ != MotionType::STATIC) {
+    setActive();
+  }
+  return true;
+}
+
 void BulletRigidObject::shiftOrigin(const Magnum::Vector3& shift) {
   if (visualNode_)
     visualNode_->translate(shift);
@@ -372,7 +497,7 @@ void BulletRigidObject::syncPose() {
 
 void BulletRigidObject::constructAndAddRigidBody(MotionType mt) {
   // get this object's creation template, appropriately cast
-  auto tmpAttr = getInitializationAttributes();
+  auto tmpAttr = getInitializationAttributesShared();
 
   if (bObjectShape_ == nullptr && isCollidable_) {
     constructCollisionShape();
@@ -381,18 +506,7 @@ void BulletRigidObject::constructAndAddRigidBody(MotionType mt) {
   double mass = 0;
   btVector3 bInertia = {0, 0, 0};
   if (mt == MotionType::DYNAMIC) {
-    mass = tmpAttr->getMass();
-    bInertia = btVector3(tmpAttr->getInertia());
-    if (bInertia == btVector3{0, 0, 0}) {
-      if (bObjectShape_ != nullptr) {
-        // allow bullet to compute the inertia tensor if we don't have one
-        bObjectShape_->calculateLocalInertia(mass,
-                                             bInertia);  // overrides bInertia
-      } else {
-        // TODO: better default given object information?
-        bInertia = btVector3(1.0, 1.0, 1.0);
-      }
-    }
+    getTemplateMassProps(mass, bInertia);
   }
 
   //! Bullet rigid body setup
@@ -438,19 +552,81 @@ void BulletRigidObject::constructAndAddRigidBody(MotionType mt) {
     CORRADE_INTERNAL_ASSERT(bObjectRigidBody_->isKinematicObject());
   }
 
-  // add the object to the world
+  // add the object to the world, with the filter of the new motion type
+  objectMotionType_ = mt;
+  bWorld_->addRigidBody(bObjectRigidBody_.get(), getCollisionGroup(),
+                        getCollisionMask());
   if (mt == MotionType::STATIC) {
     CORRADE_INTERNAL_ASSERT(bObjectRigidBody_->isStaticObject());
-    bWorld_->addRigidBody(
-        bObjectRigidBody_.get(),
-        2,       // collisionFilterGroup (2 == StaticFilter)
-        1 + 2);  // collisionFilterMask (1 == DefaultFilter, 2==StaticFilter)
   } else {
-    bWorld_->addRigidBody(bObjectRigidBody_.get());
     setActive();
   }
 }
 
+void BulletRigidObject::getTemplateMassProps(double& mass,
+                                             btVector3& inertia) const {
+  auto tmpAttr = getInitializationAttributesShared();
+  mass = tmpAttr->getMass();
+  inertia = btVector3(tmpAttr->getInertia());
+  if (inertia == btVector3{0, 0, 0}) {
+    if (bObjectShape_ != nullptr) {
+      // allow bullet to compute the inertia tensor if we don't have one
+      bObjectShape_->calculateLocalInertia(mass, inertia);  // overrides inertia
+    } else {
+      // TODO: better default given object information?
+      inertia = btVector3(1.0, 1.0, 1.0);
+    }
+  }
+}
+
+void BulletRigidObject::deactivate() {
+  if (!isActive()) {
+    // the objects it supports would keep sleeping in the air
+    activateCollisionIsland();
+  }
+  bWorld_->removeRigidBody(bObjectRigidBody_.get());
+  collisionObjToObjIds_->erase(bObjectRigidBody_.get());
+  // out of the world, so that neither the destructor nor a reactivation
+  // looks for its collision island
+  bObjectRigidBody_->forceActivationState(ACTIVE_TAG);
+}
+
+void BulletRigidObject::reactivate(const int objectId) {
+  const MotionType motionType = objectMotionType_;
+  RigidObject::reactivate(objectId);
+  objectMotionType_ = MotionType::DYNAMIC;
+
+  auto tmpAttr = getInitializationAttributesShared();
+  bObjectRigidBody_->setFriction(tmpAttr->getFrictionCoefficient());
+  bObjectRigidBody_->setRestitution(tmpAttr->getRestitutionCoefficient());
+  bObjectRigidBody_->setDamping(tmpAttr->getLinearDamping(),
+                                tmpAttr->getAngularDamping());
+  bObjectRigidBody_->setCenterOfMassTransform(btTransform::getIdentity());
+  bObjectRigidBody_->setLinearVelocity(btVector3{0, 0, 0});
+  bObjectRigidBody_->setAngularVelocity(btVector3{0, 0, 0});
+  bObjectRigidBody_->setInterpolationLinearVelocity(btVector3{0, 0, 0});
+  bObjectRigidBody_->setInterpolationAngularVelocity(btVector3{0, 0, 0});
+  bObjectRigidBody_->clearForces();
+
+  if (motionType != MotionType::DYNAMIC ||
+      isCollidable_ != tmpAttr->getIsCollidable()) {
+    // a new body with the dynamic flags and the right shape, which copies the
+    // properties restored above
+    isCollidable_ = tmpAttr->getIsCollidable();
+    constructAndAddRigidBody(objectMotionType_);
+    return;
+  }
+  double mass = 0;
+  btVector3 inertia;
+  getTemplateMassProps(mass, inertia);
+  bObjectRigidBody_->setMassProps(mass, inertia);
+  bObjectRigidBody_->updateInertiaTensor();
+  collisionObjToObjIds_->emplace(bObjectRigidBody_.get(), objectId_);
+  bWorld_->addRigidBody(bObjectRigidBody_.get(), getCollisionGroup(),
+                        getCollisionMask());
+  setActive();
+}
+
 void BulletRigidObject::activateCollisionIsland() {
   btCollisionObject* thisColObj = bObjectRigidBody_.get();
 
@@ -503,10 +679,79 @@ Magnum::Vector3 BulletRigidObject::getCOM() const {
 
 bool BulletRigidObject::contactTest() {
   SimulationContactResultCallback src;
+  // only the contacts the filter of the object lets through
+  if (const btBroadphaseProxy* proxy =
+          bObjectRigidBody_->getBroadphaseHandle()) {
+    src.m_collisionFilterGroup = proxy->m_collisionFilterGroup;
+    src.m_collisionFilterMask = proxy->m_collisionFilterMask;
+  }
   bWorld_->getCollisionWorld()->contactTest(bObjectRigidBody_.get(), src);
   return src.bCollision;
 }  // contactTest
 
+namespace {
+// Ignores the rigid body of the object a probe stands in for
+struct ProbeContactResultCallback : SimulationContactResultCallback {
+  explicit ProbeContactResultCallback(const btCollisionObject* ignored)
+      : ignored{ignored} {}
+
+  bool needsCollision(btBroadphaseProxy* proxy) const override {
+    return proxy->m_clientObject != ignored &&
+           SimulationContactResultCallback::needsCollision(proxy);
+  }
+
+  const btCollisionObject* ignored;
+};
+}  // namespace
+
+std::vector<bool> BulletRigidObject::contactTestsAt(
+    const std::vector<Magnum::Matrix4>& transformations) {
+  std::vector<bool> contacts(transformations.size(), false);
+  if (!bObjectShape_) {
+    return contacts;
+  }
+  // the body keeps its offset from the node, e.g. of a shifted origin
+  const Magnum::Matrix4 nodeToBody =
+      node().absoluteTransformationMatrix().inverted() *
+      Magnum::Matrix4{bObjectRigidBody_->getWorldTransform()};
+
+  btCollisionObject probe;
+  probe.setCollisionShape(bObjectShape_.get());
+  ProbeContactResultCallback src{bObjectRigidBody_.get()};
+  if (const btBroadphaseProxy* proxy =
+          bObjectRigidBody_->getBroadphaseHandle()) {
+    src.m_collisionFilterGroup = proxy->m_collisionFilterGroup;
+    src.m_collisionFilterMask = proxy->m_collisionFilterMask;
+  }
+  for (std::size_t i = 0; i < transformations.size(); ++i) {
+    probe.setWorldTransform(btTransform{transformations[i] * nodeToBody});
+    src.bCollision = false;
+    bWorld_->getCollisionWorld()->contactTest(&probe, src);
+    contacts[i] = src.bCollision;
+  }
+  return contacts;
+}  // contactTestsAt
+
+std::vector<std::pair<const btConvexShape*, btTransform>>
+BulletRigidObject::getConvexShapes() const {
+  std::vector<std::pair<const btConvexShape*, btTransform>> shapes;
+  if (!bObjectShape_) {
+    return shapes;
+  }
+  const btTransform nodeToBody{
+      node().absoluteTransformationMatrix().inverted() *
+      Magnum::Matrix4{bObjectRigidBody_->getWorldTransform()}};
+  for (int i = 0; i < bObjectShape_->getNumChildShapes(); ++i) {
+    const btCollisionShape* child = bObjectShape_->getChildShape(i);
+    // the hulls and primitives of objects are all convex
+    if (child->isConvex()) {
+      shapes.emplace_back(static_cast<const btConvexShape*>(child),
+                          nodeToBody * bObjectShape_->getChildTransform(i));
+    }
+  }
+  return shapes;
+}  // getConvexShapes
+
 const Magnum::Range3D BulletRigidObject::getCollisionShapeAabb() const {
   if (!bObjectShape_) {
     // e.g. empty scene
@@ -15,8 +15,7 @@
 
 #include <Magnum/BulletIntegration/MotionState.h>
 #include <btBulletDynamicsCommon.h>
-
-#include "BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h"
+#include <utility>
 
 #include "esp/core/esp.h"
 
@@ -26,6 +25,14 @@
 namespace esp {
 namespace physics {
 
+/**
+ * @brief Convex collision hulls keyed by the collision asset and the settings
+ * they were built with, so objects instanced from the same template share one
+ * set of hulls.
+ */
+typedef std::map<std::string, std::vector<std::shared_ptr<btConvexHullShape>>>
+    ConvexHullCache;
+
 /**
  * @brief An individual rigid object instance implementing an interface with
  * Bullet physics to enable dynamic objects. See @ref btRigidBody for @ref
@@ -48,13 +55,16 @@ class BulletRigidObject : public BulletBase,
    * @param bWorld The Bullet world to which this object will belong.
    * @param collisionObjToObjIds The global map of btCollisionObjects to Habitat
    * object IDs for contact query identification.
+   * @param convexHullCache The convex hulls already built by the manager,
+   * reused and added to by this object.
    */
   BulletRigidObject(scene::SceneNode* rigidBodyNode,
                     int objectId,
                     const assets::ResourceManager& resMgr,
-                    std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+                    std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
                     std::shared_ptr<std::map<const btCollisionObject*, int>>
-                        collisionObjToObjIds);
+                        collisionObjToObjIds,
+                    std::shared_ptr<ConvexHullCache> convexHullCache);
 
   /**
    * @brief Destructor cleans up simulation structures for the object.
@@ -81,10 +91,10 @@ class BulletRigidObject : public BulletBase,
   // const assets::AbstractPrimitiveAttributes& primAttributes);
 
   /**
-   * @brief Recursively construct a @ref btCompoundShape for collision from
-   * loaded mesh assets. A @ref btConvexHullShape is constructed for each
-   * sub-component, transformed to object-local space and added to the compound
-   * in a flat manner for efficiency.
+   * @brief Recursively construct the @ref bObjectConvexShapes_ for collision
+   * from loaded mesh assets. A @ref btConvexHullShape is constructed for each
+   * sub-component and transformed to object-local space, in a flat manner for
+   * efficiency.
    * @param transformFromParentToWorld The cumulative parent-to-world
    * transformation matrix constructed by composition down the @ref
    * MeshTransformNode tree to the current node.
@@ -105,6 +115,20 @@ class BulletRigidObject : public BulletBase,
    */
   bool constructCollisionShape();
 
+  /**
+   * @brief Remove the rigid body from the world, keeping it and its collision
+   * shapes for @ref reactivate(). Wakes the objects it may support.
+   */
+  void deactivate() override;
+
+  /**
+   * @brief Add the rigid body back to the world as a new @ref
+   * MotionType::DYNAMIC instance of the template, rebuilding it only if its
+   * motion type or collidability changed. The center of mass and the margin
+   * set since the object was added are kept.
+   */
+  void reactivate(int objectId) override;
+
   /**
    * @brief Check whether object is being actively simulated, or sleeping.
    * See @ref btCollisionObject::isActive.
@@ -118,6 +142,14 @@ class BulletRigidObject : public BulletBase,
    */
   void setActive() override { bObjectRigidBody_->activate(true); }
 
+  /**
+   * @brief Put an object to sleep until a collision or a change wakes it.
+   * See @ref btCollisionObject::setActivationState.
+   */
+  void setSleeping() override {
+    bObjectRigidBody_->setActivationState(ISLAND_SLEEPING);
+  }
+
   /**
    * @brief Set the @ref MotionType of the object. The object can be set to @ref
    * MotionType::STATIC, @ref MotionType::KINEMATIC or @ref MotionType::DYNAMIC.
@@ -135,6 +167,12 @@ class BulletRigidObject : public BulletBase,
    */
   bool setCollidable(bool collidable) override;
 
+  /**
+   * @brief Set the collision filter, see
+   * @ref RigidObject::setCollisionFilter(). Re-adds the rigid body to the world, whose broadphase filters the pairs.
+   */
+  bool setCollisionFilter(int group, int mask) override;
+
   /**
    * @brief Shift the object's local origin by translating all children of this
    * @ref BulletRigidObject and all components of its @ref bObjectShape_.
@@ -403,6 +441,8 @@ class BulletRigidObject : public BulletBase,
    * @param margin The new scalar collision margin of the object.
    */
   void setMargin(const double margin) override {
+    // the hulls are shared with the other instances of the template
+    unshareConvexShapes();
     for (std::size_t i = 0; i < bObjectConvexShapes_.size(); i++) {
       bObjectConvexShapes_[i]->setMargin(margin);
     }
@@ -432,6 +472,33 @@ class BulletRigidObject : public BulletBase,
    */
   bool contactTest();
 
+  /**
+   * @brief Discrete contact tests of the collision shape of the object at a
+   * batch of transformations, without moving it.
+   *
+   * A single probe, sharing the collision shape and the collision filters of
+   * the object, is placed at each transformation. The contacts with the
+   * rigid body of the object itself are ignored.
+   * @param transformations The transformations of the object's root node.
+   * @return Whether the object would be in contact with any other collision
+   * enabled objects at each transformation.
+   */
+  std::vector<bool> contactTestsAt(
+      const std::vector<Magnum::Matrix4>& transformations);
+
+  /**
+   * @brief The convex shapes whose union is the collision shape of the
+   * object, e.g. to sweep them, each with its transformation from the
+   * object's root node.
+   */
+  std::vector<std::pair<const btConvexShape*, btTransform>> getConvexShapes()
+      const;
+
+  /** @brief The collision object of the object, e.g. to ignore it. */
+  const btCollisionObject* getCollisionObject() const {
+    return bObjectRigidBody_.get();
+  }
+
   /**
    * @brief Query the Aabb from bullet physics for the root compound shape of
    * the rigid body in its local space. See @ref btCompoundShape::getAabb.
@@ -461,12 +528,25 @@ class BulletRigidObject : public BulletBase,
    */
   void constructAndAddRigidBody(MotionType mt);
 
+  /**
+   * @brief The mass and inertia of the template for a @ref
+   * MotionType::DYNAMIC rigid body, the inertia computed from the collision
+   * shape if the template has none.
+   */
+  void getTemplateMassProps(double& mass, btVector3& inertia) const;
+
   /**
    * @brief shift all child shapes of the @ref bObjectShape_ to modify collision
    * shape origin.
    */
   void shiftObjectCollisionShape(const Magnum::Vector3& shift);
 
+  /**
+   * @brief Replace the @ref bObjectConvexShapes_ in the @ref bObjectShape_ by
+   * copies owned by this object alone, before modifying them.
+   */
+  void unshareConvexShapes();
+
   /**
    * @brief Iterate through all collision objects and active all objects sharing
    * a collision island tag with this object's collision shape.
@@ -483,8 +563,13 @@ class BulletRigidObject : public BulletBase,
   //! deffered construction of collision shape
   Mn::Vector3 originShift_;
 
-  //! Object data: Composite convex collision shape
-  std::vector<std::unique_ptr<btConvexHullShape>> bObjectConvexShapes_;
+  //! Object data: Composite convex collision shape, with the template scale
+  //! applied, shared with the other instances of the template through the
+  //! @ref convexHullCache_
+  std::vector<std::shared_ptr<btConvexHullShape>> bObjectConvexShapes_;
+
+  //! convex hulls built by all the objects of the manager
+  std::shared_ptr<ConvexHullCache> convexHullCache_;
 
   //! list of @ref btCollisionShape for storing arbitrary collision shapes
   //! referenced within the @ref bObjectShape_.
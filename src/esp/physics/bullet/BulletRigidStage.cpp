@@ -5,11 +5,23 @@
 #include <Magnum/BulletIntegration/DebugDraw.h>
 #include <Magnum/BulletIntegration/Integration.h>
 
+#include <Corrade/Utility/Directory.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
 #include <utility>
 
 #include "BulletCollision/CollisionShapes/btCompoundShape.h"
 #include "BulletCollision/CollisionShapes/btConvexHullShape.h"
 #include "BulletCollision/CollisionShapes/btConvexTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btOptimizedBvh.h"
 #include "BulletCollision/Gimpact/btGImpactShape.h"
 #include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 #include "BulletRigidStage.h"
@@ -17,10 +29,60 @@
 namespace esp {
 namespace physics {
 
+namespace {
+
+const int BVH_CACHE_MAGIC = 'B' << 24 | 'V' << 16 | 'H' << 8 | 'C';  //'BVHC';
+const int BVH_CACHE_VERSION = 1;
+
+struct BvhCacheHeader {
+  int magic;
+  int version;
+  int numMeshes;
+};
+
+// what a BVH was built for, followed by where it is in the file
+struct BvhCacheEntry {
+  int numTriangles;
+  int numVertices;
+  float scaling[3];
+  float margin;
+  uint64_t offset;
+  uint64_t size;
+};
+
+// the serialized BVHs need 16 byte alignment
+uint64_t alignBvh(uint64_t offset) {
+  return (offset + 15) & ~uint64_t{15};
+}
+
+BvhCacheEntry bvhCacheEntry(const btBvhTriangleMeshShape& shape,
+                            const btIndexedMesh& mesh) {
+  const btVector3& scaling = shape.getLocalScaling();
+  return {mesh.m_numTriangles,
+          mesh.m_numVertices,
+          {float(scaling.x()), float(scaling.y()), float(scaling.z())},
+          float(shape.getMargin()),
+          0,
+          0};
+}
+
+}  // namespace
+
+struct BulletRigidStage::BvhCacheMapping {
+  void* data = MAP_FAILED;
+  std::size_t size = 0;
+
+  ~BvhCacheMapping() {
+    if (data != MAP_FAILED) {
+      munmap(data, size);
+    }
+  }
+};
+
 BulletRigidStage::BulletRigidStage(
     scene::SceneNode* rigidBodyNode,
     const assets::ResourceManager& resMgr,
-    std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+    std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
     std::shared_ptr<std::map<const btCollisionObject*, int> >
         collisionObjToObjIds)
     : BulletBase(std::move(bWorld), std::move(collisionObjToObjIds)),
@@ -34,7 +96,7 @@ BulletRigidStage::~BulletRigidStage() {
   }
 }
 bool BulletRigidStage::initialization_LibSpecific() {
-  isCollidable_ = getInitializationAttributes()->getIsCollidable();
+  isCollidable_ = getInitializationAttributesShared()->getIsCollidable();
 
   if (isCollidable_) {
     // defer construction until necessary
@@ -78,6 +140,23 @@ void BulletRigidStage::constructAndAddCollisionObjects() {
 
     constructBulletSceneFromMeshes(Magnum::Matrix4{}, meshGroup, metaData.root);
 
+    // building the BVHs of big stages takes seconds, they are cached next to
+    // the asset
+    const std::string bvhCacheFilename =
+        Corrade::Utility::Directory::splitExtension(collisionAssetHandle)
+            .first +
+        ".bullet_bvh";
+    if (!bStageShapes_.empty() && !loadBvhCache(bvhCacheFilename)) {
+      for (auto& shape : bStageShapes_) {
+        shape->buildOptimizedBvh();
+      }
+      if (!saveBvhCache(bvhCacheFilename)) {
+        LOG(WARNING) << "BulletRigidStage::constructAndAddCollisionObjects : "
+                        "cannot cache the collision BVHs in "
+                     << bvhCacheFilename;
+      }
+    }
+
     for (auto& object : bStaticCollisionObjects_) {
       object->setFriction(initializationAttributes_->getFrictionCoefficient());
       object->setRestitution(
@@ -86,12 +165,14 @@ void BulletRigidStage::constructAndAddCollisionObjects() {
     }
   }
 
-  // add the objects to the world
+  // add the objects to the world, in a group of their own so raycasts can
+  // skip them. Static and kinematic objects never collide with them, so all
+  // other groups are in the mask, including debris and custom ones
   for (auto& object : bStaticCollisionObjects_) {
     bWorld_->addRigidBody(
-        object.get(),
-        2,       // collisionFilterGroup (2 == StaticFilter)
-        1 + 2);  // collisionFilterMask (1 == DefaultFilter, 2==StaticFilter)
+        object.get(), int(CollisionGroup::STAGE),
+        int(CollisionGroup::ALL) &
+            ~(int(CollisionGroup::STATIC) | int(CollisionGroup::STAGE)));
   }
 }
 
@@ -129,16 +210,15 @@ void BulletRigidStage::constructBulletSceneFromMeshes(
     //! Embed 3D mesh into bullet shape
     //! btBvhTriangleMeshShape is the most generic/slow choice
     //! which allows concavity if the object is static
+    //! The bvh is built or loaded once all meshes are constructed
     std::unique_ptr<btBvhTriangleMeshShape> meshShape =
         std::make_unique<btBvhTriangleMeshShape>(indexedVertexArray.get(),
-                                                 true);
+                                                 true, false);
     meshShape->setMargin(initializationAttributes_->getMargin());
-    meshShape->setLocalScaling(
-        btVector3{transformFromLocalToWorld
-                      .scaling()});  // scale is a property of the shape
-
-    // re-build the bvh after setting margin
-    meshShape->buildOptimizedBvh();
+    // scale is a property of the shape, set without the bvh rebuild of
+    // btBvhTriangleMeshShape::setLocalScaling
+    meshShape->btTriangleMeshShape::setLocalScaling(
+        btVector3{transformFromLocalToWorld.scaling()});
     // mass == 0 to indicate static. See isStaticObject assert below. See also
     // examples/MultiThreadedDemo/CommonRigidBodyMTBase.h
     btVector3 localInertia(0, 0, 0);
@@ -160,6 +240,106 @@ void BulletRigidStage::constructBulletSceneFromMeshes(
   }
 }  // constructBulletSceneFromMeshes
 
+bool BulletRigidStage::loadBvhCache(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return false;
+  }
+  const std::size_t fileSize = file.tellg();
+  file.seekg(0);
+  BvhCacheHeader header{};
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      header.magic != BVH_CACHE_MAGIC || header.version != BVH_CACHE_VERSION ||
+      header.numMeshes != int(bStageShapes_.size())) {
+    return false;
+  }
+  std::vector<BvhCacheEntry> entries(header.numMeshes);
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    const BvhCacheEntry expected = bvhCacheEntry(
+        *bStageShapes_[i], bStageArrays_[i]->getIndexedMeshArray()[0]);
+    BvhCacheEntry& entry = entries[i];
+    if (!file.read(reinterpret_cast<char*>(&entry), sizeof(entry)) ||
+        std::memcmp(&entry, &expected, offsetof(BvhCacheEntry, offset)) ||
+        entry.offset % 16 || entry.offset + entry.size > fileSize) {
+      return false;
+    }
+  }
+  file.close();
+
+  auto mapping = std::make_unique<BvhCacheMapping>();
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  // private, so deserializing in place writes only to this process' copy of
+  // the pages of the BVH headers
+  mapping->size = fileSize;
+  mapping->data = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       fd, 0);
+  close(fd);
+  if (mapping->data == MAP_FAILED) {
+    return false;
+  }
+
+  // the shapes are untouched until all BVHs are valid
+  std::vector<btOptimizedBvh*> bvhs;
+  for (const BvhCacheEntry& entry : entries) {
+    bvhs.push_back(btOptimizedBvh::deSerializeInPlace(
+        static_cast<char*>(mapping->data) + entry.offset, entry.size, false));
+    if (!bvhs.back()) {
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < bvhs.size(); ++i) {
+    bStageShapes_[i]->setOptimizedBvh(bvhs[i],
+                                      bStageShapes_[i]->getLocalScaling());
+  }
+  bvhCacheMapping_ = std::move(mapping);
+  return true;
+}  // loadBvhCache
+
+bool BulletRigidStage::saveBvhCache(const std::string& filename) const {
+  BvhCacheHeader header{BVH_CACHE_MAGIC, BVH_CACHE_VERSION,
+                        int(bStageShapes_.size())};
+  std::vector<BvhCacheEntry> entries;
+  uint64_t offset =
+      alignBvh(sizeof(header) + bStageShapes_.size() * sizeof(BvhCacheEntry));
+  for (std::size_t i = 0; i < bStageShapes_.size(); ++i) {
+    entries.push_back(bvhCacheEntry(
+        *bStageShapes_[i], bStageArrays_[i]->getIndexedMeshArray()[0]));
+    entries.back().offset = offset;
+    entries.back().size =
+        bStageShapes_[i]->getOptimizedBvh()->calculateSerializeBufferSize();
+    offset = alignBvh(offset + entries.back().size);
+  }
+
+  std::vector<char> buffer(offset + 16);
+  // the vector may not be 16 byte aligned, so shift the whole file image
+  char* data = buffer.data() + (alignBvh(uintptr_t(buffer.data())) -
+                                uintptr_t(buffer.data()));
+  std::memcpy(data, &header, sizeof(header));
+  std::memcpy(data + sizeof(header), entries.data(),
+              entries.size() * sizeof(BvhCacheEntry));
+  for (std::size_t i = 0; i < bStageShapes_.size(); ++i) {
+    if (!bStageShapes_[i]->getOptimizedBvh()->serializeInPlace(
+            data + entries[i].offset, entries[i].size, false)) {
+      return false;
+    }
+  }
+
+  // written aside and renamed, so other processes never map a partial file
+  const std::string tmpFilename =
+      filename + "." + std::to_string(getpid()) + ".tmp";
+  std::ofstream file(tmpFilename, std::ios::binary);
+  file.write(data, offset);
+  file.close();
+  if (!file || std::rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+    std::remove(tmpFilename.c_str());
+    return false;
+  }
+  return true;
+}  // saveBvhCache
+
 void BulletRigidStage::setFrictionCoefficient(
     const double frictionCoefficient) {
   for (std::size_t i = 0; i < bStaticCollisionObjects_.size(); i++) {
@@ -5,6 +5,9 @@
 #ifndef ESP_PHYSICS_BULLET_BULLETRIGIDSTAGE_H_
 #define ESP_PHYSICS_BULLET_BULLETRIGIDSTAGE_H_
 
+#include <memory>
+#include <string>
+
 #include "esp/physics/RigidStage.h"
 #include "esp/physics/bullet/BulletBase.h"
 
@@ -23,7 +26,7 @@ class BulletRigidStage : public BulletBase, public RigidStage {
  public:
   BulletRigidStage(scene::SceneNode* rigidBodyNode,
                    const assets::ResourceManager& resMgr,
-                   std::shared_ptr<btMultiBodyDynamicsWorld> bWorld,
+                   std::shared_ptr<btDiscreteDynamicsWorld> bWorld,
                    std::shared_ptr<std::map<const btCollisionObject*, int>>
                        collisionObjToObjIds);
 
@@ -62,6 +65,22 @@ class BulletRigidStage : public BulletBase, public RigidStage {
    */
   void constructAndAddCollisionObjects();
 
+  /**
+   * @brief Use the BVHs of the @ref bStageShapes_ serialized in @p filename,
+   * mapped copy-on-write so the processes loading the same stage share their
+   * memory.
+   * @param filename The cache written by @ref saveBvhCache().
+   * @return false if the file doesn't exist or doesn't match the meshes, in
+   * which case no shape is modified.
+   */
+  bool loadBvhCache(const std::string& filename);
+
+  /**
+   * @brief Serialize the BVHs of the @ref bStageShapes_ to @p filename.
+   * @return Whether the file was written.
+   */
+  bool saveBvhCache(const std::string& filename) const;
+
   /**
    * @brief Set the stage to collidable or not by adding/removing the static
    * collision shapes from the simulation world.
@@ -108,6 +127,11 @@ class BulletRigidStage : public BulletBase, public RigidStage {
   //! Stage data: Bullet triangular mesh vertices
   std::vector<std::unique_ptr<btTriangleIndexVertexArray>> bStageArrays_;
 
+  struct BvhCacheMapping;
+  //! Mapped file holding the BVHs of the @ref bStageShapes_ if they were
+  //! loaded by @ref loadBvhCache(), released after the shapes
+  std::unique_ptr<BvhCacheMapping> bvhCacheMapping_;
+
   //! Stage data: Bullet triangular mesh shape
   std::vector<std::unique_ptr<btBvhTriangleMeshShape>> bStageShapes_;
 
@@ -34,6 +34,7 @@ struct Mp3dRegionCategory : public SemanticCategory {
 
  protected:
   char labelCode_;
+  friend SemanticScene;
 
   ESP_SMART_POINTERS(Mp3dRegionCategory)
 };
@@ -4,7 +4,9 @@
 
 #include "ObjectControls.h"
 
+#include <Corrade/Containers/ArrayView.h>
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/Math/Quaternion.h>
 
 #include <utility>
 
@@ -66,6 +68,34 @@ SceneNode& lookDown(SceneNode& object, float angleInDegrees) {
   return lookUp(object, -angleInDegrees);
 }
 
+namespace {
+
+// Built-in actions of actionBatch(), moving along or turning around an axis
+// of the object
+struct BatchAction {
+  const char* name;
+  bool turn;
+  Magnum::Vector3 axis;
+};
+
+const BatchAction batchActions[]{
+    {"moveRight", false, Magnum::Vector3::xAxis()},
+    {"moveLeft", false, -Magnum::Vector3::xAxis()},
+    {"moveUp", false, Magnum::Vector3::yAxis()},
+    {"moveDown", false, -Magnum::Vector3::yAxis()},
+    {"moveForward", false, -Magnum::Vector3::zAxis()},
+    {"moveBackward", false, Magnum::Vector3::zAxis()},
+    {"turnLeft", true, Magnum::Vector3::yAxis()},
+    {"turnRight", true, -Magnum::Vector3::yAxis()},
+    {"lookUp", true, Magnum::Vector3::xAxis()},
+    {"lookDown", true, -Magnum::Vector3::xAxis()},
+};
+
+// Same as the Python controls, a move that got shorter collided
+constexpr float collisionEps = 1e-5f;
+
+}  // namespace
+
 ObjectControls::ObjectControls() {
   moveFuncMap_["moveRight"] = &moveRight;
   moveFuncMap_["moveLeft"] = &moveLeft;
@@ -85,6 +115,91 @@ ObjectControls& ObjectControls::setMoveFilterFunction(
   return *this;
 }
 
+ObjectControls& ObjectControls::setBatchMoveFilterFunction(
+    BatchMoveFilterFunc filterFunc) {
+  batchMoveFilterFunc_ = std::move(filterFunc);
+  return *this;
+}
+
+int ObjectControls::actionId(const std::string& actName) {
+  for (std::size_t i = 0; i < Corrade::Containers::arraySize(batchActions);
+       ++i) {
+    if (actName == batchActions[i].name)
+      return i;
+  }
+  return ID_UNDEFINED;
+}
+
+std::vector<bool> ObjectControls::actionBatch(
+    const std::vector<int>& actionIds,
+    const std::vector<float>& amounts,
+    std::vector<core::RigidState>& states,
+    bool applyFilter /* = true */) {
+  CORRADE_ASSERT(actionIds.size() == states.size() &&
+                     amounts.size() == states.size(),
+                 "ObjectControls::actionBatch(): got"
+                     << actionIds.size() << "actions and" << amounts.size()
+                     << "amounts for" << states.size() << "states",
+                 {});
+  const int numActions = Corrade::Containers::arraySize(batchActions);
+
+  // The moves to filter, turns don't change the translation
+  std::vector<std::size_t> moved;
+  std::vector<Magnum::Vector3> starts, ends;
+  for (std::size_t i = 0; i < states.size(); ++i) {
+    const int id = actionIds[i];
+    if (id == ID_UNDEFINED)
+      continue;
+    CORRADE_ASSERT(id >= 0 && id < numActions,
+                   "ObjectControls::actionBatch(): unknown action id" << id,
+                   {});
+    const BatchAction& act = batchActions[id];
+    core::RigidState& state = states[i];
+    if (act.turn) {
+      state.rotation = (state.rotation * Magnum::Quaternion::rotation(
+                                             Magnum::Deg{amounts[i]}, act.axis))
+                           .normalized();
+      continue;
+    }
+    const Magnum::Vector3 end =
+        state.translation + state.rotation.transformVector(act.axis) *
+                                amounts[i];
+    if (applyFilter) {
+      moved.push_back(i);
+      starts.push_back(state.translation);
+      ends.push_back(end);
+    }
+    state.translation = end;
+  }
+
+  std::vector<bool> collided(states.size(), false);
+  if (moved.empty())
+    return collided;
+
+  std::vector<Magnum::Vector3> filtered;
+  if (batchMoveFilterFunc_) {
+    filtered = batchMoveFilterFunc_(starts, ends);
+    CORRADE_ASSERT(filtered.size() == ends.size(),
+                   "ObjectControls::actionBatch(): the filter returned"
+                       << filtered.size() << "ends for" << ends.size()
+                       << "moves",
+                   {});
+  } else {
+    filtered.reserve(ends.size());
+    for (std::size_t j = 0; j < ends.size(); ++j) {
+      filtered.emplace_back(
+          moveFilterFunc_(cast<vec3f>(starts[j]), cast<vec3f>(ends[j])));
+    }
+  }
+
+  for (std::size_t j = 0; j < moved.size(); ++j) {
+    states[moved[j]].translation = filtered[j];
+    collided[moved[j]] = (filtered[j] - starts[j]).dot() + collisionEps <
+                         (ends[j] - starts[j]).dot();
+  }
+  return collided;
+}
+
 ObjectControls& ObjectControls::action(SceneNode& object,
                                        const std::string& actName,
                                        float distance,
@@ -8,7 +8,12 @@
 #include <functional>
 #include <map>
 #include <string>
+#include <vector>
 
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "esp/core/RigidState.h"
 #include "esp/core/esp.h"
 
 namespace esp {
@@ -25,6 +30,23 @@ class ObjectControls {
   typedef std::function<vec3f(const vec3f&, const vec3f&)> MoveFilterFunc;
   ObjectControls& setMoveFilterFunction(MoveFilterFunc filterFunc);
 
+  /**
+   * @brief Filters many moves at once, returns the filtered end of each move
+   * from its start to its end, e.g. @ref nav::PathFinder::tryStepBatch()
+   */
+  typedef std::function<std::vector<Magnum::Vector3>(
+      const std::vector<Magnum::Vector3>&,
+      const std::vector<Magnum::Vector3>&)>
+      BatchMoveFilterFunc;
+
+  /**
+   * @brief Set the filter of the moves of @ref actionBatch()
+   *
+   * Without one, each move is filtered by the function of @ref
+   * setMoveFilterFunction().
+   */
+  ObjectControls& setBatchMoveFilterFunction(BatchMoveFilterFunc filterFunc);
+
   ObjectControls& action(SceneNode& object,
                          const std::string& actName,
                          float distance,
@@ -40,11 +62,40 @@ class ObjectControls {
     return moveFuncMap_;
   }
 
+  /**
+   * @brief The id of an action for @ref actionBatch(), ID_UNDEFINED if it
+   * isn't one of the built-in moves and turns
+   */
+  static int actionId(const std::string& actName);
+
+  /**
+   * @brief Take one action with each of many objects at once, e.g. the
+   * agents of a batch of environments
+   *
+   * Same as @ref action() on the states of the objects instead of their
+   * @ref SceneNode, for the built-in actions. The moves are all filtered by a
+   * single call of the function of @ref setBatchMoveFilterFunction(), so e.g.
+   * the navmesh takes them in parallel.
+   *
+   * @param[in] actionIds The @ref actionId() of the action of each object,
+   *                      ID_UNDEFINED for the objects that don't move
+   * @param[in] amounts The distance or angle in degrees of each action
+   * @param[in,out] states The state of each object, updated in place
+   * @param[in] applyFilter Whether to filter the moves
+   *
+   * @return Whether each move was shortened by the filter, i.e. collided
+   */
+  std::vector<bool> actionBatch(const std::vector<int>& actionIds,
+                                const std::vector<float>& amounts,
+                                std::vector<core::RigidState>& states,
+                                bool applyFilter = true);
+
  protected:
   MoveFilterFunc moveFilterFunc_ = [](const vec3f& start, const vec3f& end) {
     return end;
   };
   std::map<std::string, MoveFunc> moveFuncMap_;
+  BatchMoveFilterFunc batchMoveFilterFunc_;
 
   ESP_SMART_POINTERS(ObjectControls)
 };
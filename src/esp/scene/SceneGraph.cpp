@@ -11,9 +11,11 @@ namespace esp {
 namespace scene {
 
 SceneGraph::SceneGraph()
-    : rootNode_{world_},
+    : rootNode_{world_, arena_.get()},
       defaultRenderCameraNode_{rootNode_},
-      defaultRenderCamera_{defaultRenderCameraNode_} {
+      defaultRenderCamera_{defaultRenderCameraNode_},
+      defaultCubeMapCameraNode_{rootNode_},
+      defaultCubeMapCamera_{defaultCubeMapCameraNode_} {
   // For now, just create one drawable group with empty string uuid
   createDrawableGroup(std::string{});
 }
@@ -27,6 +29,59 @@ void SceneGraph::setDefaultRenderCamera(sensor::VisualSensor& sensor) {
       .setViewport(defaultRenderCamera_);
 }
 
+void SceneGraph::rebuildTransformHierarchy() {
+  transformNodes_.clear();
+  transformParents_.clear();
+  // (node, index of its parent)
+  std::vector<std::pair<SceneNode*, int>> stack{{&rootNode_, ID_UNDEFINED}};
+  while (!stack.empty()) {
+    const std::pair<SceneNode*, int> entry = stack.back();
+    stack.pop_back();
+    const int index = transformNodes_.size();
+    transformNodes_.push_back(entry.first);
+    transformParents_.push_back(entry.second);
+    for (MagnumObject& child : entry.first->children()) {
+      // other objects, e.g. created from python, are left to Magnum
+      auto* childNode = dynamic_cast<SceneNode*>(&child);
+      if (childNode) {
+        stack.emplace_back(childNode, index);
+      }
+    }
+  }
+  transformTopologyVersion_ = SceneNode::topologyVersion();
+}
+
+void SceneGraph::updateTransformations() {
+  if (transformTopologyVersion_ != SceneNode::topologyVersion()) {
+    rebuildTransformHierarchy();
+  }
+  for (size_t i = 0; i < transformNodes_.size(); ++i) {
+    SceneNode& node = *transformNodes_[i];
+    if (!node.isDirty()) {
+      continue;
+    }
+    const int parent = transformParents_[i];
+    const MagnumObject* expectedParent =
+        parent == ID_UNDEFINED ? static_cast<const MagnumObject*>(&world_)
+                               : transformNodes_[parent];
+    // reparenting marks the node dirty, so only dirty nodes need the check
+    if (node.parent() != expectedParent) {
+      // the nodes before i are clean, so this starts over from them cheaply
+      rebuildTransformHierarchy();
+      updateTransformations();
+      return;
+    }
+    // the world is at the origin
+    node.absoluteTransformationCache_ =
+        parent == ID_UNDEFINED
+            ? node.transformationMatrix()
+            : transformNodes_[parent]->absoluteTransformationCache_ *
+                  node.transformationMatrix();
+    node.absoluteMeshBBDirty_ = true;
+    node.setClean();
+  }
+}
+
 bool SceneGraph::isRootNode(SceneNode& node) {
   auto parent = node.parent();
   // if the parent is null, it means the node is the world_ node.
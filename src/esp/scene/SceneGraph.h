@@ -6,11 +6,13 @@
 #define ESP_SCENE_SCENEGRAPH_H
 
 #include <unordered_map>
+#include <vector>
 
 #include "esp/core/esp.h"
 #include "esp/gfx/magnum.h"
 
 #include "SceneNode.h"
+#include "esp/gfx/CubeMapCamera.h"
 #include "esp/gfx/DrawableGroup.h"
 #include "esp/gfx/RenderCamera.h"
 
@@ -43,10 +45,41 @@ class SceneGraph {
 
   gfx::RenderCamera& getDefaultRenderCamera() { return defaultRenderCamera_; }
 
+  /**
+   * @brief A default camera to render cube maps of the scene, e.g. for
+   * equirectangular and fisheye sensors. Like the default render camera, it
+   * is shared by all users, which have to set its transformation and
+   * projection before drawing.
+   */
+  gfx::CubeMapCamera& getDefaultCubeMapCamera() {
+    return defaultCubeMapCamera_;
+  }
+
+  /**
+   * @brief The arena of the nodes created under the root node and of their
+   * drawables, freed at once with the scene graph
+   */
+  const core::ObjectArena& getArena() const { return *arena_; }
+
   /* @brief check if the scene node is the root node of the scene graph.
    */
   static bool isRootNode(SceneNode& node);
 
+  /**
+   * @brief Update the cached absolute transformations of the nodes that
+   * moved, in one pass
+   *
+   * The nodes are kept flattened in pre-order with the indices of their
+   * parents, so the pass walks an array instead of the tree, and each dirty
+   * node is composed with the cache of its parent, which is always up to date
+   * by then. The flattened order is rebuilt after nodes are created,
+   * destroyed or reparented. Called before each draw; afterwards @ref
+   * SceneNode::cachedAbsoluteTransformationMatrix() and @ref
+   * SceneNode::cachedAbsoluteMeshBB(), which culling and the gfx replay
+   * recorder use, no longer walk up the tree.
+   */
+  void updateTransformations();
+
   // Drawable group management
   // TODO: move this to separate class
 
@@ -102,6 +135,13 @@ class SceneGraph {
   bool deleteDrawableGroup(const std::string& id);
 
  protected:
+  //! flatten the tree under rootNode_ into transformNodes_
+  void rebuildTransformHierarchy();
+
+  //! See @ref getArena(), declared before the scene so that it's released
+  //! after the nodes are destroyed
+  core::ObjectArena::uptr arena_ = core::ObjectArena::create();
+
   MagnumScene world_;
 
   // Each item within is a base node, parent of all in that scene, for easy
@@ -116,7 +156,7 @@ class SceneGraph {
   // The transformation matrix between rootNode_ and world_
   // is ALWAYS an IDENTITY matrix.
   // DO NOT add any other transformation in between!!
-  SceneNode rootNode_{world_};
+  SceneNode rootNode_{world_, arena_.get()};
 
   // Again, order matters! do not change the sequence!!
   // CANNOT make defaultRenderCameraNode_ specified BEFORE rootNode_.
@@ -126,6 +166,10 @@ class SceneGraph {
   // user can of course define her own RenderCamera for rendering
   gfx::RenderCamera defaultRenderCamera_;
 
+  // same as above, for rendering cube maps
+  SceneNode defaultCubeMapCameraNode_{rootNode_};
+  gfx::CubeMapCamera defaultCubeMapCamera_;
+
   // ==== Drawables ====
   // for each scene node in a scene graph,
   // we create a drawable object (e.g., PTexMeshDrawable, InstanceMeshDrawable,
@@ -135,6 +179,15 @@ class SceneGraph {
   // drawable groups for this scene graph
   // This is a mapping from (groupID -> group of drawables).
   DrawableGroups drawableGroups_;
+
+  // ==== Flattened hierarchy for updateTransformations() ====
+  //! the nodes in pre-order, so parents come before their children
+  std::vector<SceneNode*> transformNodes_;
+  //! index of the parent of each node in transformNodes_, ID_UNDEFINED for
+  //! rootNode_
+  std::vector<int> transformParents_;
+  //! SceneNode::topologyVersion() at the last rebuild
+  uint64_t transformTopologyVersion_ = 0;
 };
 }  // namespace scene
 }  // namespace esp
@@ -5,47 +5,125 @@
 #include "SceneNode.h"
 #include "esp/geo/geo.h"
 
+#include <atomic>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Utility/Assert.h>
+
 namespace Mn = Magnum;
 
 namespace esp {
 namespace scene {
 
-SceneNode::SceneNode(SceneNode& parent) {
+namespace {
+std::atomic<uint64_t> topologyCounter{0};
+}  // namespace
+
+SceneNode::SceneNode(SceneNode& parent) : arena_{parent.arena_} {
   setParent(&parent);
   setId(parent.getId());
+  ++topologyCounter;
 }
 
-SceneNode::SceneNode(MagnumScene& parentNode) {
+SceneNode::SceneNode(MagnumScene& parentNode, core::ObjectArena* arena)
+    : arena_{arena} {
   setParent(&parentNode);
+  ++topologyCounter;
+}
+
+SceneNode::~SceneNode() {
+  ++topologyCounter;
+}
+
+uint64_t SceneNode::topologyVersion() {
+  return topologyCounter;
 }
 
 SceneNode& SceneNode::createChild() {
   // will set the parent to *this
-  SceneNode* node = new SceneNode(*this);
+  SceneNode* node = new (arena_) SceneNode(*this);
   node->setId(this->getId());
   return *node;
 }
 
+const Mn::Matrix4& SceneNode::cachedAbsoluteTransformationMatrix() {
+  if (isDirty()) {
+    // the parents have to be cleaned first, Magnum expects every child of a
+    // dirty node to be dirty as well
+    auto* parentNode = dynamic_cast<SceneNode*>(parent());
+    if (parentNode) {
+      absoluteTransformationCache_ =
+          parentNode->cachedAbsoluteTransformationMatrix() *
+          transformationMatrix();
+    } else {
+      absoluteTransformationCache_ = absoluteTransformationMatrix();
+    }
+    setClean();
+    absoluteMeshBBDirty_ = true;
+  }
+  return absoluteTransformationCache_;
+}
+
+const Mn::Range3D& SceneNode::cachedAbsoluteMeshBB() {
+  // cleaning the transformation is what marks the box dirty
+  const Mn::Matrix4& transformation = cachedAbsoluteTransformationMatrix();
+  if (absoluteMeshBBDirty_) {
+    absoluteMeshBBCache_ = geo::getTransformedBB(meshBB_, transformation);
+    absoluteMeshBBDirty_ = false;
+  }
+  return absoluteMeshBBCache_;
+}
+
 //! @brief recursively compute the cumulative bounding box of this node's tree.
 const Mn::Range3D& SceneNode::computeCumulativeBB() {
   // first copy from your precomputed mesh bb
   cumulativeBB_ = Mn::Range3D(meshBB_);
   auto* child = children().first();
 
+  // transform the boxes of all the children in one batch
+  std::vector<Mn::Range3D> childBBs;
+  std::vector<Mn::Matrix4> childTransformations;
   while (child != nullptr) {
     SceneNode* child_node = dynamic_cast<SceneNode*>(child);
     if (child_node != nullptr) {
-      child_node->computeCumulativeBB();
-
-      Mn::Range3D transformedBB = esp::geo::getTransformedBB(
-          child_node->cumulativeBB_, child_node->transformation());
-
-      cumulativeBB_ = Mn::Math::join(cumulativeBB_, transformedBB);
+      childBBs.push_back(child_node->computeCumulativeBB());
+      childTransformations.push_back(child_node->transformation());
     }
     child = child->nextSibling();
   }
+  std::vector<Mn::Range3D> transformedBBs(childBBs.size());
+  esp::geo::getTransformedBBs(childBBs, childTransformations, transformedBBs);
+  for (const Mn::Range3D& transformedBB : transformedBBs) {
+    cumulativeBB_ = Mn::Math::join(cumulativeBB_, transformedBB);
+  }
   return cumulativeBB_;
 }
 
+void getRigidStates(Corrade::Containers::ArrayView<SceneNode* const> nodes,
+                    Corrade::Containers::ArrayView<core::RigidState> states) {
+  CORRADE_ASSERT(states.size() == nodes.size(),
+                 "scene::getRigidStates(): expected" << nodes.size()
+                                                     << "states, got"
+                                                     << states.size(), );
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    states[i].rotation = nodes[i]->rotation();
+    states[i].translation = nodes[i]->translation();
+  }
+}
+
+void setRigidStates(
+    Corrade::Containers::ArrayView<SceneNode* const> nodes,
+    Corrade::Containers::ArrayView<const core::RigidState> states) {
+  CORRADE_ASSERT(states.size() == nodes.size(),
+                 "scene::setRigidStates(): expected" << nodes.size()
+                                                     << "states, got"
+                                                     << states.size(), );
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i]->setTranslation(states[i].translation);
+    nodes[i]->setRotation(states[i].rotation);
+  }
+}
+
 }  // namespace scene
 }  // namespace esp
@@ -6,11 +6,14 @@
 #define ESP_SCENE_SCENENODE_H_
 
 #include <stack>
+#include <type_traits>
 
 #include <Corrade/Containers/Containers.h>
 #include <Corrade/Containers/Optional.h>
 #include <Magnum/Math/Range.h>
 
+#include "esp/core/ObjectArena.h"
+#include "esp/core/RigidState.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/magnum.h"
 
@@ -32,7 +35,15 @@ enum class SceneNodeType {
   OBJECT = 4,  // objects added via physics api
 };
 
-class SceneNode : public MagnumObject {
+/**
+ * @brief A node of a @ref SceneGraph
+ *
+ * The nodes made by @ref createChild() and the features of @ref
+ * esp::core::ArenaAllocated types, e.g. the drawables, added with @ref
+ * addFeature() live in the arena of their scene graph, inherited from the
+ * parent node.
+ */
+class SceneNode : public MagnumObject, public core::ArenaAllocated {
  public:
   // creating a scene node "in the air" is not allowed.
   // it must set an existing node as its parent node.
@@ -40,6 +51,16 @@ class SceneNode : public MagnumObject {
   // terminate node (e.g., "MagnumScene" defined in SceneGraph) as its ancestor
   SceneNode() = delete;
   SceneNode(SceneNode& parent);
+  ~SceneNode() override;
+
+  /**
+   * @brief A counter incremented whenever a scene node is created or
+   * destroyed, in any scene graph
+   *
+   * Lets @ref SceneGraph::updateTransformations() know when its flattened
+   * copy of the hierarchy is out of date.
+   */
+  static uint64_t topologyVersion();
 
   // get the type of the attached object
   SceneNodeType getType() const { return type_; }
@@ -48,10 +69,14 @@ class SceneNode : public MagnumObject {
   // Add a feature. Used to avoid naked `new` and makes intent clearer.
   template <class U, class... Args>
   void addFeature(Args&&... args) {
-    // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
-    new U{*this, std::forward<Args>(args)...};
+    newFeature<U>(std::is_base_of<core::ArenaAllocated, U>{},
+                  std::forward<Args>(args)...);
   }
 
+  //! The arena the children and features of the node are allocated in, or
+  //! nullptr for the heap
+  core::ObjectArena* arena() const { return arena_; }
+
   //! Create a new child SceneNode and return it. NOTE: this SceneNode owns and
   //! is responsible for deallocating created child
   //! NOTE: child node inherits parent id by default
@@ -73,6 +98,30 @@ class SceneNode : public MagnumObject {
     return this->absoluteTransformation().translation();
   }
 
+  /**
+   * @brief Absolute transformation matrix, cached until this node or one of
+   * its parents moves
+   *
+   * Uses the dirty flag Magnum sets on a node and all of its children when a
+   * transformation changes, so repeated queries within a frame (e.g. one per
+   * sensor) only recompute nodes that moved. The flag is cleared here, so
+   * nothing else should call @ref Magnum::SceneGraph::Object::setClean() on
+   * scene nodes.
+   */
+  const Magnum::Matrix4& cachedAbsoluteTransformationMatrix();
+
+  /**
+   * @brief World-space bounding box of the mesh of this node, cached until
+   * this node or one of its parents moves
+   *
+   * The box of @ref getMeshBB() transformed by @ref
+   * cachedAbsoluteTransformationMatrix(), for the nodes of dynamic objects
+   * that have no @ref getAbsoluteAABB(). It is only recomputed when the
+   * absolute transformation or the mesh bounding box changed, so culling a
+   * scene where few objects move costs a lookup per static object.
+   */
+  const Magnum::Range3D& cachedAbsoluteMeshBB();
+
   //! recursively compute the cumulative bounding box of the full scene graph
   //! tree for which this node is the root
   const Magnum::Range3D& computeCumulativeBB();
@@ -90,7 +139,10 @@ class SceneNode : public MagnumObject {
   const Magnum::Range3D& getCumulativeBB() const { return cumulativeBB_; };
 
   //! set local bounding box for meshes stored at this node
-  void setMeshBB(Magnum::Range3D meshBB) { meshBB_ = std::move(meshBB); };
+  void setMeshBB(Magnum::Range3D meshBB) {
+    meshBB_ = std::move(meshBB);
+    absoluteMeshBBDirty_ = true;
+  };
 
   //! set the global bounding box for mesh stored in this node
   void setAbsoluteAABB(Magnum::Range3D aabb) { aabb_ = std::move(aabb); };
@@ -105,7 +157,22 @@ class SceneNode : public MagnumObject {
   // DO not make the following constructor public!
   // it can ONLY be called from SceneGraph class to initialize the scene graph
   friend class SceneGraph;
-  SceneNode(MagnumScene& parentNode);
+  SceneNode(MagnumScene& parentNode, core::ObjectArena* arena = nullptr);
+
+  template <class U, class... Args>
+  void newFeature(std::true_type, Args&&... args) {
+    // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
+    new (arena_) U{*this, std::forward<Args>(args)...};
+  }
+
+  template <class U, class... Args>
+  void newFeature(std::false_type, Args&&... args) {
+    // NOLINTNEXTLINE(clang-analyzer-cplusplus.NewDeleteLeaks)
+    new U{*this, std::forward<Args>(args)...};
+  }
+
+  //! See @ref arena()
+  core::ObjectArena* arena_ = nullptr;
 
   // the type of the attached object (e.g., sensor, agent etc.)
   SceneNodeType type_ = SceneNodeType::EMPTY;
@@ -132,8 +199,35 @@ class SceneNode : public MagnumObject {
 
   //! the frustum plane in last frame that culls this node
   int frustumPlaneIndex = 0;
+
+  //! absolute transformation, valid while the node is not dirty
+  Magnum::Matrix4 absoluteTransformationCache_;
+
+  //! world-space mesh bounding box, valid while absoluteMeshBBDirty_ is false
+  Magnum::Range3D absoluteMeshBBCache_;
+  bool absoluteMeshBBDirty_ = true;
 };
 
+/**
+ * @brief Read the transformations of many nodes relative to their parents
+ *
+ * Writes into @p states, which has the size of @p nodes, e.g. an array
+ * shared with Python, so reading the bodies of many agents each step
+ * allocates nothing.
+ */
+void getRigidStates(Corrade::Containers::ArrayView<SceneNode* const> nodes,
+                    Corrade::Containers::ArrayView<core::RigidState> states);
+
+/**
+ * @brief Set the transformations of many nodes relative to their parents
+ *
+ * The counterpart of @ref getRigidStates(), @p states has the size of
+ * @p nodes.
+ */
+void setRigidStates(
+    Corrade::Containers::ArrayView<SceneNode* const> nodes,
+    Corrade::Containers::ArrayView<const core::RigidState> states);
+
 // Traversal Helpers
 
 /**
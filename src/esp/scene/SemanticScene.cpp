@@ -0,0 +1,83 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SemanticScene.h"
+
+#include <algorithm>
+
+namespace esp {
+namespace scene {
+
+size_t SemanticScene::semanticIdTableSize() const {
+  int maxId = -1;
+  for (const auto& object : objects_) {
+    if (object) {
+      maxId = std::max(maxId, object->index_);
+    }
+  }
+  return size_t(maxId + 1);
+}
+
+std::vector<uint32_t> SemanticScene::semanticIdToCategoryIndex(
+    const std::string& mapping) const {
+  std::vector<uint32_t> table(semanticIdTableSize(), 0);
+  for (const auto& object : objects_) {
+    if (!object || object->index_ < 0 || !object->category_) {
+      continue;
+    }
+    const int categoryIndex = object->category_->index(mapping);
+    if (categoryIndex >= 0) {
+      table[object->index_] = uint32_t(categoryIndex);
+    }
+  }
+  return table;
+}
+
+size_t SemanticScene::getHostBytes() const {
+  const size_t pointerBytes = sizeof(std::shared_ptr<void>);
+  size_t bytes = categories_.size() * pointerBytes +
+                 objects_.size() * (sizeof(SemanticObject) + pointerBytes) +
+                 segmentToObjectIndex_.size() * 2 * sizeof(int);
+  for (const auto& category : categories_) {
+    if (category) {
+      bytes += sizeof(SemanticCategory);
+    }
+  }
+  for (const auto& level : levels_) {
+    bytes += pointerBytes;
+    if (level) {
+      bytes += sizeof(SemanticLevel) +
+               (level->objects_.size() + level->regions_.size()) * pointerBytes;
+    }
+  }
+  for (const auto& region : regions_) {
+    bytes += pointerBytes;
+    if (region) {
+      bytes += sizeof(SemanticRegion) +
+               region->floorPoints_.size() * sizeof(vec3f) +
+               region->objects_.size() * pointerBytes;
+    }
+  }
+  return bytes;
+}
+
+std::vector<uint32_t> SemanticScene::semanticIdToInstanceId() const {
+  std::vector<uint32_t> table(semanticIdTableSize(), 0);
+  for (const auto& object : objects_) {
+    if (object && object->index_ >= 0) {
+      table[object->index_] = 1;
+    }
+  }
+  // the ranks of the ids present
+  uint32_t nextInstanceId = 1;
+  for (uint32_t& instanceId : table) {
+    if (instanceId) {
+      instanceId = nextInstanceId++;
+    }
+  }
+  return table;
+}
+
+}  // namespace scene
+}  // namespace esp
@@ -71,6 +71,22 @@ class SemanticScene {
     return segmentToObjectIndex_;
   }
 
+  //! table from the semantic ids of the objects, i.e. the object ids of
+  //! semantic observations, to the index of their category under mapping,
+  //! see SemanticCategory::index(); 0 for ids of no object or of objects
+  //! with no category
+  std::vector<uint32_t> semanticIdToCategoryIndex(
+      const std::string& mapping = "") const;
+
+  //! table from the semantic ids of the objects to compact instance ids,
+  //! numbering the objects from 1 in increasing semantic id order; 0 for ids
+  //! of no object
+  std::vector<uint32_t> semanticIdToInstanceId() const;
+
+  //! the estimated memory of the levels, regions, objects and categories and
+  //! of the tables between them, in bytes, not counting their strings
+  size_t getHostBytes() const;
+
   //! convert semantic mesh mask index to object index or ID_UNDEFINED if
   //! not mapped
   inline int semanticIndexToObjectIndex(int maskIndex) const {
@@ -107,7 +123,37 @@ class SemanticScene {
                              SemanticScene& scene,
                              const quatf& rotation = quatf::Identity());
 
+  //! the file the SemanticScene of houseFilename is cached in under
+  //! directory, see saveCache()
+  static std::string cacheFilename(const std::string& directory,
+                                   const std::string& houseFilename);
+
+  //! load SemanticScene from the file saveCache() wrote for houseFilename
+  //! and rotation, mapping it instead of parsing the house file. Returns
+  //! false, leaving scene untouched, if the file is missing or invalid, was
+  //! written for another rotation or before houseFilename last changed.
+  static bool loadCache(
+      const std::string& cacheFilename,
+      const std::string& houseFilename,
+      SemanticScene& scene,
+      const quatf& rotation = quatf::FromTwoVectors(-vec3f::UnitZ(),
+                                                    geo::ESP_GRAVITY));
+
+  //! save a SemanticScene loaded from houseFilename with rotation in a
+  //! compact binary file, written atomically so that several processes can
+  //! share it. Returns false if the file can't be written, or for SUNCG
+  //! scenes, which aren't cached.
+  static bool saveCache(
+      const std::string& cacheFilename,
+      const std::string& houseFilename,
+      const SemanticScene& scene,
+      const quatf& rotation = quatf::FromTwoVectors(-vec3f::UnitZ(),
+                                                    geo::ESP_GRAVITY));
+
  protected:
+  //! one past the largest semantic id of the objects
+  size_t semanticIdTableSize() const;
+
   std::string name_;
   std::string label_;
   box3f bbox_;
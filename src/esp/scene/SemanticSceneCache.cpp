@@ -0,0 +1,580 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SemanticScene.h"
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Directory.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <typeinfo>
+#include <unordered_map>
+
+#include "GibsonSemanticScene.h"
+#include "Mp3dSemanticScene.h"
+#include "ReplicaSemanticScene.h"
+#include "esp/core/MappedFile.h"
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace scene {
+
+namespace {
+
+constexpr char Magic[8] = {'e', 's', 'p', 's', 'e', 'm', '\0', '\0'};
+constexpr std::uint32_t Version = 1;
+
+// followed by the fields of the scene, in the order saveCache() writes them
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t padding;
+  std::uint64_t sourceSize;
+  std::int64_t sourceModified;
+  // the coefficients of the rotation the house was loaded with
+  float rotation[4];
+};
+
+enum class CategoryKind : std::uint8_t {
+  Mp3dObject,
+  Mp3dRegion,
+  Replica,
+  Gibson,
+};
+
+struct SourceStamp {
+  std::uint64_t size;
+  std::int64_t modified;
+};
+
+bool sourceStamp(const std::string& filename, SourceStamp& stamp) {
+  struct stat status;
+  if (::stat(filename.c_str(), &status) != 0) {
+    return false;
+  }
+  stamp.size = status.st_size;
+  stamp.modified = status.st_mtime;
+  return true;
+}
+
+class Writer {
+ public:
+  template <class T>
+  void value(const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    data_.insert(data_.end(), bytes, bytes + sizeof(T));
+  }
+
+  void string(const std::string& string) {
+    value(std::uint32_t(string.size()));
+    data_.insert(data_.end(), string.begin(), string.end());
+  }
+
+  void vector(const vec3f& vector) {
+    value(vector.x());
+    value(vector.y());
+    value(vector.z());
+  }
+
+  void box(const box3f& box) {
+    vector(box.min());
+    vector(box.max());
+  }
+
+  void indices(const std::vector<std::int32_t>& indices) {
+    value(std::uint32_t(indices.size()));
+    for (const std::int32_t index : indices) {
+      value(index);
+    }
+  }
+
+  std::vector<char>& data() { return data_; }
+
+ private:
+  std::vector<char> data_;
+};
+
+// Reads the fields back, failing for good at the first one past the end
+class Reader {
+ public:
+  explicit Reader(Cr::Containers::ArrayView<const char> data) : data_{data} {}
+
+  bool failed() const { return failed_; }
+
+  bool atEnd() const { return offset_ == data_.size(); }
+
+  template <class T>
+  T value() {
+    T value{};
+    if (data_.size() - offset_ < sizeof(T)) {
+      failed_ = true;
+      return value;
+    }
+    std::memcpy(&value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  // a number of elements of at least elementSize bytes each, 0 if there
+  // aren't as many bytes left, so that invalid files allocate nothing large
+  std::uint32_t count(std::size_t elementSize) {
+    const std::uint32_t count = value<std::uint32_t>();
+    if (count > (data_.size() - offset_) / elementSize) {
+      failed_ = true;
+      return 0;
+    }
+    return count;
+  }
+
+  std::string string() {
+    const std::uint32_t size = count(1);
+    std::string string{data_.data() + offset_, size};
+    offset_ += size;
+    return string;
+  }
+
+  vec3f vector() {
+    const float x = value<float>();
+    const float y = value<float>();
+    const float z = value<float>();
+    return vec3f{x, y, z};
+  }
+
+  box3f box() {
+    const vec3f min = vector();
+    const vec3f max = vector();
+    return box3f{min, max};
+  }
+
+  std::vector<std::int32_t> indices() {
+    std::vector<std::int32_t> indices(count(sizeof(std::int32_t)));
+    for (std::int32_t& index : indices) {
+      index = value<std::int32_t>();
+    }
+    return indices;
+  }
+
+ private:
+  Cr::Containers::ArrayView<const char> data_;
+  std::size_t offset_ = 0;
+  bool failed_ = false;
+};
+
+// The positions of the elements of a list, to store references to them
+template <class T>
+class Positions {
+ public:
+  explicit Positions(const std::vector<std::shared_ptr<T>>& elements) {
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+      if (elements[i]) {
+        positions_.emplace(elements[i].get(), std::int32_t(i));
+      }
+    }
+  }
+
+  // -1 for null or for elements out of the list
+  std::int32_t of(const std::shared_ptr<T>& element) const {
+    auto found = positions_.find(element.get());
+    return found == positions_.end() ? -1 : found->second;
+  }
+
+  std::vector<std::int32_t> of(
+      const std::vector<std::shared_ptr<T>>& elements) const {
+    std::vector<std::int32_t> positions;
+    positions.reserve(elements.size());
+    for (const auto& element : elements) {
+      positions.push_back(of(element));
+    }
+    return positions;
+  }
+
+ private:
+  std::unordered_map<const T*, std::int32_t> positions_;
+};
+
+// The element at position, null for -1, false if it's out of elements
+template <class T>
+bool resolve(const std::vector<std::shared_ptr<T>>& elements,
+             std::int32_t position,
+             std::shared_ptr<T>& element) {
+  if (position < -1 || position >= std::int32_t(elements.size())) {
+    return false;
+  }
+  element = position == -1 ? nullptr : elements[position];
+  return true;
+}
+
+template <class T>
+bool resolve(const std::vector<std::shared_ptr<T>>& elements,
+             const std::vector<std::int32_t>& positions,
+             std::vector<std::shared_ptr<T>>& resolved) {
+  resolved.resize(positions.size());
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    if (!resolve(elements, positions[i], resolved[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class T>
+bool isBaseType(const std::vector<std::shared_ptr<T>>& elements) {
+  for (const auto& element : elements) {
+    if (!element) {
+      continue;
+    }
+    const T& value = *element;
+    if (typeid(value) != typeid(T)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+std::string SemanticScene::cacheFilename(const std::string& directory,
+                                         const std::string& houseFilename) {
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx",
+                static_cast<unsigned long long>(core::hashBytes(
+                    {houseFilename.data(), houseFilename.size()})));
+  return Cr::Utility::Directory::join(
+      directory, Cr::Utility::Directory::filename(houseFilename) + "." +
+                     hash + ".semantic");
+}
+
+bool SemanticScene::saveCache(const std::string& cacheFilename,
+                              const std::string& houseFilename,
+                              const SemanticScene& scene,
+                              const quatf& rotation) {
+  // the SUNCG elements have node ids of their own
+  if (!isBaseType(scene.levels_) || !isBaseType(scene.regions_) ||
+      !isBaseType(scene.objects_)) {
+    return false;
+  }
+  SourceStamp stamp;
+  if (!sourceStamp(houseFilename, stamp)) {
+    return false;
+  }
+
+  // the categories of the scene, then the ones only regions or objects have,
+  // which the scene doesn't list
+  std::vector<std::shared_ptr<SemanticCategory>> categories{
+      scene.categories_};
+  for (const auto& region : scene.regions_) {
+    if (region) {
+      categories.push_back(region->category_);
+    }
+  }
+  for (const auto& object : scene.objects_) {
+    if (object) {
+      categories.push_back(object->category_);
+    }
+  }
+  const Positions<SemanticCategory> categoryPositions{categories};
+  const Positions<SemanticLevel> levelPositions{scene.levels_};
+  const Positions<SemanticRegion> regionPositions{scene.regions_};
+  const Positions<SemanticObject> objectPositions{scene.objects_};
+
+  Writer writer;
+  FileHeader header{};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.sourceSize = stamp.size;
+  header.sourceModified = stamp.modified;
+  std::memcpy(header.rotation, rotation.coeffs().data(),
+              sizeof(header.rotation));
+  writer.value(header);
+
+  // the categories, null where they repeat as references always point at
+  // the first position
+  writer.value(std::uint32_t(categories.size()));
+  for (std::size_t i = 0; i < categories.size(); ++i) {
+    const SemanticCategory* category = categories[i].get();
+    const bool first =
+        category && categoryPositions.of(categories[i]) == std::int32_t(i);
+    writer.value(std::uint8_t(first));
+    if (!first) {
+      continue;
+    }
+    if (auto mp3dObject = dynamic_cast<const Mp3dObjectCategory*>(category)) {
+      writer.value(CategoryKind::Mp3dObject);
+      writer.value(std::int32_t(mp3dObject->index_));
+      writer.value(std::int32_t(mp3dObject->categoryMappingIndex_));
+      writer.value(std::int32_t(mp3dObject->mpcat40Index_));
+      writer.string(mp3dObject->categoryMappingName_);
+      writer.string(mp3dObject->mpcat40Name_);
+    } else if (auto mp3dRegion =
+                   dynamic_cast<const Mp3dRegionCategory*>(category)) {
+      writer.value(CategoryKind::Mp3dRegion);
+      writer.value(mp3dRegion->labelCode_);
+    } else if (auto replica =
+                   dynamic_cast<const ReplicaObjectCategory*>(category)) {
+      writer.value(CategoryKind::Replica);
+      writer.value(std::int32_t(replica->id_));
+      writer.string(replica->name_);
+    } else if (auto gibson =
+                   dynamic_cast<const GibsonObjectCategory*>(category)) {
+      writer.value(CategoryKind::Gibson);
+      writer.value(std::int32_t(gibson->id_));
+      writer.string(gibson->name_);
+    } else {
+      return false;
+    }
+  }
+
+  writer.string(scene.name_);
+  writer.string(scene.label_);
+  writer.box(scene.bbox_);
+  writer.value(std::uint32_t(scene.elementCounts_.size()));
+  for (const auto& count : scene.elementCounts_) {
+    writer.string(count.first);
+    writer.value(std::int32_t(count.second));
+  }
+  writer.value(std::uint32_t(scene.segmentToObjectIndex_.size()));
+  for (const auto& segment : scene.segmentToObjectIndex_) {
+    writer.value(std::int32_t(segment.first));
+    writer.value(std::int32_t(segment.second));
+  }
+  writer.indices(categoryPositions.of(scene.categories_));
+
+  // the numbers of elements first, so that they all exist by the time
+  // references to them are read
+  writer.value(std::uint32_t(scene.levels_.size()));
+  writer.value(std::uint32_t(scene.regions_.size()));
+  writer.value(std::uint32_t(scene.objects_.size()));
+  for (const auto& level : scene.levels_) {
+    writer.value(std::uint8_t(bool(level)));
+    if (!level) {
+      continue;
+    }
+    writer.value(std::int32_t(level->index_));
+    writer.string(level->labelCode_);
+    writer.vector(level->position_);
+    writer.box(level->bbox_);
+    writer.indices(regionPositions.of(level->regions_));
+    writer.indices(objectPositions.of(level->objects_));
+  }
+  for (const auto& region : scene.regions_) {
+    writer.value(std::uint8_t(bool(region)));
+    if (!region) {
+      continue;
+    }
+    writer.value(std::int32_t(region->index_));
+    writer.value(std::int32_t(region->parentIndex_));
+    writer.value(categoryPositions.of(region->category_));
+    writer.vector(region->position_);
+    writer.box(region->bbox_);
+    writer.vector(region->floorNormal_);
+    writer.value(std::uint32_t(region->floorPoints_.size()));
+    for (const vec3f& point : region->floorPoints_) {
+      writer.vector(point);
+    }
+    writer.indices(objectPositions.of(region->objects_));
+    writer.value(levelPositions.of(region->level_));
+  }
+  for (const auto& object : scene.objects_) {
+    writer.value(std::uint8_t(bool(object)));
+    if (!object) {
+      continue;
+    }
+    writer.value(std::int32_t(object->index_));
+    writer.value(std::int32_t(object->parentIndex_));
+    writer.value(categoryPositions.of(object->category_));
+    writer.vector(object->obb_.center());
+    writer.vector(object->obb_.sizes());
+    const quatf obbRotation = object->obb_.rotation();
+    for (int i = 0; i != 4; ++i) {
+      writer.value(obbRotation.coeffs()[i]);
+    }
+    writer.value(regionPositions.of(object->region_));
+  }
+
+  const std::vector<char>& data = writer.data();
+  return core::writeFileAtomically(cacheFilename, {data.data(), data.size()});
+}
+
+bool SemanticScene::loadCache(const std::string& cacheFilename,
+                              const std::string& houseFilename,
+                              SemanticScene& scene,
+                              const quatf& rotation) {
+  SourceStamp stamp;
+  if (!sourceStamp(houseFilename, stamp)) {
+    return false;
+  }
+  const Cr::Containers::Array<char> file = core::mapFile(cacheFilename);
+  if (file.size() < sizeof(FileHeader)) {
+    return false;
+  }
+  FileHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.version != Version || header.sourceSize != stamp.size ||
+      header.sourceModified != stamp.modified ||
+      std::memcmp(header.rotation, rotation.coeffs().data(),
+                  sizeof(header.rotation)) != 0) {
+    return false;
+  }
+  Reader reader{file.suffix(sizeof(FileHeader))};
+
+  std::vector<std::shared_ptr<SemanticCategory>> categories(reader.count(1));
+  for (auto& category : categories) {
+    if (!reader.value<std::uint8_t>()) {
+      continue;
+    }
+    switch (reader.value<CategoryKind>()) {
+      case CategoryKind::Mp3dObject: {
+        auto mp3dObject = std::make_shared<Mp3dObjectCategory>();
+        mp3dObject->index_ = reader.value<std::int32_t>();
+        mp3dObject->categoryMappingIndex_ = reader.value<std::int32_t>();
+        mp3dObject->mpcat40Index_ = reader.value<std::int32_t>();
+        mp3dObject->categoryMappingName_ = reader.string();
+        mp3dObject->mpcat40Name_ = reader.string();
+        category = std::move(mp3dObject);
+        break;
+      }
+      case CategoryKind::Mp3dRegion:
+        category =
+            std::make_shared<Mp3dRegionCategory>(reader.value<char>());
+        break;
+      case CategoryKind::Replica: {
+        const int id = reader.value<std::int32_t>();
+        category = std::make_shared<ReplicaObjectCategory>(id, reader.string());
+        break;
+      }
+      case CategoryKind::Gibson: {
+        const int id = reader.value<std::int32_t>();
+        category = std::make_shared<GibsonObjectCategory>(id, reader.string());
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  std::string name = reader.string();
+  std::string label = reader.string();
+  const box3f bbox = reader.box();
+  std::map<std::string, int> elementCounts;
+  for (std::uint32_t i = reader.count(1); i; --i) {
+    std::string element = reader.string();
+    elementCounts[element] = reader.value<std::int32_t>();
+  }
+  std::unordered_map<int, int> segmentToObjectIndex;
+  for (std::uint32_t i = reader.count(2 * sizeof(std::int32_t)); i; --i) {
+    const int segment = reader.value<std::int32_t>();
+    segmentToObjectIndex[segment] = reader.value<std::int32_t>();
+  }
+  std::vector<std::shared_ptr<SemanticCategory>> sceneCategories;
+  if (!resolve(categories, reader.indices(), sceneCategories)) {
+    return false;
+  }
+
+  std::vector<std::shared_ptr<SemanticLevel>> levels(reader.count(1));
+  std::vector<std::shared_ptr<SemanticRegion>> regions(reader.count(1));
+  std::vector<std::shared_ptr<SemanticObject>> objects(reader.count(1));
+  for (auto& level : levels) {
+    level = SemanticLevel::create();
+  }
+  for (auto& region : regions) {
+    region = SemanticRegion::create();
+  }
+  for (auto& object : objects) {
+    object = SemanticObject::create();
+  }
+  // null from now on where they are null in the file, which nothing
+  // references
+  std::vector<std::size_t> missingLevels, missingRegions, missingObjects;
+
+  for (std::size_t i = 0; i < levels.size(); ++i) {
+    if (!reader.value<std::uint8_t>()) {
+      missingLevels.push_back(i);
+      continue;
+    }
+    SemanticLevel& level = *levels[i];
+    level.index_ = reader.value<std::int32_t>();
+    level.labelCode_ = reader.string();
+    level.position_ = reader.vector();
+    level.bbox_ = reader.box();
+    if (!resolve(regions, reader.indices(), level.regions_) ||
+        !resolve(objects, reader.indices(), level.objects_)) {
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < regions.size(); ++i) {
+    if (!reader.value<std::uint8_t>()) {
+      missingRegions.push_back(i);
+      continue;
+    }
+    SemanticRegion& region = *regions[i];
+    region.index_ = reader.value<std::int32_t>();
+    region.parentIndex_ = reader.value<std::int32_t>();
+    if (!resolve(categories, reader.value<std::int32_t>(), region.category_)) {
+      return false;
+    }
+    region.position_ = reader.vector();
+    region.bbox_ = reader.box();
+    region.floorNormal_ = reader.vector();
+    region.floorPoints_.resize(reader.count(sizeof(vec3f)));
+    for (vec3f& point : region.floorPoints_) {
+      point = reader.vector();
+    }
+    if (!resolve(objects, reader.indices(), region.objects_) ||
+        !resolve(levels, reader.value<std::int32_t>(), region.level_)) {
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < objects.size(); ++i) {
+    if (!reader.value<std::uint8_t>()) {
+      missingObjects.push_back(i);
+      continue;
+    }
+    SemanticObject& object = *objects[i];
+    object.index_ = reader.value<std::int32_t>();
+    object.parentIndex_ = reader.value<std::int32_t>();
+    if (!resolve(categories, reader.value<std::int32_t>(), object.category_)) {
+      return false;
+    }
+    const vec3f center = reader.vector();
+    const vec3f sizes = reader.vector();
+    quatf obbRotation;
+    for (int j = 0; j != 4; ++j) {
+      obbRotation.coeffs()[j] = reader.value<float>();
+    }
+    object.obb_ = geo::OBB{center, sizes, obbRotation};
+    if (!resolve(regions, reader.value<std::int32_t>(), object.region_)) {
+      return false;
+    }
+  }
+  if (reader.failed() || !reader.atEnd()) {
+    return false;
+  }
+  for (const std::size_t i : missingLevels) {
+    levels[i] = nullptr;
+  }
+  for (const std::size_t i : missingRegions) {
+    regions[i] = nullptr;
+  }
+  for (const std::size_t i : missingObjects) {
+    objects[i] = nullptr;
+  }
+
+  scene.name_ = std::move(name);
+  scene.label_ = std::move(label);
+  scene.bbox_ = bbox;
+  scene.elementCounts_ = std::move(elementCounts);
+  scene.segmentToObjectIndex_ = std::move(segmentToObjectIndex);
+  scene.categories_ = std::move(sceneCategories);
+  scene.levels_ = std::move(levels);
+  scene.regions_ = std::move(regions);
+  scene.objects_ = std::move(objects);
+  return true;
+}
+
+}  // namespace scene
+}  // namespace esp
@@ -0,0 +1,165 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SemanticSpatialIndex.h"
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <algorithm>
+#include <utility>
+
+#include "esp/core/ThreadPool.h"
+#include "esp/scene/SemanticScene.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace scene {
+
+namespace {
+
+Mn::Range3D toRange(const box3f& box) {
+  return {Mn::Vector3{box.min().x(), box.min().y(), box.min().z()},
+          Mn::Vector3{box.max().x(), box.max().y(), box.max().z()}};
+}
+
+Mn::Range3D pointRange(const vec3f& point, float radius = 0.0f) {
+  const Mn::Vector3 p{point.x(), point.y(), point.z()};
+  return {p - Mn::Vector3{radius}, p + Mn::Vector3{radius}};
+}
+
+// Runs query(i) for every point, in chunks across the shared thread pool
+// when there are enough of them
+template <class Query>
+void forEachPoint(const std::size_t numPoints, const Query& query) {
+  const std::size_t pointsPerChunk = 256;
+  const std::size_t chunks = (numPoints + pointsPerChunk - 1) / pointsPerChunk;
+  auto queryChunk = [&](const std::size_t chunk, std::size_t) {
+    const std::size_t end = std::min(numPoints, (chunk + 1) * pointsPerChunk);
+    for (std::size_t i = chunk * pointsPerChunk; i < end; ++i) {
+      query(i);
+    }
+  };
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers = pool.numWorkers(chunks, pool.numThreads() + 1);
+  if (workers <= 1) {
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      queryChunk(chunk, 0);
+    }
+  } else {
+    pool.parallelFor(chunks, workers, queryChunk);
+  }
+}
+
+}  // namespace
+
+SemanticSpatialIndex::SemanticSpatialIndex(const SemanticScene& scene) {
+  // some loaders leave holes in the object and region vectors
+  std::vector<Mn::Range3D> boxes;
+  const auto& objects = scene.objects();
+  for (size_t i = 0; i < objects.size(); ++i) {
+    if (objects[i] == nullptr) {
+      continue;
+    }
+    const geo::OBB obb = objects[i]->obb();
+    objectObbs_.push_back(obb);
+    objectIds_.push_back(i);
+    boxes.push_back(toRange(obb.toAABB()));
+  }
+  objectBVH_.build(boxes);
+
+  boxes.clear();
+  const auto& regions = scene.regions();
+  for (size_t i = 0; i < regions.size(); ++i) {
+    if (regions[i] == nullptr) {
+      continue;
+    }
+    regionBoxes_.push_back(regions[i]->aabb());
+    regionIds_.push_back(i);
+    boxes.push_back(toRange(regionBoxes_.back()));
+  }
+  regionBVH_.build(boxes);
+}
+
+std::vector<int> SemanticSpatialIndex::objectsAt(const vec3f& point) const {
+  std::vector<uint32_t> candidates;
+  objectBVH_.query(pointRange(point), candidates);
+  std::vector<char> contained(candidates.size());
+  geo::obbsContain(objectObbs_, candidates, point, contained);
+  std::vector<int> objects;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (contained[i]) {
+      objects.push_back(objectIds_[candidates[i]]);
+    }
+  }
+  std::sort(objects.begin(), objects.end());
+  return objects;
+}
+
+int SemanticSpatialIndex::regionAt(const vec3f& point) const {
+  std::vector<uint32_t> candidates;
+  regionBVH_.query(pointRange(point), candidates);
+  int region = ID_UNDEFINED;
+  float regionVolume = 0.0f;
+  for (const uint32_t item : candidates) {
+    const float volume = regionBoxes_[item].volume();
+    // ties go to the lowest index, whatever order the hierarchy visits in
+    if (region == ID_UNDEFINED || volume < regionVolume ||
+        (volume == regionVolume && regionIds_[item] < region)) {
+      region = regionIds_[item];
+      regionVolume = volume;
+    }
+  }
+  return region;
+}
+
+std::vector<int> SemanticSpatialIndex::objectsInRadius(const vec3f& point,
+                                                       float radius) const {
+  std::vector<uint32_t> candidates;
+  objectBVH_.query(pointRange(point, radius), candidates);
+  std::vector<float> distances(candidates.size());
+  geo::obbsDistance(objectObbs_, candidates, point, distances);
+  std::vector<std::pair<float, int>> objects;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (distances[i] <= radius) {
+      objects.emplace_back(distances[i], objectIds_[candidates[i]]);
+    }
+  }
+  std::sort(objects.begin(), objects.end());
+  std::vector<int> ids;
+  ids.reserve(objects.size());
+  for (const auto& object : objects) {
+    ids.push_back(object.second);
+  }
+  return ids;
+}
+
+std::vector<std::vector<int>> SemanticSpatialIndex::objectsAt(
+    const std::vector<vec3f>& points) const {
+  std::vector<std::vector<int>> objects(points.size());
+  forEachPoint(points.size(),
+               [&](std::size_t i) { objects[i] = objectsAt(points[i]); });
+  return objects;
+}
+
+std::vector<int> SemanticSpatialIndex::regionsAt(
+    const std::vector<vec3f>& points) const {
+  std::vector<int> regions(points.size());
+  forEachPoint(points.size(),
+               [&](std::size_t i) { regions[i] = regionAt(points[i]); });
+  return regions;
+}
+
+std::vector<std::vector<int>> SemanticSpatialIndex::objectsInRadius(
+    const std::vector<vec3f>& points,
+    float radius) const {
+  std::vector<std::vector<int>> objects(points.size());
+  forEachPoint(points.size(), [&](std::size_t i) {
+    objects[i] = objectsInRadius(points[i], radius);
+  });
+  return objects;
+}
+
+}  // namespace scene
+}  // namespace esp
@@ -0,0 +1,99 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SCENE_SEMANTICSPATIALINDEX_H_
+#define ESP_SCENE_SEMANTICSPATIALINDEX_H_
+
+/** @file
+ * @brief Class @ref esp::scene::SemanticSpatialIndex
+ */
+
+#include <vector>
+
+#include "esp/core/esp.h"
+#include "esp/geo/OBB.h"
+#include "esp/gfx/CullingBVH.h"
+
+namespace esp {
+namespace scene {
+
+class SemanticScene;
+
+/**
+ * @brief Point and radius queries against the objects and regions of a
+ * @ref SemanticScene
+ *
+ * Builds a bounding volume hierarchy over the AABBs of the object OBBs and
+ * over the region AABBs once, so that a query visits a handful of candidates
+ * instead of every object, then tests the candidate objects against their
+ * OBBs. Objects and regions are reported by their index in
+ * @ref SemanticScene::objects() and @ref SemanticScene::regions(). The index
+ * is a snapshot: it has to be rebuilt if the semantic scene is reloaded. It
+ * is immutable, so it can be queried from several threads at once.
+ */
+class SemanticSpatialIndex {
+ public:
+  explicit SemanticSpatialIndex(const SemanticScene& scene);
+
+  /**
+   * @brief The objects whose OBB contains @p point, in increasing index
+   * order
+   */
+  std::vector<int> objectsAt(const vec3f& point) const;
+
+  /**
+   * @brief The region that contains @p point, @ref ID_UNDEFINED if none
+   *
+   * The region AABBs of neighbouring rooms often overlap, in which case the
+   * smallest of the regions that contain the point is returned.
+   */
+  int regionAt(const vec3f& point) const;
+
+  /**
+   * @brief The objects whose OBB is at most @p radius from @p point, nearest
+   * first
+   *
+   * The objects that contain the point are at distance 0.
+   */
+  std::vector<int> objectsInRadius(const vec3f& point, float radius) const;
+
+  /**
+   * @brief @ref objectsAt() for each of @p points
+   *
+   * Large batches are spread over @ref core::ThreadPool::shared().
+   */
+  std::vector<std::vector<int>> objectsAt(
+      const std::vector<vec3f>& points) const;
+
+  /** @brief @ref regionAt() for each of @p points */
+  std::vector<int> regionsAt(const std::vector<vec3f>& points) const;
+
+  /** @brief @ref objectsInRadius() for each of @p points */
+  std::vector<std::vector<int>> objectsInRadius(
+      const std::vector<vec3f>& points,
+      float radius) const;
+
+  /** @brief Number of objects indexed, the non-null ones */
+  size_t numObjects() const { return objectIds_.size(); }
+
+  /** @brief Number of regions indexed, the non-null ones */
+  size_t numRegions() const { return regionIds_.size(); }
+
+ private:
+  gfx::CullingBVH objectBVH_;
+  // OBB and index in SemanticScene::objects() of each item of objectBVH_
+  geo::ObbsSoA objectObbs_;
+  std::vector<int> objectIds_;
+
+  gfx::CullingBVH regionBVH_;
+  std::vector<box3f, Eigen::aligned_allocator<box3f>> regionBoxes_;
+  std::vector<int> regionIds_;
+
+  ESP_SMART_POINTERS(SemanticSpatialIndex)
+};
+
+}  // namespace scene
+}  // namespace esp
+
+#endif  // ESP_SCENE_SEMANTICSPATIALINDEX_H_
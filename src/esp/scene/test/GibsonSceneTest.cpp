@@ -37,6 +37,48 @@ TEST(GibsonSceneTest, Basic) {
   ASSERT_EQ(object->category()->name(""), "microwave");
 }
 
+TEST(GibsonSceneTest, Cache) {
+  SemanticScene semanticScene;
+  ASSERT_TRUE(SemanticScene::loadGibsonHouse(houseFilename, semanticScene));
+  const std::string cacheDirectory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "GibsonSceneTest-Cache");
+  ASSERT_TRUE(Cr::Utility::Directory::mkpath(cacheDirectory));
+  const std::string cacheFilename =
+      SemanticScene::cacheFilename(cacheDirectory, houseFilename);
+  ASSERT_TRUE(
+      SemanticScene::saveCache(cacheFilename, houseFilename, semanticScene));
+
+  SemanticScene cachedScene;
+  ASSERT_TRUE(
+      SemanticScene::loadCache(cacheFilename, houseFilename, cachedScene));
+  ASSERT_EQ(cachedScene.objects().size(), semanticScene.objects().size());
+  ASSERT_EQ(cachedScene.categories().size(),
+            semanticScene.categories().size());
+  ASSERT_EQ(cachedScene.count("objects"), semanticScene.count("objects"));
+  for (size_t i = 0; i < semanticScene.objects().size(); ++i) {
+    const auto& object = semanticScene.objects()[i];
+    const auto& cached = cachedScene.objects()[i];
+    ASSERT_EQ(bool(cached), bool(object));
+    if (!object) {
+      continue;
+    }
+    ASSERT_EQ(cached->id(), object->id());
+    ASSERT_EQ(cached->category()->name(""), object->category()->name(""));
+    ASSERT_EQ(cached->category()->index(""), object->category()->index(""));
+    ASSERT(cached->obb().center().isApprox(object->obb().center()));
+    ASSERT(cached->obb().sizes().isApprox(object->obb().sizes()));
+  }
+  // the objects of a category share it as they do when parsed
+  ASSERT_EQ(cachedScene.objects()[1]->category(),
+            cachedScene.objects()[3]->category());
+
+  // stale for another rotation
+  SemanticScene rotatedScene;
+  ASSERT_FALSE(SemanticScene::loadCache(cacheFilename, houseFilename,
+                                        rotatedScene, esp::quatf::Identity()));
+  ASSERT_EQ(rotatedScene.objects().size(), 0);
+}
+
 const std::string gibsonSemanticFilename =
     Cr::Utility::Directory::join(SCENE_DATASETS, "gibson/Allensville.scn");
 
@@ -7,9 +7,12 @@
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Vector3.h>
 
+#include <algorithm>
+
 #include "configure.h"
 #include "esp/scene/ReplicaSemanticScene.h"
 #include "esp/scene/SemanticScene.h"
+#include "esp/scene/SemanticSpatialIndex.h"
 #include "esp/sim/Simulator.h"
 
 #include "esp/assets/GenericInstanceMeshData.h"
@@ -31,11 +34,14 @@ struct ReplicaSceneTest : Cr::TestSuite::Tester {
   void testSemanticSceneOBB();
 
   void testSemanticSceneLoading();
+
+  void testSemanticSpatialIndex();
 };
 
 ReplicaSceneTest::ReplicaSceneTest() {
   addTests({&ReplicaSceneTest::testSemanticSceneOBB,
-            &ReplicaSceneTest::testSemanticSceneLoading});
+            &ReplicaSceneTest::testSemanticSceneLoading,
+            &ReplicaSceneTest::testSemanticSpatialIndex});
 }
 
 void ReplicaSceneTest::testSemanticSceneOBB() {
@@ -117,6 +123,62 @@ void ReplicaSceneTest::testSemanticSceneLoading() {
   CORRADE_COMPARE(scene->objects()[12]->category()->name(), "book");
 }
 
+void ReplicaSceneTest::testSemanticSpatialIndex() {
+  if (!Cr::Utility::Directory::exists(replicaRoom0)) {
+    CORRADE_SKIP("Replica dataset not found at '" + replicaRoom0 +
+                 "'\nSkipping test");
+  }
+
+  esp::scene::SemanticScene scene;
+  CORRADE_VERIFY(esp::scene::SemanticScene::loadReplicaHouse(
+      Cr::Utility::Directory::join(replicaRoom0, "info_semantic.json"), scene));
+  const esp::scene::SemanticSpatialIndex index{scene};
+
+  // the index agrees with testing every object, at the object centers and
+  // at points around them
+  const auto& objects = scene.objects();
+  std::vector<esp::vec3f> points;
+  for (const auto& obj : objects) {
+    if (obj == nullptr)
+      continue;
+    const esp::vec3f center = obj->obb().center();
+    points.push_back(center);
+    points.push_back(center + obj->obb().halfExtents());
+    points.push_back(center + esp::vec3f{0.5f, 0.0f, -0.5f});
+  }
+  CORRADE_VERIFY(!points.empty());
+
+  const float radius = 0.25f;
+  const std::vector<std::vector<int>> batchObjects = index.objectsAt(points);
+  const std::vector<std::vector<int>> batchInRadius =
+      index.objectsInRadius(points, radius);
+  for (size_t i = 0; i < points.size(); ++i) {
+    CORRADE_ITERATION(i);
+    std::vector<int> expectedAt;
+    std::vector<int> expectedInRadius;
+    for (size_t j = 0; j < objects.size(); ++j) {
+      if (objects[j] == nullptr)
+        continue;
+      if (objects[j]->obb().contains(points[i]))
+        expectedAt.push_back(j);
+      if (objects[j]->obb().distance(points[i]) <= radius)
+        expectedInRadius.push_back(j);
+    }
+    CORRADE_VERIFY(index.objectsAt(points[i]) == expectedAt);
+    CORRADE_VERIFY(batchObjects[i] == expectedAt);
+
+    // nearest first, so compare as sets
+    std::vector<int> inRadius = batchInRadius[i];
+    std::sort(inRadius.begin(), inRadius.end());
+    CORRADE_VERIFY(inRadius == expectedInRadius);
+  }
+
+  // far away from everything
+  CORRADE_VERIFY(index.objectsAt(esp::vec3f{1e4f, 1e4f, 1e4f}).empty());
+  CORRADE_COMPARE(index.regionAt(esp::vec3f{1e4f, 1e4f, 1e4f}),
+                  esp::ID_UNDEFINED);
+}
+
 }  // namespace
 
 CORRADE_TEST_MAIN(ReplicaSceneTest)
@@ -2,18 +2,59 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Math/Algorithms/GramSchmidt.h>
+#include <Magnum/Math/Functions.h>
 #include <Magnum/PixelFormat.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
 #include "CameraSensor.h"
+#ifdef ESP_BUILD_WITH_CUDA
+#include "CudaDeviceContext.h"
+#include "DeviceBuffer.h"
+#endif
+#include "esp/core/Profiling.h"
 #include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/ObjectIdRemapping.h"
 #include "esp/gfx/Renderer.h"
+#include "esp/scene/SemanticScene.h"
 #include "esp/sim/Simulator.h"
 
 namespace esp {
 namespace sensor {
 
+namespace {
+
+/**
+ * @brief Whether sensors of @p type read just the depth: depth sensors, and
+ * normal and point cloud sensors unprojecting the depth
+ */
+bool readsDepth(SensorType type) {
+  return type == SensorType::Depth || type == SensorType::Normal ||
+         type == SensorType::PointCloud;
+}
+
+/**
+ * @brief The pass drawing just the attachment read by sensors of @p type:
+ * the sensors reading depth skip shading entirely and semantic sensors only
+ * write object ids
+ */
+gfx::RenderCamera::Flags lightweightPassFlags(SensorType type) {
+  if (readsDepth(type)) {
+    return gfx::RenderCamera::Flag::DepthOnly;
+  }
+  if (type == SensorType::Semantic) {
+    return gfx::RenderCamera::Flag::ObjectIdOnly;
+  }
+  return {};
+}
+
+}  // namespace
+
 CameraSensor::CameraSensor(scene::SceneNode& cameraNode,
                            const SensorSpec::ptr& spec)
     : VisualSensor(cameraNode, spec),
@@ -49,7 +90,11 @@ void CameraSensor::recomputeBaseProjectionMatrix() {
     baseProjMatrix_ =
         Mn::Matrix4::orthographicProjection(nearPlaneSize_, near_, far_);
   } else {
-    if (spec_->sensorSubType != SensorSubType::Pinhole) {
+    // cube map sensors keep a perspective base projection, their depth
+    // unprojection only depends on the near and far planes
+    if (spec_->sensorSubType != SensorSubType::Pinhole &&
+        spec_->sensorSubType != SensorSubType::Equirectangular &&
+        spec_->sensorSubType != SensorSubType::Fisheye) {
       LOG(INFO) << "CameraSensor::setCameraType : Unsupported Camera type val :"
                 << static_cast<int>(spec_->sensorSubType)
                 << " so defaulting to Pinhole.";
@@ -112,16 +157,205 @@ CameraSensor& CameraSensor::setViewport(gfx::RenderCamera& targetCamera) {
   return *this;
 }
 
+Mn::PixelFormat CameraSensor::observationPixelFormat() const {
+  if (spec_->sensorType == SensorType::Semantic) {
+    if (spec_->encoding == "semantic_uint16") {
+      return Mn::PixelFormat::R16UI;
+    }
+    if (spec_->encoding == "semantic_uint8") {
+      return Mn::PixelFormat::R8UI;
+    }
+    return Mn::PixelFormat::R32UI;
+  }
+  if (spec_->sensorType == SensorType::Depth) {
+    if (spec_->encoding == "depth_float16") {
+      return Mn::PixelFormat::R16F;
+    }
+    if (spec_->encoding == "depth_uint16_mm") {
+      return Mn::PixelFormat::R16UI;
+    }
+    return Mn::PixelFormat::R32F;
+  }
+  if (spec_->sensorType == SensorType::Normal ||
+      spec_->sensorType == SensorType::PointCloud) {
+    return Mn::PixelFormat::RGB32F;
+  }
+  return spec_->encoding == "rgb_uint8" ? Mn::PixelFormat::RGB8Unorm
+                                        : Mn::PixelFormat::RGBA8Unorm;
+}
+
+int CameraSensor::pointCloudStride() const {
+  auto found = spec_->parameters.find("point_cloud_stride");
+  return found == spec_->parameters.end()
+             ? 1
+             : std::max(1, std::atoi(found->second.c_str()));
+}
+
+Corrade::Containers::Optional<gfx::Foveation> CameraSensor::foveation()
+    const {
+  auto found = spec_->parameters.find("foveation_inset");
+  if (found == spec_->parameters.end() ||
+      spec_->sensorType != SensorType::Color ||
+      (getCameraType() != SensorSubType::Pinhole &&
+       getCameraType() != SensorSubType::Orthographic)) {
+    return Corrade::Containers::NullOpt;
+  }
+  gfx::Foveation foveation;
+  foveation.insetSize = std::atof(found->second.c_str());
+  auto scale = spec_->parameters.find("foveation_periphery_scale");
+  if (scale != spec_->parameters.end()) {
+    foveation.peripheryScale = std::atof(scale->second.c_str());
+  }
+  // an inset covering everything is the plain full resolution view
+  if (!(foveation.insetSize > 0.0f && foveation.insetSize < 1.0f &&
+        foveation.peripheryScale > 0.0f &&
+        foveation.peripheryScale <= 1.0f)) {
+    if (foveation.insetSize < 1.0f) {
+      LOG(ERROR) << "CameraSensor::foveation(): invalid foveation_inset "
+                 << found->second << " or foveation_periphery_scale of "
+                 << spec_->uuid << ", drawing it at full resolution";
+    }
+    return Corrade::Containers::NullOpt;
+  }
+  return foveation;
+}
+
+Mn::Matrix4 CameraSensor::pointCloudTransformation() const {
+  auto found = spec_->parameters.find("point_cloud_frame");
+  if (found == spec_->parameters.end() || found->second == "camera") {
+    return {};
+  }
+  if (found->second != "world") {
+    LOG(ERROR) << "CameraSensor::pointCloudTransformation(): " << spec_->uuid
+               << " has an unknown point_cloud_frame " << found->second
+               << ", using the camera frame";
+    return {};
+  }
+  return node().absoluteTransformationMatrix();
+}
+
+Mn::Vector2i CameraSensor::observationSize() const {
+  if (spec_->sensorType == SensorType::PointCloud) {
+    return Mn::Math::max(framebufferSize() / pointCloudStride(),
+                         Mn::Vector2i{1});
+  }
+  return readRegion().size() / readStride();
+}
+
+Mn::Range2Di CameraSensor::readRegion() const {
+  const Mn::Range2Di full{{}, framebufferSize()};
+  auto found = spec_->parameters.find("read_region");
+  if (found == spec_->parameters.end() ||
+      spec_->sensorType == SensorType::PointCloud) {
+    return full;
+  }
+  Mn::Vector2i corner, size;
+  if (std::sscanf(found->second.c_str(), "%d %d %d %d", &corner.x(),
+                  &corner.y(), &size.x(), &size.y()) != 4 ||
+      (corner < Mn::Vector2i{0}).any() || (size < Mn::Vector2i{1}).any() ||
+      (corner + size > full.max()).any()) {
+    LOG(ERROR) << "CameraSensor::readRegion(): invalid read_region "
+               << found->second << " of " << spec_->uuid
+               << ", reading the whole framebuffer";
+    return full;
+  }
+  return Mn::Range2Di::fromSize(corner, size);
+}
+
+int CameraSensor::readStride() const {
+  auto found = spec_->parameters.find("read_stride");
+  if (found == spec_->parameters.end() ||
+      spec_->sensorType == SensorType::PointCloud) {
+    return 1;
+  }
+  const int stride = std::max(1, std::atoi(found->second.c_str()));
+  if (stride > readRegion().size().min()) {
+    LOG(ERROR) << "CameraSensor::readStride(): read_stride " << stride
+               << " of " << spec_->uuid
+               << " is larger than its read region, reading every pixel";
+    return 1;
+  }
+  return stride;
+}
+
+void CameraSensor::setReadRegionOf(gfx::RenderTarget& target) const {
+  Mn::Range2Di region = readRegion();
+  // the region is in the top-down rows of the observation
+  if (!target.topDownRows()) {
+    const int height = target.framebufferSize().y();
+    region = {{region.left(), height - region.top()},
+              {region.right(), height - region.bottom()}};
+  }
+  target.setReadRegion(region, readStride());
+}
+
+void CameraSensor::updateObjectIdRemapping(
+    const std::shared_ptr<scene::SemanticScene>& scene) {
+  if (spec_->sensorType != SensorType::Semantic) {
+    return;
+  }
+  auto found = spec_->parameters.find("semantic_remapping");
+  if (found == spec_->parameters.end() || found->second.empty() || !scene) {
+    objectIdRemapping_ = nullptr;
+    return;
+  }
+  if (objectIdRemapping_ && remappedSemanticScene_.lock() == scene) {
+    return;
+  }
+
+  const std::string& remapping = found->second;
+  std::vector<uint32_t> table;
+  if (remapping == "instance") {
+    table = scene->semanticIdToInstanceId();
+  } else if (remapping == "category") {
+    table = scene->semanticIdToCategoryIndex();
+  } else if (remapping.compare(0, 9, "category:") == 0) {
+    table = scene->semanticIdToCategoryIndex(remapping.substr(9));
+  } else {
+    LOG(ERROR) << "CameraSensor::updateObjectIdRemapping(): " << spec_->uuid
+               << " has an unknown semantic_remapping " << remapping
+               << ", reading the object ids as they are";
+    objectIdRemapping_ = nullptr;
+    return;
+  }
+  objectIdRemapping_ =
+      gfx::ObjectIdRemapping::create(Corrade::Containers::arrayView(table));
+  remappedSemanticScene_ = scene;
+}
+
 bool CameraSensor::getObservationSpace(ObservationSpace& space) {
   space.spaceType = ObservationSpaceType::Tensor;
-  space.shape = {static_cast<size_t>(spec_->resolution[0]),
-                 static_cast<size_t>(spec_->resolution[1]),
-                 static_cast<size_t>(spec_->channels)};
-  space.dataType = core::DataType::DT_UINT8;
-  if (spec_->sensorType == SensorType::Semantic) {
-    space.dataType = core::DataType::DT_UINT32;
-  } else if (spec_->sensorType == SensorType::Depth) {
-    space.dataType = core::DataType::DT_FLOAT;
+  // rows by columns, like the resolution of the spec
+  space.shape = {static_cast<size_t>(observationSize().y()),
+                 static_cast<size_t>(observationSize().x())};
+  if (spec_->sensorType == SensorType::PointCloud) {
+    // a list of points, in the row-major order of the subsampled pixels
+    space.shape = {static_cast<size_t>(observationSize().product())};
+  }
+  switch (observationPixelFormat()) {
+    case Mn::PixelFormat::R32UI:
+      space.dataType = core::DataType::DT_UINT32;
+      break;
+    case Mn::PixelFormat::R32F:
+      space.dataType = core::DataType::DT_FLOAT;
+      break;
+    case Mn::PixelFormat::R16F:
+      space.dataType = core::DataType::DT_FLOAT16;
+      break;
+    case Mn::PixelFormat::R16UI:
+      space.dataType = core::DataType::DT_UINT16;
+      break;
+    case Mn::PixelFormat::R8UI:
+      space.dataType = core::DataType::DT_UINT8;
+      break;
+    case Mn::PixelFormat::RGB32F:
+      space.dataType = core::DataType::DT_FLOAT;
+      space.shape.push_back(3);
+      break;
+    default:
+      // color keeps a channel dimension, of one byte per channel
+      space.dataType = core::DataType::DT_UINT8;
+      space.shape.push_back(Mn::pixelSize(observationPixelFormat()));
   }
   return true;
 }
@@ -140,60 +374,233 @@ bool CameraSensor::getObservation(sim::Simulator& sim, Observation& obs) {
 }
 
 bool CameraSensor::drawObservation(sim::Simulator& sim) {
+  ESP_PROFILE_SCOPE("CameraSensor::drawObservation");
   if (!hasRenderTarget()) {
     return false;
   }
 
-  renderTarget().renderEnter();
+  if (spec_->sensorType == SensorType::Semantic) {
+    updateObjectIdRemapping(sim.getSemanticScene());
+    // TODO: check sim has semantic scene graph
+    scene::SceneGraph& semanticSceneGraph = sim.getActiveSemanticSceneGraph();
+    drawPass(sim, semanticSceneGraph,
+             &semanticSceneGraph != &sim.getActiveSceneGraph()
+                 ? &sim.getActiveSceneGraph()
+                 : nullptr);
+  } else {
+    // SensorType is Depth or any other type
+    drawPass(sim, sim.getActiveSceneGraph(), nullptr);
+  }
+  return true;
+}
 
+bool CameraSensor::drawObservationOf(sim::Simulator& sim,
+                                     scene::SceneGraph& sceneGraph) {
+  ESP_PROFILE_SCOPE("CameraSensor::drawObservationOf");
+  if (!hasRenderTarget()) {
+    return false;
+  }
+  drawPass(sim, sceneGraph, nullptr);
+  return true;
+}
+
+void CameraSensor::drawPass(sim::Simulator& sim,
+                            scene::SceneGraph& sceneGraph,
+                            scene::SceneGraph* objectsSceneGraph) {
   gfx::RenderCamera::Flags flags;
+  // depth sensors write the linear depth in the pass itself instead of
+  // unprojecting the depth buffer afterwards. The depth of orthographic
+  // sensors is unprojected as is, and foveated passes only compose the
+  // color attachment.
+  const bool linearDepth = spec_->sensorType == SensorType::Depth &&
+                           getCameraType() != SensorSubType::Orthographic &&
+                           !foveation();
+  if (!linearDepth) {
+    renderTarget().renderEnter();
+  } else if (renderTarget().renderEnterLinearDepth()) {
+    flags |= gfx::RenderCamera::Flag::LinearDepth;
+  }
+
   if (sim.isFrustumCullingEnabled())
     flags |= gfx::RenderCamera::Flag::FrustumCulling;
+  if (sim.isOcclusionCullingEnabled())
+    flags |= gfx::RenderCamera::Flag::OcclusionCulling;
+  flags |= lightweightPassFlags(spec_->sensorType);
+
+  // textures requested by the previous passes may be evicted from now on
+  if (gfx::TextureStreamer* textureStreamer = sim.getTextureStreamer()) {
+    textureStreamer->nextFrame();
+  }
 
   gfx::Renderer::ptr renderer = sim.getRenderer();
-  if (spec_->sensorType == SensorType::Semantic) {
-    // TODO: check sim has semantic scene graph
-    renderer->draw(*this, sim.getActiveSemanticSceneGraph(), flags);
-    if (&sim.getActiveSemanticSceneGraph() != &sim.getActiveSceneGraph()) {
-      flags |= gfx::RenderCamera::Flag::ObjectsOnly;
-      renderer->draw(*this, sim.getActiveSceneGraph(), flags);
-    }
-  } else {
-    // SensorType is Depth or any other type
-    renderer->draw(*this, sim.getActiveSceneGraph(), flags);
+  renderer->draw(*this, sceneGraph, flags);
+  if (objectsSceneGraph) {
+    flags |= gfx::RenderCamera::Flag::ObjectsOnly;
+    renderer->draw(*this, *objectsSceneGraph, flags);
   }
 
   renderTarget().renderExit();
 
-  return true;
+  // GPU reads stay on the device, there's no transfer to overlap
+  if (spec_->asyncReadback && !spec_->gpu2gpuTransfer) {
+    setReadRegionOf(renderTarget());
+    // kick off the transfer now; readObservation() blocks only if it has not
+    // landed by the time the observation is consumed
+    if (spec_->sensorType == SensorType::Semantic) {
+      renderTarget().readFrameObjectIdAsync(observationPixelFormat(),
+                                            objectIdRemapping());
+    } else if (spec_->sensorType == SensorType::Depth) {
+      renderTarget().readFrameDepthAsync(observationPixelFormat());
+    } else if (spec_->sensorType == SensorType::Normal) {
+      renderTarget().readFrameNormalAsync();
+    } else if (spec_->sensorType == SensorType::PointCloud) {
+      renderTarget().readFramePointsAsync(pointCloudTransformation(),
+                                          pointCloudStride());
+    } else {
+      renderTarget().readFrameRgbaAsync(observationPixelFormat());
+    }
+  }
+}
+
+bool CameraSensor::canShareRenderPass(const VisualSensor& other) const {
+  if (&other == this) {
+    return true;
+  }
+  auto otherCamera = dynamic_cast<const CameraSensor*>(&other);
+  if (otherCamera == nullptr) {
+    return false;
+  }
+  // a foveated pass only composes the color attachment
+  if (foveation() || otherCamera->foveation()) {
+    return false;
+  }
+  // the lightweight passes of depth and semantic sensors leave the color (and
+  // for depth sensors the object id) attachment empty
+  const gfx::RenderCamera::Flags passFlags =
+      lightweightPassFlags(spec_->sensorType);
+  const SensorType otherType = otherCamera->specification()->sensorType;
+  if ((passFlags & gfx::RenderCamera::Flag::DepthOnly) &&
+      !readsDepth(otherType)) {
+    return false;
+  }
+  if ((passFlags & gfx::RenderCamera::Flag::ObjectIdOnly) &&
+      otherType != SensorType::Semantic && !readsDepth(otherType)) {
+    return false;
+  }
+  return getCameraType() == otherCamera->getCameraType() &&
+         spec_->msaaSamples == otherCamera->specification()->msaaSamples &&
+         framebufferSize() == otherCamera->framebufferSize() &&
+         projectionMatrix_ == otherCamera->projectionMatrix_ &&
+         node().absoluteTransformationMatrix() ==
+             otherCamera->node().absoluteTransformationMatrix();
 }
 
 void CameraSensor::readObservation(Observation& obs) {
-  // Make sure we have memory
-  if (buffer_ == nullptr) {
-    // TODO: check if our sensor was resized and resize our buffer if needed
-    ObservationSpace space;
-    getObservationSpace(space);
-    buffer_ = core::Buffer::create(space.shape, space.dataType);
+  readObservationFrom(renderTarget(), obs);
+}
+
+void CameraSensor::readObservationFrom(gfx::RenderTarget& source,
+                                       Observation& obs) {
+  ESP_PROFILE_SCOPE("CameraSensor::readObservation");
+  if (spec_->gpu2gpuTransfer) {
+#ifdef ESP_BUILD_WITH_CUDA
+    readObservationToDevice(source, obs);
+    return;
+#else
+    LOG(ERROR) << "CameraSensor::readObservationFrom(): " << spec_->uuid
+               << " has gpu2gpuTransfer enabled, which requires a build with "
+               << "CUDA, reading to the host instead";
+#endif
+  }
+
+  // Rotate to the next buffer of the ring (reallocated on resize), so
+  // previously returned observations are not overwritten
+  obs.buffer = nextObservationBuffer();
+  readObservationInto(source, obs.buffer->data);
+}
+
+bool CameraSensor::readObservationInto(
+    gfx::RenderTarget& source,
+    Corrade::Containers::ArrayView<void> data) {
+  ESP_PROFILE_SCOPE("CameraSensor::readObservationInto");
+  const Mn::Vector2i size = observationSize();
+  const std::size_t dataSize =
+      Mn::pixelSize(observationPixelFormat()) * size.product();
+  if (data.size() != dataSize) {
+    LOG(ERROR) << "CameraSensor::readObservationInto(): " << spec_->uuid
+               << " expected " << dataSize << " bytes, got " << data.size();
+    return false;
   }
-  obs.buffer = buffer_;
 
   // TODO: have different classes for the different types of sensors
   // TODO: do we need to flip axis?
+  // the buffers are tightly packed, RGB8 and 16-bit rows aren't necessarily
+  // aligned to four bytes
+  const Magnum::MutableImageView2D view{Magnum::PixelStorage{}.setAlignment(1),
+                                        observationPixelFormat(), size, data};
+  if (source.hasPendingRead()) {
+    source.fence(view);
+    return true;
+  }
+  setReadRegionOf(source);
+  if (spec_->sensorType == SensorType::Semantic) {
+    source.readFrameObjectId(view, objectIdRemapping());
+  } else if (spec_->sensorType == SensorType::Depth) {
+    source.readFrameDepth(view);
+  } else if (spec_->sensorType == SensorType::Normal) {
+    source.readFrameNormal(view);
+  } else if (spec_->sensorType == SensorType::PointCloud) {
+    source.readFramePoints(view, pointCloudTransformation(),
+                           pointCloudStride());
+  } else {
+    source.readFrameRgba(view);
+  }
+  return true;
+}
+
+bool CameraSensor::readObjectIdHistogram(
+    gfx::RenderTarget& source,
+    Corrade::Containers::ArrayView<Mn::UnsignedInt> counts) {
+  ESP_PROFILE_SCOPE("CameraSensor::readObjectIdHistogram");
+  if (spec_->sensorType != SensorType::Semantic) {
+    LOG(ERROR) << "CameraSensor::readObjectIdHistogram(): " << spec_->uuid
+               << " is not a semantic sensor";
+    return false;
+  }
+  setReadRegionOf(source);
+  source.readFrameObjectIdHistogram(counts, objectIdRemapping());
+  return true;
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+void CameraSensor::readObservationToDevice(gfx::RenderTarget& source,
+                                           Observation& obs,
+                                           CUstream_st* stream) {
+  const int deviceId = source.cudaDeviceId();
+  obs.buffer = nullptr;
+  obs.deviceBuffer = nextObservationDeviceBuffer(deviceId);
+
+  CudaDeviceContext ctx{deviceId};
+  void* data = obs.deviceBuffer->data();
+  setReadRegionOf(source);
   if (spec_->sensorType == SensorType::Semantic) {
-    renderTarget().readFrameObjectId(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::R32UI, renderTarget().framebufferSize(),
-        obs.buffer->data});
+    source.readFrameObjectIdGPU(data, observationPixelFormat(),
+                                objectIdRemapping(), stream);
   } else if (spec_->sensorType == SensorType::Depth) {
-    renderTarget().readFrameDepth(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::R32F, renderTarget().framebufferSize(),
-        obs.buffer->data});
+    source.readFrameDepthGPU(data, observationPixelFormat(), stream);
+  } else if (spec_->sensorType == SensorType::Normal) {
+    source.readFrameNormalGPU(static_cast<float*>(data), stream);
+  } else if (spec_->sensorType == SensorType::PointCloud) {
+    source.readFramePointsGPU(static_cast<float*>(data),
+                              pointCloudTransformation(), pointCloudStride(),
+                              stream);
   } else {
-    renderTarget().readFrameRgba(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::RGBA8Unorm, renderTarget().framebufferSize(),
-        obs.buffer->data});
+    source.readFrameRgbaGPU(static_cast<uint8_t*>(data),
+                            observationPixelFormat(), stream);
   }
+  obs.deviceBuffer->recordWrite(stream);
 }
+#endif
 
 bool CameraSensor::displayObservation(sim::Simulator& sim) {
   if (!hasRenderTarget()) {
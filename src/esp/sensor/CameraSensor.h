@@ -5,11 +5,23 @@
 #ifndef ESP_SENSOR_CAMERASENSOR_H_
 #define ESP_SENSOR_CAMERASENSOR_H_
 
+#include <Corrade/Containers/ArrayView.h>
 #include <Magnum/Math/ConfigurationValue.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/PixelFormat.h>
+#include <memory>
 #include "VisualSensor.h"
 #include "esp/core/esp.h"
 
 namespace esp {
+namespace gfx {
+class ObjectIdRemapping;
+}
+namespace scene {
+class SceneGraph;
+class SemanticScene;
+}
+
 namespace sensor {
 
 class CameraSensor : public VisualSensor {
@@ -36,6 +48,106 @@ class CameraSensor : public VisualSensor {
 
   virtual bool getObservationSpace(ObservationSpace& space) override;
 
+  /**
+   * @brief The pixel format observations are read in, following the sensor
+   * type and @ref SensorSpec::encoding
+   *
+   * Color sensors read RGBA8, or RGB8 with the "rgb_uint8" encoding. Depth
+   * sensors read float32 meters, half floats with "depth_float16" or uint16
+   * millimeters, saturating at 65.535 meters, with "depth_uint16_mm".
+   * Semantic sensors read uint32 object ids, uint16 with "semantic_uint16"
+   * and uint8 with "semantic_uint8", normal sensors RGB32F
+   * unit normals in the camera frame and point cloud sensors RGB32F points.
+   * The pixels are packed on the GPU, so the smaller formats also shrink the
+   * GPU to host transfer.
+   */
+  Mn::PixelFormat observationPixelFormat() const;
+
+  /**
+   * @brief The size of the image of @ref observationPixelFormat() pixels
+   * observations are read as
+   *
+   * The size of @ref readRegion() divided by @ref readStride(), except for
+   * point cloud sensors, which subsample the framebuffer by
+   * @ref pointCloudStride(). Their observations are then a list of
+   * @ref Magnum::Vector3 points in the row-major order of the image, zero
+   * where nothing was drawn.
+   */
+  Mn::Vector2i observationSize() const;
+
+  /**
+   * @brief The region of the framebuffer observations are read from
+   *
+   * The `"read_region"` parameter of the spec, the column and row of its top
+   * left pixel, its width and its height, separated by spaces, e.g.
+   * `"0 120 640 240"` for the middle half of the rows of a 640x480 sensor.
+   * Defaults to the whole framebuffer, as do point cloud sensors and
+   * regions outside of it. The region is cut out on the GPU, so only it is
+   * transferred.
+   */
+  Mn::Range2Di readRegion() const;
+
+  /**
+   * @brief The subsampling of @ref readRegion()
+   *
+   * The `"read_stride"` parameter of the spec, each pixel of the observation
+   * is then the center of a stride by stride block of the region, sampled on
+   * the GPU before the transfer. Defaults to 1, as do point cloud sensors,
+   * which have @ref pointCloudStride() instead.
+   */
+  int readStride() const;
+
+  /**
+   * @brief Restrict the reads of @p target to @ref readRegion() at
+   * @ref readStride(), in the rows of the target
+   *
+   * Done by the reads of the sensor, for the code reading the render target
+   * itself, e.g. the one of another sensor sharing its render pass.
+   */
+  void setReadRegionOf(gfx::RenderTarget& target) const;
+
+  /**
+   * @brief The subsampling of point cloud sensors
+   *
+   * The `"point_cloud_stride"` parameter of the spec, each point is then the
+   * center of a stride by stride block of pixels. Defaults to 1.
+   */
+  int pointCloudStride() const;
+
+  /**
+   * @brief The transformation of the points of point cloud sensors
+   *
+   * Following the `"point_cloud_frame"` parameter of the spec, an identity
+   * for `"camera"`, the default, and the absolute transformation of the
+   * sensor for `"world"`.
+   */
+  Mn::Matrix4 pointCloudTransformation() const;
+
+  /**
+   * @brief Update the remapping of the object ids of a semantic sensor to
+   * @p scene
+   *
+   * Following the `"semantic_remapping"` parameter of the spec, the object
+   * ids are remapped on the GPU to the category index of their object with
+   * `"category"`, or `"category:<mapping>"` for a mapping of
+   * @ref scene::SemanticCategory::index() such as `"mpcat40"`, and to
+   * compact instance ids with `"instance"`, see
+   * @ref scene::SemanticScene::semanticIdToCategoryIndex() and
+   * @ref scene::SemanticScene::semanticIdToInstanceId(). The lookup table is
+   * only uploaded again when the scene changes. Does nothing for other
+   * sensors or without the parameter.
+   */
+  void updateObjectIdRemapping(
+      const std::shared_ptr<scene::SemanticScene>& scene);
+
+  /**
+   * @brief The remapping of @ref updateObjectIdRemapping(), nullptr if the
+   * object ids aren't remapped
+   */
+  gfx::ObjectIdRemapping* objectIdRemapping() const {
+    return objectIdRemapping_.get();
+  }
+
   virtual bool displayObservation(sim::Simulator& sim) override;
 
   /**
@@ -46,6 +158,18 @@ class CameraSensor : public VisualSensor {
   virtual Corrade::Containers::Optional<Magnum::Vector2> depthUnprojection()
       const override;
 
+  /**
+   * @brief The foveation of color sensors with a `"foveation_inset"`
+   * parameter, the fraction of the width and height at the center of the
+   * image drawn at full resolution
+   *
+   * The rest is drawn at `"foveation_periphery_scale"` (default 0.5) times
+   * the resolution and upscaled. Only pinhole and orthographic cameras are
+   * foveated; their depth and object id attachments are left empty.
+   */
+  virtual Corrade::Containers::Optional<gfx::Foveation> foveation()
+      const override;
+
   /**
    * @brief Draw an observation to the frame buffer using simulator's renderer
    * @return true if success, otherwise false (e.g., frame buffer is not set)
@@ -54,6 +178,80 @@ class CameraSensor : public VisualSensor {
    */
   virtual bool drawObservation(sim::Simulator& sim) override;
 
+  /**
+   * @brief Same as @ref drawObservation() but draws @p sceneGraph instead of
+   * the active scene graph of @p sim, e.g. one mirroring another simulator.
+   * Semantic sensors draw the object ids of @p sceneGraph as they are.
+   */
+  bool drawObservationOf(sim::Simulator& sim, scene::SceneGraph& sceneGraph);
+
+  /**
+   * @brief Whether @p other renders the exact same view as this sensor, i.e.
+   * it can read its observation from the render target this sensor drew.
+   * True if both are CameraSensors with the same resolution, projection and
+   * absolute pose, and the pass of this sensor wrote the attachment @p other
+   * reads: depth sensors only draw depth and semantic sensors only depth and
+   * object ids.
+   *
+   * Callers must additionally check that both sensors draw the same scene
+   * graph (semantic sensors may use a separate semantic scene graph).
+   */
+  bool canShareRenderPass(const VisualSensor& other) const;
+
+  /**
+   * @brief Read this sensor's observation from the attachment of @p source
+   * matching its @ref SensorType, e.g. the render target of another sensor
+   * for which @ref canShareRenderPass() holds and which was drawn this frame.
+   * @param[in] source The RenderTarget holding the rendered frame
+   * @param[in,out] obs Instance of Observation class in which the observation
+   * will be stored
+   */
+  void readObservationFrom(gfx::RenderTarget& source, Observation& obs);
+
+  /**
+   * @brief Same as @ref readObservationFrom() but the observation is read
+   * into memory owned by the caller, e.g. a preallocated array. Always reads
+   * to the host, regardless of @ref SensorSpec::gpu2gpuTransfer.
+   * @param[in] source The RenderTarget holding the rendered frame
+   * @param[out] data Tightly packed rows of @ref observationPixelFormat() of
+   * @ref observationSize()
+   * @return Whether @p data has the size of the observation
+   */
+  bool readObservationInto(gfx::RenderTarget& source,
+                           Corrade::Containers::ArrayView<void> data);
+
+  /**
+   * @brief Count the pixels of each object id of a semantic sensor instead
+   * of reading its observation
+   * @param[in] source The RenderTarget holding the rendered frame
+   * @param[out] counts The pixels of each object id, remapped by
+   * @ref objectIdRemapping(), of @ref readRegion() at @ref readStride()
+   * @return Whether the sensor is a semantic sensor
+   *
+   * See @ref gfx::RenderTarget::readFrameObjectIdHistogram().
+   */
+  bool readObjectIdHistogram(gfx::RenderTarget& source,
+                             Corrade::Containers::ArrayView<Mn::UnsignedInt>
+                                 counts);
+
+#ifdef ESP_BUILD_WITH_CUDA
+  /**
+   * @brief Same as @ref readObservationFrom() but the observation is read
+   * into the next @ref Observation::deviceBuffer, never touching the host.
+   * Used by @ref readObservationFrom() when @ref SensorSpec::gpu2gpuTransfer
+   * is enabled.
+   *
+   * Like the host reads, the rows are in the order of @p source, see
+   * @ref gfx::RenderTarget::topDownRows(). The read is enqueued on
+   * @p stream, the legacy default stream if null, and returns without
+   * waiting for it; the work enqueued on @p stream after has the data, other
+   * streams wait with @ref DeviceBuffer::waitForWrite().
+   */
+  void readObservationToDevice(gfx::RenderTarget& source,
+                               Observation& obs,
+                               CUstream_st* stream = nullptr);
+#endif
+
   /**
    * @brief Modify the zoom matrix for perspective and ortho cameras
    * @param factor Modification amount.
@@ -84,7 +282,8 @@ class CameraSensor : public VisualSensor {
     spec_->parameters.at("hfov") =
         Corrade::Utility::ConfigurationValue<Mn::Deg>::toString(
             FOV, Corrade::Utility::ConfigurationValueFlags());
-    if (spec_->sensorSubType != SensorSubType::Pinhole) {
+    if (spec_->sensorSubType != SensorSubType::Pinhole &&
+        spec_->sensorSubType != SensorSubType::Fisheye) {
       LOG(INFO)
           << "CameraSensor::setFOV : Only Perspective-base CameraSensors use "
              "FOV. Specified value saved but will not be consumed by this "
@@ -173,6 +372,12 @@ class CameraSensor : public VisualSensor {
    */
   virtual void readObservation(Observation& obs);
 
+  // draws @p sceneGraph, then the objects of @p objectsSceneGraph if any and
+  // starts the async readback
+  void drawPass(sim::Simulator& sim,
+                scene::SceneGraph& sceneGraph,
+                scene::SceneGraph* objectsSceneGraph);
+
   /**
    * @brief This camera's projection matrix. Should be recomputeulated every
    * time size changes.
@@ -212,6 +417,14 @@ class CameraSensor : public VisualSensor {
    */
   Mn::Vector2 nearPlaneSize_;
 
+  /** @brief lookup table of the object ids, see updateObjectIdRemapping()
+   */
+  std::shared_ptr<gfx::ObjectIdRemapping> objectIdRemapping_;
+
+  /** @brief the semantic scene of objectIdRemapping_
+   */
+  std::weak_ptr<scene::SemanticScene> remappedSemanticScene_;
+
  public:
   ESP_SMART_POINTERS(CameraSensor)
 };
@@ -0,0 +1,126 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "CubeMapSensor.h"
+
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/Math/Functions.h>
+
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/RenderTarget.h"
+#include "esp/scene/SceneGraph.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sensor {
+
+CubeMapSensor::CubeMapSensor(scene::SceneNode& cameraNode,
+                             const SensorSpec::ptr& spec)
+    : CameraSensor(cameraNode, spec) {}
+
+int CubeMapSensor::getCubeMapSize() const {
+  // a face spans 90 degrees
+  float pixelsPerFace;
+  if (getCameraType() == SensorSubType::Fisheye) {
+    // the field of view spans the image width
+    pixelsPerFace = 90.0f * width_ / float(getFOV());
+  } else {
+    pixelsPerFace = width_ / 4.0f;
+  }
+  return Mn::Math::max(1, int(Mn::Math::ceil(pixelsPerFace)));
+}
+
+bool CubeMapSensor::drawThroughCubeMap(scene::SceneGraph& sceneGraph,
+                                       gfx::RenderCamera::Flags flags,
+                                       gfx::RenderTarget& target) {
+  if (!isCubeMapCameraType(getCameraType())) {
+    return false;
+  }
+
+  gfx::CubeMap::Flags cubeMapFlags;
+  gfx::CubeMapShader::Flags shaderFlags;
+  if (spec_->sensorType == SensorType::Semantic) {
+    cubeMapFlags = gfx::CubeMap::Flag::ObjectIdTexture;
+    shaderFlags = gfx::CubeMapShader::Flag::ObjectIdTexture;
+  } else if (spec_->sensorType == SensorType::Depth) {
+    cubeMapFlags = gfx::CubeMap::Flag::DepthTexture;
+    shaderFlags = gfx::CubeMapShader::Flag::DepthTexture;
+  } else {
+    cubeMapFlags = gfx::CubeMap::Flag::ColorTexture;
+    shaderFlags = gfx::CubeMapShader::Flag::ColorTexture;
+  }
+  if (target.topDownRows()) {
+    shaderFlags |= gfx::CubeMapShader::Flag::TopDownRows;
+  }
+  const auto projection = getCameraType() == SensorSubType::Fisheye
+                              ? gfx::CubeMapShader::Projection::Fisheye
+                              : gfx::CubeMapShader::Projection::Equirectangular;
+
+  // (re)created lazily, the sensor may be reconfigured at any time
+  const int cubeMapSize = getCubeMapSize();
+  if (!cubeMap_ || cubeMap_->getCubeMapSize() != cubeMapSize ||
+      cubeMap_->getFlags() != cubeMapFlags) {
+    cubeMap_ = gfx::CubeMap::create_unique(cubeMapSize, cubeMapFlags);
+  }
+  if (!shader_ || shader_->projection() != projection ||
+      shader_->flags() != shaderFlags) {
+    shader_ = std::make_unique<gfx::CubeMapShader>(projection, shaderFlags);
+  }
+  if (!mesh_.id()) {
+    mesh_ = Mn::GL::Mesh{};
+    mesh_.setCount(3);
+  }
+
+  gfx::CubeMapCamera& camera = sceneGraph.getDefaultCubeMapCamera();
+  setTransformationMatrix(camera);
+  camera.updateOriginalViewingMatrix().setProjectionMatrix(cubeMapSize, near_,
+                                                           far_);
+  // the objects-only pass of semantic sensors is drawn on top of the first
+  // one, as it is for the render target
+  cubeMap_->renderToTexture(
+      camera, sceneGraph, flags,
+      !(flags & gfx::RenderCamera::Flag::ObjectsOnly));
+
+  target.renderReEnter();
+#ifndef MAGNUM_TARGET_GLES
+  Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::SeamlessCubeMapTexture);
+#endif
+  if (projection == gfx::CubeMapShader::Projection::Fisheye) {
+    shader_->setFieldOfView(Mn::Rad{getFOV()})
+        .setAspectRatio(float(height_) / width_);
+  }
+  if (shaderFlags & gfx::CubeMapShader::Flag::ColorTexture) {
+    shader_->bindColorTexture(
+        cubeMap_->getTexture(gfx::CubeMap::TextureType::Color));
+  }
+  if (shaderFlags & gfx::CubeMapShader::Flag::DepthTexture) {
+    shader_
+        ->setDepthUnprojection(
+            gfx::calculateDepthUnprojection(camera.projectionMatrix()))
+        .bindDepthTexture(
+            cubeMap_->getTexture(gfx::CubeMap::TextureType::Depth));
+  }
+  if (shaderFlags & gfx::CubeMapShader::Flag::ObjectIdTexture) {
+    shader_->bindObjectIdTexture(
+        cubeMap_->getTexture(gfx::CubeMap::TextureType::ObjectId));
+  }
+
+  // every pixel is written, including the depth of the earlier passes
+  Mn::GL::Renderer::setDepthFunction(
+      Mn::GL::Renderer::DepthFunction::Always);
+  if (target.topDownRows()) {
+    Mn::GL::Renderer::setFrontFace(Mn::GL::Renderer::FrontFace::ClockWise);
+  }
+  shader_->draw(mesh_);
+  if (target.topDownRows()) {
+    Mn::GL::Renderer::setFrontFace(
+        Mn::GL::Renderer::FrontFace::CounterClockWise);
+  }
+  Mn::GL::Renderer::setDepthFunction(Mn::GL::Renderer::DepthFunction::Less);
+  return true;
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,67 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_CUBEMAPSENSOR_H_
+#define ESP_SENSOR_CUBEMAPSENSOR_H_
+
+#include <Magnum/GL/Mesh.h>
+
+#include "CameraSensor.h"
+#include "esp/core/esp.h"
+#include "esp/gfx/CubeMap.h"
+#include "esp/gfx/CubeMapShader.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief Camera sensor with an equirectangular or fisheye projection
+ *
+ * The scene is rendered into a @ref gfx::CubeMap with a single traversal (see
+ * @ref gfx::CubeMapCamera::drawFaces()), which is then projected into the
+ * render target of the sensor. Used for @ref SensorSubType::Equirectangular
+ * and @ref SensorSubType::Fisheye; for other camera types it behaves like a
+ * plain @ref CameraSensor.
+ *
+ * Depth sensors output the distance along the view ray rather than along the
+ * optical axis, as there is no single one.
+ */
+class CubeMapSensor : public CameraSensor {
+ public:
+  explicit CubeMapSensor(scene::SceneNode& cameraNode,
+                         const SensorSpec::ptr& spec);
+  virtual ~CubeMapSensor() {}
+
+  /**
+   * @brief Whether sensors of @p cameraType are drawn through a cube map
+   */
+  static bool isCubeMapCameraType(SensorSubType cameraType) {
+    return cameraType == SensorSubType::Equirectangular ||
+           cameraType == SensorSubType::Fisheye;
+  }
+
+  virtual bool drawThroughCubeMap(scene::SceneGraph& sceneGraph,
+                                  gfx::RenderCamera::Flags flags,
+                                  gfx::RenderTarget& target) override;
+
+  /**
+   * @brief The size of the cube map faces, chosen such that the cube map
+   * matches the angular resolution of the output at the image center
+   */
+  int getCubeMapSize() const;
+
+ protected:
+  gfx::CubeMap::uptr cubeMap_ = nullptr;
+  std::unique_ptr<gfx::CubeMapShader> shader_ = nullptr;
+  // full-screen triangle drawn by shader_
+  Magnum::GL::Mesh mesh_{Magnum::NoCreate};
+
+ public:
+  ESP_SMART_POINTERS(CubeMapSensor)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_CUBEMAPSENSOR_H_
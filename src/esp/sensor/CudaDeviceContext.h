@@ -0,0 +1,39 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_CUDADEVICECONTEXT_H_
+#define ESP_SENSOR_CUDADEVICECONTEXT_H_
+
+#include <cuda_runtime.h>
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief Makes a CUDA device current for its lifetime, restoring the
+ * previous one afterwards
+ */
+struct CudaDeviceContext {
+  explicit CudaDeviceContext(const int deviceId) {
+    cudaGetDevice(&currentDevice);
+    if (deviceId != currentDevice) {
+      cudaSetDevice(deviceId);
+      setDevice = true;
+    }
+  }
+
+  ~CudaDeviceContext() {
+    if (setDevice)
+      cudaSetDevice(currentDevice);
+  }
+
+ private:
+  bool setDevice = false;
+  int currentDevice = -1;
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_CUDADEVICECONTEXT_H_
@@ -0,0 +1,69 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "DeviceBuffer.h"
+
+#include <utility>
+
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <cuda_runtime.h>
+
+#include "CudaDeviceContext.h"
+
+namespace esp {
+namespace sensor {
+
+DeviceBuffer::DeviceBuffer(std::vector<size_t> shape,
+                           const core::DataType dataType,
+                           const int deviceId)
+    : shape_{std::move(shape)}, dataType_{dataType}, deviceId_{deviceId} {
+  byteSize_ = core::getDataTypeByteSize(dataType_);
+  for (const size_t size : shape_) {
+    byteSize_ *= size;
+  }
+  if (byteSize_ == 0) {
+    return;
+  }
+
+  CudaDeviceContext ctx{deviceId_};
+  const cudaError_t error = cudaMalloc(&data_, byteSize_);
+  CORRADE_ASSERT(error == cudaSuccess,
+                 "DeviceBuffer: cannot allocate"
+                     << byteSize_ << "bytes on CUDA device" << deviceId_
+                     << Corrade::Utility::Debug::nospace << ":"
+                     << cudaGetErrorString(error), );
+}
+
+DeviceBuffer::~DeviceBuffer() {
+  CudaDeviceContext ctx{deviceId_};
+  if (writeEvent_ != nullptr) {
+    cudaEventDestroy(writeEvent_);
+  }
+  if (data_ != nullptr) {
+    cudaFree(data_);
+  }
+}
+
+void DeviceBuffer::recordWrite(CUstream_st* stream) {
+  CudaDeviceContext ctx{deviceId_};
+  if (writeEvent_ == nullptr) {
+    const cudaError_t error =
+        cudaEventCreateWithFlags(&writeEvent_, cudaEventDisableTiming);
+    CORRADE_ASSERT(error == cudaSuccess,
+                   "DeviceBuffer::recordWrite(): cannot create an event:"
+                       << cudaGetErrorString(error), );
+  }
+  cudaEventRecord(writeEvent_, stream);
+}
+
+void DeviceBuffer::waitForWrite(CUstream_st* stream) const {
+  if (writeEvent_ != nullptr) {
+    CudaDeviceContext ctx{deviceId_};
+    cudaStreamWaitEvent(stream, writeEvent_, 0);
+  }
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,93 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_DEVICEBUFFER_H_
+#define ESP_SENSOR_DEVICEBUFFER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "esp/core/Buffer.h"
+#include "esp/core/esp.h"
+
+// the stream and event of cudaStream_t and cudaEvent_t, so that the CUDA
+// headers aren't needed here
+struct CUstream_st;
+struct CUevent_st;
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief Contiguous row-major tensor in CUDA memory, the GPU counterpart of
+ * @ref core::Buffer for observations read with
+ * @ref SensorSpec::gpu2gpuTransfer
+ *
+ * Only available in builds with CUDA. The memory is allocated on
+ * construction and freed on destruction, on the device it was created for.
+ * The reads into it are asynchronous: @ref recordWrite() marks the end of a
+ * read on its stream, and @ref waitForWrite() makes another stream wait for
+ * it.
+ */
+class DeviceBuffer {
+ public:
+  /**
+   * @brief Constructor
+   * @param shape, the shape of the tensor
+   * @param dataType, the type of its elements
+   * @param deviceId, the CUDA device to allocate the memory on
+   */
+  DeviceBuffer(std::vector<size_t> shape,
+               core::DataType dataType,
+               int deviceId);
+
+  ~DeviceBuffer();
+
+  DeviceBuffer(const DeviceBuffer&) = delete;
+  DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+
+  /** @brief Device pointer to the data */
+  void* data() const { return data_; }
+
+  /** @brief Size of the data in bytes */
+  size_t byteSize() const { return byteSize_; }
+
+  /** @brief Shape of the tensor */
+  const std::vector<size_t>& shape() const { return shape_; }
+
+  /** @brief Type of the elements */
+  core::DataType dataType() const { return dataType_; }
+
+  /** @brief CUDA device the data is on */
+  int deviceId() const { return deviceId_; }
+
+  /**
+   * @brief Mark the data as written by the work enqueued on @p stream so
+   * far, the legacy default stream if null
+   */
+  void recordWrite(CUstream_st* stream);
+
+  /**
+   * @brief Make the work enqueued on @p stream after this call wait until
+   * the last @ref recordWrite() is done, without blocking the host. A no-op
+   * if the data was never written asynchronously.
+   */
+  void waitForWrite(CUstream_st* stream) const;
+
+ private:
+  std::vector<size_t> shape_;
+  core::DataType dataType_;
+  int deviceId_;
+  size_t byteSize_ = 0;
+  void* data_ = nullptr;
+  // created on the first recordWrite()
+  CUevent_st* writeEvent_ = nullptr;
+
+  ESP_SMART_POINTERS(DeviceBuffer)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_DEVICEBUFFER_H_
@@ -0,0 +1,135 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "LidarSensor.h"
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/Math/Angle.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Vector4.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "esp/core/Profiling.h"
+#include "esp/core/random.h"
+#include "esp/sim/Simulator.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sensor {
+
+namespace {
+float parameter(const SensorSpec& spec,
+                const std::string& name,
+                const float defaultValue) {
+  auto found = spec.parameters.find(name);
+  return found == spec.parameters.end() ? defaultValue
+                                        : std::atof(found->second.c_str());
+}
+}  // namespace
+
+LidarSensor::LidarSensor(scene::SceneNode& node, const SensorSpec::ptr& spec)
+    : Sensor{node, spec} {
+  setScanParameters(spec);
+}
+
+void LidarSensor::setScanParameters(const SensorSpec::ptr& spec) {
+  ASSERT(spec != nullptr);
+  spec_ = spec;
+  near_ = parameter(*spec_, "near", 0.0f);
+  far_ = parameter(*spec_, "far", 100.0f);
+  noiseStddev_ = parameter(*spec_, "noise_stddev", 0.0f);
+  const Mn::Rad hfov{Mn::Deg{parameter(*spec_, "hfov", 360.0f)}};
+  const Mn::Rad vfov{Mn::Deg{parameter(*spec_, "vfov", 30.0f)}};
+
+  const int channels = std::max(0, spec_->resolution[0]);
+  const int raysPerChannel = std::max(0, spec_->resolution[1]);
+  // a full turn would cast the first and the last ray the same way
+  const bool fullTurn = float(hfov) >= float(Mn::Rad{Mn::Deg{360.0f}});
+  const Mn::Rad azimuthStep =
+      raysPerChannel > 1 ? hfov / float(fullTurn ? raysPerChannel
+                                                 : raysPerChannel - 1)
+                         : Mn::Rad{0.0f};
+  const Mn::Rad elevationStep =
+      channels > 1 ? vfov / float(channels - 1) : Mn::Rad{0.0f};
+  const Mn::Rad topElevation = channels > 1 ? vfov * 0.5f : Mn::Rad{0.0f};
+  const Mn::Rad leftAzimuth =
+      raysPerChannel > 1 && !fullTurn ? hfov * 0.5f : Mn::Rad{0.0f};
+
+  rayDirections_.clear();
+  rayDirections_.reserve(channels * raysPerChannel);
+  for (int channel = 0; channel < channels; ++channel) {
+    const Mn::Rad elevation = topElevation - elevationStep * float(channel);
+    const float sinElevation = Mn::Math::sin(elevation);
+    const float cosElevation = Mn::Math::cos(elevation);
+    for (int ray = 0; ray < raysPerChannel; ++ray) {
+      // positive azimuths are to the left of -Z, towards -X
+      const Mn::Rad azimuth = leftAzimuth - azimuthStep * float(ray);
+      rayDirections_.emplace_back(-Mn::Math::sin(azimuth) * cosElevation,
+                                  sinElevation,
+                                  -Mn::Math::cos(azimuth) * cosElevation);
+    }
+  }
+}
+
+bool LidarSensor::getObservationSpace(ObservationSpace& space) {
+  space.spaceType = ObservationSpaceType::Tensor;
+  space.dataType = core::DataType::DT_FLOAT;
+  space.shape = {static_cast<size_t>(std::max(0, spec_->resolution[0])),
+                 static_cast<size_t>(std::max(0, spec_->resolution[1])), 4};
+  return true;
+}
+
+bool LidarSensor::getObservation(sim::Simulator& sim, Observation& obs) {
+  ESP_PROFILE_SCOPE("LidarSensor::getObservation");
+  if (rayDirections_.size() !=
+      size_t(std::max(0, spec_->resolution[0]) *
+             std::max(0, spec_->resolution[1]))) {
+    setScanParameters(spec_);
+  }
+
+  // the rays are unit length in the world, so that the hit distances are
+  // ranges, starting at the near distance
+  const Mn::Matrix4 transformation = node().absoluteTransformationMatrix();
+  const Mn::Vector3 origin = transformation.translation();
+  std::vector<geo::Ray> rays;
+  rays.reserve(rayDirections_.size());
+  for (const Mn::Vector3& direction : rayDirections_) {
+    const Mn::Vector3 worldDirection =
+        transformation.transformVector(direction).normalized();
+    rays.emplace_back(origin + worldDirection * near_, worldDirection);
+  }
+  const physics::MultiRaycastResults results = sim.castRays(
+      rays, std::max(0.0f, far_ - near_), /*closestHitOnly=*/true);
+
+  // the noise of all rays drawn in one go, hits or not, so that a ray gets
+  // the same noise whatever the others hit
+  noise_.resize(noiseStddev_ > 0.0f ? rayDirections_.size() : 0);
+  sim.random()->fillNormal(noise_, 0.0f, noiseStddev_);
+
+  obs.buffer = nextObservationBuffer();
+  auto* points = reinterpret_cast<Mn::Vector4*>(obs.buffer->data.data());
+  for (size_t i = 0; i != rayDirections_.size(); ++i) {
+    if (results.hitOffsets[i] == results.hitOffsets[i + 1]) {
+      points[i] = {};
+      continue;
+    }
+    float range = near_ + float(results.rayDistances[results.hitOffsets[i]]);
+    if (noiseStddev_ > 0.0f) {
+      range = std::max(0.0f, range + noise_[i]);
+    }
+    points[i] = {rayDirections_[i] * range, range};
+  }
+  return true;
+}
+
+bool LidarSensor::displayObservation(sim::Simulator&) {
+  return false;
+}
+
+}  // namespace sensor
+}  // namespace esp
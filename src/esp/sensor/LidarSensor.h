@@ -0,0 +1,75 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_LIDARSENSOR_H_
+#define ESP_SENSOR_LIDARSENSOR_H_
+
+/** @file
+ * @brief Class @ref esp::sensor::LidarSensor
+ */
+
+#include <Magnum/Math/Vector3.h>
+#include <vector>
+
+#include "Sensor.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief Range scanner casting a batch of rays into the collision world, see
+ * @ref physics::PhysicsManager::castRays()
+ *
+ * The @ref SensorSpec::resolution is the number of channels, i.e. rows of
+ * rays stacked vertically, by the number of rays per channel. The rays fan
+ * out over the `"hfov"` and `"vfov"` (default 30) parameters in degrees
+ * around the -Z axis of the sensor, the first channel at the top and the
+ * first ray of each at the left. With an `"hfov"` of 360 the rays go all
+ * around, with no two at the same azimuth. Hits closer than `"near"` or
+ * further than `"far"` are ignored, and the range of each hit gets a normal
+ * noise of `"noise_stddev"` meters (default 0).
+ *
+ * An observation is a point cloud of channels x rays x 4 floats: the hit
+ * point in the sensor frame and its range, all zero for a ray that hit
+ * nothing. It's empty, i.e. all miss, if physics isn't enabled.
+ */
+class LidarSensor : public Sensor {
+ public:
+  explicit LidarSensor(scene::SceneNode& node, const SensorSpec::ptr& spec);
+  virtual ~LidarSensor() {}
+
+  /**
+   * @brief Update the ray directions and ranges from the parameters of
+   * @p spec
+   */
+  void setScanParameters(const SensorSpec::ptr& spec);
+
+  /** @brief The unit ray directions in the sensor frame, row-major */
+  const std::vector<Magnum::Vector3>& rayDirections() const {
+    return rayDirections_;
+  }
+
+  virtual bool getObservation(sim::Simulator& sim, Observation& obs) override;
+
+  virtual bool getObservationSpace(ObservationSpace& space) override;
+
+  /** @brief A lidar has nothing to display, always fails */
+  virtual bool displayObservation(sim::Simulator& sim) override;
+
+ protected:
+  std::vector<Magnum::Vector3> rayDirections_;
+  float near_ = 0.0f;
+  float far_ = 0.0f;
+  float noiseStddev_ = 0.0f;
+  // the range noise of the rays, reused across observations
+  std::vector<float> noise_;
+
+  ESP_SMART_POINTERS(LidarSensor)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_LIDARSENSOR_H_
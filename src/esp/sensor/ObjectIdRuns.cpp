@@ -0,0 +1,45 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObjectIdRuns.h"
+
+#include <Corrade/Utility/Assert.h>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace sensor {
+
+std::size_t countObjectIdRuns(
+    Cr::Containers::ArrayView<const std::uint32_t> ids) {
+  if (ids.empty()) {
+    return 0;
+  }
+  // a run starts wherever the id changes, which the compiler vectorizes
+  std::size_t count = 1;
+  for (std::size_t i = 1; i < ids.size(); ++i) {
+    count += ids[i] != ids[i - 1];
+  }
+  return count;
+}
+
+void encodeObjectIdRuns(Cr::Containers::ArrayView<const std::uint32_t> ids,
+                        Cr::Containers::ArrayView<std::uint32_t> runs) {
+  CORRADE_ASSERT(runs.size() == 2 * countObjectIdRuns(ids),
+                 "sensor::encodeObjectIdRuns(): expected"
+                     << 2 * countObjectIdRuns(ids) << "values but got"
+                     << runs.size(), );
+  std::size_t run = 0;
+  std::size_t start = 0;
+  for (std::size_t i = 1; i <= ids.size(); ++i) {
+    if (i == ids.size() || ids[i] != ids[start]) {
+      runs[run++] = ids[start];
+      runs[run++] = std::uint32_t(i - start);
+      start = i;
+    }
+  }
+}
+
+}  // namespace sensor
+}  // namespace esp
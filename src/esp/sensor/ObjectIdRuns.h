@@ -0,0 +1,45 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_OBJECTIDRUNS_H_
+#define ESP_SENSOR_OBJECTIDRUNS_H_
+
+/** @file
+ * @brief Function @ref esp::sensor::encodeObjectIdRuns()
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief The number of runs of equal consecutive ids in @p ids, the size of
+ * the encoding of @ref encodeObjectIdRuns() in pairs
+ */
+std::size_t countObjectIdRuns(
+    Corrade::Containers::ArrayView<const std::uint32_t> ids);
+
+/**
+ * @brief Run-length encode object ids, e.g. a semantic observation as read by
+ * @ref gfx::RenderTarget::readFrameObjectId()
+ * @param[in] ids    The ids, in row-major order
+ * @param[out] runs  An id and the number of consecutive pixels with it for
+ *                   each run, interleaved, i.e. twice
+ *                   @ref countObjectIdRuns() values
+ *
+ * Runs continue across rows, so the frame size is needed to decode them.
+ * Semantic frames are mostly long runs of the same ids, their encoding is
+ * typically orders of magnitude smaller than the frame, for logging or
+ * sending observations.
+ */
+void encodeObjectIdRuns(Corrade::Containers::ArrayView<const std::uint32_t> ids,
+                        Corrade::Containers::ArrayView<std::uint32_t> runs);
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_OBJECTIDRUNS_H_
@@ -0,0 +1,275 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObservationRecorder.h"
+
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/AbstractImageConverter.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "CameraSensor.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/ThreadPool.h"
+#include "esp/gfx/RenderTarget.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sensor {
+
+namespace {
+struct Frame {
+  std::string filename;
+  Mn::PixelFormat format;
+  Mn::Vector2i size;
+  bool topDownRows;
+  std::vector<char> data;
+};
+
+// The formats that fit in a PNG without losing anything
+bool isPngFormat(const Mn::PixelFormat format) {
+  return format == Mn::PixelFormat::RGBA8Unorm ||
+         format == Mn::PixelFormat::RGB8Unorm ||
+         format == Mn::PixelFormat::R8Unorm;
+}
+
+// The numpy type of the channels of @p format and their number, bytes for
+// the formats without a numpy equivalent
+const char* npyType(const Mn::PixelFormat format, std::size_t& channels) {
+  channels = 1;
+  switch (format) {
+    case Mn::PixelFormat::R16UI:
+      return "<u2";
+    case Mn::PixelFormat::R16F:
+      return "<f2";
+    case Mn::PixelFormat::R32UI:
+      return "<u4";
+    case Mn::PixelFormat::R32I:
+      return "<i4";
+    case Mn::PixelFormat::R32F:
+      return "<f4";
+    case Mn::PixelFormat::RGB32F:
+      channels = 3;
+      return "<f4";
+    case Mn::PixelFormat::RGBA32F:
+      channels = 4;
+      return "<f4";
+    default:
+      channels = Mn::pixelSize(format);
+      return "|u1";
+  }
+}
+
+std::size_t rowSize(const Frame& frame) {
+  return Mn::pixelSize(frame.format) * frame.size.x();
+}
+
+// Writes a version 1.0 .npy file of height x width x channels
+bool writeNpy(const Frame& frame) {
+  std::size_t channels;
+  const char* type = npyType(frame.format, channels);
+  std::string header = "{'descr': '" + std::string{type} +
+                       "', 'fortran_order': False, 'shape': (" +
+                       std::to_string(frame.size.y()) + ", " +
+                       std::to_string(frame.size.x()) + ", " +
+                       std::to_string(channels) + "), }";
+  // the data starts aligned to 64 bytes, after the magic, the version and
+  // the size of the header
+  header.resize((10 + header.size() + 1 + 63) / 64 * 64 - 10 - 1, ' ');
+  header += '\n';
+
+  std::ofstream file{frame.filename, std::ios::binary};
+  const char preamble[]{'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                        char(header.size() & 0xff), char(header.size() >> 8)};
+  file.write(preamble, sizeof(preamble));
+  file << header;
+  // the rows of the render target are bottom-up unless it's flipped
+  const std::size_t size = rowSize(frame);
+  for (int y = 0; y < frame.size.y(); ++y) {
+    const int row = frame.topDownRows ? y : frame.size.y() - 1 - y;
+    file.write(frame.data.data() + row * size, size);
+  }
+  return bool(file);
+}
+
+bool writePng(Frame& frame, Mn::Trade::AbstractImageConverter& converter) {
+  // images are bottom-up, as the render targets that aren't flipped
+  if (frame.topDownRows) {
+    const std::size_t size = rowSize(frame);
+    for (int y = 0; y < frame.size.y() / 2; ++y) {
+      std::swap_ranges(frame.data.begin() + y * size,
+                       frame.data.begin() + (y + 1) * size,
+                       frame.data.end() - (y + 1) * size);
+    }
+  }
+  const Mn::ImageView2D image{Mn::PixelStorage{}.setAlignment(1), frame.format,
+                              frame.size,
+                              {frame.data.data(), frame.data.size()}};
+  return converter.exportToFile(image, frame.filename);
+}
+}  // namespace
+
+struct ObservationRecorder::Impl {
+  Impl(const std::string& directory,
+       const std::size_t numThreads,
+       const std::size_t maxQueuedFrames)
+      : directory{directory},
+        maxQueuedFrames{std::max<std::size_t>(maxQueuedFrames, 1)},
+        pool{std::max<std::size_t>(numThreads, 1)} {}
+
+  std::string directory;
+  std::size_t maxQueuedFrames;
+  // the number of the next frame of each sensor
+  std::map<std::string, int> nextFrames;
+
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImageConverter>
+      converterManager;
+
+  mutable std::mutex mutex;
+  std::condition_variable frameDone;
+  std::size_t numQueued = 0;
+  std::size_t numWritten = 0;
+  std::size_t numFailed = 0;
+  std::vector<std::vector<char>> freeBuffers;
+  // one for each thread, converters aren't thread-safe
+  std::vector<std::unique_ptr<Mn::Trade::AbstractImageConverter>>
+      freeConverters;
+
+  // last, so that its threads are done before the rest is destroyed
+  core::ThreadPool pool;
+
+  void write(Frame& frame) {
+    std::unique_ptr<Mn::Trade::AbstractImageConverter> converter;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      converter = std::move(freeConverters.back());
+      freeConverters.pop_back();
+    }
+
+    bool written;
+    if (isPngFormat(frame.format)) {
+      written = converter && writePng(frame, *converter);
+    } else {
+      written = writeNpy(frame);
+    }
+    if (!written) {
+      LOG(ERROR) << "ObservationRecorder: cannot write " << frame.filename;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      freeConverters.push_back(std::move(converter));
+      freeBuffers.push_back(std::move(frame.data));
+      if (written) {
+        ++numWritten;
+      } else {
+        ++numFailed;
+      }
+      --numQueued;
+    }
+    frameDone.notify_all();
+  }
+};
+
+ObservationRecorder::ObservationRecorder(const std::string& directory,
+                                         const std::size_t numThreads,
+                                         const std::size_t maxQueuedFrames)
+    : pimpl_{spimpl::make_unique_impl<Impl>(directory,
+                                            numThreads,
+                                            maxQueuedFrames)} {
+  for (std::size_t i = 0; i != pimpl_->pool.numThreads(); ++i) {
+    pimpl_->freeConverters.push_back(
+        pimpl_->converterManager.loadAndInstantiate("AnyImageConverter"));
+  }
+  if (!pimpl_->freeConverters.front()) {
+    LOG(ERROR) << "ObservationRecorder: the AnyImageConverter plugin is "
+                  "needed to write color observations";
+  }
+}
+
+ObservationRecorder::~ObservationRecorder() {
+  flush();
+}
+
+int ObservationRecorder::record(CameraSensor& sensor) {
+  ESP_PROFILE_SCOPE("ObservationRecorder::record");
+  if (!sensor.hasRenderTarget()) {
+    return -1;
+  }
+
+  const std::string& uuid = sensor.specification()->uuid;
+  auto found = pimpl_->nextFrames.find(uuid);
+  if (found == pimpl_->nextFrames.end()) {
+    const std::string sensorDirectory =
+        Cr::Utility::Directory::join(pimpl_->directory, uuid);
+    if (!Cr::Utility::Directory::mkpath(sensorDirectory)) {
+      LOG(ERROR) << "ObservationRecorder: cannot create " << sensorDirectory;
+    }
+    found = pimpl_->nextFrames.emplace(uuid, 0).first;
+  }
+  const int frameIndex = found->second++;
+
+  auto frame = std::make_shared<Frame>();
+  frame->format = sensor.observationPixelFormat();
+  frame->size = sensor.observationSize();
+  frame->topDownRows = sensor.renderTarget().topDownRows();
+  frame->filename = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::join(pimpl_->directory, uuid),
+      Cr::Utility::formatString("{:.6}.{}", frameIndex,
+                                isPngFormat(frame->format) ? "png" : "npy"));
+  {
+    // back-pressure, the frames wait on the disk rather than in memory
+    std::unique_lock<std::mutex> lock(pimpl_->mutex);
+    pimpl_->frameDone.wait(lock, [this]() {
+      return pimpl_->numQueued < pimpl_->maxQueuedFrames;
+    });
+    ++pimpl_->numQueued;
+    if (!pimpl_->freeBuffers.empty()) {
+      frame->data = std::move(pimpl_->freeBuffers.back());
+      pimpl_->freeBuffers.pop_back();
+    }
+  }
+
+  frame->data.resize(Mn::pixelSize(frame->format) * frame->size.product());
+  sensor.readObservationInto(sensor.renderTarget(),
+                             {frame->data.data(), frame->data.size()});
+  Impl* impl = &*pimpl_;
+  pimpl_->pool.submit([impl, frame]() { impl->write(*frame); });
+  return frameIndex;
+}
+
+void ObservationRecorder::flush() {
+  std::unique_lock<std::mutex> lock(pimpl_->mutex);
+  pimpl_->frameDone.wait(lock, [this]() { return pimpl_->numQueued == 0; });
+}
+
+std::size_t ObservationRecorder::numWritten() const {
+  std::lock_guard<std::mutex> lock(pimpl_->mutex);
+  return pimpl_->numWritten;
+}
+
+std::size_t ObservationRecorder::numFailed() const {
+  std::lock_guard<std::mutex> lock(pimpl_->mutex);
+  return pimpl_->numFailed;
+}
+
+std::size_t ObservationRecorder::numQueued() const {
+  std::lock_guard<std::mutex> lock(pimpl_->mutex);
+  return pimpl_->numQueued;
+}
+
+}  // namespace sensor
+}  // namespace esp
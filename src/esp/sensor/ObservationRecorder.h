@@ -0,0 +1,83 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_OBSERVATIONRECORDER_H_
+#define ESP_SENSOR_OBSERVATIONRECORDER_H_
+
+/** @file
+ * @brief Class @ref esp::sensor::ObservationRecorder
+ */
+
+#include <cstddef>
+#include <string>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+class CameraSensor;
+
+/**
+ * @brief Writes the observations of camera sensors to files on background
+ * threads, e.g. to create datasets
+ *
+ * @ref record() reads the observation the sensor drew straight from its
+ * render target, waiting on the async readback if there is one, and queues
+ * the encoding. The frames of a sensor are numbered in the order they are
+ * recorded, `<directory>/<uuid>/<frame>.png` for 8-bit color observations
+ * and `<directory>/<uuid>/<frame>.npy` for the others, e.g. depth, semantic
+ * ids or normals, so that they keep their exact values. The images are
+ * written with the first row at the top.
+ *
+ * At most a given number of frames wait to be written: @ref record() blocks
+ * until one is done, so that a simulator that renders faster than the disk
+ * writes doesn't run out of memory. Their buffers are reused.
+ */
+class ObservationRecorder {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] directory       Where to write the frames, created if needed
+   * @param[in] numThreads      The number of threads encoding the frames
+   * @param[in] maxQueuedFrames The number of frames waiting to be written
+   *                            from which @ref record() blocks
+   */
+  explicit ObservationRecorder(const std::string& directory,
+                               std::size_t numThreads = 2,
+                               std::size_t maxQueuedFrames = 8);
+
+  /** @brief Destructor, writes the queued frames first */
+  ~ObservationRecorder();
+
+  /**
+   * @brief Queue the observation @p sensor drew last
+   *
+   * Call it on the thread of the GL context, after the sensor drew, e.g.
+   * with @ref sim::Simulator::drawObservation().
+   *
+   * @return The number of the frame, -1 if the sensor has no render target
+   */
+  int record(CameraSensor& sensor);
+
+  /** @brief Wait until every queued frame is written */
+  void flush();
+
+  /** @brief The number of frames written so far */
+  std::size_t numWritten() const;
+
+  /** @brief The number of frames that couldn't be written */
+  std::size_t numFailed() const;
+
+  /** @brief The number of frames waiting to be written */
+  std::size_t numQueued() const;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(ObservationRecorder)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_OBSERVATIONRECORDER_H_
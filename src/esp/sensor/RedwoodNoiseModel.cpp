@@ -4,34 +4,17 @@
 
 #include <cuda_runtime.h>
 
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+
 #include "RedwoodNoiseModel.h"
 
+#include "CudaDeviceContext.h"
+#include "esp/gfx/RenderTarget.h"
+
 namespace esp {
 namespace sensor {
 
-namespace {
-
-struct CudaDeviceContext {
-  explicit CudaDeviceContext(const int deviceId) {
-    cudaGetDevice(&currentDevice);
-    if (deviceId != currentDevice) {
-      cudaSetDevice(deviceId);
-      setDevice = true;
-    }
-  }
-
-  ~CudaDeviceContext() {
-    if (setDevice)
-      cudaSetDevice(currentDevice);
-  }
-
- private:
-  bool setDevice = false;
-  int currentDevice = -1;
-};
-
-}  // namespace
-
 RedwoodNoiseModelGPUImpl::RedwoodNoiseModelGPUImpl(
     const Eigen::Ref<const Eigen::RowMatrixXf> model,
     const int gpuDeviceId,
@@ -51,9 +34,26 @@ RedwoodNoiseModelGPUImpl::~RedwoodNoiseModelGPUImpl() {
 
   if (devModel_ != nullptr)
     cudaFree(devModel_);
+  reserveDeviceBuffers(0);
   impl::freeCurandStates(curandStates_);
 }
 
+void RedwoodNoiseModelGPUImpl::reserveDeviceBuffers(const size_t size) {
+  if (size != 0 && size <= devBufferSize_)
+    return;
+
+  if (devDepth_ != nullptr)
+    cudaFree(devDepth_);
+  if (devNoisyDepth_ != nullptr)
+    cudaFree(devNoisyDepth_);
+  devDepth_ = devNoisyDepth_ = nullptr;
+  devBufferSize_ = size;
+  if (size != 0) {
+    cudaMalloc(&devDepth_, size * sizeof(float));
+    cudaMalloc(&devNoisyDepth_, size * sizeof(float));
+  }
+}
+
 Eigen::RowMatrixXf RedwoodNoiseModelGPUImpl::simulateFromCPU(
     const Eigen::Ref<const Eigen::RowMatrixXf> depth) {
   CudaDeviceContext ctx{gpuDeviceId_};
@@ -71,7 +71,49 @@ void RedwoodNoiseModelGPUImpl::simulateFromGPU(const float* devDepth,
                                                float* devNoisyDepth) {
   CudaDeviceContext ctx{gpuDeviceId_};
   impl::simulateFromGPU(devDepth, rows, cols, devModel_, curandStates_,
-                        noiseMultiplier_, devNoisyDepth);
+                        noiseMultiplier_, false, devNoisyDepth);
+}
+
+void RedwoodNoiseModelGPUImpl::simulateBatchFromGPU(const float* devDepth,
+                                                    const int batch,
+                                                    const int rows,
+                                                    const int cols,
+                                                    float* devNoisyDepth) {
+  CudaDeviceContext ctx{gpuDeviceId_};
+  impl::simulateBatchFromGPU(devDepth, batch, rows, cols, devModel_,
+                             curandStates_, noiseMultiplier_, false,
+                             devNoisyDepth);
+}
+
+void RedwoodNoiseModelGPUImpl::simulateFromRenderTargetGPU(
+    gfx::RenderTarget& target,
+    float* devNoisyDepth) {
+  CudaDeviceContext ctx{gpuDeviceId_};
+
+  const Magnum::Vector2i size = target.framebufferSize();
+  reserveDeviceBuffers(size.product());
+  target.readFrameDepthGPU(devDepth_);
+  impl::simulateFromGPU(devDepth_, size.y(), size.x(), devModel_,
+                        curandStates_, noiseMultiplier_, true, devNoisyDepth);
+}
+
+void RedwoodNoiseModelGPUImpl::simulateFromRenderTarget(
+    gfx::RenderTarget& target,
+    const Magnum::MutableImageView2D& view) {
+  CORRADE_ASSERT(view.format() == Magnum::PixelFormat::R32F &&
+                     view.size() == target.framebufferSize(),
+                 "RedwoodNoiseModelGPUImpl::simulateFromRenderTarget(): "
+                 "expected an R32F view of the framebuffer size", );
+  CudaDeviceContext ctx{gpuDeviceId_};
+
+  const Magnum::Vector2i size = target.framebufferSize();
+  reserveDeviceBuffers(size.product());
+  target.readFrameDepthGPU(devDepth_);
+  impl::simulateFromGPU(devDepth_, size.y(), size.x(), devModel_,
+                        curandStates_, noiseMultiplier_, true, devNoisyDepth_);
+  // R32F rows are always 4-byte aligned, so the view is packed
+  cudaMemcpy(view.data(), devNoisyDepth_, size.product() * sizeof(float),
+             cudaMemcpyDeviceToHost);
 }
 
 }  // namespace sensor
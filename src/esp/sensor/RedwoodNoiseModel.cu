@@ -36,19 +36,24 @@ __device__ float undistort(const int _x,
     return z / f;
 }
 
+// Noises a stack of images, one per blockIdx.y
 __global__ void redwoodNoiseModelKernel(const float* __restrict__ depth,
                                         const int H,
                                         const int W,
                                         curandState_t* states,
                                         const float* __restrict__ model,
                                         const float noiseMultiplier,
+                                        const bool flipInput,
                                         float* __restrict__ noisyDepth) {
   const int TID = threadIdx.x;
   const int BID = blockIdx.x;
 
   // curandStates are thread-safe, so all threads in a block share the same
   // state. They are NOT block safe however
-  curandState_t curandState = states[BID];
+  curandState_t curandState = states[blockIdx.y * gridDim.x + BID];
+
+  depth += size_t(blockIdx.y) * H * W;
+  noisyDepth += size_t(blockIdx.y) * H * W;
 
   const float ymax = H - 1;
   const float xmax = W - 1;
@@ -68,7 +73,8 @@ __global__ void redwoodNoiseModelKernel(const float* __restrict__ depth,
           0.5f;
 
       // downsample
-      const float d = depth[(y - y % 2) * W + x - x % 2];
+      const int row = flipInput ? H - 1 - (y - y % 2) : y - y % 2;
+      const float d = depth[row * W + x - x % 2];
       // If depth is greater than 10m, the sensor will just return a zero
       if (d >= 10.0f) {
         noisyDepth[j * W + i] = 0.0f;
@@ -115,7 +121,7 @@ struct CurandStates {
     if (n_blocks > n_blocks_) {
       release();
       cudaMalloc(&devStates, n_blocks * sizeof(curandState_t));
-      curandStatesSetupKernel<<<std::max(n_blocks / 64, 1), 64>>>(
+      curandStatesSetupKernel<<<(n_blocks + 63) / 64, 64>>>(
           devStates, rand(), n_blocks);
       n_blocks_ = n_blocks;
     }
@@ -151,14 +157,29 @@ void simulateFromGPU(const float* __restrict__ devDepth,
                      const float* __restrict__ devModel,
                      CurandStates* curandStates,
                      const float noiseMultiplier,
+                     const bool flipInput,
                      float* __restrict__ devNoisyDepth) {
+  simulateBatchFromGPU(devDepth, 1, H, W, devModel, curandStates,
+                       noiseMultiplier, flipInput, devNoisyDepth);
+}
+
+void simulateBatchFromGPU(const float* __restrict__ devDepth,
+                          const int N,
+                          const int H,
+                          const int W,
+                          const float* __restrict__ devModel,
+                          CurandStates* curandStates,
+                          const float noiseMultiplier,
+                          const bool flipInput,
+                          float* __restrict__ devNoisyDepth) {
   const int n_threads = std::min(std::max(W / 4, 1), 256);
   const int n_blocks = std::max(H / 8, 1);
 
-  curandStates->alloc(n_blocks);
-  redwoodNoiseModelKernel<<<n_blocks, n_threads>>>(
+  // every image of the stack gets its own states
+  curandStates->alloc(n_blocks * N);
+  redwoodNoiseModelKernel<<<dim3(n_blocks, N), n_threads>>>(
       devDepth, H, W, curandStates->devStates, devModel, noiseMultiplier,
-      devNoisyDepth);
+      flipInput, devNoisyDepth);
 }
 
 void simulateFromCPU(const float* __restrict__ depth,
@@ -175,7 +196,7 @@ void simulateFromCPU(const float* __restrict__ depth,
   cudaMemcpy(devDepth, depth, H * W * sizeof(float), cudaMemcpyHostToDevice);
 
   simulateFromGPU(devDepth, H, W, devModel, curandStates, noiseMultiplier,
-                  devNoisyDepth);
+                  false, devNoisyDepth);
 
   cudaMemcpy(noisyDepth, devNoisyDepth, H * W * sizeof(float),
              cudaMemcpyDeviceToHost);
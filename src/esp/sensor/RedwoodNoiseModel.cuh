@@ -23,13 +23,28 @@ void simulateFromCPU(const float* __restrict__ depth,
                      const float noiseMultiplier,
                      float* __restrict__ noisyDepth);
 
+// With flipInput, the rows of devDepth are bottom-up as read from OpenGL,
+// while devNoisyDepth is always top-down
 void simulateFromGPU(const float* __restrict__ devDepth,
                      const int H,
                      const int W,
                      const float* __restrict__ devModel,
                      CurandStates* curandStates,
                      const float noiseMultiplier,
+                     const bool flipInput,
                      float* __restrict__ devNoisyDepth);
+
+// Same as simulateFromGPU() for N images of H x W stacked contiguously, in a
+// single launch
+void simulateBatchFromGPU(const float* __restrict__ devDepth,
+                          const int N,
+                          const int H,
+                          const int W,
+                          const float* __restrict__ devModel,
+                          CurandStates* curandStates,
+                          const float noiseMultiplier,
+                          const bool flipInput,
+                          float* __restrict__ devNoisyDepth);
 }  // namespace impl
 }  // namespace sensor
 }  // namespace esp
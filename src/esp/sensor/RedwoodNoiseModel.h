@@ -6,12 +6,18 @@
 #ifndef ESP_SENSOR_REDWOODNOISEMODEL_H_
 #define ESP_SENSOR_REDWOODNOISEMODEL_H_
 
+#include <Magnum/Magnum.h>
+
 #include "esp/core/esp.h"
 #include "esp/core/random.h"
 
 #include "RedwoodNoiseModel.cuh"
 
 namespace esp {
+namespace gfx {
+class RenderTarget;
+}
+
 namespace sensor {
 
 /**
@@ -74,13 +80,65 @@ struct RedwoodNoiseModelGPUImpl {
                        const int cols,
                        float* devNoisyDepth);
 
+  /**
+   * @brief Similar to @ref simulateFromGPU() for a stack of depth images, e.g.
+   * one per environment, noised in a single kernel launch.
+   *
+   * @param[in] devDepth        Device pointer to the clean depth, @p batch
+   *                            images stored one after another
+   * @param[in] batch           The number of images
+   * @param[in] rows            The number of rows in each image
+   * @param[in] cols            The number of columns
+   * @param[out] devNoisyDepth  Device pointer to the memory to write the noisy
+   *                            depth, laid out like @p devDepth
+   */
+  void simulateBatchFromGPU(const float* devDepth,
+                            const int batch,
+                            const int rows,
+                            const int cols,
+                            float* devNoisyDepth);
+
+  /**
+   * @brief Simulates noisy depth from the depth @p target was drawn with,
+   * with the depth staying on the GPU.
+   *
+   * The clean depth is copied to device memory as by
+   * @ref gfx::RenderTarget::readFrameDepthGPU() and noised there. Unlike
+   * what the render target reads, the rows of the noisy depth are top-down as
+   * in observations, so it needs no flipping.
+   *
+   * @param[in] target          Render target of the depth sensor
+   * @param[out] devNoisyDepth  Device pointer to the memory to write the noisy
+   *                            depth, of the framebuffer size of @p target
+   */
+  void simulateFromRenderTargetGPU(gfx::RenderTarget& target,
+                                   float* devNoisyDepth);
+
+  /**
+   * @brief Similar to @ref simulateFromRenderTargetGPU() but the noisy depth
+   * is read back to @p view, the only copy between the GPU and the CPU.
+   *
+   * @param[in] target  Render target of the depth sensor
+   * @param[out] view   @ref Magnum::PixelFormat::R32F view of the framebuffer
+   *                    size of @p target, with top-down rows
+   */
+  void simulateFromRenderTarget(gfx::RenderTarget& target,
+                                const Magnum::MutableImageView2D& view);
+
   ~RedwoodNoiseModelGPUImpl();
 
  private:
+  // device buffers of (at least) size floats for the depth read from the
+  // render targets and the noisy depth read back to the CPU
+  void reserveDeviceBuffers(size_t size);
+
   const int gpuDeviceId_;
   const float noiseMultiplier_;
   float* devModel_ = nullptr;
   impl::CurandStates* curandStates_ = nullptr;
+  float* devDepth_ = nullptr;
+  float* devNoisyDepth_ = nullptr;
+  size_t devBufferSize_ = 0;
 
   ESP_SMART_POINTERS(RedwoodNoiseModelGPUImpl)
 };
@@ -0,0 +1,191 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RedwoodNoiseModelCPU.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <Corrade/Corrade.h>
+
+#include "esp/core/ThreadPool.h"
+
+namespace esp {
+namespace sensor {
+
+namespace {
+const int MODEL_N_DIMS = 4;
+const int MODEL_N_COLS = 100;
+
+/* Clang doesn't have target_clones yet: https://reviews.llvm.org/D51650 */
+#if defined(CORRADE_TARGET_X86) && defined(__GNUC__) && __GNUC__ >= 6
+#define FMV_SUPPORTED
+#endif
+
+// splitmix64 finalizer, a stateless hash turning counters into random bits
+inline uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Fills normals with count standard normal numbers drawn from the row key,
+// pairs of them by the Box-Muller transform
+#ifdef FMV_SUPPORTED
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+void fillNormals(const uint64_t key, float* normals, const int count) {
+  const float uniformScale = 1.0f / 16777216.0f;
+  const float twoPi = 6.28318530718f;
+  for (int k = 0; k < count / 2; ++k) {
+    const uint64_t bits = mix(key + (k + 1) * 0x9e3779b97f4a7c15ull);
+    // u1 in (0, 1] so the logarithm is finite
+    const float u1 = float((bits >> 40) + 1) * uniformScale;
+    const float u2 = float(bits & 0xffffff) * uniformScale;
+    const float r = std::sqrt(-2.0f * std::log(u1));
+    normals[2 * k] = r * std::cos(twoPi * u2);
+    normals[2 * k + 1] = r * std::sin(twoPi * u2);
+  }
+}
+
+// Read about the noise model here: http://www.alexteichman.com/octo/clams/
+// Original source code: http://redwood-data.org/indoor/data/simdepth.py
+inline float undistort(const int _x,
+                       const int _y,
+                       const float z,
+                       const float* model) {
+  const int i2 = (z + 1) / 2;
+  const int i1 = i2 - 1;
+  const float a = (z - (i1 * 2.0f + 1.0f)) / 2.0f;
+  const int x = _x / 8;
+  const int y = _y / 6;
+
+  const float f =
+      (1.0f - a) * model[(y * MODEL_N_COLS + x) * MODEL_N_DIMS +
+                         std::min(std::max(i1, 0), 4)] +
+      a * model[(y * MODEL_N_COLS + x) * MODEL_N_DIMS + std::min(i2, 4)];
+
+  return f < 1e-5f ? 0.0f : z / f;
+}
+
+// Noises row j of an H x W image, without branches so it vectorizes, with
+// the same steps as the CUDA kernel
+#ifdef FMV_SUPPORTED
+__attribute__((target_clones("default", "sse4.2", "avx2")))
+#endif
+void noiseRow(const float* depth,
+              const int H,
+              const int W,
+              const int j,
+              const float* model,
+              const float noiseMultiplier,
+              const float* normals,
+              float* noisyRow) {
+  const float ymax = H - 1;
+  const float xmax = W - 1;
+  const float shuffleSigma = 0.25f * noiseMultiplier;
+  const float quantizationSigma = 0.027778f * noiseMultiplier;
+
+  for (int i = 0; i < W; ++i) {
+    // Shuffle pixels
+    const int y = std::min(std::max(j + normals[3 * i] * shuffleSigma, 0.0f),
+                           ymax) +
+                  0.5f;
+    const int x =
+        std::min(std::max(i + normals[3 * i + 1] * shuffleSigma, 0.0f), xmax) +
+        0.5f;
+
+    // downsample
+    const float d = depth[(y - y % 2) * W + x - x % 2];
+
+    // Distortion
+    // The noise model was originally made for a 640x480 sensor,
+    // so re-map our arbitrarily sized sensor to that size! Depth beyond 10m
+    // is zeroed below, it's clamped only to keep the model lookup in range
+    const float undistorted =
+        undistort(static_cast<float>(x) / xmax * 639.0f + 0.5f,
+                  static_cast<float>(y) / ymax * 479.0f + 0.5f,
+                  std::min(d, 10.0f), model);
+
+    // quantization and high freq noise
+    const float denom = std::round(
+        (35.130f / undistorted + normals[3 * i + 2] * quantizationSigma) *
+        8.0f);
+
+    // If depth is greater than 10m, the sensor will just return a zero
+    noisyRow[i] = d < 10.0f && undistorted != 0.0f && denom > 1e-5f
+                      ? 35.130f * 8.0f / denom
+                      : 0.0f;
+  }
+}
+
+}  // namespace
+
+RedwoodNoiseModelCPUImpl::RedwoodNoiseModelCPUImpl(
+    const Eigen::Ref<const Eigen::RowMatrixXf> model,
+    const float noiseMultiplier,
+    const uint64_t seed)
+    : model_{model}, noiseMultiplier_{noiseMultiplier}, seed_{seed} {}
+
+Eigen::RowMatrixXf RedwoodNoiseModelCPUImpl::simulate(
+    const Eigen::Ref<const Eigen::RowMatrixXf> depth) {
+  Eigen::RowMatrixXf noisyDepth(depth.rows(), depth.cols());
+  if (depth.outerStride() == depth.cols()) {
+    simulate(depth.data(), 1, depth.rows(), depth.cols(), noisyDepth.data());
+  } else {
+    // e.g. a slice of a wider array
+    const Eigen::RowMatrixXf contiguous = depth;
+    simulate(contiguous.data(), 1, depth.rows(), depth.cols(),
+             noisyDepth.data());
+  }
+  return noisyDepth;
+}
+
+void RedwoodNoiseModelCPUImpl::simulate(const float* depth,
+                                        const int batch,
+                                        const int rows,
+                                        const int cols,
+                                        float* noisyDepth) {
+  const uint64_t firstFrame = frame_;
+  frame_ += batch;
+
+  // Chunks of about 64k pixels, as for the depth unprojection
+  const int pixelsPerChunk = 1 << 16;
+  const int rowsPerChunk = std::max(1, pixelsPerChunk / std::max(cols, 1));
+  const int imageChunks = (rows + rowsPerChunk - 1) / rowsPerChunk;
+  const std::size_t chunks = std::size_t(batch) * imageChunks;
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t workers = pool.numWorkers(chunks, pool.numThreads() + 1);
+  // three normal numbers per pixel of a row, rounded up to pairs
+  std::vector<std::vector<float>> normals(
+      workers, std::vector<float>((3 * cols + 1) & ~1));
+
+  auto noiseChunk = [&](const std::size_t chunk, const std::size_t worker) {
+    const int image = chunk / imageChunks;
+    const int firstRow = (chunk % imageChunks) * rowsPerChunk;
+    const int endRow = std::min(rows, firstRow + rowsPerChunk);
+    const std::size_t offset = std::size_t(image) * rows * cols;
+    const uint64_t frameKey =
+        mix(seed_ + (firstFrame + image + 1) * 0x9e3779b97f4a7c15ull);
+    std::vector<float>& rowNormals = normals[worker];
+    for (int j = firstRow; j < endRow; ++j) {
+      fillNormals(mix(frameKey ^ uint64_t(j)), rowNormals.data(),
+                  rowNormals.size());
+      noiseRow(depth + offset, rows, cols, j, model_.data(), noiseMultiplier_,
+               rowNormals.data(), noisyDepth + offset + std::size_t(j) * cols);
+    }
+  };
+
+  if (workers == 1) {
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+      noiseChunk(chunk, 0);
+    return;
+  }
+  pool.parallelFor(chunks, workers, noiseChunk);
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,87 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_REDWOODNOISEMODELCPU_H_
+#define ESP_SENSOR_REDWOODNOISEMODELCPU_H_
+
+#include <cstdint>
+#include <random>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * Provides a multithreaded CPU implementation of the Redwood Noise Model for
+ * PrimSense Depth sensors, for builds and nodes without CUDA. It follows
+ * @ref RedwoodNoiseModelGPUImpl, see there for the model and its citation.
+ *
+ * Rows are noised in chunks on the @ref core::ThreadPool::shared() pool. The
+ * random numbers are hashed from the seed, the frame and the pixel instead of
+ * drawn from a sequential generator, so the loops over the pixels vectorize
+ * and the noise doesn't depend on the number of threads.
+ */
+struct RedwoodNoiseModelCPUImpl {
+  /**
+   * @brief Constructor
+   * @param model             The distortion model from
+   *                          http://redwood-data.org/indoor/data/dist-model.txt
+   *                          The 3rd dimension is assumed to have been
+   *                          flattened into the second
+   * @param noiseMultiplier   Multiplier for the Gaussian random-variables. This
+   *                          can be used to increase or decrease the noise
+   *                          level
+   * @param seed              Seed of the noise, every frame noised after
+   *                          seeding the same way gets the same noise
+   */
+  RedwoodNoiseModelCPUImpl(const Eigen::Ref<const Eigen::RowMatrixXf> model,
+                           const float noiseMultiplier,
+                           const uint64_t seed = std::random_device{}());
+
+  /**
+   * @brief Simulates noisy depth from clean depth
+   *
+   * @param[in] depth  Clean depth, i.e. depth from habitat's depth shader
+   * @return Simulated noisy depth
+   */
+  Eigen::RowMatrixXf simulate(const Eigen::Ref<const Eigen::RowMatrixXf> depth);
+
+  /**
+   * @brief Similar to @ref simulate() on raw memory, e.g. for a stack of
+   * @p batch depth images noised in one go
+   *
+   * @param[in] depth        Clean depth, @p batch contiguous images in
+   *                         row-major order, one after another
+   * @param[in] batch        The number of images
+   * @param[in] rows         The number of rows in each image
+   * @param[in] cols         The number of columns
+   * @param[out] noisyDepth  Memory to write the noisy depth to, laid out like
+   *                         @p depth
+   */
+  void simulate(const float* depth,
+                const int batch,
+                const int rows,
+                const int cols,
+                float* noisyDepth);
+
+  /** @brief Seed the noise of the following frames */
+  void seed(const uint64_t seed) {
+    seed_ = seed;
+    frame_ = 0;
+  }
+
+ private:
+  const Eigen::RowMatrixXf model_;
+  const float noiseMultiplier_;
+  uint64_t seed_;
+  uint64_t frame_ = 0;
+
+  ESP_SMART_POINTERS(RedwoodNoiseModelCPUImpl)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_REDWOODNOISEMODELCPU_H_
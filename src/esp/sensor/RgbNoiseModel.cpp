@@ -0,0 +1,95 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <cuda_runtime.h>
+
+#include "RgbNoiseModel.h"
+
+#include "CudaDeviceContext.h"
+#include "esp/core/random.h"
+
+namespace esp {
+namespace sensor {
+
+RgbNoiseModelGPUImpl::RgbNoiseModelGPUImpl(const int gpuDeviceId,
+                                           const impl::RgbNoiseType type,
+                                           const float p0,
+                                           const float p1,
+                                           const float p2)
+    : gpuDeviceId_{gpuDeviceId},
+      type_{type},
+      p0_{p0},
+      p1_{p1},
+      p2_{p2},
+      seed_{core::Random{}.uniform_uint()} {}
+
+std::unique_ptr<RgbNoiseModelGPUImpl> RgbNoiseModelGPUImpl::gaussian(
+    const int gpuDeviceId,
+    const float intensityConstant,
+    const float mean,
+    const float sigma) {
+  return std::unique_ptr<RgbNoiseModelGPUImpl>{
+      new RgbNoiseModelGPUImpl{gpuDeviceId, impl::RgbNoiseType::Gaussian,
+                               intensityConstant, mean, sigma}};
+}
+
+std::unique_ptr<RgbNoiseModelGPUImpl> RgbNoiseModelGPUImpl::saltAndPepper(
+    const int gpuDeviceId,
+    const float sVsP,
+    const float amount) {
+  return std::unique_ptr<RgbNoiseModelGPUImpl>{
+      new RgbNoiseModelGPUImpl{gpuDeviceId, impl::RgbNoiseType::SaltAndPepper,
+                               sVsP, amount, 0.0f}};
+}
+
+std::unique_ptr<RgbNoiseModelGPUImpl> RgbNoiseModelGPUImpl::speckle(
+    const int gpuDeviceId,
+    const float intensityConstant,
+    const float mean,
+    const float sigma) {
+  return std::unique_ptr<RgbNoiseModelGPUImpl>{
+      new RgbNoiseModelGPUImpl{gpuDeviceId, impl::RgbNoiseType::Speckle,
+                               intensityConstant, mean, sigma}};
+}
+
+RgbNoiseModelGPUImpl::~RgbNoiseModelGPUImpl() {
+  CudaDeviceContext ctx{gpuDeviceId_};
+
+  if (devImage_ != nullptr)
+    cudaFree(devImage_);
+  if (devNoisyImage_ != nullptr)
+    cudaFree(devNoisyImage_);
+}
+
+void RgbNoiseModelGPUImpl::simulateFromGPU(const uint8_t* devImage,
+                                           const std::size_t size,
+                                           uint8_t* devNoisyImage) {
+  CudaDeviceContext ctx{gpuDeviceId_};
+  impl::simulateRgbFromGPU(devImage, size, type_, p0_, p1_, p2_, seed_++,
+                           devNoisyImage);
+}
+
+void RgbNoiseModelGPUImpl::simulateFromCPU(const uint8_t* image,
+                                           const std::size_t size,
+                                           uint8_t* noisyImage) {
+  CudaDeviceContext ctx{gpuDeviceId_};
+
+  if (size > devBufferSize_) {
+    if (devImage_ != nullptr)
+      cudaFree(devImage_);
+    if (devNoisyImage_ != nullptr)
+      cudaFree(devNoisyImage_);
+    cudaMalloc(&devImage_, size);
+    cudaMalloc(&devNoisyImage_, size);
+    devBufferSize_ = size;
+  }
+
+  cudaMemcpy(devImage_, image, size, cudaMemcpyHostToDevice);
+  impl::simulateRgbFromGPU(devImage_, size, type_, p0_, p1_, p2_, seed_++,
+                           devNoisyImage_);
+  cudaMemcpy(noisyImage, devNoisyImage_, size, cudaMemcpyDeviceToHost);
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,80 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RgbNoiseModel.cuh"
+
+#include <algorithm>
+
+#include <cuda_runtime.h>
+#include <curand_kernel.h>
+
+namespace {
+
+using esp::sensor::impl::RgbNoiseType;
+
+// Same noise as the numpy implementations in
+// habitat_sim/sensors/noise_models, with the pixels noised independently
+__global__ void rgbNoiseModelKernel(const uint8_t* __restrict__ image,
+                                    const std::size_t size,
+                                    const RgbNoiseType type,
+                                    const float p0,
+                                    const float p1,
+                                    const float p2,
+                                    const unsigned long long seed,
+                                    uint8_t* __restrict__ noisyImage) {
+  const std::size_t id = blockIdx.x * blockDim.x + threadIdx.x;
+  const std::size_t stride = std::size_t(gridDim.x) * blockDim.x;
+
+  // Philox states are cheap to initialize, so every thread gets its own for
+  // every launch instead of keeping them in device memory
+  curandStatePhilox4_32_10_t state;
+  curand_init(seed, id, 0, &state);
+
+  for (std::size_t i = id; i < size; i += stride) {
+    const float value = image[i] / 255.0f;
+    float noisy = value;
+    if (type == RgbNoiseType::Gaussian) {
+      noisy = value + (curand_normal(&state) * p2 + p1) * p0;
+    } else if (type == RgbNoiseType::Speckle) {
+      noisy = value + value * (curand_normal(&state) * p2 + p1) * p0;
+    } else {
+      // salt is 1, not 255, as in the numpy implementation
+      const float u = curand_uniform(&state);
+      if (u < p1 * p0) {
+        noisyImage[i] = 1;
+        continue;
+      } else if (u < p1) {
+        noisyImage[i] = 0;
+        continue;
+      }
+    }
+    noisyImage[i] = uint8_t(min(max(noisy, 0.0f), 1.0f) * 255.0f);
+  }
+}
+
+}  // namespace
+
+namespace esp {
+namespace sensor {
+namespace impl {
+
+void simulateRgbFromGPU(const uint8_t* __restrict__ devImage,
+                        const std::size_t size,
+                        const RgbNoiseType type,
+                        const float p0,
+                        const float p1,
+                        const float p2,
+                        const unsigned long long seed,
+                        uint8_t* __restrict__ devNoisyImage) {
+  const int n_threads = 256;
+  const int n_blocks = std::max<std::size_t>(
+      std::min<std::size_t>((size + n_threads - 1) / n_threads, 4096), 1);
+
+  rgbNoiseModelKernel<<<n_blocks, n_threads>>>(devImage, size, type, p0, p1,
+                                               p2, seed, devNoisyImage);
+}
+
+}  // namespace impl
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,33 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_RGBNOISEMODEL_CUH_
+#define ESP_SENSOR_RGBNOISEMODEL_CUH_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esp {
+namespace sensor {
+namespace impl {
+
+enum class RgbNoiseType { Gaussian, SaltAndPepper, Speckle };
+
+// Noises size 8-bit values independently. For Gaussian and Speckle noise p0,
+// p1 and p2 are the intensity constant, the mean and the sigma, for salt and
+// pepper noise p0 and p1 are the salt vs. pepper ratio and the amount.
+void simulateRgbFromGPU(const uint8_t* __restrict__ devImage,
+                        const std::size_t size,
+                        const RgbNoiseType type,
+                        const float p0,
+                        const float p1,
+                        const float p2,
+                        const unsigned long long seed,
+                        uint8_t* __restrict__ devNoisyImage);
+
+}  // namespace impl
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_RGBNOISEMODEL_CUH_
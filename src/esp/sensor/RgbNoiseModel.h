@@ -0,0 +1,111 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_RGBNOISEMODEL_H_
+#define ESP_SENSOR_RGBNOISEMODEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp/core/esp.h"
+
+#include "RgbNoiseModel.cuh"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * Provides CUDA/GPU implementations of the Gaussian, salt and pepper and
+ * speckle noise models for color sensors, matching the numpy ones in
+ * habitat_sim/sensors/noise_models. Every 8-bit value is noised
+ * independently, so one call can noise a whole stack of images, e.g. one per
+ * environment.
+ */
+struct RgbNoiseModelGPUImpl {
+  /**
+   * @brief Gaussian noise, adds (N(@p mean, @p sigma) * @p intensityConstant)
+   * to the colors in [0, 1]
+   * @param gpuDeviceId         The CUDA device ID to use
+   * @param intensityConstant   Scale of the noise
+   * @param mean                Mean of the noise
+   * @param sigma               Standard deviation of the noise
+   */
+  static std::unique_ptr<RgbNoiseModelGPUImpl> gaussian(
+      const int gpuDeviceId,
+      const float intensityConstant,
+      const float mean,
+      const float sigma);
+
+  /**
+   * @brief Salt and pepper noise, sets @p amount of the values to 1 or 0
+   * @param gpuDeviceId   The CUDA device ID to use
+   * @param sVsP          Ratio of the salt to the salt and pepper
+   * @param amount        Ratio of the values set
+   */
+  static std::unique_ptr<RgbNoiseModelGPUImpl>
+  saltAndPepper(const int gpuDeviceId, const float sVsP, const float amount);
+
+  /**
+   * @brief Speckle noise, multiplicative version of @ref gaussian()
+   */
+  static std::unique_ptr<RgbNoiseModelGPUImpl> speckle(
+      const int gpuDeviceId,
+      const float intensityConstant,
+      const float mean,
+      const float sigma);
+
+  /**
+   * @brief Simulates a noisy image from a clean one. The input and output are
+   * assumed to be on the GPU.  If they aren't, bad things happen, segfaults
+   * happen.
+   *
+   * @param[in] devImage        Device pointer to the clean image(s)
+   * @param[in] size            The number of 8-bit values in @p devImage
+   * @param[out] devNoisyImage  Device pointer to the memory to write the noisy
+   *                            image(s)
+   */
+  void simulateFromGPU(const uint8_t* devImage,
+                       const std::size_t size,
+                       uint8_t* devNoisyImage);
+
+  /**
+   * @brief Similar to @ref simulateFromGPU() but the input and output are
+   * on the CPU.
+   */
+  void simulateFromCPU(const uint8_t* image,
+                       const std::size_t size,
+                       uint8_t* noisyImage);
+
+  /**
+   * @brief Seed the noise of the following images, random by default
+   *
+   * Every image noised after seeding the same way gets the same noise.
+   */
+  void seed(const unsigned long long seed) { seed_ = seed; }
+
+  ~RgbNoiseModelGPUImpl();
+
+ private:
+  RgbNoiseModelGPUImpl(const int gpuDeviceId,
+                       const impl::RgbNoiseType type,
+                       const float p0,
+                       const float p1,
+                       const float p2);
+
+  const int gpuDeviceId_;
+  const impl::RgbNoiseType type_;
+  const float p0_, p1_, p2_;
+  // a new seed for every launch, the kernels keep no state
+  unsigned long long seed_;
+  uint8_t* devImage_ = nullptr;
+  uint8_t* devNoisyImage_ = nullptr;
+  std::size_t devBufferSize_ = 0;
+
+  ESP_SMART_POINTERS(RgbNoiseModelGPUImpl)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_RGBNOISEMODEL_H_
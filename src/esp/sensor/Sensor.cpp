@@ -6,8 +6,13 @@
 
 #include <Magnum/EigenIntegration/Integration.h>
 
+#include <algorithm>
 #include <utility>
 
+#ifdef ESP_BUILD_WITH_CUDA
+#include "DeviceBuffer.h"
+#endif
+
 namespace esp {
 namespace sensor {
 
@@ -36,6 +41,83 @@ void Sensor::setTransformationFromSpec() {
   node().rotateZ(Magnum::Rad(spec_->orientation[2]));
 }
 
+core::Buffer::ptr Sensor::nextObservationBuffer() {
+  ObservationSpace space;
+  getObservationSpace(space);
+  const size_t numBuffers =
+      static_cast<size_t>(std::max(1, spec_->numObservationBuffers));
+
+  if (bufferRing_.size() != numBuffers || bufferRing_[0]->shape != space.shape ||
+      bufferRing_[0]->dataType != space.dataType) {
+    bufferRing_.clear();
+    bufferRing_.reserve(numBuffers);
+    for (size_t i = 0; i < numBuffers; ++i) {
+      bufferRing_.emplace_back(
+          core::Buffer::create(space.shape, space.dataType));
+    }
+    bufferRingIndex_ = 0;
+  }
+
+  buffer_ = bufferRing_[bufferRingIndex_];
+  bufferRingIndex_ = (bufferRingIndex_ + 1) % numBuffers;
+  return buffer_;
+}
+
+#ifdef ESP_BUILD_WITH_CUDA
+std::shared_ptr<DeviceBuffer> Sensor::nextObservationDeviceBuffer(
+    const int deviceId) {
+  ObservationSpace space;
+  getObservationSpace(space);
+  // DLPack consumers like PyTorch lack the wider unsigned types, object ids
+  // fit their signed counterpart
+  if (space.dataType == core::DataType::DT_UINT32) {
+    space.dataType = core::DataType::DT_INT32;
+  }
+  const size_t numBuffers =
+      static_cast<size_t>(std::max(1, spec_->numObservationBuffers));
+
+  if (deviceBufferRing_.size() != numBuffers ||
+      deviceBufferRing_[0]->shape() != space.shape ||
+      deviceBufferRing_[0]->dataType() != space.dataType ||
+      deviceBufferRing_[0]->deviceId() != deviceId) {
+    deviceBufferRing_.clear();
+    deviceBufferRing_.reserve(numBuffers);
+    for (size_t i = 0; i < numBuffers; ++i) {
+      deviceBufferRing_.emplace_back(
+          DeviceBuffer::create(space.shape, space.dataType, deviceId));
+    }
+    deviceBufferRingIndex_ = 0;
+  }
+
+  std::shared_ptr<DeviceBuffer> buffer =
+      deviceBufferRing_[deviceBufferRingIndex_];
+  deviceBufferRingIndex_ = (deviceBufferRingIndex_ + 1) % numBuffers;
+  return buffer;
+}
+#endif
+
+bool Sensor::scheduleObservation(const double time) {
+  if (observationAge_ < 0 ||
+      observationAge_ + 1 >= std::max(1, spec_->renderInterval)) {
+    observationAge_ = 0;
+    observationTimestamp_ = time;
+    return true;
+  }
+  ++observationAge_;
+  return false;
+}
+
+void Sensor::recordObservation(const Observation& obs) {
+  lastObservation_ = obs;
+}
+
+Observation Sensor::lastObservation() const {
+  Observation obs = lastObservation_;
+  obs.timestamp = observationTimestamp_;
+  obs.age = std::max(0, observationAge_);
+  return obs;
+}
+
 void SensorSuite::add(const Sensor::ptr& sensor) {
   const std::string uuid = sensor->specification()->uuid;
   sensors_[uuid] = sensor;
@@ -55,7 +137,12 @@ bool operator==(const SensorSpec& a, const SensorSpec& b) {
          a.position == b.position && a.orientation == b.orientation &&
          a.resolution == b.resolution && a.channels == b.channels &&
          a.encoding == b.encoding && a.observationSpace == b.observationSpace &&
-         a.noiseModel == b.noiseModel && a.gpu2gpuTransfer == b.gpu2gpuTransfer;
+         a.noiseModel == b.noiseModel && a.gpu2gpuTransfer == b.gpu2gpuTransfer &&
+         a.asyncReadback == b.asyncReadback &&
+         a.numObservationBuffers == b.numObservationBuffers &&
+         a.msaaSamples == b.msaaSamples &&
+         a.renderInterval == b.renderInterval &&
+         a.staleObservationPolicy == b.staleObservationPolicy;
 }
 bool operator!=(const SensorSpec& a, const SensorSpec& b) {
   return !(a == b);
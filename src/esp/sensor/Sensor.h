@@ -7,6 +7,7 @@
 
 #include "esp/core/esp.h"
 
+#include "esp/core/AsyncLog.h"
 #include "esp/core/Buffer.h"
 #include "esp/scene/SceneNode.h"
 
@@ -17,6 +18,8 @@ class Simulator;
 
 namespace sensor {
 
+class DeviceBuffer;
+
 // Enumeration of types of sensors
 enum class SensorType {
   None = 0,
@@ -29,6 +32,10 @@ enum class SensorType {
   Force = 7,
   Tensor = 8,
   Text = 9,
+  // point cloud of a LidarSensor
+  Lidar = 10,
+  // point cloud unprojected from the depth of a CameraSensor
+  PointCloud = 11,
 };
 
 enum class ObservationSpaceType {
@@ -40,6 +47,20 @@ enum class ObservationSpaceType {
 enum class SensorSubType {
   Pinhole = 0,
   Orthographic = 1,
+  // 360 x 180 degrees, drawn through a cube map by a CubeMapSensor
+  Equirectangular = 2,
+  // equidistant fisheye with the "hfov" field of view across the image
+  // circle, drawn through a cube map by a CubeMapSensor
+  Fisheye = 3,
+};
+
+// What the observations of a sensor whose turn to be drawn it isn't are, see
+// SensorSpec::renderInterval
+enum class StaleObservationPolicy {
+  // the last drawn observation again, with its timestamp
+  Repeat = 0,
+  // no observation, the sensor is left out of the observations
+  Omit = 1,
 };
 
 // Specifies the configuration parameters of a sensor
@@ -55,11 +76,31 @@ struct SensorSpec {
   vec3f orientation = {0, 0, 0};
   vec2i resolution = {84, 84};
   int channels = 4;
+  // pixel format of the observations: "rgb_uint8" drops the alpha channel of
+  // color sensors, "depth_float16" and "depth_uint16_mm" read depth as half
+  // floats or millimeters, see CameraSensor::observationPixelFormat()
   std::string encoding = "rgba_uint8";
   // description of Sensor observation space as gym.spaces.Dict()
   std::string observationSpace = "";
   std::string noiseModel = "None";
+  // read observations straight into CUDA memory, Observation::deviceBuffer,
+  // instead of to the host; requires a build with CUDA
   bool gpu2gpuTransfer = false;
+  // read observations back through a pixel buffer object: the transfer is
+  // started by drawObservation() and only waited upon by readObservation()
+  bool asyncReadback = false;
+  // number of observation buffers the sensor rotates through; an Observation
+  // stays valid for numObservationBuffers - 1 further reads
+  int numObservationBuffers = 1;
+  // samples per pixel of multisample anti-aliasing, resolved on the GPU
+  // before readback; 1 disables it
+  int msaaSamples = 1;
+  // the sensor is only drawn every renderInterval-th time its observation is
+  // requested, starting with the first; the requests in between get a stale
+  // observation following staleObservationPolicy
+  int renderInterval = 1;
+  StaleObservationPolicy staleObservationPolicy =
+      StaleObservationPolicy::Repeat;
   ESP_SMART_POINTERS(SensorSpec)
 };
 
@@ -70,6 +111,15 @@ bool operator!=(const SensorSpec& a, const SensorSpec& b);
 struct Observation {
   // TODO: populate this struct with raw data
   core::Buffer::ptr buffer{nullptr};
+  // the observation in CUDA memory for sensors with gpu2gpuTransfer, in which
+  // case buffer is null; it's rotated through like the host buffers
+  std::shared_ptr<DeviceBuffer> deviceBuffer{nullptr};
+  // world time of the simulator when the observation was drawn, see
+  // Simulator::getWorldTime()
+  double timestamp = 0.0;
+  // number of requests since the observation was drawn, 0 for a fresh one
+  // and above for the stale ones of sensors with a renderInterval above 1
+  int age = 0;
   ESP_SMART_POINTERS(Observation)
 };
 
@@ -84,7 +134,7 @@ struct ObservationSpace {
 class Sensor : public Magnum::SceneGraph::AbstractFeature3D {
  public:
   explicit Sensor(scene::SceneNode& node, SensorSpec::ptr spec);
-  virtual ~Sensor() { LOG(INFO) << "Deconstructing Sensor"; }
+  virtual ~Sensor() { ESP_HOT_LOG(INFO) << "Deconstructing Sensor"; }
 
   // Get the scene node being attached to.
   scene::SceneNode& node() { return object(); }
@@ -118,9 +168,68 @@ class Sensor : public Magnum::SceneGraph::AbstractFeature3D {
    */
   virtual bool displayObservation(sim::Simulator& sim) = 0;
 
+  /**
+   * @brief Count a request for an observation and return whether the sensor
+   * is due to be drawn for it
+   *
+   * Every @ref SensorSpec::renderInterval -th request is due, starting with
+   * the first. For the others the last drawn observation is stale and
+   * @ref SensorSpec::staleObservationPolicy applies.
+   * @param time The world time a due observation is timestamped with
+   */
+  bool scheduleObservation(double time);
+
+  /**
+   * @brief Requests since the sensor was last due, 0 if it was due for the
+   * last one, -1 if it never was
+   */
+  int observationAge() const { return observationAge_; }
+
+  /** @brief World time the sensor was last due at */
+  double observationTimestamp() const { return observationTimestamp_; }
+
+  /** @brief Keep @p obs as the observation to repeat while it's stale */
+  void recordObservation(const Observation& obs);
+
+  /**
+   * @brief The last recorded observation, with its timestamp and current
+   * age, to return for a stale request; without any buffer if none was
+   * recorded
+   */
+  Observation lastObservation() const;
+
  protected:
+  /**
+   * @brief Advance to the next buffer of the observation ring and return it.
+   *
+   * The ring holds @ref SensorSpec::numObservationBuffers buffers and is
+   * (re)allocated whenever that count or the observation space changes, so a
+   * buffer handed out in an @ref Observation is not overwritten until that
+   * many further observations have been read.
+   */
+  core::Buffer::ptr nextObservationBuffer();
+
+#ifdef ESP_BUILD_WITH_CUDA
+  /**
+   * @brief Same as @ref nextObservationBuffer() for observations read into
+   * CUDA memory on device @p deviceId
+   *
+   * The 32-bit unsigned observations are signed on the device, as that's the
+   * type frameworks consuming them support.
+   */
+  std::shared_ptr<DeviceBuffer> nextObservationDeviceBuffer(int deviceId);
+#endif
+
   SensorSpec::ptr spec_ = nullptr;
+  // the most recently handed out buffer of bufferRing_
   core::Buffer::ptr buffer_ = nullptr;
+  std::vector<core::Buffer::ptr> bufferRing_;
+  size_t bufferRingIndex_ = 0;
+  std::vector<std::shared_ptr<DeviceBuffer>> deviceBufferRing_;
+  size_t deviceBufferRingIndex_ = 0;
+  int observationAge_ = -1;
+  double observationTimestamp_ = 0.0;
+  Observation lastObservation_;
 
   ESP_SMART_POINTERS(Sensor)
 };
@@ -132,7 +241,7 @@ class SensorSuite {
  public:
   void add(const Sensor::ptr& sensor);
   void clear();
-  ~SensorSuite() { LOG(INFO) << "Deconstructing SensorSuite"; }
+  ~SensorSuite() { ESP_HOT_LOG(INFO) << "Deconstructing SensorSuite"; }
 
   Sensor::ptr get(const std::string& uuid) const;
   std::map<std::string, Sensor::ptr>& getSensors() { return sensors_; }
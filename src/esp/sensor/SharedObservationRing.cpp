@@ -0,0 +1,333 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "SharedObservationRing.h"
+
+#include <Corrade/Utility/Assert.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <set>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace sensor {
+
+namespace {
+const char RING_MAGIC[8] = "espobsr";
+const std::uint32_t RING_VERSION = 1;
+// the fields and slots start on cache lines, the views are aligned for any
+// element type
+const std::size_t ALIGNMENT = 64;
+const std::size_t MAX_NAME_SIZE = 64;
+const std::size_t MAX_DIMENSIONS = 4;
+
+std::size_t alignUp(const std::size_t size) {
+  return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+struct FieldHeader {
+  char name[MAX_NAME_SIZE];
+  std::int32_t dataType;
+  std::uint32_t numDimensions;
+  std::uint64_t shape[MAX_DIMENSIONS];
+  // from the start of the slot
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+std::runtime_error error(const std::string& name, const std::string& what) {
+  return std::runtime_error{"SharedObservationRing: " + name + " " + what};
+}
+
+std::string lastError() {
+  return std::strerror(errno);
+}
+}  // namespace
+
+// at the start of the segment, followed by the field headers
+struct SharedObservationRing::Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t numFields;
+  std::uint64_t numSlots;
+  std::uint64_t slotStride;
+  // the offset of the first slot from the start of the segment
+  std::uint64_t firstSlot;
+  std::atomic<std::uint64_t> latestSequence;
+};
+
+// at the start of each slot, followed by the fields
+struct SharedObservationRing::SlotHeader {
+  // 0 while the slot is written
+  std::atomic<std::uint64_t> sequence;
+  double timestamp;
+};
+
+static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t),
+              "the counters must have the layout of their value to be shared "
+              "between processes");
+
+SharedObservationRing::SharedObservationRing(const std::string& name,
+                                             const std::vector<Field>& fields,
+                                             const std::size_t numSlots)
+    : name_{name}, writer_{true}, fields_{fields} {
+  if (numSlots == 0 || fields_.empty()) {
+    throw error(name_, "needs a slot and a field");
+  }
+  std::set<std::string> names;
+  std::size_t slotSize = alignUp(sizeof(SlotHeader));
+  for (const Field& field : fields_) {
+    if (field.name.empty() || field.name.size() >= MAX_NAME_SIZE ||
+        !names.insert(field.name).second) {
+      throw error(name_, "expected unique field names of 1 to " +
+                             std::to_string(MAX_NAME_SIZE - 1) +
+                             " bytes, got " + field.name);
+    }
+    if (field.dataType == core::DataType::DT_NONE || field.shape.empty() ||
+        field.shape.size() > MAX_DIMENSIONS) {
+      throw error(name_, "expected a data type and 1 to " +
+                             std::to_string(MAX_DIMENSIONS) +
+                             " dimensions for field " + field.name);
+    }
+    std::size_t size = core::getDataTypeByteSize(field.dataType);
+    for (const std::size_t extent : field.shape) {
+      size *= extent;
+    }
+    fieldOffsets_.push_back(slotSize);
+    fieldSizes_.push_back(size);
+    slotSize += alignUp(size);
+  }
+  const std::size_t firstSlot =
+      alignUp(sizeof(Header) + fields_.size() * sizeof(FieldHeader));
+  size_ = firstSlot + numSlots * slotSize;
+
+  const int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1) {
+    throw error(name_, "can't be created: " + lastError());
+  }
+  void* memory = MAP_FAILED;
+  if (::ftruncate(fd, size_) == 0) {
+    memory =
+        ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  const std::string mapError = lastError();
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    ::shm_unlink(name_.c_str());
+    throw error(name_, "can't be mapped: " + mapError);
+  }
+  memory_ = static_cast<char*>(memory);
+
+  // the segment is zero-filled, so the slots start unpublished
+  Header& ringHeader = *new (memory_) Header{};
+  std::memcpy(ringHeader.magic, RING_MAGIC, sizeof(RING_MAGIC));
+  ringHeader.version = RING_VERSION;
+  ringHeader.numFields = fields_.size();
+  ringHeader.numSlots = numSlots;
+  ringHeader.slotStride = slotSize;
+  ringHeader.firstSlot = firstSlot;
+  auto* fieldHeaders = reinterpret_cast<FieldHeader*>(memory_ + sizeof(Header));
+  for (std::size_t i = 0; i < fields_.size(); ++i) {
+    FieldHeader& fieldHeader = fieldHeaders[i];
+    std::strncpy(fieldHeader.name, fields_[i].name.c_str(), MAX_NAME_SIZE);
+    fieldHeader.dataType = std::int32_t(fields_[i].dataType);
+    fieldHeader.numDimensions = fields_[i].shape.size();
+    std::copy(fields_[i].shape.begin(), fields_[i].shape.end(),
+              fieldHeader.shape);
+    fieldHeader.offset = fieldOffsets_[i];
+    fieldHeader.size = fieldSizes_[i];
+  }
+  for (std::size_t slot = 0; slot < numSlots; ++slot) {
+    new (&slotHeader(slot)) SlotHeader{};
+  }
+}
+
+SharedObservationRing::SharedObservationRing(const std::string& name)
+    : name_{name} {
+  const int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+  if (fd == -1) {
+    throw error(name_, "can't be opened: " + lastError());
+  }
+  struct stat status;
+  void* memory = MAP_FAILED;
+  if (::fstat(fd, &status) == 0 &&
+      std::size_t(status.st_size) >= sizeof(Header)) {
+    size_ = status.st_size;
+    memory = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    throw error(name_, "can't be mapped");
+  }
+  memory_ = static_cast<char*>(memory);
+
+  // validated against the size of the segment, it may come from any process
+  const Header& ringHeader = header();
+  const std::size_t fieldsEnd =
+      sizeof(Header) + std::size_t(ringHeader.numFields) * sizeof(FieldHeader);
+  if (std::memcmp(ringHeader.magic, RING_MAGIC, sizeof(RING_MAGIC)) != 0 ||
+      ringHeader.version != RING_VERSION || ringHeader.numSlots == 0 ||
+      ringHeader.numFields == 0 || fieldsEnd > size_ ||
+      ringHeader.firstSlot < fieldsEnd || ringHeader.firstSlot > size_ ||
+      ringHeader.firstSlot % ALIGNMENT != 0 ||
+      ringHeader.slotStride % ALIGNMENT != 0 ||
+      ringHeader.slotStride < sizeof(SlotHeader) ||
+      (size_ - ringHeader.firstSlot) / ringHeader.slotStride <
+          ringHeader.numSlots) {
+    ::munmap(memory_, size_);
+    memory_ = nullptr;
+    throw error(name_, "isn't an observation ring of version " +
+                           std::to_string(RING_VERSION));
+  }
+  const auto* fieldHeaders =
+      reinterpret_cast<const FieldHeader*>(memory_ + sizeof(Header));
+  for (std::size_t i = 0; i < ringHeader.numFields; ++i) {
+    const FieldHeader& fieldHeader = fieldHeaders[i];
+    bool valid =
+        fieldHeader.dataType > std::int32_t(core::DataType::DT_NONE) &&
+        fieldHeader.dataType <= std::int32_t(core::DataType::DT_FLOAT16) &&
+        fieldHeader.numDimensions > 0 &&
+        fieldHeader.numDimensions <= MAX_DIMENSIONS &&
+        fieldHeader.offset >= sizeof(SlotHeader) &&
+        fieldHeader.offset % ALIGNMENT == 0 &&
+        fieldHeader.offset <= ringHeader.slotStride &&
+        fieldHeader.size <= ringHeader.slotStride - fieldHeader.offset;
+    // the shape has to cover exactly the size, the arrays are views of it
+    std::uint64_t size =
+        valid ? core::getDataTypeByteSize(core::DataType(fieldHeader.dataType))
+              : 0;
+    for (std::uint32_t d = 0; valid && d < fieldHeader.numDimensions; ++d) {
+      const std::uint64_t extent = fieldHeader.shape[d];
+      valid = extent == 0 || size <= fieldHeader.size / extent;
+      size *= extent;
+    }
+    if (!valid || size != fieldHeader.size) {
+      ::munmap(memory_, size_);
+      memory_ = nullptr;
+      throw error(name_, "has an invalid field");
+    }
+    Field field;
+    field.name.assign(fieldHeader.name,
+                      strnlen(fieldHeader.name, MAX_NAME_SIZE - 1));
+    field.dataType = core::DataType(fieldHeader.dataType);
+    field.shape.assign(fieldHeader.shape,
+                       fieldHeader.shape + fieldHeader.numDimensions);
+    fields_.push_back(std::move(field));
+    fieldOffsets_.push_back(fieldHeader.offset);
+    fieldSizes_.push_back(fieldHeader.size);
+  }
+}
+
+SharedObservationRing::~SharedObservationRing() {
+  if (memory_ != nullptr) {
+    ::munmap(memory_, size_);
+  }
+  if (writer_) {
+    ::shm_unlink(name_.c_str());
+  }
+}
+
+SharedObservationRing::Header& SharedObservationRing::header() const {
+  return *reinterpret_cast<Header*>(memory_);
+}
+
+SharedObservationRing::SlotHeader& SharedObservationRing::slotHeader(
+    const std::size_t slot) const {
+  const Header& ringHeader = header();
+  return *reinterpret_cast<SlotHeader*>(memory_ + ringHeader.firstSlot +
+                                        slot * ringHeader.slotStride);
+}
+
+std::size_t SharedObservationRing::numSlots() const {
+  return header().numSlots;
+}
+
+int SharedObservationRing::fieldIndex(const std::string& name) const {
+  for (std::size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].name == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+Cr::Containers::ArrayView<void> SharedObservationRing::data(
+    const std::size_t slot,
+    const std::size_t field) const {
+  CORRADE_ASSERT(slot < numSlots() && field < fields_.size(),
+                 "sensor::SharedObservationRing::data(): slot"
+                     << slot << "or field" << field << "out of range",
+                 {});
+  char* slotData = reinterpret_cast<char*>(&slotHeader(slot));
+  return {slotData + fieldOffsets_[field], fieldSizes_[field]};
+}
+
+std::size_t SharedObservationRing::beginWrite() {
+  CORRADE_ASSERT(writer_,
+                 "sensor::SharedObservationRing::beginWrite(): the ring"
+                     << name_.c_str() << "was opened read-only",
+                 {});
+  writeSlot_ = header().latestSequence.load(std::memory_order_relaxed) %
+               numSlots();
+  // readers checking the sequence after reading see the slot as changed
+  // before any field is
+  slotHeader(writeSlot_).sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return writeSlot_;
+}
+
+std::uint64_t SharedObservationRing::endWrite(const double timestamp) {
+  CORRADE_ASSERT(writer_,
+                 "sensor::SharedObservationRing::endWrite(): the ring"
+                     << name_.c_str() << "was opened read-only",
+                 {});
+  Header& ringHeader = header();
+  const std::uint64_t sequence =
+      ringHeader.latestSequence.load(std::memory_order_relaxed) + 1;
+  SlotHeader& slot = slotHeader(writeSlot_);
+  slot.timestamp = timestamp;
+  slot.sequence.store(sequence, std::memory_order_release);
+  ringHeader.latestSequence.store(sequence, std::memory_order_release);
+  return sequence;
+}
+
+std::uint64_t SharedObservationRing::latestSequence() const {
+  return header().latestSequence.load(std::memory_order_acquire);
+}
+
+std::size_t SharedObservationRing::slotOf(const std::uint64_t sequence) const {
+  CORRADE_ASSERT(sequence > 0,
+                 "sensor::SharedObservationRing::slotOf(): sequence numbers "
+                 "start at 1",
+                 {});
+  return (sequence - 1) % numSlots();
+}
+
+std::uint64_t SharedObservationRing::sequenceOf(const std::size_t slot) const {
+  CORRADE_ASSERT(slot < numSlots(),
+                 "sensor::SharedObservationRing::sequenceOf(): slot"
+                     << slot << "out of range",
+                 {});
+  return slotHeader(slot).sequence.load(std::memory_order_acquire);
+}
+
+double SharedObservationRing::timestampOf(const std::size_t slot) const {
+  CORRADE_ASSERT(slot < numSlots(),
+                 "sensor::SharedObservationRing::timestampOf(): slot"
+                     << slot << "out of range",
+                 {});
+  return slotHeader(slot).timestamp;
+}
+
+}  // namespace sensor
+}  // namespace esp
@@ -0,0 +1,154 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_SHAREDOBSERVATIONRING_H_
+#define ESP_SENSOR_SHAREDOBSERVATIONRING_H_
+
+/** @file
+ * @brief Class @ref esp::sensor::SharedObservationRing
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp/core/Buffer.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+/**
+ * @brief A ring of observation slots in POSIX shared memory, so that a
+ * simulator in a subprocess hands its observations to another process
+ * without pickling or copying them
+ *
+ * The process of the simulator creates the ring, naming the fields of a
+ * slot, e.g. one per sensor with the shape and type of its
+ * @ref ObservationSpace. The sensor reads go straight into the field of the
+ * slot returned by @ref beginWrite(), e.g. through
+ * @ref sim::Simulator::drawAndReadObservations(), and @ref endWrite()
+ * publishes the slot. Another process opens the ring by name, wraps the
+ * fields as arrays, and gets the slot of a publication with
+ * @ref slotOf(). A slot is written again @ref numSlots() publications
+ * later: readers keep up, e.g. by stepping in lockstep with the simulator,
+ * or check @ref sequenceOf() the slot after reading it.
+ *
+ * The segment is removed when the ring that created it is destroyed; the
+ * mappings of the other processes stay valid until they're destroyed too.
+ */
+class SharedObservationRing {
+ public:
+  //! A field of the slots, e.g. the observation of a sensor
+  struct Field {
+    //! The name of the field, e.g. the uuid of the sensor, up to 63 bytes
+    std::string name;
+    //! The type of the elements
+    core::DataType dataType = core::DataType::DT_UINT8;
+    //! The shape of the field, row-major, up to 4 dimensions
+    std::vector<std::size_t> shape;
+  };
+
+  /**
+   * @brief Create the shared memory segment @p name
+   *
+   * @param name     The name of the segment, e.g. `/habitat-env-3`
+   * @param fields   The fields of each slot
+   * @param numSlots The number of slots
+   * @throws std::runtime_error if the segment exists already or can't be
+   * created, or a field is invalid
+   */
+  SharedObservationRing(const std::string& name,
+                        const std::vector<Field>& fields,
+                        std::size_t numSlots);
+
+  /**
+   * @brief Open the segment @p name created by another ring, read-only
+   *
+   * @throws std::runtime_error if there is no such segment or it isn't a
+   * ring
+   */
+  explicit SharedObservationRing(const std::string& name);
+
+  ~SharedObservationRing();
+
+  SharedObservationRing(const SharedObservationRing&) = delete;
+  SharedObservationRing& operator=(const SharedObservationRing&) = delete;
+
+  /** @brief The name of the segment */
+  const std::string& name() const { return name_; }
+
+  /** @brief Whether this ring created the segment and writes it */
+  bool isWriter() const { return writer_; }
+
+  /** @brief The number of slots */
+  std::size_t numSlots() const;
+
+  /** @brief The fields of each slot */
+  const std::vector<Field>& fields() const { return fields_; }
+
+  /** @brief The index of the field @p name, -1 if there's none */
+  int fieldIndex(const std::string& name) const;
+
+  /**
+   * @brief The memory of a field of a slot, 64-byte aligned, tightly packed
+   * rows, e.g. to read an observation into
+   */
+  Corrade::Containers::ArrayView<void> data(std::size_t slot,
+                                            std::size_t field) const;
+
+  /**
+   * @brief Start writing the next slot, marking it unpublished
+   * @return The slot to write the fields of
+   */
+  std::size_t beginWrite();
+
+  /**
+   * @brief Publish the slot of the last @ref beginWrite()
+   *
+   * @param timestamp The world time of the observations, for the readers
+   * @return The sequence number of the publication, from 1
+   */
+  std::uint64_t endWrite(double timestamp);
+
+  /** @brief The sequence number of the last publication, 0 without one */
+  std::uint64_t latestSequence() const;
+
+  /** @brief The slot of publication @p sequence */
+  std::size_t slotOf(std::uint64_t sequence) const;
+
+  /**
+   * @brief The publication a slot holds, 0 if it's being written or was
+   * never published
+   */
+  std::uint64_t sequenceOf(std::size_t slot) const;
+
+  /** @brief The timestamp of the publication a slot holds */
+  double timestampOf(std::size_t slot) const;
+
+  ESP_SMART_POINTERS(SharedObservationRing)
+
+ private:
+  struct Header;
+  struct SlotHeader;
+
+  Header& header() const;
+  SlotHeader& slotHeader(std::size_t slot) const;
+
+  std::string name_;
+  bool writer_ = false;
+  char* memory_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<Field> fields_;
+  std::vector<std::size_t> fieldOffsets_;
+  std::vector<std::size_t> fieldSizes_;
+  std::size_t writeSlot_ = 0;
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_SHAREDOBSERVATIONRING_H_
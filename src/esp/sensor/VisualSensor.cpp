@@ -22,5 +22,9 @@ void VisualSensor::bindRenderTarget(gfx::RenderTarget::uptr&& tgt) {
   tgt_ = std::move(tgt);
 }
 
+gfx::RenderTarget::uptr VisualSensor::releaseRenderTarget() {
+  return std::move(tgt_);
+}
+
 }  // namespace sensor
 }  // namespace esp
@@ -9,6 +9,7 @@
 
 #include "esp/core/esp.h"
 
+#include "esp/gfx/Foveation.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/sensor/Sensor.h"
 
@@ -16,6 +17,9 @@ namespace esp {
 namespace gfx {
 class RenderTarget;
 }
+namespace scene {
+class SceneGraph;
+}
 
 namespace sensor {
 
@@ -78,6 +82,15 @@ class VisualSensor : public Sensor {
     return Corrade::Containers::NullOpt;
   };
 
+  /**
+   * @brief How the sensor is split into a full resolution inset and a low
+   * resolution periphery by @ref gfx::Renderer::draw(), or
+   * @ref Corrade::Containers::NullOpt if it's drawn at its full resolution
+   */
+  virtual Corrade::Containers::Optional<gfx::Foveation> foveation() const {
+    return Corrade::Containers::NullOpt;
+  }
+
   /**
    * @brief Checks to see if this sensor has a RenderTarget bound or not
    */
@@ -89,6 +102,12 @@ class VisualSensor : public Sensor {
    */
   void bindRenderTarget(std::unique_ptr<gfx::RenderTarget>&& tgt);
 
+  /**
+   * @brief Unbind the RenderTarget of the sensor and hand over its
+   * ownership, nullptr if there is none
+   */
+  std::unique_ptr<gfx::RenderTarget> releaseRenderTarget();
+
   /**
    * @brief Returns a reference to the sensors render target
    */
@@ -108,8 +127,31 @@ class VisualSensor : public Sensor {
     return false;
   }
 
+  /**
+   * @brief Draw @p sceneGraph into @p target through a cube map, for sensors
+   * whose projection a single perspective camera cannot express
+   * @param[in] sceneGraph The scene graph to draw
+   * @param[in] flags The render flags
+   * @param[in] target The render target to draw into, it is bound again after
+   *                   the cube map was rendered
+   * @return false if the sensor is drawn directly by a render camera, in
+   * which case nothing was drawn
+   *
+   * Called by @ref gfx::Renderer::draw() before anything else is drawn.
+   */
+  virtual bool drawThroughCubeMap(
+      CORRADE_UNUSED scene::SceneGraph& sceneGraph,
+      CORRADE_UNUSED gfx::RenderCamera::Flags flags,
+      CORRADE_UNUSED gfx::RenderTarget& target) {
+    return false;
+  }
+
+  /** @brief Identity of the sensor for the state the renderer keeps per view */
+  const gfx::ViewKey& viewKey() const { return viewKey_; }
+
  protected:
   std::unique_ptr<gfx::RenderTarget> tgt_;
+  gfx::ViewKey viewKey_;
 
   ESP_SMART_POINTERS(VisualSensor)
 };
@@ -0,0 +1,185 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RenderClient.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "esp/core/Profiling.h"
+#include "esp/gfx/replay/KeyframeStream.h"
+#include "esp/gfx/replay/Recorder.h"
+
+namespace esp {
+namespace sim {
+
+struct RenderClient::Impl {
+  explicit Impl(const float translationQuantum)
+      : encoder{translationQuantum} {}
+
+  int fd = -1;
+  gfx::replay::KeyframeEncoder encoder;
+  std::string received;
+  uint32_t nextRequestId = 0;
+  std::weak_ptr<gfx::replay::Recorder> recorder;
+
+  void disconnect() {
+    if (fd >= 0)
+      ::close(fd);
+    fd = -1;
+  }
+
+  void send(const RenderMessage type, const std::string& payload) {
+    if (fd < 0)
+      return;
+    std::string message;
+    appendRenderMessage(message, type, payload);
+    std::size_t offset = 0;
+    while (offset < message.size()) {
+      const ssize_t size = ::send(fd, message.data() + offset,
+                                  message.size() - offset, MSG_NOSIGNAL);
+      if (size < 0 && errno == EINTR)
+        continue;
+      if (size <= 0) {
+        LOG(ERROR) << "RenderClient: lost the connection to the server";
+        disconnect();
+        return;
+      }
+      offset += size;
+    }
+  }
+
+  // Blocks until a whole message arrived, false if the connection was lost
+  bool receive(RenderMessage& type, std::string& payload) {
+    char buffer[65536];
+    while (fd >= 0) {
+      if (const std::size_t size = readRenderMessage(
+              received.data(), received.size(), type, payload)) {
+        received.erase(0, size);
+        return true;
+      }
+      if (isRenderMessageCorrupted(received.data(), received.size())) {
+        LOG(ERROR) << "RenderClient: the server sent a corrupted message";
+        disconnect();
+        return false;
+      }
+      const ssize_t size = ::recv(fd, buffer, sizeof(buffer), 0);
+      if (size < 0 && errno == EINTR)
+        continue;
+      if (size <= 0) {
+        LOG(ERROR) << "RenderClient: lost the connection to the server";
+        disconnect();
+        return false;
+      }
+      received.append(buffer, size);
+    }
+    return false;
+  }
+};
+
+RenderClient::RenderClient(const std::string& host,
+                           const int port,
+                           const float translationQuantum)
+    : pimpl_{spimpl::make_unique_impl<Impl>(translationQuantum)} {
+  CORRADE_ASSERT(translationQuantum > 0.0f,
+                 "RenderClient: expected a positive translation quantum, got"
+                     << translationQuantum, );
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints,
+                  &addresses) != 0) {
+    LOG(ERROR) << "RenderClient: cannot resolve " << host;
+    return;
+  }
+  for (addrinfo* address = addresses; address; address = address->ai_next) {
+    const int fd = socket(address->ai_family, address->ai_socktype,
+                          address->ai_protocol);
+    if (fd < 0)
+      continue;
+    if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+      pimpl_->fd = fd;
+      break;
+    }
+    ::close(fd);
+  }
+  freeaddrinfo(addresses);
+  if (pimpl_->fd < 0) {
+    LOG(ERROR) << "RenderClient: cannot connect to " << host << ":" << port;
+    return;
+  }
+  // requests are small and waited upon
+  const int noDelay = 1;
+  setsockopt(pimpl_->fd, IPPROTO_TCP, TCP_NODELAY, &noDelay,
+             sizeof(noDelay));
+  pimpl_->send(RenderMessage::Hello,
+               gfx::replay::keyframeStreamHeader(translationQuantum));
+}
+
+RenderClient::~RenderClient() {
+  if (std::shared_ptr<gfx::replay::Recorder> recorder =
+          pimpl_->recorder.lock())
+    recorder->setKeyframeListener(nullptr);
+  pimpl_->disconnect();
+}
+
+bool RenderClient::isConnected() const {
+  return pimpl_->fd >= 0;
+}
+
+void RenderClient::setSensors(
+    const std::vector<sensor::SensorSpec::ptr>& specs) {
+  pimpl_->send(RenderMessage::Sensors, encodeRenderSensors(specs));
+}
+
+void RenderClient::sendKeyframe(const gfx::replay::Keyframe& keyframe) {
+  std::string payload;
+  pimpl_->encoder.encode(keyframe, payload);
+  pimpl_->send(RenderMessage::Keyframe, payload);
+}
+
+void RenderClient::streamKeyframes(
+    const std::shared_ptr<gfx::replay::Recorder>& recorder) {
+  if (std::shared_ptr<gfx::replay::Recorder> previous =
+          pimpl_->recorder.lock())
+    previous->setKeyframeListener(nullptr);
+  pimpl_->recorder = recorder;
+  sendKeyframe(recorder->getSavedScene());
+  recorder->setKeyframeListener(
+      [this](const gfx::replay::Keyframe& keyframe) {
+        sendKeyframe(keyframe);
+      });
+}
+
+bool RenderClient::render(const std::vector<RenderSensorPose>& poses,
+                          std::vector<RenderObservation>& observations) {
+  ESP_PROFILE_SCOPE("RenderClient::render");
+  const uint32_t id = pimpl_->nextRequestId++;
+  pimpl_->send(RenderMessage::Render, encodeRenderRequest(id, poses));
+
+  RenderMessage type;
+  std::string payload;
+  if (!pimpl_->receive(type, payload))
+    return false;
+  // the server answers the requests of a client in order
+  uint32_t observationsId;
+  if (type != RenderMessage::Observations ||
+      !decodeRenderObservations(payload, observationsId, observations) ||
+      observationsId != id) {
+    LOG(ERROR) << "RenderClient: the server sent a corrupted message";
+    pimpl_->disconnect();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace sim
+}  // namespace esp
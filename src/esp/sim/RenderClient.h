@@ -0,0 +1,102 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_RENDERCLIENT_H_
+#define ESP_SIM_RENDERCLIENT_H_
+
+/** @file
+ * @brief Class @ref esp::sim::RenderClient
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RenderProtocol.h"
+#include "esp/core/esp.h"
+#include "esp/sensor/Sensor.h"
+
+namespace esp {
+namespace gfx {
+namespace replay {
+struct Keyframe;
+class Recorder;
+}  // namespace replay
+}  // namespace gfx
+namespace sim {
+
+/**
+ * @brief Gets the observations of a simulator that doesn't render from a
+ * @ref RenderServer
+ *
+ * The client streams the keyframes of the simulator's
+ * @ref gfx::replay::Recorder to the server, see @ref streamKeyframes(), and
+ * @ref render() blocks until the server sent the observations at the given
+ * sensor poses. The connection is lost for good on the first error, see
+ * @ref isConnected().
+ */
+class RenderClient {
+ public:
+  /**
+   * @brief Constructor, connects to the server
+   *
+   * @param[in] host               The host name or address of the server
+   * @param[in] port               The port of the server
+   * @param[in] translationQuantum The precision of the translations of the
+   *                               streamed instances, in meters
+   */
+  explicit RenderClient(const std::string& host,
+                        int port,
+                        float translationQuantum = 1e-4f);
+
+  ~RenderClient();
+
+  /** @brief Whether the client is connected to the server */
+  bool isConnected() const;
+
+  /**
+   * @brief Replace the sensors the server renders for this client
+   *
+   * Only the camera sensors that @ref sensor::CameraSensor draws without a
+   * cube map are supported, the server ignores the others.
+   */
+  void setSensors(const std::vector<sensor::SensorSpec::ptr>& specs);
+
+  /**
+   * @brief Send the next keyframe, the first one holding the whole scene,
+   * e.g. @ref gfx::replay::Recorder::getSavedScene()
+   */
+  void sendKeyframe(const gfx::replay::Keyframe& keyframe);
+
+  /**
+   * @brief Send the scene of @p recorder so far, then each keyframe it saves
+   * as it saves it
+   *
+   * Replaces the keyframe listener of @p recorder until this client is
+   * destroyed.
+   */
+  void streamKeyframes(const std::shared_ptr<gfx::replay::Recorder>& recorder);
+
+  /**
+   * @brief Render the observations of the sensors at @p poses
+   *
+   * Flush the pending keyframes of the recorder first, see
+   * @ref gfx::replay::Recorder::saveKeyframe(). Blocks until the server
+   * answered.
+   *
+   * @param[in] poses         The absolute poses of sensors of
+   *                          @ref setSensors()
+   * @param[out] observations The observations, in the order of @p poses
+   * @return Whether the server answered, false if the connection was lost
+   */
+  bool render(const std::vector<RenderSensorPose>& poses,
+              std::vector<RenderObservation>& observations);
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(RenderClient)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_RENDERCLIENT_H_
@@ -0,0 +1,253 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RenderProtocol.h"
+
+#include <cstring>
+
+namespace esp {
+namespace sim {
+
+namespace {
+constexpr std::size_t messageHeaderSize = 5;
+
+void putU32(std::string& out, const uint32_t value) {
+  for (int i = 0; i < 4; ++i)
+    out += char(value >> (8 * i));
+}
+
+void putFloat(std::string& out, const float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  putU32(out, bits);
+}
+
+void putString(std::string& out, const std::string& value) {
+  putU32(out, value.size());
+  out += value;
+}
+
+uint32_t getU32(const char* data) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i)
+    value |= uint32_t(uint8_t(data[i])) << (8 * i);
+  return value;
+}
+
+// Reads the fields of a payload, failing from the first truncated one on
+struct Reader {
+  const std::string& payload;
+  std::size_t offset = 0;
+  bool ok = true;
+
+  bool has(const std::size_t size) {
+    ok = ok && payload.size() - offset >= size;
+    return ok;
+  }
+
+  uint8_t u8() {
+    if (!has(1))
+      return 0;
+    return uint8_t(payload[offset++]);
+  }
+
+  uint32_t u32() {
+    if (!has(4))
+      return 0;
+    const uint32_t value = getU32(payload.data() + offset);
+    offset += 4;
+    return value;
+  }
+
+  float f32() {
+    const uint32_t bits = u32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string string() {
+    const uint32_t size = u32();
+    if (!has(size))
+      return {};
+    std::string value = payload.substr(offset, size);
+    offset += size;
+    return value;
+  }
+
+  // The whole payload was read, without anything left over
+  bool done() const { return ok && offset == payload.size(); }
+};
+}  // namespace
+
+void appendRenderMessage(std::string& out,
+                         const RenderMessage type,
+                         const std::string& payload) {
+  putU32(out, payload.size());
+  out += char(type);
+  out += payload;
+}
+
+std::size_t readRenderMessage(const char* data,
+                              const std::size_t size,
+                              RenderMessage& type,
+                              std::string& payload) {
+  if (size < messageHeaderSize || isRenderMessageCorrupted(data, size))
+    return 0;
+  const std::size_t payloadSize = getU32(data);
+  if (size - messageHeaderSize < payloadSize)
+    return 0;
+  type = RenderMessage(uint8_t(data[4]));
+  payload.assign(data + messageHeaderSize, payloadSize);
+  return messageHeaderSize + payloadSize;
+}
+
+bool isRenderMessageCorrupted(const char* data, const std::size_t size) {
+  return size >= 4 && getU32(data) > MaxRenderMessageSize;
+}
+
+std::string encodeRenderSensors(
+    const std::vector<sensor::SensorSpec::ptr>& specs) {
+  std::string out;
+  putU32(out, specs.size());
+  for (const sensor::SensorSpec::ptr& spec : specs) {
+    putString(out, spec->uuid);
+    out += char(spec->sensorType);
+    out += char(spec->sensorSubType);
+    putU32(out, spec->parameters.size());
+    for (const auto& parameter : spec->parameters) {
+      putString(out, parameter.first);
+      putString(out, parameter.second);
+    }
+    putU32(out, spec->resolution[0]);
+    putU32(out, spec->resolution[1]);
+    putU32(out, spec->channels);
+    putString(out, spec->encoding);
+  }
+  return out;
+}
+
+bool decodeRenderSensors(const std::string& payload,
+                         std::vector<sensor::SensorSpec::ptr>& specs) {
+  Reader reader{payload};
+  specs.clear();
+  const uint32_t count = reader.u32();
+  for (uint32_t i = 0; i < count && reader.ok; ++i) {
+    auto spec = sensor::SensorSpec::create();
+    spec->uuid = reader.string();
+    spec->sensorType = sensor::SensorType(reader.u8());
+    spec->sensorSubType = sensor::SensorSubType(reader.u8());
+    spec->parameters.clear();
+    const uint32_t numParameters = reader.u32();
+    for (uint32_t j = 0; j < numParameters && reader.ok; ++j) {
+      std::string name = reader.string();
+      spec->parameters[name] = reader.string();
+    }
+    spec->resolution[0] = int32_t(reader.u32());
+    spec->resolution[1] = int32_t(reader.u32());
+    spec->channels = int32_t(reader.u32());
+    spec->encoding = reader.string();
+    specs.push_back(std::move(spec));
+  }
+  return reader.done();
+}
+
+std::string encodeRenderRequest(const uint32_t id,
+                                const std::vector<RenderSensorPose>& poses) {
+  std::string out;
+  putU32(out, id);
+  putU32(out, poses.size());
+  for (const RenderSensorPose& pose : poses) {
+    putString(out, pose.uuid);
+    for (int i = 0; i < 3; ++i)
+      putFloat(out, pose.translation[i]);
+    for (int i = 0; i < 3; ++i)
+      putFloat(out, pose.rotation.vector()[i]);
+    putFloat(out, pose.rotation.scalar());
+  }
+  return out;
+}
+
+bool decodeRenderRequest(const std::string& payload,
+                         uint32_t& id,
+                         std::vector<RenderSensorPose>& poses) {
+  Reader reader{payload};
+  id = reader.u32();
+  poses.clear();
+  const uint32_t count = reader.u32();
+  for (uint32_t i = 0; i < count && reader.ok; ++i) {
+    RenderSensorPose pose;
+    pose.uuid = reader.string();
+    for (int j = 0; j < 3; ++j)
+      pose.translation[j] = reader.f32();
+    Magnum::Vector3 vector;
+    for (int j = 0; j < 3; ++j)
+      vector[j] = reader.f32();
+    pose.rotation = Magnum::Quaternion{vector, reader.f32()};
+    poses.push_back(std::move(pose));
+  }
+  return reader.done();
+}
+
+std::string encodeRenderObservations(
+    const uint32_t id,
+    const std::vector<RenderObservation>& observations) {
+  std::string out;
+  putU32(out, id);
+  putU32(out, observations.size());
+  for (const RenderObservation& observation : observations) {
+    putString(out, observation.uuid);
+    const core::Buffer* buffer = observation.buffer.get();
+    // an observation without a buffer has no data type
+    out += char(buffer ? buffer->dataType : core::DataType::DT_NONE);
+    if (!buffer)
+      continue;
+    putU32(out, buffer->shape.size());
+    for (const std::size_t extent : buffer->shape)
+      putU32(out, extent);
+    out.append(reinterpret_cast<const char*>(buffer->data.data()),
+               buffer->data.size());
+  }
+  return out;
+}
+
+bool decodeRenderObservations(const std::string& payload,
+                              uint32_t& id,
+                              std::vector<RenderObservation>& observations) {
+  Reader reader{payload};
+  id = reader.u32();
+  observations.clear();
+  const uint32_t count = reader.u32();
+  for (uint32_t i = 0; i < count && reader.ok; ++i) {
+    RenderObservation observation;
+    observation.uuid = reader.string();
+    const core::DataType dataType = core::DataType(reader.u8());
+    if (dataType != core::DataType::DT_NONE) {
+      const uint32_t dimensions = reader.u32();
+      if (!reader.has(std::size_t{dimensions} * 4))
+        break;
+      std::vector<std::size_t> shape(dimensions);
+      std::size_t size = core::getDataTypeByteSize(dataType);
+      for (std::size_t& extent : shape) {
+        extent = reader.u32();
+        // checked as it goes, so that the size can't overflow
+        size *= extent;
+        reader.ok = reader.ok && size <= payload.size();
+      }
+      if (!core::getDataTypeByteSize(dataType) || !reader.has(size)) {
+        reader.ok = false;
+        break;
+      }
+      observation.buffer = core::Buffer::create(shape, dataType);
+      std::memcpy(observation.buffer->data.data(),
+                  payload.data() + reader.offset, size);
+      reader.offset += size;
+    }
+    observations.push_back(std::move(observation));
+  }
+  return reader.done();
+}
+
+}  // namespace sim
+}  // namespace esp
@@ -0,0 +1,147 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_RENDERPROTOCOL_H_
+#define ESP_SIM_RENDERPROTOCOL_H_
+
+/** @file
+ * @brief Enum @ref esp::sim::RenderMessage, structs
+ * @ref esp::sim::RenderSensorPose, @ref esp::sim::RenderObservation and the
+ * functions encoding the messages of @ref esp::sim::RenderServer and
+ * @ref esp::sim::RenderClient
+ */
+
+#include <Magnum/Math/Quaternion.h>
+#include <Magnum/Math/Vector3.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp/core/Buffer.h"
+#include "esp/sensor/Sensor.h"
+
+namespace esp {
+namespace sim {
+
+/**
+ * @brief The messages between a @ref RenderClient and a @ref RenderServer
+ *
+ * Each message is its payload size as a little-endian 32-bit integer, its
+ * type as a byte and the payload, see @ref appendRenderMessage().
+ */
+enum class RenderMessage : uint8_t {
+  /**
+   * Client to server, the first message: the header of
+   * @ref gfx::replay::keyframeStreamHeader()
+   */
+  Hello = 1,
+
+  /**
+   * Client to server: the sensors of the client, replacing the previous ones,
+   * see @ref encodeRenderSensors()
+   */
+  Sensors = 2,
+
+  /**
+   * Client to server: the next keyframe of the client's
+   * @ref gfx::replay::KeyframeEncoder
+   */
+  Keyframe = 3,
+
+  /**
+   * Client to server: poses of sensors to render, see
+   * @ref encodeRenderRequest()
+   */
+  Render = 4,
+
+  /**
+   * Server to client: the observations of a request, in the order of its
+   * poses, see @ref encodeRenderObservations()
+   */
+  Observations = 5,
+};
+
+/** @brief Messages larger than this are rejected as corrupted */
+constexpr std::size_t MaxRenderMessageSize = std::size_t{1} << 30;
+
+/** @brief The absolute pose of a sensor to render an observation of */
+struct RenderSensorPose {
+  /** @brief The @ref sensor::SensorSpec::uuid of the sensor */
+  std::string uuid;
+  Magnum::Vector3 translation;
+  Magnum::Quaternion rotation;
+};
+
+/** @brief A rendered observation */
+struct RenderObservation {
+  /** @brief The @ref sensor::SensorSpec::uuid of the sensor */
+  std::string uuid;
+
+  /**
+   * @brief The observation, shaped like the observation space of the
+   * sensor, nullptr if the server has no sensor of this uuid
+   */
+  core::Buffer::ptr buffer;
+};
+
+/** @brief Append a message of @p type to @p out */
+void appendRenderMessage(std::string& out,
+                         RenderMessage type,
+                         const std::string& payload);
+
+/**
+ * @brief Read the message at the start of @p data
+ *
+ * @return The size of the message, 0 if @p data doesn't hold all of it yet.
+ * Check @ref isRenderMessageCorrupted() before waiting for more.
+ */
+std::size_t readRenderMessage(const char* data,
+                              std::size_t size,
+                              RenderMessage& type,
+                              std::string& payload);
+
+/**
+ * @brief Whether the message at the start of @p data is larger than
+ * @ref MaxRenderMessageSize, in which case the stream can't be recovered
+ */
+bool isRenderMessageCorrupted(const char* data, std::size_t size);
+
+/**
+ * @brief Encode the specs of camera sensors
+ *
+ * Only the uuid, the sensor type and subtype, the parameters, the
+ * resolution, the channels and the encoding are sent, the pose comes with
+ * each request.
+ */
+std::string encodeRenderSensors(
+    const std::vector<sensor::SensorSpec::ptr>& specs);
+
+/** @brief Decode @ref encodeRenderSensors(), false if corrupted */
+bool decodeRenderSensors(const std::string& payload,
+                         std::vector<sensor::SensorSpec::ptr>& specs);
+
+/** @brief Encode a request of the observations at @p poses */
+std::string encodeRenderRequest(uint32_t id,
+                                const std::vector<RenderSensorPose>& poses);
+
+/** @brief Decode @ref encodeRenderRequest(), false if corrupted */
+bool decodeRenderRequest(const std::string& payload,
+                         uint32_t& id,
+                         std::vector<RenderSensorPose>& poses);
+
+/** @brief Encode the observations of the request @p id */
+std::string encodeRenderObservations(
+    uint32_t id,
+    const std::vector<RenderObservation>& observations);
+
+/** @brief Decode @ref encodeRenderObservations(), false if corrupted */
+bool decodeRenderObservations(const std::string& payload,
+                              uint32_t& id,
+                              std::vector<RenderObservation>& observations);
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_RENDERPROTOCOL_H_
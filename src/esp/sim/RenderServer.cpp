@@ -0,0 +1,401 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "RenderServer.h"
+#include "RenderProtocol.h"
+#include "Simulator.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <deque>
+#include <map>
+#include <memory>
+
+#include "esp/core/Profiling.h"
+#include "esp/gfx/Renderer.h"
+#include "esp/gfx/replay/KeyframeStream.h"
+#include "esp/gfx/replay/Player.h"
+#include "esp/scene/SceneGraph.h"
+#include "esp/sensor/CameraSensor.h"
+
+namespace esp {
+namespace sim {
+
+namespace {
+struct Request {
+  uint32_t id;
+  std::vector<RenderSensorPose> poses;
+};
+
+// The sensors drawn by a CameraSensor, without a cube map
+bool isCameraSensorSpec(const sensor::SensorSpec& spec) {
+  switch (spec.sensorType) {
+    case sensor::SensorType::Color:
+    case sensor::SensorType::Depth:
+    case sensor::SensorType::Normal:
+    case sensor::SensorType::Semantic:
+    case sensor::SensorType::PointCloud:
+      break;
+    default:
+      return false;
+  }
+  return (spec.sensorSubType == sensor::SensorSubType::Pinhole ||
+          spec.sensorSubType == sensor::SensorSubType::Orthographic) &&
+         spec.resolution[0] > 0 && spec.resolution[1] > 0;
+}
+
+struct Client {
+  int fd;
+  std::string received;
+  std::string pending;
+  std::unique_ptr<gfx::replay::KeyframeDecoder> decoder;
+  int sceneId = ID_UNDEFINED;
+  std::shared_ptr<gfx::replay::Player> player;
+  // the parent of the sensor nodes, at the root of the scene graph
+  scene::SceneNode* sensorRoot = nullptr;
+  std::map<std::string, sensor::CameraSensor::ptr> sensors;
+  std::deque<Request> requests;
+};
+}  // namespace
+
+struct RenderServer::Impl {
+  explicit Impl(Simulator& sim) : sim{sim} {}
+
+  Simulator& sim;
+  int fd = -1;
+  int port = -1;
+  // unique_ptr so that the clients don't move when others are added
+  std::vector<std::unique_ptr<Client>> clients;
+  // the scene graphs of the clients that disconnected, emptied for the next
+  std::vector<int> freeSceneIds;
+
+  void accept() {
+    while (true) {
+      const int clientFd = ::accept(fd, nullptr, nullptr);
+      if (clientFd < 0)
+        return;
+      fcntl(clientFd, F_SETFL, fcntl(clientFd, F_GETFL) | O_NONBLOCK);
+      // requests are small and answered right away
+      const int noDelay = 1;
+      setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &noDelay,
+                 sizeof(noDelay));
+      auto client = std::make_unique<Client>();
+      client->fd = clientFd;
+      clients.push_back(std::move(client));
+    }
+  }
+
+  // Returns false if the client disconnected or sent a bad message
+  bool receive(Client& client) {
+    char buffer[65536];
+    while (true) {
+      const ssize_t size = ::recv(client.fd, buffer, sizeof(buffer), 0);
+      if (size == 0)
+        return false;
+      if (size < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+          return false;
+        break;
+      }
+      client.received.append(buffer, size);
+    }
+
+    std::size_t offset = 0;
+    RenderMessage type;
+    std::string payload;
+    while (const std::size_t size =
+               readRenderMessage(client.received.data() + offset,
+                                 client.received.size() - offset, type,
+                                 payload)) {
+      offset += size;
+      if (!handle(client, type, payload))
+        return false;
+    }
+    client.received.erase(0, offset);
+    if (isRenderMessageCorrupted(client.received.data(),
+                                 client.received.size())) {
+      LOG(WARNING) << "RenderServer: disconnected a client that sent a "
+                      "corrupted message";
+      return false;
+    }
+    return true;
+  }
+
+  bool handle(Client& client, const RenderMessage type,
+              const std::string& payload) {
+    if (!client.decoder && type != RenderMessage::Hello) {
+      LOG(WARNING) << "RenderServer: disconnected a client that didn't start "
+                      "with a hello";
+      return false;
+    }
+    switch (type) {
+      case RenderMessage::Hello:
+        return hello(client, payload);
+      case RenderMessage::Sensors:
+        return setSensors(client, payload);
+      case RenderMessage::Keyframe: {
+        gfx::replay::Keyframe keyframe;
+        if (client.decoder->decode(payload.data(), payload.size(),
+                                   keyframe) != payload.size()) {
+          LOG(WARNING) << "RenderServer: disconnected a client that sent a "
+                          "corrupted keyframe";
+          return false;
+        }
+        client.player->applyStreamedKeyframe(std::move(keyframe));
+        return true;
+      }
+      case RenderMessage::Render: {
+        Request request;
+        if (!decodeRenderRequest(payload, request.id, request.poses)) {
+          LOG(WARNING) << "RenderServer: disconnected a client that sent a "
+                          "corrupted request";
+          return false;
+        }
+        client.requests.push_back(std::move(request));
+        return true;
+      }
+      default:
+        LOG(WARNING) << "RenderServer: disconnected a client that sent an "
+                        "unexpected message "
+                     << int(type);
+        return false;
+    }
+  }
+
+  bool hello(Client& client, const std::string& payload) {
+    float translationQuantum;
+    if (client.decoder ||
+        gfx::replay::readKeyframeStreamHeader(
+            payload.data(), payload.size(), translationQuantum) !=
+            payload.size()) {
+      LOG(WARNING) << "RenderServer: disconnected a client that sent an "
+                      "unknown header";
+      return false;
+    }
+    client.decoder =
+        std::make_unique<gfx::replay::KeyframeDecoder>(translationQuantum);
+
+    if (freeSceneIds.empty()) {
+      client.sceneId = sim.createSceneGraph();
+    } else {
+      client.sceneId = freeSceneIds.back();
+      freeSceneIds.pop_back();
+    }
+    Simulator* simulator = &sim;
+    const int sceneId = client.sceneId;
+    client.player = std::make_shared<gfx::replay::Player>(
+        [simulator, sceneId](
+            const assets::AssetInfo& assetInfo,
+            const assets::RenderAssetInstanceCreationInfo& creation) {
+          return simulator->loadAndCreateRenderAssetInstance(assetInfo,
+                                                             creation, sceneId);
+        });
+    client.player->setSnapshotInterval(0);
+    client.sensorRoot =
+        &sim.getSceneGraph(sceneId).getRootNode().createChild();
+    return true;
+  }
+
+  bool setSensors(Client& client, const std::string& payload) {
+    std::vector<sensor::SensorSpec::ptr> specs;
+    if (!decodeRenderSensors(payload, specs)) {
+      LOG(WARNING) << "RenderServer: disconnected a client that sent "
+                      "corrupted sensors";
+      return false;
+    }
+    deleteSensors(client);
+    for (const sensor::SensorSpec::ptr& spec : specs) {
+      if (!isCameraSensorSpec(*spec)) {
+        LOG(WARNING) << "RenderServer: ignored the sensor " << spec->uuid
+                     << " that isn't a camera";
+        continue;
+      }
+      spec->asyncReadback = true;
+      auto cameraSensor = sensor::CameraSensor::create(
+          client.sensorRoot->createChild(), spec);
+      sim.getRenderer()->bindRenderTarget(*cameraSensor);
+      client.sensors[spec->uuid] = std::move(cameraSensor);
+    }
+    return true;
+  }
+
+  void deleteSensors(Client& client) {
+    // the sensors are features of their nodes, destroyed before them
+    std::vector<scene::SceneNode*> nodes;
+    for (const auto& pair : client.sensors)
+      nodes.push_back(&pair.second->node());
+    client.sensors.clear();
+    for (scene::SceneNode* node : nodes)
+      delete node;
+  }
+
+  void disconnect(Client& client) {
+    ::close(client.fd);
+    if (client.sceneId == ID_UNDEFINED)
+      return;
+    deleteSensors(client);
+    delete client.sensorRoot;
+    if (client.player->getNumKeyframes())
+      client.player->setKeyframeIndex(-1);
+    freeSceneIds.push_back(client.sceneId);
+  }
+
+  // Returns false if the client disconnected
+  bool flush(Client& client) {
+    while (!client.pending.empty()) {
+      const ssize_t size = ::send(client.fd, client.pending.data(),
+                                  client.pending.size(), MSG_NOSIGNAL);
+      if (size < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+      client.pending.erase(0, size);
+    }
+    return true;
+  }
+
+  // Draws the oldest request of every client, then reads them all back
+  int render() {
+    ESP_PROFILE_SCOPE("RenderServer::render");
+    for (const std::unique_ptr<Client>& client : clients) {
+      if (client->requests.empty())
+        continue;
+      scene::SceneGraph& sceneGraph = sim.getSceneGraph(client->sceneId);
+      for (const RenderSensorPose& pose : client->requests.front().poses) {
+        auto found = client->sensors.find(pose.uuid);
+        if (found == client->sensors.end())
+          continue;
+        sensor::CameraSensor& cameraSensor = *found->second;
+        cameraSensor.node()
+            .setTranslation(pose.translation)
+            .setRotation(pose.rotation);
+        // starts the async readback, waited upon after all the draws
+        cameraSensor.drawObservationOf(sim, sceneGraph);
+      }
+    }
+
+    int rendered = 0;
+    for (const std::unique_ptr<Client>& client : clients) {
+      if (client->requests.empty())
+        continue;
+      const Request request = std::move(client->requests.front());
+      client->requests.pop_front();
+      std::vector<RenderObservation> observations;
+      for (const RenderSensorPose& pose : request.poses) {
+        RenderObservation observation{pose.uuid, nullptr};
+        auto found = client->sensors.find(pose.uuid);
+        if (found != client->sensors.end()) {
+          sensor::CameraSensor& cameraSensor = *found->second;
+          sensor::ObservationSpace space;
+          cameraSensor.getObservationSpace(space);
+          observation.buffer =
+              core::Buffer::create(space.shape, space.dataType);
+          cameraSensor.readObservationInto(cameraSensor.renderTarget(),
+                                           observation.buffer->data);
+        }
+        observations.push_back(std::move(observation));
+      }
+      appendRenderMessage(client->pending, RenderMessage::Observations,
+                          encodeRenderObservations(request.id, observations));
+      ++rendered;
+    }
+    return rendered;
+  }
+};
+
+RenderServer::RenderServer(Simulator& sim, const int port)
+    : pimpl_{spimpl::make_unique_impl<Impl>(sim)} {
+  CORRADE_ASSERT(sim.getRenderer(),
+                 "RenderServer: the simulator has no renderer", );
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    LOG(ERROR) << "RenderServer: cannot create a socket";
+    return;
+  }
+  const int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  socklen_t addressSize = sizeof(address);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), addressSize) < 0 ||
+      listen(fd, 64) < 0 ||
+      getsockname(fd, reinterpret_cast<sockaddr*>(&address), &addressSize) <
+          0) {
+    LOG(ERROR) << "RenderServer: cannot listen on port " << port;
+    ::close(fd);
+    return;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  pimpl_->fd = fd;
+  pimpl_->port = ntohs(address.sin_port);
+  LOG(INFO) << "RenderServer: rendering on port " << pimpl_->port;
+}
+
+RenderServer::~RenderServer() {
+  for (const std::unique_ptr<Client>& client : pimpl_->clients)
+    pimpl_->disconnect(*client);
+  if (pimpl_->fd >= 0)
+    ::close(pimpl_->fd);
+}
+
+bool RenderServer::isListening() const {
+  return pimpl_->fd >= 0;
+}
+
+int RenderServer::port() const {
+  return pimpl_->port;
+}
+
+int RenderServer::poll(const int timeoutMs) {
+  if (pimpl_->fd < 0)
+    return 0;
+  auto& clients = pimpl_->clients;
+
+  // wait for messages unless there is work already
+  bool hasRequests = false;
+  std::vector<pollfd> fds{{pimpl_->fd, POLLIN, 0}};
+  for (const std::unique_ptr<Client>& client : clients) {
+    hasRequests = hasRequests || !client->requests.empty();
+    fds.push_back({client->fd,
+                   short(POLLIN | (client->pending.empty() ? 0 : POLLOUT)),
+                   0});
+  }
+  ::poll(fds.data(), fds.size(), hasRequests ? 0 : timeoutMs);
+
+  pimpl_->accept();
+  for (std::size_t i = 0; i < clients.size();) {
+    if (pimpl_->receive(*clients[i]) && pimpl_->flush(*clients[i])) {
+      ++i;
+    } else {
+      pimpl_->disconnect(*clients[i]);
+      clients.erase(clients.begin() + i);
+    }
+  }
+
+  const int rendered = pimpl_->render();
+  for (std::size_t i = 0; i < clients.size();) {
+    if (pimpl_->flush(*clients[i])) {
+      ++i;
+    } else {
+      pimpl_->disconnect(*clients[i]);
+      clients.erase(clients.begin() + i);
+    }
+  }
+  return rendered;
+}
+
+int RenderServer::numClients() const {
+  return pimpl_->clients.size();
+}
+
+}  // namespace sim
+}  // namespace esp
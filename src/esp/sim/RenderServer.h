@@ -0,0 +1,74 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_RENDERSERVER_H_
+#define ESP_SIM_RENDERSERVER_H_
+
+/** @file
+ * @brief Class @ref esp::sim::RenderServer
+ */
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sim {
+
+class Simulator;
+
+/**
+ * @brief Renders the observations of remote simulators from the gfx replay
+ * keyframes they stream, see @ref RenderClient
+ *
+ * The simulators doing physics or navigation don't draw anything: they
+ * stream the keyframes of their @ref gfx::replay::Recorder and request
+ * observations at sensor poses, and a GPU process running this server
+ * renders them. Each client gets its own scene graph of the GPU simulator,
+ * created with @ref Simulator::createSceneGraph(), a @ref gfx::replay::Player
+ * applying its keyframes in it and camera sensors built from the specs it
+ * sent. The assets are loaded by the resource manager of the GPU simulator,
+ * shared by all the clients, so they have to be available at the same paths
+ * to this process.
+ *
+ * There is no thread: @ref poll() receives the messages, then renders the
+ * oldest pending request of every client in one pass, all the draws before
+ * the first readback, and sends the observations back.
+ */
+class RenderServer {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] sim  The simulator rendering the observations, with a renderer
+   * @param[in] port The TCP port to listen on, 0 for any free one
+   */
+  explicit RenderServer(Simulator& sim, int port);
+
+  ~RenderServer();
+
+  /** @brief Whether the server could listen on its port */
+  bool isListening() const;
+
+  /** @brief The port listened on, -1 if not listening */
+  int port() const;
+
+  /**
+   * @brief Accept connections, receive the messages of the clients, render
+   * their pending requests and send the observations
+   *
+   * @param[in] timeoutMs How long to wait for messages if no request is
+   *                      pending, -1 for as long as it takes
+   * @return The number of requests rendered
+   */
+  int poll(int timeoutMs = 0);
+
+  /** @brief The number of connected clients */
+  int numClients() const;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(RenderServer)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_RENDERSERVER_H_
@@ -4,24 +4,42 @@
 
 #include "Simulator.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include <Corrade/Utility/Algorithms.h>
 #include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
 #include <Corrade/Utility/String.h>
 #include <Magnum/EigenIntegration/GeometryIntegration.h>
 #include <Magnum/GL/Context.h>
-
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/ImageView.h>
+
+#include "esp/assets/FileProvider.h"
+#include "esp/assets/SceneBundle.h"
+#include "esp/core/MappedFile.h"
+#include "esp/core/PerfStats.h"
+#include "esp/core/Profiling.h"
+#include "esp/core/StartupProfile.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/Drawable.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/Renderer.h"
+#include "esp/gfx/TextureStreamer.h"
 #include "esp/gfx/replay/Recorder.h"
 #include "esp/gfx/replay/ReplayManager.h"
 #include "esp/io/io.h"
 #include "esp/metadata/attributes/AttributesBase.h"
 #include "esp/nav/PathFinder.h"
+#include "esp/physics/KinematicCharacterController.h"
 #include "esp/physics/PhysicsManager.h"
 #include "esp/scene/ObjectControls.h"
 #include "esp/scene/SemanticScene.h"
@@ -45,11 +63,129 @@ Simulator::Simulator(const SimulatorConfiguration& cfg)
   reconfigure(cfg);
 }
 
+Simulator::Simulator(const SimulatorConfiguration& cfg,
+                     metadata::MetadataMediator::ptr metadataMediator)
+    : metadataMediator_{std::move(metadataMediator)},
+      random_{core::Random::create(cfg.randomSeed)},
+      requiresTextures_{Cr::Containers::NullOpt} {
+  reconfigure(cfg);
+}
+
 Simulator::~Simulator() {
   LOG(INFO) << "Deconstructing Simulator";
   close();
 }
 
+namespace {
+
+// Create a pathfinder with the navmesh if available, preferring the one
+// baked in the bundle of the same name
+nav::PathFinder::ptr loadPathFinder(const std::string& navmeshFilename) {
+  nav::PathFinder::ptr pathfinder = nav::PathFinder::create();
+  const std::string bundleFilename =
+      assets::SceneBundle::filenameFor(navmeshFilename);
+  if (io::exists(bundleFilename)) {
+    ESP_STARTUP_SPAN("nav::PathFinder::loadNavMesh");
+    if (assets::SceneBundle{bundleFilename}.loadNavMesh(*pathfinder)) {
+      LOG(INFO) << "Loaded the navmesh from " << bundleFilename;
+      return pathfinder;
+    }
+  }
+  if (io::exists(navmeshFilename)) {
+    ESP_STARTUP_SPAN("nav::PathFinder::loadNavMesh");
+    core::StartupProfile::addBytesRead(io::fileSize(navmeshFilename));
+    LOG(INFO) << "Loading navmesh from " << navmeshFilename;
+    pathfinder->loadNavMesh(navmeshFilename);
+    LOG(INFO) << "Loaded.";
+  } else {
+    LOG(WARNING) << "Navmesh file not found, checked at " << navmeshFilename;
+  }
+  return pathfinder;
+}
+
+// Parse a house file with load, or read it from its binary cache in
+// cacheDirectory if it's not empty, caching it at the first load
+bool loadCachedHouse(bool (*load)(const std::string&,
+                                  scene::SemanticScene&,
+                                  const quatf&),
+                     const std::string& houseFilename,
+                     const std::string& cacheDirectory,
+                     scene::SemanticScene& semanticScene) {
+  const quatf rotation =
+      quatf::FromTwoVectors(-vec3f::UnitZ(), geo::ESP_GRAVITY);
+  if (cacheDirectory.empty()) {
+    return load(houseFilename, semanticScene, rotation);
+  }
+  const std::string cacheFilename =
+      scene::SemanticScene::cacheFilename(cacheDirectory, houseFilename);
+  if (scene::SemanticScene::loadCache(cacheFilename, houseFilename,
+                                      semanticScene, rotation)) {
+    return true;
+  }
+  if (!load(houseFilename, semanticScene, rotation)) {
+    return false;
+  }
+  if (!Cr::Utility::Directory::mkpath(cacheDirectory) ||
+      !scene::SemanticScene::saveCache(cacheFilename, houseFilename,
+                                       semanticScene, rotation)) {
+    LOG(WARNING) << "Simulator: cannot cache the semantic scene of "
+                 << houseFilename << " in " << cacheDirectory;
+  }
+  return true;
+}
+
+// Load the semantic annotations of a stage, if it has any
+std::shared_ptr<scene::SemanticScene> loadSemanticScene(
+    assets::AssetType stageType,
+    std::string houseFilename,
+    const std::string& stageFilename,
+    const std::string& cacheDirectory) {
+  ESP_STARTUP_SPAN("scene::SemanticScene::load");
+  auto semanticScene = scene::SemanticScene::create();
+  switch (stageType) {
+    case assets::AssetType::INSTANCE_MESH:
+      houseFilename = Cr::Utility::Directory::join(
+          Cr::Utility::Directory::path(houseFilename), "info_semantic.json");
+      if (io::exists(houseFilename)) {
+        core::StartupProfile::addBytesRead(io::fileSize(houseFilename));
+        loadCachedHouse(scene::SemanticScene::loadReplicaHouse, houseFilename,
+                        cacheDirectory, *semanticScene);
+      }
+      break;
+    case assets::AssetType::MP3D_MESH:
+      // TODO(msb) Fix AssetType determination logic.
+      if (io::exists(houseFilename)) {
+        core::StartupProfile::addBytesRead(io::fileSize(houseFilename));
+        using Corrade::Utility::String::endsWith;
+        if (endsWith(houseFilename, ".house")) {
+          loadCachedHouse(scene::SemanticScene::loadMp3dHouse, houseFilename,
+                          cacheDirectory, *semanticScene);
+        } else if (endsWith(houseFilename, ".scn")) {
+          loadCachedHouse(scene::SemanticScene::loadGibsonHouse,
+                          houseFilename, cacheDirectory, *semanticScene);
+        }
+      }
+      break;
+    case assets::AssetType::SUNCG_SCENE:
+      scene::SemanticScene::loadSuncgHouse(stageFilename, *semanticScene);
+      break;
+    default:
+      break;
+  }
+  return semanticScene;
+}
+
+// Read a file and drop its contents, so that it's in the OS file cache when
+// it's loaded
+void warmFileCache(const std::string& filename) {
+  std::ifstream file{filename, std::ios::binary};
+  std::vector<char> chunk(1 << 20);
+  while (file.read(chunk.data(), chunk.size()) || file.gcount()) {
+  }
+}
+
+}  // namespace
+
 void Simulator::close() {
   pathfinder_ = nullptr;
   navMeshVisPrimID_ = esp::ID_UNDEFINED;
@@ -73,21 +209,43 @@ void Simulator::close() {
   config_ = SimulatorConfiguration{};
 
   frustumCulling_ = true;
+  occlusionCulling_ = false;
   requiresTextures_ = Cr::Containers::NullOpt;
+  prefetchedScene_ = std::future<PrefetchedScene>{};
 }
 
 void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
+  bool loaded;
+  {
+    core::StartupProfile::Recording recording{startupProfile_,
+                                              "Simulator::reconfigure"};
+    loaded = reconfigureInternal(cfg);
+  }
+  if (loaded) {
+    LOG(INFO) << "Simulator::reconfigure: startup profile\n"
+              << startupProfile_.report();
+  }
+}
+
+bool Simulator::reconfigureInternal(const SimulatorConfiguration& cfg) {
+  // before anything the dataset and stage load runs on the shared pool
+  if (cfg.threadBudget) {
+    core::ThreadPool::setThreadBudget(cfg.threadBudget);
+  }
   // set dataset upon creation or reconfigure
-  if (!metadataMediator_) {
-    metadataMediator_ =
-        metadata::MetadataMediator::create(cfg.sceneDatasetConfigFile);
-  } else {
-    metadataMediator_->setActiveSceneDatasetName(cfg.sceneDatasetConfigFile);
+  {
+    ESP_STARTUP_SPAN("metadata::MetadataMediator");
+    if (!metadataMediator_) {
+      metadataMediator_ =
+          metadata::MetadataMediator::create(cfg.sceneDatasetConfigFile);
+    } else {
+      metadataMediator_->setActiveSceneDatasetName(cfg.sceneDatasetConfigFile);
+    }
   }
   // assign MM to RM on create or reconfigure
   if (!resourceManager_) {
     resourceManager_ =
-        std::make_unique<assets::ResourceManager>(metadataMediator_);
+        std::make_shared<assets::ResourceManager>(metadataMediator_);
   } else {
     resourceManager_->setMetadataMediator(metadataMediator_);
   }
@@ -99,10 +257,11 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
   // if configuration is unchanged, just reset and return
   if (cfg == config_) {
     reset();
-    return;
+    return false;
   }
-  // otherwise set current configuration and initialize
-  // TODO can optimize to do partial re-initialization instead of from-scratch
+  // otherwise set current configuration and initialize, the loaded stage is
+  // kept if none of the settings it depends on changed
+  const bool reloadStage = isStageReloadRequired(cfg);
   config_ = cfg;
 
   if (requiresTextures_ == Cr::Containers::NullOpt) {
@@ -116,6 +275,38 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
     LOG(WARNING) << "Not changing requiresTextures as the simulator was "
                     "initialized with True.  Call close() to change this.";
   }
+  // only affects meshes which are not loaded yet
+  resourceManager_->setGenerateMeshLods(config_.generateMeshLods);
+  resourceManager_->setMergeStaticMeshes(config_.mergeStaticMeshes);
+  resourceManager_->setBakeStaticLighting(config_.bakeStaticLighting);
+  resourceManager_->setReleaseStageMeshData(config_.releaseStageMeshData);
+  resourceManager_->setStageCollisionSimplification(
+      config_.stageCollisionSimplification);
+  resourceManager_->setCompressVertexFormats(config_.compressVertexFormats);
+  resourceManager_->setMeshCacheDirectory(config_.meshCacheDirectory);
+  resourceManager_->setBakedLightingCacheDirectory(
+      config_.bakedLightingCacheDirectory);
+  resourceManager_->setCompressTextures(config_.compressTextures);
+  resourceManager_->setCompressedTextureCacheDirectory(
+      config_.compressedTextureCacheDirectory);
+  resourceManager_->setShaderCacheDirectory(config_.shaderCacheDirectory);
+  resourceManager_->setImageBasedLightingCacheDirectory(
+      config_.imageBasedLightingCacheDirectory);
+  resourceManager_->setPTexConversionDirectory(
+      config_.ptexConversionDirectory, config_.ptexConversionTileResolution);
+  resourceManager_->setFileProvider(config_.fileProvider);
+  core::PerfStats::shared().setEnabled(config_.enablePerfStats);
+  if (config_.textureMemoryBudget || resourceManager_->getTextureStreamer()) {
+    resourceManager_->setTextureMemoryBudget(config_.textureMemoryBudget);
+  }
+  resourceManager_->setAssetCacheBudget(config_.assetCacheHostBudget,
+                                        config_.assetCacheGpuBudget);
+
+  if (!reloadStage) {
+    seed(config_.randomSeed);
+    reset();
+    return false;
+  }
 
   // use physics attributes manager to get physics manager attributes
   // described by config file - this always exists to configure scene
@@ -150,14 +341,44 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
   esp::assets::AssetType stageType = static_cast<esp::assets::AssetType>(
       stageAttributes->getRenderAssetType());
 
+  // take the navmesh and semantic scene from a prefetch of the same stage
+  PrefetchedScene prefetched;
+  if (prefetchedScene_.valid()) {
+    prefetched = prefetchedScene_.get();
+    if (prefetched.stageFilename != stageFilename ||
+        prefetched.navmeshFilename != navmeshFilename ||
+        prefetched.houseFilename != houseFilename) {
+      LOG(INFO) << "Discarding the prefetched stage "
+                << prefetched.stageFilename;
+      prefetched = PrefetchedScene{};
+    }
+  }
+  // or from a preload, of this process or of the one it was forked from
+  if (!prefetched.pathfinder) {
+    auto& preloaded = preloadedScenes();
+    auto found = preloaded.find(stageFilename);
+    if (found != preloaded.end() &&
+        found->second.navmeshFilename == navmeshFilename &&
+        found->second.houseFilename == houseFilename) {
+      prefetched = std::move(found->second);
+      preloaded.erase(found);
+    }
+  }
+
   // create pathfinder and load navmesh if available
-  pathfinder_ = nav::PathFinder::create();
-  if (io::exists(navmeshFilename)) {
-    LOG(INFO) << "Loading navmesh from " << navmeshFilename;
-    pathfinder_->loadNavMesh(navmeshFilename);
-    LOG(INFO) << "Loaded.";
+  pendingNavmeshFilename_.clear();
+  navMeshModified_ = false;
+  if (prefetched.pathfinder) {
+    pathfinder_ = std::move(prefetched.pathfinder);
+  } else if (config_.fileProvider && !navmeshFilename.empty() &&
+             config_.fileProvider->request(navmeshFilename) !=
+                 assets::FileProvider::Status::Unavailable) {
+    // loaded by loadStreamedFiles(), now if it's there already
+    pathfinder_ = nav::PathFinder::create();
+    pendingNavmeshFilename_ = navmeshFilename;
+    loadStreamedNavMesh();
   } else {
-    LOG(WARNING) << "Navmesh file not found, checked at " << navmeshFilename;
+    pathfinder_ = loadPathFinder(navmeshFilename);
   }
 
   // Calling to seeding needs to be done after the pathfinder creation
@@ -170,6 +391,7 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
   // We need to make a design decision here:
   // when doing reconfigure, shall we delete all of the previous scene graphs
 
+  const std::vector<int> previousSceneIDs = sceneID_;
   activeSceneID_ = sceneManager_->initSceneGraph();
 
   // LOG(INFO) << "Active scene graph ID = " << activeSceneID_;
@@ -179,11 +401,13 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
     /* When creating a viewer based app, there is no need to create a
     WindowlessContext since a (windowed) context already exists. */
     if (!context_ && !Magnum::GL::Context::hasCurrent()) {
-      context_ = gfx::WindowlessContext::create_unique(config_.gpuDeviceId);
+      ESP_STARTUP_SPAN("gfx::WindowlessContext::create");
+      context_ = gfx::WindowlessContext::create(config_.gpuDeviceId);
     }
 
     // reinitalize members
     if (!renderer_) {
+      ESP_STARTUP_SPAN("gfx::Renderer::create");
       gfx::Renderer::Flags flags;
       if (!(*requiresTextures_))
         flags |= gfx::Renderer::Flag::NoTextures;
@@ -199,8 +423,16 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
     bool loadSuccess = false;
 
     // (re)seat & (re)init physics manager
-    resourceManager_->initPhysicsManager(physicsManager_, config_.enablePhysics,
-                                         &rootNode, physicsManagerAttributes);
+    {
+      ESP_STARTUP_SPAN("ResourceManager::initPhysicsManager");
+      resourceManager_->initPhysicsManager(
+          physicsManager_, config_.enablePhysics, &rootNode,
+          physicsManagerAttributes);
+    }
+
+    // before the stage is instantiated, so that its lighting can be baked,
+    // see SimulatorConfiguration::bakeStaticLighting
+    resourceManager_->setLightSetup(gfx::getDefaultLights());
 
     std::vector<int> tempIDs{activeSceneID_, activeSemanticSceneID_};
     // Load scene
@@ -223,7 +455,13 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
     }
 
     const Magnum::Range3D& sceneBB = rootNode.computeCumulativeBB();
-    resourceManager_->setLightSetup(gfx::getDefaultLights());
+
+    if (config_.pbrImageBasedLighting) {
+      resourceManager_->loadImageBasedLighting(sceneGraph, sceneBB.center(),
+                                               stageFilename);
+    } else {
+      resourceManager_->removeImageBasedLighting();
+    }
 
     // set activeSemanticSceneID_ values and push onto sceneID vector if
     // appropriate - tempIDs[1] will either be old activeSemanticSceneID_ (if
@@ -250,38 +488,231 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
         }
       }
     }  // if ID has changed - needs to be reset
-  }    // if (config_.createRenderer)
 
-  semanticScene_ = nullptr;
-  semanticScene_ = scene::SemanticScene::create();
-  switch (stageType) {
-    case assets::AssetType::INSTANCE_MESH:
-      houseFilename = Cr::Utility::Directory::join(
-          Cr::Utility::Directory::path(houseFilename), "info_semantic.json");
-      if (io::exists(houseFilename)) {
-        scene::SemanticScene::loadReplicaHouse(houseFilename, *semanticScene_);
-      }
-      break;
-    case assets::AssetType::MP3D_MESH:
-      // TODO(msb) Fix AssetType determination logic.
-      if (io::exists(houseFilename)) {
-        using Corrade::Utility::String::endsWith;
-        if (endsWith(houseFilename, ".house")) {
-          scene::SemanticScene::loadMp3dHouse(houseFilename, *semanticScene_);
-        } else if (endsWith(houseFilename, ".scn")) {
-          scene::SemanticScene::loadGibsonHouse(houseFilename, *semanticScene_);
+    // the previous stages are no longer drawn, their assets are freed first
+    // if over budget
+    if (config_.assetCacheHostBudget || config_.assetCacheGpuBudget) {
+      for (const int sceneID : previousSceneIDs) {
+        if (sceneID != activeSceneID_ && sceneID != activeSemanticSceneID_) {
+          resourceManager_->deleteAssetInstances(
+              sceneManager_->getSceneGraph(sceneID).getRootNode());
         }
       }
-      break;
-    case assets::AssetType::SUNCG_SCENE:
-      scene::SemanticScene::loadSuncgHouse(stageFilename, *semanticScene_);
-      break;
-    default:
-      break;
+      resourceManager_->evictUnusedAssets();
+    }
+  }  // if (config_.createRenderer)
+
+  semanticScene_ = nullptr;
+  if (prefetched.semanticScene) {
+    semanticScene_ = std::move(prefetched.semanticScene);
+  } else {
+    semanticScene_ = loadSemanticScene(stageType, houseFilename, stageFilename,
+                                       config_.semanticSceneCacheDirectory);
   }
 
   reset();
-}  // Simulator::reconfigure
+  return true;
+}  // Simulator::reconfigureInternal
+
+bool Simulator::describePrefetch(const SimulatorConfiguration& cfg,
+                                 metadata::MetadataMediator& metadataMediator,
+                                 PrefetchedScene& prefetched,
+                                 assets::AssetType& stageType,
+                                 std::vector<std::string>& assetFilenames) {
+  auto stageAttributes =
+      metadataMediator.getStageAttributesManager()->createObject(
+          cfg.activeSceneID, false);
+  if (!stageAttributes) {
+    return false;
+  }
+  prefetched.stageFilename = cfg.activeSceneID;
+  prefetched.navmeshFilename = stageAttributes->getNavmeshAssetHandle();
+  prefetched.houseFilename = stageAttributes->getHouseFilename();
+  stageType =
+      static_cast<assets::AssetType>(stageAttributes->getRenderAssetType());
+  assetFilenames = {stageAttributes->getRenderAssetHandle()};
+  if (cfg.loadSemanticMesh) {
+    assetFilenames.push_back(stageAttributes->getSemanticAssetHandle());
+  }
+  return true;
+}
+
+void Simulator::loadPrefetch(PrefetchedScene& prefetched,
+                             assets::AssetType stageType,
+                             const std::vector<std::string>& assetFilenames,
+                             const std::string& semanticSceneCacheDirectory) {
+  for (const std::string& filename : assetFilenames) {
+    if (io::exists(filename)) {
+      warmFileCache(filename);
+    }
+  }
+  prefetched.pathfinder = loadPathFinder(prefetched.navmeshFilename);
+  prefetched.semanticScene =
+      loadSemanticScene(stageType, prefetched.houseFilename,
+                        prefetched.stageFilename, semanticSceneCacheDirectory);
+}
+
+std::map<std::string, Simulator::PrefetchedScene>&
+Simulator::preloadedScenes() {
+  static std::map<std::string, PrefetchedScene> scenes;
+  return scenes;
+}
+
+void Simulator::prefetchScene(const SimulatorConfiguration& cfg) {
+  if (!metadataMediator_ || metadataMediator_->getActiveSceneDatasetName() !=
+                                cfg.sceneDatasetConfigFile) {
+    LOG(WARNING) << "Simulator::prefetchScene(): only stages of the active "
+                    "scene dataset can be prefetched, skipping "
+                 << cfg.activeSceneID;
+    return;
+  }
+
+  // the metadata managers aren't thread-safe, resolve the file names here
+  PrefetchedScene prefetched;
+  assets::AssetType stageType;
+  std::vector<std::string> assetFilenames;
+  if (!describePrefetch(cfg, *metadataMediator_, prefetched, stageType,
+                        assetFilenames)) {
+    return;
+  }
+
+  if (!prefetchThread_) {
+    prefetchThread_ = std::make_unique<core::ThreadPool>(1);
+  }
+  const std::string semanticSceneCacheDirectory =
+      cfg.semanticSceneCacheDirectory;
+  prefetchedScene_ = prefetchThread_->submit(
+      [prefetched, stageType, assetFilenames,
+       semanticSceneCacheDirectory]() mutable {
+        loadPrefetch(prefetched, stageType, assetFilenames,
+                     semanticSceneCacheDirectory);
+        return prefetched;
+      });
+}
+
+void Simulator::preloadScene(const SimulatorConfiguration& cfg,
+                             metadata::MetadataMediator& metadataMediator) {
+  metadataMediator.setActiveSceneDatasetName(cfg.sceneDatasetConfigFile);
+  PrefetchedScene prefetched;
+  assets::AssetType stageType;
+  std::vector<std::string> assetFilenames;
+  if (!describePrefetch(cfg, metadataMediator, prefetched, stageType,
+                        assetFilenames)) {
+    LOG(WARNING) << "Simulator::preloadScene(): no stage " << cfg.activeSceneID
+                 << " in the scene dataset " << cfg.sceneDatasetConfigFile;
+    return;
+  }
+  loadPrefetch(prefetched, stageType, assetFilenames,
+               cfg.semanticSceneCacheDirectory);
+  preloadedScenes()[cfg.activeSceneID] = std::move(prefetched);
+}
+
+void Simulator::clearPreloadedScenes() {
+  preloadedScenes().clear();
+}
+
+Simulator::ptr Simulator::fork() const {
+  if (activeSceneID_ == ID_UNDEFINED) {
+    throw std::runtime_error(
+        "Simulator::fork(): the simulator isn't configured");
+  }
+  if (config_.enableGfxReplaySave) {
+    throw std::runtime_error(
+        "Simulator::fork(): forking while recording gfx replays is not "
+        "supported");
+  }
+
+  Simulator::ptr forked{new Simulator{}};
+  forked->metadataMediator_ = metadataMediator_;
+  forked->resourceManager_ = resourceManager_;
+  forked->context_ = context_;
+  forked->renderer_ = renderer_;
+  forked->config_ = config_;
+  forked->requiresTextures_ = requiresTextures_;
+  forked->random_ = core::Random::create(*random_);
+  forked->pathfinder_ = pathfinder_;
+  forked->semanticScene_ = semanticScene_;
+  forked->frustumCulling_ = frustumCulling_;
+  forked->occlusionCulling_ = occlusionCulling_;
+
+  forked->sceneManager_ = scene::SceneManager::create_unique();
+  forked->activeSceneID_ = forked->sceneManager_->initSceneGraph();
+  forked->sceneID_.push_back(forked->activeSceneID_);
+
+  if (config_.createRenderer) {
+    forked->reconfigureReplayManager();
+
+    auto& sceneGraph = forked->getActiveSceneGraph();
+    auto physicsManagerAttributes =
+        physicsManager_->getInitializationAttributes();
+    resourceManager_->initPhysicsManager(
+        forked->physicsManager_, config_.enablePhysics,
+        &sceneGraph.getRootNode(), physicsManagerAttributes);
+
+    // the stage assets are loaded already, this only instances them
+    std::vector<int> tempIDs{forked->activeSceneID_, ID_UNDEFINED};
+    const auto stageAttributes = physicsManager_->getStageInitAttributes();
+    if (!resourceManager_->loadStage(
+            stageAttributes, forked->physicsManager_,
+            forked->sceneManager_.get(), tempIDs, config_.loadSemanticMesh,
+            config_.forceSeparateSemanticSceneGraph)) {
+      throw std::runtime_error("Simulator::fork(): cannot instance " +
+                               stageAttributes->getHandle());
+    }
+    forked->activeSemanticSceneID_ = tempIDs[1];
+    if (forked->activeSemanticSceneID_ != ID_UNDEFINED &&
+        forked->activeSemanticSceneID_ != forked->activeSceneID_) {
+      forked->sceneID_.push_back(forked->activeSemanticSceneID_);
+    }
+
+    physics::PhysicsManager& forkedPhysics = *forked->physicsManager_;
+    forkedPhysics.setGravity(physicsManager_->getGravity());
+    forkedPhysics.setTimestep(physicsManager_->getTimestep());
+    forkedPhysics.setMaxSubsteps(physicsManager_->getMaxSubsteps());
+    forkedPhysics.setSkipIfBehind(physicsManager_->getSkipIfBehind());
+    forkedPhysics.setRenderInterpolation(
+        physicsManager_->getRenderInterpolation());
+    forkedPhysics.addObjectsOf(*physicsManager_, &sceneGraph.getDrawables());
+    forkedPhysics.deserializeState(physicsManager_->serializeState());
+  }
+
+  for (const auto& agent : agents_) {
+    agent::Agent::ptr forkedAgent = forked->addAgent(agent->getConfig());
+    auto state = agent::AgentState::create();
+    agent->getState(state);
+    forkedAgent->setState(*state, false);
+  }
+
+  return forked;
+}
+
+Simulator::ptr Simulator::createSibling(
+    const SimulatorConfiguration& cfg) const {
+  if (activeSceneID_ == ID_UNDEFINED) {
+    throw std::runtime_error(
+        "Simulator::createSibling(): the simulator isn't configured");
+  }
+  if (cfg.sceneDatasetConfigFile != config_.sceneDatasetConfigFile) {
+    throw std::runtime_error(
+        "Simulator::createSibling(): expected a scene of the dataset " +
+        config_.sceneDatasetConfigFile + ", got " + cfg.sceneDatasetConfigFile);
+  }
+  if (config_.enableGfxReplaySave || cfg.enableGfxReplaySave) {
+    throw std::runtime_error(
+        "Simulator::createSibling(): siblings recording gfx replays are not "
+        "supported");
+  }
+
+  Simulator::ptr sibling{new Simulator{}};
+  sibling->metadataMediator_ = metadataMediator_;
+  sibling->resourceManager_ = resourceManager_;
+  sibling->context_ = context_;
+  sibling->renderer_ = renderer_;
+  sibling->requiresTextures_ = requiresTextures_;
+  sibling->random_ = core::Random::create(cfg.randomSeed);
+  sibling->reconfigure(cfg);
+  return sibling;
+}
 
 void Simulator::reset() {
   if (physicsManager_ != nullptr) {
@@ -297,6 +728,55 @@ void Simulator::reset() {
   resourceManager_->setLightSetup(gfx::getDefaultLights());
 }  // Simulator::reset()
 
+bool Simulator::isStageReloadRequired(
+    const SimulatorConfiguration& cfg) const {
+  return activeSceneID_ == ID_UNDEFINED || requiresStageReload(config_, cfg);
+}
+
+bool Simulator::loadStreamedFiles() {
+  const bool loadedTextures = resourceManager_->loadStreamedFiles() > 0;
+  return loadStreamedNavMesh() || loadedTextures;
+}
+
+bool Simulator::hasPendingFiles() const {
+  return resourceManager_->hasPendingFiles() ||
+         !pendingNavmeshFilename_.empty();
+}
+
+bool Simulator::loadStreamedNavMesh() {
+  if (pendingNavmeshFilename_.empty()) {
+    return false;
+  }
+  assets::FileProvider& provider = *config_.fileProvider;
+  const std::string& filename = pendingNavmeshFilename_;
+  bool loaded = false;
+  switch (provider.request(filename)) {
+    case assets::FileProvider::Status::Pending:
+      return false;
+    case assets::FileProvider::Status::Available: {
+      // the tiles reference the data, which the provider may free
+      const Cr::Containers::ArrayView<const char> view =
+          provider.data(filename);
+      Cr::Containers::Array<char> data{Cr::Containers::NoInit, view.size()};
+      Cr::Utility::copy(view, data);
+      provider.release(filename);
+      loaded = pathfinder_->loadNavMeshData(std::move(data));
+      break;
+    }
+    case assets::FileProvider::Status::Unavailable:
+      loaded = io::exists(filename) && pathfinder_->loadNavMesh(filename);
+      break;
+  }
+  if (loaded) {
+    LOG(INFO) << "Loaded the streamed navmesh " << filename;
+    refreshNavMeshVisualization(*pathfinder_);
+  } else {
+    LOG(WARNING) << "Cannot load the streamed navmesh " << filename;
+  }
+  pendingNavmeshFilename_.clear();
+  return loaded;
+}
+
 void Simulator::seed(uint32_t newSeed) {
   random_->seed(newSeed);
   pathfinder_->seed(newSeed);
@@ -389,6 +869,32 @@ std::vector<int> Simulator::getExistingObjectIDs(const int sceneID) {
   return std::vector<int>();  // empty if no simulator exists
 }
 
+void Simulator::setObjectPoolSize(const int size, const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->setObjectPoolSize(size);
+  }
+}
+
+int Simulator::getObjectPoolSize(const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->getObjectPoolSize();
+  }
+  return 0;
+}
+
+int Simulator::getNumPooledObjects(const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->getNumPooledObjects();
+  }
+  return 0;
+}
+
+void Simulator::clearObjectPool(const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->clearObjectPool();
+  }
+}
+
 // remove object objectID instance in sceneID
 void Simulator::removeObject(const int objectID,
                              bool deleteObjectNode,
@@ -578,127 +1084,718 @@ Magnum::Vector3 Simulator::getAngularVelocity(const int objectID,
   return Magnum::Vector3();
 }
 
-bool Simulator::contactTest(const int objectID, const int sceneID) {
+void Simulator::getRigidStates(
+    Cr::Containers::ArrayView<const int> objectIDs,
+    Cr::Containers::ArrayView<Magnum::Vector3> translations,
+    Cr::Containers::ArrayView<Magnum::Quaternion> rotations,
+    const int sceneID) const {
   if (sceneHasPhysics(sceneID)) {
-    return physicsManager_->contactTest(objectID);
+    physicsManager_->getRigidStates(objectIDs, translations, rotations);
+    return;
   }
-  return false;
+  std::fill(translations.begin(), translations.end(), Magnum::Vector3());
+  std::fill(rotations.begin(), rotations.end(), Magnum::Quaternion());
 }
 
-esp::physics::RaycastResults Simulator::castRay(const esp::geo::Ray& ray,
-                                                float maxDistance,
-                                                const int sceneID) {
+void Simulator::setRigidStates(
+    Cr::Containers::ArrayView<const int> objectIDs,
+    Cr::Containers::ArrayView<const Magnum::Vector3> translations,
+    Cr::Containers::ArrayView<const Magnum::Quaternion> rotations,
+    const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
-    return physicsManager_->castRay(ray, maxDistance);
+    physicsManager_->setRigidStates(objectIDs, translations, rotations);
   }
-  return esp::physics::RaycastResults();
 }
 
-void Simulator::setObjectBBDraw(bool drawBB,
-                                const int objectID,
-                                const int sceneID) {
+void Simulator::getVelocities(
+    Cr::Containers::ArrayView<const int> objectIDs,
+    Cr::Containers::ArrayView<Magnum::Vector3> linVels,
+    Cr::Containers::ArrayView<Magnum::Vector3> angVels,
+    const int sceneID) const {
   if (sceneHasPhysics(sceneID)) {
-    auto& sceneGraph_ = sceneManager_->getSceneGraph(activeSceneID_);
-    auto& drawables = sceneGraph_.getDrawables();
-    physicsManager_->setObjectBBDraw(objectID, &drawables, drawBB);
+    physicsManager_->getVelocities(objectIDs, linVels, angVels);
+    return;
   }
+  std::fill(linVels.begin(), linVels.end(), Magnum::Vector3());
+  std::fill(angVels.begin(), angVels.end(), Magnum::Vector3());
 }
 
-void Simulator::setObjectSemanticId(uint32_t semanticId,
-                                    const int objectID,
-                                    const int sceneID) {
+void Simulator::setVelocities(
+    Cr::Containers::ArrayView<const int> objectIDs,
+    Cr::Containers::ArrayView<const Magnum::Vector3> linVels,
+    Cr::Containers::ArrayView<const Magnum::Vector3> angVels,
+    const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
-    physicsManager_->setSemanticId(objectID, semanticId);
+    physicsManager_->setVelocities(objectIDs, linVels, angVels);
   }
 }
 
-double Simulator::stepWorld(const double dt) {
-  if (physicsManager_ != nullptr) {
-    physicsManager_->stepPhysics(dt);
+int Simulator::savePhysicsState(const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->saveState();
   }
-  return getWorldTime();
+  return ID_UNDEFINED;
 }
 
-// get the simulated world time (0 if no physics enabled)
-double Simulator::getWorldTime() {
-  if (physicsManager_ != nullptr) {
-    return physicsManager_->getWorldTime();
+bool Simulator::restorePhysicsState(const int handle, const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->restoreState(handle);
   }
-  return NO_TIME;
+  return false;
 }
 
-void Simulator::setGravity(const Magnum::Vector3& gravity, const int sceneID) {
+bool Simulator::removePhysicsState(const int handle, const int sceneID) {
   if (sceneHasPhysics(sceneID)) {
-    physicsManager_->setGravity(gravity);
+    return physicsManager_->removeState(handle);
   }
+  return false;
 }
 
-Magnum::Vector3 Simulator::getGravity(const int sceneID) const {
+std::string Simulator::serializePhysicsState(const int sceneID) const {
   if (sceneHasPhysics(sceneID)) {
-    return physicsManager_->getGravity();
+    return physicsManager_->serializeState();
   }
-  return Magnum::Vector3();
+  return {};
 }
 
-bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
-                                 const nav::NavMeshSettings& navMeshSettings,
-                                 bool includeStaticObjects) {
-  CORRADE_ASSERT(config_.createRenderer,
-                 "Simulator::recomputeNavMesh: "
-                 "SimulatorConfiguration::createRenderer is "
-                 "false. Scene geometry is required to recompute navmesh. No "
-                 "geometry is "
-                 "loaded without renderer initialization.",
-                 false);
-
-  assets::MeshData::uptr joinedMesh = assets::MeshData::create_unique();
-  auto stageInitAttrs = physicsManager_->getStageInitAttributes();
-  if (stageInitAttrs != nullptr) {
-    joinedMesh = resourceManager_->createJoinedCollisionMesh(
-        stageInitAttrs->getRenderAssetHandle());
+std::uint64_t Simulator::getPhysicsStateChecksum(const int sceneID) const {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->getStateChecksum();
   }
+  return 0;
+}
 
-  // add STATIC collision objects
-  if (includeStaticObjects) {
-    for (auto objectID : physicsManager_->getExistingObjectIDs()) {
-      if (physicsManager_->getObjectMotionType(objectID) ==
-          physics::MotionType::STATIC) {
-        auto objectTransform = Magnum::EigenIntegration::cast<
-            Eigen::Transform<float, 3, Eigen::Affine> >(
-            physicsManager_->getObjectVisualSceneNode(objectID)
-                .absoluteTransformationMatrix());
-        const metadata::attributes::ObjectAttributes::cptr
-            initializationTemplate =
-                physicsManager_->getObjectInitAttributes(objectID);
-        objectTransform.scale(Magnum::EigenIntegration::cast<vec3f>(
-            initializationTemplate->getScale()));
-        std::string meshHandle =
-            initializationTemplate->getCollisionAssetHandle();
-        if (meshHandle.empty()) {
-          meshHandle = initializationTemplate->getRenderAssetHandle();
-        }
-        assets::MeshData::uptr joinedObjectMesh =
-            resourceManager_->createJoinedCollisionMesh(meshHandle);
-        int prevNumIndices = joinedMesh->ibo.size();
-        int prevNumVerts = joinedMesh->vbo.size();
-        joinedMesh->ibo.resize(prevNumIndices + joinedObjectMesh->ibo.size());
-        for (size_t ix = 0; ix < joinedObjectMesh->ibo.size(); ++ix) {
-          joinedMesh->ibo[ix + prevNumIndices] =
-              joinedObjectMesh->ibo[ix] + prevNumVerts;
-        }
-        joinedMesh->vbo.reserve(joinedObjectMesh->vbo.size() + prevNumVerts);
-        for (auto& vert : joinedObjectMesh->vbo) {
-          joinedMesh->vbo.push_back(objectTransform * vert);
-        }
-      }
-    }
+bool Simulator::deserializePhysicsState(const std::string& state,
+                                        const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->deserializeState(state);
   }
+  return false;
+}
 
-  if (!pathfinder.build(navMeshSettings, *joinedMesh)) {
+namespace {
+
+constexpr char CheckpointMagic[8] = {'e', 's', 'p', 'c', 'k', 'p', 't', '\0'};
+constexpr std::uint32_t CheckpointVersion = 1;
+
+struct CheckpointTransformation {
+  float translation[3];
+  float rotation[4];
+};
+
+template <class T>
+void appendValue(std::string& out, const T& value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// a section of bytes, prefixed by its size
+void appendSection(std::string& out, const std::string& section) {
+  appendValue(out, std::uint64_t(section.size()));
+  out.append(section);
+}
+
+// reads the values and sections appended above in order, failing once
+// the data runs out
+class CheckpointReader {
+ public:
+  explicit CheckpointReader(Cr::Containers::ArrayView<const char> data)
+      : data_{data} {}
+
+  template <class T>
+  bool read(T& value) {
+    if (data_.size() - offset_ < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool readSection(std::string& section) {
+    std::uint64_t size = 0;
+    if (!read(size) || data_.size() - offset_ < size) {
+      return false;
+    }
+    section.assign(data_.data() + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  bool atEnd() const { return offset_ == data_.size(); }
+
+ private:
+  Cr::Containers::ArrayView<const char> data_;
+  std::size_t offset_ = 0;
+};
+
+CheckpointTransformation checkpointTransformation(
+    const scene::SceneNode& node) {
+  CheckpointTransformation transformation{};
+  Mn::Vector3::from(transformation.translation) = node.translation();
+  const Mn::Quaternion rotation = node.rotation();
+  Mn::Vector3::from(transformation.rotation) = rotation.vector();
+  transformation.rotation[3] = rotation.scalar();
+  return transformation;
+}
+
+}  // namespace
+
+bool Simulator::saveCheckpoint(const std::string& path,
+                               const std::string& userData) {
+  std::string checkpoint(CheckpointMagic, sizeof(CheckpointMagic));
+  appendValue(checkpoint, CheckpointVersion);
+  appendSection(checkpoint, config_.sceneDatasetConfigFile);
+  appendSection(checkpoint, config_.activeSceneID);
+  appendSection(checkpoint, physicsManager_
+                                ? physicsManager_->serializeObjectInstances()
+                                : std::string{});
+  appendSection(checkpoint, physicsManager_ ? physicsManager_->serializeState()
+                                            : std::string{});
+
+  std::string agents;
+  appendValue(agents, std::uint32_t(agents_.size()));
+  for (const auto& agent : agents_) {
+    appendValue(agents, checkpointTransformation(agent->node()));
+    auto& sensors = agent->getSensorSuite().getSensors();
+    appendValue(agents, std::uint32_t(sensors.size()));
+    for (const auto& sensor : sensors) {
+      appendSection(agents, sensor.first);
+      appendValue(agents, checkpointTransformation(sensor.second->node()));
+    }
+  }
+  appendSection(checkpoint, agents);
+
+  appendValue(checkpoint, random_->state());
+  appendValue(checkpoint, pathfinder_->getRandomState());
+
+  // the navmesh is saved through a file, its islands are written to one
+  std::string navMesh;
+  if (navMeshModified_ && pathfinder_->isLoaded()) {
+    const std::string navMeshPath = path + ".navmesh.tmp";
+    if (!pathfinder_->saveNavMesh(navMeshPath)) {
+      LOG(ERROR) << "Simulator::saveCheckpoint : cannot write "
+                 << navMeshPath;
+      return false;
+    }
+    const Cr::Containers::Array<char> data = core::mapFile(navMeshPath);
+    navMesh.assign(data.data(), data.size());
+    Cr::Utility::Directory::rm(navMeshPath);
+  }
+  appendSection(checkpoint, navMesh);
+  appendSection(checkpoint, userData);
+
+  return core::writeFileAtomically(path,
+                                   {checkpoint.data(), checkpoint.size()});
+}
+
+bool Simulator::loadCheckpoint(const std::string& path,
+                               std::string* userData) {
+  const Cr::Containers::Array<char> data = core::mapFile(path);
+  CheckpointReader reader{data};
+  char magic[sizeof(CheckpointMagic)];
+  std::uint32_t version = 0;
+  std::string dataset, sceneID, objectInstances, physicsState, agents,
+      navMesh, storedUserData;
+  core::Random::State randomState{}, pathfinderRandomState{};
+  if (!reader.read(magic) ||
+      std::memcmp(magic, CheckpointMagic, sizeof(magic)) != 0 ||
+      !reader.read(version) || version != CheckpointVersion ||
+      !reader.readSection(dataset) || !reader.readSection(sceneID) ||
+      !reader.readSection(objectInstances) ||
+      !reader.readSection(physicsState) || !reader.readSection(agents) ||
+      !reader.read(randomState) || !reader.read(pathfinderRandomState) ||
+      !reader.readSection(navMesh) || !reader.readSection(storedUserData) ||
+      !reader.atEnd()) {
+    LOG(ERROR) << "Simulator::loadCheckpoint : " << path
+               << " is not a checkpoint of this version";
+    return false;
+  }
+  if (dataset != config_.sceneDatasetConfigFile ||
+      sceneID != config_.activeSceneID) {
+    LOG(ERROR) << "Simulator::loadCheckpoint : " << path
+               << " is a checkpoint of the scene " << sceneID
+               << " of the dataset " << dataset;
+    return false;
+  }
+
+  // the agents are checked before anything changes
+  CheckpointReader agentReader{{agents.data(), agents.size()}};
+  std::uint32_t agentCount = 0;
+  if (!agentReader.read(agentCount) || agentCount != agents_.size()) {
+    LOG(ERROR) << "Simulator::loadCheckpoint : " << path
+               << " has other agents";
+    return false;
+  }
+  struct SensorState {
+    std::string uuid;
+    CheckpointTransformation transformation;
+  };
+  std::vector<CheckpointTransformation> agentStates(agentCount);
+  std::vector<std::vector<SensorState>> sensorStates(agentCount);
+  for (std::uint32_t i = 0; i != agentCount; ++i) {
+    std::uint32_t sensorCount = 0;
+    if (!agentReader.read(agentStates[i]) || !agentReader.read(sensorCount)) {
+      LOG(ERROR) << "Simulator::loadCheckpoint : " << path
+                 << " is malformed";
+      return false;
+    }
+    auto& sensors = agents_[i]->getSensorSuite().getSensors();
+    if (sensorCount != sensors.size()) {
+      LOG(ERROR) << "Simulator::loadCheckpoint : " << path
+                 << " has other sensors on agent " << i;
+      return false;
+    }
+    sensorStates[i].resize(sensorCount);
+    for (SensorState& sensor : sensorStates[i]) {
+      if (!agentReader.readSection(sensor.uuid) ||
+          !agentReader.read(sensor.transformation) ||
+          !sensors.count(sensor.uuid)) {
+        LOG(ERROR) << "Simulator::loadCheckpoint : " << path
+                   << " has other sensors on agent " << i;
+        return false;
+      }
+    }
+  }
+
+  bool success = true;
+  if (physicsManager_ && !objectInstances.empty()) {
+    // the state isn't restored if objects are missing
+    success = physicsManager_->deserializeObjectInstances(
+                  objectInstances, &getActiveSceneGraph().getDrawables()) &&
+              physicsManager_->deserializeState(physicsState);
+  }
+
+  const auto setTransformation =
+      [](scene::SceneNode& node,
+         const CheckpointTransformation& transformation) {
+        node.setTranslation(Mn::Vector3::from(transformation.translation));
+        node.setRotation(Mn::Quaternion{
+            Mn::Vector3::from(transformation.rotation),
+            transformation.rotation[3]});
+      };
+  for (std::uint32_t i = 0; i != agentCount; ++i) {
+    setTransformation(agents_[i]->node(), agentStates[i]);
+    auto& sensors = agents_[i]->getSensorSuite().getSensors();
+    for (const SensorState& sensor : sensorStates[i]) {
+      setTransformation(sensors.at(sensor.uuid)->node(),
+                        sensor.transformation);
+    }
+  }
+
+  random_->setState(randomState);
+  pathfinder_->setRandomState(pathfinderRandomState);
+
+  if (!navMesh.empty()) {
+    Cr::Containers::Array<char> navMeshData{Cr::Containers::NoInit,
+                                            navMesh.size()};
+    std::memcpy(navMeshData.data(), navMesh.data(), navMesh.size());
+    if (pathfinder_->loadNavMeshData(std::move(navMeshData))) {
+      navMeshModified_ = true;
+      refreshNavMeshVisualization(*pathfinder_);
+    } else {
+      LOG(ERROR) << "Simulator::loadCheckpoint : cannot load the navmesh of "
+                 << path;
+      success = false;
+    }
+  }
+  if (userData) {
+    *userData = std::move(storedUserData);
+  }
+  return success;
+}
+
+bool Simulator::contactTest(const int objectID, const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->contactTest(objectID);
+  }
+  return false;
+}
+
+esp::physics::RaycastResults Simulator::castRay(const esp::geo::Ray& ray,
+                                                float maxDistance,
+                                                const int sceneID,
+                                                bool closestHitOnly,
+                                                int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->castRay(ray, maxDistance, closestHitOnly,
+                                    collisionFilterMask);
+  }
+  return esp::physics::RaycastResults();
+}
+
+esp::physics::MultiRaycastResults Simulator::castRays(
+    const std::vector<esp::geo::Ray>& rays,
+    float maxDistance,
+    bool closestHitOnly,
+    const int sceneID,
+    int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->castRays(rays, maxDistance, closestHitOnly,
+                                     collisionFilterMask);
+  }
+  esp::physics::MultiRaycastResults results;
+  results.hitOffsets.resize(rays.size() + 1, 0);
+  return results;
+}
+
+std::vector<int> Simulator::overlapAabb(const Magnum::Range3D& aabb,
+                                        const int sceneID,
+                                        const int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->overlapAabb(aabb, collisionFilterMask);
+  }
+  return {};
+}
+
+std::vector<int> Simulator::overlapSphere(const Magnum::Vector3& center,
+                                          const float radius,
+                                          const int sceneID,
+                                          const int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->overlapSphere(center, radius, collisionFilterMask);
+  }
+  return {};
+}
+
+std::vector<int> Simulator::overlapObb(const esp::geo::OBB& obb,
+                                       const int sceneID,
+                                       const int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->overlapObb(obb, collisionFilterMask);
+  }
+  return {};
+}
+
+std::vector<bool> Simulator::contactTests(const std::vector<int>& objectIDs,
+                                          const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->contactTests(objectIDs);
+  }
+  return std::vector<bool>(objectIDs.size(), false);
+}
+
+std::vector<bool> Simulator::testPlacements(
+    const int objectID,
+    const std::vector<Magnum::Matrix4>& transformations,
+    const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->testPlacements(objectID, transformations);
+  }
+  return std::vector<bool>(transformations.size(), false);
+}
+
+std::vector<bool> Simulator::testPlacements(
+    const std::string& objectLibHandle,
+    const std::vector<Mn::Matrix4>& transformations,
+    const int sceneID) {
+  if (!sceneHasPhysics(sceneID)) {
+    return std::vector<bool>(transformations.size(), false);
+  }
+  const int objectID = addObjectByHandle(
+      objectLibHandle, nullptr, DEFAULT_LIGHTING_KEY, sceneID);
+  if (objectID == ID_UNDEFINED) {
+    LOG(ERROR) << "Simulator::testPlacements : cannot instance "
+               << objectLibHandle;
+    return std::vector<bool>(transformations.size(), false);
+  }
+  std::vector<bool> collisions =
+      physicsManager_->testPlacements(objectID, transformations);
+  removeObject(objectID, true, true, sceneID);
+  return collisions;
+}
+
+esp::physics::SweepResult Simulator::sweepObject(
+    const int objectID,
+    const Magnum::Matrix4& from,
+    const Magnum::Vector3& to,
+    const int sceneID,
+    const int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->sweepObject(objectID, from, to,
+                                        collisionFilterMask);
+  }
+  return {};
+}
+
+std::vector<esp::physics::SweepResult> Simulator::sweepObjectBatch(
+    const int objectID,
+    const std::vector<Magnum::Matrix4>& from,
+    const std::vector<Magnum::Vector3>& to,
+    const int sceneID,
+    const int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->sweepObjectBatch(objectID, from, to,
+                                             collisionFilterMask);
+  }
+  return std::vector<esp::physics::SweepResult>(from.size());
+}
+
+esp::physics::SweepResult Simulator::sweepCapsule(
+    const float radius,
+    const float height,
+    const Magnum::Vector3& from,
+    const Magnum::Vector3& to,
+    const int sceneID,
+    const int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->sweepCapsule(radius, height, from, to,
+                                         collisionFilterMask);
+  }
+  return {};
+}
+
+std::vector<esp::physics::SweepResult> Simulator::sweepCapsuleBatch(
+    const float radius,
+    const float height,
+    const std::vector<Magnum::Vector3>& from,
+    const std::vector<Magnum::Vector3>& to,
+    const int sceneID,
+    const int collisionFilterMask) {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->sweepCapsuleBatch(radius, height, from, to,
+                                              collisionFilterMask);
+  }
+  return std::vector<esp::physics::SweepResult>(from.size());
+}
+
+std::vector<Mn::Vector3> Simulator::collideAgentMoves(
+    const std::vector<Mn::Vector3>& starts,
+    const std::vector<Mn::Vector3>& ends) {
+  if (!config_.kinematicAgentCollisions || !physicsManager_) {
+    return ends;
+  }
+  physics::KinematicCharacterController::Configuration collisions;
+  collisions.radius = config_.agentCollisionRadius;
+  collisions.height = config_.agentCollisionHeight;
+  collisions.allowSliding = config_.allowSliding;
+  return physics::KinematicCharacterController{collisions}.moveBatch(
+      *physicsManager_, starts, ends);
+}
+
+void Simulator::setObjectBBDraw(bool drawBB,
+                                const int objectID,
+                                const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    auto& sceneGraph_ = sceneManager_->getSceneGraph(activeSceneID_);
+    auto& drawables = sceneGraph_.getDrawables();
+    physicsManager_->setObjectBBDraw(objectID, &drawables, drawBB);
+  }
+}
+
+void Simulator::setObjectSemanticId(uint32_t semanticId,
+                                    const int objectID,
+                                    const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->setSemanticId(objectID, semanticId);
+  }
+}
+
+bool Simulator::setSemanticObjectHidden(uint32_t semanticObjectId,
+                                        bool hidden) {
+  // the instance mesh may be in the scene graph of the semantic sensors, or
+  // be the stage itself
+  std::vector<int> sceneIDs{activeSceneID_};
+  if (activeSemanticSceneID_ != activeSceneID_) {
+    sceneIDs.push_back(activeSemanticSceneID_);
+  }
+  std::size_t count = 0;
+  for (const int sceneID : sceneIDs) {
+    if (sceneID == ID_UNDEFINED) {
+      continue;
+    }
+    gfx::DrawableGroup& drawables =
+        sceneManager_->getSceneGraph(sceneID).getDrawables();
+    for (std::size_t i = 0; i < drawables.size(); ++i) {
+      if (auto* drawable = dynamic_cast<gfx::Drawable*>(&drawables[i])) {
+        count += drawable->setSubmeshesHidden(semanticObjectId, hidden);
+      }
+    }
+  }
+  return count != 0;
+}
+
+double Simulator::stepWorld(const double dt) {
+  ESP_PROFILE_SCOPE("Simulator::stepWorld");
+  if (physicsManager_ != nullptr) {
+    {
+      ESP_PERF_TIMER(Physics);
+      physicsManager_->stepPhysics(dt);
+    }
+    core::PerfStats& perfStats = core::PerfStats::shared();
+    // counting the contacts walks the contact manifolds
+    if (perfStats.isEnabled()) {
+      const int numContacts = physicsManager_->getNumActiveContactPoints();
+      if (numContacts >= 0) {
+        perfStats.add(core::PerfStat::ActiveContactPoints, numContacts);
+      }
+    }
+  }
+  return getWorldTime();
+}
+
+std::vector<bool> Simulator::actBodies(
+    const std::vector<scene::SceneNode*>& bodies,
+    const std::vector<std::string>& actions,
+    const std::vector<float>& amounts) {
+  ESP_PROFILE_SCOPE("Simulator::actBodies");
+  if (actions.size() != bodies.size() || amounts.size() != bodies.size()) {
+    LOG(ERROR) << "Simulator::actBodies : got " << actions.size()
+               << " actions and " << amounts.size() << " amounts for "
+               << bodies.size() << " bodies";
+    return {};
+  }
+  std::vector<int> actionIds;
+  std::vector<core::RigidState> states;
+  actionIds.reserve(bodies.size());
+  states.reserve(bodies.size());
+  for (std::size_t i = 0; i < bodies.size(); ++i) {
+    if (agent::Agent::BodyActions.count(actions[i]) == 0) {
+      LOG(ERROR) << "Simulator::actBodies : " << actions[i]
+                 << " is not a body action";
+      return {};
+    }
+    actionIds.push_back(scene::ObjectControls::actionId(actions[i]));
+    states.emplace_back(bodies[i]->rotation(), bodies[i]->translation());
+  }
+
+  const bool collide = config_.kinematicAgentCollisions && physicsManager_;
+  const bool applyFilter = pathfinder_->isLoaded() || collide;
+  if (applyFilter) {
+    bodyControls_.setBatchMoveFilterFunction(
+        [this, collide](const std::vector<Mn::Vector3>& starts,
+                        const std::vector<Mn::Vector3>& ends) {
+          std::vector<Mn::Vector3> filtered =
+              !pathfinder_->isLoaded()
+                  ? ends
+                  : config_.allowSliding
+                        ? pathfinder_->tryStepBatch(starts, ends)
+                        : pathfinder_->tryStepNoSlidingBatch(starts, ends);
+          return collide ? collideAgentMoves(starts, filtered) : filtered;
+        });
+  }
+  std::vector<bool> collided =
+      bodyControls_.actionBatch(actionIds, amounts, states, applyFilter);
+  for (std::size_t i = 0; i < bodies.size(); ++i) {
+    bodies[i]->setTranslation(states[i].translation);
+    bodies[i]->setRotation(states[i].rotation);
+  }
+  return collided;
+}
+
+std::map<int, bool> Simulator::step(const std::map<int, std::string>& actions,
+                                    const double dt) {
+  ESP_PROFILE_SCOPE("Simulator::step");
+  std::map<int, bool> collided;
+  std::vector<int> bodyAgentIds;
+  std::vector<scene::SceneNode*> bodies;
+  std::vector<std::string> bodyActions;
+  std::vector<float> amounts;
+  for (const auto& action : actions) {
+    if (action.first < 0 || action.first >= int(agents_.size())) {
+      LOG(ERROR) << "Simulator::step : there is no agent " << action.first;
+      continue;
+    }
+    agent::Agent& agent = *agents_[action.first];
+    const agent::ActionSpace& actionSpace = agent.getConfig().actionSpace;
+    const auto found = actionSpace.find(action.second);
+    if (found == actionSpace.end()) {
+      LOG(ERROR) << "Simulator::step : agent " << action.first
+                 << " has no action " << action.second;
+      continue;
+    }
+    const agent::ActionSpec& spec = *found->second;
+    if (agent::Agent::BodyActions.count(spec.name) != 0) {
+      bodyAgentIds.push_back(action.first);
+      bodies.push_back(&agent.node());
+      bodyActions.push_back(spec.name);
+      amounts.push_back(spec.actuation.at("amount"));
+    } else {
+      agent.act(action.second);
+      collided[action.first] = false;
+    }
+  }
+
+  const std::vector<bool> bodyCollided =
+      actBodies(bodies, bodyActions, amounts);
+  for (std::size_t i = 0; i < bodyCollided.size(); ++i) {
+    collided[bodyAgentIds[i]] = bodyCollided[i];
+  }
+
+  stepWorld(dt);
+  return collided;
+}
+
+// get the simulated world time (0 if no physics enabled)
+double Simulator::getWorldTime() {
+  if (physicsManager_ != nullptr) {
+    return physicsManager_->getWorldTime();
+  }
+  return NO_TIME;
+}
+
+void Simulator::setGravity(const Magnum::Vector3& gravity, const int sceneID) {
+  if (sceneHasPhysics(sceneID)) {
+    physicsManager_->setGravity(gravity);
+  }
+}
+
+Magnum::Vector3 Simulator::getGravity(const int sceneID) const {
+  if (sceneHasPhysics(sceneID)) {
+    return physicsManager_->getGravity();
+  }
+  return Magnum::Vector3();
+}
+
+bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
+                                 const nav::NavMeshSettings& navMeshSettings,
+                                 bool includeStaticObjects) {
+  CORRADE_ASSERT(config_.createRenderer,
+                 "Simulator::recomputeNavMesh: "
+                 "SimulatorConfiguration::createRenderer is "
+                 "false. Scene geometry is required to recompute navmesh. No "
+                 "geometry is "
+                 "loaded without renderer initialization.",
+                 false);
+
+  assets::MeshData::uptr joinedMesh =
+      joinNavMeshGeometry(includeStaticObjects);
+  if (!pathfinder.build(navMeshSettings, *joinedMesh)) {
     LOG(ERROR) << "Failed to build navmesh";
     return false;
   }
+  refreshNavMeshVisualization(pathfinder);
+  navMeshModified_ |= &pathfinder == pathfinder_.get();
 
+  LOG(INFO) << "reconstruct navmesh successful";
+  return true;
+}
+
+bool Simulator::updateNavMesh(nav::PathFinder& pathfinder,
+                              const Mn::Vector3& regionMin,
+                              const Mn::Vector3& regionMax,
+                              bool includeStaticObjects) {
+  CORRADE_ASSERT(config_.createRenderer,
+                 "Simulator::updateNavMesh: "
+                 "SimulatorConfiguration::createRenderer is false. Scene "
+                 "geometry is required to update the navmesh.",
+                 false);
+
+  // joining is cheap next to rasterizing, which is limited to the region
+  assets::MeshData::uptr joinedMesh =
+      joinNavMeshGeometry(includeStaticObjects);
+  if (!pathfinder.rebuildTiles(*joinedMesh,
+                               Mn::EigenIntegration::cast<vec3f>(regionMin),
+                               Mn::EigenIntegration::cast<vec3f>(regionMax))) {
+    LOG(ERROR) << "Failed to update navmesh";
+    return false;
+  }
+  refreshNavMeshVisualization(pathfinder);
+  navMeshModified_ |= &pathfinder == pathfinder_.get();
+  return true;
+}
+
+void Simulator::refreshNavMeshVisualization(
+    const nav::PathFinder& pathfinder) {
   if (&pathfinder == pathfinder_.get()) {
     if (isNavMeshVisualizationActive()) {
       // if updating pathfinder_ instance, refresh the visualization.
@@ -706,9 +1803,177 @@ bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
       setNavMeshVisualization(true);
     }
   }
+}
 
-  LOG(INFO) << "reconstruct navmesh successful";
-  return true;
+namespace {
+// The meshes joined by joinNavMeshGeometry() are split in chunks of this many
+// vertices and indices, so that a large stage is spread over the threads too
+const std::size_t JOIN_CHUNK_SIZE = 1 << 16;
+}  // namespace
+
+assets::MeshData::uptr Simulator::joinNavMeshGeometry(
+    bool includeStaticObjects) {
+  ESP_PROFILE_SCOPE("Simulator::joinNavMeshGeometry");
+  // the cached meshes of the stage and the STATIC collision objects, where
+  // they go in the joined mesh and how they're transformed to get there
+  struct Part {
+    assets::MeshData::cptr mesh;
+    Magnum::Matrix4 transform;
+    std::size_t firstVertex;
+    std::size_t firstIndex;
+  };
+  std::vector<Part> parts;
+  auto stageInitAttrs = physicsManager_->getStageInitAttributes();
+  if (stageInitAttrs != nullptr) {
+    parts.push_back({resourceManager_->getJoinedCollisionMesh(
+                         stageInitAttrs->getRenderAssetHandle()),
+                     Magnum::Matrix4{}, 0, 0});
+  }
+  if (includeStaticObjects) {
+    for (auto objectID : physicsManager_->getExistingObjectIDs()) {
+      if (physicsManager_->getObjectMotionType(objectID) ==
+          physics::MotionType::STATIC) {
+        Part part{nullptr, {}, 0, 0};
+        part.mesh = getObjectCollisionMesh(objectID, part.transform);
+        parts.push_back(std::move(part));
+      }
+    }
+  }
+
+  // sized once, then filled by all threads, each chunk writing its own range
+  struct Chunk {
+    std::size_t part;
+    std::size_t begin;
+  };
+  std::vector<Chunk> chunks;
+  std::size_t numVertices = 0;
+  std::size_t numIndices = 0;
+  for (std::size_t iPart = 0; iPart != parts.size(); ++iPart) {
+    Part& part = parts[iPart];
+    part.firstVertex = numVertices;
+    part.firstIndex = numIndices;
+    numVertices += part.mesh->vbo.size();
+    numIndices += part.mesh->ibo.size();
+    const std::size_t size =
+        std::max(part.mesh->vbo.size(), part.mesh->ibo.size());
+    for (std::size_t begin = 0; begin < size; begin += JOIN_CHUNK_SIZE) {
+      chunks.push_back({iPart, begin});
+    }
+  }
+  assets::MeshData::uptr joinedMesh = assets::MeshData::create_unique();
+  joinedMesh->vbo.resize(numVertices);
+  joinedMesh->ibo.resize(numIndices);
+
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  const std::size_t numWorkers = pool.numThreads() + 1;
+  pool.parallelFor(
+      chunks.size(), numWorkers, [&](std::size_t iChunk, std::size_t) {
+        const Chunk& chunk = chunks[iChunk];
+        const Part& part = parts[chunk.part];
+        const assets::MeshData& mesh = *part.mesh;
+        const std::size_t vertexEnd =
+            std::min(mesh.vbo.size(), chunk.begin + JOIN_CHUNK_SIZE);
+        for (std::size_t i = chunk.begin; i < vertexEnd; ++i) {
+          joinedMesh->vbo[part.firstVertex + i] =
+              Magnum::EigenIntegration::cast<vec3f>(
+                  part.transform.transformPoint(
+                      Magnum::Vector3{mesh.vbo[i]}));
+        }
+        const std::size_t indexEnd =
+            std::min(mesh.ibo.size(), chunk.begin + JOIN_CHUNK_SIZE);
+        for (std::size_t i = chunk.begin; i < indexEnd; ++i) {
+          joinedMesh->ibo[part.firstIndex + i] =
+              mesh.ibo[i] + uint32_t(part.firstVertex);
+        }
+      });
+  return joinedMesh;
+}
+
+assets::MeshData::cptr Simulator::getObjectCollisionMesh(
+    int objectID,
+    Magnum::Matrix4& transform) {
+  const metadata::attributes::ObjectAttributes::cptr initializationTemplate =
+      physicsManager_->getObjectInitAttributes(objectID);
+  transform = physicsManager_->getObjectVisualSceneNode(objectID)
+                  .absoluteTransformationMatrix() *
+              Magnum::Matrix4::scaling(initializationTemplate->getScale());
+  std::string meshHandle = initializationTemplate->getCollisionAssetHandle();
+  if (meshHandle.empty()) {
+    meshHandle = initializationTemplate->getRenderAssetHandle();
+  }
+  return resourceManager_->getJoinedCollisionMesh(meshHandle);
+}
+
+assets::MeshData::uptr Simulator::joinObjectCollisionMesh(int objectID) {
+  Magnum::Matrix4 transform;
+  assets::MeshData::uptr joinedObjectMesh = assets::MeshData::create_unique(
+      *getObjectCollisionMesh(objectID, transform));
+  for (auto& vert : joinedObjectMesh->vbo) {
+    vert = Magnum::EigenIntegration::cast<vec3f>(
+        transform.transformPoint(Magnum::Vector3{vert}));
+  }
+  return joinedObjectMesh;
+}
+
+namespace {
+void voxelizeMesh(geo::VoxelGrid& grid,
+                  const assets::MeshData& mesh,
+                  const uint32_t semanticId) {
+  std::vector<Mn::Vector3> positions;
+  positions.reserve(mesh.vbo.size());
+  for (const vec3f& v : mesh.vbo) {
+    positions.emplace_back(v[0], v[1], v[2]);
+  }
+  geo::voxelizeTriangles(grid, {positions.data(), positions.size()},
+                         {mesh.ibo.data(), mesh.ibo.size()}, Mn::Matrix4{},
+                         semanticId);
+}
+}  // namespace
+
+geo::VoxelGrid Simulator::voxelizeScene(const float voxelSize,
+                                        const bool includeObjects) {
+  ESP_PROFILE_SCOPE("Simulator::voxelizeScene");
+  // the meshes are joined once, for the bounds and then their voxels
+  std::vector<std::pair<assets::MeshData::uptr, uint32_t>> meshes;
+  auto stageInitAttrs = physicsManager_->getStageInitAttributes();
+  if (stageInitAttrs != nullptr) {
+    meshes.emplace_back(resourceManager_->createJoinedCollisionMesh(
+                            stageInitAttrs->getRenderAssetHandle()),
+                        0);
+  }
+  if (includeObjects) {
+    for (const int objectID : physicsManager_->getExistingObjectIDs()) {
+      meshes.emplace_back(
+          joinObjectCollisionMesh(objectID),
+          physicsManager_->getObjectVisualSceneNode(objectID).getSemanticId());
+    }
+  }
+
+  // inverted, so that no vertex gives an empty grid
+  Mn::Range3D bounds{Mn::Vector3{std::numeric_limits<float>::max()},
+                     Mn::Vector3{-std::numeric_limits<float>::max()}};
+  for (const auto& mesh : meshes) {
+    for (const vec3f& v : mesh.first->vbo) {
+      const Mn::Vector3 position{v[0], v[1], v[2]};
+      bounds = {Mn::Math::min(bounds.min(), position),
+                Mn::Math::max(bounds.max(), position)};
+    }
+  }
+  geo::VoxelGrid grid = geo::VoxelGrid::covering(bounds, voxelSize);
+  for (const auto& mesh : meshes) {
+    voxelizeMesh(grid, *mesh.first, mesh.second);
+  }
+  return grid;
+}
+
+void Simulator::voxelizeObjects(geo::VoxelGrid& grid,
+                                const std::vector<int>& objectIds) {
+  ESP_PROFILE_SCOPE("Simulator::voxelizeObjects");
+  for (const int objectID : objectIds) {
+    voxelizeMesh(
+        grid, *joinObjectCollisionMesh(objectID),
+        physicsManager_->getObjectVisualSceneNode(objectID).getSemanticId());
+  }
 }
 
 bool Simulator::setNavMeshVisualization(bool visualize) {
@@ -743,6 +2008,123 @@ bool Simulator::isNavMeshVisualizationActive() {
   return (navMeshVisNode_ != nullptr && navMeshVisPrimID_ != ID_UNDEFINED);
 }
 
+TopDownMap Simulator::renderTopDownMap(const float metersPerPixel,
+                                       const float minHeight,
+                                       const float maxHeight,
+                                       const int tileSize) {
+  ESP_PROFILE_SCOPE("Simulator::renderTopDownMap");
+  TopDownMap map;
+  map.metersPerPixel = metersPerPixel;
+  CORRADE_ASSERT(metersPerPixel > 0.0f && minHeight < maxHeight &&
+                     tileSize > 0,
+                 "Simulator::renderTopDownMap(): expected a positive pixel "
+                 "and tile size and a non-empty height range",
+                 map);
+  if (!renderer_ || !pathfinder_ || !pathfinder_->isLoaded()) {
+    LOG(ERROR) << "Simulator::renderTopDownMap(): needs a renderer and a "
+                  "navmesh";
+    return map;
+  }
+
+  // the grid of PathFinder::getTopDownView()
+  const std::pair<vec3f, vec3f> bounds = pathfinder_->bounds();
+  map.origin = {std::min(bounds.first[0], bounds.second[0]),
+                std::min(bounds.first[2], bounds.second[2])};
+  const Mn::Vector2i size{
+      int(std::abs(bounds.first[0] - bounds.second[0]) / metersPerPixel),
+      int(std::abs(bounds.first[2] - bounds.second[2]) / metersPerPixel)};
+  map.occupancy.setZero(size.y(), size.x());
+  map.semanticIds.setZero(size.y(), size.x());
+  map.heights.setConstant(size.y(), size.x(),
+                          std::numeric_limits<float>::quiet_NaN());
+
+  // looking down, the top of the image towards -z and its right towards +x,
+  // so that the top-down rows follow the grid
+  scene::SceneNode& sensorNode =
+      getActiveSceneGraph().getRootNode().createChild();
+  sensorNode.setRotation(
+      Mn::Quaternion::rotation(Mn::Deg(-90.0f), Mn::Vector3::xAxis()));
+  const float far = maxHeight - minHeight;
+  auto spec = sensor::SensorSpec::create();
+  spec->uuid = "top_down_map";
+  spec->sensorType = sensor::SensorType::Semantic;
+  spec->sensorSubType = sensor::SensorSubType::Orthographic;
+  spec->resolution = {tileSize, tileSize};
+  spec->channels = 1;
+  spec->parameters["near"] = "0";
+  spec->parameters["far"] = Cr::Utility::formatString("{:.9}", far);
+  spec->parameters["ortho_scale"] =
+      Cr::Utility::formatString("{:.9}", 1.0f / (tileSize * metersPerPixel));
+  sensor::CameraSensor::ptr topDownSensor =
+      sensor::CameraSensor::create(sensorNode, spec);
+  renderer_->bindRenderTarget(*topDownSensor, /*topDownRows=*/true);
+  gfx::RenderTarget& target = topDownSensor->renderTarget();
+
+  // the filled navmesh, in a scene graph of its own
+  scene::SceneGraph navMeshSceneGraph;
+  scene::SceneNode* navMeshNode =
+      &navMeshSceneGraph.getRootNode().createChild();
+  navMeshNode->setSemanticId(1);
+  const int navMeshPrimID = resourceManager_->loadNavMeshVisualization(
+      *pathfinder_, navMeshNode, &navMeshSceneGraph.getDrawables(),
+      /*wireframe=*/false);
+
+  const Mn::Vector2i tileImageSize{tileSize};
+  std::vector<uint32_t> ids(tileImageSize.product());
+  std::vector<float> depths(tileImageSize.product());
+  std::vector<uint32_t> navMeshIds(tileImageSize.product());
+  for (int tileY = 0; tileY < size.y(); tileY += tileSize) {
+    for (int tileX = 0; tileX < size.x(); tileX += tileSize) {
+      sensorNode.setTranslation(
+          {map.origin.x() + (tileX + 0.5f * tileSize) * metersPerPixel,
+           maxHeight,
+           map.origin.y() + (tileY + 0.5f * tileSize) * metersPerPixel});
+
+      // the semantic ids and the depth, of the same pass
+      topDownSensor->drawObservation(*this);
+      topDownSensor->readObservationInto(
+          target, {ids.data(), ids.size() * sizeof(uint32_t)});
+      target.readFrameDepthBuffer(
+          Mn::MutableImageView2D{Mn::PixelFormat::R32F, tileImageSize,
+                                 {depths.data(), depths.size() * 4}});
+
+      // the triangles of the navmesh are seen from both sides
+      Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
+      topDownSensor->drawObservationOf(*this, navMeshSceneGraph);
+      Mn::GL::Renderer::enable(Mn::GL::Renderer::Feature::FaceCulling);
+      target.readFrameObjectId(Mn::MutableImageView2D{
+          Mn::PixelFormat::R32UI, tileImageSize,
+          {navMeshIds.data(), navMeshIds.size() * sizeof(uint32_t)}});
+
+      const int rows = std::min(tileSize, size.y() - tileY);
+      const int columns = std::min(tileSize, size.x() - tileX);
+      for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < columns; ++x) {
+          const std::size_t i = std::size_t(y) * tileSize + x;
+          map.occupancy(tileY + y, tileX + x) = navMeshIds[i] != 0;
+          // the depth is linear from the near to the far plane
+          if (depths[i] < 1.0f) {
+            map.semanticIds(tileY + y, tileX + x) = ids[i];
+            map.heights(tileY + y, tileX + x) = maxHeight - depths[i] * far;
+          }
+        }
+      }
+    }
+  }
+
+  delete navMeshNode;
+  if (navMeshPrimID != ID_UNDEFINED) {
+    resourceManager_->removePrimitiveMesh(navMeshPrimID);
+  }
+  topDownSensor = nullptr;
+  delete &sensorNode;
+  // the occlusion history of the sensor is stale
+  if (isOcclusionCullingEnabled()) {
+    renderer_->resetOcclusionCulling();
+  }
+  return map;
+}
+
 int Simulator::addTrajectoryObject(const std::string& trajVisName,
                                    const std::vector<Mn::Vector3>& pts,
                                    int numSegments,
@@ -817,6 +2199,23 @@ scene::SceneNode* Simulator::loadAndCreateRenderAssetInstance(
       assetInfo, creation, sceneManager_.get(), tempIDs);
 }
 
+scene::SceneNode* Simulator::loadAndCreateRenderAssetInstance(
+    const assets::AssetInfo& assetInfo,
+    const assets::RenderAssetInstanceCreationInfo& creation,
+    const int sceneId) {
+  std::vector<int> tempIDs{sceneId, sceneId};
+  return resourceManager_->loadAndCreateRenderAssetInstance(
+      assetInfo, creation, sceneManager_.get(), tempIDs);
+}
+
+int Simulator::createSceneGraph() {
+  return sceneManager_->initSceneGraph();
+}
+
+scene::SceneGraph& Simulator::getSceneGraph(const int sceneId) {
+  return sceneManager_->getSceneGraph(sceneId);
+}
+
 agent::Agent::ptr Simulator::addAgent(
     const agent::AgentConfiguration& agentConfig,
     scene::SceneNode& agentParentNode) {
@@ -843,7 +2242,16 @@ agent::Agent::ptr Simulator::addAgent(
 
   agents_.push_back(ag);
   // TODO: just do this once
-  if (pathfinder_->isLoaded()) {
+  if (config_.kinematicAgentCollisions && physicsManager_) {
+    ag->getControls()->setMoveFilterFunction(
+        [this](const vec3f& start, const vec3f& end) {
+          const vec3f filtered =
+              pathfinder_->isLoaded() ? pathfinder_->tryStep(start, end) : end;
+          return Mn::EigenIntegration::cast<vec3f>(
+              collideAgentMoves({Mn::Vector3{start}}, {Mn::Vector3{filtered}})
+                  .front());
+        });
+  } else if (pathfinder_->isLoaded()) {
     ag->getControls()->setMoveFilterFunction(
         [&](const vec3f& start, const vec3f& end) {
           return pathfinder_->tryStep(start, end);
@@ -869,6 +2277,7 @@ nav::PathFinder::ptr Simulator::getPathFinder() {
 
 void Simulator::setPathFinder(nav::PathFinder::ptr pathfinder) {
   pathfinder_ = std::move(pathfinder);
+  navMeshModified_ = true;
 }
 gfx::RenderTarget* Simulator::getRenderTarget(int agentId,
                                               const std::string& sensorId) {
@@ -899,11 +2308,12 @@ bool Simulator::displayObservation(const int agentId,
 
 bool Simulator::drawObservation(const int agentId,
                                 const std::string& sensorId) {
+  ESP_PROFILE_SCOPE("Simulator::drawObservation");
   agent::Agent::ptr ag = getAgent(agentId);
 
   if (ag != nullptr) {
     sensor::Sensor::ptr sensor = ag->getSensorSuite().get(sensorId);
-    if (sensor != nullptr) {
+    if (sensor != nullptr && sensor->isVisualSensor()) {
       return std::static_pointer_cast<sensor::VisualSensor>(sensor)
           ->drawObservation(*this);
     }
@@ -911,6 +2321,38 @@ bool Simulator::drawObservation(const int agentId,
   return false;
 }
 
+std::vector<float> Simulator::queryObjectVisibility(
+    const int agentId,
+    const std::string& sensorId,
+    const std::vector<Mn::Matrix4>& poses,
+    const std::vector<int>& objectIds) {
+  ESP_PROFILE_SCOPE("Simulator::queryObjectVisibility");
+  agent::Agent::ptr ag = getAgent(agentId);
+  if (ag == nullptr) {
+    return {};
+  }
+  sensor::Sensor::ptr sensor = ag->getSensorSuite().get(sensorId);
+  if (sensor == nullptr || !sensor->isVisualSensor()) {
+    return {};
+  }
+  auto& visualSensor = static_cast<sensor::VisualSensor&>(*sensor);
+  if (!visualSensor.hasRenderTarget()) {
+    return {};
+  }
+
+  std::vector<scene::SceneNode*> objects;
+  objects.reserve(objectIds.size());
+  for (const int objectId : objectIds) {
+    objects.push_back(getObjectSceneNode(objectId));
+  }
+  gfx::RenderCamera::Flags flags;
+  if (isFrustumCullingEnabled()) {
+    flags |= gfx::RenderCamera::Flag::FrustumCulling;
+  }
+  return renderer_->queryVisibility(visualSensor, getActiveSceneGraph(),
+                                    poses, objects, flags);
+}
+
 bool Simulator::getAgentObservation(const int agentId,
                                     const std::string& sensorId,
                                     sensor::Observation& observation) {
@@ -924,6 +2366,36 @@ bool Simulator::getAgentObservation(const int agentId,
   return false;
 }
 
+bool Simulator::sensorsCanShareRenderPass(const sensor::Sensor& a,
+                                          const sensor::Sensor& b) {
+  auto cameraA = dynamic_cast<const sensor::CameraSensor*>(&a);
+  auto cameraB = dynamic_cast<const sensor::CameraSensor*>(&b);
+  if (cameraA == nullptr || cameraB == nullptr || !cameraA->hasRenderTarget() ||
+      !cameraB->hasRenderTarget()) {
+    return false;
+  }
+  // an asynchronous read of one attachment would block reading the others
+  if (a.specification()->asyncReadback || b.specification()->asyncReadback) {
+    return false;
+  }
+  // a render pass fills its target in a single row order
+  if (cameraA->renderTarget().topDownRows() !=
+      cameraB->renderTarget().topDownRows()) {
+    return false;
+  }
+  // semantic sensors draw the semantic scene graph, which can only be fused
+  // with the other sensors if it is the same as the active scene graph
+  const bool semanticA =
+      a.specification()->sensorType == sensor::SensorType::Semantic;
+  const bool semanticB =
+      b.specification()->sensorType == sensor::SensorType::Semantic;
+  if (semanticA != semanticB &&
+      &getActiveSemanticSceneGraph() != &getActiveSceneGraph()) {
+    return false;
+  }
+  return cameraA->canShareRenderPass(*cameraB);
+}
+
 int Simulator::getAgentObservations(
     const int agentId,
     std::map<std::string, sensor::Observation>& observations) {
@@ -932,16 +2404,197 @@ int Simulator::getAgentObservations(
   if (ag != nullptr) {
     const std::map<std::string, sensor::Sensor::ptr>& sensors =
         ag->getSensorSuite().getSensors();
+    // sensors sharing a view with an already drawn sensor only read the
+    // matching attachment of its render target instead of drawing again
+    std::vector<sensor::CameraSensor*> drawnSensors;
+    const double time = getWorldTime();
     for (std::pair<std::string, sensor::Sensor::ptr> s : sensors) {
+      if (!s.second->scheduleObservation(time)) {
+        sensor::Observation obs = s.second->lastObservation();
+        if (s.second->specification()->staleObservationPolicy ==
+                sensor::StaleObservationPolicy::Repeat &&
+            (obs.buffer != nullptr || obs.deviceBuffer != nullptr)) {
+          observations[s.first] = obs;
+        }
+        continue;
+      }
+
+      sensor::CameraSensor* source = nullptr;
+      for (sensor::CameraSensor* drawn : drawnSensors) {
+        if (sensorsCanShareRenderPass(*drawn, *s.second)) {
+          source = drawn;
+          break;
+        }
+      }
+
       sensor::Observation obs;
-      if (s.second->getObservation(*this, obs)) {
+      if (source != nullptr) {
+        auto& camera = static_cast<sensor::CameraSensor&>(*s.second);
+        camera.updateObjectIdRemapping(semanticScene_);
+        camera.readObservationFrom(source->renderTarget(), obs);
+        obs.timestamp = time;
+        s.second->recordObservation(obs);
+        observations[s.first] = obs;
+      } else if (s.second->getObservation(*this, obs)) {
+        obs.timestamp = time;
+        s.second->recordObservation(obs);
         observations[s.first] = obs;
+        if (auto camera = dynamic_cast<sensor::CameraSensor*>(s.second.get())) {
+          drawnSensors.push_back(camera);
+        }
       }
     }
   }
   return observations.size();
 }
 
+void Simulator::prewarmShaders() {
+  if (renderer_ == nullptr) {
+    return;
+  }
+  for (const int sceneID : sceneID_) {
+    gfx::prewarmShadersForSubTree(
+        sceneManager_->getSceneGraph(sceneID).getRootNode());
+  }
+}
+
+std::map<std::string, core::PerfStats::Stat> Simulator::getPerfStats() {
+  core::PerfStats& perfStats = core::PerfStats::shared();
+  if (gfx::TextureStreamer* textureStreamer = getTextureStreamer()) {
+    perfStats.add(core::PerfStat::TextureMemory,
+                  textureStreamer->statistics().residentBytes /
+                      (1024.0 * 1024.0));
+  }
+  std::map<std::string, core::PerfStats::Stat> stats;
+  for (std::size_t i = 0; i < core::PerfStats::NumStats; ++i) {
+    const auto stat = core::PerfStat(i);
+    core::PerfStats::Stat value = perfStats.get(stat);
+    if (value.count) {
+      stats[core::PerfStats::name(stat)] = value;
+    }
+  }
+  return stats;
+}
+
+void Simulator::resetPerfStats() {
+  core::PerfStats::shared().reset();
+}
+
+std::map<std::string, core::MemoryUsage> Simulator::getMemoryStats() {
+  std::map<std::string, core::MemoryUsage> stats =
+      resourceManager_->getMemoryUsage();
+  core::MemoryUsage& navmesh = stats["navmesh"];
+  if (pathfinder_) {
+    navmesh.hostBytes = pathfinder_->getHostBytes();
+  }
+  core::MemoryUsage& semanticScene = stats["semantic_scene"];
+  if (semanticScene_) {
+    semanticScene.hostBytes = semanticScene_->getHostBytes();
+  }
+  core::MemoryUsage& renderTargets = stats["render_targets"];
+  if (renderer_) {
+    renderTargets.gpuBytes = renderer_->renderTargetPoolGpuBytes();
+  }
+  for (const auto& agent : agents_) {
+    for (const auto& sensor : agent->getSensorSuite().getSensors()) {
+      if (!sensor.second->isVisualSensor()) {
+        continue;
+      }
+      auto& visualSensor = static_cast<sensor::VisualSensor&>(*sensor.second);
+      if (visualSensor.hasRenderTarget()) {
+        renderTargets.gpuBytes += visualSensor.renderTarget().getGpuBytes();
+      }
+    }
+  }
+  core::MemoryUsage& replay = stats["replay"];
+  if (gfxReplayMgr_ && gfxReplayMgr_->getRecorder()) {
+    replay.hostBytes = gfxReplayMgr_->getRecorder()->getHostBytes();
+  }
+  return stats;
+}
+
+bool Simulator::drawAndReadObservations(
+    const std::map<int,
+                   std::map<std::string, Cr::Containers::ArrayView<void>>>&
+        buffers) {
+  std::vector<PendingObservationRead> reads;
+  const bool drawn = drawObservations(buffers, reads);
+  return readObservations(reads) && drawn;
+}
+
+bool Simulator::drawObservations(
+    const std::map<int,
+                   std::map<std::string, Cr::Containers::ArrayView<void>>>&
+        buffers,
+    std::vector<PendingObservationRead>& reads) {
+  ESP_PROFILE_SCOPE("Simulator::drawObservations");
+  bool success = true;
+  for (const auto& agentBuffers : buffers) {
+    agent::Agent::ptr ag = getAgent(agentBuffers.first);
+    if (ag == nullptr) {
+      LOG(ERROR) << "Simulator::drawObservations : Unknown agent "
+                 << agentBuffers.first;
+      success = false;
+      continue;
+    }
+    const sensor::SensorSuite& sensors = ag->getSensorSuite();
+    std::vector<sensor::CameraSensor*> drawnSensors;
+    const double time = getWorldTime();
+    for (const auto& sensorBuffer : agentBuffers.second) {
+      auto camera = dynamic_cast<sensor::CameraSensor*>(
+          sensors.get(sensorBuffer.first).get());
+      if (camera == nullptr || !camera->hasRenderTarget()) {
+        LOG(ERROR) << "Simulator::drawObservations : "
+                   << sensorBuffer.first << " of agent " << agentBuffers.first
+                   << " is not a camera sensor with a render target";
+        success = false;
+        continue;
+      }
+      if (camera->specification()->sensorType ==
+              sensor::SensorType::Semantic &&
+          semanticScene_ == nullptr) {
+        LOG(ERROR) << "Simulator::drawObservations : "
+                   << sensorBuffer.first
+                   << " is a semantic sensor but no semantic scene is loaded";
+        success = false;
+        continue;
+      }
+      // the buffer of a stale observation keeps what was last read into it
+      if (!camera->scheduleObservation(time)) {
+        continue;
+      }
+
+      sensor::CameraSensor* source = nullptr;
+      for (sensor::CameraSensor* drawn : drawnSensors) {
+        if (sensorsCanShareRenderPass(*drawn, *camera)) {
+          source = drawn;
+          break;
+        }
+      }
+      if (source == nullptr) {
+        camera->drawObservation(*this);
+        drawnSensors.push_back(camera);
+        source = camera;
+      } else {
+        camera->updateObjectIdRemapping(semanticScene_);
+      }
+      reads.push_back({camera, source, sensorBuffer.second});
+    }
+  }
+  return success;
+}
+
+bool Simulator::readObservations(
+    const std::vector<PendingObservationRead>& reads) {
+  bool success = true;
+  for (const PendingObservationRead& read : reads) {
+    success = read.sensor->readObservationInto(read.source->renderTarget(),
+                                               read.data) &&
+              success;
+  }
+  return success;
+}
+
 bool Simulator::getAgentObservationSpace(const int agentId,
                                          const std::string& sensorId,
                                          sensor::ObservationSpace& space) {
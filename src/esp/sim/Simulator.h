@@ -5,12 +5,18 @@
 #ifndef ESP_SIM_SIMULATOR_H_
 #define ESP_SIM_SIMULATOR_H_
 
+#include <Corrade/Containers/ArrayView.h>
 #include <Corrade/Utility/Assert.h>
 #include "esp/agent/Agent.h"
 #include "esp/assets/ResourceManager.h"
+#include "esp/core/MemoryUsage.h"
+#include "esp/core/PerfStats.h"
+#include "esp/core/StartupProfile.h"
 #include "esp/core/esp.h"
+#include "esp/core/ThreadPool.h"
 #include "esp/core/random.h"
 #include "esp/gfx/RenderTarget.h"
+#include "esp/geo/VoxelGrid.h"
 #include "esp/gfx/WindowlessContext.h"
 #include "esp/metadata/MetadataMediator.h"
 #include "esp/nav/PathFinder.h"
@@ -30,6 +36,9 @@ class ActionSpacePathFinder;
 namespace scene {
 class SemanticScene;
 }  // namespace scene
+namespace sensor {
+class CameraSensor;
+}  // namespace sensor
 namespace gfx {
 class Renderer;
 namespace replay {
@@ -40,9 +49,46 @@ class ReplayManager;
 
 namespace esp {
 namespace sim {
+
+/**
+ * @brief A top-down map drawn by @ref Simulator::renderTopDownMap()
+ *
+ * The grids are those of @ref nav::PathFinder::getTopDownView(), with the
+ * rows along z and the columns along x from the lower corner of the navmesh
+ * bounds, so that the maps line up.
+ */
+struct TopDownMap {
+  //! The x and z of the lower corner of the first pixel
+  Magnum::Vector2 origin;
+  //! The size of a pixel
+  float metersPerPixel = 0.0f;
+  //! Where the navmesh is, seen from above in the height range
+  Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> occupancy;
+  //! The semantic id of the highest surface in the height range, 0 where
+  //! there is none
+  Eigen::Matrix<uint32_t, Eigen::Dynamic, Eigen::Dynamic> semanticIds;
+  //! The height of the highest surface in the height range, NaN where there
+  //! is none
+  Eigen::MatrixXf heights;
+};
+
 class Simulator {
  public:
   explicit Simulator(const SimulatorConfiguration& cfg);
+
+  /**
+   * @brief Create a simulator using the already loaded @p metadataMediator
+   * instead of parsing the scene dataset configs again
+   *
+   * The mediator is shared with the simulator, see
+   * @ref getMetadataMediator(). With @ref preloadScene() this lets a parent
+   * process load the metadata and the CPU-side parts of the stages once
+   * before forking worker processes, which inherit them copy-on-write and
+   * only create their GL context and upload the render assets.
+   */
+  Simulator(const SimulatorConfiguration& cfg,
+            metadata::MetadataMediator::ptr metadataMediator);
+
   virtual ~Simulator();
 
   /**
@@ -56,14 +102,131 @@ class Simulator {
    */
   virtual void close();
 
+  /**
+   * @brief Load the stage of @p cfg and apply the settings.
+   *
+   * Records the time spent in each stage of the loading in
+   * @ref getStartupProfile(), logged once done.
+   */
   virtual void reconfigure(const SimulatorConfiguration& cfg);
 
+  /**
+   * @brief Where the time of the last @ref reconfigure() went
+   *
+   * Hierarchical timings of the JSON configs, the stage assets and their
+   * textures, meshes and shaders, the navmesh and the semantic scene, with
+   * the bytes read, textures uploaded and triangles of each.
+   */
+  const core::StartupProfile& getStartupProfile() const {
+    return startupProfile_;
+  }
+
+  /**
+   * @brief Whether @ref reconfigure() with @p cfg loads the stage from
+   * scratch. If not, only the cheap settings are applied and the simulator
+   * is reset, see @ref requiresStageReload().
+   */
+  bool isStageReloadRequired(const SimulatorConfiguration& cfg) const;
+
+  /**
+   * @brief Start loading the parts of the stage of @p cfg which need no GL
+   * context on a background thread, so that a following @ref reconfigure()
+   * to the same stage swaps them in instead of loading them.
+   *
+   * Prefetches the navmesh and the semantic scene, and reads the render and
+   * semantic assets of the stage once so that loading them hits the OS file
+   * cache. A new call replaces the previous prefetch. Only stages of the
+   * active scene dataset can be prefetched.
+   */
+  void prefetchScene(const SimulatorConfiguration& cfg);
+
+  /**
+   * @brief Load the parts of the stage of @p cfg which need no GL context
+   * into a cache of the process, for the simulators created later in this
+   * process or in the processes forked from it
+   *
+   * Loads the navmesh and the semantic scene, resolving the stage with the
+   * scene dataset of @p cfg in @p metadataMediator, and reads the render and
+   * semantic assets once so that loading them hits the OS file cache. The
+   * first @ref reconfigure() of a simulator of the process to the stage
+   * takes them out of the cache instead of loading them, later ones load
+   * them again. Not thread-safe.
+   */
+  static void preloadScene(const SimulatorConfiguration& cfg,
+                           metadata::MetadataMediator& metadataMediator);
+
+  /** @brief Drop the stages loaded by @ref preloadScene() */
+  static void clearPreloadedScenes();
+
+  /**
+   * @brief Branch the simulator into a copy to roll forward independently,
+   * e.g. for tree search, without loading anything again.
+   *
+   * The copy shares the read-only parts: the OpenGL context, the renderer,
+   * the loaded assets, the convex hulls of the objects, the pathfinder and
+   * the semantic scene. It gets its own scene graph, physics world, agents
+   * and random generator, with the stage, objects and agents in the current
+   * state of this simulator. The objects are attached to the stage node,
+   * whatever node they are attached to here.
+   *
+   * The copies render with the same OpenGL context, so they must be used from
+   * the thread of this simulator, except for stepping the physics of
+   * different copies, which can run concurrently. Closing this simulator
+   * keeps the assets and the context until all copies are closed too.
+   * Forking while recording gfx replays is not supported.
+   */
+  std::shared_ptr<Simulator> fork() const;
+
+  /**
+   * @brief Create a simulator of another scene of the same dataset, to keep
+   * several scenes active at once, e.g. one per environment of a @ref
+   * VectorSimulator.
+   *
+   * The sibling shares the OpenGL context, the renderer, the metadata and
+   * the loaded assets of this simulator, so only the assets that this one
+   * hasn't loaded yet are loaded. It gets its own scene graph, physics world,
+   * pathfinder, semantic scene, agents and random generator, configured from
+   * @p cfg. The asset settings of the resource manager are shared too, the
+   * last simulator (re)configured sets them for the assets loaded after.
+   *
+   * The same threading rules as for @ref fork() apply. The assets of a
+   * sibling are referenced by its instances, so evicting unused assets from
+   * any sibling keeps them.
+   *
+   * @throws std::runtime_error if this simulator isn't configured, @p cfg is
+   * of another scene dataset or either records gfx replays
+   */
+  std::shared_ptr<Simulator> createSibling(
+      const SimulatorConfiguration& cfg) const;
+
   virtual void reset();
 
  public:
   virtual void seed(uint32_t newSeed);
 
   std::shared_ptr<gfx::Renderer> getRenderer() { return renderer_; }
+
+  /**
+   * @brief The texture streamer, nullptr if
+   * SimulatorConfiguration::textureMemoryBudget was never set
+   */
+  gfx::TextureStreamer* getTextureStreamer() {
+    return resourceManager_->getTextureStreamer();
+  }
+
+  /**
+   * @brief Load the files of the stage which were still pending at
+   * SimulatorConfiguration::fileProvider when it was loaded and arrived since,
+   * i.e. the images drawn with a placeholder and the navmesh, see
+   * assets::ResourceManager::loadStreamedFiles()
+   *
+   * Call it e.g. once per frame while @ref hasPendingFiles().
+   * @return Whether anything was loaded
+   */
+  bool loadStreamedFiles();
+
+  /** @brief Whether files of the stage are still pending */
+  bool hasPendingFiles() const;
   std::shared_ptr<scene::SemanticScene> getSemanticScene() {
     return semanticScene_;
   }
@@ -251,6 +414,39 @@ class Simulator {
    */
   std::vector<int> getExistingObjectIDs(int sceneID = 0);
 
+  /**
+   * @brief Set the number of removed objects of each template kept for reuse
+   * by the next @ref addObject calls, e.g. to reset episodes faster. See @ref
+   * esp::physics::PhysicsManager::setObjectPoolSize.
+   * @param size The number of objects kept for each template, 0 to disable
+   * pooling.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * pool the objects of.
+   */
+  void setObjectPoolSize(int size, int sceneID = 0);
+
+  /**
+   * @brief Get the number of removed objects of each template kept for reuse.
+   * See @ref setObjectPoolSize.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * query.
+   */
+  int getObjectPoolSize(int sceneID = 0);
+
+  /**
+   * @brief Get the number of removed objects waiting for reuse.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * query.
+   */
+  int getNumPooledObjects(int sceneID = 0);
+
+  /**
+   * @brief Delete the removed objects waiting for reuse.
+   * @param sceneID !! Not used currently !! Specifies which physical scene to
+   * clear the pool of.
+   */
+  void clearObjectPool(int sceneID = 0);
+
   /**
    * @brief Get the @ref esp::physics::MotionType of an object.
    * See @ref esp::physics::PhysicsManager::getExistingObjectIDs.
@@ -480,6 +676,122 @@ class Simulator {
    */
   Magnum::Vector3 getAngularVelocity(int objectID, int sceneID = 0);
 
+  /**
+   * @brief Get the rigid states of many objects in one go. See @ref
+   * esp::physics::PhysicsManager::getRigidStates. Without physics, the
+   * states are identity transformations.
+   */
+  void getRigidStates(
+      Corrade::Containers::ArrayView<const int> objectIDs,
+      Corrade::Containers::ArrayView<Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<Magnum::Quaternion> rotations,
+      int sceneID = 0) const;
+
+  /**
+   * @brief Set the rigid states of many objects kinematically in one go. See
+   * @ref esp::physics::PhysicsManager::setRigidStates.
+   */
+  void setRigidStates(
+      Corrade::Containers::ArrayView<const int> objectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> translations,
+      Corrade::Containers::ArrayView<const Magnum::Quaternion> rotations,
+      int sceneID = 0);
+
+  /**
+   * @brief Get the linear and angular velocities of many objects in one go.
+   * See @ref esp::physics::PhysicsManager::getVelocities. Without physics,
+   * the velocities are zero.
+   */
+  void getVelocities(Corrade::Containers::ArrayView<const int> objectIDs,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> linVels,
+                     Corrade::Containers::ArrayView<Magnum::Vector3> angVels,
+                     int sceneID = 0) const;
+
+  /**
+   * @brief Set the linear and angular velocities of many objects in one go.
+   * See @ref esp::physics::PhysicsManager::setVelocities.
+   */
+  void setVelocities(
+      Corrade::Containers::ArrayView<const int> objectIDs,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> linVels,
+      Corrade::Containers::ArrayView<const Magnum::Vector3> angVels,
+      int sceneID = 0);
+
+  /**
+   * @brief Save the state of all objects to restore it later. See @ref
+   * esp::physics::PhysicsManager::saveState.
+   * @return The handle of the state, @ref ID_UNDEFINED without physics.
+   */
+  int savePhysicsState(int sceneID = 0);
+
+  /**
+   * @brief Restore a state saved by @ref savePhysicsState. See @ref
+   * esp::physics::PhysicsManager::restoreState.
+   */
+  bool restorePhysicsState(int handle, int sceneID = 0);
+
+  /**
+   * @brief Free a state saved by @ref savePhysicsState. See @ref
+   * esp::physics::PhysicsManager::removeState.
+   */
+  bool removePhysicsState(int handle, int sceneID = 0);
+
+  /**
+   * @brief The state of all objects as a binary blob. See @ref
+   * esp::physics::PhysicsManager::serializeState. Empty without physics.
+   */
+  std::string serializePhysicsState(int sceneID = 0) const;
+
+  /**
+   * @brief Restore a blob from @ref serializePhysicsState. See @ref
+   * esp::physics::PhysicsManager::deserializeState.
+   */
+  bool deserializePhysicsState(const std::string& state, int sceneID = 0);
+
+  /**
+   * @brief A hash of the physics state, to verify that runs are
+   * reproducible. See @ref esp::physics::PhysicsManager::getStateChecksum.
+   * 0 without physics.
+   */
+  std::uint64_t getPhysicsStateChecksum(int sceneID = 0) const;
+
+  /**
+   * @brief Save the simulation to @p path, to continue it later with
+   * @ref loadCheckpoint(), e.g. after the process was preempted.
+   *
+   * The checkpoint is a compact binary of the scene and its dataset, the
+   * objects with their templates, IDs and velocity controls (see @ref
+   * physics::PhysicsManager::serializeObjectInstances()), the physics state
+   * of @ref serializePhysicsState(), the states of the agents and of their
+   * sensors, the random generators of the simulator and of the pathfinder,
+   * and the navmesh if it was recomputed or updated since the stage was
+   * loaded. The assets aren't in it, they are loaded again.
+   * @param path     The file, written atomically
+   * @param userData Stored along, e.g. the states of agents managed
+   *                 elsewhere, returned by @ref loadCheckpoint()
+   * @return false if the file can't be written
+   */
+  bool saveCheckpoint(const std::string& path,
+                      const std::string& userData = {});
+
+  /**
+   * @brief Continue the simulation of a checkpoint of @ref saveCheckpoint()
+   *
+   * The simulator has to be configured for the scene of the checkpoint,
+   * with the agents and sensors it had when saving. The objects are replaced
+   * by those of the checkpoint: as for @ref fork(), they are attached to the
+   * stage node whatever node they were attached to, and objects of templates
+   * which aren't registered are missing, their physics state isn't restored
+   * then.
+   * @param path          The file of @ref saveCheckpoint()
+   * @param[out] userData If not null, set to the data passed to
+   *                      @ref saveCheckpoint()
+   * @return false, changing nothing, if the file is malformed or of another
+   * scene or agents, otherwise whether all objects were instanced
+   */
+  bool loadCheckpoint(const std::string& path,
+                      std::string* userData = nullptr);
+
   /**
    * @brief Turn on/off rendering for the bounding box of the object's visual
    * component.
@@ -508,6 +820,18 @@ class Simulator {
    */
   void setObjectSemanticId(uint32_t semanticId, int objectID, int sceneID = 0);
 
+  /**
+   * @brief Hide or show an object of the semantic instance mesh of the stage
+   *
+   * Only stages loaded with their instance mesh split by object, see
+   * @ref assets::AssetInfo::splitInstanceMesh, have their objects drawn
+   * separately.
+   * @param semanticObjectId The object ID in the instance mesh.
+   * @param hidden Whether to hide it from all sensors.
+   * @return false if no instance mesh of the stage has the object
+   */
+  bool setSemanticObjectHidden(uint32_t semanticObjectId, bool hidden);
+
   /**
    * @brief Discrete collision check for contact between an object and the
    * collision world.
@@ -540,6 +864,41 @@ class Simulator {
     return false;
   };
 
+  /**
+   * @brief Set the collision group of an object and the groups it collides
+   * with, see @ref physics::RigidObject::setCollisionFilter().
+   */
+  bool setObjectCollisionFilter(const int group,
+                                const int mask,
+                                const int objectID) {
+    if (sceneHasPhysics(activeSceneID_)) {
+      return physicsManager_->setObjectCollisionFilter(objectID, group, mask);
+    }
+    return false;
+  }
+
+  /**
+   * @brief Get the collision group of an object, see
+   * @ref physics::RigidObject::getCollisionGroup().
+   */
+  int getObjectCollisionGroup(const int objectID) {
+    if (sceneHasPhysics(activeSceneID_)) {
+      return physicsManager_->getObjectCollisionGroup(objectID);
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Get the groups an object collides with, see
+   * @ref physics::RigidObject::getCollisionMask().
+   */
+  int getObjectCollisionMask(const int objectID) {
+    if (sceneHasPhysics(activeSceneID_)) {
+      return physicsManager_->getObjectCollisionMask(objectID);
+    }
+    return 0;
+  }
+
   /**
    * @brief Set the stage to collidable or not.
    */
@@ -572,25 +931,259 @@ class Simulator {
    * In units of ray length.
    * @param sceneID !! Not used currently !! Specifies which physical scene of
    * the object.
+   * @param closestHitOnly Whether to only report the closest hit.
+   * @param collisionFilterMask The @ref esp::physics::CollisionGroup values
+   * the ray hits.
    * @return Raycast results sorted by distance.
    */
-  esp::physics::RaycastResults castRay(const esp::geo::Ray& ray,
-                                       float maxDistance = 100.0,
-                                       int sceneID = 0);
+  esp::physics::RaycastResults castRay(
+      const esp::geo::Ray& ray,
+      float maxDistance = 100.0,
+      int sceneID = 0,
+      bool closestHitOnly = false,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief Cast a batch of rays into the collision world, in parallel. See
+   * @ref esp::physics::PhysicsManager::castRays. Physics must be enabled, the
+   * rays have no hits otherwise.
+   *
+   * @param rays The rays to cast.
+   * @param maxDistance The maximum distance along the ray directions to
+   * search. In units of ray length.
+   * @param closestHitOnly Whether to only report the closest hit of each ray.
+   * @param sceneID !! Not used currently !! Specifies which physical scene of
+   * the object.
+   * @param collisionFilterMask The @ref esp::physics::CollisionGroup values
+   * the rays hit.
+   * @return The hits of all rays, each ray's sorted by distance.
+   */
+  esp::physics::MultiRaycastResults castRays(
+      const std::vector<esp::geo::Ray>& rays,
+      float maxDistance = 100.0,
+      bool closestHitOnly = false,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief The objects whose bounding box overlaps a box, from the
+   * broadphase of the collision world. See @ref
+   * esp::physics::PhysicsManager::overlapAabb. Physics must be enabled,
+   * nothing overlaps otherwise.
+   *
+   * @param aabb The box.
+   * @param sceneID !! Not used currently !! Specifies which physical scene
+   * to query.
+   * @param collisionFilterMask The @ref esp::physics::CollisionGroup values
+   * included.
+   * @return The IDs of the objects, sorted, -1 for the stage.
+   */
+  std::vector<int> overlapAabb(
+      const Magnum::Range3D& aabb,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief The objects whose bounding box overlaps a sphere, as @ref
+   * overlapAabb().
+   */
+  std::vector<int> overlapSphere(
+      const Magnum::Vector3& center,
+      float radius,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief The objects whose bounding box overlaps an oriented box, as @ref
+   * overlapAabb().
+   */
+  std::vector<int> overlapObb(
+      const esp::geo::OBB& obb,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief @ref contactTest() of a batch of objects. See @ref
+   * esp::physics::PhysicsManager::contactTests.
+   *
+   * @param objectIDs The IDs of the objects.
+   * @param sceneID !! Not used currently !! Specifies which physical scene
+   * of the objects.
+   * @return Whether each object is in contact with any other object.
+   */
+  std::vector<bool> contactTests(const std::vector<int>& objectIDs,
+                                 int sceneID = 0);
+
+  /**
+   * @brief Whether an object would be in contact with any other object at
+   * each of a batch of transformations, without moving it. See @ref
+   * esp::physics::PhysicsManager::testPlacements.
+   *
+   * @param objectID The ID of the object.
+   * @param transformations The candidate transformations of the object.
+   * @param sceneID !! Not used currently !! Specifies which physical scene
+   * of the object.
+   * @return Whether the object collides at each transformation.
+   */
+  std::vector<bool> testPlacements(
+      int objectID,
+      const std::vector<Magnum::Matrix4>& transformations,
+      int sceneID = 0);
+
+  /**
+   * @brief @ref testPlacements() of an object template, instanced once for
+   * the whole batch and removed after.
+   *
+   * @param objectLibHandle The handle of the object template.
+   * @param transformations The candidate transformations of the object.
+   * @param sceneID !! Not used currently !! Specifies which physical scene
+   * to test in.
+   * @return Whether the object collides at each transformation, all false if
+   * it can't be instanced.
+   */
+  std::vector<bool> testPlacements(
+      const std::string& objectLibHandle,
+      const std::vector<Magnum::Matrix4>& transformations,
+      int sceneID = 0);
+
+  /**
+   * @brief Sweep the collision shape of an object along a straight path and
+   * return its first hit, without moving it. See @ref
+   * esp::physics::PhysicsManager::sweepObject. Physics must be enabled,
+   * nothing is hit otherwise.
+   *
+   * @param objectID The ID of the object.
+   * @param from The transformation of the object's root node at the start.
+   * @param to The translation of the object's root node at the end.
+   * @param sceneID !! Not used currently !! Specifies which physical scene
+   * of the object.
+   * @param collisionFilterMask The @ref esp::physics::CollisionGroup values
+   * the object hits.
+   * @return The first hit.
+   */
+  esp::physics::SweepResult sweepObject(
+      int objectID,
+      const Magnum::Matrix4& from,
+      const Magnum::Vector3& to,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief @ref sweepObject() along a batch of paths, in parallel. See @ref
+   * esp::physics::PhysicsManager::sweepObjectBatch.
+   */
+  std::vector<esp::physics::SweepResult> sweepObjectBatch(
+      int objectID,
+      const std::vector<Magnum::Matrix4>& from,
+      const std::vector<Magnum::Vector3>& to,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief Sweep an upright capsule along a straight path and return its
+   * first hit, e.g. the body of an agent. See @ref
+   * esp::physics::PhysicsManager::sweepCapsule. Physics must be enabled,
+   * nothing is hit otherwise.
+   *
+   * @param radius The radius of the capsule.
+   * @param height The height of the capsule, caps included.
+   * @param from The center of the capsule at the start.
+   * @param to The center of the capsule at the end.
+   * @param sceneID !! Not used currently !! Specifies which physical scene
+   * to sweep in.
+   * @param collisionFilterMask The @ref esp::physics::CollisionGroup values
+   * the capsule hits.
+   * @return The first hit.
+   */
+  esp::physics::SweepResult sweepCapsule(
+      float radius,
+      float height,
+      const Magnum::Vector3& from,
+      const Magnum::Vector3& to,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief @ref sweepCapsule() along a batch of paths, in parallel. See @ref
+   * esp::physics::PhysicsManager::sweepCapsuleBatch.
+   */
+  std::vector<esp::physics::SweepResult> sweepCapsuleBatch(
+      float radius,
+      float height,
+      const std::vector<Magnum::Vector3>& from,
+      const std::vector<Magnum::Vector3>& to,
+      int sceneID = 0,
+      int collisionFilterMask = int(esp::physics::CollisionGroup::ALL));
+
+  /**
+   * @brief Block the moves of agent bodies by the stage and the objects,
+   * e.g. the objects missing from the navmesh, without simulating the bodies
+   *
+   * With @ref SimulatorConfiguration::kinematicAgentCollisions, each move of
+   * the feet of a body from @p starts to @p ends is swept as a capsule of
+   * @ref SimulatorConfiguration::agentCollisionRadius and
+   * @ref SimulatorConfiguration::agentCollisionHeight that slides along the
+   * obstacles following @ref SimulatorConfiguration::allowSliding, see
+   * @ref physics::KinematicCharacterController. The moves are swept as a
+   * batch, in parallel. Returns @p ends unchanged otherwise or without
+   * physics.
+   */
+  std::vector<Magnum::Vector3> collideAgentMoves(
+      const std::vector<Magnum::Vector3>& starts,
+      const std::vector<Magnum::Vector3>& ends);
 
   /**
    * @brief the physical world has a notion of time which passes during
    * animation/simulation/action/etc... Step the physical world forward in time
    * by a desired duration. Note that the actual duration of time passed by this
-   * step will depend on simulation time stepping mode (todo). See @ref
+   * step will depend on the fixed time step and the max substeps of the
+   * physics manager attributes. See @ref
    * esp::physics::PhysicsManager::stepPhysics.
-   * @todo timestepping options?
    * @param dt The desired amount of time to advance the physical world.
    * @return The new world time after stepping. See @ref
    * esp::physics::PhysicsManager::worldTime_.
    */
   double stepWorld(double dt = 1.0 / 60.0);
 
+  /**
+   * @brief Take a built-in body action with each of several scene nodes,
+   * e.g. the bodies of agents, filtered by the navmesh all at once
+   *
+   * Same as @ref scene::ObjectControls::action() with each node, but the
+   * moves are filtered by a single @ref nav::PathFinder::tryStepBatch() or
+   * @ref nav::PathFinder::tryStepNoSlidingBatch(), following
+   * @ref SimulatorConfiguration::allowSliding, and unfiltered without a
+   * loaded navmesh, then by @ref collideAgentMoves(). The nodes are expected
+   * to be children of the root of the scene graph, like the bodies of
+   * agents.
+   *
+   * @param bodies The nodes to move
+   * @param actions The name of the action of each node, one of the moves and
+   * turns of @ref agent::Agent::BodyActions
+   * @param amounts The distance or angle in degrees of each action
+   * @return Whether the move of each node collided, empty if an action isn't
+   * a body action or the sizes don't match
+   */
+  std::vector<bool> actBodies(const std::vector<scene::SceneNode*>& bodies,
+                              const std::vector<std::string>& actions,
+                              const std::vector<float>& amounts);
+
+  /**
+   * @brief Take an action with each of several agents, then step the
+   * physical world once
+   *
+   * The body actions of all agents are taken by a single @ref actBodies(),
+   * the others with @ref agent::Agent::act(). Then steps the world by @p dt
+   * with @ref stepWorld().
+   *
+   * @param actions The action of each agent, by agent ID
+   * @param dt The desired amount of time to advance the physical world
+   * @return Whether the action of each agent collided, by agent ID. Agents
+   * without such an action are left out.
+   */
+  std::map<int, bool> step(const std::map<int, std::string>& actions,
+                           double dt = 1.0 / 60.0);
+
   /**
    * @brief Get the current time in the simulated world. This is always 0 if no
    * @ref esp::physics::PhysicsManager is initialized. See @ref stepWorld. See
@@ -623,6 +1216,23 @@ class Simulator {
                         const nav::NavMeshSettings& navMeshSettings,
                         bool includeStaticObjects = false);
 
+  /**
+   * @brief Update a navmesh computed by @ref recomputeNavMesh with a nonzero
+   * @ref nav::NavMeshSettings::tileSize after the geometry changed within a
+   * region, e.g. an object moved, rebuilding only the tiles overlapping it.
+   * See @ref nav::PathFinder::rebuildTiles.
+   * @param pathfinder The pathfinder object whose navmesh is updated.
+   * @param regionMin, regionMax The region of the change, e.g. the union of
+   * the bounding boxes of the object before and after moving.
+   * @param includeStaticObjects Whether the navmesh includes the STATIC
+   * objects, as passed to @ref recomputeNavMesh.
+   * @return Whether or not the navmesh update succeeded.
+   */
+  bool updateNavMesh(nav::PathFinder& pathfinder,
+                     const Magnum::Vector3& regionMin,
+                     const Magnum::Vector3& regionMax,
+                     bool includeStaticObjects = false);
+
   /**
    * @brief Set visualization of the current NavMesh @ref pathfinder_ on or off.
    *
@@ -636,6 +1246,48 @@ class Simulator {
    */
   bool isNavMeshVisualizationActive();
 
+  /**
+   * @brief Draw a top-down map of the navmesh, the semantic ids and the
+   * heights of the scene between two heights
+   *
+   * An orthographic semantic sensor looks down from @p maxHeight, tile after
+   * tile. Each tile is one pass over the scene, giving the semantic ids and
+   * the depth, and one over the filled navmesh. Draw the slab of a level,
+   * e.g. from below its floor to under its ceiling, to map it alone.
+   *
+   * @param metersPerPixel The size of a pixel
+   * @param minHeight      The bottom of the slab drawn
+   * @param maxHeight      The top of the slab drawn
+   * @param tileSize       The size of the square tiles, in pixels
+   * @return The map, empty if there is no renderer or no navmesh
+   */
+  TopDownMap renderTopDownMap(float metersPerPixel,
+                              float minHeight,
+                              float maxHeight,
+                              int tileSize = 1024);
+
+  /**
+   * @brief Voxelize the collision meshes of the stage, and of the objects if
+   * requested, at their current poses
+   *
+   * The voxels of the stage hold 0 and those of an object the semantic id of
+   * its visual node, see @ref geo::voxelizeTriangles() for which voxels are
+   * marked. The grid covers the meshes with a voxel of margin.
+   *
+   * @param voxelSize      The edge length of the voxels
+   * @param includeObjects Whether the objects are voxelized too
+   */
+  geo::VoxelGrid voxelizeScene(float voxelSize, bool includeObjects = true);
+
+  /**
+   * @brief Mark the voxels of @p grid the collision meshes of objects touch
+   * at their current poses
+   *
+   * To follow the dynamic objects, voxelize the stage and the static objects
+   * once and voxelize the others into a copy of that grid each step.
+   */
+  void voxelizeObjects(geo::VoxelGrid& grid, const std::vector<int>& objectIds);
+
   /**
    * @brief Compute a trajectory visualization for the passed points.
    * @param trajVisName The name to use for the trajectory visualization
@@ -749,13 +1401,136 @@ class Simulator {
    */
   bool drawObservation(int agentId, const std::string& sensorId);
 
+  /**
+   * @brief The fractions of rigid objects a sensor of an agent sees from
+   * several poses, see @ref gfx::Renderer::queryVisibility()
+   * @param agentId    Id of the agent of the sensor
+   * @param sensorId   Id of the sensor, whose render target is overwritten
+   * @param poses      Absolute transformations of the sensor
+   * @param objectIds  Ids of the rigid objects
+   * @return The fraction of each object for each pose, the objects of the
+   *    first pose first, empty if there is no such visual sensor
+   */
+  std::vector<float> queryObjectVisibility(
+      int agentId,
+      const std::string& sensorId,
+      const std::vector<Magnum::Matrix4>& poses,
+      const std::vector<int>& objectIds);
+
   bool getAgentObservation(int agentId,
                            const std::string& sensorId,
                            sensor::Observation& observation);
+  /**
+   * @brief Get the observations of all sensors of an agent.
+   *
+   * Sensors that see the exact same view (see @ref sensorsCanShareRenderPass)
+   * are rendered in a single pass; each reads its own attachment (color,
+   * depth or object id) of the shared render target. Sensors whose turn to
+   * be drawn it isn't, see @ref sensor::SensorSpec::renderInterval, aren't
+   * drawn; they repeat their last observation or are left out, following
+   * their @ref sensor::SensorSpec::staleObservationPolicy.
+   * @return The number of observations retrieved
+   */
   int getAgentObservations(
       int agentId,
       std::map<std::string, sensor::Observation>& observations);
 
+  /**
+   * @brief Draw the sensors of several agents and read their observations
+   * into memory owned by the caller, e.g. preallocated arrays, in one call.
+   *
+   * All the sensors are drawn before any is read, so that asynchronous reads
+   * overlap with drawing the other sensors, and sensors that see the exact
+   * same view (see @ref sensorsCanShareRenderPass) share a render pass. The
+   * rows are in the order of the render targets of the sensors, see
+   * @ref gfx::RenderTarget::topDownRows(). Sensors whose turn to be drawn it
+   * isn't, see @ref sensor::SensorSpec::renderInterval, are skipped, leaving
+   * their buffer as it is.
+   * @param buffers The memory each observation is read into, of the size of
+   * the observation, by agent ID and sensor UUID. Only these sensors are
+   * drawn; they must be @ref sensor::CameraSensor s with a render target.
+   * @return Whether every observation could be drawn and read
+   */
+  bool drawAndReadObservations(
+      const std::map<
+          int,
+          std::map<std::string, Corrade::Containers::ArrayView<void>>>&
+          buffers);
+
+  /**
+   * @brief An observation drawn by @ref drawObservations(), still to be read
+   */
+  struct PendingObservationRead {
+    sensor::CameraSensor* sensor;
+    /** @brief The sensor whose render target holds the observation */
+    sensor::CameraSensor* source;
+    Corrade::Containers::ArrayView<void> data;
+  };
+
+  /**
+   * @brief The drawing half of @ref drawAndReadObservations(), appending the
+   * reads to do to @p reads
+   *
+   * Lets a caller draw the sensors of several simulators sharing a context
+   * before reading any, see @ref VectorSimulator.
+   * @return Whether every sensor of @p buffers could be drawn
+   */
+  bool drawObservations(
+      const std::map<
+          int,
+          std::map<std::string, Corrade::Containers::ArrayView<void>>>&
+          buffers,
+      std::vector<PendingObservationRead>& reads);
+
+  /**
+   * @brief The reading half of @ref drawAndReadObservations()
+   * @return Whether every observation could be read
+   */
+  static bool readObservations(
+      const std::vector<PendingObservationRead>& reads);
+
+  /**
+   * @brief Whether two sensors can be filled by the same render pass: both
+   * are @ref sensor::CameraSensor s with the same resolution, projection and
+   * pose, neither uses asynchronous readback, they draw the same scene
+   * graph and their render targets have the same row order.
+   */
+  bool sensorsCanShareRenderPass(const sensor::Sensor& a,
+                                 const sensor::Sensor& b);
+
+  /**
+   * @brief Create the shader variants the drawables of the loaded scene need
+   * for their current light setups, so that the first frame doesn't compile
+   * them. Call it again after adding objects with new materials or changing
+   * light setups. See also @ref SimulatorConfiguration::shaderCacheDirectory.
+   */
+  void prewarmShaders();
+
+  /**
+   * @brief The aggregated timings and counts of the hot paths since the last
+   * @ref resetPerfStats(), by @ref core::PerfStats::name()
+   *
+   * Only the quantities with samples are included. Recorded while
+   * @ref SimulatorConfiguration::enablePerfStats is set, in
+   * @ref core::PerfStats::shared(). Also samples the memory of the streamed
+   * textures.
+   */
+  std::map<std::string, core::PerfStats::Stat> getPerfStats();
+
+  /** @brief Forget the samples of @ref getPerfStats() */
+  void resetPerfStats();
+
+  /**
+   * @brief The estimated memory of the subsystems, by name
+   *
+   * The entries of @ref assets::ResourceManager::getMemoryUsage(), plus
+   * `navmesh`, see @ref nav::PathFinder::getHostBytes(), `semantic_scene`,
+   * `render_targets`, the ones of the sensors and the pool of the renderer,
+   * and `replay`, the keyframes of the recorder. Measured when called, so
+   * it's cheap enough to poll between episodes but not every step.
+   */
+  std::map<std::string, core::MemoryUsage> getMemoryStats();
+
   bool getAgentObservationSpace(int agentId,
                                 const std::string& sensorId,
                                 sensor::ObservationSpace& space);
@@ -778,6 +1553,22 @@ class Simulator {
    */
   bool isFrustumCullingEnabled() { return frustumCulling_; }
 
+  /**
+   * @brief Enable or disable occlusion culling (disabled by default)
+   * @param val true = enable, false = disable
+   *
+   * Drawables hidden behind others when a sensor was last drawn are skipped,
+   * see @ref gfx::RenderCamera::Flag::OcclusionCulling. Visibility lags by a
+   * frame, so a drawable coming into view may be missing for one frame.
+   */
+  void setOcclusionCullingEnabled(bool val) { occlusionCulling_ = val; }
+
+  /**
+   * @brief Get status, whether occlusion culling is enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isOcclusionCullingEnabled() { return occlusionCulling_; }
+
   /**
    * @brief Get a copy of an existing @ref gfx::LightSetup by its key.
    *
@@ -845,6 +1636,29 @@ class Simulator {
       const assets::AssetInfo& assetInfo,
       const assets::RenderAssetInstanceCreationInfo& creation);
 
+  /**
+   * @brief Load and add a render asset instance to the scene graph of
+   * @p sceneId, see @ref createSceneGraph()
+   *
+   * Static instances that are only RGBD or only semantic are not supported,
+   * since the scene graph serves both.
+   */
+  scene::SceneNode* loadAndCreateRenderAssetInstance(
+      const assets::AssetInfo& assetInfo,
+      const assets::RenderAssetInstanceCreationInfo& creation,
+      int sceneId);
+
+  /**
+   * @brief Create an empty scene graph besides the active ones, e.g. for the
+   * instances of a @ref gfx::replay::Player, drawn with
+   * @ref gfx::Renderer::draw()
+   * @return The id of the scene graph, see @ref getSceneGraph()
+   */
+  int createSceneGraph();
+
+  /** @brief The scene graph of @p sceneId */
+  scene::SceneGraph& getSceneGraph(int sceneId);
+
  protected:
   Simulator(){};
 
@@ -861,7 +1675,63 @@ class Simulator {
 
   void reconfigureReplayManager();
 
-  gfx::WindowlessContext::uptr context_ = nullptr;
+  //! @ref reconfigure(), recorded in @ref startupProfile_. Returns whether
+  //! the stage was loaded.
+  bool reconfigureInternal(const SimulatorConfiguration& cfg);
+
+  //! The stage collision mesh joined with the STATIC objects if requested,
+  //! what the navmesh is computed from
+  std::unique_ptr<assets::MeshData> joinNavMeshGeometry(
+      bool includeStaticObjects);
+
+  //! The collision mesh of an object, in the frame of the scene
+  std::unique_ptr<assets::MeshData> joinObjectCollisionMesh(int objectID);
+
+  //! The cached collision mesh of an object, see
+  //! assets::ResourceManager::getJoinedCollisionMesh(), and in @p transform
+  //! its transformation into the frame of the scene
+  std::shared_ptr<const assets::MeshData> getObjectCollisionMesh(
+      int objectID,
+      Magnum::Matrix4& transform);
+
+  //! Refresh the visualization after @p pathfinder changed
+  void refreshNavMeshVisualization(const nav::PathFinder& pathfinder);
+
+  //! Load @ref pendingNavmeshFilename_ if it arrived, see
+  //! @ref loadStreamedFiles()
+  bool loadStreamedNavMesh();
+
+  //! Parts of a stage loaded by @ref prefetchScene() and
+  //! @ref preloadScene()
+  struct PrefetchedScene {
+    std::string stageFilename;
+    std::string navmeshFilename;
+    std::string houseFilename;
+    nav::PathFinder::ptr pathfinder;
+    std::shared_ptr<scene::SemanticScene> semanticScene;
+  };
+
+  //! What to load for the stage of @p cfg: its file names in @p prefetched,
+  //! and the files to warm the OS file cache with. False if it has no stage
+  //! in the active dataset of @p metadataMediator.
+  static bool describePrefetch(const SimulatorConfiguration& cfg,
+                               metadata::MetadataMediator& metadataMediator,
+                               PrefetchedScene& prefetched,
+                               assets::AssetType& stageType,
+                               std::vector<std::string>& assetFilenames);
+
+  //! Load the navmesh and semantic scene described in @p prefetched
+  static void loadPrefetch(PrefetchedScene& prefetched,
+                           assets::AssetType stageType,
+                           const std::vector<std::string>& assetFilenames,
+                           const std::string& semanticSceneCacheDirectory);
+
+  //! The stages loaded by @ref preloadScene(), by stage file name
+  static std::map<std::string, PrefetchedScene>& preloadedScenes();
+
+  // shared with the simulators forked from this one and its siblings, see
+  // fork() and createSibling()
+  gfx::WindowlessContext::ptr context_ = nullptr;
   std::shared_ptr<gfx::Renderer> renderer_ = nullptr;
   // CANNOT make the specification of resourceManager_ above the context_!
   // Because when deconstructing the resourceManager_, it needs
@@ -869,7 +1739,7 @@ class Simulator {
   // If you switch the order, you will have the error:
   // GL::Context::current(): no current context from Magnum
   // during the deconstruction
-  std::unique_ptr<assets::ResourceManager> resourceManager_ = nullptr;
+  std::shared_ptr<assets::ResourceManager> resourceManager_ = nullptr;
 
   // Owns and manages the metadata/attributes managers
   metadata::MetadataMediator::ptr metadataMediator_ = nullptr;
@@ -888,7 +1758,14 @@ class Simulator {
   SimulatorConfiguration config_;
 
   std::vector<agent::Agent::ptr> agents_;
+  //! Takes the actions of @ref actBodies(), filtered by @ref pathfinder_
+  scene::ObjectControls bodyControls_;
   nav::PathFinder::ptr pathfinder_;
+  //! The navmesh still pending at SimulatorConfiguration::fileProvider
+  std::string pendingNavmeshFilename_;
+  //! Whether the navmesh of @ref pathfinder_ isn't the one of the stage,
+  //! stored by @ref saveCheckpoint()
+  bool navMeshModified_ = false;
   // state indicating frustum culling is enabled or not
   //
   // TODO:
@@ -899,6 +1776,9 @@ class Simulator {
   // Currently, we need it defined here, because sensor., e.g., PinholeCamera
   // rquires it when drawing the observation
   bool frustumCulling_ = true;
+  // state indicating occlusion culling is enabled or not, same caveat as
+  // frustumCulling_ above
+  bool occlusionCulling_ = false;
 
   //! NavMesh visualization variables
   int navMeshVisPrimID_ = esp::ID_UNDEFINED;
@@ -915,6 +1795,12 @@ class Simulator {
    */
   Corrade::Containers::Optional<bool> requiresTextures_;
 
+  //! Runs @ref prefetchScene(), created on first use
+  std::unique_ptr<core::ThreadPool> prefetchThread_;
+  std::future<PrefetchedScene> prefetchedScene_;
+
+  core::StartupProfile startupProfile_;
+
   ESP_SMART_POINTERS(Simulator)
 };
 
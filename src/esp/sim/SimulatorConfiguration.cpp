@@ -15,10 +15,39 @@ bool operator==(const SimulatorConfiguration& a,
          a.compressTextures == b.compressTextures &&
          a.createRenderer == b.createRenderer &&
          a.allowSliding == b.allowSliding &&
+         a.kinematicAgentCollisions == b.kinematicAgentCollisions &&
+         a.agentCollisionRadius == b.agentCollisionRadius &&
+         a.agentCollisionHeight == b.agentCollisionHeight &&
          a.frustumCulling == b.frustumCulling &&
+         a.occlusionCulling == b.occlusionCulling &&
          a.enablePhysics == b.enablePhysics &&
          a.loadSemanticMesh == b.loadSemanticMesh &&
          a.requiresTextures == b.requiresTextures &&
+         a.generateMeshLods == b.generateMeshLods &&
+         a.mergeStaticMeshes == b.mergeStaticMeshes &&
+         a.bakeStaticLighting == b.bakeStaticLighting &&
+         a.pbrImageBasedLighting == b.pbrImageBasedLighting &&
+         a.releaseStageMeshData == b.releaseStageMeshData &&
+         a.stageCollisionSimplification == b.stageCollisionSimplification &&
+         a.compressVertexFormats == b.compressVertexFormats &&
+         a.textureMemoryBudget == b.textureMemoryBudget &&
+         a.assetCacheHostBudget == b.assetCacheHostBudget &&
+         a.assetCacheGpuBudget == b.assetCacheGpuBudget &&
+         a.meshCacheDirectory.compare(b.meshCacheDirectory) == 0 &&
+         a.bakedLightingCacheDirectory.compare(
+             b.bakedLightingCacheDirectory) == 0 &&
+         a.compressedTextureCacheDirectory.compare(
+             b.compressedTextureCacheDirectory) == 0 &&
+         a.shaderCacheDirectory.compare(b.shaderCacheDirectory) == 0 &&
+         a.imageBasedLightingCacheDirectory.compare(
+             b.imageBasedLightingCacheDirectory) == 0 &&
+         a.ptexConversionDirectory.compare(b.ptexConversionDirectory) == 0 &&
+         a.ptexConversionTileResolution == b.ptexConversionTileResolution &&
+         a.semanticSceneCacheDirectory.compare(
+             b.semanticSceneCacheDirectory) == 0 &&
+         a.fileProvider == b.fileProvider &&
+         a.enablePerfStats == b.enablePerfStats &&
+         a.threadBudget == b.threadBudget &&
          a.physicsConfigFile.compare(b.physicsConfigFile) == 0 &&
          a.sceneDatasetConfigFile.compare(b.sceneDatasetConfigFile) == 0 &&
          a.sceneLightSetup.compare(b.sceneLightSetup) == 0;
@@ -29,5 +58,25 @@ bool operator!=(const SimulatorConfiguration& a,
   return !(a == b);
 }
 
+bool requiresStageReload(const SimulatorConfiguration& a,
+                         const SimulatorConfiguration& b) {
+  return a.activeSceneID.compare(b.activeSceneID) != 0 ||
+         a.gpuDeviceId != b.gpuDeviceId ||
+         a.compressTextures != b.compressTextures ||
+         a.createRenderer != b.createRenderer ||
+         a.frustumCulling != b.frustumCulling ||
+         a.enablePhysics != b.enablePhysics ||
+         a.enableGfxReplaySave != b.enableGfxReplaySave ||
+         a.loadSemanticMesh != b.loadSemanticMesh ||
+         a.forceSeparateSemanticSceneGraph !=
+             b.forceSeparateSemanticSceneGraph ||
+         a.requiresTextures != b.requiresTextures ||
+         a.pbrImageBasedLighting != b.pbrImageBasedLighting ||
+         a.stageCollisionSimplification != b.stageCollisionSimplification ||
+         a.physicsConfigFile.compare(b.physicsConfigFile) != 0 ||
+         a.sceneDatasetConfigFile.compare(b.sceneDatasetConfigFile) != 0 ||
+         a.sceneLightSetup.compare(b.sceneLightSetup) != 0;
+}
+
 }  // namespace sim
 }  // namespace esp
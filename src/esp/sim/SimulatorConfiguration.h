@@ -5,12 +5,16 @@
 #ifndef ESP_SIM_SIMULATORCONFIGURATION_H_
 #define ESP_SIM_SIMULATORCONFIGURATION_H_
 
+#include <memory>
 #include <string>
 
 #include "esp/core/esp.h"
 #include "esp/physics/configure.h"
 
 namespace esp {
+namespace assets {
+class FileProvider;
+}
 
 namespace sim {
 struct SimulatorConfiguration {
@@ -19,6 +23,10 @@ struct SimulatorConfiguration {
    */
   std::string activeSceneID;
   int defaultAgentId = 0;
+  /**
+   * @brief CUDA device id of the GPU to render on, gfx::AUTO_GPU_DEVICE for
+   * the least loaded one, see gfx::leastLoadedGpuDevice()
+   */
   int gpuDeviceId = 0;
   unsigned int randomSeed = 0;
   std::string defaultCameraUuid = "rgba_camera";
@@ -26,8 +34,20 @@ struct SimulatorConfiguration {
   bool createRenderer = true;
   // Whether or not the agent can slide on collisions
   bool allowSliding = true;
+  /**
+   * @brief Whether the moves of the agents are also blocked by the stage and
+   * the objects, see @ref Simulator::collideAgentMoves(). Requires
+   * @ref enablePhysics.
+   */
+  bool kinematicAgentCollisions = false;
+  /** @brief The radius and height of the bodies of the agents collided */
+  float agentCollisionRadius = 0.1f;
+  float agentCollisionHeight = 1.5f;
   // enable or disable the frustum culling
   bool frustumCulling = true;
+  // enable or disable temporal occlusion culling, see
+  // gfx::RenderCamera::Flag::OcclusionCulling
+  bool occlusionCulling = false;
   /**
    * @brief This flags specifies whether or not dynamics is supported by the
    * simulation, if a suitable library (i.e. Bullet) has been installed.
@@ -53,6 +73,133 @@ struct SimulatorConfiguration {
    * for RGB rendering
    */
   bool requiresTextures = true;
+  /**
+   * @brief Whether to generate coarser levels of detail of the meshes of
+   * general assets when they are loaded, see
+   * assets::ResourceManager::setGenerateMeshLods()
+   */
+  bool generateMeshLods = false;
+  /**
+   * @brief Whether static instances of general assets, e.g. stages, draw
+   * their meshes merged by material, see
+   * assets::ResourceManager::setMergeStaticMeshes()
+   */
+  bool mergeStaticMeshes = false;
+  /**
+   * @brief Whether static instances of general assets drawn merged bake the
+   * lighting of their light setup into vertex colors, so that it costs
+   * nothing per frame, see assets::ResourceManager::setBakeStaticLighting()
+   */
+  bool bakeStaticLighting = false;
+  /**
+   * @brief Whether the PBR materials are lit by the environment of the stage
+   * too, captured from the center of its bounding box when it is loaded,
+   * see assets::ResourceManager::loadImageBasedLighting()
+   */
+  bool pbrImageBasedLighting = false;
+  /**
+   * @brief Whether stages loaded without physics free the CPU copies of
+   * their meshes once uploaded, re-reading them when needed, e.g. to
+   * recompute the navmesh, see
+   * assets::ResourceManager::setReleaseStageMeshData()
+   */
+  bool releaseStageMeshData = false;
+  /**
+   * @brief The error the collision meshes of stages without a collision
+   * asset are simplified with, for physics and the navmesh, in the units of
+   * the stage. 0 to use the render meshes, see
+   * assets::ResourceManager::setStageCollisionSimplification()
+   */
+  float stageCollisionSimplification = 0.0f;
+  /**
+   * @brief Whether the meshes of general assets are uploaded with 16-bit
+   * normals, tangents and texture coordinates, see
+   * assets::ResourceManager::setCompressVertexFormats()
+   */
+  bool compressVertexFormats = false;
+  /**
+   * @brief GPU memory budget of the textures of general assets loaded
+   * afterwards, in bytes. If not 0 the textures are streamed, see
+   * assets::ResourceManager::setTextureMemoryBudget()
+   */
+  std::size_t textureMemoryBudget = 0;
+  /**
+   * @brief CPU and GPU memory budgets of the loaded assets, in bytes, 0 for
+   * none. Over budget the assets only the previous stages used are freed
+   * when the stage changes, least recently used first, see
+   * assets::ResourceManager::setAssetCacheBudget()
+   */
+  std::size_t assetCacheHostBudget = 0;
+  std::size_t assetCacheGpuBudget = 0;
+  /**
+   * @brief Directory caching the processed meshes of general assets, shared
+   * by the simulators loading the same dataset. Empty to disable, see
+   * assets::ResourceManager::setMeshCacheDirectory()
+   */
+  std::string meshCacheDirectory;
+  /**
+   * @brief Directory caching the lighting baked by @ref bakeStaticLighting,
+   * per asset and light setup. Empty to disable, see
+   * assets::ResourceManager::setBakedLightingCacheDirectory()
+   */
+  std::string bakedLightingCacheDirectory;
+  /**
+   * @brief Directory caching the textures compressed by @ref compressTextures,
+   * by the hash of their images. Empty to disable, see
+   * assets::ResourceManager::setCompressedTextureCacheDirectory()
+   */
+  std::string compressedTextureCacheDirectory;
+  /**
+   * @brief Directory caching the linked shader programs, so that they are
+   * compiled once per driver instead of once per process. Empty to disable,
+   * see assets::ResourceManager::setShaderCacheDirectory()
+   */
+  std::string shaderCacheDirectory;
+  /**
+   * @brief Directory caching the maps of @ref pbrImageBasedLighting, per
+   * stage, so that they are computed once. Empty to disable, see
+   * assets::ResourceManager::setImageBasedLightingCacheDirectory()
+   */
+  std::string imageBasedLightingCacheDirectory;
+  /**
+   * @brief Directory of the PTex stages converted to general assets, drawn
+   * by the flat shader instead of the PTex one. Empty to draw them with the
+   * PTex shader, see assets::ResourceManager::setPTexConversionDirectory()
+   */
+  std::string ptexConversionDirectory;
+  /**
+   * @brief The texels along the side of a face in the atlases of the PTex
+   * stages converted into @ref ptexConversionDirectory, 0 for the tile size
+   * of the PTex atlases less two
+   */
+  int ptexConversionTileResolution = 0;
+  /**
+   * @brief Directory caching the parsed semantic scenes of the stages, so
+   * that their house files are parsed once instead of at every load. Empty
+   * to disable, see scene::SemanticScene::saveCache()
+   */
+  std::string semanticSceneCacheDirectory;
+  /**
+   * @brief Supplies the files of the stage and its navmesh instead of the
+   * filesystem, e.g. as they are downloaded, see
+   * assets::ResourceManager::setFileProvider() and
+   * Simulator::loadStreamedFiles(). nullptr reads the filesystem.
+   */
+  std::shared_ptr<assets::FileProvider> fileProvider;
+  /**
+   * @brief Record the timings and counts of the hot paths, see
+   * Simulator::getPerfStats(). They are shared by the simulators of the
+   * process, the last one configured decides.
+   */
+  bool enablePerfStats = false;
+  /**
+   * @brief The number of threads the process computes on, the share of the
+   * cores of each process when several run on a node. 0 keeps the current
+   * budget, the hardware concurrency by default. Shared by the simulators of
+   * the process, the last one configured decides, see
+   * core::ThreadPool::setThreadBudget()
+   */
+  std::size_t threadBudget = 0;
   std::string physicsConfigFile = ESP_DEFAULT_PHYSICS_CONFIG_REL_PATH;
 
   /**
@@ -70,6 +217,16 @@ bool operator==(const SimulatorConfiguration& a,
 bool operator!=(const SimulatorConfiguration& a,
                 const SimulatorConfiguration& b);
 
+/**
+ * @brief Whether going from configuration @p a to @p b needs the stage to be
+ * loaded again. Only the random seed, the default agent and camera, sliding,
+ * occlusion culling, mesh LOD generation, the texture memory budget, the
+ * mesh cache directory and the file provider can change without it; the last
+ * four only affect assets loaded afterwards.
+ */
+bool requiresStageReload(const SimulatorConfiguration& a,
+                         const SimulatorConfiguration& b);
+
 }  // namespace sim
 }  // namespace esp
 
@@ -0,0 +1,88 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "VectorSimulator.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "esp/core/ThreadPool.h"
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace sim {
+
+VectorSimulator::VectorSimulator(std::vector<Simulator::ptr> envs)
+    : envs_{std::move(envs)} {
+  if (envs_.empty()) {
+    throw std::runtime_error("VectorSimulator: expected an environment");
+  }
+  for (const Simulator::ptr& env : envs_) {
+    if (env == nullptr || env->getRenderer() != envs_[0]->getRenderer()) {
+      throw std::runtime_error(
+          "VectorSimulator: the environments have to share a renderer");
+    }
+  }
+}
+
+VectorSimulator::ptr VectorSimulator::fork(const Simulator::ptr& base,
+                                           const int numEnvs) {
+  if (numEnvs <= 0) {
+    throw std::runtime_error(
+        "VectorSimulator::fork(): expected a positive number of environments");
+  }
+  std::vector<Simulator::ptr> envs{base};
+  for (int i = 1; i < numEnvs; ++i) {
+    envs.push_back(base->fork());
+  }
+  return VectorSimulator::create(std::move(envs));
+}
+
+VectorSimulator::ptr VectorSimulator::withScenes(
+    const Simulator::ptr& base,
+    const std::vector<SimulatorConfiguration>& cfgs) {
+  std::vector<Simulator::ptr> envs{base};
+  for (const SimulatorConfiguration& cfg : cfgs) {
+    envs.push_back(base->createSibling(cfg));
+  }
+  return VectorSimulator::create(std::move(envs));
+}
+
+void VectorSimulator::seed(const uint32_t newSeed) {
+  for (std::size_t i = 0; i < envs_.size(); ++i) {
+    envs_[i]->seed(newSeed + i);
+  }
+}
+
+std::vector<double> VectorSimulator::stepWorld(const double dt) {
+  std::vector<double> worldTimes(envs_.size());
+  core::ThreadPool& pool = core::ThreadPool::shared();
+  pool.parallelFor(envs_.size(), pool.numThreads() + 1,
+                   [&](std::size_t i, std::size_t) {
+                     worldTimes[i] = envs_[i]->stepWorld(dt);
+                   });
+  return worldTimes;
+}
+
+bool VectorSimulator::drawAndReadObservations(
+    const std::vector<
+        std::map<int, std::map<std::string, Cr::Containers::ArrayView<void>>>>&
+        buffers) {
+  if (buffers.size() != envs_.size()) {
+    LOG(ERROR) << "VectorSimulator::drawAndReadObservations : expected the "
+                  "buffers of "
+               << envs_.size() << " environments, got " << buffers.size();
+    return false;
+  }
+  std::vector<Simulator::PendingObservationRead> reads;
+  bool success = true;
+  for (std::size_t i = 0; i < envs_.size(); ++i) {
+    success = envs_[i]->drawObservations(buffers[i], reads) && success;
+  }
+  return Simulator::readObservations(reads) && success;
+}
+
+}  // namespace sim
+}  // namespace esp
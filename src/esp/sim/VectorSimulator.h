@@ -0,0 +1,109 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SIM_VECTORSIMULATOR_H_
+#define ESP_SIM_VECTORSIMULATOR_H_
+
+/** @file
+ * @brief Class @ref esp::sim::VectorSimulator
+ */
+
+#include <Corrade/Containers/ArrayView.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+#include "Simulator.h"
+
+namespace esp {
+namespace sim {
+
+/**
+ * @brief Several environments in one process, sharing one OpenGL context,
+ * renderer and asset cache, stepped in batches
+ *
+ * The environments are @ref Simulator s forked from the same one or
+ * siblings of it, see @ref Simulator::fork() and
+ * @ref Simulator::createSibling(), so the shaders are compiled and the
+ * assets loaded once for all of them. The CPU work that the environments
+ * don't share, the physics, runs on the workers of
+ * @ref core::ThreadPool::shared(). The GPU work stays on the thread of the
+ * context: the sensors of all environments are drawn before any is read, so
+ * that the reads overlap with the drawing.
+ */
+class VectorSimulator {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param[in] envs The environments, sharing the renderer of the first, e.g.
+   *                 forked from it
+   * @throws std::runtime_error if there is no environment or they don't share
+   * a renderer
+   */
+  explicit VectorSimulator(std::vector<Simulator::ptr> envs);
+
+  /**
+   * @brief Create @p numEnvs environments, @p base and copies of it
+   *
+   * @throws std::runtime_error if @p numEnvs isn't positive or @p base can't
+   * be forked
+   */
+  static std::shared_ptr<VectorSimulator> fork(const Simulator::ptr& base,
+                                               int numEnvs);
+
+  /**
+   * @brief Create an environment per configuration after @p base, each of
+   * its own scene, see @ref Simulator::createSibling()
+   *
+   * @throws std::runtime_error if a configuration can't be a sibling of
+   * @p base
+   */
+  static std::shared_ptr<VectorSimulator> withScenes(
+      const Simulator::ptr& base,
+      const std::vector<SimulatorConfiguration>& cfgs);
+
+  /** @brief The number of environments */
+  int numEnvs() const { return envs_.size(); }
+
+  /** @brief An environment */
+  Simulator::ptr getSimulator(int env) const { return envs_.at(env); }
+
+  /** @brief Seed the environment @p env with @p newSeed + @p env */
+  void seed(uint32_t newSeed);
+
+  /**
+   * @brief Step the physics of all environments concurrently
+   *
+   * @return The world time of each environment
+   */
+  std::vector<double> stepWorld(double dt = 1.0 / 60.0);
+
+  /**
+   * @brief @ref Simulator::drawAndReadObservations() for all environments
+   *
+   * Every sensor is drawn before any is read.
+   * @param buffers The buffers of @ref Simulator::drawAndReadObservations()
+   * of each environment
+   * @return Whether every observation could be drawn and read
+   */
+  bool drawAndReadObservations(
+      const std::vector<std::map<
+          int,
+          std::map<std::string, Corrade::Containers::ArrayView<void>>>>&
+          buffers);
+
+ private:
+  std::vector<Simulator::ptr> envs_;
+
+  ESP_SMART_POINTERS(VectorSimulator)
+};
+
+}  // namespace sim
+}  // namespace esp
+
+#endif  // ESP_SIM_VECTORSIMULATOR_H_
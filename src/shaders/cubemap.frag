@@ -0,0 +1,86 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+precision highp float;
+
+// -------------- input ---------------------
+in highp vec2 textureCoordinates;
+
+#if defined(FISHEYE)
+// field of view in radians, spanning the diameter of the image circle
+uniform highp float FieldOfView;
+// height / width of the output image
+uniform highp float AspectRatio;
+#endif
+
+#if defined(COLOR_TEXTURE)
+uniform lowp samplerCube ColorTexture;
+#endif
+#if defined(DEPTH_TEXTURE)
+uniform highp samplerCube DepthTexture;
+// see calculateDepthUnprojection(), the cube map and the output have the same
+// near and far planes
+uniform highp vec2 DepthUnprojection;
+#endif
+#if defined(OBJECT_ID_TEXTURE)
+uniform highp usamplerCube ObjectIdTexture;
+#endif
+
+// -------------- output -------------------
+#if defined(COLOR_TEXTURE)
+layout(location = OUTPUT_ATTRIBUTE_LOCATION_COLOR) out lowp vec4 fragmentColor;
+#endif
+#if defined(OBJECT_ID_TEXTURE)
+layout(location = OUTPUT_ATTRIBUTE_LOCATION_OBJECT_ID) out highp uint
+    fragmentObjectId;
+#endif
+
+const highp float PI = 3.14159265358979;
+
+void main() {
+  // view direction in camera space, looking down -Z with +Y up
+#if defined(FISHEYE)
+  // equidistant fisheye: the angle from the optical axis grows linearly with
+  // the distance from the image center
+  highp vec2 p = (textureCoordinates*2.0 - vec2(1.0))*vec2(1.0, AspectRatio);
+  highp float r = length(p);
+  if (r > 1.0) {
+    discard;
+  }
+  highp float theta = r*0.5*FieldOfView;
+  highp vec2 axis = r > 0.0 ? p/r : vec2(0.0);
+  highp vec3 direction = vec3(sin(theta)*axis, -cos(theta));
+#else
+  highp float longitude = (textureCoordinates.x - 0.5)*2.0*PI;
+  highp float latitude = (textureCoordinates.y - 0.5)*PI;
+  highp vec3 direction = vec3(sin(longitude)*cos(latitude), sin(latitude),
+                              -cos(longitude)*cos(latitude));
+#endif
+
+  // see CubeMapCamera::cameraLocalTransform()
+  highp vec3 cubeDirection = vec3(-direction.x, direction.y, -direction.z);
+
+#if defined(COLOR_TEXTURE)
+  fragmentColor = texture(ColorTexture, cubeDirection);
+#endif
+#if defined(OBJECT_ID_TEXTURE)
+  fragmentObjectId = texture(ObjectIdTexture, cubeDirection).r;
+#endif
+#if defined(DEPTH_TEXTURE)
+  highp float depth = texture(DepthTexture, cubeDirection).r;
+  if (depth == 1.0) {
+    // nothing was drawn there
+    gl_FragDepth = 1.0;
+  } else {
+    // the depth along the axis of the face the direction falls into
+    highp float z = DepthUnprojection[1]/(depth + DepthUnprojection[0]);
+    highp vec3 a = abs(direction);
+    highp float distance = z/max(a.x, max(a.y, a.z));
+    // store the distance along the ray, such that unprojecting the depth
+    // buffer of the output yields it directly
+    gl_FragDepth = clamp(DepthUnprojection[1]/distance - DepthUnprojection[0],
+                         0.0, 1.0);
+  }
+#endif
+}
@@ -0,0 +1,16 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+out highp vec2 textureCoordinates;
+
+void main() {
+  // a full-screen triangle
+  gl_Position = vec4((gl_VertexID == 2) ?  3.0 : -1.0,
+                     (gl_VertexID == 1) ? -3.0 :  1.0, 0.0, 1.0);
+  textureCoordinates = gl_Position.xy*0.5 + vec2(0.5);
+  #ifdef TOP_DOWN_ROWS
+  // the first rows of the render target are the top of the image
+  gl_Position.y = -gl_Position.y;
+  #endif
+}
@@ -7,10 +7,62 @@ in highp vec2 textureCoordinates;
 in highp float depth;
 #endif
 
+#if defined(RECONSTRUCT_NORMALS) || defined(UNPROJECT_POINTS)
+uniform highp vec2 pixelUnprojection;
+
+#ifdef RECONSTRUCT_NORMALS
+out highp vec4 normal;
+#else
+uniform highp mat4 pointTransformation;
+uniform int pointStride;
+
+out highp vec4 point;
+#endif
+
+/* The camera frame point seen at the center of a pixel */
+highp vec3 unprojectPixel(ivec2 pixel, ivec2 size) {
+  highp float d = texelFetch(depthTexture, pixel, 0).r;
+  highp float forward = depthUnprojection[1] / (d + depthUnprojection[0]);
+  highp vec2 ndc = (vec2(pixel) + vec2(0.5))/vec2(size)*2.0 - vec2(1.0);
+  return vec3(ndc*pixelUnprojection*forward, -forward);
+}
+#else
 out highp float originalDepth;
+#endif
 
 void main() {
-  #ifdef UNPROJECT_EXISTING_DEPTH
+  #ifdef RECONSTRUCT_NORMALS
+  ivec2 size = textureSize(depthTexture, 0);
+  ivec2 pixel = ivec2(gl_FragCoord.xy);
+  if (texelFetch(depthTexture, pixel, 0).r == 1.0) {
+    normal = vec4(0.0);
+    return;
+  }
+  highp vec3 center = unprojectPixel(pixel, size);
+  highp vec3 left = unprojectPixel(max(pixel - ivec2(1, 0), ivec2(0)), size);
+  highp vec3 right = unprojectPixel(min(pixel + ivec2(1, 0), size - 1), size);
+  highp vec3 below = unprojectPixel(max(pixel - ivec2(0, 1), ivec2(0)), size);
+  highp vec3 above = unprojectPixel(min(pixel + ivec2(0, 1), size - 1), size);
+  /* Of the two neighbors along each axis, the one on the same surface is the
+     closer in depth, so normals don't bleed over depth discontinuities */
+  highp vec3 dx = abs(right.z - center.z) < abs(center.z - left.z) ?
+    right - center : center - left;
+  highp vec3 dy = abs(above.z - center.z) < abs(center.z - below.z) ?
+    above - center : center - below;
+  /* A vertically flipped projection mirrors dy */
+  highp float handedness = sign(pixelUnprojection.x*pixelUnprojection.y);
+  normal = vec4(normalize(cross(dx, dy))*handedness, 0.0);
+  #elif defined(UNPROJECT_POINTS)
+  ivec2 size = textureSize(depthTexture, 0);
+  /* The center of the block of pixels this one subsamples */
+  ivec2 pixel = min(ivec2(gl_FragCoord.xy)*pointStride + ivec2(pointStride/2),
+                    size - 1);
+  if (texelFetch(depthTexture, pixel, 0).r == 1.0) {
+    point = vec4(0.0);
+    return;
+  }
+  point = pointTransformation*vec4(unprojectPixel(pixel, size), 1.0);
+  #elif defined(UNPROJECT_EXISTING_DEPTH)
   highp float depth = texture(depthTexture, textureCoordinates).r;
   originalDepth =
     #ifndef NO_FAR_PLANE_PATCHING
@@ -0,0 +1,35 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+precision highp float;
+
+in highp vec2 textureCoordinates;
+
+uniform lowp sampler2D FoveatedTexture;
+// fraction of the output covered by the inset, centered
+uniform highp float InsetSize;
+// offset and size of the inset and the periphery in FoveatedTexture
+uniform highp vec4 InsetRange;
+uniform highp vec4 PeripheryRange;
+
+out lowp vec4 fragmentColor;
+
+/* Sample a view at coordinates in [0, 1], kept half a texel inside so the
+   linear filtering doesn't bleed in the other view */
+lowp vec4 sampleView(highp vec4 range, highp vec2 coordinates) {
+  highp vec2 halfTexel = vec2(0.5)/vec2(textureSize(FoveatedTexture, 0));
+  return texture(FoveatedTexture,
+                 clamp(range.xy + coordinates*range.zw, range.xy + halfTexel,
+                       range.xy + range.zw - halfTexel));
+}
+
+void main() {
+  highp vec2 inset = (textureCoordinates - vec2(0.5))/InsetSize + vec2(0.5);
+  if (all(greaterThanEqual(inset, vec2(0.0))) &&
+      all(lessThanEqual(inset, vec2(1.0)))) {
+    fragmentColor = sampleView(InsetRange, inset);
+  } else {
+    fragmentColor = sampleView(PeripheryRange, textureCoordinates);
+  }
+}
@@ -0,0 +1,10 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// added to the bin by the blending
+out highp float count;
+
+void main() {
+  count = 1.0;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+uniform highp usampler2D ObjectIdTexture;
+// the table of the remapping, wrapped in rows of the texture width
+uniform highp usampler2D TableTexture;
+uniform bool RemapIds;
+uniform highp uint TableSize;
+uniform highp uint UnmappedValue;
+
+// the bins, wrapped in rows of the width of the histogram
+uniform highp uint BinCount;
+uniform highp ivec2 HistogramSize;
+
+// the first pixel counted, the columns of the counted region and the
+// stride between the pixels counted
+uniform highp ivec2 RegionOrigin;
+uniform highp int RegionColumns;
+uniform highp int Stride;
+
+void main() {
+  // one point per counted pixel
+  highp ivec2 pixel = RegionOrigin +
+    Stride*ivec2(gl_VertexID % RegionColumns, gl_VertexID / RegionColumns);
+  highp uint id = texelFetch(ObjectIdTexture, pixel, 0).r;
+  if (RemapIds) {
+    if (id >= TableSize) {
+      id = UnmappedValue;
+    } else {
+      highp uint width = uint(textureSize(TableTexture, 0).x);
+      id = texelFetch(TableTexture,
+                      ivec2(int(id % width), int(id / width)), 0).r;
+    }
+  }
+
+  gl_PointSize = 1.0;
+  if (id >= BinCount) {
+    // outside of the clip volume, not counted
+    gl_Position = vec4(2.0, 2.0, 0.0, 1.0);
+    return;
+  }
+  highp ivec2 bin = ivec2(int(id) % HistogramSize.x,
+                          int(id) / HistogramSize.x);
+  gl_Position = vec4((vec2(bin) + vec2(0.5))/vec2(HistogramSize)*2.0 -
+                     vec2(1.0), 0.0, 1.0);
+}
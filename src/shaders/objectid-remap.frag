@@ -0,0 +1,22 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+uniform highp usampler2D ObjectIdTexture;
+// the table, wrapped in rows of the texture width
+uniform highp usampler2D TableTexture;
+uniform highp uint TableSize;
+uniform highp uint UnmappedValue;
+
+out highp uint remappedObjectId;
+
+void main() {
+  highp uint id = texelFetch(ObjectIdTexture, ivec2(gl_FragCoord.xy), 0).r;
+  if (id >= TableSize) {
+    remappedObjectId = UnmappedValue;
+    return;
+  }
+  highp uint width = uint(textureSize(TableTexture, 0).x);
+  remappedObjectId =
+    texelFetch(TableTexture, ivec2(int(id % width), int(id / width)), 0).r;
+}
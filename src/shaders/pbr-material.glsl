@@ -0,0 +1,18 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// The materials of all draws in one uniform buffer, a range of it bound per
+// draw. The std140 layout has to match PbrMaterialBuffer::Uniforms.
+struct MaterialData {
+  highp vec4 baseColor;
+  highp float roughness;
+  highp float metallic;
+  highp vec3 emissiveColor;
+};
+
+layout(std140) uniform MaterialBlock {
+  MaterialData Material;
+  highp mat3 TextureMatrix;
+  highp float NormalTextureScale;
+};
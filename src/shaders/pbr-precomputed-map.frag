@@ -0,0 +1,173 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// The precomputed maps of the split sum approximation of image based
+// lighting in
+// Karis, Brian. “Real Shading in Unreal Engine 4 by.” (2013).
+// The environment is sampled with the filtered importance sampling of
+// Křivánek, Jaroslav, and Mark Colbert. “Real-time Shading with Filtered
+// Importance Sampling.” (2008), from the mip levels covering the solid angle
+// of each sample, so few samples are enough.
+
+precision highp float;
+
+in highp vec2 textureCoordinates;
+
+layout(location = OUTPUT_ATTRIBUTE_LOCATION_COLOR) out highp vec4
+    fragmentColor;
+
+#if !defined(BRDF_LOOKUP_TABLE)
+uniform samplerCube EnvironmentMap;
+// the face drawn into, in the order of the cube map coordinates
+uniform int Face;
+#endif
+#if defined(PREFILTERED_MAP)
+uniform float Roughness;
+#endif
+
+const float PI = 3.14159265359;
+const uint SampleCount = 512u;
+
+// the low-discrepancy sample i of n
+vec2 hammersley(uint i, uint n) {
+  uint bits = (i << 16u) | (i >> 16u);
+  bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+  bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+  bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+  bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+  return vec2(float(i) / float(n), float(bits) * 2.3283064365386963e-10);
+}
+
+// a half vector around +Z distributed like the GGX normal distribution
+vec3 importanceSampleGgx(vec2 xi, float roughness) {
+  float a = roughness * roughness;
+  float phi = 2.0 * PI * xi.x;
+  float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+  float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+  return vec3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta);
+}
+
+#if !defined(BRDF_LOOKUP_TABLE)
+// the direction of a texel of the face, see the cube map coordinates of the
+// OpenGL specification
+vec3 faceDirection(vec2 uv) {
+  vec2 p = uv * 2.0 - 1.0;
+  if (Face == 0)
+    return vec3(1.0, -p.y, -p.x);
+  if (Face == 1)
+    return vec3(-1.0, -p.y, p.x);
+  if (Face == 2)
+    return vec3(p.x, 1.0, p.y);
+  if (Face == 3)
+    return vec3(p.x, -1.0, -p.y);
+  if (Face == 4)
+    return vec3(p.x, -p.y, 1.0);
+  return vec3(-p.x, -p.y, -1.0);
+}
+
+// an orthonormal basis with n as its Z axis
+mat3 tangentFrame(vec3 n) {
+  vec3 up = abs(n.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+  vec3 t = normalize(cross(up, n));
+  return mat3(t, cross(n, t), n);
+}
+
+// the mip level of the environment whose texels cover the solid angle of a
+// sample of probability density pdf
+float sampleLevel(float pdf) {
+  float size = float(textureSize(EnvironmentMap, 0).x);
+  float sampleAngle = 1.0 / (float(SampleCount) * pdf + 0.0001);
+  float texelAngle = 4.0 * PI / (6.0 * size * size);
+  return max(0.5 * log2(sampleAngle / texelAngle) + 1.0, 0.0);
+}
+#endif
+
+#if defined(IRRADIANCE_MAP)
+// the mean of the cosine-weighted radiance around n, which is the diffuse
+// reflection of a white surface in the convention of pbr.frag
+vec3 irradiance(vec3 n) {
+  mat3 frame = tangentFrame(n);
+  vec3 sum = vec3(0.0);
+  for (uint i = 0u; i < SampleCount; ++i) {
+    vec2 xi = hammersley(i, SampleCount);
+    float phi = 2.0 * PI * xi.x;
+    float cosTheta = sqrt(1.0 - xi.y);
+    float sinTheta = sqrt(xi.y);
+    vec3 l = frame * vec3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta);
+    sum += textureLod(EnvironmentMap, l, sampleLevel(cosTheta / PI)).rgb;
+  }
+  return sum / float(SampleCount);
+}
+#endif
+
+#if defined(PREFILTERED_MAP)
+// the radiance around the reflection direction r weighted by the GGX lobe
+// of roughness, with the view along r
+vec3 prefiltered(vec3 r, float roughness) {
+  mat3 frame = tangentFrame(r);
+  float a2 = max(roughness * roughness * roughness * roughness, 1.0e-6);
+  vec3 sum = vec3(0.0);
+  float weight = 0.0;
+  for (uint i = 0u; i < SampleCount; ++i) {
+    vec3 h = frame * importanceSampleGgx(hammersley(i, SampleCount), roughness);
+    float r_dot_h = dot(r, h);
+    vec3 l = 2.0 * r_dot_h * h - r;
+    float r_dot_l = dot(r, l);
+    if (r_dot_l > 0.0) {
+      // the density of l is D(h) n.h / (4 v.h), which is D(h) / 4 for
+      // v == n == r
+      float d = r_dot_h * r_dot_h * (a2 - 1.0) + 1.0;
+      float pdf = a2 / (PI * d * d) / 4.0;
+      sum += textureLod(EnvironmentMap, l, sampleLevel(pdf)).rgb * r_dot_l;
+      weight += r_dot_l;
+    }
+  }
+  return sum / max(weight, 0.0001);
+}
+#endif
+
+#if defined(BRDF_LOOKUP_TABLE)
+// the scale and bias of F0 of the specular reflection of a uniform
+// environment
+vec2 integrateBrdf(float n_dot_v, float roughness) {
+  vec3 v = vec3(sqrt(1.0 - n_dot_v * n_dot_v), 0.0, n_dot_v);
+  // the k of the geometry term of image based lighting
+  float k = roughness * roughness / 2.0;
+  vec2 sum = vec2(0.0);
+  for (uint i = 0u; i < SampleCount; ++i) {
+    vec3 h = importanceSampleGgx(hammersley(i, SampleCount), roughness);
+    float v_dot_h = dot(v, h);
+    vec3 l = 2.0 * v_dot_h * h - v;
+    float n_dot_l = l.z;
+    if (n_dot_l > 0.0) {
+      v_dot_h = max(v_dot_h, 0.0);
+      float g = n_dot_l / (n_dot_l * (1.0 - k) + k) * n_dot_v /
+                (n_dot_v * (1.0 - k) + k);
+      float visibility = g * v_dot_h / max(h.z * n_dot_v, 0.0001);
+      float fresnel = pow(1.0 - v_dot_h, 5.0);
+      sum += vec2(1.0 - fresnel, fresnel) * visibility;
+    }
+  }
+  return sum / float(SampleCount);
+}
+#endif
+
+void main() {
+#if defined(BRDF_LOOKUP_TABLE)
+  // n.v along x, the roughness along y
+  fragmentColor = vec4(
+      integrateBrdf(max(textureCoordinates.x, 0.001), textureCoordinates.y),
+      0.0, 1.0);
+#else
+  vec3 direction = normalize(faceDirection(textureCoordinates));
+#if defined(IRRADIANCE_MAP)
+  fragmentColor = vec4(irradiance(direction), 1.0);
+#elif defined(PREFILTERED_MAP)
+  fragmentColor = vec4(prefiltered(direction, Roughness), 1.0);
+#else
+  // a copy of the environment, whose mip levels are generated after
+  fragmentColor = vec4(textureLod(EnvironmentMap, direction, 0.0).rgb, 1.0);
+#endif
+#endif
+}
@@ -26,7 +26,22 @@ layout(location = OUTPUT_ATTRIBUTE_LOCATION_OBJECT_ID) out highp uint
     fragmentObjectId;
 #endif
 
-#if (LIGHT_COUNT > 0)
+#if defined(CLUSTERED_LIGHTS) && (LIGHT_COUNT > 0)
+// -------------- clustered lights -------------------
+// the light vectors in the first row, the colors and ranges in the second,
+// the directional lights first
+uniform highp sampler2D LightData;
+// the offset into LightIndices and the count of the point lights of each
+// cluster, the slices stacked along y
+uniform highp usampler2D LightClusters;
+uniform highp usampler2D LightIndices;
+uniform int DirectionalLightCount;
+// the slice of a camera-space depth z is log(z)*x + y
+uniform highp vec2 LightClusterDepth;
+// the same as in the vertex shader, for the tile of the fragment
+uniform highp mat4 ProjectionMatrix;
+#define LIT
+#elif (LIGHT_COUNT > 0)
 // -------------- lights -------------------
 // NOTE: In this shader, the light intensity is considered in the lightColor!!
 uniform vec3 LightColors[LIGHT_COUNT];
@@ -37,9 +52,23 @@ uniform float LightRanges[LIGHT_COUNT];
 // it is NOT put in the Light Structure, simply because we may modify the code
 // so it is computed in the vertex shader.
 uniform vec4 LightDirections[LIGHT_COUNT];
+#define LIT
+#endif
+
+#if defined(IMAGE_BASED_LIGHTING) && defined(LIT)
+// -------------- image based lighting -------------------
+// see PbrImageBasedLighting, the cube maps are looked up at (-x, y, -z) of a
+// world direction
+uniform samplerCube IrradianceMap;
+uniform samplerCube PrefilteredMap;
+uniform sampler2D BrdfLookupTable;
+// from camera to world space
+uniform highp mat3 CameraRotation;
+#define ENVIRONMENT_LIT
 #endif
 
 // -------------- material, textures ------------------
+#if !defined(MATERIAL_BUFFER)
 struct MaterialData {
   vec4 baseColor;     // diffuse color, if BaseColorTexture exists,
                       // multiply it with the BaseColorTexture
@@ -51,6 +80,7 @@ struct MaterialData {
                       // multiply it the EmissiveTexture
 };
 uniform MaterialData Material;
+#endif
 
 #if defined(BASECOLOR_TEXTURE)
 uniform sampler2D BaseColorTexture;
@@ -72,7 +102,7 @@ uniform sampler2D EmissiveTexture;
 uniform highp uint ObjectId;
 #endif
 
-#if defined(NORMAL_TEXTURE) && defined(NORMAL_TEXTURE_SCALE)
+#if defined(NORMAL_TEXTURE) && defined(NORMAL_TEXTURE_SCALE) && !defined(MATERIAL_BUFFER)
 uniform mediump float NormalTextureScale
 #ifndef GL_ES
     = 1.0
@@ -216,6 +246,73 @@ vec3 microfacetModel(vec3 baseColor,
 #endif
 }
 
+#if defined(LIT)
+// the contribution of a light of lightVector, color and range, see
+// LightDirections, LightColors and LightRanges
+vec3 shadeLight(vec4 lightVector,
+                vec3 lightColor,
+                float lightRange,
+                vec3 baseColor,
+                float metallic,
+                float roughness,
+                vec3 normal,
+                vec3 view) {
+  // Attenuation. Directional lights have the .w component set to 0, use
+  // that to make the distance zero -- which will then ensure the
+  // attenuation is always 1.0
+  highp float dist = length(lightVector.xyz - position) * lightVector.w;
+  // If range is 0 for whatever reason, clamp it to a small value to
+  // avoid a NaN when dist is 0 as well (which is the case for
+  // directional lights).
+  highp float attenuation =
+      clamp(1.0 - pow(dist / max(lightRange, 0.0001), 4.0), 0.0, 1.0);
+  attenuation = attenuation * attenuation / (1.0 + dist * dist);
+
+  // radiance
+  vec3 lightRadiance = lightColor * attenuation;
+
+  // light source direction: a vector from current position to the light
+  vec3 light = normalize(lightVector.xyz - position * lightVector.w);
+
+  return microfacetModel(baseColor, metallic, roughness, normal, light, view,
+                         lightRadiance);
+}
+#endif
+
+#if defined(ENVIRONMENT_LIT)
+vec3 environmentDirection(vec3 direction) {
+  vec3 world = CameraRotation * direction;
+  return vec3(-world.x, world.y, -world.z);
+}
+
+// the reflection of the environment with the split sum approximation of
+// Karis, see the microfacet model above for the diffuse part
+vec3 imageBasedLighting(vec3 baseColor,
+                        float metallic,
+                        float roughness,
+                        vec3 normal,
+                        vec3 view) {
+#if defined(DOUBLE_SIDED)
+  // the side facing the camera reflects
+  if (dot(normal, view) < 0.0) {
+    normal = -normal;
+  }
+#endif
+  float n_dot_v = clamp(dot(normal, view), 0.0, 1.0);
+  vec3 F0 = mix(vec3(0.04), baseColor, metallic);
+  vec3 diffuse = mix(vec3(1.0) - F0, vec3(0.0), metallic) * baseColor *
+                 texture(IrradianceMap, environmentDirection(normal)).rgb;
+
+  vec3 reflection = reflect(-view, normal);
+  vec3 prefiltered =
+      textureLod(PrefilteredMap, environmentDirection(reflection),
+                 roughness * float(PREFILTERED_MAP_LEVELS - 1))
+          .rgb;
+  vec2 brdf = texture(BrdfLookupTable, vec2(n_dot_v, roughness)).rg;
+  return diffuse + prefiltered * (F0 * brdf.x + brdf.y);
+}
+#endif
+
 void main() {
   vec3 emissiveColor = Material.emissiveColor;
 #if defined(EMISSIVE_TEXTURE)
@@ -223,7 +320,7 @@ void main() {
 #endif
   fragmentColor = vec4(emissiveColor, 0.0);
 
-#if (LIGHT_COUNT > 0)
+#if defined(LIT)
   vec4 baseColor = Material.baseColor;
 #if defined(BASECOLOR_TEXTURE)
   baseColor *= texture(BaseColorTexture, texCoord);
@@ -256,34 +353,50 @@ void main() {
   // compute contribution of each light using the microfacet model
   // the following part of the code is inspired by the Phong.frag in Magnum
   // library (https://magnum.graphics/)
+#if defined(CLUSTERED_LIGHTS)
+  for (int iLight = 0; iLight < DirectionalLightCount; ++iLight) {
+    vec4 color = texelFetch(LightData, ivec2(iLight, 1), 0);
+    finalColor += shadeLight(texelFetch(LightData, ivec2(iLight, 0), 0),
+                             color.rgb, color.a, baseColor.rgb, metallic,
+                             roughness, n, view);
+  }
+
+  // the cluster of the fragment, see LightClusters
+  highp vec4 clipPosition = ProjectionMatrix * vec4(position, 1.0);
+  ivec2 tile = ivec2(clamp((clipPosition.xy / clipPosition.w * 0.5 + 0.5) *
+                               vec2(CLUSTER_TILE_COUNT),
+                           vec2(0.0), vec2(CLUSTER_TILE_COUNT - 1)));
+  int slice = int(clamp(log(max(-position.z, 0.0001)) * LightClusterDepth.x +
+                            LightClusterDepth.y,
+                        0.0, float(CLUSTER_SLICE_COUNT - 1)));
+  int clusterRow = tile.y + slice * CLUSTER_TILE_COUNT.y;
+  uvec2 cluster = texelFetch(LightClusters, ivec2(tile.x, clusterRow), 0).xy;
+  const uint indexWidth = uint(LIGHT_INDEX_TEXTURE_WIDTH);
+  for (uint k = 0u; k < cluster.y; ++k) {
+    uint index = cluster.x + k;
+    ivec2 texel = ivec2(int(index % indexWidth), int(index / indexWidth));
+    int iLight = int(texelFetch(LightIndices, texel, 0).r);
+    vec4 color = texelFetch(LightData, ivec2(iLight, 1), 0);
+    finalColor += shadeLight(texelFetch(LightData, ivec2(iLight, 0), 0),
+                             color.rgb, color.a, baseColor.rgb, metallic,
+                             roughness, n, view);
+  }
+#else
   for (int iLight = 0; iLight < LIGHT_COUNT; ++iLight) {
-    // Attenuation. Directional lights have the .w component set to 0, use
-    // that to make the distance zero -- which will then ensure the
-    // attenuation is always 1.0
-    highp float dist =
-        length(LightDirections[iLight].xyz - position) * LightDirections[iLight].w;
-    // If range is 0 for whatever reason, clamp it to a small value to
-    // avoid a NaN when dist is 0 as well (which is the case for
-    // directional lights).
-    highp float attenuation =
-        clamp(1.0 - pow(dist / max(LightRanges[iLight], 0.0001), 4.0), 0.0,
-              1.0);
-    attenuation = attenuation * attenuation / (1.0 + dist * dist);
-
-    // radiance
-    vec3 lightRadiance = LightColors[iLight] * attenuation;
-
-    // light source direction: a vector from current position to the light
-    vec3 light = normalize(LightDirections[iLight].xyz -
-                           position * LightDirections[iLight].w);
-
-    finalColor += microfacetModel(baseColor.rgb, metallic, roughness, n, light,
-                                  view, lightRadiance);
+    finalColor += shadeLight(LightDirections[iLight], LightColors[iLight],
+                             LightRanges[iLight], baseColor.rgb, metallic,
+                             roughness, n, view);
   }  // for lights
+#endif
+
+#if defined(ENVIRONMENT_LIT)
+  finalColor +=
+      imageBasedLighting(baseColor.rgb, metallic, roughness, n, view);
+#endif
 
   // TODO: use ALPHA_MASK to discard fragments
   fragmentColor += vec4(finalColor, baseColor.a);
-#endif  // if LIGHT_COUNT > 0
+#endif  // if defined(LIT)
 
 #if defined(OBJECT_ID)
   fragmentObjectId = ObjectId;
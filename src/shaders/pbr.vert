@@ -29,7 +29,7 @@ uniform highp mat4 ModelViewMatrix;
 uniform highp mat3 NormalMatrix;  // inverse transpose of 3x3 modelview matrix
 uniform highp mat4 ProjectionMatrix;
 
-#ifdef TEXTURE_TRANSFORMATION
+#if defined(TEXTURE_TRANSFORMATION) && !defined(MATERIAL_BUFFER)
 uniform highp mat3 TextureMatrix
 #ifndef GL_ES
     = mat3(1.0)
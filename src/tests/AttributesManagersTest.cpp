@@ -421,6 +421,7 @@ TEST_F(AttributesManagersTest, AttributesManagers_PhysicsJSONLoadTest) {
   const std::string& jsonString = R"({
       "physics_simulator": "bullet_test",
       "timestep": 1.0,
+      "num_threads": 4,
       "gravity": [1,2,3],
       "friction_coefficient": 1.4,
       "restitution_coefficient": 1.1
@@ -435,6 +436,7 @@ TEST_F(AttributesManagersTest, AttributesManagers_PhysicsJSONLoadTest) {
   // TODO : get these values programmatically?
   ASSERT_EQ(physMgrAttr->getGravity(), Magnum::Vector3(1, 2, 3));
   ASSERT_EQ(physMgrAttr->getTimestep(), 1.0);
+  ASSERT_EQ(physMgrAttr->getNumThreads(), 4);
   ASSERT_EQ(physMgrAttr->getSimulator(), "bullet_test");
   ASSERT_EQ(physMgrAttr->getFrictionCoefficient(), 1.4);
   ASSERT_EQ(physMgrAttr->getRestitutionCoefficient(), 1.1);
@@ -635,6 +637,8 @@ TEST_F(AttributesManagersTest, AttributesManagers_ObjectJSONLoadTest) {
         "mass": 9,
         "use_bounding_box_for_collision": true,
         "join_collision_meshes":true,
+        "max_hull_vertices": 32,
+        "use_convex_decomposition": true,
         "inertia": [1.1, 0.9, 0.3],
         "semantic_id" : 7,
         "COM": [0.1,0.2,0.3]
@@ -663,6 +667,8 @@ TEST_F(AttributesManagersTest, AttributesManagers_ObjectJSONLoadTest) {
   ASSERT_EQ(objAttr->getMass(), 9);
   ASSERT_EQ(objAttr->getBoundingBoxCollisions(), true);
   ASSERT_EQ(objAttr->getJoinCollisionMeshes(), true);
+  ASSERT_EQ(objAttr->getMaxHullVertices(), 32);
+  ASSERT_EQ(objAttr->getUseConvexDecomposition(), true);
   ASSERT_EQ(objAttr->getInertia(), Magnum::Vector3(1.1, 0.9, 0.3));
   ASSERT_EQ(objAttr->getCOM(), Magnum::Vector3(0.1, 0.2, 0.3));
 
@@ -766,6 +772,117 @@ TEST_F(AttributesManagersTest, ObjectAttributesManagersCreate) {
   ASSERT_EQ(origNumPrimBased, newNumPrimBased3);
 }  // AttributesManagersTest::ObjectAttributesManagersCreate test
 
+TEST_F(AttributesManagersTest, ObjectAttributesManagersLoadDirectory) {
+  // the configs are parsed in parallel, but registered in directory order
+  const std::string objectsDir =
+      Cr::Utility::Directory::join(DATA_DIR, "test_assets/objects");
+  std::vector<int> templateIDs =
+      objectAttributesManager_->loadAllConfigsFromPath(objectsDir);
+  const std::vector<std::string> names{"chair", "donut", "nested_box",
+                                       "sphere"};
+  ASSERT_EQ(templateIDs.size(), names.size());
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    ASSERT_NE(templateIDs[i], esp::ID_UNDEFINED);
+    auto attr = objectAttributesManager_->getObjectByID(templateIDs[i]);
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(attr->getHandle(),
+              Cr::Utility::Directory::join(
+                  objectsDir, names[i] + ".object_config.json"));
+    if (i > 0) {
+      EXPECT_GT(templateIDs[i], templateIDs[i - 1]);
+    }
+  }
+}  // AttributesManagersTest::ObjectAttributesManagersLoadDirectory test
+
+TEST_F(AttributesManagersTest, ObjectAttributesManagersLazyLoading) {
+  const std::string objectsDir =
+      Cr::Utility::Directory::join(DATA_DIR, "test_assets/objects");
+  const std::string chairConfig =
+      Cr::Utility::Directory::join(objectsDir, "chair.object_config.json");
+  int origNumFileBased = objectAttributesManager_->getNumFileTemplateObjects();
+
+  objectAttributesManager_->setLazyLoading(true);
+  std::vector<int> templateIDs =
+      objectAttributesManager_->loadAllConfigsFromPath(objectsDir, true);
+  ASSERT_EQ(templateIDs.size(), 4);
+  // registered without being parsed
+  EXPECT_EQ(objectAttributesManager_->getNumDeferredTemplateObjects(), 4);
+  EXPECT_EQ(objectAttributesManager_->getNumFileTemplateObjects(),
+            origNumFileBased + 4);
+  EXPECT_TRUE(objectAttributesManager_->getObjectLibHasHandle(chairConfig));
+
+  // parsed on first access, keeping the ID
+  auto chair = objectAttributesManager_->getObjectCopyByHandle(chairConfig);
+  ASSERT_NE(chair, nullptr);
+  EXPECT_EQ(chair->getID(), templateIDs[0]);
+  EXPECT_EQ(chair->getMass(), 9);
+  EXPECT_EQ(chair->getRenderAssetHandle(),
+            Cr::Utility::Directory::join(objectsDir, "chair.glb"));
+  EXPECT_EQ(objectAttributesManager_->getNumDeferredTemplateObjects(), 3);
+  EXPECT_EQ(objectAttributesManager_->getNumFileTemplateObjects(),
+            origNumFileBased + 4);
+
+  auto byID = objectAttributesManager_->getObjectByID(templateIDs[1]);
+  ASSERT_NE(byID, nullptr);
+  EXPECT_FALSE(byID->getRenderAssetHandle().empty());
+  EXPECT_EQ(objectAttributesManager_->getNumDeferredTemplateObjects(), 2);
+}  // AttributesManagersTest::ObjectAttributesManagersLazyLoading test
+
+TEST_F(AttributesManagersTest, ObjectAttributesManagersShared) {
+  const std::string chairConfig = Cr::Utility::Directory::join(
+      DATA_DIR, "test_assets/objects/chair.object_config.json");
+  auto chair = objectAttributesManager_->createObject(chairConfig, true);
+  ASSERT_NE(chair, nullptr);
+
+  // shared without copying
+  auto shared = objectAttributesManager_->getObjectSharedByHandle(chairConfig);
+  ASSERT_NE(shared, nullptr);
+  EXPECT_EQ(shared,
+            objectAttributesManager_->getObjectSharedByID(shared->getID()));
+  EXPECT_EQ(shared->getMass(), 9);
+
+  // registering an edited copy replaces the shared template in the library
+  // without changing it
+  auto edited = objectAttributesManager_->getObjectCopyByHandle(chairConfig);
+  edited->setMass(3);
+  objectAttributesManager_->registerObject(edited, chairConfig);
+  EXPECT_EQ(shared->getMass(), 9);
+  auto updated = objectAttributesManager_->getObjectSharedByHandle(chairConfig);
+  EXPECT_NE(updated, shared);
+  EXPECT_EQ(updated->getMass(), 3);
+  EXPECT_EQ(updated->getID(), shared->getID());
+}  // AttributesManagersTest::ObjectAttributesManagersShared test
+
+TEST_F(AttributesManagersTest, ObjectAttributesManagersHandlesByPrefix) {
+  const std::string chairConfig = Cr::Utility::Directory::join(
+      DATA_DIR, "test_assets/objects/chair.object_config.json");
+  auto chair = objectAttributesManager_->createObject(chairConfig, true);
+  ASSERT_NE(chair, nullptr);
+  for (const std::string handle : {"Prefix_b", "prefix_A", "noprefix_c"}) {
+    objectAttributesManager_->registerObject(
+        objectAttributesManager_->getObjectCopyByHandle(chairConfig), handle);
+  }
+
+  // case-insensitive, sorted ignoring case
+  std::vector<std::string> handles =
+      objectAttributesManager_->getObjectHandlesByPrefix("PREFIX_");
+  ASSERT_EQ(handles.size(), 2);
+  EXPECT_EQ(handles[0], "prefix_A");
+  EXPECT_EQ(handles[1], "Prefix_b");
+  EXPECT_EQ(objectAttributesManager_->getObjectHandlesByPrefix("prefix_c")
+                .size(),
+            0);
+
+  // removed handles aren't found anymore
+  objectAttributesManager_->removeObjectByHandle("prefix_A");
+  handles = objectAttributesManager_->getObjectHandlesByPrefix("prefix");
+  ASSERT_EQ(handles.size(), 1);
+  EXPECT_EQ(handles[0], "Prefix_b");
+  EXPECT_EQ(objectAttributesManager_->getObjectHandlesBySubstring("REFIX_")
+                .size(),
+            2);
+}  // AttributesManagersTest::ObjectAttributesManagersHandlesByPrefix test
+
 TEST_F(AttributesManagersTest, LightLayoutAttributesManagerTest) {
   LOG(INFO) << "Starting "
                "AttributesManagersTest::LightLayoutAttributesManagerTest";
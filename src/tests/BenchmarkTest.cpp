@@ -0,0 +1,269 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/TestSuite/Tester.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/PixelFormat.h>
+#include <string>
+#include <vector>
+
+#include "esp/core/configure.h"
+#include "esp/gfx/RenderCamera.h"
+#include "esp/gfx/RenderTarget.h"
+#include "esp/sensor/VisualSensor.h"
+#include "esp/sim/Simulator.h"
+
+#include "configure.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+using esp::agent::AgentConfiguration;
+using esp::sensor::SensorSpec;
+using esp::sensor::SensorType;
+using esp::sensor::VisualSensor;
+using esp::sim::Simulator;
+using esp::sim::SimulatorConfiguration;
+
+// Function-level benchmarks of the rendering and physics hot paths on fixed
+// scenes, to catch regressions that end-to-end frame rates hide. The navmesh
+// queries are benchmarked in PathFinderTest, depth unprojection in
+// DepthUnprojectionTest.
+
+namespace {
+
+const std::string testAssets = TEST_ASSETS;
+
+const struct {
+  const char* name;
+  const char* scene;
+} SceneData[]{
+    {"van-gogh-room", "habitat-test-scenes/van-gogh-room.glb"},
+    {"skokloster-castle", "habitat-test-scenes/skokloster-castle.glb"},
+};
+
+const Mn::Vector2i Resolution{256, 256};
+constexpr int NumPhysicsObjects = 50;
+
+struct BenchmarkTest : Cr::TestSuite::Tester {
+  explicit BenchmarkTest();
+
+  void benchmarkCull();
+  void benchmarkDraw();
+  void benchmarkReadbackRgba();
+  void benchmarkReadbackDepth();
+  void benchmarkStepPhysics();
+  void benchmarkCastRay();
+
+  // The simulator of the current test case, kept across its repeats. Only
+  // one exists at a time, each has its own GL context.
+  Simulator* sceneSimulator(const std::string& scene);
+  Simulator* physicsSimulator();
+
+  VisualSensor& sensor(Simulator& sim, const std::string& uuid) {
+    return static_cast<VisualSensor&>(
+        *sim.getAgent(0)->getSensorSuite().get(uuid));
+  }
+
+  std::string simulatorKey_;
+  Simulator::uptr simulator_;
+};
+
+BenchmarkTest::BenchmarkTest() {
+  addInstancedBenchmarks({&BenchmarkTest::benchmarkCull,
+                          &BenchmarkTest::benchmarkDraw,
+                          &BenchmarkTest::benchmarkReadbackRgba,
+                          &BenchmarkTest::benchmarkReadbackDepth},
+                         20, Cr::Containers::arraySize(SceneData));
+
+  addBenchmarks(
+      {&BenchmarkTest::benchmarkStepPhysics, &BenchmarkTest::benchmarkCastRay},
+      20);
+}
+
+Simulator* BenchmarkTest::sceneSimulator(const std::string& scene) {
+  const std::string path = Cr::Utility::Directory::join(SCENE_DATASETS, scene);
+  if (!Cr::Utility::Directory::exists(path)) {
+    return nullptr;
+  }
+  if (simulatorKey_ == path) {
+    return simulator_.get();
+  }
+
+  simulator_ = nullptr;
+  SimulatorConfiguration simConfig{};
+  simConfig.activeSceneID = path;
+  simulator_ = Simulator::create_unique(simConfig);
+
+  AgentConfiguration agentConfig{};
+  for (const SensorType type : {SensorType::Color, SensorType::Depth}) {
+    auto spec = SensorSpec::create();
+    spec->uuid = type == SensorType::Color ? "rgba" : "depth";
+    spec->sensorSubType = esp::sensor::SensorSubType::Pinhole;
+    spec->sensorType = type;
+    spec->position = {0.0f, 1.5f, 0.0f};
+    spec->resolution = {Resolution.y(), Resolution.x()};
+    agentConfig.sensorSpecifications.push_back(spec);
+  }
+  simulator_->addAgent(agentConfig);
+  simulatorKey_ = path;
+  return simulator_.get();
+}
+
+Simulator* BenchmarkTest::physicsSimulator() {
+  const std::string key = "physics";
+  if (simulatorKey_ == key) {
+    return simulator_.get();
+  }
+
+  simulator_ = nullptr;
+  SimulatorConfiguration simConfig{};
+  simConfig.activeSceneID =
+      Cr::Utility::Directory::join(testAssets, "scenes/plane.glb");
+  simConfig.enablePhysics = true;
+  simConfig.physicsConfigFile =
+      Cr::Utility::Directory::join(testAssets, "testing.physics_config.json");
+  simulator_ = Simulator::create_unique(simConfig);
+
+  auto objectAttributesManager = simulator_->getObjectAttributesManager();
+  objectAttributesManager->loadAllConfigsFromPath(
+      Cr::Utility::Directory::join(testAssets, "objects/nested_box"), true);
+  const std::vector<std::string> handles =
+      objectAttributesManager->getObjectHandlesBySubstring("nested_box");
+  CORRADE_INTERNAL_ASSERT(!handles.empty());
+  // a grid of stacks, so that the boxes keep colliding for a while
+  for (int i = 0; i < NumPhysicsObjects; ++i) {
+    const int objectId = simulator_->addObjectByHandle(handles[0]);
+    simulator_->setTranslation(
+        {float(i % 5) - 2.0f, 0.5f + 0.6f * (i / 25), float(i / 5 % 5) - 2.0f},
+        objectId);
+  }
+  simulatorKey_ = key;
+  return simulator_.get();
+}
+
+void BenchmarkTest::benchmarkCull() {
+  auto&& data = SceneData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+  Simulator* sim = sceneSimulator(data.scene);
+  if (!sim) {
+    CORRADE_SKIP(std::string{data.scene} + " not found");
+  }
+
+  esp::scene::SceneGraph& sceneGraph = sim->getActiveSceneGraph();
+  sceneGraph.setDefaultRenderCamera(sensor(*sim, "rgba"));
+  esp::gfx::RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+  sceneGraph.updateTransformations();
+
+  std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                        Mn::Matrix4>>
+      transforms;
+  std::size_t numVisible = 0;
+  CORRADE_BENCHMARK(10) {
+    numVisible = 0;
+    for (auto& it : sceneGraph.getDrawableGroups()) {
+      it.second.drawableTransformations(camera.cameraMatrix(), transforms);
+      numVisible += camera.cull(it.second, transforms);
+    }
+  }
+  CORRADE_VERIFY(numVisible > 0);
+}
+
+void BenchmarkTest::benchmarkDraw() {
+  auto&& data = SceneData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+  Simulator* sim = sceneSimulator(data.scene);
+  if (!sim) {
+    CORRADE_SKIP(std::string{data.scene} + " not found");
+  }
+
+  VisualSensor& rgba = sensor(*sim, "rgba");
+  // the first frame compiles the shaders
+  CORRADE_VERIFY(rgba.drawObservation(*sim));
+  CORRADE_BENCHMARK(5) {
+    rgba.drawObservation(*sim);
+    // wait for the GPU, the draw calls themselves only queue the work
+    Mn::GL::Renderer::finish();
+  }
+}
+
+void BenchmarkTest::benchmarkReadbackRgba() {
+  auto&& data = SceneData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+  Simulator* sim = sceneSimulator(data.scene);
+  if (!sim) {
+    CORRADE_SKIP(std::string{data.scene} + " not found");
+  }
+
+  VisualSensor& rgba = sensor(*sim, "rgba");
+  CORRADE_VERIFY(rgba.drawObservation(*sim));
+  Mn::GL::Renderer::finish();
+  Cr::Containers::Array<char> pixels{Cr::NoInit,
+                                     std::size_t(Resolution.product()) * 4};
+  const Mn::MutableImageView2D view{Mn::PixelFormat::RGBA8Unorm, Resolution,
+                                    pixels};
+  CORRADE_BENCHMARK(5) { rgba.renderTarget().readFrameRgba(view); }
+}
+
+void BenchmarkTest::benchmarkReadbackDepth() {
+  auto&& data = SceneData[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+  Simulator* sim = sceneSimulator(data.scene);
+  if (!sim) {
+    CORRADE_SKIP(std::string{data.scene} + " not found");
+  }
+
+  VisualSensor& depth = sensor(*sim, "depth");
+  CORRADE_VERIFY(depth.drawObservation(*sim));
+  Mn::GL::Renderer::finish();
+  Cr::Containers::Array<char> pixels{
+      Cr::NoInit, std::size_t(Resolution.product()) * sizeof(Mn::Float)};
+  const Mn::MutableImageView2D view{Mn::PixelFormat::R32F, Resolution,
+                                    pixels};
+  // includes the unprojection to meters
+  CORRADE_BENCHMARK(5) { depth.renderTarget().readFrameDepth(view); }
+}
+
+void BenchmarkTest::benchmarkStepPhysics() {
+#ifndef ESP_BUILD_WITH_BULLET
+  CORRADE_SKIP("Built without Bullet");
+#else
+  Simulator* sim = physicsSimulator();
+  const double startTime = sim->getWorldTime();
+  CORRADE_BENCHMARK(10) { sim->stepWorld(1.0 / 60.0); }
+  CORRADE_VERIFY(sim->getWorldTime() > startTime);
+#endif
+}
+
+void BenchmarkTest::benchmarkCastRay() {
+#ifndef ESP_BUILD_WITH_BULLET
+  CORRADE_SKIP("Built without Bullet");
+#else
+  Simulator* sim = physicsSimulator();
+  // straight down through the stacks of boxes, onto the plane
+  std::vector<esp::geo::Ray> rays;
+  for (int i = 0; i < 100; ++i) {
+    rays.emplace_back(Mn::Vector3{0.05f * (i % 10) - 0.25f, 5.0f,
+                                  0.05f * (i / 10) - 0.25f},
+                      Mn::Vector3{0.0f, -1.0f, 0.0f});
+  }
+
+  std::size_t numHits = 0;
+  CORRADE_BENCHMARK(1) {
+    numHits = 0;
+    for (const esp::geo::Ray& ray : rays) {
+      numHits += sim->castRay(ray).hits.size();
+    }
+  }
+  CORRADE_VERIFY(numHits >= rays.size());
+#endif
+}
+
+}  // namespace
+
+CORRADE_TEST_MAIN(BenchmarkTest)
@@ -3,9 +3,22 @@
 // LICENSE file in the root directory of this source tree.
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "esp/core/AsyncLog.h"
 #include "esp/core/Configuration.h"
+#include "esp/core/MappedFile.h"
+#include "esp/core/ObjectArena.h"
+#include "esp/core/ThreadPool.h"
 #include "esp/core/esp.h"
+#include "esp/core/random.h"
 
 using namespace esp::core;
 
@@ -17,4 +30,295 @@ TEST(CoreTest, ConfigurationTest) {
   EXPECT_TRUE(cfg.hasValue("myString"));
   EXPECT_EQ(cfg.get<int>("myInt"), 10);
   EXPECT_EQ(cfg.get<std::string>("myString"), "test");
+
+  // other types convert through the string representation
+  cfg.setDouble("myDouble", 0.25);
+  EXPECT_EQ(cfg.getDouble("myDouble"), 0.25);
+  EXPECT_EQ(cfg.getFloat("myDouble"), 0.25f);
+  EXPECT_EQ(cfg.getString("myInt"), "10");
+  EXPECT_EQ(cfg.getDouble("myInt"), 10.0);
+  cfg.setString("myVec3", "1 2.5 -3");
+  EXPECT_EQ(cfg.getVec3("myVec3"), (Magnum::Vector3{1.0f, 2.5f, -3.0f}));
+  cfg.setVec3("myVec3", {0.5f, 0.0f, 1.0f});
+  EXPECT_EQ(cfg.getString("myVec3"), "0.5 0 1");
+  EXPECT_EQ(cfg.getInt("missing"), 0);
+  EXPECT_FALSE(cfg.hasValue("missing"));
+
+  cfg.addStringToGroup("group", "a");
+  EXPECT_EQ(cfg.addStringToGroup("group", "b"), 2);
+  EXPECT_EQ(cfg.getStringGroup("group"), (std::vector<std::string>{"a", "b"}));
+  EXPECT_TRUE(cfg.removeValue("group"));
+  EXPECT_EQ(cfg.getString("group"), "b");
+
+  Corrade::Utility::ConfigurationGroup group = cfg.getConfigurationGroup();
+  EXPECT_EQ(group.value<int>("myInt"), 10);
+  EXPECT_EQ(group.value("myDouble"), "0.25");
+  EXPECT_EQ(group.value("group"), "b");
+}
+
+TEST(CoreTest, ThreadPoolTest) {
+  ThreadPool pool{3};
+  EXPECT_EQ(pool.numThreads(), 3u);
+  EXPECT_EQ(pool.submit([]() { return 42; }).get(), 42);
+
+  // every index runs exactly once, and each worker handles one at a time
+  std::vector<int> visits(1000, 0);
+  std::vector<std::atomic<int>> busy(4);
+  std::atomic<bool> overlapped{false};
+  pool.parallelFor(visits.size(), 4, [&](size_t index, size_t worker) {
+    ASSERT_LT(worker, 4u);
+    if (busy[worker]++) {
+      overlapped = true;
+    }
+    ++visits[index];
+    --busy[worker];
+  });
+  EXPECT_FALSE(overlapped);
+  for (int count : visits) {
+    EXPECT_EQ(count, 1);
+  }
+
+  // a single worker is the calling thread
+  const std::thread::id caller = std::this_thread::get_id();
+  pool.parallelFor(10, 1, [&](size_t, size_t worker) {
+    EXPECT_EQ(worker, 0u);
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+  });
+
+  EXPECT_THROW(pool.parallelFor(8, 4,
+                                [](size_t index, size_t) {
+                                  if (index == 5) {
+                                    throw std::runtime_error{"failed"};
+                                  }
+                                }),
+               std::runtime_error);
+}
+
+TEST(CoreTest, TaskGroupTest) {
+  ThreadPool pool{2};
+
+  // tasks running more tasks, and continuations once all of them are done
+  std::atomic<int> ran{0};
+  std::atomic<int> ranBeforeContinuation{-1};
+  {
+    TaskGroup group{pool};
+    for (int i = 0; i != 8; ++i) {
+      group.run([&]() {
+        group.run([&]() { ++ran; });
+        ++ran;
+      });
+    }
+    group.then([&]() {
+      ranBeforeContinuation = ran.load();
+      group.run([&]() { ++ran; });
+    });
+    group.wait();
+    EXPECT_TRUE(group.done());
+    EXPECT_EQ(ranBeforeContinuation.load(), 16);
+    EXPECT_EQ(ran.load(), 17);
+
+    // a continuation of a group with nothing running runs right away
+    group.then([&]() { ++ran; });
+    group.wait();
+    EXPECT_EQ(ran.load(), 18);
+  }
+
+  // the first exception is rethrown, and skips the continuations
+  TaskGroup failing{pool};
+  bool continued = false;
+  failing.run([]() { throw std::runtime_error{"failed"}; });
+  failing.then([&]() { continued = true; });
+  EXPECT_THROW(failing.wait(), std::runtime_error);
+  EXPECT_FALSE(continued);
+  failing.wait();
+
+  // loops nested in tasks of the same pool help instead of blocking its
+  // workers, with more outer indices than threads
+  std::vector<std::atomic<int>> sums(6);
+  pool.parallelFor(sums.size(), 3, [&](size_t index, size_t) {
+    pool.parallelFor(100, 3, [&](size_t, size_t) { ++sums[index]; });
+  });
+  for (const std::atomic<int>& sum : sums) {
+    EXPECT_EQ(sum.load(), 100);
+  }
+
+  std::vector<int> visits(1000, 0);
+  pool.parallelForRanges(visits.size(), 64, [&](size_t begin, size_t end) {
+    EXPECT_LE(end - begin, 64u);
+    for (size_t i = begin; i != end; ++i) {
+      ++visits[i];
+    }
+  });
+  for (int count : visits) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(CoreTest, ThreadBudgetTest) {
+  ThreadPool pool{4};
+  pool.setNumThreads(2);
+  EXPECT_EQ(pool.numThreads(), 2u);
+  EXPECT_EQ(pool.numWorkers(100, 100), 3u);
+  // clamped to the threads the pool was created with
+  pool.setNumThreads(8);
+  EXPECT_EQ(pool.numThreads(), 4u);
+  pool.setNumThreads(0);
+  EXPECT_EQ(pool.numThreads(), 1u);
+  EXPECT_EQ(pool.submit([]() { return 7; }).get(), 7);
+
+  // the budget includes the calling thread, and sizes the shared pool and
+  // the ones created with the default number of threads
+  ThreadPool::setThreadBudget(2);
+  EXPECT_EQ(ThreadPool::threadBudget(), 2u);
+  EXPECT_EQ(ThreadPool::shared().numThreads(), 1u);
+  EXPECT_EQ(ThreadPool{}.numThreads(), 1u);
+  ThreadPool::setThreadBudget(0);
+  EXPECT_EQ(ThreadPool::threadBudget(),
+            std::max<std::size_t>(1, std::thread::hardware_concurrency()));
+}
+
+TEST(CoreTest, ObjectArenaTest) {
+  struct Node : ArenaAllocated {
+    explicit Node(int value) : value{value} {}
+    int value;
+    char payload[100];
+  };
+
+  ObjectArena::uptr arena = ObjectArena::create();
+  std::vector<Node*> nodes;
+  for (int i = 0; i < 1000; ++i) {
+    nodes.push_back(new (arena.get()) Node{i});
+  }
+  EXPECT_EQ(arena->numAllocations(), 1000u);
+  const std::size_t reservedBytes = arena->reservedBytes();
+  EXPECT_GT(reservedBytes, 0u);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(nodes[i]->value, i);
+    delete nodes[i];
+  }
+  EXPECT_EQ(arena->numAllocations(), 0u);
+
+  // deallocated memory is reused rather than reserved again
+  for (int i = 0; i < 1000; ++i) {
+    nodes[i] = new (arena.get()) Node{i};
+  }
+  EXPECT_EQ(arena->reservedBytes(), reservedBytes);
+
+  // the heap, without an arena, and a release with live allocations, which
+  // stay valid
+  Node* heapNode = new Node{-1};
+  Node* lastNode = nodes.back();
+  nodes.pop_back();
+  for (Node* node : nodes) {
+    delete node;
+  }
+  arena.reset();
+  EXPECT_EQ(lastNode->value, 999);
+  delete lastNode;
+  EXPECT_EQ(heapNode->value, -1);
+  delete heapNode;
+}
+
+TEST(CoreTest, AsyncLogTest) {
+  std::mutex mutex;
+  std::vector<std::string> messages;
+  AsyncLogSink::instance().setOutput([&](const AsyncLogSink::Record& record) {
+    std::lock_guard<std::mutex> lock{mutex};
+    messages.push_back(record.message);
+  });
+  const double interval = LogRateLimiter::interval();
+  // a single call site
+  auto log = [](int i) { ESP_HOT_LOG(WARNING) << "message " << i; };
+
+  LogRateLimiter::setInterval(3600.0);
+  for (int i = 0; i < 5; ++i) {
+    log(i);
+  }
+  AsyncLogSink::instance().flush();
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    EXPECT_EQ(messages, std::vector<std::string>{"message 0"});
+  }
+
+  // the first message after the suppressed ones counts them
+  LogRateLimiter::setInterval(0.0);
+  log(5);
+  log(6);
+  AsyncLogSink::instance().flush();
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    EXPECT_EQ(messages,
+              (std::vector<std::string>{
+                  "message 0", "message 5 (4 similar messages suppressed)",
+                  "message 6"}));
+  }
+
+  LogRateLimiter::setInterval(interval);
+  AsyncLogSink::instance().setOutput(nullptr);
+}
+
+TEST(CoreTest, HashBytesXXH64Test) {
+  // the reference values, with and without full 32-byte stripes
+  const auto hash = [](const std::string& data) {
+    return esp::core::hashBytesXXH64({data.data(), data.size()});
+  };
+  EXPECT_EQ(hash(""), 0xef46db3751d8e999ull);
+  EXPECT_EQ(hash("a"), 0xd24ec4f1a98c6e5bull);
+  EXPECT_EQ(hash("abc"), 0x44bc2cf5ad770999ull);
+  EXPECT_EQ(hash("Nobody inspects the spammish repetition"),
+            0xfbcea83c8a378bf1ull);
+}
+
+TEST(CoreTest, RandomTest) {
+  // the same seed gives the same sequence, copies fork it
+  Random a{7};
+  Random b{7};
+  EXPECT_EQ(a.uniform_uint(), b.uniform_uint());
+  Random fork = a;
+  EXPECT_EQ(fork.uniform_float_01(), a.uniform_float_01());
+
+  // splits only depend on the seed and the stream id
+  const Random split = b.split(3);
+  b.uniform_uint();
+  EXPECT_EQ(b.split(3).uniform_uint(), Random{split}.uniform_uint());
+  EXPECT_NE(b.split(3).uniform_uint(), b.split(4).uniform_uint());
+  EXPECT_NE(b.split(3).split(0).uniform_uint(), b.split(3).uniform_uint());
+
+  for (int i = 0; i < 1000; ++i) {
+    const float u = a.uniform_float_01();
+    EXPECT_GE(u, 0.0f);
+    EXPECT_LT(u, 1.0f);
+    const int n = a.uniform_int(-2, 3);
+    EXPECT_GE(n, -2);
+    EXPECT_LT(n, 3);
+  }
+  EXPECT_EQ(a.uniform_int(5, 5), 5);
+
+  // the batched fills draw what the scalar calls draw
+  Random c{11};
+  Random d{11};
+  std::vector<float> uniforms(5);
+  c.fillUniform({uniforms.data(), uniforms.size()}, 2.0f, 4.0f);
+  for (float value : uniforms) {
+    EXPECT_FLOAT_EQ(value, d.uniform_float(2.0f, 4.0f));
+  }
+  // an odd count, so that the next fill starts with the spare normal
+  std::vector<float> normals(3);
+  for (int fill = 0; fill < 2; ++fill) {
+    c.fillNormal({normals.data(), normals.size()}, 1.0f, 2.0f);
+    for (float value : normals) {
+      EXPECT_FLOAT_EQ(value, d.normal_float_01() * 2.0f + 1.0f);
+    }
+  }
+
+  std::vector<float> many(100000);
+  c.fillNormal({many.data(), many.size()});
+  double sum = 0.0, squares = 0.0;
+  for (float value : many) {
+    EXPECT_TRUE(std::isfinite(value));
+    sum += value;
+    squares += value * value;
+  }
+  EXPECT_NEAR(sum / many.size(), 0.0, 0.02);
+  EXPECT_NEAR(squares / many.size(), 1.0, 0.02);
 }
@@ -15,6 +15,8 @@
 #include <string>
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/CullingBVH.h"
+#include "esp/gfx/FrustumCulling.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/WindowlessContext.h"
@@ -39,12 +41,18 @@ struct CullingTest : Cr::TestSuite::Tester {
   // tests
   void computeAbsoluteAABB();
   void frustumCulling();
+  void cullingBVH();
+  void frustumCullAabbs();
+  void cachedAbsoluteMeshBB();
 };
 
 CullingTest::CullingTest() {
   // clang-format off
   addTests({&CullingTest::computeAbsoluteAABB,
-            &CullingTest::frustumCulling});
+            &CullingTest::frustumCulling,
+            &CullingTest::cullingBVH,
+            &CullingTest::frustumCullAabbs,
+            &CullingTest::cachedAbsoluteMeshBB});
   // clang-format on
 }
 
@@ -273,6 +281,122 @@ void CullingTest::frustumCulling() {
   target->renderExit();
   CORRADE_COMPARE(numVisibleObjects, numVisibleObjectsGroundTruth);
 }
+
+void CullingTest::cullingBVH() {
+  // a 20 x 20 x 4 grid of unit boxes, spaced 2m apart
+  std::vector<Mn::Range3D> boxes;
+  for (int x = 0; x < 20; ++x) {
+    for (int y = 0; y < 4; ++y) {
+      for (int z = 0; z < 20; ++z) {
+        const Mn::Vector3 min{2.0f * x - 20.0f, 2.0f * y, 2.0f * z - 20.0f};
+        boxes.emplace_back(min, min + Mn::Vector3{1.0f});
+      }
+    }
+  }
+
+  esp::gfx::CullingBVH bvh;
+  bvh.build(boxes);
+  CORRADE_COMPARE(bvh.numItems(), boxes.size());
+  CORRADE_VERIFY(bvh.numNodes() < 2 * boxes.size());
+
+  auto checkAgainstLinear = [&](const Mn::Matrix4& cameraTransform) {
+    const Mn::Frustum frustum = Mn::Frustum::fromMatrix(
+        Mn::Matrix4::perspectiveProjection(60.0_degf, 4.0f / 3.0f, 0.1f,
+                                           30.0f) *
+        cameraTransform.inverted());
+    std::vector<char> visible;
+    size_t numVisible = bvh.cull(frustum, visible);
+    CORRADE_COMPARE(visible.size(), boxes.size());
+
+    size_t numVisibleGroundTruth = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      const bool expected = Mn::Math::Intersection::rangeFrustum(
+          boxes[i], frustum);
+      CORRADE_COMPARE(bool(visible[i]), expected);
+      numVisibleGroundTruth += expected;
+    }
+    CORRADE_COMPARE(numVisible, numVisibleGroundTruth);
+    return numVisible;
+  };
+
+  const Mn::Matrix4 camera = Mn::Matrix4::lookAt(
+      {0.0f, 3.0f, 25.0f}, {0.0f, 3.0f, 0.0f}, Mn::Vector3::yAxis());
+  // some, but not all of the boxes are visible
+  size_t numVisible = checkAgainstLinear(camera);
+  CORRADE_VERIFY(numVisible > 0);
+  CORRADE_VERIFY(numVisible < boxes.size());
+
+  // move every box far behind the camera and refit, nothing is visible
+  std::vector<Mn::Range3D> movedBoxes = boxes;
+  for (Mn::Range3D& box : movedBoxes) {
+    box = box.translated({0.0f, 0.0f, 100.0f});
+  }
+  bvh.refit(movedBoxes);
+  boxes = movedBoxes;
+  CORRADE_COMPARE(checkAgainstLinear(camera), 0);
+
+  // a camera looking at the moved boxes sees them again
+  checkAgainstLinear(Mn::Matrix4::lookAt(
+      {0.0f, 3.0f, 140.0f}, {0.0f, 3.0f, 100.0f}, Mn::Vector3::yAxis()));
+}
+
+void CullingTest::frustumCullAabbs() {
+  const Mn::Frustum frustum = Mn::Frustum::fromMatrix(
+      Mn::Matrix4::perspectiveProjection(60.0_degf, 1.0f, 0.1f, 10.0f) *
+      Mn::Matrix4::lookAt({0.0f, 0.0f, 5.0f}, {}, Mn::Vector3::yAxis())
+          .inverted());
+
+  // an odd number of boxes so that the vectorized loops have a remainder
+  std::vector<Mn::Range3D> boxes;
+  esp::gfx::AabbsSoA soa;
+  for (int x = -7; x <= 7; ++x) {
+    for (int z = -7; z <= 7; ++z) {
+      const Mn::Vector3 min{1.5f * x, 0.25f * x, 1.5f * z};
+      boxes.emplace_back(min, min + Mn::Vector3{0.5f, 1.0f, 0.75f});
+      soa.push_back(boxes.back());
+    }
+  }
+  CORRADE_COMPARE(soa.size(), boxes.size());
+
+  // test a subrange as well as the full range
+  for (size_t begin : {size_t{0}, size_t{3}}) {
+    std::vector<char> visible(boxes.size(), 2);
+    esp::gfx::frustumCullAabbs(frustum, soa, begin, boxes.size(),
+                               visible.data());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      CORRADE_ITERATION(i);
+      if (i < begin) {
+        // not touched
+        CORRADE_COMPARE(visible[i], 2);
+      } else {
+        CORRADE_COMPARE(
+            bool(visible[i]),
+            Mn::Math::Intersection::rangeFrustum(boxes[i], frustum));
+      }
+    }
+  }
+}
+
+void CullingTest::cachedAbsoluteMeshBB() {
+  esp::scene::SceneGraph sceneGraph;
+  esp::scene::SceneNode& parent = sceneGraph.getRootNode().createChild();
+  esp::scene::SceneNode& node = parent.createChild();
+  node.setMeshBB({{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}});
+  node.translate({1.0f, 0.0f, 0.0f});
+  CORRADE_COMPARE(node.cachedAbsoluteMeshBB(),
+                  Mn::Range3D({0.0f, -1.0f, -1.0f}, {2.0f, 1.0f, 1.0f}));
+
+  // moving a parent invalidates the box of its children
+  parent.translate({0.0f, 2.0f, 0.0f});
+  CORRADE_COMPARE(node.cachedAbsoluteMeshBB(),
+                  Mn::Range3D({0.0f, 1.0f, -1.0f}, {2.0f, 3.0f, 1.0f}));
+
+  // and so does changing the mesh box
+  node.setMeshBB({{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}});
+  CORRADE_COMPARE(node.cachedAbsoluteMeshBB(),
+                  Mn::Range3D({1.0f, 2.0f, 0.0f}, {2.0f, 3.0f, 1.0f}));
+}
+
 }  // namespace
 }  // namespace Test
 
@@ -2,15 +2,27 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/TestSuite/Tester.h>
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/Math/Angle.h>
 #include <Magnum/MeshTools/Compile.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/ResourceManager.h>
 #include <Magnum/Primitives/Cube.h>
 #include <Magnum/Shaders/Flat.h>
 #include <Magnum/Trade/MeshData.h>
+#include <algorithm>
+#include <string>
+#include <iterator>
+#include <vector>
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/DepthUnprojection.h"
 #include "esp/gfx/GenericDrawable.h"
+#include "esp/gfx/InstanceBuffers.h"
+#include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/WindowlessContext.h"
 #include "esp/scene/SceneManager.h"
@@ -37,10 +49,77 @@ class ResourceManagerExtended : public ResourceManager {
   esp::gfx::ShaderManager& getShaderManager() { return shaderManager_; }
 };
 
+// exposes the draw order of a render pass
+class SortingCamera : public esp::gfx::RenderCamera {
+ public:
+  explicit SortingCamera(esp::scene::SceneNode& node) : RenderCamera(node) {}
+  using RenderCamera::sortByDrawState;
+};
+
+// records how it was drawn into a shared log
+class RecordingDrawable : public esp::gfx::Drawable {
+ public:
+  RecordingDrawable(esp::scene::SceneNode& node,
+                    Mn::GL::Mesh& mesh,
+                    std::vector<std::string>& log,
+                    std::string name,
+                    Mn::UnsignedInt meshId,
+                    bool opaque = true)
+      : Drawable{node, mesh, nullptr},
+        log_(log),
+        name_{std::move(name)},
+        meshId_{meshId},
+        opaque_{opaque} {}
+
+  esp::gfx::InstanceKey getInstanceKey() const override {
+    esp::gfx::InstanceKey key;
+    key.meshId = meshId_;
+    key.mesh = &mesh_;
+    return key;
+  }
+  bool isOpaque() const override { return opaque_; }
+  void drawInstances(
+      const std::vector<
+          std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                    Mn::Matrix4>>& instances,
+      Mn::SceneGraph::Camera3D&) override {
+    std::string batch;
+    for (const auto& instance : instances) {
+      batch += (batch.empty() ? "" : "+") +
+               static_cast<RecordingDrawable&>(instance.first.get()).name_;
+    }
+    log_.push_back(batch);
+  }
+
+ private:
+  void draw(const Mn::Matrix4&, Mn::SceneGraph::Camera3D&) override {
+    log_.push_back(name_);
+  }
+
+  std::vector<std::string>& log_;
+  std::string name_;
+  Mn::UnsignedInt meshId_;
+  bool opaque_;
+};
+
+// a drawable the renderer knows nothing about, e.g. an overlay
+class OverlayDrawable : public Mn::SceneGraph::Drawable3D {
+ public:
+  explicit OverlayDrawable(esp::scene::SceneNode& node)
+      : Mn::SceneGraph::Drawable3D{node} {}
+
+ private:
+  void draw(const Mn::Matrix4&, Mn::SceneGraph::Camera3D&) override {}
+};
+
 struct DrawableTest : Cr::TestSuite::Tester {
   explicit DrawableTest();
   // tests
   void addRemoveDrawables();
+  void instancedDrawsOfTwoGroups();
+  void drawStateOrder();
+  void instancedDrawOrder();
+  void drawStatistics();
 
  protected:
   esp::gfx::WindowlessContext::uptr context_ =
@@ -57,7 +136,11 @@ DrawableTest::DrawableTest() {
   auto MM = MetadataMediator::create();
   resourceManager_ = std::make_unique<ResourceManagerExtended>(MM);
   //clang-format off
-  addTests({&DrawableTest::addRemoveDrawables});
+  addTests({&DrawableTest::addRemoveDrawables,
+            &DrawableTest::instancedDrawsOfTwoGroups,
+            &DrawableTest::drawStateOrder,
+            &DrawableTest::instancedDrawOrder,
+            &DrawableTest::drawStatistics});
   // flang-format on
   auto stageAttributesMgr = MM->getStageAttributesManager();
   std::string stageFile =
@@ -149,6 +232,198 @@ void DrawableTest::addRemoveDrawables() {
   CORRADE_VERIFY(!drawableGroup_->hasDrawable(dr->getDrawableId()));
 }
 
+void DrawableTest::instancedDrawsOfTwoGroups() {
+  Mn::GL::Mesh box = Mn::MeshTools::compile(Mn::Primitives::cubeSolid());
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID_);
+  esp::scene::SceneNode& sceneRootNode = sceneGraph.getRootNode();
+
+  // two groups drawing copies of the same mesh, on each side of the view
+  esp::gfx::DrawableGroup* groups[]{
+      sceneGraph.createDrawableGroup("instancedLeft"),
+      sceneGraph.createDrawableGroup("instancedRight")};
+  for (int i = 0; i != 2; ++i) {
+    CORRADE_VERIFY(groups[i]);
+    groups[i]->setInstancingEnabled(true);
+    for (const float y : {-2.0f, 2.0f}) {
+      esp::scene::SceneNode& node = sceneRootNode.createChild();
+      node.translate({i == 0 ? -3.0f : 3.0f, y, -12.0f});
+      node.addFeature<esp::gfx::GenericDrawable>(
+          box, esp::gfx::Drawable::Flags{},
+          resourceManager_->getShaderManager(), esp::NO_LIGHT_KEY,
+          esp::WHITE_MATERIAL_KEY, groups[i]);
+    }
+  }
+
+  const Mn::Vector2i size{64, 64};
+  esp::gfx::RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+  camera.node().setTransformation(Mn::Matrix4{});
+  camera.setProjectionMatrix(size.x(), size.y(), 0.1f, 100.0f,
+                             Mn::Deg(90.0f));
+  esp::gfx::RenderTarget::uptr target = esp::gfx::RenderTarget::create_unique(
+      size, esp::gfx::calculateDepthUnprojection(camera.projectionMatrix()));
+
+  auto draw = [&](esp::gfx::DrawableGroup& group) {
+    target->renderEnter();
+    camera.draw(group);
+    target->renderExit();
+    std::vector<char> pixels(std::size_t(size.product()) * 4);
+    target->readFrameRgba(
+        Mn::MutableImageView2D{Mn::PixelFormat::RGBA8Unorm, size, pixels});
+    return pixels;
+  };
+  const std::vector<char> left = draw(*groups[0]);
+  const std::vector<char> right = draw(*groups[1]);
+  CORRADE_VERIFY(left != std::vector<char>(left.size(), 0));
+  CORRADE_VERIFY(right != left);
+  // the draws of the second group don't change what the first one draws
+  CORRADE_VERIFY(draw(*groups[0]) == left);
+  CORRADE_VERIFY(draw(*groups[1]) == right);
+
+  // both fill the one buffer of the mesh, added to it once
+  Mn::Resource<esp::gfx::InstanceBuffers> instanceBuffers =
+      resourceManager_->getShaderManager().get<esp::gfx::InstanceBuffers>(
+          esp::gfx::InstanceBuffers::Key);
+  CORRADE_VERIFY(instanceBuffers);
+  CORRADE_COMPARE(instanceBuffers->size(), 1);
+}
+
+void DrawableTest::instancedDrawOrder() {
+  Mn::GL::Mesh box;
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID_);
+  esp::scene::SceneNode& node = sceneGraph.getRootNode().createChild();
+  esp::gfx::DrawableGroup group;
+
+  std::vector<std::string> log;
+  OverlayDrawable overlay{node};
+  RecordingDrawable a{node, box, log, "a", 1};
+  RecordingDrawable b{node, box, log, "b", 2};
+  RecordingDrawable c{node, box, log, "c", 1};
+  RecordingDrawable blended{node, box, log, "blended", 1, false};
+  RecordingDrawable d{node, box, log, "d", 2};
+  RecordingDrawable e{node, box, log, "e", 2};
+  RecordingDrawable f{node, box, log, "f", 1};
+  std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                        Mn::Matrix4>>
+      transforms;
+  for (Mn::SceneGraph::Drawable3D* drawable :
+       {static_cast<Mn::SceneGraph::Drawable3D*>(&a), &b, &c, &blended, &d,
+        &e, &overlay, &f}) {
+    transforms.emplace_back(*drawable, Mn::Matrix4{});
+  }
+
+  // batches don't reach across the drawables depending on the draw order,
+  // and are drawn in the order of their first drawable
+  CORRADE_COMPARE(
+      group.drawInstanced(transforms, sceneGraph.getDefaultRenderCamera()), 2);
+  CORRADE_COMPARE(log.size(), 5);
+  CORRADE_COMPARE(log[0], "a+c");
+  CORRADE_COMPARE(log[1], "b");
+  CORRADE_COMPARE(log[2], "blended");
+  CORRADE_COMPARE(log[3], "d+e");
+  CORRADE_COMPARE(log[4], "f");
+}
+
+void DrawableTest::drawStateOrder() {
+  Mn::GL::Mesh box = Mn::MeshTools::compile(Mn::Primitives::cubeSolid());
+  Mn::GL::Mesh strip =
+      Mn::MeshTools::compile(Mn::Primitives::cubeSolidStrip());
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID_);
+  esp::scene::SceneNode& node = sceneGraph.getRootNode().createChild();
+  esp::scene::SceneNode& cameraNode = sceneGraph.getRootNode().createChild();
+  SortingCamera camera{cameraNode};
+
+  auto create = [&](Mn::GL::Mesh& mesh, const char* material) {
+    return new esp::gfx::GenericDrawable{node,
+                                         mesh,
+                                         esp::gfx::Drawable::Flags{},
+                                         resourceManager_->getShaderManager(),
+                                         esp::NO_LIGHT_KEY,
+                                         material,
+                                         nullptr};
+  };
+  esp::gfx::GenericDrawable* white = create(box, esp::WHITE_MATERIAL_KEY);
+
+  // the key is made of the resource keys and the GL ids, not of addresses
+  const esp::gfx::DrawStateKey key = white->getDrawStateKey();
+  CORRADE_COMPARE(key.material, std::hash<Mn::ResourceKey>{}(
+                                    Mn::ResourceKey{esp::WHITE_MATERIAL_KEY}));
+  CORRADE_COMPARE(key.mesh, box.id());
+
+  // two runs of opaque drawables, on each side of an overlay
+  OverlayDrawable overlay{node};
+  Mn::SceneGraph::Drawable3D* groupOrder[]{
+      white,
+      create(strip, esp::DEFAULT_MATERIAL_KEY),
+      &overlay,
+      create(box, esp::DEFAULT_MATERIAL_KEY),
+      create(strip, esp::WHITE_MATERIAL_KEY),
+      create(box, esp::WHITE_MATERIAL_KEY)};
+  auto sorted = [&]() {
+    std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                          Mn::Matrix4>>
+        transforms;
+    for (Mn::SceneGraph::Drawable3D* drawable : groupOrder) {
+      transforms.emplace_back(*drawable,
+                              Mn::Matrix4::translation({0.0f, 0.0f, -5.0f}));
+    }
+    camera.sortByDrawState(transforms);
+    std::vector<Mn::SceneGraph::Drawable3D*> order;
+    for (const auto& transform : transforms) {
+      order.push_back(&transform.first.get());
+    }
+    return order;
+  };
+  const std::vector<Mn::SceneGraph::Drawable3D*> order = sorted();
+  CORRADE_COMPARE(order.size(), 6);
+  CORRADE_VERIFY(sorted() == order);
+
+  // the overlay stays between the drawables before and after it
+  CORRADE_VERIFY(order[2] == &overlay);
+  CORRADE_VERIFY(std::is_permutation(order.begin(), order.begin() + 2,
+                                     std::begin(groupOrder)));
+  CORRADE_VERIFY(std::is_permutation(order.begin() + 3, order.end(),
+                                     std::begin(groupOrder) + 3));
+  // and the runs are ordered by their keys
+  for (const std::size_t i : {0, 3, 4}) {
+    CORRADE_VERIFY(!(static_cast<esp::gfx::Drawable*>(order[i + 1])
+                         ->getDrawStateKey() <
+                     static_cast<esp::gfx::Drawable*>(order[i])
+                         ->getDrawStateKey()));
+  }
+}
+
+void DrawableTest::drawStatistics() {
+  Mn::GL::Mesh box = Mn::MeshTools::compile(Mn::Primitives::cubeSolid());
+  Mn::GL::Mesh strip =
+      Mn::MeshTools::compile(Mn::Primitives::cubeSolidStrip());
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID_);
+  esp::scene::SceneNode& node = sceneGraph.getRootNode().createChild();
+  esp::gfx::DrawableGroup group;
+  std::vector<std::string> log;
+  RecordingDrawable a{node, box, log, "a", 1};
+  RecordingDrawable b{node, strip, log, "b", 2};
+  RecordingDrawable c{node, box, log, "c", 1};
+  group.add(a).add(b).add(c);
+  sceneGraph.updateTransformations();
+  esp::gfx::RenderCamera& camera = sceneGraph.getDefaultRenderCamera();
+
+  // the triangles are counted whatever the order the drawables are drawn in,
+  // only the state changes depend on the sorting
+  CORRADE_COMPARE(camera.draw(group, {}), 3);
+  CORRADE_COMPARE(log.size(), 3);
+  CORRADE_COMPARE(camera.getPreviousNumTriangles(), 3 * 12);
+  CORRADE_COMPARE(camera.getPreviousNumDrawStateChanges(), 2);
+
+  log.clear();
+  CORRADE_COMPARE(
+      camera.draw(group, {esp::gfx::RenderCamera::Flag::PreserveDrawOrder}),
+      3);
+  CORRADE_COMPARE(log.size(), 3);
+  CORRADE_COMPARE(log[1], "b");
+  CORRADE_COMPARE(camera.getPreviousNumTriangles(), 3 * 12);
+  CORRADE_COMPARE(camera.getPreviousNumDrawStateChanges(), 0);
+}
+
 }  // namespace
 }  // namespace Test
 
@@ -6,11 +6,14 @@
 #include <Corrade/TestSuite/Compare/Numeric.h>
 #include <Corrade/TestSuite/Tester.h>
 #include <Corrade/Utility/DebugStl.h>
+#include <Corrade/Utility/Directory.h>
 #include <Magnum/EigenIntegration/Integration.h>
 #include <Magnum/Math/FunctionsBatch.h>
 #include "esp/core/Utility.h"
 #include "esp/geo/CoordinateFrame.h"
 #include "esp/geo/OBB.h"
+#include "esp/geo/TriangleBVH.h"
+#include "esp/geo/VoxelGrid.h"
 #include "esp/geo/geo.h"
 
 namespace Cr = Corrade;
@@ -41,16 +44,42 @@ Mn::Range3D getTransformedBB_standard(const Mn::Range3D& range,
   return transformedBB;
 }
 
+// a flat grid of size x size quads made of two triangles each, with unit
+// spacing
+void gridMesh(int size,
+              std::vector<Mn::Vector3>& positions,
+              std::vector<Mn::UnsignedInt>& indices) {
+  for (int y = 0; y <= size; ++y) {
+    for (int x = 0; x <= size; ++x) {
+      positions.emplace_back(float(x), float(y), 0.0f);
+    }
+  }
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      const Mn::UnsignedInt a = y * (size + 1) + x;
+      const Mn::UnsignedInt c = a + size + 1;
+      indices.insert(indices.end(), {a, a + 1, c + 1, a, c + 1, c});
+    }
+  }
+}
+
 struct GeoTest : Cr::TestSuite::Tester {
   explicit GeoTest();
   // tests
   void aabb();
   void obbConstruction();
   void obbFunctions();
+  void batchedKernels();
   void coordinateFrame();
+  void simplifyByVertexClustering();
+  void generateMeshLods();
+  void simplifyCollisionMesh();
+  void voxelizeTriangles();
+  void triangleBVH();
   // benchmarks
   void getTransformedBB_standard();
   void getTransformedBB();
+  void getTransformedBBs();
 
   std::vector<Mn::Matrix4> xforms_;
   // number of transformations
@@ -66,9 +95,16 @@ GeoTest::GeoTest() {
   addTests({&GeoTest::aabb,
             &GeoTest::obbConstruction,
             &GeoTest::obbFunctions,
-            &GeoTest::coordinateFrame});
+            &GeoTest::batchedKernels,
+            &GeoTest::coordinateFrame,
+            &GeoTest::simplifyByVertexClustering,
+            &GeoTest::generateMeshLods,
+            &GeoTest::simplifyCollisionMesh,
+            &GeoTest::voxelizeTriangles,
+            &GeoTest::triangleBVH});
   addBenchmarks({&GeoTest::getTransformedBB_standard,
-                 &GeoTest::getTransformedBB}, 10);
+                 &GeoTest::getTransformedBB,
+                 &GeoTest::getTransformedBBs}, 10);
   // clang-format on
 
   // Generate N transformations (random positions and orientations)
@@ -100,6 +136,14 @@ void GeoTest::getTransformedBB() {
   }
 }
 
+void GeoTest::getTransformedBBs() {
+  const std::vector<Mn::Range3D> boxes(xforms_.size(), box_);
+  std::vector<Mn::Range3D> aabbs(xforms_.size());
+  CORRADE_BENCHMARK(iterations_) {
+    esp::geo::getTransformedBBs(boxes, xforms_, aabbs);
+  }
+}
+
 void GeoTest::aabb() {
   // compute aabb for each box using standard method and library method
   // respectively.
@@ -160,6 +204,82 @@ void GeoTest::obbFunctions() {
   CORRADE_COMPARE_AS(obb2.distance(vec3f(-10, -5, 2)), 1, float);
 }
 
+void GeoTest::batchedKernels() {
+  const auto randomFloat = []() { return (rand() % 2001) / 100.0f - 10.0f; };
+  const auto randomPoint = [&]() {
+    return Mn::Vector3{randomFloat(), randomFloat(), randomFloat()};
+  };
+
+  // the batched AABB transform matches the scalar one
+  std::vector<Mn::Range3D> boxes;
+  for (size_t i = 0; i < xforms_.size(); ++i) {
+    boxes.emplace_back(Mn::Math::minmax({randomPoint(), randomPoint()}));
+  }
+  std::vector<Mn::Range3D> aabbs(boxes.size());
+  esp::geo::getTransformedBBs(boxes, xforms_, aabbs);
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    const Mn::Range3D expected =
+        esp::geo::getTransformedBB(boxes[i], xforms_[i]);
+    CORRADE_COMPARE_WITH(aabbs[i].min(), expected.min(),
+                         Cr::TestSuite::Compare::around(Mn::Vector3{1e-3f}));
+    CORRADE_COMPARE_WITH(aabbs[i].max(), expected.max(),
+                         Cr::TestSuite::Compare::around(Mn::Vector3{1e-3f}));
+  }
+
+  // the bounds of point sets, around the lane count and its remainders
+  CORRADE_COMPARE(esp::geo::getPointSetBounds({}), Mn::Range3D{});
+  for (const size_t count : {1, 7, 8, 24, 25, 100}) {
+    std::vector<Mn::Vector3> points;
+    for (size_t i = 0; i < count; ++i) {
+      points.push_back(randomPoint());
+    }
+    const std::pair<Mn::Vector3, Mn::Vector3> expected =
+        Mn::Math::minmax(points);
+    const Mn::Range3D bounds = esp::geo::getPointSetBounds(points);
+    CORRADE_COMPARE(bounds.min(), expected.first);
+    CORRADE_COMPARE(bounds.max(), expected.second);
+
+    std::vector<float> distances(count - 1);
+    esp::geo::calcWeightedDistances(points, 0.5f, distances);
+    for (size_t i = 0; i + 1 < count; ++i) {
+      CORRADE_COMPARE(distances[i], esp::geo::calcWeightedDistance(
+                                        points[i], points[i + 1], 0.5f));
+    }
+  }
+
+  // OBB containment and distance match the per-box ones
+  ObbsSoA obbs;
+  std::vector<OBB> reference;
+  for (int i = 0; i < 20; ++i) {
+    const Mn::Quaternion rotation = esp::core::randomRotation();
+    reference.emplace_back(
+        vec3f(randomFloat(), randomFloat(), randomFloat()),
+        vec3f(1.0f + rand() % 5, 1.0f + rand() % 5, 1.0f + rand() % 5),
+        quatf(rotation.scalar(), rotation.vector().x(), rotation.vector().y(),
+              rotation.vector().z()));
+    obbs.push_back(reference.back());
+  }
+  CORRADE_COMPARE(obbs.size(), reference.size());
+  // every other box, to test the indexing
+  std::vector<uint32_t> items;
+  for (uint32_t i = 0; i < reference.size(); i += 2) {
+    items.push_back(i);
+  }
+  std::vector<char> contained(items.size());
+  std::vector<float> obbDistances(items.size());
+  for (int j = 0; j < 200; ++j) {
+    const vec3f point(randomFloat(), randomFloat(), randomFloat());
+    esp::geo::obbsContain(obbs, items, point, contained);
+    esp::geo::obbsDistance(obbs, items, point, obbDistances);
+    for (size_t i = 0; i < items.size(); ++i) {
+      const OBB& obb = reference[items[i]];
+      CORRADE_COMPARE(bool(contained[i]), obb.contains(point));
+      CORRADE_COMPARE_WITH(obbDistances[i], obb.distance(point),
+                           Cr::TestSuite::Compare::around(1e-4f));
+    }
+  }
+}
+
 void GeoTest::coordinateFrame() {
   const vec3f origin(1, -2, 3);
   const vec3f up(0, 0, 1);
@@ -200,6 +320,193 @@ void GeoTest::coordinateFrame() {
   CORRADE_VERIFY(c3 == c4);
 }
 
+void GeoTest::simplifyByVertexClustering() {
+  std::vector<Mn::Vector3> positions;
+  std::vector<Mn::UnsignedInt> indices;
+  gridMesh(64, positions, indices);
+
+  // cells smaller than the spacing keep every triangle
+  CORRADE_COMPARE(
+      esp::geo::simplifyByVertexClustering(positions, indices, 0.5f).size(),
+      indices.size());
+
+  // 2x2 vertices per cell leave a grid with a spacing of 2
+  std::vector<Mn::UnsignedInt> simplified =
+      esp::geo::simplifyByVertexClustering(positions, indices, 2.0f);
+  CORRADE_COMPARE(simplified.size(), indices.size() / 4);
+  for (std::size_t i = 0; i < simplified.size(); i += 3) {
+    CORRADE_VERIFY(simplified[i] < positions.size());
+    CORRADE_VERIFY(simplified[i] != simplified[i + 1]);
+    CORRADE_VERIFY(simplified[i + 1] != simplified[i + 2]);
+    CORRADE_VERIFY(simplified[i] != simplified[i + 2]);
+  }
+
+  // a single cell collapses everything
+  CORRADE_VERIFY(
+      esp::geo::simplifyByVertexClustering(positions, indices, 100.0f)
+          .empty());
+}
+
+void GeoTest::generateMeshLods() {
+  std::vector<Mn::Vector3> positions;
+  std::vector<Mn::UnsignedInt> indices;
+  gridMesh(64, positions, indices);
+
+  // 8192 triangles, the third level would have less than 256
+  std::vector<esp::geo::MeshLod> lods =
+      esp::geo::generateMeshLods(positions, indices, 3, 0.25f, 256);
+  CORRADE_COMPARE(lods.size(), std::size_t{2});
+
+  std::size_t previousTriangles = indices.size() / 3;
+  float previousError = 0.0f;
+  for (const esp::geo::MeshLod& lod : lods) {
+    const std::size_t triangles = lod.indices.size() / 3;
+    CORRADE_VERIFY(triangles >= 256);
+    CORRADE_VERIFY(triangles <= previousTriangles / 4);
+    CORRADE_VERIFY(lod.error > previousError);
+    previousTriangles = triangles;
+    previousError = lod.error;
+  }
+
+  // too small to be worth simplifying
+  CORRADE_VERIFY(
+      esp::geo::generateMeshLods(positions, indices, 3, 0.25f, 100000)
+          .empty());
+}
+
+void GeoTest::simplifyCollisionMesh() {
+  std::vector<Mn::Vector3> positions;
+  std::vector<Mn::UnsignedInt> indices;
+  gridMesh(64, positions, indices);
+
+  // cells with a diagonal of the error, of 2x2 vertices here
+  esp::geo::SimplifiedMesh simplified = esp::geo::simplifyCollisionMesh(
+      positions, indices, 2.0f * std::sqrt(3.0f));
+  CORRADE_COMPARE(simplified.indices.size(), indices.size() / 4);
+  CORRADE_VERIFY(simplified.positions.size() < positions.size() / 3);
+  for (const Mn::UnsignedInt index : simplified.indices) {
+    CORRADE_VERIFY(index < simplified.positions.size());
+  }
+  for (const Mn::Vector3& position : simplified.positions) {
+    CORRADE_COMPARE(position.z(), 0.0f);
+  }
+
+  // the same triangle in both windings is kept once
+  const std::vector<Mn::UnsignedInt> twice{0, 1, 65, 65, 1, 0};
+  simplified = esp::geo::simplifyCollisionMesh(positions, twice, 0.5f);
+  CORRADE_COMPARE(simplified.indices.size(), std::size_t{3});
+  CORRADE_COMPARE(simplified.positions.size(), std::size_t{3});
+  CORRADE_COMPARE(simplified.positions[simplified.indices[2]],
+                  positions[65]);
+}
+
+void GeoTest::voxelizeTriangles() {
+  std::vector<Mn::Vector3> positions;
+  std::vector<Mn::UnsignedInt> indices;
+  gridMesh(8, positions, indices);
+
+  // the 8x8 quad lying in the middle of the third layer of 10x10 voxels,
+  // half a voxel off their corners so that it partly covers 9x9 of them
+  VoxelGrid grid{{-0.5f, -0.5f, -2.5f}, 1.0f, {10, 10, 5}};
+  esp::geo::voxelizeTriangles(grid, positions, indices, Mn::Matrix4{}, 7);
+  CORRADE_COMPARE(grid.numOccupied(), std::size_t{81});
+  CORRADE_COMPARE(grid.at({0, 0, 2}), 7);
+  CORRADE_COMPARE(grid.at({8, 8, 2}), 7);
+  CORRADE_COMPARE(grid.at({9, 9, 2}), VoxelGrid::Empty);
+  CORRADE_COMPARE(grid.at({1, 1, 1}), VoxelGrid::Empty);
+
+  // a thin diagonal wall touches every voxel it crosses, the later mesh
+  // winning where they overlap, the same on any number of threads
+  const Mn::Matrix4 wall = Mn::Matrix4::translation({0.3f, 0.0f, -2.2f}) *
+                           Mn::Matrix4::rotationY(Mn::Deg(-60.0f)) *
+                           Mn::Matrix4::rotationX(Mn::Deg(10.0f));
+  VoxelGrid single = grid;
+  esp::geo::voxelizeTriangles(grid, positions, indices, wall, 3);
+  esp::geo::voxelizeTriangles(single, positions, indices, wall, 3, 1);
+  CORRADE_VERIFY(grid.voxels == single.voxels);
+  CORRADE_VERIFY(grid.numOccupied() > 81);
+  for (const Mn::Vector3i& voxel : grid.occupiedVoxels()) {
+    const uint32_t id = grid.at(voxel);
+    CORRADE_VERIFY(id == 3 || id == 7);
+  }
+  // the center of every triangle is in a marked voxel
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const Mn::Vector3 center =
+        wall.transformPoint((positions[indices[i]] + positions[indices[i + 1]] +
+                             positions[indices[i + 2]]) /
+                            3.0f);
+    const Mn::Vector3i voxel{Mn::Math::floor(center - grid.origin)};
+    if ((voxel >= Mn::Vector3i{0}).all() && (voxel < grid.size).all())
+      CORRADE_COMPARE(grid.at(voxel), 3);
+  }
+
+  const std::string filename = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "GeoTest_voxelizeTriangles.voxels");
+  CORRADE_VERIFY(saveVoxelGrid(grid, filename));
+  VoxelGrid loaded;
+  CORRADE_VERIFY(loadVoxelGrid(filename, loaded));
+  CORRADE_COMPARE(loaded.origin, grid.origin);
+  CORRADE_COMPARE(loaded.voxelSize, grid.voxelSize);
+  CORRADE_COMPARE(loaded.size, grid.size);
+  CORRADE_VERIFY(loaded.voxels == grid.voxels);
+  CORRADE_VERIFY(Cr::Utility::Directory::writeString(filename, "VOXG"));
+  CORRADE_VERIFY(!loadVoxelGrid(filename, loaded));
+}
+
+void GeoTest::triangleBVH() {
+  std::vector<Mn::Vector3> positions;
+  std::vector<Mn::UnsignedInt> indices;
+  gridMesh(32, positions, indices);
+
+  // two 32x32 floors, at y = 0 and y = 2
+  TriangleBVH bvh;
+  const Mn::Matrix4 floor = Mn::Matrix4::rotationX(Mn::Deg(90.0f));
+  bvh.addMesh(positions, indices, floor);
+  bvh.addMesh(positions, indices,
+              Mn::Matrix4::translation(Mn::Vector3::yAxis(2.0f)) * floor);
+  CORRADE_COMPARE(bvh.numNodes(), 0);
+  bvh.build();
+  CORRADE_COMPARE(bvh.numTriangles(), std::size_t{4 * 32 * 32});
+  CORRADE_VERIFY(bvh.numNodes() > 1);
+  CORRADE_COMPARE(bvh.bounds(), Mn::Range3D({0.0f, 0.0f, 0.0f},
+                                            {32.0f, 2.0f, 32.0f}));
+
+  // slanted rays from above, of length 2, cross y = 2 after 1.5 lengths and
+  // y = 0 after 2.5, everywhere on the floors
+  const Mn::Vector3 direction{0.2f, -2.0f, 0.1f};
+  std::vector<TriangleBVH::Hit> hits;
+  for (float x = 1.1f; x < 30.0f; x += 1.7f) {
+    for (float z = 1.3f; z < 30.0f; z += 2.3f) {
+      const Ray ray{{x, 5.0f, z}, direction};
+      TriangleBVH::Hit hit;
+      CORRADE_VERIFY(bvh.castRay(ray, 100.0f, hit));
+      CORRADE_COMPARE_WITH(hit.distance, 1.5f,
+                           Cr::TestSuite::Compare::around(1.0e-5f));
+      CORRADE_COMPARE(hit.normal, Mn::Vector3::yAxis());
+      CORRADE_COMPARE(hit.triangle / (2 * 32 * 32), 1);
+
+      hits.clear();
+      CORRADE_COMPARE(bvh.castRayAll(ray, 100.0f, hits), 2);
+      CORRADE_COMPARE_WITH(hits[0].distance, 1.5f,
+                           Cr::TestSuite::Compare::around(1.0e-5f));
+      CORRADE_COMPARE_WITH(hits[1].distance, 2.5f,
+                           Cr::TestSuite::Compare::around(1.0e-5f));
+      CORRADE_COMPARE(hits[1].triangle / (2 * 32 * 32), 0);
+      CORRADE_COMPARE(bvh.castRayAll(ray, 2.0f, hits), 1);
+    }
+  }
+
+  // the normals face the origin of the ray, rays outside miss
+  TriangleBVH::Hit hit;
+  CORRADE_VERIFY(bvh.castRay({{4.5f, 1.0f, 4.5f}, Mn::Vector3::yAxis()},
+                             100.0f, hit));
+  CORRADE_COMPARE(hit.normal, -Mn::Vector3::yAxis());
+  CORRADE_VERIFY(!bvh.castRay({{40.0f, 5.0f, 4.5f}, -Mn::Vector3::yAxis()},
+                              100.0f, hit));
+  CORRADE_VERIFY(!bvh.castRay({{4.5f, 5.0f, 4.5f}, Mn::Vector3{}}, 100.0f,
+                              hit));
+}
+
 }  // namespace Test
 
 CORRADE_TEST_MAIN(Test::GeoTest)
@@ -8,8 +8,11 @@
 #include "esp/assets/ResourceManager.h"
 #include "esp/gfx/Renderer.h"
 #include "esp/gfx/WindowlessContext.h"
+#include "esp/gfx/replay/KeyframeServer.h"
+#include "esp/gfx/replay/KeyframeStream.h"
 #include "esp/gfx/replay/Player.h"
 #include "esp/gfx/replay/Recorder.h"
+#include "esp/scene/SceneGraph.h"
 #include "esp/scene/SceneManager.h"
 
 #include <Corrade/Containers/Optional.h>
@@ -18,6 +21,10 @@
 #include <Magnum/Math/Range.h>
 
 #include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
 #include <fstream>
 #include <string>
 
@@ -101,6 +108,80 @@ TEST(GfxReplayTest, recorder) {
          Mn::Vector3(4.f, 5.f, 6.f));
 }
 
+// only the instances that moved or changed semantic id get state updates
+TEST(GfxReplayTest, recorderMovedInstances) {
+  esp::scene::SceneGraph sceneGraph;
+  auto& parent = sceneGraph.getRootNode().createChild();
+  auto& child = parent.createChild();
+  auto& other = sceneGraph.getRootNode().createChild();
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+
+  esp::gfx::replay::Recorder recorder;
+  recorder.onCreateRenderAssetInstance(&child, creation);
+  recorder.onCreateRenderAssetInstance(&other, creation);
+  recorder.saveKeyframe();
+  // nothing changed
+  recorder.saveKeyframe();
+  // moving the parent moves the child, even if something else cleaned it
+  parent.setTranslation(Mn::Vector3(1.f, 0.f, 0.f));
+  child.cachedAbsoluteTransformationMatrix();
+  recorder.saveKeyframe();
+  other.setSemanticId(3);
+  recorder.saveKeyframe();
+  // moving a node that is still dirty
+  other.setTranslation(Mn::Vector3(0.f, 1.f, 0.f));
+  other.setTranslation(Mn::Vector3(0.f, 2.f, 0.f));
+  recorder.saveKeyframe();
+
+  const auto& keyframes = recorder.debugGetSavedKeyframes();
+  ASSERT_EQ(keyframes.size(), 5);
+  EXPECT_EQ(keyframes[0].stateUpdates.size(), 2);
+  EXPECT_EQ(keyframes[1].stateUpdates.size(), 0);
+  ASSERT_EQ(keyframes[2].stateUpdates.size(), 1);
+  EXPECT_EQ(keyframes[2].stateUpdates[0].second.absTransform.translation,
+            Mn::Vector3(1.f, 0.f, 0.f));
+  ASSERT_EQ(keyframes[3].stateUpdates.size(), 1);
+  EXPECT_EQ(keyframes[3].stateUpdates[0].second.semanticId, 3);
+  ASSERT_EQ(keyframes[4].stateUpdates.size(), 1);
+  EXPECT_EQ(keyframes[4].stateUpdates[0].second.absTransform.translation,
+            Mn::Vector3(0.f, 2.f, 0.f));
+}
+
+// moves below the thresholds are dropped, and don't add up
+TEST(GfxReplayTest, recorderStateUpdateThresholds) {
+  esp::scene::SceneGraph sceneGraph;
+  auto& node = sceneGraph.getRootNode().createChild();
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+
+  esp::gfx::replay::Recorder recorder;
+  recorder.setStateUpdateThresholds(0.01f, 0.01f);
+  recorder.onCreateRenderAssetInstance(&node, creation);
+  recorder.saveKeyframe();
+  for (int i = 1; i <= 4; ++i) {
+    node.setTranslation(Mn::Vector3(0.004f * i, 0.f, 0.f));
+    recorder.saveKeyframe();
+  }
+  node.setRotation(
+      Mn::Quaternion::rotation(Mn::Deg(0.1f), Mn::Vector3::yAxis()));
+  recorder.saveKeyframe();
+  node.setRotation(
+      Mn::Quaternion::rotation(Mn::Deg(1.f), Mn::Vector3::yAxis()));
+  recorder.saveKeyframe();
+
+  const auto& keyframes = recorder.debugGetSavedKeyframes();
+  ASSERT_EQ(keyframes.size(), 7);
+  EXPECT_EQ(keyframes[0].stateUpdates.size(), 1);
+  EXPECT_EQ(keyframes[1].stateUpdates.size(), 0);
+  EXPECT_EQ(keyframes[2].stateUpdates.size(), 0);
+  // 12 mm from the last saved state
+  ASSERT_EQ(keyframes[3].stateUpdates.size(), 1);
+  EXPECT_EQ(keyframes[4].stateUpdates.size(), 0);
+  EXPECT_EQ(keyframes[5].stateUpdates.size(), 0);
+  EXPECT_EQ(keyframes[6].stateUpdates.size(), 1);
+}
+
 // construct some render keyframes and play them using replay::Player
 TEST(GfxReplayTest, player) {
   esp::gfx::WindowlessContext::uptr context_ =
@@ -275,3 +356,336 @@ TEST(GfxReplayTest, playerReadInvalidFile) {
                  << testFilepath;
   }
 }
+
+// write keyframes with KeyframeStreamWriter and read them back
+TEST(GfxReplayTest, keyframeStream) {
+  auto testFilepath =
+      Corrade::Utility::Directory::join(DATA_DIR, "./gfx_replay_test.bin");
+
+  esp::assets::AssetInfo info = esp::assets::AssetInfo::fromPath("box.glb");
+  info.virtualUnitToMeters = 0.5f;
+  esp::assets::RenderAssetInstanceCreationInfo::Flags flags;
+  flags |= esp::assets::RenderAssetInstanceCreationInfo::Flag::IsSemantic;
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Mn::Vector3(1.f, 2.f, 3.f), flags, "lights");
+  const Mn::Quaternion rotation =
+      Mn::Quaternion::rotation(Mn::Deg(30.f), Mn::Vector3::yAxis());
+
+  std::vector<esp::gfx::replay::Keyframe> keyframes;
+  keyframes.emplace_back(
+      esp::gfx::replay::Keyframe{{info}, {{7, creation}}, {}, {}, {}});
+  // enough keyframes for a few chunks, the last one partial
+  for (int i = 0; i < 10; ++i) {
+    keyframes.emplace_back(esp::gfx::replay::Keyframe{
+        {},
+        {},
+        {},
+        {{7, {{Mn::Vector3(0.1f * i, -2.f, 300.f), rotation}, i}}},
+        {{"camera", {Mn::Vector3(0.123456f, 0.f, 0.f), rotation}}}});
+  }
+  keyframes.emplace_back(esp::gfx::replay::Keyframe{{}, {}, {7}, {}, {}});
+
+  {
+    esp::gfx::replay::KeyframeStreamWriter writer(testFilepath, 4);
+    ASSERT_TRUE(writer.isOpen());
+    for (const auto& keyframe : keyframes) {
+      writer.write(keyframe);
+    }
+    EXPECT_TRUE(writer.close());
+    EXPECT_EQ(writer.numKeyframes(), keyframes.size());
+  }
+
+  ASSERT_TRUE(esp::gfx::replay::isKeyframeStreamFile(testFilepath));
+  std::vector<esp::gfx::replay::Keyframe> read;
+  ASSERT_TRUE(esp::gfx::replay::readKeyframeStream(testFilepath, read));
+  ASSERT_EQ(read.size(), keyframes.size());
+
+  ASSERT_EQ(read[0].loads.size(), 1);
+  EXPECT_EQ(read[0].loads[0], info);
+  ASSERT_EQ(read[0].creations.size(), 1);
+  EXPECT_EQ(read[0].creations[0].first, 7);
+  EXPECT_EQ(read[0].creations[0].second.filepath, "box.glb");
+  EXPECT_EQ(*read[0].creations[0].second.scale, Mn::Vector3(1.f, 2.f, 3.f));
+  EXPECT_TRUE(read[0].creations[0].second.isSemantic());
+  EXPECT_FALSE(read[0].creations[0].second.isRGBD());
+  EXPECT_EQ(read[0].creations[0].second.lightSetupKey, "lights");
+
+  for (int i = 0; i < 10; ++i) {
+    const auto& keyframe = read[i + 1];
+    ASSERT_EQ(keyframe.stateUpdates.size(), 1);
+    EXPECT_EQ(keyframe.stateUpdates[0].first, 7);
+    const auto& state = keyframe.stateUpdates[0].second;
+    // translations are quantized to 0.1 mm, rotations to 16 bits
+    const Mn::Vector3 translation(0.1f * i, -2.f, 300.f);
+    EXPECT_LE((state.absTransform.translation - translation).max(), 1e-4f);
+    EXPECT_GE((state.absTransform.translation - translation).min(), -1e-4f);
+    EXPECT_GT(Mn::Math::dot(state.absTransform.rotation, rotation), 0.9999f);
+    EXPECT_EQ(state.semanticId, i);
+    // user transforms are exact
+    EXPECT_EQ(keyframe.userTransforms.at("camera").translation,
+              Mn::Vector3(0.123456f, 0.f, 0.f));
+    EXPECT_EQ(keyframe.userTransforms.at("camera").rotation, rotation);
+  }
+  ASSERT_EQ(read.back().deletions.size(), 1);
+  EXPECT_EQ(read.back().deletions[0], 7);
+
+  // Player tells the binary file from a JSON one
+  auto dummyCallback =
+      [&](const esp::assets::AssetInfo& assetInfo,
+          const esp::assets::RenderAssetInstanceCreationInfo& creation) {
+        return nullptr;
+      };
+  esp::gfx::replay::Player player(dummyCallback);
+  player.readKeyframesFromFile(testFilepath);
+  EXPECT_EQ(player.getNumKeyframes(), keyframes.size());
+
+  bool success = Corrade::Utility::Directory::rm(testFilepath);
+  if (!success) {
+    LOG(WARNING) << "GfxReplayTest::keyframeStream : unable to remove "
+                    "temporary test file "
+                 << testFilepath;
+  }
+}
+
+// seeking from snapshots gives the same scene as replaying from the start
+TEST(GfxReplayTest, playerSeekFromSnapshots) {
+  esp::assets::AssetInfo info = esp::assets::AssetInfo::fromPath("box.glb");
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+
+  std::vector<esp::gfx::replay::Keyframe> keyframes;
+  for (int i = 0; i < 100; ++i) {
+    esp::gfx::replay::Keyframe keyframe;
+    if (i == 0) {
+      keyframe.loads.push_back(info);
+    }
+    // instance 0 lives throughout and instance i / 10 for ten keyframes
+    if (i % 10 == 0) {
+      keyframe.creations.emplace_back(1 + i / 10, creation);
+      if (i > 0) {
+        keyframe.deletions.push_back(i / 10);
+      } else {
+        keyframe.creations.emplace_back(0, creation);
+      }
+    }
+    keyframe.stateUpdates.emplace_back(
+        0, esp::gfx::replay::RenderAssetInstanceState{
+               {Mn::Vector3(float(i), 0.f, 0.f), Mn::Quaternion()}, i});
+    if (i % 3 == 0) {
+      keyframe.stateUpdates.emplace_back(
+          1 + i / 10,
+          esp::gfx::replay::RenderAssetInstanceState{
+              {Mn::Vector3(0.f, float(i), 0.f), Mn::Quaternion()}, 0});
+    }
+    keyframes.push_back(keyframe);
+  }
+
+  esp::scene::SceneGraph sceneGraph;
+  esp::scene::SceneGraph referenceSceneGraph;
+  auto createIn = [](esp::scene::SceneGraph& graph) {
+    return [&graph](const esp::assets::AssetInfo&,
+                    const esp::assets::RenderAssetInstanceCreationInfo&) {
+      return &graph.getRootNode().createChild();
+    };
+  };
+  auto translations = [](esp::scene::SceneGraph& graph) {
+    std::vector<std::pair<float, float>> result;
+    for (auto* child = graph.getRootNode().children().first(); child;
+         child = child->nextSibling()) {
+      const Mn::Vector3 translation =
+          static_cast<esp::scene::SceneNode*>(child)->translation();
+      result.emplace_back(translation.x(), translation.y());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+
+  esp::gfx::replay::Player player(createIn(sceneGraph));
+  player.setSnapshotInterval(7);
+  player.debugSetKeyframes(std::vector<esp::gfx::replay::Keyframe>(keyframes));
+  esp::gfx::replay::Player reference(createIn(referenceSceneGraph));
+  reference.setSnapshotInterval(0);
+  reference.debugSetKeyframes(std::move(keyframes));
+
+  for (const int keyframeIndex : {99, 3, 50, 51, 49, 14, 14, 0, 98, -1, 42}) {
+    player.setKeyframeIndex(keyframeIndex);
+    reference.setKeyframeIndex(keyframeIndex);
+    EXPECT_EQ(player.getKeyframeIndex(), keyframeIndex);
+    EXPECT_EQ(translations(sceneGraph), translations(referenceSceneGraph));
+  }
+}
+
+// a fractional keyframe index blends the transforms of two keyframes, and
+// setting a keyframe afterwards isn't affected by the blending
+TEST(GfxReplayTest, playerInterpolation) {
+  esp::assets::AssetInfo info = esp::assets::AssetInfo::fromPath("box.glb");
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+  const Mn::Quaternion rotation =
+      Mn::Quaternion::rotation(Mn::Deg(90.f), Mn::Vector3::yAxis());
+
+  std::vector<esp::gfx::replay::Keyframe> keyframes(3);
+  keyframes[0].loads.push_back(info);
+  keyframes[0].creations.emplace_back(0, creation);
+  keyframes[0].stateUpdates.emplace_back(
+      0, esp::gfx::replay::RenderAssetInstanceState{
+             {Mn::Vector3(0.f), Mn::Quaternion()}, 0});
+  keyframes[0].userTransforms["camera"] = {Mn::Vector3(0.f), Mn::Quaternion()};
+  keyframes[1].stateUpdates.emplace_back(
+      0, esp::gfx::replay::RenderAssetInstanceState{
+             {Mn::Vector3(2.f, 0.f, 0.f), rotation}, 0});
+  keyframes[1].creations.emplace_back(1, creation);
+  keyframes[1].stateUpdates.emplace_back(
+      1, esp::gfx::replay::RenderAssetInstanceState{
+             {Mn::Vector3(0.f, 5.f, 0.f), Mn::Quaternion()}, 0});
+  keyframes[1].userTransforms["camera"] = {Mn::Vector3(0.f, 0.f, 4.f),
+                                           Mn::Quaternion()};
+
+  esp::scene::SceneGraph sceneGraph;
+  std::vector<esp::scene::SceneNode*> nodes;
+  esp::gfx::replay::Player player(
+      [&](const esp::assets::AssetInfo&,
+          const esp::assets::RenderAssetInstanceCreationInfo&) {
+        nodes.push_back(&sceneGraph.getRootNode().createChild());
+        return nodes.back();
+      });
+  player.debugSetKeyframes(std::move(keyframes));
+
+  player.setInterpolatedKeyframeIndex(0.25f);
+  EXPECT_EQ(player.getKeyframeIndex(), 0);
+  // instance 1 is only created by keyframe 1
+  ASSERT_EQ(nodes.size(), 1u);
+  EXPECT_EQ(nodes[0]->translation(), Mn::Vector3(0.5f, 0.f, 0.f));
+  EXPECT_EQ(nodes[0]->rotation(),
+            Mn::Quaternion::rotation(Mn::Deg(22.5f), Mn::Vector3::yAxis()));
+  Mn::Vector3 translation;
+  Mn::Quaternion userRotation;
+  EXPECT_TRUE(player.getUserTransform("camera", &translation, &userRotation));
+  EXPECT_EQ(translation, Mn::Vector3(0.f, 0.f, 1.f));
+
+  player.setKeyframeIndex(0);
+  EXPECT_EQ(nodes[0]->translation(), Mn::Vector3(0.f));
+  EXPECT_EQ(nodes[0]->rotation(), Mn::Quaternion());
+
+  player.setInterpolatedKeyframeIndex(0.5f);
+  player.setKeyframeIndex(1);
+  EXPECT_EQ(nodes[0]->translation(), Mn::Vector3(2.f, 0.f, 0.f));
+  EXPECT_EQ(nodes[0]->rotation(), rotation);
+
+  // keyframe 2 updates nothing, so nothing moves toward it
+  player.setInterpolatedKeyframeIndex(1.5f);
+  EXPECT_EQ(player.getKeyframeIndex(), 1);
+  ASSERT_EQ(nodes.size(), 2u);
+  EXPECT_EQ(nodes[0]->translation(), Mn::Vector3(2.f, 0.f, 0.f));
+  EXPECT_EQ(nodes[1]->translation(), Mn::Vector3(0.f, 5.f, 0.f));
+
+  player.setInterpolatedKeyframeIndex(2.f);
+  EXPECT_EQ(player.getKeyframeIndex(), 2);
+}
+
+// A viewer connects to a KeyframeServer, gets the scene published so far and
+// decodes the keyframes published afterwards
+TEST(GfxReplayTest, keyframeServer) {
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+  esp::gfx::replay::Keyframe first;
+  first.creations.emplace_back(7, creation);
+  first.stateUpdates.emplace_back(
+      7, esp::gfx::replay::RenderAssetInstanceState{
+             {Mn::Vector3(1.f, 2.f, 3.f), Mn::Quaternion()}, 0});
+  esp::gfx::replay::Keyframe second;
+  second.stateUpdates.emplace_back(
+      7, esp::gfx::replay::RenderAssetInstanceState{
+             {Mn::Vector3(1.5f, 2.f, 3.f), Mn::Quaternion()}, 0});
+
+  esp::gfx::replay::KeyframeServer server(0);
+  ASSERT_TRUE(server.isListening());
+  server.publish(first);
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(server.port());
+  ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)),
+            0);
+  const std::string request =
+      "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+      "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+      "Sec-WebSocket-Version: 13\r\n\r\n";
+  ASSERT_EQ(send(fd, request.data(), request.size(), 0),
+            ssize_t(request.size()));
+  // the messages are sent when polled
+  std::string received;
+  while (server.numViewers() == 0) {
+    server.poll();
+  }
+  server.publish(second);
+
+  // reads the payload of the next binary frame
+  auto readMessage = [&]() {
+    while (true) {
+      if (received.size() >= 2) {
+        std::size_t size = uint8_t(received[1]);
+        std::size_t offset = 2;
+        if (size == 126) {
+          size = uint8_t(received[2]) << 8 | uint8_t(received[3]);
+          offset = 4;
+        }
+        if (received.size() >= offset + size) {
+          EXPECT_EQ(uint8_t(received[0]), 0x82);
+          std::string message = received.substr(offset, size);
+          received.erase(0, offset + size);
+          return message;
+        }
+      }
+      char buffer[4096];
+      const ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+      if (size <= 0)
+        return std::string{};
+      received.append(buffer, size);
+    }
+  };
+  char buffer[4096];
+  while (received.find("\r\n\r\n") == std::string::npos) {
+    const ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+    ASSERT_GT(size, 0);
+    received.append(buffer, size);
+  }
+  const std::size_t headersEnd = received.find("\r\n\r\n") + 4;
+  EXPECT_NE(received.substr(0, headersEnd)
+                .find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo="),
+            std::string::npos);
+  received.erase(0, headersEnd);
+
+  const std::string header = readMessage();
+  float translationQuantum = 0.f;
+  ASSERT_EQ(esp::gfx::replay::readKeyframeStreamHeader(
+                header.data(), header.size(), translationQuantum),
+            header.size());
+  EXPECT_FLOAT_EQ(translationQuantum, 1e-4f);
+  esp::gfx::replay::KeyframeDecoder decoder(translationQuantum);
+
+  // the scene at the time the viewer joined, then the next keyframe
+  const std::string joined = readMessage();
+  esp::gfx::replay::Keyframe keyframe;
+  ASSERT_EQ(decoder.decode(joined.data(), joined.size(), keyframe),
+            joined.size());
+  ASSERT_EQ(keyframe.creations.size(), 1);
+  EXPECT_EQ(keyframe.creations[0].first, 7);
+  ASSERT_EQ(keyframe.stateUpdates.size(), 1);
+  EXPECT_NEAR(keyframe.stateUpdates[0].second.absTransform.translation.x(),
+              1.f, 1e-4f);
+
+  const std::string next = readMessage();
+  keyframe = {};
+  ASSERT_EQ(decoder.decode(next.data(), next.size(), keyframe), next.size());
+  EXPECT_TRUE(keyframe.creations.empty());
+  ASSERT_EQ(keyframe.stateUpdates.size(), 1);
+  EXPECT_NEAR(keyframe.stateUpdates[0].second.absTransform.translation.x(),
+              1.5f, 1e-4f);
+
+  close(fd);
+  server.poll();
+  EXPECT_EQ(server.numViewers(), 0);
+}
@@ -13,6 +13,7 @@
 
 #include "configure.h"
 
+#include <fstream>
 #include <limits>
 
 using namespace esp::io;
@@ -170,6 +171,62 @@ TEST(IOTest, JsonTest) {
   EXPECT_EQ(attributes->getRenderAssetHandle(), "banana.glb");
 }
 
+// Parse files in situ, with and without room for the terminator in the last
+// mapped page
+TEST(IOTest, JsonFileInsituTest) {
+  const std::string testFilepath = Corrade::Utility::Directory::join(
+      Corrade::Utility::Directory::tmp(), "io_test_insitu.json");
+  for (const std::size_t size : {4095, 4096}) {
+    std::string contents = "{\"name\":\"banana\",\"list\":[1,2]}";
+    contents.resize(size, ' ');
+    std::ofstream{testFilepath, std::ios::binary} << contents;
+    JsonDocument json = parseJsonFile(testFilepath);
+    // the document keeps the mapping of the file
+    Corrade::Utility::Directory::rm(testFilepath);
+    EXPECT_STREQ(json["name"].GetString(), "banana");
+    EXPECT_EQ(json["list"].Size(), 2u);
+  }
+  EXPECT_THROW(parseJsonFile(testFilepath), std::runtime_error);
+}
+
+// Read the elements of a top-level array one at a time
+TEST(IOTest, JsonArrayElementsTest) {
+  const std::string testFilepath = Corrade::Utility::Directory::join(
+      Corrade::Utility::Directory::tmp(), "io_test_elements.json");
+  std::ofstream{testFilepath, std::ios::binary}
+      << "{\"other\":{\"keyframes\":[9]},\"list\":[\"skipped\"],"
+         "\"keyframes\":[{\"a\":1,\"b\":[\"x\",{\"c\":2.5}]},3,\"s\"]}";
+
+  std::vector<std::string> elements;
+  EXPECT_TRUE(forEachJsonArrayElement(
+      testFilepath, "keyframes", [&](const JsonGenericValue& value) {
+        elements.push_back(jsonToString(value));
+        return true;
+      }));
+  ASSERT_EQ(elements.size(), 3u);
+  EXPECT_EQ(elements[0], "{\"a\":1,\"b\":[\"x\",{\"c\":2.5}]}");
+  EXPECT_EQ(elements[1], "3");
+  EXPECT_EQ(elements[2], "\"s\"");
+
+  // stopping early fails
+  int count = 0;
+  EXPECT_FALSE(forEachJsonArrayElement(
+      testFilepath, "keyframes", [&](const JsonGenericValue&) {
+        return ++count < 2;
+      }));
+  EXPECT_EQ(count, 2);
+
+  // without the member, there's nothing to read
+  count = 0;
+  EXPECT_TRUE(forEachJsonArrayElement(
+      testFilepath, "missing", [&](const JsonGenericValue&) {
+        ++count;
+        return true;
+      }));
+  EXPECT_EQ(count, 0);
+  Corrade::Utility::Directory::rm(testFilepath);
+}
+
 // Serialize/deserialize the 7 rapidjson builtin types using
 // io::addMember/readMember and assert equality.
 TEST(IOTest, JsonBuiltinTypesTest) {
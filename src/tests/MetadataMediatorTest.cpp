@@ -2,7 +2,9 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Utility/Directory.h>
 #include <gtest/gtest.h>
+#include "esp/metadata/DatasetIndex.h"
 #include "esp/metadata/MetadataMediator.h"
 #include "esp/metadata/managers/AssetAttributesManager.h"
 #include "esp/metadata/managers/AttributesManagerBase.h"
@@ -314,3 +316,75 @@ TEST_F(MetadataMediatorTest, MetadataMediatorTest_CreateTestDataset) {
   testLoadSemanticScene();
 
 }  // MetadataMediatorTest, MetadataMediatorTest_CreateTestDataset
+
+TEST_F(MetadataMediatorTest, MetadataMediatorTest_DatasetIndex) {
+  const std::string indexFile =
+      esp::metadata::DatasetIndex::filenameFor(sceneDatasetConfigFile);
+  ASSERT_TRUE(MM->buildDatasetIndex(sceneDatasetConfigFile));
+  esp::metadata::DatasetIndex index;
+  ASSERT_TRUE(index.load(indexFile));
+  ASSERT_GT(index.size(), 0);
+
+  // the dataset loaded through the index has the same templates
+  MM = MetadataMediator::create(sceneDatasetConfigFile);
+  ASSERT_TRUE(MM->getUseDatasetIndex());
+  testLoadStages();
+  testLoadObjects();
+  testLoadLights();
+  Cr::Utility::Directory::rm(indexFile);
+}  // MetadataMediatorTest, MetadataMediatorTest_DatasetIndex
+
+TEST(DatasetIndexTest, FindAndInvalidate) {
+  namespace Directory = Cr::Utility::Directory;
+  const std::string dir =
+      Directory::join(Directory::tmp(), "DatasetIndexTest");
+  ASSERT_TRUE(Directory::mkpath(dir));
+  const std::string config = Directory::join(dir, "a.object_config.json");
+  ASSERT_TRUE(Directory::writeString(config, "{}"));
+  // the config the search path names, missing at first
+  const std::string configFile = dir + ".object_config.json";
+  Directory::rm(configFile);
+
+  esp::metadata::DatasetIndex index;
+  index.record(dir, configFile, {config});
+  const std::string indexFile =
+      Directory::join(Directory::tmp(), "DatasetIndexTest.index");
+  ASSERT_TRUE(index.save(indexFile));
+
+  esp::metadata::DatasetIndex loaded;
+  ASSERT_TRUE(loaded.load(indexFile));
+  EXPECT_EQ(loaded.size(), 1);
+  std::vector<std::string> configs;
+  EXPECT_TRUE(loaded.find(dir, configFile, configs));
+  EXPECT_EQ(configs, std::vector<std::string>{config});
+  EXPECT_TRUE(loaded.changedConfigs().empty());
+  EXPECT_EQ(loaded.numMisses(), 0);
+
+  // a path never searched
+  configs.clear();
+  EXPECT_FALSE(loaded.find(config, config, configs));
+  EXPECT_EQ(loaded.numMisses(), 1);
+
+  // a config edited in place is still found, and reported as changed
+  ASSERT_TRUE(Directory::writeString(config, "{ }"));
+  EXPECT_TRUE(loaded.find(dir, configFile, configs));
+  EXPECT_EQ(loaded.changedConfigs(), std::vector<std::string>{config});
+
+  // the config the path names appearing makes the entry stale
+  ASSERT_TRUE(Directory::writeString(configFile, "{}"));
+  configs.clear();
+  EXPECT_FALSE(loaded.find(dir, configFile, configs));
+  EXPECT_TRUE(configs.empty());
+  EXPECT_EQ(loaded.numMisses(), 2);
+
+  // truncated files aren't loaded
+  ASSERT_TRUE(Directory::writeString(indexFile, "espdsidx"));
+  esp::metadata::DatasetIndex truncated;
+  EXPECT_FALSE(truncated.load(indexFile));
+  EXPECT_EQ(truncated.size(), 0);
+
+  Directory::rm(indexFile);
+  Directory::rm(configFile);
+  Directory::rm(config);
+  Directory::rm(dir);
+}  // DatasetIndexTest, FindAndInvalidate
@@ -4,15 +4,19 @@
 
 #include <Corrade/Utility/Directory.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "esp/sim/Simulator.h"
 
 #include "esp/assets/ResourceManager.h"
 #include "esp/scene/SceneManager.h"
 
+#include "esp/physics/KinematicCharacterController.h"
 #include "esp/physics/PhysicsManager.h"
 #ifdef ESP_BUILD_WITH_BULLET
+#include "esp/physics/bullet/BulletConvexDecomposition.h"
 #include "esp/physics/bullet/BulletPhysicsManager.h"
 #endif
 
@@ -47,7 +51,7 @@ class PhysicsManagerTest : public testing::Test {
         metadataMediator_->getPhysicsAttributesManager();
   };
 
-  void initStage(const std::string stageFile) {
+  void initStage(const std::string stageFile, bool enablePhysics = true) {
     auto& sceneGraph = sceneManager_.getSceneGraph(sceneID_);
     auto& rootNode = sceneGraph.getRootNode();
 
@@ -62,8 +66,8 @@ class PhysicsManagerTest : public testing::Test {
     auto stageAttributes = stageAttributesMgr->createObject(stageFile, true);
 
     // construct physics manager based on specifications in attributes
-    resourceManager_->initPhysicsManager(physicsManager_, true, &rootNode,
-                                         physicsManagerAttributes);
+    resourceManager_->initPhysicsManager(physicsManager_, enablePhysics,
+                                         &rootNode, physicsManagerAttributes);
 
     // load scene
     std::vector<int> tempIDs{sceneID_, esp::ID_UNDEFINED};
@@ -294,6 +298,226 @@ TEST_F(PhysicsManagerTest, DiscreteContactTest) {
   }
 }
 
+TEST_F(PhysicsManagerTest, BroadphaseOverlapAndBatchedContactTests) {
+  LOG(INFO) << "Starting physics test: "
+               "BroadphaseOverlapAndBatchedContactTests";
+
+  std::string stageFile =
+      Cr::Utility::Directory::join(dataDir, "test_assets/scenes/plane.glb");
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(stageFile);
+
+  if (physicsManager_->getPhysicsSimulationLibrary() !=
+      PhysicsManager::PhysicsSimulationLibrary::NONE) {
+    ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+    ObjectAttributes->setRenderAssetHandle(objectFile);
+    ObjectAttributes->setMargin(0.0);
+    auto objectAttributesManager =
+        metadataMediator_->getObjectAttributesManager();
+    objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+
+    // two 2x2x2 boxes 0.1 above the ground plane and 2 apart
+    int objectId0 = physicsManager_->addObject(objectFile, nullptr);
+    int objectId1 = physicsManager_->addObject(objectFile, nullptr);
+    physicsManager_->setTranslation(objectId0, Magnum::Vector3{0, 1.1, 0});
+    physicsManager_->setTranslation(objectId1, Magnum::Vector3{4, 1.1, 0});
+
+    EXPECT_EQ(physicsManager_->overlapAabb({{-0.5, 1, -0.5}, {0.5, 1.2, 0.5}}),
+              std::vector<int>{objectId0});
+    EXPECT_EQ(physicsManager_->overlapAabb({{-2, 1, -2}, {6, 1.2, 2}}),
+              (std::vector<int>{objectId0, objectId1}));
+    // the stage, between the plane and the boxes
+    EXPECT_EQ(
+        physicsManager_->overlapAabb({{-0.1, -0.1, -0.1}, {0.1, 0.05, 0.1}}),
+        std::vector<int>{-1});
+    EXPECT_TRUE(physicsManager_
+                    ->overlapAabb({{-0.1, -0.1, -0.1}, {0.1, 0.05, 0.1}},
+                                  ~int(esp::physics::CollisionGroup::STAGE))
+                    .empty());
+
+    // in the gap, then over both
+    EXPECT_TRUE(
+        physicsManager_->overlapSphere(Magnum::Vector3{2, 1.1, 0}, 0.5)
+            .empty());
+    EXPECT_EQ(physicsManager_->overlapSphere(Magnum::Vector3{2, 1.1, 0}, 1.5),
+              (std::vector<int>{objectId0, objectId1}));
+    // off the top corner of box 0, its bounds overlap but the sphere doesn't
+    EXPECT_TRUE(
+        physicsManager_->overlapSphere(Magnum::Vector3{1.4, 2.5, 0}, 0.5)
+            .empty());
+
+    // a slab off the top corner of box 0, across the diagonal and then along
+    // it, whose bounds overlap the box both times
+    const esp::vec3f center{1.2, 2.3, 0};
+    const esp::vec3f sizes{0.6, 0.1, 0.6};
+    const esp::geo::OBB across{
+        center, sizes,
+        esp::quatf{Eigen::AngleAxisf(-EIGEN_PI / 4, esp::vec3f::UnitZ())}};
+    const esp::geo::OBB along{
+        center, sizes,
+        esp::quatf{Eigen::AngleAxisf(EIGEN_PI / 4, esp::vec3f::UnitZ())}};
+    EXPECT_TRUE(physicsManager_->overlapObb(across).empty());
+    EXPECT_EQ(physicsManager_->overlapObb(along),
+              std::vector<int>{objectId0});
+
+    EXPECT_EQ(physicsManager_->contactTests({objectId0, objectId1}),
+              (std::vector<bool>{false, false}));
+    // move box 0 into the floor
+    physicsManager_->setTranslation(objectId0, Magnum::Vector3{0, 0.9, 0});
+    EXPECT_EQ(physicsManager_->contactTests({objectId0, objectId1}),
+              (std::vector<bool>{true, false}));
+
+    // box 1 where it is, into the floor, free, and into box 0
+    const std::vector<Magnum::Matrix4> placements{
+        Magnum::Matrix4::translation({4, 1.1, 0}),
+        Magnum::Matrix4::translation({4, 0.9, 0}),
+        Magnum::Matrix4::translation({8, 1.1, 0}),
+        Magnum::Matrix4::translation({0, 2.5, 0})};
+    EXPECT_EQ(physicsManager_->testPlacements(objectId1, placements),
+              (std::vector<bool>{false, true, false, true}));
+    // without moving it
+    EXPECT_EQ(physicsManager_->getTranslation(objectId1),
+              (Magnum::Vector3{4, 1.1, 0}));
+    EXPECT_FALSE(physicsManager_->contactTest(objectId1));
+  }
+}
+
+TEST_F(PhysicsManagerTest, ConvexSweepTests) {
+  LOG(INFO) << "Starting physics test: ConvexSweepTests";
+
+  std::string stageFile =
+      Cr::Utility::Directory::join(dataDir, "test_assets/scenes/plane.glb");
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(stageFile);
+
+  if (physicsManager_->getPhysicsSimulationLibrary() !=
+      PhysicsManager::PhysicsSimulationLibrary::NONE) {
+    ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+    ObjectAttributes->setRenderAssetHandle(objectFile);
+    ObjectAttributes->setMargin(0.0);
+    auto objectAttributesManager =
+        metadataMediator_->getObjectAttributesManager();
+    objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+
+    // two 2x2x2 boxes 0.1 above the ground plane and 2 apart
+    int objectId0 = physicsManager_->addObject(objectFile, nullptr);
+    int objectId1 = physicsManager_->addObject(objectFile, nullptr);
+    const Magnum::Matrix4 start = Magnum::Matrix4::translation({0, 1.1, 0});
+    physicsManager_->setTransformation(objectId0, start);
+    physicsManager_->setTranslation(objectId1, Magnum::Vector3{4, 1.1, 0});
+
+    // into box 1, after the gap of 2 out of 10
+    esp::physics::SweepResult hit =
+        physicsManager_->sweepObject(objectId0, start, {10, 1.1, 0});
+    ASSERT_TRUE(hit.hasHit);
+    EXPECT_EQ(hit.objectId, objectId1);
+    EXPECT_NEAR(hit.timeOfImpact, 0.2, 0.01);
+    EXPECT_NEAR(hit.normal.x(), -1.0, 0.01);
+
+    // up, without hitting the object itself
+    hit = physicsManager_->sweepObject(objectId0, start, {0, 5, 0});
+    EXPECT_FALSE(hit.hasHit);
+    EXPECT_EQ(hit.timeOfImpact, 1.0);
+
+    // into the stage, unless it's filtered out
+    hit = physicsManager_->sweepObject(objectId0, start, {0, 0, 0});
+    ASSERT_TRUE(hit.hasHit);
+    EXPECT_EQ(hit.objectId, -1);
+    EXPECT_NEAR(hit.timeOfImpact, 0.1 / 1.1, 0.01);
+    EXPECT_FALSE(physicsManager_
+                     ->sweepObject(objectId0, start, {0, 0, 0},
+                                   ~int(esp::physics::CollisionGroup::STAGE))
+                     .hasHit);
+
+    const std::vector<esp::physics::SweepResult> batch =
+        physicsManager_->sweepObjectBatch(objectId0, {start, start},
+                                          {{10, 1.1, 0}, {0, 5, 0}});
+    ASSERT_EQ(batch.size(), 2);
+    EXPECT_TRUE(batch[0].hasHit);
+    EXPECT_EQ(batch[0].objectId, objectId1);
+    EXPECT_FALSE(batch[1].hasHit);
+    // without moving it
+    EXPECT_EQ(physicsManager_->getTranslation(objectId0),
+              (Magnum::Vector3{0, 1.1, 0}));
+
+    // a capsule through the gap, then into box 0 after 3.75 out of 7
+    EXPECT_FALSE(physicsManager_
+                     ->sweepCapsule(0.25, 1.5, {2, 1.1, -5}, {2, 1.1, 5})
+                     .hasHit);
+    hit = physicsManager_->sweepCapsule(0.25, 1.5, {-5, 1.1, 0}, {2, 1.1, 0});
+    ASSERT_TRUE(hit.hasHit);
+    EXPECT_EQ(hit.objectId, objectId0);
+    EXPECT_NEAR(hit.timeOfImpact, 3.75 / 7, 0.01);
+
+    const std::vector<esp::physics::SweepResult> capsules =
+        physicsManager_->sweepCapsuleBatch(0.25, 1.5,
+                                           {{2, 1.1, -5}, {-5, 1.1, 0}},
+                                           {{2, 1.1, 5}, {2, 1.1, 0}});
+    ASSERT_EQ(capsules.size(), 2);
+    EXPECT_FALSE(capsules[0].hasHit);
+    EXPECT_EQ(capsules[1].objectId, objectId0);
+  }
+}
+
+TEST_F(PhysicsManagerTest, KinematicCharacterController) {
+  LOG(INFO) << "Starting physics test: KinematicCharacterController";
+
+  std::string stageFile =
+      Cr::Utility::Directory::join(dataDir, "test_assets/scenes/plane.glb");
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(stageFile);
+
+  if (physicsManager_->getPhysicsSimulationLibrary() !=
+      PhysicsManager::PhysicsSimulationLibrary::NONE) {
+    ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+    ObjectAttributes->setRenderAssetHandle(objectFile);
+    ObjectAttributes->setMargin(0.0);
+    auto objectAttributesManager =
+        metadataMediator_->getObjectAttributesManager();
+    objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+
+    // a 2x2x2 box 0.1 above the ground plane
+    int objectId = physicsManager_->addObject(objectFile, nullptr);
+    physicsManager_->setTranslation(objectId, Magnum::Vector3{0, 1.1, 0});
+
+    esp::physics::KinematicCharacterController::Configuration config;
+    config.radius = 0.25;
+    config.height = 1.5;
+    esp::physics::KinematicCharacterController controller{config};
+    // the capsule stops the radius and the skin width before the box, the
+    // floor is below the step height
+    const float stop = -1.0f - config.radius - config.skinWidth;
+
+    // straight into the box, sliding along it, and free
+    const std::vector<Magnum::Vector3> ends = controller.moveBatch(
+        *physicsManager_, {{-5, 0, 0}, {-3, 0, 0}, {-3, 0, 3}},
+        {{0, 0, 0}, {0, 0, 1}, {0, 0, 3}});
+    ASSERT_EQ(ends.size(), 3);
+    EXPECT_NEAR(ends[0].x(), stop, 0.02);
+    EXPECT_NEAR(ends[0].z(), 0.0, 0.02);
+    EXPECT_NEAR(ends[1].x(), stop, 0.02);
+    EXPECT_NEAR(ends[1].z(), 1.0, 0.02);
+    EXPECT_EQ(ends[2], (Magnum::Vector3{0, 0, 3}));
+    for (const Magnum::Vector3& end : ends) {
+      EXPECT_EQ(end.y(), 0.0f);
+    }
+
+    // without sliding the move stops at the box
+    config.allowSliding = false;
+    esp::physics::KinematicCharacterController stopping{config};
+    const Magnum::Vector3 end =
+        stopping.move(*physicsManager_, {-3, 0, 0}, {0, 0, 1});
+    EXPECT_NEAR(end.x(), stop, 0.02);
+    EXPECT_NEAR(end.z(), (stop + 3.0f) / 3.0f, 0.02);
+  }
+}
+
 TEST_F(PhysicsManagerTest, BulletCompoundShapeMargins) {
   // test that all different construction methods for a simple shape result in
   // the same Aabb for the given margin
@@ -358,8 +582,175 @@ TEST_F(PhysicsManagerTest, BulletCompoundShapeMargins) {
     ASSERT_EQ(AabbOb2, objectGroundTruth);
   }
 }
+
+TEST_F(PhysicsManagerTest, BulletConvexHullCache) {
+  // test that instances of a template share their hulls without affecting
+  // each other, and that the hulls are simplified to the vertex budget
+  LOG(INFO) << "Starting physics test: BulletConvexHullCache";
+
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  initStage(objectFile);
+
+  if (physicsManager_->getPhysicsSimulationLibrary() ==
+      PhysicsManager::PhysicsSimulationLibrary::BULLET) {
+    ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+    ObjectAttributes->setRenderAssetHandle(objectFile);
+    ObjectAttributes->setMargin(0.0);
+
+    auto objectAttributesManager =
+        metadataMediator_->getObjectAttributesManager();
+    objectAttributesManager->registerObject(ObjectAttributes, objectFile);
+
+    ObjectAttributes::ptr objectTemplate =
+        objectAttributesManager->getObjectCopyByHandle(objectFile);
+
+    auto* drawables = &sceneManager_.getSceneGraph(sceneID_).getDrawables();
+
+    esp::physics::BulletPhysicsManager* bPhysManager =
+        static_cast<esp::physics::BulletPhysicsManager*>(physicsManager_.get());
+
+    const Magnum::Range3D objectGroundTruth({-1.0, -1.0, -1.0},
+                                            {1.0, 1.0, 1.0});
+
+    // add instances of the same template, changing the margin of one of them
+    int objectId0 = physicsManager_->addObject(objectFile, drawables);
+    int objectId1 = physicsManager_->addObject(objectFile, drawables);
+    bPhysManager->setMargin(objectId0, 0.1);
+    int objectId2 = physicsManager_->addObject(objectFile, drawables);
+    ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId1),
+              objectGroundTruth);
+    ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId2),
+              objectGroundTruth);
+
+    // a hull simplified to a single box corner
+    objectTemplate->setMaxHullVertices(1);
+    objectAttributesManager->registerObject(objectTemplate);
+    int objectId3 = physicsManager_->addObject(objectFile, drawables);
+    const Magnum::Range3D AabbOb3 =
+        bPhysManager->getCollisionShapeAabb(objectId3);
+    ASSERT_EQ(AabbOb3.size(), Magnum::Vector3(0.0));
+    ASSERT_TRUE(objectGroundTruth.contains(AabbOb3.min()));
+
+    // the simplified hull is cached separately from the full one
+    objectTemplate->setMaxHullVertices(0);
+    objectAttributesManager->registerObject(objectTemplate);
+    int objectId4 = physicsManager_->addObject(objectFile, drawables);
+    ASSERT_EQ(bPhysManager->getCollisionShapeAabb(objectId4),
+              objectGroundTruth);
+  }
+}
+
+TEST_F(PhysicsManagerTest, BulletStageBvhCache) {
+  // test that a stage loaded from its cached BVH collides like a built one
+  LOG(INFO) << "Starting physics test: BulletStageBvhCache";
+
+  std::string stageFile =
+      Cr::Utility::Directory::join(dataDir, "test_assets/scenes/plane.glb");
+  const std::string bvhCacheFile =
+      Cr::Utility::Directory::splitExtension(stageFile).first + ".bullet_bvh";
+  Cr::Utility::Directory::rm(bvhCacheFile);
+
+  const esp::geo::Ray ray{{0.5, 5.0, 0.5}, {0, -1.0, 0}};
+  initStage(stageFile);
+  if (physicsManager_->getPhysicsSimulationLibrary() ==
+      PhysicsManager::PhysicsSimulationLibrary::BULLET) {
+    ASSERT_TRUE(Cr::Utility::Directory::exists(bvhCacheFile));
+    esp::physics::RaycastResults built = physicsManager_->castRay(ray);
+    ASSERT_TRUE(built.hasHits());
+
+    // a new manager maps the BVH written by the first one
+    initStage(stageFile);
+    esp::physics::RaycastResults cached = physicsManager_->castRay(ray);
+    ASSERT_TRUE(cached.hasHits());
+    ASSERT_EQ(cached.hits[0].point, built.hits[0].point);
+    ASSERT_EQ(cached.hits[0].normal, built.hits[0].normal);
+  }
+  Cr::Utility::Directory::rm(bvhCacheFile);
+}
+
+TEST(PhysicsConvexDecompositionTest, SeparateBoxes) {
+  // two unit cubes side by side need a hull each
+  LOG(INFO) << "Starting physics test: SeparateBoxes";
+
+  std::vector<Magnum::Vector3> positions;
+  std::vector<Magnum::UnsignedInt> indices;
+  const Magnum::UnsignedInt faces[]{0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6,
+                                    0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7,
+                                    0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+  for (const float offset : {0.0f, 3.0f}) {
+    const Magnum::UnsignedInt first = positions.size();
+    for (int c = 0; c < 8; ++c) {
+      positions.emplace_back(offset + (c & 1), (c >> 1) & 1, c >> 2);
+    }
+    for (const Magnum::UnsignedInt index : faces) {
+      indices.push_back(first + index);
+    }
+  }
+
+  const esp::physics::ConvexDecomposition hulls =
+      esp::physics::decomposeConvex(positions, indices);
+  ASSERT_EQ(hulls.size(), 2u);
+  std::vector<Magnum::Range3D> bounds;
+  for (const std::vector<Magnum::Vector3>& hull : hulls) {
+    Magnum::Range3D hullBounds{hull[0], hull[0]};
+    for (const Magnum::Vector3& v : hull) {
+      hullBounds = Magnum::Math::join(hullBounds, Magnum::Range3D{v, v});
+    }
+    bounds.push_back(hullBounds);
+  }
+  std::sort(bounds.begin(), bounds.end(),
+            [](const Magnum::Range3D& a, const Magnum::Range3D& b) {
+              return a.min().x() < b.min().x();
+            });
+  ASSERT_EQ(bounds[0], Magnum::Range3D({0, 0, 0}, {1, 1, 1}));
+  ASSERT_EQ(bounds[1], Magnum::Range3D({3, 0, 0}, {4, 1, 1}));
+
+  // the saved decomposition loads back unchanged
+  const std::string filename = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "PhysicsTest-boxes.hulls");
+  ASSERT_TRUE(esp::physics::saveConvexDecomposition(hulls, filename));
+  esp::physics::ConvexDecomposition loaded;
+  ASSERT_TRUE(esp::physics::loadConvexDecomposition(filename, loaded));
+  ASSERT_EQ(loaded, hulls);
+  Cr::Utility::Directory::rm(filename);
+}
 #endif
 
+TEST_F(PhysicsManagerTest, StageRaycastWithoutPhysics) {
+  // the default PhysicsManager casts rays against the stage collision mesh
+  LOG(INFO) << "Starting physics test: StageRaycastWithoutPhysics";
+
+  std::string stageFile =
+      Cr::Utility::Directory::join(dataDir, "test_assets/scenes/plane.glb");
+  initStage(stageFile, false);
+  ASSERT_EQ(physicsManager_->getPhysicsSimulationLibrary(),
+            PhysicsManager::PhysicsSimulationLibrary::NONE);
+
+  const esp::geo::Ray down{{0.5, 5.0, 0.5}, {0, -1.0, 0}};
+  const esp::geo::Ray up{{0.5, 5.0, 0.5}, {0, 1.0, 0}};
+  esp::physics::RaycastResults results = physicsManager_->castRay(down);
+  ASSERT_EQ(results.hits.size(), 1);
+  EXPECT_EQ(results.hits[0].objectId, -1);
+  EXPECT_NEAR(results.hits[0].rayDistance, 5.0, 1.0e-4);
+  EXPECT_NEAR(results.hits[0].point.y(), 0.0, 1.0e-4);
+  EXPECT_NEAR(results.hits[0].normal.y(), 1.0, 1.0e-4);
+  EXPECT_FALSE(physicsManager_->castRay(up).hasHits());
+  EXPECT_FALSE(physicsManager_->castRay(down, 4.0).hasHits());
+  EXPECT_FALSE(physicsManager_
+                   ->castRay(down, 100.0, false,
+                             ~int(esp::physics::CollisionGroup::STAGE))
+                   .hasHits());
+
+  const esp::physics::MultiRaycastResults batch =
+      physicsManager_->castRays({down, up, down}, 100.0, true);
+  EXPECT_EQ(batch.hitOffsets, (std::vector<int>{0, 1, 1, 2}));
+  ASSERT_EQ(batch.numHits(), 2);
+  EXPECT_EQ(batch.points[0], results.hits[0].point);
+  EXPECT_EQ(batch.points[1], results.hits[0].point);
+}
+
 TEST_F(PhysicsManagerTest, ConfigurableScaling) {
   // test scaling of objects via template configuration (visual and collision)
   LOG(INFO) << "Starting physics test: ConfigurableScaling";
@@ -571,6 +962,95 @@ TEST_F(PhysicsManagerTest, TestVelocityControl) {
       physicsManager_->getRotation(objectId), qLocalGroundTruth);
 
   ASSERT_LE(float(angleErrorLocal), errorEps);
+
+  // the control keeps applying to its object only, stepping still works once
+  // the controlled object is gone
+  int otherObjectId = physicsManager_->addObject(objectFile, &drawables);
+  physicsManager_->setObjectMotionType(otherObjectId,
+                                       esp::physics::MotionType::KINEMATIC);
+  physicsManager_->setTranslation(otherObjectId, Magnum::Vector3{0, 5.0, 0});
+  velControl->linVel = Magnum::Vector3{1.0, 0.0, 0.0};
+  physicsManager_->stepPhysics(physicsManager_->getTimestep());
+  ASSERT_EQ(physicsManager_->getTranslation(otherObjectId),
+            (Magnum::Vector3{0, 5.0, 0}));
+
+  physicsManager_->removeObject(objectId);
+  physicsManager_->stepPhysics(physicsManager_->getTimestep());
+  ASSERT_EQ(physicsManager_->getTranslation(otherObjectId),
+            (Magnum::Vector3{0, 5.0, 0}));
+}
+
+TEST_F(PhysicsManagerTest, TestSubsteps) {
+  LOG(INFO) << "Starting physics test: TestSubsteps";
+
+  std::string objectFile = Cr::Utility::Directory::join(
+      dataDir, "test_assets/objects/transform_box.glb");
+
+  std::string stageFile =
+      Cr::Utility::Directory::join(dataDir, "test_assets/scenes/plane.glb");
+
+  initStage(stageFile);
+
+  ObjectAttributes::ptr ObjectAttributes = ObjectAttributes::create();
+  ObjectAttributes->setRenderAssetHandle(objectFile);
+  metadataMediator_->getObjectAttributesManager()->registerObject(
+      ObjectAttributes, objectFile);
+
+  auto& drawables = sceneManager_.getSceneGraph(sceneID_).getDrawables();
+  int objectId = physicsManager_->addObject(objectFile, &drawables);
+  physicsManager_->setObjectMotionType(objectId,
+                                       esp::physics::MotionType::KINEMATIC);
+  physicsManager_->setTranslation(objectId, Magnum::Vector3{0, 2.0, 0});
+  esp::physics::VelocityControl::ptr velControl =
+      physicsManager_->getVelocityControl(objectId);
+  velControl->controllingLinVel = true;
+  velControl->linVel = Magnum::Vector3{1.0, 0.0, 0.0};
+
+  const double timestep = physicsManager_->getTimestep();
+  const float errorEps = 1e-4;
+
+  // the time not making a whole step is kept, the object drawn ahead of its
+  // last step meanwhile
+  physicsManager_->stepPhysics(2.5 * timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 2 * timestep, 1e-9);
+  ASSERT_NEAR(physicsManager_->getRenderTime(), 2.5 * timestep, 1e-9);
+  ASSERT_NEAR(physicsManager_->getTranslation(objectId).x(), 2.5 * timestep,
+              errorEps);
+  physicsManager_->stepPhysics(0.5 * timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 3 * timestep, 1e-9);
+  ASSERT_NEAR(physicsManager_->getTranslation(objectId).x(), 3 * timestep,
+              errorEps);
+
+  // interpolated between the last two steps instead
+  physicsManager_->setRenderInterpolation(true);
+  physicsManager_->stepPhysics(1.25 * timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 4 * timestep, 1e-9);
+  ASSERT_NEAR(physicsManager_->getRenderTime(), 3.25 * timestep, 1e-9);
+  ASSERT_NEAR(physicsManager_->getTranslation(objectId).x(), 3.25 * timestep,
+              errorEps);
+  physicsManager_->setRenderInterpolation(false);
+  physicsManager_->stepPhysics(0.75 * timestep);
+  ASSERT_NEAR(physicsManager_->getTranslation(objectId).x(), 5 * timestep,
+              errorEps);
+
+  // the steps beyond the budget are dropped
+  physicsManager_->setMaxSubsteps(2);
+  physicsManager_->stepPhysics(5 * timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 7 * timestep, 1e-9);
+  physicsManager_->stepPhysics(timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 8 * timestep, 1e-9);
+
+  // or caught up by the next calls
+  physicsManager_->setSkipIfBehind(false);
+  physicsManager_->stepPhysics(5 * timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 10 * timestep, 1e-9);
+  physicsManager_->stepPhysics(timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 12 * timestep, 1e-9);
+  physicsManager_->stepPhysics(timestep);
+  physicsManager_->stepPhysics(timestep);
+  ASSERT_NEAR(physicsManager_->getWorldTime(), 16 * timestep, 1e-9);
+  ASSERT_NEAR(physicsManager_->getTranslation(objectId).x(), 16 * timestep,
+              errorEps);
 }
 
 TEST_F(PhysicsManagerTest, TestSceneNodeAttachment) {
@@ -862,3 +1342,78 @@ TEST_F(PhysicsManagerTest, TestRemoveSleepingSupport) {
     }
   }
 }
+
+TEST_F(PhysicsManagerTest, ObjectPooling) {
+  // test that removed objects are reused by the next additions of their
+  // template, reset to a new instance
+  LOG(INFO) << "Starting physics test: ObjectPooling";
+
+  std::string stageFile = "NONE";
+
+  initStage(stageFile);
+  auto& drawables = sceneManager_.getSceneGraph(sceneID_).getDrawables();
+  auto objectAttributesManager =
+      metadataMediator_->getObjectAttributesManager();
+  std::string cubeHandle =
+      objectAttributesManager->getObjectHandlesBySubstring("cubeSolid")[0];
+  const esp::physics::MotionType defaultMotionType =
+      physicsManager_->getPhysicsSimulationLibrary() ==
+              PhysicsManager::PhysicsSimulationLibrary::NONE
+          ? esp::physics::MotionType::KINEMATIC
+          : esp::physics::MotionType::DYNAMIC;
+
+  physicsManager_->setObjectPoolSize(2);
+  ASSERT_EQ(physicsManager_->getObjectPoolSize(), 2);
+  const std::size_t numStageDrawables = drawables.size();
+  std::vector<int> cubeIds;
+  for (int i = 0; i < 3; ++i) {
+    cubeIds.push_back(physicsManager_->addObject(cubeHandle, &drawables));
+  }
+  const std::size_t numCubeDrawables =
+      (drawables.size() - numStageDrawables) / 3;
+  ASSERT_GT(numCubeDrawables, 0);
+  physicsManager_->setTranslation(cubeIds[1], Mn::Vector3{1.0, 2.0, 3.0});
+  physicsManager_->setObjectMotionType(cubeIds[1],
+                                       esp::physics::MotionType::KINEMATIC);
+  physicsManager_->getVelocityControl(cubeIds[1])->controllingLinVel = true;
+  esp::scene::SceneNode* pooledNode =
+      &physicsManager_->getObjectSceneNode(cubeIds[1]);
+
+  // the pool keeps two of the three, hidden
+  for (int id : cubeIds) {
+    physicsManager_->removeObject(id);
+  }
+  ASSERT_EQ(physicsManager_->getNumRigidObjects(), 0);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 2);
+  ASSERT_EQ(drawables.size(), numStageDrawables);
+
+  // the most recently removed comes back first, as a new instance
+  int objectId = physicsManager_->addObject(cubeHandle, &drawables);
+  ASSERT_NE(objectId, esp::ID_UNDEFINED);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 1);
+  ASSERT_EQ(&physicsManager_->getObjectSceneNode(objectId), pooledNode);
+  ASSERT_EQ(physicsManager_->getTranslation(objectId), Mn::Vector3{});
+  ASSERT_EQ(physicsManager_->getObjectMotionType(objectId), defaultMotionType);
+  ASSERT(!physicsManager_->getVelocityControl(objectId)->controllingLinVel);
+  ASSERT_EQ(drawables.size(), numStageDrawables + numCubeDrawables);
+  if (defaultMotionType == esp::physics::MotionType::DYNAMIC) {
+    // back in the world, so it falls
+    physicsManager_->stepPhysics(0.1);
+    ASSERT_LT(physicsManager_->getTranslation(objectId).y(), 0.0);
+  }
+
+  // objects attached to other nodes aren't pooled
+  esp::scene::SceneNode* attachmentNode =
+      &sceneManager_.getSceneGraph(sceneID_).getRootNode().createChild();
+  int attachedId =
+      physicsManager_->addObject(cubeHandle, &drawables, attachmentNode);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 1);
+  physicsManager_->removeObject(attachedId);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 1);
+
+  physicsManager_->removeObject(objectId);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 2);
+  physicsManager_->setObjectPoolSize(0);
+  ASSERT_EQ(physicsManager_->getNumPooledObjects(), 0);
+  ASSERT_EQ(drawables.size(), numStageDrawables);
+}
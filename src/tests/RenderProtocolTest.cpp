@@ -0,0 +1,147 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esp/sim/RenderProtocol.h"
+
+namespace Mn = Magnum;
+
+using esp::core::Buffer;
+using esp::core::DataType;
+using esp::sensor::SensorSpec;
+using esp::sensor::SensorSubType;
+using esp::sensor::SensorType;
+using esp::sim::RenderMessage;
+using esp::sim::RenderObservation;
+using esp::sim::RenderSensorPose;
+
+TEST(RenderProtocolTest, messages) {
+  std::string stream;
+  esp::sim::appendRenderMessage(stream, RenderMessage::Render, "abc");
+  esp::sim::appendRenderMessage(stream, RenderMessage::Keyframe, "");
+  ASSERT_EQ(stream.size(), 5 + 3 + 5);
+
+  RenderMessage type;
+  std::string payload;
+  // a truncated message waits for the rest
+  EXPECT_EQ(esp::sim::readRenderMessage(stream.data(), 7, type, payload), 0);
+  ASSERT_EQ(esp::sim::readRenderMessage(stream.data(), stream.size(), type,
+                                        payload),
+            8);
+  EXPECT_EQ(type, RenderMessage::Render);
+  EXPECT_EQ(payload, "abc");
+  ASSERT_EQ(esp::sim::readRenderMessage(stream.data() + 8, 5, type, payload),
+            5);
+  EXPECT_EQ(type, RenderMessage::Keyframe);
+  EXPECT_EQ(payload, "");
+
+  // a size that can't be right is never waited for
+  const std::string corrupted{"\xff\xff\xff\xff\x04", 5};
+  EXPECT_TRUE(esp::sim::isRenderMessageCorrupted(corrupted.data(),
+                                                 corrupted.size()));
+  EXPECT_FALSE(esp::sim::isRenderMessageCorrupted(stream.data(),
+                                                  stream.size()));
+  EXPECT_EQ(esp::sim::readRenderMessage(corrupted.data(), corrupted.size(),
+                                        type, payload),
+            0);
+}
+
+TEST(RenderProtocolTest, sensors) {
+  auto color = SensorSpec::create();
+  color->uuid = "rgb";
+  color->resolution = {48, 64};
+  color->parameters["hfov"] = "70";
+  auto depth = SensorSpec::create();
+  depth->uuid = "depth";
+  depth->sensorType = SensorType::Depth;
+  depth->sensorSubType = SensorSubType::Orthographic;
+  depth->channels = 1;
+  depth->encoding = "float";
+
+  const std::string payload = esp::sim::encodeRenderSensors({color, depth});
+  std::vector<SensorSpec::ptr> specs;
+  ASSERT_TRUE(esp::sim::decodeRenderSensors(payload, specs));
+  ASSERT_EQ(specs.size(), 2);
+  EXPECT_EQ(specs[0]->uuid, "rgb");
+  EXPECT_EQ(specs[0]->sensorType, SensorType::Color);
+  EXPECT_EQ(specs[0]->resolution, color->resolution);
+  EXPECT_EQ(specs[0]->parameters, color->parameters);
+  EXPECT_EQ(specs[1]->uuid, "depth");
+  EXPECT_EQ(specs[1]->sensorType, SensorType::Depth);
+  EXPECT_EQ(specs[1]->sensorSubType, SensorSubType::Orthographic);
+  EXPECT_EQ(specs[1]->channels, 1);
+  EXPECT_EQ(specs[1]->encoding, "float");
+
+  for (std::size_t size = 0; size < payload.size(); ++size) {
+    EXPECT_FALSE(esp::sim::decodeRenderSensors(payload.substr(0, size), specs))
+        << size;
+  }
+}
+
+TEST(RenderProtocolTest, request) {
+  const std::vector<RenderSensorPose> poses{
+      {"rgb", {1.0f, 2.0f, -3.0f}, Mn::Quaternion::rotation(
+                                       Mn::Deg(30.0f), Mn::Vector3::yAxis())},
+      {"depth", {}, {}}};
+  const std::string payload = esp::sim::encodeRenderRequest(7, poses);
+
+  uint32_t id = 0;
+  std::vector<RenderSensorPose> decoded;
+  ASSERT_TRUE(esp::sim::decodeRenderRequest(payload, id, decoded));
+  EXPECT_EQ(id, 7);
+  ASSERT_EQ(decoded.size(), 2);
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(decoded[i].uuid, poses[i].uuid);
+    EXPECT_EQ(decoded[i].translation, poses[i].translation);
+    EXPECT_EQ(decoded[i].rotation, poses[i].rotation);
+  }
+  // trailing bytes are as corrupted as missing ones
+  EXPECT_FALSE(esp::sim::decodeRenderRequest(payload + "x", id, decoded));
+  EXPECT_FALSE(esp::sim::decodeRenderRequest(
+      payload.substr(0, payload.size() - 1), id, decoded));
+}
+
+TEST(RenderProtocolTest, observations) {
+  auto depth = Buffer::create(std::vector<size_t>{2, 3, 1}, DataType::DT_FLOAT);
+  for (std::size_t i = 0; i < 6; ++i) {
+    const float value = 0.5f * i;
+    std::memcpy(depth->data.data() + 4 * i, &value, 4);
+  }
+  const std::string payload = esp::sim::encodeRenderObservations(
+      3, {{"depth", depth}, {"missing", nullptr}});
+
+  uint32_t id = 0;
+  std::vector<RenderObservation> observations;
+  ASSERT_TRUE(esp::sim::decodeRenderObservations(payload, id, observations));
+  EXPECT_EQ(id, 3);
+  ASSERT_EQ(observations.size(), 2);
+  EXPECT_EQ(observations[0].uuid, "depth");
+  ASSERT_TRUE(observations[0].buffer);
+  EXPECT_EQ(observations[0].buffer->dataType, DataType::DT_FLOAT);
+  EXPECT_EQ(observations[0].buffer->shape, depth->shape);
+  ASSERT_EQ(observations[0].buffer->data.size(), depth->data.size());
+  EXPECT_EQ(std::memcmp(observations[0].buffer->data.data(),
+                        depth->data.data(), depth->data.size()),
+            0);
+  EXPECT_EQ(observations[1].uuid, "missing");
+  EXPECT_FALSE(observations[1].buffer);
+
+  for (std::size_t size = 0; size < payload.size(); ++size) {
+    EXPECT_FALSE(esp::sim::decodeRenderObservations(payload.substr(0, size),
+                                                    id, observations))
+        << size;
+  }
+
+  // a shape much larger than the payload is rejected before allocating it,
+  // replacing the shape after the id, the count, the uuid and the data type
+  std::string huge = payload.substr(0, 4 + 4 + 4 + 5 + 1);
+  huge += std::string{"\x03\x00\x00\x00", 4};
+  for (int i = 0; i < 3; ++i)
+    huge += std::string{"\xff\xff\xff\x7f", 4};
+  EXPECT_FALSE(esp::sim::decodeRenderObservations(huge, id, observations));
+}
@@ -3,17 +3,30 @@
 // LICENSE file in the root directory of this source tree.
 
 #include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/PluginManager/Manager.h>
 #include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/String.h>
 #include <Magnum/EigenIntegration/Integration.h>
 #include <Magnum/Math/Range.h>
+#include <Magnum/Trade/AbstractImporter.h>
 #include <gtest/gtest.h>
+#include <cmath>
+#include <map>
 #include <string>
 
+#include "esp/assets/FileProvider.h"
+#include "esp/assets/GenericInstanceMeshData.h"
 #include "esp/assets/RenderAssetInstanceCreationInfo.h"
 #include "esp/assets/ResourceManager.h"
+#include "esp/assets/SceneBundle.h"
 #include "esp/gfx/Renderer.h"
+#include "esp/gfx/TextureStreamer.h"
 #include "esp/gfx/WindowlessContext.h"
 #include "esp/scene/SceneManager.h"
+#ifdef ESP_BUILD_PTEX_SUPPORT
+#include "esp/assets/PTexMeshData.h"
+#endif
 
 #include "configure.h"
 
@@ -84,6 +97,16 @@ TEST(ResourceManagerTest, createJoinedCollisionMesh) {
     // indexGroundTruth[iix];
     ASSERT_EQ(indexGroundTruth[iix], joinedBox->ibo[iix]);
   }
+
+  // joined once, then shared until the CPU data is released
+  esp::assets::MeshData::cptr cachedBox =
+      resourceManager.getJoinedCollisionMesh(boxFile);
+  ASSERT_EQ(cachedBox, resourceManager.getJoinedCollisionMesh(boxFile));
+  ASSERT_EQ(cachedBox->vbo.size(), joinedBox->vbo.size());
+  resourceManager.releaseHostMeshData(boxFile);
+  ASSERT_NE(cachedBox, resourceManager.getJoinedCollisionMesh(boxFile));
+  ASSERT_EQ(resourceManager.getJoinedCollisionMesh(boxFile)->ibo,
+            joinedBox->ibo);
 }
 
 // Load and create a render asset instance and assert success
@@ -116,3 +139,568 @@ TEST(ResourceManagerTest, loadAndCreateRenderAssetInstance) {
       info, creation, &sceneManager_, tempIDs);
   ASSERT(node);
 }
+
+// Load a stage twice through the mesh cache, the second time from the cache
+TEST(ResourceManagerTest, meshCache) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  const std::string cacheDirectory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "ResourceManagerTest-meshCache");
+  for (const std::string& file : Cr::Utility::Directory::list(
+           cacheDirectory,
+           Cr::Utility::Directory::Flag::SkipDotAndDotDot)) {
+    Cr::Utility::Directory::rm(
+        Cr::Utility::Directory::join(cacheDirectory, file));
+  }
+  std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+
+  std::vector<esp::assets::MeshData::uptr> joinedBoxes;
+  for (int i = 0; i < 2; ++i) {
+    // must declare these in this order due to avoid deallocation errors
+    auto MM = MetadataMediator::create();
+    ResourceManager resourceManager(MM);
+    resourceManager.setMeshCacheDirectory(cacheDirectory);
+    SceneManager sceneManager_;
+    auto stageAttributes =
+        MM->getStageAttributesManager()->createObject(boxFile, true);
+
+    int sceneID = sceneManager_.initSceneGraph();
+    std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+    ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                          &sceneManager_, tempIDs, false));
+    // the first load stores the meshes
+    ASSERT_FALSE(Cr::Utility::Directory::list(
+                     cacheDirectory,
+                     Cr::Utility::Directory::Flag::SkipDotAndDotDot)
+                     .empty());
+    joinedBoxes.push_back(resourceManager.createJoinedCollisionMesh(boxFile));
+  }
+
+  const esp::assets::MeshData& imported = *joinedBoxes[0];
+  const esp::assets::MeshData& cached = *joinedBoxes[1];
+  ASSERT_EQ(imported.vbo.size(), 24u);
+  ASSERT_EQ(cached.vbo.size(), imported.vbo.size());
+  ASSERT_EQ(cached.ibo.size(), imported.ibo.size());
+  for (size_t vix = 0; vix < imported.vbo.size(); vix++) {
+    ASSERT_EQ(Magnum::Vector3(imported.vbo[vix]),
+              Magnum::Vector3(cached.vbo[vix]));
+  }
+  for (size_t iix = 0; iix < imported.ibo.size(); iix++) {
+    ASSERT_EQ(imported.ibo[iix], cached.ibo[iix]);
+  }
+}
+
+// Load a copy of a stage with a baked bundle next to it, and the original
+TEST(ResourceManagerTest, sceneBundle) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  const std::string directory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "ResourceManagerTest-sceneBundle");
+  ASSERT_TRUE(Cr::Utility::Directory::mkpath(directory));
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  const std::string copiedFile =
+      Cr::Utility::Directory::join(directory, "transform_box.glb");
+  ASSERT_TRUE(Cr::Utility::Directory::copy(boxFile, copiedFile));
+  const std::string bundleFile =
+      esp::assets::SceneBundle::filenameFor(copiedFile);
+  ASSERT_TRUE(esp::assets::SceneBundle::bake(copiedFile, bundleFile));
+  ASSERT_TRUE(esp::assets::SceneBundle{bundleFile}.has(
+      esp::assets::SceneBundle::meshEntry(0)));
+
+  std::vector<esp::assets::MeshData::uptr> joinedBoxes;
+  for (const std::string& file : {boxFile, copiedFile}) {
+    // must declare these in this order due to avoid deallocation errors
+    auto MM = MetadataMediator::create();
+    ResourceManager resourceManager(MM);
+    SceneManager sceneManager_;
+    auto stageAttributes =
+        MM->getStageAttributesManager()->createObject(file, true);
+
+    int sceneID = sceneManager_.initSceneGraph();
+    std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+    ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                          &sceneManager_, tempIDs, false));
+    joinedBoxes.push_back(resourceManager.createJoinedCollisionMesh(file));
+  }
+
+  const esp::assets::MeshData& imported = *joinedBoxes[0];
+  const esp::assets::MeshData& baked = *joinedBoxes[1];
+  ASSERT_EQ(imported.vbo.size(), 24u);
+  ASSERT_EQ(baked.vbo.size(), imported.vbo.size());
+  ASSERT_EQ(baked.ibo.size(), imported.ibo.size());
+  for (size_t vix = 0; vix < imported.vbo.size(); vix++) {
+    ASSERT_EQ(Magnum::Vector3(imported.vbo[vix]),
+              Magnum::Vector3(baked.vbo[vix]));
+  }
+  for (size_t iix = 0; iix < imported.ibo.size(); iix++) {
+    ASSERT_EQ(imported.ibo[iix], baked.ibo[iix]);
+  }
+}
+
+// Free the CPU copies of a stage's meshes and re-read them to join them
+TEST(ResourceManagerTest, releaseStageMeshData) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+  std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+
+  std::vector<esp::assets::MeshData::uptr> joinedBoxes;
+  for (const bool release : {false, true}) {
+    // must declare these in this order due to avoid deallocation errors
+    auto MM = MetadataMediator::create();
+    ResourceManager resourceManager(MM);
+    resourceManager.setReleaseStageMeshData(release);
+    SceneManager sceneManager_;
+    auto stageAttributes =
+        MM->getStageAttributesManager()->createObject(boxFile, true);
+
+    int sceneID = sceneManager_.initSceneGraph();
+    std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+    ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                          &sceneManager_, tempIDs, false));
+    joinedBoxes.push_back(resourceManager.createJoinedCollisionMesh(boxFile));
+    // released again after joining, nothing left to free then
+    ASSERT_EQ(resourceManager.releaseHostMeshData(boxFile) == 0, release);
+  }
+
+  const esp::assets::MeshData& kept = *joinedBoxes[0];
+  const esp::assets::MeshData& reread = *joinedBoxes[1];
+  ASSERT_EQ(kept.vbo.size(), 24u);
+  ASSERT_EQ(reread.vbo.size(), kept.vbo.size());
+  ASSERT_EQ(reread.ibo.size(), kept.ibo.size());
+  for (size_t vix = 0; vix < kept.vbo.size(); vix++) {
+    ASSERT_EQ(Magnum::Vector3(kept.vbo[vix]), Magnum::Vector3(reread.vbo[vix]));
+  }
+  for (size_t iix = 0; iix < kept.ibo.size(); iix++) {
+    ASSERT_EQ(kept.ibo[iix], reread.ibo[iix]);
+  }
+}
+
+// Load a stage through a file provider, once its file arrived
+TEST(ResourceManagerTest, fileProvider) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+  std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+
+  // must declare these in this order due to avoid deallocation errors
+  auto MM = MetadataMediator::create();
+  ResourceManager resourceManager(MM);
+  auto provider = esp::assets::StreamingFileProvider::create();
+  resourceManager.setFileProvider(provider);
+  SceneManager sceneManager_;
+  auto stageAttributes =
+      MM->getStageAttributesManager()->createObject(boxFile, true);
+
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+  ASSERT_FALSE(resourceManager.loadStage(stageAttributes, nullptr,
+                                         &sceneManager_, tempIDs, false));
+  ASSERT_EQ(provider->takeRequests(), std::vector<std::string>{boxFile});
+  ASSERT_TRUE(provider->takeRequests().empty());
+
+  provider->addFile(boxFile, Cr::Utility::Directory::read(boxFile));
+  ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                        &sceneManager_, tempIDs, false));
+  ASSERT_EQ(resourceManager.createJoinedCollisionMesh(boxFile)->vbo.size(),
+            24u);
+  ASSERT_FALSE(resourceManager.hasPendingFiles());
+}
+
+// Two quads of different objects sharing an edge, with per-face object IDs
+TEST(ResourceManagerTest, loadInstancePlySplitByObjectId) {
+  std::string ply =
+      "ply\n"
+      "format binary_little_endian 1.0\n"
+      "element vertex 6\n"
+      "property float x\n"
+      "property float y\n"
+      "property float z\n"
+      "property uchar red\n"
+      "property uchar green\n"
+      "property uchar blue\n"
+      "element face 2\n"
+      "property list uchar int vertex_indices\n"
+      "property ushort object_id\n"
+      "end_header\n";
+  for (uint8_t i = 0; i < 6; ++i) {
+    const float position[]{float(i % 3), float(i / 3), 0.0f};
+    const uint8_t color[]{i, uint8_t(10 * i), uint8_t(20 * i)};
+    ply.append(reinterpret_cast<const char*>(position), sizeof(position));
+    ply.append(reinterpret_cast<const char*>(color), sizeof(color));
+  }
+  const uint32_t faces[][4]{{0, 1, 4, 3}, {1, 2, 5, 4}};
+  const uint16_t objectIds[]{7, 3};
+  for (int f = 0; f < 2; ++f) {
+    ply += char(4);
+    ply.append(reinterpret_cast<const char*>(faces[f]), sizeof(faces[f]));
+    ply.append(reinterpret_cast<const char*>(&objectIds[f]),
+               sizeof(uint16_t));
+  }
+  const std::string plyFile = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "ResourceManagerTest-instance.ply");
+  ASSERT_TRUE(Cr::Utility::Directory::writeString(plyFile, ply));
+
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImporter> manager;
+  Cr::Containers::Pointer<Mn::Trade::AbstractImporter> importer =
+      manager.loadAndInstantiate("StanfordImporter");
+  ASSERT_TRUE(importer);
+
+  // the vertices of the shared edge are duplicated for the second object
+  esp::assets::GenericInstanceMeshData::uptr mesh =
+      esp::assets::GenericInstanceMeshData::fromPLY(*importer, plyFile);
+  ASSERT_TRUE(mesh);
+  ASSERT_EQ(mesh->getVertexBufferObjectCPU().size(), 8u);
+  ASSERT_EQ(mesh->getIndexBufferObjectCPU().size(), 12u);
+  const std::vector<uint16_t>& meshObjectIds =
+      mesh->getObjectIdsBufferObjectCPU();
+  for (size_t i = 0; i < 12; ++i) {
+    ASSERT_EQ(meshObjectIds[mesh->getIndexBufferObjectCPU()[i]],
+              objectIds[i / 6]);
+  }
+
+  // the objects are ranges of one mesh, in the order they first appear in
+  esp::assets::GenericInstanceMeshData::uptr split =
+      esp::assets::GenericInstanceMeshData::fromPlySplitByObjectId(*importer,
+                                                                   plyFile);
+  ASSERT_TRUE(split);
+  ASSERT_EQ(split->getVertexBufferObjectCPU().size(), 8u);
+  ASSERT_EQ(split->getIndexBufferObjectCPU().size(), 12u);
+  const std::vector<esp::gfx::Drawable::Submesh>& submeshes =
+      split->getObjectSubmeshes();
+  ASSERT_EQ(submeshes.size(), 2u);
+  for (int f = 0; f < 2; ++f) {
+    const esp::gfx::Drawable::Submesh& submesh = submeshes[f];
+    ASSERT_EQ(submesh.id, objectIds[f]);
+    ASSERT_EQ(submesh.indexOffset, 6u * f);
+    ASSERT_EQ(submesh.indexCount, 6u);
+    ASSERT_FALSE(submesh.hidden);
+    for (size_t i = 0; i < 6; ++i) {
+      const uint32_t index = split->getIndexBufferObjectCPU()[6 * f + i];
+      ASSERT_EQ(split->getObjectIdsBufferObjectCPU()[index], objectIds[f]);
+      const esp::vec3f& position = split->getVertexBufferObjectCPU()[index];
+      ASSERT_TRUE(submesh.box.contains(Mn::Vector3::from(position.data())));
+    }
+    // the first triangle of the fan is the first three quad corners
+    for (size_t i = 0; i < 3; ++i) {
+      const esp::vec3uc& color =
+          split->getColorBufferObjectCPU()
+              [split->getIndexBufferObjectCPU()[6 * f + i]];
+      ASSERT_EQ(int(color[0]), int(faces[f][i]));
+    }
+  }
+}
+
+#ifdef ESP_BUILD_PTEX_SUPPORT
+TEST(ResourceManagerTest, packPTexAtlasRgb9e5) {
+  using esp::assets::PTexMeshData;
+  auto unpack = [](uint32_t packed) {
+    const float scale = std::ldexp(1.0f, int(packed >> 27) - 15 - 9);
+    return Mn::Vector3{float(packed & 0x1ff), float((packed >> 9) & 0x1ff),
+                       float((packed >> 18) & 0x1ff)} *
+           scale;
+  };
+
+  ASSERT_EQ(PTexMeshData::packRgb9e5({1.0f, 1.0f, 1.0f}),
+            (16u << 27) | (256u << 18) | (256u << 9) | 256u);
+  ASSERT_EQ(unpack(PTexMeshData::packRgb9e5({})), Mn::Vector3{});
+  // out of range components are clamped
+  ASSERT_EQ(unpack(PTexMeshData::packRgb9e5({-1.0f, 1.0e6f, 0.0f})),
+            (Mn::Vector3{0.0f, 65408.0f, 0.0f}));
+
+  // the components share the exponent of the largest
+  const Mn::Vector3 color{0.3f, 12.5f, 0.001f};
+  const Mn::Vector3 unpacked = unpack(PTexMeshData::packRgb9e5(color));
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NEAR(unpacked[i], color[i], 16.0f / 512.0f);
+  }
+  ASSERT_EQ(unpacked[1], 12.5f);
+}
+
+// The baked atlases of PTexMeshData::convertToGltf() are tone mapped as the
+// PTex shader does
+TEST(ResourceManagerTest, toneMapPTexAtlas) {
+  using esp::assets::PTexMeshData;
+  ASSERT_EQ(PTexMeshData::toneMap({}, 0.0125f, 1.0f / 1.6969f, 1.5f),
+            (Mn::Color3ub{0, 0, 0}));
+  // grays keep their saturation, the exposure and the gamma apply
+  const Mn::Color3ub gray =
+      PTexMeshData::toneMap(Mn::Vector3{1.0f}, 0.25f, 0.5f, 1.5f);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NEAR(int(gray[i]), 128, 1);
+  }
+  // the components saturated below 0 are black, above 1 are clamped
+  ASSERT_EQ(PTexMeshData::toneMap({1.0f, 0.0f, 0.0f}, 1.0f, 1.0f, 2.0f),
+            (Mn::Color3ub{255, 0, 0}));
+}
+#endif
+
+// Load a stage with its meshes merged, the merged drawables cover the same
+// boxes as the separate ones
+TEST(ResourceManagerTest, mergeStaticMeshes) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+  std::string stageFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/5boxes.glb");
+
+  std::vector<Mn::Range3D> stageBoxes;
+  std::vector<size_t> numDrawables;
+  for (const bool merge : {false, true}) {
+    // must declare these in this order due to avoid deallocation errors
+    auto MM = MetadataMediator::create();
+    ResourceManager resourceManager(MM);
+    resourceManager.setMergeStaticMeshes(merge);
+    // without materials, all the boxes share the default one
+    resourceManager.setRequiresTextures(false);
+    SceneManager sceneManager_;
+    auto stageAttributes =
+        MM->getStageAttributesManager()->createObject(stageFile, true);
+
+    int sceneID = sceneManager_.initSceneGraph();
+    std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+    ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                          &sceneManager_, tempIDs, false));
+
+    auto& drawables = sceneManager_.getSceneGraph(sceneID).getDrawables();
+    numDrawables.push_back(drawables.size());
+    Mn::Range3D stageBox;
+    size_t numSubmeshes = 0;
+    for (size_t i = 0; i < drawables.size(); ++i) {
+      auto& drawable = static_cast<esp::gfx::Drawable&>(drawables[i]);
+      auto aabb = drawable.getSceneNode().getAbsoluteAABB();
+      ASSERT_TRUE(aabb);
+      stageBox = i ? Mn::Math::join(stageBox, *aabb) : *aabb;
+      numSubmeshes += drawable.getSubmeshes().size();
+    }
+    stageBoxes.push_back(stageBox);
+    if (merge) {
+      // one range per original mesh
+      EXPECT_EQ(numSubmeshes, numDrawables[0]);
+    }
+  }
+
+  EXPECT_EQ(numDrawables[0], 5u);
+  EXPECT_EQ(numDrawables[1], 1u);
+  EXPECT_EQ(stageBoxes[1].min(), stageBoxes[0].min());
+  EXPECT_EQ(stageBoxes[1].max(), stageBoxes[0].max());
+}
+
+// Load a stage with its lighting baked twice, the second time from the cache
+TEST(ResourceManagerTest, bakeStaticLighting) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+  std::string stageFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/5boxes.glb");
+
+  const std::string cacheDirectory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "ResourceManagerTest-bakeStaticLighting");
+  for (const std::string& file : Cr::Utility::Directory::list(
+           cacheDirectory,
+           Cr::Utility::Directory::Flag::SkipDotAndDotDot)) {
+    Cr::Utility::Directory::rm(
+        Cr::Utility::Directory::join(cacheDirectory, file));
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    // must declare these in this order due to avoid deallocation errors
+    auto MM = MetadataMediator::create();
+    ResourceManager resourceManager(MM);
+    resourceManager.setMergeStaticMeshes(true);
+    resourceManager.setBakeStaticLighting(true);
+    resourceManager.setBakedLightingCacheDirectory(cacheDirectory);
+    resourceManager.setRequiresTextures(false);
+    resourceManager.setLightSetup(esp::gfx::getDefaultLights());
+    SceneManager sceneManager_;
+    auto stageAttributes =
+        MM->getStageAttributesManager()->createObject(stageFile, true);
+    stageAttributes->setRequiresLighting(true);
+    stageAttributes->setLightSetup(esp::DEFAULT_LIGHTING_KEY);
+
+    int sceneID = sceneManager_.initSceneGraph();
+    std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+    ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                          &sceneManager_, tempIDs, false));
+    EXPECT_EQ(sceneManager_.getSceneGraph(sceneID).getDrawables().size(), 1u);
+
+    // the first load stores the colors of the merged mesh, the second loads
+    // them
+    std::vector<std::string> files = Cr::Utility::Directory::list(
+        cacheDirectory, Cr::Utility::Directory::Flag::SkipDotAndDotDot);
+    ASSERT_EQ(files.size(), 1u);
+    EXPECT_TRUE(Cr::Utility::String::endsWith(files[0], ".light"));
+  }
+}
+
+// Evict the assets without instances over budget, least recently used first
+TEST(ResourceManagerTest, evictUnusedAssets) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  // must declare these in this order due to avoid deallocation errors
+  auto MM = MetadataMediator::create();
+  ResourceManager resourceManager(MM);
+  SceneManager sceneManager_;
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+  // the textures of the chair are streamed
+  resourceManager.setTextureMemoryBudget(1 << 20);
+  esp::gfx::TextureStreamer* textureStreamer =
+      resourceManager.getTextureStreamer();
+  ASSERT_TRUE(textureStreamer);
+
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  const std::string sphereFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/sphere.glb");
+  const std::string chairFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/chair.glb");
+  std::map<std::string, esp::scene::SceneNode*> nodes;
+  for (const std::string& file : {boxFile, sphereFile, chairFile}) {
+    esp::assets::RenderAssetInstanceCreationInfo creation(
+        file, Corrade::Containers::NullOpt, {}, "");
+    nodes[file] = resourceManager.loadAndCreateRenderAssetInstance(
+        esp::assets::AssetInfo::fromPath(file), creation, &sceneManager_,
+        tempIDs);
+    ASSERT_TRUE(nodes[file]);
+    ASSERT_EQ(resourceManager.getNumAssetReferences(file), 1);
+  }
+  const std::size_t hostBytes = resourceManager.getAssetCacheHostBytes();
+  ASSERT_GT(hostBytes, 0u);
+  const std::size_t numTextures = textureStreamer->statistics().numTextures;
+  ASSERT_GT(numTextures, 0u);
+  ASSERT_GT(resourceManager.getAssetCacheGpuBytes(), 0u);
+
+  // everything is referenced, nothing to evict
+  resourceManager.setAssetCacheBudget(1, 0);
+  ASSERT_EQ(resourceManager.evictUnusedAssets(), 0);
+
+  // the sphere is released last and kept pinned, the box is the least
+  // recently used
+  auto pinned = resourceManager.acquireAsset(sphereFile);
+  delete nodes[boxFile];
+  delete nodes[sphereFile];
+  ASSERT_EQ(resourceManager.getNumAssetReferences(boxFile), 0);
+  ASSERT_EQ(resourceManager.getNumAssetReferences(sphereFile), 1);
+  resourceManager.setAssetCacheBudget(hostBytes - 1, 0);
+  ASSERT_EQ(resourceManager.evictUnusedAssets(), 1);
+  ASSERT_LT(resourceManager.getAssetCacheHostBytes(), hostBytes);
+
+  // unpinned, the sphere goes too, and the stage of a previous scene graph
+  pinned = {};
+  resourceManager.setAssetCacheBudget(1, 0);
+  ASSERT_EQ(resourceManager.deleteAssetInstances(
+                sceneManager_.getSceneGraph(sceneID).getRootNode()),
+            1);
+  ASSERT_EQ(resourceManager.evictUnusedAssets(), 2);
+  ASSERT_EQ(resourceManager.getAssetCacheHostBytes(), 0u);
+  // the streamer forgot the textures of the chair
+  esp::gfx::TextureStreamer::Statistics statistics =
+      textureStreamer->statistics();
+  ASSERT_EQ(statistics.numTextures, 0u);
+  ASSERT_EQ(statistics.residentBytes, 0u);
+  ASSERT_EQ(statistics.hostBytes, 0u);
+
+  // loaded again when instanced next, the textures streamed again
+  for (const std::string& file : {boxFile, chairFile}) {
+    esp::assets::RenderAssetInstanceCreationInfo creation(
+        file, Corrade::Containers::NullOpt, {}, "");
+    ASSERT_TRUE(resourceManager.loadAndCreateRenderAssetInstance(
+        esp::assets::AssetInfo::fromPath(file), creation, &sceneManager_,
+        tempIDs));
+    ASSERT_EQ(resourceManager.getNumAssetReferences(file), 1);
+  }
+  statistics = textureStreamer->statistics();
+  ASSERT_EQ(statistics.numTextures, numTextures);
+  ASSERT_GT(statistics.residentBytes, 0u);
+}
+
+// The same file under another path shares the meshes loaded already
+TEST(ResourceManagerTest, shareIdenticalAssets) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  const std::string copyDirectory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "ResourceManagerTest-shareIdentical");
+  ASSERT_TRUE(Cr::Utility::Directory::mkpath(copyDirectory));
+  const std::string copyFile =
+      Cr::Utility::Directory::join(copyDirectory, "box copy.glb");
+  ASSERT_TRUE(Cr::Utility::Directory::copy(boxFile, copyFile));
+
+  // must declare these in this order due to avoid deallocation errors
+  auto MM = MetadataMediator::create();
+  ResourceManager resourceManager(MM);
+  SceneManager sceneManager_;
+  int sceneID = sceneManager_.initSceneGraph();
+  std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+
+  std::size_t hostBytes = 0;
+  for (const std::string& file : {boxFile, copyFile}) {
+    esp::assets::RenderAssetInstanceCreationInfo creation(
+        file, Corrade::Containers::NullOpt, {}, "");
+    ASSERT_TRUE(resourceManager.loadAndCreateRenderAssetInstance(
+        esp::assets::AssetInfo::fromPath(file), creation, &sceneManager_,
+        tempIDs));
+    if (!hostBytes) {
+      hostBytes = resourceManager.getAssetCacheHostBytes();
+    }
+  }
+  ASSERT_EQ(resourceManager.getMeshMetaData(copyFile).meshIndex,
+            resourceManager.getMeshMetaData(boxFile).meshIndex);
+  ASSERT_EQ(resourceManager.getAssetCacheHostBytes(), hostBytes);
+  ASSERT_EQ(resourceManager.createJoinedCollisionMesh(copyFile)->ibo,
+            resourceManager.createJoinedCollisionMesh(boxFile)->ibo);
+
+  // the copy keeps the meshes when the original is evicted
+  ASSERT_EQ(resourceManager.deleteAssetInstances(
+                sceneManager_.getSceneGraph(sceneID).getRootNode()),
+            2);
+  auto pinned = resourceManager.acquireAsset(copyFile);
+  resourceManager.setAssetCacheBudget(1, 0);
+  ASSERT_EQ(resourceManager.evictUnusedAssets(), 1);
+  ASSERT_EQ(resourceManager.getAssetCacheHostBytes(), hostBytes);
+  ASSERT_EQ(resourceManager.createJoinedCollisionMesh(copyFile)->ibo.size(),
+            36u);
+}
+
+// A stage drawing the semantic observations from its render mesh needs no
+// separate semantic scene graph
+TEST(ResourceManagerTest, unifiedSemanticStage) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  const std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  for (const bool forceSeparate : {false, true}) {
+    // must declare these in this order due to avoid deallocation errors
+    auto MM = MetadataMediator::create();
+    ResourceManager resourceManager(MM);
+    SceneManager sceneManager_;
+    auto stageAttributes =
+        MM->getStageAttributesManager()->createObject(boxFile, true);
+    stageAttributes->setSemanticAssetHandle(boxFile);
+    stageAttributes->setSemanticAssetType(
+        stageAttributes->getRenderAssetType());
+
+    int sceneID = sceneManager_.initSceneGraph();
+    std::vector<int> tempIDs{sceneID, sceneID};
+    ASSERT_TRUE(resourceManager.loadStage(stageAttributes, nullptr,
+                                          &sceneManager_, tempIDs, true,
+                                          forceSeparate));
+    ASSERT_EQ(tempIDs[1] != tempIDs[0], forceSeparate);
+  }
+}
@@ -38,3 +38,58 @@ TEST_F(SceneGraphTest, DeleteDrawableGroup) {
   EXPECT_EQ(g.getDrawableGroups().size(), numInitialGroups);
   ASSERT_EQ(g.getDrawableGroup(groupName), nullptr);
 }
+
+TEST_F(SceneGraphTest, NodeArena) {
+  const std::size_t numAllocations = g.getArena().numAllocations();
+  esp::scene::SceneNode& parent = g.getRootNode().createChild();
+  EXPECT_EQ(parent.arena(), g.getRootNode().arena());
+  for (int i = 0; i < 100; ++i) {
+    parent.createChild().createChild();
+  }
+  EXPECT_EQ(g.getArena().numAllocations(), numAllocations + 201);
+
+  // the nodes are deallocated into the arena, which reuses them
+  const std::size_t reservedBytes = g.getArena().reservedBytes();
+  delete &parent;
+  EXPECT_EQ(g.getArena().numAllocations(), numAllocations);
+  esp::scene::SceneNode& other = g.getRootNode().createChild();
+  for (int i = 0; i < 200; ++i) {
+    other.createChild();
+  }
+  EXPECT_EQ(g.getArena().numAllocations(), numAllocations + 201);
+  EXPECT_EQ(g.getArena().reservedBytes(), reservedBytes);
+}
+
+TEST_F(SceneGraphTest, UpdateTransformations) {
+  esp::scene::SceneNode& parent = g.getRootNode().createChild();
+  esp::scene::SceneNode& child = parent.createChild();
+  parent.translate({1.0f, 0.0f, 0.0f});
+  child.translate({0.0f, 2.0f, 0.0f});
+
+  g.updateTransformations();
+  EXPECT_FALSE(child.isDirty());
+  EXPECT_EQ(child.cachedAbsoluteTransformationMatrix().translation(),
+            Magnum::Vector3(1.0f, 2.0f, 0.0f));
+
+  // nodes created after the last update are picked up
+  esp::scene::SceneNode& grandChild = child.createChild();
+  grandChild.translate({0.0f, 0.0f, 3.0f});
+  parent.translate({1.0f, 0.0f, 0.0f});
+  g.updateTransformations();
+  EXPECT_FALSE(grandChild.isDirty());
+  EXPECT_EQ(grandChild.cachedAbsoluteTransformationMatrix().translation(),
+            Magnum::Vector3(2.0f, 2.0f, 3.0f));
+
+  // and so are reparented ones
+  grandChild.setParent(&g.getRootNode());
+  g.updateTransformations();
+  EXPECT_EQ(grandChild.cachedAbsoluteTransformationMatrix().translation(),
+            Magnum::Vector3(0.0f, 0.0f, 3.0f));
+
+  // destroying nodes doesn't leave dangling ones behind
+  delete &parent;
+  grandChild.translate({1.0f, 0.0f, 0.0f});
+  g.updateTransformations();
+  EXPECT_EQ(grandChild.cachedAbsoluteTransformationMatrix().translation(),
+            Magnum::Vector3(1.0f, 0.0f, 3.0f));
+}
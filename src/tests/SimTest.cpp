@@ -2,18 +2,32 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/TestSuite/Compare/Numeric.h>
 #include <Corrade/TestSuite/Tester.h>
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/DebugTools/CompareImage.h>
 #include <Magnum/EigenIntegration/Integration.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Magnum.h>
+#include <Magnum/Math/Angle.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
 #include <Magnum/PixelFormat.h>
+#include <chrono>
+#include <cmath>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/RenderTarget.h"
+#include "esp/gfx/Renderer.h"
 #include "esp/physics/RigidObject.h"
+#include "esp/sensor/CameraSensor.h"
+#include "esp/sensor/ObservationRecorder.h"
 #include "esp/sim/Simulator.h"
 
 #include "configure.h"
@@ -88,6 +102,8 @@ struct SimTest : Cr::TestSuite::Tester {
 
   void basic();
   void reconfigure();
+  void prefetchScene();
+  void partialReconfigure();
   void reset();
   void getSceneRGBAObservation();
   void getSceneWithLightingRGBAObservation();
@@ -99,6 +115,13 @@ struct SimTest : Cr::TestSuite::Tester {
   void recomputeNavmeshWithStaticObjects();
   void loadingObjectTemplates();
   void buildingPrimAssetObjectTemplates();
+  void recordObservations();
+  void lightweightPasses();
+  void movingCamera();
+  void asyncReads();
+  void batchTiles();
+  void observationBufferRing();
+  void renderTopDownMap();
 
   // TODO: remove outlier pixels from image and lower maxThreshold
   const Magnum::Float maxThreshold = 255.f;
@@ -113,6 +136,8 @@ SimTest::SimTest() {
   // clang-format off
   addTests({&SimTest::basic,
             &SimTest::reconfigure,
+            &SimTest::prefetchScene,
+            &SimTest::partialReconfigure,
             &SimTest::reset,
             &SimTest::getSceneRGBAObservation,
             &SimTest::getSceneWithLightingRGBAObservation,
@@ -123,7 +148,14 @@ SimTest::SimTest() {
             &SimTest::multipleLightingSetupsRGBAObservation,
             &SimTest::recomputeNavmeshWithStaticObjects,
             &SimTest::loadingObjectTemplates,
-            &SimTest::buildingPrimAssetObjectTemplates});
+            &SimTest::buildingPrimAssetObjectTemplates,
+            &SimTest::recordObservations,
+            &SimTest::lightweightPasses,
+            &SimTest::movingCamera,
+            &SimTest::asyncReads,
+            &SimTest::batchTiles,
+            &SimTest::observationBufferRing,
+            &SimTest::renderTopDownMap});
   // clang-format on
 }
 
@@ -148,6 +180,50 @@ void SimTest::reconfigure() {
   CORRADE_VERIFY(pathfinder != simulator.getPathFinder());
 }
 
+void SimTest::prefetchScene() {
+  SimulatorConfiguration cfg;
+  cfg.activeSceneID = vangogh;
+  Simulator simulator(cfg);
+  PathFinder::ptr pathfinder = simulator.getPathFinder();
+
+  SimulatorConfiguration cfg2;
+  cfg2.activeSceneID = skokloster;
+  simulator.prefetchScene(cfg2);
+  simulator.reconfigure(cfg2);
+  CORRADE_VERIFY(pathfinder != simulator.getPathFinder());
+  CORRADE_VERIFY(simulator.getPathFinder()->isLoaded());
+
+  // a prefetch of another stage is discarded
+  simulator.prefetchScene(cfg);
+  SimulatorConfiguration cfg3 = cfg2;
+  cfg3.frustumCulling = !cfg2.frustumCulling;
+  simulator.reconfigure(cfg3);
+  CORRADE_VERIFY(simulator.getPathFinder()->isLoaded());
+}
+
+void SimTest::partialReconfigure() {
+  SimulatorConfiguration cfg;
+  cfg.activeSceneID = vangogh;
+  Simulator simulator(cfg);
+  PathFinder::ptr pathfinder = simulator.getPathFinder();
+  esp::scene::SceneGraph* sceneGraph = &simulator.getActiveSceneGraph();
+
+  // a new seed keeps the stage
+  SimulatorConfiguration cfg2 = cfg;
+  cfg2.randomSeed = cfg.randomSeed + 1;
+  CORRADE_VERIFY(!simulator.isStageReloadRequired(cfg2));
+  simulator.reconfigure(cfg2);
+  CORRADE_VERIFY(pathfinder == simulator.getPathFinder());
+  CORRADE_VERIFY(sceneGraph == &simulator.getActiveSceneGraph());
+
+  // culling is set up when the stage is loaded
+  SimulatorConfiguration cfg3 = cfg2;
+  cfg3.frustumCulling = !cfg2.frustumCulling;
+  CORRADE_VERIFY(simulator.isStageReloadRequired(cfg3));
+  simulator.reconfigure(cfg3);
+  CORRADE_VERIFY(pathfinder != simulator.getPathFinder());
+}
+
 void SimTest::reset() {
   SimulatorConfiguration cfg;
   cfg.activeSceneID = vangogh;
@@ -643,6 +719,359 @@ void SimTest::buildingPrimAssetObjectTemplates() {
 
 }  // SimTest::buildingPrimAssetObjectTemplates
 
+void SimTest::recordObservations() {
+  Simulator::uptr simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->resolution = {32, 48};
+  auto depthSpec = SensorSpec::create();
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::Depth;
+  depthSpec->channels = 1;
+  depthSpec->resolution = {32, 48};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+
+  const std::string directory = Cr::Utility::Directory::join(
+      Cr::Utility::Directory::tmp(), "SimTest_recordObservations");
+  {
+    // a single queued frame, so that recording waits on the writes
+    esp::sensor::ObservationRecorder recorder{directory, 2, 1};
+    for (int frame = 0; frame != 3; ++frame) {
+      for (const std::string& uuid : {"color", "depth"}) {
+        CORRADE_VERIFY(simulator->drawObservation(0, uuid));
+        auto& sensor = static_cast<esp::sensor::CameraSensor&>(
+            *agent->getSensorSuite().get(uuid));
+        CORRADE_COMPARE(recorder.record(sensor), frame);
+      }
+    }
+    recorder.flush();
+    CORRADE_COMPARE(recorder.numQueued(), 0);
+    CORRADE_COMPARE(recorder.numWritten(), 6);
+    CORRADE_COMPARE(recorder.numFailed(), 0);
+  }
+
+  CORRADE_VERIFY(Cr::Utility::Directory::exists(
+      Cr::Utility::Directory::join(directory, "color/000002.png")));
+  // the 128 bytes of the header and the float depths
+  CORRADE_COMPARE(Cr::Utility::Directory::read(
+                      Cr::Utility::Directory::join(directory,
+                                                   "depth/000002.npy"))
+                      .size(),
+                  128 + 32 * 48 * 4);
+}
+
+void SimTest::lightweightPasses() {
+  Simulator::uptr simulator = getSimulator(vangogh);
+  auto objectAttribsMgr = simulator->getObjectAttributesManager();
+  auto objs = objectAttribsMgr->getObjectHandlesBySubstring("nested_box");
+  int objectID = simulator->addObjectByHandle(objs[0]);
+  CORRADE_VERIFY(objectID != esp::ID_UNDEFINED);
+  simulator->setTranslation({0.0f, 1.5f, -1.5f}, objectID);
+
+  auto makeSpec = [](const std::string& uuid, SensorType type) {
+    auto spec = SensorSpec::create();
+    spec->uuid = uuid;
+    spec->sensorType = type;
+    spec->channels = type == SensorType::Color ? 4 : 1;
+    spec->resolution = {32, 48};
+    return spec;
+  };
+  auto colorSpec = makeSpec("color", SensorType::Color);
+  auto depthSpec = makeSpec("depth", SensorType::Depth);
+  auto semanticSpec = makeSpec("semantic", SensorType::Semantic);
+  auto narrowSpec = makeSpec("narrow", SensorType::Color);
+  narrowSpec->parameters["hfov"] = "60";
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec, semanticSpec,
+                                      narrowSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+  auto camera = [&](const std::string& uuid) -> esp::sensor::CameraSensor& {
+    return static_cast<esp::sensor::CameraSensor&>(
+        *agent->getSensorSuite().get(uuid));
+  };
+  esp::sensor::CameraSensor& color = camera("color");
+  esp::sensor::CameraSensor& depth = camera("depth");
+  esp::sensor::CameraSensor& semantic = camera("semantic");
+  esp::sensor::CameraSensor& narrow = camera("narrow");
+
+  // the full pass of a color sensor serves all of them, the lightweight
+  // passes only the sensors reading what they wrote
+  CORRADE_VERIFY(color.canShareRenderPass(depth));
+  CORRADE_VERIFY(color.canShareRenderPass(semantic));
+  CORRADE_VERIFY(semantic.canShareRenderPass(depth));
+  CORRADE_VERIFY(!depth.canShareRenderPass(color));
+  CORRADE_VERIFY(!depth.canShareRenderPass(semantic));
+  CORRADE_VERIFY(!semantic.canShareRenderPass(color));
+  // sensors with different projections never share
+  CORRADE_VERIFY(!color.canShareRenderPass(narrow));
+  CORRADE_VERIFY(!narrow.canShareRenderPass(color));
+
+  // the lightweight passes match what the full shaders wrote
+  for (const std::string& uuid : {"color", "depth", "semantic"}) {
+    CORRADE_VERIFY(simulator->drawObservation(0, uuid));
+  }
+  auto read = [](esp::sensor::CameraSensor& sensor,
+                 esp::gfx::RenderTarget& source) {
+    Observation observation;
+    sensor.readObservationFrom(source, observation);
+    return std::vector<uint8_t>(observation.buffer->data.begin(),
+                                observation.buffer->data.end());
+  };
+  const std::vector<uint8_t> fullDepth = read(depth, color.renderTarget());
+  const std::vector<uint8_t> lightDepth = read(depth, depth.renderTarget());
+  CORRADE_COMPARE(lightDepth.size(), fullDepth.size());
+  const auto* full = reinterpret_cast<const float*>(fullDepth.data());
+  const auto* light = reinterpret_cast<const float*>(lightDepth.data());
+  std::size_t numDifferent = 0;
+  std::size_t numCovered = 0;
+  for (std::size_t i = 0; i != lightDepth.size() / sizeof(float); ++i) {
+    // the linear depth of the pass and the one unprojected from the depth
+    // buffer differ by the precision of the latter
+    numDifferent += std::abs(light[i] - full[i]) > 1.0e-3f + 0.01f * full[i];
+    numCovered += full[i] > 0.0f;
+  }
+  CORRADE_COMPARE(numDifferent, 0);
+  CORRADE_VERIFY(numCovered > 0);
+  CORRADE_VERIFY(read(semantic, color.renderTarget()) ==
+                 read(semantic, semantic.renderTarget()));
+}
+
+void SimTest::movingCamera() {
+  Simulator::uptr simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->resolution = {32, 48};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+  auto& sensor = static_cast<esp::sensor::CameraSensor&>(
+      *agent->getSensorSuite().get("color"));
+
+  auto draw = [&]() {
+    CORRADE_VERIFY(simulator->drawObservation(0, "color"));
+    Observation observation;
+    sensor.readObservationFrom(sensor.renderTarget(), observation);
+    return std::vector<uint8_t>(observation.buffer->data.begin(),
+                                observation.buffer->data.end());
+  };
+  const std::vector<uint8_t> before = draw();
+  const Mn::Matrix4 initial = sensor.node().transformation();
+
+  // the drawables are transformed with the matrix of the moved camera, not
+  // the one of the previous draw
+  sensor.node().rotateYLocal(Mn::Deg(90.0f));
+  const std::vector<uint8_t> rotated = draw();
+  CORRADE_COMPARE(rotated.size(), before.size());
+  CORRADE_VERIFY(rotated != before);
+
+  sensor.node().setTransformation(initial);
+  CORRADE_VERIFY(draw() == before);
+}
+
+void SimTest::asyncReads() {
+  Simulator::uptr simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->resolution = {32, 48};
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+  auto& sensor = static_cast<esp::sensor::CameraSensor&>(
+      *agent->getSensorSuite().get("color"));
+  esp::gfx::RenderTarget& target = sensor.renderTarget();
+  CORRADE_VERIFY(!target.hasPendingRead());
+  CORRADE_VERIFY(!target.isPendingReadReady());
+
+  CORRADE_VERIFY(simulator->drawObservation(0, "color"));
+  const Mn::Vector2i size = target.framebufferSize();
+  std::vector<char> expected(std::size_t(size.product()) * 4);
+  target.readFrameRgba(
+      Mn::MutableImageView2D{Mn::PixelFormat::RGBA8Unorm, size, expected});
+
+  target.readFrameRgbaAsync();
+  CORRADE_VERIFY(target.hasPendingRead());
+  // the read is submitted when started, so polling alone sees it complete
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!target.isPendingReadReady() &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CORRADE_VERIFY(target.isPendingReadReady());
+
+  std::vector<char> pixels(expected.size());
+  target.fence(
+      Mn::MutableImageView2D{Mn::PixelFormat::RGBA8Unorm, size, pixels});
+  CORRADE_VERIFY(!target.hasPendingRead());
+  CORRADE_VERIFY(!target.isPendingReadReady());
+  CORRADE_VERIFY(pixels == expected);
+}
+
+void SimTest::batchTiles() {
+  Simulator::uptr simulator = getSimulator(vangogh);
+  AgentConfiguration agentConfig{};
+  for (const char* uuid : {"a", "b", "c"}) {
+    auto spec = SensorSpec::create();
+    spec->uuid = uuid;
+    spec->resolution = {32, 48};
+    agentConfig.sensorSpecifications.push_back(spec);
+  }
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+  std::vector<esp::sensor::CameraSensor*> sensors;
+  for (const char* uuid : {"a", "b", "c"}) {
+    sensors.push_back(static_cast<esp::sensor::CameraSensor*>(
+        agent->getSensorSuite().get(uuid).get()));
+    sensors.back()->node().rotateYLocal(Mn::Deg(120.0f * sensors.size()));
+  }
+  const Mn::Vector2i tileSize = sensors[0]->framebufferSize();
+  const std::size_t tilePixels = tileSize.product();
+
+  // each sensor drawn alone
+  std::vector<std::vector<Mn::Color4ub>> colors;
+  std::vector<std::vector<float>> depths;
+  for (esp::sensor::CameraSensor* sensor : sensors) {
+    CORRADE_VERIFY(
+        simulator->drawObservation(0, sensor->specification()->uuid));
+    colors.emplace_back(tilePixels);
+    depths.emplace_back(tilePixels);
+    sensor->renderTarget().readFrameRgba(Mn::MutableImageView2D{
+        Mn::PixelFormat::RGBA8Unorm, tileSize, colors.back()});
+    sensor->renderTarget().readFrameDepth(
+        Mn::MutableImageView2D{Mn::PixelFormat::R32F, tileSize, depths.back()});
+  }
+  // the views differ, so that a tile drawn from the wrong sensor is caught
+  CORRADE_VERIFY(colors[0] != colors[1]);
+  CORRADE_VERIFY(colors[1] != colors[2]);
+
+  esp::gfx::Renderer& renderer = *simulator->getRenderer();
+  std::unique_ptr<esp::gfx::RenderTarget> target =
+      renderer.createBatchRenderTarget(*sensors[0], sensors.size());
+  std::vector<esp::gfx::Renderer::BatchEntry> batch;
+  for (esp::sensor::CameraSensor* sensor : sensors) {
+    batch.push_back({*sensor, simulator->getActiveSceneGraph()});
+  }
+  renderer.drawBatch(*target, batch);
+  const Mn::Vector2i size = target->framebufferSize();
+  CORRADE_COMPARE(size, esp::gfx::Renderer::batchFramebufferSize(
+                            tileSize, sensors.size()));
+  std::vector<Mn::Color4ub> batchColors(std::size_t(size.product()));
+  std::vector<float> batchDepths(std::size_t(size.product()));
+  target->readFrameRgba(
+      Mn::MutableImageView2D{Mn::PixelFormat::RGBA8Unorm, size, batchColors});
+  target->readFrameDepth(
+      Mn::MutableImageView2D{Mn::PixelFormat::R32F, size, batchDepths});
+
+  for (std::size_t i = 0; i != sensors.size(); ++i) {
+    CORRADE_ITERATION(i);
+    const Mn::Vector2i offset =
+        esp::gfx::Renderer::batchTileViewport(tileSize, sensors.size(), i)
+            .min();
+    std::size_t numDifferentColors = 0;
+    std::size_t numDifferentDepths = 0;
+    for (int y = 0; y != tileSize.y(); ++y) {
+      for (int x = 0; x != tileSize.x(); ++x) {
+        const std::size_t tile = std::size_t(y) * tileSize.x() + x;
+        const std::size_t whole =
+            std::size_t(offset.y() + y) * size.x() + offset.x() + x;
+        numDifferentColors += batchColors[whole] != colors[i][tile];
+        // the depth of the whole batch is unprojected with the projection of
+        // the first sensor, which all of them share
+        numDifferentDepths +=
+            std::abs(batchDepths[whole] - depths[i][tile]) > 1.0e-4f;
+      }
+    }
+    CORRADE_COMPARE(numDifferentColors, 0);
+    CORRADE_COMPARE(numDifferentDepths, 0);
+  }
+}
+
+void SimTest::observationBufferRing() {
+  Simulator::uptr simulator = getSimulator(vangogh);
+  auto colorSpec = SensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->resolution = {32, 48};
+  colorSpec->numObservationBuffers = 3;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  agent->setInitialState(AgentState{});
+  auto& sensor = static_cast<esp::sensor::CameraSensor&>(
+      *agent->getSensorSuite().get("color"));
+
+  auto read = [&]() {
+    CORRADE_VERIFY(simulator->drawObservation(0, "color"));
+    Observation observation;
+    sensor.readObservationFrom(sensor.renderTarget(), observation);
+    return observation;
+  };
+  auto contents = [](const Observation& observation) {
+    return std::vector<uint8_t>(observation.buffer->data.begin(),
+                                observation.buffer->data.end());
+  };
+
+  const Observation first = read();
+  const std::vector<uint8_t> firstContents = contents(first);
+
+  // the next reads, of another view, go to the other buffers of the ring
+  sensor.node().rotateYLocal(Mn::Deg(90.0f));
+  const Observation second = read();
+  const Observation third = read();
+  CORRADE_VERIFY(second.buffer != first.buffer);
+  CORRADE_VERIFY(third.buffer != first.buffer);
+  CORRADE_VERIFY(third.buffer != second.buffer);
+  const std::vector<uint8_t> rotatedContents = contents(second);
+  CORRADE_VERIFY(rotatedContents != firstContents);
+  CORRADE_VERIFY(contents(third) == rotatedContents);
+  // the first observation is still valid
+  CORRADE_VERIFY(contents(first) == firstContents);
+
+  // after as many reads as there are buffers, the first one is reused
+  const Observation fourth = read();
+  CORRADE_VERIFY(fourth.buffer == first.buffer);
+  CORRADE_VERIFY(contents(first) == rotatedContents);
+  CORRADE_VERIFY(contents(second) == rotatedContents);
+  CORRADE_VERIFY(read().buffer == second.buffer);
+}
+
 }  // namespace
 
+void SimTest::renderTopDownMap() {
+  Simulator::uptr simulator = getSimulator(vangogh);
+  PathFinder::ptr pathfinder = simulator->getPathFinder();
+  CORRADE_VERIFY(pathfinder->isLoaded());
+  const float height = pathfinder->bounds().first[1];
+  const float metersPerPixel = 0.05f;
+
+  // tiles that don't divide the grid give the map of a single tile
+  const esp::sim::TopDownMap map = simulator->renderTopDownMap(
+      metersPerPixel, height - 0.5f, height + 2.0f, 48);
+  const esp::sim::TopDownMap single = simulator->renderTopDownMap(
+      metersPerPixel, height - 0.5f, height + 2.0f, 4096);
+  CORRADE_COMPARE(map.metersPerPixel, metersPerPixel);
+  CORRADE_VERIFY(map.occupancy.rows() > 48 || map.occupancy.cols() > 48);
+  CORRADE_VERIFY(map.occupancy == single.occupancy);
+  CORRADE_VERIFY(map.semanticIds == single.semanticIds);
+  CORRADE_COMPARE(map.origin, single.origin);
+
+  // the rasterized navmesh matches its sampled view, but along its edges
+  const auto view = pathfinder->getTopDownView(metersPerPixel, height);
+  CORRADE_COMPARE(view.rows(), map.occupancy.rows());
+  CORRADE_COMPARE(view.cols(), map.occupancy.cols());
+  const auto different = (view.array() != map.occupancy.array()).count();
+  CORRADE_COMPARE_AS(different, view.size() / 20, Cr::TestSuite::Compare::Less);
+
+  // the floor is seen under the navmesh, within the slab
+  const Eigen::ArrayXXf heights = map.heights.array();
+  CORRADE_VERIFY(((heights >= height - 0.5f && heights <= height + 2.0f) ||
+                  !map.occupancy.array())
+                     .all());
+}
+
 CORRADE_TEST_MAIN(SimTest)
@@ -2,9 +2,31 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/ConfigurationGroup.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/Sha1.h>
+#include <Corrade/Utility/String.h>
+#include <Magnum/Math/FunctionsBatch.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Trade/AbstractImageConverter.h>
+#include <Magnum/Trade/AbstractImporter.h>
+#include <Magnum/Trade/ImageData.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "SceneLoader.h"
 
@@ -12,20 +34,40 @@
 #include <tiny_obj_loader.h>
 
 #include "esp/assets/Mp3dInstanceMeshData.h"
+#include "esp/assets/SceneBundle.h"
+#include "esp/core/ThreadPool.h"
 #include "esp/core/esp.h"
+#include "esp/geo/VoxelGrid.h"
+#include "esp/metadata/DatasetIndex.h"
+#include "esp/metadata/MetadataMediator.h"
+#ifdef ESP_BUILD_PTEX_SUPPORT
+#include "esp/assets/PTexMeshData.h"
+#endif
 #include "esp/nav/PathFinder.h"
 #include "esp/scene/SemanticScene.h"
+#ifdef ESP_BUILD_WITH_BULLET
+#include "esp/physics/bullet/BulletConvexDecomposition.h"
+#endif
 
 using namespace esp::assets;
 using namespace esp::scene;
 using namespace esp::nav;
 
-int createNavMesh(const std::string& meshFile, const std::string& navmeshFile) {
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+extern char** environ;
+
+int createNavMesh(const std::string& meshFile,
+                  const std::string& navmeshFile,
+                  const int tileSize) {
   SceneLoader loader;
   const AssetInfo info = AssetInfo::fromPath(meshFile);
   const MeshData mesh = loader.load(info);
   NavMeshSettings bs;
   bs.setDefaults();
+  // tiles are built in parallel
+  bs.tileSize = tileSize;
   PathFinder pf;
   if (!pf.build(bs, mesh)) {
     LOG(ERROR) << "Failed to build navmesh";
@@ -62,61 +104,69 @@ int createGibsonSemanticMesh(const std::string& objFile,
     return 1;
   }
 
-  std::ifstream file(idsFile, std::ios::binary | std::ios::ate);
-  std::streamsize size = file.tellg();
-  file.seekg(0, std::ios::beg);
-
-  std::vector<unsigned short> objectId(size / sizeof(short));
-  file.read(reinterpret_cast<char*>(objectId.data()), size);
-  if (!file) {
+  // one read of the whole file
+  const Cr::Containers::Array<char> ids = Cr::Utility::Directory::read(idsFile);
+  const size_t numFaces = shapes[0].mesh.num_face_vertices.size();
+  if (ids.size() < numFaces * sizeof(unsigned short)) {
     LOG(ERROR) << "Failed to load " << idsFile;
     return 2;
   }
+  const auto* objectId = reinterpret_cast<const unsigned short*>(ids.data());
 
   size_t numVerts = attrib.vertices.size() / 3;
 
-  std::ofstream f(semMeshFile, std::ios::out | std::ios::binary);
-  f << "ply" << std::endl;
-  f << "format binary_little_endian 1.0" << std::endl;
-  f << "element vertex " << numVerts << std::endl;
-  f << "property float x" << std::endl;
-  f << "property float y" << std::endl;
-  f << "property float z" << std::endl;
-  f << "property uchar red" << std::endl;
-  f << "property uchar green" << std::endl;
-  f << "property uchar blue" << std::endl;
-  f << "element face " << shapes[0].mesh.num_face_vertices.size() << std::endl;
-  f << "property list uchar int vertex_indices" << std::endl;
-  f << "property ushort object_id" << std::endl;
-  f << "end_header" << std::endl;
+  // The whole file is assembled in memory and written at once
+  std::ostringstream header;
+  header << "ply\n"
+         << "format binary_little_endian 1.0\n"
+         << "element vertex " << numVerts << "\n"
+         << "property float x\n"
+         << "property float y\n"
+         << "property float z\n"
+         << "property uchar red\n"
+         << "property uchar green\n"
+         << "property uchar blue\n"
+         << "element face " << numFaces << "\n"
+         << "property list uchar int vertex_indices\n"
+         << "property ushort object_id\n"
+         << "end_header\n";
+  std::string data = header.str();
+  data.reserve(data.size() + numVerts * (sizeof(float) * 3 + 3) +
+               shapes[0].mesh.indices.size() * sizeof(int) +
+               numFaces * (1 + sizeof(unsigned short)));
+  const auto append = [&data](const void* bytes, size_t size) {
+    data.append(static_cast<const char*>(bytes), size);
+  };
 
   // We need to rotate to match .glb where -Z is gravity
   const auto transform =
       esp::quatf::FromTwoVectors(esp::vec3f::UnitY(), esp::vec3f::UnitZ());
   for (size_t i = 0; i < numVerts; i++) {
-    unsigned char gray[] = {0x80, 0x80, 0x80};
+    const unsigned char gray[] = {0x80, 0x80, 0x80};
     float* components = &attrib.vertices[i * 3];
     Eigen::Map<esp::vec3f> vertex{components};
     vertex = transform * vertex;
-    f.write(reinterpret_cast<char*>(components), sizeof(float) * 3);
-    f.write(reinterpret_cast<char*>(gray), sizeof(gray));
+    append(components, sizeof(float) * 3);
+    append(gray, sizeof(gray));
   }
 
   size_t index_offset = 0;
-  for (size_t i = 0; i < shapes[0].mesh.num_face_vertices.size(); i++) {
+  for (size_t i = 0; i < numFaces; i++) {
     unsigned char fv = shapes[0].mesh.num_face_vertices[i];
-    f.put(fv);
+    data += char(fv);
 
     for (size_t j = 0; j < fv; j++) {
       tinyobj::index_t idx = shapes[0].mesh.indices[index_offset + j];
-      f.write(reinterpret_cast<char*>(&idx.vertex_index),
-              sizeof(idx.vertex_index));
+      append(&idx.vertex_index, sizeof(idx.vertex_index));
     }
     index_offset += fv;
-    f.write(reinterpret_cast<char*>(&objectId[i]), sizeof(objectId[i]));
+    append(&objectId[i], sizeof(objectId[i]));
   }
 
-  f.close();
+  if (!Cr::Utility::Directory::writeString(semMeshFile, data)) {
+    LOG(ERROR) << "Failed to save " << semMeshFile;
+    return 3;
+  }
 
   return 0;
 }
@@ -150,35 +200,366 @@ int createMp3dSemanticMesh(const std::string& plyFile,
   return 0;
 }
 
-int main(int argc, char** argv) {
-  if (argc < 4) {
-    std::cout << "Usage: datatool task input_file output_file" << std::endl;
+int convertTexturesToBasis(const std::string& inputDir,
+                           const std::string& outputDir) {
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImporter> importerManager;
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImageConverter>
+      converterManager;
+  std::unique_ptr<Mn::Trade::AbstractImporter> importer =
+      importerManager.loadAndInstantiate("AnyImageImporter");
+  std::unique_ptr<Mn::Trade::AbstractImageConverter> converter =
+      converterManager.loadAndInstantiate("BasisImageConverter");
+  if (!importer || !converter) {
+    LOG(ERROR) << "The AnyImageImporter and BasisImageConverter plugins are "
+                  "needed, the latter is built only with the Basis Universal "
+                  "encoder";
+    return 1;
+  }
+  // the full mip chain, so the textures need no mip generation on load
+  converter->configuration().setValue("mip_gen", true);
+
+  if (!Cr::Utility::Directory::mkpath(outputDir)) {
+    LOG(ERROR) << "Cannot create " << outputDir;
+    return 2;
+  }
+
+  int numConverted = 0;
+  int numFailed = 0;
+  for (const std::string& filename : Cr::Utility::Directory::list(
+           inputDir, Cr::Utility::Directory::Flag::SkipDirectories |
+                         Cr::Utility::Directory::Flag::SortAscending)) {
+    const std::string extension = Cr::Utility::String::lowercase(
+        Cr::Utility::Directory::splitExtension(filename).second);
+    if (extension != ".png" && extension != ".jpg" && extension != ".jpeg" &&
+        extension != ".tga" && extension != ".bmp") {
+      continue;
+    }
+
+    const std::string input = Cr::Utility::Directory::join(inputDir, filename);
+    const std::string output = Cr::Utility::Directory::join(
+        outputDir,
+        Cr::Utility::Directory::splitExtension(filename).first + ".basis");
+    Cr::Containers::Optional<Mn::Trade::ImageData2D> image;
+    if (!importer->openFile(input) || !(image = importer->image2D(0)) ||
+        !converter->exportToFile(*image, output)) {
+      LOG(ERROR) << "Failed converting " << input;
+      ++numFailed;
+      continue;
+    }
+    ++numConverted;
+  }
+
+  LOG(INFO) << "Converted " << numConverted << " textures to " << outputDir;
+  return numFailed ? 3 : 0;
+}
+
+int createConvexDecomposition(const std::string& meshFile,
+                              const std::string& hullsFile) {
+#ifdef ESP_BUILD_WITH_BULLET
+  SceneLoader loader;
+  const MeshData mesh = loader.load(AssetInfo::fromPath(meshFile));
+  std::vector<Mn::Vector3> positions;
+  positions.reserve(mesh.vbo.size());
+  for (const esp::vec3f& v : mesh.vbo) {
+    positions.emplace_back(v[0], v[1], v[2]);
+  }
+  const std::vector<Mn::UnsignedInt> indices{mesh.ibo.begin(), mesh.ibo.end()};
+  const esp::physics::ConvexDecomposition hulls =
+      esp::physics::decomposeConvex(positions, indices);
+  if (hulls.empty()) {
+    LOG(ERROR) << "Failed to decompose " << meshFile;
+    return 2;
+  }
+  if (!esp::physics::saveConvexDecomposition(hulls, hullsFile)) {
+    LOG(ERROR) << "Failed to save " << hullsFile;
+    return 3;
+  }
+  LOG(INFO) << "Decomposed " << meshFile << " into " << hulls.size()
+            << " hulls";
+  return 0;
+#else
+  LOG(ERROR) << "Convex decompositions need Bullet. Build with Bullet "
+                "support to create them.";
+  return 1;
+#endif
+}
+
+int createVoxelGrid(const std::string& meshFile,
+                    const std::string& voxelsFile,
+                    const float voxelSize) {
+  if (!(voxelSize > 0.0f)) {
+    LOG(ERROR) << "Expected a positive voxel size, got " << voxelSize;
     return 64;
   }
-  const std::string task = argv[1];
+  SceneLoader loader;
+  const MeshData mesh = loader.load(AssetInfo::fromPath(meshFile));
+  std::vector<Mn::Vector3> positions;
+  positions.reserve(mesh.vbo.size());
+  for (const esp::vec3f& v : mesh.vbo) {
+    positions.emplace_back(v[0], v[1], v[2]);
+  }
+  if (positions.empty()) {
+    LOG(ERROR) << "Failed to load " << meshFile;
+    return 2;
+  }
+  esp::geo::VoxelGrid grid = esp::geo::VoxelGrid::covering(
+      Mn::Range3D{Mn::Math::minmax(positions)}, voxelSize);
+  // a single mesh has no semantic ids, every voxel it touches holds 0
+  esp::geo::voxelizeTriangles(grid, positions,
+                              {mesh.ibo.data(), mesh.ibo.size()},
+                              Mn::Matrix4{}, 0);
+  if (!esp::geo::saveVoxelGrid(grid, voxelsFile)) {
+    LOG(ERROR) << "Failed to save " << voxelsFile;
+    return 3;
+  }
+  LOG(INFO) << "Voxelized " << meshFile << " into " << grid.numOccupied()
+            << " of " << grid.voxels.size() << " voxels";
+  return 0;
+}
+
+int rebuildDatasetIndex(const std::string& datasetFile) {
+  // what changed since the previous index, if any, for the log
+  esp::metadata::DatasetIndex previous;
+  if (previous.load(esp::metadata::DatasetIndex::filenameFor(datasetFile))) {
+    for (const std::string& config : previous.changedConfigs()) {
+      LOG(INFO) << "Changed since the previous index: " << config;
+    }
+  }
+  esp::metadata::MetadataMediator mediator;
+  if (!mediator.buildDatasetIndex(datasetFile)) {
+    LOG(ERROR) << "Failed to build the index of " << datasetFile;
+    return 2;
+  }
+  return 0;
+}
+
+const char* const usage =
+    "Usage: datatool task input_file output_file\n"
+    "       datatool batch manifest_file [num_workers]";
+
+// Runs a task, args[0] being its name and the others its arguments
+int runTask(const std::vector<std::string>& args) {
+  const std::string& task = args[0];
   if (task == "create_navmesh") {
-    createNavMesh(argv[2], argv[3]);
+    // an optional tile size in voxels, e.g. 64, to build the tiles on all
+    // cores, 0 for a single tile
+    return createNavMesh(args[1], args[2],
+                         args.size() > 3 ? std::stoi(args[3]) : 0);
   } else if (task == "create_mp3d_semantic_mesh") {
-    if (argc < 5) {
+    if (args.size() < 4) {
       std::cout << "Usage: datatool create_mp3d_semantic_mesh input_ply "
                    "input_house output_mesh"
                 << std::endl;
       return 64;
     }
-    createMp3dSemanticMesh(argv[2], argv[3], argv[4]);
+    return createMp3dSemanticMesh(args[1], args[2], args[3]);
   } else if (task == "create_gibson_semantic_mesh") {
-    if (argc < 5) {
+    if (args.size() < 4) {
       std::cout << "Usage: datatool create_gibson_semantic_mesh input_obj "
                    "input_ids output_mesh"
                 << std::endl;
       return 64;
     }
-    createGibsonSemanticMesh(argv[2], argv[3], argv[4]);
-  } else {
-    LOG(ERROR) << "Unrecognized task " << task;
+    return createGibsonSemanticMesh(args[1], args[2], args[3]);
+  } else if (task == "create_convex_decomposition") {
+    // objects using convex decompositions look for the .hulls file next to
+    // their collision asset, with the extension replaced
+    return createConvexDecomposition(args[1], args[2]);
+  } else if (task == "create_voxel_grid") {
+    // an optional voxel size in meters, 0.1 by default; read the grid with
+    // esp::geo::loadVoxelGrid()
+    return createVoxelGrid(args[1], args[2],
+                           args.size() > 3 ? std::stof(args[3]) : 0.1f);
+  } else if (task == "convert_textures_to_basis") {
+    // references to the textures in the scene files are not updated
+    return convertTexturesToBasis(args[1], args[2]);
+  } else if (task == "bake_scene_bundle") {
+    // the navmesh next to the asset is baked too; the bundle is picked up
+    // when it's next to the asset, named as SceneBundle::filenameFor()
+    return esp::assets::SceneBundle::bake(args[1], args[2]) ? 0 : 2;
+  } else if (task == "rebuild_dataset_index") {
+    // the index is written next to the dataset config, named as
+    // DatasetIndex::filenameFor(), args[2] is unused; it is picked up when
+    // the dataset is loaded
+    return rebuildDatasetIndex(args[1]);
+  } else if (task == "convert_ptex_atlases") {
+#ifdef ESP_BUILD_PTEX_SUPPORT
+    // the converted atlases are written to the input folder, args[2] is
+    // unused; they are picked up on load without other changes
+    const int numConverted =
+        esp::assets::PTexMeshData::convertAtlases(args[1]);
+    if (numConverted < 0) {
+      return 2;
+    }
+    LOG(INFO) << "Converted " << numConverted << " atlases in " << args[1];
+    return 0;
+#else
+    LOG(ERROR) << "PTex support not enabled. Enable the BUILD_PTEX_SUPPORT "
+                  "CMake option when building.";
+    return 1;
+#endif
+  } else if (task == "convert_ptex_to_gltf") {
+#ifdef ESP_BUILD_PTEX_SUPPORT
+    // an optional tile resolution, the texels along the side of a face, 0 by
+    // default for the PTex tile size less two; the atlases and the buffer
+    // are written next to the output
+    esp::assets::PTexMeshData mesh;
+    mesh.load(args[1], Cr::Utility::Directory::join(
+                           Cr::Utility::Directory::path(args[1]), "textures"));
+    return mesh.convertToGltf(args[2],
+                              args.size() > 3 ? std::stoi(args[3]) : 0)
+               ? 0
+               : 2;
+#else
+    LOG(ERROR) << "PTex support not enabled. Enable the BUILD_PTEX_SUPPORT "
+                  "CMake option when building.";
     return 1;
+#endif
+  }
+  LOG(ERROR) << "Unrecognized task " << task;
+  return 1;
+}
+
+// The arguments of a task which are its input files or folders, and the one
+// which is its output. A negative output if the task writes to its input.
+struct TaskFiles {
+  std::vector<std::size_t> inputs;
+  int output;
+};
+
+TaskFiles taskFiles(const std::string& task) {
+  if (task == "create_mp3d_semantic_mesh" ||
+      task == "create_gibson_semantic_mesh")
+    return {{1, 2}, 3};
+  if (task == "convert_ptex_atlases" || task == "rebuild_dataset_index")
+    return {{1}, -1};
+  return {{1}, 2};
+}
+
+// Hash of the task, its arguments and the contents of its inputs, what its
+// output is up to date with
+std::string hashTask(const std::vector<std::string>& args,
+                     const TaskFiles& files) {
+  Cr::Utility::Sha1 sha1;
+  for (const std::string& arg : args)
+    sha1 << arg << std::string(1, '\0');
+  for (const std::size_t input : files.inputs) {
+    const std::string& path = args[input];
+    // the files of a folder, as convert_textures_to_basis doesn't recurse
+    std::vector<std::string> filenames;
+    if (Cr::Utility::Directory::isDirectory(path)) {
+      for (const std::string& name : Cr::Utility::Directory::list(
+               path, Cr::Utility::Directory::Flag::SkipDirectories |
+                         Cr::Utility::Directory::Flag::SortAscending))
+        filenames.push_back(Cr::Utility::Directory::join(path, name));
+    } else {
+      filenames.push_back(path);
+    }
+    for (const std::string& filename : filenames) {
+      const Cr::Containers::Array<char> data =
+          Cr::Utility::Directory::read(filename);
+      sha1 << filename << std::string(1, '\0');
+      sha1 << Cr::Containers::ArrayView<const char>{data};
+    }
   }
+  return sha1.digest().hexString();
+}
+
+// Runs a task in a child process, so that tasks can't interfere through
+// plugins or global state
+int spawnTask(const std::vector<std::string>& args) {
+  const std::string executable = Cr::Utility::Directory::executableLocation();
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(executable.c_str()));
+  for (const std::string& arg : args)
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
 
+  pid_t pid;
+  if (posix_spawn(&pid, executable.c_str(), nullptr, nullptr, argv.data(),
+                  environ) != 0) {
+    LOG(ERROR) << "Cannot spawn " << executable;
+    return 1;
+  }
+  int status;
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+    return 1;
+  return WEXITSTATUS(status);
+}
+
+// Runs the tasks of a manifest, one per line with the arguments of a single
+// task, e.g. "create_navmesh scene.glb scene.navmesh". Lines starting with #
+// are comments. The tasks whose output exists and is up to date with the
+// hash of their inputs, stored next to the output with a .sha1 suffix, are
+// skipped.
+int runBatch(const std::string& manifestFile, const int numWorkers) {
+  std::ifstream manifest{manifestFile};
+  if (!manifest) {
+    LOG(ERROR) << "Cannot open " << manifestFile;
+    return 1;
+  }
+  std::vector<std::vector<std::string>> tasks;
+  for (std::string line; std::getline(manifest, line);) {
+    std::vector<std::string> args =
+        Cr::Utility::String::splitWithoutEmptyParts(line);
+    if (args.empty() || args[0][0] == '#')
+      continue;
+    const TaskFiles files = taskFiles(args[0]);
+    if (int(args.size()) <= std::max(files.output, 2)) {
+      LOG(ERROR) << "Missing arguments in the manifest line: " << line;
+      return 64;
+    }
+    tasks.push_back(std::move(args));
+  }
+
+  // the tasks run in child processes, these threads only wait for them
+  const std::size_t maxWorkers =
+      numWorkers > 0 ? numWorkers : std::thread::hardware_concurrency();
+  esp::core::ThreadPool pool{std::max<std::size_t>(maxWorkers, 2) - 1};
+  std::atomic<int> numSkipped{0}, numFailed{0};
+  pool.parallelFor(
+      tasks.size(), maxWorkers, [&](std::size_t index, std::size_t) {
+        const std::vector<std::string>& args = tasks[index];
+        const TaskFiles files = taskFiles(args[0]);
+        std::string hash, hashFile;
+        if (files.output >= 0) {
+          hash = hashTask(args, files);
+          hashFile = args[files.output] + ".sha1";
+          if (Cr::Utility::Directory::exists(args[files.output]) &&
+              Cr::Utility::Directory::readString(hashFile) == hash) {
+            ++numSkipped;
+            return;
+          }
+        }
+        LOG(INFO) << "Running " << Cr::Utility::String::join(args, ' ');
+        if (spawnTask(args) != 0) {
+          LOG(ERROR) << "Failed: " << Cr::Utility::String::join(args, ' ');
+          ++numFailed;
+          return;
+        }
+        if (files.output >= 0)
+          Cr::Utility::Directory::writeString(hashFile, hash);
+      });
+
+  LOG(INFO) << "Ran " << tasks.size() - numSkipped - numFailed << " tasks, "
+            << numSkipped << " up to date, " << numFailed << " failed";
+  return numFailed ? 2 : 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3 || (argc < 4 && std::string{argv[1]} != "batch")) {
+    std::cout << usage << std::endl;
+    return 64;
+  }
+  const std::string task = argv[1];
+  if (task == "batch") {
+    return runBatch(argv[2], argc > 3 ? std::stoi(argv[3]) : 0);
+  }
+
+  const int status = runTask({argv + 1, argv + argc});
+  if (status != 0) {
+    return status;
+  }
   LOG(INFO) << "task: \"" << task << "\" done";
   return 0;
 }
@@ -0,0 +1,218 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Renders gfx replay files offline, e.g. episodes recorded without sensors,
+// to image sequences. Each GPU renders whole files with its own Simulator, and
+// the render assets stay loaded from one file to the next.
+
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
+#include <Corrade/Utility/String.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Trade/AbstractImageConverter.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "esp/agent/Agent.h"
+#include "esp/core/esp.h"
+#include "esp/gfx/replay/Player.h"
+#include "esp/gfx/replay/ReplayManager.h"
+#include "esp/sensor/Sensor.h"
+#include "esp/sim/Simulator.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace {
+
+const std::string cameraUuid = "replay_camera";
+
+struct Options {
+  // user transforms the cameras are placed at
+  std::vector<std::string> cameras;
+  std::string outputDir;
+  int width;
+  int height;
+  std::string hfov;
+  int frameStride;
+};
+
+// Renders every frame of a replay from every camera, returns whether all the
+// images could be written
+bool renderReplay(esp::sim::Simulator& sim,
+                  Mn::Trade::AbstractImageConverter& converter,
+                  const std::string& replay,
+                  const Options& options) {
+  auto player = sim.getGfxReplayManager()->readKeyframesFromFile(replay);
+  if (!player) {
+    return false;
+  }
+
+  const std::string name = Cr::Utility::Directory::splitExtension(
+                               Cr::Utility::Directory::filename(replay))
+                               .first;
+  const std::string outputDir =
+      Cr::Utility::Directory::join(options.outputDir, name);
+  if (!Cr::Utility::Directory::mkpath(outputDir)) {
+    LOG(ERROR) << "Cannot create " << outputDir;
+    return false;
+  }
+
+  esp::agent::Agent::ptr agent = sim.getAgent(0);
+  bool ok = true;
+  int numMissing = 0;
+  for (int frame = 0; frame < player->getNumKeyframes();
+       frame += options.frameStride) {
+    player->setKeyframeIndex(frame);
+    for (const std::string& camera : options.cameras) {
+      Mn::Vector3 translation;
+      Mn::Quaternion rotation;
+      if (!player->getUserTransform(camera, &translation, &rotation)) {
+        ++numMissing;
+        continue;
+      }
+      agent->node().setTranslation(translation);
+      agent->node().setRotation(rotation);
+
+      esp::sensor::Observation observation;
+      if (!sim.getAgentObservation(0, cameraUuid, observation)) {
+        LOG(ERROR) << "Failed to render frame " << frame << " of " << replay;
+        ok = false;
+        continue;
+      }
+      const Mn::ImageView2D image{Mn::PixelFormat::RGBA8Unorm,
+                                  {options.width, options.height},
+                                  observation.buffer->data};
+      const std::string filename = Cr::Utility::Directory::join(
+          outputDir, Cr::Utility::formatString("{}_{:.5}.png", camera, frame));
+      ok = converter.exportToFile(image, filename) && ok;
+    }
+  }
+  if (numMissing) {
+    LOG(WARNING) << numMissing << " camera frames of " << replay
+                 << " have no user transform for the camera";
+  }
+  // delete the instances, the assets stay loaded for the next replay
+  player->setKeyframeIndex(-1);
+  return ok;
+}
+
+// Renders the replays taken from next on a GPU until there are none left,
+// returns the number of replays that failed
+int renderOnGpu(const int gpu,
+                const std::vector<std::string>& replays,
+                std::atomic<std::size_t>& next,
+                const Options& options) {
+  esp::sim::SimulatorConfiguration simConfig;
+  simConfig.activeSceneID = esp::assets::EMPTY_SCENE;
+  simConfig.gpuDeviceId = gpu;
+  simConfig.requiresTextures = true;
+  esp::sim::Simulator sim(simConfig);
+
+  auto cameraSpec = esp::sensor::SensorSpec::create();
+  cameraSpec->uuid = cameraUuid;
+  cameraSpec->sensorSubType = esp::sensor::SensorSubType::Pinhole;
+  cameraSpec->sensorType = esp::sensor::SensorType::Color;
+  // the agent is placed at the camera transforms
+  cameraSpec->position = {0.0f, 0.0f, 0.0f};
+  cameraSpec->resolution = {options.height, options.width};
+  cameraSpec->parameters["hfov"] = options.hfov;
+  esp::agent::AgentConfiguration agentConfig;
+  agentConfig.sensorSpecifications = {cameraSpec};
+  sim.addAgent(agentConfig);
+
+  Cr::PluginManager::Manager<Mn::Trade::AbstractImageConverter>
+      converterManager;
+  std::unique_ptr<Mn::Trade::AbstractImageConverter> converter =
+      converterManager.loadAndInstantiate("AnyImageConverter");
+  if (!converter) {
+    LOG(ERROR) << "The AnyImageConverter plugin is needed";
+    return replays.size();
+  }
+
+  int numFailed = 0;
+  for (std::size_t i = next++; i < replays.size(); i = next++) {
+    LOG(INFO) << "GPU " << gpu << " rendering " << replays[i];
+    numFailed += !renderReplay(sim, *converter, replays[i], options);
+  }
+  return numFailed;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Cr::Utility::Arguments args;
+  args.addArrayArgument("replays")
+      .setHelp("replays", "gfx replay files, JSON or streamed")
+      .addOption("cameras", "camera")
+      .setHelp("cameras",
+               "comma-separated names of the user transforms to render from")
+      .addOption("output-dir", ".")
+      .setHelp("output-dir",
+               "where the images are written, in a folder per replay")
+      .addOption("width", "512")
+      .addOption("height", "512")
+      .addOption("hfov", "90")
+      .setHelp("hfov", "horizontal field of view, in degrees")
+      .addOption("frame-stride", "1")
+      .setHelp("frame-stride", "render every n-th keyframe")
+      .addOption("gpus", "0")
+      .setHelp("gpus", "comma-separated GPU device ids to render on")
+      .setGlobalHelp(
+          "Renders the keyframes of gfx replays from the user transforms of "
+          "cameras to PNG sequences, in parallel across GPUs.")
+      .parse(argc, argv);
+
+  Options options;
+  options.cameras =
+      Cr::Utility::String::splitWithoutEmptyParts(args.value("cameras"), ',');
+  options.outputDir = args.value("output-dir");
+  options.width = args.value<int>("width");
+  options.height = args.value<int>("height");
+  options.hfov = args.value("hfov");
+  options.frameStride = std::max(1, args.value<int>("frame-stride"));
+
+  std::vector<std::string> replays;
+  for (std::size_t i = 0; i < args.arrayValueCount("replays"); ++i) {
+    replays.push_back(args.arrayValue("replays", i));
+  }
+  std::vector<int> gpus;
+  for (const std::string& gpu :
+       Cr::Utility::String::splitWithoutEmptyParts(args.value("gpus"), ',')) {
+    gpus.push_back(std::stoi(gpu));
+  }
+  if (options.cameras.empty() || gpus.empty() || options.width <= 0 ||
+      options.height <= 0) {
+    LOG(ERROR) << "Expected at least one camera, one GPU and a positive "
+                  "resolution";
+    return 1;
+  }
+
+  // one Simulator per GPU, each with its own GL context and asset cache
+  std::atomic<std::size_t> next{0};
+  std::vector<int> numFailed(gpus.size(), 0);
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < gpus.size(); ++i) {
+    workers.emplace_back([&, i]() {
+      numFailed[i] = renderOnGpu(gpus[i], replays, next, options);
+    });
+  }
+  int totalFailed = 0;
+  for (std::size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+    totalFailed += numFailed[i];
+  }
+
+  LOG(INFO) << "Rendered " << replays.size() - totalFailed << " of "
+            << replays.size() << " replays";
+  return totalFailed ? 2 : 0;
+}
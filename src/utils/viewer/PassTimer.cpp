@@ -0,0 +1,92 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "PassTimer.h"
+
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Extensions.h>
+#include <utility>
+
+namespace Mn = Magnum;
+
+PassTimer::PassTimer(std::vector<std::string> passNames) {
+#ifndef MAGNUM_TARGET_WEBGL
+  const Mn::GL::Context& context = Mn::GL::Context::current();
+#ifndef MAGNUM_TARGET_GLES
+  hasGpuTimes_ =
+      context.isExtensionSupported<Mn::GL::Extensions::ARB::timer_query>();
+#else
+  hasGpuTimes_ = context.isExtensionSupported<
+      Mn::GL::Extensions::EXT::disjoint_timer_query>();
+#endif
+#endif
+  passes_.resize(passNames.size());
+  for (std::size_t i = 0; i != passNames.size(); ++i) {
+    passes_[i].name = std::move(passNames[i]);
+    passes_[i].cpuHistory.assign(HistorySize, 0.0f);
+    passes_[i].gpuHistory.assign(HistorySize, 0.0f);
+  }
+}
+
+void PassTimer::push(std::vector<float>& history, const float value) {
+  history.erase(history.begin());
+  history.push_back(value);
+}
+
+void PassTimer::beginFrame() {
+  slot_ = frame_ % FramesInFlight;
+  for (Pass& pass : passes_) {
+    if (frame_ > 0) {
+      push(pass.cpuHistory, pass.cpuMs);
+      pass.cpuMs = 0.0f;
+    }
+#ifndef MAGNUM_TARGET_WEBGL
+    Queries& queries = pass.queries[slot_];
+    float gpuMs = 0.0f;
+    // dropped rather than waited for if the GPU is that far behind
+    if (queries.issued && queries.end.resultAvailable()) {
+      gpuMs = float(queries.end.result<Mn::UnsignedLong>() -
+                    queries.begin.result<Mn::UnsignedLong>()) /
+              1.0e6f;
+    }
+    queries.issued = false;
+    if (hasGpuTimes_ && frame_ >= FramesInFlight) {
+      push(pass.gpuHistory, gpuMs);
+    }
+#endif
+  }
+  ++frame_;
+}
+
+void PassTimer::begin(const std::size_t pass) {
+  CORRADE_ASSERT(pass < passes_.size(),
+                 "PassTimer::begin(): the pass" << pass << "is out of range", );
+  passes_[pass].cpuBegin = Clock::now();
+#ifndef MAGNUM_TARGET_WEBGL
+  if (hasGpuTimes_) {
+    Queries& queries = passes_[pass].queries[slot_];
+    if (!queries.begin.id()) {
+      queries.begin = Mn::GL::TimeQuery{Mn::GL::TimeQuery::Target::Timestamp};
+      queries.end = Mn::GL::TimeQuery{Mn::GL::TimeQuery::Target::Timestamp};
+    }
+    queries.begin.timestamp();
+  }
+#endif
+}
+
+void PassTimer::end(const std::size_t pass) {
+  CORRADE_ASSERT(pass < passes_.size(),
+                 "PassTimer::end(): the pass" << pass << "is out of range", );
+  Pass& timed = passes_[pass];
+  timed.cpuMs += std::chrono::duration<float, std::milli>(Clock::now() -
+                                                          timed.cpuBegin)
+                     .count();
+#ifndef MAGNUM_TARGET_WEBGL
+  if (hasGpuTimes_) {
+    timed.queries[slot_].end.timestamp();
+    timed.queries[slot_].issued = true;
+  }
+#endif
+}
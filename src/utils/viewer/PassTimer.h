@@ -0,0 +1,102 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_UTILS_VIEWER_PASSTIMER_H_
+#define ESP_UTILS_VIEWER_PASSTIMER_H_
+
+#include <Magnum/GL/TimeQuery.h>
+#include <Magnum/Magnum.h>
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The CPU and GPU durations of the passes of a frame, e.g. the scene
+ * draw, the object picking pass and its readback, with their history
+ *
+ * The GPU durations are measured with timestamp queries, which unlike the
+ * elapsed time query of @ref Magnum::DebugTools::GLFrameProfiler may overlap
+ * it. The queries of a frame are read @ref FramesInFlight frames later, when
+ * the GPU has long finished it, so that measuring doesn't stall the
+ * pipeline. Without timestamp queries, e.g. on WebGL, only the CPU
+ * durations are measured.
+ */
+class PassTimer {
+ public:
+  enum : std::size_t {
+    //! frames between issuing the queries and reading them
+    FramesInFlight = 3,
+    //! frames kept in the history of each pass
+    HistorySize = 120,
+  };
+
+  /**
+   * @brief Constructor
+   * @param passNames the names of the passes, indexed by the pass of
+   * @ref begin()
+   */
+  explicit PassTimer(std::vector<std::string> passNames);
+
+  /** @brief Whether the GPU durations are measured */
+  bool hasGpuTimes() const { return hasGpuTimes_; }
+
+  /** @brief Start a frame, reading the queries of an earlier one */
+  void beginFrame();
+
+  /** @brief Start timing @p pass, at most once per frame */
+  void begin(std::size_t pass);
+
+  /** @brief Stop timing @p pass */
+  void end(std::size_t pass);
+
+  /** @brief The number of passes */
+  std::size_t numPasses() const { return passes_.size(); }
+
+  /** @brief The name of @p pass */
+  const std::string& name(std::size_t pass) const {
+    return passes_[pass].name;
+  }
+
+  /**
+   * @brief The CPU, or GPU, durations of @p pass, in milliseconds, oldest
+   * first, 0 in frames it didn't run in
+   */
+  const std::vector<float>& cpuHistory(std::size_t pass) const {
+    return passes_[pass].cpuHistory;
+  }
+  const std::vector<float>& gpuHistory(std::size_t pass) const {
+    return passes_[pass].gpuHistory;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Queries {
+    Magnum::GL::TimeQuery begin{Magnum::NoCreate};
+    Magnum::GL::TimeQuery end{Magnum::NoCreate};
+    bool issued = false;
+  };
+
+  struct Pass {
+    std::string name;
+    std::array<Queries, FramesInFlight> queries;
+    Clock::time_point cpuBegin;
+    //! the CPU duration in the current frame
+    float cpuMs = 0.0f;
+    std::vector<float> cpuHistory;
+    std::vector<float> gpuHistory;
+  };
+
+  // shifts a new sample into history
+  static void push(std::vector<float>& history, float value);
+
+  std::vector<Pass> passes_;
+  std::size_t frame_ = 0;
+  //! the queries of the current frame
+  std::size_t slot_ = 0;
+  bool hasGpuTimes_ = false;
+};
+
+#endif  // ESP_UTILS_VIEWER_PASSTIMER_H_
@@ -4,6 +4,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <cfloat>
 #include <ctime>
 
 #include <Magnum/configure.h>
@@ -35,6 +36,7 @@
 #include <Corrade/Utility/Debug.h>
 #include <Corrade/Utility/DebugStl.h>
 #include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/FormatStl.h>
 #include <Corrade/Utility/String.h>
 #include <Magnum/DebugTools/FrameProfiler.h>
 #include <Magnum/DebugTools/Screenshot.h>
@@ -42,6 +44,7 @@
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
 #include <sophus/so3.hpp>
+#include "esp/core/PerfStats.h"
 #include "esp/core/Utility.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/Drawable.h"
@@ -51,6 +54,7 @@
 #include "esp/sim/Simulator.h"
 
 #include "ObjectPickingHelper.h"
+#include "PassTimer.h"
 #include "esp/physics/configure.h"
 
 constexpr float moveSensitivity = 0.07f;
@@ -190,7 +194,7 @@ Key Commands:
   '5' switch ortho/perspective camera.
   '6' reset ortho camera zoom/perspective camera FOV.
   'e' enable/disable frustum culling.
-  'c' show/hide FPS overlay.
+  'c' show/hide FPS overlay, with the CPU and GPU times of the passes.
   'n' show/hide NavMesh wireframe.
   'i' Save a screenshot to "./screenshots/year_month_day_hour-minute-second/#.png"
 
@@ -334,6 +338,19 @@ Key Commands:
   // included)
 
   Mn::DebugTools::GLFrameProfiler profiler_{};
+
+  // the passes of the per-frame breakdown of the overlay
+  enum Pass : std::size_t {
+    ScenePass,
+    DebugDrawPass,
+    PickedObjectPass,
+    ObjectIdPass,
+    ReadbackPass,
+    BlitPass,
+    ImGuiPass,
+  };
+  std::unique_ptr<PassTimer> passTimer_;
+  void drawPassTimes();
 };
 
 Viewer::Viewer(const Arguments& arguments)
@@ -409,6 +426,8 @@ Viewer::Viewer(const Arguments& arguments)
   simConfig.activeSceneID = sceneFileName;
   simConfig.enablePhysics = useBullet;
   simConfig.frustumCulling = true;
+  // the culling time of the overlay
+  simConfig.enablePerfStats = showFPS_;
   simConfig.requiresTextures = true;
   if (args.isSet("stage-requires-lighting")) {
     Mn::Debug{} << "Stage using DEFAULT_LIGHTING_KEY";
@@ -527,6 +546,9 @@ Viewer::Viewer(const Arguments& arguments)
 #endif
 
   profiler_.setup(profilerValues, 50);
+  passTimer_ = std::make_unique<PassTimer>(std::vector<std::string>{
+      "scene", "debug draw", "picked object", "object ids", "readback", "blit",
+      "imgui"});
 
   printHelpText();
 }  // end Viewer::Viewer
@@ -694,9 +716,25 @@ void Viewer::wiggleLastObject() {
                              existingObjectIDs.back());
 }
 
+void Viewer::drawPassTimes() {
+  for (std::size_t pass = 0; pass != passTimer_->numPasses(); ++pass) {
+    const std::vector<float>& cpu = passTimer_->cpuHistory(pass);
+    const std::vector<float>& gpu = passTimer_->gpuHistory(pass);
+    const std::string overlay = Cr::Utility::formatString(
+        "{}: cpu {:.2f} ms, gpu {:.2f} ms", passTimer_->name(pass), cpu.back(),
+        gpu.back());
+    // the GPU durations, or the CPU ones if there are no timer queries
+    const std::vector<float>& plotted = passTimer_->hasGpuTimes() ? gpu : cpu;
+    ImGui::PlotLines(("##" + passTimer_->name(pass)).c_str(), plotted.data(),
+                     int(plotted.size()), 0, overlay.c_str(), 0.0f, FLT_MAX,
+                     ImVec2(360, 36));
+  }
+}
+
 float timeSinceLastSimulation = 0.0;
 void Viewer::drawEvent() {
   profiler_.beginFrame();
+  passTimer_->beginFrame();
   Mn::GL::defaultFramebuffer.clear(Mn::GL::FramebufferClear::Color |
                                    Mn::GL::FramebufferClear::Depth);
 
@@ -725,7 +763,9 @@ void Viewer::drawEvent() {
   // ONLY draw the content to the frame buffer but not immediately blit the
   // result to the default main buffer
   // (this is the reason we do not call displayObservation)
+  passTimer_->begin(ScenePass);
   simulator_->drawObservation(defaultAgentId_, "rgba_camera");
+  passTimer_->end(ScenePass);
   // TODO: enable other sensors to be displayed
 
   Mn::GL::Renderer::setDepthFunction(
@@ -734,13 +774,18 @@ void Viewer::drawEvent() {
     Mn::Matrix4 camM(renderCamera_->cameraMatrix());
     Mn::Matrix4 projM(renderCamera_->projectionMatrix());
 
+    passTimer_->begin(DebugDrawPass);
     simulator_->physicsDebugDraw(projM * camM);
+    passTimer_->end(DebugDrawPass);
   }
   Mn::GL::Renderer::setDepthFunction(Mn::GL::Renderer::DepthFunction::Less);
   Mn::GL::Renderer::setPolygonOffset(0.0f, 0.0f);
   Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::PolygonOffsetFill);
 
   uint32_t visibles = renderCamera_->getPreviousNumVisibileDrawables();
+  const std::size_t triangles = renderCamera_->getPreviousNumTriangles();
+  const std::size_t stateChanges =
+      renderCamera_->getPreviousNumDrawStateChanges();
 
   esp::gfx::RenderTarget* sensorRenderTarget =
       simulator_->getRenderTarget(defaultAgentId_, "rgba_camera");
@@ -748,6 +793,7 @@ void Viewer::drawEvent() {
                  "Error in Viewer::drawEvent: sensor's rendering target "
                  "cannot be nullptr.", );
   if (objectPickingHelper_->isObjectPicked()) {
+    passTimer_->begin(PickedObjectPass);
     // we need to immediately draw picked object to the SAME frame buffer
     // so bind it first
     // bind the framebuffer
@@ -764,9 +810,12 @@ void Viewer::drawEvent() {
     renderCamera_->draw(objectPickingHelper_->getDrawables(), flags);
 
     Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::Blending);
+    passTimer_->end(PickedObjectPass);
   }
 
+  passTimer_->begin(BlitPass);
   sensorRenderTarget->blitRgbaToDefault();
+  passTimer_->end(BlitPass);
   profiler_.endFrame();
   // Immediately bind the main buffer back so that the "imgui" below can work
   // properly
@@ -783,12 +832,18 @@ void Viewer::drawEvent() {
     uint32_t total = activeSceneGraph_->getDrawables().size();
     ImGui::Text("%u drawables", total);
     ImGui::Text("%u culled", total - visibles);
+    ImGui::Text("%zu triangles, %zu state changes", triangles, stateChanges);
+    ImGui::Text("%.2f ms culling",
+                esp::core::PerfStats::shared()
+                    .get(esp::core::PerfStat::Cull)
+                    .last);
     auto& cam = getAgentCamera();
     ImGui::Text("%s camera",
                 (cam.getCameraType() == esp::sensor::SensorSubType::Orthographic
                      ? "Orthographic"
                      : "Pinhole"));
     ImGui::Text("%s", profiler_.statistics().c_str());
+    drawPassTimes();
     ImGui::End();
   }
 
@@ -799,7 +854,9 @@ void Viewer::drawEvent() {
   Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::FaceCulling);
   Mn::GL::Renderer::disable(Mn::GL::Renderer::Feature::DepthTest);
 
+  passTimer_->begin(ImGuiPass);
   imgui_.drawFrame();
+  passTimer_->end(ImGuiPass);
 
   /* Reset state. Only needed if you want to draw something else with
      different state after. */
@@ -903,13 +960,17 @@ void Viewer::mousePressEvent(MouseEvent& event) {
         esp::gfx::RenderCamera::Flag::UseDrawableIdAsObjectId;
     if (simulator_->isFrustumCullingEnabled())
       flags |= esp::gfx::RenderCamera::Flag::FrustumCulling;
+    passTimer_->begin(ObjectIdPass);
     for (auto& it : activeSceneGraph_->getDrawableGroups()) {
       renderCamera_->draw(it.second, flags);
     }
+    passTimer_->end(ObjectIdPass);
 
     // Read the object Id
+    passTimer_->begin(ReadbackPass);
     unsigned int pickedObject =
         objectPickingHelper_->getObjectId(event.position(), windowSize());
+    passTimer_->end(ReadbackPass);
 
     // if an object is selected, create a visualizer
     createPickedObjectVisualizer(pickedObject);
@@ -1060,6 +1121,7 @@ void Viewer::keyPressEvent(KeyEvent& event) {
     case KeyEvent::Key::C:
       showFPS_ = !showFPS_;
       showFPS_ ? profiler_.enable() : profiler_.disable();
+      esp::core::PerfStats::shared().setEnabled(showFPS_);
       break;
     case KeyEvent::Key::E:
       simulator_->setFrustumCullingEnabled(
@@ -84,6 +84,14 @@ def test_physics_object_attributes():
     assert object_template.bounding_box_collisions == True
     object_template.join_collision_meshes = False
     assert object_template.join_collision_meshes == False
+    object_template.max_hull_vertices = 32
+    assert object_template.max_hull_vertices == 32
+    object_template.use_convex_decomposition = True
+    assert object_template.use_convex_decomposition == True
+    assert object_template.collision_group == 0
+    assert object_template.collision_mask == 0
+    object_template.static_environment_only = True
+    assert object_template.static_environment_only == True
     object_template.requires_lighting = False
     assert object_template.requires_lighting == False
 
@@ -258,3 +258,87 @@ def test_constrainted(
         look_angle = -mn.Deg(mn.Rad(np.arctan2(look_vector[0], -look_vector[2])))
 
     assert np.abs(float(expected_angle - look_angle)) < 1e-1
+
+
+def test_object_controls_action_batch():
+    names = [
+        "moveForward",
+        "moveBackward",
+        "moveLeft",
+        "moveRight",
+        "moveUp",
+        "moveDown",
+        "turnLeft",
+        "turnRight",
+        "lookUp",
+        "lookDown",
+    ]
+    amounts = [0.25 if name.startswith("move") else 10.0 for name in names]
+    controls = habitat_sim.ObjectControls()
+    ids = [controls.action_id(name) for name in names]
+    assert controls.action_id("DNF") == -1
+
+    scene_graph = habitat_sim.SceneGraph()
+    start = habitat_sim.RigidState(
+        mn.Quaternion.rotation(mn.Deg(30.0), mn.Vector3.y_axis()),
+        mn.Vector3(1.0, 0.5, -2.0),
+    )
+    states, collided = controls.action_batch(
+        ids + [-1], amounts + [1.0], [start] * (len(names) + 1), apply_filter=False
+    )
+    assert not any(collided)
+    # the object that didn't act keeps its state
+    assert states[-1].translation == start.translation
+
+    # each state is where the same action moves a scene node
+    for name, amount, state in zip(names, amounts, states):
+        node = scene_graph.get_root_node().create_child()
+        node.rotation = start.rotation
+        node.translation = start.translation
+        controls.action(node, name, amount, apply_filter=False)
+        assert np.allclose(node.translation, state.translation, atol=1e-5)
+        assert np.allclose(node.rotation.vector, state.rotation.vector, atol=1e-5)
+        assert abs(node.rotation.scalar - state.rotation.scalar) < 1e-5
+
+    # a batch filter sees all moves at once
+    filtered = []
+
+    def stop_all(starts, ends):
+        filtered.append(len(starts))
+        return starts
+
+    controls.set_batch_move_filter_function(stop_all)
+    states, collided = controls.action_batch(
+        ids, amounts, [start] * len(names), apply_filter=True
+    )
+    assert filtered == [6]
+    assert collided == [name.startswith("move") for name in names]
+
+
+def test_rigid_state_arrays():
+    state = habitat_sim.RigidState(
+        mn.Quaternion.rotation(mn.Deg(30.0), mn.Vector3.y_axis()),
+        mn.Vector3(1.0, 0.5, -2.0),
+    )
+    # the arrays are views on the state
+    view = np.asarray(state)
+    assert np.allclose(view[4:], [1.0, 0.5, -2.0])
+    state.translation_array[1] = 3.0
+    assert state.translation[1] == 3.0
+    assert view[5] == 3.0
+    assert np.allclose(state.rotation_array[:3], state.rotation.vector)
+    assert state.rotation_array[3] == state.rotation.scalar
+
+    scene_graph = habitat_sim.SceneGraph()
+    nodes = [scene_graph.get_root_node().create_child() for _ in range(3)]
+    states = np.tile(view, (3, 1))
+    states[:, 4] += np.arange(3)
+    habitat_sim.SceneNode.set_rigid_states(nodes, states)
+    assert np.allclose(nodes[2].translation, [3.0, 3.0, -2.0])
+
+    # reading into the same array again writes it in place
+    out = np.zeros((3, 7), dtype=np.float32)
+    assert habitat_sim.SceneNode.get_rigid_states(nodes, out=out) is out
+    assert np.allclose(out, states)
+    with pytest.raises(ValueError):
+        habitat_sim.SceneNode.get_rigid_states(nodes, out=np.zeros((2, 7)))
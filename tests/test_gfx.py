@@ -55,3 +55,11 @@ def test_unproject():
         assert np.allclose(
             test_ray_2.direction, np.array([0.569653, -0.581161, -0.581161]), atol=0.07
         )
+
+
+def test_gpu_devices():
+    devices = habitat_sim.gfx.query_gpu_devices()
+    assert len(devices) > 0
+    assert habitat_sim.gfx.least_loaded_gpu_device() in [
+        device.device for device in devices
+    ]
@@ -1,6 +1,7 @@
 import glob
 from os import path as osp
 
+import magnum as mn
 import numpy as np
 import pytest
 import tqdm
@@ -180,3 +181,100 @@ def test_greedy_follower(test_navmesh, move_filter_fn, action_noise, pbar):
 
     if not test_all:
         assert test_spl / NUM_TESTS >= ACCEPTABLE_SPLS[(move_filter_fn, action_noise)]
+
+
+@pytest.mark.parametrize("allow_sliding", [True, False])
+def test_batched_greedy_follower(allow_sliding):
+    test_navmesh = test_navmeshes[1]
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    assert pathfinder.is_loaded
+    pathfinder.seed(0)
+
+    forward_amount = 0.25
+    follower = habitat_sim.BatchedGreedyGeodesicFollower(
+        pathfinder,
+        0.75 * forward_amount,
+        forward_amount,
+        np.deg2rad(TURN_DEGREE),
+        allow_sliding=allow_sliding,
+    )
+
+    starts = []
+    goals = []
+    while len(starts) < 32:
+        start = pathfinder.get_random_navigable_point()
+        goal = pathfinder.get_random_navigable_point()
+        path = habitat_sim.ShortestPath()
+        path.requested_start = start
+        path.requested_end = goal
+        if pathfinder.find_path(path) and path.geodesic_distance > 2.0:
+            starts.append(habitat_sim.RigidState(mn.Quaternion(), mn.Vector3(*start)))
+            goals.append(mn.Vector3(*goal))
+
+    paths = follower.find_paths(starts, goals)
+    assert len(paths) == len(starts)
+    num_reached = 0
+    for actions in paths:
+        if len(actions) > 0:
+            assert actions[-1] == habitat_sim.GreedyFollowerCodes.STOP
+            num_reached += 1
+    assert num_reached >= 0.9 * len(starts)
+
+    # planning one step at a time takes the first action of the full plan
+    follower.reset()
+    actions = follower.next_actions_along(starts, goals)
+    for action, path in zip(actions, paths):
+        if len(path) > 0:
+            assert action == path[0]
+
+
+def test_continuous_path_follower():
+    test_navmesh = test_navmeshes[1]
+    if not osp.exists(test_navmesh):
+        pytest.skip(f"{test_navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    pathfinder.load_nav_mesh(test_navmesh)
+    assert pathfinder.is_loaded
+    pathfinder.seed(0)
+
+    settings = habitat_sim.PathFollowerSettings()
+    follower = habitat_sim.ContinuousPathFollower(pathfinder, settings)
+
+    num_tested = 0
+    num_reached = 0
+    while num_tested < 32:
+        start = pathfinder.get_random_navigable_point()
+        goal = pathfinder.get_random_navigable_point()
+        path = habitat_sim.ShortestPath()
+        path.requested_start = start
+        path.requested_end = goal
+        if not pathfinder.find_path(path) or path.geodesic_distance < 2.0:
+            continue
+        num_tested += 1
+
+        assert follower.set_goal(mn.Vector3(*start), mn.Vector3(*goal))
+        # rounding the corners only shortens the path
+        assert follower.path_length <= path.geodesic_distance + 1e-3
+        assert follower.path_length >= np.linalg.norm(goal - start) - 1e-3
+
+        states = follower.follow_path(
+            habitat_sim.RigidState(mn.Quaternion(), mn.Vector3(*start)), 0.1
+        )
+        assert len(states) > 0
+        end = np.array(states[-1].translation)
+        if np.linalg.norm(end - goal) < settings.goal_radius + 0.05:
+            num_reached += 1
+
+    assert num_reached >= 0.9 * num_tested
+
+    # a straight path is followed straight ahead
+    follower.set_path([mn.Vector3(0, 0, 0), mn.Vector3(0, 0, -2)])
+    command = follower.next_command(habitat_sim.RigidState(), 0.1)
+    assert not command.done
+    assert np.allclose(command.linear_velocity, [0, 0, -settings.linear_speed])
+    assert np.allclose(command.angular_velocity, [0, 0, 0])
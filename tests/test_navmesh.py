@@ -1,6 +1,8 @@
 import math
 from os import path as osp
 
+import magnum as mn
+import numpy as np
 import pytest
 
 import examples.settings
@@ -143,3 +145,409 @@ def test_navmesh_area(test_scene):
             assert math.isclose(recomputedNavMeshArea1, 565.1781616210938)
         elif test_scene.endswith("van-gogh-room.glb"):
             assert math.isclose(recomputedNavMeshArea1, 9.17772102355957)
+
+
+def test_find_paths_batch():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    samples = [
+        (
+            pathfinder.get_random_navigable_point(),
+            pathfinder.get_random_navigable_point(),
+        )
+        for _ in range(100)
+    ]
+    starts = np.array([start for start, _ in samples])
+    ends = np.array([end for _, end in samples])
+
+    distances, points, offsets = pathfinder.find_paths_batch(
+        starts, ends, return_paths=True
+    )
+    assert np.array_equal(distances, pathfinder.find_paths_batch(starts, ends))
+    assert points.shape == (offsets[-1], 3)
+    for i, (start, end) in enumerate(samples):
+        path = habitat_sim.ShortestPath()
+        path.requested_start = start
+        path.requested_end = end
+        assert pathfinder.find_path(path) == np.isfinite(distances[i])
+        assert math.isclose(distances[i], path.geodesic_distance, rel_tol=EPS)
+        assert np.allclose(points[offsets[i] : offsets[i + 1]], path.points)
+
+
+def test_point_queries_batch():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    rng = np.random.default_rng(0)
+    navigable = np.array([pathfinder.get_random_navigable_point() for _ in range(50)])
+    # points off the navmesh too, and far away from it
+    points = np.concatenate(
+        [navigable, navigable + rng.uniform(-1.0, 1.0, navigable.shape), [[1e4] * 3]]
+    ).astype(np.float32)
+
+    snapped = pathfinder.snap_point_batch(points)
+    is_navigable = pathfinder.is_navigable_batch(points)
+    assert is_navigable.dtype == bool
+    for point, snapped_point, point_is_navigable in zip(points, snapped, is_navigable):
+        assert np.allclose(snapped_point, pathfinder.snap_point(point), equal_nan=True)
+        assert point_is_navigable == pathfinder.is_navigable(point)
+    assert np.all(np.isnan(snapped[-1]))
+
+    # several moves from each start, which share its projection
+    starts = np.repeat(navigable, 4, axis=0)
+    ends = starts + rng.uniform(-0.5, 0.5, starts.shape).astype(np.float32)
+    for allow_sliding in (True, False):
+        steps = pathfinder.try_step_batch_array(starts, ends, allow_sliding)
+        try_step = (
+            pathfinder.try_step if allow_sliding else pathfinder.try_step_no_sliding
+        )
+        for start, end, step in zip(starts, ends, steps):
+            assert np.allclose(step, try_step(start, end))
+
+
+def test_geodesic_distance_field(tmp_path):
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    goals = [pathfinder.get_random_navigable_point() for _ in range(3)]
+    field = pathfinder.build_geodesic_distance_field(goals)
+    assert len(field.goals) == 3
+
+    filename = str(tmp_path / "skokloster.gdf")
+    assert field.save(filename)
+    loaded_field = habitat_sim.GeodesicDistanceField.load(filename)
+    assert loaded_field is not None
+
+    path = habitat_sim.MultiGoalShortestPath()
+    path.requested_ends = goals
+    for _ in range(50):
+        path.requested_start = pathfinder.get_random_navigable_point()
+        distance = pathfinder.geodesic_distance(field, path.requested_start)
+        assert distance == pathfinder.geodesic_distance(
+            loaded_field, path.requested_start
+        )
+        if pathfinder.find_path(path):
+            assert abs(distance - path.geodesic_distance) < (
+                0.1 + 0.05 * path.geodesic_distance
+            )
+        else:
+            assert math.isinf(distance)
+
+
+def test_island_sampling():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    assert pathfinder.num_islands > 0
+    largest = pathfinder.largest_island
+    assert math.isclose(
+        sum(pathfinder.island_area(i) for i in range(pathfinder.num_islands)),
+        pathfinder.navigable_area,
+        rel_tol=1e-3,
+    )
+
+    pathfinder.seed(0)
+    for _ in range(100):
+        pt = pathfinder.get_random_navigable_point_on_largest_island()
+        assert pathfinder.is_navigable(pt)
+        assert pathfinder.get_island(pt) == largest
+
+
+def test_sample_episodes():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    settings = habitat_sim.EpisodeSamplingSettings()
+    settings.min_geodesic_distance = 2.0
+    settings.max_geodesic_distance = 10.0
+    settings.min_geodesic_to_euclidean_ratio = 1.05
+    episodes = pathfinder.sample_episodes(100, 3, settings)
+    assert len(episodes) == 100
+    for episode in episodes:
+        assert 2.0 <= episode.geodesic_distance <= 10.0
+        euclidean = np.linalg.norm(episode.goal - episode.start)
+        assert episode.geodesic_distance >= 1.05 * euclidean - EPS
+
+    again = pathfinder.sample_episodes(100, 3, settings)
+    for episode, other in zip(episodes, again):
+        assert np.array_equal(episode.start, other.start)
+        assert np.array_equal(episode.goal, other.goal)
+
+
+def test_obstacle_distance_field():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    points = [pathfinder.get_random_navigable_point() for _ in range(100)]
+    distances = [pathfinder.distance_to_closest_obstacle(pt, 0.5) for pt in points]
+
+    pathfinder.enable_obstacle_distance_field()
+    assert pathfinder.is_obstacle_distance_field_enabled
+    for pt, distance in zip(points, distances):
+        assert pathfinder.distance_to_closest_obstacle(pt, 0.5) == distance
+
+
+def test_navmesh_agent_batch():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    np.random.seed(seed=0)
+
+    scene_graph = habitat_sim.SceneGraph()
+    agent = habitat_sim.Agent(scene_graph.get_root_node().create_child())
+    agent.controls.move_filter_fn = pathfinder.try_step
+    action_space = agent.agent_config.action_space
+    action_names = ["move_forward", "turn_left", "turn_right"]
+
+    num_agents = 8
+    batch = habitat_sim.NavMeshAgentBatch(pathfinder, num_agents)
+    for name, motion in zip(
+        action_names,
+        [
+            habitat_sim.NavMeshMotion.MOVE_FORWARD,
+            habitat_sim.NavMeshMotion.TURN_LEFT,
+            habitat_sim.NavMeshMotion.TURN_RIGHT,
+        ],
+    ):
+        batch.add_action(motion, action_space[name].actuation.amount)
+    assert batch.num_actions == len(action_names)
+
+    starts = [pathfinder.get_random_navigable_point() for _ in range(num_agents)]
+    batch.states = [
+        habitat_sim.RigidState(mn.Quaternion(), mn.Vector3(*start)) for start in starts
+    ]
+    actions = np.random.randint(len(action_names), size=(50, num_agents))
+    for step_actions in actions:
+        batch.step(step_actions.tolist())
+
+    # each agent of the batch moves as the agent does
+    for i, start in enumerate(starts):
+        state = habitat_sim.AgentState()
+        state.position = start
+        agent.state = state
+        for step_actions in actions:
+            agent.act(action_names[step_actions[i]])
+        assert np.allclose(
+            agent.state.position, np.array(batch.state(i).translation), atol=1e-4
+        )
+
+    # the node is only written when the state changed
+    node = scene_graph.get_root_node().create_child()
+    assert batch.sync_node(0, node)
+    assert np.allclose(np.array(node.translation), np.array(batch.state(0).translation))
+    assert not batch.sync_node(0, node)
+    batch.step([-1] * num_agents)
+    assert not batch.sync_node(0, node)
+
+
+def test_coverage_map():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    start = pathfinder.get_random_navigable_point()
+    meters_per_pixel = 0.1
+    coverage_map = habitat_sim.CoverageMap(pathfinder, meters_per_pixel, start[1])
+    navigable = pathfinder.get_topdown_view(meters_per_pixel, start[1])
+    assert np.array_equal(coverage_map.navigable, navigable)
+    assert coverage_map.num_navigable == navigable.sum()
+
+    pose = habitat_sim.RigidState(mn.Quaternion(), mn.Vector3(*start))
+    new_cells = coverage_map.update(pose, np.deg2rad(90), 3.0)
+    assert new_cells > 0
+    assert coverage_map.num_covered == new_cells
+    assert coverage_map.coverage.sum() == new_cells
+    # only navigable cells within range are seen
+    assert not np.any(coverage_map.coverage & ~navigable)
+    rows, cols = np.nonzero(coverage_map.coverage)
+    bounds = pathfinder.get_bounds()
+    cell_x = bounds[0][0] + cols * meters_per_pixel
+    cell_z = bounds[0][2] + rows * meters_per_pixel
+    assert np.all(
+        np.hypot(cell_x - start[0], cell_z - start[2]) <= 3.0 + 2 * meters_per_pixel
+    )
+
+    # the same view again sees nothing new, looking all around does
+    assert coverage_map.update(pose, np.deg2rad(90), 3.0) == 0
+    pose.rotation = mn.Quaternion.rotation(mn.Deg(180), mn.Vector3.y_axis())
+    assert coverage_map.update(pose, 2 * np.pi, 3.0) > 0
+    assert coverage_map.covered_area == pytest.approx(
+        coverage_map.num_covered * meters_per_pixel ** 2
+    )
+
+    coverage_map.reset()
+    assert coverage_map.num_covered == 0
+
+
+def test_navmesh_levels():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    assert pathfinder.num_levels >= 1
+    levels = pathfinder.get_levels()
+    assert len(levels) == pathfinder.num_levels
+    heights = [level.height for level in levels]
+    assert heights == sorted(heights)
+    assert sum(level.area for level in levels) == pytest.approx(
+        pathfinder.navigable_area, rel=1e-2
+    )
+
+    meters_per_pixel = 0.1
+    union = None
+    for i, level in enumerate(levels):
+        for _ in range(10):
+            pt = pathfinder.get_random_navigable_point_on_level(i)
+            assert pathfinder.is_navigable(pt)
+            assert pathfinder.get_level(pt) == i
+            assert np.all(pt >= level.bounds[0] - EPS)
+            assert np.all(pt <= level.bounds[1] + EPS)
+        view = pathfinder.get_topdown_view_of_level(i, meters_per_pixel)
+        assert view.shape == pathfinder.get_topdown_view(meters_per_pixel, 0).shape
+        assert view.any()
+        union = view if union is None else union | view
+    assert np.all(np.isinf(pathfinder.get_random_navigable_point_on_level(-1)))
+
+    # the same floor as one given level covers the whole navmesh
+    pathfinder.segment_levels([heights[0]])
+    assert pathfinder.num_levels == 1
+    assert np.array_equal(
+        pathfinder.get_topdown_view_of_level(0, meters_per_pixel), union
+    )
+
+
+def test_recompute_navmesh_heightfield_cache():
+    test_scene = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb"
+    )
+    if not osp.exists(test_scene):
+        pytest.skip(f"{test_scene} not found")
+
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = test_scene
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        navmesh_settings = habitat_sim.NavMeshSettings()
+        navmesh_settings.set_defaults()
+        # sweep the settings that reuse the voxelization, then one that doesn't
+        sweep = [("agent_radius", 0.2), ("agent_height", 1.0), ("agent_max_climb", 0.1)]
+        cached_areas = []
+        assert sim.recompute_navmesh(sim.pathfinder, navmesh_settings)
+        for name, value in sweep:
+            setattr(navmesh_settings, name, value)
+            assert sim.recompute_navmesh(sim.pathfinder, navmesh_settings)
+            cached_areas.append(sim.pathfinder.navigable_area)
+
+        # the same builds from scratch
+        navmesh_settings.set_defaults()
+        for (name, value), cached_area in zip(sweep, cached_areas):
+            setattr(navmesh_settings, name, value)
+            sim.pathfinder.clear_heightfield_cache()
+            assert sim.recompute_navmesh(sim.pathfinder, navmesh_settings)
+            assert sim.pathfinder.navigable_area == cached_area
+
+
+def test_path_cache():
+    navmesh = osp.join(
+        base_dir, "data/scene_datasets/habitat-test-scenes/skokloster-castle.navmesh"
+    )
+    if not osp.exists(navmesh):
+        pytest.skip(f"{navmesh} not found")
+
+    pathfinder = habitat_sim.PathFinder()
+    assert pathfinder.load_nav_mesh(navmesh)
+    pathfinder.seed(0)
+    pairs = [
+        (
+            pathfinder.get_random_navigable_point(),
+            pathfinder.get_random_navigable_point(),
+        )
+        for _ in range(20)
+    ]
+
+    def find_all():
+        results = []
+        for start, end in pairs:
+            path = habitat_sim.ShortestPath()
+            path.requested_start = start
+            path.requested_end = end
+            found = pathfinder.find_path(path)
+            points = [list(point) for point in path.points]
+            results.append((found, path.geodesic_distance, points))
+        return results
+
+    uncached = find_all()
+    assert not pathfinder.is_path_cache_enabled
+    pathfinder.enable_path_cache(capacity=len(pairs))
+    assert pathfinder.is_path_cache_enabled
+    assert find_all() == uncached
+    assert pathfinder.path_cache_hits == 0
+    assert pathfinder.path_cache_misses == len(pairs)
+    assert find_all() == uncached
+    assert pathfinder.path_cache_hits == len(pairs)
+
+    # a smaller cache keeps the most recent paths
+    pathfinder.enable_path_cache(capacity=1)
+    find_all()
+    find_all()
+    assert pathfinder.path_cache_hits == 0
+
+    # reloading the navmesh clears the cache
+    pathfinder.enable_path_cache()
+    find_all()
+    assert pathfinder.load_nav_mesh(navmesh)
+    find_all()
+    assert pathfinder.path_cache_hits == 0
+    pathfinder.disable_path_cache()
+    assert not pathfinder.is_path_cache_enabled
@@ -11,10 +11,18 @@ import pytest
 
 import habitat_sim
 from habitat_sim.sensors.noise_models import redwood_depth_noise_model
+from habitat_sim.sensors.noise_models.gaussian_noise_model import (
+    GaussianNoiseModel,
+    GaussianNoiseModelCPUImpl,
+)
 from habitat_sim.sensors.noise_models.redwood_depth_noise_model import (
     RedwoodDepthNoiseModel,
     RedwoodNoiseModelCPUImpl,
 )
+from habitat_sim.sensors.noise_models.speckle_noise_model import (
+    SpeckleNoiseModel,
+    SpeckleNoiseModelCPUImpl,
+)
 
 
 @pytest.mark.gfxtest
@@ -45,3 +53,81 @@ def test_compare_gpu_cpu_redwood_depth(noise_multiplier: float, tolerance: float
     cpu_depth = np.mean(np.stack(cpu_depths, 0), 0)
 
     assert np.abs(cuda_depth - cpu_depth).mean() <= tolerance
+
+
+@pytest.mark.parametrize("noise_multiplier,tolerance", [(0.0, 1e-5), (1.0, 5e-2)])
+def test_compare_native_numba_cpu_redwood_depth(
+    noise_multiplier: float, tolerance: float
+):
+    depth = np.linspace(0, 20, num=(256 * 256), dtype=np.float32).reshape(256, 256)
+    dist = np.load(
+        osp.join(
+            osp.dirname(redwood_depth_noise_model.__file__),
+            "data",
+            "redwood-depth-dist-model.npy",
+        )
+    )
+
+    native_impl = habitat_sim._ext.habitat_sim_bindings.RedwoodNoiseModelCPUImpl(
+        dist, noise_multiplier, seed=0
+    )
+    numba_impl = RedwoodNoiseModelCPUImpl(dist, noise_multiplier=noise_multiplier)
+
+    NUM_SIMS = 20
+    native_depths = [native_impl.simulate(depth) for _ in range(NUM_SIMS)]
+    numba_depths = [numba_impl.simulate(depth) for _ in range(NUM_SIMS)]
+
+    native_depth = np.mean(np.stack(native_depths, 0), 0)
+    numba_depth = np.mean(np.stack(numba_depths, 0), 0)
+
+    assert np.abs(native_depth - numba_depth).mean() <= tolerance
+
+    # the noise only depends on the seed and the frame, not on the threads
+    native_impl.seed(0)
+    assert np.array_equal(native_impl.simulate(depth), native_depths[0])
+    batch = native_impl.simulate_batch(np.stack([depth, depth], 0))
+    assert np.array_equal(batch[0], native_depths[1])
+    assert np.array_equal(batch[1], native_depths[2])
+
+
+@pytest.mark.gfxtest
+@pytest.mark.skipif(not habitat_sim.cuda_enabled, reason="Test requires cuda")
+def test_batched_redwood_depth():
+    torch = pytest.importorskip("torch")
+    depth = np.linspace(0, 20, num=(256 * 256), dtype=np.float32).reshape(256, 256)
+
+    cuda_impl = RedwoodDepthNoiseModel(noise_multiplier=0.0, gpu_device_id=0)
+    depths = torch.from_numpy(np.stack([depth, depth[::-1].copy()], 0)).cuda()
+
+    # without noise, every image of the stack matches the single image path
+    noisy_batch = cuda_impl(depths).cpu().numpy()
+    for i in range(2):
+        assert np.abs(noisy_batch[i] - cuda_impl(depths[i]).cpu().numpy()).max() < 1e-5
+
+
+@pytest.mark.gfxtest
+@pytest.mark.skipif(not habitat_sim.cuda_enabled, reason="Test requires cuda")
+@pytest.mark.parametrize(
+    "model_cls,cpu_impl_cls",
+    [
+        (GaussianNoiseModel, GaussianNoiseModelCPUImpl),
+        (SpeckleNoiseModel, SpeckleNoiseModelCPUImpl),
+    ],
+)
+def test_compare_gpu_cpu_rgb(model_cls, cpu_impl_cls):
+    image = np.tile(np.arange(256, dtype=np.uint8).reshape(1, 256, 1), (256, 1, 3))
+
+    cuda_impl = model_cls(gpu_device_id=0)
+    cpu_impl = cpu_impl_cls(
+        cuda_impl.intensity_constant, cuda_impl.mean, cuda_impl.sigma
+    )
+
+    NUM_SIMS = 20
+    cuda_images = [cuda_impl(image).astype(np.float32) for _ in range(NUM_SIMS)]
+    cpu_images = [cpu_impl.simulate(image).astype(np.float32) for _ in range(NUM_SIMS)]
+
+    assert cuda_images[0].shape == image.shape
+    cuda_image = np.mean(np.stack(cuda_images, 0), 0)
+    cpu_image = np.mean(np.stack(cpu_images, 0), 0)
+
+    assert np.abs(cuda_image - cpu_image).mean() <= 2.0
@@ -4,6 +4,7 @@
 # This source code is licensed under the MIT license found in the
 # LICENSE file in the root directory of this source tree.
 
+import json
 import math
 import random
 from os import path as osp
@@ -413,6 +414,26 @@ def test_raycast():
             assert abs(raycast_results.hits[0].ray_distance - 2.8935) < 0.001
             assert raycast_results.hits[0].object_id == 0
 
+            # only the closest hit, the cube
+            closest_results = sim.cast_ray(test_ray_1, closest_hit_only=True)
+            assert len(closest_results.hits) == 1
+            assert closest_results.hits[0].object_id == 0
+            assert abs(closest_results.hits[0].ray_distance - 2.8935) < 0.001
+
+            # filter out the stage or the dynamic cube
+            CollisionGroup = habitat_sim.physics.CollisionGroup
+            raycast_results = sim.cast_ray(
+                test_ray_1, collision_filter_mask=~int(CollisionGroup.STAGE)
+            )
+            assert len(raycast_results.hits) == 1
+            assert raycast_results.hits[0].object_id == 0
+            raycast_results = sim.cast_ray(
+                test_ray_1, collision_filter_mask=int(CollisionGroup.STAGE)
+            )
+            assert len(raycast_results.hits) == 1
+            assert raycast_results.hits[0].object_id == -1
+            assert abs(raycast_results.hits[0].ray_distance - 6.831) < 0.001
+
             # test raycast against a non-collidable object.
             # should not register a hit with the object.
             sim.set_object_is_collidable(False, cube_obj_id)
@@ -425,3 +446,412 @@ def test_raycast():
             sim.set_stage_is_collidable(False)
             raycast_results = sim.cast_ray(test_ray_1)
             assert not raycast_results.has_hits()
+
+
+def test_collision_filter():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/apartment_1.glb"
+    cfg_settings["enable_physics"] = True
+
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        if (
+            sim.get_physics_simulation_library()
+            == habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            return
+        CollisionGroup = habitat_sim.physics.CollisionGroup
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+
+        # two overlapping cubes, without the stage in the way
+        sim.set_stage_is_collidable(False)
+        cube_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(2)]
+        sim.set_translation(mn.Vector3(3.0, 0, 0), cube_ids[0])
+        sim.set_translation(mn.Vector3(3.1, 0, 0), cube_ids[1])
+        assert sim.get_object_collision_group(cube_ids[0]) == int(
+            CollisionGroup.DEFAULT
+        )
+        assert sim.get_object_collision_mask(cube_ids[0]) == int(CollisionGroup.ALL)
+        assert sim.contact_test(cube_ids[0])
+
+        # clutter colliding with the static environment only
+        static_environment = int(CollisionGroup.STATIC) | int(CollisionGroup.STAGE)
+        assert sim.set_object_collision_filter(
+            int(CollisionGroup.DEBRIS), static_environment, cube_ids[0]
+        )
+        assert sim.get_object_collision_group(cube_ids[0]) == int(
+            CollisionGroup.DEBRIS
+        )
+        assert sim.get_object_collision_mask(cube_ids[0]) == static_environment
+        assert not sim.contact_test(cube_ids[0])
+        assert not sim.contact_test(cube_ids[1])
+
+        # raycasts only hit the groups in their mask
+        test_ray = habitat_sim.geo.Ray()
+        test_ray.direction = mn.Vector3(1.0, 0, 0)
+        raycast_results = sim.cast_ray(
+            test_ray, collision_filter_mask=int(CollisionGroup.DEBRIS)
+        )
+        assert len(raycast_results.hits) == 1
+        assert raycast_results.hits[0].object_id == cube_ids[0]
+
+        # a static cube is part of the static environment
+        sim.set_object_motion_type(habitat_sim.physics.MotionType.STATIC, cube_ids[1])
+        assert sim.contact_test(cube_ids[0])
+
+        # back to the defaults of the motion type
+        assert sim.set_object_collision_filter(0, 0, cube_ids[0])
+        assert sim.get_object_collision_group(cube_ids[0]) == int(
+            CollisionGroup.DEFAULT
+        )
+
+
+def test_cast_rays():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+
+    # configure some settings in case defaults change
+    cfg_settings["scene"] = "data/scene_datasets/habitat-test-scenes/apartment_1.glb"
+
+    # enable the physics simulator
+    cfg_settings["enable_physics"] = True
+
+    # loading the physical scene
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        obj_mgr = sim.get_object_template_manager()
+
+        if (
+            sim.get_physics_simulation_library()
+            != habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+            cube_obj_id = sim.add_object_by_handle(cube_prim_handle)
+            sim.set_translation(mn.Vector3(3.0, 0, 0), cube_obj_id)
+
+            # a fan of rays around the y axis, more than a chunk of them, and
+            # a zero length one
+            angles = np.linspace(0, 2 * np.pi, 500, endpoint=False)
+            directions = np.stack(
+                [np.cos(angles), np.zeros_like(angles), np.sin(angles)], axis=1
+            )
+            directions[7] = 0
+            origins = np.zeros_like(directions)
+
+            results = sim.cast_rays(origins, directions)
+            assert results.num_rays == len(angles)
+            assert results.hit_offsets[0] == 0
+            assert results.hit_offsets[-1] == results.num_hits
+            assert results.points.shape == (results.num_hits, 3)
+            assert results.normals.shape == (results.num_hits, 3)
+            assert results.hit_offsets[8] == results.hit_offsets[7]
+
+            closest = sim.cast_rays(origins, directions, closest_hit_only=True)
+            assert closest.num_rays == len(angles)
+
+            # the same hits as one ray at a time
+            for i in range(0, len(angles), 25):
+                ray = habitat_sim.geo.Ray(
+                    mn.Vector3(origins[i]), mn.Vector3(directions[i])
+                )
+                expected = sim.cast_ray(ray)
+                first, end = results.hit_offsets[i : i + 2]
+                assert end - first == len(expected.hits)
+                for hit, j in zip(expected.hits, range(first, end)):
+                    assert results.object_ids[j] == hit.object_id
+                    assert np.allclose(results.points[j], hit.point, atol=1e-4)
+                    assert np.allclose(results.normals[j], hit.normal, atol=1e-4)
+                    assert abs(results.ray_distances[j] - hit.ray_distance) < 1e-4
+
+                first, end = closest.hit_offsets[i : i + 2]
+                assert end - first == min(1, len(expected.hits))
+                if expected.has_hits():
+                    closest_hit = expected.hits[0]
+                    assert closest.object_ids[first] == closest_hit.object_id
+                    distance = closest.ray_distances[first]
+                    assert abs(distance - closest_hit.ray_distance) < 1e-4
+
+            # the cube is in front of the stage along the x axis
+            assert results.object_ids[results.hit_offsets[0]] == cube_obj_id
+
+
+def test_bulk_rigid_states():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "NONE"
+    cfg_settings["enable_physics"] = True
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        sim.set_gravity(np.array([0, 0, 0.0]))
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        object_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(5)]
+
+        translations = np.arange(15, dtype=np.float32).reshape(5, 3)
+        angles = np.linspace(0, np.pi, 5, endpoint=False)
+        # rotations around the y axis as x, y, z, w quaternions
+        rotations = np.zeros((5, 4), dtype=np.float32)
+        rotations[:, 1] = np.sin(angles / 2)
+        rotations[:, 3] = np.cos(angles / 2)
+        sim.set_rigid_states(object_ids, translations, rotations)
+
+        got_translations, got_rotations = sim.get_rigid_states(object_ids)
+        assert np.allclose(got_translations, translations)
+        assert np.allclose(got_rotations, rotations, atol=1e-6)
+        for i, object_id in enumerate(object_ids):
+            assert np.allclose(sim.get_translation(object_id), translations[i])
+            rotation = sim.get_rotation(object_id)
+            assert np.allclose(
+                [*rotation.vector, rotation.scalar], rotations[i], atol=1e-6
+            )
+
+        # a subset in another order
+        states = sim.get_rigid_states(object_ids[::-2])
+        assert np.allclose(states[0], translations[::-2])
+
+        with pytest.raises(ValueError):
+            sim.set_rigid_states(object_ids, translations[:4], rotations)
+
+        if (
+            sim.get_physics_simulation_library()
+            != habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            linear_velocities = np.ones((5, 3), dtype=np.float32)
+            angular_velocities = np.zeros((5, 3), dtype=np.float32)
+            angular_velocities[:, 1] = np.arange(5)
+            sim.set_velocities(object_ids, linear_velocities, angular_velocities)
+            got_linear, got_angular = sim.get_velocities(object_ids)
+            assert np.allclose(got_linear, linear_velocities)
+            assert np.allclose(got_angular, angular_velocities)
+            for i, object_id in enumerate(object_ids):
+                assert np.allclose(
+                    sim.get_linear_velocity(object_id), linear_velocities[i]
+                )
+
+
+def test_physics_state_snapshot():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "NONE"
+    cfg_settings["enable_physics"] = True
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        object_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(3)]
+        for i, object_id in enumerate(object_ids):
+            sim.set_translation(np.array([3.0 * i, 0, 0]), object_id)
+
+        handle = sim.save_physics_state()
+        assert handle >= 0
+        blob = sim.serialize_physics_state()
+        world_time = sim.get_world_time()
+        translations, rotations = sim.get_rigid_states(object_ids)
+        motion_type = sim.get_object_motion_type(object_ids[0])
+
+        sim.step_physics(0.5)
+        for object_id in object_ids:
+            sim.set_translation(np.array([0, 10.0, 0]), object_id)
+            sim.set_object_motion_type(
+                habitat_sim.physics.MotionType.KINEMATIC, object_id
+            )
+
+        assert sim.restore_physics_state(handle)
+        assert sim.get_world_time() == world_time
+        got_translations, got_rotations = sim.get_rigid_states(object_ids)
+        assert np.allclose(got_translations, translations)
+        assert np.allclose(got_rotations, rotations)
+        assert sim.get_object_motion_type(object_ids[0]) == motion_type
+
+        sim.set_translation(np.array([0, 10.0, 0]), object_ids[1])
+        assert sim.deserialize_physics_state(blob)
+        assert np.allclose(sim.get_translation(object_ids[1]), translations[1])
+        assert not sim.deserialize_physics_state(b"not a state")
+
+        assert sim.remove_physics_state(handle)
+        assert not sim.restore_physics_state(handle)
+
+        # states of removed objects can't be restored
+        handle = sim.save_physics_state()
+        sim.remove_object(object_ids[2])
+        assert not sim.restore_physics_state(handle)
+
+
+def test_checkpoint(tmp_path):
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "NONE"
+    cfg_settings["enable_physics"] = True
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    checkpoint = str(tmp_path / "episode.checkpoint")
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        object_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(3)]
+        for i, object_id in enumerate(object_ids):
+            sim.set_translation(np.array([3.0 * i, 1.0, 0]), object_id)
+        # a gap in the IDs
+        sim.remove_object(object_ids[1])
+        sim.step_physics(0.25)
+        agent_state = habitat_sim.AgentState()
+        agent_state.position = np.array([1.0, 0.0, 2.0])
+        sim.get_agent(0).set_state(agent_state)
+
+        assert sim.save_checkpoint(checkpoint)
+        world_time = sim.get_world_time()
+        existing_ids = sim.get_existing_object_ids()
+        translations, rotations = sim.get_rigid_states(existing_ids)
+        randoms = [sim.random.uniform_float_01() for _ in range(3)]
+
+        sim.step_physics(0.5)
+        sim.remove_object(object_ids[0])
+        sim.add_object_by_handle(cube_prim_handle)
+        agent_state.position = np.array([0.0, 0.0, 0.0])
+        sim.get_agent(0).set_state(agent_state)
+
+        assert sim.load_checkpoint(checkpoint)
+        assert sim.get_world_time() == world_time
+        assert sim.get_existing_object_ids() == existing_ids
+        got_translations, got_rotations = sim.get_rigid_states(existing_ids)
+        assert np.allclose(got_translations, translations)
+        assert np.allclose(got_rotations, rotations)
+        assert np.allclose(
+            sim.get_agent(0).get_state().position, np.array([1.0, 0.0, 2.0])
+        )
+        assert [sim.random.uniform_float_01() for _ in range(3)] == randoms
+        # the next object gets the ID it would have got
+        assert sim.add_object_by_handle(cube_prim_handle) == object_ids[1]
+
+        with open(checkpoint, "wb") as f:
+            f.write(b"not a checkpoint")
+        assert not sim.load_checkpoint(checkpoint)
+
+
+def test_physics_state_checksum():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "NONE"
+    cfg_settings["enable_physics"] = True
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+
+    def run():
+        checksums = []
+        with habitat_sim.Simulator(hab_cfg) as sim:
+            obj_mgr = sim.get_object_template_manager()
+            cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+            for i in range(3):
+                object_id = sim.add_object_by_handle(cube_prim_handle)
+                sim.set_translation(np.array([0, 1.5 * i, 0]), object_id)
+            sim.apply_torque(np.array([0, 1.0, 0]), object_id)
+            checksums.append(sim.get_physics_state_checksum())
+            for _ in range(10):
+                sim.step_physics(1.0 / 60.0)
+                checksums.append(sim.get_physics_state_checksum())
+        return checksums
+
+    checksums = run()
+    # the world changes from step to step, the same way in each run
+    assert len(set(checksums)) == len(checksums)
+    assert run() == checksums
+
+
+def test_deterministic_physics_state_checksum(tmp_path):
+    default_physics_config = examples.settings.default_sim_settings[
+        "physics_config_file"
+    ]
+    with open(default_physics_config) as f:
+        physics_config = json.load(f)
+    # several threads, which the deterministic mode must not make visible
+    physics_config["deterministic"] = True
+    physics_config["num_threads"] = 4
+    physics_config["rigid object paths"] = [
+        osp.abspath(osp.join(osp.dirname(default_physics_config), path))
+        for path in physics_config["rigid object paths"]
+    ]
+    physics_config_file = str(tmp_path / "deterministic.physics_config.json")
+    with open(physics_config_file, "w") as f:
+        json.dump(physics_config, f)
+
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "NONE"
+    cfg_settings["enable_physics"] = True
+    cfg_settings["physics_config_file"] = physics_config_file
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+
+    def populate(sim):
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        # stacks far enough apart for separate islands
+        for i in range(4):
+            for j in range(2):
+                object_id = sim.add_object_by_handle(cube_prim_handle)
+                sim.set_translation(np.array([4.0 * i, 1.5 * j, 0]), object_id)
+                sim.apply_torque(np.array([0, 1.0 + i, 0]), object_id)
+
+    def step(sim, num_steps):
+        checksums = []
+        for _ in range(num_steps):
+            sim.step_physics(1.0 / 60.0)
+            checksums.append(sim.get_physics_state_checksum())
+        return checksums
+
+    def run():
+        with habitat_sim.Simulator(hab_cfg) as sim:
+            populate(sim)
+            checksums = step(sim, 10)
+            state = sim.serialize_physics_state()
+            # the world restored from the state, in the simulator that
+            # stepped into it
+            assert sim.deserialize_physics_state(state)
+            restored_checksums = step(sim, 10)
+        return checksums, state, restored_checksums
+
+    checksums, state, restored_checksums = run()
+    # the world changes from step to step, the same way in each run
+    assert len(set(checksums)) == len(checksums)
+    assert run() == (checksums, state, restored_checksums)
+
+    # the state steps the same in a simulator that only got populated the same
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        populate(sim)
+        assert sim.deserialize_physics_state(state)
+        assert step(sim, 10) == restored_checksums
+
+
+def test_fork():
+    cfg_settings = examples.settings.default_sim_settings.copy()
+    cfg_settings["scene"] = "NONE"
+    cfg_settings["enable_physics"] = True
+    hab_cfg = examples.settings.make_cfg(cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        obj_mgr = sim.get_object_template_manager()
+        cube_prim_handle = obj_mgr.get_template_handles("cube")[0]
+        object_ids = [sim.add_object_by_handle(cube_prim_handle) for _ in range(3)]
+        for i, object_id in enumerate(object_ids):
+            sim.set_translation(np.array([3.0 * i, 0, 0]), object_id)
+        # the copy gets the same IDs, gaps included
+        sim.remove_object(object_ids.pop(1))
+        sim.set_gravity(np.array([0, -1.0, 0]))
+        sim.step_physics(0.1)
+        agent_state = sim.get_agent(0).get_state()
+
+        forked = sim.fork()
+        assert forked.get_existing_object_ids() == object_ids
+        assert forked.get_world_time() == sim.get_world_time()
+        assert np.allclose(forked.get_gravity(), sim.get_gravity())
+        translations, rotations = sim.get_rigid_states(object_ids)
+        forked_translations, forked_rotations = forked.get_rigid_states(object_ids)
+        assert np.allclose(forked_translations, translations)
+        assert np.allclose(forked_rotations, rotations)
+        forked_state = forked.get_agent(0).get_state()
+        assert np.allclose(forked_state.position, agent_state.position)
+        assert forked.get_sensor_observations().keys() == sim._sensors.keys()
+
+        # the copies evolve independently
+        forked.set_translation(np.array([0, 10.0, 0]), object_ids[0])
+        forked.get_agent(0).act("move_forward")
+        forked.step_physics(0.5)
+        assert np.allclose(sim.get_translation(object_ids[0]), translations[0])
+        assert np.allclose(sim.get_agent(0).get_state().position, agent_state.position)
+        forked.remove_object(object_ids[1])
+        assert sim.get_existing_object_ids() == object_ids
+
+        forked.close()
+        sim.step_physics(0.1)
+        assert sim.get_existing_object_ids() == object_ids
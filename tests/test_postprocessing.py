@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+
+# Copyright (c) Facebook, Inc. and its affiliates.
+# This source code is licensed under the MIT license found in the
+# LICENSE file in the root directory of this source tree.
+
+import numpy as np
+import pytest
+
+from habitat_sim.sensors.postprocessing import (
+    Crop,
+    Normalize,
+    Resize,
+    apply_postprocessing,
+)
+
+
+def test_resize_averages_integer_factors():
+    image = np.arange(4 * 6 * 3, dtype=np.uint8).reshape(4, 6, 3)
+    resized = Resize(height=2, width=3)(image)
+
+    assert resized.shape == (2, 3, 3)
+    assert resized.dtype == np.uint8
+    expected = image.astype(np.float32).reshape(2, 2, 3, 2, 3).mean(axis=(1, 3))
+    assert np.array_equal(resized, np.rint(expected).astype(np.uint8))
+
+
+def test_resize_nearest_keeps_ids():
+    ids = np.array([[1, 2, 3, 4], [5, 6, 7, 8]], dtype=np.uint32)
+
+    assert np.array_equal(
+        Resize(height=1, width=2, nearest=True)(ids), np.array([[6, 8]])
+    )
+    # not an integer factor, picks pixels even without nearest
+    assert Resize(height=2, width=3)(ids).tolist() == [[1, 3, 4], [5, 7, 8]]
+
+
+def test_crop_and_normalize():
+    depth = np.flip(np.arange(16, dtype=np.float32).reshape(4, 4), axis=0)
+    stages = [Crop(top=1, left=2, height=2, width=2), Normalize(mean=1.0, std=2.0)]
+    processed = apply_postprocessing(stages, depth)
+
+    assert processed.dtype == np.float32
+    assert np.array_equal(processed, (depth[1:3, 2:4] - 1.0) / 2.0)
+
+    with pytest.raises(AssertionError):
+        Crop(top=3, height=2, width=2)(depth)
+
+
+def test_normalize_per_channel():
+    image = np.full((2, 2, 3), 10, dtype=np.uint8)
+    normalized = Normalize(mean=(0.0, 5.0, 10.0), std=(1.0, 5.0, 2.0))(image)
+
+    assert normalized[0, 0].tolist() == [10.0, 1.0, 0.0]
+
+
+def test_postprocessing_torch():
+    torch = pytest.importorskip("torch")
+    image = np.arange(4 * 4 * 4, dtype=np.uint8).reshape(4, 4, 4)
+    stages = [Resize(height=2, width=2), Normalize(mean=100.0)]
+
+    processed = apply_postprocessing(stages, torch.from_numpy(image))
+    assert torch.is_tensor(processed)
+    assert np.allclose(processed.numpy(), apply_postprocessing(stages, image))
@@ -58,3 +58,17 @@ def test_semantic_scene(scene, make_cfg_settings):
 
     for level in scene.levels:
         level.id
+
+    index = habitat_sim.scene.SemanticSpatialIndex(scene)
+    objects = [
+        (i, obj) for i, obj in enumerate(scene.objects) if obj is not None
+    ]
+    assert index.num_objects == len(objects)
+    points = [obj.obb.center for _, obj in objects]
+    for (i, obj), found in zip(objects, index.batch_objects_at(points)):
+        assert i in found
+        assert found == [
+            j for j, other in objects if other.obb.contains(obj.obb.center, 1e-6)
+        ]
+        assert i in index.objects_in_radius(obj.obb.center, 0.0)
+    assert index.batch_regions_at(points) == [index.region_at(p) for p in points]
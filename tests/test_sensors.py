@@ -6,8 +6,10 @@
 
 import itertools
 import json
+import os
 from os import path as osp
 
+import magnum as mn
 import numpy as np
 import pytest
 import quaternion  # noqa: F401
@@ -205,6 +207,44 @@ def test_smoke_no_sensors(make_cfg_settings):
         sims.append(habitat_sim.Simulator(cfg))
 
 
+@pytest.mark.gfxtest
+@pytest.mark.skipif(not habitat_sim.cuda_enabled, reason="Test requires cuda")
+@pytest.mark.parametrize("sensor_type", all_sensor_types)
+def test_gpu2gpu_observation_dlpack(sensor_type, make_cfg_settings):
+    torch = pytest.importorskip("torch")
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = sens == sensor_type
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+    cfg.agents[0].sensor_specifications[0].gpu2gpu_transfer = True
+    cfg.agents[0].sensor_specifications[0].num_observation_buffers = 2
+
+    with habitat_sim.Simulator(cfg) as sim:
+        sim.get_sensor_observations()
+        sensor = sim.get_agent(0)._sensors[sensor_type]
+        first = sensor.read_observation_from(sensor.render_target)
+        second = sensor.read_observation_from(sensor.render_target)
+        assert first.buffer is None
+        assert first.device_buffer.data_ptr != second.device_buffer.data_ptr
+        assert first.device_buffer.__dlpack_device__() == (2, sim.gpu_device)
+
+        # a zero-copy view of the first buffer of the ring, which is reused
+        # after num_observation_buffers reads
+        tensor = torch.utils.dlpack.from_dlpack(first.device_buffer.__dlpack__())
+        assert tensor.data_ptr() == first.device_buffer.data_ptr
+        assert list(tensor.shape) == first.device_buffer.shape
+        third = sensor.read_observation_from(sensor.render_target)
+        assert third.device_buffer.data_ptr == first.device_buffer.data_ptr
+        assert torch.equal(
+            tensor,
+            torch.utils.dlpack.from_dlpack(second.device_buffer.__dlpack__()),
+        )
+
+
 @pytest.mark.gfxtest
 @pytest.mark.parametrize(
     "scene,gpu2gpu", itertools.product(_test_scenes, [True, False])
@@ -267,3 +307,571 @@ def test_rgb_noise(scene, model_name, make_cfg_settings):
         ) > 1.5e-2 * np.linalg.norm(
             gt.astype(np.float)
         ), "Incorrect color_sensor output"
+
+
+@pytest.mark.gfxtest
+@pytest.mark.parametrize(
+    "sensor_type,encoding",
+    [
+        ("color_sensor", "rgb_uint8"),
+        ("depth_sensor", "depth_float16"),
+        ("depth_sensor", "depth_uint16_mm"),
+    ],
+)
+@pytest.mark.parametrize("async_readback", [True, False])
+def test_observation_encodings(
+    sensor_type, encoding, async_readback, make_cfg_settings
+):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = sens == sensor_type
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+    cfg.agents[0].sensor_specifications[0].encoding = encoding
+    cfg.agents[0].sensor_specifications[0].async_readback = async_readback
+
+    with habitat_sim.Simulator(cfg) as sim:
+        obs, gt = _render_and_load_gt(sim, scene, sensor_type, False)
+        obs = obs[sensor_type]
+
+        if encoding == "rgb_uint8":
+            assert obs.shape == gt.shape[:2] + (3,)
+            assert obs.dtype == np.uint8
+            gt = gt[..., :3]
+        elif encoding == "depth_float16":
+            assert obs.shape == gt.shape
+            assert obs.dtype == np.float16
+        else:
+            assert obs.shape == gt.shape
+            assert obs.dtype == np.uint16
+            gt = np.clip(np.round(gt * 1000.0), 0, 65535)
+
+        assert np.linalg.norm(
+            obs.astype(np.float) - gt.astype(np.float)
+        ) < 9.0e-2 * np.linalg.norm(
+            gt.astype(np.float)
+        ), f"Incorrect {sensor_type} output with the {encoding} encoding"
+
+
+@pytest.mark.gfxtest
+@pytest.mark.parametrize("sensor_type", all_sensor_types)
+def test_msaa_and_postprocessing(sensor_type, make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = sens == sensor_type
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+    spec = cfg.agents[0].sensor_specifications[0]
+    spec.msaa_samples = 4
+    height, width = spec.resolution
+    spec.postprocessing = [
+        habitat_sim.sensors.postprocessing.Resize(
+            height=height // 2,
+            width=width // 2,
+            nearest=sensor_type == "semantic_sensor",
+        )
+    ]
+
+    with habitat_sim.Simulator(cfg) as sim:
+        assert sim.get_agent(0)._sensors[sensor_type].render_target.samples > 1
+        obs, gt = _render_and_load_gt(sim, scene, sensor_type, False)
+        obs = obs[sensor_type]
+        gt = spec.postprocessing[0](gt)
+
+        assert obs.shape == gt.shape
+        # multisampling only changes the edges
+        assert np.linalg.norm(
+            obs.astype(np.float) - gt.astype(np.float)
+        ) < 9.0e-2 * np.linalg.norm(
+            gt.astype(np.float)
+        ), f"Incorrect {sensor_type} output"
+
+
+@pytest.mark.gfxtest
+def test_native_observations_match_per_sensor(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    for sens in all_sensor_types:
+        make_cfg_settings[sens] = sens != "semantic_sensor"
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        sim.step("move_forward")
+        # the observations are views of the buffers the sensors read into
+        obs = {k: v.copy() for k, v in sim.get_sensor_observations().items()}
+        for uuid, sensor in sim._sensors.items():
+            assert sensor._native_read
+            sensor.draw_observation()
+            assert np.array_equal(obs[uuid], sensor.get_observation()), uuid
+
+        # the rows are read top-down, no flipped views
+        for uuid, observation in sim.get_sensor_observations().items():
+            assert observation.flags["C_CONTIGUOUS"], uuid
+
+        # unknown sensors fail without drawing anything
+        assert not sim.draw_and_read_observations({0: {"unknown": np.empty(4)}})
+
+
+@pytest.mark.gfxtest
+def test_shared_observations(make_cfg_settings):
+    from habitat_sim.sensors.shared_observations import (
+        SharedObservationReader,
+        SharedObservationWriter,
+    )
+
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+    make_cfg_settings["scene"] = scene
+
+    name = "/habitat-test-{}".format(os.getpid())
+    with habitat_sim.Simulator(make_cfg(make_cfg_settings)) as sim:
+        with SharedObservationWriter(sim, name, num_slots=2) as writer:
+            reader = SharedObservationReader(name)
+            assert reader.latest_sequence == 0
+            assert not reader.is_current(0)
+
+            sim.step("move_forward")
+            sequence = writer.write()
+            assert reader.latest_sequence == sequence
+            assert reader.timestamp(sequence) == sim.get_world_time()
+            expected = sim.get_sensor_observations()
+            observations = reader.observations(sequence)
+            assert observations.keys() == expected.keys()
+            for uuid, obs in observations.items():
+                assert not obs.flags["WRITEABLE"], uuid
+                assert np.array_equal(obs, expected[uuid]), uuid
+
+            # the slot is written again num_slots writes later
+            writer.write()
+            assert reader.is_current(sequence)
+            writer.write()
+            assert not reader.is_current(sequence)
+            with pytest.raises(ValueError):
+                reader.observations(sequence)
+            reader.close()
+
+
+@pytest.mark.gfxtest
+def test_lidar_point_cloud(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["scene"] = scene
+    make_cfg_settings["enable_physics"] = True
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        if (
+            sim.get_physics_simulation_library()
+            == habitat_sim.physics.PhysicsSimulationLibrary.NONE
+        ):
+            pytest.skip("Lidar needs physics")
+
+        spec = habitat_sim.SensorSpec()
+        spec.uuid = "lidar"
+        spec.sensor_type = habitat_sim.SensorType.LIDAR
+        spec.resolution = [16, 360]
+        spec.parameters["hfov"] = "360"
+        spec.parameters["vfov"] = "30"
+        spec.parameters["near"] = "0.1"
+        spec.parameters["far"] = "20"
+        sim.add_sensor(spec)
+
+        obs = sim.get_sensor_observations()
+        points = obs["lidar"]
+        assert points.shape == (16, 360, 4)
+        assert points.dtype == np.float32
+
+        hit = points[..., 3] > 0
+        assert hit.any()
+        assert np.all(points[~hit] == 0)
+        # the points are along the rays, at their range
+        assert np.allclose(
+            np.linalg.norm(points[..., :3], axis=-1), points[..., 3], atol=1e-4
+        )
+        assert np.all(points[hit, 3] >= 0.1) and np.all(points[hit, 3] <= 20.0)
+
+        # the same ranges as casting the rays one by one
+        lidar = sim._sensors["lidar"]._sensor_object
+        directions = lidar.ray_directions
+        assert directions.shape == (16 * 360, 3)
+        transformation = lidar.node.absolute_transformation()
+        for i in range(0, len(directions), 397):
+            direction = transformation.transform_vector(mn.Vector3(directions[i]))
+            ray = habitat_sim.geo.Ray(
+                transformation.translation + direction * 0.1, direction
+            )
+            results = sim.cast_ray(ray, max_distance=19.9)
+            expected = results.hits[0].ray_distance + 0.1 if results.has_hits() else 0
+            assert abs(points.reshape(-1, 4)[i, 3] - expected) < 1e-3
+
+
+@pytest.mark.gfxtest
+def test_normal_sensor(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        depth_spec = sim._sensors["depth_sensor"]._spec
+        spec = habitat_sim.SensorSpec()
+        spec.uuid = "normal_sensor"
+        spec.sensor_type = habitat_sim.SensorType.NORMAL
+        spec.resolution = depth_spec.resolution
+        spec.position = depth_spec.position
+        sim.add_sensor(spec)
+
+        obs = sim.get_sensor_observations()
+        normals = obs["normal_sensor"]
+        h, w = depth_spec.resolution
+        assert normals.shape == (h, w, 3)
+        assert normals.dtype == np.float32
+
+        # unit normals wherever there's depth, zero in the void
+        hit = obs["depth_sensor"] > 0
+        assert hit.any()
+        assert np.allclose(np.linalg.norm(normals[hit], axis=-1), 1.0, atol=1e-3)
+        assert np.all(normals[~hit] == 0)
+        # the visible surfaces mostly face the camera at -Z
+        assert np.median(normals[hit][:, 2]) > 0
+
+
+@pytest.mark.gfxtest
+@pytest.mark.parametrize("stride", [1, 2])
+def test_point_cloud_sensor(stride, make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        depth_spec = sim._sensors["depth_sensor"]._spec
+        for frame in ["camera", "world"]:
+            spec = habitat_sim.SensorSpec()
+            spec.uuid = "points_" + frame
+            spec.sensor_type = habitat_sim.SensorType.POINT_CLOUD
+            spec.resolution = depth_spec.resolution
+            spec.position = depth_spec.position
+            spec.parameters["point_cloud_stride"] = str(stride)
+            spec.parameters["point_cloud_frame"] = frame
+            sim.add_sensor(spec)
+
+        obs = sim.get_sensor_observations()
+        h, w = depth_spec.resolution
+        points = obs["points_camera"]
+        assert points.shape == ((h // stride) * (w // stride), 3)
+        assert points.dtype == np.float32
+
+        # the points are at the depth of the centers of the subsampled pixels
+        depth = obs["depth_sensor"][
+            stride // 2 : (h // stride) * stride : stride,
+            stride // 2 : (w // stride) * stride : stride,
+        ].reshape(-1)
+        hit = depth > 0
+        assert hit.any()
+        assert np.allclose(-points[hit, 2], depth[hit], rtol=1e-3, atol=1e-3)
+        assert np.all(points[~hit] == 0)
+
+        sensor = sim._sensors["points_world"]._sensor_object
+        transformation = sensor.node.absolute_transformation()
+        world = np.array(
+            [transformation.transform_point(mn.Vector3(p)) for p in points[hit]]
+        )
+        assert np.allclose(obs["points_world"][hit], world, atol=1e-3)
+
+
+@pytest.mark.gfxtest
+@pytest.mark.parametrize("stride,async_readback", [(1, False), (2, False), (3, True)])
+def test_read_region(stride, async_readback, make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        for name in ["color_sensor", "depth_sensor"]:
+            full_spec = sim._sensors[name]._spec
+            spec = habitat_sim.SensorSpec()
+            spec.uuid = name + "_region"
+            spec.sensor_type = full_spec.sensor_type
+            spec.resolution = full_spec.resolution
+            spec.position = full_spec.position
+            spec.async_readback = async_readback
+            spec.parameters["read_region"] = "32 48 200 100"
+            spec.parameters["read_stride"] = str(stride)
+            sim.add_sensor(spec)
+
+        obs = sim.get_sensor_observations()
+        # the centers of the stride x stride blocks of the region
+        rows = np.s_[48 + stride // 2 : 48 + (100 // stride) * stride : stride]
+        columns = np.s_[32 + stride // 2 : 32 + (200 // stride) * stride : stride]
+        color = obs["color_sensor_region"]
+        assert color.shape == (100 // stride, 200 // stride, 4)
+        assert np.array_equal(color, obs["color_sensor"][rows, columns])
+        depth = obs["depth_sensor_region"]
+        assert depth.shape == (100 // stride, 200 // stride)
+        assert np.allclose(depth, obs["depth_sensor"][rows, columns], atol=1e-5)
+
+        sensor = sim._sensors["color_sensor_region"]._sensor_object
+        assert sensor.read_region == mn.Range2Di.from_size((32, 48), (200, 100))
+        assert sensor.read_stride == stride
+
+
+@pytest.mark.gfxtest
+@pytest.mark.parametrize(
+    "remapping,encoding", [("category", "semantic_uint16"), ("instance", "")]
+)
+def test_semantic_remapping(remapping, encoding, make_cfg_settings):
+    scene = _test_scenes[0]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["semantic_sensor"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        semantic_spec = sim._sensors["semantic_sensor"]._spec
+        spec = habitat_sim.SensorSpec()
+        spec.uuid = "remapped"
+        spec.sensor_type = habitat_sim.SensorType.SEMANTIC
+        spec.resolution = semantic_spec.resolution
+        spec.position = semantic_spec.position
+        spec.parameters["semantic_remapping"] = remapping
+        if encoding:
+            spec.encoding = encoding
+        sim.add_sensor(spec)
+
+        obs = sim.get_sensor_observations()
+        remapped = obs["remapped"]
+        assert remapped.dtype == (np.uint16 if encoding else np.uint32)
+
+        # the same lookup on the CPU, ids past the end of the table to 0
+        if remapping == "category":
+            table = sim.semantic_scene.semantic_id_to_category_index()
+        else:
+            table = sim.semantic_scene.semantic_id_to_instance_id()
+        table = np.append(np.array(table, dtype=np.uint32), 0)
+        ids = np.minimum(obs["semantic_sensor"], len(table) - 1)
+        assert np.any(table[ids])
+        assert np.array_equal(remapped, table[ids])
+
+
+@pytest.mark.gfxtest
+def test_hide_semantic_object(make_cfg_settings):
+    scene = _test_scenes[0]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["semantic_sensor"] = True
+    make_cfg_settings["frustum_culling"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        semantic = sim.get_sensor_observations()["semantic_sensor"]
+        ids, counts = np.unique(semantic[semantic != 0], return_counts=True)
+        if len(ids) == 0:
+            pytest.skip("No semantic object in view")
+        hidden = int(ids[np.argmax(counts)])
+
+        assert sim.set_semantic_object_hidden(hidden, True)
+        assert not np.any(sim.get_sensor_observations()["semantic_sensor"] == hidden)
+
+        assert sim.set_semantic_object_hidden(hidden, False)
+        assert np.array_equal(
+            sim.get_sensor_observations()["semantic_sensor"], semantic
+        )
+
+
+@pytest.mark.gfxtest
+@pytest.mark.parametrize("remapping", ["", "category"])
+def test_object_id_histogram(remapping, make_cfg_settings):
+    scene = _test_scenes[0]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["semantic_sensor"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        semantic_spec = sim._sensors["semantic_sensor"]._spec
+        spec = habitat_sim.SensorSpec()
+        spec.uuid = "counted"
+        spec.sensor_type = habitat_sim.SensorType.SEMANTIC
+        spec.resolution = semantic_spec.resolution
+        spec.position = semantic_spec.position
+        if remapping:
+            spec.parameters["semantic_remapping"] = remapping
+        sim.add_sensor(spec)
+
+        obs = sim.get_sensor_observations()
+        sensor = sim._sensors["counted"]._sensor_object
+        # the ids past the last bin aren't counted
+        bin_count = 50
+        counts = sensor.read_object_id_histogram(sensor.render_target, bin_count)
+        assert counts.dtype == np.uint32
+        expected = np.bincount(obs["counted"].reshape(-1), minlength=bin_count)
+        assert np.array_equal(counts, expected[:bin_count])
+        assert counts.sum() > 0
+
+
+def test_object_id_runs():
+    ids = np.zeros((4, 6), dtype=np.uint32)
+    ids[1:3, 2:5] = 7
+    ids[3, :] = 3
+    runs = habitat_sim.sensor.encode_object_id_runs(ids)
+    assert runs.dtype == np.uint32
+    # the runs continue across rows
+    assert runs.tolist() == [[0, 8], [7, 3], [0, 3], [7, 3], [0, 1], [3, 6]]
+    decoded = habitat_sim.sensor.decode_object_id_runs(runs, ids.shape)
+    assert np.array_equal(decoded, ids)
+
+    assert habitat_sim.sensor.encode_object_id_runs(ids[:0]).shape == (0, 2)
+
+
+@pytest.mark.gfxtest
+def test_semantic_observation_runs(make_cfg_settings):
+    scene = _test_scenes[0]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["semantic_sensor"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        semantic = sim.get_sensor_observations()["semantic_sensor"]
+        runs = habitat_sim.sensor.encode_object_id_runs(semantic)
+        assert runs.nbytes * 10 < semantic.nbytes
+        decoded = habitat_sim.sensor.decode_object_id_runs(runs, semantic.shape)
+        assert np.array_equal(decoded, semantic)
+
+
+@pytest.mark.gfxtest
+def test_query_object_visibility(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["scene"] = scene
+    make_cfg_settings["enable_physics"] = True
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        obj_mgr = sim.get_object_template_manager()
+        obj_mgr.load_configs("data/objects/", True)
+        handle = obj_mgr.get_template_handles("cheezit")[0]
+        sensor = sim._sensors["color_sensor"]._sensor_object
+        pose = sensor.node.absolute_transformation()
+        # the second is right behind the first, and smaller in the view
+        front = sim.add_object_by_handle(handle)
+        sim.set_translation(pose.transform_point(mn.Vector3(0.0, 0.0, -1.0)), front)
+        behind = sim.add_object_by_handle(handle)
+        sim.set_translation(pose.transform_point(mn.Vector3(0.0, 0.0, -4.0)), behind)
+        away = pose @ mn.Matrix4.rotation_y(mn.Deg(180.0))
+
+        fractions = sim.query_object_visibility(
+            sim._default_agent_id, "color_sensor", [pose, away], [front, behind]
+        )
+        assert len(fractions) == 4
+        assert fractions[0] > 0.9
+        assert fractions[1] == 0.0
+        assert fractions[2:] == [0.0, 0.0]
+        # the render target is drawn again for the observations
+        assert sim.get_sensor_observations()["color_sensor"].any()
+
+
+@pytest.mark.gfxtest
+def test_render_interval(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        color_spec = sim._sensors["color_sensor"]._spec
+        for policy in ["REPEAT", "OMIT"]:
+            spec = habitat_sim.SensorSpec()
+            spec.uuid = "color_" + policy.lower()
+            spec.resolution = color_spec.resolution
+            spec.position = color_spec.position
+            spec.render_interval = 3
+            spec.stale_observation_policy = getattr(
+                habitat_sim.StaleObservationPolicy, policy
+            )
+            sim.add_sensor(spec)
+
+        # the observations may be views of buffers read into at every draw
+        obs = [
+            {k: np.copy(v) for k, v in sim.step("turn_left").items()}
+            for _ in range(4)
+        ]
+        assert all("depth_sensor" in o for o in obs)
+        assert [("color_omit" in o) for o in obs] == [True, False, False, True]
+        # stale observations repeat the last drawn one, while the view turns
+        assert np.array_equal(obs[0]["color_repeat"], obs[1]["color_repeat"])
+        assert np.array_equal(obs[0]["color_repeat"], obs[2]["color_repeat"])
+        assert not np.array_equal(obs[2]["color_repeat"], obs[3]["color_repeat"])
+        assert np.array_equal(obs[3]["color_repeat"], obs[3]["color_omit"])
+        assert not np.array_equal(obs[0]["depth_sensor"], obs[1]["depth_sensor"])
+
+
+@pytest.mark.gfxtest
+def test_foveated_color_sensor(make_cfg_settings):
+    scene = _test_scenes[-1]
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["width"] = 256
+    make_cfg_settings["height"] = 256
+    make_cfg_settings["scene"] = scene
+    cfg = make_cfg(make_cfg_settings)
+
+    with habitat_sim.Simulator(cfg) as sim:
+        color_spec = sim._sensors["color_sensor"]._spec
+        spec = habitat_sim.SensorSpec()
+        spec.uuid = "foveated"
+        spec.resolution = color_spec.resolution
+        spec.position = color_spec.position
+        spec.parameters["foveation_inset"] = "0.5"
+        spec.parameters["foveation_periphery_scale"] = "0.25"
+        sim.add_sensor(spec)
+
+        obs = sim.get_sensor_observations()
+        full = obs["color_sensor"].astype(np.float32)
+        foveated = obs["foveated"].astype(np.float32)
+        assert foveated.shape == full.shape
+
+        # the inset is drawn at the full resolution, the periphery upscaled
+        inset = np.s_[64:192, 64:192]
+        assert np.abs(foveated[inset] - full[inset]).mean() < 2.0
+        assert np.abs(foveated - full).mean() < 16.0
+        assert np.abs(foveated - full).mean() > np.abs(
+            foveated[inset] - full[inset]
+        ).mean()
@@ -119,6 +119,34 @@ def test_sim_multiagent_move_and_reset(make_cfg_settings, num_agents=10):
             )
 
 
+def test_sim_multiagent_native_act(make_cfg_settings, num_agents=10):
+    sim_cfg = examples.settings.make_cfg(make_cfg_settings)
+    sim_cfg.agents[0].sensor_specifications = []
+    sim_cfg.agents += [copy(sim_cfg.agents[0]) for _ in range(1, num_agents)]
+    with habitat_sim.Simulator(sim_cfg) as sim:
+        random.seed(0)
+        for _ in range(20):
+            starts = [sim.get_agent(i).state for i in range(num_agents)]
+            actions = {
+                i: random.choice(["move_forward", "turn_left", "turn_right"])
+                for i in range(num_agents)
+            }
+            collided = sim._act(actions)
+            ends = [sim.get_agent(i).state for i in range(num_agents)]
+
+            # the same actions taken one by one in python
+            for i in range(num_agents):
+                agent = sim.get_agent(i)
+                agent.set_state(starts[i], reset_sensors=False)
+                assert agent.act(actions[i]) == collided[i]
+                assert np.allclose(agent.state.position, ends[i].position, atol=1e-5)
+                assert np.allclose(
+                    agent.state.rotation.components,
+                    ends[i].rotation.components,
+                    atol=1e-5,
+                )
+
+
 # Make sure you can keep a reference to an agent alive without crashing
 def test_keep_agent():
     sim_cfg = habitat_sim.SimulatorConfiguration()
@@ -206,3 +234,172 @@ def test_object_template_editing():
 
         obj_init_template = sim.get_object_initialization_template(object_id)
         assert obj_init_template.render_asset_handle.endswith("sphere.glb")
+
+
+def test_vector_simulator(make_cfg_settings):
+    make_cfg_settings["depth_sensor"] = True
+    hab_cfg = examples.settings.make_cfg(make_cfg_settings)
+    with habitat_sim.VectorSimulator(hab_cfg, num_envs=3) as vector_sim:
+        assert vector_sim.num_envs == 3
+        initial_position = vector_sim.envs[0].get_agent(0).get_state().position
+
+        # the environments step independently
+        observations = vector_sim.step(["move_forward", "turn_left", "turn_right"])
+        assert len(observations) == 3
+        assert all("collided" in env_observations for env_observations in observations)
+        turned_position = vector_sim.envs[1].get_agent(0).get_state().position
+        assert np.allclose(turned_position, initial_position)
+        assert not np.array_equal(
+            observations[1]["color_sensor"], observations[2]["color_sensor"]
+        )
+
+        # the batched observations are those of each environment on its own
+        batched = [
+            {uuid: np.copy(obs) for uuid, obs in env_observations.items()}
+            for env_observations in vector_sim.get_sensor_observations()
+        ]
+        for env, env_batched in zip(vector_sim.envs, batched):
+            env_observations = env.get_sensor_observations()
+            for uuid, obs in env_observations.items():
+                assert np.array_equal(obs, env_batched[uuid])
+
+
+def test_vector_simulator_scenes(make_cfg_settings):
+    make_cfg_settings["semantic_sensor"] = False
+    van_gogh_settings = dict(make_cfg_settings)
+    van_gogh_settings[
+        "scene"
+    ] = "data/scene_datasets/habitat-test-scenes/van-gogh-room.glb"
+    hab_cfgs = [
+        examples.settings.make_cfg(make_cfg_settings),
+        examples.settings.make_cfg(van_gogh_settings),
+    ]
+    with habitat_sim.VectorSimulator(hab_cfgs) as vector_sim:
+        assert vector_sim.num_envs == 2
+        castle, van_gogh = vector_sim.envs
+        assert castle.config.sim_cfg.scene_id == make_cfg_settings["scene"]
+        assert van_gogh.config.sim_cfg.scene_id == van_gogh_settings["scene"]
+        # each scene has its own scene graph and navmesh
+        castle_bb = castle.get_active_scene_graph().get_root_node().cumulative_bb
+        van_gogh_bb = van_gogh.get_active_scene_graph().get_root_node().cumulative_bb
+        assert castle_bb != van_gogh_bb
+        assert not np.allclose(
+            castle.pathfinder.get_bounds()[0], van_gogh.pathfinder.get_bounds()[0]
+        )
+
+        observations = vector_sim.step(["move_forward", "move_forward"])
+        assert not np.array_equal(
+            observations[0]["color_sensor"], observations[1]["color_sensor"]
+        )
+        # the same as a simulator of the scene on its own
+        for env, env_observations in zip(vector_sim.envs, observations):
+            own = env.get_sensor_observations()
+            assert np.array_equal(own["depth_sensor"], env_observations["depth_sensor"])
+
+
+def test_perf_stats(make_cfg_settings):
+    hab_cfg = examples.settings.make_cfg(make_cfg_settings)
+    hab_cfg.sim_cfg.enable_perf_stats = True
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        sim.reset_perf_stats()
+        num_steps = 5
+        for _ in range(num_steps):
+            sim.step("move_forward")
+
+        stats = sim.get_perf_stats()
+        for name in ["draw_ms", "readback_ms", "visible_drawables"]:
+            assert stats[name]["count"] >= num_steps
+            assert sum(stats[name]["histogram"]) == stats[name]["count"]
+            assert stats[name]["min"] <= stats[name]["mean"] <= stats[name]["max"]
+        assert stats["visible_drawables"]["max"] > 0
+
+        sim.reset_perf_stats()
+        assert "draw_ms" not in sim.get_perf_stats()
+
+
+def test_memory_stats(make_cfg_settings):
+    hab_cfg = examples.settings.make_cfg(make_cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        sim.step("move_forward")
+        stats = sim.get_memory_stats()
+        for name in [
+            "meshes",
+            "textures",
+            "ptex_atlases",
+            "collision_meshes",
+            "navmesh",
+            "semantic_scene",
+            "render_targets",
+            "replay",
+        ]:
+            assert stats[name]["host_bytes"] >= 0
+            assert stats[name]["gpu_bytes"] >= 0
+        assert stats["meshes"]["gpu_bytes"] > 0
+        assert stats["render_targets"]["gpu_bytes"] > 0
+        if sim.pathfinder.is_loaded:
+            assert stats["navmesh"]["host_bytes"] > 0
+
+
+def test_startup_profile(make_cfg_settings):
+    hab_cfg = examples.settings.make_cfg(make_cfg_settings)
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        spans = sim.get_startup_profile()
+        assert spans[0]["name"] == "Simulator::reconfigure"
+        assert spans[0]["parent"] == -1
+        for span in spans[1:]:
+            parent = spans[span["parent"]]
+            assert span["depth"] == parent["depth"] + 1
+            assert span["duration_ms"] <= parent["duration_ms"]
+            assert span["bytes_read"] <= parent["bytes_read"]
+            assert span["triangles"] <= parent["triangles"]
+
+        load_stage = [s for s in spans if s["name"] == "ResourceManager::loadStage"]
+        assert len(load_stage) == 1
+        assert load_stage[0]["bytes_read"] > 0
+        assert load_stage[0]["triangles"] > 0
+        assert "ResourceManager::loadStage" in sim.get_startup_report()
+
+
+def test_render_target_pool(make_cfg_settings):
+    with habitat_sim.Simulator(examples.settings.make_cfg(make_cfg_settings)) as sim:
+        renderer = sim.renderer
+        assert renderer.render_target_pool_size == 0
+
+        # a released render target is bound again to a sensor of the same size
+        sensor = sim.get_agent(0)._sensors["color_sensor"]
+        renderer.release_render_target(sensor)
+        assert renderer.render_target_pool_size == 1
+        renderer.bind_render_target(sensor, top_down_rows=True)
+        assert renderer.render_target_pool_size == 0
+        assert sim.get_sensor_observations()["color_sensor"].shape[:2] == (480, 640)
+
+        # the sensors of replaced agents release theirs, the new sensors take
+        # them from the pool, and the one without a sensor to take it stays
+        settings = dict(make_cfg_settings)
+        settings["sensor_height"] = 1.0
+        settings["depth_sensor"] = False
+        sim.reconfigure(examples.settings.make_cfg(settings))
+        assert renderer.render_target_pool_size == 1
+        assert "depth_sensor" not in sim.get_sensor_observations()
+
+        renderer.set_render_target_pool_capacity(0)
+        assert renderer.render_target_pool_size == 0
+
+
+def test_fork_server(make_cfg_settings):
+    hab_cfg = examples.settings.make_cfg(make_cfg_settings)
+    with habitat_sim.ForkServer(hab_cfg) as server:
+        queue = server.context.Queue()
+
+        def run(sim, queue):
+            observation = sim.get_sensor_observations()["color_sensor"]
+            queue.put((sim.pathfinder.is_loaded, observation))
+
+        server.start_worker(hab_cfg, run, queue)
+        worker_loaded, worker_observation = queue.get(timeout=120)
+
+    with habitat_sim.Simulator(hab_cfg) as sim:
+        assert sim.pathfinder.is_loaded == worker_loaded
+        assert np.array_equal(
+            sim.get_sensor_observations()["color_sensor"], worker_observation
+        )